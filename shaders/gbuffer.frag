@@ -1,48 +1,60 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 // G-Buffer fragment shader for deferred rendering
 
-layout(location = 0) in vec3 in_world_pos;
 layout(location = 1) in vec3 in_normal;
 layout(location = 2) in vec2 in_texcoord;
 
-// G-Buffer outputs
-layout(location = 0) out vec4 out_position;   // RGB16F
-layout(location = 1) out vec4 out_normal;      // RGB16F
-layout(location = 2) out vec4 out_albedo;      // RGBA8
-layout(location = 3) out vec4 out_material;    // RGBA8 (roughness, metallic, ao, unused)
+// G-Buffer outputs, position is rebuilt from depth (see render_pass.h)
+layout(location = 0) out vec2 out_normal;      // RG16 or RGB10A2, octahedral
+layout(location = 1) out vec4 out_albedo;      // RGBA8
+layout(location = 2) out vec4 out_material;    // RGBA8 (roughness, metallic, ao, unused)
 
-// Material properties
-layout(set = 0, binding = 0) uniform sampler2D albedo_map;
-layout(set = 0, binding = 1) uniform sampler2D normal_map;
-layout(set = 0, binding = 2) uniform sampler2D roughness_map;
-layout(set = 0, binding = 3) uniform sampler2D metallic_map;
-layout(set = 0, binding = 4) uniform sampler2D ao_map;
+// Bindless heap (see descriptor.h)
+layout(set = 0, binding = 0) uniform texture2D textures[];
+layout(set = 0, binding = 2) uniform sampler samplers[];
 
+// Material permutation (see shader.h), unused maps compile out
+layout(constant_id = 0) const bool HAS_ALBEDO_MAP = false;
+layout(constant_id = 1) const bool HAS_ROUGHNESS_MAP = false;
+layout(constant_id = 2) const bool HAS_METALLIC_MAP = false;
+layout(constant_id = 3) const bool HAS_AO_MAP = false;
+
+// Material properties, after the vertex stage's matrices
 layout(push_constant) uniform PushConstants {
-    vec4 base_color;
+    layout(offset = 192) vec4 base_color;
     float roughness;
     float metallic;
     float ao;
-    int use_albedo_map;
-    int use_normal_map;
-    int use_roughness_map;
-    int use_metallic_map;
-    int use_ao_map;
+    uint sampler_index;
+    uint albedo_index;
+    uint normal_index;
+    uint roughness_index;
+    uint metallic_index;
+    uint ao_index;
 } push;
 
-void main() {
-    // Store world position
-    out_position = vec4(in_world_pos, 1.0);
+// Octahedral encoding of a unit vector, remapped to [0, 1] for UNORM targets
+vec2 encode_octahedral(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 e = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return e * 0.5 + 0.5;
+}
 
+vec4 sample_map(uint index) {
+    return texture(sampler2D(textures[nonuniformEXT(index)], samplers[push.sampler_index]), in_texcoord);
+}
+
+void main() {
     // Store normal (normalized)
     vec3 normal = normalize(in_normal);
-    out_normal = vec4(normal, 1.0);
+    out_normal = encode_octahedral(normal);
 
     // Store albedo
     vec4 albedo = push.base_color;
-    if (push.use_albedo_map != 0) {
-        albedo *= texture(albedo_map, in_texcoord);
+    if (HAS_ALBEDO_MAP) {
+        albedo *= sample_map(push.albedo_index);
     }
     out_albedo = albedo;
 
@@ -51,14 +63,14 @@ void main() {
     float metallic = push.metallic;
     float ao = push.ao;
 
-    if (push.use_roughness_map != 0) {
-        roughness *= texture(roughness_map, in_texcoord).r;
+    if (HAS_ROUGHNESS_MAP) {
+        roughness *= sample_map(push.roughness_index).r;
     }
-    if (push.use_metallic_map != 0) {
-        metallic *= texture(metallic_map, in_texcoord).r;
+    if (HAS_METALLIC_MAP) {
+        metallic *= sample_map(push.metallic_index).r;
     }
-    if (push.use_ao_map != 0) {
-        ao *= texture(ao_map, in_texcoord).r;
+    if (HAS_AO_MAP) {
+        ao *= sample_map(push.ao_index).r;
     }
 
     out_material = vec4(roughness, metallic, ao, 1.0);
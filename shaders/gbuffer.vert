@@ -2,26 +2,37 @@
 
 // G-Buffer vertex shader for deferred rendering
 
-layout(location = 0) in vec3 in_position;
-layout(location = 1) in vec3 in_normal;
+// Cooked meshes are quantized (ve_mesh_vertex_packed): positions are
+// R16G16B16A16_UNORM within the mesh bounds, normals R16G16_SNORM
+// octahedral, texcoords R16G16_SFLOAT
+layout(location = 0) in vec4 in_position;
+layout(location = 1) in vec2 in_normal;
 layout(location = 2) in vec2 in_texcoord;
-layout(location = 3) in vec3 in_tangent;
 
-// G-Buffer outputs
-layout(location = 0) out vec3 out_world_pos;
+// G-Buffer outputs (position is rebuilt from depth in the lighting pass)
 layout(location = 1) out vec3 out_normal;
 layout(location = 2) out vec2 out_texcoord;
 
+// gbuffer.frag's material constants start at offset 192
 layout(push_constant) uniform PushConstants {
     mat4 model;
-    mat4 view;
-    mat4 projection;
+    mat4 view_projection;
+    vec4 position_scale;    // bounds_max - bounds_min
+    vec4 position_offset;   // bounds_min
 } push;
 
+vec3 octahedral_decode(vec2 encoded) {
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    if (normal.z < 0.0) {
+        normal.xy = (1.0 - abs(normal.yx)) * vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(normal);
+}
+
 void main() {
-    vec4 world_pos = push.model * vec4(in_position, 1.0);
-    out_world_pos = world_pos.xyz;
-    out_normal = mat3(push.model) * in_normal;
+    vec3 position = push.position_offset.xyz + in_position.xyz * push.position_scale.xyz;
+    vec4 world_pos = push.model * vec4(position, 1.0);
+    out_normal = mat3(push.model) * octahedral_decode(in_normal);
     out_texcoord = in_texcoord;
-    gl_Position = push.projection * push.view * world_pos;
+    gl_Position = push.view_projection * world_pos;
 }
@@ -0,0 +1,57 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Instanced G-Buffer vertex shader (see instancing.h)
+
+// Same packed vertex layout as gbuffer.vert
+layout(location = 0) in vec4 in_position;
+layout(location = 1) in vec2 in_normal;
+layout(location = 2) in vec2 in_texcoord;
+
+layout(location = 1) out vec3 out_normal;
+layout(location = 2) out vec2 out_texcoord;
+
+// Must match ve_gpu_instance
+struct Instance {
+    vec4 model[3];          // First three rows of the world matrix
+    uvec4 data;             // material, mesh, padding
+};
+
+// Bindless storage buffers (see descriptor.h), aliased by element type
+layout(set = 0, binding = 1) readonly buffer InstanceBuffer {
+    Instance instances[];
+} instance_buffers[];
+
+layout(set = 0, binding = 1) readonly buffer UintBuffer {
+    uint values[];
+} uint_buffers[];
+
+// Must match ve_instancing_push; gbuffer.frag's material constants start at offset 192
+layout(push_constant) uniform PushConstants {
+    mat4 view_projection;
+    vec4 position_scale;    // bounds_max - bounds_min
+    vec4 position_offset;   // bounds_min
+    uint instance_buffer;
+    uint instance_id_buffer;
+} push;
+
+vec3 octahedral_decode(vec2 encoded) {
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    if (normal.z < 0.0) {
+        normal.xy = (1.0 - abs(normal.yx)) * vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(normal);
+}
+
+void main() {
+    // gl_InstanceIndex includes the draw's first instance, its offset into the ID list
+    uint slot = uint_buffers[push.instance_id_buffer].values[gl_InstanceIndex];
+    Instance instance = instance_buffers[push.instance_buffer].instances[slot];
+    mat4x3 model = transpose(mat3x4(instance.model[0], instance.model[1], instance.model[2]));
+
+    vec3 position = push.position_offset.xyz + in_position.xyz * push.position_scale.xyz;
+    vec3 world_pos = model * vec4(position, 1.0);
+    out_normal = mat3(model) * octahedral_decode(in_normal);
+    out_texcoord = in_texcoord;
+    gl_Position = push.view_projection * vec4(world_pos, 1.0);
+}
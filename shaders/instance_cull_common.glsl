@@ -0,0 +1,149 @@
+// GPU-driven instance culling: one thread per instance
+// Shared by instance_cull.comp (single and early phases) and
+// instance_cull_late.comp, which defines LATE_PHASE before including it.
+// Layouts and capacities must match gpu_culling.h
+
+#define GROUP_SIZE 64
+#define MAX_INSTANCES 65536
+#define MAX_BATCHES 64
+
+// Append visible instances to their batch (drawIndirectCount) or keep fixed slots
+layout(constant_id = 0) const bool COMPACT = true;
+
+#ifndef LATE_PHASE
+// Early phase of two-phase culling: draw only what was visible last frame
+layout(constant_id = 1) const bool EARLY_PHASE = false;
+#endif
+
+layout(local_size_x = GROUP_SIZE) in;
+
+struct Instance {
+    vec4 sphere;            // World center, radius
+    uvec4 ids;              // mesh, batch, object, slot
+};
+
+struct Mesh {
+    uint index_count;
+    uint first_index;
+    int vertex_offset;
+    uint padding;
+};
+
+// VkDrawIndexedIndirectCommand
+struct DrawCommand {
+    uint index_count;
+    uint instance_count;
+    uint first_index;
+    int vertex_offset;
+    uint first_instance;
+};
+
+layout(set = 0, binding = 0) uniform CullParams {
+    mat4 view_projection;
+    vec4 planes[6];         // Normalized, inside where dot(xyz, p) + w >= 0
+    uvec4 batch_offsets[MAX_BATCHES / 4];
+    vec4 hiz;               // Level 0 width, height, level count, valid
+    uint instance_count;
+} params;
+
+layout(set = 0, binding = 1) readonly buffer Instances {
+    Instance instances[];
+};
+
+layout(set = 0, binding = 2) readonly buffer Meshes {
+    Mesh meshes[];
+};
+
+// Two regions of MAX_INSTANCES: single and early phase, then late phase
+layout(set = 0, binding = 3) writeonly buffer Commands {
+    DrawCommand commands[];
+};
+
+// Two regions of MAX_BATCHES, matching the commands
+layout(set = 0, binding = 4) buffer DrawCounts {
+    uint draw_counts[];
+};
+
+// Non-zero for instances drawn last frame, by instance index
+layout(set = 0, binding = 5) buffer Visibility {
+    uint visibility[];
+};
+
+#ifdef LATE_PHASE
+// Hi-Z pyramid through a max-reduction sampler
+layout(set = 0, binding = 6) uniform sampler2D hiz;
+
+// Test the sphere's screen-space box against the farthest depth of the pyramid texels it covers
+bool is_occluded(vec4 sphere) {
+    if (params.hiz.w == 0.0) {
+        return false;
+    }
+
+    vec3 box_min = vec3(1.0);
+    vec3 box_max = vec3(-1.0);
+    for (int i = 0; i < 8; i++) {
+        vec3 corner = vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0, (i & 4) != 0 ? 1.0 : -1.0);
+        vec4 clip = params.view_projection * vec4(sphere.xyz + corner * sphere.w, 1.0);
+        // Crossing the camera plane, the box is unbounded
+        if (clip.w <= 0.0) {
+            return false;
+        }
+        vec3 ndc = clip.xyz / clip.w;
+        box_min = i == 0 ? ndc : min(box_min, ndc);
+        box_max = i == 0 ? ndc : max(box_max, ndc);
+    }
+
+    vec2 uv_min = clamp(box_min.xy * 0.5 + 0.5, 0.0, 1.0);
+    vec2 uv_max = clamp(box_max.xy * 0.5 + 0.5, 0.0, 1.0);
+    vec2 extent = (uv_max - uv_min) * params.hiz.xy;
+
+    // At this level the box spans at most one texel, so one bilinear tap covers it
+    float level = ceil(log2(max(max(extent.x, extent.y), 1.0)));
+    level = min(level, params.hiz.z - 1.0);
+
+    float farthest = textureLod(hiz, (uv_min + uv_max) * 0.5, level).x;
+    return box_min.z > farthest;
+}
+#endif
+
+void main() {
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= params.instance_count) {
+        return;
+    }
+
+    Instance instance = instances[index];
+    bool visible = true;
+    for (int i = 0; i < 6; i++) {
+        visible = visible && dot(params.planes[i].xyz, instance.sphere.xyz) + params.planes[i].w >= -instance.sphere.w;
+    }
+
+#ifdef LATE_PHASE
+    // Everything visible now is remembered; only what the early phase skipped is drawn
+    visible = visible && !is_occluded(instance.sphere);
+    bool was_visible = visibility[index] != 0u;
+    visibility[index] = visible ? 1u : 0u;
+    visible = visible && !was_visible;
+    uint command_region = MAX_INSTANCES;
+    uint count_region = MAX_BATCHES;
+#else
+    if (EARLY_PHASE) {
+        visible = visible && visibility[index] != 0u;
+    }
+    uint command_region = 0u;
+    uint count_region = 0u;
+#endif
+
+    uint slot = instance.ids.w;
+    if (COMPACT) {
+        if (!visible) {
+            return;
+        }
+        uint batch = instance.ids.y;
+        slot = params.batch_offsets[batch / 4][batch % 4] + atomicAdd(draw_counts[count_region + batch], 1u);
+    }
+
+    Mesh mesh = meshes[instance.ids.x];
+    commands[command_region + slot] = DrawCommand(mesh.index_count, visible ? 1u : 0u, mesh.first_index,
+                                                  mesh.vertex_offset, instance.ids.z);
+}
@@ -0,0 +1,209 @@
+// Deferred lighting shared by lighting.frag and lighting_subpass.frag.
+// The including shader declares set 0 bindings 0-3 (G-buffer) and calls
+// shade_gbuffer with the texels of the pixel it shades.
+
+// IBL
+layout(set = 0, binding = 4) uniform samplerCube irradiance_map;
+layout(set = 0, binding = 5) uniform samplerCube prefilter_map;
+layout(set = 0, binding = 6) uniform sampler2D brdf_lut;
+
+// Clustered point lights (see light_culling.h), grid sizes must match light_cull.comp
+#define CLUSTER_X 16
+#define CLUSTER_Y 9
+#define CLUSTER_Z 24
+#define MAX_LIGHTS_PER_CLUSTER 128
+
+struct PointLight {
+    vec4 position_radius;
+    vec4 color_intensity;
+};
+
+layout(set = 1, binding = 0) uniform ClusterParams {
+    mat4 view;
+    mat4 projection;
+    vec4 screen;            // width, height, 1 / width, 1 / height
+    vec4 depth;             // z_near, z_far, slice_scale, slice_bias
+    uint light_count;
+} clusters;
+
+layout(set = 1, binding = 1) readonly buffer Lights {
+    PointLight lights[];
+};
+
+layout(set = 1, binding = 2) readonly buffer ClusterCounts {
+    uint cluster_counts[];
+};
+
+layout(set = 1, binding = 3) readonly buffer ClusterLights {
+    uint cluster_lights[];
+};
+
+// Camera
+layout(push_constant) uniform PushConstants {
+    mat4 inv_view_projection;
+    vec3 camera_pos;
+} push;
+
+// Output mode (see shader.h): 0=final, 1=position, 2=normal, 3=albedo, 4=material
+layout(constant_id = 0) const int DEBUG_MODE = 0;
+
+const float PI = 3.14159265359;
+
+// Inverse of the G-buffer's octahedral encoding
+vec3 decode_octahedral(vec2 e) {
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+// World position from the depth buffer (Vulkan NDC, depth in [0, 1])
+vec3 reconstruct_position(vec2 uv, float depth) {
+    vec4 ndc = vec4(uv * 2.0 - 1.0, depth, 1.0);
+    vec4 world = push.inv_view_projection * ndc;
+    return world.xyz / world.w;
+}
+
+// PBR functions
+vec3 fresnel_schlick(float cos_theta, vec3 F0) {
+    return F0 + (1.0 - F0) * pow(clamp(1.0 - cos_theta, 0.0, 1.0), 5.0);
+}
+
+vec3 fresnel_schlick_roughness(float cos_theta, vec3 F0, float roughness) {
+    return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(clamp(1.0 - cos_theta, 0.0, 1.0), 5.0);
+}
+
+float distribution_ggx(vec3 N, vec3 H, float roughness) {
+    float a = roughness * roughness;
+    float a2 = a * a;
+    float NdotH = max(dot(N, H), 0.0);
+    float NdotH2 = NdotH * NdotH;
+
+    float nom = a2;
+    float denom = (NdotH2 * (a2 - 1.0) + 1.0);
+    denom = PI * denom * denom;
+
+    return nom / denom;
+}
+
+float geometry_schlick_ggx(float NdotV, float roughness) {
+    float r = (roughness + 1.0);
+    float k = (r * r) / 8.0;
+
+    float nom = NdotV;
+    float denom = NdotV * (1.0 - k) + k;
+
+    return nom / denom;
+}
+
+float geometry_smith(vec3 N, vec3 V, vec3 L, float roughness) {
+    float NdotV = max(dot(N, V), 0.0);
+    float NdotL = max(dot(N, L), 0.0);
+    float ggx2 = geometry_schlick_ggx(NdotV, roughness);
+    float ggx1 = geometry_schlick_ggx(NdotL, roughness);
+
+    return ggx1 * ggx2;
+}
+
+// Cook-Torrance BRDF for one light, times NdotL
+vec3 shade(vec3 N, vec3 V, vec3 L, vec3 radiance, vec3 albedo, vec3 F0, float roughness, float metallic) {
+    vec3 H = normalize(V + L);
+
+    float NDF = distribution_ggx(N, H, roughness);
+    float G = geometry_smith(N, V, L, roughness);
+    vec3 F = fresnel_schlick(max(dot(H, V), 0.0), F0);
+
+    vec3 numerator = NDF * G * F;
+    float denominator = 4.0 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.0001;
+    vec3 specular = numerator / denominator;
+
+    vec3 kS = F;
+    vec3 kD = vec3(1.0) - kS;
+    kD *= 1.0 - metallic;
+
+    float NdotL = max(dot(N, L), 0.0);
+    return (kD * albedo / PI + specular) * radiance * NdotL;
+}
+
+// Index of the cluster containing a pixel
+uint cluster_index(vec2 frag_coord, vec3 world_pos) {
+    float view_depth = -(clusters.view * vec4(world_pos, 1.0)).z;
+    uint cz = uint(clamp(log(view_depth) * clusters.depth.z + clusters.depth.w, 0.0, float(CLUSTER_Z - 1)));
+    uvec2 cxy = min(uvec2(frag_coord * clusters.screen.zw * vec2(CLUSTER_X, CLUSTER_Y)),
+                    uvec2(CLUSTER_X - 1, CLUSTER_Y - 1));
+    return cxy.x + cxy.y * CLUSTER_X + cz * CLUSTER_X * CLUSTER_Y;
+}
+
+// Shade one pixel from its G-buffer texels
+vec4 shade_gbuffer(vec2 uv, float depth, vec2 encoded_normal, vec3 albedo, vec3 material) {
+    vec3 world_pos = reconstruct_position(uv, depth);
+    vec3 normal = decode_octahedral(encoded_normal);
+
+    float roughness = material.r;
+    float metallic = material.g;
+    float ao = material.b;
+
+    // Debug modes
+    if (DEBUG_MODE == 1) {
+        return vec4(world_pos * 0.01, 1.0);
+    }
+    if (DEBUG_MODE == 2) {
+        return vec4(normal * 0.5 + 0.5, 1.0);
+    }
+    if (DEBUG_MODE == 3) {
+        return vec4(albedo, 1.0);
+    }
+    if (DEBUG_MODE == 4) {
+        return vec4(roughness, metallic, ao, 1.0);
+    }
+
+    vec3 N = normal;
+    vec3 V = normalize(push.camera_pos - world_pos);
+
+    // Calculate reflectance
+    vec3 F0 = vec3(0.04);
+    F0 = mix(F0, albedo, metallic);
+
+    // Directional light
+    vec3 L = normalize(vec3(1.0, 1.0, 1.0));
+    vec3 radiance = vec3(1.0);  // White light
+    vec3 Lo = shade(N, V, L, radiance, albedo, F0, roughness, metallic);
+
+    // Point lights of this pixel's cluster only
+    uint cluster = cluster_index(gl_FragCoord.xy, world_pos);
+    uint light_count = cluster_counts[cluster];
+    for (uint i = 0; i < light_count; i++) {
+        PointLight light = lights[cluster_lights[cluster * MAX_LIGHTS_PER_CLUSTER + i]];
+        vec3 to_light = light.position_radius.xyz - world_pos;
+        float distance_sq = dot(to_light, to_light);
+        float ratio = distance_sq / (light.position_radius.w * light.position_radius.w);
+        float window = clamp(1.0 - ratio * ratio, 0.0, 1.0);
+        float attenuation = window * window / (distance_sq + 1.0);
+        vec3 light_radiance = light.color_intensity.rgb * light.color_intensity.a * attenuation;
+        Lo += shade(N, V, to_light * inversesqrt(max(distance_sq, 1e-8)), light_radiance,
+                    albedo, F0, roughness, metallic);
+    }
+
+    // Ambient with IBL (simplified)
+    vec3 R = reflect(-V, N);
+    vec3 F_ambient = fresnel_schlick_roughness(max(dot(N, V), 0.0), F0, roughness);
+
+    vec3 kD_ambient = (1.0 - F_ambient) * (1.0 - metallic);
+    vec3 irradiance = texture(irradiance_map, N).rgb;
+    vec3 diffuse = irradiance * albedo;
+
+    vec3 prefiltered = textureLod(prefilter_map, R, roughness * 4.0).rgb;
+    vec2 brdf = texture(brdf_lut, vec2(max(dot(N, V), 0.0), roughness)).rg;
+    vec3 specular_ambient = prefiltered * (F_ambient * brdf.x + brdf.y);
+
+    vec3 ambient = (kD_ambient * diffuse + specular_ambient) * ao;
+    vec3 color = ambient + Lo;
+
+    // Tone mapping (ACES approx)
+    color = color / (color + vec3(1.0));
+    color = pow(color, vec3(1.0 / 2.2));  // Gamma correction
+
+    return vec4(color, 1.0);
+}
@@ -0,0 +1,22 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+// Lighting subpass of the deferred render pass (see render_pass.h). The
+// G-buffer is read as input attachments at the shaded pixel, so it can stay
+// in tile memory.
+
+layout(location = 0) in vec2 in_texcoord;
+layout(location = 0) out vec4 out_color;
+
+// G-Buffer inputs, same set 0 bindings as the sampled lighting pass
+layout(input_attachment_index = 0, set = 0, binding = 0) uniform subpassInput g_depth;
+layout(input_attachment_index = 1, set = 0, binding = 1) uniform subpassInput g_normal;
+layout(input_attachment_index = 2, set = 0, binding = 2) uniform subpassInput g_albedo;
+layout(input_attachment_index = 3, set = 0, binding = 3) uniform subpassInput g_material;
+
+#include "lighting_common.glsl"
+
+void main() {
+    out_color = shade_gbuffer(in_texcoord, subpassLoad(g_depth).r, subpassLoad(g_normal).rg,
+                              subpassLoad(g_albedo).rgb, subpassLoad(g_material).rgb);
+}
@@ -0,0 +1,36 @@
+// Meshlet buffers and push constants shared by meshlet.task and meshlet.mesh
+// Layouts must match meshlet.h and ve_meshlet in model_loader.h.
+// The including shader enables GL_EXT_nonuniform_qualifier for the
+// unsized bindless arrays; indices come from push constants and are uniform.
+
+struct Meshlet {
+    uvec4 ranges;           // vertex_offset, triangle_offset (bytes), vertex_count, triangle_count
+    vec4 sphere;            // Mesh-space center, radius
+    vec4 cone;              // Axis, cutoff
+};
+
+// Bindless storage buffers (see descriptor.h), aliased by element type
+layout(set = 0, binding = 1) readonly buffer MeshletBuffer {
+    Meshlet meshlets[];
+} meshlet_buffers[];
+
+layout(set = 0, binding = 1) readonly buffer UintBuffer {
+    uint values[];
+} uint_buffers[];
+
+layout(set = 0, binding = 1) readonly buffer FloatBuffer {
+    float values[];
+} float_buffers[];
+
+// Below gbuffer.frag's material block at offset 192
+layout(push_constant) uniform PushConstants {
+    mat4 model;
+    mat4 view_projection;
+    vec3 camera_position;
+    uint meshlet_count;
+    uint meshlet_buffer;
+    uint vertex_index_buffer;
+    uint triangle_buffer;
+    uint vertex_buffer;
+    uint vertex_stride;     // Floats per vertex
+} push;
@@ -4,5 +4,724 @@
  */
 
 #include "asset_manager.h"
+#include "../platform/platform.h"
+#include "../core/memory.h"
+#include "../core/logger.h"
+#include "../core/assert.h"
+#include "../core/queue.h"
 
-/* TODO: Implement asset management */
+#include <string.h>
+
+/* Marks an empty link, a free slot chain end and a request not in the queue */
+#define ASSET_NONE UINT32_MAX
+
+#define ASSET_GENERATION_MASK ((1u << (32 - VE_ASSET_INDEX_BITS)) - 1)
+
+#define ASSET_HASH_SEED 0xcbf29ce484222325ull
+
+/**
+ * @brief Load running on the pool
+ *
+ * Owns a copy of the loader and the path, so the main thread may grow the
+ * slot and loader arrays meanwhile.
+ */
+typedef struct asset_job {
+    ve_mpsc_node node;              /* Finished queue */
+    ve_asset_loader loader;
+    char* path;
+    uint32_t slot;
+    ve_atomic_int32 cancelled;
+    bool skipped;                   /* Cancelled before decoding */
+    bool success;
+    void* asset;
+    size_t resident_size;
+} asset_job;
+
+/**
+ * @brief Asset slot
+ *
+ * Free slots have state VE_ASSET_INVALID and chain through lru_next.
+ */
+typedef struct ve_asset_slot {
+    char* path;
+    uint64_t hash;
+    void* asset;
+    size_t resident_size;
+    uint64_t fence;                 /* Upload completion, 0 if none */
+    asset_job* job;                 /* While loading */
+    float priority;
+    uint32_t type;
+    uint32_t generation;
+    uint32_t ref_count;
+    uint32_t queue_index;           /* Heap position while queued */
+    uint32_t lru_prev;              /* Neighbours in the cache while ready and unreferenced */
+    uint32_t lru_next;
+    ve_asset_state state;
+    bool uploaded;
+    bool cancelled;                 /* Released while loading, freed when the job returns */
+} ve_asset_slot;
+
+/* Global asset manager state */
+static struct {
+    bool initialized;
+    ve_thread_pool* pool;
+    size_t memory_budget;
+    uint32_t max_in_flight;
+    bool (*is_fence_complete)(uint64_t fence);
+    ve_asset_loader loaders[VE_ASSET_MAX_TYPES];
+    uint32_t loader_count;
+    ve_asset_slot* slots;
+    uint32_t slot_count;
+    uint32_t slot_capacity;
+    uint32_t free_slot;
+    uint32_t* table;                /* Open addressing by path, slot index + 1, 0 is empty */
+    uint32_t table_capacity;
+    uint32_t table_count;
+    uint32_t* queue;                /* Max heap of queued slots by priority */
+    uint32_t queue_count;
+    uint32_t queue_capacity;
+    uint32_t* uploads;              /* Decoded slots waiting for their upload */
+    uint32_t upload_count;
+    uint32_t upload_capacity;
+    uint32_t lru_head;              /* Least recently released */
+    uint32_t lru_tail;
+    uint32_t in_flight;
+    size_t resident_size;
+    ve_mpsc_queue finished;         /* Pushed by load jobs, drained on the main thread */
+    ve_job_counter counter;
+    uint64_t loaded;
+    uint64_t cancelled;
+    uint64_t evicted;
+} g_assets = {0};
+
+/* FNV-1a */
+static uint64_t hash_string(const char* string) {
+    uint64_t hash = ASSET_HASH_SEED;
+    for (const uint8_t* c = (const uint8_t*)string; *c; c++) {
+        hash ^= *c;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static bool grow_array(uint32_t** array, uint32_t* capacity, uint32_t count) {
+    if (count < *capacity) {
+        return true;
+    }
+    uint32_t new_capacity = *capacity ? *capacity * 2 : 64;
+    uint32_t* grown = (uint32_t*)ve_reallocate(*array, new_capacity * sizeof(uint32_t), VE_MEMORY_TAG_ASSET);
+    if (!grown) {
+        return false;
+    }
+    *array = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+static ve_asset_slot* get_slot(ve_asset asset) {
+    uint32_t index = asset & (VE_ASSET_MAX_ASSETS - 1);
+    if (asset == VE_ASSET_NULL || index >= g_assets.slot_count) {
+        return NULL;
+    }
+    ve_asset_slot* slot = &g_assets.slots[index];
+    if (slot->state == VE_ASSET_INVALID || slot->generation != asset >> VE_ASSET_INDEX_BITS) {
+        return NULL;
+    }
+    return slot;
+}
+
+/* Path table */
+
+static bool rebuild_table(uint32_t capacity) {
+    uint32_t* table = (uint32_t*)ve_allocate_cleared(capacity, sizeof(uint32_t), VE_MEMORY_TAG_ASSET);
+    if (!table) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < g_assets.table_capacity; i++) {
+        uint32_t entry = g_assets.table[i];
+        if (entry != 0) {
+            uint32_t position = (uint32_t)g_assets.slots[entry - 1].hash & (capacity - 1);
+            while (table[position] != 0) {
+                position = (position + 1) & (capacity - 1);
+            }
+            table[position] = entry;
+        }
+    }
+
+    VE_FREE(g_assets.table);
+    g_assets.table = table;
+    g_assets.table_capacity = capacity;
+    return true;
+}
+
+static uint32_t table_find(uint64_t hash, const char* path) {
+    if (g_assets.table_capacity == 0) {
+        return ASSET_NONE;
+    }
+
+    uint32_t mask = g_assets.table_capacity - 1;
+    for (uint32_t position = (uint32_t)hash & mask; g_assets.table[position] != 0; position = (position + 1) & mask) {
+        const ve_asset_slot* slot = &g_assets.slots[g_assets.table[position] - 1];
+        if (slot->hash == hash && strcmp(slot->path, path) == 0) {
+            return g_assets.table[position] - 1;
+        }
+    }
+    return ASSET_NONE;
+}
+
+static bool table_insert(uint32_t index) {
+    if ((g_assets.table_count + 1) * 4 > g_assets.table_capacity * 3 &&
+        !rebuild_table(g_assets.table_capacity ? g_assets.table_capacity * 2 : 256)) {
+        return false;
+    }
+
+    uint32_t mask = g_assets.table_capacity - 1;
+    uint32_t position = (uint32_t)g_assets.slots[index].hash & mask;
+    while (g_assets.table[position] != 0) {
+        position = (position + 1) & mask;
+    }
+    g_assets.table[position] = index + 1;
+    g_assets.table_count++;
+    return true;
+}
+
+/* Backward shift deletion keeps every probe chain unbroken without tombstones */
+static void table_remove(uint32_t index) {
+    uint32_t mask = g_assets.table_capacity - 1;
+    uint32_t hole = (uint32_t)g_assets.slots[index].hash & mask;
+    while (g_assets.table[hole] != index + 1) {
+        hole = (hole + 1) & mask;
+    }
+
+    for (uint32_t position = (hole + 1) & mask; g_assets.table[position] != 0; position = (position + 1) & mask) {
+        uint32_t home = (uint32_t)g_assets.slots[g_assets.table[position] - 1].hash & mask;
+        /* Entries whose home lies cyclically in (hole, position] must stay put */
+        if (((position - home) & mask) >= ((position - hole) & mask)) {
+            g_assets.table[hole] = g_assets.table[position];
+            hole = position;
+        }
+    }
+    g_assets.table[hole] = 0;
+    g_assets.table_count--;
+}
+
+/* Request queue */
+
+static bool queue_before(uint32_t a, uint32_t b) {
+    return g_assets.slots[a].priority > g_assets.slots[b].priority;
+}
+
+static void queue_place(uint32_t position, uint32_t index) {
+    g_assets.queue[position] = index;
+    g_assets.slots[index].queue_index = position;
+}
+
+static void queue_sift_up(uint32_t position) {
+    uint32_t index = g_assets.queue[position];
+    while (position > 0) {
+        uint32_t parent = (position - 1) / 2;
+        if (!queue_before(index, g_assets.queue[parent])) {
+            break;
+        }
+        queue_place(position, g_assets.queue[parent]);
+        position = parent;
+    }
+    queue_place(position, index);
+}
+
+static void queue_sift_down(uint32_t position) {
+    uint32_t index = g_assets.queue[position];
+    for (;;) {
+        uint32_t child = position * 2 + 1;
+        if (child >= g_assets.queue_count) {
+            break;
+        }
+        if (child + 1 < g_assets.queue_count && queue_before(g_assets.queue[child + 1], g_assets.queue[child])) {
+            child++;
+        }
+        if (!queue_before(g_assets.queue[child], index)) {
+            break;
+        }
+        queue_place(position, g_assets.queue[child]);
+        position = child;
+    }
+    queue_place(position, index);
+}
+
+static bool queue_push(uint32_t index) {
+    if (!grow_array(&g_assets.queue, &g_assets.queue_capacity, g_assets.queue_count)) {
+        return false;
+    }
+    g_assets.queue[g_assets.queue_count] = index;
+    queue_sift_up(g_assets.queue_count++);
+    return true;
+}
+
+static void queue_remove(uint32_t index) {
+    uint32_t position = g_assets.slots[index].queue_index;
+    g_assets.slots[index].queue_index = ASSET_NONE;
+    uint32_t last = g_assets.queue[--g_assets.queue_count];
+    if (position < g_assets.queue_count) {
+        queue_place(position, last);
+        queue_sift_up(position);
+        queue_sift_down(g_assets.slots[last].queue_index);
+    }
+}
+
+/* Cache of ready, unreferenced assets */
+
+static void lru_push(uint32_t index) {
+    ve_asset_slot* slot = &g_assets.slots[index];
+    slot->lru_prev = g_assets.lru_tail;
+    slot->lru_next = ASSET_NONE;
+    if (g_assets.lru_tail != ASSET_NONE) {
+        g_assets.slots[g_assets.lru_tail].lru_next = index;
+    } else {
+        g_assets.lru_head = index;
+    }
+    g_assets.lru_tail = index;
+}
+
+static void lru_remove(uint32_t index) {
+    ve_asset_slot* slot = &g_assets.slots[index];
+    if (slot->lru_prev != ASSET_NONE) {
+        g_assets.slots[slot->lru_prev].lru_next = slot->lru_next;
+    } else {
+        g_assets.lru_head = slot->lru_next;
+    }
+    if (slot->lru_next != ASSET_NONE) {
+        g_assets.slots[slot->lru_next].lru_prev = slot->lru_prev;
+    } else {
+        g_assets.lru_tail = slot->lru_prev;
+    }
+    slot->lru_prev = ASSET_NONE;
+    slot->lru_next = ASSET_NONE;
+}
+
+/* Slots */
+
+static void unload_slot(ve_asset_slot* slot) {
+    if (slot->asset) {
+        const ve_asset_loader* loader = &g_assets.loaders[slot->type];
+        if (loader->unload) {
+            loader->unload(slot->asset, loader->user_data);
+        }
+        g_assets.resident_size -= slot->resident_size;
+    }
+    slot->asset = NULL;
+    slot->resident_size = 0;
+}
+
+static void free_slot(uint32_t index) {
+    ve_asset_slot* slot = &g_assets.slots[index];
+    unload_slot(slot);
+    table_remove(index);
+    VE_FREE(slot->path);
+    slot->path = NULL;
+    slot->state = VE_ASSET_INVALID;
+    slot->generation = (slot->generation + 1) & ASSET_GENERATION_MASK;
+    if (slot->generation == 0) {
+        slot->generation = 1;
+    }
+    slot->lru_next = g_assets.free_slot;
+    g_assets.free_slot = index;
+}
+
+static uint32_t alloc_slot(void) {
+    if (g_assets.free_slot != ASSET_NONE) {
+        uint32_t index = g_assets.free_slot;
+        g_assets.free_slot = g_assets.slots[index].lru_next;
+        return index;
+    }
+
+    if (g_assets.slot_count == VE_ASSET_MAX_ASSETS) {
+        VE_LOG_ERROR("Asset limit (%u) reached", VE_ASSET_MAX_ASSETS);
+        return ASSET_NONE;
+    }
+    if (g_assets.slot_count == g_assets.slot_capacity) {
+        uint32_t capacity = g_assets.slot_capacity ? g_assets.slot_capacity * 2 : 64;
+        ve_asset_slot* slots = (ve_asset_slot*)ve_reallocate(g_assets.slots, capacity * sizeof(ve_asset_slot),
+                                                             VE_MEMORY_TAG_ASSET);
+        if (!slots) {
+            return ASSET_NONE;
+        }
+        g_assets.slots = slots;
+        g_assets.slot_capacity = capacity;
+    }
+    g_assets.slots[g_assets.slot_count].generation = 1;
+    return g_assets.slot_count++;
+}
+
+/* Loading */
+
+/* Task: read and decode one asset, then hand it back to the main thread */
+static void load_job(void* user_data) {
+    asset_job* job = (asset_job*)user_data;
+
+    /* Decoders read the file in place through the mapping */
+    ve_file_mapping mapping;
+    if (ve_atomic_load32(&job->cancelled)) {
+        job->skipped = true;
+    } else if (!ve_file_map(job->path, VE_FILE_ACCESS_SEQUENTIAL, &mapping)) {
+        VE_LOG_ERROR("Failed to read asset %s", job->path);
+    } else {
+        if (ve_atomic_load32(&job->cancelled)) {
+            job->skipped = true;
+        } else {
+            job->success = job->loader.decode(mapping.data, mapping.size, &job->asset, &job->resident_size,
+                                              job->loader.user_data);
+            if (!job->success) {
+                VE_LOG_ERROR("Failed to decode %s asset %s", job->loader.name ? job->loader.name : "", job->path);
+            }
+        }
+        ve_file_unmap(&mapping);
+    }
+
+    ve_mpsc_queue_push(&g_assets.finished, &job->node);
+}
+
+static void start_load(uint32_t index) {
+    ve_asset_slot* slot = &g_assets.slots[index];
+
+    asset_job* job = (asset_job*)ve_allocate_cleared(1, sizeof(asset_job), VE_MEMORY_TAG_ASSET);
+    if (!job) {
+        VE_LOG_ERROR("Out of memory starting the load of %s", slot->path);
+        slot->state = VE_ASSET_FAILED;
+        return;
+    }
+    job->loader = g_assets.loaders[slot->type];
+    job->path = slot->path;
+    job->slot = index;
+
+    slot->state = VE_ASSET_LOADING;
+    slot->job = job;
+    g_assets.in_flight++;
+
+    if (!g_assets.pool || !ve_thread_pool_submit_job(g_assets.pool, load_job, job, NULL, &g_assets.counter)) {
+        load_job(job);
+    }
+}
+
+static void finish_load(asset_job* job) {
+    ve_asset_slot* slot = &g_assets.slots[job->slot];
+    slot->job = NULL;
+    g_assets.in_flight--;
+
+    if (job->success) {
+        slot->asset = job->asset;
+        slot->resident_size = job->resident_size;
+        g_assets.resident_size += job->resident_size;
+    }
+
+    if (slot->cancelled) {
+        free_slot(job->slot);
+    } else if (job->skipped) {
+        /* Requested again after the load gave up on it */
+        slot->state = VE_ASSET_QUEUED;
+        if (!queue_push(job->slot)) {
+            slot->state = VE_ASSET_FAILED;
+        }
+    } else if (!job->success) {
+        slot->state = VE_ASSET_FAILED;
+    } else if (grow_array(&g_assets.uploads, &g_assets.upload_capacity, g_assets.upload_count)) {
+        slot->state = VE_ASSET_UPLOADING;
+        slot->uploaded = false;
+        slot->fence = 0;
+        g_assets.uploads[g_assets.upload_count++] = job->slot;
+    } else {
+        unload_slot(slot);
+        slot->state = VE_ASSET_FAILED;
+    }
+
+    VE_FREE(job);
+}
+
+static void collect_finished(void) {
+    /* A job still inside its push is picked up next update */
+    ve_mpsc_node* node;
+    while ((node = ve_mpsc_queue_pop(&g_assets.finished)) != NULL) {
+        finish_load(VE_MPSC_ELEMENT(node, asset_job, node));
+    }
+}
+
+static void process_uploads(void) {
+    bool ring_full = false;
+    uint32_t kept = 0;
+
+    for (uint32_t i = 0; i < g_assets.upload_count; i++) {
+        uint32_t index = g_assets.uploads[i];
+        ve_asset_slot* slot = &g_assets.slots[index];
+        const ve_asset_loader* loader = &g_assets.loaders[slot->type];
+
+        if (!slot->uploaded && !ring_full) {
+            ve_asset_upload_result result = VE_ASSET_UPLOAD_DONE;
+            if (loader->upload) {
+                result = loader->upload(slot->asset, &slot->fence, loader->user_data);
+            }
+            if (result == VE_ASSET_UPLOAD_FAILED) {
+                VE_LOG_ERROR("Failed to upload %s asset %s", loader->name ? loader->name : "", slot->path);
+                unload_slot(slot);
+                slot->state = VE_ASSET_FAILED;
+                if (slot->ref_count == 0) {
+                    free_slot(index);
+                }
+                continue;
+            }
+            /* Later uploads would not fit either; keep them in order for the next update */
+            ring_full = result == VE_ASSET_UPLOAD_RETRY;
+            slot->uploaded = !ring_full;
+        }
+
+        if (slot->uploaded &&
+            (slot->fence == 0 || !g_assets.is_fence_complete || g_assets.is_fence_complete(slot->fence))) {
+            slot->state = VE_ASSET_READY;
+            g_assets.loaded++;
+            if (slot->ref_count == 0) {
+                lru_push(index);
+            }
+            continue;
+        }
+        g_assets.uploads[kept++] = index;
+    }
+    g_assets.upload_count = kept;
+}
+
+static void evict_over_budget(void) {
+    while (g_assets.resident_size > g_assets.memory_budget && g_assets.lru_head != ASSET_NONE) {
+        uint32_t index = g_assets.lru_head;
+        lru_remove(index);
+        free_slot(index);
+        g_assets.evicted++;
+    }
+}
+
+bool ve_asset_manager_init(const ve_asset_manager_config* config) {
+    if (g_assets.initialized) {
+        return true;
+    }
+
+    ve_asset_manager_config defaults = {0};
+    if (!config) {
+        config = &defaults;
+    }
+
+    memset(&g_assets, 0, sizeof(g_assets));
+    ve_mpsc_queue_init(&g_assets.finished);
+
+    g_assets.pool = config->pool;
+    g_assets.is_fence_complete = config->is_fence_complete;
+    g_assets.memory_budget = config->memory_budget ? config->memory_budget : ve_get_available_memory() / 2;
+    g_assets.max_in_flight = config->max_in_flight;
+    if (g_assets.max_in_flight == 0) {
+        uint32_t threads = ve_thread_pool_get_thread_count(config->pool);
+        g_assets.max_in_flight = threads > 1 ? threads * 2 : 2;
+    }
+    g_assets.free_slot = ASSET_NONE;
+    g_assets.lru_head = ASSET_NONE;
+    g_assets.lru_tail = ASSET_NONE;
+    ve_job_counter_init(&g_assets.counter);
+    g_assets.initialized = true;
+
+    VE_LOG_INFO("Asset manager initialized (budget %zu MB, %u loads in flight)",
+                g_assets.memory_budget / (1024 * 1024), g_assets.max_in_flight);
+    return true;
+}
+
+void ve_asset_manager_shutdown(void) {
+    if (!g_assets.initialized) {
+        return;
+    }
+
+    if (g_assets.pool) {
+        ve_thread_pool_wait_counter(g_assets.pool, &g_assets.counter);
+    }
+    collect_finished();
+
+    for (uint32_t i = 0; i < g_assets.slot_count; i++) {
+        ve_asset_slot* slot = &g_assets.slots[i];
+        if (slot->state != VE_ASSET_INVALID) {
+            unload_slot(slot);
+            VE_FREE(slot->path);
+        }
+    }
+    VE_FREE(g_assets.slots);
+    VE_FREE(g_assets.table);
+    VE_FREE(g_assets.queue);
+    VE_FREE(g_assets.uploads);
+
+    memset(&g_assets, 0, sizeof(g_assets));
+}
+
+uint32_t ve_asset_register_loader(const ve_asset_loader* loader) {
+    VE_ASSERT(g_assets.initialized && loader && loader->decode);
+
+    if (g_assets.loader_count == VE_ASSET_MAX_TYPES) {
+        VE_LOG_ERROR("Asset type limit (%u) reached", VE_ASSET_MAX_TYPES);
+        return UINT32_MAX;
+    }
+    g_assets.loaders[g_assets.loader_count] = *loader;
+    return g_assets.loader_count++;
+}
+
+ve_asset ve_asset_load(const char* path, uint32_t type, float priority) {
+    VE_ASSERT(g_assets.initialized && path);
+    VE_ASSERT_MSG(type < g_assets.loader_count, "Unknown asset type");
+
+    uint64_t hash = hash_string(path);
+    uint32_t index = table_find(hash, path);
+    if (index != ASSET_NONE) {
+        ve_asset_slot* slot = &g_assets.slots[index];
+        if (slot->ref_count++ == 0) {
+            if (slot->state == VE_ASSET_READY) {
+                lru_remove(index);
+            } else if (slot->cancelled) {
+                slot->cancelled = false;
+                ve_atomic_store32(&slot->job->cancelled, 0);
+            }
+        }
+        if (priority > slot->priority) {
+            ve_asset_set_priority((slot->generation << VE_ASSET_INDEX_BITS) | index, priority);
+        }
+        return (slot->generation << VE_ASSET_INDEX_BITS) | index;
+    }
+
+    size_t path_size = strlen(path) + 1;
+    char* path_copy = (char*)VE_ALLOCATE_TAG(path_size, VE_MEMORY_TAG_STRING);
+    index = path_copy ? alloc_slot() : ASSET_NONE;
+    if (index == ASSET_NONE) {
+        VE_FREE(path_copy);
+        return VE_ASSET_NULL;
+    }
+    memcpy(path_copy, path, path_size);
+
+    ve_asset_slot* slot = &g_assets.slots[index];
+    uint32_t generation = slot->generation;
+    memset(slot, 0, sizeof(ve_asset_slot));
+    slot->path = path_copy;
+    slot->hash = hash;
+    slot->priority = priority;
+    slot->type = type;
+    slot->generation = generation;
+    slot->ref_count = 1;
+    slot->queue_index = ASSET_NONE;
+    slot->lru_prev = ASSET_NONE;
+    slot->lru_next = ASSET_NONE;
+    slot->state = VE_ASSET_QUEUED;
+
+    if (!table_insert(index)) {
+        VE_FREE(slot->path);
+        slot->path = NULL;
+        slot->state = VE_ASSET_INVALID;
+        slot->lru_next = g_assets.free_slot;
+        g_assets.free_slot = index;
+        return VE_ASSET_NULL;
+    }
+    if (!queue_push(index)) {
+        free_slot(index);
+        return VE_ASSET_NULL;
+    }
+    return (generation << VE_ASSET_INDEX_BITS) | index;
+}
+
+void ve_asset_set_priority(ve_asset asset, float priority) {
+    ve_asset_slot* slot = get_slot(asset);
+    if (!slot) {
+        return;
+    }
+
+    float previous = slot->priority;
+    slot->priority = priority;
+    if (slot->state == VE_ASSET_QUEUED && slot->queue_index != ASSET_NONE) {
+        if (priority > previous) {
+            queue_sift_up(slot->queue_index);
+        } else {
+            queue_sift_down(slot->queue_index);
+        }
+    }
+}
+
+void ve_asset_release(ve_asset asset) {
+    ve_asset_slot* slot = get_slot(asset);
+    if (!slot || slot->ref_count == 0) {
+        return;
+    }
+    if (--slot->ref_count > 0) {
+        return;
+    }
+
+    uint32_t index = asset & (VE_ASSET_MAX_ASSETS - 1);
+    switch (slot->state) {
+        case VE_ASSET_QUEUED:
+            queue_remove(index);
+            free_slot(index);
+            g_assets.cancelled++;
+            break;
+        case VE_ASSET_LOADING:
+            slot->cancelled = true;
+            ve_atomic_store32(&slot->job->cancelled, 1);
+            g_assets.cancelled++;
+            break;
+        case VE_ASSET_READY:
+            lru_push(index);
+            break;
+        case VE_ASSET_FAILED:
+            free_slot(index);
+            break;
+        default:
+            /* Uploading assets join the cache once ready */
+            break;
+    }
+}
+
+ve_asset_state ve_asset_get_state(ve_asset asset) {
+    const ve_asset_slot* slot = get_slot(asset);
+    return slot ? slot->state : VE_ASSET_INVALID;
+}
+
+void* ve_asset_get(ve_asset asset) {
+    const ve_asset_slot* slot = get_slot(asset);
+    return slot && slot->state == VE_ASSET_READY ? slot->asset : NULL;
+}
+
+void ve_asset_manager_update(void) {
+    if (!g_assets.initialized) {
+        return;
+    }
+
+    collect_finished();
+
+    while (g_assets.in_flight < g_assets.max_in_flight && g_assets.queue_count > 0) {
+        uint32_t index = g_assets.queue[0];
+        queue_remove(index);
+        start_load(index);
+    }
+
+    process_uploads();
+    evict_over_budget();
+}
+
+void ve_asset_manager_get_stats(ve_asset_stats* stats) {
+    VE_ASSERT(stats);
+
+    memset(stats, 0, sizeof(ve_asset_stats));
+    for (uint32_t i = 0; i < g_assets.slot_count; i++) {
+        const ve_asset_slot* slot = &g_assets.slots[i];
+        switch (slot->state) {
+            case VE_ASSET_QUEUED: stats->queued++; break;
+            case VE_ASSET_LOADING: stats->loading++; break;
+            case VE_ASSET_UPLOADING: stats->uploading++; break;
+            case VE_ASSET_READY:
+                stats->ready++;
+                stats->cached += slot->ref_count == 0;
+                break;
+            case VE_ASSET_FAILED: stats->failed++; break;
+            default: break;
+        }
+    }
+    stats->resident_size = g_assets.resident_size;
+    stats->memory_budget = g_assets.memory_budget;
+    stats->loaded = g_assets.loaded;
+    stats->cancelled = g_assets.cancelled;
+    stats->evicted = g_assets.evicted;
+}
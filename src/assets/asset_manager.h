@@ -1,18 +1,214 @@
 /**
  * @file asset_manager.h
  * @brief Asset management
+ *
+ * Assets are streamed in the background. ve_asset_load returns a handle
+ * at once and queues the request; ve_asset_manager_update, called once per
+ * frame on the main thread, starts the most urgent requests on the thread
+ * pool, where the file is mapped and decoded in place by the loader of
+ * the asset's type. Decoded assets are then handed back to the main
+ * thread for upload (typically into the staging ring of upload.h) and
+ * become ready once the GPU reaches the timeline value the upload
+ * returned.
+ *
+ * Requests are ordered by a priority the caller derives from distance or
+ * screen size, and can be re-prioritized while queued. Requests for the
+ * same path share one asset and a reference count; releasing the last
+ * reference cancels a request that has not finished loading. Ready assets
+ * nobody references stay cached, least recently released first out, until
+ * the resident size exceeds the memory budget.
+ *
+ * All functions except the loader callbacks are called from the main
+ * thread.
  */
 
 #ifndef VE_ASSET_MANAGER_H
 #define VE_ASSET_MANAGER_H
 
+#include "../core/thread.h"
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* TODO: Implement asset management */
+/* Asset handle layout: slot index in the low bits, generation above */
+#define VE_ASSET_INDEX_BITS 20
+#define VE_ASSET_MAX_ASSETS (1u << VE_ASSET_INDEX_BITS)
+
+/* Never a live asset */
+#define VE_ASSET_NULL 0u
+
+/* Most registered asset types */
+#define VE_ASSET_MAX_TYPES 16
+
+typedef uint32_t ve_asset;
+
+/**
+ * @brief Asset state
+ */
+typedef enum ve_asset_state {
+    VE_ASSET_INVALID,           /* Stale handle */
+    VE_ASSET_QUEUED,
+    VE_ASSET_LOADING,           /* Being read and decoded on the pool */
+    VE_ASSET_UPLOADING,         /* Decoded, waiting for its upload to complete */
+    VE_ASSET_READY,
+    VE_ASSET_FAILED
+} ve_asset_state;
+
+/**
+ * @brief Result of a loader's upload
+ */
+typedef enum ve_asset_upload_result {
+    VE_ASSET_UPLOAD_DONE,
+    VE_ASSET_UPLOAD_RETRY,      /* No room now (e.g. the staging ring is full), try next update */
+    VE_ASSET_UPLOAD_FAILED
+} ve_asset_upload_result;
+
+/**
+ * @brief Loader of one asset type
+ */
+typedef struct ve_asset_loader {
+    const char* name;
+
+    /**
+     * Decode file contents on a pool thread. The data is a read-only
+     * mapping of the file, valid only during the call. Sets the asset and
+     * the bytes it keeps resident; returns false on failure.
+     */
+    bool (*decode)(const void* data, size_t size, void** asset, size_t* resident_size, void* user_data);
+
+    /**
+     * Queue the GPU upload of a decoded asset on the main thread (NULL if
+     * there is none). Sets fence to the timeline value that marks
+     * completion, or leaves it 0 if the asset is usable at once.
+     */
+    ve_asset_upload_result (*upload)(void* asset, uint64_t* fence, void* user_data);
+
+    /* Free a decoded asset on the main thread */
+    void (*unload)(void* asset, void* user_data);
+
+    void* user_data;
+} ve_asset_loader;
+
+/**
+ * @brief Asset manager configuration
+ *
+ * Zeroed fields select the defaults.
+ */
+typedef struct ve_asset_manager_config {
+    ve_thread_pool* pool;           /* NULL loads on the main thread during updates */
+    size_t memory_budget;           /* Resident bytes, 0 for half of the available memory */
+    uint32_t max_in_flight;         /* Requests loading at once, 0 for two per worker */
+
+    /* Check if an upload fence was reached, e.g. ve_upload_is_complete; NULL treats fences as reached */
+    bool (*is_fence_complete)(uint64_t fence);
+} ve_asset_manager_config;
+
+/**
+ * @brief Asset manager statistics
+ */
+typedef struct ve_asset_stats {
+    uint32_t queued;
+    uint32_t loading;
+    uint32_t uploading;
+    uint32_t ready;
+    uint32_t cached;                /* Ready and unreferenced, eviction candidates */
+    uint32_t failed;
+    size_t resident_size;
+    size_t memory_budget;
+    uint64_t loaded;                /* Assets that became ready over the manager's lifetime */
+    uint64_t cancelled;
+    uint64_t evicted;
+} ve_asset_stats;
+
+/**
+ * @brief Initialize the asset manager
+ *
+ * @param config Configuration, NULL for the defaults
+ * @return true on success
+ */
+bool ve_asset_manager_init(const ve_asset_manager_config* config);
+
+/**
+ * @brief Wait for loads in flight and unload every asset
+ */
+void ve_asset_manager_shutdown(void);
+
+/**
+ * @brief Register the loader of an asset type
+ *
+ * @param loader Loader, copied
+ * @return Asset type, or UINT32_MAX if the type table is full
+ */
+uint32_t ve_asset_register_loader(const ve_asset_loader* loader);
+
+/**
+ * @brief Request an asset
+ *
+ * Returns the existing asset if the path was requested before, raising its
+ * priority if the new one is higher. Each call adds a reference.
+ *
+ * @param path File path
+ * @param type Asset type from ve_asset_register_loader
+ * @param priority Larger loads sooner, e.g. screen size or negated distance
+ * @return Asset, or VE_ASSET_NULL if out of memory
+ */
+ve_asset ve_asset_load(const char* path, uint32_t type, float priority);
+
+/**
+ * @brief Change the priority of a queued request
+ *
+ * Has no effect once loading has started.
+ *
+ * @param asset Asset
+ * @param priority Larger loads sooner
+ */
+void ve_asset_set_priority(ve_asset asset, float priority);
+
+/**
+ * @brief Drop a reference
+ *
+ * Releasing the last reference cancels a queued or loading request; a
+ * ready asset stays cached until it is evicted. Stale handles are ignored.
+ *
+ * @param asset Asset
+ */
+void ve_asset_release(ve_asset asset);
+
+/**
+ * @brief Get the state of an asset
+ *
+ * @param asset Asset
+ * @return State, VE_ASSET_INVALID for stale handles
+ */
+ve_asset_state ve_asset_get_state(ve_asset asset);
+
+/**
+ * @brief Get a ready asset
+ *
+ * @param asset Asset
+ * @return Decoded asset, or NULL if it is not ready
+ */
+void* ve_asset_get(ve_asset asset);
+
+/**
+ * @brief Advance streaming
+ *
+ * Collects finished loads, queues and completes uploads, starts the most
+ * urgent queued requests and evicts cached assets over the budget. Call
+ * once per frame.
+ */
+void ve_asset_manager_update(void);
+
+/**
+ * @brief Get asset manager statistics
+ *
+ * @param stats Output statistics
+ */
+void ve_asset_manager_get_stats(ve_asset_stats* stats);
 
 #ifdef __cplusplus
 }
@@ -1,8 +1,1683 @@
 /**
  * @file model_loader.c
- * @brief glTF/OBJ model loading implementation
+ * @brief Model loading implementation
  */
 
 #include "model_loader.h"
+#include "../core/memory.h"
+#include "../core/logger.h"
+#include "../core/assert.h"
 
-/* TODO: Implement model loading */
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Marks a source vertex not yet in the current meshlet */
+#define MESHLET_UNUSED 0xFF
+
+/* Alignment of the arrays in a cooked mesh blob */
+#define MESH_BLOB_ALIGNMENT 16
+
+/* A level of detail must have at most this fraction of the previous level's triangles */
+#define MESH_LOD_MIN_REDUCTION 0.85f
+
+/**
+ * @brief OBJ face corner, 1-based attribute indices, 0 when absent
+ */
+typedef struct obj_corner {
+    uint32_t position;
+    uint32_t uv;
+    uint32_t normal;
+} obj_corner;
+
+static const float* vertex_position(const float* positions, size_t stride, uint32_t index) {
+    return (const float*)((const uint8_t*)positions + (size_t)index * stride);
+}
+
+/**
+ * @brief Compute the bounding sphere and normal cone of a finished meshlet
+ */
+static void compute_meshlet_bounds(ve_meshlet* meshlet, const ve_meshlet_data* data,
+                                   const float* positions, size_t stride) {
+    const uint32_t* vertices = data->vertices + meshlet->vertex_offset;
+    const uint8_t* triangles = data->triangles + meshlet->triangle_offset;
+
+    /* Sphere around the box center; not minimal, but cheap and conservative */
+    float min[3] = {INFINITY, INFINITY, INFINITY};
+    float max[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for (uint32_t i = 0; i < meshlet->vertex_count; i++) {
+        const float* p = vertex_position(positions, stride, vertices[i]);
+        for (uint32_t c = 0; c < 3; c++) {
+            min[c] = fminf(min[c], p[c]);
+            max[c] = fmaxf(max[c], p[c]);
+        }
+    }
+
+    float radius_squared = 0.0f;
+    for (uint32_t c = 0; c < 3; c++) {
+        meshlet->center[c] = (min[c] + max[c]) * 0.5f;
+    }
+    for (uint32_t i = 0; i < meshlet->vertex_count; i++) {
+        const float* p = vertex_position(positions, stride, vertices[i]);
+        float dx = p[0] - meshlet->center[0];
+        float dy = p[1] - meshlet->center[1];
+        float dz = p[2] - meshlet->center[2];
+        radius_squared = fmaxf(radius_squared, dx * dx + dy * dy + dz * dz);
+    }
+    meshlet->radius = sqrtf(radius_squared);
+
+    /* Cone axis is the mean unit normal; the cone is as wide as the widest deviation from it */
+    float normals[VE_MESHLET_MAX_TRIANGLES][3];
+    float axis[3] = {0.0f, 0.0f, 0.0f};
+    for (uint32_t t = 0; t < meshlet->triangle_count; t++) {
+        const float* a = vertex_position(positions, stride, vertices[triangles[t * 3 + 0]]);
+        const float* b = vertex_position(positions, stride, vertices[triangles[t * 3 + 1]]);
+        const float* c = vertex_position(positions, stride, vertices[triangles[t * 3 + 2]]);
+        float e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+        float e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+        float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+        float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        float scale = length > 0.0f ? 1.0f / length : 0.0f;
+        for (uint32_t k = 0; k < 3; k++) {
+            normals[t][k] = n[k] * scale;
+            axis[k] += normals[t][k];
+        }
+    }
+
+    float axis_length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    float min_dot = axis_length > 0.0f ? 1.0f : -1.0f;
+    for (uint32_t k = 0; k < 3; k++) {
+        meshlet->cone_axis[k] = axis_length > 0.0f ? axis[k] / axis_length : 0.0f;
+    }
+    for (uint32_t t = 0; t < meshlet->triangle_count; t++) {
+        float d = normals[t][0] * meshlet->cone_axis[0] + normals[t][1] * meshlet->cone_axis[1] +
+                  normals[t][2] * meshlet->cone_axis[2];
+        min_dot = fminf(min_dot, d);
+    }
+
+    /* Normals spread over a hemisphere or more can always face the camera */
+    meshlet->cone_cutoff = min_dot <= 0.0f ? 1.0f : sqrtf(1.0f - min_dot * min_dot);
+}
+
+bool ve_meshlet_build(const uint32_t* indices, uint32_t index_count,
+                      const float* positions, uint32_t vertex_count, size_t position_stride,
+                      ve_meshlet_data* out) {
+    VE_ASSERT(indices && positions && out && position_stride >= 3 * sizeof(float));
+    VE_ASSERT_MSG(index_count % 3 == 0, "Index count must be a multiple of 3");
+
+    memset(out, 0, sizeof(ve_meshlet_data));
+    uint32_t triangle_count = index_count / 3;
+    if (triangle_count == 0) {
+        return true;
+    }
+
+    /* Worst case is one triangle per meshlet; the meshlet array is shrunk afterwards */
+    out->meshlets = (ve_meshlet*)VE_ALLOCATE_TAG(triangle_count * sizeof(ve_meshlet), VE_MEMORY_TAG_MESH);
+    out->vertices = (uint32_t*)VE_ALLOCATE_TAG(index_count * sizeof(uint32_t), VE_MEMORY_TAG_MESH);
+    out->triangles = (uint8_t*)VE_ALLOCATE_TAG(index_count, VE_MEMORY_TAG_MESH);
+    uint8_t* local = (uint8_t*)VE_ALLOCATE_TAG(vertex_count, VE_MEMORY_TAG_MESH);
+    if (!out->meshlets || !out->vertices || !out->triangles || !local) {
+        VE_LOG_ERROR("Failed to allocate meshlets for %u triangles", triangle_count);
+        VE_FREE(local);
+        ve_meshlet_free(out);
+        return false;
+    }
+    memset(local, MESHLET_UNUSED, vertex_count);
+
+    ve_meshlet current = {0};
+    for (uint32_t t = 0; t <= triangle_count; t++) {
+        uint32_t a = 0, b = 0, c = 0;
+        uint32_t fresh = 0;
+        bool last = t == triangle_count;
+        if (!last) {
+            a = indices[t * 3 + 0];
+            b = indices[t * 3 + 1];
+            c = indices[t * 3 + 2];
+            if (a >= vertex_count || b >= vertex_count || c >= vertex_count) {
+                VE_LOG_ERROR("Meshlet build: index out of range in triangle %u", t);
+                VE_FREE(local);
+                ve_meshlet_free(out);
+                return false;
+            }
+            /* Degenerate triangles rasterize nothing */
+            if (a == b || b == c || a == c) {
+                continue;
+            }
+            fresh = (local[a] == MESHLET_UNUSED) + (local[b] == MESHLET_UNUSED) + (local[c] == MESHLET_UNUSED);
+        }
+
+        /* Close the meshlet when the triangle does not fit, and after the last one */
+        bool full = current.vertex_count + fresh > VE_MESHLET_MAX_VERTICES ||
+                    current.triangle_count == VE_MESHLET_MAX_TRIANGLES;
+        if ((last || full) && current.triangle_count > 0) {
+            compute_meshlet_bounds(&current, out, positions, position_stride);
+            for (uint32_t i = 0; i < current.vertex_count; i++) {
+                local[out->vertices[current.vertex_offset + i]] = MESHLET_UNUSED;
+            }
+            out->meshlets[out->meshlet_count++] = current;
+            current = (ve_meshlet){
+                .vertex_offset = out->vertex_count,
+                .triangle_offset = out->triangle_count * 3,
+            };
+        }
+        if (last) {
+            break;
+        }
+
+        const uint32_t corners[3] = {a, b, c};
+        for (uint32_t k = 0; k < 3; k++) {
+            if (local[corners[k]] == MESHLET_UNUSED) {
+                local[corners[k]] = (uint8_t)current.vertex_count++;
+                out->vertices[out->vertex_count++] = corners[k];
+            }
+            out->triangles[out->triangle_count * 3 + k] = local[corners[k]];
+        }
+        out->triangle_count++;
+        current.triangle_count++;
+    }
+
+    VE_FREE(local);
+
+    if (out->meshlet_count > 0) {
+        ve_meshlet* shrunk = (ve_meshlet*)ve_reallocate(out->meshlets, out->meshlet_count * sizeof(ve_meshlet),
+                                                        VE_MEMORY_TAG_MESH);
+        if (shrunk) {
+            out->meshlets = shrunk;
+        }
+    }
+    return true;
+}
+
+void ve_meshlet_free(ve_meshlet_data* data) {
+    if (!data) {
+        return;
+    }
+    VE_FREE(data->meshlets);
+    VE_FREE(data->vertices);
+    VE_FREE(data->triangles);
+    memset(data, 0, sizeof(ve_meshlet_data));
+}
+
+bool ve_meshlet_is_backfacing(const ve_meshlet* meshlet, const float camera_position[3]) {
+    VE_ASSERT(meshlet && camera_position);
+
+    /* The whole sphere must lie inside the cone of directions from which every triangle faces away */
+    float v[3] = {
+        meshlet->center[0] - camera_position[0],
+        meshlet->center[1] - camera_position[1],
+        meshlet->center[2] - camera_position[2],
+    };
+    float distance = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    float along = v[0] * meshlet->cone_axis[0] + v[1] * meshlet->cone_axis[1] + v[2] * meshlet->cone_axis[2];
+    return along >= meshlet->cone_cutoff * distance + meshlet->radius;
+}
+
+/* Mesh optimization */
+
+/* Cache the vertex cache optimizer scores for; larger than real caches so it plans ahead */
+#define FORSYTH_CACHE_SIZE 32
+
+/* Valences with a precomputed score */
+#define FORSYTH_MAX_VALENCE 32
+
+/* Shortest run the overdraw optimizer splits off outside of cold cache starts */
+#define OVERDRAW_MIN_CLUSTER 32
+
+#define OPTIMIZER_NONE UINT32_MAX
+
+/**
+ * @brief Simulated FIFO post-transform cache
+ */
+typedef struct fifo_cache {
+    uint32_t entries[64];
+    uint32_t size;
+    uint32_t count;
+    uint32_t head;
+} fifo_cache;
+
+/* Returns true on a miss, which inserts the vertex */
+static bool fifo_cache_touch(fifo_cache* cache, uint32_t vertex) {
+    for (uint32_t i = 0; i < cache->count; i++) {
+        if (cache->entries[i] == vertex) {
+            return false;
+        }
+    }
+    cache->entries[cache->head] = vertex;
+    cache->head = (cache->head + 1) % cache->size;
+    if (cache->count < cache->size) {
+        cache->count++;
+    }
+    return true;
+}
+
+float ve_mesh_get_acmr(const uint32_t* indices, uint32_t index_count, uint32_t cache_size) {
+    VE_ASSERT(indices || index_count == 0);
+    VE_ASSERT_MSG(cache_size > 0 && cache_size <= 64, "Cache size must be 1 to 64");
+
+    if (index_count < 3) {
+        return 0.0f;
+    }
+    fifo_cache cache = {.size = cache_size};
+    uint32_t misses = 0;
+    for (uint32_t i = 0; i < index_count; i++) {
+        misses += fifo_cache_touch(&cache, indices[i]);
+    }
+    return (float)misses / (float)(index_count / 3);
+}
+
+/**
+ * @brief Score tables of the vertex cache optimizer
+ */
+typedef struct forsyth_scores {
+    float cache[FORSYTH_CACHE_SIZE];
+    float valence[FORSYTH_MAX_VALENCE + 1];
+} forsyth_scores;
+
+static void forsyth_init_scores(forsyth_scores* scores) {
+    /* The last triangle's vertices score the same, so its orientation does not matter */
+    for (uint32_t i = 0; i < FORSYTH_CACHE_SIZE; i++) {
+        scores->cache[i] = i < 3 ? 0.75f : powf(1.0f - (float)(i - 3) / (FORSYTH_CACHE_SIZE - 3), 1.5f);
+    }
+
+    /* Vertices with few triangles left are finished early, so they stop occupying the cache */
+    scores->valence[0] = 0.0f;
+    for (uint32_t i = 1; i <= FORSYTH_MAX_VALENCE; i++) {
+        scores->valence[i] = 2.0f / sqrtf((float)i);
+    }
+}
+
+static float forsyth_vertex_score(const forsyth_scores* scores, uint32_t cache_position, uint32_t remaining) {
+    if (remaining == 0) {
+        return -1.0f;
+    }
+    float score = cache_position < FORSYTH_CACHE_SIZE ? scores->cache[cache_position] : 0.0f;
+    return score + (remaining <= FORSYTH_MAX_VALENCE ? scores->valence[remaining] : 2.0f / sqrtf((float)remaining));
+}
+
+/**
+ * @brief Working arrays of the vertex cache optimizer
+ */
+typedef struct forsyth_state {
+    uint32_t* adjacency_offsets;    /* Per vertex, into adjacency */
+    uint32_t* adjacency;            /* Unemitted triangles of each vertex first */
+    uint32_t* remaining;            /* Unemitted triangles per vertex */
+    uint32_t* cache_positions;
+    float* vertex_scores;
+    float* triangle_scores;
+    bool* emitted;
+    uint32_t* output;
+} forsyth_state;
+
+static void forsyth_reorder(forsyth_state* state, const uint32_t* indices, uint32_t index_count,
+                            uint32_t vertex_count) {
+    uint32_t triangle_count = index_count / 3;
+    uint32_t* adjacency_offsets = state->adjacency_offsets;
+    uint32_t* adjacency = state->adjacency;
+    uint32_t* remaining = state->remaining;
+    uint32_t* cache_positions = state->cache_positions;
+    float* vertex_scores = state->vertex_scores;
+    float* triangle_scores = state->triangle_scores;
+
+    for (uint32_t i = 0; i < index_count; i++) {
+        VE_ASSERT_MSG(indices[i] < vertex_count, "Index out of range");
+        remaining[indices[i]]++;
+    }
+    for (uint32_t v = 0; v < vertex_count; v++) {
+        adjacency_offsets[v + 1] = adjacency_offsets[v] + remaining[v];
+        remaining[v] = 0;
+    }
+    for (uint32_t i = 0; i < index_count; i++) {
+        uint32_t v = indices[i];
+        adjacency[adjacency_offsets[v] + remaining[v]++] = i / 3;
+    }
+
+    forsyth_scores scores;
+    forsyth_init_scores(&scores);
+    for (uint32_t v = 0; v < vertex_count; v++) {
+        cache_positions[v] = OPTIMIZER_NONE;
+        vertex_scores[v] = forsyth_vertex_score(&scores, OPTIMIZER_NONE, remaining[v]);
+    }
+
+    uint32_t best = 0;
+    for (uint32_t t = 0; t < triangle_count; t++) {
+        const uint32_t* triangle = &indices[t * 3];
+        triangle_scores[t] = vertex_scores[triangle[0]] + vertex_scores[triangle[1]] + vertex_scores[triangle[2]];
+        if (triangle_scores[t] > triangle_scores[best]) {
+            best = t;
+        }
+    }
+
+    /* Three slots past the scored size hold the vertices pushed out by the last triangle */
+    uint32_t cache[FORSYTH_CACHE_SIZE + 3];
+    uint32_t cache_count = 0;
+    uint32_t scan = 0;
+    for (uint32_t emitted_count = 0; emitted_count < triangle_count; emitted_count++) {
+        /* Nothing in the cache has triangles left: continue with the next unemitted triangle */
+        if (best == OPTIMIZER_NONE) {
+            while (state->emitted[scan]) {
+                scan++;
+            }
+            best = scan;
+        }
+
+        const uint32_t* triangle = &indices[best * 3];
+        memcpy(&state->output[emitted_count * 3], triangle, 3 * sizeof(uint32_t));
+        state->emitted[best] = true;
+        for (uint32_t k = 0; k < 3; k++) {
+            uint32_t v = triangle[k];
+            uint32_t* triangles = &adjacency[adjacency_offsets[v]];
+            for (uint32_t j = 0; j < remaining[v]; j++) {
+                if (triangles[j] == best) {
+                    triangles[j] = triangles[--remaining[v]];
+                    break;
+                }
+            }
+        }
+
+        /* The triangle's vertices move to the front, the rest shift back */
+        uint32_t next_cache[FORSYTH_CACHE_SIZE + 3];
+        uint32_t next_count = 0;
+        for (uint32_t k = 0; k < 3; k++) {
+            bool duplicate = false;
+            for (uint32_t j = 0; j < next_count; j++) {
+                duplicate |= next_cache[j] == triangle[k];
+            }
+            if (!duplicate) {
+                next_cache[next_count++] = triangle[k];
+            }
+        }
+        for (uint32_t i = 0; i < cache_count; i++) {
+            uint32_t v = cache[i];
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+                next_cache[next_count++] = v;
+            }
+        }
+
+        /* Rescore the cached vertices and their triangles, then pick the best of those */
+        for (uint32_t i = 0; i < next_count; i++) {
+            uint32_t v = next_cache[i];
+            cache_positions[v] = i < FORSYTH_CACHE_SIZE ? i : OPTIMIZER_NONE;
+            float score = forsyth_vertex_score(&scores, cache_positions[v], remaining[v]);
+            float delta = score - vertex_scores[v];
+            vertex_scores[v] = score;
+            const uint32_t* triangles = &adjacency[adjacency_offsets[v]];
+            for (uint32_t j = 0; j < remaining[v]; j++) {
+                triangle_scores[triangles[j]] += delta;
+            }
+        }
+
+        cache_count = next_count < FORSYTH_CACHE_SIZE ? next_count : FORSYTH_CACHE_SIZE;
+        memcpy(cache, next_cache, cache_count * sizeof(uint32_t));
+        best = OPTIMIZER_NONE;
+        float best_score = -INFINITY;
+        for (uint32_t i = 0; i < cache_count; i++) {
+            const uint32_t* triangles = &adjacency[adjacency_offsets[cache[i]]];
+            for (uint32_t j = 0; j < remaining[cache[i]]; j++) {
+                if (triangle_scores[triangles[j]] > best_score) {
+                    best = triangles[j];
+                    best_score = triangle_scores[triangles[j]];
+                }
+            }
+        }
+    }
+}
+
+bool ve_mesh_optimize_vertex_cache(uint32_t* indices, uint32_t index_count, uint32_t vertex_count) {
+    VE_ASSERT(indices || index_count == 0);
+    VE_ASSERT_MSG(index_count % 3 == 0, "Index count must be a multiple of 3");
+
+    uint32_t triangle_count = index_count / 3;
+    if (triangle_count < 2) {
+        return true;
+    }
+
+    forsyth_state state = {
+        .adjacency_offsets = (uint32_t*)ve_allocate_cleared(vertex_count + 1, sizeof(uint32_t), VE_MEMORY_TAG_MESH),
+        .adjacency = (uint32_t*)VE_ALLOCATE_TAG(index_count * sizeof(uint32_t), VE_MEMORY_TAG_MESH),
+        .remaining = (uint32_t*)ve_allocate_cleared(vertex_count, sizeof(uint32_t), VE_MEMORY_TAG_MESH),
+        .cache_positions = (uint32_t*)VE_ALLOCATE_TAG(vertex_count * sizeof(uint32_t), VE_MEMORY_TAG_MESH),
+        .vertex_scores = (float*)VE_ALLOCATE_TAG(vertex_count * sizeof(float), VE_MEMORY_TAG_MESH),
+        .triangle_scores = (float*)VE_ALLOCATE_TAG(triangle_count * sizeof(float), VE_MEMORY_TAG_MESH),
+        .emitted = (bool*)ve_allocate_cleared(triangle_count, sizeof(bool), VE_MEMORY_TAG_MESH),
+        .output = (uint32_t*)VE_ALLOCATE_TAG(index_count * sizeof(uint32_t), VE_MEMORY_TAG_MESH),
+    };
+    bool success = state.adjacency_offsets && state.adjacency && state.remaining && state.cache_positions &&
+                   state.vertex_scores && state.triangle_scores && state.emitted && state.output;
+    if (success) {
+        forsyth_reorder(&state, indices, index_count, vertex_count);
+        memcpy(indices, state.output, index_count * sizeof(uint32_t));
+    } else {
+        VE_LOG_ERROR("Out of memory optimizing %u triangles for the vertex cache", triangle_count);
+    }
+
+    VE_FREE(state.adjacency_offsets);
+    VE_FREE(state.adjacency);
+    VE_FREE(state.remaining);
+    VE_FREE(state.cache_positions);
+    VE_FREE(state.vertex_scores);
+    VE_FREE(state.triangle_scores);
+    VE_FREE(state.emitted);
+    VE_FREE(state.output);
+    return success;
+}
+
+/**
+ * @brief Run of triangles the overdraw optimizer moves as one
+ */
+typedef struct overdraw_cluster {
+    uint32_t first_triangle;
+    uint32_t triangle_count;
+    float sort_key;                 /* How far the run faces out of the mesh */
+} overdraw_cluster;
+
+/* Most outward first, keeping the cache order among equals */
+static int compare_clusters(const void* a, const void* b) {
+    const overdraw_cluster* first = (const overdraw_cluster*)a;
+    const overdraw_cluster* second = (const overdraw_cluster*)b;
+    if (first->sort_key != second->sort_key) {
+        return first->sort_key > second->sort_key ? -1 : 1;
+    }
+    return first->first_triangle < second->first_triangle ? -1 : 1;
+}
+
+bool ve_mesh_optimize_overdraw(uint32_t* indices, uint32_t index_count, const float* positions,
+                               uint32_t vertex_count, size_t position_stride, float threshold) {
+    VE_ASSERT((indices || index_count == 0) && positions);
+    VE_ASSERT_MSG(index_count % 3 == 0, "Index count must be a multiple of 3");
+    (void)vertex_count;
+
+    uint32_t triangle_count = index_count / 3;
+    if (triangle_count < 2) {
+        return true;
+    }
+
+    overdraw_cluster* clusters = (overdraw_cluster*)VE_ALLOCATE_TAG(triangle_count * sizeof(overdraw_cluster),
+                                                                    VE_MEMORY_TAG_MESH);
+    uint32_t* output = (uint32_t*)VE_ALLOCATE_TAG(index_count * sizeof(uint32_t), VE_MEMORY_TAG_MESH);
+    if (!clusters || !output) {
+        VE_LOG_ERROR("Out of memory optimizing %u triangles for overdraw", triangle_count);
+        VE_FREE(clusters);
+        VE_FREE(output);
+        return false;
+    }
+
+    /* Runs begin where the cache is cold, or where the run so far is about as cache friendly as the mesh */
+    float limit = ve_mesh_get_acmr(indices, index_count, VE_MESH_VERTEX_CACHE_SIZE) * threshold;
+    fifo_cache cache = {.size = VE_MESH_VERTEX_CACHE_SIZE};
+    uint32_t cluster_count = 0;
+    uint32_t cluster_misses = 0;
+    for (uint32_t t = 0; t < triangle_count; t++) {
+        uint32_t misses = 0;
+        for (uint32_t k = 0; k < 3; k++) {
+            misses += fifo_cache_touch(&cache, indices[t * 3 + k]);
+        }
+
+        bool split = cluster_count == 0 || misses == 3;
+        if (!split) {
+            overdraw_cluster* current = &clusters[cluster_count - 1];
+            uint32_t length = t - current->first_triangle;
+            split = length >= OVERDRAW_MIN_CLUSTER && (float)cluster_misses <= limit * (float)length;
+        }
+        if (split) {
+            clusters[cluster_count++] = (overdraw_cluster){t, 0, 0.0f};
+            cluster_misses = 0;
+        }
+        clusters[cluster_count - 1].triangle_count++;
+        cluster_misses += misses;
+    }
+
+    /* Area-weighted centroids and normals: a run facing away from the mesh center occludes the rest */
+    float mesh_centroid[3] = {0.0f, 0.0f, 0.0f};
+    float mesh_area = 0.0f;
+    for (uint32_t pass = 0; pass < 2; pass++) {
+        for (uint32_t c = 0; c < cluster_count; c++) {
+            overdraw_cluster* cluster = &clusters[c];
+            float centroid[3] = {0.0f, 0.0f, 0.0f};
+            float normal[3] = {0.0f, 0.0f, 0.0f};
+            float area = 0.0f;
+            for (uint32_t t = cluster->first_triangle; t < cluster->first_triangle + cluster->triangle_count; t++) {
+                const float* a = vertex_position(positions, position_stride, indices[t * 3 + 0]);
+                const float* b = vertex_position(positions, position_stride, indices[t * 3 + 1]);
+                const float* p = vertex_position(positions, position_stride, indices[t * 3 + 2]);
+                float e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+                float e2[3] = {p[0] - a[0], p[1] - a[1], p[2] - a[2]};
+                float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2],
+                              e1[0] * e2[1] - e1[1] * e2[0]};
+                float triangle_area = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                for (uint32_t j = 0; j < 3; j++) {
+                    centroid[j] += (a[j] + b[j] + p[j]) * triangle_area / 3.0f;
+                    normal[j] += n[j];
+                }
+                area += triangle_area;
+            }
+
+            if (pass == 0) {
+                for (uint32_t j = 0; j < 3; j++) {
+                    mesh_centroid[j] += centroid[j];
+                }
+                mesh_area += area;
+                continue;
+            }
+
+            float normal_length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            float scale = area > 0.0f ? 1.0f / area : 0.0f;
+            float normal_scale = normal_length > 0.0f ? 1.0f / normal_length : 0.0f;
+            cluster->sort_key = 0.0f;
+            for (uint32_t j = 0; j < 3; j++) {
+                cluster->sort_key += (centroid[j] * scale - mesh_centroid[j]) * normal[j] * normal_scale;
+            }
+        }
+        if (pass == 0) {
+            float scale = mesh_area > 0.0f ? 1.0f / mesh_area : 0.0f;
+            for (uint32_t j = 0; j < 3; j++) {
+                mesh_centroid[j] *= scale;
+            }
+        }
+    }
+
+    qsort(clusters, cluster_count, sizeof(overdraw_cluster), compare_clusters);
+    uint32_t written = 0;
+    for (uint32_t c = 0; c < cluster_count; c++) {
+        size_t count = (size_t)clusters[c].triangle_count * 3;
+        memcpy(&output[written], &indices[clusters[c].first_triangle * 3], count * sizeof(uint32_t));
+        written += (uint32_t)count;
+    }
+    memcpy(indices, output, index_count * sizeof(uint32_t));
+
+    VE_FREE(clusters);
+    VE_FREE(output);
+    return true;
+}
+
+bool ve_mesh_optimize_vertex_fetch(ve_mesh_vertex* vertices, uint32_t* vertex_count, uint32_t* indices,
+                                   uint32_t index_count) {
+    VE_ASSERT(vertices && vertex_count && (indices || index_count == 0));
+
+    uint32_t count = *vertex_count;
+    uint32_t* remap = (uint32_t*)VE_ALLOCATE_TAG((size_t)count * sizeof(uint32_t), VE_MEMORY_TAG_MESH);
+    ve_mesh_vertex* reordered = (ve_mesh_vertex*)VE_ALLOCATE_TAG((size_t)count * sizeof(ve_mesh_vertex),
+                                                                 VE_MEMORY_TAG_MESH);
+    if (!remap || !reordered) {
+        VE_LOG_ERROR("Out of memory reordering %u vertices", count);
+        VE_FREE(remap);
+        VE_FREE(reordered);
+        return false;
+    }
+
+    /* Vertices are stored in the order the index buffer first reaches them */
+    memset(remap, 0xff, (size_t)count * sizeof(uint32_t));
+    uint32_t next = 0;
+    for (uint32_t i = 0; i < index_count; i++) {
+        uint32_t v = indices[i];
+        VE_ASSERT_MSG(v < count, "Index out of range");
+        if (remap[v] == OPTIMIZER_NONE) {
+            reordered[next] = vertices[v];
+            remap[v] = next++;
+        }
+        indices[i] = remap[v];
+    }
+    memcpy(vertices, reordered, (size_t)next * sizeof(ve_mesh_vertex));
+    *vertex_count = next;
+
+    VE_FREE(remap);
+    VE_FREE(reordered);
+    return true;
+}
+
+/* Simplification */
+
+#define SIMPLIFY_EMPTY_EDGE UINT64_MAX
+
+/**
+ * @brief Area-weighted sum of squared distances to a set of planes
+ */
+typedef struct quadric {
+    double a00, a01, a02, a11, a12, a22;
+    double b0, b1, b2;
+    double c;
+    double weight;
+} quadric;
+
+/**
+ * @brief Candidate collapse of one vertex onto a neighbour
+ */
+typedef struct simplify_collapse {
+    uint32_t from;
+    uint32_t to;
+    float cost;                     /* Mean squared distance to the planes of both vertices */
+} simplify_collapse;
+
+/**
+ * @brief Working arrays of the simplifier
+ */
+typedef struct simplify_state {
+    const float* positions;
+    size_t stride;
+    uint32_t vertex_count;
+    bool* locked;
+    quadric* quadrics;
+    uint32_t* adjacency_offsets;
+    uint32_t* adjacency;
+    uint32_t* remap;
+    bool* touched;
+    simplify_collapse* collapses;
+} simplify_state;
+
+static void quadric_add_plane(quadric* q, const float normal[3], float distance, float weight) {
+    double a = normal[0], b = normal[1], c = normal[2], d = distance, w = weight;
+    q->a00 += w * a * a;
+    q->a01 += w * a * b;
+    q->a02 += w * a * c;
+    q->a11 += w * b * b;
+    q->a12 += w * b * c;
+    q->a22 += w * c * c;
+    q->b0 += w * a * d;
+    q->b1 += w * b * d;
+    q->b2 += w * c * d;
+    q->c += w * d * d;
+    q->weight += w;
+}
+
+static void quadric_add(quadric* q, const quadric* other) {
+    q->a00 += other->a00;
+    q->a01 += other->a01;
+    q->a02 += other->a02;
+    q->a11 += other->a11;
+    q->a12 += other->a12;
+    q->a22 += other->a22;
+    q->b0 += other->b0;
+    q->b1 += other->b1;
+    q->b2 += other->b2;
+    q->c += other->c;
+    q->weight += other->weight;
+}
+
+/* Mean squared distance of a point to the planes of both quadrics */
+static float quadric_error(const quadric* q, const quadric* other, const float p[3]) {
+    quadric sum = *q;
+    quadric_add(&sum, other);
+    double x = p[0], y = p[1], z = p[2];
+    double error = sum.a00 * x * x + sum.a11 * y * y + sum.a22 * z * z +
+                   2.0 * (sum.a01 * x * y + sum.a02 * x * z + sum.a12 * y * z) +
+                   2.0 * (sum.b0 * x + sum.b1 * y + sum.b2 * z) + sum.c;
+    return sum.weight > 0.0 && error > 0.0 ? (float)(error / sum.weight) : 0.0f;
+}
+
+static void triangle_normal(const float* a, const float* b, const float* c, float normal[3]) {
+    float e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    float e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+static uint32_t hash_u64(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+    return (uint32_t)value;
+}
+
+static uint32_t hash_position(const float* p) {
+    uint32_t bits[3];
+    memcpy(bits, p, sizeof(bits));
+    return hash_u64(((uint64_t)bits[0] << 32 | bits[1]) ^ ((uint64_t)bits[2] * 0x9e3779b97f4a7c15ull));
+}
+
+static uint32_t table_capacity(uint32_t count) {
+    uint32_t capacity = 64;
+    while (capacity < count * 2) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+/**
+ * @brief Lock the vertices collapses must not move
+ *
+ * Vertices sharing a position sit on an attribute seam, where moving one
+ * copy would tear the surface. Edges of a single triangle lie on an open
+ * border, and edges used twice in one direction are non-manifold.
+ */
+static bool simplify_lock_vertices(simplify_state* state, const uint32_t* indices, uint32_t index_count) {
+    uint32_t vertex_count = state->vertex_count;
+    uint32_t position_capacity = table_capacity(vertex_count);
+    uint32_t edge_capacity = table_capacity(index_count);
+    uint32_t* positions = (uint32_t*)VE_ALLOCATE_TAG(position_capacity * sizeof(uint32_t), VE_MEMORY_TAG_MESH);
+    uint32_t* canonical = (uint32_t*)VE_ALLOCATE_TAG(vertex_count * sizeof(uint32_t), VE_MEMORY_TAG_MESH);
+    uint64_t* edges = (uint64_t*)VE_ALLOCATE_TAG(edge_capacity * sizeof(uint64_t), VE_MEMORY_TAG_MESH);
+    uint32_t* edge_counts = (uint32_t*)ve_allocate_cleared(edge_capacity, sizeof(uint32_t), VE_MEMORY_TAG_MESH);
+    if (!positions || !canonical || !edges || !edge_counts) {
+        VE_FREE(positions);
+        VE_FREE(canonical);
+        VE_FREE(edges);
+        VE_FREE(edge_counts);
+        return false;
+    }
+
+    /* Vertices with the same position share the first one's id; both are locked */
+    memset(positions, 0xff, position_capacity * sizeof(uint32_t));
+    for (uint32_t v = 0; v < vertex_count; v++) {
+        const float* p = vertex_position(state->positions, state->stride, v);
+        uint32_t slot = hash_position(p) & (position_capacity - 1);
+        while (positions[slot] != OPTIMIZER_NONE &&
+               memcmp(vertex_position(state->positions, state->stride, positions[slot]), p, 3 * sizeof(float))) {
+            slot = (slot + 1) & (position_capacity - 1);
+        }
+        if (positions[slot] == OPTIMIZER_NONE) {
+            positions[slot] = v;
+        } else {
+            state->locked[v] = true;
+            state->locked[positions[slot]] = true;
+        }
+        canonical[v] = positions[slot];
+    }
+
+    memset(edges, 0xff, edge_capacity * sizeof(uint64_t));
+    for (uint32_t pass = 0; pass < 2; pass++) {
+        for (uint32_t i = 0; i < index_count; i++) {
+            uint32_t a = indices[i];
+            uint32_t b = indices[i - i % 3 + (i + 1) % 3];
+            uint64_t forward = (uint64_t)canonical[a] << 32 | canonical[b];
+            uint64_t key = pass == 0 ? forward : (uint64_t)canonical[b] << 32 | canonical[a];
+            uint32_t slot = hash_u64(key) & (edge_capacity - 1);
+            while (edges[slot] != key && edges[slot] != SIMPLIFY_EMPTY_EDGE) {
+                slot = (slot + 1) & (edge_capacity - 1);
+            }
+
+            /* First pass counts directed edges, the second finds the ones without a twin or with several */
+            if (pass == 0) {
+                edges[slot] = key;
+                edge_counts[slot]++;
+                continue;
+            }
+            uint32_t forward_slot = hash_u64(forward) & (edge_capacity - 1);
+            while (edges[forward_slot] != forward) {
+                forward_slot = (forward_slot + 1) & (edge_capacity - 1);
+            }
+            if (edges[slot] != key || edge_counts[forward_slot] > 1) {
+                state->locked[a] = true;
+                state->locked[b] = true;
+            }
+        }
+    }
+
+    VE_FREE(positions);
+    VE_FREE(canonical);
+    VE_FREE(edges);
+    VE_FREE(edge_counts);
+    return true;
+}
+
+/* Most promising collapse first, ties broken by vertex so results do not depend on qsort */
+static int compare_collapses(const void* a, const void* b) {
+    const simplify_collapse* first = (const simplify_collapse*)a;
+    const simplify_collapse* second = (const simplify_collapse*)b;
+    if (first->cost != second->cost) {
+        return first->cost < second->cost ? -1 : 1;
+    }
+    if (first->from != second->from) {
+        return first->from < second->from ? -1 : 1;
+    }
+    return first->to < second->to ? -1 : (first->to > second->to ? 1 : 0);
+}
+
+/* Moving from onto to must not turn any remaining triangle of from over */
+static bool collapse_keeps_orientation(const simplify_state* state, const uint32_t* indices, uint32_t from,
+                                       uint32_t to) {
+    const float* target = vertex_position(state->positions, state->stride, to);
+    for (uint32_t j = state->adjacency_offsets[from]; j < state->adjacency_offsets[from + 1]; j++) {
+        const uint32_t* triangle = &indices[state->adjacency[j] * 3];
+        if (triangle[0] == to || triangle[1] == to || triangle[2] == to) {
+            continue;
+        }
+        const float* corners[3];
+        const float* moved[3];
+        for (uint32_t k = 0; k < 3; k++) {
+            corners[k] = vertex_position(state->positions, state->stride, triangle[k]);
+            moved[k] = triangle[k] == from ? target : corners[k];
+        }
+        float before[3];
+        float after[3];
+        triangle_normal(corners[0], corners[1], corners[2], before);
+        triangle_normal(moved[0], moved[1], moved[2], after);
+        float dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+        if (dot < 0.0f || (after[0] == 0.0f && after[1] == 0.0f && after[2] == 0.0f)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Collapse an independent set of the cheapest edges
+ *
+ * @return Collapses made; 0 once no edge is within the error limit
+ */
+static uint32_t simplify_pass(simplify_state* state, uint32_t* indices, uint32_t* index_count,
+                              uint32_t target_index_count, float error_limit, float* max_cost) {
+    uint32_t vertex_count = state->vertex_count;
+    uint32_t count = *index_count;
+
+    memset(state->adjacency_offsets, 0, (vertex_count + 1) * sizeof(uint32_t));
+    for (uint32_t i = 0; i < count; i++) {
+        state->adjacency_offsets[indices[i] + 1]++;
+    }
+    for (uint32_t v = 0; v < vertex_count; v++) {
+        state->adjacency_offsets[v + 1] += state->adjacency_offsets[v];
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        state->adjacency[state->adjacency_offsets[indices[i]]++] = i / 3;
+    }
+    for (uint32_t v = vertex_count; v > 0; v--) {
+        state->adjacency_offsets[v] = state->adjacency_offsets[v - 1];
+    }
+    state->adjacency_offsets[0] = 0;
+
+    uint32_t candidate_count = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t a = indices[i];
+        uint32_t b = indices[i - i % 3 + (i + 1) % 3];
+        for (uint32_t direction = 0; direction < 2; direction++) {
+            uint32_t from = direction == 0 ? a : b;
+            uint32_t to = direction == 0 ? b : a;
+            if (state->locked[from] || from == to) {
+                continue;
+            }
+            float cost = quadric_error(&state->quadrics[from], &state->quadrics[to],
+                                       vertex_position(state->positions, state->stride, to));
+            if (cost <= error_limit) {
+                state->collapses[candidate_count++] = (simplify_collapse){from, to, cost};
+            }
+        }
+    }
+    qsort(state->collapses, candidate_count, sizeof(simplify_collapse), compare_collapses);
+
+    /* A collapse freezes every vertex of the triangles it changes, so the others stay valid */
+    memset(state->touched, 0, vertex_count * sizeof(bool));
+    uint32_t collapsed = 0;
+    uint32_t removed = 0;
+    for (uint32_t c = 0; c < candidate_count && removed * 3 < count - target_index_count; c++) {
+        const simplify_collapse* collapse = &state->collapses[c];
+        if (state->touched[collapse->from] || state->touched[collapse->to] ||
+            !collapse_keeps_orientation(state, indices, collapse->from, collapse->to)) {
+            continue;
+        }
+        state->remap[collapse->from] = collapse->to;
+        quadric_add(&state->quadrics[collapse->to], &state->quadrics[collapse->from]);
+        for (uint32_t j = state->adjacency_offsets[collapse->from]; j < state->adjacency_offsets[collapse->from + 1];
+             j++) {
+            const uint32_t* triangle = &indices[state->adjacency[j] * 3];
+            state->touched[triangle[0]] = true;
+            state->touched[triangle[1]] = true;
+            state->touched[triangle[2]] = true;
+        }
+        *max_cost = fmaxf(*max_cost, collapse->cost);
+        collapsed++;
+        removed += 2;               /* An interior collapse removes the two triangles on its edge */
+    }
+
+    uint32_t written = 0;
+    for (uint32_t i = 0; i < count; i += 3) {
+        uint32_t a = state->remap[indices[i + 0]];
+        uint32_t b = state->remap[indices[i + 1]];
+        uint32_t c = state->remap[indices[i + 2]];
+        if (a != b && b != c && a != c) {
+            indices[written++] = a;
+            indices[written++] = b;
+            indices[written++] = c;
+        }
+    }
+    *index_count = written;
+    return collapsed;
+}
+
+bool ve_mesh_simplify(const uint32_t* indices, uint32_t index_count, const float* positions, uint32_t vertex_count,
+                      size_t position_stride, uint32_t target_index_count, float target_error,
+                      uint32_t* out_indices, uint32_t* out_index_count, float* out_error) {
+    VE_ASSERT((indices || index_count == 0) && positions && out_indices && out_index_count && out_error);
+    VE_ASSERT_MSG(index_count % 3 == 0, "Index count must be a multiple of 3");
+
+    memcpy(out_indices, indices, (size_t)index_count * sizeof(uint32_t));
+    *out_index_count = index_count;
+    *out_error = 0.0f;
+    if (index_count <= target_index_count) {
+        return true;
+    }
+
+    simplify_state state = {
+        .positions = positions,
+        .stride = position_stride,
+        .vertex_count = vertex_count,
+        .locked = (bool*)ve_allocate_cleared(vertex_count, sizeof(bool), VE_MEMORY_TAG_MESH),
+        .quadrics = (quadric*)ve_allocate_cleared(vertex_count, sizeof(quadric), VE_MEMORY_TAG_MESH),
+        .adjacency_offsets = (uint32_t*)VE_ALLOCATE_TAG((vertex_count + 1) * sizeof(uint32_t), VE_MEMORY_TAG_MESH),
+        .adjacency = (uint32_t*)VE_ALLOCATE_TAG(index_count * sizeof(uint32_t), VE_MEMORY_TAG_MESH),
+        .remap = (uint32_t*)VE_ALLOCATE_TAG(vertex_count * sizeof(uint32_t), VE_MEMORY_TAG_MESH),
+        .touched = (bool*)VE_ALLOCATE_TAG(vertex_count * sizeof(bool), VE_MEMORY_TAG_MESH),
+        .collapses = (simplify_collapse*)VE_ALLOCATE_TAG((size_t)index_count * 2 * sizeof(simplify_collapse),
+                                                         VE_MEMORY_TAG_MESH),
+    };
+    bool success = state.locked && state.quadrics && state.adjacency_offsets && state.adjacency && state.remap &&
+                   state.touched && state.collapses && simplify_lock_vertices(&state, indices, index_count);
+    if (success) {
+        for (uint32_t i = 0; i < index_count; i += 3) {
+            VE_ASSERT_MSG(indices[i] < vertex_count && indices[i + 1] < vertex_count &&
+                              indices[i + 2] < vertex_count,
+                          "Index out of range");
+            const float* a = vertex_position(positions, position_stride, indices[i + 0]);
+            float normal[3];
+            triangle_normal(a, vertex_position(positions, position_stride, indices[i + 1]),
+                            vertex_position(positions, position_stride, indices[i + 2]), normal);
+            float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            if (length == 0.0f) {
+                continue;
+            }
+            for (uint32_t c = 0; c < 3; c++) {
+                normal[c] /= length;
+            }
+            float distance = -(normal[0] * a[0] + normal[1] * a[1] + normal[2] * a[2]);
+            for (uint32_t k = 0; k < 3; k++) {
+                quadric_add_plane(&state.quadrics[indices[i + k]], normal, distance, length * 0.5f);
+            }
+        }
+        for (uint32_t v = 0; v < vertex_count; v++) {
+            state.remap[v] = v;
+        }
+
+        float max_cost = 0.0f;
+        while (*out_index_count > target_index_count &&
+               simplify_pass(&state, out_indices, out_index_count, target_index_count, target_error * target_error,
+                             &max_cost) > 0) {
+        }
+        *out_error = sqrtf(max_cost);
+    } else {
+        VE_LOG_ERROR("Out of memory simplifying %u triangles", index_count / 3);
+    }
+
+    VE_FREE(state.locked);
+    VE_FREE(state.quadrics);
+    VE_FREE(state.adjacency_offsets);
+    VE_FREE(state.adjacency);
+    VE_FREE(state.remap);
+    VE_FREE(state.touched);
+    VE_FREE(state.collapses);
+    return success;
+}
+
+/* Vertex quantization */
+
+/* Round to nearest even; overflow becomes infinity, values below the half range flush to signed zero */
+static uint16_t float_to_half(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    uint32_t exponent = (bits >> 23) & 0xffu;
+    uint32_t mantissa = bits & 0x7fffffu;
+
+    if (exponent == 0xffu) {
+        return (uint16_t)(sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+    }
+    int32_t half_exponent = (int32_t)exponent - 127 + 15;
+    if (half_exponent >= 31) {
+        return (uint16_t)(sign | 0x7c00u);
+    }
+    if (half_exponent <= 0) {
+        /* Subnormal half: shift the mantissa with its implicit bit into place */
+        if (half_exponent < -10) {
+            return (uint16_t)sign;
+        }
+        mantissa |= 0x800000u;
+        uint32_t shift = (uint32_t)(14 - half_exponent);
+        uint32_t half_mantissa = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half_mantissa & 1u))) {
+            half_mantissa++;
+        }
+        return (uint16_t)(sign | half_mantissa);
+    }
+
+    uint32_t half = sign | ((uint32_t)half_exponent << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1fffu;
+    if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) {
+        half++;                     /* Carries into the exponent, up to infinity, as it should */
+    }
+    return (uint16_t)half;
+}
+
+static float half_to_float(uint16_t half) {
+    uint32_t sign = (uint32_t)(half & 0x8000u) << 16;
+    uint32_t exponent = (half >> 10) & 0x1fu;
+    uint32_t mantissa = half & 0x3ffu;
+
+    uint32_t bits;
+    if (exponent == 0x1fu) {
+        bits = sign | 0x7f800000u | (mantissa << 13);
+    } else if (exponent == 0) {
+        float value = (float)mantissa * (1.0f / 16777216.0f);  /* mantissa * 2^-24 */
+        return sign ? -value : value;
+    } else {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static int16_t float_to_snorm16(float value) {
+    value = fminf(fmaxf(value, -1.0f), 1.0f);
+    return (int16_t)lrintf(value * 32767.0f);
+}
+
+static float snorm16_to_float(int16_t value) {
+    return fmaxf((float)value / 32767.0f, -1.0f);
+}
+
+static float sign_not_zero(float value) {
+    return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+/* Project the unit sphere onto an octahedron, then unfold the lower half over the corners */
+static void octahedral_encode(const float normal[3], float out[2]) {
+    float length = fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]);
+    if (length == 0.0f) {
+        out[0] = 0.0f;
+        out[1] = 0.0f;
+        return;
+    }
+    float x = normal[0] / length;
+    float y = normal[1] / length;
+    if (normal[2] < 0.0f) {
+        float folded_x = (1.0f - fabsf(y)) * sign_not_zero(x);
+        y = (1.0f - fabsf(x)) * sign_not_zero(y);
+        x = folded_x;
+    }
+    out[0] = x;
+    out[1] = y;
+}
+
+static void octahedral_decode(const float encoded[2], float out[3]) {
+    float x = encoded[0];
+    float y = encoded[1];
+    float z = 1.0f - fabsf(x) - fabsf(y);
+    if (z < 0.0f) {
+        float unfolded_x = (1.0f - fabsf(y)) * sign_not_zero(x);
+        y = (1.0f - fabsf(x)) * sign_not_zero(y);
+        x = unfolded_x;
+    }
+    float length = sqrtf(x * x + y * y + z * z);
+    out[0] = x / length;
+    out[1] = y / length;
+    out[2] = z / length;
+}
+
+void ve_mesh_quantize(const ve_mesh_vertex* vertices, uint32_t vertex_count, const float bounds_min[3],
+                      const float bounds_max[3], ve_mesh_vertex_packed* out) {
+    VE_ASSERT((vertices && out) || vertex_count == 0);
+    VE_ASSERT(bounds_min && bounds_max);
+
+    float scale[3];
+    for (uint32_t c = 0; c < 3; c++) {
+        float extent = bounds_max[c] - bounds_min[c];
+        scale[c] = extent > 0.0f ? 65535.0f / extent : 0.0f;
+    }
+
+    for (uint32_t i = 0; i < vertex_count; i++) {
+        const ve_mesh_vertex* vertex = &vertices[i];
+        ve_mesh_vertex_packed* packed = &out[i];
+        for (uint32_t c = 0; c < 3; c++) {
+            float q = (vertex->position[c] - bounds_min[c]) * scale[c];
+            packed->position[c] = (uint16_t)lrintf(fminf(fmaxf(q, 0.0f), 65535.0f));
+        }
+        packed->position[3] = 0;
+
+        float encoded[2];
+        octahedral_encode(vertex->normal, encoded);
+        packed->normal[0] = float_to_snorm16(encoded[0]);
+        packed->normal[1] = float_to_snorm16(encoded[1]);
+        packed->uv[0] = float_to_half(vertex->uv[0]);
+        packed->uv[1] = float_to_half(vertex->uv[1]);
+    }
+}
+
+void ve_mesh_dequantize(const ve_mesh_vertex_packed* packed, uint32_t vertex_count, const float bounds_min[3],
+                        const float bounds_max[3], ve_mesh_vertex* out) {
+    VE_ASSERT((packed && out) || vertex_count == 0);
+    VE_ASSERT(bounds_min && bounds_max);
+
+    for (uint32_t i = 0; i < vertex_count; i++) {
+        ve_mesh_vertex* vertex = &out[i];
+        for (uint32_t c = 0; c < 3; c++) {
+            vertex->position[c] =
+                bounds_min[c] + (float)packed[i].position[c] / 65535.0f * (bounds_max[c] - bounds_min[c]);
+        }
+        float encoded[2] = {snorm16_to_float(packed[i].normal[0]), snorm16_to_float(packed[i].normal[1])};
+        octahedral_decode(encoded, vertex->normal);
+        vertex->uv[0] = half_to_float(packed[i].uv[0]);
+        vertex->uv[1] = half_to_float(packed[i].uv[1]);
+    }
+}
+
+/* Cooked meshes */
+
+static bool grow_array(void** array, uint32_t* capacity, uint32_t needed, size_t element_size) {
+    if (needed <= *capacity) {
+        return true;
+    }
+    uint32_t grown_capacity = *capacity ? *capacity : 256;
+    while (grown_capacity < needed) {
+        grown_capacity *= 2;
+    }
+    void* grown = ve_reallocate(*array, (size_t)grown_capacity * element_size, VE_MEMORY_TAG_MESH);
+    if (!grown) {
+        return false;
+    }
+    *array = grown;
+    *capacity = grown_capacity;
+    return true;
+}
+
+/* Resolve a 1-based or negative (relative) OBJ index against count elements, 0 if invalid */
+static uint32_t resolve_obj_index(long index, uint32_t count) {
+    if (index < 0) {
+        index += (long)count + 1;
+    }
+    return index >= 1 && index <= (long)count ? (uint32_t)index : 0;
+}
+
+static uint32_t hash_corner(const obj_corner* corner) {
+    uint32_t hash = 2166136261u;
+    const uint32_t values[3] = {corner->position, corner->uv, corner->normal};
+    for (uint32_t i = 0; i < 3; i++) {
+        hash = (hash ^ values[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Parse the attributes and face corners of an OBJ file
+ *
+ * Every three corners form a triangle.
+ */
+static bool parse_obj_lines(char* source, float** positions, uint32_t* position_count, float** uvs,
+                            uint32_t* uv_count, float** normals, uint32_t* normal_count, obj_corner** corners,
+                            uint32_t* corner_count) {
+    uint32_t position_capacity = 0, uv_capacity = 0, normal_capacity = 0, corner_capacity = 0;
+    uint32_t line_number = 0;
+
+    for (char* line = source; line;) {
+        char* line_end = strchr(line, '\n');
+        if (line_end) {
+            *line_end = '\0';
+        }
+        char* next = line_end ? line_end + 1 : NULL;
+        line_number++;
+
+        while (*line == ' ' || *line == '\t') {
+            line++;
+        }
+
+        char* cursor = line;
+        if (strncmp(line, "v ", 2) == 0 || strncmp(line, "vn ", 3) == 0 || strncmp(line, "vt ", 3) == 0) {
+            bool is_uv = line[1] == 't';
+            bool is_normal = line[1] == 'n';
+            uint32_t components = is_uv ? 2 : 3;
+            float** array = is_uv ? uvs : is_normal ? normals : positions;
+            uint32_t* count = is_uv ? uv_count : is_normal ? normal_count : position_count;
+            uint32_t* capacity = is_uv ? &uv_capacity : is_normal ? &normal_capacity : &position_capacity;
+            if (!grow_array((void**)array, capacity, *count + 1, components * sizeof(float))) {
+                VE_LOG_ERROR("Out of memory parsing OBJ");
+                return false;
+            }
+
+            cursor += is_uv || is_normal ? 3 : 2;
+            for (uint32_t c = 0; c < components; c++) {
+                char* end;
+                (*array)[*count * components + c] = strtof(cursor, &end);
+                if (end == cursor) {
+                    VE_LOG_ERROR("OBJ line %u: expected %u numbers", line_number, components);
+                    return false;
+                }
+                cursor = end;
+            }
+            (*count)++;
+        } else if (strncmp(line, "f ", 2) == 0) {
+            obj_corner first = {0}, previous = {0};
+            uint32_t face_corners = 0;
+            cursor += 2;
+            for (;;) {
+                while (*cursor == ' ' || *cursor == '\t' || *cursor == '\r') {
+                    cursor++;
+                }
+                if (*cursor == '\0') {
+                    break;
+                }
+
+                /* v, v/vt, v//vn or v/vt/vn */
+                obj_corner corner = {0};
+                char* end;
+                corner.position = resolve_obj_index(strtol(cursor, &end, 10), *position_count);
+                bool valid = end != cursor && corner.position != 0;
+                cursor = end;
+                if (valid && *cursor == '/') {
+                    cursor++;
+                    if (*cursor != '/') {
+                        corner.uv = resolve_obj_index(strtol(cursor, &end, 10), *uv_count);
+                        valid = end != cursor && corner.uv != 0;
+                        cursor = end;
+                    }
+                    if (valid && *cursor == '/') {
+                        cursor++;
+                        corner.normal = resolve_obj_index(strtol(cursor, &end, 10), *normal_count);
+                        valid = end != cursor && corner.normal != 0;
+                        cursor = end;
+                    }
+                }
+                if (!valid) {
+                    VE_LOG_ERROR("OBJ line %u: invalid face corner", line_number);
+                    return false;
+                }
+
+                /* Fan triangulation around the first corner */
+                if (face_corners >= 2) {
+                    if (!grow_array((void**)corners, &corner_capacity, *corner_count + 3, sizeof(obj_corner))) {
+                        VE_LOG_ERROR("Out of memory parsing OBJ");
+                        return false;
+                    }
+                    (*corners)[(*corner_count)++] = first;
+                    (*corners)[(*corner_count)++] = previous;
+                    (*corners)[(*corner_count)++] = corner;
+                }
+                if (face_corners == 0) {
+                    first = corner;
+                }
+                previous = corner;
+                face_corners++;
+            }
+        }
+
+        line = next;
+    }
+    return true;
+}
+
+bool ve_model_parse_obj(const char* text, size_t size, ve_mesh_vertex** vertices, uint32_t* vertex_count,
+                        uint32_t** indices, uint32_t* index_count) {
+    VE_ASSERT((text || size == 0) && vertices && vertex_count && indices && index_count);
+
+    *vertices = NULL;
+    *vertex_count = 0;
+    *indices = NULL;
+    *index_count = 0;
+
+    /* A NUL terminated copy, so lines can be split and fed to strtof */
+    char* source = (char*)VE_ALLOCATE_TAG(size + 1, VE_MEMORY_TAG_STRING);
+    if (!source) {
+        VE_LOG_ERROR("Out of memory parsing OBJ");
+        return false;
+    }
+    memcpy(source, text, size);
+    source[size] = '\0';
+
+    float* positions = NULL;
+    float* uvs = NULL;
+    float* normals = NULL;
+    obj_corner* corners = NULL;
+    uint32_t position_count = 0, uv_count = 0, normal_count = 0, corner_count = 0;
+    bool success = parse_obj_lines(source, &positions, &position_count, &uvs, &uv_count, &normals, &normal_count,
+                                   &corners, &corner_count);
+    VE_FREE(source);
+
+    /* Deduplicate corners into vertices through an open addressing table of vertex index + 1 */
+    uint32_t table_size = 1;
+    while (table_size < corner_count * 2) {
+        table_size *= 2;
+    }
+    uint32_t* table = NULL;
+    obj_corner* unique = NULL;
+    ve_mesh_vertex* out_vertices = NULL;
+    uint32_t* out_indices = NULL;
+    uint32_t unique_count = 0;
+    if (success && corner_count > 0) {
+        table = (uint32_t*)ve_allocate_cleared(table_size, sizeof(uint32_t), VE_MEMORY_TAG_MESH);
+        unique = (obj_corner*)VE_ALLOCATE_TAG(corner_count * sizeof(obj_corner), VE_MEMORY_TAG_MESH);
+        out_indices = (uint32_t*)VE_ALLOCATE_TAG(corner_count * sizeof(uint32_t), VE_MEMORY_TAG_MESH);
+        success = table && unique && out_indices;
+        if (!success) {
+            VE_LOG_ERROR("Out of memory indexing OBJ with %u corners", corner_count);
+        }
+    }
+
+    for (uint32_t i = 0; success && i < corner_count; i++) {
+        const obj_corner* corner = &corners[i];
+        uint32_t slot = hash_corner(corner) & (table_size - 1);
+        while (table[slot] != 0) {
+            const obj_corner* other = &unique[table[slot] - 1];
+            if (other->position == corner->position && other->uv == corner->uv && other->normal == corner->normal) {
+                break;
+            }
+            slot = (slot + 1) & (table_size - 1);
+        }
+        if (table[slot] == 0) {
+            unique[unique_count++] = *corner;
+            table[slot] = unique_count;
+        }
+        out_indices[i] = table[slot] - 1;
+    }
+
+    if (success && unique_count > 0) {
+        out_vertices = (ve_mesh_vertex*)ve_allocate_cleared(unique_count, sizeof(ve_mesh_vertex),
+                                                            VE_MEMORY_TAG_MESH);
+        success = out_vertices != NULL;
+    }
+
+    bool missing_normals = false;
+    for (uint32_t i = 0; success && i < unique_count; i++) {
+        ve_mesh_vertex* vertex = &out_vertices[i];
+        memcpy(vertex->position, &positions[(unique[i].position - 1) * 3], sizeof(vertex->position));
+        if (unique[i].uv) {
+            /* OBJ puts v = 0 at the bottom, Vulkan samples it at the top */
+            vertex->uv[0] = uvs[(unique[i].uv - 1) * 2];
+            vertex->uv[1] = 1.0f - uvs[(unique[i].uv - 1) * 2 + 1];
+        }
+        if (unique[i].normal) {
+            memcpy(vertex->normal, &normals[(unique[i].normal - 1) * 3], sizeof(vertex->normal));
+        } else {
+            missing_normals = true;
+        }
+    }
+
+    /* Unnormalized face normals weigh each face by its area */
+    for (uint32_t t = 0; success && missing_normals && t < corner_count / 3; t++) {
+        const uint32_t* triangle = &out_indices[t * 3];
+        const float* a = out_vertices[triangle[0]].position;
+        const float* b = out_vertices[triangle[1]].position;
+        const float* c = out_vertices[triangle[2]].position;
+        float e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+        float e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+        float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+        for (uint32_t k = 0; k < 3; k++) {
+            if (unique[triangle[k]].normal == 0) {
+                for (uint32_t j = 0; j < 3; j++) {
+                    out_vertices[triangle[k]].normal[j] += n[j];
+                }
+            }
+        }
+    }
+    for (uint32_t i = 0; success && missing_normals && i < unique_count; i++) {
+        if (unique[i].normal == 0) {
+            float* n = out_vertices[i].normal;
+            float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            float scale = length > 0.0f ? 1.0f / length : 0.0f;
+            n[0] *= scale;
+            n[1] *= scale;
+            n[2] *= scale;
+        }
+    }
+
+    VE_FREE(positions);
+    VE_FREE(uvs);
+    VE_FREE(normals);
+    VE_FREE(corners);
+    VE_FREE(table);
+    VE_FREE(unique);
+
+    if (!success) {
+        VE_FREE(out_vertices);
+        VE_FREE(out_indices);
+        return false;
+    }
+    *vertices = out_vertices;
+    *vertex_count = unique_count;
+    *indices = out_indices;
+    *index_count = corner_count;
+    return true;
+}
+
+static uint64_t align_blob(uint64_t offset) {
+    return (offset + MESH_BLOB_ALIGNMENT - 1) & ~(uint64_t)(MESH_BLOB_ALIGNMENT - 1);
+}
+
+/**
+ * @brief Append coarser levels of detail after the full mesh's triangle list
+ *
+ * Every level is simplified from the full mesh, so its error is measured
+ * against the original surface. The chain ends at the error bound, or
+ * once a level no longer removes enough triangles to be worth drawing.
+ */
+static bool append_lods(const ve_mesh_vertex* vertices, uint32_t vertex_count, uint32_t** indices,
+                        uint32_t* index_capacity, uint32_t* index_count, float max_error,
+                        ve_mesh_blob_header* header) {
+    uint32_t full_count = *index_count;
+    header->lods[0] = (ve_mesh_lod){0, full_count, 0.0f, 0};
+    header->lod_count = 1;
+
+    uint32_t* simplified = (uint32_t*)VE_ALLOCATE_TAG((size_t)full_count * sizeof(uint32_t), VE_MEMORY_TAG_MESH);
+    if (!simplified) {
+        VE_LOG_ERROR("Out of memory simplifying a mesh with %u indices", full_count);
+        return false;
+    }
+
+    bool success = true;
+    while (header->lod_count < VE_MESH_MAX_LODS) {
+        const ve_mesh_lod* previous = &header->lods[header->lod_count - 1];
+        uint32_t target = (uint32_t)((float)(previous->index_count / 3) * VE_MESH_LOD_REDUCTION) * 3;
+        uint32_t count = 0;
+        float error = 0.0f;
+        success = ve_mesh_simplify(*indices, full_count, vertices[0].position, vertex_count, sizeof(ve_mesh_vertex),
+                                   target, max_error, simplified, &count, &error);
+        if (!success || count == 0 || (float)count > (float)previous->index_count * MESH_LOD_MIN_REDUCTION) {
+            break;
+        }
+        success = ve_mesh_optimize_vertex_cache(simplified, count, vertex_count) &&
+                  grow_array((void**)indices, index_capacity, *index_count + count, sizeof(uint32_t));
+        if (!success) {
+            break;
+        }
+        memcpy(*indices + *index_count, simplified, (size_t)count * sizeof(uint32_t));
+        header->lods[header->lod_count] = (ve_mesh_lod){*index_count, count, fmaxf(error, previous->error), 0};
+        header->lod_count++;
+        *index_count += count;
+    }
+
+    VE_FREE(simplified);
+    return success;
+}
+
+bool ve_mesh_cook(const ve_mesh_vertex* vertices, uint32_t vertex_count, const uint32_t* indices,
+                  uint32_t index_count, void** blob, size_t* size) {
+    VE_ASSERT(vertices && indices && blob && size);
+    VE_ASSERT_MSG(index_count % 3 == 0, "Index count must be a multiple of 3");
+
+    *blob = NULL;
+    *size = 0;
+    if (vertex_count == 0 || index_count == 0) {
+        VE_LOG_ERROR("Cannot cook an empty mesh");
+        return false;
+    }
+
+    /* Optimize copies: cache order first, then overdraw order among cache friendly runs, then fetch order */
+    ve_mesh_vertex* optimized_vertices =
+        (ve_mesh_vertex*)VE_ALLOCATE_TAG((size_t)vertex_count * sizeof(ve_mesh_vertex), VE_MEMORY_TAG_MESH);
+    uint32_t* optimized_indices =
+        (uint32_t*)VE_ALLOCATE_TAG((size_t)index_count * sizeof(uint32_t), VE_MEMORY_TAG_MESH);
+    if (!optimized_vertices || !optimized_indices) {
+        VE_LOG_ERROR("Out of memory cooking a mesh with %u vertices", vertex_count);
+        VE_FREE(optimized_vertices);
+        VE_FREE(optimized_indices);
+        return false;
+    }
+    memcpy(optimized_vertices, vertices, (size_t)vertex_count * sizeof(ve_mesh_vertex));
+    memcpy(optimized_indices, indices, (size_t)index_count * sizeof(uint32_t));
+
+    ve_meshlet_data meshlets = {0};
+    bool optimized = ve_mesh_optimize_vertex_cache(optimized_indices, index_count, vertex_count) &&
+                     ve_mesh_optimize_overdraw(optimized_indices, index_count, optimized_vertices[0].position,
+                                               vertex_count, sizeof(ve_mesh_vertex), VE_MESH_OVERDRAW_THRESHOLD) &&
+                     ve_mesh_optimize_vertex_fetch(optimized_vertices, &vertex_count, optimized_indices, index_count);
+    if (!optimized || !ve_meshlet_build(optimized_indices, index_count, optimized_vertices[0].position, vertex_count,
+                                        sizeof(ve_mesh_vertex), &meshlets)) {
+        VE_FREE(optimized_vertices);
+        VE_FREE(optimized_indices);
+        return false;
+    }
+    vertices = optimized_vertices;
+
+    ve_mesh_blob_header header = {
+        .magic = VE_MESH_BLOB_MAGIC,
+        .vertex_count = vertex_count,
+        .meshlet_count = meshlets.meshlet_count,
+        .meshlet_vertex_count = meshlets.vertex_count,
+        .meshlet_triangle_count = meshlets.triangle_count,
+        .bounds_min = {INFINITY, INFINITY, INFINITY},
+        .bounds_max = {-INFINITY, -INFINITY, -INFINITY},
+    };
+    for (uint32_t i = 0; i < vertex_count; i++) {
+        for (uint32_t c = 0; c < 3; c++) {
+            header.bounds_min[c] = fminf(header.bounds_min[c], vertices[i].position[c]);
+            header.bounds_max[c] = fmaxf(header.bounds_max[c], vertices[i].position[c]);
+        }
+    }
+
+    /* Coarser levels follow the full triangle list in the same index array */
+    float diagonal = 0.0f;
+    for (uint32_t c = 0; c < 3; c++) {
+        diagonal += (header.bounds_max[c] - header.bounds_min[c]) * (header.bounds_max[c] - header.bounds_min[c]);
+    }
+    uint32_t index_capacity = index_count;
+    if (!append_lods(vertices, vertex_count, &optimized_indices, &index_capacity, &index_count,
+                     sqrtf(diagonal) * VE_MESH_LOD_MAX_ERROR, &header)) {
+        ve_meshlet_free(&meshlets);
+        VE_FREE(optimized_vertices);
+        VE_FREE(optimized_indices);
+        return false;
+    }
+    indices = optimized_indices;
+    header.index_count = index_count;
+
+    uint64_t offset = align_blob(sizeof(ve_mesh_blob_header));
+    uint64_t vertex_offset = offset;
+    offset = align_blob(offset + (uint64_t)vertex_count * sizeof(ve_mesh_vertex_packed));
+    uint64_t index_offset = offset;
+    offset = align_blob(offset + (uint64_t)index_count * sizeof(uint32_t));
+    uint64_t meshlet_offset = offset;
+    offset = align_blob(offset + (uint64_t)meshlets.meshlet_count * sizeof(ve_meshlet));
+    uint64_t meshlet_vertex_offset = offset;
+    offset = align_blob(offset + (uint64_t)meshlets.vertex_count * sizeof(uint32_t));
+    uint64_t meshlet_triangle_offset = offset;
+    offset = align_blob(offset + (uint64_t)meshlets.triangle_count * 3);
+    if (offset > UINT32_MAX) {
+        VE_LOG_ERROR("Mesh with %u vertices and %u indices is too large to cook", vertex_count, index_count);
+        ve_meshlet_free(&meshlets);
+        VE_FREE(optimized_vertices);
+        VE_FREE(optimized_indices);
+        return false;
+    }
+    header.vertex_offset = (uint32_t)vertex_offset;
+    header.index_offset = (uint32_t)index_offset;
+    header.meshlet_offset = (uint32_t)meshlet_offset;
+    header.meshlet_vertex_offset = (uint32_t)meshlet_vertex_offset;
+    header.meshlet_triangle_offset = (uint32_t)meshlet_triangle_offset;
+
+    uint8_t* data = (uint8_t*)ve_allocate_cleared(1, (size_t)offset, VE_MEMORY_TAG_MESH);
+    if (!data) {
+        VE_LOG_ERROR("Out of memory cooking a mesh of %llu bytes", (unsigned long long)offset);
+        ve_meshlet_free(&meshlets);
+        VE_FREE(optimized_vertices);
+        VE_FREE(optimized_indices);
+        return false;
+    }
+    memcpy(data, &header, sizeof(header));
+    ve_mesh_quantize(vertices, vertex_count, header.bounds_min, header.bounds_max,
+                     (ve_mesh_vertex_packed*)(data + vertex_offset));
+    memcpy(data + index_offset, indices, (size_t)index_count * sizeof(uint32_t));
+    if (meshlets.meshlet_count > 0) {
+        memcpy(data + meshlet_offset, meshlets.meshlets, meshlets.meshlet_count * sizeof(ve_meshlet));
+        memcpy(data + meshlet_vertex_offset, meshlets.vertices, meshlets.vertex_count * sizeof(uint32_t));
+        memcpy(data + meshlet_triangle_offset, meshlets.triangles, (size_t)meshlets.triangle_count * 3);
+    }
+    ve_meshlet_free(&meshlets);
+    VE_FREE(optimized_vertices);
+    VE_FREE(optimized_indices);
+
+    *blob = data;
+    *size = (size_t)offset;
+    return true;
+}
+
+/* Check that an array lies inside the blob and is aligned */
+static bool blob_array_valid(uint32_t offset, uint64_t array_size, size_t blob_size) {
+    return offset % MESH_BLOB_ALIGNMENT == 0 && offset <= blob_size && array_size <= blob_size - offset;
+}
+
+bool ve_mesh_view(const void* blob, size_t size, ve_mesh_data* out) {
+    VE_ASSERT(blob && out);
+    VE_ASSERT_MSG(((uintptr_t)blob & (MESH_BLOB_ALIGNMENT - 1)) == 0, "Mesh blobs must be 16 byte aligned");
+
+    memset(out, 0, sizeof(ve_mesh_data));
+    const ve_mesh_blob_header* header = (const ve_mesh_blob_header*)blob;
+    if (size < sizeof(ve_mesh_blob_header) || header->magic != VE_MESH_BLOB_MAGIC ||
+        !blob_array_valid(header->vertex_offset, (uint64_t)header->vertex_count * sizeof(ve_mesh_vertex_packed),
+                          size) ||
+        !blob_array_valid(header->index_offset, (uint64_t)header->index_count * sizeof(uint32_t), size) ||
+        !blob_array_valid(header->meshlet_offset, (uint64_t)header->meshlet_count * sizeof(ve_meshlet), size) ||
+        !blob_array_valid(header->meshlet_vertex_offset, (uint64_t)header->meshlet_vertex_count * sizeof(uint32_t),
+                          size) ||
+        !blob_array_valid(header->meshlet_triangle_offset, (uint64_t)header->meshlet_triangle_count * 3, size) ||
+        header->lod_count == 0 || header->lod_count > VE_MESH_MAX_LODS) {
+        VE_LOG_ERROR("Malformed mesh blob");
+        return false;
+    }
+    for (uint32_t i = 0; i < header->lod_count; i++) {
+        const ve_mesh_lod* lod = &header->lods[i];
+        if (lod->index_count % 3 != 0 || lod->index_offset > header->index_count ||
+            lod->index_count > header->index_count - lod->index_offset) {
+            VE_LOG_ERROR("Malformed mesh blob");
+            return false;
+        }
+    }
+
+    const uint8_t* data = (const uint8_t*)blob;
+    out->vertices = (const ve_mesh_vertex_packed*)(data + header->vertex_offset);
+    out->vertex_count = header->vertex_count;
+    out->indices = (const uint32_t*)(data + header->index_offset);
+    out->index_count = header->index_count;
+    out->lods = header->lods;
+    out->lod_count = header->lod_count;
+    out->meshlets = (const ve_meshlet*)(data + header->meshlet_offset);
+    out->meshlet_count = header->meshlet_count;
+    out->meshlet_vertices = (const uint32_t*)(data + header->meshlet_vertex_offset);
+    out->meshlet_vertex_count = header->meshlet_vertex_count;
+    out->meshlet_triangles = data + header->meshlet_triangle_offset;
+    out->meshlet_triangle_count = header->meshlet_triangle_count;
+    memcpy(out->bounds_min, header->bounds_min, sizeof(out->bounds_min));
+    memcpy(out->bounds_max, header->bounds_max, sizeof(out->bounds_max));
+    return true;
+}
+
+bool ve_model_load_pak(const ve_pak* pak, const char* name, ve_model* model) {
+    VE_ASSERT(pak && name && model);
+
+    memset(model, 0, sizeof(ve_model));
+    const ve_pak_entry* entry = ve_pak_find(pak, name);
+    if (!entry || entry->type != VE_PAK_TYPE_MESH) {
+        VE_LOG_ERROR("Pak has no mesh named %s", name);
+        return false;
+    }
+
+    const void* blob = ve_pak_load(pak, entry, &model->owned);
+    if (!blob || !ve_mesh_view(blob, (size_t)entry->size, &model->mesh)) {
+        ve_model_release(model);
+        return false;
+    }
+    return true;
+}
+
+void ve_model_release(ve_model* model) {
+    if (!model) {
+        return;
+    }
+    VE_FREE(model->owned);
+    memset(model, 0, sizeof(ve_model));
+}
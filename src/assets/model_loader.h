@@ -1,18 +1,389 @@
 /**
  * @file model_loader.h
- * @brief glTF/OBJ model loading
+ * @brief Model loading
+ *
+ * Meshes can be split into meshlets at load time for the mesh shader
+ * path. A meshlet is a small cluster of triangles with its own vertex
+ * list, bounding sphere and normal cone, so task shaders can reject
+ * clusters that are off screen or face away from the camera before any of
+ * their vertices are processed.
+ *
+ * At runtime meshes come from paks (see pak.h). The cooker parses source
+ * models once and stores each mesh as a blob in the layout the GPU
+ * consumes, meshlets included, so loading a mesh is a lookup and a view
+ * into the mapped archive rather than a parse.
+ *
+ * Cooking also optimizes each mesh for the vertex stage: triangles are
+ * ordered for the post-transform cache, then grouped so outward-facing
+ * clusters draw first and hide what is behind them, and vertices are
+ * stored in the order the triangles first use them so fetches stream
+ * through memory. Vertices are quantized to 16 bytes
+ * (ve_mesh_vertex_packed), half the size of the float layout.
+ *
+ * Each cooked mesh carries a chain of levels of detail. Coarser levels
+ * are simplified by edge collapses that keep the geometric error within a
+ * bound, share the vertices of the full mesh and only add index lists.
+ * Cameras pick a level per instance from its error projected on screen
+ * (see scene/camera.h).
  */
 
 #ifndef VE_MODEL_LOADER_H
 #define VE_MODEL_LOADER_H
 
+#include "pak.h"
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* TODO: Implement model loading */
+/* Meshlet limits, must match meshlet.mesh */
+#define VE_MESHLET_MAX_VERTICES 64
+#define VE_MESHLET_MAX_TRIANGLES 124
+
+/**
+ * @brief Triangle cluster, laid out as three uvec4/vec4 in the shaders
+ */
+typedef struct ve_meshlet {
+    uint32_t vertex_offset;         /* First entry in ve_meshlet_data.vertices */
+    uint32_t triangle_offset;       /* First byte in ve_meshlet_data.triangles */
+    uint32_t vertex_count;
+    uint32_t triangle_count;
+    float center[3];                /* Bounding sphere in mesh space */
+    float radius;
+    float cone_axis[3];             /* Average facing direction */
+    float cone_cutoff;              /* 1 when the cone cannot cull */
+} ve_meshlet;
+
+/**
+ * @brief Meshlets of one mesh
+ */
+typedef struct ve_meshlet_data {
+    ve_meshlet* meshlets;
+    uint32_t meshlet_count;
+    uint32_t* vertices;             /* Indices into the source vertex buffer */
+    uint32_t vertex_count;
+    uint8_t* triangles;             /* Three meshlet-local vertex indices per triangle */
+    uint32_t triangle_count;
+} ve_meshlet_data;
+
+/**
+ * @brief Split an indexed triangle list into meshlets
+ *
+ * Triangles are taken in index order, so run a vertex cache optimizer
+ * first for tighter clusters. Winding is counter-clockwise front faces.
+ *
+ * @param indices Triangle list indices
+ * @param index_count Number of indices, a multiple of 3
+ * @param positions First vertex position (three floats)
+ * @param vertex_count Number of vertices
+ * @param position_stride Bytes between vertex positions
+ * @param out Output meshlets, freed with ve_meshlet_free
+ * @return true on success
+ */
+bool ve_meshlet_build(const uint32_t* indices, uint32_t index_count,
+                      const float* positions, uint32_t vertex_count, size_t position_stride,
+                      ve_meshlet_data* out);
+
+/**
+ * @brief Free meshlets built by ve_meshlet_build
+ *
+ * @param data Meshlets, cleared on return
+ */
+void ve_meshlet_free(ve_meshlet_data* data);
+
+/**
+ * @brief Check if a meshlet faces entirely away from a camera
+ *
+ * Same test as meshlet.task, for CPU-side culling and tests.
+ *
+ * @param meshlet Meshlet
+ * @param camera_position Camera position in mesh space
+ * @return true if every triangle of the meshlet is back-facing
+ */
+bool ve_meshlet_is_backfacing(const ve_meshlet* meshlet, const float camera_position[3]);
+
+/* FIFO depth the vertex cache optimizer and its analysis assume */
+#define VE_MESH_VERTEX_CACHE_SIZE 16
+
+/* Overdraw ordering may raise the vertex cache miss ratio by this factor */
+#define VE_MESH_OVERDRAW_THRESHOLD 1.05f
+
+/**
+ * @brief Get the average vertex cache misses per triangle
+ *
+ * Simulates a FIFO post-transform cache. 0.5 is the best a regular grid
+ * can reach, 3 means no reuse at all.
+ *
+ * @param indices Triangle list indices
+ * @param index_count Number of indices, a multiple of 3
+ * @param cache_size Cache entries, at most 64
+ * @return Average cache miss ratio (ACMR)
+ */
+float ve_mesh_get_acmr(const uint32_t* indices, uint32_t index_count, uint32_t cache_size);
+
+/**
+ * @brief Reorder triangles for the post-transform vertex cache
+ *
+ * Greedy and linear time (Forsyth): the next triangle is the one whose
+ * vertices score best for being recently used and having few triangles
+ * left. Works for any cache size.
+ *
+ * @param indices Triangle list indices, reordered in place
+ * @param index_count Number of indices, a multiple of 3
+ * @param vertex_count Number of vertices
+ * @return false if out of memory, leaving the indices unchanged
+ */
+bool ve_mesh_optimize_vertex_cache(uint32_t* indices, uint32_t index_count, uint32_t vertex_count);
+
+/**
+ * @brief Reorder clusters of cache-optimized triangles to reduce overdraw
+ *
+ * Splits the triangles into runs that start with a cold cache or, once
+ * the run is long, wherever the miss ratio so far stays within threshold
+ * of the whole mesh's, then draws the runs that face most outward first.
+ * Run after ve_mesh_optimize_vertex_cache.
+ *
+ * @param indices Triangle list indices, reordered in place
+ * @param index_count Number of indices, a multiple of 3
+ * @param positions First vertex position (three floats)
+ * @param vertex_count Number of vertices
+ * @param position_stride Bytes between vertex positions
+ * @param threshold Allowed ACMR increase, e.g. VE_MESH_OVERDRAW_THRESHOLD
+ * @return false if out of memory, leaving the indices unchanged
+ */
+bool ve_mesh_optimize_overdraw(uint32_t* indices, uint32_t index_count, const float* positions,
+                               uint32_t vertex_count, size_t position_stride, float threshold);
+
+/* Levels of detail per cooked mesh, the full mesh included */
+#define VE_MESH_MAX_LODS 8
+
+/* Each level aims for this fraction of the previous level's triangles */
+#define VE_MESH_LOD_REDUCTION 0.5f
+
+/* Levels stop once the error would exceed this fraction of the bounds diagonal */
+#define VE_MESH_LOD_MAX_ERROR 0.05f
+
+/**
+ * @brief Simplify a mesh by collapsing edges
+ *
+ * Vertices are collapsed onto neighbours in order of quadric error until
+ * the target index count is reached or the next collapse would exceed
+ * target_error. Vertices on open borders, at attribute seams (vertices
+ * sharing a position) and on non-manifold edges stay in place, and
+ * collapses that would flip a triangle are skipped. The result uses a
+ * subset of the original vertices.
+ *
+ * @param indices Triangle list indices
+ * @param index_count Number of indices, a multiple of 3
+ * @param positions First vertex position (three floats)
+ * @param vertex_count Number of vertices
+ * @param position_stride Bytes between vertex positions
+ * @param target_index_count Index count to stop at
+ * @param target_error Largest error to accept, in position units
+ * @param out_indices Receives up to index_count indices
+ * @param out_index_count Receives the index count
+ * @param out_error Receives the error of the result, in position units
+ * @return false if out of memory
+ */
+bool ve_mesh_simplify(const uint32_t* indices, uint32_t index_count, const float* positions, uint32_t vertex_count,
+                      size_t position_stride, uint32_t target_index_count, float target_error,
+                      uint32_t* out_indices, uint32_t* out_index_count, float* out_error);
+
+#define VE_MESH_BLOB_MAGIC 0x4853454Du  /* "MESH" */
+
+/**
+ * @brief Vertex layout of parsed meshes
+ */
+typedef struct ve_mesh_vertex {
+    float position[3];
+    float normal[3];
+    float uv[2];
+} ve_mesh_vertex;
+
+/**
+ * @brief Vertex layout of cooked meshes
+ *
+ * Vertex input formats R16G16B16A16_UNORM, R16G16_SNORM and
+ * R16G16_SFLOAT. Positions are fractions of the mesh bounds (pos =
+ * bounds_min + position * (bounds_max - bounds_min)), normals are
+ * octahedral and texture coordinates half floats.
+ */
+typedef struct ve_mesh_vertex_packed {
+    uint16_t position[4];               /* w is padding */
+    int16_t normal[2];
+    uint16_t uv[2];
+} ve_mesh_vertex_packed;
+
+/**
+ * @brief Reorder vertices by first use and drop unused ones
+ *
+ * @param vertices Vertices, reordered in place
+ * @param vertex_count Vertex count, receives the count of used vertices
+ * @param indices Triangle list indices, remapped in place
+ * @param index_count Number of indices
+ * @return false if out of memory, leaving both arrays unchanged
+ */
+bool ve_mesh_optimize_vertex_fetch(ve_mesh_vertex* vertices, uint32_t* vertex_count, uint32_t* indices,
+                                   uint32_t index_count);
+
+/**
+ * @brief Quantize vertices to the cooked layout
+ *
+ * @param vertices Vertices
+ * @param vertex_count Vertex count
+ * @param bounds_min Smallest position of any vertex
+ * @param bounds_max Largest position of any vertex
+ * @param out Receives vertex_count packed vertices
+ */
+void ve_mesh_quantize(const ve_mesh_vertex* vertices, uint32_t vertex_count, const float bounds_min[3],
+                      const float bounds_max[3], ve_mesh_vertex_packed* out);
+
+/**
+ * @brief Expand packed vertices, as the vertex shaders do
+ *
+ * @param packed Packed vertices
+ * @param vertex_count Vertex count
+ * @param bounds_min Bounds the vertices were quantized in
+ * @param bounds_max Bounds the vertices were quantized in
+ * @param out Receives vertex_count vertices with unit normals
+ */
+void ve_mesh_dequantize(const ve_mesh_vertex_packed* packed, uint32_t vertex_count, const float bounds_min[3],
+                        const float bounds_max[3], ve_mesh_vertex* out);
+
+/**
+ * @brief One level of detail of a cooked mesh
+ */
+typedef struct ve_mesh_lod {
+    uint32_t index_offset;              /* First index of the level's triangle list */
+    uint32_t index_count;
+    float error;                        /* Geometric error in position units, 0 for the full mesh */
+    uint32_t reserved;
+} ve_mesh_lod;
+
+/**
+ * @brief Start of a cooked mesh blob
+ *
+ * Offsets are bytes from the start of the blob, 16 byte aligned so each
+ * array can be copied straight into a buffer. The bounds are also the
+ * quantization range of the vertex positions. The index array holds the
+ * triangle lists of all levels of detail, finest first; meshlets cover
+ * the full mesh only.
+ */
+typedef struct ve_mesh_blob_header {
+    uint32_t magic;
+    uint32_t vertex_count;
+    uint32_t index_count;
+    uint32_t meshlet_count;
+    uint32_t meshlet_vertex_count;
+    uint32_t meshlet_triangle_count;
+    float bounds_min[3];
+    float bounds_max[3];
+    uint32_t vertex_offset;             /* ve_mesh_vertex_packed[vertex_count] */
+    uint32_t index_offset;              /* uint32_t[index_count], every level */
+    uint32_t meshlet_offset;            /* ve_meshlet[meshlet_count] */
+    uint32_t meshlet_vertex_offset;     /* uint32_t[meshlet_vertex_count] */
+    uint32_t meshlet_triangle_offset;   /* uint8_t[meshlet_triangle_count * 3] */
+    uint32_t lod_count;
+    ve_mesh_lod lods[VE_MESH_MAX_LODS];
+} ve_mesh_blob_header;
+
+/**
+ * @brief Read-only view of a cooked mesh
+ */
+typedef struct ve_mesh_data {
+    const ve_mesh_vertex_packed* vertices;
+    uint32_t vertex_count;
+    const uint32_t* indices;            /* Every level, ranges given by lods */
+    uint32_t index_count;
+    const ve_mesh_lod* lods;            /* lods[0] is the full mesh */
+    uint32_t lod_count;
+    const ve_meshlet* meshlets;
+    uint32_t meshlet_count;
+    const uint32_t* meshlet_vertices;
+    uint32_t meshlet_vertex_count;
+    const uint8_t* meshlet_triangles;
+    uint32_t meshlet_triangle_count;
+    float bounds_min[3];
+    float bounds_max[3];
+} ve_mesh_data;
+
+/**
+ * @brief Mesh loaded from a pak
+ */
+typedef struct ve_model {
+    ve_mesh_data mesh;
+    void* owned;                        /* Expanded blob if it was compressed */
+} ve_model;
+
+/**
+ * @brief Parse a Wavefront OBJ file into one indexed mesh
+ *
+ * Faces are triangulated as fans and identical position/uv/normal
+ * combinations share a vertex. Vertices without a normal get the
+ * area-weighted normal of their faces. Groups and materials are ignored.
+ *
+ * @param text File contents, need not be NUL terminated
+ * @param size Content size
+ * @param vertices Receives the vertices, freed with VE_FREE
+ * @param vertex_count Receives the vertex count
+ * @param indices Receives the triangle list, freed with VE_FREE
+ * @param index_count Receives the index count
+ * @return false if the file is malformed or out of memory
+ */
+bool ve_model_parse_obj(const char* text, size_t size, ve_mesh_vertex** vertices, uint32_t* vertex_count,
+                        uint32_t** indices, uint32_t* index_count);
+
+/**
+ * @brief Cook an indexed mesh into a blob
+ *
+ * Optimizes the triangle and vertex order, builds the meshlets and bounds,
+ * generates the levels of detail, quantizes the vertices and lays
+ * everything out as described by ve_mesh_blob_header. Vertices no
+ * triangle uses are dropped.
+ *
+ * @param vertices Vertices
+ * @param vertex_count Vertex count
+ * @param indices Triangle list indices
+ * @param index_count Index count, a multiple of 3
+ * @param blob Receives the blob, freed with VE_FREE
+ * @param size Receives the blob size
+ * @return true on success
+ */
+bool ve_mesh_cook(const ve_mesh_vertex* vertices, uint32_t vertex_count, const uint32_t* indices,
+                  uint32_t index_count, void** blob, size_t* size);
+
+/**
+ * @brief View a cooked mesh blob in place
+ *
+ * @param blob Blob, 16 byte aligned
+ * @param size Blob size
+ * @param out Receives pointers into the blob
+ * @return false if the blob is malformed
+ */
+bool ve_mesh_view(const void* blob, size_t size, ve_mesh_data* out);
+
+/**
+ * @brief Load a cooked mesh from a pak
+ *
+ * The mesh points into the archive, which must stay open until the model
+ * is released.
+ *
+ * @param pak Archive
+ * @param name Entry name
+ * @param model Receives the mesh
+ * @return false if the entry is missing, not a mesh or malformed
+ */
+bool ve_model_load_pak(const ve_pak* pak, const char* name, ve_model* model);
+
+/**
+ * @brief Release a model loaded from a pak
+ *
+ * @param model Model, cleared on return
+ */
+void ve_model_release(ve_model* model);
 
 #ifdef __cplusplus
 }
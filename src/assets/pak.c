@@ -0,0 +1,520 @@
+/**
+ * @file pak.c
+ * @brief Packed asset archive implementation
+ */
+
+#include "pak.h"
+#include "../platform/platform.h"
+#include "../core/memory.h"
+#include "../core/logger.h"
+#include "../core/assert.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PAK_HASH_SEED 0xcbf29ce484222325ull
+
+/* LZ4 block format limits */
+#define LZ4_MIN_MATCH 4
+#define LZ4_LAST_LITERALS 5         /* The block always ends with this many literals */
+#define LZ4_MATCH_START_LIMIT 12    /* No match starts this close to the end */
+#define LZ4_MAX_OFFSET 65535
+#define LZ4_HASH_BITS 12
+
+struct ve_pak {
+    ve_file_mapping mapping;
+    const ve_pak_header* header;
+    const ve_pak_entry* entries;
+    const char* names;
+    size_t names_size;
+};
+
+struct ve_pak_writer {
+    FILE* file;
+    uint64_t offset;
+    ve_pak_entry* entries;
+    uint32_t entry_count;
+    uint32_t entry_capacity;
+    char* names;
+    size_t names_size;
+    size_t names_capacity;
+    bool failed;
+};
+
+uint64_t ve_pak_hash_name(const char* name) {
+    uint64_t hash = PAK_HASH_SEED;
+    for (const uint8_t* c = (const uint8_t*)name; *c; c++) {
+        hash ^= *c;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+/* LZ4 */
+
+static uint32_t read32(const uint8_t* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint32_t lz4_hash(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+}
+
+/* Lengths of 15 and up continue in bytes of 255 and a final remainder */
+static uint8_t* lz4_write_length(uint8_t* op, const uint8_t* end, size_t length) {
+    while (length >= 255) {
+        if (op >= end) {
+            return NULL;
+        }
+        *op++ = 255;
+        length -= 255;
+    }
+    if (op >= end) {
+        return NULL;
+    }
+    *op++ = (uint8_t)length;
+    return op;
+}
+
+/* One token, its literals and, unless match_length is 0, a match */
+static uint8_t* lz4_write_sequence(uint8_t* op, const uint8_t* end, const uint8_t* literals, size_t literal_count,
+                                   size_t offset, size_t match_length) {
+    if (op >= end) {
+        return NULL;
+    }
+    uint8_t* token = op++;
+    *token = (uint8_t)((literal_count >= 15 ? 15 : literal_count) << 4);
+    if (literal_count >= 15 && !(op = lz4_write_length(op, end, literal_count - 15))) {
+        return NULL;
+    }
+    if ((size_t)(end - op) < literal_count) {
+        return NULL;
+    }
+    memcpy(op, literals, literal_count);
+    op += literal_count;
+
+    if (match_length == 0) {
+        return op;
+    }
+    if (end - op < 2) {
+        return NULL;
+    }
+    *op++ = (uint8_t)(offset & 0xFF);
+    *op++ = (uint8_t)(offset >> 8);
+    size_t length = match_length - LZ4_MIN_MATCH;
+    *token |= (uint8_t)(length >= 15 ? 15 : length);
+    if (length >= 15 && !(op = lz4_write_length(op, end, length - 15))) {
+        return NULL;
+    }
+    return op;
+}
+
+size_t ve_lz4_compress(const void* src, size_t size, void* dst, size_t capacity) {
+    const uint8_t* in = (const uint8_t*)src;
+    uint8_t* op = (uint8_t*)dst;
+    const uint8_t* end = op + capacity;
+    size_t anchor = 0;
+
+    if (size > INT32_MAX) {
+        return 0;
+    }
+
+    /* Greedy matching against the last position of each hashed 4-byte sequence */
+    if (size > LZ4_MATCH_START_LIMIT) {
+        int32_t table[1 << LZ4_HASH_BITS];
+        memset(table, 0xFF, sizeof(table));
+
+        size_t match_start_limit = size - LZ4_MATCH_START_LIMIT;
+        size_t match_end_limit = size - LZ4_LAST_LITERALS;
+        size_t ip = 0;
+        while (ip < match_start_limit) {
+            uint32_t sequence = read32(in + ip);
+            uint32_t hash = lz4_hash(sequence);
+            int32_t ref = table[hash];
+            table[hash] = (int32_t)ip;
+
+            if (ref < 0 || ip - (size_t)ref > LZ4_MAX_OFFSET || read32(in + ref) != sequence) {
+                ip++;
+                continue;
+            }
+
+            size_t length = LZ4_MIN_MATCH;
+            while (ip + length < match_end_limit && in[ref + length] == in[ip + length]) {
+                length++;
+            }
+            op = lz4_write_sequence(op, end, in + anchor, ip - anchor, ip - (size_t)ref, length);
+            if (!op) {
+                return 0;
+            }
+            ip += length;
+            anchor = ip;
+        }
+    }
+
+    op = lz4_write_sequence(op, end, in + anchor, size - anchor, 0, 0);
+    return op ? (size_t)(op - (uint8_t*)dst) : 0;
+}
+
+bool ve_lz4_decompress(const void* src, size_t size, void* dst, size_t capacity) {
+    const uint8_t* ip = (const uint8_t*)src;
+    const uint8_t* in_end = ip + size;
+    uint8_t* op = (uint8_t*)dst;
+    uint8_t* out_end = op + capacity;
+
+    while (ip < in_end) {
+        uint8_t token = *ip++;
+
+        size_t literal_count = token >> 4;
+        if (literal_count == 15) {
+            uint8_t extra;
+            do {
+                if (ip >= in_end) {
+                    return false;
+                }
+                extra = *ip++;
+                literal_count += extra;
+            } while (extra == 255);
+        }
+        if ((size_t)(in_end - ip) < literal_count || (size_t)(out_end - op) < literal_count) {
+            return false;
+        }
+        memcpy(op, ip, literal_count);
+        op += literal_count;
+        ip += literal_count;
+
+        /* The last sequence has literals only */
+        if (ip == in_end) {
+            break;
+        }
+
+        if (in_end - ip < 2) {
+            return false;
+        }
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - (uint8_t*)dst)) {
+            return false;
+        }
+
+        size_t length = token & 15;
+        if (length == 15) {
+            uint8_t extra;
+            do {
+                if (ip >= in_end) {
+                    return false;
+                }
+                extra = *ip++;
+                length += extra;
+            } while (extra == 255);
+        }
+        length += LZ4_MIN_MATCH;
+        if ((size_t)(out_end - op) < length) {
+            return false;
+        }
+
+        /* Byte by byte, since a match may overlap the bytes it produces */
+        const uint8_t* match = op - offset;
+        for (size_t i = 0; i < length; i++) {
+            op[i] = match[i];
+        }
+        op += length;
+    }
+
+    return op == out_end;
+}
+
+/* Reading */
+
+ve_pak* ve_pak_open(const char* path) {
+    VE_ASSERT(path);
+
+    ve_pak* pak = (ve_pak*)ve_allocate_cleared(1, sizeof(ve_pak), VE_MEMORY_TAG_ASSET);
+    if (!pak) {
+        return NULL;
+    }
+    if (!ve_file_map(path, VE_FILE_ACCESS_RANDOM, &pak->mapping)) {
+        VE_LOG_ERROR("Failed to open pak %s", path);
+        VE_FREE(pak);
+        return NULL;
+    }
+
+    const uint8_t* data = (const uint8_t*)pak->mapping.data;
+    size_t size = pak->mapping.size;
+    const ve_pak_header* header = (const ve_pak_header*)data;
+    bool valid = size >= sizeof(ve_pak_header) && header->magic == VE_PAK_MAGIC &&
+                 header->version == VE_PAK_VERSION && header->toc_offset % 8 == 0 &&
+                 header->toc_offset <= size && header->toc_size <= size - header->toc_offset &&
+                 (uint64_t)header->entry_count * sizeof(ve_pak_entry) <= header->toc_size;
+
+    if (valid) {
+        pak->header = header;
+        pak->entries = (const ve_pak_entry*)(data + header->toc_offset);
+        pak->names = (const char*)(pak->entries + header->entry_count);
+        pak->names_size = header->toc_size - header->entry_count * sizeof(ve_pak_entry);
+        valid = header->entry_count == 0 || (pak->names_size > 0 && pak->names[pak->names_size - 1] == '\0');
+
+        for (uint32_t i = 0; valid && i < header->entry_count; i++) {
+            const ve_pak_entry* entry = &pak->entries[i];
+            valid = entry->offset <= header->toc_offset && entry->stored_size <= header->toc_offset - entry->offset &&
+                    entry->name_offset < pak->names_size && (i == 0 || entry->name_hash >= entry[-1].name_hash) &&
+                    (entry->compression != VE_PAK_COMPRESSION_NONE || entry->stored_size == entry->size);
+        }
+    }
+
+    if (!valid) {
+        VE_LOG_ERROR("Pak %s is malformed or from another version", path);
+        ve_file_unmap(&pak->mapping);
+        VE_FREE(pak);
+        return NULL;
+    }
+    return pak;
+}
+
+void ve_pak_close(ve_pak* pak) {
+    if (pak) {
+        ve_file_unmap(&pak->mapping);
+        VE_FREE(pak);
+    }
+}
+
+uint32_t ve_pak_get_count(const ve_pak* pak) {
+    return pak->header->entry_count;
+}
+
+const ve_pak_entry* ve_pak_get_entry(const ve_pak* pak, uint32_t index) {
+    VE_ASSERT(index < pak->header->entry_count);
+    return &pak->entries[index];
+}
+
+const char* ve_pak_get_name(const ve_pak* pak, const ve_pak_entry* entry) {
+    return pak->names + entry->name_offset;
+}
+
+const ve_pak_entry* ve_pak_find(const ve_pak* pak, const char* name) {
+    VE_ASSERT(pak && name);
+
+    uint64_t hash = ve_pak_hash_name(name);
+    uint32_t low = 0;
+    uint32_t high = pak->header->entry_count;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        if (pak->entries[middle].name_hash < hash) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    for (uint32_t i = low; i < pak->header->entry_count && pak->entries[i].name_hash == hash; i++) {
+        if (strcmp(pak->names + pak->entries[i].name_offset, name) == 0) {
+            return &pak->entries[i];
+        }
+    }
+    return NULL;
+}
+
+void ve_pak_prefetch(const ve_pak* pak, const ve_pak_entry* entry) {
+    ve_file_prefetch(&pak->mapping, (size_t)entry->offset, (size_t)entry->stored_size);
+}
+
+const void* ve_pak_load(const ve_pak* pak, const ve_pak_entry* entry, void** owned) {
+    VE_ASSERT(pak && entry && owned);
+
+    *owned = NULL;
+    const uint8_t* stored = (const uint8_t*)pak->mapping.data + entry->offset;
+
+    switch (entry->compression) {
+        case VE_PAK_COMPRESSION_NONE:
+            return stored;
+
+        case VE_PAK_COMPRESSION_LZ4: {
+            void* buffer = VE_ALLOCATE_TAG(entry->size > 0 ? (size_t)entry->size : 1, VE_MEMORY_TAG_ASSET);
+            if (!buffer) {
+                VE_LOG_ERROR("Out of memory expanding %s", ve_pak_get_name(pak, entry));
+                return NULL;
+            }
+            if (!ve_lz4_decompress(stored, (size_t)entry->stored_size, buffer, (size_t)entry->size)) {
+                VE_LOG_ERROR("Pak entry %s is corrupt", ve_pak_get_name(pak, entry));
+                VE_FREE(buffer);
+                return NULL;
+            }
+            *owned = buffer;
+            return buffer;
+        }
+
+        default:
+            VE_LOG_ERROR("Pak entry %s uses unsupported compression %u", ve_pak_get_name(pak, entry),
+                         entry->compression);
+            return NULL;
+    }
+}
+
+/* Writing */
+
+static bool writer_write(ve_pak_writer* writer, const void* data, size_t size) {
+    if (!writer->failed && size > 0 && fwrite(data, 1, size, writer->file) != size) {
+        writer->failed = true;
+    }
+    writer->offset += size;
+    return !writer->failed;
+}
+
+static bool writer_pad(ve_pak_writer* writer, uint64_t alignment) {
+    static const uint8_t zeros[4096] = {0};
+    uint64_t padding = (alignment - writer->offset % alignment) % alignment;
+    while (padding > 0) {
+        size_t chunk = padding < sizeof(zeros) ? (size_t)padding : sizeof(zeros);
+        if (!writer_write(writer, zeros, chunk)) {
+            return false;
+        }
+        padding -= chunk;
+    }
+    return true;
+}
+
+static int compare_entries(const void* a, const void* b) {
+    uint64_t hash_a = ((const ve_pak_entry*)a)->name_hash;
+    uint64_t hash_b = ((const ve_pak_entry*)b)->name_hash;
+    return hash_a < hash_b ? -1 : hash_a > hash_b;
+}
+
+ve_pak_writer* ve_pak_writer_create(const char* path) {
+    VE_ASSERT(path);
+
+    ve_pak_writer* writer = (ve_pak_writer*)ve_allocate_cleared(1, sizeof(ve_pak_writer), VE_MEMORY_TAG_ASSET);
+    if (!writer) {
+        return NULL;
+    }
+    writer->file = fopen(path, "wb");
+    if (!writer->file) {
+        VE_LOG_ERROR("Failed to create pak %s", path);
+        VE_FREE(writer);
+        return NULL;
+    }
+
+    /* Rewritten with the final values by ve_pak_writer_finish */
+    ve_pak_header header = {0};
+    writer_write(writer, &header, sizeof(header));
+    return writer;
+}
+
+bool ve_pak_writer_add(ve_pak_writer* writer, const char* name, ve_pak_type type, const void* data, size_t size,
+                       ve_pak_compression compression) {
+    VE_ASSERT(writer && name && (data || size == 0));
+
+    if (writer->entry_count == writer->entry_capacity) {
+        uint32_t capacity = writer->entry_capacity ? writer->entry_capacity * 2 : 64;
+        ve_pak_entry* entries = (ve_pak_entry*)ve_reallocate(writer->entries, capacity * sizeof(ve_pak_entry),
+                                                             VE_MEMORY_TAG_ASSET);
+        if (!entries) {
+            writer->failed = true;
+            return false;
+        }
+        writer->entries = entries;
+        writer->entry_capacity = capacity;
+    }
+
+    size_t name_size = strlen(name) + 1;
+    if (writer->names_size + name_size > writer->names_capacity) {
+        size_t capacity = writer->names_capacity ? writer->names_capacity * 2 : 4096;
+        while (capacity < writer->names_size + name_size) {
+            capacity *= 2;
+        }
+        char* names = (char*)ve_reallocate(writer->names, capacity, VE_MEMORY_TAG_ASSET);
+        if (!names) {
+            writer->failed = true;
+            return false;
+        }
+        writer->names = names;
+        writer->names_capacity = capacity;
+    }
+
+    if (compression == VE_PAK_COMPRESSION_ZSTD) {
+        VE_LOG_WARN("Zstd is not available in this build, storing %s uncompressed", name);
+        compression = VE_PAK_COMPRESSION_NONE;
+    }
+
+    const void* stored = data;
+    size_t stored_size = size;
+    void* compressed = NULL;
+    if (compression == VE_PAK_COMPRESSION_LZ4 && size > 0) {
+        compressed = VE_ALLOCATE_TAG(size, VE_MEMORY_TAG_ASSET);
+        size_t compressed_size = compressed ? ve_lz4_compress(data, size, compressed, size - 1) : 0;
+        if (compressed_size > 0) {
+            stored = compressed;
+            stored_size = compressed_size;
+        } else {
+            compression = VE_PAK_COMPRESSION_NONE;
+        }
+    } else {
+        compression = VE_PAK_COMPRESSION_NONE;
+    }
+
+    bool written = writer_pad(writer, VE_PAK_ALIGNMENT);
+    ve_pak_entry* entry = &writer->entries[writer->entry_count];
+    memset(entry, 0, sizeof(ve_pak_entry));
+    entry->name_hash = ve_pak_hash_name(name);
+    entry->offset = writer->offset;
+    entry->stored_size = stored_size;
+    entry->size = size;
+    entry->name_offset = (uint32_t)writer->names_size;
+    entry->type = (uint16_t)type;
+    entry->compression = (uint16_t)compression;
+    written = written && writer_write(writer, stored, stored_size);
+    VE_FREE(compressed);
+
+    if (!written) {
+        VE_LOG_ERROR("Failed to write pak entry %s", name);
+        return false;
+    }
+    memcpy(writer->names + writer->names_size, name, name_size);
+    writer->names_size += name_size;
+    writer->entry_count++;
+    return true;
+}
+
+bool ve_pak_writer_finish(ve_pak_writer* writer) {
+    VE_ASSERT(writer);
+
+    bool success = !writer->failed;
+    qsort(writer->entries, writer->entry_count, sizeof(ve_pak_entry), compare_entries);
+
+    /* Equal names hash equally, so duplicates sit in the same run */
+    for (uint32_t i = 0; success && i < writer->entry_count; i++) {
+        for (uint32_t j = i + 1; j < writer->entry_count &&
+                                 writer->entries[j].name_hash == writer->entries[i].name_hash; j++) {
+            const char* name = writer->names + writer->entries[i].name_offset;
+            if (strcmp(name, writer->names + writer->entries[j].name_offset) == 0) {
+                VE_LOG_ERROR("Pak entry %s was added twice", name);
+                success = false;
+                break;
+            }
+        }
+    }
+
+    if (success) {
+        writer_pad(writer, 8);
+        ve_pak_header header = {
+            .magic = VE_PAK_MAGIC,
+            .version = VE_PAK_VERSION,
+            .entry_count = writer->entry_count,
+            .toc_offset = writer->offset,
+            .toc_size = writer->entry_count * sizeof(ve_pak_entry) + writer->names_size,
+        };
+        writer_write(writer, writer->entries, writer->entry_count * sizeof(ve_pak_entry));
+        writer_write(writer, writer->names, writer->names_size);
+        success = !writer->failed && fseek(writer->file, 0, SEEK_SET) == 0 &&
+                  fwrite(&header, sizeof(header), 1, writer->file) == 1;
+    }
+    if (fclose(writer->file) != 0) {
+        success = false;
+    }
+
+    VE_FREE(writer->entries);
+    VE_FREE(writer->names);
+    VE_FREE(writer);
+    return success;
+}
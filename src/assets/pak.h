@@ -0,0 +1,235 @@
+/**
+ * @file pak.h
+ * @brief Packed asset archives
+ *
+ * A pak holds every cooked asset of a game in one file, so a level load is
+ * one open and mostly sequential reads instead of a file open and a format
+ * parse per asset. The file is mapped whole: a header points at a table of
+ * contents sorted by name hash, and each entry points at a blob that
+ * starts on a VE_PAK_ALIGNMENT boundary. Blobs are stored in GPU-ready
+ * layouts (see ve_mesh_view and ve_texture_view), so uncompressed blobs are
+ * used in place; compressed blobs are expanded into one heap buffer.
+ *
+ * Layout:
+ *   ve_pak_header
+ *   blobs, each VE_PAK_ALIGNMENT aligned
+ *   ve_pak_entry[entry_count], sorted by name_hash
+ *   entry names, NUL terminated
+ *
+ * Paks are written offline by the cooker (tools/cooker) through
+ * ve_pak_writer.
+ */
+
+#ifndef VE_PAK_H
+#define VE_PAK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VE_PAK_MAGIC 0x4B415056u        /* "VPAK" */
+#define VE_PAK_VERSION 1
+
+/* Blob alignment, a multiple of every page and sector size */
+#define VE_PAK_ALIGNMENT (64u * 1024u)
+
+/**
+ * @brief Blob compression
+ */
+typedef enum ve_pak_compression {
+    VE_PAK_COMPRESSION_NONE = 0,
+    VE_PAK_COMPRESSION_LZ4 = 1,         /* LZ4 block format */
+    VE_PAK_COMPRESSION_ZSTD = 2         /* Reserved, not supported by this build */
+} ve_pak_compression;
+
+/**
+ * @brief Blob contents
+ */
+typedef enum ve_pak_type {
+    VE_PAK_TYPE_RAW = 0,
+    VE_PAK_TYPE_MESH = 1,               /* ve_mesh_blob_header and its arrays */
+    VE_PAK_TYPE_TEXTURE = 2             /* ve_texture_blob_header and its mips */
+} ve_pak_type;
+
+/**
+ * @brief File header
+ */
+typedef struct ve_pak_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t reserved;
+    uint64_t toc_offset;                /* Entries, then names */
+    uint64_t toc_size;
+} ve_pak_header;
+
+/**
+ * @brief Table of contents entry
+ */
+typedef struct ve_pak_entry {
+    uint64_t name_hash;                 /* FNV-1a of the name */
+    uint64_t offset;                    /* Blob offset in the file */
+    uint64_t stored_size;               /* Bytes in the file */
+    uint64_t size;                      /* Bytes once decompressed */
+    uint32_t name_offset;               /* Into the names after the entries */
+    uint16_t type;                      /* ve_pak_type */
+    uint16_t compression;               /* ve_pak_compression */
+} ve_pak_entry;
+
+/**
+ * @brief Open archive
+ */
+typedef struct ve_pak ve_pak;
+
+/**
+ * @brief Archive writer
+ */
+typedef struct ve_pak_writer ve_pak_writer;
+
+/**
+ * @brief Hash an entry name
+ *
+ * @param name Name
+ * @return FNV-1a hash
+ */
+uint64_t ve_pak_hash_name(const char* name);
+
+/**
+ * @brief Map an archive and validate its table of contents
+ *
+ * @param path Archive path
+ * @return Archive, or NULL if it cannot be read or is malformed
+ */
+ve_pak* ve_pak_open(const char* path);
+
+/**
+ * @brief Unmap an archive
+ *
+ * Pointers into it become invalid.
+ *
+ * @param pak Archive
+ */
+void ve_pak_close(ve_pak* pak);
+
+/**
+ * @brief Get the number of entries
+ *
+ * @param pak Archive
+ * @return Entry count
+ */
+uint32_t ve_pak_get_count(const ve_pak* pak);
+
+/**
+ * @brief Get an entry by index, in name hash order
+ *
+ * @param pak Archive
+ * @param index Index below ve_pak_get_count
+ * @return Entry
+ */
+const ve_pak_entry* ve_pak_get_entry(const ve_pak* pak, uint32_t index);
+
+/**
+ * @brief Get the name of an entry
+ *
+ * @param pak Archive
+ * @param entry Entry
+ * @return Name
+ */
+const char* ve_pak_get_name(const ve_pak* pak, const ve_pak_entry* entry);
+
+/**
+ * @brief Find an entry by name
+ *
+ * @param pak Archive
+ * @param name Name
+ * @return Entry, or NULL if absent
+ */
+const ve_pak_entry* ve_pak_find(const ve_pak* pak, const char* name);
+
+/**
+ * @brief Ask the OS to start reading an entry's blob
+ *
+ * @param pak Archive
+ * @param entry Entry
+ */
+void ve_pak_prefetch(const ve_pak* pak, const ve_pak_entry* entry);
+
+/**
+ * @brief Get the contents of an entry
+ *
+ * Uncompressed blobs are returned in place. Compressed blobs are expanded
+ * into a buffer returned through owned, which the caller frees with
+ * VE_FREE; owned is NULL for blobs returned in place.
+ *
+ * @param pak Archive
+ * @param entry Entry
+ * @param owned Receives the buffer to free, if any
+ * @return entry->size bytes of contents, or NULL on failure
+ */
+const void* ve_pak_load(const ve_pak* pak, const ve_pak_entry* entry, void** owned);
+
+/**
+ * @brief Start writing an archive
+ *
+ * @param path Output path
+ * @return Writer, or NULL if the file cannot be created
+ */
+ve_pak_writer* ve_pak_writer_create(const char* path);
+
+/**
+ * @brief Append an entry
+ *
+ * A compressed blob that would not be smaller is stored uncompressed.
+ *
+ * @param writer Writer
+ * @param name Unique name, e.g. the source path relative to the asset root
+ * @param type Contents
+ * @param data Blob
+ * @param size Blob size
+ * @param compression Compression to try
+ * @return false on IO failure or out of memory
+ */
+bool ve_pak_writer_add(ve_pak_writer* writer, const char* name, ve_pak_type type, const void* data, size_t size,
+                       ve_pak_compression compression);
+
+/**
+ * @brief Write the table of contents and close the archive
+ *
+ * Frees the writer whether or not it succeeds.
+ *
+ * @param writer Writer
+ * @return false on IO failure or duplicate names
+ */
+bool ve_pak_writer_finish(ve_pak_writer* writer);
+
+/**
+ * @brief Compress with the LZ4 block format
+ *
+ * @param src Input
+ * @param size Input size
+ * @param dst Output
+ * @param capacity Output capacity
+ * @return Compressed size, 0 if it does not fit
+ */
+size_t ve_lz4_compress(const void* src, size_t size, void* dst, size_t capacity);
+
+/**
+ * @brief Decompress an LZ4 block
+ *
+ * @param src Compressed input
+ * @param size Input size
+ * @param dst Output
+ * @param capacity Exact decompressed size
+ * @return false if the input is malformed or does not expand to capacity bytes
+ */
+bool ve_lz4_decompress(const void* src, size_t size, void* dst, size_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_PAK_H */
@@ -4,5 +4,1100 @@
  */
 
 #include "texture_loader.h"
+#include "../core/memory.h"
+#include "../core/logger.h"
+#include "../core/assert.h"
 
-/* TODO: Implement texture loading */
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TGA_HEADER_SIZE 18
+#define TGA_TYPE_TRUE_COLOR 2
+#define TGA_TYPE_TRUE_COLOR_RLE 10
+#define TGA_DESCRIPTOR_RIGHT_TO_LEFT 0x10
+#define TGA_DESCRIPTOR_TOP_TO_BOTTOM 0x20
+
+/* Alignment of the mips in a cooked texture blob, enough for any block format */
+#define TEXTURE_BLOB_ALIGNMENT 16
+
+/* Texels of one block, row major, RGBA8 */
+typedef uint8_t texture_block[VE_TEXTURE_BLOCK_SIZE * VE_TEXTURE_BLOCK_SIZE][4];
+
+typedef struct texture_format_info {
+    ve_texture_family family;
+    bool srgb;
+    uint32_t block_size;            /* Texels across a block */
+    uint32_t block_bytes;
+} texture_format_info;
+
+static const texture_format_info g_format_info[VE_TEXTURE_FORMAT_COUNT] = {
+    [VE_TEXTURE_FORMAT_RGBA8_UNORM] = {VE_TEXTURE_FAMILY_RGBA8, false, 1, 4},
+    [VE_TEXTURE_FORMAT_RGBA8_SRGB] = {VE_TEXTURE_FAMILY_RGBA8, true, 1, 4},
+    [VE_TEXTURE_FORMAT_BC1_UNORM] = {VE_TEXTURE_FAMILY_BC, false, 4, 8},
+    [VE_TEXTURE_FORMAT_BC1_SRGB] = {VE_TEXTURE_FAMILY_BC, true, 4, 8},
+    [VE_TEXTURE_FORMAT_BC3_UNORM] = {VE_TEXTURE_FAMILY_BC, false, 4, 16},
+    [VE_TEXTURE_FORMAT_BC3_SRGB] = {VE_TEXTURE_FAMILY_BC, true, 4, 16},
+    [VE_TEXTURE_FORMAT_ETC2_RGB8_UNORM] = {VE_TEXTURE_FAMILY_ETC2, false, 4, 8},
+    [VE_TEXTURE_FORMAT_ETC2_RGB8_SRGB] = {VE_TEXTURE_FAMILY_ETC2, true, 4, 8},
+    [VE_TEXTURE_FORMAT_ETC2_RGBA8_UNORM] = {VE_TEXTURE_FAMILY_ETC2, false, 4, 16},
+    [VE_TEXTURE_FORMAT_ETC2_RGBA8_SRGB] = {VE_TEXTURE_FAMILY_ETC2, true, 4, 16},
+    [VE_TEXTURE_FORMAT_ASTC_4x4_UNORM] = {VE_TEXTURE_FAMILY_ASTC, false, 4, 16},
+    [VE_TEXTURE_FORMAT_ASTC_4x4_SRGB] = {VE_TEXTURE_FAMILY_ASTC, true, 4, 16},
+};
+
+/* ETC1 intensity modifiers: selectors 0-3 pick +a, +b, -a, -b */
+static const int g_etc_modifiers[8][2] = {
+    {2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183},
+};
+
+/* ETC2 T and H mode distances */
+static const int g_etc_distances[8] = {3, 6, 11, 16, 23, 32, 41, 64};
+
+/* EAC alpha modifiers */
+static const int g_eac_modifiers[16][8] = {
+    {-3, -6, -9, -15, 2, 5, 8, 14},  {-3, -7, -10, -13, 2, 6, 9, 12}, {-2, -5, -8, -13, 1, 4, 7, 12},
+    {-2, -4, -6, -13, 1, 3, 5, 12},  {-3, -6, -8, -12, 2, 5, 7, 11},  {-3, -7, -9, -11, 2, 6, 8, 10},
+    {-4, -7, -8, -11, 3, 6, 7, 10},  {-3, -5, -8, -11, 2, 4, 7, 10},  {-2, -6, -8, -10, 1, 5, 7, 9},
+    {-2, -5, -8, -10, 1, 4, 7, 9},   {-2, -4, -8, -10, 1, 3, 7, 9},   {-2, -5, -7, -10, 1, 4, 6, 9},
+    {-3, -4, -7, -10, 2, 3, 6, 9},   {-1, -2, -3, -10, 0, 1, 2, 9},   {-4, -6, -8, -9, 3, 5, 7, 8},
+    {-3, -5, -7, -9, 2, 4, 6, 8},
+};
+
+/* EAC table whose modifier 4 is 0, for constant alpha */
+#define EAC_CONSTANT_TABLE 13
+
+static float srgb_to_linear(float value) {
+    return value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+}
+
+static float linear_to_srgb(float value) {
+    return value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+}
+
+static uint8_t quantize(float value) {
+    value = value < 0.0f ? 0.0f : value > 1.0f ? 1.0f : value;
+    return (uint8_t)(value * 255.0f + 0.5f);
+}
+
+static int clamp_byte(int value) {
+    return value < 0 ? 0 : value > 255 ? 255 : value;
+}
+
+static uint32_t color_error(const int a[3], const uint8_t b[4]) {
+    int dr = a[0] - b[0];
+    int dg = a[1] - b[1];
+    int db = a[2] - b[2];
+    return (uint32_t)(dr * dr + dg * dg + db * db);
+}
+
+static uint64_t read_be64(const uint8_t* in) {
+    uint64_t value = 0;
+    for (uint32_t i = 0; i < 8; i++) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+static void write_be64(uint8_t* out, uint64_t value) {
+    for (uint32_t i = 0; i < 8; i++) {
+        out[i] = (uint8_t)(value >> (56 - i * 8));
+    }
+}
+
+ve_texture_family ve_texture_format_get_family(ve_texture_format format) {
+    VE_ASSERT(format < VE_TEXTURE_FORMAT_COUNT);
+    return g_format_info[format].family;
+}
+
+bool ve_texture_format_is_srgb(ve_texture_format format) {
+    VE_ASSERT(format < VE_TEXTURE_FORMAT_COUNT);
+    return g_format_info[format].srgb;
+}
+
+uint64_t ve_texture_get_level_size(ve_texture_format format, uint32_t width, uint32_t height) {
+    VE_ASSERT(format < VE_TEXTURE_FORMAT_COUNT);
+    const texture_format_info* info = &g_format_info[format];
+    uint64_t blocks_x = (width + info->block_size - 1) / info->block_size;
+    uint64_t blocks_y = (height + info->block_size - 1) / info->block_size;
+    return blocks_x * blocks_y * info->block_bytes;
+}
+
+int32_t ve_texture_select_variant(const ve_texture_data* data, uint32_t families) {
+    VE_ASSERT(data);
+
+    /* ASTC 4x4 and BC3 match in size, ASTC holds detail better; ETC2 trails BC in quality */
+    static const uint32_t ranks[] = {
+        [VE_TEXTURE_FAMILY_RGBA8] = 1,
+        [VE_TEXTURE_FAMILY_ETC2] = 2,
+        [VE_TEXTURE_FAMILY_BC] = 3,
+        [VE_TEXTURE_FAMILY_ASTC] = 4,
+    };
+
+    int32_t best = -1;
+    uint32_t best_rank = 0;
+    families |= VE_TEXTURE_FAMILY_RGBA8;
+    for (uint32_t i = 0; i < data->variant_count; i++) {
+        ve_texture_family family = ve_texture_format_get_family((ve_texture_format)data->variants[i].format);
+        if ((families & family) && ranks[family] > best_rank) {
+            best = (int32_t)i;
+            best_rank = ranks[family];
+        }
+    }
+    return best;
+}
+
+bool ve_texture_decode_tga(const void* data, size_t size, uint8_t** pixels, uint32_t* width, uint32_t* height) {
+    VE_ASSERT((data || size == 0) && pixels && width && height);
+
+    *pixels = NULL;
+    *width = 0;
+    *height = 0;
+
+    const uint8_t* bytes = (const uint8_t*)data;
+    if (size < TGA_HEADER_SIZE) {
+        VE_LOG_ERROR("TGA is truncated");
+        return false;
+    }
+
+    uint8_t image_type = bytes[2];
+    uint32_t image_width = (uint32_t)bytes[12] | ((uint32_t)bytes[13] << 8);
+    uint32_t image_height = (uint32_t)bytes[14] | ((uint32_t)bytes[15] << 8);
+    uint32_t bytes_per_pixel = bytes[16] / 8;
+    uint8_t descriptor = bytes[17];
+    if ((image_type != TGA_TYPE_TRUE_COLOR && image_type != TGA_TYPE_TRUE_COLOR_RLE) ||
+        (bytes[16] != 24 && bytes[16] != 32) || image_width == 0 || image_height == 0) {
+        VE_LOG_ERROR("Unsupported TGA: type %u, %u bits per pixel", image_type, bytes[16]);
+        return false;
+    }
+
+    /* Skip the image ID and any color map, which true color images do not use */
+    size_t color_map_size = bytes[1] ? ((size_t)bytes[5] | ((size_t)bytes[6] << 8)) * ((bytes[7] + 7u) / 8u) : 0;
+    size_t offset = TGA_HEADER_SIZE + bytes[0] + color_map_size;
+
+    size_t pixel_count = (size_t)image_width * image_height;
+    uint8_t* out = (uint8_t*)VE_ALLOCATE_TAG(pixel_count * 4, VE_MEMORY_TAG_TEXTURE);
+    if (!out) {
+        VE_LOG_ERROR("Out of memory decoding a %ux%u TGA", image_width, image_height);
+        return false;
+    }
+
+    bool flip_x = (descriptor & TGA_DESCRIPTOR_RIGHT_TO_LEFT) != 0;
+    bool flip_y = (descriptor & TGA_DESCRIPTOR_TOP_TO_BOTTOM) == 0;
+    size_t i = 0;
+    while (i < pixel_count) {
+        /* Uncompressed images are one raw run of every pixel */
+        size_t run = pixel_count - i;
+        bool repeat = false;
+        if (image_type == TGA_TYPE_TRUE_COLOR_RLE) {
+            if (offset >= size) {
+                break;
+            }
+            uint8_t packet = bytes[offset++];
+            run = (size_t)(packet & 0x7F) + 1;
+            repeat = (packet & 0x80) != 0;
+            run = run < pixel_count - i ? run : pixel_count - i;
+        }
+
+        size_t needed = (repeat ? 1 : run) * bytes_per_pixel;
+        if (needed > size - offset) {
+            break;
+        }
+        for (size_t k = 0; k < run; k++, i++) {
+            const uint8_t* source = bytes + offset + (repeat ? 0 : k * bytes_per_pixel);
+            size_t x = i % image_width;
+            size_t y = i / image_width;
+            x = flip_x ? image_width - 1 - x : x;
+            y = flip_y ? image_height - 1 - y : y;
+            uint8_t* target = out + (y * image_width + x) * 4;
+            target[0] = source[2];
+            target[1] = source[1];
+            target[2] = source[0];
+            target[3] = bytes_per_pixel == 4 ? source[3] : 255;
+        }
+        offset += needed;
+    }
+
+    if (i < pixel_count) {
+        VE_LOG_ERROR("TGA pixel data is truncated");
+        VE_FREE(out);
+        return false;
+    }
+
+    *pixels = out;
+    *width = image_width;
+    *height = image_height;
+    return true;
+}
+
+/* Block encoders */
+
+static uint16_t pack_565(const float color[3]) {
+    int r = (int)(color[0] * 31.0f / 255.0f + 0.5f);
+    int g = (int)(color[1] * 63.0f / 255.0f + 0.5f);
+    int b = (int)(color[2] * 31.0f / 255.0f + 0.5f);
+    r = r < 0 ? 0 : r > 31 ? 31 : r;
+    g = g < 0 ? 0 : g > 63 ? 63 : g;
+    b = b < 0 ? 0 : b > 31 ? 31 : b;
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void unpack_565(uint16_t value, int color[3]) {
+    int r = (value >> 11) & 31;
+    int g = (value >> 5) & 63;
+    int b = value & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+/* Colors of a BC1 block; the three color mode makes entry 3 transparent black */
+static void bc1_palette(uint16_t c0, uint16_t c1, bool four_colors, int palette[4][4]) {
+    unpack_565(c0, palette[0]);
+    unpack_565(c1, palette[1]);
+    for (uint32_t c = 0; c < 3; c++) {
+        if (four_colors) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        } else {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    palette[0][3] = palette[1][3] = palette[2][3] = 255;
+    palette[3][3] = four_colors ? 255 : 0;
+}
+
+/**
+ * @brief Encode the color half of a BC1/BC3 block
+ *
+ * Endpoints are the extremes of the colors along their principal axis,
+ * which fits gradients far better than the bounding box corners.
+ */
+static void encode_bc1_color(const texture_block block, uint8_t* out) {
+    float mean[3] = {0.0f, 0.0f, 0.0f};
+    for (uint32_t i = 0; i < 16; i++) {
+        for (uint32_t c = 0; c < 3; c++) {
+            mean[c] += block[i][c] / 16.0f;
+        }
+    }
+
+    float covariance[6] = {0.0f};
+    for (uint32_t i = 0; i < 16; i++) {
+        float r = block[i][0] - mean[0];
+        float g = block[i][1] - mean[1];
+        float b = block[i][2] - mean[2];
+        covariance[0] += r * r;
+        covariance[1] += r * g;
+        covariance[2] += r * b;
+        covariance[3] += g * g;
+        covariance[4] += g * b;
+        covariance[5] += b * b;
+    }
+
+    /* Power iteration for the dominant eigenvector */
+    float axis[3] = {1.0f, 1.0f, 1.0f};
+    for (uint32_t iteration = 0; iteration < 8; iteration++) {
+        float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+        float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+        float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+        float largest = fmaxf(fabsf(x), fmaxf(fabsf(y), fabsf(z)));
+        if (largest < 1e-6f) {
+            break;
+        }
+        axis[0] = x / largest;
+        axis[1] = y / largest;
+        axis[2] = z / largest;
+    }
+    float length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    for (uint32_t c = 0; c < 3; c++) {
+        axis[c] /= length;
+    }
+
+    float low = FLT_MAX;
+    float high = -FLT_MAX;
+    for (uint32_t i = 0; i < 16; i++) {
+        float t = (block[i][0] - mean[0]) * axis[0] + (block[i][1] - mean[1]) * axis[1] +
+                  (block[i][2] - mean[2]) * axis[2];
+        low = fminf(low, t);
+        high = fmaxf(high, t);
+    }
+
+    float end0[3], end1[3];
+    for (uint32_t c = 0; c < 3; c++) {
+        end0[c] = mean[c] + axis[c] * high;
+        end1[c] = mean[c] + axis[c] * low;
+    }
+    uint16_t c0 = pack_565(end0);
+    uint16_t c1 = pack_565(end1);
+
+    /* c0 > c1 selects four colors; equal endpoints need only index 0 */
+    if (c0 < c1) {
+        uint16_t swap = c0;
+        c0 = c1;
+        c1 = swap;
+    }
+    uint32_t indices = 0;
+    if (c0 != c1) {
+        int palette[4][4];
+        bc1_palette(c0, c1, true, palette);
+        for (uint32_t i = 0; i < 16; i++) {
+            uint32_t best = 0;
+            uint32_t best_error = UINT32_MAX;
+            for (uint32_t p = 0; p < 4; p++) {
+                uint32_t error = color_error(palette[p], block[i]);
+                if (error < best_error) {
+                    best = p;
+                    best_error = error;
+                }
+            }
+            indices |= best << (i * 2);
+        }
+    }
+
+    out[0] = (uint8_t)(c0 & 0xFF);
+    out[1] = (uint8_t)(c0 >> 8);
+    out[2] = (uint8_t)(c1 & 0xFF);
+    out[3] = (uint8_t)(c1 >> 8);
+    for (uint32_t b = 0; b < 4; b++) {
+        out[4 + b] = (uint8_t)(indices >> (b * 8));
+    }
+}
+
+/* Values of a BC4 (BC3 alpha) block */
+static void bc4_palette(uint8_t a0, uint8_t a1, int palette[8]) {
+    palette[0] = a0;
+    palette[1] = a1;
+    if (a0 > a1) {
+        for (int i = 1; i <= 6; i++) {
+            palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+        }
+    } else {
+        for (int i = 1; i <= 4; i++) {
+            palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+static void encode_bc4(const uint8_t values[16], uint8_t* out) {
+    uint8_t low = 255;
+    uint8_t high = 0;
+    for (uint32_t i = 0; i < 16; i++) {
+        low = values[i] < low ? values[i] : low;
+        high = values[i] > high ? values[i] : high;
+    }
+
+    uint64_t indices = 0;
+    if (high != low) {
+        int palette[8];
+        bc4_palette(high, low, palette);
+        for (uint32_t i = 0; i < 16; i++) {
+            uint64_t best = 0;
+            int best_error = INT32_MAX;
+            for (uint32_t p = 0; p < 8; p++) {
+                int error = abs(palette[p] - values[i]);
+                if (error < best_error) {
+                    best = p;
+                    best_error = error;
+                }
+            }
+            indices |= best << (i * 3);
+        }
+    }
+
+    out[0] = high;
+    out[1] = low;
+    for (uint32_t b = 0; b < 6; b++) {
+        out[2 + b] = (uint8_t)(indices >> (b * 8));
+    }
+}
+
+/* ETC selector for a texel at (x, y): MSB at bit 16 + x * 4 + y, LSB at bit x * 4 + y */
+static uint32_t etc_texel_bit(uint32_t texel) {
+    return (texel % 4) * 4 + texel / 4;
+}
+
+/**
+ * @brief Best intensity table and selectors for one half of an ETC block
+ *
+ * @return Squared error
+ */
+static uint32_t etc_fit_half(const texture_block block, const uint8_t texels[8], const int base[3],
+                             uint32_t* table, uint8_t selectors[8]) {
+    uint32_t best_error = UINT32_MAX;
+    for (uint32_t t = 0; t < 8; t++) {
+        uint32_t error = 0;
+        uint8_t chosen[8];
+        for (uint32_t i = 0; i < 8 && error < best_error; i++) {
+            uint32_t texel_error = UINT32_MAX;
+            for (uint32_t s = 0; s < 4; s++) {
+                int modifier = g_etc_modifiers[t][s & 1] * (s & 2 ? -1 : 1);
+                int color[3] = {
+                    clamp_byte(base[0] + modifier),
+                    clamp_byte(base[1] + modifier),
+                    clamp_byte(base[2] + modifier),
+                };
+                uint32_t candidate = color_error(color, block[texels[i]]);
+                if (candidate < texel_error) {
+                    texel_error = candidate;
+                    chosen[i] = (uint8_t)s;
+                }
+            }
+            error += texel_error;
+        }
+        if (error < best_error) {
+            best_error = error;
+            *table = t;
+            memcpy(selectors, chosen, 8);
+        }
+    }
+    return best_error;
+}
+
+/**
+ * @brief Encode an ETC2 RGB8 block
+ *
+ * Uses the ETC1 individual and differential modes, which ETC2 decodes
+ * unchanged; differential bases are kept in range so the block never
+ * reads as a T, H or planar block.
+ */
+static void encode_etc2_color(const texture_block block, uint8_t* out) {
+    uint64_t best_bits = 0;
+    uint64_t best_error = UINT64_MAX;
+
+    for (uint32_t flip = 0; flip < 2; flip++) {
+        /* Not flipped: left and right 2x4 halves; flipped: top and bottom 4x2 halves */
+        uint8_t texels[2][8];
+        uint32_t counts[2] = {0, 0};
+        float average[2][3] = {{0.0f}};
+        for (uint32_t texel = 0; texel < 16; texel++) {
+            uint32_t half = flip ? texel / 4 >= 2 : texel % 4 >= 2;
+            texels[half][counts[half]++] = (uint8_t)texel;
+            for (uint32_t c = 0; c < 3; c++) {
+                average[half][c] += block[texel][c] / 8.0f;
+            }
+        }
+
+        for (uint32_t differential = 0; differential < 2; differential++) {
+            int quantized[2][3];
+            int base[2][3];
+            bool representable = true;
+            for (uint32_t half = 0; half < 2; half++) {
+                for (uint32_t c = 0; c < 3; c++) {
+                    int levels = differential ? 31 : 15;
+                    int q = (int)(average[half][c] * levels / 255.0f + 0.5f);
+                    q = q > levels ? levels : q;
+                    quantized[half][c] = q;
+                    base[half][c] = differential ? (q << 3) | (q >> 2) : (q << 4) | q;
+                }
+            }
+            for (uint32_t c = 0; differential && c < 3; c++) {
+                int delta = quantized[1][c] - quantized[0][c];
+                representable = representable && delta >= -4 && delta <= 3;
+            }
+            if (!representable) {
+                continue;
+            }
+
+            uint32_t tables[2];
+            uint8_t selectors[2][8];
+            uint64_t error = (uint64_t)etc_fit_half(block, texels[0], base[0], &tables[0], selectors[0]) +
+                             etc_fit_half(block, texels[1], base[1], &tables[1], selectors[1]);
+            if (error >= best_error) {
+                continue;
+            }
+
+            uint64_t bits = 0;
+            for (uint32_t c = 0; c < 3; c++) {
+                uint32_t shift = 59 - c * 8;
+                if (differential) {
+                    bits |= (uint64_t)quantized[0][c] << shift;
+                    bits |= (uint64_t)((quantized[1][c] - quantized[0][c]) & 7) << (shift - 3);
+                } else {
+                    bits |= (uint64_t)quantized[0][c] << (shift + 1);
+                    bits |= (uint64_t)quantized[1][c] << (shift - 3);
+                }
+            }
+            bits |= (uint64_t)tables[0] << 37 | (uint64_t)tables[1] << 34;
+            bits |= (uint64_t)differential << 33 | (uint64_t)flip << 32;
+            for (uint32_t half = 0; half < 2; half++) {
+                for (uint32_t i = 0; i < 8; i++) {
+                    uint32_t bit = etc_texel_bit(texels[half][i]);
+                    bits |= (uint64_t)(selectors[half][i] >> 1) << (16 + bit);
+                    bits |= (uint64_t)(selectors[half][i] & 1) << bit;
+                }
+            }
+            best_bits = bits;
+            best_error = error;
+        }
+    }
+
+    write_be64(out, best_bits);
+}
+
+static uint32_t eac_fit(const uint8_t values[16], int base, int multiplier, uint32_t table, uint8_t indices[16]) {
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < 16; i++) {
+        uint32_t best_error = UINT32_MAX;
+        for (uint32_t m = 0; m < 8; m++) {
+            int error = clamp_byte(base + g_eac_modifiers[table][m] * multiplier) - values[i];
+            if ((uint32_t)(error * error) < best_error) {
+                best_error = (uint32_t)(error * error);
+                indices[i] = (uint8_t)m;
+            }
+        }
+        total += best_error;
+    }
+    return total;
+}
+
+/**
+ * @brief Encode an EAC alpha block
+ *
+ * The multiplier is derived from each table's spread instead of searched,
+ * trying its neighbors to absorb rounding.
+ */
+static void encode_eac(const uint8_t values[16], uint8_t* out) {
+    int low = 255;
+    int high = 0;
+    for (uint32_t i = 0; i < 16; i++) {
+        low = values[i] < low ? values[i] : low;
+        high = values[i] > high ? values[i] : high;
+    }
+
+    int base = (low + high + 1) / 2;
+    int best_multiplier = 1;
+    uint32_t best_table = EAC_CONSTANT_TABLE;
+    uint8_t best_indices[16];
+    uint32_t best_error = eac_fit(values, base, 1, EAC_CONSTANT_TABLE, best_indices);
+
+    for (uint32_t table = 0; table < 16 && best_error > 0; table++) {
+        int spread = g_eac_modifiers[table][7] - g_eac_modifiers[table][3];
+        int guess = (high - low + spread / 2) / spread;
+        for (int multiplier = guess - 1; multiplier <= guess + 1; multiplier++) {
+            if (multiplier < 1 || multiplier > 15) {
+                continue;
+            }
+            uint8_t indices[16];
+            uint32_t error = eac_fit(values, base, multiplier, table, indices);
+            if (error < best_error) {
+                best_error = error;
+                best_multiplier = multiplier;
+                best_table = table;
+                memcpy(best_indices, indices, sizeof(indices));
+            }
+        }
+    }
+
+    uint64_t bits = (uint64_t)base << 56 | (uint64_t)best_multiplier << 52 | (uint64_t)best_table << 48;
+    for (uint32_t i = 0; i < 16; i++) {
+        bits |= (uint64_t)best_indices[i] << (45 - etc_texel_bit(i) * 3);
+    }
+    write_be64(out, bits);
+}
+
+/* Block decoders */
+
+static void decode_bc1_color(const uint8_t* in, bool allow_transparent, texture_block block) {
+    uint16_t c0 = (uint16_t)(in[0] | (in[1] << 8));
+    uint16_t c1 = (uint16_t)(in[2] | (in[3] << 8));
+    uint32_t indices = (uint32_t)in[4] | ((uint32_t)in[5] << 8) | ((uint32_t)in[6] << 16) | ((uint32_t)in[7] << 24);
+
+    int palette[4][4];
+    bc1_palette(c0, c1, c0 > c1 || !allow_transparent, palette);
+    for (uint32_t i = 0; i < 16; i++) {
+        const int* color = palette[(indices >> (i * 2)) & 3];
+        for (uint32_t c = 0; c < 4; c++) {
+            block[i][c] = (uint8_t)color[c];
+        }
+    }
+}
+
+static void decode_bc4(const uint8_t* in, texture_block block, uint32_t channel) {
+    int palette[8];
+    bc4_palette(in[0], in[1], palette);
+    uint64_t indices = 0;
+    for (uint32_t b = 0; b < 6; b++) {
+        indices |= (uint64_t)in[2 + b] << (b * 8);
+    }
+    for (uint32_t i = 0; i < 16; i++) {
+        block[i][channel] = (uint8_t)palette[(indices >> (i * 3)) & 7];
+    }
+}
+
+static int etc_expand4(uint64_t value) {
+    return (int)((value & 15) << 4 | (value & 15));
+}
+
+static int etc_expand5(uint64_t value) {
+    return (int)((value & 31) << 3 | (value & 31) >> 2);
+}
+
+static int etc_signed3(uint64_t value) {
+    int v = (int)(value & 7);
+    return v >= 4 ? v - 8 : v;
+}
+
+/* Planar mode: a color at the origin and at the right and bottom edges, interpolated */
+static void decode_etc2_planar(uint64_t bits, texture_block block) {
+    int origin[3] = {
+        (int)(bits >> 57 & 63),
+        (int)((bits >> 56 & 1) << 6 | (bits >> 49 & 63)),
+        (int)((bits >> 48 & 1) << 5 | (bits >> 43 & 3) << 3 | (bits >> 39 & 7)),
+    };
+    int horizontal[3] = {
+        (int)((bits >> 34 & 31) << 1 | (bits >> 32 & 1)),
+        (int)(bits >> 25 & 127),
+        (int)(bits >> 19 & 63),
+    };
+    int vertical[3] = {(int)(bits >> 13 & 63), (int)(bits >> 6 & 127), (int)(bits & 63)};
+
+    /* Red and blue have 6 bits, green 7 */
+    for (uint32_t c = 0; c < 3; c++) {
+        int shift = c == 1 ? 6 : 5;
+        int up = c == 1 ? 1 : 2;
+        origin[c] = origin[c] << up | origin[c] >> shift;
+        horizontal[c] = horizontal[c] << up | horizontal[c] >> shift;
+        vertical[c] = vertical[c] << up | vertical[c] >> shift;
+    }
+    for (uint32_t i = 0; i < 16; i++) {
+        int x = (int)(i % 4);
+        int y = (int)(i / 4);
+        for (uint32_t c = 0; c < 3; c++) {
+            int value = x * (horizontal[c] - origin[c]) + y * (vertical[c] - origin[c]) + 4 * origin[c] + 2;
+            block[i][c] = (uint8_t)clamp_byte(value < 0 ? 0 : value >> 2);
+        }
+        block[i][3] = 255;
+    }
+}
+
+static void decode_etc2_color(const uint8_t* in, texture_block block) {
+    uint64_t bits = read_be64(in);
+    bool differential = bits >> 33 & 1;
+    bool flip = bits >> 32 & 1;
+
+    int base[2][3];
+    int paint[4][3];
+    bool paint_mode = false;
+    if (!differential) {
+        for (uint32_t c = 0; c < 3; c++) {
+            base[0][c] = etc_expand4(bits >> (60 - c * 8));
+            base[1][c] = etc_expand4(bits >> (56 - c * 8));
+        }
+    } else {
+        int red = (int)(bits >> 59 & 31) + etc_signed3(bits >> 56);
+        int green = (int)(bits >> 51 & 31) + etc_signed3(bits >> 48);
+        int blue = (int)(bits >> 43 & 31) + etc_signed3(bits >> 40);
+
+        if (red < 0 || red > 31) {
+            /* T mode: one color, and a second one with a distance either side */
+            int first[3] = {
+                etc_expand4((bits >> 59 & 3) << 2 | (bits >> 56 & 3)),
+                etc_expand4(bits >> 52),
+                etc_expand4(bits >> 48),
+            };
+            int second[3] = {etc_expand4(bits >> 44), etc_expand4(bits >> 40), etc_expand4(bits >> 36)};
+            int distance = g_etc_distances[(bits >> 34 & 3) << 1 | (bits >> 32 & 1)];
+            for (uint32_t c = 0; c < 3; c++) {
+                paint[0][c] = first[c];
+                paint[1][c] = clamp_byte(second[c] + distance);
+                paint[2][c] = second[c];
+                paint[3][c] = clamp_byte(second[c] - distance);
+            }
+            paint_mode = true;
+        } else if (green < 0 || green > 31) {
+            /* H mode: two colors, each with a distance either side */
+            uint32_t first4[3] = {
+                (uint32_t)(bits >> 59 & 15),
+                (uint32_t)((bits >> 56 & 7) << 1 | (bits >> 52 & 1)),
+                (uint32_t)((bits >> 51 & 1) << 3 | (bits >> 47 & 7)),
+            };
+            uint32_t second4[3] = {
+                (uint32_t)(bits >> 43 & 15),
+                (uint32_t)(bits >> 39 & 15),
+                (uint32_t)(bits >> 35 & 15),
+            };
+            uint32_t first_value = first4[0] << 8 | first4[1] << 4 | first4[2];
+            uint32_t second_value = second4[0] << 8 | second4[1] << 4 | second4[2];
+            int distance = g_etc_distances[(bits >> 34 & 1) << 2 | (bits >> 32 & 1) << 1 |
+                                           (first_value >= second_value)];
+            for (uint32_t c = 0; c < 3; c++) {
+                paint[0][c] = clamp_byte(etc_expand4(first4[c]) + distance);
+                paint[1][c] = clamp_byte(etc_expand4(first4[c]) - distance);
+                paint[2][c] = clamp_byte(etc_expand4(second4[c]) + distance);
+                paint[3][c] = clamp_byte(etc_expand4(second4[c]) - distance);
+            }
+            paint_mode = true;
+        } else if (blue < 0 || blue > 31) {
+            decode_etc2_planar(bits, block);
+            return;
+        } else {
+            int second[3] = {red, green, blue};
+            for (uint32_t c = 0; c < 3; c++) {
+                base[0][c] = etc_expand5(bits >> (59 - c * 8));
+                base[1][c] = etc_expand5((uint64_t)second[c]);
+            }
+        }
+    }
+
+    uint32_t tables[2] = {(uint32_t)(bits >> 37 & 7), (uint32_t)(bits >> 34 & 7)};
+    for (uint32_t i = 0; i < 16; i++) {
+        uint32_t bit = etc_texel_bit(i);
+        uint32_t selector = (uint32_t)((bits >> (16 + bit) & 1) << 1 | (bits >> bit & 1));
+        for (uint32_t c = 0; c < 3; c++) {
+            if (paint_mode) {
+                block[i][c] = (uint8_t)paint[selector][c];
+            } else {
+                uint32_t half = flip ? i / 4 >= 2 : i % 4 >= 2;
+                int modifier = g_etc_modifiers[tables[half]][selector & 1] * (selector & 2 ? -1 : 1);
+                block[i][c] = (uint8_t)clamp_byte(base[half][c] + modifier);
+            }
+        }
+        block[i][3] = 255;
+    }
+}
+
+static void decode_eac(const uint8_t* in, texture_block block) {
+    uint64_t bits = read_be64(in);
+    int base = (int)(bits >> 56);
+    int multiplier = (int)(bits >> 52 & 15);
+    uint32_t table = (uint32_t)(bits >> 48 & 15);
+    for (uint32_t i = 0; i < 16; i++) {
+        uint32_t index = (uint32_t)(bits >> (45 - etc_texel_bit(i) * 3) & 7);
+        block[i][3] = (uint8_t)clamp_byte(base + g_eac_modifiers[table][index] * multiplier);
+    }
+}
+
+/* Levels */
+
+/* Read a block, repeating the edge texels of partial blocks */
+static void gather_block(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t block_x, uint32_t block_y,
+                         texture_block block) {
+    for (uint32_t y = 0; y < 4; y++) {
+        uint32_t source_y = block_y * 4 + y < height ? block_y * 4 + y : height - 1;
+        for (uint32_t x = 0; x < 4; x++) {
+            uint32_t source_x = block_x * 4 + x < width ? block_x * 4 + x : width - 1;
+            memcpy(block[y * 4 + x], rgba + ((size_t)source_y * width + source_x) * 4, 4);
+        }
+    }
+}
+
+static void encode_level(ve_texture_format format, const uint8_t* rgba, uint32_t width, uint32_t height,
+                         uint8_t* out) {
+    const texture_format_info* info = &g_format_info[format];
+    if (info->family == VE_TEXTURE_FAMILY_RGBA8) {
+        memcpy(out, rgba, (size_t)width * height * 4);
+        return;
+    }
+
+    bool alpha = info->block_bytes == 16;
+    for (uint32_t block_y = 0; block_y < (height + 3) / 4; block_y++) {
+        for (uint32_t block_x = 0; block_x < (width + 3) / 4; block_x++) {
+            texture_block block;
+            gather_block(rgba, width, height, block_x, block_y, block);
+
+            /* Alpha, if any, comes first */
+            uint8_t* color = out;
+            if (alpha) {
+                uint8_t values[16];
+                for (uint32_t i = 0; i < 16; i++) {
+                    values[i] = block[i][3];
+                }
+                if (info->family == VE_TEXTURE_FAMILY_BC) {
+                    encode_bc4(values, out);
+                } else {
+                    encode_eac(values, out);
+                }
+                color += 8;
+            }
+            /* C17 does not convert to a pointer to const arrays implicitly */
+            const uint8_t (*texels)[4] = (const uint8_t (*)[4])block;
+            if (info->family == VE_TEXTURE_FAMILY_BC) {
+                encode_bc1_color(texels, color);
+            } else {
+                encode_etc2_color(texels, color);
+            }
+            out += info->block_bytes;
+        }
+    }
+}
+
+bool ve_texture_decompress(ve_texture_format format, const void* data, uint32_t width, uint32_t height,
+                           uint8_t* rgba) {
+    VE_ASSERT(format < VE_TEXTURE_FORMAT_COUNT && data && rgba);
+
+    const texture_format_info* info = &g_format_info[format];
+    if (info->family == VE_TEXTURE_FAMILY_RGBA8) {
+        memcpy(rgba, data, (size_t)width * height * 4);
+        return true;
+    }
+    if (info->family == VE_TEXTURE_FAMILY_ASTC) {
+        VE_LOG_ERROR("ASTC textures cannot be decoded on the CPU");
+        return false;
+    }
+
+    const uint8_t* in = (const uint8_t*)data;
+    bool alpha = info->block_bytes == 16;
+    for (uint32_t block_y = 0; block_y < (height + 3) / 4; block_y++) {
+        for (uint32_t block_x = 0; block_x < (width + 3) / 4; block_x++) {
+            texture_block block;
+            const uint8_t* color = alpha ? in + 8 : in;
+            if (info->family == VE_TEXTURE_FAMILY_BC) {
+                decode_bc1_color(color, !alpha, block);
+                if (alpha) {
+                    decode_bc4(in, block, 3);
+                }
+            } else {
+                decode_etc2_color(color, block);
+                if (alpha) {
+                    decode_eac(in, block);
+                }
+            }
+            in += info->block_bytes;
+
+            for (uint32_t y = 0; y < 4 && block_y * 4 + y < height; y++) {
+                for (uint32_t x = 0; x < 4 && block_x * 4 + x < width; x++) {
+                    memcpy(rgba + ((size_t)(block_y * 4 + y) * width + block_x * 4 + x) * 4, block[y * 4 + x], 4);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static uint64_t align_blob(uint64_t offset) {
+    return (offset + TEXTURE_BLOB_ALIGNMENT - 1) & ~(uint64_t)(TEXTURE_BLOB_ALIGNMENT - 1);
+}
+
+/**
+ * @brief Build RGBA8 mips below level 0
+ *
+ * Filters in linear space from the previous level kept in float, so
+ * rounding does not accumulate.
+ */
+static bool build_mips(uint8_t** levels, const uint32_t* widths, const uint32_t* heights, uint32_t mip_count,
+                       bool srgb) {
+    float* buffers[2] = {
+        (float*)VE_ALLOCATE_TAG((size_t)widths[0] * heights[0] * 4 * sizeof(float), VE_MEMORY_TAG_TEXTURE),
+        (float*)VE_ALLOCATE_TAG((size_t)(widths[0] / 2 + 1) * (heights[0] / 2 + 1) * 4 * sizeof(float),
+                                VE_MEMORY_TAG_TEXTURE),
+    };
+    if (!buffers[0] || !buffers[1]) {
+        VE_FREE(buffers[0]);
+        VE_FREE(buffers[1]);
+        return false;
+    }
+
+    float to_linear[256];
+    for (uint32_t v = 0; v < 256; v++) {
+        to_linear[v] = srgb ? srgb_to_linear(v / 255.0f) : v / 255.0f;
+    }
+    for (size_t i = 0; i < (size_t)widths[0] * heights[0] * 4; i++) {
+        buffers[0][i] = i % 4 == 3 ? levels[0][i] / 255.0f : to_linear[levels[0][i]];
+    }
+
+    for (uint32_t level = 1; level < mip_count; level++) {
+        uint32_t source_width = widths[level - 1];
+        uint32_t source_height = heights[level - 1];
+        const float* source = buffers[(level - 1) & 1];
+        float* target = buffers[level & 1];
+        uint8_t* out = levels[level];
+
+        for (uint32_t y = 0; y < heights[level]; y++) {
+            uint32_t y0 = y * 2 < source_height ? y * 2 : source_height - 1;
+            uint32_t y1 = y * 2 + 1 < source_height ? y * 2 + 1 : y0;
+            for (uint32_t x = 0; x < widths[level]; x++) {
+                uint32_t x0 = x * 2 < source_width ? x * 2 : source_width - 1;
+                uint32_t x1 = x * 2 + 1 < source_width ? x * 2 + 1 : x0;
+                for (uint32_t c = 0; c < 4; c++) {
+                    float sum = source[((size_t)y0 * source_width + x0) * 4 + c] +
+                                source[((size_t)y0 * source_width + x1) * 4 + c] +
+                                source[((size_t)y1 * source_width + x0) * 4 + c] +
+                                source[((size_t)y1 * source_width + x1) * 4 + c];
+                    float value = sum * 0.25f;
+                    size_t index = ((size_t)y * widths[level] + x) * 4 + c;
+                    target[index] = value;
+                    out[index] = quantize(srgb && c != 3 ? linear_to_srgb(value) : value);
+                }
+            }
+        }
+    }
+
+    VE_FREE(buffers[0]);
+    VE_FREE(buffers[1]);
+    return true;
+}
+
+bool ve_texture_cook(const uint8_t* pixels, uint32_t width, uint32_t height, const ve_texture_cook_config* config,
+                     void** blob, size_t* size) {
+    VE_ASSERT(pixels && blob && size);
+
+    *blob = NULL;
+    *size = 0;
+    bool srgb = config ? config->srgb : true;
+    uint32_t families = config && config->families ? config->families : VE_TEXTURE_FAMILY_BC | VE_TEXTURE_FAMILY_ETC2;
+    if (families & VE_TEXTURE_FAMILY_ASTC) {
+        VE_LOG_WARN("ASTC encoding is not available, skipping the ASTC variant");
+        families &= ~(uint32_t)VE_TEXTURE_FAMILY_ASTC;
+    }
+    if (families == 0 || width == 0 || height == 0 || width > (1u << (VE_TEXTURE_MAX_MIPS - 1)) ||
+        height > (1u << (VE_TEXTURE_MAX_MIPS - 1))) {
+        VE_LOG_ERROR("Cannot cook a %ux%u texture", width, height);
+        return false;
+    }
+
+    bool opaque = true;
+    for (size_t i = 0; i < (size_t)width * height && opaque; i++) {
+        opaque = pixels[i * 4 + 3] == 255;
+    }
+
+    /* Variants in a fixed order, each in the smallest format that keeps alpha if there is any */
+    ve_texture_format formats[VE_TEXTURE_MAX_VARIANTS];
+    uint32_t variant_count = 0;
+    if (families & VE_TEXTURE_FAMILY_RGBA8) {
+        formats[variant_count++] = srgb ? VE_TEXTURE_FORMAT_RGBA8_SRGB : VE_TEXTURE_FORMAT_RGBA8_UNORM;
+    }
+    if (families & VE_TEXTURE_FAMILY_BC) {
+        formats[variant_count++] = opaque ? (srgb ? VE_TEXTURE_FORMAT_BC1_SRGB : VE_TEXTURE_FORMAT_BC1_UNORM)
+                                          : (srgb ? VE_TEXTURE_FORMAT_BC3_SRGB : VE_TEXTURE_FORMAT_BC3_UNORM);
+    }
+    if (families & VE_TEXTURE_FAMILY_ETC2) {
+        formats[variant_count++] =
+            opaque ? (srgb ? VE_TEXTURE_FORMAT_ETC2_RGB8_SRGB : VE_TEXTURE_FORMAT_ETC2_RGB8_UNORM)
+                   : (srgb ? VE_TEXTURE_FORMAT_ETC2_RGBA8_SRGB : VE_TEXTURE_FORMAT_ETC2_RGBA8_UNORM);
+    }
+
+    ve_texture_blob_header header = {
+        .magic = VE_TEXTURE_BLOB_MAGIC,
+        .width = width,
+        .height = height,
+        .variant_count = variant_count,
+    };
+
+    uint32_t widths[VE_TEXTURE_MAX_MIPS];
+    uint32_t heights[VE_TEXTURE_MAX_MIPS];
+    uint32_t mip_count = 0;
+    for (uint32_t w = width, h = height;; w = w > 1 ? w / 2 : 1, h = h > 1 ? h / 2 : 1) {
+        widths[mip_count] = w;
+        heights[mip_count] = h;
+        mip_count++;
+        if (w == 1 && h == 1) {
+            break;
+        }
+    }
+
+    /* Coarsest mip first within each variant */
+    uint64_t offset = align_blob(sizeof(ve_texture_blob_header));
+    for (uint32_t v = 0; v < variant_count; v++) {
+        ve_texture_variant* variant = &header.variants[v];
+        variant->format = formats[v];
+        variant->mip_count = mip_count;
+        for (uint32_t level = mip_count; level-- > 0;) {
+            uint64_t level_size = ve_texture_get_level_size(formats[v], widths[level], heights[level]);
+            variant->mips[level] = (ve_texture_mip){(uint32_t)offset, (uint32_t)level_size, widths[level],
+                                                    heights[level]};
+            offset = align_blob(offset + level_size);
+            if (offset > UINT32_MAX) {
+                VE_LOG_ERROR("%ux%u texture is too large to cook", width, height);
+                return false;
+            }
+        }
+    }
+
+    uint8_t* data = (uint8_t*)ve_allocate_cleared(1, (size_t)offset, VE_MEMORY_TAG_TEXTURE);
+    uint8_t* levels[VE_TEXTURE_MAX_MIPS] = {(uint8_t*)pixels};
+    bool success = data != NULL;
+    for (uint32_t level = 1; level < mip_count && success; level++) {
+        levels[level] = (uint8_t*)VE_ALLOCATE_TAG((size_t)widths[level] * heights[level] * 4, VE_MEMORY_TAG_TEXTURE);
+        success = levels[level] != NULL;
+    }
+    success = success && build_mips(levels, widths, heights, mip_count, srgb);
+
+    if (success) {
+        memcpy(data, &header, sizeof(header));
+        for (uint32_t v = 0; v < variant_count; v++) {
+            for (uint32_t level = 0; level < mip_count; level++) {
+                encode_level(formats[v], levels[level], widths[level], heights[level],
+                             data + header.variants[v].mips[level].offset);
+            }
+        }
+    } else {
+        VE_LOG_ERROR("Out of memory cooking a %ux%u texture", width, height);
+        VE_FREE(data);
+    }
+
+    for (uint32_t level = 1; level < mip_count; level++) {
+        VE_FREE(levels[level]);
+    }
+    if (!success) {
+        return false;
+    }
+    *blob = data;
+    *size = (size_t)offset;
+    return true;
+}
+
+bool ve_texture_view(const void* blob, size_t size, ve_texture_data* out) {
+    VE_ASSERT(blob && out);
+
+    memset(out, 0, sizeof(ve_texture_data));
+    const ve_texture_blob_header* header = (const ve_texture_blob_header*)blob;
+    bool valid = size >= sizeof(ve_texture_blob_header) && header->magic == VE_TEXTURE_BLOB_MAGIC &&
+                 header->width > 0 && header->height > 0 && header->variant_count >= 1 &&
+                 header->variant_count <= VE_TEXTURE_MAX_VARIANTS;
+
+    for (uint32_t v = 0; valid && v < header->variant_count; v++) {
+        const ve_texture_variant* variant = &header->variants[v];
+        valid = variant->format < VE_TEXTURE_FORMAT_COUNT && variant->mip_count >= 1 &&
+                variant->mip_count <= VE_TEXTURE_MAX_MIPS;
+        for (uint32_t i = 0; valid && i < variant->mip_count; i++) {
+            const ve_texture_mip* mip = &variant->mips[i];
+            uint32_t mip_width = header->width >> i ? header->width >> i : 1;
+            uint32_t mip_height = header->height >> i ? header->height >> i : 1;
+            valid = mip->width == mip_width && mip->height == mip_height &&
+                    mip->offset % TEXTURE_BLOB_ALIGNMENT == 0 && mip->offset <= size &&
+                    mip->size <= size - mip->offset &&
+                    mip->size == ve_texture_get_level_size((ve_texture_format)variant->format, mip_width, mip_height);
+        }
+    }
+    if (!valid) {
+        VE_LOG_ERROR("Malformed texture blob");
+        return false;
+    }
+
+    out->width = header->width;
+    out->height = header->height;
+    out->variant_count = header->variant_count;
+    out->variants = header->variants;
+    out->blob = (const uint8_t*)blob;
+    return true;
+}
+
+bool ve_texture_load_pak(const ve_pak* pak, const char* name, ve_texture* texture) {
+    VE_ASSERT(pak && name && texture);
+
+    memset(texture, 0, sizeof(ve_texture));
+    const ve_pak_entry* entry = ve_pak_find(pak, name);
+    if (!entry || entry->type != VE_PAK_TYPE_TEXTURE) {
+        VE_LOG_ERROR("Pak has no texture named %s", name);
+        return false;
+    }
+
+    const void* blob = ve_pak_load(pak, entry, &texture->owned);
+    if (!blob || !ve_texture_view(blob, (size_t)entry->size, &texture->data)) {
+        ve_texture_release(texture);
+        return false;
+    }
+    return true;
+}
+
+void ve_texture_release(ve_texture* texture) {
+    if (!texture) {
+        return;
+    }
+    VE_FREE(texture->owned);
+    memset(texture, 0, sizeof(ve_texture));
+}
@@ -1,18 +1,244 @@
 /**
  * @file texture_loader.h
  * @brief Texture loading
+ *
+ * At runtime textures come from paks (see pak.h). The cooker decodes
+ * source images once, builds the full mip chain and encodes it in one or
+ * more block-compressed formats, so a texture costs a quarter to an
+ * eighth of its RGBA8 size in memory and bandwidth. Each encoding is a
+ * variant of the blob; the loader picks the best one the device samples
+ * (ve_texture_select_variant) and never touches the others, which stay
+ * unread in the mapped archive.
+ *
+ * Within a variant, mips are stored coarsest first, so streaming in finer
+ * levels (see renderer/texture_streaming.h) reads the archive front to
+ * back.
  */
 
 #ifndef VE_TEXTURE_LOADER_H
 #define VE_TEXTURE_LOADER_H
 
+#include "pak.h"
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* TODO: Implement texture loading */
+#define VE_TEXTURE_BLOB_MAGIC 0x54584554u   /* "TEXT" */
+
+/* Enough mips for a 32768 texel texture */
+#define VE_TEXTURE_MAX_MIPS 16
+
+/* Most encodings of one texture */
+#define VE_TEXTURE_MAX_VARIANTS 4
+
+/* Texels across a compressed block */
+#define VE_TEXTURE_BLOCK_SIZE 4
+
+/**
+ * @brief Texel format of a cooked texture
+ */
+typedef enum ve_texture_format {
+    VE_TEXTURE_FORMAT_RGBA8_UNORM = 0,
+    VE_TEXTURE_FORMAT_RGBA8_SRGB = 1,
+    VE_TEXTURE_FORMAT_BC1_UNORM = 2,        /* Opaque RGB, 8 bytes per block */
+    VE_TEXTURE_FORMAT_BC1_SRGB = 3,
+    VE_TEXTURE_FORMAT_BC3_UNORM = 4,        /* RGBA, 16 bytes per block */
+    VE_TEXTURE_FORMAT_BC3_SRGB = 5,
+    VE_TEXTURE_FORMAT_ETC2_RGB8_UNORM = 6,  /* Opaque RGB, 8 bytes per block */
+    VE_TEXTURE_FORMAT_ETC2_RGB8_SRGB = 7,
+    VE_TEXTURE_FORMAT_ETC2_RGBA8_UNORM = 8, /* RGB with EAC alpha, 16 bytes per block */
+    VE_TEXTURE_FORMAT_ETC2_RGBA8_SRGB = 9,
+    VE_TEXTURE_FORMAT_ASTC_4x4_UNORM = 10,  /* Accepted in blobs, not produced by the cooker */
+    VE_TEXTURE_FORMAT_ASTC_4x4_SRGB = 11,
+    VE_TEXTURE_FORMAT_COUNT
+} ve_texture_format;
+
+/**
+ * @brief Format families, matching the device's texture compression features
+ */
+typedef enum ve_texture_family {
+    VE_TEXTURE_FAMILY_RGBA8 = 1 << 0,       /* Always supported */
+    VE_TEXTURE_FAMILY_BC = 1 << 1,
+    VE_TEXTURE_FAMILY_ETC2 = 1 << 2,
+    VE_TEXTURE_FAMILY_ASTC = 1 << 3
+} ve_texture_family;
+
+/**
+ * @brief One mip level of a cooked texture
+ */
+typedef struct ve_texture_mip {
+    uint32_t offset;                /* Bytes from the start of the blob, 16 byte aligned */
+    uint32_t size;
+    uint32_t width;
+    uint32_t height;
+} ve_texture_mip;
+
+/**
+ * @brief One encoding of a cooked texture
+ */
+typedef struct ve_texture_variant {
+    uint32_t format;                /* ve_texture_format */
+    uint32_t mip_count;
+    uint32_t reserved[2];
+    ve_texture_mip mips[VE_TEXTURE_MAX_MIPS];   /* Largest first */
+} ve_texture_variant;
+
+/**
+ * @brief Start of a cooked texture blob
+ */
+typedef struct ve_texture_blob_header {
+    uint32_t magic;
+    uint32_t width;
+    uint32_t height;
+    uint32_t variant_count;
+    ve_texture_variant variants[VE_TEXTURE_MAX_VARIANTS];
+} ve_texture_blob_header;
+
+/**
+ * @brief Read-only view of a cooked texture
+ */
+typedef struct ve_texture_data {
+    uint32_t width;
+    uint32_t height;
+    uint32_t variant_count;
+    const ve_texture_variant* variants;
+    const uint8_t* blob;            /* Mip offsets are relative to this */
+} ve_texture_data;
+
+/**
+ * @brief Texture loaded from a pak
+ */
+typedef struct ve_texture {
+    ve_texture_data data;
+    void* owned;                    /* Expanded blob if it was compressed */
+} ve_texture;
+
+/**
+ * @brief Cooking options
+ */
+typedef struct ve_texture_cook_config {
+    bool srgb;                      /* Color channels are sRGB encoded */
+    uint32_t families;              /* ve_texture_family flags, one variant each; 0 for BC and ETC2 */
+} ve_texture_cook_config;
+
+/**
+ * @brief Get the family of a format
+ *
+ * @param format Format
+ * @return Family flag
+ */
+ve_texture_family ve_texture_format_get_family(ve_texture_format format);
+
+/**
+ * @brief Check if a format decodes from sRGB
+ *
+ * @param format Format
+ * @return true for sRGB formats
+ */
+bool ve_texture_format_is_srgb(ve_texture_format format);
+
+/**
+ * @brief Get the size of one mip level
+ *
+ * @param format Format
+ * @param width Level width
+ * @param height Level height
+ * @return Bytes, whole blocks for compressed formats
+ */
+uint64_t ve_texture_get_level_size(ve_texture_format format, uint32_t width, uint32_t height);
+
+/**
+ * @brief Pick the variant to sample on a device
+ *
+ * Prefers ASTC, then BC, then ETC2, then RGBA8.
+ *
+ * @param data Texture
+ * @param families Supported ve_texture_family flags
+ * @return Variant index, or -1 if no variant is supported
+ */
+int32_t ve_texture_select_variant(const ve_texture_data* data, uint32_t families);
+
+/**
+ * @brief Decode a TGA image
+ *
+ * Supports uncompressed and run-length encoded 24 and 32 bit true color
+ * images. 24 bit images get an opaque alpha.
+ *
+ * @param data File contents
+ * @param size Content size
+ * @param pixels Receives RGBA8 pixels, top row first, freed with VE_FREE
+ * @param width Receives the width
+ * @param height Receives the height
+ * @return false if the image is malformed or unsupported
+ */
+bool ve_texture_decode_tga(const void* data, size_t size, uint8_t** pixels, uint32_t* width, uint32_t* height);
+
+/**
+ * @brief Cook RGBA8 pixels into a blob with a full mip chain per variant
+ *
+ * Mips are box filtered, in linear space for sRGB textures. Opaque images
+ * get BC1 and ETC2 RGB8, others BC3 and ETC2 RGBA8.
+ *
+ * @param pixels RGBA8 pixels, top row first
+ * @param width Width
+ * @param height Height
+ * @param config Options, NULL for sRGB with BC and ETC2 variants
+ * @param blob Receives the blob, freed with VE_FREE
+ * @param size Receives the blob size
+ * @return true on success
+ */
+bool ve_texture_cook(const uint8_t* pixels, uint32_t width, uint32_t height, const ve_texture_cook_config* config,
+                     void** blob, size_t* size);
+
+/**
+ * @brief Decompress one mip level to RGBA8
+ *
+ * The fallback for devices that sample none of a texture's variants.
+ * ASTC is not decoded.
+ *
+ * @param format Format of the level
+ * @param data Level data
+ * @param width Level width
+ * @param height Level height
+ * @param rgba Receives width * height RGBA8 texels
+ * @return false if the format cannot be decoded
+ */
+bool ve_texture_decompress(ve_texture_format format, const void* data, uint32_t width, uint32_t height,
+                           uint8_t* rgba);
+
+/**
+ * @brief View a cooked texture blob in place
+ *
+ * @param blob Blob
+ * @param size Blob size
+ * @param out Receives pointers into the blob
+ * @return false if the blob is malformed
+ */
+bool ve_texture_view(const void* blob, size_t size, ve_texture_data* out);
+
+/**
+ * @brief Load a cooked texture from a pak
+ *
+ * The texture points into the archive, which must stay open until the
+ * texture is released.
+ *
+ * @param pak Archive
+ * @param name Entry name
+ * @param texture Receives the texture
+ * @return false if the entry is missing, not a texture or malformed
+ */
+bool ve_texture_load_pak(const ve_pak* pak, const char* name, ve_texture* texture);
+
+/**
+ * @brief Release a texture loaded from a pak
+ *
+ * @param texture Texture, cleared on return
+ */
+void ve_texture_release(ve_texture* texture);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,293 @@
+/**
+ * @file benchmark.c
+ * @brief Frame time recording for benchmark runs implementation
+ */
+
+#include "benchmark.h"
+#include "memory.h"
+#include "logger.h"
+#include "json.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCHMARK_MAX_NAME 128
+
+/* Growable array of frame times */
+typedef struct benchmark_series {
+    double* samples;
+    uint32_t count;
+    uint32_t capacity;
+} benchmark_series;
+
+typedef struct benchmark_pass {
+    const char* name;
+    double current;                 /* Time in the frame being recorded */
+    benchmark_series series;
+} benchmark_pass;
+
+/* Global benchmark state. CPU frames are written by one thread, GPU frames and passes by another. */
+static struct {
+    bool active;
+    char name[BENCHMARK_MAX_NAME];
+    uint32_t warmup_frames;
+
+    /* CPU recording thread */
+    uint32_t cpu_seen;
+    benchmark_series cpu;
+
+    /* GPU recording thread */
+    uint32_t gpu_seen;
+    benchmark_series gpu;
+    benchmark_pass passes[VE_BENCHMARK_MAX_PASSES];
+    uint32_t pass_count;
+} g_benchmark = {0};
+
+static void series_append(benchmark_series* series, double value) {
+    if (series->count == series->capacity) {
+        uint32_t capacity = series->capacity ? series->capacity * 2 : 1024;
+        double* samples = (double*)ve_reallocate(series->samples, capacity * sizeof(double), VE_MEMORY_TAG_CORE);
+        if (!samples) {
+            return;
+        }
+        series->samples = samples;
+        series->capacity = capacity;
+    }
+    series->samples[series->count++] = value;
+}
+
+static void series_free(benchmark_series* series) {
+    VE_FREE(series->samples);
+    memset(series, 0, sizeof(benchmark_series));
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* Frame rate over the slowest fraction of sorted frame times, at least one frame */
+static double low_fps(const double* sorted, uint32_t count, double fraction) {
+    uint32_t slowest = (uint32_t)(count * fraction);
+    if (slowest == 0) {
+        slowest = 1;
+    }
+
+    double sum = 0.0;
+    for (uint32_t i = count - slowest; i < count; i++) {
+        sum += sorted[i];
+    }
+    return sum > 0.0 ? 1000.0 * slowest / sum : 0.0;
+}
+
+void ve_benchmark_sort(double* values, uint32_t count) {
+    qsort(values, count, sizeof(double), compare_doubles);
+}
+
+double ve_benchmark_percentile(const double* sorted, uint32_t count, double fraction) {
+    uint32_t rank = (uint32_t)(fraction * count + 0.999999);
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+bool ve_benchmark_begin(const char* name, uint32_t warmup_frames) {
+    ve_benchmark_end();
+
+    snprintf(g_benchmark.name, sizeof(g_benchmark.name), "%s", name ? name : "");
+    g_benchmark.warmup_frames = warmup_frames;
+    g_benchmark.active = true;
+    return true;
+}
+
+void ve_benchmark_end(void) {
+    series_free(&g_benchmark.cpu);
+    series_free(&g_benchmark.gpu);
+    for (uint32_t i = 0; i < g_benchmark.pass_count; i++) {
+        series_free(&g_benchmark.passes[i].series);
+    }
+    memset(&g_benchmark, 0, sizeof(g_benchmark));
+}
+
+bool ve_benchmark_is_active(void) {
+    return g_benchmark.active;
+}
+
+void ve_benchmark_record_cpu_frame(double ms) {
+    if (!g_benchmark.active || g_benchmark.cpu_seen++ < g_benchmark.warmup_frames) {
+        return;
+    }
+    series_append(&g_benchmark.cpu, ms);
+}
+
+void ve_benchmark_record_gpu_pass(const char* name, double ms) {
+    if (!g_benchmark.active || g_benchmark.gpu_seen < g_benchmark.warmup_frames || !name) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < g_benchmark.pass_count; i++) {
+        benchmark_pass* pass = &g_benchmark.passes[i];
+        if (pass->name == name || strcmp(pass->name, name) == 0) {
+            pass->current += ms;
+            return;
+        }
+    }
+
+    if (g_benchmark.pass_count == VE_BENCHMARK_MAX_PASSES) {
+        return;
+    }
+    benchmark_pass* pass = &g_benchmark.passes[g_benchmark.pass_count++];
+    pass->name = name;
+    pass->current = ms;
+}
+
+void ve_benchmark_record_gpu_frame(double ms) {
+    if (!g_benchmark.active || g_benchmark.gpu_seen++ < g_benchmark.warmup_frames) {
+        return;
+    }
+
+    series_append(&g_benchmark.gpu, ms);
+    for (uint32_t i = 0; i < g_benchmark.pass_count; i++) {
+        benchmark_pass* pass = &g_benchmark.passes[i];
+        series_append(&pass->series, pass->current);
+        pass->current = 0.0;
+    }
+}
+
+bool ve_benchmark_summarize(const double* samples, uint32_t count, ve_benchmark_summary* summary) {
+    if (!summary) {
+        return false;
+    }
+    memset(summary, 0, sizeof(ve_benchmark_summary));
+    if (!samples || count == 0) {
+        return false;
+    }
+
+    double* sorted = (double*)VE_ALLOCATE_TAG(count * sizeof(double), VE_MEMORY_TAG_CORE);
+    if (!sorted) {
+        return false;
+    }
+    memcpy(sorted, samples, count * sizeof(double));
+    ve_benchmark_sort(sorted, count);
+
+    double sum = 0.0;
+    for (uint32_t i = 0; i < count; i++) {
+        sum += sorted[i];
+    }
+
+    summary->count = count;
+    summary->min_ms = sorted[0];
+    summary->mean_ms = sum / count;
+    summary->p50_ms = ve_benchmark_percentile(sorted, count, 0.50);
+    summary->p90_ms = ve_benchmark_percentile(sorted, count, 0.90);
+    summary->p95_ms = ve_benchmark_percentile(sorted, count, 0.95);
+    summary->p99_ms = ve_benchmark_percentile(sorted, count, 0.99);
+    summary->max_ms = sorted[count - 1];
+    summary->low_1_fps = low_fps(sorted, count, 0.01);
+    summary->low_01_fps = low_fps(sorted, count, 0.001);
+
+    VE_FREE(sorted);
+    return true;
+}
+
+bool ve_benchmark_get_cpu_summary(ve_benchmark_summary* summary) {
+    return ve_benchmark_summarize(g_benchmark.cpu.samples, g_benchmark.cpu.count, summary);
+}
+
+bool ve_benchmark_get_gpu_summary(ve_benchmark_summary* summary) {
+    return ve_benchmark_summarize(g_benchmark.gpu.samples, g_benchmark.gpu.count, summary);
+}
+
+uint32_t ve_benchmark_get_pass_count(void) {
+    return g_benchmark.pass_count;
+}
+
+bool ve_benchmark_get_pass_summary(uint32_t index, const char** name, ve_benchmark_summary* summary) {
+    if (index >= g_benchmark.pass_count) {
+        return false;
+    }
+
+    const benchmark_pass* pass = &g_benchmark.passes[index];
+    if (name) {
+        *name = pass->name;
+    }
+    ve_benchmark_summarize(pass->series.samples, pass->series.count, summary);
+    return true;
+}
+
+static void log_summary(const char* label, const ve_benchmark_summary* summary) {
+    VE_LOG_INFO("%-24s p50 %7.3f  p95 %7.3f  p99 %7.3f  max %7.3f ms, 1%% low %7.1f fps, 0.1%% low %7.1f fps",
+                label, summary->p50_ms, summary->p95_ms, summary->p99_ms, summary->max_ms, summary->low_1_fps,
+                summary->low_01_fps);
+}
+
+void ve_benchmark_log_report(void) {
+    ve_benchmark_summary summary;
+    VE_LOG_INFO("Benchmark %s: %u CPU frames, %u GPU frames", g_benchmark.name, g_benchmark.cpu.count,
+                g_benchmark.gpu.count);
+
+    if (ve_benchmark_get_cpu_summary(&summary)) {
+        VE_LOG_INFO("Average %.1f fps", summary.mean_ms > 0.0 ? 1000.0 / summary.mean_ms : 0.0);
+        log_summary("CPU frame", &summary);
+    }
+    if (ve_benchmark_get_gpu_summary(&summary)) {
+        log_summary("GPU frame", &summary);
+    }
+    for (uint32_t i = 0; i < g_benchmark.pass_count; i++) {
+        const char* name;
+        if (ve_benchmark_get_pass_summary(i, &name, &summary)) {
+            VE_LOG_INFO("  %-22s mean %7.3f  p95 %7.3f  p99 %7.3f ms", name, summary.mean_ms, summary.p95_ms,
+                        summary.p99_ms);
+        }
+    }
+}
+
+static void write_json_summary(FILE* file, const ve_benchmark_summary* summary) {
+    fprintf(file,
+            "{\"frames\":%u,\"min_ms\":%.4f,\"mean_ms\":%.4f,\"p50_ms\":%.4f,\"p90_ms\":%.4f,\"p95_ms\":%.4f,"
+            "\"p99_ms\":%.4f,\"max_ms\":%.4f,\"low_1_fps\":%.2f,\"low_01_fps\":%.2f}",
+            summary->count, summary->min_ms, summary->mean_ms, summary->p50_ms, summary->p90_ms, summary->p95_ms,
+            summary->p99_ms, summary->max_ms, summary->low_1_fps, summary->low_01_fps);
+}
+
+bool ve_benchmark_write_report(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        VE_LOG_ERROR("Failed to open benchmark report: %s", path);
+        return false;
+    }
+
+    ve_benchmark_summary summary;
+    fputs("{\n\"name\":", file);
+    ve_json_write_string(file, g_benchmark.name);
+    fprintf(file, ",\n\"warmup_frames\":%u,\n\"cpu\":", g_benchmark.warmup_frames);
+    ve_benchmark_get_cpu_summary(&summary);
+    write_json_summary(file, &summary);
+    fputs(",\n\"gpu\":", file);
+    ve_benchmark_get_gpu_summary(&summary);
+    write_json_summary(file, &summary);
+
+    fputs(",\n\"passes\":[", file);
+    for (uint32_t i = 0; i < g_benchmark.pass_count; i++) {
+        const char* name;
+        ve_benchmark_get_pass_summary(i, &name, &summary);
+        fputs(i > 0 ? ",\n{\"name\":" : "\n{\"name\":", file);
+        ve_json_write_string(file, name);
+        fputs(",\"gpu\":", file);
+        write_json_summary(file, &summary);
+        fputc('}', file);
+    }
+    fputs("\n]\n}\n", file);
+
+    bool success = ferror(file) == 0;
+    if (fclose(file) != 0) {
+        success = false;
+    }
+    if (!success) {
+        VE_LOG_ERROR("Failed to write benchmark report: %s", path);
+        return false;
+    }
+
+    VE_LOG_INFO("Wrote benchmark report to %s", path);
+    return true;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file benchmark.h
+ * @brief Frame time recording for benchmark runs
+ *
+ * A run records the CPU time of every frame, and the GPU time of every
+ * frame with the time of each GPU pass in it, then summarizes each series
+ * with percentiles and lows: the frame rate over the slowest 1% and 0.1%
+ * of frames, which show stutter that averages and medians hide. The first
+ * frames of a run are a warm-up and are not recorded.
+ *
+ * CPU frames are recorded from one thread and GPU frames and passes from
+ * another (or the same); summaries are read once both have stopped.
+ */
+
+#ifndef VE_BENCHMARK_H
+#define VE_BENCHMARK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Distinct GPU passes recorded */
+#define VE_BENCHMARK_MAX_PASSES 64
+
+/**
+ * @brief Distribution of one series of frame times
+ */
+typedef struct ve_benchmark_summary {
+    uint32_t count;                 /* Frames recorded */
+    double min_ms;
+    double mean_ms;
+    double p50_ms;
+    double p90_ms;
+    double p95_ms;
+    double p99_ms;
+    double max_ms;
+    double low_1_fps;               /* Frame rate over the slowest 1% of frames */
+    double low_01_fps;              /* Frame rate over the slowest 0.1% of frames */
+} ve_benchmark_summary;
+
+/**
+ * @brief Start a run, discarding the previous one
+ *
+ * @param name Name of the run in the report, e.g. the scene; copied
+ * @param warmup_frames Frames of each series skipped before recording
+ * @return true on success
+ */
+bool ve_benchmark_begin(const char* name, uint32_t warmup_frames);
+
+/**
+ * @brief Free the recorded frames
+ */
+void ve_benchmark_end(void);
+
+/**
+ * @brief Check if a run is being recorded
+ *
+ * @return true between ve_benchmark_begin and ve_benchmark_end
+ */
+bool ve_benchmark_is_active(void);
+
+/**
+ * @brief Record the CPU time of a frame
+ *
+ * @param ms Frame time in milliseconds
+ */
+void ve_benchmark_record_cpu_frame(double ms);
+
+/**
+ * @brief Record the GPU time of one pass of the frame being recorded
+ *
+ * Passes with the same name in one frame add up. Record the passes of a
+ * frame before the frame itself.
+ *
+ * @param name Pass name; must outlive the run (normally a string literal)
+ * @param ms Pass time in milliseconds
+ */
+void ve_benchmark_record_gpu_pass(const char* name, double ms);
+
+/**
+ * @brief Record the GPU time of a frame, closing its passes
+ *
+ * Passes that did not run in the frame count as zero for it.
+ *
+ * @param ms Frame time in milliseconds
+ */
+void ve_benchmark_record_gpu_frame(double ms);
+
+/**
+ * @brief Sort samples in ascending order, for ve_benchmark_percentile
+ *
+ * @param values Samples to sort in place
+ * @param count Number of samples
+ */
+void ve_benchmark_sort(double* values, uint32_t count);
+
+/**
+ * @brief Nearest-rank percentile of sorted samples
+ *
+ * @param sorted Samples in ascending order (ve_benchmark_sort)
+ * @param count Number of samples, at least 1
+ * @param fraction Percentile as a fraction, 0.99 for p99
+ * @return Smallest sample with at least that fraction of the samples at or below it
+ */
+double ve_benchmark_percentile(const double* sorted, uint32_t count, double fraction);
+
+/**
+ * @brief Summarize a series of frame times
+ *
+ * @param samples Frame times in milliseconds
+ * @param count Number of frame times
+ * @param summary Output summary, zeroed when count is 0
+ * @return false if there are no frame times or no memory to sort them
+ */
+bool ve_benchmark_summarize(const double* samples, uint32_t count, ve_benchmark_summary* summary);
+
+/**
+ * @brief Summarize the CPU frame times of the run
+ *
+ * @param summary Output summary
+ * @return false if no frame was recorded
+ */
+bool ve_benchmark_get_cpu_summary(ve_benchmark_summary* summary);
+
+/**
+ * @brief Summarize the GPU frame times of the run
+ *
+ * @param summary Output summary
+ * @return false if no frame was recorded
+ */
+bool ve_benchmark_get_gpu_summary(ve_benchmark_summary* summary);
+
+/**
+ * @brief Get the number of distinct GPU passes recorded
+ *
+ * @return Pass count
+ */
+uint32_t ve_benchmark_get_pass_count(void);
+
+/**
+ * @brief Summarize the GPU times of one pass
+ *
+ * @param index Pass index, below ve_benchmark_get_pass_count
+ * @param name Receives the pass name
+ * @param summary Output summary over the GPU frames recorded since the pass first ran
+ * @return false if the index is out of range
+ */
+bool ve_benchmark_get_pass_summary(uint32_t index, const char** name, ve_benchmark_summary* summary);
+
+/**
+ * @brief Log the summaries of the run
+ */
+void ve_benchmark_log_report(void);
+
+/**
+ * @brief Write the summaries of the run as JSON
+ *
+ * @param path Output file path
+ * @return true on success
+ */
+bool ve_benchmark_write_report(const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_BENCHMARK_H */
@@ -0,0 +1,238 @@
+/**
+ * @file frame_pipeline.c
+ * @brief Simulation and render threads with frame pipelining implementation
+ */
+
+#include "frame_pipeline.h"
+#include "queue.h"
+#include "memory.h"
+#include "logger.h"
+
+#include <string.h>
+
+/* Global frame pipeline state. Snapshot indices travel simulation -> render
+   through ready and back through free; each queue has one producer and one
+   consumer, and a semaphore per queue counts its entries for the side that
+   sleeps on it. */
+static struct {
+    bool initialized;
+    bool threaded;
+    ve_frame_pipeline_config config;
+    ve_cpu_set render_cpus;
+    ve_render_snapshot snapshots[VE_FRAME_PIPELINE_SNAPSHOTS];
+    uint8_t* data;
+    ve_spsc_queue ready;
+    ve_spsc_queue free;
+    ve_semaphore* ready_count;
+    ve_semaphore* free_count;
+    ve_semaphore* prepared;         /* Signaled once prepare is done with the latest snapshot */
+    ve_thread* thread;
+    ve_atomic_int32 in_flight;      /* Submitted and not rendered, ve_frame_pipeline_flush sleeps on it */
+    ve_atomic_int32 shutdown;
+
+    /* Simulation thread */
+    uint64_t frame;
+    uint64_t submitted;
+    double simulation_wait;
+
+    /* Render thread */
+    ve_atomic_int64 rendered;
+    ve_atomic_int64 render_idle_us;
+} g_frame_pipeline = {0};
+
+static void render_snapshot(uint32_t index) {
+    const ve_render_snapshot* snapshot = &g_frame_pipeline.snapshots[index];
+
+    if (g_frame_pipeline.config.prepare) {
+        g_frame_pipeline.config.prepare(snapshot, g_frame_pipeline.config.user_data);
+    }
+    if (g_frame_pipeline.threaded) {
+        ve_semaphore_signal(g_frame_pipeline.prepared);
+    }
+
+    g_frame_pipeline.config.render(snapshot, g_frame_pipeline.config.user_data);
+
+    ve_spsc_queue_push(&g_frame_pipeline.free, &index);
+    ve_atomic_fetch_add64(&g_frame_pipeline.rendered, 1);
+    if (g_frame_pipeline.threaded) {
+        ve_semaphore_signal(g_frame_pipeline.free_count);
+        ve_atomic_decrement32(&g_frame_pipeline.in_flight);
+        ve_futex_wake_all(&g_frame_pipeline.in_flight);
+    }
+}
+
+static void* render_thread(void* user_data) {
+    (void)user_data;
+
+    if (g_frame_pipeline.config.render_cpus && !ve_thread_set_affinity(NULL, &g_frame_pipeline.render_cpus)) {
+        VE_LOG_WARN("Render thread could not be pinned");
+    }
+    if (g_frame_pipeline.config.render_priority != VE_THREAD_PRIORITY_NORMAL &&
+        !ve_thread_set_priority(NULL, g_frame_pipeline.config.render_priority)) {
+        VE_LOG_DEBUG("Cannot change the render thread priority");
+    }
+
+    for (;;) {
+        ve_timestamp wait_start = ve_timer_now();
+        ve_semaphore_wait(g_frame_pipeline.ready_count, UINT32_MAX);
+        double idle = ve_timer_elapsed(wait_start, ve_timer_now());
+        ve_atomic_fetch_add64(&g_frame_pipeline.render_idle_us, (int64_t)(idle * 1e6));
+
+        /* Shutdown wakes the thread with nothing queued */
+        uint32_t index;
+        if (!ve_spsc_queue_pop(&g_frame_pipeline.ready, &index)) {
+            if (ve_atomic_load32(&g_frame_pipeline.shutdown)) {
+                break;
+            }
+            continue;
+        }
+        render_snapshot(index);
+    }
+
+    return NULL;
+}
+
+bool ve_frame_pipeline_init(const ve_frame_pipeline_config* config) {
+    if (g_frame_pipeline.initialized) {
+        return true;
+    }
+    if (!config || !config->render) {
+        VE_LOG_ERROR("Frame pipeline needs a render callback");
+        return false;
+    }
+
+    memset(&g_frame_pipeline, 0, sizeof(g_frame_pipeline));
+    g_frame_pipeline.config = *config;
+    g_frame_pipeline.threaded = config->threaded;
+    if (config->render_cpus) {
+        g_frame_pipeline.render_cpus = *config->render_cpus;
+    }
+
+    if (config->snapshot_size > 0) {
+        g_frame_pipeline.data = (uint8_t*)ve_allocate_cleared(VE_FRAME_PIPELINE_SNAPSHOTS, config->snapshot_size,
+                                                              VE_MEMORY_TAG_CORE);
+        if (!g_frame_pipeline.data) {
+            VE_LOG_ERROR("Failed to allocate render snapshots");
+            return false;
+        }
+    }
+
+    if (!ve_spsc_queue_init(&g_frame_pipeline.ready, sizeof(uint32_t), VE_FRAME_PIPELINE_SNAPSHOTS) ||
+        !ve_spsc_queue_init(&g_frame_pipeline.free, sizeof(uint32_t), VE_FRAME_PIPELINE_SNAPSHOTS)) {
+        VE_LOG_ERROR("Failed to create frame pipeline queues");
+        ve_frame_pipeline_shutdown();
+        return false;
+    }
+
+    for (uint32_t i = 0; i < VE_FRAME_PIPELINE_SNAPSHOTS; i++) {
+        g_frame_pipeline.snapshots[i].data =
+            g_frame_pipeline.data ? g_frame_pipeline.data + (size_t)i * config->snapshot_size : NULL;
+        ve_spsc_queue_push(&g_frame_pipeline.free, &i);
+    }
+    g_frame_pipeline.initialized = true;
+
+    if (g_frame_pipeline.threaded) {
+        g_frame_pipeline.ready_count = ve_semaphore_create(0, VE_FRAME_PIPELINE_SNAPSHOTS + 1);
+        g_frame_pipeline.free_count = ve_semaphore_create(VE_FRAME_PIPELINE_SNAPSHOTS, VE_FRAME_PIPELINE_SNAPSHOTS);
+        g_frame_pipeline.prepared = ve_semaphore_create(0, 1);
+        if (g_frame_pipeline.ready_count && g_frame_pipeline.free_count && g_frame_pipeline.prepared) {
+            g_frame_pipeline.thread = ve_thread_create(render_thread, NULL, "render");
+        }
+        if (!g_frame_pipeline.thread) {
+            VE_LOG_ERROR("Failed to start the render thread");
+            ve_frame_pipeline_shutdown();
+            return false;
+        }
+    }
+
+    VE_LOG_INFO("Frame pipeline started (%s)", g_frame_pipeline.threaded ? "render thread" : "inline");
+    return true;
+}
+
+void ve_frame_pipeline_shutdown(void) {
+    if (g_frame_pipeline.thread) {
+        ve_frame_pipeline_flush();
+        ve_atomic_store32(&g_frame_pipeline.shutdown, 1);
+        ve_semaphore_signal(g_frame_pipeline.ready_count);
+        ve_thread_join(g_frame_pipeline.thread);
+    }
+
+    ve_semaphore_destroy(g_frame_pipeline.ready_count);
+    ve_semaphore_destroy(g_frame_pipeline.free_count);
+    ve_semaphore_destroy(g_frame_pipeline.prepared);
+    ve_spsc_queue_destroy(&g_frame_pipeline.ready);
+    ve_spsc_queue_destroy(&g_frame_pipeline.free);
+    VE_FREE(g_frame_pipeline.data);
+
+    memset(&g_frame_pipeline, 0, sizeof(g_frame_pipeline));
+}
+
+bool ve_frame_pipeline_is_threaded(void) {
+    return g_frame_pipeline.initialized && g_frame_pipeline.threaded;
+}
+
+ve_render_snapshot* ve_frame_pipeline_begin_snapshot(void) {
+    if (!g_frame_pipeline.initialized) {
+        return NULL;
+    }
+
+    if (g_frame_pipeline.threaded) {
+        ve_timestamp wait_start = ve_timer_now();
+        ve_semaphore_wait(g_frame_pipeline.free_count, UINT32_MAX);
+        g_frame_pipeline.simulation_wait += ve_timer_elapsed(wait_start, ve_timer_now());
+    }
+
+    uint32_t index;
+    if (!ve_spsc_queue_pop(&g_frame_pipeline.free, &index)) {
+        VE_LOG_ERROR("Frame pipeline has no free snapshot: one was begun and not submitted");
+        return NULL;
+    }
+
+    ve_render_snapshot* snapshot = &g_frame_pipeline.snapshots[index];
+    void* data = snapshot->data;
+    memset(snapshot, 0, sizeof(ve_render_snapshot));
+    snapshot->data = data;
+    snapshot->frame = ++g_frame_pipeline.frame;
+    return snapshot;
+}
+
+void ve_frame_pipeline_submit_snapshot(ve_render_snapshot* snapshot) {
+    if (!g_frame_pipeline.initialized || !snapshot) {
+        return;
+    }
+
+    uint32_t index = (uint32_t)(snapshot - g_frame_pipeline.snapshots);
+    g_frame_pipeline.submitted++;
+
+    if (!g_frame_pipeline.threaded) {
+        render_snapshot(index);
+        return;
+    }
+
+    ve_atomic_increment32(&g_frame_pipeline.in_flight);
+    ve_spsc_queue_push(&g_frame_pipeline.ready, &index);
+    ve_semaphore_signal(g_frame_pipeline.ready_count);
+
+    /* Hold the simulation until the render side has read what it shares with it */
+    ve_timestamp wait_start = ve_timer_now();
+    ve_semaphore_wait(g_frame_pipeline.prepared, UINT32_MAX);
+    g_frame_pipeline.simulation_wait += ve_timer_elapsed(wait_start, ve_timer_now());
+}
+
+void ve_frame_pipeline_flush(void) {
+    int32_t in_flight;
+    while ((in_flight = ve_atomic_load32(&g_frame_pipeline.in_flight)) != 0) {
+        ve_futex_wait(&g_frame_pipeline.in_flight, in_flight, UINT32_MAX);
+    }
+}
+
+void ve_frame_pipeline_get_stats(ve_frame_pipeline_stats* stats) {
+    if (!stats) {
+        return;
+    }
+
+    stats->submitted = g_frame_pipeline.submitted;
+    stats->rendered = (uint64_t)ve_atomic_load64(&g_frame_pipeline.rendered);
+    stats->simulation_wait = g_frame_pipeline.simulation_wait;
+    stats->render_idle = (double)ve_atomic_load64(&g_frame_pipeline.render_idle_us) * 1e-6;
+}
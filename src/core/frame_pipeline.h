@@ -0,0 +1,146 @@
+/**
+ * @file frame_pipeline.h
+ * @brief Simulation and render threads with frame pipelining
+ *
+ * The simulation thread describes each frame in a render snapshot and
+ * hands it over; in threaded mode a render thread records and submits it
+ * while the simulation thread moves on to the next frame. Two snapshots
+ * alternate, so the simulation runs at most one frame ahead.
+ *
+ * Rendering a snapshot is split in two callbacks. prepare runs first, on
+ * the render thread while the simulation thread waits at the handoff: it
+ * is the one place the render side may read simulation-owned state
+ * directly (uploading changed instances, servicing asset loads). render
+ * then runs in parallel with the next simulation step and may only use the
+ * snapshot and render-owned state.
+ *
+ * Without the thread both callbacks run inline from
+ * ve_frame_pipeline_submit_snapshot, so the same code serves both modes.
+ * Snapshots carry the fixed-timestep interpolation factor
+ * (ve_frame_time_get_alpha) the simulation was at, so the render side
+ * blends the previous and latest simulation states instead of showing
+ * whichever step the render thread happens to overlap.
+ */
+
+#ifndef VE_FRAME_PIPELINE_H
+#define VE_FRAME_PIPELINE_H
+
+#include "thread.h"
+#include "timer.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Snapshots in the pipeline: one being rendered, one being built */
+#define VE_FRAME_PIPELINE_SNAPSHOTS 2
+
+/**
+ * @brief Immutable description of one frame, from simulation to render
+ */
+typedef struct ve_render_snapshot {
+    uint64_t frame;                 /* Sequence number, from 1 */
+    double time;                    /* Simulation time of the latest fixed step */
+    double alpha;                   /* Blend from the previous to the latest fixed step, [0, 1] */
+    double delta_time;              /* Frame delta in seconds */
+    ve_timestamp input_time;        /* When the frame's input was sampled */
+    ve_timestamp simulation_end;    /* When the simulation step finished */
+    void* data;                     /* snapshot_size bytes of application data */
+} ve_render_snapshot;
+
+/**
+ * @brief Render-side callback
+ *
+ * @param snapshot Snapshot being rendered, read-only
+ * @param user_data User data from the configuration
+ */
+typedef void (*ve_render_fn)(const ve_render_snapshot* snapshot, void* user_data);
+
+/**
+ * @brief Frame pipeline configuration
+ */
+typedef struct ve_frame_pipeline_config {
+    bool threaded;                  /* Render on a dedicated thread; false runs the callbacks inline */
+    uint32_t snapshot_size;         /* Bytes of application data per snapshot */
+    ve_render_fn prepare;           /* Optional, runs while the simulation thread waits */
+    ve_render_fn render;            /* Runs alongside the next simulation step */
+    void* user_data;
+    const ve_cpu_set* render_cpus;  /* Affinity of the render thread, NULL to leave it */
+    ve_thread_priority render_priority;
+} ve_frame_pipeline_config;
+
+/**
+ * @brief Frame pipeline statistics
+ */
+typedef struct ve_frame_pipeline_stats {
+    uint64_t submitted;             /* Snapshots handed over */
+    uint64_t rendered;              /* Snapshots fully rendered */
+    double simulation_wait;         /* Seconds the simulation thread waited for the render side */
+    double render_idle;             /* Seconds the render thread waited for a snapshot */
+} ve_frame_pipeline_stats;
+
+/**
+ * @brief Start the pipeline, and the render thread in threaded mode
+ *
+ * Call from the simulation thread, which must be the only caller of the
+ * functions below.
+ *
+ * @param config Configuration
+ * @return true on success
+ */
+bool ve_frame_pipeline_init(const ve_frame_pipeline_config* config);
+
+/**
+ * @brief Render every submitted snapshot and stop the render thread
+ */
+void ve_frame_pipeline_shutdown(void);
+
+/**
+ * @brief Check if snapshots render on a dedicated thread
+ *
+ * @return true in threaded mode
+ */
+bool ve_frame_pipeline_is_threaded(void);
+
+/**
+ * @brief Get the snapshot to fill for the next frame
+ *
+ * Waits while both snapshots are in use, i.e. until the render side has
+ * finished the frame before the previous one. Its data keeps whatever the
+ * frame two submissions ago left in it.
+ *
+ * @return Snapshot to fill, or NULL if the pipeline is not running
+ */
+ve_render_snapshot* ve_frame_pipeline_begin_snapshot(void);
+
+/**
+ * @brief Hand a filled snapshot to the render side
+ *
+ * Returns once prepare has run for it; in inline mode, once render has too.
+ *
+ * @param snapshot Snapshot from ve_frame_pipeline_begin_snapshot
+ */
+void ve_frame_pipeline_submit_snapshot(ve_render_snapshot* snapshot);
+
+/**
+ * @brief Wait until every submitted snapshot has been rendered
+ *
+ * For work that must not overlap rendering, like tearing down resources
+ * the render thread uses.
+ */
+void ve_frame_pipeline_flush(void);
+
+/**
+ * @brief Get pipeline statistics
+ *
+ * @param stats Output statistics
+ */
+void ve_frame_pipeline_get_stats(ve_frame_pipeline_stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_FRAME_PIPELINE_H */
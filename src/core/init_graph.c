@@ -0,0 +1,214 @@
+/**
+ * @file init_graph.c
+ * @brief Startup task graph implementation
+ */
+
+#include "init_graph.h"
+#include "timer.h"
+#include "logger.h"
+
+#include <string.h>
+
+/* One run of a graph. Workers publish each task's outcome through its status
+   and then signal the semaphore, their last touch of the run; the caller
+   waits once per submitted task before the run leaves its stack. */
+typedef struct init_run {
+    ve_init_graph* graph;
+    ve_timestamp start;
+    ve_semaphore* finished;
+    ve_atomic_int32 status[VE_INIT_GRAPH_MAX_TASKS];
+} init_run;
+
+typedef struct init_job {
+    init_run* run;
+    uint32_t index;
+} init_job;
+
+void ve_init_graph_init(ve_init_graph* graph) {
+    memset(graph, 0, sizeof(ve_init_graph));
+}
+
+uint32_t ve_init_graph_add(ve_init_graph* graph, const char* name, ve_init_fn fn, void* user_data, uint32_t flags,
+                           uint64_t dependencies) {
+    if (!graph || !fn || graph->task_count == VE_INIT_GRAPH_MAX_TASKS) {
+        VE_LOG_ERROR("Cannot add startup task %s", name ? name : "");
+        return VE_INIT_TASK_INVALID;
+    }
+
+    /* Only earlier tasks, which keeps the graph acyclic */
+    uint32_t index = graph->task_count;
+    if ((dependencies >> index) != 0) {
+        VE_LOG_ERROR("Startup task %s depends on a task added after it", name ? name : "");
+        return VE_INIT_TASK_INVALID;
+    }
+
+    ve_init_task* task = &graph->tasks[graph->task_count++];
+    memset(task, 0, sizeof(ve_init_task));
+    task->name = name ? name : "";
+    task->fn = fn;
+    task->user_data = user_data;
+    task->flags = flags;
+    task->dependencies = dependencies;
+    return index;
+}
+
+/* Run a task on the calling thread, recording its timing */
+static ve_init_task_state run_task(init_run* run, uint32_t index) {
+    ve_init_task* task = &run->graph->tasks[index];
+    ve_timestamp start = ve_timer_now();
+    bool success = task->fn(task->user_data);
+    ve_timestamp end = ve_timer_now();
+
+    task->start_ms = ve_timer_elapsed(run->start, start) * 1000.0;
+    task->duration_ms = ve_timer_elapsed(start, end) * 1000.0;
+    if (!success) {
+        VE_LOG_ERROR("Startup task %s failed", task->name);
+    }
+    return success ? VE_INIT_TASK_SUCCEEDED : VE_INIT_TASK_FAILED;
+}
+
+static void worker_task(void* user_data) {
+    init_job* job = (init_job*)user_data;
+    init_run* run = job->run;
+
+    run->graph->tasks[job->index].ran_on_worker = true;
+    ve_init_task_state state = run_task(run, job->index);
+    ve_atomic_store32(&run->status[job->index], (int32_t)state);
+    ve_semaphore_signal(run->finished);
+}
+
+static bool run_serial(init_run* run) {
+    ve_init_graph* graph = run->graph;
+    bool success = true;
+    for (uint32_t i = 0; i < graph->task_count; i++) {
+        if (success) {
+            graph->tasks[i].state = run_task(run, i);
+            success = graph->tasks[i].state == VE_INIT_TASK_SUCCEEDED;
+        } else {
+            graph->tasks[i].state = VE_INIT_TASK_SKIPPED;
+        }
+    }
+    return success;
+}
+
+bool ve_init_graph_run(ve_init_graph* graph, ve_thread_pool* pool) {
+    init_run run;
+    memset(&run, 0, sizeof(run));
+    run.graph = graph;
+    run.start = ve_timer_now();
+
+    for (uint32_t i = 0; i < graph->task_count; i++) {
+        ve_init_task* task = &graph->tasks[i];
+        task->state = VE_INIT_TASK_PENDING;
+        task->ran_on_worker = false;
+        task->start_ms = 0.0;
+        task->duration_ms = 0.0;
+    }
+
+    run.finished = pool ? ve_semaphore_create(0, VE_INIT_GRAPH_MAX_TASKS) : NULL;
+    if (!run.finished) {
+        bool success = run_serial(&run);
+        graph->total_ms = ve_timer_elapsed(run.start, ve_timer_now()) * 1000.0;
+        return success;
+    }
+
+    init_job jobs[VE_INIT_GRAPH_MAX_TASKS];
+    uint64_t started = 0;
+    uint64_t succeeded = 0;
+    uint64_t running = 0;           /* Started on a worker and not yet seen finishing */
+    uint32_t unsignaled = 0;        /* Submitted tasks whose signal has not been waited for */
+    bool failed = false;
+
+    for (;;) {
+        /* Collect finished workers */
+        for (uint32_t i = 0; i < graph->task_count; i++) {
+            int32_t status = ve_atomic_load32(&run.status[i]);
+            if ((running & VE_INIT_AFTER(i)) && status != VE_INIT_TASK_PENDING) {
+                running &= ~VE_INIT_AFTER(i);
+                graph->tasks[i].state = (ve_init_task_state)status;
+                if (status == VE_INIT_TASK_SUCCEEDED) {
+                    succeeded |= VE_INIT_AFTER(i);
+                } else {
+                    failed = true;
+                }
+            }
+        }
+
+        /* Hand every ready worker task to the pool, then run one ready main-thread task */
+        bool progressed = false;
+        for (uint32_t i = 0; i < graph->task_count && !failed; i++) {
+            ve_init_task* task = &graph->tasks[i];
+            if ((started & VE_INIT_AFTER(i)) || (task->dependencies & ~succeeded) != 0 ||
+                (task->flags & VE_INIT_TASK_MAIN_THREAD)) {
+                continue;
+            }
+            started |= VE_INIT_AFTER(i);
+            jobs[i].run = &run;
+            jobs[i].index = i;
+            if (ve_thread_pool_submit(pool, worker_task, &jobs[i])) {
+                running |= VE_INIT_AFTER(i);
+                unsignaled++;
+            } else {
+                task->state = run_task(&run, i);
+                succeeded |= task->state == VE_INIT_TASK_SUCCEEDED ? VE_INIT_AFTER(i) : 0;
+                failed = task->state != VE_INIT_TASK_SUCCEEDED;
+            }
+            progressed = true;
+        }
+        for (uint32_t i = 0; i < graph->task_count && !failed && !progressed; i++) {
+            ve_init_task* task = &graph->tasks[i];
+            if ((started & VE_INIT_AFTER(i)) || (task->dependencies & ~succeeded) != 0 ||
+                !(task->flags & VE_INIT_TASK_MAIN_THREAD)) {
+                continue;
+            }
+            started |= VE_INIT_AFTER(i);
+            task->state = run_task(&run, i);
+            if (task->state == VE_INIT_TASK_SUCCEEDED) {
+                succeeded |= VE_INIT_AFTER(i);
+            } else {
+                failed = true;
+            }
+            progressed = true;
+        }
+
+        if (progressed) {
+            continue;
+        }
+        /* A status can be seen before its worker signals, so finishing goes by the signals */
+        if (unsignaled == 0) {
+            break;
+        }
+        ve_semaphore_wait(run.finished, UINT32_MAX);
+        unsignaled--;
+    }
+
+    ve_semaphore_destroy(run.finished);
+
+    bool success = !failed;
+    for (uint32_t i = 0; i < graph->task_count; i++) {
+        if (!(started & VE_INIT_AFTER(i))) {
+            graph->tasks[i].state = VE_INIT_TASK_SKIPPED;
+            success = false;
+        }
+    }
+    graph->total_ms = ve_timer_elapsed(run.start, ve_timer_now()) * 1000.0;
+    return success;
+}
+
+void ve_init_graph_log_timings(const ve_init_graph* graph) {
+    double work_ms = 0.0;
+    for (uint32_t i = 0; i < graph->task_count; i++) {
+        work_ms += graph->tasks[i].duration_ms;
+    }
+    VE_LOG_INFO("Startup took %.1f ms for %.1f ms of tasks", graph->total_ms, work_ms);
+
+    for (uint32_t i = 0; i < graph->task_count; i++) {
+        const ve_init_task* task = &graph->tasks[i];
+        if (task->state == VE_INIT_TASK_SKIPPED) {
+            VE_LOG_INFO("  %-20s skipped", task->name);
+        } else {
+            VE_LOG_INFO("  %-20s %-6s +%7.1f ms %7.1f ms%s", task->name, task->ran_on_worker ? "worker" : "main",
+                        task->start_ms, task->duration_ms, task->state == VE_INIT_TASK_FAILED ? " failed" : "");
+        }
+    }
+}
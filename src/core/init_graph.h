@@ -0,0 +1,130 @@
+/**
+ * @file init_graph.h
+ * @brief Startup tasks run in dependency order, in parallel where they allow it
+ *
+ * Each task names the earlier tasks it needs. Running the graph starts
+ * every task as soon as its dependencies have succeeded: main-thread tasks
+ * (windowing, anything that must stay on the calling thread) run on the
+ * caller, the rest on a thread pool, so slow independent work such as
+ * reading caches and loading shaders overlaps. Each task's start and
+ * duration are recorded for the startup log.
+ *
+ * Dependencies can only name tasks added before, so the graph cannot have
+ * cycles and the order tasks were added in is always a valid serial order.
+ */
+
+#ifndef VE_INIT_GRAPH_H
+#define VE_INIT_GRAPH_H
+
+#include "thread.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VE_INIT_GRAPH_MAX_TASKS 64
+#define VE_INIT_TASK_INVALID UINT32_MAX
+
+/* Dependency mask bit of a task */
+#define VE_INIT_AFTER(task) (1ull << (task))
+
+/**
+ * @brief Startup task
+ *
+ * @param user_data User data given to ve_init_graph_add
+ * @return false on a failure that must stop startup; optional features log and return true
+ */
+typedef bool (*ve_init_fn)(void* user_data);
+
+/**
+ * @brief Task flags
+ */
+typedef enum ve_init_task_flags {
+    VE_INIT_TASK_NONE           = 0,
+    VE_INIT_TASK_MAIN_THREAD    = 1 << 0,   /* Run on the thread calling ve_init_graph_run */
+} ve_init_task_flags;
+
+/**
+ * @brief Task outcome
+ */
+typedef enum ve_init_task_state {
+    VE_INIT_TASK_PENDING = 0,
+    VE_INIT_TASK_SUCCEEDED,
+    VE_INIT_TASK_FAILED,
+    VE_INIT_TASK_SKIPPED,           /* Not run because a task failed */
+} ve_init_task_state;
+
+/**
+ * @brief Task and its timing
+ */
+typedef struct ve_init_task {
+    const char* name;
+    ve_init_fn fn;
+    void* user_data;
+    uint32_t flags;
+    uint64_t dependencies;          /* VE_INIT_AFTER bits of earlier tasks */
+
+    /* Filled in by ve_init_graph_run */
+    ve_init_task_state state;
+    bool ran_on_worker;
+    double start_ms;                /* From the start of the run */
+    double duration_ms;
+} ve_init_task;
+
+/**
+ * @brief Startup task graph
+ */
+typedef struct ve_init_graph {
+    ve_init_task tasks[VE_INIT_GRAPH_MAX_TASKS];
+    uint32_t task_count;
+    double total_ms;                /* Wall time of the last run */
+} ve_init_graph;
+
+/**
+ * @brief Reset a graph to no tasks
+ *
+ * @param graph Graph
+ */
+void ve_init_graph_init(ve_init_graph* graph);
+
+/**
+ * @brief Add a task
+ *
+ * @param graph Graph
+ * @param name Name in the startup log; must outlive the graph (normally a string literal)
+ * @param fn Task function
+ * @param user_data Passed to the task
+ * @param flags Combination of ve_init_task_flags
+ * @param dependencies VE_INIT_AFTER bits of tasks that must succeed first, 0 for none
+ * @return Task index, or VE_INIT_TASK_INVALID if the graph is full or a dependency is not an earlier task
+ */
+uint32_t ve_init_graph_add(ve_init_graph* graph, const char* name, ve_init_fn fn, void* user_data, uint32_t flags,
+                           uint64_t dependencies);
+
+/**
+ * @brief Run every task
+ *
+ * Returns once no task is running. After a failure no further task starts;
+ * the ones already running finish and the rest are marked skipped. Worker
+ * tasks must not wait for the whole pool (ve_thread_pool_wait).
+ *
+ * @param graph Graph
+ * @param pool Pool for tasks not bound to the main thread, or NULL to run everything on the caller in order
+ * @return true if every task succeeded
+ */
+bool ve_init_graph_run(ve_init_graph* graph, ve_thread_pool* pool);
+
+/**
+ * @brief Log each task's start, duration and thread, and the total
+ *
+ * @param graph Graph that has run
+ */
+void ve_init_graph_log_timings(const ve_init_graph* graph);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_INIT_GRAPH_H */
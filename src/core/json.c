@@ -0,0 +1,21 @@
+/**
+ * @file json.c
+ * @brief JSON writing helpers implementation
+ */
+
+#include "json.h"
+
+void ve_json_write_string(FILE* file, const char* text) {
+    fputc('"', file);
+    for (const char* c = text ? text : ""; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', file);
+            fputc(*c, file);
+        } else if ((unsigned char)*c < 0x20) {
+            fprintf(file, "\\u%04x", (unsigned char)*c);
+        } else {
+            fputc(*c, file);
+        }
+    }
+    fputc('"', file);
+}
@@ -0,0 +1,30 @@
+/**
+ * @file json.h
+ * @brief Helpers for writing JSON files
+ *
+ * Shared by the reports and traces that core modules write with stdio
+ * (profiler Chrome traces, benchmark reports).
+ */
+
+#ifndef VE_JSON_H
+#define VE_JSON_H
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Write a JSON string literal, escaping quotes, backslashes and control characters
+ *
+ * @param file Output file
+ * @param text Text to write, NULL writes an empty string
+ */
+void ve_json_write_string(FILE* file, const char* text);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_JSON_H */
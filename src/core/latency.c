@@ -0,0 +1,112 @@
+/**
+ * @file latency.c
+ * @brief Input-to-photon latency markers implementation
+ */
+
+#include "latency.h"
+
+#include <string.h>
+
+/**
+ * @brief Markers of one frame, 0 where not recorded
+ */
+typedef struct ve_latency_frame {
+    uint64_t frame_id;
+    bool used;
+    ve_timestamp markers[VE_LATENCY_MARKER_COUNT];
+} ve_latency_frame;
+
+/* Recorded frames, indexed by frame id modulo the history size */
+static ve_latency_frame g_latency_frames[VE_LATENCY_HISTORY] = {0};
+
+void ve_latency_reset(void) {
+    memset(g_latency_frames, 0, sizeof(g_latency_frames));
+}
+
+void ve_latency_mark(uint64_t frame_id, ve_latency_marker marker) {
+    ve_latency_mark_at(frame_id, marker, ve_timer_now());
+}
+
+void ve_latency_mark_at(uint64_t frame_id, ve_latency_marker marker, ve_timestamp time) {
+    if (marker >= VE_LATENCY_MARKER_COUNT) {
+        return;
+    }
+
+    ve_latency_frame* frame = &g_latency_frames[frame_id % VE_LATENCY_HISTORY];
+    if (!frame->used || frame->frame_id != frame_id) {
+        /* Late markers of a frame that was already overwritten are dropped */
+        if (frame->used && frame->frame_id > frame_id) {
+            return;
+        }
+        memset(frame, 0, sizeof(ve_latency_frame));
+        frame->frame_id = frame_id;
+        frame->used = true;
+    }
+
+    frame->markers[marker] = time;
+}
+
+bool ve_latency_get_marker(uint64_t frame_id, ve_latency_marker marker, ve_timestamp* out_time) {
+    if (marker >= VE_LATENCY_MARKER_COUNT) {
+        return false;
+    }
+
+    const ve_latency_frame* frame = &g_latency_frames[frame_id % VE_LATENCY_HISTORY];
+    if (!frame->used || frame->frame_id != frame_id || frame->markers[marker] == 0) {
+        return false;
+    }
+
+    if (out_time) {
+        *out_time = frame->markers[marker];
+    }
+    return true;
+}
+
+void ve_latency_get_stats(ve_latency_stats* stats) {
+    if (!stats) {
+        return;
+    }
+
+    memset(stats, 0, sizeof(ve_latency_stats));
+
+    uint32_t submit_count = 0;
+    for (uint32_t i = 0; i < VE_LATENCY_HISTORY; i++) {
+        const ve_latency_frame* frame = &g_latency_frames[i];
+        ve_timestamp input = frame->markers[VE_LATENCY_INPUT_SAMPLE];
+        if (!frame->used || input == 0) {
+            continue;
+        }
+
+        ve_timestamp submit = frame->markers[VE_LATENCY_RENDER_SUBMIT];
+        if (submit >= input) {
+            stats->input_to_submit_ms += ve_timer_to_milliseconds(submit - input);
+            submit_count++;
+        }
+
+        ve_timestamp present = frame->markers[VE_LATENCY_PRESENT];
+        if (present >= input) {
+            stats->input_to_present_ms += ve_timer_to_milliseconds(present - input);
+            stats->frame_count++;
+        }
+
+        ve_timestamp photon = frame->markers[VE_LATENCY_PRESENT_COMPLETE];
+        if (photon >= input) {
+            double ms = ve_timer_to_milliseconds(photon - input);
+            stats->input_to_photon_ms += ms;
+            if (ms > stats->max_input_to_photon_ms) {
+                stats->max_input_to_photon_ms = ms;
+            }
+            stats->photon_frame_count++;
+        }
+    }
+
+    if (submit_count > 0) {
+        stats->input_to_submit_ms /= submit_count;
+    }
+    if (stats->frame_count > 0) {
+        stats->input_to_present_ms /= stats->frame_count;
+    }
+    if (stats->photon_frame_count > 0) {
+        stats->input_to_photon_ms /= stats->photon_frame_count;
+    }
+}
@@ -0,0 +1,100 @@
+/**
+ * @file latency.h
+ * @brief Input-to-photon latency markers
+ *
+ * Each frame records when its input was sampled, when its GPU work was
+ * submitted, when it was presented and, where the swapchain can observe
+ * it (VK_KHR_present_wait), when the image reached the display. The last
+ * VE_LATENCY_HISTORY frames are kept and averaged on request.
+ *
+ * Markers are recorded from the frame thread.
+ */
+
+#ifndef VE_LATENCY_H
+#define VE_LATENCY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "timer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Frames kept for the latency averages */
+#define VE_LATENCY_HISTORY 64
+
+/**
+ * @brief Points in a frame's life that are timestamped
+ */
+typedef enum ve_latency_marker {
+    VE_LATENCY_INPUT_SAMPLE,        /* Input polled for the frame */
+    VE_LATENCY_SIMULATION_END,      /* Game update finished */
+    VE_LATENCY_RENDER_SUBMIT,       /* GPU work of the frame submitted */
+    VE_LATENCY_PRESENT,             /* Image handed to the presentation engine */
+    VE_LATENCY_PRESENT_COMPLETE,    /* Image reached the display */
+    VE_LATENCY_MARKER_COUNT
+} ve_latency_marker;
+
+/**
+ * @brief Latency averaged over the recorded frames
+ *
+ * Every average only includes frames that reached the corresponding
+ * marker; averages without frames are zero.
+ */
+typedef struct ve_latency_stats {
+    uint32_t frame_count;           /* Frames with input and present marked */
+    uint32_t photon_frame_count;    /* Frames whose display time is known */
+    double input_to_submit_ms;
+    double input_to_present_ms;
+    double input_to_photon_ms;
+    double max_input_to_photon_ms;
+} ve_latency_stats;
+
+/**
+ * @brief Forget every recorded frame
+ */
+void ve_latency_reset(void);
+
+/**
+ * @brief Timestamp a marker of a frame with the current time
+ *
+ * @param frame_id Frame number (monotonic)
+ * @param marker Marker to record
+ */
+void ve_latency_mark(uint64_t frame_id, ve_latency_marker marker);
+
+/**
+ * @brief Record a marker of a frame at a given time
+ *
+ * A frame that falls out of the history is overwritten by the first
+ * marker of the newer frame sharing its slot.
+ *
+ * @param frame_id Frame number (monotonic)
+ * @param marker Marker to record
+ * @param time Time in ve_timer_now units
+ */
+void ve_latency_mark_at(uint64_t frame_id, ve_latency_marker marker, ve_timestamp time);
+
+/**
+ * @brief Get the time of a recorded marker
+ *
+ * @param frame_id Frame number
+ * @param marker Marker
+ * @param out_time Receives the time in ve_timer_now units
+ * @return true if the marker was recorded for the frame and is still in the history
+ */
+bool ve_latency_get_marker(uint64_t frame_id, ve_latency_marker marker, ve_timestamp* out_time);
+
+/**
+ * @brief Average the latency of the recorded frames
+ *
+ * @param stats Output statistics
+ */
+void ve_latency_get_stats(ve_latency_stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_LATENCY_H */
@@ -5,6 +5,7 @@
 
 #define VE_LOGGER_IMPL
 #include "logger.h"
+#include "thread.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -16,15 +17,24 @@
     #include <windows.h>
     #include <io.h>
     #include <fcntl.h>
+    #define THREAD_LOCAL __declspec(thread)
 #elif defined(__linux__) || defined(__APPLE__)
     #define VE_PLATFORM_UNIX
     #include <unistd.h>
     #include <pthread.h>
     #include <sys/syscall.h>
+    #define THREAD_LOCAL __thread
 #endif
 
 #define VE_MAX_LOG_MESSAGE_SIZE 4096
 #define VE_MAX_LOG_BUFFER_SIZE (1024 * 1024)  /* 1MB buffer */
+#define VE_LOG_QUEUE_DEFAULT_CAPACITY 4096
+#define VE_LOG_QUEUE_CELL_SIZE 512
+#define VE_LOG_WRITER_IDLE_MS 50
+#define VE_LOG_THREAD_BUFFER_SIZE (64 * 1024)  /* Power of two */
+#define VE_LOG_MAX_SPECS 16
+#define VE_LOG_MAX_SPEC_LENGTH 31
+#define VE_LOG_MAX_DEFERRED_RECORD 2048
 
 /* Level names and colors */
 static const struct {
@@ -41,6 +51,86 @@ static const struct {
     { "OFF",   "X", VE_COLOR_DEFAULT },
 };
 
+/* Everything needed to format a message except its text */
+typedef struct ve_log_record {
+    ve_log_level level;
+    int line;
+    const char* file;
+    const char* func;
+    unsigned long thread_id;
+    time_t time;
+    uint64_t timestamp;       /* Monotonic, orders queued and deferred messages */
+    size_t length;
+} ve_log_record;
+
+#define VE_LOG_QUEUE_TEXT_SIZE \
+    (VE_LOG_QUEUE_CELL_SIZE - sizeof(ve_atomic_int64) - sizeof(ve_log_record))
+
+/* Bounded MPSC queue cell (Vyukov). sequence == position means free for the
+   producer claiming position, position + 1 means ready for the writer. */
+typedef struct ve_log_cell {
+    ve_atomic_int64 sequence;
+    ve_log_record record;
+    char text[VE_LOG_QUEUE_TEXT_SIZE];
+} ve_log_cell;
+
+/* Deferred formatting. A format string is parsed once per call site into
+   its conversions; the caller then copies each argument as raw bytes into
+   a per-thread ring and the writer feeds them back to snprintf one
+   conversion at a time. */
+typedef enum ve_log_arg_type {
+    VE_LOG_ARG_INT = 0,
+    VE_LOG_ARG_LONG,
+    VE_LOG_ARG_LLONG,
+    VE_LOG_ARG_SIZE,
+    VE_LOG_ARG_INTMAX,
+    VE_LOG_ARG_PTRDIFF,
+    VE_LOG_ARG_DOUBLE,
+    VE_LOG_ARG_POINTER,
+    VE_LOG_ARG_STRING,
+} ve_log_arg_type;
+
+typedef struct ve_log_spec {
+    uint16_t literal_start;  /* Plain text since the previous conversion */
+    uint16_t start;          /* Offset of the '%' */
+    uint8_t length;
+    uint8_t arg_count;       /* '*' width and precision come before the value */
+    uint8_t types[3];
+} ve_log_spec;
+
+typedef struct ve_log_format {
+    const char* fmt;
+    bool deferrable;         /* false for conversions we can't replay (%n, %ls, long double) */
+    uint32_t spec_count;
+    uint32_t arg_count;
+    uint16_t tail_start;
+    ve_log_spec specs[VE_LOG_MAX_SPECS];
+} ve_log_format;
+
+/* Record header in a thread buffer. Arguments follow in 8-byte slots;
+   a string slot holds its length and is followed by the padded bytes. */
+typedef struct ve_log_deferred_header {
+    uint32_t size;
+    uint32_t level;          /* VE_LOG_OFF marks padding up to the end of the ring */
+    const ve_log_site* site;
+    const ve_log_format* format;
+    uint64_t timestamp;
+    uint64_t thread_id;
+} ve_log_deferred_header;
+
+/* Single-producer ring owned by one thread and read by the writer. Buffers
+   are never freed; one left behind by an exited thread is adopted. */
+typedef struct ve_log_thread_buffer {
+    ve_atomic_int64 head;
+    uint8_t padding0[64 - sizeof(ve_atomic_int64)];
+    ve_atomic_int64 tail;
+    uint8_t padding1[64 - sizeof(ve_atomic_int64)];
+    struct ve_log_thread_buffer* next;
+    ve_atomic_int32 abandoned;
+    unsigned long thread_id;
+    uint8_t data[VE_LOG_THREAD_BUFFER_SIZE];
+} ve_log_thread_buffer;
+
 /* Logger state */
 static struct {
     ve_logger_config config;
@@ -52,14 +142,47 @@ static struct {
     bool initialized;
     bool console_supports_color;
 
+    /* Output lock, held while writing to the targets */
 #ifdef VE_PLATFORM_UNIX
     pthread_mutex_t mutex;
 #endif
 #ifdef VE_PLATFORM_WINDOWS
     CRITICAL_SECTION mutex;
 #endif
+
+    /* Asynchronous mode */
+    bool async;
+    ve_log_cell* cells;
+    uint64_t cell_mask;
+    ve_atomic_int64 enqueue_pos;
+    uint64_t dequeue_pos;             /* Writer thread only */
+    ve_atomic_int64 written;          /* Messages processed by the writer */
+    ve_atomic_int64 dropped;
+    int64_t dropped_reported;
+    ve_atomic_int32 writer_sleeping;
+    ve_atomic_int32 shutdown;
+    ve_semaphore* wake;
+    ve_thread* writer;
+
+    /* Deferred formatting */
+    bool deferred;
+    ve_atomic_ptr thread_buffers;     /* Push-only list of ve_log_thread_buffer */
+    bool thread_buffer_key_created;
+    time_t base_time;                 /* Wall clock at base_timestamp */
+    uint64_t base_timestamp;
+#ifdef VE_PLATFORM_UNIX
+    pthread_key_t thread_buffer_key;
+#endif
+#ifdef VE_PLATFORM_WINDOWS
+    DWORD thread_buffer_key;
+    LARGE_INTEGER counter_frequency;
+#endif
 } g_logger = {0};
 
+/* Set on the writer thread, whose own messages must not wait on the queue */
+static THREAD_LOCAL bool t_is_log_writer = false;
+static THREAD_LOCAL ve_log_thread_buffer* t_log_buffer = NULL;
+
 /* Forward declarations */
 static void lock_logger(void);
 static void unlock_logger(void);
@@ -68,9 +191,21 @@ static void write_to_buffer(const char* message, size_t len);
 static void rotate_log_file(void);
 static void set_terminal_color(ve_log_color color);
 static void reset_terminal_color(void);
-static const char* get_timestamp(char* buffer, size_t size);
+static const char* get_timestamp(time_t now, char* buffer, size_t size);
 static unsigned long get_thread_id(void);
 static const char* basename(const char* path);
+static void write_record(const ve_log_record* record, const char* text);
+static bool start_writer(void);
+static void stop_writer(void);
+static bool enqueue_record(const ve_log_record* record, const char* text);
+static void wake_writer(void);
+static uint64_t get_monotonic_ns(void);
+#ifdef VE_PLATFORM_WINDOWS
+static void WINAPI thread_buffer_release(void* ptr);
+#else
+static void thread_buffer_release(void* ptr);
+#endif
+static bool log_deferred(ve_log_site* site, ve_log_level level, const char* fmt, va_list args, bool* dropped);
 
 /* Implementation */
 bool ve_logger_init(const ve_logger_config* config) {
@@ -101,6 +236,10 @@ bool ve_logger_init(const ve_logger_config* config) {
         g_logger.config.file_pattern = NULL;
         g_logger.config.max_file_size = 10 * 1024 * 1024;  /* 10MB */
         g_logger.config.max_files = 5;
+        g_logger.config.async = false;
+        g_logger.config.queue_capacity = 0;
+        g_logger.config.overflow_policy = VE_LOG_OVERFLOW_BLOCK;
+        g_logger.config.deferred_format = false;
     }
 
     /* Check if console supports colors */
@@ -163,8 +302,33 @@ bool ve_logger_init(const ve_logger_config* config) {
 
     g_logger.buffer_pos = 0;
     g_logger.current_file_index = 0;
+
+    /* Clocks for ordering and dating deferred messages */
+#ifdef VE_PLATFORM_WINDOWS
+    QueryPerformanceFrequency(&g_logger.counter_frequency);
+#endif
+    g_logger.base_time = time(NULL);
+    g_logger.base_timestamp = get_monotonic_ns();
+
+    /* Marks a thread's deferred buffer for reuse when the thread exits */
+    if (!g_logger.thread_buffer_key_created) {
+#ifdef VE_PLATFORM_UNIX
+        g_logger.thread_buffer_key_created = pthread_key_create(&g_logger.thread_buffer_key, thread_buffer_release) == 0;
+#endif
+#ifdef VE_PLATFORM_WINDOWS
+        g_logger.thread_buffer_key = FlsAlloc(thread_buffer_release);
+        g_logger.thread_buffer_key_created = g_logger.thread_buffer_key != FLS_OUT_OF_INDEXES;
+#endif
+    }
+
     g_logger.initialized = true;
 
+    /* Fall back to synchronous logging if the writer can't be started */
+    g_logger.async = false;
+    if (g_logger.config.async && !start_writer()) {
+        fprintf(stderr, "Failed to start log writer thread, logging synchronously\n");
+    }
+
     /* Log initialization message */
     ve_logger_log(VE_LOG_INFO, __FILE__, __LINE__, __func__, "Logger initialized");
 
@@ -176,6 +340,9 @@ void ve_logger_shutdown(void) {
         return;
     }
 
+    /* Let the writer drain the queue before the targets go away */
+    stop_writer();
+
     lock_logger();
     flush_buffer();
 
@@ -224,21 +391,126 @@ void ve_logger_log_va(ve_log_level level, const char* file, int line, const char
         return;
     }
 
+    ve_log_record record = {
+        .level = level,
+        .line = line,
+        .file = file,
+        .func = func,
+        .thread_id = g_logger.config.thread_ids ? get_thread_id() : 0,
+        .time = g_logger.config.timestamps ? time(NULL) : 0,
+        .timestamp = g_logger.async ? get_monotonic_ns() : 0,
+    };
+
+    /* Only the user message is formatted here; the writer adds the rest */
+    char text[VE_MAX_LOG_MESSAGE_SIZE];
+    int length = vsnprintf(text, sizeof(text), fmt, args);
+    if (length < 0) {
+        return;
+    }
+    record.length = (size_t)length < sizeof(text) ? (size_t)length : sizeof(text) - 1;
+
+    /* The writer itself and messages too large for a cell bypass the queue;
+       flushing first keeps them in order */
+    bool queued = false;
+    if (g_logger.async && !t_is_log_writer) {
+        if (record.length < VE_LOG_QUEUE_TEXT_SIZE) {
+            if (!enqueue_record(&record, text)) {
+                return;  /* Dropped */
+            }
+            queued = true;
+        } else {
+            ve_logger_flush();
+        }
+    }
+
+    if (!queued) {
+        lock_logger();
+        write_record(&record, text);
+        unlock_logger();
+    }
+
+    /* Flush for fatal errors */
+    if (level >= VE_LOG_ERROR) {
+        ve_logger_flush();
+    }
+}
+
+void ve_logger_log_site(ve_log_site* site, ve_log_level level, const char* fmt, ...) {
+    if (!ve_logger_should_log(level) || !g_logger.initialized) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, fmt);
+
+    bool dropped = false;
+    if (g_logger.deferred && !t_is_log_writer && log_deferred(site, level, fmt, args, &dropped)) {
+        if (!dropped && level >= VE_LOG_ERROR) {
+            ve_logger_flush();
+        }
+    } else {
+        ve_logger_log_va(level, site->file, site->line, site->func, fmt, args);
+    }
+
+    va_end(args);
+}
+
+size_t ve_logger_get_dropped_count(void) {
+    return (size_t)ve_atomic_load64(&g_logger.dropped);
+}
+
+void ve_logger_flush(void) {
+    if (!g_logger.initialized) {
+        return;
+    }
+
+    /* Wait for everything queued so far to reach the targets */
+    if (g_logger.async && !t_is_log_writer) {
+        int64_t target = ve_atomic_load64(&g_logger.enqueue_pos);
+        while (ve_atomic_load64(&g_logger.written) < target) {
+            wake_writer();
+            ve_thread_yield();
+        }
+
+        ve_log_thread_buffer* buffer = (ve_log_thread_buffer*)ve_atomic_load_ptr(&g_logger.thread_buffers);
+        for (; buffer; buffer = buffer->next) {
+            int64_t head = ve_atomic_load64(&buffer->head);
+            while (ve_atomic_load64(&buffer->tail) < head) {
+                wake_writer();
+                ve_thread_yield();
+            }
+        }
+    }
+
     lock_logger();
+    flush_buffer();
+
+    if (g_logger.log_file) {
+        fflush(g_logger.log_file);
+    }
+
+    fflush(stdout);
+    unlock_logger();
+}
 
+/* Helper functions */
+
+/* Format a record and send it to every target. Caller holds the output lock. */
+static void write_record(const ve_log_record* record, const char* text) {
     char message[VE_MAX_LOG_MESSAGE_SIZE];
     int pos = 0;
+    ve_log_level level = record->level;
 
     /* Build message header */
     if (g_logger.config.timestamps) {
         char timestamp[64];
-        get_timestamp(timestamp, sizeof(timestamp));
+        get_timestamp(record->time, timestamp, sizeof(timestamp));
         pos += snprintf(message + pos, VE_MAX_LOG_MESSAGE_SIZE - pos, "[%s] ", timestamp);
     }
 
     /* Thread ID */
     if (g_logger.config.thread_ids) {
-        pos += snprintf(message + pos, VE_MAX_LOG_MESSAGE_SIZE - pos, "[%lu] ", get_thread_id());
+        pos += snprintf(message + pos, VE_MAX_LOG_MESSAGE_SIZE - pos, "[%lu] ", record->thread_id);
     }
 
     /* Level and color info for console */
@@ -248,17 +520,20 @@ void ve_logger_log_va(ve_log_level level, const char* file, int line, const char
     /* Source location (optional, can be made configurable) */
     if (level >= VE_LOG_ERROR) {
         pos += snprintf(message + pos, VE_MAX_LOG_MESSAGE_SIZE - pos,
-            "[%s:%d:%s] ", basename(file), line, func);
+            "[%s:%d:%s] ", basename(record->file), record->line, record->func);
     }
 
     /* User message */
-    pos += vsnprintf(message + pos, VE_MAX_LOG_MESSAGE_SIZE - pos, fmt, args);
-
-    /* Add newline */
     if (pos < VE_MAX_LOG_MESSAGE_SIZE - 1) {
-        message[pos] = '\n';
-        message[pos + 1] = '\0';
+        pos += snprintf(message + pos, VE_MAX_LOG_MESSAGE_SIZE - pos, "%.*s", (int)record->length, text);
     }
+    if (pos > VE_MAX_LOG_MESSAGE_SIZE - 2) {
+        pos = VE_MAX_LOG_MESSAGE_SIZE - 2;
+    }
+
+    /* Add newline */
+    message[pos] = '\n';
+    message[pos + 1] = '\0';
 
     /* Output to console */
     if (g_logger.config.targets & VE_LOG_TARGET_CONSOLE) {
@@ -299,32 +574,682 @@ void ve_logger_log_va(ve_log_level level, const char* file, int line, const char
         OutputDebugStringA("\n");
     }
 #endif
+}
 
-    unlock_logger();
+/* Deferred formatting */
 
-    /* Flush for fatal errors */
-    if (level >= VE_LOG_ERROR) {
-        ve_logger_flush();
+static void parse_format(const char* fmt, ve_log_format* format) {
+    memset(format, 0, sizeof(ve_log_format));
+    format->fmt = fmt;
+    format->deferrable = strlen(fmt) <= UINT16_MAX;
+
+    size_t literal = 0;
+    size_t i = 0;
+    while (format->deferrable && fmt[i]) {
+        if (fmt[i] != '%') {
+            i++;
+            continue;
+        }
+        if (format->spec_count == VE_LOG_MAX_SPECS) {
+            format->deferrable = false;
+            break;
+        }
+
+        ve_log_spec* spec = &format->specs[format->spec_count];
+        size_t start = i++;
+
+        if (fmt[i] == '%') {
+            i++;  /* Literal percent, no argument */
+        } else {
+            /* Flags, width, precision */
+            while (fmt[i] && strchr("-+ #0'", fmt[i])) {
+                i++;
+            }
+            if (fmt[i] == '*') {
+                spec->types[spec->arg_count++] = VE_LOG_ARG_INT;
+                i++;
+            }
+            while (fmt[i] >= '0' && fmt[i] <= '9') {
+                i++;
+            }
+            if (fmt[i] == '.') {
+                i++;
+                if (fmt[i] == '*') {
+                    spec->types[spec->arg_count++] = VE_LOG_ARG_INT;
+                    i++;
+                }
+                while (fmt[i] >= '0' && fmt[i] <= '9') {
+                    i++;
+                }
+            }
+
+            /* Length modifier */
+            char modifier = 0;
+            bool doubled = false;
+            if (fmt[i] && strchr("hlzjtL", fmt[i])) {
+                modifier = fmt[i++];
+                if ((modifier == 'h' || modifier == 'l') && fmt[i] == modifier) {
+                    doubled = true;
+                    i++;
+                }
+            }
+
+            ve_log_arg_type type = VE_LOG_ARG_INT;
+            char conversion = fmt[i];
+            if (conversion) {
+                i++;
+            }
+            switch (conversion) {
+                case 'd': case 'i': case 'u': case 'x': case 'X': case 'o':
+                    switch (modifier) {
+                        case 'l': type = doubled ? VE_LOG_ARG_LLONG : VE_LOG_ARG_LONG; break;
+                        case 'z': type = VE_LOG_ARG_SIZE; break;
+                        case 'j': type = VE_LOG_ARG_INTMAX; break;
+                        case 't': type = VE_LOG_ARG_PTRDIFF; break;
+                        case 'L': format->deferrable = false; break;
+                        default: type = VE_LOG_ARG_INT; break;
+                    }
+                    break;
+                case 'c':
+                    format->deferrable = modifier == 0;
+                    type = VE_LOG_ARG_INT;
+                    break;
+                case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                    format->deferrable = modifier != 'L';
+                    type = VE_LOG_ARG_DOUBLE;
+                    break;
+                case 's':
+                    format->deferrable = modifier == 0;
+                    type = VE_LOG_ARG_STRING;
+                    break;
+                case 'p':
+                    type = VE_LOG_ARG_POINTER;
+                    break;
+                default:
+                    format->deferrable = false;  /* %n, wide or unknown conversions */
+                    break;
+            }
+            spec->types[spec->arg_count++] = (uint8_t)type;
+        }
+
+        if (i - start > VE_LOG_MAX_SPEC_LENGTH) {
+            format->deferrable = false;
+        }
+        spec->literal_start = (uint16_t)literal;
+        spec->start = (uint16_t)start;
+        spec->length = (uint8_t)(i - start);
+        format->arg_count += spec->arg_count;
+        format->spec_count++;
+        literal = i;
     }
+
+    format->tail_start = (uint16_t)literal;
 }
 
-void ve_logger_flush(void) {
-    if (!g_logger.initialized) {
-        return;
+static const ve_log_format* get_site_format(ve_log_site* site, const char* fmt) {
+    ve_log_format* format = (ve_log_format*)ve_atomic_load_ptr(&site->format);
+    if (format) {
+        /* A site with a non-literal format can see different strings */
+        return format->fmt == fmt ? format : NULL;
+    }
+
+    /* Plain malloc: formats live as long as their (static) site */
+    format = (ve_log_format*)malloc(sizeof(ve_log_format));
+    if (!format) {
+        return NULL;
+    }
+    parse_format(fmt, format);
+
+    void* expected = NULL;
+    if (!ve_atomic_compare_exchange_ptr(&site->format, &expected, format)) {
+        free(format);
+        format = (ve_log_format*)expected;
+    }
+    return format->fmt == fmt ? format : NULL;
+}
+
+#ifdef VE_PLATFORM_WINDOWS
+static void WINAPI thread_buffer_release(void* ptr) {
+#else
+static void thread_buffer_release(void* ptr) {
+#endif
+    if (ptr) {
+        ve_atomic_store32(&((ve_log_thread_buffer*)ptr)->abandoned, 1);
+    }
+}
+
+static ve_log_thread_buffer* get_thread_buffer(void) {
+    if (t_log_buffer) {
+        return t_log_buffer;
+    }
+
+    /* Reuse a buffer whose thread has exited */
+    ve_log_thread_buffer* buffer = (ve_log_thread_buffer*)ve_atomic_load_ptr(&g_logger.thread_buffers);
+    for (; buffer; buffer = buffer->next) {
+        int32_t expected = 1;
+        if (ve_atomic_compare_exchange32(&buffer->abandoned, &expected, 0)) {
+            break;
+        }
+    }
+
+    if (!buffer) {
+        buffer = (ve_log_thread_buffer*)malloc(sizeof(ve_log_thread_buffer));
+        if (!buffer) {
+            return NULL;
+        }
+        ve_atomic_store64(&buffer->head, 0);
+        ve_atomic_store64(&buffer->tail, 0);
+        ve_atomic_store32(&buffer->abandoned, 0);
+
+        void* head = ve_atomic_load_ptr(&g_logger.thread_buffers);
+        do {
+            buffer->next = (ve_log_thread_buffer*)head;
+        } while (!ve_atomic_compare_exchange_ptr(&g_logger.thread_buffers, &head, buffer));
+    }
+
+    buffer->thread_id = get_thread_id();
+#ifdef VE_PLATFORM_UNIX
+    pthread_setspecific(g_logger.thread_buffer_key, buffer);
+#endif
+#ifdef VE_PLATFORM_WINDOWS
+    FlsSetValue(g_logger.thread_buffer_key, buffer);
+#endif
+    t_log_buffer = buffer;
+    return buffer;
+}
+
+/* Oldest record in a buffer, skipping wrap padding. Writer thread only. */
+static ve_log_deferred_header* buffer_peek(ve_log_thread_buffer* buffer) {
+    int64_t head = ve_atomic_load64(&buffer->head);
+    int64_t tail = ve_atomic_load64(&buffer->tail);
+
+    while (tail != head) {
+        ve_log_deferred_header* header = (ve_log_deferred_header*)
+            (buffer->data + ((uint64_t)tail & (VE_LOG_THREAD_BUFFER_SIZE - 1)));
+        if (header->level != VE_LOG_OFF) {
+            return header;
+        }
+        tail += header->size;
+        ve_atomic_store64(&buffer->tail, tail);
+    }
+    return NULL;
+}
+
+static size_t deferred_record_size(const ve_log_format* format, va_list args, size_t* lengths) {
+    size_t size = sizeof(ve_log_deferred_header);
+    uint32_t strings = 0;
+
+    for (uint32_t s = 0; s < format->spec_count; s++) {
+        const ve_log_spec* spec = &format->specs[s];
+        for (uint32_t a = 0; a < spec->arg_count; a++) {
+            size += sizeof(uint64_t);
+            switch (spec->types[a]) {
+                case VE_LOG_ARG_INT: (void)va_arg(args, int); break;
+                case VE_LOG_ARG_LONG: (void)va_arg(args, long); break;
+                case VE_LOG_ARG_LLONG: (void)va_arg(args, long long); break;
+                case VE_LOG_ARG_SIZE: (void)va_arg(args, size_t); break;
+                case VE_LOG_ARG_INTMAX: (void)va_arg(args, intmax_t); break;
+                case VE_LOG_ARG_PTRDIFF: (void)va_arg(args, ptrdiff_t); break;
+                case VE_LOG_ARG_DOUBLE: (void)va_arg(args, double); break;
+                case VE_LOG_ARG_POINTER: (void)va_arg(args, void*); break;
+                case VE_LOG_ARG_STRING: {
+                    const char* str = va_arg(args, const char*);
+                    size_t length = str ? strlen(str) : 0;
+                    lengths[strings++] = length;
+                    size += (length + 1 + 7) & ~(size_t)7;
+                    break;
+                }
+            }
+        }
+    }
+    return size;
+}
+
+static void write_deferred_args(const ve_log_format* format, va_list args, const size_t* lengths, uint8_t* out) {
+    uint32_t strings = 0;
+
+    for (uint32_t s = 0; s < format->spec_count; s++) {
+        const ve_log_spec* spec = &format->specs[s];
+        for (uint32_t a = 0; a < spec->arg_count; a++) {
+            uint64_t slot = 0;
+            switch (spec->types[a]) {
+                case VE_LOG_ARG_INT: { int64_t v = va_arg(args, int); memcpy(&slot, &v, sizeof(v)); break; }
+                case VE_LOG_ARG_LONG: { int64_t v = va_arg(args, long); memcpy(&slot, &v, sizeof(v)); break; }
+                case VE_LOG_ARG_LLONG: { long long v = va_arg(args, long long); memcpy(&slot, &v, sizeof(v)); break; }
+                case VE_LOG_ARG_SIZE: slot = (uint64_t)va_arg(args, size_t); break;
+                case VE_LOG_ARG_INTMAX: { int64_t v = (int64_t)va_arg(args, intmax_t); memcpy(&slot, &v, sizeof(v)); break; }
+                case VE_LOG_ARG_PTRDIFF: { int64_t v = (int64_t)va_arg(args, ptrdiff_t); memcpy(&slot, &v, sizeof(v)); break; }
+                case VE_LOG_ARG_DOUBLE: { double v = va_arg(args, double); memcpy(&slot, &v, sizeof(v)); break; }
+                case VE_LOG_ARG_POINTER: slot = (uint64_t)(uintptr_t)va_arg(args, void*); break;
+                case VE_LOG_ARG_STRING: {
+                    const char* str = va_arg(args, const char*);
+                    size_t length = lengths[strings++];
+                    slot = str ? (uint64_t)length : UINT64_MAX;
+                    memcpy(out, &slot, sizeof(slot));
+                    out += sizeof(slot);
+                    if (str) {
+                        memcpy(out, str, length);
+                    }
+                    out[length] = '\0';
+                    out += (length + 1 + 7) & ~(size_t)7;
+                    continue;
+                }
+            }
+            memcpy(out, &slot, sizeof(slot));
+            out += sizeof(slot);
+        }
+    }
+}
+
+/* Capture a message into the calling thread's buffer. Returns false if the
+   message has to be formatted immediately instead. */
+static bool log_deferred(ve_log_site* site, ve_log_level level, const char* fmt, va_list args, bool* dropped) {
+    *dropped = false;
+
+    const ve_log_format* format = get_site_format(site, fmt);
+    if (!format || !format->deferrable) {
+        return false;
+    }
+    ve_log_thread_buffer* buffer = get_thread_buffer();
+    if (!buffer) {
+        return false;
+    }
+
+    size_t lengths[VE_LOG_MAX_SPECS];
+    va_list measure;
+    va_copy(measure, args);
+    size_t size = deferred_record_size(format, measure, lengths);
+    va_end(measure);
+    if (size > VE_LOG_MAX_DEFERRED_RECORD) {
+        return false;
+    }
+
+    /* Wait for room, or drop, like the shared queue */
+    bool may_drop = g_logger.config.overflow_policy == VE_LOG_OVERFLOW_DROP && level < VE_LOG_WARN;
+    int64_t head = ve_atomic_load64(&buffer->head);
+    size_t offset = (size_t)((uint64_t)head & (VE_LOG_THREAD_BUFFER_SIZE - 1));
+    size_t wrap = offset + size > VE_LOG_THREAD_BUFFER_SIZE ? VE_LOG_THREAD_BUFFER_SIZE - offset : 0;
+    while ((uint64_t)(head + (int64_t)(wrap + size) - ve_atomic_load64(&buffer->tail)) > VE_LOG_THREAD_BUFFER_SIZE) {
+        if (may_drop) {
+            ve_atomic_fetch_add64(&g_logger.dropped, 1);
+            *dropped = true;
+            return true;
+        }
+        wake_writer();
+        ve_thread_yield();
+    }
+
+    if (wrap) {
+        ve_log_deferred_header* padding = (ve_log_deferred_header*)(buffer->data + offset);
+        padding->size = (uint32_t)wrap;
+        padding->level = VE_LOG_OFF;
+        head += (int64_t)wrap;
+        offset = 0;
+    }
+
+    ve_log_deferred_header* header = (ve_log_deferred_header*)(buffer->data + offset);
+    header->size = (uint32_t)size;
+    header->level = (uint32_t)level;
+    header->site = site;
+    header->format = format;
+    header->timestamp = get_monotonic_ns();
+    header->thread_id = buffer->thread_id;
+
+    va_list copy;
+    va_copy(copy, args);
+    write_deferred_args(format, copy, lengths, (uint8_t*)(header + 1));
+    va_end(copy);
+
+    ve_atomic_store64(&buffer->head, head + (int64_t)size);
+    wake_writer();
+    return true;
+}
+
+/* Rebuild the message text on the writer thread */
+static size_t format_deferred(const ve_log_deferred_header* header, char* out, size_t capacity) {
+    const ve_log_format* format = header->format;
+    const char* fmt = format->fmt;
+    const uint8_t* arg = (const uint8_t*)(header + 1);
+    size_t pos = 0;
+
+    for (uint32_t s = 0; s < format->spec_count; s++) {
+        const ve_log_spec* spec = &format->specs[s];
+
+        size_t literal = spec->start - spec->literal_start;
+        if (literal > capacity - 1 - pos) {
+            literal = capacity - 1 - pos;
+        }
+        memcpy(out + pos, fmt + spec->literal_start, literal);
+        pos += literal;
+
+        if (spec->arg_count == 0) {
+            if (pos < capacity - 1) {
+                out[pos++] = '%';
+            }
+            continue;
+        }
+
+        char conversion[VE_LOG_MAX_SPEC_LENGTH + 1];
+        memcpy(conversion, fmt + spec->start, spec->length);
+        conversion[spec->length] = '\0';
+
+        /* Leading '*' arguments, then the value */
+        int stars[2] = {0, 0};
+        uint32_t star_count = spec->arg_count - 1;
+        for (uint32_t a = 0; a < star_count; a++) {
+            int64_t value;
+            memcpy(&value, arg, sizeof(value));
+            stars[a] = (int)value;
+            arg += sizeof(uint64_t);
+        }
+
+        uint64_t slot;
+        memcpy(&slot, arg, sizeof(slot));
+        arg += sizeof(uint64_t);
+
+        char* dst = out + pos;
+        size_t room = capacity - pos;
+        int written = 0;
+
+#define VE_LOG_FORMAT_VALUE(value) \
+    (star_count == 0 ? snprintf(dst, room, conversion, value) : \
+     star_count == 1 ? snprintf(dst, room, conversion, stars[0], value) : \
+                       snprintf(dst, room, conversion, stars[0], stars[1], value))
+
+        switch (spec->types[star_count]) {
+            case VE_LOG_ARG_INT: { int64_t v; memcpy(&v, &slot, sizeof(v)); written = VE_LOG_FORMAT_VALUE((int)v); break; }
+            case VE_LOG_ARG_LONG: { int64_t v; memcpy(&v, &slot, sizeof(v)); written = VE_LOG_FORMAT_VALUE((long)v); break; }
+            case VE_LOG_ARG_LLONG: { long long v; memcpy(&v, &slot, sizeof(v)); written = VE_LOG_FORMAT_VALUE(v); break; }
+            case VE_LOG_ARG_SIZE: written = VE_LOG_FORMAT_VALUE((size_t)slot); break;
+            case VE_LOG_ARG_INTMAX: { int64_t v; memcpy(&v, &slot, sizeof(v)); written = VE_LOG_FORMAT_VALUE((intmax_t)v); break; }
+            case VE_LOG_ARG_PTRDIFF: { int64_t v; memcpy(&v, &slot, sizeof(v)); written = VE_LOG_FORMAT_VALUE((ptrdiff_t)v); break; }
+            case VE_LOG_ARG_DOUBLE: { double v; memcpy(&v, &slot, sizeof(v)); written = VE_LOG_FORMAT_VALUE(v); break; }
+            case VE_LOG_ARG_POINTER: written = VE_LOG_FORMAT_VALUE((void*)(uintptr_t)slot); break;
+            case VE_LOG_ARG_STRING: {
+                const char* str = slot == UINT64_MAX ? "(null)" : (const char*)arg;
+                written = VE_LOG_FORMAT_VALUE(str);
+                if (slot != UINT64_MAX) {
+                    arg += (slot + 1 + 7) & ~(uint64_t)7;
+                }
+                break;
+            }
+        }
+
+#undef VE_LOG_FORMAT_VALUE
+
+        if (written > 0) {
+            pos += (size_t)written < room ? (size_t)written : room - 1;
+        }
+    }
+
+    size_t tail = strlen(fmt + format->tail_start);
+    if (tail > capacity - 1 - pos) {
+        tail = capacity - 1 - pos;
+    }
+    memcpy(out + pos, fmt + format->tail_start, tail);
+    pos += tail;
+    out[pos] = '\0';
+    return pos;
+}
+
+/* Format and write one deferred record. Caller holds the output lock. */
+static void write_deferred(const ve_log_deferred_header* header) {
+    char text[VE_MAX_LOG_MESSAGE_SIZE];
+    ve_log_record record = {
+        .level = (ve_log_level)header->level,
+        .line = header->site->line,
+        .file = header->site->file,
+        .func = header->site->func,
+        .thread_id = (unsigned long)header->thread_id,
+        .time = g_logger.base_time + (time_t)((header->timestamp - g_logger.base_timestamp) / 1000000000ull),
+        .timestamp = header->timestamp,
+    };
+    record.length = format_deferred(header, text, sizeof(text));
+    write_record(&record, text);
+}
+
+static uint64_t get_monotonic_ns(void) {
+#ifdef VE_PLATFORM_WINDOWS
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    uint64_t frequency = (uint64_t)g_logger.counter_frequency.QuadPart;
+    return ((uint64_t)counter.QuadPart / frequency) * 1000000000ull +
+           ((uint64_t)counter.QuadPart % frequency) * 1000000000ull / frequency;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/* Asynchronous writer */
+
+static void wake_writer(void) {
+    int32_t expected = 1;
+    if (ve_atomic_load32(&g_logger.writer_sleeping) == 1 &&
+        ve_atomic_compare_exchange32(&g_logger.writer_sleeping, &expected, 0)) {
+        ve_semaphore_signal(g_logger.wake);
+    }
+}
+
+static bool enqueue_record(const ve_log_record* record, const char* text) {
+    /* Warnings and errors always wait for room */
+    bool may_drop = g_logger.config.overflow_policy == VE_LOG_OVERFLOW_DROP && record->level < VE_LOG_WARN;
+
+    int64_t pos = ve_atomic_load64(&g_logger.enqueue_pos);
+    ve_log_cell* cell;
+    for (;;) {
+        cell = &g_logger.cells[(uint64_t)pos & g_logger.cell_mask];
+        int64_t diff = ve_atomic_load64(&cell->sequence) - pos;
+
+        if (diff == 0) {
+            if (ve_atomic_compare_exchange64(&g_logger.enqueue_pos, &pos, pos + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* Queue full */
+            if (may_drop) {
+                ve_atomic_fetch_add64(&g_logger.dropped, 1);
+                return false;
+            }
+            wake_writer();
+            ve_thread_yield();
+            pos = ve_atomic_load64(&g_logger.enqueue_pos);
+        } else {
+            pos = ve_atomic_load64(&g_logger.enqueue_pos);
+        }
+    }
+
+    cell->record = *record;
+    memcpy(cell->text, text, record->length);
+    ve_atomic_store64(&cell->sequence, pos + 1);
+
+    wake_writer();
+    return true;
+}
+
+/* Write every ready cell; returns the number written */
+static uint32_t drain_queue(void) {
+    uint32_t count = 0;
+    bool locked = false;
+
+    uint32_t queued = 0;
+
+    /* Merge the shared queue and the thread buffers by timestamp */
+    for (;;) {
+        ve_log_cell* cell = &g_logger.cells[g_logger.dequeue_pos & g_logger.cell_mask];
+        bool cell_ready = ve_atomic_load64(&cell->sequence) == (int64_t)(g_logger.dequeue_pos + 1);
+        bool found = cell_ready;
+        uint64_t oldest = cell_ready ? cell->record.timestamp : 0;
+
+        ve_log_thread_buffer* best = NULL;
+        ve_log_deferred_header* best_header = NULL;
+        ve_log_thread_buffer* buffer = (ve_log_thread_buffer*)ve_atomic_load_ptr(&g_logger.thread_buffers);
+        for (; buffer; buffer = buffer->next) {
+            ve_log_deferred_header* header = buffer_peek(buffer);
+            if (header && (!found || header->timestamp < oldest)) {
+                found = true;
+                oldest = header->timestamp;
+                best = buffer;
+                best_header = header;
+            }
+        }
+
+        if (!found) {
+            break;
+        }
+
+        if (!locked) {
+            lock_logger();
+            locked = true;
+        }
+
+        if (best) {
+            write_deferred(best_header);
+            ve_atomic_store64(&best->tail, ve_atomic_load64(&best->tail) + best_header->size);
+        } else {
+            write_record(&cell->record, cell->text);
+            ve_atomic_store64(&cell->sequence, (int64_t)(g_logger.dequeue_pos + g_logger.cell_mask + 1));
+            g_logger.dequeue_pos++;
+            queued++;
+        }
+        count++;
+    }
+
+    int64_t dropped = ve_atomic_load64(&g_logger.dropped);
+    if (dropped != g_logger.dropped_reported) {
+        char text[128];
+        ve_log_record record = {
+            .level = VE_LOG_WARN,
+            .file = __FILE__,
+            .line = __LINE__,
+            .func = __func__,
+            .time = time(NULL),
+        };
+        record.length = (size_t)snprintf(text, sizeof(text), "Log queue full, dropped %lld messages",
+                                         (long long)(dropped - g_logger.dropped_reported));
+        g_logger.dropped_reported = dropped;
+
+        if (!locked) {
+            lock_logger();
+            locked = true;
+        }
+        write_record(&record, text);
+    }
+
+    if (locked) {
+        unlock_logger();
+        ve_atomic_fetch_add64(&g_logger.written, queued);
+    }
+    return count;
+}
+
+static void* writer_thread(void* user_data) {
+    (void)user_data;
+    t_is_log_writer = true;
+
+    for (;;) {
+        if (drain_queue() > 0) {
+            continue;
+        }
+        if (ve_atomic_load32(&g_logger.shutdown)) {
+            break;
+        }
+
+        /* Announce the sleep, then re-check so a producer that missed the
+           flag is still seen */
+        ve_atomic_store32(&g_logger.writer_sleeping, 1);
+        if (drain_queue() > 0 || ve_atomic_load32(&g_logger.shutdown)) {
+            int32_t expected = 1;
+            if (!ve_atomic_compare_exchange32(&g_logger.writer_sleeping, &expected, 0)) {
+                ve_semaphore_wait(g_logger.wake, VE_LOG_WRITER_IDLE_MS);  /* Consume the wakeup */
+            }
+            continue;
+        }
+
+        if (!ve_semaphore_wait(g_logger.wake, VE_LOG_WRITER_IDLE_MS)) {
+            int32_t expected = 1;
+            if (!ve_atomic_compare_exchange32(&g_logger.writer_sleeping, &expected, 0)) {
+                ve_semaphore_wait(g_logger.wake, VE_LOG_WRITER_IDLE_MS);
+            }
+        }
     }
 
     lock_logger();
     flush_buffer();
+    unlock_logger();
+    return NULL;
+}
 
-    if (g_logger.log_file) {
-        fflush(g_logger.log_file);
+static bool start_writer(void) {
+    size_t capacity = g_logger.config.queue_capacity ? g_logger.config.queue_capacity : VE_LOG_QUEUE_DEFAULT_CAPACITY;
+    size_t rounded = 2;
+    while (rounded < capacity) {
+        rounded <<= 1;
     }
 
-    fflush(stdout);
-    unlock_logger();
+    /* Plain malloc: the memory system logs through us */
+    g_logger.cells = (ve_log_cell*)malloc(rounded * sizeof(ve_log_cell));
+    if (!g_logger.cells) {
+        return false;
+    }
+    for (size_t i = 0; i < rounded; i++) {
+        ve_atomic_store64(&g_logger.cells[i].sequence, (int64_t)i);
+    }
+
+    g_logger.cell_mask = rounded - 1;
+    g_logger.dequeue_pos = 0;
+    g_logger.dropped_reported = 0;
+    ve_atomic_store64(&g_logger.enqueue_pos, 0);
+    ve_atomic_store64(&g_logger.written, 0);
+    ve_atomic_store64(&g_logger.dropped, 0);
+    ve_atomic_store32(&g_logger.writer_sleeping, 0);
+    ve_atomic_store32(&g_logger.shutdown, 0);
+
+    g_logger.wake = ve_semaphore_create(0, 1);
+    if (!g_logger.wake) {
+        free(g_logger.cells);
+        g_logger.cells = NULL;
+        return false;
+    }
+
+    /* Producers may see async before the writer runs; they just queue */
+    g_logger.deferred = g_logger.config.deferred_format && g_logger.thread_buffer_key_created;
+    g_logger.async = true;
+    g_logger.writer = ve_thread_create(writer_thread, NULL, "log_writer");
+    if (!g_logger.writer) {
+        g_logger.async = false;
+        g_logger.deferred = false;
+        ve_semaphore_destroy(g_logger.wake);
+        g_logger.wake = NULL;
+        free(g_logger.cells);
+        g_logger.cells = NULL;
+        return false;
+    }
+
+    return true;
 }
 
-/* Helper functions */
+static void stop_writer(void) {
+    if (!g_logger.async) {
+        return;
+    }
+
+    ve_atomic_store32(&g_logger.shutdown, 1);
+    ve_semaphore_signal(g_logger.wake);
+    ve_thread_join(g_logger.writer);
+    g_logger.writer = NULL;
+
+    /* Late messages from other threads go straight to the targets */
+    g_logger.deferred = false;
+    g_logger.async = false;
+    drain_queue();
+
+    ve_semaphore_destroy(g_logger.wake);
+    g_logger.wake = NULL;
+    free(g_logger.cells);
+    g_logger.cells = NULL;
+}
 static void lock_logger(void) {
 #ifdef VE_PLATFORM_UNIX
     pthread_mutex_lock(&g_logger.mutex);
@@ -411,8 +1336,7 @@ static void reset_terminal_color(void) {
     printf("\033[0m");
 }
 
-static const char* get_timestamp(char* buffer, size_t size) {
-    time_t now = time(NULL);
+static const char* get_timestamp(time_t now, char* buffer, size_t size) {
     struct tm* tm_info = localtime(&now);
     strftime(buffer, size, "%Y-%m-%d %H:%M:%S", tm_info);
     return buffer;
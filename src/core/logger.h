@@ -8,6 +8,9 @@
 
 #include <stdbool.h>
 #include <stdarg.h>
+#include <stddef.h>
+
+#include "thread.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -58,6 +61,14 @@ typedef enum ve_log_color {
     VE_COLOR_BRIGHT_WHITE   = 97,
 } ve_log_color;
 
+/**
+ * @brief What an asynchronous logger does when its queue is full
+ */
+typedef enum ve_log_overflow_policy {
+    VE_LOG_OVERFLOW_BLOCK = 0,  /* Wait for the writer thread to make room */
+    VE_LOG_OVERFLOW_DROP,       /* Discard the message (below VE_LOG_WARN only) */
+} ve_log_overflow_policy;
+
 /**
  * @brief Logger configuration
  */
@@ -70,8 +81,25 @@ typedef struct ve_logger_config {
     const char* file_pattern;     /* Log file pattern (e.g., "logs/engine_%Y%m%d.log") */
     size_t max_file_size;         /* Max size per log file in bytes (0 = unlimited) */
     int max_files;                /* Max number of rotated log files (0 = no rotation) */
+    bool async;                   /* Hand messages to a background writer thread */
+    size_t queue_capacity;        /* Messages the async queue holds (0 = default) */
+    ve_log_overflow_policy overflow_policy; /* Behaviour when the async queue is full */
+    bool deferred_format;         /* Record raw arguments, the writer formats them (async only) */
 } ve_logger_config;
 
+/**
+ * @brief Static description of a log call site
+ *
+ * One is emitted per VE_LOG_* use. format caches the parsed format string
+ * the first time the site logs in deferred mode.
+ */
+typedef struct ve_log_site {
+    const char* file;
+    int line;
+    const char* func;
+    ve_atomic_ptr format;
+} ve_log_site;
+
 /**
  * @brief Initialize the logging system
  *
@@ -131,16 +159,41 @@ void ve_logger_log(ve_log_level level, const char* file, int line, const char* f
  */
 void ve_logger_log_va(ve_log_level level, const char* file, int line, const char* func, const char* fmt, va_list args);
 
+/**
+ * @brief Log from a static call site
+ *
+ * Used by the VE_LOG_* macros. In deferred mode the arguments are copied
+ * as raw bytes into a per-thread buffer and formatted on the writer thread;
+ * otherwise this behaves like ve_logger_log.
+ *
+ * @param site Call site description
+ * @param level Log level
+ * @param fmt Format string
+ * @param ... Format arguments
+ */
+void ve_logger_log_site(ve_log_site* site, ve_log_level level, const char* fmt, ...);
+
 /**
  * @brief Flush any buffered log output
+ *
+ * In asynchronous mode this waits until the writer thread has written every
+ * message queued before the call.
  */
 void ve_logger_flush(void);
 
+/**
+ * @brief Get the number of messages dropped because the async queue was full
+ *
+ * @return Dropped message count since ve_logger_init
+ */
+size_t ve_logger_get_dropped_count(void);
+
 /* Convenience macros with file/line/function info */
 #define VE_LOG_HELPER(level, ...) \
     do { \
         if (ve_logger_should_log(level)) { \
-            ve_logger_log(level, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+            static ve_log_site ve_log_site_ = { __FILE__, __LINE__, __func__, { NULL } }; \
+            ve_logger_log_site(&ve_log_site_, level, __VA_ARGS__); \
         } \
     } while (0)
 
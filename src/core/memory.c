@@ -1,12 +1,23 @@
 /**
  * @file memory.c
  * @brief Memory allocation and tracking implementation
+ *
+ * ve_allocate is backed by a size-class allocator. Each thread owns a heap of
+ * slabs, one list per size class. A slab is a VE_SLAB_SIZE-aligned block
+ * carved into equal-sized blocks. Frees from the owning thread go back to the
+ * slab's local free list. Frees from other threads are pushed onto the slab's
+ * atomic remote list, which the owner collects when it runs out of blocks.
+ * Requests above VE_SMALL_SIZE_MAX are mapped straight from the OS.
+ *
+ * With VE_MEMORY_TRACKING defined, every allocation carries a
+ * ve_allocation_header and is linked into a sharded live list for leak reports.
  */
 
 #define _CRT_SECURE_NO_WARNINGS
 #include "memory.h"
 #include "logger.h"
 #include "assert.h"
+#include "thread.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -14,13 +25,38 @@
 
 #if defined(_WIN32) || defined(_WIN64)
     #include <windows.h>
+    #include <intrin.h>
+    #define THREAD_LOCAL __declspec(thread)
 #else
     #include <pthread.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+    #define THREAD_LOCAL __thread
 #endif
 
 #define VE_MEMORY_ALIGNMENT 16
-#define VE_THREAD_ARENA_SIZE (1024 * 1024)  /* 1MB per thread */
-
+#define VE_THREAD_ARENA_RESERVE_SIZE ((size_t)256 * 1024 * 1024)  /* Address space per thread */
+#define VE_ARENA_COMMIT_SIZE ((size_t)64 * 1024)     /* Commit granularity of virtual arenas */
+#define VE_ARENA_MIN_BLOCK_SIZE ((size_t)64 * 1024)  /* First block of chained arenas */
+#define VE_MEMORY_TRACKING_SHARD_BITS 6
+#define VE_MEMORY_TRACKING_SHARDS (1 << VE_MEMORY_TRACKING_SHARD_BITS)
+
+/* Size-class allocator configuration */
+#define VE_SLAB_SIZE ((size_t)256 * 1024)       /* Slabs are aligned to their size */
+#define VE_SMALL_SIZE_MAX ((size_t)32 * 1024)   /* Larger requests go straight to the OS */
+#define VE_SIZE_CLASS_COUNT 40                  /* 16..128 by 16, then 4 steps per power of two */
+#define VE_SLAB_CACHE_MAX 64                    /* Empty slabs kept for reuse */
+#define VE_SLAB_MAGIC 0x56455342u
+#define VE_LARGE_MAGIC 0x5645534Cu
+
+/* Concurrent pool configuration */
+#define VE_POOL_CHUNK_HEADER_SIZE 64
+#define VE_POOL_DEFAULT_CHUNK_ELEMENTS 1024
+#define VE_POOL_MAX_CHUNKS 4096
+#define VE_POOL_MAGAZINE_COUNT 16   /* Threads beyond this share magazines */
+#define VE_POOL_MAGAZINE_SIZE 30
+
+#if defined(VE_MEMORY_TRACKING)
 /* Allocation header for tracking */
 typedef struct ve_allocation_header {
     size_t size;
@@ -31,32 +67,638 @@ typedef struct ve_allocation_header {
     struct ve_allocation_header* prev;
 } ve_allocation_header;
 
+#define VE_ALLOCATION_HEADER_SIZE sizeof(ve_allocation_header)
 #define HEADER_TO_USER(hdr) ((void*)((char*)(hdr) + sizeof(ve_allocation_header)))
 #define USER_TO_HEADER(ptr) ((ve_allocation_header*)((char*)(ptr) - sizeof(ve_allocation_header)))
 
+/* Live allocations are spread over several independently locked lists so
+   threads allocating at the same time rarely touch the same lock */
+typedef struct ve_allocation_shard {
+    ve_atomic_int32 lock;
+    ve_allocation_header* head;
+    uint8_t padding[64 - sizeof(ve_atomic_int32) - sizeof(ve_allocation_header*)];
+} ve_allocation_shard;
+#else
+#define VE_ALLOCATION_HEADER_SIZE 0
+#endif
+
+/* Per-thread statistics. Only the owning thread writes to a block, readers
+   merge all blocks. Frees on another thread than the allocation are counted
+   by the freeing thread, so individual blocks may go negative. */
+typedef struct ve_thread_stats {
+    int64_t total_allocated;
+    int64_t total_freed;
+    int64_t allocation_count;
+    int64_t external_usage;
+    int64_t tag_usage[VE_MEMORY_TAG_MAX];
+} ve_thread_stats;
+
+struct ve_heap;
+
+/* Slab header, stored at the start of every VE_SLAB_SIZE-aligned segment.
+   Large allocations use the same header so ve_free can tell them apart. */
+typedef struct ve_slab {
+    uint32_t magic;
+    uint32_t size_class;
+    size_t block_size;
+    size_t mapping_size;
+    struct ve_heap* owner;
+    struct ve_slab* next;
+    struct ve_slab* prev;
+    void* local_free;           /* Owner-only free list */
+    ve_atomic_ptr remote_free;  /* Blocks freed by other threads */
+    uint32_t used;              /* Blocks not on the local free list */
+    uint32_t bump;              /* Blocks carved so far */
+    uint32_t capacity;
+    uint32_t list;
+    ve_memory_tag large_tag;
+    uint8_t* tags;              /* Per-block tag slot (untracked builds) */
+    uint8_t* blocks;
+} ve_slab;
+
+enum {
+    VE_SLAB_LIST_NONE = 0,
+    VE_SLAB_LIST_AVAILABLE,
+    VE_SLAB_LIST_FULL,
+};
+
+/* Thread heap. Heaps are never freed; a heap whose thread exited is adopted
+   by the next new thread together with its slabs and statistics. */
+typedef struct ve_heap {
+    ve_thread_stats stats;
+    ve_slab* available[VE_SIZE_CLASS_COUNT];
+    ve_slab* full[VE_SIZE_CLASS_COUNT];
+    uint8_t padding[64];
+    ve_atomic_int32 remote_frees[VE_SIZE_CLASS_COUNT];  /* Written by other threads */
+    struct ve_heap* next;
+    ve_atomic_int32 in_use;
+} ve_heap;
+
+/* Allocator state. Kept apart from g_memory so allocations made before
+   ve_memory_init() are not lost when it resets the rest of the state. */
+typedef struct ve_allocator_state {
+#if defined(VE_MEMORY_TRACKING)
+    ve_allocation_shard shards[VE_MEMORY_TRACKING_SHARDS];
+#endif
+    ve_atomic_ptr heaps;        /* Push-only list of ve_heap */
+    ve_atomic_int32 slab_cache_lock;
+    ve_slab* slab_cache[VE_SLAB_CACHE_MAX];
+    uint32_t slab_cache_count;
+    size_t page_size;
+} ve_allocator_state;
+
 /* Memory system state */
 typedef struct ve_memory_state {
-    ve_memory_stats stats;
-    ve_allocation_header* allocation_list;
+    ve_memory_stats stats_baseline; /* Subtracted on read, see ve_memory_reset_stats */
     bool initialized;
     bool track_allocations;
 
-    /* Thread-local arena support */
+    /* Thread-local arena and heap support */
 #if defined(_WIN32) || defined(_WIN64)
     DWORD thread_arena_tls;
+    DWORD thread_heap_fls;
 #else
     pthread_key_t thread_arena_tls;
+    pthread_key_t thread_heap_tls;
 #endif
 } ve_memory_state;
 
+/* Frame allocator state */
+typedef struct ve_frame_allocator_state {
+    ve_arena* arenas[VE_FRAME_ALLOCATOR_MAX_SLOTS];
+    uint32_t slot_count;
+    uint32_t current;
+    ve_atomic_int32 lock;
+} ve_frame_allocator_state;
+
+static ve_allocator_state g_allocator = {0};
 static ve_memory_state g_memory = {0};
+static ve_frame_allocator_state g_frame_allocator = {0};
+
+static THREAD_LOCAL ve_heap* t_heap = NULL;
+
+/* Single-writer counter update; relaxed so concurrent readers see whole values */
+static void stat_add(int64_t* counter, int64_t delta) {
+#if defined(_MSC_VER)
+    *(volatile int64_t*)counter += delta;
+#else
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + delta, __ATOMIC_RELAXED);
+#endif
+}
+
+static int64_t stat_load(const int64_t* counter) {
+#if defined(_MSC_VER)
+    return *(const volatile int64_t*)counter;
+#else
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+#endif
+}
+
+static void spin_lock(ve_atomic_int32* lock) {
+    for (;;) {
+        int32_t expected = 0;
+        if (ve_atomic_compare_exchange32(lock, &expected, 1)) {
+            return;
+        }
+        while (ve_atomic_load32(lock) != 0) {
+            /* Spin on a plain load to keep the cacheline shared */
+        }
+    }
+}
+
+static void spin_unlock(ve_atomic_int32* lock) {
+    ve_atomic_store32(lock, 0);
+}
+
+/* OS virtual memory */
+
+static size_t os_page_size(void) {
+    if (g_allocator.page_size == 0) {
+#if defined(_WIN32) || defined(_WIN64)
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        g_allocator.page_size = info.dwPageSize;
+#else
+        g_allocator.page_size = (size_t)sysconf(_SC_PAGESIZE);
+#endif
+    }
+    return g_allocator.page_size;
+}
+
+static void* os_map_aligned(size_t size, size_t alignment) {
+#if defined(_WIN32) || defined(_WIN64)
+    /* Reserve an oversized range to find an aligned address, then map exactly
+       there. Another thread may grab the range in between, so retry. */
+    for (int attempt = 0; attempt < 8; attempt++) {
+        uint8_t* raw = (uint8_t*)VirtualAlloc(NULL, size + alignment, MEM_RESERVE, PAGE_NOACCESS);
+        if (!raw) {
+            return NULL;
+        }
+
+        uint8_t* aligned = (uint8_t*)(((uintptr_t)raw + alignment - 1) & ~(uintptr_t)(alignment - 1));
+        VirtualFree(raw, 0, MEM_RELEASE);
+
+        void* memory = VirtualAlloc(aligned, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if (memory) {
+            return memory;
+        }
+    }
+    return NULL;
+#else
+    size_t total = size + alignment;
+    uint8_t* raw = (uint8_t*)mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        return NULL;
+    }
+
+    uint8_t* aligned = (uint8_t*)(((uintptr_t)raw + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    size_t head = (size_t)(aligned - raw);
+    size_t tail = total - head - size;
+
+    if (head > 0) {
+        munmap(raw, head);
+    }
+    if (tail > 0) {
+        munmap(aligned + size, tail);
+    }
+
+    return aligned;
+#endif
+}
+
+static void os_unmap(void* memory, size_t size) {
+#if defined(_WIN32) || defined(_WIN64)
+    (void)size;
+    VirtualFree(memory, 0, MEM_RELEASE);
+#else
+    munmap(memory, size);
+#endif
+}
+
+/* Reserve address space without backing it; pages are made usable with
+   os_commit. Returns NULL where the platform refuses to overcommit. */
+static void* os_reserve(size_t size) {
+#if defined(_WIN32) || defined(_WIN64)
+    return VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    void* memory = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return memory == MAP_FAILED ? NULL : memory;
+#endif
+}
+
+static bool os_commit(void* memory, size_t size) {
+#if defined(_WIN32) || defined(_WIN64)
+    return VirtualAlloc(memory, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+    return mprotect(memory, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+static void os_decommit(void* memory, size_t size) {
+#if defined(_WIN32) || defined(_WIN64)
+    VirtualFree(memory, size, MEM_DECOMMIT);
+#else
+    madvise(memory, size, MADV_DONTNEED);
+    mprotect(memory, size, PROT_NONE);
+#endif
+}
+
+/* Size classes */
+
+static uint32_t floor_log2(size_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, (unsigned long long)value);
+    return (uint32_t)index;
+#else
+    return 63u - (uint32_t)__builtin_clzll((unsigned long long)value);
+#endif
+}
+
+static uint32_t size_to_class(size_t size) {
+    if (size <= 128) {
+        return (uint32_t)((size + 15) >> 4) - 1;
+    }
+
+    uint32_t log2 = floor_log2(size - 1);
+    uint32_t step = (uint32_t)((size - 1) >> (log2 - 2)) & 3;
+    return 8 + (log2 - 7) * 4 + step;
+}
+
+static size_t class_to_size(uint32_t size_class) {
+    if (size_class < 8) {
+        return (size_t)(size_class + 1) * 16;
+    }
+
+    uint32_t log2 = 7 + (size_class - 8) / 4;
+    uint32_t step = (size_class - 8) % 4;
+    return ((size_t)1 << log2) + (size_t)(step + 1) * ((size_t)1 << (log2 - 2));
+}
+
+#if !defined(VE_MEMORY_TRACKING)
+/* Tag slots: one byte per block, 0 for UNKNOWN and bit index + 1 otherwise.
+   Combined tags are accounted as UNKNOWN in untracked builds. */
+static uint8_t tag_to_slot(ve_memory_tag tag) {
+    uint32_t value = (uint32_t)tag;
+    if (value == 0 || (value & (value - 1)) != 0 || tag >= VE_MEMORY_TAG_MAX) {
+        return 0;
+    }
+    return (uint8_t)(floor_log2(value) + 1);
+}
+
+static ve_memory_tag slot_to_tag(uint8_t slot) {
+    return slot == 0 ? VE_MEMORY_TAG_UNKNOWN : (ve_memory_tag)(1u << (slot - 1));
+}
+#endif
+
+/* Slabs */
+
+static ve_slab* slab_from_pointer(const void* ptr) {
+    return (ve_slab*)((uintptr_t)ptr & ~(uintptr_t)(VE_SLAB_SIZE - 1));
+}
+
+static size_t slab_header_size(void) {
+    return (sizeof(ve_slab) + VE_MEMORY_ALIGNMENT - 1) & ~(size_t)(VE_MEMORY_ALIGNMENT - 1);
+}
+
+static ve_slab* slab_create(ve_heap* heap, uint32_t size_class) {
+    ve_slab* slab = NULL;
+
+    spin_lock(&g_allocator.slab_cache_lock);
+    if (g_allocator.slab_cache_count > 0) {
+        slab = g_allocator.slab_cache[--g_allocator.slab_cache_count];
+    }
+    spin_unlock(&g_allocator.slab_cache_lock);
+
+    if (!slab) {
+        slab = (ve_slab*)os_map_aligned(VE_SLAB_SIZE, VE_SLAB_SIZE);
+        if (!slab) {
+            return NULL;
+        }
+    }
+
+    size_t block_size = class_to_size(size_class);
+    size_t header_size = slab_header_size();
+    size_t capacity = (VE_SLAB_SIZE - header_size) / (block_size + 1);
+    size_t blocks_offset;
+
+    /* Tag bytes follow the header, blocks start at the next aligned offset */
+    for (;;) {
+        blocks_offset = (header_size + capacity + VE_MEMORY_ALIGNMENT - 1) & ~(size_t)(VE_MEMORY_ALIGNMENT - 1);
+        if (blocks_offset + capacity * block_size <= VE_SLAB_SIZE) {
+            break;
+        }
+        capacity--;
+    }
+
+    memset(slab, 0, sizeof(ve_slab));
+    slab->magic = VE_SLAB_MAGIC;
+    slab->size_class = size_class;
+    slab->block_size = block_size;
+    slab->mapping_size = VE_SLAB_SIZE;
+    slab->owner = heap;
+    slab->capacity = (uint32_t)capacity;
+    slab->tags = (uint8_t*)slab + header_size;
+    slab->blocks = (uint8_t*)slab + blocks_offset;
+
+    return slab;
+}
+
+static void slab_release(ve_slab* slab) {
+    slab->magic = 0;
+
+    spin_lock(&g_allocator.slab_cache_lock);
+    if (g_allocator.slab_cache_count < VE_SLAB_CACHE_MAX) {
+        g_allocator.slab_cache[g_allocator.slab_cache_count++] = slab;
+        slab = NULL;
+    }
+    spin_unlock(&g_allocator.slab_cache_lock);
+
+    if (slab) {
+        os_unmap(slab, VE_SLAB_SIZE);
+    }
+}
+
+static void slab_list_push(ve_heap* heap, ve_slab* slab, uint32_t list) {
+    ve_slab** head = (list == VE_SLAB_LIST_FULL) ? &heap->full[slab->size_class]
+                                                 : &heap->available[slab->size_class];
+    slab->prev = NULL;
+    slab->next = *head;
+    if (*head) {
+        (*head)->prev = slab;
+    }
+    *head = slab;
+    slab->list = list;
+}
+
+static void slab_list_remove(ve_heap* heap, ve_slab* slab) {
+    ve_slab** head = (slab->list == VE_SLAB_LIST_FULL) ? &heap->full[slab->size_class]
+                                                       : &heap->available[slab->size_class];
+    if (slab->prev) {
+        slab->prev->next = slab->next;
+    } else {
+        *head = slab->next;
+    }
+    if (slab->next) {
+        slab->next->prev = slab->prev;
+    }
+    slab->next = NULL;
+    slab->prev = NULL;
+    slab->list = VE_SLAB_LIST_NONE;
+}
+
+static void* slab_take_block(ve_slab* slab) {
+    void* block = slab->local_free;
+
+    if (block) {
+        slab->local_free = *(void**)block;
+    } else if (slab->bump < slab->capacity) {
+        block = slab->blocks + (size_t)slab->bump++ * slab->block_size;
+    } else {
+        /* Collect everything other threads have freed in one go */
+        void* list = ve_atomic_load_ptr(&slab->remote_free);
+        while (list && !ve_atomic_compare_exchange_ptr(&slab->remote_free, &list, NULL)) {
+        }
+
+        if (!list) {
+            return NULL;
+        }
+
+        for (void* it = list; it; it = *(void**)it) {
+            slab->used--;
+        }
+
+        block = list;
+        slab->local_free = *(void**)list;
+    }
+
+    slab->used++;
+    return block;
+}
+
+static void slab_free_local(ve_heap* heap, ve_slab* slab, void* block) {
+    *(void**)block = slab->local_free;
+    slab->local_free = block;
+    slab->used--;
+
+    if (slab->list == VE_SLAB_LIST_FULL) {
+        slab_list_remove(heap, slab);
+        slab_list_push(heap, slab, VE_SLAB_LIST_AVAILABLE);
+    } else if (slab->used == 0 && heap->available[slab->size_class] != slab) {
+        /* Keep the current slab of the class, return other empty ones. Remote
+           frees count as used until collected, so none can still arrive. */
+        slab_list_remove(heap, slab);
+        slab_release(slab);
+    }
+}
+
+static void slab_free_remote(ve_slab* slab, void* block) {
+    /* Read everything needed first: once the block is published the owner may
+       collect it and release the slab */
+    ve_heap* owner = slab->owner;
+    uint32_t size_class = slab->size_class;
+
+    void* head = ve_atomic_load_ptr(&slab->remote_free);
+    do {
+        *(void**)block = head;
+    } while (!ve_atomic_compare_exchange_ptr(&slab->remote_free, &head, block));
+
+    ve_atomic_increment32(&owner->remote_frees[size_class]);
+}
+
+/* Thread heaps */
+
+#if defined(_WIN32) || defined(_WIN64)
+static void WINAPI thread_heap_release(void* ptr) {
+#else
+static void thread_heap_release(void* ptr) {
+#endif
+    /* Thread exited: hand the heap to the next thread that needs one */
+    if (ptr) {
+        if (t_heap == ptr) {
+            t_heap = NULL;
+        }
+        ve_atomic_store32(&((ve_heap*)ptr)->in_use, 0);
+    }
+}
+
+static ve_heap* get_thread_heap(void) {
+    ve_heap* heap = t_heap;
+    if (heap) {
+        return heap;
+    }
+
+    /* Adopt a heap left behind by an exited thread */
+    for (heap = (ve_heap*)ve_atomic_load_ptr(&g_allocator.heaps); heap; heap = heap->next) {
+        int32_t expected = 0;
+        if (ve_atomic_compare_exchange32(&heap->in_use, &expected, 1)) {
+            break;
+        }
+    }
+
+    if (!heap) {
+        /* Plain calloc: heaps are part of the allocator itself */
+        heap = (ve_heap*)calloc(1, sizeof(ve_heap));
+        if (!heap) {
+            return NULL;
+        }
+        heap->in_use.value = 1;
+
+        void* head = ve_atomic_load_ptr(&g_allocator.heaps);
+        do {
+            heap->next = (ve_heap*)head;
+        } while (!ve_atomic_compare_exchange_ptr(&g_allocator.heaps, &head, heap));
+    }
+
+    /* Register for release at thread exit once the TLS key exists */
+    if (g_memory.initialized) {
+#if defined(_WIN32) || defined(_WIN64)
+        FlsSetValue(g_memory.thread_heap_fls, heap);
+#else
+        pthread_setspecific(g_memory.thread_heap_tls, heap);
+#endif
+    }
+
+    t_heap = heap;
+    return heap;
+}
+
+static void record_allocation(ve_heap* heap, ve_memory_tag tag, int64_t size) {
+    ve_thread_stats* stats = &heap->stats;
+
+    if (size > 0) {
+        stat_add(&stats->total_allocated, size);
+        stat_add(&stats->allocation_count, 1);
+    } else {
+        stat_add(&stats->total_freed, -size);
+        stat_add(&stats->allocation_count, -1);
+    }
+
+    if (tag < VE_MEMORY_TAG_MAX) {
+        stat_add(&stats->tag_usage[tag], size);
+    }
+}
+
+static bool reclaim_full_slabs(ve_heap* heap, uint32_t size_class) {
+    bool reclaimed = false;
+
+    ve_atomic_store32(&heap->remote_frees[size_class], 0);
+
+    ve_slab* slab = heap->full[size_class];
+    while (slab) {
+        ve_slab* next = slab->next;
+        if (ve_atomic_load_ptr(&slab->remote_free) != NULL) {
+            slab_list_remove(heap, slab);
+            slab_list_push(heap, slab, VE_SLAB_LIST_AVAILABLE);
+            reclaimed = true;
+        }
+        slab = next;
+    }
+
+    return reclaimed;
+}
+
+static void* heap_allocate_small(ve_heap* heap, uint32_t size_class, ve_memory_tag tag) {
+    for (;;) {
+        ve_slab* slab;
+        while ((slab = heap->available[size_class]) != NULL) {
+            uint8_t* block = (uint8_t*)slab_take_block(slab);
+            if (block) {
+#if !defined(VE_MEMORY_TRACKING)
+                slab->tags[(size_t)(block - slab->blocks) / slab->block_size] = tag_to_slot(tag);
+#else
+                (void)tag;
+#endif
+                return block;
+            }
+
+            slab_list_remove(heap, slab);
+            slab_list_push(heap, slab, VE_SLAB_LIST_FULL);
+        }
+
+        if (ve_atomic_load32(&heap->remote_frees[size_class]) > 0 &&
+            reclaim_full_slabs(heap, size_class)) {
+            continue;
+        }
+
+        slab = slab_create(heap, size_class);
+        if (!slab) {
+            return NULL;
+        }
+        slab_list_push(heap, slab, VE_SLAB_LIST_AVAILABLE);
+    }
+}
+
+static void* allocate_large(size_t size, ve_memory_tag tag) {
+    size_t header_size = slab_header_size();
+    size_t page_size = os_page_size();
+    size_t mapping_size = (header_size + size + page_size - 1) & ~(page_size - 1);
+
+    /* Aligned like a slab so slab_from_pointer() finds this header */
+    ve_slab* slab = (ve_slab*)os_map_aligned(mapping_size, VE_SLAB_SIZE);
+    if (!slab) {
+        return NULL;
+    }
+
+    memset(slab, 0, sizeof(ve_slab));
+    slab->magic = VE_LARGE_MAGIC;
+    slab->size_class = UINT32_MAX;
+    slab->block_size = size;
+    slab->mapping_size = mapping_size;
+    slab->large_tag = tag;
+    slab->blocks = (uint8_t*)slab + header_size;
+
+    return slab->blocks;
+}
+
+static void* allocate_block(ve_heap* heap, size_t size, ve_memory_tag tag) {
+    if (size <= VE_SMALL_SIZE_MAX) {
+        return heap_allocate_small(heap, size_to_class(size), tag);
+    }
+    return allocate_large(size, tag);
+}
+
+static void free_block(void* block) {
+    ve_slab* slab = slab_from_pointer(block);
+
+    if (slab->magic == VE_LARGE_MAGIC) {
+        os_unmap(slab, slab->mapping_size);
+        return;
+    }
+
+    VE_ASSERT(slab->magic == VE_SLAB_MAGIC);
+
+    ve_heap* heap = t_heap;
+    if (heap && slab->owner == heap) {
+        slab_free_local(heap, slab, block);
+    } else {
+        slab_free_remote(slab, block);
+    }
+}
+
+#if !defined(VE_MEMORY_TRACKING)
+/* Accounting for untracked builds: block size and tag come from the slab */
+static void block_info(const void* block, size_t* size, ve_memory_tag* tag) {
+    ve_slab* slab = slab_from_pointer(block);
+
+    if (slab->magic == VE_LARGE_MAGIC) {
+        *size = slab->block_size;
+        *tag = slab->large_tag;
+    } else {
+        *size = slab->block_size;
+        *tag = slot_to_tag(slab->tags[(size_t)((const uint8_t*)block - slab->blocks) / slab->block_size]);
+    }
+}
+#endif
 
 /* Platform-specific TLS functions */
 static void init_tls(void) {
 #if defined(_WIN32) || defined(_WIN64)
     g_memory.thread_arena_tls = TlsAlloc();
+    g_memory.thread_heap_fls = FlsAlloc(thread_heap_release);
 #else
     pthread_key_create(&g_memory.thread_arena_tls, NULL);
+    pthread_key_create(&g_memory.thread_heap_tls, thread_heap_release);
 #endif
 }
 
@@ -85,6 +727,47 @@ static void arena_cleanup(void* ptr) {
 }
 #endif
 
+#if defined(VE_MEMORY_TRACKING)
+/* Allocation shards */
+
+static ve_allocation_shard* get_shard(const ve_allocation_header* hdr) {
+    /* Fibonacci hash of the header address, low bits are always zero */
+    uint64_t key = (uint64_t)(uintptr_t)hdr >> 4;
+    return &g_allocator.shards[(key * 0x9E3779B97F4A7C15ull) >> (64 - VE_MEMORY_TRACKING_SHARD_BITS)];
+}
+
+static void track_header(ve_allocation_header* hdr) {
+    ve_allocation_shard* shard = get_shard(hdr);
+    spin_lock(&shard->lock);
+
+    hdr->next = shard->head;
+    hdr->prev = NULL;
+    if (shard->head) {
+        shard->head->prev = hdr;
+    }
+    shard->head = hdr;
+
+    spin_unlock(&shard->lock);
+}
+
+static void untrack_header(ve_allocation_header* hdr) {
+    ve_allocation_shard* shard = get_shard(hdr);
+    spin_lock(&shard->lock);
+
+    if (hdr->prev) {
+        hdr->prev->next = hdr->next;
+    } else {
+        shard->head = hdr->next;
+    }
+
+    if (hdr->next) {
+        hdr->next->prev = hdr->prev;
+    }
+
+    spin_unlock(&shard->lock);
+}
+#endif
+
 bool ve_memory_init(void) {
     if (g_memory.initialized) {
         return true;
@@ -114,28 +797,46 @@ void ve_memory_shutdown(void) {
     }
 
     /* Check for leaks */
-    if (g_memory.track_allocations && g_memory.allocation_list != NULL) {
+#if defined(VE_MEMORY_TRACKING)
+    if (g_memory.track_allocations && ve_memory_check_leaks()) {
         VE_LOG_WARN("Memory leaks detected:");
-        ve_allocation_header* hdr = g_memory.allocation_list;
         size_t leak_count = 0;
         size_t leak_size = 0;
 
-        while (hdr) {
-            VE_LOG_WARN("  Leak: %zu bytes, tag %d, at %s:%d",
-                hdr->size, hdr->tag, hdr->file ? hdr->file : "unknown", hdr->line);
-            leak_size += hdr->size;
-            leak_count++;
-            hdr = hdr->next;
+        for (int i = 0; i < VE_MEMORY_TRACKING_SHARDS; i++) {
+            ve_allocation_shard* shard = &g_allocator.shards[i];
+            spin_lock(&shard->lock);
+
+            for (ve_allocation_header* hdr = shard->head; hdr; hdr = hdr->next) {
+                VE_LOG_WARN("  Leak: %zu bytes, tag %d, at %s:%d",
+                    hdr->size, hdr->tag, hdr->file ? hdr->file : "unknown", hdr->line);
+                leak_size += hdr->size;
+                leak_count++;
+            }
+
+            spin_unlock(&shard->lock);
         }
 
         VE_LOG_WARN("Total leaks: %zu allocations, %zu bytes", leak_count, leak_size);
     }
+#else
+    if (ve_memory_check_leaks()) {
+        ve_memory_stats stats = ve_memory_get_stats();
+        VE_LOG_WARN("Memory leaks detected: %zu allocations, %zu bytes (build with "
+                    "VE_MEMORY_TRACKING for details)",
+                    stats.allocation_count, stats.total_allocated - stats.total_freed);
+    }
+#endif
 
     g_memory.initialized = false;
 
-    /* Cleanup TLS */
-#if !defined(_WIN32) && !defined(_WIN64)
+    /* Cleanup TLS. Heaps stay registered so late frees on other threads still
+       have somewhere to go. */
+#if defined(_WIN32) || defined(_WIN64)
+    FlsFree(g_memory.thread_heap_fls);
+#else
     pthread_key_delete(g_memory.thread_arena_tls);
+    pthread_key_delete(g_memory.thread_heap_tls);
 #endif
 
     VE_LOG_INFO("Memory system shutdown");
@@ -149,37 +850,37 @@ void* ve_allocate(size_t size, ve_memory_tag tag) {
     /* Align size */
     size = ve_align_size(size, VE_MEMORY_ALIGNMENT);
 
-    /* Allocate with header */
-    ve_allocation_header* hdr = (ve_allocation_header*)malloc(sizeof(ve_allocation_header) + size);
-    if (!hdr) {
+    ve_heap* heap = get_thread_heap();
+    void* block = heap ? allocate_block(heap, size + VE_ALLOCATION_HEADER_SIZE, tag) : NULL;
+    if (!block) {
         VE_LOG_ERROR("Failed to allocate %zu bytes", size);
         return NULL;
     }
 
+#if defined(VE_MEMORY_TRACKING)
+    ve_allocation_header* hdr = (ve_allocation_header*)block;
     hdr->size = size;
     hdr->tag = tag;
     hdr->file = NULL;
     hdr->line = 0;
+    hdr->next = NULL;
+    hdr->prev = NULL;
 
     /* Track allocation */
     if (g_memory.track_allocations) {
-        hdr->next = g_memory.allocation_list;
-        hdr->prev = NULL;
-
-        if (g_memory.allocation_list) {
-            g_memory.allocation_list->prev = hdr;
-        }
-        g_memory.allocation_list = hdr;
-
-        /* Update stats */
-        g_memory.stats.total_allocated += size;
-        g_memory.stats.allocation_count++;
-        if (tag < VE_MEMORY_TAG_MAX) {
-            g_memory.stats.tag_usage[tag] += size;
-        }
+        track_header(hdr);
     }
+    record_allocation(heap, tag, (int64_t)size);
 
     return HEADER_TO_USER(hdr);
+#else
+    size_t block_size;
+    ve_memory_tag block_tag;
+    block_info(block, &block_size, &block_tag);
+    record_allocation(heap, block_tag, (int64_t)block_size);
+
+    return block;
+#endif
 }
 
 void ve_free(void* memory) {
@@ -187,30 +888,38 @@ void ve_free(void* memory) {
         return;
     }
 
+    ve_heap* heap = get_thread_heap();
+
+#if defined(VE_MEMORY_TRACKING)
     ve_allocation_header* hdr = USER_TO_HEADER(memory);
 
     /* Untrack allocation */
+    if (heap) {
+        record_allocation(heap, hdr->tag, -(int64_t)hdr->size);
+    }
     if (g_memory.track_allocations) {
-        g_memory.stats.total_freed += hdr->size;
-        g_memory.stats.allocation_count--;
-
-        if (hdr->tag < VE_MEMORY_TAG_MAX) {
-            g_memory.stats.tag_usage[hdr->tag] -= hdr->size;
-        }
-
-        /* Remove from list */
-        if (hdr->prev) {
-            hdr->prev->next = hdr->next;
-        } else {
-            g_memory.allocation_list = hdr->next;
-        }
+        untrack_header(hdr);
+    }
 
-        if (hdr->next) {
-            hdr->next->prev = hdr->prev;
-        }
+    free_block(hdr);
+#else
+    if (heap) {
+        size_t block_size;
+        ve_memory_tag block_tag;
+        block_info(memory, &block_size, &block_tag);
+        record_allocation(heap, block_tag, -(int64_t)block_size);
     }
 
-    free(hdr);
+    free_block(memory);
+#endif
+}
+
+static size_t usable_size(const void* memory) {
+#if defined(VE_MEMORY_TRACKING)
+    return USER_TO_HEADER(memory)->size;
+#else
+    return slab_from_pointer(memory)->block_size;
+#endif
 }
 
 void* ve_reallocate(void* memory, size_t new_size, ve_memory_tag tag) {
@@ -223,8 +932,7 @@ void* ve_reallocate(void* memory, size_t new_size, ve_memory_tag tag) {
         return NULL;
     }
 
-    ve_allocation_header* old_hdr = USER_TO_HEADER(memory);
-    size_t old_size = old_hdr->size;
+    size_t old_size = usable_size(memory);
     new_size = ve_align_size(new_size, VE_MEMORY_ALIGNMENT);
 
     /* Allocate new block */
@@ -264,16 +972,165 @@ char* ve_string_duplicate(const char* str, ve_memory_tag tag) {
     return duplicate;
 }
 
+static void merge_thread_stats(ve_memory_stats* out) {
+    int64_t total_allocated = 0;
+    int64_t total_freed = 0;
+    int64_t allocation_count = 0;
+    int64_t external_usage = 0;
+
+    memset(out, 0, sizeof(ve_memory_stats));
+
+    for (ve_heap* heap = (ve_heap*)ve_atomic_load_ptr(&g_allocator.heaps); heap; heap = heap->next) {
+        ve_thread_stats* stats = &heap->stats;
+        total_allocated += stat_load(&stats->total_allocated);
+        total_freed += stat_load(&stats->total_freed);
+        allocation_count += stat_load(&stats->allocation_count);
+        external_usage += stat_load(&stats->external_usage);
+
+        for (int i = 0; i < VE_MEMORY_TAG_MAX; i++) {
+            out->tag_usage[i] += (size_t)stat_load(&stats->tag_usage[i]);
+        }
+    }
+
+    out->total_allocated = (size_t)total_allocated;
+    out->total_freed = (size_t)total_freed;
+    out->allocation_count = (size_t)allocation_count;
+    out->external_usage = (size_t)external_usage;
+}
+
 ve_memory_stats ve_memory_get_stats(void) {
-    return g_memory.stats;
+    ve_memory_stats stats;
+    merge_thread_stats(&stats);
+
+    /* Unsigned wrap-around makes this correct for tags that shrank since the reset */
+    stats.total_allocated -= g_memory.stats_baseline.total_allocated;
+    stats.total_freed -= g_memory.stats_baseline.total_freed;
+    stats.allocation_count -= g_memory.stats_baseline.allocation_count;
+    stats.external_usage -= g_memory.stats_baseline.external_usage;
+    for (int i = 0; i < VE_MEMORY_TAG_MAX; i++) {
+        stats.tag_usage[i] -= g_memory.stats_baseline.tag_usage[i];
+    }
+
+    return stats;
 }
 
 void ve_memory_reset_stats(void) {
-    memset(&g_memory.stats, 0, sizeof(ve_memory_stats));
+    merge_thread_stats(&g_memory.stats_baseline);
+}
+
+void ve_memory_record_external(ve_memory_tag tag, int64_t delta) {
+    ve_heap* heap = get_thread_heap();
+    if (!heap) {
+        return;
+    }
+
+    stat_add(&heap->stats.external_usage, delta);
+    if (tag < VE_MEMORY_TAG_MAX) {
+        stat_add(&heap->stats.tag_usage[tag], delta);
+    }
 }
 
 /* Arena allocator implementation */
 
+/* Header of a chained arena block; the data follows, aligned to the arena */
+typedef struct ve_arena_block {
+    struct ve_arena_block* prev;
+    size_t capacity;
+    size_t base;  /* Arena position at the start of this block */
+} ve_arena_block;
+
+static size_t arena_block_header_size(size_t alignment) {
+    return ve_align_size(sizeof(ve_arena_block), alignment);
+}
+
+static void* aligned_alloc_block(size_t size, size_t alignment) {
+    void* memory = NULL;
+#if defined(_WIN32) || defined(_WIN64)
+    memory = _aligned_malloc(size, alignment);
+#else
+    if (posix_memalign(&memory, alignment, size) != 0) {
+        memory = NULL;
+    }
+#endif
+    return memory;
+}
+
+static void aligned_free_block(void* memory) {
+#if defined(_WIN32) || defined(_WIN64)
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+static ve_arena_block* arena_block_create(const ve_arena* arena, size_t capacity, size_t base) {
+    size_t header = arena_block_header_size(arena->alignment);
+    ve_arena_block* block = (ve_arena_block*)aligned_alloc_block(header + capacity, arena->alignment);
+    if (!block) {
+        return NULL;
+    }
+
+    block->prev = NULL;
+    block->capacity = capacity;
+    block->base = base;
+    return block;
+}
+
+static void arena_set_block(ve_arena* arena, ve_arena_block* block) {
+    arena->block = block;
+    arena->memory = (char*)block + arena_block_header_size(arena->alignment);
+    arena->capacity = block->capacity;
+    arena->block_base = block->base;
+}
+
+/* Make room for size more bytes at the current position */
+static bool arena_grow(ve_arena* arena, size_t size) {
+    if (arena->kind == VE_ARENA_KIND_VIRTUAL) {
+        size_t needed = arena->used + size;
+        if (needed > arena->reserved) {
+            VE_LOG_ERROR("Arena reservation of %zu bytes exhausted", arena->reserved);
+            return false;
+        }
+
+        size_t commit_end = ve_align_size(needed, VE_ARENA_COMMIT_SIZE);
+        if (commit_end > arena->reserved) {
+            commit_end = arena->reserved;
+        }
+        if (!os_commit((char*)arena->memory + arena->capacity, commit_end - arena->capacity)) {
+            VE_LOG_ERROR("Failed to commit %zu bytes of arena memory", commit_end - arena->capacity);
+            return false;
+        }
+        arena->capacity = commit_end;
+        return true;
+    }
+
+    if (arena->kind == VE_ARENA_KIND_CHAINED) {
+        /* The tail of the current block is skipped so positions stay unique */
+        size_t capacity = arena->block->capacity * 2;
+        if (capacity < size) {
+            capacity = ve_align_size(size, VE_ARENA_MIN_BLOCK_SIZE);
+        }
+
+        ve_arena_block* block = arena_block_create(arena, capacity, arena->block_base + arena->capacity);
+        if (!block) {
+            VE_LOG_ERROR("Failed to allocate %zu byte arena block", capacity);
+            return false;
+        }
+        block->prev = arena->block;
+        arena_set_block(arena, block);
+        arena->used = block->base;
+        return true;
+    }
+
+    return false;
+}
+
+static void arena_pop_block(ve_arena* arena) {
+    ve_arena_block* block = arena->block;
+    arena_set_block(arena, block->prev);
+    aligned_free_block(block);
+}
+
 ve_arena* ve_arena_create(size_t capacity, size_t alignment, ve_arena* parent) {
     if (alignment == 0) {
         alignment = VE_MEMORY_ALIGNMENT;
@@ -283,14 +1140,10 @@ ve_arena* ve_arena_create(size_t capacity, size_t alignment, ve_arena* parent) {
     if (!arena) {
         return NULL;
     }
+    memset(arena, 0, sizeof(ve_arena));
 
     /* Allocate aligned memory */
-#if defined(_WIN32) || defined(_WIN64)
-    arena->memory = _aligned_malloc(capacity, alignment);
-#else
-    posix_memalign(&arena->memory, alignment, capacity);
-#endif
-
+    arena->memory = aligned_alloc_block(capacity, alignment);
     if (!arena->memory) {
         free(arena);
         return NULL;
@@ -300,6 +1153,49 @@ ve_arena* ve_arena_create(size_t capacity, size_t alignment, ve_arena* parent) {
     arena->used = 0;
     arena->alignment = alignment;
     arena->parent = parent;
+    arena->kind = VE_ARENA_KIND_FIXED;
+
+    return arena;
+}
+
+ve_arena* ve_arena_create_growable(size_t reserve_size, size_t alignment, unsigned int flags) {
+    if (alignment == 0) {
+        alignment = VE_MEMORY_ALIGNMENT;
+    }
+
+    ve_arena* arena = (ve_arena*)malloc(sizeof(ve_arena));
+    if (!arena) {
+        return NULL;
+    }
+    memset(arena, 0, sizeof(ve_arena));
+
+    arena->alignment = alignment;
+    arena->flags = flags;
+
+    /* Page-aligned reservations keep every allocation aligned up to the page size */
+    if (!(flags & VE_ARENA_FLAG_CHAINED) && alignment <= os_page_size()) {
+        size_t reserved = ve_align_size(reserve_size > 0 ? reserve_size : VE_ARENA_COMMIT_SIZE, VE_ARENA_COMMIT_SIZE);
+        void* memory = os_reserve(reserved);
+        if (memory && os_commit(memory, VE_ARENA_COMMIT_SIZE)) {
+            arena->kind = VE_ARENA_KIND_VIRTUAL;
+            arena->memory = memory;
+            arena->capacity = VE_ARENA_COMMIT_SIZE;
+            arena->reserved = reserved;
+            return arena;
+        }
+        if (memory) {
+            os_unmap(memory, reserved);
+        }
+        VE_LOG_DEBUG("Address space reservation of %zu bytes failed, using chained arena", reserved);
+    }
+
+    ve_arena_block* block = arena_block_create(arena, VE_ARENA_MIN_BLOCK_SIZE, 0);
+    if (!block) {
+        free(arena);
+        return NULL;
+    }
+    arena->kind = VE_ARENA_KIND_CHAINED;
+    arena_set_block(arena, block);
 
     return arena;
 }
@@ -309,11 +1205,22 @@ void ve_arena_destroy(ve_arena* arena) {
         return;
     }
 
-#if defined(_WIN32) || defined(_WIN64)
-    _aligned_free(arena->memory);
-#else
-    free(arena->memory);
-#endif
+    switch (arena->kind) {
+        case VE_ARENA_KIND_VIRTUAL:
+            os_unmap(arena->memory, arena->reserved);
+            break;
+        case VE_ARENA_KIND_CHAINED:
+            while (arena->block) {
+                ve_arena_block* prev = arena->block->prev;
+                aligned_free_block(arena->block);
+                arena->block = prev;
+            }
+            break;
+        case VE_ARENA_KIND_FIXED:
+        default:
+            aligned_free_block(arena->memory);
+            break;
+    }
     free(arena);
 }
 
@@ -326,7 +1233,7 @@ void* ve_arena_allocate(ve_arena* arena, size_t size) {
     size = ve_align_size(size, arena->alignment);
 
     /* Check capacity */
-    if (arena->used + size > arena->capacity) {
+    if (arena->used - arena->block_base + size > arena->capacity && !arena_grow(arena, size)) {
         /* Try parent arena */
         if (arena->parent) {
             return ve_arena_allocate(arena->parent, size);
@@ -334,15 +1241,42 @@ void* ve_arena_allocate(ve_arena* arena, size_t size) {
         return NULL;
     }
 
-    void* ptr = (char*)arena->memory + arena->used;
+    void* ptr = (char*)arena->memory + (arena->used - arena->block_base);
     arena->used += size;
+    if (arena->used > arena->high_water_mark) {
+        arena->high_water_mark = arena->used;
+    }
 
     return ptr;
 }
 
 void ve_arena_reset(ve_arena* arena) {
-    if (arena) {
-        arena->used = 0;
+    if (!arena) {
+        return;
+    }
+
+    arena->used = 0;
+
+    if (arena->kind == VE_ARENA_KIND_VIRTUAL) {
+        if ((arena->flags & VE_ARENA_FLAG_DECOMMIT_ON_RESET) && arena->capacity > VE_ARENA_COMMIT_SIZE) {
+            os_decommit((char*)arena->memory + VE_ARENA_COMMIT_SIZE, arena->capacity - VE_ARENA_COMMIT_SIZE);
+            arena->capacity = VE_ARENA_COMMIT_SIZE;
+        }
+    } else if (arena->kind == VE_ARENA_KIND_CHAINED) {
+        bool chained = arena->block->prev != NULL;
+        while (arena->block->prev) {
+            arena_pop_block(arena);
+        }
+
+        /* Replace the first block with one large enough for the last peak */
+        if (chained && !(arena->flags & VE_ARENA_FLAG_DECOMMIT_ON_RESET)) {
+            size_t capacity = ve_align_size(arena->high_water_mark, VE_ARENA_MIN_BLOCK_SIZE);
+            ve_arena_block* block = arena_block_create(arena, capacity, 0);
+            if (block) {
+                aligned_free_block(arena->block);
+                arena_set_block(arena, block);
+            }
+        }
     }
 }
 
@@ -350,20 +1284,32 @@ size_t ve_arena_get_usage(const ve_arena* arena) {
     return arena ? arena->used : 0;
 }
 
+size_t ve_arena_get_high_water_mark(const ve_arena* arena) {
+    return arena ? arena->high_water_mark : 0;
+}
+
 size_t ve_arena_get_position(ve_arena* arena) {
     return arena ? arena->used : 0;
 }
 
 void ve_arena_set_position(ve_arena* arena, size_t position) {
-    if (arena && position <= arena->used) {
-        arena->used = position;
+    if (!arena || position > arena->used) {
+        return;
+    }
+
+    /* Release blocks chained after the snapshot */
+    if (arena->kind == VE_ARENA_KIND_CHAINED) {
+        while (arena->block->base > position) {
+            arena_pop_block(arena);
+        }
     }
+    arena->used = position;
 }
 
 ve_arena* ve_arena_get_thread_arena(void) {
     ve_arena* arena = get_thread_arena();
     if (!arena) {
-        arena = ve_arena_create(VE_THREAD_ARENA_SIZE, VE_MEMORY_ALIGNMENT, NULL);
+        arena = ve_arena_create_growable(VE_THREAD_ARENA_RESERVE_SIZE, VE_MEMORY_ALIGNMENT, VE_ARENA_FLAG_NONE);
         if (arena) {
             set_thread_arena(arena);
         }
@@ -371,6 +1317,66 @@ ve_arena* ve_arena_get_thread_arena(void) {
     return arena;
 }
 
+/* Frame allocator implementation */
+
+bool ve_frame_allocator_init(uint32_t slot_count, size_t reserve_size) {
+    if (slot_count == 0 || slot_count > VE_FRAME_ALLOCATOR_MAX_SLOTS) {
+        VE_LOG_ERROR("Invalid frame allocator slot count: %u", slot_count);
+        return false;
+    }
+
+    ve_frame_allocator_shutdown();
+
+    for (uint32_t i = 0; i < slot_count; i++) {
+        g_frame_allocator.arenas[i] = ve_arena_create_growable(reserve_size, VE_MEMORY_ALIGNMENT, VE_ARENA_FLAG_NONE);
+        if (!g_frame_allocator.arenas[i]) {
+            VE_LOG_ERROR("Failed to create frame arena %u", i);
+            ve_frame_allocator_shutdown();
+            return false;
+        }
+    }
+
+    g_frame_allocator.slot_count = slot_count;
+    g_frame_allocator.current = 0;
+    return true;
+}
+
+void ve_frame_allocator_shutdown(void) {
+    for (uint32_t i = 0; i < VE_FRAME_ALLOCATOR_MAX_SLOTS; i++) {
+        ve_arena_destroy(g_frame_allocator.arenas[i]);
+        g_frame_allocator.arenas[i] = NULL;
+    }
+    g_frame_allocator.slot_count = 0;
+    g_frame_allocator.current = 0;
+}
+
+void ve_frame_allocator_begin(uint32_t slot) {
+    if (slot >= g_frame_allocator.slot_count) {
+        return;
+    }
+
+    spin_lock(&g_frame_allocator.lock);
+    ve_arena_reset(g_frame_allocator.arenas[slot]);
+    g_frame_allocator.current = slot;
+    spin_unlock(&g_frame_allocator.lock);
+}
+
+void* ve_frame_allocate(size_t size) {
+    if (g_frame_allocator.slot_count == 0) {
+        return NULL;
+    }
+
+    spin_lock(&g_frame_allocator.lock);
+    void* ptr = ve_arena_allocate(g_frame_allocator.arenas[g_frame_allocator.current], size);
+    spin_unlock(&g_frame_allocator.lock);
+
+    return ptr;
+}
+
+ve_arena* ve_frame_allocator_get_arena(uint32_t slot) {
+    return slot < g_frame_allocator.slot_count ? g_frame_allocator.arenas[slot] : NULL;
+}
+
 /* Memory pool implementation */
 
 ve_pool* ve_pool_create(size_t element_size, size_t capacity) {
@@ -454,6 +1460,300 @@ bool ve_pool_contains(const ve_pool* pool, const void* ptr) {
             (const char*)ptr < (const char*)pool->memory + (pool->capacity * pool->element_size));
 }
 
+/* Concurrent pool implementation */
+
+/* Chunk header, stored at the start of every chunk. Chunks are aligned to
+   their size so an element finds its chunk by masking its address. */
+typedef struct ve_pool_chunk {
+    struct ve_concurrent_pool* pool;
+    uint32_t index;
+} ve_pool_chunk;
+
+/* Small cache of free element ids. Each thread maps to one magazine; if it
+   is busy the thread goes to the shared list instead of waiting. */
+typedef struct ve_pool_magazine {
+    ve_atomic_int32 busy;
+    uint32_t count;
+    uint32_t items[VE_POOL_MAGAZINE_SIZE];
+    uint8_t padding[64 - (2 * sizeof(uint32_t) + VE_POOL_MAGAZINE_SIZE * sizeof(uint32_t)) % 64];
+} ve_pool_magazine;
+
+/* Elements are named by id = (chunk << chunk_bits | slot) + 1, so 0 means
+   none. Each chunk holds a link table after its header, the id of the next
+   free element per slot, followed by the elements. Keeping links out of the
+   elements means a stale read in pool_pop never touches user data. The list
+   head packs the first id with an ABA tag that is bumped on every update. */
+struct ve_concurrent_pool {
+    ve_atomic_int64 head;  /* Low 32 bits: first free id, high 32 bits: tag */
+    uint8_t padding[64 - sizeof(ve_atomic_int64)];
+    ve_pool_magazine magazines[VE_POOL_MAGAZINE_COUNT];
+    size_t element_size;
+    size_t elements_offset;
+    size_t chunk_size;
+    uint32_t chunk_bits;
+    uint32_t elements_per_chunk;
+    uint32_t max_chunks;
+    ve_atomic_int32 chunk_count;
+    ve_atomic_int32 grow_lock;
+    ve_atomic_ptr* chunks;
+};
+
+static ve_atomic_int32 g_pool_thread_counter = {0};
+static THREAD_LOCAL uint32_t t_pool_thread_slot = 0;
+
+static uint8_t* pool_chunk(ve_concurrent_pool* pool, uint32_t id) {
+    return (uint8_t*)ve_atomic_load_ptr(&pool->chunks[(id - 1) >> pool->chunk_bits]);
+}
+
+static uint32_t pool_slot(ve_concurrent_pool* pool, uint32_t id) {
+    return (id - 1) & ((1u << pool->chunk_bits) - 1);
+}
+
+static uint8_t* pool_element(ve_concurrent_pool* pool, uint32_t id) {
+    return pool_chunk(pool, id) + pool->elements_offset + (size_t)pool_slot(pool, id) * pool->element_size;
+}
+
+static ve_atomic_int32* pool_link(ve_concurrent_pool* pool, uint32_t id) {
+    return (ve_atomic_int32*)(pool_chunk(pool, id) + VE_POOL_CHUNK_HEADER_SIZE) + pool_slot(pool, id);
+}
+
+static uint32_t pool_element_id(ve_concurrent_pool* pool, const void* element) {
+    uintptr_t chunk = (uintptr_t)element & ~(uintptr_t)(pool->chunk_size - 1);
+    uint32_t slot = (uint32_t)(((uintptr_t)element - chunk - pool->elements_offset) / pool->element_size);
+    return ((((ve_pool_chunk*)chunk)->index << pool->chunk_bits) | slot) + 1;
+}
+
+static int64_t pool_make_head(int64_t previous, uint32_t id) {
+    uint64_t tag = ((uint64_t)previous >> 32) + 1;
+    return (int64_t)((tag << 32) | id);
+}
+
+static uint32_t pool_pop(ve_concurrent_pool* pool) {
+    int64_t head = ve_atomic_load64(&pool->head);
+    for (;;) {
+        uint32_t id = (uint32_t)head;
+        if (id == 0) {
+            return 0;
+        }
+
+        /* The link may be stale if another thread took the element; the tag
+           makes the exchange fail in that case */
+        uint32_t next = (uint32_t)ve_atomic_load32(pool_link(pool, id));
+        if (ve_atomic_compare_exchange64(&pool->head, &head, pool_make_head(head, next))) {
+            return id;
+        }
+    }
+}
+
+/* Push a chain already linked from first to last */
+static void pool_push_chain(ve_concurrent_pool* pool, uint32_t first, uint32_t last) {
+    int64_t head = ve_atomic_load64(&pool->head);
+    for (;;) {
+        ve_atomic_store32(pool_link(pool, last), (int32_t)(uint32_t)head);
+        if (ve_atomic_compare_exchange64(&pool->head, &head, pool_make_head(head, first))) {
+            return;
+        }
+    }
+}
+
+/* Add a chunk; returns one of its elements and publishes the rest */
+static uint32_t pool_grow(ve_concurrent_pool* pool) {
+    spin_lock(&pool->grow_lock);
+
+    /* Another thread may have grown the pool while we waited */
+    uint32_t id = pool_pop(pool);
+    if (id != 0) {
+        spin_unlock(&pool->grow_lock);
+        return id;
+    }
+
+    uint32_t chunk_index = (uint32_t)ve_atomic_load32(&pool->chunk_count);
+    if (chunk_index >= pool->max_chunks) {
+        spin_unlock(&pool->grow_lock);
+        VE_LOG_ERROR("Concurrent pool exhausted (%u chunks)", chunk_index);
+        return 0;
+    }
+
+    ve_pool_chunk* chunk = (ve_pool_chunk*)os_map_aligned(pool->chunk_size, pool->chunk_size);
+    if (!chunk) {
+        spin_unlock(&pool->grow_lock);
+        VE_LOG_ERROR("Failed to map %zu byte pool chunk", pool->chunk_size);
+        return 0;
+    }
+    chunk->pool = pool;
+    chunk->index = chunk_index;
+    ve_atomic_store_ptr(&pool->chunks[chunk_index], chunk);
+    ve_atomic_store32(&pool->chunk_count, (int32_t)chunk_index + 1);
+
+    uint32_t first = (chunk_index << pool->chunk_bits) + 1;
+    uint32_t last = first + pool->elements_per_chunk - 1;
+    for (uint32_t i = first + 1; i < last; i++) {
+        ve_atomic_store32(pool_link(pool, i), (int32_t)(i + 1));
+    }
+    if (last > first) {
+        pool_push_chain(pool, first + 1, last);
+    }
+
+    spin_unlock(&pool->grow_lock);
+    return first;
+}
+
+static ve_pool_magazine* pool_thread_magazine(ve_concurrent_pool* pool) {
+    if (t_pool_thread_slot == 0) {
+        t_pool_thread_slot = (uint32_t)ve_atomic_increment32(&g_pool_thread_counter);
+    }
+    return &pool->magazines[(t_pool_thread_slot - 1) % VE_POOL_MAGAZINE_COUNT];
+}
+
+static bool pool_magazine_acquire(ve_pool_magazine* magazine) {
+    int32_t expected = 0;
+    return ve_atomic_load32(&magazine->busy) == 0 &&
+           ve_atomic_compare_exchange32(&magazine->busy, &expected, 1);
+}
+
+ve_concurrent_pool* ve_concurrent_pool_create(size_t element_size, uint32_t elements_per_chunk) {
+    if (element_size == 0) {
+        return NULL;
+    }
+    if (elements_per_chunk == 0) {
+        elements_per_chunk = VE_POOL_DEFAULT_CHUNK_ELEMENTS;
+    }
+
+    ve_concurrent_pool* pool = (ve_concurrent_pool*)aligned_alloc_block(sizeof(ve_concurrent_pool), 64);
+    if (!pool) {
+        return NULL;
+    }
+    memset(pool, 0, sizeof(ve_concurrent_pool));
+
+    /* Round the chunk up to a power of two and fill it */
+    pool->element_size = ve_align_size(element_size, VE_MEMORY_ALIGNMENT);
+    size_t chunk_size = os_page_size();
+    size_t slot_size = pool->element_size + sizeof(uint32_t);
+    while (chunk_size < VE_POOL_CHUNK_HEADER_SIZE + VE_MEMORY_ALIGNMENT + slot_size * elements_per_chunk) {
+        chunk_size <<= 1;
+    }
+    size_t per_chunk = (chunk_size - VE_POOL_CHUNK_HEADER_SIZE - VE_MEMORY_ALIGNMENT) / slot_size;
+    pool->elements_offset = VE_POOL_CHUNK_HEADER_SIZE + ve_align_size(per_chunk * sizeof(uint32_t), VE_MEMORY_ALIGNMENT);
+
+    pool->chunk_bits = floor_log2(per_chunk);
+    if (((size_t)1 << pool->chunk_bits) < per_chunk) {
+        pool->chunk_bits++;
+    }
+    if (pool->chunk_bits >= 31) {
+        aligned_free_block(pool);
+        VE_LOG_ERROR("Concurrent pool chunk of %zu elements is too large", per_chunk);
+        return NULL;
+    }
+
+    pool->chunk_size = chunk_size;
+    pool->elements_per_chunk = (uint32_t)per_chunk;
+    pool->max_chunks = (uint32_t)(((uint64_t)1 << 32) - 1) >> pool->chunk_bits;
+    if (pool->max_chunks > VE_POOL_MAX_CHUNKS) {
+        pool->max_chunks = VE_POOL_MAX_CHUNKS;
+    }
+
+    pool->chunks = (ve_atomic_ptr*)calloc(pool->max_chunks, sizeof(ve_atomic_ptr));
+    if (!pool->chunks) {
+        aligned_free_block(pool);
+        return NULL;
+    }
+
+    return pool;
+}
+
+void ve_concurrent_pool_destroy(ve_concurrent_pool* pool) {
+    if (!pool) {
+        return;
+    }
+
+    uint32_t chunk_count = (uint32_t)ve_atomic_load32(&pool->chunk_count);
+    for (uint32_t i = 0; i < chunk_count; i++) {
+        os_unmap(ve_atomic_load_ptr(&pool->chunks[i]), pool->chunk_size);
+    }
+    free(pool->chunks);
+    aligned_free_block(pool);
+}
+
+void* ve_concurrent_pool_allocate(ve_concurrent_pool* pool) {
+    if (!pool) {
+        return NULL;
+    }
+
+    uint32_t id = 0;
+    ve_pool_magazine* magazine = pool_thread_magazine(pool);
+    if (pool_magazine_acquire(magazine)) {
+        /* Refill half a magazine so the next frees have room */
+        while (magazine->count < VE_POOL_MAGAZINE_SIZE / 2) {
+            uint32_t item = pool_pop(pool);
+            if (item == 0) {
+                break;
+            }
+            magazine->items[magazine->count++] = item;
+        }
+        if (magazine->count > 0) {
+            id = magazine->items[--magazine->count];
+        }
+        ve_atomic_store32(&magazine->busy, 0);
+    } else {
+        id = pool_pop(pool);
+    }
+
+    if (id == 0) {
+        id = pool_grow(pool);
+    }
+    return id != 0 ? pool_element(pool, id) : NULL;
+}
+
+void ve_concurrent_pool_free(ve_concurrent_pool* pool, void* element) {
+    if (!pool || !element) {
+        return;
+    }
+
+    uint32_t id = pool_element_id(pool, element);
+
+    ve_pool_magazine* magazine = pool_thread_magazine(pool);
+    if (pool_magazine_acquire(magazine)) {
+        /* Hand the top half back to the shared list in one exchange */
+        if (magazine->count == VE_POOL_MAGAZINE_SIZE) {
+            uint32_t start = VE_POOL_MAGAZINE_SIZE / 2;
+            for (uint32_t i = start; i + 1 < VE_POOL_MAGAZINE_SIZE; i++) {
+                ve_atomic_store32(pool_link(pool, magazine->items[i]), (int32_t)magazine->items[i + 1]);
+            }
+            pool_push_chain(pool, magazine->items[start], magazine->items[VE_POOL_MAGAZINE_SIZE - 1]);
+            magazine->count = start;
+        }
+        magazine->items[magazine->count++] = id;
+        ve_atomic_store32(&magazine->busy, 0);
+        return;
+    }
+
+    pool_push_chain(pool, id, id);
+}
+
+bool ve_concurrent_pool_contains(const ve_concurrent_pool* pool, const void* ptr) {
+    if (!pool || !ptr) {
+        return false;
+    }
+
+    uint32_t chunk_count = (uint32_t)ve_atomic_load32(&pool->chunk_count);
+    for (uint32_t i = 0; i < chunk_count; i++) {
+        const uint8_t* chunk = (const uint8_t*)ve_atomic_load_ptr(&pool->chunks[i]);
+        const uint8_t* begin = chunk + pool->elements_offset;
+        const uint8_t* end = begin + (size_t)pool->elements_per_chunk * pool->element_size;
+        if ((const uint8_t*)ptr >= begin && (const uint8_t*)ptr < end) {
+            return ((size_t)((const uint8_t*)ptr - begin) % pool->element_size) == 0;
+        }
+    }
+    return false;
+}
+
+size_t ve_concurrent_pool_get_capacity(const ve_concurrent_pool* pool) {
+    if (!pool) {
+        return 0;
+    }
+    return (size_t)ve_atomic_load32(&pool->chunk_count) * pool->elements_per_chunk;
+}
+
 /* Alignment utilities */
 
 size_t ve_align_size(size_t size, size_t alignment) {
@@ -471,34 +1771,63 @@ bool ve_is_aligned(const void* ptr, size_t alignment) {
 
 bool ve_memory_validate(void) {
     /* Validate all tracked allocations */
-    ve_allocation_header* hdr = g_memory.allocation_list;
-    while (hdr) {
-        /* Basic validation - could add more checks */
-        if (hdr->size == 0 || hdr->tag >= VE_MEMORY_TAG_MAX) {
-            return false;
+    bool valid = true;
+
+#if defined(VE_MEMORY_TRACKING)
+    for (int i = 0; i < VE_MEMORY_TRACKING_SHARDS && valid; i++) {
+        ve_allocation_shard* shard = &g_allocator.shards[i];
+        spin_lock(&shard->lock);
+
+        for (ve_allocation_header* hdr = shard->head; hdr; hdr = hdr->next) {
+            /* Basic validation - could add more checks */
+            uint32_t magic = slab_from_pointer(hdr)->magic;
+            if (hdr->size == 0 || hdr->tag >= VE_MEMORY_TAG_MAX || get_shard(hdr) != shard ||
+                (magic != VE_SLAB_MAGIC && magic != VE_LARGE_MAGIC)) {
+                valid = false;
+                break;
+            }
         }
-        hdr = hdr->next;
+
+        spin_unlock(&shard->lock);
     }
-    return true;
+#endif
+
+    return valid;
 }
 
 void ve_memory_dump_stats(ve_memory_tag tag) {
+    ve_memory_stats stats = ve_memory_get_stats();
+
     if (tag == VE_MEMORY_TAG_UNKNOWN) {
         VE_LOG_INFO("=== Memory Statistics ===");
-        VE_LOG_INFO("Total allocated: %zu bytes", g_memory.stats.total_allocated);
-        VE_LOG_INFO("Total freed: %zu bytes", g_memory.stats.total_freed);
-        VE_LOG_INFO("Current allocations: %zu", g_memory.stats.allocation_count);
+        VE_LOG_INFO("Total allocated: %zu bytes", stats.total_allocated);
+        VE_LOG_INFO("Total freed: %zu bytes", stats.total_freed);
+        VE_LOG_INFO("Current allocations: %zu", stats.allocation_count);
+        VE_LOG_INFO("External memory: %zu bytes", stats.external_usage);
 
         for (int i = 0; i < VE_MEMORY_TAG_MAX; i++) {
-            if (g_memory.stats.tag_usage[i] > 0) {
-                VE_LOG_INFO("Tag %d: %zu bytes", i, g_memory.stats.tag_usage[i]);
+            if (stats.tag_usage[i] > 0) {
+                VE_LOG_INFO("Tag %d: %zu bytes", i, stats.tag_usage[i]);
             }
         }
     } else {
-        VE_LOG_INFO("Tag %d usage: %zu bytes", tag, g_memory.stats.tag_usage[tag]);
+        VE_LOG_INFO("Tag %d usage: %zu bytes", tag, stats.tag_usage[tag]);
     }
 }
 
 bool ve_memory_check_leaks(void) {
-    return g_memory.allocation_list != NULL;
+#if defined(VE_MEMORY_TRACKING)
+    bool leaks = false;
+
+    for (int i = 0; i < VE_MEMORY_TRACKING_SHARDS && !leaks; i++) {
+        ve_allocation_shard* shard = &g_allocator.shards[i];
+        spin_lock(&shard->lock);
+        leaks = shard->head != NULL;
+        spin_unlock(&shard->lock);
+    }
+
+    return leaks;
+#else
+    return ve_memory_get_stats().allocation_count != 0;
+#endif
 }
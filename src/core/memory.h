@@ -7,6 +7,7 @@
 #define VE_MEMORY_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -31,8 +32,30 @@ typedef enum ve_memory_tag {
     VE_MEMORY_TAG_MAX
 } ve_memory_tag;
 
+/**
+ * @brief Arena creation flags
+ */
+typedef enum ve_arena_flags {
+    VE_ARENA_FLAG_NONE              = 0,
+    VE_ARENA_FLAG_DECOMMIT_ON_RESET = 1 << 0,  /* Give pages back to the OS on reset */
+    VE_ARENA_FLAG_CHAINED           = 1 << 1,  /* Chain heap blocks instead of reserving address space */
+} ve_arena_flags;
+
+/**
+ * @brief Arena backing kind
+ */
+typedef enum ve_arena_kind {
+    VE_ARENA_KIND_FIXED = 0,  /* Single block, allocations fail when full */
+    VE_ARENA_KIND_VIRTUAL,    /* Reserved range, pages committed on demand */
+    VE_ARENA_KIND_CHAINED,    /* Linked list of heap blocks */
+} ve_arena_kind;
+
 /**
  * @brief Arena allocator for temporary allocations
+ *
+ * memory and capacity always describe the block the arena is currently
+ * bumping in; used is the position across all blocks and block_base is the
+ * position at which the current block starts.
  */
 typedef struct ve_arena {
     void* memory;
@@ -40,6 +63,12 @@ typedef struct ve_arena {
     size_t used;
     size_t alignment;
     struct ve_arena* parent;  /* For arena hierarchy */
+    ve_arena_kind kind;
+    unsigned int flags;
+    size_t reserved;          /* Address space reserved (virtual arenas) */
+    size_t block_base;
+    size_t high_water_mark;
+    struct ve_arena_block* block;  /* Current block (chained arenas) */
 } ve_arena;
 
 /**
@@ -53,6 +82,13 @@ typedef struct ve_pool {
     void* free_list;  /* Linked list of free blocks */
 } ve_pool;
 
+/**
+ * @brief Thread-safe pool for fixed-size allocations
+ *
+ * Grows by whole chunks and never shrinks until destroyed.
+ */
+typedef struct ve_concurrent_pool ve_concurrent_pool;
+
 /**
  * @brief Memory statistics
  */
@@ -60,6 +96,7 @@ typedef struct ve_memory_stats {
     size_t total_allocated;
     size_t total_freed;
     size_t allocation_count;
+    size_t external_usage;          /* Bytes recorded with ve_memory_record_external */
     size_t tag_usage[VE_MEMORY_TAG_MAX];
 } ve_memory_stats;
 
@@ -78,6 +115,10 @@ void ve_memory_shutdown(void);
 /**
  * @brief Allocate memory with tracking
  *
+ * Requests up to 32 KB are served from size-class slabs owned by the calling
+ * thread; larger ones are mapped directly from the OS. Memory may be freed
+ * from any thread.
+ *
  * @param size Size in bytes
  * @param tag Memory tag for tracking
  * @return Pointer to allocated memory, or NULL on failure
@@ -132,6 +173,18 @@ ve_memory_stats ve_memory_get_stats(void);
  */
 void ve_memory_reset_stats(void);
 
+/**
+ * @brief Account for memory not allocated through ve_allocate
+ *
+ * Adds delta to the tag usage and to external_usage, so memory such as
+ * device allocations appears in ve_memory_get_stats without counting as a
+ * host allocation.
+ *
+ * @param tag Memory tag for tracking
+ * @param delta Bytes allocated (positive) or released (negative)
+ */
+void ve_memory_record_external(ve_memory_tag tag, int64_t delta);
+
 /* Arena allocator functions */
 
 /**
@@ -144,6 +197,21 @@ void ve_memory_reset_stats(void);
  */
 ve_arena* ve_arena_create(size_t capacity, size_t alignment, ve_arena* parent);
 
+/**
+ * @brief Create an arena that grows instead of failing
+ *
+ * Reserves reserve_size bytes of address space and commits pages as the
+ * arena grows. Where reservation is unavailable, or with
+ * VE_ARENA_FLAG_CHAINED, the arena chains heap blocks instead and has no
+ * upper bound.
+ *
+ * @param reserve_size Address space to reserve in bytes
+ * @param alignment Memory alignment (default 16)
+ * @param flags Combination of ve_arena_flags
+ * @return New arena, or NULL on failure
+ */
+ve_arena* ve_arena_create_growable(size_t reserve_size, size_t alignment, unsigned int flags);
+
 /**
  * @brief Destroy an arena allocator
  *
@@ -163,6 +231,10 @@ void* ve_arena_allocate(ve_arena* arena, size_t size);
 /**
  * @brief Reset arena (free all allocations)
  *
+ * Chained arenas release all blocks but the first, which is regrown to the
+ * high-water mark so the next frame fits in one block. With
+ * VE_ARENA_FLAG_DECOMMIT_ON_RESET committed pages go back to the OS.
+ *
  * @param arena Arena to reset
  */
 void ve_arena_reset(ve_arena* arena);
@@ -175,6 +247,14 @@ void ve_arena_reset(ve_arena* arena);
  */
 size_t ve_arena_get_usage(const ve_arena* arena);
 
+/**
+ * @brief Get the highest position the arena has reached since creation
+ *
+ * @param arena Arena allocator
+ * @return High-water mark in bytes
+ */
+size_t ve_arena_get_high_water_mark(const ve_arena* arena);
+
 /**
  * @brief Create a memory snapshot for rollback
  *
@@ -215,6 +295,54 @@ void ve_arena_set_position(ve_arena* arena, size_t position);
  */
 ve_arena* ve_arena_get_thread_arena(void);
 
+/* Frame allocator functions */
+
+#define VE_FRAME_ALLOCATOR_MAX_SLOTS 4
+
+/**
+ * @brief Create one growable arena per frame slot
+ *
+ * Memory from ve_frame_allocate stays valid until the same slot begins
+ * again, i.e. until the GPU has finished with the frame that used it.
+ *
+ * @param slot_count Number of slots (frames in flight)
+ * @param reserve_size Address space to reserve per slot
+ * @return true on success
+ */
+bool ve_frame_allocator_init(uint32_t slot_count, size_t reserve_size);
+
+/**
+ * @brief Destroy the frame arenas
+ */
+void ve_frame_allocator_shutdown(void);
+
+/**
+ * @brief Reset a slot and make it the target of ve_frame_allocate
+ *
+ * Call once the GPU is done with the slot's previous frame.
+ *
+ * @param slot Slot index
+ */
+void ve_frame_allocator_begin(uint32_t slot);
+
+/**
+ * @brief Allocate memory that lives until the current slot is reused
+ *
+ * Safe to call from any thread.
+ *
+ * @param size Size in bytes
+ * @return Pointer to memory, or NULL on failure
+ */
+void* ve_frame_allocate(size_t size);
+
+/**
+ * @brief Get the arena backing a slot
+ *
+ * @param slot Slot index
+ * @return Arena, or NULL if the slot does not exist
+ */
+ve_arena* ve_frame_allocator_get_arena(uint32_t slot);
+
 /* Memory pool functions */
 
 /**
@@ -265,6 +393,62 @@ void ve_pool_reset(ve_pool* pool);
  */
 bool ve_pool_contains(const ve_pool* pool, const void* ptr);
 
+/* Concurrent pool functions */
+
+/**
+ * @brief Create a thread-safe memory pool
+ *
+ * Free elements are kept on a lock-free list, with small per-thread caches
+ * in front of it. The pool grows by one chunk whenever it runs dry.
+ *
+ * @param element_size Size of each element
+ * @param elements_per_chunk Minimum elements added per growth (0 for default)
+ * @return New pool, or NULL on failure
+ */
+ve_concurrent_pool* ve_concurrent_pool_create(size_t element_size, uint32_t elements_per_chunk);
+
+/**
+ * @brief Destroy a thread-safe memory pool
+ *
+ * No other thread may use the pool during or after this call.
+ *
+ * @param pool Pool to destroy
+ */
+void ve_concurrent_pool_destroy(ve_concurrent_pool* pool);
+
+/**
+ * @brief Allocate from a thread-safe pool
+ *
+ * @param pool Memory pool
+ * @return Pointer to element, or NULL on failure
+ */
+void* ve_concurrent_pool_allocate(ve_concurrent_pool* pool);
+
+/**
+ * @brief Return an element to a thread-safe pool, from any thread
+ *
+ * @param pool Memory pool
+ * @param element Element to free
+ */
+void ve_concurrent_pool_free(ve_concurrent_pool* pool, void* element);
+
+/**
+ * @brief Check if pointer is an element of a thread-safe pool
+ *
+ * @param pool Memory pool
+ * @param ptr Pointer to check
+ * @return true if pointer is from this pool
+ */
+bool ve_concurrent_pool_contains(const ve_concurrent_pool* pool, const void* ptr);
+
+/**
+ * @brief Get the number of elements the pool can hold without growing
+ *
+ * @param pool Memory pool
+ * @return Capacity in elements
+ */
+size_t ve_concurrent_pool_get_capacity(const ve_concurrent_pool* pool);
+
 /* Alignment utilities */
 
 /**
@@ -0,0 +1,599 @@
+/**
+ * @file profiler.c
+ * @brief Built-in hierarchical CPU profiler implementation
+ */
+
+#include "profiler.h"
+#include "logger.h"
+#include "json.h"
+#include "memory.h"
+#include "thread.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32) || defined(_WIN64)
+    #define THREAD_LOCAL __declspec(thread)
+#else
+    #define THREAD_LOCAL __thread
+#endif
+
+#define VE_PROFILER_RING_MASK (VE_PROFILER_RING_SIZE - 1)
+#define VE_PROFILER_HASH_SIZE (VE_PROFILER_MAX_ZONES * 2)  /* Power of two */
+#define VE_PROFILER_MAX_THREADS 256
+#define VE_PROFILER_THREAD_NAME_SIZE 32
+#define VE_PROFILER_NO_ENTRY UINT16_MAX
+
+/**
+ * @brief Closed zone as stored in the thread rings and the capture
+ */
+typedef struct ve_profiler_event {
+    const char* name;
+    const char* parent;
+    const char* track;      /* NULL for zones recorded by CPU threads */
+    ve_timestamp start;
+    ve_timestamp end;
+    uint32_t depth;
+    uint32_t thread_index;
+} ve_profiler_event;
+
+/**
+ * @brief Zone that has been opened but not closed yet
+ */
+typedef struct ve_profiler_open_zone {
+    const char* name;
+    ve_timestamp start;
+} ve_profiler_open_zone;
+
+/**
+ * @brief Per-thread recording state
+ *
+ * The ring is single-producer/single-consumer: the owning thread advances
+ * head, the thread calling ve_profiler_end_frame advances tail.
+ */
+typedef struct ve_profiler_thread {
+    ve_profiler_event events[VE_PROFILER_RING_SIZE];
+    ve_atomic_int64 head;
+    ve_atomic_int64 tail;
+    ve_atomic_int32 abandoned;  /* Set once the owning thread has exited */
+    ve_profiler_open_zone stack[VE_PROFILER_MAX_DEPTH];
+    uint32_t depth;             /* Open zones, including ones past VE_PROFILER_MAX_DEPTH */
+    uint32_t index;
+    struct ve_profiler_thread* next;
+} ve_profiler_thread;
+
+/**
+ * @brief Aggregation entry for one (name, parent, depth, track) key
+ */
+typedef struct ve_profiler_zone {
+    const char* name;
+    const char* parent;
+    const char* track;
+    uint32_t depth;
+    uint32_t calls;
+    ve_timestamp total;
+    ve_timestamp min;
+    ve_timestamp max;
+} ve_profiler_zone;
+
+/* Profiler state */
+static struct {
+    ve_atomic_int32 generation;  /* 0 while the profiler is not initialized */
+    ve_atomic_int32 enabled;
+    ve_atomic_int64 dropped;
+    ve_mutex* threads_mutex;
+    ve_tls_key* thread_key;
+    ve_profiler_thread* threads;
+    uint32_t thread_count;
+    char thread_names[VE_PROFILER_MAX_THREADS][VE_PROFILER_THREAD_NAME_SIZE];
+
+    /* Frame aggregation, owned by the thread calling ve_profiler_end_frame */
+    ve_timestamp frame_start;
+    ve_timestamp frame_time;
+    ve_profiler_zone zones[VE_PROFILER_MAX_ZONES];
+    uint16_t zone_hash[VE_PROFILER_HASH_SIZE];
+    uint32_t zone_count;
+    ve_profile_zone_stats stats[VE_PROFILER_MAX_ZONES];
+    uint32_t stats_count;
+
+    /* Trace capture */
+    ve_profiler_event* capture;
+    uint32_t capture_capacity;
+    uint32_t capture_count;
+    ve_timestamp capture_start;
+    bool capturing;
+} g_profiler = {0};
+
+static int32_t g_profiler_generation_counter = 0;
+
+/* Calling thread's state, valid while t_profiler_generation matches */
+static THREAD_LOCAL ve_profiler_thread* t_profiler_thread = NULL;
+static THREAD_LOCAL int32_t t_profiler_generation = 0;
+
+/* Thread registration */
+
+/**
+ * @brief TLS destructor: hand the buffer over to the aggregating thread
+ */
+static void profiler_thread_exit(void* value) {
+    ve_profiler_thread* thread = (ve_profiler_thread*)value;
+    if (thread) {
+        ve_atomic_store32(&thread->abandoned, 1);
+    }
+    t_profiler_thread = NULL;
+    t_profiler_generation = 0;
+}
+
+static ve_profiler_thread* profiler_register_thread(int32_t generation) {
+    ve_profiler_thread* thread = (ve_profiler_thread*)VE_ALLOCATE_TAG(sizeof(ve_profiler_thread),
+                                                                      VE_MEMORY_TAG_CORE);
+    if (!thread) {
+        return NULL;
+    }
+    memset(thread, 0, sizeof(ve_profiler_thread));
+
+    ve_mutex_lock(g_profiler.threads_mutex);
+    thread->index = g_profiler.thread_count++;
+    if (thread->index < VE_PROFILER_MAX_THREADS) {
+        char* name = g_profiler.thread_names[thread->index];
+        if (!ve_thread_get_name(name, VE_PROFILER_THREAD_NAME_SIZE) || name[0] == '\0') {
+            snprintf(name, VE_PROFILER_THREAD_NAME_SIZE, "Thread %u", thread->index);
+        }
+    }
+    thread->next = g_profiler.threads;
+    g_profiler.threads = thread;
+    ve_mutex_unlock(g_profiler.threads_mutex);
+
+    ve_tls_set(g_profiler.thread_key, thread);
+    t_profiler_thread = thread;
+    t_profiler_generation = generation;
+    return thread;
+}
+
+static inline ve_profiler_thread* profiler_get_thread(void) {
+    int32_t generation = ve_atomic_load32(&g_profiler.generation);
+    if (generation == 0) {
+        return NULL;
+    }
+    if (t_profiler_generation == generation) {
+        return t_profiler_thread;
+    }
+    return profiler_register_thread(generation);
+}
+
+/* Lifecycle */
+
+bool ve_profiler_init(void) {
+    if (ve_atomic_load32(&g_profiler.generation) != 0) {
+        return true;
+    }
+
+    g_profiler.threads_mutex = ve_mutex_create();
+    if (!g_profiler.threads_mutex) {
+        VE_LOG_ERROR("Failed to create profiler mutex");
+        return false;
+    }
+
+    g_profiler.thread_key = ve_tls_create(profiler_thread_exit);
+    if (!g_profiler.thread_key) {
+        VE_LOG_ERROR("Failed to create profiler thread key");
+        ve_mutex_destroy(g_profiler.threads_mutex);
+        g_profiler.threads_mutex = NULL;
+        return false;
+    }
+
+    g_profiler.threads = NULL;
+    g_profiler.thread_count = 0;
+    g_profiler.frame_start = 0;
+    g_profiler.frame_time = 0;
+    g_profiler.zone_count = 0;
+    g_profiler.stats_count = 0;
+    ve_atomic_store64(&g_profiler.dropped, 0);
+    ve_atomic_store32(&g_profiler.enabled, 1);
+    ve_atomic_store32(&g_profiler.generation, ++g_profiler_generation_counter);
+
+    VE_LOG_INFO("Profiler initialized");
+    return true;
+}
+
+void ve_profiler_shutdown(void) {
+    if (ve_atomic_load32(&g_profiler.generation) == 0) {
+        return;
+    }
+    ve_atomic_store32(&g_profiler.generation, 0);
+
+    ve_profiler_thread* thread = g_profiler.threads;
+    while (thread) {
+        ve_profiler_thread* next = thread->next;
+        VE_FREE(thread);
+        thread = next;
+    }
+    g_profiler.threads = NULL;
+
+    if (g_profiler.capture) {
+        VE_FREE(g_profiler.capture);
+        g_profiler.capture = NULL;
+    }
+    g_profiler.capture_capacity = 0;
+    g_profiler.capture_count = 0;
+    g_profiler.capturing = false;
+
+    ve_tls_destroy(g_profiler.thread_key);
+    g_profiler.thread_key = NULL;
+    ve_mutex_destroy(g_profiler.threads_mutex);
+    g_profiler.threads_mutex = NULL;
+
+    t_profiler_thread = NULL;
+    t_profiler_generation = 0;
+
+    VE_LOG_INFO("Profiler shutdown");
+}
+
+void ve_profiler_set_enabled(bool enabled) {
+    ve_atomic_store32(&g_profiler.enabled, enabled ? 1 : 0);
+}
+
+bool ve_profiler_is_enabled(void) {
+    return ve_atomic_load32(&g_profiler.enabled) != 0;
+}
+
+/* Zone recording */
+
+void ve_profiler_begin_zone(const char* name) {
+    if (!ve_atomic_load32(&g_profiler.enabled)) {
+        return;
+    }
+
+    ve_profiler_thread* thread = profiler_get_thread();
+    if (!thread) {
+        return;
+    }
+
+    if (thread->depth < VE_PROFILER_MAX_DEPTH) {
+        ve_profiler_open_zone* zone = &thread->stack[thread->depth];
+        zone->name = name;
+        zone->start = ve_timer_now();
+    }
+    thread->depth++;
+}
+
+void ve_profiler_end_zone(void) {
+    ve_timestamp end = ve_timer_now();
+
+    ve_profiler_thread* thread = profiler_get_thread();
+    if (!thread || thread->depth == 0) {
+        return;
+    }
+
+    uint32_t depth = --thread->depth;
+    if (depth >= VE_PROFILER_MAX_DEPTH) {
+        return;
+    }
+
+    int64_t head = ve_atomic_load64(&thread->head);
+    if (head - ve_atomic_load64(&thread->tail) >= VE_PROFILER_RING_SIZE) {
+        ve_atomic_fetch_add64(&g_profiler.dropped, 1);
+        return;
+    }
+
+    ve_profiler_event* event = &thread->events[head & VE_PROFILER_RING_MASK];
+    event->name = thread->stack[depth].name;
+    event->parent = depth > 0 ? thread->stack[depth - 1].name : NULL;
+    event->track = NULL;
+    event->start = thread->stack[depth].start;
+    event->end = end;
+    event->depth = depth;
+    event->thread_index = thread->index;
+    ve_atomic_store64(&thread->head, head + 1);
+}
+
+ve_profile_scope ve_profile_scope_begin(const char* name) {
+    ve_profile_scope scope;
+    scope.name = name;
+    scope.start = ve_timer_now();
+    ve_profiler_begin_zone(name);
+    return scope;
+}
+
+void ve_profile_scope_end(ve_profile_scope* scope) {
+    (void)scope;
+    ve_profiler_end_zone();
+}
+
+void ve_profile_scope_end_log(ve_profile_scope* scope) {
+    ve_profiler_end_zone();
+    double elapsed = ve_timer_elapsed(scope->start, ve_timer_now());
+    VE_LOG_DEBUG("Timer: %s took %.6f seconds", scope->name, elapsed);
+}
+
+uint32_t ve_profiler_register_track(const char* name) {
+    if (ve_atomic_load32(&g_profiler.generation) == 0) {
+        return UINT32_MAX;
+    }
+
+    ve_mutex_lock(g_profiler.threads_mutex);
+    uint32_t track = UINT32_MAX;
+    if (g_profiler.thread_count < VE_PROFILER_MAX_THREADS) {
+        track = g_profiler.thread_count++;
+        snprintf(g_profiler.thread_names[track], VE_PROFILER_THREAD_NAME_SIZE, "%s", name);
+    }
+    ve_mutex_unlock(g_profiler.threads_mutex);
+
+    if (track == UINT32_MAX) {
+        VE_LOG_WARN("Profiler track limit reached, dropping track %s", name);
+    }
+    return track;
+}
+
+void ve_profiler_record_zone(uint32_t track, const char* name, const char* parent, uint32_t depth,
+                             ve_timestamp start, ve_timestamp end) {
+    if (track >= VE_PROFILER_MAX_THREADS || !ve_atomic_load32(&g_profiler.enabled)) {
+        return;
+    }
+
+    ve_profiler_thread* thread = profiler_get_thread();
+    if (!thread) {
+        return;
+    }
+
+    int64_t head = ve_atomic_load64(&thread->head);
+    if (head - ve_atomic_load64(&thread->tail) >= VE_PROFILER_RING_SIZE) {
+        ve_atomic_fetch_add64(&g_profiler.dropped, 1);
+        return;
+    }
+
+    ve_profiler_event* event = &thread->events[head & VE_PROFILER_RING_MASK];
+    event->name = name;
+    event->parent = parent;
+    event->track = g_profiler.thread_names[track];
+    event->start = start;
+    event->end = end;
+    event->depth = depth;
+    event->thread_index = track;
+    ve_atomic_store64(&thread->head, head + 1);
+}
+
+/* Frame aggregation */
+
+static inline uint32_t profiler_hash(const char* name, uint32_t depth) {
+    uint64_t key = (uint64_t)(uintptr_t)name ^ ((uint64_t)depth * 0x9E3779B97F4A7C15ull);
+    key ^= key >> 29;
+    key *= 0xBF58476D1CE4E5B9ull;
+    key ^= key >> 32;
+    return (uint32_t)key & (VE_PROFILER_HASH_SIZE - 1);
+}
+
+static void profiler_aggregate_event(const ve_profiler_event* event) {
+    ve_timestamp duration = event->end - event->start;
+    uint32_t slot = profiler_hash(event->name, event->depth);
+
+    for (;;) {
+        uint16_t entry = g_profiler.zone_hash[slot];
+        if (entry == VE_PROFILER_NO_ENTRY) {
+            break;
+        }
+        ve_profiler_zone* zone = &g_profiler.zones[entry];
+        if (zone->name == event->name && zone->parent == event->parent &&
+            zone->depth == event->depth && zone->track == event->track) {
+            zone->calls++;
+            zone->total += duration;
+            if (duration < zone->min) zone->min = duration;
+            if (duration > zone->max) zone->max = duration;
+            return;
+        }
+        slot = (slot + 1) & (VE_PROFILER_HASH_SIZE - 1);
+    }
+
+    if (g_profiler.zone_count >= VE_PROFILER_MAX_ZONES) {
+        return;
+    }
+
+    uint16_t entry = (uint16_t)g_profiler.zone_count++;
+    ve_profiler_zone* zone = &g_profiler.zones[entry];
+    zone->name = event->name;
+    zone->parent = event->parent;
+    zone->track = event->track;
+    zone->depth = event->depth;
+    zone->calls = 1;
+    zone->total = duration;
+    zone->min = duration;
+    zone->max = duration;
+    g_profiler.zone_hash[slot] = entry;
+}
+
+/**
+ * @brief Find the first aggregated zone with the given name at the given depth on a track
+ */
+static uint32_t profiler_find_zone(const char* name, uint32_t depth, const char* track) {
+    uint32_t slot = profiler_hash(name, depth);
+    for (;;) {
+        uint16_t entry = g_profiler.zone_hash[slot];
+        if (entry == VE_PROFILER_NO_ENTRY) {
+            return UINT32_MAX;
+        }
+        const ve_profiler_zone* zone = &g_profiler.zones[entry];
+        if (zone->name == name && zone->depth == depth && zone->track == track) {
+            return entry;
+        }
+        slot = (slot + 1) & (VE_PROFILER_HASH_SIZE - 1);
+    }
+}
+
+static void profiler_capture_event(const ve_profiler_event* event) {
+    if (g_profiler.capturing && g_profiler.capture_count < g_profiler.capture_capacity) {
+        g_profiler.capture[g_profiler.capture_count++] = *event;
+    }
+}
+
+void ve_profiler_begin_frame(void) {
+    g_profiler.frame_start = ve_timer_now();
+}
+
+void ve_profiler_end_frame(void) {
+    ve_profiler_thread* self = profiler_get_thread();
+    if (!self) {
+        return;
+    }
+
+    ve_timestamp frame_end = ve_timer_now();
+    g_profiler.frame_time = g_profiler.frame_start ? frame_end - g_profiler.frame_start : 0;
+
+    g_profiler.zone_count = 0;
+    memset(g_profiler.zone_hash, 0xFF, sizeof(g_profiler.zone_hash));
+
+    ve_mutex_lock(g_profiler.threads_mutex);
+    ve_profiler_thread** link = &g_profiler.threads;
+    while (*link) {
+        ve_profiler_thread* thread = *link;
+        bool abandoned = ve_atomic_load32(&thread->abandoned) != 0;
+        int64_t head = ve_atomic_load64(&thread->head);
+        int64_t tail = ve_atomic_load64(&thread->tail);
+
+        for (; tail < head; tail++) {
+            const ve_profiler_event* event = &thread->events[tail & VE_PROFILER_RING_MASK];
+            profiler_aggregate_event(event);
+            profiler_capture_event(event);
+        }
+        ve_atomic_store64(&thread->tail, tail);
+
+        if (abandoned) {
+            *link = thread->next;
+            VE_FREE(thread);
+        } else {
+            link = &thread->next;
+        }
+    }
+    ve_mutex_unlock(g_profiler.threads_mutex);
+
+    if (g_profiler.frame_start) {
+        ve_profiler_event frame = {
+            .name = "Frame",
+            .parent = NULL,
+            .track = NULL,
+            .start = g_profiler.frame_start,
+            .end = frame_end,
+            .depth = 0,
+            .thread_index = self->index,
+        };
+        profiler_capture_event(&frame);
+    }
+
+    for (uint32_t i = 0; i < g_profiler.zone_count; i++) {
+        const ve_profiler_zone* zone = &g_profiler.zones[i];
+        ve_profile_zone_stats* stats = &g_profiler.stats[i];
+        stats->name = zone->name;
+        stats->parent = zone->parent;
+        stats->track = zone->track;
+        stats->parent_index = zone->depth > 0
+                            ? profiler_find_zone(zone->parent, zone->depth - 1, zone->track)
+                            : UINT32_MAX;
+        stats->depth = zone->depth;
+        stats->calls = zone->calls;
+        stats->total_ms = ve_timer_to_milliseconds(zone->total);
+        stats->min_ms = ve_timer_to_milliseconds(zone->min);
+        stats->max_ms = ve_timer_to_milliseconds(zone->max);
+        stats->avg_ms = stats->total_ms / (double)zone->calls;
+    }
+    g_profiler.stats_count = g_profiler.zone_count;
+}
+
+uint32_t ve_profiler_get_zone_stats(ve_profile_zone_stats* stats, uint32_t max_count) {
+    if (stats) {
+        uint32_t count = g_profiler.stats_count < max_count ? g_profiler.stats_count : max_count;
+        memcpy(stats, g_profiler.stats, count * sizeof(ve_profile_zone_stats));
+    }
+    return g_profiler.stats_count;
+}
+
+double ve_profiler_get_frame_time_ms(void) {
+    return ve_timer_to_milliseconds(g_profiler.frame_time);
+}
+
+uint64_t ve_profiler_get_dropped_count(void) {
+    return (uint64_t)ve_atomic_load64(&g_profiler.dropped);
+}
+
+/* Trace capture */
+
+bool ve_profiler_start_capture(uint32_t max_events) {
+    if (max_events == 0) {
+        return false;
+    }
+
+    if (max_events != g_profiler.capture_capacity) {
+        ve_profiler_event* capture = (ve_profiler_event*)VE_ALLOCATE_TAG(
+            (size_t)max_events * sizeof(ve_profiler_event), VE_MEMORY_TAG_CORE);
+        if (!capture) {
+            VE_LOG_ERROR("Failed to allocate profiler capture for %u events", max_events);
+            return false;
+        }
+        if (g_profiler.capture) {
+            VE_FREE(g_profiler.capture);
+        }
+        g_profiler.capture = capture;
+        g_profiler.capture_capacity = max_events;
+    }
+
+    g_profiler.capture_count = 0;
+    g_profiler.capture_start = ve_timer_now();
+    g_profiler.capturing = true;
+    return true;
+}
+
+void ve_profiler_stop_capture(void) {
+    g_profiler.capturing = false;
+}
+
+uint32_t ve_profiler_get_capture_count(void) {
+    return g_profiler.capture_count;
+}
+
+bool ve_profiler_export_chrome_trace(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        VE_LOG_ERROR("Failed to open trace file: %s", path);
+        return false;
+    }
+
+    double base = ve_timer_to_seconds(g_profiler.capture_start);
+    bool first = true;
+
+    fputs("{\"traceEvents\":[\n", file);
+
+    ve_mutex_lock(g_profiler.threads_mutex);
+    uint32_t thread_count = g_profiler.thread_count < VE_PROFILER_MAX_THREADS
+                          ? g_profiler.thread_count : VE_PROFILER_MAX_THREADS;
+    for (uint32_t i = 0; i < thread_count; i++) {
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+                first ? "" : ",\n", i);
+        ve_json_write_string(file, g_profiler.thread_names[i]);
+        fputs("}}", file);
+        first = false;
+    }
+    ve_mutex_unlock(g_profiler.threads_mutex);
+
+    for (uint32_t i = 0; i < g_profiler.capture_count; i++) {
+        const ve_profiler_event* event = &g_profiler.capture[i];
+        double ts = (ve_timer_to_seconds(event->start) - base) * 1e6;
+        double dur = ve_timer_to_seconds(event->end - event->start) * 1e6;
+        fprintf(file, "%s{\"name\":", first ? "" : ",\n");
+        ve_json_write_string(file, event->name);
+        fprintf(file, ",\"cat\":\"cpu\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                ts, dur, event->thread_index);
+        first = false;
+    }
+
+    fputs("\n],\"displayTimeUnit\":\"ms\"}\n", file);
+
+    bool success = ferror(file) == 0;
+    if (fclose(file) != 0) {
+        success = false;
+    }
+    if (!success) {
+        VE_LOG_ERROR("Failed to write trace file: %s", path);
+        return false;
+    }
+
+    VE_LOG_INFO("Exported %u profiler events to %s", g_profiler.capture_count, path);
+    return true;
+}
@@ -0,0 +1,264 @@
+/**
+ * @file profiler.h
+ * @brief Built-in hierarchical CPU profiler
+ *
+ * Zones are recorded with ve_timer_now into a per-thread ring buffer, so
+ * opening and closing a zone never takes a lock. Once per frame the rings
+ * are drained and aggregated into per-zone statistics (call count, total,
+ * min/avg/max per call), keyed by the zone name and its parent so the
+ * call hierarchy is preserved. Drained events can optionally be kept in a
+ * capture buffer and exported in the Chrome trace event format, which
+ * chrome://tracing and Perfetto load directly.
+ */
+
+#ifndef VE_PROFILER_H
+#define VE_PROFILER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "timer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Profiler limits */
+#define VE_PROFILER_RING_SIZE 8192      /* Events buffered per thread between frames */
+#define VE_PROFILER_MAX_DEPTH 64        /* Deepest zone nesting that is recorded */
+#define VE_PROFILER_MAX_ZONES 512       /* Distinct zones aggregated per frame */
+
+/**
+ * @brief Aggregated statistics for one zone over the last frame
+ */
+typedef struct ve_profile_zone_stats {
+    const char* name;       /* Zone name */
+    const char* parent;     /* Enclosing zone name, NULL for root zones */
+    const char* track;      /* Track name for zones from ve_profiler_record_zone, NULL for CPU zones */
+    uint32_t parent_index;  /* Index of the parent entry, UINT32_MAX for root zones */
+    uint32_t depth;         /* Nesting depth, 0 for root zones */
+    uint32_t calls;         /* Number of times the zone closed this frame */
+    double total_ms;        /* Summed duration of all calls */
+    double min_ms;          /* Shortest call */
+    double avg_ms;          /* Mean call duration */
+    double max_ms;          /* Longest call */
+} ve_profile_zone_stats;
+
+/**
+ * @brief Scope state used by the cleanup-based timing macros
+ */
+typedef struct ve_profile_scope {
+    const char* name;
+    ve_timestamp start;
+} ve_profile_scope;
+
+/**
+ * @brief Initialize the profiler
+ *
+ * @return true on success
+ */
+bool ve_profiler_init(void);
+
+/**
+ * @brief Shutdown the profiler and release all thread buffers
+ */
+void ve_profiler_shutdown(void);
+
+/**
+ * @brief Enable or disable zone recording at runtime
+ *
+ * @param enabled true to record zones
+ */
+void ve_profiler_set_enabled(bool enabled);
+
+/**
+ * @brief Check if zone recording is enabled
+ *
+ * @return true if zones are recorded
+ */
+bool ve_profiler_is_enabled(void);
+
+/**
+ * @brief Open a zone on the calling thread
+ *
+ * @param name Zone name; must outlive the profiler (normally a string literal)
+ */
+void ve_profiler_begin_zone(const char* name);
+
+/**
+ * @brief Close the innermost open zone on the calling thread
+ */
+void ve_profiler_end_zone(void);
+
+/**
+ * @brief Register a named timeline for zones that are not measured by a CPU
+ *        thread, e.g. GPU queue timestamps
+ *
+ * @param name Track name shown in traces
+ * @return Track id, or UINT32_MAX on failure
+ */
+uint32_t ve_profiler_register_track(const char* name);
+
+/**
+ * @brief Record an already measured zone on a track
+ *
+ * The zone is aggregated with the frame in which it is recorded.
+ *
+ * @param track Track id from ve_profiler_register_track
+ * @param name Zone name; must outlive the profiler
+ * @param parent Enclosing zone name, NULL for root zones
+ * @param depth Nesting depth
+ * @param start Start time in ve_timer_now units
+ * @param end End time in ve_timer_now units
+ */
+void ve_profiler_record_zone(uint32_t track, const char* name, const char* parent, uint32_t depth,
+                             ve_timestamp start, ve_timestamp end);
+
+/**
+ * @brief Mark the start of a frame
+ */
+void ve_profiler_begin_frame(void);
+
+/**
+ * @brief Mark the end of a frame and aggregate the zones closed since the
+ *        previous call
+ *
+ * Must be called from a single thread, which is also the thread that reads
+ * the statistics.
+ */
+void ve_profiler_end_frame(void);
+
+/**
+ * @brief Copy the statistics of the last aggregated frame
+ *
+ * @param stats Output array (may be NULL to query the count)
+ * @param max_count Capacity of the output array
+ * @return Number of zones in the last frame
+ */
+uint32_t ve_profiler_get_zone_stats(ve_profile_zone_stats* stats, uint32_t max_count);
+
+/**
+ * @brief Get the duration of the last frame
+ *
+ * @return Time between the last ve_profiler_begin_frame and ve_profiler_end_frame in milliseconds
+ */
+double ve_profiler_get_frame_time_ms(void);
+
+/**
+ * @brief Start keeping drained events for trace export
+ *
+ * Any previous capture is discarded.
+ *
+ * @param max_events Maximum number of events kept; later events are ignored
+ * @return true on success
+ */
+bool ve_profiler_start_capture(uint32_t max_events);
+
+/**
+ * @brief Stop adding events to the capture (the captured events are kept)
+ */
+void ve_profiler_stop_capture(void);
+
+/**
+ * @brief Get the number of captured events
+ *
+ * @return Captured event count
+ */
+uint32_t ve_profiler_get_capture_count(void);
+
+/**
+ * @brief Write the captured events in the Chrome trace event JSON format
+ *
+ * @param path Output file path
+ * @return true on success
+ */
+bool ve_profiler_export_chrome_trace(const char* path);
+
+/**
+ * @brief Get the number of events lost because a thread ring was full
+ *
+ * @return Dropped event count
+ */
+uint64_t ve_profiler_get_dropped_count(void);
+
+/**
+ * @brief Open a zone and return its scope state (used by VE_TIME_SCOPE)
+ *
+ * @param name Zone name
+ * @return Scope state
+ */
+ve_profile_scope ve_profile_scope_begin(const char* name);
+
+/**
+ * @brief Close a zone opened with ve_profile_scope_begin
+ *
+ * @param scope Scope state
+ */
+void ve_profile_scope_end(ve_profile_scope* scope);
+
+/**
+ * @brief Close a zone opened with ve_profile_scope_begin and log its duration
+ *
+ * @param scope Scope state
+ */
+void ve_profile_scope_end_log(ve_profile_scope* scope);
+
+/* Utility macros */
+#define VE_CAT_IMPL(a, b) a##b
+#define VE_CAT(a, b) VE_CAT_IMPL(a, b)
+
+/**
+ * @brief Scope-based timing
+ *
+ * The zone closes when the block ends; leaving the block with break,
+ * goto or return skips the close.
+ *
+ * Usage:
+ * @code
+ * VE_TIMED_SCOPE("MyFunction") {
+ *     // Code to time
+ * }
+ * @endcode
+ */
+#define VE_TIMED_SCOPE(name) \
+    for (int VE_CAT(_ve_zone_, __LINE__) = (ve_profiler_begin_zone(name), 1); \
+         VE_CAT(_ve_zone_, __LINE__); \
+         VE_CAT(_ve_zone_, __LINE__) = (ve_profiler_end_zone(), 0))
+
+#ifdef __GNUC__
+/**
+ * @brief Time from this point to the end of the enclosing scope
+ */
+#define VE_TIME_SCOPE(name) \
+    __attribute__((cleanup(ve_profile_scope_end))) \
+    ve_profile_scope VE_CAT(_ve_scope_, __LINE__) = ve_profile_scope_begin(name)
+
+/**
+ * @brief RAII-style timer that records a zone and logs on scope exit
+ */
+#define VE_SCOPED_TIMER(name) \
+    __attribute__((cleanup(ve_profile_scope_end_log))) \
+    ve_profile_scope VE_CAT(_ve_scoped_timer_, __LINE__) = ve_profile_scope_begin(name)
+#else
+/* Scope-exit hooks need compiler support; use VE_TIMED_SCOPE instead */
+#define VE_TIME_SCOPE(name) ((void)0)
+#define VE_SCOPED_TIMER(name) ((void)0)
+#endif
+
+/**
+ * @brief Function timing
+ *
+ * Usage:
+ * @code
+ * void my_function(void) {
+ *     VE_TIMED_FUNCTION();
+ *     // Function code
+ * }
+ * @endcode
+ */
+#define VE_TIMED_FUNCTION() VE_TIME_SCOPE(__func__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_PROFILER_H */
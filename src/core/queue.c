@@ -0,0 +1,232 @@
+/**
+ * @file queue.c
+ * @brief Lock-free queues implementation
+ */
+
+#include "queue.h"
+#include "memory.h"
+
+#include <string.h>
+
+static uint32_t round_up_power_of_two(uint32_t value) {
+    uint32_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+/* SPSC queue functions */
+
+bool ve_spsc_queue_init(ve_spsc_queue* queue, uint32_t element_size, uint32_t capacity) {
+    if (!queue || element_size == 0 || capacity == 0 || capacity > (1u << 31)) {
+        return false;
+    }
+
+    memset(queue, 0, sizeof(ve_spsc_queue));
+    capacity = round_up_power_of_two(capacity);
+    queue->elements = (uint8_t*)VE_ALLOCATE_TAG((size_t)capacity * element_size, VE_MEMORY_TAG_CORE);
+    if (!queue->elements) {
+        return false;
+    }
+
+    queue->element_size = element_size;
+    queue->mask = capacity - 1;
+    return true;
+}
+
+void ve_spsc_queue_destroy(ve_spsc_queue* queue) {
+    if (queue) {
+        VE_FREE(queue->elements);
+        memset(queue, 0, sizeof(ve_spsc_queue));
+    }
+}
+
+bool ve_spsc_queue_push(ve_spsc_queue* queue, const void* element) {
+    int64_t head = ve_atomic_load64(&queue->head);
+    if (head - queue->cached_tail > (int64_t)queue->mask) {
+        queue->cached_tail = ve_atomic_load64(&queue->tail);
+        if (head - queue->cached_tail > (int64_t)queue->mask) {
+            return false;
+        }
+    }
+
+    memcpy(queue->elements + (size_t)((uint64_t)head & queue->mask) * queue->element_size, element,
+           queue->element_size);
+    ve_atomic_store64(&queue->head, head + 1);
+    return true;
+}
+
+void* ve_spsc_queue_peek(ve_spsc_queue* queue) {
+    int64_t tail = ve_atomic_load64(&queue->tail);
+    if (tail == queue->cached_head) {
+        queue->cached_head = ve_atomic_load64(&queue->head);
+        if (tail == queue->cached_head) {
+            return NULL;
+        }
+    }
+    return queue->elements + (size_t)((uint64_t)tail & queue->mask) * queue->element_size;
+}
+
+bool ve_spsc_queue_pop(ve_spsc_queue* queue, void* element) {
+    void* front = ve_spsc_queue_peek(queue);
+    if (!front) {
+        return false;
+    }
+
+    if (element) {
+        memcpy(element, front, queue->element_size);
+    }
+    ve_atomic_store64(&queue->tail, ve_atomic_load64(&queue->tail) + 1);
+    return true;
+}
+
+uint32_t ve_spsc_queue_get_count(const ve_spsc_queue* queue) {
+    int64_t tail = ve_atomic_load64(&queue->tail);
+    int64_t head = ve_atomic_load64(&queue->head);
+    return head > tail ? (uint32_t)(head - tail) : 0;
+}
+
+uint32_t ve_spsc_queue_get_capacity(const ve_spsc_queue* queue) {
+    return queue->elements ? queue->mask + 1 : 0;
+}
+
+/* MPMC queue functions */
+
+static ve_atomic_int64* mpmc_cell(const ve_mpmc_queue* queue, int64_t position) {
+    return (ve_atomic_int64*)(queue->cells + (size_t)((uint64_t)position & queue->mask) * queue->cell_size);
+}
+
+bool ve_mpmc_queue_init(ve_mpmc_queue* queue, uint32_t element_size, uint32_t capacity) {
+    if (!queue || element_size == 0 || capacity == 0 || capacity > (1u << 31)) {
+        return false;
+    }
+
+    memset(queue, 0, sizeof(ve_mpmc_queue));
+    /* With one cell, "ready to read" and "free on the next lap" would share a sequence */
+    capacity = round_up_power_of_two(capacity < 2 ? 2 : capacity);
+    queue->cell_size = (uint32_t)((sizeof(ve_atomic_int64) + element_size + 7) & ~(size_t)7);
+    queue->cells = (uint8_t*)VE_ALLOCATE_TAG((size_t)capacity * queue->cell_size, VE_MEMORY_TAG_CORE);
+    if (!queue->cells) {
+        return false;
+    }
+
+    queue->element_size = element_size;
+    queue->mask = capacity - 1;
+
+    /* A cell whose sequence equals a position is free for the push claiming that position */
+    for (uint32_t i = 0; i < capacity; i++) {
+        ve_atomic_store64(mpmc_cell(queue, i), i);
+    }
+    return true;
+}
+
+void ve_mpmc_queue_destroy(ve_mpmc_queue* queue) {
+    if (queue) {
+        VE_FREE(queue->cells);
+        memset(queue, 0, sizeof(ve_mpmc_queue));
+    }
+}
+
+bool ve_mpmc_queue_push(ve_mpmc_queue* queue, const void* element) {
+    int64_t position = ve_atomic_load64(&queue->enqueue_pos);
+    ve_atomic_int64* cell;
+    for (;;) {
+        cell = mpmc_cell(queue, position);
+        int64_t diff = ve_atomic_load64(cell) - position;
+
+        if (diff == 0) {
+            if (ve_atomic_compare_exchange64(&queue->enqueue_pos, &position, position + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* The cell still holds the element from the previous lap */
+            return false;
+        } else {
+            position = ve_atomic_load64(&queue->enqueue_pos);
+        }
+    }
+
+    memcpy(cell + 1, element, queue->element_size);
+    ve_atomic_store64(cell, position + 1);
+    return true;
+}
+
+bool ve_mpmc_queue_pop(ve_mpmc_queue* queue, void* element) {
+    int64_t position = ve_atomic_load64(&queue->dequeue_pos);
+    ve_atomic_int64* cell;
+    for (;;) {
+        cell = mpmc_cell(queue, position);
+        int64_t diff = ve_atomic_load64(cell) - (position + 1);
+
+        if (diff == 0) {
+            if (ve_atomic_compare_exchange64(&queue->dequeue_pos, &position, position + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* Not written yet on this lap */
+            return false;
+        } else {
+            position = ve_atomic_load64(&queue->dequeue_pos);
+        }
+    }
+
+    memcpy(element, cell + 1, queue->element_size);
+    ve_atomic_store64(cell, position + (int64_t)queue->mask + 1);
+    return true;
+}
+
+uint32_t ve_mpmc_queue_get_count(const ve_mpmc_queue* queue) {
+    int64_t dequeue = ve_atomic_load64(&queue->dequeue_pos);
+    int64_t enqueue = ve_atomic_load64(&queue->enqueue_pos);
+    return enqueue > dequeue ? (uint32_t)(enqueue - dequeue) : 0;
+}
+
+/* MPSC queue functions */
+
+void ve_mpsc_queue_init(ve_mpsc_queue* queue) {
+    memset(queue, 0, sizeof(ve_mpsc_queue));
+    ve_atomic_store_ptr(&queue->head, &queue->stub);
+    queue->tail = &queue->stub;
+}
+
+void ve_mpsc_queue_push(ve_mpsc_queue* queue, ve_mpsc_node* node) {
+    ve_atomic_store_ptr(&node->next, NULL);
+    ve_mpsc_node* previous = (ve_mpsc_node*)ve_atomic_exchange_ptr(&queue->head, node);
+    /* Until this store the node is unreachable from the tail: the consumer sees a gap */
+    ve_atomic_store_ptr(&previous->next, node);
+}
+
+ve_mpsc_node* ve_mpsc_queue_pop(ve_mpsc_queue* queue) {
+    ve_mpsc_node* tail = queue->tail;
+    ve_mpsc_node* next = (ve_mpsc_node*)ve_atomic_load_ptr(&tail->next);
+
+    /* Step over the stub */
+    if (tail == &queue->stub) {
+        if (!next) {
+            return NULL;
+        }
+        queue->tail = next;
+        tail = next;
+        next = (ve_mpsc_node*)ve_atomic_load_ptr(&tail->next);
+    }
+
+    if (next) {
+        queue->tail = next;
+        return tail;
+    }
+
+    /* tail is the last linked node: either a push is in progress, or it is the only node left and
+       the stub goes back in behind it so it can be handed out */
+    if (tail != (ve_mpsc_node*)ve_atomic_load_ptr(&queue->head)) {
+        return NULL;
+    }
+    ve_mpsc_queue_push(queue, &queue->stub);
+
+    next = (ve_mpsc_node*)ve_atomic_load_ptr(&tail->next);
+    if (next) {
+        queue->tail = next;
+        return tail;
+    }
+    return NULL;
+}
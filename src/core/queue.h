@@ -0,0 +1,236 @@
+/**
+ * @file queue.h
+ * @brief Lock-free queues
+ *
+ * Three queues for handing work between threads without a lock:
+ *
+ * - ve_spsc_queue: bounded ring for one producer and one consumer thread.
+ *   Each side keeps a cached copy of the other side's position and only
+ *   reads the shared one when the cache says the ring is full or empty.
+ * - ve_mpmc_queue: bounded ring for any number of producers and consumers
+ *   (Vyukov). Each cell carries a sequence number telling which lap of the
+ *   ring it is ready for, so a push or pop is one compare-and-swap on the
+ *   position plus the element copy.
+ * - ve_mpsc_queue: unbounded intrusive queue for any number of producers and
+ *   one consumer (Vyukov). Elements embed a ve_mpsc_node; a push is one
+ *   atomic exchange and never fails.
+ *
+ * The producer and consumer positions sit on separate cache lines. The
+ * bounded rings copy fixed-size elements by value and round their capacity
+ * up to a power of two. None of the operations block: a full push or an
+ * empty pop returns false (or NULL) and the caller decides whether to retry,
+ * drop or wait on something else.
+ */
+
+#ifndef VE_QUEUE_H
+#define VE_QUEUE_H
+
+#include "thread.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Bounded single-producer single-consumer ring
+ */
+typedef struct ve_spsc_queue {
+    ve_atomic_int64 head;           /* Next position to write */
+    int64_t cached_tail;            /* Producer's last view of tail */
+    uint8_t head_padding[64 - sizeof(ve_atomic_int64) - sizeof(int64_t)];
+    ve_atomic_int64 tail;           /* Next position to read */
+    int64_t cached_head;            /* Consumer's last view of head */
+    uint8_t tail_padding[64 - sizeof(ve_atomic_int64) - sizeof(int64_t)];
+    uint8_t* elements;
+    uint32_t element_size;
+    uint32_t mask;
+} ve_spsc_queue;
+
+/**
+ * @brief Bounded multi-producer multi-consumer ring
+ */
+typedef struct ve_mpmc_queue {
+    ve_atomic_int64 enqueue_pos;
+    uint8_t enqueue_padding[64 - sizeof(ve_atomic_int64)];
+    ve_atomic_int64 dequeue_pos;
+    uint8_t dequeue_padding[64 - sizeof(ve_atomic_int64)];
+    uint8_t* cells;                 /* Sequence number followed by the element */
+    uint32_t cell_size;
+    uint32_t element_size;
+    uint32_t mask;
+} ve_mpmc_queue;
+
+/**
+ * @brief Link embedded in elements of a ve_mpsc_queue
+ */
+typedef struct ve_mpsc_node {
+    ve_atomic_ptr next;
+} ve_mpsc_node;
+
+/**
+ * @brief Unbounded intrusive multi-producer single-consumer queue
+ */
+typedef struct ve_mpsc_queue {
+    ve_atomic_ptr head;             /* Most recently pushed node */
+    uint8_t head_padding[64 - sizeof(ve_atomic_ptr)];
+    ve_mpsc_node* tail;             /* Next node to pop, consumer only */
+    ve_mpsc_node stub;              /* Keeps the list non-empty */
+} ve_mpsc_queue;
+
+/**
+ * @brief Get the element containing a queue node
+ */
+#define VE_MPSC_ELEMENT(node, type, member) ((type*)((char*)(node) - offsetof(type, member)))
+
+/* SPSC queue functions */
+
+/**
+ * @brief Create the ring of an SPSC queue
+ *
+ * @param queue Queue to initialize
+ * @param element_size Bytes per element
+ * @param capacity Minimum elements, rounded up to a power of two
+ * @return true on success
+ */
+bool ve_spsc_queue_init(ve_spsc_queue* queue, uint32_t element_size, uint32_t capacity);
+
+/**
+ * @brief Free the ring of an SPSC queue
+ *
+ * @param queue Queue to destroy
+ */
+void ve_spsc_queue_destroy(ve_spsc_queue* queue);
+
+/**
+ * @brief Copy an element in (producer thread)
+ *
+ * @param queue Queue
+ * @param element Element to copy
+ * @return false if the queue is full
+ */
+bool ve_spsc_queue_push(ve_spsc_queue* queue, const void* element);
+
+/**
+ * @brief Get the oldest element in place without removing it (consumer thread)
+ *
+ * @param queue Queue
+ * @return Oldest element, valid until it is popped, or NULL if empty
+ */
+void* ve_spsc_queue_peek(ve_spsc_queue* queue);
+
+/**
+ * @brief Remove the oldest element (consumer thread)
+ *
+ * @param queue Queue
+ * @param element Where to copy it, or NULL to discard it
+ * @return false if the queue is empty
+ */
+bool ve_spsc_queue_pop(ve_spsc_queue* queue, void* element);
+
+/**
+ * @brief Get the number of queued elements
+ *
+ * Exact on either of the two threads for the elements it cannot race with,
+ * a snapshot otherwise.
+ *
+ * @param queue Queue
+ * @return Queued elements
+ */
+uint32_t ve_spsc_queue_get_count(const ve_spsc_queue* queue);
+
+/**
+ * @brief Get the capacity of an SPSC queue
+ *
+ * @param queue Queue
+ * @return Elements the ring holds
+ */
+uint32_t ve_spsc_queue_get_capacity(const ve_spsc_queue* queue);
+
+/* MPMC queue functions */
+
+/**
+ * @brief Create the ring of an MPMC queue
+ *
+ * @param queue Queue to initialize
+ * @param element_size Bytes per element
+ * @param capacity Minimum elements, rounded up to a power of two (at least 2)
+ * @return true on success
+ */
+bool ve_mpmc_queue_init(ve_mpmc_queue* queue, uint32_t element_size, uint32_t capacity);
+
+/**
+ * @brief Free the ring of an MPMC queue
+ *
+ * @param queue Queue to destroy
+ */
+void ve_mpmc_queue_destroy(ve_mpmc_queue* queue);
+
+/**
+ * @brief Copy an element in, from any thread
+ *
+ * @param queue Queue
+ * @param element Element to copy
+ * @return false if the queue is full
+ */
+bool ve_mpmc_queue_push(ve_mpmc_queue* queue, const void* element);
+
+/**
+ * @brief Copy the oldest element out, from any thread
+ *
+ * @param queue Queue
+ * @param element Where to copy it
+ * @return false if the queue is empty
+ */
+bool ve_mpmc_queue_pop(ve_mpmc_queue* queue, void* element);
+
+/**
+ * @brief Get a snapshot of the number of queued elements
+ *
+ * Counts elements being pushed or popped at the time of the call.
+ *
+ * @param queue Queue
+ * @return Queued elements
+ */
+uint32_t ve_mpmc_queue_get_count(const ve_mpmc_queue* queue);
+
+/* MPSC queue functions */
+
+/**
+ * @brief Initialize an empty intrusive MPSC queue
+ *
+ * Allocates nothing, so there is no destroy.
+ *
+ * @param queue Queue to initialize
+ */
+void ve_mpsc_queue_init(ve_mpsc_queue* queue);
+
+/**
+ * @brief Push a node, from any thread
+ *
+ * The node must stay valid and unused until it is popped.
+ *
+ * @param queue Queue
+ * @param node Node embedded in the element
+ */
+void ve_mpsc_queue_push(ve_mpsc_queue* queue, ve_mpsc_node* node);
+
+/**
+ * @brief Pop the oldest node (consumer thread)
+ *
+ * Nodes pushed by one thread pop in the order it pushed them. May return
+ * NULL while a push on another thread is halfway through; that node and
+ * those after it pop once the push completes.
+ *
+ * @param queue Queue
+ * @return Oldest node, or NULL
+ */
+ve_mpsc_node* ve_mpsc_queue_pop(ve_mpsc_queue* queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_QUEUE_H */
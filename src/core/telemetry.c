@@ -0,0 +1,361 @@
+/**
+ * @file telemetry.c
+ * @brief Runtime metrics export implementation
+ */
+
+#include "telemetry.h"
+#include "memory.h"
+#include "logger.h"
+#include "../platform/platform.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Longest wait of the endpoint thread, bounding how long shutdown takes */
+#define TELEMETRY_POLL_MS 100
+
+/* Longest JSON text: every metric with a full name and a long value */
+#define TELEMETRY_JSON_SIZE (VE_TELEMETRY_MAX_METRICS * (VE_TELEMETRY_MAX_NAME + 32) + 64)
+
+typedef struct telemetry_source {
+    ve_telemetry_source_fn fn;
+    void* user_data;
+    ve_thread_pool* pool;               /* Set for thread pool sources, which have no callback */
+    char name[VE_TELEMETRY_MAX_NAME];
+} telemetry_source;
+
+/* Names of the memory tags, by bit */
+static const char* const k_tag_names[] = {
+    "core", "renderer", "vulkan", "ecs", "scene", "asset", "texture", "mesh", "shader", "string", "application",
+};
+
+/* Global telemetry state. Samples are taken on one thread and published
+   under the lock for readers on any thread. */
+static struct {
+    bool initialized;
+    uint32_t sample_interval;
+    uint32_t frames;                    /* Frames since the last sample */
+    telemetry_source sources[VE_TELEMETRY_MAX_SOURCES];
+    uint32_t source_count;
+
+    /* Sample being taken */
+    bool sampling;
+    ve_telemetry_metric current[VE_TELEMETRY_MAX_METRICS];
+    uint32_t current_count;
+
+    /* Latest sample */
+    ve_lock lock;
+    ve_telemetry_metric latest[VE_TELEMETRY_MAX_METRICS];
+    uint32_t latest_count;
+    uint64_t sequence;
+
+    /* Endpoint */
+    ve_socket* listener;
+    ve_thread* server;
+    ve_atomic_int32 shutdown;
+    uint16_t port;
+} g_telemetry = {0};
+
+static void serve_client(ve_socket* client, char* body, size_t capacity) {
+    char request[1024];
+    int64_t received = ve_socket_receive(client, request, sizeof(request) - 1, TELEMETRY_POLL_MS);
+    if (received <= 0) {
+        return;
+    }
+    request[received] = '\0';
+
+    /* Every path serves the sample; only reads are accepted */
+    char header[256];
+    if (strncmp(request, "GET ", 4) != 0) {
+        int length = snprintf(header, sizeof(header),
+                              "HTTP/1.0 405 Method Not Allowed\r\nAllow: GET\r\nContent-Length: 0\r\n"
+                              "Connection: close\r\n\r\n");
+        ve_socket_send(client, header, (size_t)length);
+        return;
+    }
+
+    size_t body_length = ve_telemetry_write_json(body, capacity);
+    if (body_length >= capacity) {
+        body_length = capacity - 1;
+    }
+    int length = snprintf(header, sizeof(header),
+                          "HTTP/1.0 200 OK\r\nContent-Type: application/json\r\nContent-Length: %zu\r\n"
+                          "Cache-Control: no-store\r\nConnection: close\r\n\r\n",
+                          body_length);
+    if (ve_socket_send(client, header, (size_t)length)) {
+        ve_socket_send(client, body, body_length);
+    }
+}
+
+static void* server_thread(void* user_data) {
+    (void)user_data;
+
+    char* body = (char*)VE_ALLOCATE_TAG(TELEMETRY_JSON_SIZE, VE_MEMORY_TAG_CORE);
+    if (!body) {
+        VE_LOG_ERROR("Out of memory starting the telemetry endpoint");
+        return NULL;
+    }
+
+    while (!ve_atomic_load32(&g_telemetry.shutdown)) {
+        ve_socket* client = ve_socket_accept(g_telemetry.listener, TELEMETRY_POLL_MS);
+        if (client) {
+            serve_client(client, body, TELEMETRY_JSON_SIZE);
+            ve_socket_close(client);
+        }
+    }
+
+    VE_FREE(body);
+    return NULL;
+}
+
+static bool start_endpoint(uint16_t port) {
+    g_telemetry.listener = ve_socket_listen(port);
+    if (!g_telemetry.listener) {
+        return false;
+    }
+
+    ve_atomic_store32(&g_telemetry.shutdown, 0);
+    g_telemetry.server = ve_thread_create(server_thread, NULL, "telemetry");
+    if (!g_telemetry.server) {
+        ve_socket_close(g_telemetry.listener);
+        g_telemetry.listener = NULL;
+        return false;
+    }
+
+    g_telemetry.port = ve_socket_get_port(g_telemetry.listener);
+    VE_LOG_INFO("Serving telemetry on http://127.0.0.1:%u/", g_telemetry.port);
+    return true;
+}
+
+bool ve_telemetry_init(const ve_telemetry_config* config) {
+    if (g_telemetry.initialized) {
+        return true;
+    }
+
+    ve_telemetry_config defaults = {0};
+    if (!config) {
+        config = &defaults;
+    }
+
+    g_telemetry.sample_interval = config->sample_interval ? config->sample_interval : VE_TELEMETRY_DEFAULT_INTERVAL;
+    g_telemetry.initialized = true;
+
+    if (config->serve && !start_endpoint(config->port)) {
+        VE_LOG_WARN("Telemetry endpoint unavailable, samples can only be pulled in process");
+    }
+    return true;
+}
+
+void ve_telemetry_shutdown(void) {
+    if (!g_telemetry.initialized) {
+        return;
+    }
+
+    if (g_telemetry.server) {
+        ve_atomic_store32(&g_telemetry.shutdown, 1);
+        ve_thread_join(g_telemetry.server);
+    }
+    ve_socket_close(g_telemetry.listener);
+    memset(&g_telemetry, 0, sizeof(g_telemetry));
+}
+
+bool ve_telemetry_is_enabled(void) {
+    return g_telemetry.initialized;
+}
+
+bool ve_telemetry_add_source(ve_telemetry_source_fn fn, void* user_data) {
+    if (!g_telemetry.initialized || !fn || g_telemetry.source_count == VE_TELEMETRY_MAX_SOURCES) {
+        return false;
+    }
+
+    telemetry_source* source = &g_telemetry.sources[g_telemetry.source_count++];
+    memset(source, 0, sizeof(telemetry_source));
+    source->fn = fn;
+    source->user_data = user_data;
+    return true;
+}
+
+bool ve_telemetry_add_thread_pool(const char* name, ve_thread_pool* pool) {
+    if (!g_telemetry.initialized || !pool || g_telemetry.source_count == VE_TELEMETRY_MAX_SOURCES) {
+        return false;
+    }
+
+    telemetry_source* source = &g_telemetry.sources[g_telemetry.source_count++];
+    memset(source, 0, sizeof(telemetry_source));
+    source->pool = pool;
+    snprintf(source->name, sizeof(source->name), "%s", name ? name : "thread_pool");
+    return true;
+}
+
+void ve_telemetry_remove_thread_pool(ve_thread_pool* pool) {
+    for (uint32_t i = 0; i < g_telemetry.source_count; i++) {
+        if (g_telemetry.sources[i].pool == pool) {
+            g_telemetry.sources[i] = g_telemetry.sources[--g_telemetry.source_count];
+            return;
+        }
+    }
+}
+
+void ve_telemetry_set(const char* name, double value) {
+    if (!g_telemetry.sampling || !name) {
+        return;
+    }
+
+    /* Names go into the JSON text unescaped */
+    char clean[VE_TELEMETRY_MAX_NAME];
+    size_t length = 0;
+    for (; name[length] && length < sizeof(clean) - 1; length++) {
+        char c = name[length];
+        clean[length] = (c == '"' || c == '\\' || (unsigned char)c < 0x20) ? '_' : c;
+    }
+    clean[length] = '\0';
+
+    for (uint32_t i = 0; i < g_telemetry.current_count; i++) {
+        if (strcmp(g_telemetry.current[i].name, clean) == 0) {
+            g_telemetry.current[i].value = value;
+            return;
+        }
+    }
+    if (g_telemetry.current_count == VE_TELEMETRY_MAX_METRICS) {
+        return;
+    }
+
+    ve_telemetry_metric* metric = &g_telemetry.current[g_telemetry.current_count++];
+    memcpy(metric->name, clean, length + 1);
+    metric->value = value;
+}
+
+static void sample_memory(void) {
+    ve_memory_stats stats = ve_memory_get_stats();
+    ve_telemetry_set("memory.in_use_bytes", (double)(stats.total_allocated - stats.total_freed));
+    ve_telemetry_set("memory.allocations", (double)stats.allocation_count);
+    ve_telemetry_set("memory.external_bytes", (double)stats.external_usage);
+
+    /* Every tag, so dashboards see a stable set of names */
+    char name[VE_TELEMETRY_MAX_NAME];
+    ve_telemetry_set("memory.tag.unknown", (double)stats.tag_usage[VE_MEMORY_TAG_UNKNOWN]);
+    for (uint32_t bit = 0; bit < sizeof(k_tag_names) / sizeof(k_tag_names[0]); bit++) {
+        snprintf(name, sizeof(name), "memory.tag.%s", k_tag_names[bit]);
+        ve_telemetry_set(name, (double)stats.tag_usage[1u << bit]);
+    }
+}
+
+static void sample_thread_pool(const telemetry_source* source) {
+    char name[VE_TELEMETRY_MAX_NAME];
+    snprintf(name, sizeof(name), "%s.pending", source->name);
+    ve_telemetry_set(name, (double)ve_thread_pool_get_pending_count(source->pool));
+    snprintf(name, sizeof(name), "%s.threads", source->name);
+    ve_telemetry_set(name, (double)ve_thread_pool_get_thread_count(source->pool));
+}
+
+void ve_telemetry_sample(const ve_frame_time* frame_time) {
+    if (!g_telemetry.initialized) {
+        return;
+    }
+
+    g_telemetry.current_count = 0;
+    g_telemetry.sampling = true;
+
+    if (frame_time) {
+        ve_telemetry_set("frame.count", (double)frame_time->frame_count);
+        ve_telemetry_set("frame.time_s", frame_time->total_time);
+        ve_telemetry_set("frame.delta_ms", frame_time->delta_time * 1000.0);
+        ve_telemetry_set("frame.fps", frame_time->frame_rate);
+    }
+    sample_memory();
+    for (uint32_t i = 0; i < g_telemetry.source_count; i++) {
+        const telemetry_source* source = &g_telemetry.sources[i];
+        if (source->pool) {
+            sample_thread_pool(source);
+        } else {
+            source->fn(source->user_data);
+        }
+    }
+
+    g_telemetry.sampling = false;
+
+    ve_lock_acquire(&g_telemetry.lock);
+    memcpy(g_telemetry.latest, g_telemetry.current, g_telemetry.current_count * sizeof(ve_telemetry_metric));
+    g_telemetry.latest_count = g_telemetry.current_count;
+    g_telemetry.sequence++;
+    ve_lock_release(&g_telemetry.lock);
+}
+
+bool ve_telemetry_frame(const ve_frame_time* frame_time) {
+    if (!g_telemetry.initialized || ++g_telemetry.frames < g_telemetry.sample_interval) {
+        return false;
+    }
+
+    g_telemetry.frames = 0;
+    ve_telemetry_sample(frame_time);
+    return true;
+}
+
+uint64_t ve_telemetry_get_sample(ve_telemetry_metric* metrics, uint32_t capacity, uint32_t* count) {
+    ve_lock_acquire(&g_telemetry.lock);
+    uint32_t copied = g_telemetry.latest_count < capacity ? g_telemetry.latest_count : capacity;
+    if (metrics && copied > 0) {
+        memcpy(metrics, g_telemetry.latest, copied * sizeof(ve_telemetry_metric));
+    }
+    if (count) {
+        *count = g_telemetry.latest_count;
+    }
+    uint64_t sequence = g_telemetry.sequence;
+    ve_lock_release(&g_telemetry.lock);
+    return sequence;
+}
+
+bool ve_telemetry_get_value(const char* name, double* value) {
+    bool found = false;
+    ve_lock_acquire(&g_telemetry.lock);
+    for (uint32_t i = 0; i < g_telemetry.latest_count && !found; i++) {
+        if (strcmp(g_telemetry.latest[i].name, name) == 0) {
+            *value = g_telemetry.latest[i].value;
+            found = true;
+        }
+    }
+    ve_lock_release(&g_telemetry.lock);
+    return found;
+}
+
+/* Append formatted text, counting what did not fit */
+static void json_append(char* buffer, size_t size, size_t* length, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(*length < size ? buffer + *length : NULL, *length < size ? size - *length : 0, format,
+                            args);
+    va_end(args);
+    if (written > 0) {
+        *length += (size_t)written;
+    }
+}
+
+size_t ve_telemetry_write_json(char* buffer, size_t size) {
+    size_t length = 0;
+    if (size > 0) {
+        buffer[0] = '\0';
+    }
+
+    ve_lock_acquire(&g_telemetry.lock);
+    json_append(buffer, size, &length, "{\"sample\":%llu,\"metrics\":{", (unsigned long long)g_telemetry.sequence);
+    for (uint32_t i = 0; i < g_telemetry.latest_count; i++) {
+        const ve_telemetry_metric* metric = &g_telemetry.latest[i];
+        const char* separator = i > 0 ? "," : "";
+        /* JSON has no NaN or infinity */
+        if (isfinite(metric->value)) {
+            json_append(buffer, size, &length, "%s\"%s\":%.15g", separator, metric->name, metric->value);
+        } else {
+            json_append(buffer, size, &length, "%s\"%s\":null", separator, metric->name);
+        }
+    }
+    ve_lock_release(&g_telemetry.lock);
+
+    json_append(buffer, size, &length, "}}");
+    return length;
+}
+
+uint16_t ve_telemetry_get_port(void) {
+    return g_telemetry.port;
+}
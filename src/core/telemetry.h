@@ -0,0 +1,177 @@
+/**
+ * @file telemetry.h
+ * @brief Runtime metrics export
+ *
+ * Every few frames the engine takes a sample: a flat list of named values
+ * covering frame timing, memory usage per tag and thread pool queue depths,
+ * plus whatever registered sources add (the renderer adds GPU memory budget
+ * and upload queue depth). The latest sample can be pulled from any thread,
+ * and is optionally served as JSON over HTTP on the loopback interface so
+ * a dashboard can poll a running process:
+ *
+ *   curl http://127.0.0.1:<port>/
+ *
+ * Samples are taken and sources run on the thread calling
+ * ve_telemetry_frame; sources may read state owned by that thread.
+ */
+
+#ifndef VE_TELEMETRY_H
+#define VE_TELEMETRY_H
+
+#include "timer.h"
+#include "thread.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VE_TELEMETRY_MAX_METRICS 256
+#define VE_TELEMETRY_MAX_SOURCES 16
+#define VE_TELEMETRY_MAX_NAME 48
+#define VE_TELEMETRY_DEFAULT_INTERVAL 30
+
+/**
+ * @brief One sampled value
+ */
+typedef struct ve_telemetry_metric {
+    char name[VE_TELEMETRY_MAX_NAME];   /* Dotted name, e.g. "memory.tag.texture" */
+    double value;
+} ve_telemetry_metric;
+
+/**
+ * @brief Callback adding values to a sample with ve_telemetry_set
+ */
+typedef void (*ve_telemetry_source_fn)(void* user_data);
+
+/**
+ * @brief Telemetry configuration
+ */
+typedef struct ve_telemetry_config {
+    uint32_t sample_interval;       /* Frames between samples, 0 for VE_TELEMETRY_DEFAULT_INTERVAL */
+    bool serve;                     /* Serve the latest sample as JSON on 127.0.0.1 */
+    uint16_t port;                  /* Port to serve on, 0 for any free port */
+} ve_telemetry_config;
+
+/**
+ * @brief Initialize telemetry
+ *
+ * @param config Configuration, or NULL for defaults without the endpoint
+ * @return true on success; a failure to open the endpoint is logged and not fatal
+ */
+bool ve_telemetry_init(const ve_telemetry_config* config);
+
+/**
+ * @brief Stop the endpoint and drop the sources and the latest sample
+ */
+void ve_telemetry_shutdown(void);
+
+/**
+ * @brief Check if telemetry is initialized
+ *
+ * @return true between ve_telemetry_init and ve_telemetry_shutdown
+ */
+bool ve_telemetry_is_enabled(void);
+
+/**
+ * @brief Register a source run for every sample
+ *
+ * Sources are added and removed before sampling starts or on the thread
+ * taking samples.
+ *
+ * @param fn Callback
+ * @param user_data Passed to the callback
+ * @return false if there is no room for another source
+ */
+bool ve_telemetry_add_source(ve_telemetry_source_fn fn, void* user_data);
+
+/**
+ * @brief Sample the queue depth and thread count of a thread pool
+ *
+ * @param name Metric prefix, e.g. "jobs"; copied
+ * @param pool Thread pool, must outlive telemetry or be removed with ve_telemetry_remove_thread_pool
+ * @return false if there is no room for another source
+ */
+bool ve_telemetry_add_thread_pool(const char* name, ve_thread_pool* pool);
+
+/**
+ * @brief Stop sampling a thread pool
+ *
+ * @param pool Thread pool
+ */
+void ve_telemetry_remove_thread_pool(ve_thread_pool* pool);
+
+/**
+ * @brief Set a value in the sample being taken
+ *
+ * Only has an effect from a source. Setting a name twice keeps the last
+ * value; values past VE_TELEMETRY_MAX_METRICS are dropped. Quotes,
+ * backslashes and control characters in names become '_'.
+ *
+ * @param name Metric name, truncated to VE_TELEMETRY_MAX_NAME - 1 characters
+ * @param value Value
+ */
+void ve_telemetry_set(const char* name, double value);
+
+/**
+ * @brief Count a frame, taking a sample every sample_interval frames
+ *
+ * @param frame_time Timing of the frame
+ * @return true if a sample was taken
+ */
+bool ve_telemetry_frame(const ve_frame_time* frame_time);
+
+/**
+ * @brief Take a sample now
+ *
+ * @param frame_time Timing of the current frame, or NULL to leave the frame values out
+ */
+void ve_telemetry_sample(const ve_frame_time* frame_time);
+
+/**
+ * @brief Copy the latest sample
+ *
+ * Safe to call from any thread.
+ *
+ * @param metrics Receives the values, may be NULL to only count them
+ * @param capacity Room in metrics
+ * @param count Receives the number of values in the sample
+ * @return Sequence number of the sample, 0 if none has been taken
+ */
+uint64_t ve_telemetry_get_sample(ve_telemetry_metric* metrics, uint32_t capacity, uint32_t* count);
+
+/**
+ * @brief Look up one value of the latest sample
+ *
+ * @param name Metric name
+ * @param value Receives the value
+ * @return false if the latest sample has no such value
+ */
+bool ve_telemetry_get_value(const char* name, double* value);
+
+/**
+ * @brief Format the latest sample as a JSON object
+ *
+ * The object has the sample sequence number and a "metrics" object mapping
+ * names to values. Safe to call from any thread.
+ *
+ * @param buffer Output buffer, NUL terminated if size > 0
+ * @param size Buffer size
+ * @return Length of the full JSON text; the output was truncated if this is >= size
+ */
+size_t ve_telemetry_write_json(char* buffer, size_t size);
+
+/**
+ * @brief Get the port of the endpoint
+ *
+ * @return Port, or 0 if the endpoint is not running
+ */
+uint16_t ve_telemetry_get_port(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_TELEMETRY_H */
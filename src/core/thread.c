@@ -3,11 +3,17 @@
  * @brief Thread utilities implementation
  */
 
+/* pthread affinity and sched_getcpu are GNU extensions */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
 #include "thread.h"
 #include "memory.h"
 #include "logger.h"
 
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
 
 /* Platform detection */
@@ -18,37 +24,38 @@
     typedef HANDLE thread_handle_t;
     typedef CRITICAL_SECTION mutex_handle_t;
     typedef CONDITION_VARIABLE condvar_handle_t;
-    typedef HANDLE semaphore_handle_t;
     typedef DWORD thread_id_t;
 
     #define THREAD_CALL_CONV WINAPI
+    #define THREAD_LOCAL __declspec(thread)
 #else
     #define VE_PLATFORM_POSIX
     #include <pthread.h>
+    #include <sched.h>
     #include <unistd.h>
     #include <sys/time.h>
+    #include <time.h>
     #include <errno.h>
+    #if defined(__linux__)
+        #include <linux/futex.h>
+        #include <sys/resource.h>
+        #include <sys/syscall.h>
+    #endif
 
     typedef pthread_t thread_handle_t;
-    typedef struct {
-        pthread_mutex_t mutex;
-        pthread_cond_t cond;
-    } condvar_handle_t;
-    typedef struct {
-        pthread_mutex_t mutex;
-        pthread_cond_t cond;
-        uint32_t count;
-        uint32_t max_count;
-    } semaphore_handle_t;
+    typedef pthread_mutex_t mutex_handle_t;
+    typedef pthread_cond_t condvar_handle_t;
     typedef pthread_t thread_id_t;
 
     #define THREAD_CALL_CONV
+    #define THREAD_LOCAL __thread
 #endif
 
 /* Thread implementation */
 struct ve_thread {
     thread_handle_t handle;
     ve_thread_id id;
+    ve_atomic_int32 system_id;      /* Kernel thread ID on Linux, set once the thread runs */
     char name[64];
 };
 
@@ -72,28 +79,74 @@ struct ve_condvar {
 };
 
 /* Semaphore implementation */
+/* Count in the low bits, sleepers above it, in the one word sleepers wait on: signal decides whether to wake
+   from the value it replaced, and never reads the semaphore after publishing the count */
+#define VE_SEMAPHORE_COUNT_MASK ((1 << 20) - 1)
+#define VE_SEMAPHORE_WAITER (1 << 20)
+
 struct ve_semaphore {
-    semaphore_handle_t* handle;
+    ve_atomic_int32 state;
+    int32_t max_count;
+};
+
+/* Job system implementation */
+
+#define VE_JOB_DEQUE_CAPACITY 2048  /* Must be a power of two */
+#define VE_JOB_RING_CAPACITY 2048   /* Must be a power of two */
+#define VE_JOB_SPIN_COUNT 64
+#define VE_JOB_PARK_TIMEOUT_MS 100
+
+enum {
+    VE_JOB_STATE_FREE = 0,
+    VE_JOB_STATE_ALLOCATED = 1,
 };
 
+typedef struct ve_job {
+    ve_task_fn func;
+    void* user_data;
+    ve_job_counter* counter;
+    ve_thread_pool* pool;
+    struct ve_job* next_waiter;
+    ve_atomic_int32 state;
+} ve_job;
+
+/* Chase-Lev work-stealing deque: the owner pushes and pops at the bottom,
+   other threads steal from the top. */
+typedef struct ve_job_deque {
+    ve_atomic_int64 top;
+    uint8_t top_padding[64 - sizeof(ve_atomic_int64)];
+    ve_atomic_int64 bottom;
+    uint8_t bottom_padding[64 - sizeof(ve_atomic_int64)];
+    ve_atomic_ptr entries[VE_JOB_DEQUE_CAPACITY];
+} ve_job_deque;
+
+typedef struct ve_job_context {
+    ve_job_deque deque;
+    ve_job* jobs;           /* Ring the owner allocates jobs from */
+    uint32_t next_job;
+    uint32_t rng_state;
+    uint32_t index;
+    int32_t cpu;            /* CPU the worker pins itself to, -1 for none */
+    ve_thread_priority priority;
+    ve_thread_pool* pool;
+} ve_job_context;
+
 /* Thread pool implementation */
 struct ve_thread_pool {
     ve_thread** threads;
     uint32_t thread_count;
-    ve_mutex* queue_mutex;
-    ve_condvar* queue_condvar;
-    ve_semaphore* task_semaphore;
-
-    struct {
-        ve_task_fn func;
-        void* user_data;
-    }* task_queue;
-
-    size_t queue_capacity;
-    size_t queue_head;
-    size_t queue_tail;
-    size_t queue_count;
-    bool shutdown;
+
+    /* One context per worker, plus a shared context (the last one) for
+       submissions from threads that do not belong to the pool */
+    ve_job_context* contexts;
+    uint32_t context_count;
+    ve_lock external_lock;
+
+    ve_semaphore* wake_semaphore;
+    ve_atomic_int32 sleeping_count;
+    ve_atomic_int32 pending_count;
+    ve_atomic_int32 shutdown;
+    ve_atomic_int32 placement_failures;
 };
 
 /* Platform-specific implementations */
@@ -188,6 +241,54 @@ void ve_thread_sleep_ms(uint32_t milliseconds) {
     Sleep(milliseconds);
 }
 
+bool ve_thread_set_affinity(ve_thread* thread, const ve_cpu_set* cpus) {
+    /* A thread runs in one processor group, the one holding the set's first CPU */
+    GROUP_AFFINITY affinity = {0};
+    bool found = false;
+    for (uint32_t i = 0; i < VE_MAX_CPUS / 64; i++) {
+        if (cpus->bits[i] == 0) {
+            continue;
+        }
+        if (found) {
+            VE_LOG_WARN("CPU set spans processor groups, keeping group %u", (uint32_t)affinity.Group);
+            break;
+        }
+        affinity.Group = (WORD)i;
+        affinity.Mask = (KAFFINITY)cpus->bits[i];
+        found = true;
+    }
+    if (!found) {
+        return false;
+    }
+
+    HANDLE handle = thread ? thread->handle : GetCurrentThread();
+    return SetThreadGroupAffinity(handle, &affinity, NULL) != 0;
+}
+
+bool ve_thread_get_affinity(ve_thread* thread, ve_cpu_set* cpus) {
+    GROUP_AFFINITY affinity;
+    HANDLE handle = thread ? thread->handle : GetCurrentThread();
+    if (!GetThreadGroupAffinity(handle, &affinity) || affinity.Group >= VE_MAX_CPUS / 64) {
+        return false;
+    }
+
+    ve_cpu_set_clear(cpus);
+    cpus->bits[affinity.Group] = (uint64_t)affinity.Mask;
+    return true;
+}
+
+bool ve_thread_set_priority(ve_thread* thread, ve_thread_priority priority) {
+    static const int priorities[] = {
+        [VE_THREAD_PRIORITY_NORMAL] = THREAD_PRIORITY_NORMAL,
+        [VE_THREAD_PRIORITY_LOW] = THREAD_PRIORITY_BELOW_NORMAL,
+        [VE_THREAD_PRIORITY_HIGH] = THREAD_PRIORITY_ABOVE_NORMAL,
+        [VE_THREAD_PRIORITY_HIGHEST] = THREAD_PRIORITY_HIGHEST,
+    };
+
+    HANDLE handle = thread ? thread->handle : GetCurrentThread();
+    return SetThreadPriority(handle, priorities[priority]) != 0;
+}
+
 /* Mutex functions */
 ve_mutex* ve_mutex_create(void) {
     ve_mutex* mutex = (ve_mutex*)VE_ALLOCATE_TAG(sizeof(ve_mutex), VE_MEMORY_TAG_CORE);
@@ -309,52 +410,25 @@ bool ve_condvar_wait(ve_condvar* cv, ve_mutex* mutex, uint32_t timeout_ms) {
     return SleepConditionVariableCS(&cv->handle, &mutex->handle, timeout) != 0;
 }
 
-/* Semaphore functions */
-ve_semaphore* ve_semaphore_create(uint32_t initial_count, uint32_t max_count) {
-    ve_semaphore* sem = (ve_semaphore*)VE_ALLOCATE_TAG(sizeof(ve_semaphore), VE_MEMORY_TAG_CORE);
-    if (!sem) {
-        return NULL;
-    }
-
-    sem->handle = (semaphore_handle_t*)VE_ALLOCATE_TAG(sizeof(HANDLE), VE_MEMORY_TAG_CORE);
-    if (!sem->handle) {
-        VE_FREE(sem);
-        return NULL;
-    }
-
-    HANDLE h = CreateSemaphoreA(NULL, initial_count, max_count, NULL);
-    if (!h) {
-        VE_FREE(sem->handle);
-        VE_FREE(sem);
-        return NULL;
-    }
-
-    *(HANDLE*)sem->handle = h;
-    return sem;
+/* Futex functions */
+static uint64_t monotonic_ms(void) {
+    return GetTickCount64();
 }
 
-void ve_semaphore_destroy(ve_semaphore* sem) {
-    if (sem && sem->handle) {
-        CloseHandle(*(HANDLE*)sem->handle);
-        VE_FREE(sem->handle);
-        VE_FREE(sem);
+bool ve_futex_wait(const ve_atomic_int32* atomic, int32_t expected, uint32_t timeout_ms) {
+    DWORD timeout = (timeout_ms == UINT32_MAX) ? INFINITE : timeout_ms;
+    if (WaitOnAddress((volatile VOID*)&atomic->value, &expected, sizeof(expected), timeout)) {
+        return true;
     }
+    return GetLastError() != ERROR_TIMEOUT;
 }
 
-bool ve_semaphore_wait(ve_semaphore* sem, uint32_t timeout_ms) {
-    if (!sem || !sem->handle) {
-        return false;
-    }
-
-    DWORD timeout = (timeout_ms == UINT32_MAX) ? INFINITE : timeout_ms;
-    return WaitForSingleObject(*(HANDLE*)sem->handle, timeout) == WAIT_OBJECT_0;
+void ve_futex_wake_one(const ve_atomic_int32* atomic) {
+    WakeByAddressSingle((PVOID)&atomic->value);
 }
 
-bool ve_semaphore_signal(ve_semaphore* sem) {
-    if (!sem || !sem->handle) {
-        return false;
-    }
-    return ReleaseSemaphore(*(HANDLE*)sem->handle, 1, NULL) != 0;
+void ve_futex_wake_all(const ve_atomic_int32* atomic) {
+    WakeByAddressAll((PVOID)&atomic->value);
 }
 
 #else /* POSIX implementation */
@@ -370,6 +444,10 @@ static void* thread_wrapper(void* param) {
     struct thread_wrapper_data* data = (struct thread_wrapper_data*)param;
     ve_thread* thread = data->thread;
 
+#if defined(__linux__)
+    ve_atomic_store32(&thread->system_id, (int32_t)syscall(SYS_gettid));
+#endif
+
     if (thread->name[0] != '\0') {
 #if defined(__linux__)
         pthread_setname_np(pthread_self(), thread->name);
@@ -462,6 +540,80 @@ void ve_thread_sleep_ms(uint32_t milliseconds) {
     usleep(milliseconds * 1000);
 }
 
+#if defined(__linux__)
+
+bool ve_thread_set_affinity(ve_thread* thread, const ve_cpu_set* cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (uint32_t cpu = 0; cpu < VE_MAX_CPUS && cpu < CPU_SETSIZE; cpu++) {
+        if (ve_cpu_set_contains(cpus, cpu)) {
+            CPU_SET(cpu, &set);
+        }
+    }
+
+    pthread_t handle = thread ? thread->handle : pthread_self();
+    return pthread_setaffinity_np(handle, sizeof(set), &set) == 0;
+}
+
+bool ve_thread_get_affinity(ve_thread* thread, ve_cpu_set* cpus) {
+    cpu_set_t set;
+    pthread_t handle = thread ? thread->handle : pthread_self();
+    if (pthread_getaffinity_np(handle, sizeof(set), &set) != 0) {
+        return false;
+    }
+
+    ve_cpu_set_clear(cpus);
+    for (uint32_t cpu = 0; cpu < VE_MAX_CPUS && cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &set)) {
+            ve_cpu_set_add(cpus, cpu);
+        }
+    }
+    return true;
+}
+
+bool ve_thread_set_priority(ve_thread* thread, ve_thread_priority priority) {
+    /* Normal threads all share SCHED_OTHER priority 0; Linux weighs them per thread by nice value */
+    static const int nice_values[] = {
+        [VE_THREAD_PRIORITY_NORMAL] = 0,
+        [VE_THREAD_PRIORITY_LOW] = 5,
+        [VE_THREAD_PRIORITY_HIGH] = -5,
+        [VE_THREAD_PRIORITY_HIGHEST] = -10,
+    };
+
+    int32_t id = 0;
+    if (thread) {
+        /* Only known once the thread has started */
+        while ((id = ve_atomic_load32(&thread->system_id)) == 0) {
+            ve_thread_yield();
+        }
+    } else {
+        id = (int32_t)syscall(SYS_gettid);
+    }
+    return setpriority(PRIO_PROCESS, (id_t)id, nice_values[priority]) == 0;
+}
+
+#else
+
+bool ve_thread_set_affinity(ve_thread* thread, const ve_cpu_set* cpus) {
+    (void)thread;
+    (void)cpus;
+    return false;
+}
+
+bool ve_thread_get_affinity(ve_thread* thread, ve_cpu_set* cpus) {
+    (void)thread;
+    (void)cpus;
+    return false;
+}
+
+bool ve_thread_set_priority(ve_thread* thread, ve_thread_priority priority) {
+    (void)thread;
+    (void)priority;
+    return false;
+}
+
+#endif
+
 /* Mutex functions */
 ve_mutex* ve_mutex_create(void) {
     ve_mutex* mutex = (ve_mutex*)VE_ALLOCATE_TAG(sizeof(ve_mutex), VE_MEMORY_TAG_CORE);
@@ -556,32 +708,26 @@ ve_condvar* ve_condvar_create(void) {
         return NULL;
     }
 
-    pthread_mutex_init(&cv->handle.mutex, NULL);
-    pthread_cond_init(&cv->handle.cond, NULL);
+    pthread_cond_init(&cv->handle, NULL);
     return cv;
 }
 
 void ve_condvar_destroy(ve_condvar* cv) {
     if (cv) {
-        pthread_mutex_destroy(&cv->handle.mutex);
-        pthread_cond_destroy(&cv->handle.cond);
+        pthread_cond_destroy(&cv->handle);
         VE_FREE(cv);
     }
 }
 
 void ve_condvar_signal(ve_condvar* cv) {
     if (cv) {
-        pthread_mutex_lock(&cv->handle.mutex);
-        pthread_cond_signal(&cv->handle.cond);
-        pthread_mutex_unlock(&cv->handle.mutex);
+        pthread_cond_signal(&cv->handle);
     }
 }
 
 void ve_condvar_broadcast(ve_condvar* cv) {
     if (cv) {
-        pthread_mutex_lock(&cv->handle.mutex);
-        pthread_cond_broadcast(&cv->handle.cond);
-        pthread_mutex_unlock(&cv->handle.mutex);
+        pthread_cond_broadcast(&cv->handle);
     }
 }
 
@@ -602,98 +748,310 @@ bool ve_condvar_wait(ve_condvar* cv, ve_mutex* mutex, uint32_t timeout_ms) {
 
     int result;
     if (timeout_ms == UINT32_MAX) {
-        result = pthread_cond_wait(&cv->handle.cond, &mutex->handle);
+        result = pthread_cond_wait(&cv->handle, &mutex->handle);
     } else {
-        result = pthread_cond_timedwait(&cv->handle.cond, &mutex->handle, &ts);
+        result = pthread_cond_timedwait(&cv->handle, &mutex->handle, &ts);
     }
 
     return result == 0;
 }
 
+/* Futex functions */
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+#if defined(__linux__)
+
+bool ve_futex_wait(const ve_atomic_int32* atomic, int32_t expected, uint32_t timeout_ms) {
+    struct timespec ts;
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = (long)(timeout_ms % 1000) * 1000000;
+
+    /* Relative timeout; EAGAIN (value changed) and EINTR count as wakeups */
+    long result = syscall(SYS_futex, &atomic->value, FUTEX_WAIT_PRIVATE, expected,
+                          timeout_ms == UINT32_MAX ? NULL : &ts, NULL, 0);
+    return result == 0 || errno != ETIMEDOUT;
+}
+
+void ve_futex_wake_one(const ve_atomic_int32* atomic) {
+    syscall(SYS_futex, &atomic->value, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+void ve_futex_wake_all(const ve_atomic_int32* atomic) {
+    syscall(SYS_futex, &atomic->value, FUTEX_WAKE_PRIVATE, INT32_MAX, NULL, NULL, 0);
+}
+
+#else
+
+/* No portable address wait: poll, which ve_futex_wait's callers see as spurious wakeups */
+bool ve_futex_wait(const ve_atomic_int32* atomic, int32_t expected, uint32_t timeout_ms) {
+    if (ve_atomic_load32(atomic) != expected) {
+        return true;
+    }
+    if (timeout_ms == 0) {
+        return false;
+    }
+    ve_thread_sleep_ms(1);
+    return timeout_ms > 1 || ve_atomic_load32(atomic) != expected;
+}
+
+void ve_futex_wake_one(const ve_atomic_int32* atomic) {
+    (void)atomic;
+}
+
+void ve_futex_wake_all(const ve_atomic_int32* atomic) {
+    (void)atomic;
+}
+
+#endif
+
+#endif /* Platform selection */
+
+/* Spinning and timeouts shared by the futex-based primitives */
+
+#define VE_WAIT_SPIN_COUNT 128
+
+static inline void cpu_relax(void) {
+#if defined(_MSC_VER)
+    YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ volatile("yield");
+#endif
+}
+
+static uint64_t wait_deadline(uint32_t timeout_ms) {
+    return timeout_ms == UINT32_MAX ? UINT64_MAX : monotonic_ms() + timeout_ms;
+}
+
+static uint32_t wait_remaining(uint64_t deadline) {
+    if (deadline == UINT64_MAX) {
+        return UINT32_MAX;
+    }
+    uint64_t now = monotonic_ms();
+    return now >= deadline ? 0 : (uint32_t)(deadline - now);
+}
+
+/* Lightweight lock functions */
+void ve_lock_acquire(ve_lock* lock) {
+    int32_t state = 0;
+    if (ve_atomic_compare_exchange32(&lock->state, &state, 1)) {
+        return;
+    }
+
+    /* Short critical sections usually end within the spin, without a sleep */
+    for (uint32_t i = 0; i < VE_WAIT_SPIN_COUNT && state != 2; i++) {
+        cpu_relax();
+        state = ve_atomic_load32(&lock->state);
+        if (state == 0 && ve_atomic_compare_exchange32(&lock->state, &state, 1)) {
+            return;
+        }
+    }
+
+    /* Mark the lock contended, so the holder wakes a sleeper on release. Taking it
+       this way keeps it marked, which costs at most one needless wake. */
+    while (ve_atomic_exchange32(&lock->state, 2) != 0) {
+        ve_futex_wait(&lock->state, 2, UINT32_MAX);
+    }
+}
+
+bool ve_lock_try_acquire(ve_lock* lock) {
+    int32_t state = 0;
+    return ve_atomic_compare_exchange32(&lock->state, &state, 1);
+}
+
+void ve_lock_release(ve_lock* lock) {
+    if (ve_atomic_exchange32(&lock->state, 0) == 2) {
+        ve_futex_wake_one(&lock->state);
+    }
+}
+
+/* Event functions */
+void ve_event_set(ve_event* event) {
+    if (ve_atomic_exchange32(&event->state, 1) == 2) {
+        ve_futex_wake_all(&event->state);
+    }
+}
+
+void ve_event_reset(ve_event* event) {
+    int32_t set = 1;
+    ve_atomic_compare_exchange32(&event->state, &set, 0);
+}
+
+bool ve_event_is_set(const ve_event* event) {
+    return ve_atomic_load32(&event->state) == 1;
+}
+
+bool ve_event_wait(ve_event* event, uint32_t timeout_ms) {
+    if (ve_atomic_load32(&event->state) == 1) {
+        return true;
+    }
+
+    uint64_t deadline = wait_deadline(timeout_ms);
+    for (;;) {
+        int32_t state = ve_atomic_load32(&event->state);
+        if (state == 1) {
+            return true;
+        }
+
+        uint32_t remaining = wait_remaining(deadline);
+        if (remaining == 0) {
+            return false;
+        }
+
+        /* Announce a sleeper so ve_event_set wakes us */
+        if (state == 0 && !ve_atomic_compare_exchange32(&event->state, &state, 2)) {
+            continue;
+        }
+        ve_futex_wait(&event->state, 2, remaining);
+    }
+}
+
 /* Semaphore functions */
 ve_semaphore* ve_semaphore_create(uint32_t initial_count, uint32_t max_count) {
-    (void)max_count;  /* Not used in POSIX semaphores */
     ve_semaphore* sem = (ve_semaphore*)VE_ALLOCATE_TAG(sizeof(ve_semaphore), VE_MEMORY_TAG_CORE);
     if (!sem) {
         return NULL;
     }
 
-    sem->handle = (semaphore_handle_t*)VE_ALLOCATE_TAG(sizeof(semaphore_handle_t), VE_MEMORY_TAG_CORE);
-    if (!sem->handle) {
-        VE_FREE(sem);
-        return NULL;
-    }
-
-    sem->handle->count = initial_count;
-    sem->handle->max_count = max_count;
-    pthread_mutex_init(&sem->handle->mutex, NULL);
-    pthread_cond_init(&sem->handle->cond, NULL);
-
+    sem->max_count = max_count > VE_SEMAPHORE_COUNT_MASK ? VE_SEMAPHORE_COUNT_MASK : (int32_t)max_count;
+    sem->state.value = initial_count > (uint32_t)sem->max_count ? sem->max_count : (int32_t)initial_count;
     return sem;
 }
 
 void ve_semaphore_destroy(ve_semaphore* sem) {
-    if (sem && sem->handle) {
-        pthread_mutex_destroy(&sem->handle->mutex);
-        pthread_cond_destroy(&sem->handle->cond);
-        VE_FREE(sem->handle);
-        VE_FREE(sem);
+    VE_FREE(sem);
+}
+
+/* Take one from the count; on failure state holds the value seen, with a count of 0 */
+static bool semaphore_try_take(ve_semaphore* sem, int32_t* state) {
+    *state = ve_atomic_load32(&sem->state);
+    while ((*state & VE_SEMAPHORE_COUNT_MASK) > 0) {
+        if (ve_atomic_compare_exchange32(&sem->state, state, *state - 1)) {
+            return true;
+        }
     }
+    return false;
 }
 
 bool ve_semaphore_wait(ve_semaphore* sem, uint32_t timeout_ms) {
-    if (!sem || !sem->handle) {
+    if (!sem) {
         return false;
     }
 
-    pthread_mutex_lock(&sem->handle->mutex);
-
-    while (sem->handle->count == 0) {
-        if (timeout_ms == 0) {
-            pthread_mutex_unlock(&sem->handle->mutex);
-            return false;
+    int32_t state;
+    if (semaphore_try_take(sem, &state)) {
+        return true;
+    }
+    if (timeout_ms == 0) {
+        return false;
+    }
+    for (uint32_t i = 0; i < VE_WAIT_SPIN_COUNT; i++) {
+        cpu_relax();
+        if (semaphore_try_take(sem, &state)) {
+            return true;
         }
+    }
 
-        if (timeout_ms == UINT32_MAX) {
-            pthread_cond_wait(&sem->handle->cond, &sem->handle->mutex);
-        } else {
-            struct timespec ts;
-            struct timeval tv;
-            gettimeofday(&tv, NULL);
+    /* Registered before the last look at the count, so a signal after it sees us */
+    uint64_t deadline = wait_deadline(timeout_ms);
+    ve_atomic_fetch_add32(&sem->state, VE_SEMAPHORE_WAITER);
 
-            uint64_t nsec = tv.tv_usec * 1000 + timeout_ms * 1000000;
-            ts.tv_sec = tv.tv_sec + nsec / 1000000000;
-            ts.tv_nsec = nsec % 1000000000;
+    bool taken = false;
+    for (;;) {
+        if (semaphore_try_take(sem, &state)) {
+            taken = true;
+            break;
+        }
 
-            if (pthread_cond_timedwait(&sem->handle->cond, &sem->handle->mutex, &ts) != 0) {
-                pthread_mutex_unlock(&sem->handle->mutex);
-                return false;
-            }
+        uint32_t remaining = wait_remaining(deadline);
+        if (remaining == 0) {
+            break;
         }
+        ve_futex_wait(&sem->state, state, remaining);
     }
 
-    sem->handle->count--;
-    pthread_mutex_unlock(&sem->handle->mutex);
-    return true;
+    ve_atomic_fetch_sub32(&sem->state, VE_SEMAPHORE_WAITER);
+    return taken;
 }
 
 bool ve_semaphore_signal(ve_semaphore* sem) {
-    if (!sem || !sem->handle) {
+    if (!sem) {
         return false;
     }
 
-    pthread_mutex_lock(&sem->handle->mutex);
+    int32_t state = ve_atomic_load32(&sem->state);
+    do {
+        if ((state & VE_SEMAPHORE_COUNT_MASK) >= sem->max_count) {
+            return false;
+        }
+    } while (!ve_atomic_compare_exchange32(&sem->state, &state, state + 1));
 
-    if (sem->handle->count < sem->handle->max_count) {
-        sem->handle->count++;
-        pthread_cond_signal(&sem->handle->cond);
+    /* A waiter may take the count and destroy the semaphore from here on; waking a freed address is harmless */
+    if ((uint32_t)state >= VE_SEMAPHORE_WAITER) {
+        ve_futex_wake_one(&sem->state);
     }
-
-    pthread_mutex_unlock(&sem->handle->mutex);
     return true;
 }
 
-#endif /* Platform selection */
+/* CPU sets and placement */
+
+void ve_cpu_set_clear(ve_cpu_set* set) {
+    memset(set, 0, sizeof(ve_cpu_set));
+}
+
+void ve_cpu_set_add(ve_cpu_set* set, uint32_t cpu) {
+    if (cpu < VE_MAX_CPUS) {
+        set->bits[cpu / 64] |= 1ull << (cpu % 64);
+    }
+}
+
+bool ve_cpu_set_contains(const ve_cpu_set* set, uint32_t cpu) {
+    return cpu < VE_MAX_CPUS && (set->bits[cpu / 64] & (1ull << (cpu % 64))) != 0;
+}
+
+uint32_t ve_cpu_set_count(const ve_cpu_set* set) {
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < VE_MAX_CPUS / 64; i++) {
+        for (uint64_t bits = set->bits[i]; bits; bits &= bits - 1) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/* Sort key of ve_cpu_get_placement: SMT siblings last, then core type, node, core */
+static uint64_t placement_key(const ve_logical_cpu* cpu) {
+    return ((uint64_t)(cpu->smt_index > 0) << 63) | ((uint64_t)cpu->type << 62) |
+           ((uint64_t)(cpu->numa_node & 0x3FFFu) << 48) | ((uint64_t)cpu->smt_index << 32) | cpu->core;
+}
+
+uint32_t ve_cpu_get_placement(const ve_cpu_topology* topology, int32_t numa_node, uint32_t* cpus, uint32_t capacity) {
+    uint32_t count = 0;
+    for (uint32_t cpu = 0; cpu < VE_MAX_CPUS && count < capacity; cpu++) {
+        if (ve_cpu_set_contains(&topology->available, cpu) &&
+            (numa_node < 0 || topology->cpus[cpu].numa_node == (uint32_t)numa_node)) {
+            cpus[count++] = cpu;
+        }
+    }
+
+    /* Insertion sort, stable so equal keys keep CPU order */
+    for (uint32_t i = 1; i < count; i++) {
+        uint32_t cpu = cpus[i];
+        uint64_t key = placement_key(&topology->cpus[cpu]);
+        uint32_t j = i;
+        while (j > 0 && placement_key(&topology->cpus[cpus[j - 1]]) > key) {
+            cpus[j] = cpus[j - 1];
+            j--;
+        }
+        cpus[j] = cpu;
+    }
+    return count;
+}
 
 /* Atomic operations - portable implementation */
 
@@ -713,6 +1071,14 @@ void ve_atomic_store32(volatile ve_atomic_int32* atomic, int32_t value) {
 #endif
 }
 
+int32_t ve_atomic_exchange32(volatile ve_atomic_int32* atomic, int32_t value) {
+#if defined(_MSC_VER)
+    return InterlockedExchange((volatile LONG*)&atomic->value, value);
+#else
+    return __atomic_exchange_n(&atomic->value, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
 int32_t ve_atomic_fetch_add32(volatile ve_atomic_int32* atomic, int32_t operand) {
 #if defined(_MSC_VER)
     return InterlockedExchangeAdd((volatile LONG*)&atomic->value, operand);
@@ -783,6 +1149,20 @@ int64_t ve_atomic_fetch_add64(volatile ve_atomic_int64* atomic, int64_t operand)
 #endif
 }
 
+bool ve_atomic_compare_exchange64(volatile ve_atomic_int64* atomic, int64_t* expected, int64_t desired) {
+#if defined(_MSC_VER)
+    int64_t actual = InterlockedCompareExchange64((volatile LONGLONG*)&atomic->value, desired, *expected);
+    if (actual == *expected) {
+        return true;
+    }
+    *expected = actual;
+    return false;
+#else
+    return __atomic_compare_exchange_n(&atomic->value, expected, desired, false,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+}
+
 void* ve_atomic_load_ptr(const volatile ve_atomic_ptr* atomic) {
 #if defined(_MSC_VER)
     return (void*)atomic->value;
@@ -799,6 +1179,14 @@ void ve_atomic_store_ptr(volatile ve_atomic_ptr* atomic, void* value) {
 #endif
 }
 
+void* ve_atomic_exchange_ptr(volatile ve_atomic_ptr* atomic, void* value) {
+#if defined(_MSC_VER)
+    return InterlockedExchangePointer((void* volatile*)&atomic->value, value);
+#else
+    return (void*)__atomic_exchange_n(&atomic->value, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
 bool ve_atomic_compare_exchange_ptr(volatile ve_atomic_ptr* atomic, void** expected, void* desired) {
 #if defined(_MSC_VER)
     void* actual = InterlockedCompareExchangePointer((void* volatile*)&atomic->value, desired, *expected);
@@ -913,47 +1301,324 @@ void* ve_tls_get(ve_tls_key* key) {
 #endif
 }
 
-/* Thread pool implementation */
-static void* worker_thread(void* user_data) {
-    ve_thread_pool* pool = (ve_thread_pool*)user_data;
+/* Job deque */
 
-    while (!pool->shutdown) {
-        if (!ve_semaphore_wait(pool->task_semaphore, 100)) {
-            continue;
+static bool job_deque_push(ve_job_deque* deque, ve_job* job) {
+    int64_t bottom = ve_atomic_load64(&deque->bottom);
+    int64_t top = ve_atomic_load64(&deque->top);
+
+    if (bottom - top >= VE_JOB_DEQUE_CAPACITY) {
+        return false;
+    }
+
+    ve_atomic_store_ptr(&deque->entries[bottom & (VE_JOB_DEQUE_CAPACITY - 1)], job);
+    ve_atomic_store64(&deque->bottom, bottom + 1);
+    return true;
+}
+
+static ve_job* job_deque_pop(ve_job_deque* deque) {
+    int64_t bottom = ve_atomic_load64(&deque->bottom) - 1;
+    ve_atomic_store64(&deque->bottom, bottom);
+    int64_t top = ve_atomic_load64(&deque->top);
+
+    if (top > bottom) {
+        /* Empty */
+        ve_atomic_store64(&deque->bottom, bottom + 1);
+        return NULL;
+    }
+
+    ve_job* job = (ve_job*)ve_atomic_load_ptr(&deque->entries[bottom & (VE_JOB_DEQUE_CAPACITY - 1)]);
+    if (top == bottom) {
+        /* Last entry: race against stealers for it */
+        if (!ve_atomic_compare_exchange64(&deque->top, &top, top + 1)) {
+            job = NULL;
         }
+        ve_atomic_store64(&deque->bottom, bottom + 1);
+    }
+
+    return job;
+}
+
+static ve_job* job_deque_steal(ve_job_deque* deque) {
+    int64_t top = ve_atomic_load64(&deque->top);
+    int64_t bottom = ve_atomic_load64(&deque->bottom);
+
+    if (top >= bottom) {
+        return NULL;
+    }
+
+    ve_job* job = (ve_job*)ve_atomic_load_ptr(&deque->entries[top & (VE_JOB_DEQUE_CAPACITY - 1)]);
+    if (!ve_atomic_compare_exchange64(&deque->top, &top, top + 1)) {
+        return NULL;
+    }
+
+    return job;
+}
+
+/* Job scheduling */
+
+static THREAD_LOCAL ve_job_context* t_job_context = NULL;
+
+static ve_job_context* get_current_context(ve_thread_pool* pool) {
+    ve_job_context* context = t_job_context;
+    return (context && context->pool == pool) ? context : NULL;
+}
+
+static ve_job_context* get_external_context(ve_thread_pool* pool) {
+    return &pool->contexts[pool->context_count - 1];
+}
+
+static uint32_t next_random(ve_job_context* context) {
+    /* xorshift32 */
+    uint32_t x = context->rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    context->rng_state = x;
+    return x;
+}
+
+static ve_job* job_ring_alloc(ve_job_context* context) {
+    for (uint32_t i = 0; i < VE_JOB_RING_CAPACITY; i++) {
+        ve_job* job = &context->jobs[context->next_job++ & (VE_JOB_RING_CAPACITY - 1)];
+        if (ve_atomic_load32(&job->state) == VE_JOB_STATE_FREE) {
+            ve_atomic_store32(&job->state, VE_JOB_STATE_ALLOCATED);
+            return job;
+        }
+    }
+
+    return NULL;
+}
+
+static ve_job* job_alloc(ve_thread_pool* pool, ve_job_context* context) {
+    if (context) {
+        return job_ring_alloc(context);
+    }
+
+    ve_lock_acquire(&pool->external_lock);
+    ve_job* job = job_ring_alloc(get_external_context(pool));
+    ve_lock_release(&pool->external_lock);
+    return job;
+}
+
+static void wake_workers(ve_thread_pool* pool) {
+    if (ve_atomic_load32(&pool->sleeping_count) > 0) {
+        ve_semaphore_signal(pool->wake_semaphore);
+    }
+}
+
+static ve_job* find_job(ve_thread_pool* pool, ve_job_context* context) {
+    ve_job* job;
 
-        ve_mutex_lock(pool->queue_mutex);
+    /* Own work first, newest to oldest */
+    if (context) {
+        job = job_deque_pop(&context->deque);
+    } else {
+        ve_lock_acquire(&pool->external_lock);
+        job = job_deque_pop(&get_external_context(pool)->deque);
+        ve_lock_release(&pool->external_lock);
+    }
 
-        if (pool->queue_count == 0) {
-            ve_mutex_unlock(pool->queue_mutex);
+    if (job) {
+        return job;
+    }
+
+    /* Steal the oldest work from someone else, starting at a random victim */
+    uint32_t start = context ? next_random(context) % pool->context_count : 0;
+    for (uint32_t i = 0; i < pool->context_count; i++) {
+        ve_job_context* victim = &pool->contexts[(start + i) % pool->context_count];
+        if (victim == context) {
             continue;
         }
 
-        ve_task_fn task = pool->task_queue[pool->queue_head].func;
-        void* task_data = pool->task_queue[pool->queue_head].user_data;
+        job = job_deque_steal(&victim->deque);
+        if (job) {
+            return job;
+        }
+    }
+
+    return NULL;
+}
+
+static void run_job(ve_thread_pool* pool, ve_job* job);
+
+static void enqueue_job(ve_thread_pool* pool, ve_job* job) {
+    ve_job_context* context = get_current_context(pool);
+    bool pushed;
+
+    if (context) {
+        pushed = job_deque_push(&context->deque, job);
+    } else {
+        ve_lock_acquire(&pool->external_lock);
+        pushed = job_deque_push(&get_external_context(pool)->deque, job);
+        ve_lock_release(&pool->external_lock);
+    }
+
+    if (!pushed) {
+        /* Deque is full: run the job right here instead of failing */
+        run_job(pool, job);
+        return;
+    }
+
+    wake_workers(pool);
+}
+
+/* Returns false if the counter was already done and the job must be queued now */
+static bool job_counter_add_waiter(ve_job_counter* counter, ve_job* job) {
+    ve_lock_acquire(&counter->lock);
+
+    if (ve_atomic_load32(&counter->value) == 0) {
+        ve_lock_release(&counter->lock);
+        return false;
+    }
+
+    job->next_waiter = (ve_job*)counter->waiters;
+    counter->waiters = job;
+
+    ve_lock_release(&counter->lock);
+    return true;
+}
+
+/* True once the count is zero and the job that dropped it there has let go of the counter */
+static bool job_counter_settled(ve_job_counter* counter) {
+    if (ve_atomic_load32(&counter->value) != 0) {
+        return false;
+    }
+    ve_lock_acquire(&counter->lock);
+    ve_lock_release(&counter->lock);
+    return true;
+}
+
+static void job_counter_release(ve_job_counter* counter) {
+    /* Not the last job: the counter is not touched after the decrement */
+    int32_t value = ve_atomic_load32(&counter->value);
+    while (value > 1) {
+        if (ve_atomic_compare_exchange32(&counter->value, &value, value - 1)) {
+            return;
+        }
+    }
+
+    /* The last job drops the count to zero under the lock, so a waiter that sees zero and then passes
+       through the lock (job_counter_settled) knows this thread is done with the counter and may free it */
+    ve_lock_acquire(&counter->lock);
+
+    /* A new submission may have reused the counter since the load above */
+    ve_job* waiter = NULL;
+    if (ve_atomic_decrement32(&counter->value) == 0) {
+        waiter = (ve_job*)counter->waiters;
+        counter->waiters = NULL;
+    }
+
+    ve_lock_release(&counter->lock);
+
+    while (waiter) {
+        ve_job* next = waiter->next_waiter;
+        waiter->next_waiter = NULL;
+        enqueue_job(waiter->pool, waiter);
+        waiter = next;
+    }
+}
+
+static void run_job(ve_thread_pool* pool, ve_job* job) {
+    ve_task_fn func = job->func;
+    void* user_data = job->user_data;
+    ve_job_counter* counter = job->counter;
+
+    func(user_data);
+
+    ve_atomic_store32(&job->state, VE_JOB_STATE_FREE);
+
+    if (counter) {
+        job_counter_release(counter);
+    }
+
+    ve_atomic_decrement32(&pool->pending_count);
+}
+
+static void* worker_thread(void* user_data) {
+    ve_job_context* context = (ve_job_context*)user_data;
+    ve_thread_pool* pool = context->pool;
+    uint32_t idle_spins = 0;
+
+    t_job_context = context;
+
+    bool placed = true;
+    if (context->cpu >= 0) {
+        ve_cpu_set cpus;
+        ve_cpu_set_clear(&cpus);
+        ve_cpu_set_add(&cpus, (uint32_t)context->cpu);
+        placed = ve_thread_set_affinity(NULL, &cpus);
+    }
+    if (context->priority != VE_THREAD_PRIORITY_NORMAL) {
+        placed = ve_thread_set_priority(NULL, context->priority) && placed;
+    }
+    if (!placed && ve_atomic_increment32(&pool->placement_failures) == 1) {
+        VE_LOG_WARN("Worker %u refused CPU %d or priority %d, further failures not logged", context->index,
+                    context->cpu, (int)context->priority);
+    }
 
-        pool->queue_head = (pool->queue_head + 1) % pool->queue_capacity;
-        pool->queue_count--;
+    while (!ve_atomic_load32(&pool->shutdown)) {
+        ve_job* job = find_job(pool, context);
+        if (job) {
+            run_job(pool, job);
+            idle_spins = 0;
+            continue;
+        }
+
+        if (idle_spins < VE_JOB_SPIN_COUNT) {
+            idle_spins++;
+            ve_thread_yield();
+            continue;
+        }
 
-        ve_mutex_unlock(pool->queue_mutex);
+        /* Announce that we are about to sleep, then look once more so a job
+           pushed before the announcement became visible is not missed */
+        ve_atomic_increment32(&pool->sleeping_count);
 
-        if (task) {
-            task(task_data);
+        job = find_job(pool, context);
+        if (job) {
+            ve_atomic_decrement32(&pool->sleeping_count);
+            run_job(pool, job);
+            idle_spins = 0;
+            continue;
         }
+
+        ve_semaphore_wait(pool->wake_semaphore, VE_JOB_PARK_TIMEOUT_MS);
+        ve_atomic_decrement32(&pool->sleeping_count);
+        idle_spins = 0;
     }
 
+    t_job_context = NULL;
     return NULL;
 }
 
 ve_thread_pool* ve_thread_pool_create(uint32_t num_threads) {
+    ve_thread_pool_config config = {
+        .thread_count = num_threads,
+    };
+    return ve_thread_pool_create_with_config(&config);
+}
+
+ve_thread_pool* ve_thread_pool_create_with_config(const ve_thread_pool_config* config) {
+    ve_thread_pool_config settings = {0};
+    if (config) {
+        settings = *config;
+    }
+
+    /* Workers take the placement order after the reserved CPUs, wrapping if there are more workers */
+    const ve_cpu_topology* topology = ve_cpu_get_topology();
+    uint32_t placement[VE_MAX_CPUS];
+    uint32_t placement_count = ve_cpu_get_placement(topology, -1, placement, VE_MAX_CPUS);
+    if (settings.numa_local && placement_count > 0) {
+        placement_count = ve_cpu_get_placement(topology, (int32_t)topology->cpus[placement[0]].numa_node, placement,
+                                               VE_MAX_CPUS);
+    }
+    uint32_t first_cpu = settings.reserved_cpus < placement_count ? settings.reserved_cpus : placement_count;
+    uint32_t free_count = placement_count - first_cpu;
+
+    uint32_t num_threads = settings.thread_count;
     if (num_threads == 0) {
-#if defined(VE_PLATFORM_WINDOWS)
-        SYSTEM_INFO sysinfo;
-        GetSystemInfo(&sysinfo);
-        num_threads = sysinfo.dwNumberOfProcessors;
-#else
-        num_threads = (uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
-#endif
+        num_threads = free_count > 0 ? free_count : 1;
     }
 
     ve_thread_pool* pool = (ve_thread_pool*)VE_ALLOCATE_TAG(sizeof(ve_thread_pool), VE_MEMORY_TAG_CORE);
@@ -963,26 +1628,41 @@ ve_thread_pool* ve_thread_pool_create(uint32_t num_threads) {
 
     memset(pool, 0, sizeof(ve_thread_pool));
 
-    pool->thread_count = num_threads;
-    pool->queue_capacity = 1024;
-    pool->shutdown = false;
-
-    pool->queue_mutex = ve_mutex_create();
-    pool->queue_condvar = ve_condvar_create();
-    pool->task_semaphore = ve_semaphore_create(0, UINT32_MAX);
+    pool->wake_semaphore = ve_semaphore_create(0, UINT32_MAX);
 
-    if (!pool->queue_mutex || !pool->queue_condvar || !pool->task_semaphore) {
+    if (!pool->wake_semaphore) {
         ve_thread_pool_destroy(pool);
         return NULL;
     }
 
-    pool->task_queue = (void*)VE_ALLOCATE_TAG(pool->queue_capacity * sizeof(pool->task_queue[0]),
-                                               VE_MEMORY_TAG_CORE);
-    if (!pool->task_queue) {
+    pool->context_count = num_threads + 1;
+    pool->contexts = (ve_job_context*)VE_ALLOCATE_TAG(pool->context_count * sizeof(ve_job_context),
+                                                      VE_MEMORY_TAG_CORE);
+    if (!pool->contexts) {
+        pool->context_count = 0;
         ve_thread_pool_destroy(pool);
         return NULL;
     }
 
+    memset(pool->contexts, 0, pool->context_count * sizeof(ve_job_context));
+
+    for (uint32_t i = 0; i < pool->context_count; i++) {
+        ve_job_context* context = &pool->contexts[i];
+        context->pool = pool;
+        context->index = i;
+        context->rng_state = 0x9E3779B9u * (i + 1);
+        context->cpu = settings.pin_workers && i < num_threads && free_count > 0
+                           ? (int32_t)placement[first_cpu + i % free_count]
+                           : -1;
+        context->priority = i < num_threads ? settings.priority : VE_THREAD_PRIORITY_NORMAL;
+        context->jobs = (ve_job*)VE_ALLOCATE_TAG(VE_JOB_RING_CAPACITY * sizeof(ve_job), VE_MEMORY_TAG_CORE);
+        if (!context->jobs) {
+            ve_thread_pool_destroy(pool);
+            return NULL;
+        }
+        memset(context->jobs, 0, VE_JOB_RING_CAPACITY * sizeof(ve_job));
+    }
+
     pool->threads = (ve_thread**)VE_ALLOCATE_TAG(num_threads * sizeof(ve_thread*),
                                                   VE_MEMORY_TAG_CORE);
     if (!pool->threads) {
@@ -993,12 +1673,12 @@ ve_thread_pool* ve_thread_pool_create(uint32_t num_threads) {
     for (uint32_t i = 0; i < num_threads; i++) {
         char name[64];
         snprintf(name, sizeof(name), "Worker_%u", i);
-        pool->threads[i] = ve_thread_create(worker_thread, pool, name);
+        pool->threads[i] = ve_thread_create(worker_thread, &pool->contexts[i], name);
         if (!pool->threads[i]) {
-            pool->thread_count = i;
             ve_thread_pool_destroy(pool);
             return NULL;
         }
+        pool->thread_count = i + 1;
     }
 
     return pool;
@@ -1009,11 +1689,16 @@ void ve_thread_pool_destroy(ve_thread_pool* pool) {
         return;
     }
 
-    pool->shutdown = true;
+    /* Drain outstanding work before the workers go away */
+    if (pool->thread_count > 0) {
+        ve_thread_pool_wait(pool);
+    }
+
+    ve_atomic_store32(&pool->shutdown, 1);
 
-    if (pool->task_semaphore) {
+    if (pool->wake_semaphore) {
         for (uint32_t i = 0; i < pool->thread_count; i++) {
-            ve_semaphore_signal(pool->task_semaphore);
+            ve_semaphore_signal(pool->wake_semaphore);
         }
     }
 
@@ -1027,45 +1712,62 @@ void ve_thread_pool_destroy(ve_thread_pool* pool) {
         VE_FREE(pool->threads);
     }
 
-    if (pool->task_queue) {
-        VE_FREE(pool->task_queue);
-    }
-
-    if (pool->queue_mutex) {
-        ve_mutex_destroy(pool->queue_mutex);
-    }
-
-    if (pool->queue_condvar) {
-        ve_condvar_destroy(pool->queue_condvar);
+    if (pool->contexts) {
+        for (uint32_t i = 0; i < pool->context_count; i++) {
+            if (pool->contexts[i].jobs) {
+                VE_FREE(pool->contexts[i].jobs);
+            }
+        }
+        VE_FREE(pool->contexts);
     }
 
-    if (pool->task_semaphore) {
-        ve_semaphore_destroy(pool->task_semaphore);
+    if (pool->wake_semaphore) {
+        ve_semaphore_destroy(pool->wake_semaphore);
     }
 
     VE_FREE(pool);
 }
 
 bool ve_thread_pool_submit(ve_thread_pool* pool, ve_task_fn task, void* user_data) {
+    return ve_thread_pool_submit_job(pool, task, user_data, NULL, NULL);
+}
+
+bool ve_thread_pool_submit_job(ve_thread_pool* pool, ve_task_fn task, void* user_data,
+                               ve_job_counter* dependency, ve_job_counter* counter) {
     if (!pool || !task) {
         return false;
     }
 
-    ve_mutex_lock(pool->queue_mutex);
+    ve_job_context* context = get_current_context(pool);
 
-    if (pool->queue_count >= pool->queue_capacity) {
-        ve_mutex_unlock(pool->queue_mutex);
-        return false;
+    /* Every job slot of this thread is still in flight: help out until one frees up */
+    ve_job* job;
+    while ((job = job_alloc(pool, context)) == NULL) {
+        ve_job* other = find_job(pool, context);
+        if (other) {
+            run_job(pool, other);
+        } else {
+            ve_thread_yield();
+        }
     }
 
-    size_t tail = (pool->queue_head + pool->queue_count) % pool->queue_capacity;
-    pool->task_queue[tail].func = task;
-    pool->task_queue[tail].user_data = user_data;
-    pool->queue_count++;
+    job->func = task;
+    job->user_data = user_data;
+    job->counter = counter;
+    job->pool = pool;
+    job->next_waiter = NULL;
 
-    ve_mutex_unlock(pool->queue_mutex);
+    ve_atomic_increment32(&pool->pending_count);
+    if (counter) {
+        ve_atomic_increment32(&counter->value);
+    }
 
-    ve_semaphore_signal(pool->task_semaphore);
+    if (dependency && job_counter_add_waiter(dependency, job)) {
+        /* Queued by job_counter_release() once the dependency completes */
+        return true;
+    }
+
+    enqueue_job(pool, job);
     return true;
 }
 
@@ -1074,8 +1776,32 @@ void ve_thread_pool_wait(ve_thread_pool* pool) {
         return;
     }
 
-    while (pool->queue_count > 0) {
-        ve_thread_sleep_ms(1);
+    ve_job_context* context = get_current_context(pool);
+
+    while (ve_atomic_load32(&pool->pending_count) > 0) {
+        ve_job* job = find_job(pool, context);
+        if (job) {
+            run_job(pool, job);
+        } else {
+            ve_thread_yield();
+        }
+    }
+}
+
+void ve_thread_pool_wait_counter(ve_thread_pool* pool, ve_job_counter* counter) {
+    if (!pool || !counter) {
+        return;
+    }
+
+    ve_job_context* context = get_current_context(pool);
+
+    while (!job_counter_settled(counter)) {
+        ve_job* job = find_job(pool, context);
+        if (job) {
+            run_job(pool, job);
+        } else {
+            ve_thread_yield();
+        }
     }
 }
 
@@ -1083,14 +1809,130 @@ uint32_t ve_thread_pool_get_thread_count(const ve_thread_pool* pool) {
     return pool ? pool->thread_count : 0;
 }
 
+uint32_t ve_thread_pool_get_worker_index(ve_thread_pool* pool) {
+    ve_job_context* context = pool ? get_current_context(pool) : NULL;
+    return context ? context->index : ve_thread_pool_get_thread_count(pool);
+}
+
 size_t ve_thread_pool_get_pending_count(const ve_thread_pool* pool) {
     if (!pool) {
         return 0;
     }
 
-    ve_mutex_lock((ve_mutex*)pool->queue_mutex);
-    size_t count = pool->queue_count;
-    ve_mutex_unlock((ve_mutex*)pool->queue_mutex);
+    int32_t count = ve_atomic_load32(&pool->pending_count);
+    return count > 0 ? (size_t)count : 0;
+}
 
-    return count;
+/* Job counters */
+
+void ve_job_counter_init(ve_job_counter* counter) {
+    if (counter) {
+        memset(counter, 0, sizeof(ve_job_counter));
+    }
+}
+
+bool ve_job_counter_is_done(const ve_job_counter* counter) {
+    /* Taking the lock leaves the counter unchanged */
+    return !counter || job_counter_settled((ve_job_counter*)counter);
+}
+
+/* Task groups */
+
+void ve_task_group_init(ve_task_group* group, ve_thread_pool* pool) {
+    if (group) {
+        group->pool = pool;
+        ve_job_counter_init(&group->counter);
+    }
+}
+
+bool ve_task_group_run(ve_task_group* group, ve_task_fn task, void* user_data) {
+    if (!group) {
+        return false;
+    }
+
+    return ve_thread_pool_submit_job(group->pool, task, user_data, NULL, &group->counter);
+}
+
+void ve_task_group_wait(ve_task_group* group) {
+    if (group) {
+        ve_thread_pool_wait_counter(group->pool, &group->counter);
+    }
+}
+
+bool ve_task_group_is_done(const ve_task_group* group) {
+    return !group || ve_job_counter_is_done(&group->counter);
+}
+
+/* Parallel for */
+
+#define VE_PARALLEL_FOR_CHUNKS_PER_THREAD 4
+
+typedef struct parallel_for_state {
+    ve_parallel_for_fn fn;
+    void* user_data;
+    uint32_t begin;
+    uint32_t end;
+    uint32_t grain;
+    uint32_t chunk_count;
+    ve_atomic_int32 next_chunk;
+} parallel_for_state;
+
+static void parallel_for_run_chunks(parallel_for_state* state) {
+    for (;;) {
+        int32_t chunk = ve_atomic_fetch_add32(&state->next_chunk, 1);
+        if ((uint32_t)chunk >= state->chunk_count) {
+            return;
+        }
+
+        uint32_t chunk_begin = state->begin + (uint32_t)chunk * state->grain;
+        uint32_t chunk_end = (state->end - chunk_begin > state->grain) ? chunk_begin + state->grain : state->end;
+        state->fn(chunk_begin, chunk_end, state->user_data);
+    }
+}
+
+static void parallel_for_task(void* user_data) {
+    parallel_for_run_chunks((parallel_for_state*)user_data);
+}
+
+void ve_parallel_for(ve_thread_pool* pool, uint32_t begin, uint32_t end, uint32_t grain,
+                     ve_parallel_for_fn fn, void* user_data) {
+    if (!fn || begin >= end) {
+        return;
+    }
+
+    uint32_t count = end - begin;
+    uint32_t thread_count = ve_thread_pool_get_thread_count(pool);
+
+    if (grain == 0) {
+        uint32_t target_chunks = (thread_count + 1) * VE_PARALLEL_FOR_CHUNKS_PER_THREAD;
+        grain = (count + target_chunks - 1) / target_chunks;
+    }
+
+    uint32_t chunk_count = (uint32_t)(((uint64_t)count + grain - 1) / grain);
+    if (thread_count == 0 || chunk_count <= 1) {
+        fn(begin, end, user_data);
+        return;
+    }
+
+    parallel_for_state state = {
+        .fn = fn,
+        .user_data = user_data,
+        .begin = begin,
+        .end = end,
+        .grain = grain,
+        .chunk_count = chunk_count,
+    };
+
+    /* One helper per worker at most; the caller takes a share as well */
+    uint32_t helper_count = chunk_count - 1 < thread_count ? chunk_count - 1 : thread_count;
+
+    ve_task_group group;
+    ve_task_group_init(&group, pool);
+
+    for (uint32_t i = 0; i < helper_count; i++) {
+        ve_task_group_run(&group, parallel_for_task, &state);
+    }
+
+    parallel_for_run_chunks(&state);
+    ve_task_group_wait(&group);
 }
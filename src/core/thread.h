@@ -7,6 +7,7 @@
 #define VE_THREAD_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -42,7 +43,11 @@ typedef struct ve_rwlock ve_rwlock;
 typedef struct ve_condvar ve_condvar;
 
 /**
- * @brief Semaphore
+ * @brief Counting semaphore
+ *
+ * Built on ve_futex_wait(): signaling with no sleeper and waiting on a
+ * positive count stay in user mode. A semaphore may be destroyed as soon
+ * as a wait on it returns, even if the signal that satisfied it has not.
  */
 typedef struct ve_semaphore ve_semaphore;
 
@@ -67,6 +72,32 @@ typedef struct ve_atomic_ptr {
     volatile void* value;
 } ve_atomic_ptr;
 
+/**
+ * @brief Lightweight lock
+ *
+ * A plain value: zero-initialize it or use VE_LOCK_INIT, no create or
+ * destroy. Acquiring spins briefly, then sleeps on the lock word (futex on
+ * Linux, WaitOnAddress on Windows); uncontended acquire and release are a
+ * single atomic each and never enter the kernel. Not recursive.
+ */
+typedef struct ve_lock {
+    ve_atomic_int32 state;          /* 0 free, 1 held, 2 held with sleepers */
+} ve_lock;
+
+#define VE_LOCK_INIT {{0}}
+
+/**
+ * @brief Manual-reset event
+ *
+ * A plain value, zero-initialized to unset. Stays set, releasing every
+ * waiter, until reset. Setting it with no one waiting stays in user mode.
+ */
+typedef struct ve_event {
+    ve_atomic_int32 state;          /* 0 unset, 1 set, 2 unset with sleepers */
+} ve_event;
+
+#define VE_EVENT_INIT {{0}}
+
 /**
  * @brief Thread ID type
  */
@@ -134,6 +165,156 @@ void ve_thread_yield(void);
  */
 void ve_thread_sleep_ms(uint32_t milliseconds);
 
+/* CPU topology and placement */
+
+/* Logical CPUs covered by topology and affinity sets */
+#define VE_MAX_CPUS 256
+
+/**
+ * @brief Set of logical CPUs, by OS CPU number
+ *
+ * On Windows, CPU numbers are processor group * 64 + index in the group.
+ */
+typedef struct ve_cpu_set {
+    uint64_t bits[VE_MAX_CPUS / 64];
+} ve_cpu_set;
+
+/**
+ * @brief Core class on hybrid CPUs
+ *
+ * Every core of a CPU without classes counts as a performance core.
+ */
+typedef enum ve_core_type {
+    VE_CORE_TYPE_PERFORMANCE = 0,
+    VE_CORE_TYPE_EFFICIENCY
+} ve_core_type;
+
+/**
+ * @brief Where a logical CPU sits
+ */
+typedef struct ve_logical_cpu {
+    uint32_t core;                  /* Physical core, 0 to core_count - 1 */
+    uint32_t numa_node;             /* 0 to numa_node_count - 1 */
+    uint32_t smt_index;             /* Hardware thread within its core, 0 for the first */
+    ve_core_type type;
+} ve_logical_cpu;
+
+/**
+ * @brief Processor topology
+ */
+typedef struct ve_cpu_topology {
+    ve_cpu_set online;
+    ve_cpu_set available;           /* Online and in the process affinity mask */
+    uint32_t logical_count;         /* Online */
+    uint32_t core_count;
+    uint32_t performance_core_count;
+    uint32_t numa_node_count;
+    bool hybrid;                    /* Has efficiency cores */
+    ve_logical_cpu cpus[VE_MAX_CPUS];   /* Valid for online CPUs */
+} ve_cpu_topology;
+
+/**
+ * @brief Thread scheduling priority
+ *
+ * Raising a thread above normal may need privileges (CAP_SYS_NICE on
+ * Linux) and fail.
+ */
+typedef enum ve_thread_priority {
+    VE_THREAD_PRIORITY_NORMAL = 0,
+    VE_THREAD_PRIORITY_LOW,
+    VE_THREAD_PRIORITY_HIGH,
+    VE_THREAD_PRIORITY_HIGHEST
+} ve_thread_priority;
+
+/**
+ * @brief Empty a CPU set
+ *
+ * @param set Set
+ */
+void ve_cpu_set_clear(ve_cpu_set* set);
+
+/**
+ * @brief Add a CPU to a set
+ *
+ * @param set Set
+ * @param cpu CPU number, below VE_MAX_CPUS
+ */
+void ve_cpu_set_add(ve_cpu_set* set, uint32_t cpu);
+
+/**
+ * @brief Check if a set contains a CPU
+ *
+ * @param set Set
+ * @param cpu CPU number
+ * @return true if cpu is in the set
+ */
+bool ve_cpu_set_contains(const ve_cpu_set* set, uint32_t cpu);
+
+/**
+ * @brief Count the CPUs in a set
+ *
+ * @param set Set
+ * @return Number of CPUs
+ */
+uint32_t ve_cpu_set_count(const ve_cpu_set* set);
+
+/**
+ * @brief Get the processor topology
+ *
+ * Detected from sysfs on Linux and GetLogicalProcessorInformationEx on
+ * Windows on first use. Without that information every online CPU is its
+ * own performance core on node 0.
+ *
+ * @return Topology, valid for the lifetime of the process
+ */
+const ve_cpu_topology* ve_cpu_get_topology(void);
+
+/**
+ * @brief Order CPUs for placing busy threads
+ *
+ * First hardware threads of performance cores, then of efficiency cores,
+ * then the remaining SMT siblings, so threads land on separate physical
+ * cores for as long as there are any and on efficiency cores only once
+ * the performance cores are taken. Within each class CPUs are grouped by
+ * NUMA node. Only available CPUs are listed.
+ *
+ * @param topology Topology
+ * @param numa_node Only list CPUs of this node, -1 for any
+ * @param cpus Output CPU numbers
+ * @param capacity Capacity of cpus
+ * @return Number of CPUs written
+ */
+uint32_t ve_cpu_get_placement(const ve_cpu_topology* topology, int32_t numa_node, uint32_t* cpus, uint32_t capacity);
+
+/**
+ * @brief Restrict a thread to a set of CPUs
+ *
+ * On Windows the set must lie within one processor group.
+ *
+ * @param thread Thread, NULL for the calling thread
+ * @param cpus CPUs the thread may run on
+ * @return true on success
+ */
+bool ve_thread_set_affinity(ve_thread* thread, const ve_cpu_set* cpus);
+
+/**
+ * @brief Get the CPUs a thread may run on
+ *
+ * @param thread Thread, NULL for the calling thread
+ * @param cpus Output set
+ * @return true on success
+ */
+bool ve_thread_get_affinity(ve_thread* thread, ve_cpu_set* cpus);
+
+/**
+ * @brief Set a thread's scheduling priority
+ *
+ * @param thread Thread, NULL for the calling thread
+ * @param priority Priority
+ * @return true on success
+ */
+bool ve_thread_set_priority(ve_thread* thread, ve_thread_priority priority);
+
 /* Mutex functions */
 
 /**
@@ -271,7 +452,7 @@ bool ve_condvar_wait(ve_condvar* cv, ve_mutex* mutex, uint32_t timeout_ms);
  * @brief Create a new semaphore
  *
  * @param initial_count Initial count value
- * @param max_count Maximum count value
+ * @param max_count Maximum count value, clamped to 2^20 - 1
  * @return Semaphore, or NULL on failure
  */
 ve_semaphore* ve_semaphore_create(uint32_t initial_count, uint32_t max_count);
@@ -296,10 +477,98 @@ bool ve_semaphore_wait(ve_semaphore* sem, uint32_t timeout_ms);
  * @brief Signal semaphore (increment count)
  *
  * @param sem Semaphore to signal
- * @return true on success
+ * @return false if the count is already at its maximum
  */
 bool ve_semaphore_signal(ve_semaphore* sem);
 
+/* Futex functions */
+
+/**
+ * @brief Sleep while a value equals an expected value
+ *
+ * The comparison and going to sleep are atomic with respect to
+ * ve_futex_wake_*() on the same address. May return spuriously; callers
+ * re-check their condition. Uses futex on Linux and WaitOnAddress on
+ * Windows.
+ *
+ * @param atomic Value to watch
+ * @param expected Sleep only while the value equals this
+ * @param timeout_ms Timeout in milliseconds (UINT32_MAX = infinite)
+ * @return false if the timeout expired
+ */
+bool ve_futex_wait(const ve_atomic_int32* atomic, int32_t expected, uint32_t timeout_ms);
+
+/**
+ * @brief Wake one thread sleeping in ve_futex_wait() on a value
+ *
+ * @param atomic Value the thread sleeps on
+ */
+void ve_futex_wake_one(const ve_atomic_int32* atomic);
+
+/**
+ * @brief Wake every thread sleeping in ve_futex_wait() on a value
+ *
+ * @param atomic Value the threads sleep on
+ */
+void ve_futex_wake_all(const ve_atomic_int32* atomic);
+
+/* Lightweight lock functions */
+
+/**
+ * @brief Acquire a lock, spinning briefly and then sleeping
+ *
+ * @param lock Lock to acquire
+ */
+void ve_lock_acquire(ve_lock* lock);
+
+/**
+ * @brief Try to acquire a lock without waiting
+ *
+ * @param lock Lock to try
+ * @return true if acquired
+ */
+bool ve_lock_try_acquire(ve_lock* lock);
+
+/**
+ * @brief Release a lock, waking one sleeper if there is any
+ *
+ * @param lock Lock held by the calling thread
+ */
+void ve_lock_release(ve_lock* lock);
+
+/* Event functions */
+
+/**
+ * @brief Set an event, releasing every waiter
+ *
+ * @param event Event to set
+ */
+void ve_event_set(ve_event* event);
+
+/**
+ * @brief Reset an event to unset
+ *
+ * @param event Event to reset
+ */
+void ve_event_reset(ve_event* event);
+
+/**
+ * @brief Check whether an event is set
+ *
+ * @param event Event to check
+ * @return true if set
+ */
+bool ve_event_is_set(const ve_event* event);
+
+/**
+ * @brief Wait for an event to be set
+ *
+ * @param event Event to wait on
+ * @param timeout_ms Timeout in milliseconds (UINT32_MAX = infinite)
+ * @return true if set, false on timeout
+ */
+bool ve_event_wait(ve_event* event, uint32_t timeout_ms);
+
 /* Atomic operations */
 
 /**
@@ -312,6 +581,11 @@ int32_t ve_atomic_load32(const volatile ve_atomic_int32* atomic);
  */
 void ve_atomic_store32(volatile ve_atomic_int32* atomic, int32_t value);
 
+/**
+ * @brief Atomic exchange of 32-bit integer (returns old value)
+ */
+int32_t ve_atomic_exchange32(volatile ve_atomic_int32* atomic, int32_t value);
+
 /**
  * @brief Atomic add to 32-bit integer (returns old value)
  */
@@ -354,6 +628,13 @@ void ve_atomic_store64(volatile ve_atomic_int64* atomic, int64_t value);
  */
 int64_t ve_atomic_fetch_add64(volatile ve_atomic_int64* atomic, int64_t operand);
 
+/**
+ * @brief Atomic compare and exchange 64-bit integer
+ *
+ * @return true if exchange occurred
+ */
+bool ve_atomic_compare_exchange64(volatile ve_atomic_int64* atomic, int64_t* expected, int64_t desired);
+
 /**
  * @brief Atomic load pointer
  */
@@ -364,6 +645,11 @@ void* ve_atomic_load_ptr(const volatile ve_atomic_ptr* atomic);
  */
 void ve_atomic_store_ptr(volatile ve_atomic_ptr* atomic, void* value);
 
+/**
+ * @brief Atomic exchange of pointer (returns old value)
+ */
+void* ve_atomic_exchange_ptr(volatile ve_atomic_ptr* atomic, void* value);
+
 /**
  * @brief Atomic compare and exchange pointer
  *
@@ -449,6 +735,10 @@ void* ve_tls_get(ve_tls_key* key);
 
 /**
  * @brief Thread pool handle
+ *
+ * Each worker owns a work-stealing deque. Tasks submitted from a worker go to
+ * its own deque; tasks submitted from any other thread go to a shared deque.
+ * Idle workers steal from the other deques before going to sleep.
  */
 typedef struct ve_thread_pool ve_thread_pool;
 
@@ -457,6 +747,52 @@ typedef struct ve_thread_pool ve_thread_pool;
  */
 typedef void (*ve_task_fn)(void* user_data);
 
+/**
+ * @brief Job counter
+ *
+ * Tracks a group of jobs: every job submitted with the counter increments it,
+ * and decrements it once the job has finished. Jobs submitted with a counter as
+ * their dependency are held back until it drops to zero. Initialize with
+ * ve_job_counter_init() and keep it alive until ve_thread_pool_wait_counter()
+ * has returned or ve_job_counter_is_done() has returned true.
+ */
+typedef struct ve_job_counter {
+    ve_atomic_int32 value;
+    ve_lock lock;
+    void* waiters;
+} ve_job_counter;
+
+/**
+ * @brief Group of tasks that can be waited on independently of the rest of the pool
+ */
+typedef struct ve_task_group {
+    ve_thread_pool* pool;
+    ve_job_counter counter;
+} ve_task_group;
+
+/**
+ * @brief Range function for ve_parallel_for
+ *
+ * @param begin First index of the chunk
+ * @param end One past the last index of the chunk
+ * @param user_data User data passed to ve_parallel_for
+ */
+typedef void (*ve_parallel_for_fn)(uint32_t begin, uint32_t end, void* user_data);
+
+/**
+ * @brief Thread pool placement
+ *
+ * Zeroed fields select the defaults: one unpinned worker per logical CPU
+ * at normal priority.
+ */
+typedef struct ve_thread_pool_config {
+    uint32_t thread_count;          /* 0 for one per placement CPU left after the reserved ones */
+    uint32_t reserved_cpus;         /* Leading CPUs of the placement order kept for other threads */
+    bool pin_workers;               /* Pin worker i to the i-th CPU after the reserved ones, wrapping */
+    bool numa_local;                /* Keep workers on the node of the first placement CPU */
+    ve_thread_priority priority;
+} ve_thread_pool_config;
+
 /**
  * @brief Create a thread pool
  *
@@ -465,9 +801,24 @@ typedef void (*ve_task_fn)(void* user_data);
  */
 ve_thread_pool* ve_thread_pool_create(uint32_t num_threads);
 
+/**
+ * @brief Create a thread pool with placement control
+ *
+ * Pinned workers do not migrate between cores, and with reserved CPUs
+ * they leave the first cores of ve_cpu_get_placement (performance cores
+ * on hybrid CPUs) to the threads pinned there, such as the render thread.
+ * Placement that the OS refuses is logged and the workers run unpinned.
+ *
+ * @param config Placement, NULL for the defaults
+ * @return Thread pool, or NULL on failure
+ */
+ve_thread_pool* ve_thread_pool_create_with_config(const ve_thread_pool_config* config);
+
 /**
  * @brief Destroy a thread pool
  *
+ * Outstanding tasks are completed before the workers are stopped.
+ *
  * @param pool Thread pool to destroy
  */
 void ve_thread_pool_destroy(ve_thread_pool* pool);
@@ -482,13 +833,37 @@ void ve_thread_pool_destroy(ve_thread_pool* pool);
  */
 bool ve_thread_pool_submit(ve_thread_pool* pool, ve_task_fn task, void* user_data);
 
+/**
+ * @brief Submit a task with an optional dependency and completion counter
+ *
+ * @param pool Thread pool
+ * @param task Task function
+ * @param user_data User data for task
+ * @param dependency Counter that must reach zero before the task runs (may be NULL)
+ * @param counter Counter incremented now and decremented when the task finishes (may be NULL)
+ * @return true if task was submitted
+ */
+bool ve_thread_pool_submit_job(ve_thread_pool* pool, ve_task_fn task, void* user_data,
+                               ve_job_counter* dependency, ve_job_counter* counter);
+
 /**
  * @brief Wait for all tasks to complete
  *
+ * The calling thread executes pending tasks while it waits. Must not be called
+ * from inside a task; use ve_thread_pool_wait_counter() there instead.
+ *
  * @param pool Thread pool
  */
 void ve_thread_pool_wait(ve_thread_pool* pool);
 
+/**
+ * @brief Wait for a job counter to reach zero, executing tasks meanwhile
+ *
+ * @param pool Thread pool
+ * @param counter Counter to wait on
+ */
+void ve_thread_pool_wait_counter(ve_thread_pool* pool, ve_job_counter* counter);
+
 /**
  * @brief Get the number of worker threads
  *
@@ -498,13 +873,96 @@ void ve_thread_pool_wait(ve_thread_pool* pool);
 uint32_t ve_thread_pool_get_thread_count(const ve_thread_pool* pool);
 
 /**
- * @brief Get approximate number of pending tasks
+ * @brief Get the index of the calling thread within a pool
+ *
+ * Lets tasks pick per-worker state without locking. Every thread outside
+ * the pool gets the same index.
+ *
+ * @param pool Thread pool
+ * @return Worker index below the thread count, or the thread count outside the pool
+ */
+uint32_t ve_thread_pool_get_worker_index(ve_thread_pool* pool);
+
+/**
+ * @brief Get approximate number of tasks that have not finished yet
  *
  * @param pool Thread pool
- * @return Number of pending tasks
+ * @return Number of queued or running tasks
  */
 size_t ve_thread_pool_get_pending_count(const ve_thread_pool* pool);
 
+/**
+ * @brief Reset a job counter
+ *
+ * @param counter Counter to initialize
+ */
+void ve_job_counter_init(ve_job_counter* counter);
+
+/**
+ * @brief Check whether all jobs tracked by a counter have finished
+ *
+ * @param counter Counter to check
+ * @return true if the counter is zero
+ */
+bool ve_job_counter_is_done(const ve_job_counter* counter);
+
+/* Task groups */
+
+/**
+ * @brief Initialize a task group
+ *
+ * @param group Task group to initialize
+ * @param pool Thread pool the group's tasks run on
+ */
+void ve_task_group_init(ve_task_group* group, ve_thread_pool* pool);
+
+/**
+ * @brief Run a task as part of a group
+ *
+ * @param group Task group
+ * @param task Task function
+ * @param user_data User data for task
+ * @return true if task was submitted
+ */
+bool ve_task_group_run(ve_task_group* group, ve_task_fn task, void* user_data);
+
+/**
+ * @brief Wait until every task of the group has finished
+ *
+ * The calling thread executes pending tasks while it waits, so this is safe
+ * to call from inside another task.
+ *
+ * @param group Task group
+ */
+void ve_task_group_wait(ve_task_group* group);
+
+/**
+ * @brief Check whether every task of the group has finished
+ *
+ * @param group Task group
+ * @return true if no task of the group is queued or running
+ */
+bool ve_task_group_is_done(const ve_task_group* group);
+
+/* Parallel for */
+
+/**
+ * @brief Split [begin, end) into chunks and process them on the pool
+ *
+ * Chunks are claimed dynamically by at most one task per worker plus the
+ * calling thread, so the cost does not grow with the number of chunks. Returns
+ * once the whole range has been processed.
+ *
+ * @param pool Thread pool (NULL runs the whole range on the calling thread)
+ * @param begin First index
+ * @param end One past the last index
+ * @param grain Chunk size (0 = pick one from the range and worker count)
+ * @param fn Range function
+ * @param user_data User data for fn
+ */
+void ve_parallel_for(ve_thread_pool* pool, uint32_t begin, uint32_t end, uint32_t grain,
+                     ve_parallel_for_fn fn, void* user_data);
+
 #ifdef __cplusplus
 }
 #endif
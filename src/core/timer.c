@@ -24,6 +24,12 @@ static double g_timer_frequency = 0.0;
 static double g_target_fps = 60.0;
 static double g_fixed_timestep = 1.0 / 60.0;
 
+/* The limiter sleeps until this close to the deadline and spins the rest */
+#define VE_LIMITER_SPIN_SECONDS 0.002
+
+static bool g_limiter_enabled = false;
+static ve_timestamp g_limiter_frame_start = 0;
+
 bool ve_timer_init(void) {
 #if defined(VE_PLATFORM_WINDOWS)
     LARGE_INTEGER frequency;
@@ -244,3 +250,40 @@ double ve_frame_time_get_alpha(const ve_frame_time* ft) {
     (void)ft;  /* Unused */
     return g_frame_state.accumulator / g_fixed_timestep;
 }
+
+void ve_frame_time_set_limiter_enabled(bool enabled) {
+    g_limiter_enabled = enabled;
+    g_limiter_frame_start = 0;
+}
+
+bool ve_frame_time_is_limiter_enabled(void) {
+    return g_limiter_enabled;
+}
+
+double ve_frame_time_limit(void) {
+    if (!g_limiter_enabled) {
+        return 0.0;
+    }
+
+    ve_timestamp start = ve_timer_now();
+
+    /* The first frame only starts the clock */
+    if (g_limiter_frame_start == 0) {
+        g_limiter_frame_start = start;
+        return 0.0;
+    }
+
+    double period = 1.0 / g_target_fps;
+    double remaining = period - ve_timer_elapsed(g_limiter_frame_start, start);
+    if (remaining > VE_LIMITER_SPIN_SECONDS) {
+        ve_timer_sleep(remaining - VE_LIMITER_SPIN_SECONDS);
+    }
+
+    ve_timestamp now = ve_timer_now();
+    while (ve_timer_elapsed(g_limiter_frame_start, now) < period) {
+        now = ve_timer_now();
+    }
+
+    g_limiter_frame_start = now;
+    return ve_timer_elapsed(start, now);
+}
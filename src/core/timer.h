@@ -201,69 +201,40 @@ void ve_frame_time_consume_update(ve_frame_time* ft);
  */
 double ve_frame_time_get_alpha(const ve_frame_time* ft);
 
-/* Utility macros */
-
 /**
- * @brief Scope-based timing
+ * @brief Enable or disable the frame-rate limiter
  *
- * Usage:
- * @code
- * VE_TIMED_SCOPE("MyFunction") {
- *     // Code to time
- * }
- * @endcode
- */
-#define VE_TIMED_SCOPE(name) \
-    ve_timer VE_CAT(_timer_, __LINE__) = ve_timer_start(); \
-    if (0)
-
-/**
- * @brief Function timing
+ * The limiter holds frames to the target FPS set with
+ * ve_frame_time_set_target_fps. It is disabled by default.
  *
- * Usage:
- * @code
- * void my_function(void) {
- *     VE_TIMED_FUNCTION();
- *     // Function code
- * }
- * @endcode
+ * @param enabled true to limit the frame rate
  */
-#define VE_TIMED_FUNCTION() \
-    ve_timer VE_CAT(_timer_, __LINE__) = ve_timer_start(); \
-    if (0)
+void ve_frame_time_set_limiter_enabled(bool enabled);
 
 /**
- * @brief Measure elapsed time at end of scope
+ * @brief Check if the frame-rate limiter is enabled
+ *
+ * @return true if frames are limited to the target FPS
  */
-#define VE_TIME_SCOPE(name) \
-    ve_timer VE_CAT(_timer_, __LINE__) = ve_timer_start(); \
-    if (0)
-
-/* Helper macros */
-#define VE_CAT_IMPL(a, b) a##b
-#define VE_CAT(a, b) VE_CAT_IMPL(a, b)
+bool ve_frame_time_is_limiter_enabled(void);
 
 /**
- * @brief RAII-style timer that logs on scope exit
+ * @brief Wait until the next frame may start
+ *
+ * Sleeps for most of the remaining frame budget and spins for the rest,
+ * since OS sleeps overshoot by up to a scheduler tick. Call it right
+ * before sampling input so each frame starts from the freshest input.
+ * Does nothing while the limiter is disabled.
+ *
+ * @return Time spent waiting in seconds
  */
-#ifdef __GNUC__
-    #define VE_SCOPED_TIMER(name) \
-        __attribute__((cleanup(_ve ScopedTimer_cleanup))) \
-        ve_timer VE_CAT(_scoped_timer_, __LINE__) = ve_timer_start(); \
-        const char* VE_CAT(_scoped_name_, __LINE__) = name
-
-    static inline void _ve_ScopedTimer_cleanup(ve_timer* timer) {
-        double elapsed = ve_timer_get_elapsed(timer);
-        VE_LOG_DEBUG("Timer: %s took %.6f seconds", "scope", elapsed);
-    }
-#else
-    #define VE_SCOPED_TIMER(name) \
-        ve_timer VE_CAT(_scoped_timer_, __LINE__) = ve_timer_start(); \
-        if (0)
-#endif
+double ve_frame_time_limit(void);
 
 #ifdef __cplusplus
 }
 #endif
 
+/* Scope timing macros (VE_TIMED_SCOPE, VE_SCOPED_TIMER, ...) */
+#include "profiler.h"
+
 #endif /* VE_TIMER_H */
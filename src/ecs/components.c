@@ -4,5 +4,42 @@
  */
 
 #include "components.h"
+#include "../core/logger.h"
+#include "../core/assert.h"
 
-/* TODO: Implement built-in components */
+#include <stdalign.h>
+#include <string.h>
+
+bool ve_components_register(ve_world* world) {
+    VE_ASSERT(world);
+
+    const struct {
+        ve_builtin_component id;
+        const char* name;
+        size_t size;
+        size_t alignment;
+    } builtins[] = {
+        {VE_COMPONENT_TRANSFORM, "transform", sizeof(ve_transform_component), alignof(ve_transform_component)},
+        {VE_COMPONENT_BOUNDS, "bounds", sizeof(ve_bounds_component), alignof(ve_bounds_component)},
+        {VE_COMPONENT_RENDER, "render", sizeof(ve_render_component), alignof(ve_render_component)},
+    };
+
+    for (uint32_t i = 0; i < sizeof(builtins) / sizeof(builtins[0]); i++) {
+        ve_component_id id = ve_ecs_register_component(world, builtins[i].name, builtins[i].size,
+                                                       builtins[i].alignment);
+        if (id != (ve_component_id)builtins[i].id) {
+            VE_LOG_ERROR("Built-in component '%s' must be registered first", builtins[i].name);
+            return false;
+        }
+    }
+    return true;
+}
+
+void ve_transform_identity(ve_transform_component* transform) {
+    VE_ASSERT(transform);
+    memset(transform, 0, sizeof(ve_transform_component));
+    transform->rotation[3] = 1.0f;
+    transform->scale[0] = 1.0f;
+    transform->scale[1] = 1.0f;
+    transform->scale[2] = 1.0f;
+}
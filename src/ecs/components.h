@@ -1,18 +1,74 @@
 /**
  * @file components.h
  * @brief Built-in ECS components
+ *
+ * The components every renderable entity carries. They are registered
+ * first in a world, so their IDs are the constants below in every world.
  */
 
 #ifndef VE_COMPONENTS_H
 #define VE_COMPONENTS_H
 
+#include "ecs.h"
 #include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* TODO: Implement built-in components */
+/**
+ * @brief IDs of the built-in components
+ */
+typedef enum ve_builtin_component {
+    VE_COMPONENT_TRANSFORM = 0,
+    VE_COMPONENT_BOUNDS,
+    VE_COMPONENT_RENDER,
+    VE_BUILTIN_COMPONENT_COUNT
+} ve_builtin_component;
+
+/**
+ * @brief Local position, rotation and scale
+ */
+typedef struct ve_transform_component {
+    float position[3];
+    float rotation[4];          /* Quaternion x, y, z, w */
+    float scale[3];
+} ve_transform_component;
+
+/**
+ * @brief World-space bounding sphere, laid out as ve_gpu_cull_instance expects
+ */
+typedef struct ve_bounds_component {
+    float center[3];
+    float radius;
+} ve_bounds_component;
+
+/**
+ * @brief What to draw for an entity
+ */
+typedef struct ve_render_component {
+    uint32_t mesh;              /* From ve_gpu_culling_add_mesh */
+    uint32_t material;
+    uint32_t batch;             /* Pipeline and buffer binding group */
+    uint32_t flags;
+} ve_render_component;
+
+/**
+ * @brief Register the built-in components
+ *
+ * Must be the first registrations in the world.
+ *
+ * @param world World without components
+ * @return true on success
+ */
+bool ve_components_register(ve_world* world);
+
+/**
+ * @brief Identity transform
+ *
+ * @param transform Output transform
+ */
+void ve_transform_identity(ve_transform_component* transform);
 
 #ifdef __cplusplus
 }
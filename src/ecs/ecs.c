@@ -4,5 +4,805 @@
  */
 
 #include "ecs.h"
+#include "../core/memory.h"
+#include "../core/logger.h"
+#include "../core/assert.h"
+#include "../platform/platform.h"
 
-/* TODO: Implement ECS */
+#include <string.h>
+
+#define ENTITY_INDEX_MASK (VE_ECS_MAX_ENTITIES - 1)
+#define ENTITY_GENERATION_MASK ((1u << VE_ENTITY_GENERATION_BITS) - 1)
+
+/* Marks an absent column and a free entity slot */
+#define ECS_NONE UINT32_MAX
+
+/**
+ * @brief Component type
+ */
+typedef struct ve_ecs_component_info {
+    const char* name;
+    uint32_t size;
+    uint32_t alignment;
+} ve_ecs_component_info;
+
+/**
+ * @brief Chunk of an archetype
+ */
+typedef struct ve_ecs_chunk {
+    void* memory;               /* Allocation, data is aligned inside it */
+    uint8_t* data;
+    uint32_t count;
+    uint32_t versions[VE_ECS_MAX_COMPONENTS];       /* Last change per component */
+} ve_ecs_chunk;
+
+/**
+ * @brief Entities sharing one component set
+ */
+typedef struct ve_archetype {
+    ve_component_mask mask;
+    uint32_t capacity;                                  /* Rows per chunk */
+    uint32_t entity_count;
+    uint32_t column_offsets[VE_ECS_MAX_COMPONENTS];     /* ECS_NONE for absent components */
+    ve_ecs_chunk* chunks;
+    uint32_t chunk_count;
+    uint32_t chunk_capacity;
+} ve_archetype;
+
+/**
+ * @brief Location of an entity slot
+ *
+ * Free slots have archetype ECS_NONE and chain through row.
+ */
+typedef struct ve_entity_record {
+    uint32_t generation;
+    uint32_t archetype;
+    uint32_t chunk;
+    uint32_t row;
+} ve_entity_record;
+
+struct ve_world {
+    ve_ecs_component_info components[VE_ECS_MAX_COMPONENTS];
+    uint32_t component_count;
+
+    ve_archetype* archetypes;
+    uint32_t archetype_count;
+    uint32_t archetype_capacity;
+
+    ve_entity_record* records;
+    uint32_t record_count;
+    uint32_t record_capacity;
+    uint32_t free_head;
+
+    uint32_t entity_count;
+    uint32_t version;               /* Stamped on changes */
+    size_t chunk_alignment;         /* Cache line size */
+};
+
+static ve_entity make_entity(uint32_t index, uint32_t generation) {
+    return (generation << VE_ENTITY_INDEX_BITS) | index;
+}
+
+static uint32_t entity_index(ve_entity entity) {
+    return entity & ENTITY_INDEX_MASK;
+}
+
+static uint32_t entity_generation(ve_entity entity) {
+    return entity >> VE_ENTITY_INDEX_BITS;
+}
+
+/**
+ * @brief Get the record of a live entity
+ *
+ * @return Record, or NULL for stale or invalid handles
+ */
+static ve_entity_record* find_record(const ve_world* world, ve_entity entity) {
+    uint32_t index = entity_index(entity);
+    if (index >= world->record_count) {
+        return NULL;
+    }
+    ve_entity_record* record = &world->records[index];
+    if (record->archetype == ECS_NONE || record->generation != entity_generation(entity)) {
+        return NULL;
+    }
+    return record;
+}
+
+static uint8_t* chunk_column(const ve_archetype* archetype, const ve_ecs_chunk* chunk, ve_component_id component) {
+    return chunk->data + archetype->column_offsets[component];
+}
+
+/**
+ * @brief Mark every component of a chunk changed, after rows moved in or around
+ */
+static void touch_chunk(ve_ecs_chunk* chunk, uint32_t version) {
+    for (uint32_t c = 0; c < VE_ECS_MAX_COMPONENTS; c++) {
+        chunk->versions[c] = version;
+    }
+}
+
+/**
+ * @brief Lay out the columns of an archetype
+ *
+ * The entity array comes first and every column starts on a cache line.
+ * The row count is the largest that fits VE_ECS_CHUNK_SIZE.
+ *
+ * @return false if not even one row fits
+ */
+static bool layout_archetype(const ve_world* world, ve_archetype* archetype) {
+    size_t row_size = sizeof(ve_entity);
+    uint32_t column_count = 0;
+    for (uint32_t c = 0; c < world->component_count; c++) {
+        archetype->column_offsets[c] = ECS_NONE;
+        if (archetype->mask & VE_COMPONENT_BIT(c)) {
+            row_size += world->components[c].size;
+            column_count++;
+        }
+    }
+    for (uint32_t c = world->component_count; c < VE_ECS_MAX_COMPONENTS; c++) {
+        archetype->column_offsets[c] = ECS_NONE;
+    }
+
+    size_t line = world->chunk_alignment;
+    if (row_size + (column_count + 1) * line > VE_ECS_CHUNK_SIZE) {
+        return false;
+    }
+
+    /* Start from the estimate ignoring padding, then shrink until the padded layout fits */
+    uint32_t capacity = (uint32_t)((VE_ECS_CHUNK_SIZE - column_count * line) / row_size);
+    for (; capacity > 1; capacity--) {
+        size_t offset = ve_align_size(capacity * sizeof(ve_entity), line);
+        for (uint32_t c = 0; c < world->component_count; c++) {
+            if (archetype->mask & VE_COMPONENT_BIT(c)) {
+                offset = ve_align_size(offset + (size_t)capacity * world->components[c].size, line);
+            }
+        }
+        if (offset <= VE_ECS_CHUNK_SIZE) {
+            break;
+        }
+    }
+
+    size_t offset = ve_align_size(capacity * sizeof(ve_entity), line);
+    for (uint32_t c = 0; c < world->component_count; c++) {
+        if (archetype->mask & VE_COMPONENT_BIT(c)) {
+            archetype->column_offsets[c] = (uint32_t)offset;
+            offset = ve_align_size(offset + (size_t)capacity * world->components[c].size, line);
+        }
+    }
+    archetype->capacity = capacity;
+    return true;
+}
+
+/**
+ * @brief Find the archetype of a component set, creating it on first use
+ *
+ * @return Archetype index, or ECS_NONE if out of memory
+ */
+static uint32_t get_archetype(ve_world* world, ve_component_mask mask) {
+    for (uint32_t i = 0; i < world->archetype_count; i++) {
+        if (world->archetypes[i].mask == mask) {
+            return i;
+        }
+    }
+
+    if (world->archetype_count == world->archetype_capacity) {
+        uint32_t capacity = world->archetype_capacity ? world->archetype_capacity * 2 : 16;
+        ve_archetype* archetypes = (ve_archetype*)ve_reallocate(world->archetypes, capacity * sizeof(ve_archetype),
+                                                                VE_MEMORY_TAG_ECS);
+        if (!archetypes) {
+            return ECS_NONE;
+        }
+        world->archetypes = archetypes;
+        world->archetype_capacity = capacity;
+    }
+
+    ve_archetype* archetype = &world->archetypes[world->archetype_count];
+    memset(archetype, 0, sizeof(ve_archetype));
+    archetype->mask = mask;
+    if (!layout_archetype(world, archetype)) {
+        VE_LOG_ERROR("Components of archetype 0x%llx do not fit a %u byte chunk", (unsigned long long)mask,
+                     VE_ECS_CHUNK_SIZE);
+        return ECS_NONE;
+    }
+    return world->archetype_count++;
+}
+
+/**
+ * @brief Reserve the next row of an archetype
+ *
+ * @return false if out of memory
+ */
+static bool push_row(ve_world* world, ve_archetype* archetype, uint32_t* chunk_index, uint32_t* row) {
+    ve_ecs_chunk* last = archetype->chunk_count > 0 ? &archetype->chunks[archetype->chunk_count - 1] : NULL;
+    if (!last || last->count == archetype->capacity) {
+        if (archetype->chunk_count == archetype->chunk_capacity) {
+            uint32_t capacity = archetype->chunk_capacity ? archetype->chunk_capacity * 2 : 4;
+            ve_ecs_chunk* chunks = (ve_ecs_chunk*)ve_reallocate(archetype->chunks, capacity * sizeof(ve_ecs_chunk),
+                                                                VE_MEMORY_TAG_ECS);
+            if (!chunks) {
+                return false;
+            }
+            archetype->chunks = chunks;
+            archetype->chunk_capacity = capacity;
+        }
+
+        /* The allocator only guarantees 16-byte alignment, so over-allocate and align inside */
+        size_t line = world->chunk_alignment;
+        void* memory = VE_ALLOCATE_TAG(VE_ECS_CHUNK_SIZE + line, VE_MEMORY_TAG_ECS);
+        if (!memory) {
+            return false;
+        }
+        last = &archetype->chunks[archetype->chunk_count++];
+        last->memory = memory;
+        last->data = (uint8_t*)(((uintptr_t)memory + line - 1) & ~(uintptr_t)(line - 1));
+        last->count = 0;
+    }
+
+    *chunk_index = archetype->chunk_count - 1;
+    *row = last->count++;
+    archetype->entity_count++;
+    touch_chunk(last, world->version);
+    return true;
+}
+
+/**
+ * @brief Remove a row, filling the hole with the archetype's last entity
+ */
+static void remove_row(ve_world* world, ve_archetype* archetype, uint32_t chunk_index, uint32_t row) {
+    ve_ecs_chunk* chunk = &archetype->chunks[chunk_index];
+    ve_ecs_chunk* last = &archetype->chunks[archetype->chunk_count - 1];
+    uint32_t last_row = last->count - 1;
+
+    if (chunk != last || row != last_row) {
+        ve_entity* entities = (ve_entity*)chunk->data;
+        ve_entity moved = ((ve_entity*)last->data)[last_row];
+        entities[row] = moved;
+        for (uint32_t c = 0; c < world->component_count; c++) {
+            if (archetype->column_offsets[c] != ECS_NONE && world->components[c].size > 0) {
+                size_t size = world->components[c].size;
+                memcpy(chunk_column(archetype, chunk, c) + row * size,
+                       chunk_column(archetype, last, c) + last_row * size, size);
+            }
+        }
+
+        ve_entity_record* record = &world->records[entity_index(moved)];
+        record->chunk = chunk_index;
+        record->row = row;
+        touch_chunk(chunk, world->version);
+    }
+
+    last->count--;
+    archetype->entity_count--;
+    if (last->count == 0) {
+        VE_FREE(last->memory);
+        archetype->chunk_count--;
+    }
+}
+
+/**
+ * @brief Move an entity to another archetype, keeping the components both share
+ *
+ * Components new to the entity are zeroed.
+ *
+ * @return false if out of memory, with the entity left where it was
+ */
+static bool move_entity(ve_world* world, ve_entity entity, ve_entity_record* record, uint32_t target) {
+    uint32_t chunk_index, row;
+    if (!push_row(world, &world->archetypes[target], &chunk_index, &row)) {
+        return false;
+    }
+
+    ve_archetype* source = &world->archetypes[record->archetype];
+    ve_archetype* destination = &world->archetypes[target];
+    ve_ecs_chunk* from = &source->chunks[record->chunk];
+    ve_ecs_chunk* to = &destination->chunks[chunk_index];
+
+    ((ve_entity*)to->data)[row] = entity;
+    for (uint32_t c = 0; c < world->component_count; c++) {
+        size_t size = world->components[c].size;
+        if (destination->column_offsets[c] == ECS_NONE || size == 0) {
+            continue;
+        }
+        uint8_t* dst = chunk_column(destination, to, c) + row * size;
+        if (source->column_offsets[c] != ECS_NONE) {
+            memcpy(dst, chunk_column(source, from, c) + record->row * size, size);
+        } else {
+            memset(dst, 0, size);
+        }
+    }
+
+    remove_row(world, source, record->chunk, record->row);
+    record->archetype = target;
+    record->chunk = chunk_index;
+    record->row = row;
+    return true;
+}
+
+ve_world* ve_world_create(void) {
+    ve_world* world = (ve_world*)ve_allocate_cleared(1, sizeof(ve_world), VE_MEMORY_TAG_ECS);
+    if (!world) {
+        return NULL;
+    }
+
+    /* Features are zero before ve_platform_init */
+    const ve_cpu_features* features = ve_get_cpu_features();
+    size_t line = features && features->cache_line_size > 0 ? (size_t)features->cache_line_size : 64;
+    if ((line & (line - 1)) != 0) {
+        line = 64;
+    }
+    world->chunk_alignment = line;
+    world->free_head = ECS_NONE;
+    world->version = 1;
+
+    /* Archetype 0 holds entities without components */
+    if (get_archetype(world, 0) == ECS_NONE) {
+        ve_world_destroy(world);
+        return NULL;
+    }
+    return world;
+}
+
+void ve_world_destroy(ve_world* world) {
+    if (!world) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < world->archetype_count; i++) {
+        ve_archetype* archetype = &world->archetypes[i];
+        for (uint32_t c = 0; c < archetype->chunk_count; c++) {
+            VE_FREE(archetype->chunks[c].memory);
+        }
+        VE_FREE(archetype->chunks);
+    }
+    VE_FREE(world->archetypes);
+    VE_FREE(world->records);
+    VE_FREE(world);
+}
+
+ve_component_id ve_ecs_register_component(ve_world* world, const char* name, size_t size, size_t alignment) {
+    VE_ASSERT(world && name);
+    VE_ASSERT_MSG(alignment > 0 && (alignment & (alignment - 1)) == 0, "Component alignment must be a power of two");
+    VE_ASSERT_MSG(alignment <= world->chunk_alignment, "Component alignment above the cache line size");
+    VE_ASSERT_MSG(size <= VE_ECS_MAX_COMPONENT_SIZE, "Component too large for a chunk");
+
+    if (world->component_count == VE_ECS_MAX_COMPONENTS) {
+        VE_LOG_ERROR("Too many component types, cannot register '%s'", name);
+        return VE_INVALID_COMPONENT;
+    }
+
+    ve_component_id id = world->component_count++;
+    world->components[id] = (ve_ecs_component_info){
+        .name = name,
+        .size = (uint32_t)size,
+        .alignment = (uint32_t)alignment,
+    };
+
+    /* Existing archetypes already mark every unregistered ID as absent */
+    return id;
+}
+
+size_t ve_ecs_get_component_size(const ve_world* world, ve_component_id component) {
+    VE_ASSERT(world && component < world->component_count);
+    return world->components[component].size;
+}
+
+ve_entity ve_ecs_create_entity(ve_world* world) {
+    return ve_ecs_create_entity_with(world, 0);
+}
+
+ve_entity ve_ecs_create_entity_with(ve_world* world, ve_component_mask components) {
+    VE_ASSERT(world);
+    VE_ASSERT_MSG(world->component_count == VE_ECS_MAX_COMPONENTS ||
+                  (components >> world->component_count) == 0, "Unregistered component in mask");
+
+    /* Take a slot before touching storage, so failures leave nothing behind */
+    uint32_t index = world->free_head;
+    if (index == ECS_NONE) {
+        if (world->record_count == VE_ECS_MAX_ENTITIES) {
+            VE_LOG_ERROR("Entity limit (%u) reached", VE_ECS_MAX_ENTITIES);
+            return VE_ENTITY_NULL;
+        }
+        if (world->record_count == world->record_capacity) {
+            uint32_t capacity = world->record_capacity ? world->record_capacity * 2 : 1024;
+            ve_entity_record* records = (ve_entity_record*)ve_reallocate(world->records,
+                                                                         capacity * sizeof(ve_entity_record),
+                                                                         VE_MEMORY_TAG_ECS);
+            if (!records) {
+                return VE_ENTITY_NULL;
+            }
+            world->records = records;
+            world->record_capacity = capacity;
+        }
+        index = world->record_count;
+        world->records[index] = (ve_entity_record){.generation = 1, .archetype = ECS_NONE, .row = ECS_NONE};
+    }
+
+    uint32_t archetype_index = get_archetype(world, components);
+    if (archetype_index == ECS_NONE) {
+        return VE_ENTITY_NULL;
+    }
+
+    ve_archetype* archetype = &world->archetypes[archetype_index];
+    uint32_t chunk_index, row;
+    if (!push_row(world, archetype, &chunk_index, &row)) {
+        return VE_ENTITY_NULL;
+    }
+
+    /* Commit the slot */
+    ve_entity_record* record = &world->records[index];
+    if (index == world->free_head) {
+        world->free_head = record->row;
+    } else {
+        world->record_count++;
+    }
+
+    ve_entity entity = make_entity(index, record->generation);
+    record->archetype = archetype_index;
+    record->chunk = chunk_index;
+    record->row = row;
+
+    ve_ecs_chunk* chunk = &archetype->chunks[chunk_index];
+    ((ve_entity*)chunk->data)[row] = entity;
+    for (uint32_t c = 0; c < world->component_count; c++) {
+        if (archetype->column_offsets[c] != ECS_NONE && world->components[c].size > 0) {
+            size_t size = world->components[c].size;
+            memset(chunk_column(archetype, chunk, c) + row * size, 0, size);
+        }
+    }
+
+    world->entity_count++;
+    return entity;
+}
+
+void ve_ecs_destroy_entity(ve_world* world, ve_entity entity) {
+    VE_ASSERT(world);
+
+    ve_entity_record* record = find_record(world, entity);
+    if (!record) {
+        return;
+    }
+
+    remove_row(world, &world->archetypes[record->archetype], record->chunk, record->row);
+
+    /* Generation 0 is skipped so that no handle equals VE_ENTITY_NULL */
+    uint32_t generation = (record->generation + 1) & ENTITY_GENERATION_MASK;
+    record->generation = generation ? generation : 1;
+    record->archetype = ECS_NONE;
+    record->row = world->free_head;
+    world->free_head = entity_index(entity);
+    world->entity_count--;
+}
+
+bool ve_ecs_is_alive(const ve_world* world, ve_entity entity) {
+    VE_ASSERT(world);
+    return find_record(world, entity) != NULL;
+}
+
+void* ve_ecs_add_component(ve_world* world, ve_entity entity, ve_component_id component) {
+    VE_ASSERT(world && component < world->component_count);
+
+    ve_entity_record* record = find_record(world, entity);
+    VE_ASSERT_MSG(record, "Adding a component to a dead entity");
+    if (!record) {
+        return NULL;
+    }
+
+    ve_component_mask mask = world->archetypes[record->archetype].mask;
+    if (!(mask & VE_COMPONENT_BIT(component))) {
+        uint32_t target = get_archetype(world, mask | VE_COMPONENT_BIT(component));
+        if (target == ECS_NONE || !move_entity(world, entity, record, target)) {
+            return NULL;
+        }
+    }
+    return ve_ecs_get_component(world, entity, component);
+}
+
+bool ve_ecs_remove_component(ve_world* world, ve_entity entity, ve_component_id component) {
+    VE_ASSERT(world && component < world->component_count);
+
+    ve_entity_record* record = find_record(world, entity);
+    if (!record) {
+        return false;
+    }
+
+    ve_component_mask mask = world->archetypes[record->archetype].mask;
+    if (!(mask & VE_COMPONENT_BIT(component))) {
+        return false;
+    }
+
+    uint32_t target = get_archetype(world, mask & ~VE_COMPONENT_BIT(component));
+    return target != ECS_NONE && move_entity(world, entity, record, target);
+}
+
+void* ve_ecs_get_component(const ve_world* world, ve_entity entity, ve_component_id component) {
+    VE_ASSERT(world && component < VE_ECS_MAX_COMPONENTS);
+
+    const ve_entity_record* record = find_record(world, entity);
+    if (!record) {
+        return NULL;
+    }
+
+    const ve_archetype* archetype = &world->archetypes[record->archetype];
+    if (archetype->column_offsets[component] == ECS_NONE) {
+        return NULL;
+    }
+    return chunk_column(archetype, &archetype->chunks[record->chunk], component) +
+           (size_t)record->row * world->components[component].size;
+}
+
+void* ve_ecs_write_component(ve_world* world, ve_entity entity, ve_component_id component) {
+    VE_ASSERT(world && component < VE_ECS_MAX_COMPONENTS);
+
+    const ve_entity_record* record = find_record(world, entity);
+    if (!record) {
+        return NULL;
+    }
+
+    ve_archetype* archetype = &world->archetypes[record->archetype];
+    if (archetype->column_offsets[component] == ECS_NONE) {
+        return NULL;
+    }
+    ve_ecs_chunk* chunk = &archetype->chunks[record->chunk];
+    chunk->versions[component] = world->version;
+    return chunk_column(archetype, chunk, component) + (size_t)record->row * world->components[component].size;
+}
+
+bool ve_ecs_has_component(const ve_world* world, ve_entity entity, ve_component_id component) {
+    return (ve_ecs_get_mask(world, entity) & VE_COMPONENT_BIT(component)) != 0;
+}
+
+ve_component_mask ve_ecs_get_mask(const ve_world* world, ve_entity entity) {
+    VE_ASSERT(world);
+    const ve_entity_record* record = find_record(world, entity);
+    return record ? world->archetypes[record->archetype].mask : 0;
+}
+
+uint32_t ve_ecs_get_entity_count(const ve_world* world) {
+    VE_ASSERT(world);
+    return world->entity_count;
+}
+
+uint32_t ve_ecs_get_archetype_count(const ve_world* world) {
+    VE_ASSERT(world);
+    return world->archetype_count;
+}
+
+uint32_t ve_ecs_get_version(const ve_world* world) {
+    VE_ASSERT(world);
+    return world->version;
+}
+
+uint32_t ve_ecs_advance_version(ve_world* world) {
+    VE_ASSERT(world);
+    uint32_t closed = world->version++;
+    return closed;
+}
+
+bool ve_ecs_version_newer(uint32_t version, uint32_t since) {
+    return (int32_t)(version - since) > 0;
+}
+
+static bool archetype_matches(const ve_archetype* archetype, const ve_query* query) {
+    return (archetype->mask & query->all) == query->all && (archetype->mask & query->none) == 0;
+}
+
+static bool chunk_changed(const ve_ecs_chunk* chunk, const ve_query* query) {
+    for (uint32_t c = 0; c < VE_ECS_MAX_COMPONENTS; c++) {
+        if ((query->changed & VE_COMPONENT_BIT(c)) && ve_ecs_version_newer(chunk->versions[c], query->changed_since)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Kind of a recorded command
+ */
+typedef enum ve_ecs_command_type {
+    VE_ECS_COMMAND_CREATE = 0,
+    VE_ECS_COMMAND_DESTROY,
+    VE_ECS_COMMAND_ADD,
+    VE_ECS_COMMAND_REMOVE,
+} ve_ecs_command_type;
+
+/**
+ * @brief Recorded command, followed by size bytes of component value
+ */
+typedef struct ve_ecs_command {
+    ve_component_mask mask;
+    uint32_t type;
+    uint32_t component;
+    ve_entity entity;
+    uint32_t size;
+} ve_ecs_command;
+
+static bool push_command(ve_ecs_commands* commands, const ve_ecs_command* command, const void* value) {
+    size_t bytes = ve_align_size(sizeof(ve_ecs_command) + command->size, sizeof(ve_component_mask));
+    if (commands->size + bytes > commands->capacity) {
+        size_t capacity = commands->capacity ? commands->capacity * 2 : 4096;
+        while (capacity < commands->size + bytes) {
+            capacity *= 2;
+        }
+        uint8_t* data = (uint8_t*)ve_reallocate(commands->data, capacity, VE_MEMORY_TAG_ECS);
+        if (!data) {
+            return false;
+        }
+        commands->data = data;
+        commands->capacity = capacity;
+    }
+
+    uint8_t* destination = commands->data + commands->size;
+    memcpy(destination, command, sizeof(ve_ecs_command));
+    if (command->size > 0) {
+        if (value) {
+            memcpy(destination + sizeof(ve_ecs_command), value, command->size);
+        } else {
+            memset(destination + sizeof(ve_ecs_command), 0, command->size);
+        }
+    }
+    commands->size += bytes;
+    commands->count++;
+    return true;
+}
+
+void ve_ecs_commands_init(ve_ecs_commands* commands) {
+    VE_ASSERT(commands);
+    memset(commands, 0, sizeof(ve_ecs_commands));
+}
+
+void ve_ecs_commands_free(ve_ecs_commands* commands) {
+    if (!commands) {
+        return;
+    }
+    VE_FREE(commands->data);
+    memset(commands, 0, sizeof(ve_ecs_commands));
+}
+
+bool ve_ecs_commands_create_entity(ve_ecs_commands* commands, ve_component_mask components) {
+    VE_ASSERT(commands);
+    ve_ecs_command command = {.mask = components, .type = VE_ECS_COMMAND_CREATE};
+    return push_command(commands, &command, NULL);
+}
+
+bool ve_ecs_commands_destroy_entity(ve_ecs_commands* commands, ve_entity entity) {
+    VE_ASSERT(commands);
+    ve_ecs_command command = {.type = VE_ECS_COMMAND_DESTROY, .entity = entity};
+    return push_command(commands, &command, NULL);
+}
+
+bool ve_ecs_commands_add_component(ve_ecs_commands* commands, ve_entity entity, ve_component_id component,
+                                   const void* value, size_t size) {
+    VE_ASSERT(commands && component < VE_ECS_MAX_COMPONENTS && size <= VE_ECS_MAX_COMPONENT_SIZE);
+    ve_ecs_command command = {
+        .type = VE_ECS_COMMAND_ADD,
+        .component = component,
+        .entity = entity,
+        .size = (uint32_t)size,
+    };
+    return push_command(commands, &command, value);
+}
+
+bool ve_ecs_commands_remove_component(ve_ecs_commands* commands, ve_entity entity, ve_component_id component) {
+    VE_ASSERT(commands && component < VE_ECS_MAX_COMPONENTS);
+    ve_ecs_command command = {.type = VE_ECS_COMMAND_REMOVE, .component = component, .entity = entity};
+    return push_command(commands, &command, NULL);
+}
+
+void ve_ecs_commands_flush(ve_ecs_commands* commands, ve_world* world) {
+    VE_ASSERT(commands && world);
+
+    size_t offset = 0;
+    while (offset < commands->size) {
+        ve_ecs_command command;
+        memcpy(&command, commands->data + offset, sizeof(ve_ecs_command));
+        const uint8_t* value = commands->data + offset + sizeof(ve_ecs_command);
+        offset += ve_align_size(sizeof(ve_ecs_command) + command.size, sizeof(ve_component_mask));
+
+        switch (command.type) {
+            case VE_ECS_COMMAND_CREATE:
+                ve_ecs_create_entity_with(world, command.mask);
+                break;
+            case VE_ECS_COMMAND_DESTROY:
+                ve_ecs_destroy_entity(world, command.entity);
+                break;
+            case VE_ECS_COMMAND_ADD: {
+                if (!ve_ecs_is_alive(world, command.entity)) {
+                    break;
+                }
+                VE_ASSERT_MSG(command.size == 0 || command.size == world->components[command.component].size,
+                              "Component value size mismatch");
+                void* component = ve_ecs_add_component(world, command.entity, command.component);
+                if (component && command.size > 0) {
+                    memcpy(component, value, command.size);
+                }
+                break;
+            }
+            case VE_ECS_COMMAND_REMOVE:
+                ve_ecs_remove_component(world, command.entity, command.component);
+                break;
+            default:
+                VE_ASSERT_MSG(false, "Corrupt ECS command buffer");
+                break;
+        }
+    }
+
+    commands->size = 0;
+    commands->count = 0;
+}
+
+void ve_query_iter_init(ve_query_iter* iter, ve_world* world, const ve_query* query) {
+    VE_ASSERT(iter && world && query);
+    VE_ASSERT_MSG((query->all & query->none) == 0, "Query requires and excludes the same component");
+
+    memset(iter, 0, sizeof(ve_query_iter));
+    iter->world = world;
+    iter->query = *query;
+    iter->write_version = world->version;
+}
+
+bool ve_query_next(ve_query_iter* iter) {
+    VE_ASSERT(iter && iter->world);
+
+    ve_world* world = iter->world;
+    while (iter->archetype < world->archetype_count) {
+        ve_archetype* archetype = &world->archetypes[iter->archetype];
+        bool matches = archetype_matches(archetype, &iter->query);
+
+        /* Chunks are never empty, empty ones are freed */
+        while (matches && iter->chunk < archetype->chunk_count) {
+            ve_ecs_chunk* chunk = &archetype->chunks[iter->chunk++];
+            if (iter->query.changed && !chunk_changed(chunk, &iter->query)) {
+                continue;
+            }
+            iter->count = chunk->count;
+            iter->entities = (const ve_entity*)chunk->data;
+            iter->data = chunk->data;
+            iter->offsets = archetype->column_offsets;
+            iter->versions = chunk->versions;
+            return true;
+        }
+
+        iter->archetype++;
+        iter->chunk = 0;
+    }
+
+    iter->count = 0;
+    iter->entities = NULL;
+    iter->data = NULL;
+    iter->versions = NULL;
+    return false;
+}
+
+void* ve_query_column(const ve_query_iter* iter, ve_component_id component) {
+    VE_ASSERT(iter && iter->data && component < VE_ECS_MAX_COMPONENTS);
+    VE_ASSERT_MSG(iter->offsets[component] != ECS_NONE, "Component not in the current archetype");
+    return iter->data + iter->offsets[component];
+}
+
+void* ve_query_column_write(const ve_query_iter* iter, ve_component_id component) {
+    void* column = ve_query_column(iter, component);
+    iter->versions[component] = iter->write_version;
+    return column;
+}
+
+uint32_t ve_query_count(ve_world* world, const ve_query* query) {
+    VE_ASSERT(world && query);
+
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < world->archetype_count; i++) {
+        const ve_archetype* archetype = &world->archetypes[i];
+        if (!archetype_matches(archetype, query)) {
+            continue;
+        }
+        if (!query->changed) {
+            count += archetype->entity_count;
+            continue;
+        }
+        for (uint32_t c = 0; c < archetype->chunk_count; c++) {
+            if (chunk_changed(&archetype->chunks[c], query)) {
+                count += archetype->chunks[c].count;
+            }
+        }
+    }
+    return count;
+}
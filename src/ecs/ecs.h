@@ -1,11 +1,41 @@
 /**
  * @file ecs.h
  * @brief Entity Component System
+ *
+ * Entities with the same set of components share an archetype. Each
+ * archetype stores its entities in 16 KB chunks laid out as structure of
+ * arrays: the entity handles come first, then one contiguous array per
+ * component, each starting on a cache line. Queries walk the chunks of
+ * every matching archetype, so systems read dense arrays instead of
+ * chasing a pointer per component.
+ *
+ * Adding or removing a component moves the entity to another archetype.
+ * Rows are kept dense by moving the archetype's last entity into the hole
+ * left behind, so component pointers are only valid until the next
+ * structural change (create, destroy, add or remove). Structural changes
+ * must not happen while a query is being iterated.
+ *
+ * Entity handles are generational: destroying an entity bumps the
+ * generation of its slot, so stale handles are detected instead of
+ * aliasing whatever reuses the slot.
+ *
+ * Every chunk keeps a change version per component. Writes through
+ * ve_query_column_write and ve_ecs_write_component, and structural changes
+ * that move rows into a chunk, stamp it with the world's current version.
+ * A query with a changed mask skips chunks none of whose listed components
+ * changed after changed_since, so incremental consumers only touch what
+ * moved: keep the value ve_ecs_advance_version returned last time and
+ * pass it as changed_since. Tracking is per chunk, so a hit means at least
+ * one of the chunk's entities changed.
+ *
+ * A world is not thread-safe; concurrent readers are fine as long as
+ * nothing changes its structure.
  */
 
 #ifndef VE_ECS_H
 #define VE_ECS_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -13,7 +43,377 @@
 extern "C" {
 #endif
 
-/* TODO: Implement ECS */
+/* Bytes per chunk of an archetype */
+#define VE_ECS_CHUNK_SIZE (16 * 1024)
+
+/* Component types per world, one bit each in ve_component_mask */
+#define VE_ECS_MAX_COMPONENTS 64
+
+/* Largest component, so that every archetype fits several rows per chunk */
+#define VE_ECS_MAX_COMPONENT_SIZE 1024
+
+/* Entity handle layout: slot index in the low bits, generation above */
+#define VE_ENTITY_INDEX_BITS 22
+#define VE_ENTITY_GENERATION_BITS 10
+#define VE_ECS_MAX_ENTITIES (1u << VE_ENTITY_INDEX_BITS)
+
+/* Never a live entity */
+#define VE_ENTITY_NULL 0u
+
+/* Returned by ve_ecs_register_component on failure */
+#define VE_INVALID_COMPONENT UINT32_MAX
+
+#define VE_COMPONENT_BIT(id) ((ve_component_mask)1 << (id))
+
+typedef uint32_t ve_entity;
+typedef uint32_t ve_component_id;
+typedef uint64_t ve_component_mask;
+
+/**
+ * @brief Set of entities and their components
+ */
+typedef struct ve_world ve_world;
+
+/**
+ * @brief Component filter
+ */
+typedef struct ve_query {
+    ve_component_mask all;      /* Components an entity must have */
+    ve_component_mask none;     /* Components an entity must not have */
+    ve_component_mask changed;  /* If set, only chunks where one of these changed */
+    uint32_t changed_since;     /* Version the changes must be newer than */
+} ve_query;
+
+/**
+ * @brief Chunk-by-chunk iteration over the entities matching a query
+ *
+ * After ve_query_next returns true, count entities are available in
+ * entities and in the arrays returned by ve_query_column.
+ */
+typedef struct ve_query_iter {
+    ve_world* world;
+    ve_query query;
+    uint32_t archetype;             /* Next archetype to visit */
+    uint32_t chunk;                 /* Next chunk of that archetype */
+    uint32_t count;                 /* Entities in the current chunk */
+    const ve_entity* entities;      /* Handles of the current chunk */
+    uint8_t* data;                  /* Current chunk */
+    const uint32_t* offsets;        /* Column offsets of the current archetype */
+    uint32_t* versions;             /* Change versions of the current chunk */
+    uint32_t write_version;         /* Stamped by ve_query_column_write */
+} ve_query_iter;
+
+/**
+ * @brief Recorded structural changes, applied later with ve_ecs_commands_flush
+ *
+ * Lets code that iterates a query, or runs on a worker thread, create and
+ * destroy entities and add or remove components without touching the
+ * world. One buffer must only be recorded to by one thread at a time.
+ */
+typedef struct ve_ecs_commands {
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+    uint32_t count;
+} ve_ecs_commands;
+
+/**
+ * @brief Create an empty world
+ *
+ * @return World, or NULL if out of memory
+ */
+ve_world* ve_world_create(void);
+
+/**
+ * @brief Destroy a world and everything in it
+ *
+ * @param world World
+ */
+void ve_world_destroy(ve_world* world);
+
+/**
+ * @brief Register a component type
+ *
+ * Components are plain data: they are copied with memcpy when entities
+ * move between archetypes and start zeroed. A size of 0 makes a tag.
+ *
+ * @param world World
+ * @param name Name for debugging, must outlive the world
+ * @param size Component size in bytes, at most VE_ECS_MAX_COMPONENT_SIZE
+ * @param alignment Component alignment, a power of two
+ * @return Component ID, or VE_INVALID_COMPONENT if the world has VE_ECS_MAX_COMPONENTS
+ */
+ve_component_id ve_ecs_register_component(ve_world* world, const char* name, size_t size, size_t alignment);
+
+/**
+ * @brief Get the size of a component type
+ *
+ * @param world World
+ * @param component Component ID
+ * @return Size in bytes
+ */
+size_t ve_ecs_get_component_size(const ve_world* world, ve_component_id component);
+
+/**
+ * @brief Create an entity without components
+ *
+ * @param world World
+ * @return Entity, or VE_ENTITY_NULL if out of memory or entity slots
+ */
+ve_entity ve_ecs_create_entity(ve_world* world);
+
+/**
+ * @brief Create an entity straight into the archetype of a component set
+ *
+ * Avoids moving the entity once per added component. The components start
+ * zeroed.
+ *
+ * @param world World
+ * @param components Components of the entity
+ * @return Entity, or VE_ENTITY_NULL if out of memory or entity slots
+ */
+ve_entity ve_ecs_create_entity_with(ve_world* world, ve_component_mask components);
+
+/**
+ * @brief Destroy an entity
+ *
+ * Stale handles are ignored.
+ *
+ * @param world World
+ * @param entity Entity
+ */
+void ve_ecs_destroy_entity(ve_world* world, ve_entity entity);
+
+/**
+ * @brief Check if a handle refers to a live entity
+ *
+ * @param world World
+ * @param entity Entity
+ * @return true if alive
+ */
+bool ve_ecs_is_alive(const ve_world* world, ve_entity entity);
+
+/**
+ * @brief Add a component to an entity
+ *
+ * Returns the existing component if the entity already has it.
+ *
+ * @param world World
+ * @param entity Live entity
+ * @param component Component ID
+ * @return Zeroed component, or NULL if out of memory
+ */
+void* ve_ecs_add_component(ve_world* world, ve_entity entity, ve_component_id component);
+
+/**
+ * @brief Remove a component from an entity
+ *
+ * @param world World
+ * @param entity Live entity
+ * @param component Component ID
+ * @return true if removed, false if the entity did not have it or out of memory
+ */
+bool ve_ecs_remove_component(ve_world* world, ve_entity entity, ve_component_id component);
+
+/**
+ * @brief Get a component of an entity
+ *
+ * @param world World
+ * @param entity Entity
+ * @param component Component ID
+ * @return Component, or NULL if the entity is dead or does not have it
+ */
+void* ve_ecs_get_component(const ve_world* world, ve_entity entity, ve_component_id component);
+
+/**
+ * @brief Get a component of an entity for writing
+ *
+ * As ve_ecs_get_component, and marks the component of the entity's chunk
+ * changed.
+ *
+ * @param world World
+ * @param entity Entity
+ * @param component Component ID
+ * @return Component, or NULL if the entity is dead or does not have it
+ */
+void* ve_ecs_write_component(ve_world* world, ve_entity entity, ve_component_id component);
+
+/**
+ * @brief Check if an entity has a component
+ *
+ * @param world World
+ * @param entity Entity
+ * @param component Component ID
+ * @return true if the entity is alive and has the component
+ */
+bool ve_ecs_has_component(const ve_world* world, ve_entity entity, ve_component_id component);
+
+/**
+ * @brief Get the components of an entity
+ *
+ * @param world World
+ * @param entity Entity
+ * @return Component mask, 0 for dead entities
+ */
+ve_component_mask ve_ecs_get_mask(const ve_world* world, ve_entity entity);
+
+/**
+ * @brief Get the number of live entities
+ *
+ * @param world World
+ * @return Entity count
+ */
+uint32_t ve_ecs_get_entity_count(const ve_world* world);
+
+/**
+ * @brief Get the number of archetypes created so far
+ *
+ * @param world World
+ * @return Archetype count, including the empty archetype
+ */
+uint32_t ve_ecs_get_archetype_count(const ve_world* world);
+
+/**
+ * @brief Get the version changes are stamped with now
+ *
+ * @param world World
+ * @return Current version
+ */
+uint32_t ve_ecs_get_version(const ve_world* world);
+
+/**
+ * @brief Close the current version
+ *
+ * Changes made from now on are newer than the returned version.
+ *
+ * @param world World
+ * @return The version just closed, to pass as changed_since next time
+ */
+uint32_t ve_ecs_advance_version(ve_world* world);
+
+/**
+ * @brief Check if a version is newer than another, allowing for wrap-around
+ *
+ * @param version Version to test
+ * @param since Reference version
+ * @return true if version is after since
+ */
+bool ve_ecs_version_newer(uint32_t version, uint32_t since);
+
+/**
+ * @brief Initialize an empty command buffer
+ *
+ * @param commands Command buffer
+ */
+void ve_ecs_commands_init(ve_ecs_commands* commands);
+
+/**
+ * @brief Free the memory of a command buffer
+ *
+ * @param commands Command buffer, empty on return
+ */
+void ve_ecs_commands_free(ve_ecs_commands* commands);
+
+/**
+ * @brief Record the creation of an entity
+ *
+ * @param commands Command buffer
+ * @param components Components of the entity, zeroed
+ * @return false if out of memory
+ */
+bool ve_ecs_commands_create_entity(ve_ecs_commands* commands, ve_component_mask components);
+
+/**
+ * @brief Record the destruction of an entity
+ *
+ * @param commands Command buffer
+ * @param entity Entity
+ * @return false if out of memory
+ */
+bool ve_ecs_commands_destroy_entity(ve_ecs_commands* commands, ve_entity entity);
+
+/**
+ * @brief Record adding a component to an entity
+ *
+ * @param commands Command buffer
+ * @param entity Entity
+ * @param component Component ID
+ * @param value Initial value, copied now (NULL for zero)
+ * @param size Size of value, the component's size
+ * @return false if out of memory
+ */
+bool ve_ecs_commands_add_component(ve_ecs_commands* commands, ve_entity entity, ve_component_id component,
+                                   const void* value, size_t size);
+
+/**
+ * @brief Record removing a component from an entity
+ *
+ * @param commands Command buffer
+ * @param entity Entity
+ * @param component Component ID
+ * @return false if out of memory
+ */
+bool ve_ecs_commands_remove_component(ve_ecs_commands* commands, ve_entity entity, ve_component_id component);
+
+/**
+ * @brief Apply recorded commands in order and clear the buffer
+ *
+ * Commands on entities that died in the meantime are skipped.
+ *
+ * @param commands Command buffer
+ * @param world World, not being iterated
+ */
+void ve_ecs_commands_flush(ve_ecs_commands* commands, ve_world* world);
+
+/**
+ * @brief Start iterating a query
+ *
+ * @param iter Iterator to initialize
+ * @param world World
+ * @param query Filter, copied
+ */
+void ve_query_iter_init(ve_query_iter* iter, ve_world* world, const ve_query* query);
+
+/**
+ * @brief Advance to the next non-empty chunk
+ *
+ * @param iter Iterator
+ * @return false when every matching chunk has been visited
+ */
+bool ve_query_next(ve_query_iter* iter);
+
+/**
+ * @brief Get a component array of the current chunk
+ *
+ * The array is cache-line aligned and holds iter->count components.
+ *
+ * @param iter Iterator positioned by ve_query_next
+ * @param component Component in the query's all mask
+ * @return Component array
+ */
+void* ve_query_column(const ve_query_iter* iter, ve_component_id component);
+
+/**
+ * @brief Get a component array of the current chunk for writing
+ *
+ * As ve_query_column, and marks the component of the chunk changed.
+ *
+ * @param iter Iterator positioned by ve_query_next
+ * @param component Component in the query's all mask
+ * @return Component array
+ */
+void* ve_query_column_write(const ve_query_iter* iter, ve_component_id component);
+
+/**
+ * @brief Count the entities matching a query
+ *
+ * With a changed mask, counts every entity of the matching chunks.
+ *
+ * @param world World
+ * @param query Filter
+ * @return Entity count
+ */
+uint32_t ve_query_count(ve_world* world, const ve_query* query);
 
 #ifdef __cplusplus
 }
@@ -4,5 +4,254 @@
  */
 
 #include "systems.h"
+#include "../core/memory.h"
+#include "../core/logger.h"
+#include "../core/assert.h"
 
-/* TODO: Implement built-in systems */
+#include <string.h>
+
+/**
+ * @brief Registered system and its per-run state
+ */
+typedef struct ve_system_node {
+    ve_system_desc desc;
+    uint64_t dependencies;          /* Earlier systems it conflicts with */
+    uint64_t dependents;            /* Later systems that conflict with it */
+    ve_atomic_int32 remaining;      /* Dependencies not finished this run */
+    uint32_t version;               /* Stamped on written components this run */
+    uint32_t last_version;          /* Version of the previous run, 0 before the first */
+    ve_query_iter* chunks;          /* Matching chunks, gathered once its dependencies have finished */
+    uint32_t chunk_count;
+    uint32_t chunk_capacity;
+    struct ve_system_scheduler* scheduler;
+} ve_system_node;
+
+struct ve_system_scheduler {
+    ve_world* world;
+    ve_thread_pool* pool;
+    ve_system_node systems[VE_ECS_MAX_SYSTEMS];
+    uint32_t system_count;
+    ve_ecs_commands* commands;      /* One per worker, then one for threads outside the pool */
+    uint32_t command_count;
+    ve_task_group group;
+    float delta_time;
+};
+
+/* Changed components are read when gathering chunks, so they count as reads */
+static bool systems_conflict(const ve_system_desc* a, const ve_system_desc* b) {
+    ve_component_mask a_reads = a->reads | a->changed;
+    ve_component_mask b_reads = b->reads | b->changed;
+    return (a->writes & (b_reads | b->writes)) != 0 || (b->writes & a_reads) != 0;
+}
+
+/**
+ * @brief Snapshot the chunks a system visits this run
+ *
+ * Taken once every system it waits for has finished, so changes those
+ * systems made this run pass its changed filter. Structure does not change
+ * while systems run, so the snapshots stay valid.
+ *
+ * @return false if out of memory
+ */
+static bool gather_chunks(ve_system_scheduler* scheduler, ve_system_node* node) {
+    ve_query query = {
+        .all = node->desc.reads | node->desc.writes,
+        .none = node->desc.exclude,
+        .changed = node->desc.changed,
+        .changed_since = node->last_version,
+    };
+
+    node->chunk_count = 0;
+    ve_query_iter iter;
+    ve_query_iter_init(&iter, scheduler->world, &query);
+    while (ve_query_next(&iter)) {
+        if (node->chunk_count == node->chunk_capacity) {
+            uint32_t capacity = node->chunk_capacity ? node->chunk_capacity * 2 : 64;
+            ve_query_iter* chunks = (ve_query_iter*)ve_reallocate(node->chunks, capacity * sizeof(ve_query_iter),
+                                                                  VE_MEMORY_TAG_ECS);
+            if (!chunks) {
+                return false;
+            }
+            node->chunks = chunks;
+            node->chunk_capacity = capacity;
+        }
+        iter.write_version = node->version;
+        node->chunks[node->chunk_count++] = iter;
+    }
+    return true;
+}
+
+static void run_chunks(uint32_t begin, uint32_t end, void* user_data) {
+    ve_system_node* node = (ve_system_node*)user_data;
+    ve_system_scheduler* scheduler = node->scheduler;
+
+    ve_system_context context = {
+        .world = scheduler->world,
+        .commands = &scheduler->commands[ve_thread_pool_get_worker_index(scheduler->pool)],
+        .delta_time = scheduler->delta_time,
+        .user_data = node->desc.user_data,
+    };
+    for (uint32_t i = begin; i < end; i++) {
+        const ve_query_iter* chunk = &node->chunks[i];
+        for (uint32_t c = 0; c < VE_ECS_MAX_COMPONENTS; c++) {
+            if (node->desc.writes & VE_COMPONENT_BIT(c)) {
+                chunk->versions[c] = node->version;
+            }
+        }
+        context.chunk = chunk;
+        node->desc.fn(&context);
+    }
+}
+
+/**
+ * @brief Gather a system's chunks and visit them
+ */
+static void run_system(ve_system_scheduler* scheduler, ve_system_node* node) {
+    if (!gather_chunks(scheduler, node)) {
+        VE_LOG_ERROR("Out of memory gathering chunks of system '%s'", node->desc.name ? node->desc.name : "?");
+        node->chunk_count = 0;
+    }
+
+    if (node->desc.serial) {
+        run_chunks(0, node->chunk_count, node);
+    } else {
+        ve_parallel_for(scheduler->pool, 0, node->chunk_count, 1, run_chunks, node);
+    }
+}
+
+static void system_task(void* user_data);
+
+/**
+ * @brief Start a system whose dependencies have finished
+ */
+static void launch_system(ve_system_scheduler* scheduler, ve_system_node* node) {
+    /* A full job ring is no reason to stall the graph; run it here instead */
+    if (!ve_task_group_run(&scheduler->group, system_task, node)) {
+        system_task(node);
+    }
+}
+
+static void system_task(void* user_data) {
+    ve_system_node* node = (ve_system_node*)user_data;
+    ve_system_scheduler* scheduler = node->scheduler;
+
+    run_system(scheduler, node);
+
+    uint32_t index = (uint32_t)(node - scheduler->systems);
+    for (uint32_t i = index + 1; i < scheduler->system_count; i++) {
+        if ((node->dependents >> i) & 1) {
+            ve_system_node* dependent = &scheduler->systems[i];
+            if (ve_atomic_decrement32(&dependent->remaining) == 0) {
+                launch_system(scheduler, dependent);
+            }
+        }
+    }
+}
+
+ve_system_scheduler* ve_scheduler_create(ve_world* world, ve_thread_pool* pool) {
+    VE_ASSERT(world);
+
+    ve_system_scheduler* scheduler = (ve_system_scheduler*)ve_allocate_cleared(1, sizeof(ve_system_scheduler),
+                                                                               VE_MEMORY_TAG_ECS);
+    if (!scheduler) {
+        return NULL;
+    }
+
+    scheduler->world = world;
+    scheduler->pool = pool;
+    scheduler->command_count = ve_thread_pool_get_thread_count(pool) + 1;
+    scheduler->commands = (ve_ecs_commands*)ve_allocate_cleared(scheduler->command_count, sizeof(ve_ecs_commands),
+                                                                VE_MEMORY_TAG_ECS);
+    if (!scheduler->commands) {
+        VE_FREE(scheduler);
+        return NULL;
+    }
+    return scheduler;
+}
+
+void ve_scheduler_destroy(ve_system_scheduler* scheduler) {
+    if (!scheduler) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < scheduler->system_count; i++) {
+        VE_FREE(scheduler->systems[i].chunks);
+    }
+    for (uint32_t i = 0; i < scheduler->command_count; i++) {
+        ve_ecs_commands_free(&scheduler->commands[i]);
+    }
+    VE_FREE(scheduler->commands);
+    VE_FREE(scheduler);
+}
+
+uint32_t ve_scheduler_add_system(ve_system_scheduler* scheduler, const ve_system_desc* desc) {
+    VE_ASSERT(scheduler && desc && desc->fn);
+
+    if (scheduler->system_count == VE_ECS_MAX_SYSTEMS) {
+        VE_LOG_ERROR("Too many systems, cannot add '%s'", desc->name ? desc->name : "unnamed");
+        return VE_INVALID_SYSTEM;
+    }
+
+    uint32_t index = scheduler->system_count++;
+    ve_system_node* node = &scheduler->systems[index];
+    memset(node, 0, sizeof(ve_system_node));
+    node->desc = *desc;
+    node->scheduler = scheduler;
+
+    /* Declarations are fixed, so the graph edges are worked out once */
+    for (uint32_t i = 0; i < index; i++) {
+        if (systems_conflict(&scheduler->systems[i].desc, desc)) {
+            node->dependencies |= (uint64_t)1 << i;
+            scheduler->systems[i].dependents |= (uint64_t)1 << index;
+        }
+    }
+    return index;
+}
+
+uint64_t ve_scheduler_get_dependencies(const ve_system_scheduler* scheduler, uint32_t system) {
+    VE_ASSERT(scheduler && system < scheduler->system_count);
+    return scheduler->systems[system].dependencies;
+}
+
+void ve_scheduler_run(ve_system_scheduler* scheduler, float delta_time) {
+    VE_ASSERT(scheduler);
+    VE_ASSERT_MSG(ve_thread_pool_get_worker_index(scheduler->pool) == ve_thread_pool_get_thread_count(scheduler->pool),
+                  "ve_scheduler_run called from a pool worker");
+
+    scheduler->delta_time = delta_time;
+    for (uint32_t i = 0; i < scheduler->system_count; i++) {
+        ve_system_node* node = &scheduler->systems[i];
+        node->version = ve_ecs_advance_version(scheduler->world) + 1;
+
+        int32_t remaining = 0;
+        for (uint32_t d = 0; d < i; d++) {
+            remaining += (int32_t)((node->dependencies >> d) & 1);
+        }
+        ve_atomic_store32(&node->remaining, remaining);
+    }
+
+    if (ve_thread_pool_get_thread_count(scheduler->pool) == 0) {
+        /* Registration order already respects every dependency */
+        for (uint32_t i = 0; i < scheduler->system_count; i++) {
+            run_system(scheduler, &scheduler->systems[i]);
+        }
+    } else {
+        ve_task_group_init(&scheduler->group, scheduler->pool);
+        for (uint32_t i = 0; i < scheduler->system_count; i++) {
+            if (scheduler->systems[i].dependencies == 0) {
+                launch_system(scheduler, &scheduler->systems[i]);
+            }
+        }
+        ve_task_group_wait(&scheduler->group);
+    }
+
+    for (uint32_t i = 0; i < scheduler->system_count; i++) {
+        scheduler->systems[i].last_version = scheduler->systems[i].version;
+    }
+
+    /* Deferred changes are newer than every system of this run */
+    ve_ecs_advance_version(scheduler->world);
+    for (uint32_t i = 0; i < scheduler->command_count; i++) {
+        ve_ecs_commands_flush(&scheduler->commands[i], scheduler->world);
+    }
+}
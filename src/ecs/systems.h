@@ -1,18 +1,131 @@
 /**
  * @file systems.h
  * @brief Built-in ECS systems
+ *
+ * Systems declare the components they read and write. The scheduler
+ * orders them into a dependency graph: a system waits for every earlier
+ * system that writes what it touches, or touches what it writes, and
+ * systems without such conflicts run concurrently on the thread pool.
+ * Each system's chunks are also split across workers, so one heavy system
+ * does not serialize the frame.
+ *
+ * A system that lists components in changed only visits chunks where one
+ * of them changed since its previous run, which is what incremental work
+ * such as transform propagation and instance uploads wants. Each system
+ * run gets its own world version, and the chunks it visits are stamped
+ * with it for every component it writes, so a system never sees its own
+ * writes as changes but does see those of every other system: writes of
+ * systems it waits for in the same run, the rest by its next run. Listing
+ * a component in changed orders the system after earlier writers of it,
+ * as reading it would.
+ *
+ * System functions run once per chunk and must not change the world's
+ * structure; they record structural changes in the calling thread's
+ * command buffer, and the scheduler applies every buffer after the last
+ * system has finished, in worker order.
  */
 
 #ifndef VE_SYSTEMS_H
 #define VE_SYSTEMS_H
 
+#include "ecs.h"
+#include "../core/thread.h"
 #include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* TODO: Implement built-in systems */
+/* Systems per scheduler, one bit each in a dependency mask */
+#define VE_ECS_MAX_SYSTEMS 64
+
+/* Returned by ve_scheduler_add_system on failure */
+#define VE_INVALID_SYSTEM UINT32_MAX
+
+/**
+ * @brief Arguments of one system invocation
+ */
+typedef struct ve_system_context {
+    ve_world* world;
+    const ve_query_iter* chunk;     /* Read columns with ve_query_column */
+    ve_ecs_commands* commands;      /* Calling thread's deferred structural changes */
+    float delta_time;
+    void* user_data;
+} ve_system_context;
+
+/**
+ * @brief System function, called once per matching chunk
+ */
+typedef void (*ve_system_fn)(const ve_system_context* context);
+
+/**
+ * @brief System registration
+ *
+ * The system visits entities that have every component in reads and
+ * writes and none in exclude.
+ */
+typedef struct ve_system_desc {
+    const char* name;
+    ve_system_fn fn;
+    void* user_data;
+    ve_component_mask reads;
+    ve_component_mask writes;
+    ve_component_mask exclude;
+    ve_component_mask changed;      /* If set, only chunks where one of these changed since the last run */
+    bool serial;                    /* Visit the chunks one after another on one thread */
+} ve_system_desc;
+
+/**
+ * @brief System scheduler handle
+ */
+typedef struct ve_system_scheduler ve_system_scheduler;
+
+/**
+ * @brief Create a scheduler for a world
+ *
+ * @param world World the systems run on
+ * @param pool Thread pool (NULL runs everything on the calling thread)
+ * @return Scheduler, or NULL if out of memory
+ */
+ve_system_scheduler* ve_scheduler_create(ve_world* world, ve_thread_pool* pool);
+
+/**
+ * @brief Destroy a scheduler
+ *
+ * @param scheduler Scheduler
+ */
+void ve_scheduler_destroy(ve_system_scheduler* scheduler);
+
+/**
+ * @brief Register a system
+ *
+ * Registration order is the order conflicting systems run in.
+ *
+ * @param scheduler Scheduler
+ * @param desc System description, copied
+ * @return System index, or VE_INVALID_SYSTEM if the scheduler is full
+ */
+uint32_t ve_scheduler_add_system(ve_system_scheduler* scheduler, const ve_system_desc* desc);
+
+/**
+ * @brief Get the systems a system waits for
+ *
+ * @param scheduler Scheduler
+ * @param system System index
+ * @return One bit per earlier system it conflicts with
+ */
+uint64_t ve_scheduler_get_dependencies(const ve_system_scheduler* scheduler, uint32_t system);
+
+/**
+ * @brief Run every system once and apply their deferred commands
+ *
+ * Returns when all systems have finished. Must be called from a thread
+ * outside the pool.
+ *
+ * @param scheduler Scheduler
+ * @param delta_time Frame time passed to the systems
+ */
+void ve_scheduler_run(ve_system_scheduler* scheduler, float delta_time);
 
 #ifdef __cplusplus
 }
@@ -6,16 +6,42 @@
 #include "core/logger.h"
 #include "core/memory.h"
 #include "core/timer.h"
+#include "core/profiler.h"
+#include "core/latency.h"
+#include "core/thread.h"
+#include "core/frame_pipeline.h"
+#include "core/benchmark.h"
+#include "core/telemetry.h"
+#include "core/init_graph.h"
 #include "platform/platform.h"
+#include "math/simd.h"
 #include "renderer/vulkan_core.h"
 #include "renderer/swapchain.h"
 #include "renderer/sync.h"
 #include "renderer/command_buffer.h"
 #include "renderer/render_pass.h"
+#include "renderer/gpu_profiler.h"
+#include "renderer/gpu_stats.h"
+#include "renderer/submit.h"
+#include "renderer/deletion_queue.h"
+#include "renderer/gpu_memory.h"
+#include "renderer/upload.h"
+#include "renderer/descriptor.h"
+#include "renderer/pipeline.h"
+#include "renderer/light_culling.h"
+#include "renderer/gpu_culling.h"
+#include "renderer/hiz.h"
+#include "renderer/texture_streaming.h"
+#include "renderer/instancing.h"
+#include "renderer/offscreen.h"
+#include "assets/asset_manager.h"
+#include "assets/pak.h"
+#include "scene/camera_path.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include <GLFW/glfw3.h>
 
@@ -28,6 +54,50 @@ static struct {
     bool framebuffer_resized;
 } g_window = {0};
 
+/* Worker threads for background engine jobs */
+static ve_thread_pool* g_job_pool = NULL;
+
+/* Record and submit on a render thread while the main thread simulates the next frame */
+static bool g_render_thread = true;
+
+/* No window: render into offscreen targets and read the frames back */
+static bool g_headless = false;
+
+/* Frames to run before exiting, 0 to run until the window closes */
+static uint64_t g_frame_limit = 0;
+
+/* Headless runs have no window to close */
+#define HEADLESS_DEFAULT_FRAMES 600
+#define HEADLESS_WIDTH 1280
+#define HEADLESS_HEIGHT 720
+
+/* Benchmark mode: fly a recorded camera path through a scene at a fixed timestep, without vsync */
+static struct {
+    bool enabled;
+    const char* scene;
+    const char* path_file;
+    const char* report;
+    ve_pak* pak;
+    ve_camera_path path;
+} g_benchmark = {0};
+
+/* Frames drawn from the first key before recording, while caches and streaming settle */
+#define BENCHMARK_WARMUP_FRAMES 60
+#define BENCHMARK_DEFAULT_REPORT "benchmark.json"
+
+/* Runtime metrics, served on 127.0.0.1 when --telemetry-port is given */
+static ve_telemetry_config g_telemetry_config = {0};
+
+/* Render snapshot data: what the render side needs from the main thread */
+typedef struct frame_snapshot {
+    uint32_t framebuffer_width;     /* 0 while minimized */
+    uint32_t framebuffer_height;
+    bool framebuffer_resized;
+    ve_vec3 camera_eye;             /* Benchmark camera */
+    ve_vec3 camera_target;
+    ve_frame_time frame_time;       /* For telemetry */
+} frame_snapshot;
+
 /* Forward declarations */
 static void glfw_framebuffer_resize_callback(GLFWwindow* window, int width, int height);
 static void glfw_key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
@@ -35,6 +105,9 @@ static void glfw_cursor_position_callback(GLFWwindow* window, double xpos, doubl
 static void glfw_mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 static void glfw_scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 static void glfw_error_callback(int error, const char* description);
+static void prepare_frame(const ve_render_snapshot* snapshot, void* user_data);
+static void render_frame(const ve_render_snapshot* snapshot, void* user_data);
+static void sample_renderer_telemetry(void* user_data);
 
 /* Initialize window */
 static bool init_window(uint32_t width, uint32_t height, const char* title) {
@@ -79,53 +152,50 @@ static void shutdown_window(void) {
     glfwTerminate();
 }
 
-/* Initialize engine */
-static bool init_engine(void) {
-    /* Initialize core systems */
-    if (!ve_memory_init()) {
-        fprintf(stderr, "Failed to initialize memory system\n");
-        return false;
-    }
+/* Results startup tasks hand to later ones */
+typedef struct engine_init {
+    VkExtent2D extent;
+    VkFormat color_format;
+} engine_init;
 
-    ve_logger_config logger_config = {
-        .level = VE_LOG_TRACE,
-        .targets = VE_LOG_TARGET_CONSOLE | VE_LOG_TARGET_DEBUGGER,
-        .color_output = true,
-        .timestamps = true,
-        .thread_ids = false,
-    };
-
-    if (!ve_logger_init(&logger_config)) {
-        fprintf(stderr, "Failed to initialize logger\n");
-        return false;
-    }
+static bool init_window_task(void* user_data) {
+    (void)user_data;
+    return init_window(1280, 720, "Vulkan Engine");
+}
 
-    if (!ve_timer_init()) {
-        VE_LOG_ERROR("Failed to initialize timer system");
-        return false;
-    }
+/* Loader and instance enumeration need no window, so they overlap its creation */
+static bool init_vulkan_loader_task(void* user_data) {
+    (void)user_data;
+    return ve_vulkan_preload();
+}
 
-    if (!ve_platform_init()) {
-        VE_LOG_ERROR("Failed to initialize platform layer");
-        return false;
-    }
+static bool init_vulkan_task(void* user_data) {
+    (void)user_data;
 
-    /* Initialize Vulkan */
     bool enable_validation = true;
 #ifdef NDEBUG
     enable_validation = false;
 #endif
 
-    if (!ve_vulkan_init("Vulkan Engine", VK_MAKE_VERSION(0, 1, 0), enable_validation)) {
+    uint32_t version = VK_MAKE_VERSION(0, 1, 0);
+    bool vulkan_ready = g_headless ? ve_vulkan_init_headless("Vulkan Engine", version, enable_validation)
+                                   : ve_vulkan_init("Vulkan Engine", version, enable_validation);
+    if (!vulkan_ready) {
         VE_LOG_ERROR("Failed to initialize Vulkan");
         return false;
     }
 
     /* Create surface */
-    if (ve_vulkan_create_surface(g_window.window) != VK_SUCCESS) {
+    if (!g_headless && ve_vulkan_create_surface(g_window.window) != VK_SUCCESS) {
         VE_LOG_ERROR("Failed to create Vulkan surface");
         return false;
     }
+    return true;
+}
+
+/* Device-level objects the rest of the renderer builds on; quick, and each needs the one before */
+static bool init_device_objects_task(void* user_data) {
+    (void)user_data;
 
     /* Initialize sync primitives */
     if (ve_sync_init() != VK_SUCCESS) {
@@ -133,20 +203,172 @@ static bool init_engine(void) {
         return false;
     }
 
+    /* Device memory blocks shared by buffers and images */
+    if (!ve_gpu_memory_init()) {
+        VE_LOG_ERROR("Failed to initialize GPU memory allocator");
+        return false;
+    }
+
+    /* Resources retired while frames are in flight */
+    if (!ve_deletion_queue_init()) {
+        VE_LOG_ERROR("Failed to initialize deletion queue");
+        return false;
+    }
+
     /* Initialize command buffers */
     if (ve_command_buffer_init() != VK_SUCCESS) {
         VE_LOG_ERROR("Failed to initialize command buffers");
         return false;
     }
 
-    /* Create swapchain */
+    /* GPU timestamps, recorded at debug label boundaries */
+    if (ve_gpu_profiler_init() != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to initialize GPU profiler");
+        return false;
+    }
+
+    /* Per-pass pipeline statistics and occlusion counts */
+    if (ve_gpu_stats_init() != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to initialize GPU statistics");
+        return false;
+    }
+
+    /* Batched submission on per-queue timelines; without them submits go one by one */
+    VkResult submit_result = ve_submit_init();
+    if (submit_result != VK_SUCCESS && submit_result != VK_ERROR_FEATURE_NOT_PRESENT) {
+        VE_LOG_ERROR("Failed to initialize submission batcher");
+        return false;
+    }
+
+    /* Staging ring for streaming through the transfer queue */
+    VkResult upload_result = ve_upload_init(0);
+    if (upload_result != VK_SUCCESS && upload_result != VK_ERROR_FEATURE_NOT_PRESENT) {
+        VE_LOG_ERROR("Failed to initialize upload ring");
+        return false;
+    }
+
+    /* Global descriptor heap for bindless materials */
+    VkResult bindless_result = ve_bindless_init();
+    if (bindless_result != VK_SUCCESS && bindless_result != VK_ERROR_FEATURE_NOT_PRESENT) {
+        VE_LOG_ERROR("Failed to initialize bindless descriptors");
+        return false;
+    }
+
+    /* Layout cache and descriptor pools for non-bindless sets */
+    if (ve_descriptor_init() != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to initialize descriptor allocators");
+        return false;
+    }
+    return true;
+}
+
+/* Pipelines compile on the job pool through the on-disk cache, read here */
+static bool init_pipeline_cache_task(void* user_data) {
+    (void)user_data;
+    if (ve_pipeline_init(NULL, g_job_pool) != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to initialize pipeline cache");
+        return false;
+    }
+    return true;
+}
+
+static bool init_asset_manager_task(void* user_data) {
+    (void)user_data;
+
+    /* Assets stream in on the job pool and become ready on the transfer timeline */
+    ve_asset_manager_config asset_config = {
+        .pool = g_job_pool,
+        .is_fence_complete = ve_upload_is_enabled() ? ve_upload_is_complete : NULL,
+    };
+    if (!ve_asset_manager_init(&asset_config)) {
+        VE_LOG_ERROR("Failed to initialize asset manager");
+        return false;
+    }
+    return true;
+}
+
+static bool init_streaming_task(void* user_data) {
+    (void)user_data;
+
+    /* Texture mips follow on-screen size within a memory budget */
+    VkResult streaming_result = ve_texture_streaming_init(NULL);
+    if (streaming_result != VK_SUCCESS && streaming_result != VK_ERROR_FEATURE_NOT_PRESENT) {
+        VE_LOG_WARN("Texture streaming unavailable");
+    }
+
+    /* Instance transforms and materials stay on the GPU and are uploaded as they change */
+    VkResult instancing_result = ve_instancing_init(0);
+    if (instancing_result != VK_SUCCESS && instancing_result != VK_ERROR_FEATURE_NOT_PRESENT) {
+        VE_LOG_WARN("Instancing unavailable");
+    }
+    return true;
+}
+
+/* The compute passes below each read their shader module from disk; pipelines then compile in the background */
+static bool init_light_culling_task(void* user_data) {
+    (void)user_data;
+
+    /* Clustered point light lists for the lighting pass */
+    VkResult light_result = ve_light_culling_init("shaders/light_cull.comp.spv");
+    if (light_result != VK_SUCCESS && light_result != VK_ERROR_FEATURE_NOT_PRESENT) {
+        VE_LOG_WARN("Light culling unavailable, point lights disabled");
+    }
+    return true;
+}
+
+static bool init_hiz_task(void* user_data) {
+    (void)user_data;
+
+    /* Depth pyramid for occlusion culling, needed before GPU culling picks its phases */
+    VkResult hiz_result = ve_hiz_init("shaders/hiz_build.comp.spv");
+    if (hiz_result != VK_SUCCESS && hiz_result != VK_ERROR_FEATURE_NOT_PRESENT) {
+        VE_LOG_WARN("Hi-Z unavailable, occlusion culling disabled");
+    }
+    return true;
+}
+
+static bool init_gpu_culling_task(void* user_data) {
+    (void)user_data;
+
+    /* Frustum and occlusion culling and indirect draw commands for GPU-driven batches */
+    VkResult cull_result = ve_gpu_culling_init("shaders/instance_cull.comp.spv", "shaders/instance_cull_late.comp.spv");
+    if (cull_result != VK_SUCCESS && cull_result != VK_ERROR_FEATURE_NOT_PRESENT) {
+        VE_LOG_WARN("GPU culling unavailable");
+    }
+    return true;
+}
+
+/* Create swapchain, or headless the offscreen targets frames are read back from */
+static bool init_present_task(void* user_data) {
+    engine_init* init = (engine_init*)user_data;
+
+    if (g_headless) {
+        ve_offscreen_config offscreen_config = {
+            .width = HEADLESS_WIDTH,
+            .height = HEADLESS_HEIGHT,
+            .format = VK_FORMAT_R8G8B8A8_SRGB,
+            .usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            .readback = true,
+        };
+
+        if (ve_offscreen_init(&offscreen_config) != VK_SUCCESS) {
+            VE_LOG_ERROR("Failed to create offscreen targets");
+            return false;
+        }
+        init->extent = ve_offscreen_get_extent();
+        init->color_format = ve_offscreen_get_format();
+        return true;
+    }
+
+    /* Benchmarks measure how fast frames render, not the refresh rate */
     ve_swapchain_config swapchain_config = {
         .width = g_window.width,
         .height = g_window.height,
-        .vsync = true,
+        .vsync = !g_benchmark.enabled,
         .triple_buffering = true,
+        .low_latency = true,
         .preferred_format = {VK_FORMAT_B8G8R8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR},
-        .preferred_present_mode = VK_PRESENT_MODE_MAILBOX_KHR,
+        .preferred_present_mode = g_benchmark.enabled ? VK_PRESENT_MODE_IMMEDIATE_KHR : VK_PRESENT_MODE_MAILBOX_KHR,
         .additional_usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT,
     };
 
@@ -154,6 +376,19 @@ static bool init_engine(void) {
         VE_LOG_ERROR("Failed to create swapchain");
         return false;
     }
+    init->extent = ve_swapchain_get_extent();
+    init->color_format = ve_swapchain_get_format();
+    return true;
+}
+
+static bool init_render_pass_task(void* user_data) {
+    engine_init* init = (engine_init*)user_data;
+
+    if (ve_hiz_is_enabled()) {
+        if (!ve_hiz_resize(init->extent.width, init->extent.height)) {
+            VE_LOG_WARN("Failed to size Hi-Z pyramid");
+        }
+    }
 
     /* Create basic render pass */
     VkFormat depth_format = VK_FORMAT_D24_UNORM_S8_UINT;
@@ -163,12 +398,179 @@ static bool init_engine(void) {
     }
 
     VkRenderPass render_pass = VK_NULL_HANDLE;
-    if (ve_render_pass_create_basic(ve_swapchain_get_format(), depth_format, &render_pass) != VK_SUCCESS) {
+    if (ve_render_pass_create_basic(init->color_format, depth_format, &render_pass) != VK_SUCCESS) {
         VE_LOG_ERROR("Failed to create render pass");
         return false;
     }
+    return true;
+}
+
+/* Open the benchmark scene and camera path and page the scene in up front, so the run measures rendering rather
+ * than the disk; needs nothing else from startup */
+static bool load_benchmark_assets(void* user_data) {
+    (void)user_data;
+
+    g_benchmark.pak = ve_pak_open(g_benchmark.scene);
+    if (!g_benchmark.pak) {
+        VE_LOG_ERROR("Failed to open benchmark scene: %s", g_benchmark.scene);
+        return false;
+    }
+    if (!ve_camera_path_load(g_benchmark.path_file, &g_benchmark.path)) {
+        return false;
+    }
+
+    uint32_t entry_count = ve_pak_get_count(g_benchmark.pak);
+    for (uint32_t i = 0; i < entry_count; i++) {
+        ve_pak_prefetch(g_benchmark.pak, ve_pak_get_entry(g_benchmark.pak, i));
+    }
+    return true;
+}
+
+/* Initialize engine */
+static bool init_engine(void) {
+    /* Initialize core systems */
+    if (!ve_memory_init()) {
+        fprintf(stderr, "Failed to initialize memory system\n");
+        return false;
+    }
+
+    ve_logger_config logger_config = {
+        .level = VE_LOG_TRACE,
+        .targets = VE_LOG_TARGET_CONSOLE | VE_LOG_TARGET_DEBUGGER,
+        .color_output = true,
+        .timestamps = true,
+        .thread_ids = false,
+        .async = true,
+        .queue_capacity = 8192,
+        .overflow_policy = VE_LOG_OVERFLOW_DROP,  /* Trace bursts must not stall the frame */
+        .deferred_format = true,
+    };
+
+    if (!ve_logger_init(&logger_config)) {
+        fprintf(stderr, "Failed to initialize logger\n");
+        return false;
+    }
+
+    if (!ve_timer_init()) {
+        VE_LOG_ERROR("Failed to initialize timer system");
+        return false;
+    }
+    ve_timestamp init_start = ve_timer_now();
+
+    if (!ve_profiler_init()) {
+        VE_LOG_ERROR("Failed to initialize profiler");
+        return false;
+    }
+
+    if (!ve_platform_init()) {
+        VE_LOG_ERROR("Failed to initialize platform layer");
+        return false;
+    }
+
+    /* Batched math kernels for the widest instruction set available */
+    ve_simd_init();
+
+    /* Startup tasks and later background jobs share the pool. Workers stay off the first placement CPU, which
+     * the frame-recording thread takes at the end of init, after they exist so none inherits it. */
+    ve_thread_pool_config pool_config = {
+        .reserved_cpus = 1,
+        .pin_workers = true,
+        .numa_local = true,
+    };
+    g_job_pool = ve_thread_pool_create_with_config(&pool_config);
+    if (!g_job_pool) {
+        VE_LOG_WARN("Failed to create job pool, startup runs serially and pipelines compile on the main thread");
+    }
+
+    /* Startup as a dependency graph: independent work (the Vulkan loader, the pipeline cache, shader modules,
+     * benchmark assets) runs on the pool while the main thread brings up the window and the device */
+    engine_init init = {0};
+    ve_init_graph graph;
+    ve_init_graph_init(&graph);
+
+    uint64_t window = 0;
+    if (!g_headless) {
+        window = VE_INIT_AFTER(ve_init_graph_add(&graph, "window", init_window_task, NULL,
+                                                 VE_INIT_TASK_MAIN_THREAD, 0));
+    }
+    uint32_t loader = ve_init_graph_add(&graph, "vulkan_loader", init_vulkan_loader_task, NULL, VE_INIT_TASK_NONE, 0);
+    uint32_t vulkan = ve_init_graph_add(&graph, "vulkan", init_vulkan_task, NULL, VE_INIT_TASK_MAIN_THREAD,
+                                        window | VE_INIT_AFTER(loader));
+    uint32_t device = ve_init_graph_add(&graph, "device_objects", init_device_objects_task, NULL,
+                                        VE_INIT_TASK_MAIN_THREAD, VE_INIT_AFTER(vulkan));
+    uint32_t pipeline_cache = ve_init_graph_add(&graph, "pipeline_cache", init_pipeline_cache_task, NULL,
+                                                VE_INIT_TASK_NONE, VE_INIT_AFTER(vulkan));
+    ve_init_graph_add(&graph, "asset_manager", init_asset_manager_task, NULL, VE_INIT_TASK_MAIN_THREAD,
+                      VE_INIT_AFTER(device));
+    ve_init_graph_add(&graph, "streaming", init_streaming_task, NULL, VE_INIT_TASK_MAIN_THREAD,
+                      VE_INIT_AFTER(device));
+
+    uint64_t shader_dependencies = VE_INIT_AFTER(device) | VE_INIT_AFTER(pipeline_cache);
+    ve_init_graph_add(&graph, "light_culling", init_light_culling_task, NULL, VE_INIT_TASK_NONE,
+                      shader_dependencies);
+    uint32_t hiz = ve_init_graph_add(&graph, "hiz", init_hiz_task, NULL, VE_INIT_TASK_NONE, shader_dependencies);
+    uint32_t culling = ve_init_graph_add(&graph, "gpu_culling", init_gpu_culling_task, NULL, VE_INIT_TASK_NONE,
+                                         shader_dependencies | VE_INIT_AFTER(hiz));
+
+    uint32_t present = ve_init_graph_add(&graph, "present", init_present_task, &init, VE_INIT_TASK_MAIN_THREAD,
+                                         VE_INIT_AFTER(device));
+    /* Resizing the pyramid waits for GPU culling, which reads Hi-Z state while it sets up */
+    ve_init_graph_add(&graph, "render_pass", init_render_pass_task, &init, VE_INIT_TASK_MAIN_THREAD,
+                      VE_INIT_AFTER(present) | VE_INIT_AFTER(culling));
+
+    if (g_benchmark.enabled) {
+        ve_init_graph_add(&graph, "benchmark_assets", load_benchmark_assets, NULL, VE_INIT_TASK_NONE, 0);
+    }
+
+    bool initialized = ve_init_graph_run(&graph, g_job_pool);
+    ve_init_graph_log_timings(&graph);
+    if (!initialized) {
+        VE_LOG_ERROR("Engine startup failed");
+        return false;
+    }
+
+    /* The thread that records and submits frames gets the first performance core, clear of the workers:
+     * the render thread when there is one, else the main thread */
+    const ve_cpu_topology* topology = ve_cpu_get_topology();
+    uint32_t render_cpu = 0;
+    bool pin_render = ve_cpu_get_placement(topology, -1, &render_cpu, 1) == 1 &&
+                      ve_cpu_set_count(&topology->available) > 1;
+    ve_cpu_set render_cpus;
+    ve_cpu_set_clear(&render_cpus);
+    ve_cpu_set_add(&render_cpus, render_cpu);
+    VE_LOG_INFO("CPU: %u logical, %u cores (%u performance), %u NUMA nodes", topology->logical_count,
+                topology->core_count, topology->performance_core_count, topology->numa_node_count);
+
+    if (!g_render_thread) {
+        if (pin_render && !ve_thread_set_affinity(NULL, &render_cpus)) {
+            VE_LOG_WARN("Main thread could not be pinned");
+        }
+        if (!ve_thread_set_priority(NULL, VE_THREAD_PRIORITY_HIGH)) {
+            VE_LOG_DEBUG("Cannot raise the main thread priority");
+        }
+    }
+
+    /* Sampled on the render side, in prepare_frame, where the renderer state it reads holds still */
+    ve_telemetry_init(&g_telemetry_config);
+    if (g_job_pool) {
+        ve_telemetry_add_thread_pool("jobs", g_job_pool);
+    }
+    ve_telemetry_add_source(sample_renderer_telemetry, NULL);
+
+    ve_frame_pipeline_config pipeline_config = {
+        .threaded = g_render_thread,
+        .snapshot_size = sizeof(frame_snapshot),
+        .prepare = prepare_frame,
+        .render = render_frame,
+        .render_cpus = pin_render ? &render_cpus : NULL,
+        .render_priority = VE_THREAD_PRIORITY_HIGH,
+    };
+    if (!ve_frame_pipeline_init(&pipeline_config)) {
+        VE_LOG_ERROR("Failed to start the frame pipeline");
+        return false;
+    }
 
-    VE_LOG_INFO("Engine initialized successfully");
+    VE_LOG_INFO("Engine initialized in %.1f ms", ve_timer_elapsed(init_start, ve_timer_now()) * 1000.0);
     return true;
 }
 
@@ -176,69 +578,377 @@ static bool init_engine(void) {
 static void shutdown_engine(void) {
     VE_LOG_INFO("Shutting down engine...");
 
+    ve_frame_pipeline_shutdown();
     ve_vulkan_wait_idle();
+    ve_telemetry_shutdown();
 
     /* TODO: Destroy render pass, framebuffers, etc. */
 
+    ve_gpu_culling_shutdown();
+    ve_hiz_shutdown();
+    ve_light_culling_shutdown();
+    ve_asset_manager_shutdown();
+    ve_instancing_shutdown();
+    ve_texture_streaming_shutdown();
+    ve_pipeline_shutdown();
+    if (g_job_pool) {
+        ve_thread_pool_destroy(g_job_pool);
+        g_job_pool = NULL;
+    }
+    ve_upload_shutdown();
+    ve_submit_shutdown();
+    ve_gpu_stats_shutdown();
+    ve_gpu_profiler_shutdown();
     ve_command_buffer_shutdown();
+    ve_offscreen_shutdown();
     ve_swapchain_destroy();
+    ve_deletion_queue_shutdown();
+    ve_descriptor_shutdown();
+    ve_bindless_shutdown();
+    ve_gpu_memory_shutdown();
     ve_sync_shutdown();
     ve_vulkan_shutdown();
     ve_platform_shutdown();
+    ve_profiler_shutdown();
     ve_timer_shutdown();
     ve_logger_shutdown();
     ve_memory_shutdown();
 }
 
-/* Main loop */
+/* Start of a frame on the render side: the main thread waits until this returns, so the
+   updates that read state the simulation writes (instances, asset requests) run here */
+static void prepare_frame(const ve_render_snapshot* snapshot, void* user_data) {
+    (void)user_data;
+    const frame_snapshot* data = (const frame_snapshot*)snapshot->data;
+
+    /* Inline, the main loop already waited before sampling input */
+    if (ve_frame_pipeline_is_threaded() && !g_headless) {
+        ve_swapchain_wait_for_present(1, 100000000ull);
+    }
+
+    uint64_t frame = ve_sync_get_frame_number();
+    ve_latency_mark_at(frame, VE_LATENCY_INPUT_SAMPLE, snapshot->input_time);
+    ve_latency_mark_at(frame, VE_LATENCY_SIMULATION_END, snapshot->simulation_end);
+
+    ve_asset_manager_update();
+    ve_instancing_update();
+    ve_texture_streaming_update();
+
+    ve_telemetry_frame(&data->frame_time);
+}
+
+/* Renderer values for telemetry: GPU memory budget per heap and upload queue depth */
+static void sample_renderer_telemetry(void* user_data) {
+    (void)user_data;
+    char name[VE_TELEMETRY_MAX_NAME];
+
+    ve_gpu_heap_budget budgets[VK_MAX_MEMORY_HEAPS];
+    uint32_t heap_count = ve_gpu_memory_get_budget(budgets, VK_MAX_MEMORY_HEAPS);
+    for (uint32_t i = 0; i < heap_count; i++) {
+        snprintf(name, sizeof(name), "gpu.heap%u.budget_bytes", i);
+        ve_telemetry_set(name, (double)budgets[i].budget);
+        snprintf(name, sizeof(name), "gpu.heap%u.usage_bytes", i);
+        ve_telemetry_set(name, (double)budgets[i].usage);
+        snprintf(name, sizeof(name), "gpu.heap%u.reserved_bytes", i);
+        ve_telemetry_set(name, (double)budgets[i].reserved);
+    }
+
+    ve_gpu_memory_stats memory_stats;
+    ve_gpu_memory_get_stats(&memory_stats);
+    ve_telemetry_set("gpu.used_bytes", (double)memory_stats.used_bytes);
+    ve_telemetry_set("gpu.allocations", (double)memory_stats.allocation_count);
+
+    if (ve_upload_is_enabled()) {
+        ve_upload_stats upload_stats;
+        ve_upload_get_stats(&upload_stats);
+        ve_telemetry_set("upload.pending", (double)upload_stats.pending_uploads);
+        ve_telemetry_set("upload.ring_used_bytes", (double)upload_stats.ring_used);
+        ve_telemetry_set("upload.ring_size_bytes", (double)upload_stats.ring_size);
+        ve_telemetry_set("upload.rejected", (double)upload_stats.rejected_uploads);
+    }
+}
+
+/* Hand the frames whose readback has finished to their consumer, without waiting for the rest. The
+   consumer hashes each frame, so the trace log of two runs can be compared frame by frame. */
+static void drain_readbacks(void) {
+    ve_offscreen_frame frame;
+    while (ve_offscreen_acquire_readback(&frame)) {
+        /* FNV-1a over the packed rows */
+        const uint8_t* bytes = (const uint8_t*)frame.data;
+        size_t size = (size_t)frame.row_pitch * frame.height;
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+        }
+        VE_LOG_TRACE("Frame %llu read back (%ux%u): %016llx", (unsigned long long)frame.frame, frame.width,
+                     frame.height, (unsigned long long)hash);
+        ve_offscreen_release_readback();
+    }
+}
+
+/* Hand the GPU times of the frame the profiler collected last to the benchmark */
+static void record_gpu_benchmark(void) {
+    if (!ve_benchmark_is_active() || !ve_gpu_profiler_is_enabled()) {
+        return;
+    }
+
+    ve_gpu_zone_result zones[VE_GPU_PROFILER_MAX_ZONES];
+    uint32_t count = ve_gpu_profiler_get_results(zones, VE_GPU_PROFILER_MAX_ZONES);
+    if (count == 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        ve_benchmark_record_gpu_pass(zones[i].name, zones[i].duration_ms);
+    }
+    ve_benchmark_record_gpu_frame(ve_gpu_profiler_get_frame_time_ms());
+}
+
+/* Clear color of a frame, cycling slowly with simulation time so consecutive frames differ. A benchmark
+   follows its camera instead, so every run clears to the same sequence of colors. */
+static VkClearColorValue frame_clear_color(const ve_render_snapshot* snapshot) {
+    if (g_benchmark.enabled) {
+        const frame_snapshot* data = (const frame_snapshot*)snapshot->data;
+        ve_vec3 forward = ve_vec3_normalize(ve_vec3_sub(data->camera_target, data->camera_eye));
+        VkClearColorValue color = {{
+            0.5f + 0.5f * forward.x,
+            0.5f + 0.5f * forward.y,
+            0.5f + 0.5f * forward.z,
+            1.0f,
+        }};
+        return color;
+    }
+
+    float phase = (float)snapshot->time * 0.5f;
+    VkClearColorValue color = {{
+        0.5f + 0.5f * sinf(phase),
+        0.5f + 0.5f * sinf(phase + 2.094f),
+        0.5f + 0.5f * sinf(phase + 4.189f),
+        1.0f,
+    }};
+    return color;
+}
+
+/*
+ * Record and submit one frame: a timed clear of the acquired swapchain image and its present, or headless a
+ * clear of the offscreen target and its readback. Waits for the frame's slot first, which also collects the
+ * GPU times of the frame that used it last.
+ */
+static bool record_frame(const ve_render_snapshot* snapshot) {
+    if (ve_sync_wait_for_frame(UINT64_MAX) != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to wait for frame slot");
+        return false;
+    }
+
+    ve_frame_sync* sync = ve_sync_get_current_frame();
+    VkImage target;
+    if (g_headless) {
+        target = ve_offscreen_get_target()->image;
+    } else {
+        /* Out of date: skip the frame, the next one recreates the swapchain */
+        if (ve_swapchain_acquire_next_image(sync->image_available) != VK_SUCCESS) {
+            return false;
+        }
+        ve_swapchain* swapchain = ve_swapchain_get_current();
+        target = swapchain->images[swapchain->current_image_index];
+    }
+    ve_sync_reset_frame();
+
+    ve_command_buffer* cmd = ve_command_buffer_get_current(VE_COMMAND_BUFFER_GRAPHICS);
+    if (cmd) {
+        ve_command_buffer_set_device_mask(cmd, ve_vulkan_get_frame_device_mask(ve_sync_get_frame_number()));
+        cmd = ve_command_buffer_begin_frame(VE_COMMAND_BUFFER_GRAPHICS);
+    }
+    if (!cmd) {
+        VE_LOG_ERROR("Failed to begin frame command buffer");
+        return false;
+    }
+
+    /* The clear covers the whole image, so its earlier contents are discarded */
+    VkImageSubresourceRange range = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    ve_command_buffer_image_barrier(cmd, target, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                    0, VK_ACCESS_TRANSFER_WRITE_BIT,
+                                    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, &range);
+
+    VkClearColorValue color = frame_clear_color(snapshot);
+    ve_vulkan_begin_debug_label(cmd->buffer, "clear", color.float32[0], color.float32[1], color.float32[2]);
+    ve_command_buffer_clear_color_image(cmd, target, &color, &range);
+    ve_vulkan_end_debug_label(cmd->buffer);
+
+    if (g_headless) {
+        /* Readback expects a target written as a color attachment */
+        ve_command_buffer_image_barrier(cmd, target, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                                        VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                                        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                        &range);
+        ve_offscreen_record_readback(cmd, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    } else {
+        ve_command_buffer_image_barrier(cmd, target, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                        VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_ACCESS_TRANSFER_WRITE_BIT, 0,
+                                        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, &range);
+    }
+
+    VkResult result = ve_command_buffer_end_frame(cmd);
+    if (result == VK_SUCCESS && ve_submit_is_enabled()) {
+        if (!g_headless) {
+            ve_submit_wait_semaphore(VE_COMMAND_BUFFER_GRAPHICS, sync->image_available, 0,
+                                     VK_PIPELINE_STAGE_2_TRANSFER_BIT);
+            ve_submit_signal_semaphore(VE_COMMAND_BUFFER_GRAPHICS, sync->render_finished, 0);
+        }
+        result = ve_submit_add(cmd) ? ve_submit_flush() : VK_ERROR_OUT_OF_HOST_MEMORY;
+    } else if (result == VK_SUCCESS) {
+        VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        uint32_t semaphore_count = g_headless ? 0 : 1;
+        result = ve_command_buffer_submit(cmd, &sync->image_available, &wait_stage, semaphore_count,
+                                          &sync->render_finished, semaphore_count, sync->render_fence);
+    }
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to submit frame: %d", result);
+        return false;
+    }
+
+    /* An out-of-date swapchain is flagged and recreated by the next frame */
+    if (!g_headless) {
+        ve_swapchain_present(sync->render_finished);
+    }
+    ve_sync_advance_frame();
+    return true;
+}
+
+/* Rest of the frame, overlapping the next simulation step: only the snapshot and renderer state */
+static void render_frame(const ve_render_snapshot* snapshot, void* user_data) {
+    (void)user_data;
+    const frame_snapshot* data = (const frame_snapshot*)snapshot->data;
+
+    if (g_headless) {
+        record_frame(snapshot);
+        record_gpu_benchmark();
+        drain_readbacks();
+        return;
+    }
+
+    /* Handle window resize without stalling the device */
+    if (data->framebuffer_resized || ve_swapchain_is_out_of_date()) {
+        /* Minimized: skip the frame and retry once the window has a size */
+        if (data->framebuffer_width == 0 || data->framebuffer_height == 0) {
+            return;
+        }
+
+        ve_swapchain_config config = {
+            .width = data->framebuffer_width,
+            .height = data->framebuffer_height,
+            .vsync = !g_benchmark.enabled,
+            .triple_buffering = true,
+            .low_latency = true,
+            .preferred_format = {VK_FORMAT_B8G8R8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR},
+            .preferred_present_mode = g_benchmark.enabled ? VK_PRESENT_MODE_IMMEDIATE_KHR : VK_PRESENT_MODE_MAILBOX_KHR,
+            .additional_usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        };
+
+        if (ve_swapchain_recreate(&config) == VK_SUCCESS) {
+            VE_LOG_INFO("Swapchain resized: %ux%u", data->framebuffer_width, data->framebuffer_height);
+        }
+    }
+
+    record_frame(snapshot);
+    record_gpu_benchmark();
+}
+
+/* Main loop: input and simulation, handing each frame to the render side */
 static void main_loop(void) {
     ve_frame_time frame_time = {0};
     ve_frame_time_init(&frame_time);
+    double simulation_time = 0.0;
+
+    /* Pace the CPU to the target frame rate instead of spinning; headless runs and benchmarks go as fast as the GPU */
+    ve_frame_time_set_limiter_enabled(!g_headless && !g_benchmark.enabled);
 
     VE_LOG_INFO("Entering main loop");
 
-    while (!glfwWindowShouldClose(g_window.window)) {
-        glfwPollEvents();
+    for (uint64_t frame = 0; g_frame_limit == 0 || frame < g_frame_limit; frame++) {
+        if (!g_headless && glfwWindowShouldClose(g_window.window)) {
+            break;
+        }
+
+        /* Wait before sampling input, so the frame starts from the freshest input. With a render
+           thread, that thread waits for presentation and the handoff paces this one. */
+        ve_frame_time_limit();
+        if (!ve_frame_pipeline_is_threaded() && !g_headless) {
+            ve_swapchain_wait_for_present(1, 100000000ull);
+        }
+
+        ve_profiler_begin_frame();
+        if (!g_headless) {
+            glfwPollEvents();
+        }
+        ve_timestamp input_time = ve_timer_now();
 
         /* Update frame time */
         ve_frame_time_update(&frame_time);
 
-        /* Handle window resize */
-        if (g_window.framebuffer_resized) {
-            int width, height;
-            glfwGetFramebufferSize(g_window.window, &width, &height);
+        /* Fixed-timestep simulation clock; the render side draws from the snapshot of the latest step, while
+           the previous frame's recording and submission still overlap this one on the render thread */
+        while (ve_frame_time_should_update(&frame_time)) {
+            ve_frame_time_consume_update(&frame_time);
+            simulation_time += ve_frame_time_get_fixed_timestep();
+        }
 
-            while (width == 0 || height == 0) {
+        ve_render_snapshot* snapshot = ve_frame_pipeline_begin_snapshot();
+        if (snapshot) {
+            frame_snapshot* data = (frame_snapshot*)snapshot->data;
+            int width = (int)ve_offscreen_get_extent().width;
+            int height = (int)ve_offscreen_get_extent().height;
+            if (!g_headless) {
                 glfwGetFramebufferSize(g_window.window, &width, &height);
-                glfwWaitEvents();
+            }
+            data->framebuffer_width = (uint32_t)width;
+            data->framebuffer_height = (uint32_t)height;
+            data->framebuffer_resized = g_window.framebuffer_resized;
+
+            /* One fixed step along the path per frame, however long the frame took, so every run draws the
+               same views */
+            if (g_benchmark.enabled) {
+                uint64_t step = frame > BENCHMARK_WARMUP_FRAMES ? frame - BENCHMARK_WARMUP_FRAMES : 0;
+                ve_camera_path_sample(&g_benchmark.path, (float)(step * ve_frame_time_get_fixed_timestep()),
+                                      &data->camera_eye, &data->camera_target);
             }
 
-            ve_swapchain_config config = {
-                .width = (uint32_t)width,
-                .height = (uint32_t)height,
-                .vsync = true,
-                .triple_buffering = true,
-            };
-
-            if (ve_swapchain_recreate(&config) == VK_SUCCESS) {
-                g_window.width = (uint32_t)width;
-                g_window.height = (uint32_t)height;
-                VE_LOG_INFO("Swapchain resized: %ux%u", width, height);
+            /* A minimized window keeps the resize pending until it has a size again */
+            if (width > 0 && height > 0) {
+                g_window.framebuffer_resized = false;
             }
 
-            g_window.framebuffer_resized = false;
+            snapshot->time = simulation_time;
+            snapshot->alpha = ve_frame_time_get_alpha(&frame_time);
+            snapshot->delta_time = frame_time.delta_time;
+            data->frame_time = frame_time;
+            snapshot->input_time = input_time;
+            snapshot->simulation_end = ve_timer_now();
+            ve_frame_pipeline_submit_snapshot(snapshot);
         }
 
-        /* TODO: Render frame */
-        /* For now, just clear to screen */
-        ve_frame_time* ft = &frame_time;
-        (void)ft;
+        ve_profiler_end_frame();
+        ve_benchmark_record_cpu_frame(ve_profiler_get_frame_time_ms());
     }
 
+    ve_frame_pipeline_flush();
     ve_vulkan_wait_idle();
+    if (g_headless) {
+        drain_readbacks();
+    }
 
+    ve_frame_pipeline_stats stats;
+    ve_frame_pipeline_get_stats(&stats);
     VE_LOG_INFO("Main loop terminated");
     VE_LOG_INFO("Average FPS: %.2f", frame_time.frame_rate);
+    VE_LOG_INFO("Frames: %llu, simulation waited %.2f s, render thread idle %.2f s",
+                (unsigned long long)stats.rendered, stats.simulation_wait, stats.render_idle);
+    if (g_headless) {
+        ve_offscreen_stats offscreen_stats;
+        ve_offscreen_get_stats(&offscreen_stats);
+        VE_LOG_INFO("Read back %llu frames, dropped %llu", (unsigned long long)offscreen_stats.read_back,
+                    (unsigned long long)offscreen_stats.dropped);
+    }
 }
 
 /* GLFW callbacks */
@@ -288,35 +998,146 @@ static void glfw_error_callback(int error, const char* description) {
     VE_LOG_ERROR("GLFW Error %d: %s", error, description);
 }
 
+/* Size the run to the warm-up plus one frame per step of the path loaded during startup */
+static bool start_benchmark(void) {
+    uint32_t entry_count = ve_pak_get_count(g_benchmark.pak);
+
+    double step = ve_frame_time_get_fixed_timestep();
+    uint64_t path_frames = (uint64_t)(ve_camera_path_get_duration(&g_benchmark.path) / step) + 1;
+    g_frame_limit = BENCHMARK_WARMUP_FRAMES + path_frames;
+    VE_LOG_INFO("Benchmark %s (%u entries): %llu frames of %.2f ms after %d warm-up frames", g_benchmark.scene,
+                entry_count, (unsigned long long)path_frames, step * 1000.0, BENCHMARK_WARMUP_FRAMES);
+
+    return ve_benchmark_begin(g_benchmark.scene, BENCHMARK_WARMUP_FRAMES);
+}
+
+static void stop_benchmark(void) {
+    ve_benchmark_end();
+    ve_camera_path_free(&g_benchmark.path);
+    if (g_benchmark.pak) {
+        ve_pak_close(g_benchmark.pak);
+        g_benchmark.pak = NULL;
+    }
+}
+
+/* Report the run; false if the report could not be written */
+static bool finish_benchmark(void) {
+    ve_benchmark_log_report();
+
+    /* A report without GPU times would compare as a regression-free run */
+    ve_benchmark_summary gpu;
+    if (!ve_benchmark_get_gpu_summary(&gpu)) {
+        VE_LOG_ERROR("Benchmark recorded no GPU frames, not writing a report");
+        stop_benchmark();
+        return false;
+    }
+
+    bool written = ve_benchmark_write_report(g_benchmark.report ? g_benchmark.report : BENCHMARK_DEFAULT_REPORT);
+    stop_benchmark();
+    return written;
+}
+
+/* Parse a device UUID as 32 hex digits, dashes allowed between them */
+static bool parse_device_uuid(const char* text, uint8_t uuid[VK_UUID_SIZE]) {
+    uint32_t digits = 0;
+    for (const char* c = text; *c; c++) {
+        if (*c == '-') {
+            continue;
+        }
+
+        int value;
+        if (*c >= '0' && *c <= '9') {
+            value = *c - '0';
+        } else if (*c >= 'a' && *c <= 'f') {
+            value = *c - 'a' + 10;
+        } else if (*c >= 'A' && *c <= 'F') {
+            value = *c - 'A' + 10;
+        } else {
+            return false;
+        }
+
+        if (digits == VK_UUID_SIZE * 2) {
+            return false;
+        }
+        uuid[digits / 2] = (uint8_t)(digits % 2 == 0 ? value << 4 : uuid[digits / 2] | value);
+        digits++;
+    }
+    return digits == VK_UUID_SIZE * 2;
+}
+
 /* Entry point */
 int main(int argc, char* argv[]) {
-    (void)argc;
-    (void)argv;
+    /* GPU by index or UUID (see the GPU list logged at startup), and whether to span its device group */
+    ve_vulkan_device_selection device_selection = {.index = -1};
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--no-render-thread") == 0) {
+            g_render_thread = false;
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            g_headless = true;
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            g_frame_limit = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--benchmark") == 0 && i + 2 < argc) {
+            g_benchmark.enabled = true;
+            g_benchmark.scene = argv[++i];
+            g_benchmark.path_file = argv[++i];
+        } else if (strcmp(argv[i], "--benchmark-report") == 0 && i + 1 < argc) {
+            g_benchmark.report = argv[++i];
+        } else if (strcmp(argv[i], "--telemetry-port") == 0 && i + 1 < argc) {
+            g_telemetry_config.serve = true;
+            g_telemetry_config.port = (uint16_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--gpu") == 0 && i + 1 < argc) {
+            const char* gpu = argv[++i];
+            device_selection.match_uuid = parse_device_uuid(gpu, device_selection.uuid);
+            if (!device_selection.match_uuid) {
+                device_selection.index = atoi(gpu);
+            }
+        } else if (strcmp(argv[i], "--device-group") == 0 && i + 1 < argc) {
+            const char* mode = argv[++i];
+            device_selection.group_mode = strcmp(mode, "sfr") == 0 ? VE_DEVICE_GROUP_SPLIT_FRAME
+                                                                   : VE_DEVICE_GROUP_ALTERNATE_FRAME;
+        }
+    }
+    ve_vulkan_set_device_selection(&device_selection);
+    if (g_headless && g_frame_limit == 0) {
+        g_frame_limit = HEADLESS_DEFAULT_FRAMES;
+    }
 
     VE_LOG_INFO("Vulkan Engine starting...");
     VE_LOG_INFO("Version: 0.1.0");
     VE_LOG_INFO("Build: %s %s", __DATE__, __TIME__);
 
-    /* Initialize window */
-    if (!init_window(1280, 720, "Vulkan Engine")) {
-        fprintf(stderr, "Failed to initialize window\n");
+    /* Initialize engine, window included */
+    if (!init_engine()) {
+        fprintf(stderr, "Failed to initialize engine\n");
+        stop_benchmark();
+        if (!g_headless) {
+            shutdown_window();
+        }
         return EXIT_FAILURE;
     }
 
-    /* Initialize engine */
-    if (!init_engine()) {
-        fprintf(stderr, "Failed to initialize engine\n");
-        shutdown_window();
+    if (g_benchmark.enabled && !start_benchmark()) {
+        fprintf(stderr, "Failed to start benchmark\n");
+        stop_benchmark();
+        shutdown_engine();
+        if (!g_headless) {
+            shutdown_window();
+        }
         return EXIT_FAILURE;
     }
 
     /* Run main loop */
     main_loop();
 
+    bool benchmark_written = !g_benchmark.enabled || finish_benchmark();
+
     /* Shutdown */
     shutdown_engine();
-    shutdown_window();
+    if (!g_headless) {
+        shutdown_window();
+    }
 
     VE_LOG_INFO("Engine terminated successfully");
-    return EXIT_SUCCESS;
+    return benchmark_written ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -0,0 +1,735 @@
+/**
+ * @file simd.c
+ * @brief Batched math kernels with runtime instruction set dispatch
+ *
+ * Every level lives in this file. The x86 kernels are compiled for their
+ * instruction set with target attributes rather than per-file flags, so
+ * the rest of the engine keeps building for the baseline CPU and the wide
+ * code only runs after ve_simd_init has checked for it.
+ */
+
+#include "simd.h"
+#include "../core/assert.h"
+#include "../core/logger.h"
+
+#if defined(VE_ARCH_X64) || defined(VE_ARCH_X86)
+    #define SIMD_X86 1
+    #include <immintrin.h>
+#elif defined(VE_ARCH_ARM64)
+    #define SIMD_NEON 1
+    #include <arm_neon.h>
+#endif
+
+#if defined(VE_COMPILER_GCC) || defined(VE_COMPILER_CLANG)
+    #define SIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+    #define SIMD_TARGET(isa)
+#endif
+
+/**
+ * @brief One implementation of every kernel
+ */
+typedef struct simd_kernels {
+    void (*mat4_mul)(ve_mat4* out, const ve_mat4* a, const ve_mat4* b, uint32_t count);
+    void (*transform_points)(const ve_mat4* m, const float* x, const float* y, const float* z, float* out_x,
+                             float* out_y, float* out_z, uint32_t count);
+    uint32_t (*cull_aabbs)(const ve_frustum* frustum, const ve_aabb_soa* boxes, uint32_t count, uint32_t* visible);
+    uint32_t (*cull_spheres)(const ve_frustum* frustum, const ve_sphere_soa* spheres, uint32_t count,
+                             uint32_t* visible);
+} simd_kernels;
+
+/**
+ * @brief Frustum planes split into components, with the absolute normals
+ * the box test projects extents onto
+ */
+typedef struct cull_planes {
+    float nx[6], ny[6], nz[6], d[6];
+    float ax[6], ay[6], az[6];
+} cull_planes;
+
+static void prepare_planes(const ve_frustum* frustum, cull_planes* planes) {
+    for (int i = 0; i < 6; i++) {
+        const ve_vec4* p = &frustum->planes[i];
+        planes->nx[i] = p->x;
+        planes->ny[i] = p->y;
+        planes->nz[i] = p->z;
+        planes->d[i] = p->w;
+        planes->ax[i] = fabsf(p->x);
+        planes->ay[i] = fabsf(p->y);
+        planes->az[i] = fabsf(p->z);
+    }
+}
+
+static uint32_t bit_scan_forward(uint32_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return (uint32_t)index;
+#else
+    return (uint32_t)__builtin_ctz(value);
+#endif
+}
+
+/**
+ * @brief Append the indices of the set bits of a lane mask
+ */
+static uint32_t append_visible(uint32_t* visible, uint32_t visible_count, uint32_t base, uint32_t mask) {
+    while (mask) {
+        visible[visible_count++] = base + bit_scan_forward(mask);
+        mask &= mask - 1;
+    }
+    return visible_count;
+}
+
+/* ------------------------------------------------------------------------ */
+/* Scalar                                                                   */
+/* ------------------------------------------------------------------------ */
+
+static bool aabb_visible(const cull_planes* planes, const ve_aabb_soa* boxes, uint32_t i) {
+    float cx = boxes->center_x[i], cy = boxes->center_y[i], cz = boxes->center_z[i];
+    float ex = boxes->extent_x[i], ey = boxes->extent_y[i], ez = boxes->extent_z[i];
+    for (int p = 0; p < 6; p++) {
+        float distance = planes->nx[p] * cx + planes->ny[p] * cy + planes->nz[p] * cz + planes->d[p];
+        float radius = planes->ax[p] * ex + planes->ay[p] * ey + planes->az[p] * ez;
+        if (distance + radius < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool sphere_visible(const cull_planes* planes, const ve_sphere_soa* spheres, uint32_t i) {
+    float cx = spheres->center_x[i], cy = spheres->center_y[i], cz = spheres->center_z[i];
+    for (int p = 0; p < 6; p++) {
+        float distance = planes->nx[p] * cx + planes->ny[p] * cy + planes->nz[p] * cz + planes->d[p];
+        if (distance + spheres->radius[i] < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void transform_point_scalar(const ve_mat4* m, const float* x, const float* y, const float* z, float* out_x,
+                                   float* out_y, float* out_z, uint32_t i) {
+    float px = x[i], py = y[i], pz = z[i];
+    out_x[i] = m->m[0] * px + m->m[4] * py + m->m[8] * pz + m->m[12];
+    out_y[i] = m->m[1] * px + m->m[5] * py + m->m[9] * pz + m->m[13];
+    out_z[i] = m->m[2] * px + m->m[6] * py + m->m[10] * pz + m->m[14];
+}
+
+static void mat4_mul_scalar(ve_mat4* out, const ve_mat4* a, const ve_mat4* b, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        ve_mat4 r = ve_mat4_mul(&a[i], &b[i]);
+        out[i] = r;
+    }
+}
+
+static void transform_points_scalar(const ve_mat4* m, const float* x, const float* y, const float* z, float* out_x,
+                                    float* out_y, float* out_z, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        transform_point_scalar(m, x, y, z, out_x, out_y, out_z, i);
+    }
+}
+
+static uint32_t cull_aabbs_scalar(const ve_frustum* frustum, const ve_aabb_soa* boxes, uint32_t count,
+                                  uint32_t* visible) {
+    cull_planes planes;
+    prepare_planes(frustum, &planes);
+
+    uint32_t visible_count = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (aabb_visible(&planes, boxes, i)) {
+            visible[visible_count++] = i;
+        }
+    }
+    return visible_count;
+}
+
+static uint32_t cull_spheres_scalar(const ve_frustum* frustum, const ve_sphere_soa* spheres, uint32_t count,
+                                    uint32_t* visible) {
+    cull_planes planes;
+    prepare_planes(frustum, &planes);
+
+    uint32_t visible_count = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (sphere_visible(&planes, spheres, i)) {
+            visible[visible_count++] = i;
+        }
+    }
+    return visible_count;
+}
+
+#ifdef SIMD_X86
+
+/* ------------------------------------------------------------------------ */
+/* SSE2                                                                     */
+/* ------------------------------------------------------------------------ */
+
+SIMD_TARGET("sse2")
+static void mat4_mul_sse(ve_mat4* out, const ve_mat4* a, const ve_mat4* b, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        __m128 a0 = _mm_loadu_ps(&a[i].m[0]);
+        __m128 a1 = _mm_loadu_ps(&a[i].m[4]);
+        __m128 a2 = _mm_loadu_ps(&a[i].m[8]);
+        __m128 a3 = _mm_loadu_ps(&a[i].m[12]);
+
+        /* Column c of the product is a's columns weighted by b's column c */
+        __m128 r[4];
+        for (int c = 0; c < 4; c++) {
+            __m128 bc = _mm_loadu_ps(&b[i].m[c * 4]);
+            __m128 sum = _mm_mul_ps(a0, _mm_shuffle_ps(bc, bc, 0x00));
+            sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_shuffle_ps(bc, bc, 0x55)));
+            sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_shuffle_ps(bc, bc, 0xAA)));
+            r[c] = _mm_add_ps(sum, _mm_mul_ps(a3, _mm_shuffle_ps(bc, bc, 0xFF)));
+        }
+        for (int c = 0; c < 4; c++) {
+            _mm_storeu_ps(&out[i].m[c * 4], r[c]);
+        }
+    }
+}
+
+SIMD_TARGET("sse2")
+static void transform_points_sse(const ve_mat4* m, const float* x, const float* y, const float* z, float* out_x,
+                                 float* out_y, float* out_z, uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i), pz = _mm_loadu_ps(z + i);
+        for (int row = 0; row < 3; row++) {
+            __m128 sum = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m->m[row]), px), _mm_set1_ps(m->m[12 + row]));
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(m->m[4 + row]), py));
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(m->m[8 + row]), pz));
+            _mm_storeu_ps((row == 0 ? out_x : row == 1 ? out_y : out_z) + i, sum);
+        }
+    }
+    for (; i < count; i++) {
+        transform_point_scalar(m, x, y, z, out_x, out_y, out_z, i);
+    }
+}
+
+SIMD_TARGET("sse2")
+static uint32_t cull_aabbs_sse(const ve_frustum* frustum, const ve_aabb_soa* boxes, uint32_t count,
+                               uint32_t* visible) {
+    cull_planes planes;
+    prepare_planes(frustum, &planes);
+
+    uint32_t visible_count = 0;
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 cx = _mm_loadu_ps(boxes->center_x + i);
+        __m128 cy = _mm_loadu_ps(boxes->center_y + i);
+        __m128 cz = _mm_loadu_ps(boxes->center_z + i);
+        __m128 ex = _mm_loadu_ps(boxes->extent_x + i);
+        __m128 ey = _mm_loadu_ps(boxes->extent_y + i);
+        __m128 ez = _mm_loadu_ps(boxes->extent_z + i);
+
+        int mask = 0xF;
+        for (int p = 0; p < 6 && mask; p++) {
+            __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.nx[p]), cx), _mm_set1_ps(planes.d[p]));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes.ny[p]), cy));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes.nz[p]), cz));
+            __m128 radius = _mm_mul_ps(_mm_set1_ps(planes.ax[p]), ex);
+            radius = _mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(planes.ay[p]), ey));
+            radius = _mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(planes.az[p]), ez));
+            mask &= _mm_movemask_ps(_mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+        }
+        visible_count = append_visible(visible, visible_count, i, (uint32_t)mask);
+    }
+    for (; i < count; i++) {
+        if (aabb_visible(&planes, boxes, i)) {
+            visible[visible_count++] = i;
+        }
+    }
+    return visible_count;
+}
+
+SIMD_TARGET("sse2")
+static uint32_t cull_spheres_sse(const ve_frustum* frustum, const ve_sphere_soa* spheres, uint32_t count,
+                                 uint32_t* visible) {
+    cull_planes planes;
+    prepare_planes(frustum, &planes);
+
+    uint32_t visible_count = 0;
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 cx = _mm_loadu_ps(spheres->center_x + i);
+        __m128 cy = _mm_loadu_ps(spheres->center_y + i);
+        __m128 cz = _mm_loadu_ps(spheres->center_z + i);
+        __m128 r = _mm_loadu_ps(spheres->radius + i);
+
+        int mask = 0xF;
+        for (int p = 0; p < 6 && mask; p++) {
+            __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.nx[p]), cx), _mm_set1_ps(planes.d[p]));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes.ny[p]), cy));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes.nz[p]), cz));
+            mask &= _mm_movemask_ps(_mm_cmpge_ps(_mm_add_ps(distance, r), _mm_setzero_ps()));
+        }
+        visible_count = append_visible(visible, visible_count, i, (uint32_t)mask);
+    }
+    for (; i < count; i++) {
+        if (sphere_visible(&planes, spheres, i)) {
+            visible[visible_count++] = i;
+        }
+    }
+    return visible_count;
+}
+
+/* ------------------------------------------------------------------------ */
+/* AVX2 + FMA                                                               */
+/* ------------------------------------------------------------------------ */
+
+SIMD_TARGET("avx2,fma")
+static void mat4_mul_avx2(ve_mat4* out, const ve_mat4* a, const ve_mat4* b, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        /* a's columns in both halves; two columns of the product per register */
+        __m256 a0 = _mm256_broadcast_ps((const __m128*)&a[i].m[0]);
+        __m256 a1 = _mm256_broadcast_ps((const __m128*)&a[i].m[4]);
+        __m256 a2 = _mm256_broadcast_ps((const __m128*)&a[i].m[8]);
+        __m256 a3 = _mm256_broadcast_ps((const __m128*)&a[i].m[12]);
+        __m256 b01 = _mm256_loadu_ps(&b[i].m[0]);
+        __m256 b23 = _mm256_loadu_ps(&b[i].m[8]);
+
+        __m256 r01 = _mm256_mul_ps(a0, _mm256_permute_ps(b01, 0x00));
+        r01 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b01, 0x55), r01);
+        r01 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b01, 0xAA), r01);
+        r01 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b01, 0xFF), r01);
+
+        __m256 r23 = _mm256_mul_ps(a0, _mm256_permute_ps(b23, 0x00));
+        r23 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b23, 0x55), r23);
+        r23 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b23, 0xAA), r23);
+        r23 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b23, 0xFF), r23);
+
+        _mm256_storeu_ps(&out[i].m[0], r01);
+        _mm256_storeu_ps(&out[i].m[8], r23);
+    }
+}
+
+SIMD_TARGET("avx2,fma")
+static void transform_points_avx2(const ve_mat4* m, const float* x, const float* y, const float* z, float* out_x,
+                                  float* out_y, float* out_z, uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i), pz = _mm256_loadu_ps(z + i);
+        for (int row = 0; row < 3; row++) {
+            __m256 sum = _mm256_fmadd_ps(_mm256_set1_ps(m->m[row]), px, _mm256_set1_ps(m->m[12 + row]));
+            sum = _mm256_fmadd_ps(_mm256_set1_ps(m->m[4 + row]), py, sum);
+            sum = _mm256_fmadd_ps(_mm256_set1_ps(m->m[8 + row]), pz, sum);
+            _mm256_storeu_ps((row == 0 ? out_x : row == 1 ? out_y : out_z) + i, sum);
+        }
+    }
+    for (; i < count; i++) {
+        transform_point_scalar(m, x, y, z, out_x, out_y, out_z, i);
+    }
+}
+
+SIMD_TARGET("avx2,fma")
+static uint32_t cull_aabbs_avx2(const ve_frustum* frustum, const ve_aabb_soa* boxes, uint32_t count,
+                                uint32_t* visible) {
+    cull_planes planes;
+    prepare_planes(frustum, &planes);
+
+    uint32_t visible_count = 0;
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 cx = _mm256_loadu_ps(boxes->center_x + i);
+        __m256 cy = _mm256_loadu_ps(boxes->center_y + i);
+        __m256 cz = _mm256_loadu_ps(boxes->center_z + i);
+        __m256 ex = _mm256_loadu_ps(boxes->extent_x + i);
+        __m256 ey = _mm256_loadu_ps(boxes->extent_y + i);
+        __m256 ez = _mm256_loadu_ps(boxes->extent_z + i);
+
+        int mask = 0xFF;
+        for (int p = 0; p < 6 && mask; p++) {
+            __m256 distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.nx[p]), cx, _mm256_set1_ps(planes.d[p]));
+            distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.ny[p]), cy, distance);
+            distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.nz[p]), cz, distance);
+            distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.ax[p]), ex, distance);
+            distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.ay[p]), ey, distance);
+            distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.az[p]), ez, distance);
+            mask &= _mm256_movemask_ps(_mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+        visible_count = append_visible(visible, visible_count, i, (uint32_t)mask);
+    }
+    for (; i < count; i++) {
+        if (aabb_visible(&planes, boxes, i)) {
+            visible[visible_count++] = i;
+        }
+    }
+    return visible_count;
+}
+
+SIMD_TARGET("avx2,fma")
+static uint32_t cull_spheres_avx2(const ve_frustum* frustum, const ve_sphere_soa* spheres, uint32_t count,
+                                  uint32_t* visible) {
+    cull_planes planes;
+    prepare_planes(frustum, &planes);
+
+    uint32_t visible_count = 0;
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 cx = _mm256_loadu_ps(spheres->center_x + i);
+        __m256 cy = _mm256_loadu_ps(spheres->center_y + i);
+        __m256 cz = _mm256_loadu_ps(spheres->center_z + i);
+        __m256 r = _mm256_loadu_ps(spheres->radius + i);
+
+        int mask = 0xFF;
+        for (int p = 0; p < 6 && mask; p++) {
+            __m256 distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.nx[p]), cx, _mm256_set1_ps(planes.d[p]));
+            distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.ny[p]), cy, distance);
+            distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.nz[p]), cz, distance);
+            mask &= _mm256_movemask_ps(_mm256_cmp_ps(_mm256_add_ps(distance, r), _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+        visible_count = append_visible(visible, visible_count, i, (uint32_t)mask);
+    }
+    for (; i < count; i++) {
+        if (sphere_visible(&planes, spheres, i)) {
+            visible[visible_count++] = i;
+        }
+    }
+    return visible_count;
+}
+
+/* ------------------------------------------------------------------------ */
+/* AVX-512F                                                                 */
+/* ------------------------------------------------------------------------ */
+
+SIMD_TARGET("avx512f")
+static void mat4_mul_avx512(ve_mat4* out, const ve_mat4* a, const ve_mat4* b, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        /* Every column of the product in one register */
+        __m512 a0 = _mm512_broadcast_f32x4(_mm_loadu_ps(&a[i].m[0]));
+        __m512 a1 = _mm512_broadcast_f32x4(_mm_loadu_ps(&a[i].m[4]));
+        __m512 a2 = _mm512_broadcast_f32x4(_mm_loadu_ps(&a[i].m[8]));
+        __m512 a3 = _mm512_broadcast_f32x4(_mm_loadu_ps(&a[i].m[12]));
+        __m512 bm = _mm512_loadu_ps(b[i].m);
+
+        __m512 r = _mm512_mul_ps(a0, _mm512_permute_ps(bm, 0x00));
+        r = _mm512_fmadd_ps(a1, _mm512_permute_ps(bm, 0x55), r);
+        r = _mm512_fmadd_ps(a2, _mm512_permute_ps(bm, 0xAA), r);
+        r = _mm512_fmadd_ps(a3, _mm512_permute_ps(bm, 0xFF), r);
+        _mm512_storeu_ps(out[i].m, r);
+    }
+}
+
+SIMD_TARGET("avx512f")
+static void transform_points_avx512(const ve_mat4* m, const float* x, const float* y, const float* z, float* out_x,
+                                    float* out_y, float* out_z, uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512 px = _mm512_loadu_ps(x + i), py = _mm512_loadu_ps(y + i), pz = _mm512_loadu_ps(z + i);
+        for (int row = 0; row < 3; row++) {
+            __m512 sum = _mm512_fmadd_ps(_mm512_set1_ps(m->m[row]), px, _mm512_set1_ps(m->m[12 + row]));
+            sum = _mm512_fmadd_ps(_mm512_set1_ps(m->m[4 + row]), py, sum);
+            sum = _mm512_fmadd_ps(_mm512_set1_ps(m->m[8 + row]), pz, sum);
+            _mm512_storeu_ps((row == 0 ? out_x : row == 1 ? out_y : out_z) + i, sum);
+        }
+    }
+    for (; i < count; i++) {
+        transform_point_scalar(m, x, y, z, out_x, out_y, out_z, i);
+    }
+}
+
+SIMD_TARGET("avx512f")
+static uint32_t cull_aabbs_avx512(const ve_frustum* frustum, const ve_aabb_soa* boxes, uint32_t count,
+                                  uint32_t* visible) {
+    cull_planes planes;
+    prepare_planes(frustum, &planes);
+
+    const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    uint32_t visible_count = 0;
+    uint32_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512 cx = _mm512_loadu_ps(boxes->center_x + i);
+        __m512 cy = _mm512_loadu_ps(boxes->center_y + i);
+        __m512 cz = _mm512_loadu_ps(boxes->center_z + i);
+        __m512 ex = _mm512_loadu_ps(boxes->extent_x + i);
+        __m512 ey = _mm512_loadu_ps(boxes->extent_y + i);
+        __m512 ez = _mm512_loadu_ps(boxes->extent_z + i);
+
+        __mmask16 mask = 0xFFFF;
+        for (int p = 0; p < 6 && mask; p++) {
+            __m512 distance = _mm512_fmadd_ps(_mm512_set1_ps(planes.nx[p]), cx, _mm512_set1_ps(planes.d[p]));
+            distance = _mm512_fmadd_ps(_mm512_set1_ps(planes.ny[p]), cy, distance);
+            distance = _mm512_fmadd_ps(_mm512_set1_ps(planes.nz[p]), cz, distance);
+            distance = _mm512_fmadd_ps(_mm512_set1_ps(planes.ax[p]), ex, distance);
+            distance = _mm512_fmadd_ps(_mm512_set1_ps(planes.ay[p]), ey, distance);
+            distance = _mm512_fmadd_ps(_mm512_set1_ps(planes.az[p]), ez, distance);
+            mask = _mm512_mask_cmp_ps_mask(mask, distance, _mm512_setzero_ps(), _CMP_GE_OQ);
+        }
+
+        /* Compress the visible lane indices straight into the output */
+        __m512i indices = _mm512_add_epi32(_mm512_set1_epi32((int)i), lanes);
+        _mm512_mask_compressstoreu_epi32(visible + visible_count, mask, indices);
+        for (uint32_t bits = mask; bits; bits &= bits - 1) {
+            visible_count++;
+        }
+    }
+    for (; i < count; i++) {
+        if (aabb_visible(&planes, boxes, i)) {
+            visible[visible_count++] = i;
+        }
+    }
+    return visible_count;
+}
+
+SIMD_TARGET("avx512f")
+static uint32_t cull_spheres_avx512(const ve_frustum* frustum, const ve_sphere_soa* spheres, uint32_t count,
+                                    uint32_t* visible) {
+    cull_planes planes;
+    prepare_planes(frustum, &planes);
+
+    const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    uint32_t visible_count = 0;
+    uint32_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512 cx = _mm512_loadu_ps(spheres->center_x + i);
+        __m512 cy = _mm512_loadu_ps(spheres->center_y + i);
+        __m512 cz = _mm512_loadu_ps(spheres->center_z + i);
+        __m512 r = _mm512_loadu_ps(spheres->radius + i);
+
+        __mmask16 mask = 0xFFFF;
+        for (int p = 0; p < 6 && mask; p++) {
+            __m512 distance = _mm512_fmadd_ps(_mm512_set1_ps(planes.nx[p]), cx, _mm512_set1_ps(planes.d[p]));
+            distance = _mm512_fmadd_ps(_mm512_set1_ps(planes.ny[p]), cy, distance);
+            distance = _mm512_fmadd_ps(_mm512_set1_ps(planes.nz[p]), cz, distance);
+            mask = _mm512_mask_cmp_ps_mask(mask, _mm512_add_ps(distance, r), _mm512_setzero_ps(), _CMP_GE_OQ);
+        }
+
+        __m512i indices = _mm512_add_epi32(_mm512_set1_epi32((int)i), lanes);
+        _mm512_mask_compressstoreu_epi32(visible + visible_count, mask, indices);
+        for (uint32_t bits = mask; bits; bits &= bits - 1) {
+            visible_count++;
+        }
+    }
+    for (; i < count; i++) {
+        if (sphere_visible(&planes, spheres, i)) {
+            visible[visible_count++] = i;
+        }
+    }
+    return visible_count;
+}
+
+#endif /* SIMD_X86 */
+
+#ifdef SIMD_NEON
+
+/* ------------------------------------------------------------------------ */
+/* NEON                                                                     */
+/* ------------------------------------------------------------------------ */
+
+static uint32_t neon_lane_mask(uint32x4_t lanes) {
+    const uint32_t bits[4] = {1, 2, 4, 8};
+    return vaddvq_u32(vandq_u32(lanes, vld1q_u32(bits)));
+}
+
+static void mat4_mul_neon(ve_mat4* out, const ve_mat4* a, const ve_mat4* b, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        float32x4_t a0 = vld1q_f32(&a[i].m[0]);
+        float32x4_t a1 = vld1q_f32(&a[i].m[4]);
+        float32x4_t a2 = vld1q_f32(&a[i].m[8]);
+        float32x4_t a3 = vld1q_f32(&a[i].m[12]);
+
+        float32x4_t r[4];
+        for (int c = 0; c < 4; c++) {
+            float32x4_t bc = vld1q_f32(&b[i].m[c * 4]);
+            float32x4_t sum = vmulq_laneq_f32(a0, bc, 0);
+            sum = vfmaq_laneq_f32(sum, a1, bc, 1);
+            sum = vfmaq_laneq_f32(sum, a2, bc, 2);
+            r[c] = vfmaq_laneq_f32(sum, a3, bc, 3);
+        }
+        for (int c = 0; c < 4; c++) {
+            vst1q_f32(&out[i].m[c * 4], r[c]);
+        }
+    }
+}
+
+static void transform_points_neon(const ve_mat4* m, const float* x, const float* y, const float* z, float* out_x,
+                                  float* out_y, float* out_z, uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t px = vld1q_f32(x + i), py = vld1q_f32(y + i), pz = vld1q_f32(z + i);
+        for (int row = 0; row < 3; row++) {
+            float32x4_t sum = vfmaq_n_f32(vdupq_n_f32(m->m[12 + row]), px, m->m[row]);
+            sum = vfmaq_n_f32(sum, py, m->m[4 + row]);
+            sum = vfmaq_n_f32(sum, pz, m->m[8 + row]);
+            vst1q_f32((row == 0 ? out_x : row == 1 ? out_y : out_z) + i, sum);
+        }
+    }
+    for (; i < count; i++) {
+        transform_point_scalar(m, x, y, z, out_x, out_y, out_z, i);
+    }
+}
+
+static uint32_t cull_aabbs_neon(const ve_frustum* frustum, const ve_aabb_soa* boxes, uint32_t count,
+                                uint32_t* visible) {
+    cull_planes planes;
+    prepare_planes(frustum, &planes);
+
+    uint32_t visible_count = 0;
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t cx = vld1q_f32(boxes->center_x + i);
+        float32x4_t cy = vld1q_f32(boxes->center_y + i);
+        float32x4_t cz = vld1q_f32(boxes->center_z + i);
+        float32x4_t ex = vld1q_f32(boxes->extent_x + i);
+        float32x4_t ey = vld1q_f32(boxes->extent_y + i);
+        float32x4_t ez = vld1q_f32(boxes->extent_z + i);
+
+        uint32_t mask = 0xF;
+        for (int p = 0; p < 6 && mask; p++) {
+            float32x4_t distance = vfmaq_n_f32(vdupq_n_f32(planes.d[p]), cx, planes.nx[p]);
+            distance = vfmaq_n_f32(distance, cy, planes.ny[p]);
+            distance = vfmaq_n_f32(distance, cz, planes.nz[p]);
+            distance = vfmaq_n_f32(distance, ex, planes.ax[p]);
+            distance = vfmaq_n_f32(distance, ey, planes.ay[p]);
+            distance = vfmaq_n_f32(distance, ez, planes.az[p]);
+            mask &= neon_lane_mask(vcgeq_f32(distance, vdupq_n_f32(0.0f)));
+        }
+        visible_count = append_visible(visible, visible_count, i, mask);
+    }
+    for (; i < count; i++) {
+        if (aabb_visible(&planes, boxes, i)) {
+            visible[visible_count++] = i;
+        }
+    }
+    return visible_count;
+}
+
+static uint32_t cull_spheres_neon(const ve_frustum* frustum, const ve_sphere_soa* spheres, uint32_t count,
+                                  uint32_t* visible) {
+    cull_planes planes;
+    prepare_planes(frustum, &planes);
+
+    uint32_t visible_count = 0;
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t cx = vld1q_f32(spheres->center_x + i);
+        float32x4_t cy = vld1q_f32(spheres->center_y + i);
+        float32x4_t cz = vld1q_f32(spheres->center_z + i);
+        float32x4_t r = vld1q_f32(spheres->radius + i);
+
+        uint32_t mask = 0xF;
+        for (int p = 0; p < 6 && mask; p++) {
+            float32x4_t distance = vfmaq_n_f32(vaddq_f32(vdupq_n_f32(planes.d[p]), r), cx, planes.nx[p]);
+            distance = vfmaq_n_f32(distance, cy, planes.ny[p]);
+            distance = vfmaq_n_f32(distance, cz, planes.nz[p]);
+            mask &= neon_lane_mask(vcgeq_f32(distance, vdupq_n_f32(0.0f)));
+        }
+        visible_count = append_visible(visible, visible_count, i, mask);
+    }
+    for (; i < count; i++) {
+        if (sphere_visible(&planes, spheres, i)) {
+            visible[visible_count++] = i;
+        }
+    }
+    return visible_count;
+}
+
+#endif /* SIMD_NEON */
+
+/* ------------------------------------------------------------------------ */
+/* Dispatch                                                                 */
+/* ------------------------------------------------------------------------ */
+
+/* Indexed by ve_simd_level; levels this build cannot run stay NULL */
+static const simd_kernels g_kernels[VE_SIMD_LEVEL_COUNT] = {
+    [VE_SIMD_SCALAR] = {mat4_mul_scalar, transform_points_scalar, cull_aabbs_scalar, cull_spheres_scalar},
+#ifdef SIMD_X86
+    [VE_SIMD_SSE] = {mat4_mul_sse, transform_points_sse, cull_aabbs_sse, cull_spheres_sse},
+    [VE_SIMD_AVX2] = {mat4_mul_avx2, transform_points_avx2, cull_aabbs_avx2, cull_spheres_avx2},
+    [VE_SIMD_AVX512] = {mat4_mul_avx512, transform_points_avx512, cull_aabbs_avx512, cull_spheres_avx512},
+#endif
+#ifdef SIMD_NEON
+    [VE_SIMD_NEON] = {mat4_mul_neon, transform_points_neon, cull_aabbs_neon, cull_spheres_neon},
+#endif
+};
+
+static struct {
+    ve_simd_level level;
+    const simd_kernels* kernels;
+} g_simd = {VE_SIMD_SCALAR, &g_kernels[VE_SIMD_SCALAR]};
+
+bool ve_simd_is_supported(ve_simd_level level) {
+    if ((int)level < 0 || level >= VE_SIMD_LEVEL_COUNT || !g_kernels[level].mat4_mul) {
+        return false;
+    }
+
+    const ve_cpu_features* features = ve_get_cpu_features();
+    switch (level) {
+    case VE_SIMD_SSE:
+        return features->sse2;
+    case VE_SIMD_AVX2:
+        return features->avx2 && features->fma;
+    case VE_SIMD_AVX512:
+        return features->avx512f;
+    default:
+        /* Scalar always works and NEON is part of every ARM64 CPU */
+        return true;
+    }
+}
+
+ve_simd_level ve_simd_init(void) {
+    static const ve_simd_level preference[] = {
+        VE_SIMD_AVX512, VE_SIMD_AVX2, VE_SIMD_NEON, VE_SIMD_SSE, VE_SIMD_SCALAR,
+    };
+
+    for (uint32_t i = 0; i < sizeof(preference) / sizeof(preference[0]); i++) {
+        if (ve_simd_set_level(preference[i])) {
+            break;
+        }
+    }
+    VE_LOG_INFO("SIMD kernels: %s", ve_simd_level_name(g_simd.level));
+    return g_simd.level;
+}
+
+bool ve_simd_set_level(ve_simd_level level) {
+    if (!ve_simd_is_supported(level)) {
+        return false;
+    }
+    g_simd.level = level;
+    g_simd.kernels = &g_kernels[level];
+    return true;
+}
+
+ve_simd_level ve_simd_get_level(void) {
+    return g_simd.level;
+}
+
+const char* ve_simd_level_name(ve_simd_level level) {
+    switch (level) {
+    case VE_SIMD_SCALAR:
+        return "scalar";
+    case VE_SIMD_SSE:
+        return "SSE2";
+    case VE_SIMD_AVX2:
+        return "AVX2";
+    case VE_SIMD_AVX512:
+        return "AVX-512";
+    case VE_SIMD_NEON:
+        return "NEON";
+    default:
+        return "unknown";
+    }
+}
+
+void ve_mat4_mul_batch(ve_mat4* out, const ve_mat4* a, const ve_mat4* b, uint32_t count) {
+    VE_ASSERT(count == 0 || (out && a && b));
+    g_simd.kernels->mat4_mul(out, a, b, count);
+}
+
+void ve_transform_points_soa(const ve_mat4* m, const float* x, const float* y, const float* z, float* out_x,
+                             float* out_y, float* out_z, uint32_t count) {
+    VE_ASSERT(m);
+    g_simd.kernels->transform_points(m, x, y, z, out_x, out_y, out_z, count);
+}
+
+uint32_t ve_frustum_cull_aabbs(const ve_frustum* frustum, const ve_aabb_soa* boxes, uint32_t count,
+                               uint32_t* visible) {
+    VE_ASSERT(frustum && boxes);
+    return g_simd.kernels->cull_aabbs(frustum, boxes, count, visible);
+}
+
+uint32_t ve_frustum_cull_spheres(const ve_frustum* frustum, const ve_sphere_soa* spheres, uint32_t count,
+                                 uint32_t* visible) {
+    VE_ASSERT(frustum && spheres);
+    return g_simd.kernels->cull_spheres(frustum, spheres, count, visible);
+}
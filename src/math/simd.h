@@ -0,0 +1,156 @@
+/**
+ * @file simd.h
+ * @brief Batched math kernels with runtime instruction set dispatch
+ *
+ * Transform propagation and culling run the same few operations over
+ * thousands of elements, so they are written once per instruction set and
+ * ve_simd_init picks the widest one the CPU and OS support. Inputs are
+ * structure of arrays where lanes map to elements, so one vector
+ * instruction processes 4, 8 or 16 elements.
+ *
+ * Until ve_simd_init runs, every kernel uses the scalar version. The
+ * kernels give the same results at every level up to floating-point
+ * rounding, since the wider levels use fused multiply-add.
+ */
+
+#ifndef VE_SIMD_H
+#define VE_SIMD_H
+
+#include "vmath.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Kernel implementations, narrowest first
+ */
+typedef enum ve_simd_level {
+    VE_SIMD_SCALAR = 0,
+    VE_SIMD_SSE,                /* SSE2, 4 lanes */
+    VE_SIMD_AVX2,               /* AVX2 and FMA, 8 lanes */
+    VE_SIMD_AVX512,             /* AVX-512F, 16 lanes */
+    VE_SIMD_NEON,               /* NEON, 4 lanes */
+    VE_SIMD_LEVEL_COUNT
+} ve_simd_level;
+
+/**
+ * @brief Boxes as separate center and half-extent arrays
+ */
+typedef struct ve_aabb_soa {
+    const float* center_x;
+    const float* center_y;
+    const float* center_z;
+    const float* extent_x;
+    const float* extent_y;
+    const float* extent_z;
+} ve_aabb_soa;
+
+/**
+ * @brief Spheres as separate center and radius arrays
+ */
+typedef struct ve_sphere_soa {
+    const float* center_x;
+    const float* center_y;
+    const float* center_z;
+    const float* radius;
+} ve_sphere_soa;
+
+/**
+ * @brief Select the widest supported kernels
+ *
+ * Uses ve_get_cpu_features, so call it after ve_platform_init.
+ *
+ * @return Selected level
+ */
+ve_simd_level ve_simd_init(void);
+
+/**
+ * @brief Check if a level can run on this CPU and build
+ *
+ * @param level Level
+ * @return true if supported
+ */
+bool ve_simd_is_supported(ve_simd_level level);
+
+/**
+ * @brief Force a level, for benchmarks and tests
+ *
+ * @param level Supported level
+ * @return false if the level is not supported, leaving the current one
+ */
+bool ve_simd_set_level(ve_simd_level level);
+
+/**
+ * @brief Get the level in use
+ *
+ * @return Current level
+ */
+ve_simd_level ve_simd_get_level(void);
+
+/**
+ * @brief Get the name of a level
+ *
+ * @param level Level
+ * @return Name for logging
+ */
+const char* ve_simd_level_name(ve_simd_level level);
+
+/**
+ * @brief Multiply matrices pairwise: out[i] = a[i] * b[i]
+ *
+ * out may be a or b.
+ *
+ * @param out Products
+ * @param a Left matrices, typically parent world transforms
+ * @param b Right matrices, typically local transforms
+ * @param count Number of products
+ */
+void ve_mat4_mul_batch(ve_mat4* out, const ve_mat4* a, const ve_mat4* b, uint32_t count);
+
+/**
+ * @brief Transform points by one affine matrix
+ *
+ * The output arrays may be the input arrays.
+ *
+ * @param m Matrix, its projective row is ignored
+ * @param x,y,z Input coordinates
+ * @param out_x,out_y,out_z Output coordinates
+ * @param count Number of points
+ */
+void ve_transform_points_soa(const ve_mat4* m, const float* x, const float* y, const float* z, float* out_x,
+                             float* out_y, float* out_z, uint32_t count);
+
+/**
+ * @brief Find the boxes that intersect a frustum
+ *
+ * Conservative: boxes near a frustum corner may pass without touching it.
+ *
+ * @param frustum Frustum in the boxes' space
+ * @param boxes Boxes
+ * @param count Number of boxes
+ * @param visible Receives the indices of the visible boxes, in order; room for count
+ * @return Number of visible boxes
+ */
+uint32_t ve_frustum_cull_aabbs(const ve_frustum* frustum, const ve_aabb_soa* boxes, uint32_t count,
+                               uint32_t* visible);
+
+/**
+ * @brief Find the spheres that intersect a frustum
+ *
+ * @param frustum Frustum in the spheres' space
+ * @param spheres Spheres
+ * @param count Number of spheres
+ * @param visible Receives the indices of the visible spheres, in order; room for count
+ * @return Number of visible spheres
+ */
+uint32_t ve_frustum_cull_spheres(const ve_frustum* frustum, const ve_sphere_soa* spheres, uint32_t count,
+                                 uint32_t* visible);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_SIMD_H */
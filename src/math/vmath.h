@@ -0,0 +1,322 @@
+/**
+ * @file vmath.h
+ * @brief Vector, quaternion and matrix types
+ *
+ * Single-value operations are inline here; the batched kernels that the
+ * hot loops use live in simd.h. Matrices are column-major, m[column * 4 +
+ * row], so they upload to GLSL mat4 as is. Projections follow Vulkan:
+ * right-handed view space looking down -Z, clip space Y pointing down and
+ * depth from 0 to 1.
+ */
+
+#ifndef VE_VMATH_H
+#define VE_VMATH_H
+
+#include "../platform/platform.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VE_PI 3.14159265358979323846f
+
+typedef struct ve_vec3 {
+    float x, y, z;
+} ve_vec3;
+
+typedef struct ve_vec4 {
+    float x, y, z, w;
+} ve_vec4;
+
+/**
+ * @brief Rotation quaternion, w is the scalar part
+ */
+typedef struct ve_quat {
+    float x, y, z, w;
+} ve_quat;
+
+/**
+ * @brief Column-major 4x4 matrix
+ */
+typedef struct VE_ALIGN(16) ve_mat4 {
+    float m[16];
+} ve_mat4;
+
+/**
+ * @brief View volume as six inward-facing planes
+ *
+ * Each plane is (normal, distance) with dot(normal, p) + distance >= 0 on
+ * the inside; the normals are unit length. Order: clip-space -X, +X, -Y,
+ * +Y, near, far.
+ */
+typedef struct ve_frustum {
+    ve_vec4 planes[6];
+} ve_frustum;
+
+/**
+ * @brief Axis-aligned box as min and max corners
+ */
+typedef struct ve_aabb {
+    ve_vec3 min;
+    ve_vec3 max;
+} ve_aabb;
+
+static inline ve_vec3 ve_vec3_make(float x, float y, float z) {
+    ve_vec3 v = {x, y, z};
+    return v;
+}
+
+static inline ve_vec3 ve_vec3_add(ve_vec3 a, ve_vec3 b) {
+    return ve_vec3_make(a.x + b.x, a.y + b.y, a.z + b.z);
+}
+
+static inline ve_vec3 ve_vec3_sub(ve_vec3 a, ve_vec3 b) {
+    return ve_vec3_make(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+static inline ve_vec3 ve_vec3_scale(ve_vec3 v, float s) {
+    return ve_vec3_make(v.x * s, v.y * s, v.z * s);
+}
+
+static inline float ve_vec3_dot(ve_vec3 a, ve_vec3 b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static inline ve_vec3 ve_vec3_cross(ve_vec3 a, ve_vec3 b) {
+    return ve_vec3_make(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+static inline float ve_vec3_length(ve_vec3 v) {
+    return sqrtf(ve_vec3_dot(v, v));
+}
+
+/**
+ * @brief Unit vector in the direction of v, or zero for a zero vector
+ */
+static inline ve_vec3 ve_vec3_normalize(ve_vec3 v) {
+    float length = ve_vec3_length(v);
+    return length > 0.0f ? ve_vec3_scale(v, 1.0f / length) : v;
+}
+
+static inline ve_quat ve_quat_identity(void) {
+    ve_quat q = {0.0f, 0.0f, 0.0f, 1.0f};
+    return q;
+}
+
+/**
+ * @brief Rotation of angle radians around a unit axis
+ */
+static inline ve_quat ve_quat_from_axis_angle(ve_vec3 axis, float angle) {
+    float s = sinf(angle * 0.5f);
+    ve_quat q = {axis.x * s, axis.y * s, axis.z * s, cosf(angle * 0.5f)};
+    return q;
+}
+
+/**
+ * @brief Rotation b followed by rotation a
+ */
+static inline ve_quat ve_quat_mul(ve_quat a, ve_quat b) {
+    ve_quat q = {
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+    };
+    return q;
+}
+
+static inline ve_quat ve_quat_normalize(ve_quat q) {
+    float length = sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    if (length <= 0.0f) {
+        return ve_quat_identity();
+    }
+    float inv = 1.0f / length;
+    ve_quat r = {q.x * inv, q.y * inv, q.z * inv, q.w * inv};
+    return r;
+}
+
+/**
+ * @brief Rotate a vector by a unit quaternion
+ */
+static inline ve_vec3 ve_quat_rotate(ve_quat q, ve_vec3 v) {
+    ve_vec3 u = ve_vec3_make(q.x, q.y, q.z);
+    ve_vec3 t = ve_vec3_scale(ve_vec3_cross(u, v), 2.0f);
+    return ve_vec3_add(ve_vec3_add(v, ve_vec3_scale(t, q.w)), ve_vec3_cross(u, t));
+}
+
+static inline ve_mat4 ve_mat4_identity(void) {
+    ve_mat4 r = {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}};
+    return r;
+}
+
+/**
+ * @brief Matrix product a * b, which applies b first
+ *
+ * For many products use ve_mat4_mul_batch.
+ */
+static inline ve_mat4 ve_mat4_mul(const ve_mat4* a, const ve_mat4* b) {
+    ve_mat4 r;
+    for (int c = 0; c < 4; c++) {
+        for (int row = 0; row < 4; row++) {
+            r.m[c * 4 + row] = a->m[0 * 4 + row] * b->m[c * 4 + 0] + a->m[1 * 4 + row] * b->m[c * 4 + 1] +
+                               a->m[2 * 4 + row] * b->m[c * 4 + 2] + a->m[3 * 4 + row] * b->m[c * 4 + 3];
+        }
+    }
+    return r;
+}
+
+/**
+ * @brief Transform a point, ignoring the projective row
+ */
+static inline ve_vec3 ve_mat4_transform_point(const ve_mat4* m, ve_vec3 p) {
+    return ve_vec3_make(m->m[0] * p.x + m->m[4] * p.y + m->m[8] * p.z + m->m[12],
+                        m->m[1] * p.x + m->m[5] * p.y + m->m[9] * p.z + m->m[13],
+                        m->m[2] * p.x + m->m[6] * p.y + m->m[10] * p.z + m->m[14]);
+}
+
+/**
+ * @brief Translation * rotation * scale
+ *
+ * @param position Translation
+ * @param rotation Unit quaternion
+ * @param scale Per-axis scale
+ */
+static inline ve_mat4 ve_mat4_from_trs(ve_vec3 position, ve_quat rotation, ve_vec3 scale) {
+    float x = rotation.x, y = rotation.y, z = rotation.z, w = rotation.w;
+    ve_mat4 r = {{
+        (1.0f - 2.0f * (y * y + z * z)) * scale.x,
+        (2.0f * (x * y + z * w)) * scale.x,
+        (2.0f * (x * z - y * w)) * scale.x,
+        0.0f,
+        (2.0f * (x * y - z * w)) * scale.y,
+        (1.0f - 2.0f * (x * x + z * z)) * scale.y,
+        (2.0f * (y * z + x * w)) * scale.y,
+        0.0f,
+        (2.0f * (x * z + y * w)) * scale.z,
+        (2.0f * (y * z - x * w)) * scale.z,
+        (1.0f - 2.0f * (x * x + y * y)) * scale.z,
+        0.0f,
+        position.x,
+        position.y,
+        position.z,
+        1.0f,
+    }};
+    return r;
+}
+
+/**
+ * @brief Perspective projection
+ *
+ * @param fov_y Vertical field of view in radians
+ * @param aspect Width over height
+ * @param z_near Near plane distance, maps to depth 0
+ * @param z_far Far plane distance, maps to depth 1
+ */
+static inline ve_mat4 ve_mat4_perspective(float fov_y, float aspect, float z_near, float z_far) {
+    float f = 1.0f / tanf(fov_y * 0.5f);
+    ve_mat4 r = {{0}};
+    r.m[0] = f / aspect;
+    r.m[5] = -f;
+    r.m[10] = z_far / (z_near - z_far);
+    r.m[11] = -1.0f;
+    r.m[14] = z_near * z_far / (z_near - z_far);
+    return r;
+}
+
+/**
+ * @brief View matrix of a camera at eye looking at target
+ */
+static inline ve_mat4 ve_mat4_look_at(ve_vec3 eye, ve_vec3 target, ve_vec3 up) {
+    ve_vec3 f = ve_vec3_normalize(ve_vec3_sub(target, eye));
+    ve_vec3 s = ve_vec3_normalize(ve_vec3_cross(f, up));
+    ve_vec3 u = ve_vec3_cross(s, f);
+    ve_mat4 r = {{
+        s.x, u.x, -f.x, 0.0f,
+        s.y, u.y, -f.y, 0.0f,
+        s.z, u.z, -f.z, 0.0f,
+        -ve_vec3_dot(s, eye), -ve_vec3_dot(u, eye), ve_vec3_dot(f, eye), 1.0f,
+    }};
+    return r;
+}
+
+/**
+ * @brief Smallest box containing two boxes
+ */
+static inline ve_aabb ve_aabb_union(const ve_aabb* a, const ve_aabb* b) {
+    ve_aabb r = {
+        {fminf(a->min.x, b->min.x), fminf(a->min.y, b->min.y), fminf(a->min.z, b->min.z)},
+        {fmaxf(a->max.x, b->max.x), fmaxf(a->max.y, b->max.y), fmaxf(a->max.z, b->max.z)},
+    };
+    return r;
+}
+
+static inline bool ve_aabb_overlaps(const ve_aabb* a, const ve_aabb* b) {
+    return a->min.x <= b->max.x && a->max.x >= b->min.x && a->min.y <= b->max.y && a->max.y >= b->min.y &&
+           a->min.z <= b->max.z && a->max.z >= b->min.z;
+}
+
+/**
+ * @brief Surface area, the cost weight of the surface area heuristic
+ */
+static inline float ve_aabb_surface_area(const ve_aabb* box) {
+    ve_vec3 d = ve_vec3_sub(box->max, box->min);
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+/**
+ * @brief Box around a transformed box
+ *
+ * Projects the half extents onto the absolute matrix rows, so the result
+ * is tight for rotations and scales.
+ */
+static inline ve_aabb ve_aabb_transform(const ve_mat4* m, const ve_aabb* box) {
+    ve_vec3 center = ve_mat4_transform_point(m, ve_vec3_scale(ve_vec3_add(box->min, box->max), 0.5f));
+    ve_vec3 e = ve_vec3_scale(ve_vec3_sub(box->max, box->min), 0.5f);
+    ve_vec3 extent = ve_vec3_make(fabsf(m->m[0]) * e.x + fabsf(m->m[4]) * e.y + fabsf(m->m[8]) * e.z,
+                                  fabsf(m->m[1]) * e.x + fabsf(m->m[5]) * e.y + fabsf(m->m[9]) * e.z,
+                                  fabsf(m->m[2]) * e.x + fabsf(m->m[6]) * e.y + fabsf(m->m[10]) * e.z);
+    ve_aabb r = {ve_vec3_sub(center, extent), ve_vec3_add(center, extent)};
+    return r;
+}
+
+/**
+ * @brief Extract the frustum planes of a view-projection matrix
+ *
+ * Planes come out in the space the matrix transforms from, so a
+ * view-projection gives world-space planes.
+ *
+ * @param m Projection with Vulkan depth range
+ * @param frustum Output planes
+ */
+static inline void ve_frustum_from_matrix(const ve_mat4* m, ve_frustum* frustum) {
+    for (int i = 0; i < 6; i++) {
+        int row = i < 4 ? i / 2 : 2;
+        float sign = (i & 1) ? -1.0f : 1.0f;
+        /* Depth is 0..1, so the near plane is the z row alone */
+        float w = i == 4 ? 0.0f : 1.0f;
+        ve_vec4 p = {
+            w * m->m[3] + sign * m->m[row],
+            w * m->m[7] + sign * m->m[4 + row],
+            w * m->m[11] + sign * m->m[8 + row],
+            w * m->m[15] + sign * m->m[12 + row],
+        };
+        float length = sqrtf(p.x * p.x + p.y * p.y + p.z * p.z);
+        if (length > 0.0f) {
+            float inv = 1.0f / length;
+            p.x *= inv;
+            p.y *= inv;
+            p.z *= inv;
+            p.w *= inv;
+        }
+        frustum->planes[i] = p;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_VMATH_H */
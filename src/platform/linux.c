@@ -3,11 +3,17 @@
  * @brief Linux-specific platform code
  */
 
+/* pthread and sched affinity are GNU extensions */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
 #include "platform.h"
 
 #if defined(VE_PLATFORM_LINUX)
 
 #include "../core/logger.h"
+#include "../core/thread.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -22,8 +28,21 @@
 #include <fcntl.h>
 #include <dlfcn.h>
 #include <pthread.h>
+#include <sched.h>
 #include <signal.h>
 #include <execinfo.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+
+#if defined(__has_include)
+    #if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+        #include <linux/io_uring.h>
+        #define VE_HAS_IO_URING 1
+    #endif
+#endif
 
 /* Stack trace for debugging */
 void ve_linux_print_stack_trace(void) {
@@ -418,4 +437,620 @@ bool ve_linux_get_thread_name(pthread_t thread, char* buffer, size_t size) {
 #endif
 }
 
+/* Memory-mapped files */
+bool ve_file_map(const char* path, ve_file_access access, ve_file_mapping* mapping) {
+    memset(mapping, 0, sizeof(ve_file_mapping));
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return true;
+    }
+
+    /* The mapping keeps its own reference to the file */
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        VE_LOG_ERROR("Failed to map %s: %s", path, strerror(errno));
+        return false;
+    }
+
+    if (access == VE_FILE_ACCESS_SEQUENTIAL) {
+        madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+    } else if (access == VE_FILE_ACCESS_RANDOM) {
+        madvise(data, (size_t)st.st_size, MADV_RANDOM);
+    }
+
+    mapping->data = data;
+    mapping->size = (size_t)st.st_size;
+    return true;
+}
+
+void ve_file_unmap(ve_file_mapping* mapping) {
+    if (mapping->data) {
+        munmap((void*)mapping->data, mapping->size);
+    }
+    memset(mapping, 0, sizeof(ve_file_mapping));
+}
+
+void ve_file_prefetch(const ve_file_mapping* mapping, size_t offset, size_t size) {
+    if (!mapping->data || offset >= mapping->size) {
+        return;
+    }
+    if (size > mapping->size - offset) {
+        size = mapping->size - offset;
+    }
+
+    /* madvise needs a page-aligned start */
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = offset & ~(page_size - 1);
+    madvise((uint8_t*)mapping->data + start, size + (offset - start), MADV_WILLNEED);
+}
+
+/* Asynchronous file reads */
+struct ve_file {
+    int fd;
+    uint64_t size;
+};
+
+struct ve_io_queue {
+    uint32_t depth;
+    uint32_t pending;               /* Queued or in flight */
+    uint32_t unsubmitted;           /* Queued in the SQ ring, not yet entered */
+    int ring_fd;                    /* -1 when reads run synchronously */
+
+#ifdef VE_HAS_IO_URING
+    void* sq_ring;
+    size_t sq_ring_size;
+    void* cq_ring;
+    size_t cq_ring_size;
+    struct io_uring_sqe* sqes;
+    size_t sqes_size;
+    uint32_t* sq_head;
+    uint32_t* sq_tail;
+    uint32_t* sq_mask;
+    uint32_t* sq_array;
+    uint32_t* cq_head;
+    uint32_t* cq_tail;
+    uint32_t* cq_mask;
+    struct io_uring_cqe* cqes;
+#endif
+
+    /* Synchronous fallback: reads complete at once and wait here */
+    ve_io_completion* completed;
+    uint32_t completed_head;
+};
+
+ve_file* ve_file_open_async(const char* path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    ve_file* file = (ve_file*)malloc(sizeof(ve_file));
+    if (!file || fstat(fd, &st) != 0) {
+        free(file);
+        close(fd);
+        return NULL;
+    }
+    file->fd = fd;
+    file->size = (uint64_t)st.st_size;
+    return file;
+}
+
+void ve_file_close(ve_file* file) {
+    if (file) {
+        close(file->fd);
+        free(file);
+    }
+}
+
+uint64_t ve_file_get_size(const ve_file* file) {
+    return file->size;
+}
+
+#ifdef VE_HAS_IO_URING
+static bool io_uring_init(ve_io_queue* queue, uint32_t depth) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    int fd = (int)syscall(__NR_io_uring_setup, depth, &params);
+    if (fd < 0) {
+        return false;
+    }
+    /* IORING_OP_READ arrived in 5.6, one release before fast poll */
+    if (!(params.features & IORING_FEAT_FAST_POLL)) {
+        close(fd);
+        return false;
+    }
+
+    queue->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    queue->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        if (queue->cq_ring_size > queue->sq_ring_size) {
+            queue->sq_ring_size = queue->cq_ring_size;
+        }
+        queue->cq_ring_size = queue->sq_ring_size;
+    }
+
+    queue->sq_ring = mmap(NULL, queue->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                          IORING_OFF_SQ_RING);
+    queue->cq_ring = single_mmap ? queue->sq_ring :
+                     mmap(NULL, queue->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                          IORING_OFF_CQ_RING);
+    queue->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    queue->sqes = (struct io_uring_sqe*)mmap(NULL, queue->sqes_size, PROT_READ | PROT_WRITE,
+                                             MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (queue->sq_ring == MAP_FAILED || queue->cq_ring == MAP_FAILED || queue->sqes == MAP_FAILED) {
+        if (queue->sqes != MAP_FAILED) {
+            munmap(queue->sqes, queue->sqes_size);
+        }
+        if (!single_mmap && queue->cq_ring != MAP_FAILED) {
+            munmap(queue->cq_ring, queue->cq_ring_size);
+        }
+        if (queue->sq_ring != MAP_FAILED) {
+            munmap(queue->sq_ring, queue->sq_ring_size);
+        }
+        close(fd);
+        return false;
+    }
+
+    uint8_t* sq = (uint8_t*)queue->sq_ring;
+    uint8_t* cq = (uint8_t*)queue->cq_ring;
+    queue->sq_head = (uint32_t*)(sq + params.sq_off.head);
+    queue->sq_tail = (uint32_t*)(sq + params.sq_off.tail);
+    queue->sq_mask = (uint32_t*)(sq + params.sq_off.ring_mask);
+    queue->sq_array = (uint32_t*)(sq + params.sq_off.array);
+    queue->cq_head = (uint32_t*)(cq + params.cq_off.head);
+    queue->cq_tail = (uint32_t*)(cq + params.cq_off.tail);
+    queue->cq_mask = (uint32_t*)(cq + params.cq_off.ring_mask);
+    queue->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    queue->ring_fd = fd;
+    queue->depth = params.sq_entries;
+    return true;
+}
+
+static int io_uring_enter(ve_io_queue* queue, uint32_t to_submit, uint32_t min_complete) {
+    unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    return (int)syscall(__NR_io_uring_enter, queue->ring_fd, to_submit, min_complete, flags, NULL, 0);
+}
+#endif
+
+ve_io_queue* ve_io_queue_create(uint32_t depth) {
+    if (depth == 0) {
+        return NULL;
+    }
+
+    ve_io_queue* queue = (ve_io_queue*)calloc(1, sizeof(ve_io_queue));
+    if (!queue) {
+        return NULL;
+    }
+    queue->ring_fd = -1;
+    queue->depth = depth;
+
+#ifdef VE_HAS_IO_URING
+    if (io_uring_init(queue, depth)) {
+        return queue;
+    }
+#endif
+
+    VE_LOG_WARN("io_uring not available, asynchronous reads run synchronously");
+    queue->completed = (ve_io_completion*)malloc(depth * sizeof(ve_io_completion));
+    if (!queue->completed) {
+        free(queue);
+        return NULL;
+    }
+    return queue;
+}
+
+void ve_io_queue_destroy(ve_io_queue* queue) {
+    if (!queue) {
+        return;
+    }
+
+    ve_io_completion completions[32];
+    while (queue->pending > 0) {
+        ve_io_poll(queue, completions, 32, true);
+    }
+
+#ifdef VE_HAS_IO_URING
+    if (queue->ring_fd >= 0) {
+        munmap(queue->sqes, queue->sqes_size);
+        if (queue->cq_ring != queue->sq_ring) {
+            munmap(queue->cq_ring, queue->cq_ring_size);
+        }
+        munmap(queue->sq_ring, queue->sq_ring_size);
+        close(queue->ring_fd);
+    }
+#endif
+    free(queue->completed);
+    free(queue);
+}
+
+bool ve_io_read(ve_io_queue* queue, ve_file* file, uint64_t offset, void* buffer, size_t size, void* user_data) {
+    if (queue->pending == queue->depth) {
+        return false;
+    }
+    if (size > 0x7FFFF000u) {
+        size = 0x7FFFF000u;
+    }
+
+#ifdef VE_HAS_IO_URING
+    if (queue->ring_fd >= 0) {
+        uint32_t tail = *queue->sq_tail;
+        uint32_t index = tail & *queue->sq_mask;
+        struct io_uring_sqe* sqe = &queue->sqes[index];
+        memset(sqe, 0, sizeof(struct io_uring_sqe));
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = file->fd;
+        sqe->off = offset;
+        sqe->addr = (uint64_t)(uintptr_t)buffer;
+        sqe->len = (uint32_t)size;
+        sqe->user_data = (uint64_t)(uintptr_t)user_data;
+        queue->sq_array[index] = index;
+
+        /* Publish the entry before the kernel can see the new tail */
+        __atomic_store_n(queue->sq_tail, tail + 1, __ATOMIC_RELEASE);
+        queue->unsubmitted++;
+        queue->pending++;
+        return true;
+    }
+#endif
+
+    size_t done = 0;
+    int64_t result = 0;
+    while (done < size) {
+        ssize_t n = pread(file->fd, (uint8_t*)buffer + done, size - done, (off_t)(offset + done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            result = -(int64_t)errno;
+            break;
+        }
+        if (n == 0) {
+            break;
+        }
+        done += (size_t)n;
+    }
+
+    uint32_t slot = (queue->completed_head + queue->pending) % queue->depth;
+    queue->completed[slot].user_data = user_data;
+    queue->completed[slot].result = result < 0 ? result : (int64_t)done;
+    queue->pending++;
+    return true;
+}
+
+uint32_t ve_io_poll(ve_io_queue* queue, ve_io_completion* completions, uint32_t capacity, bool wait) {
+    uint32_t count = 0;
+
+#ifdef VE_HAS_IO_URING
+    if (queue->ring_fd >= 0) {
+        uint32_t head = *queue->cq_head;
+        bool ready = head != __atomic_load_n(queue->cq_tail, __ATOMIC_ACQUIRE);
+        uint32_t min_complete = wait && !ready && queue->pending > 0 ? 1 : 0;
+        if (queue->unsubmitted > 0 || min_complete > 0) {
+            int submitted = io_uring_enter(queue, queue->unsubmitted, min_complete);
+            if (submitted >= 0) {
+                queue->unsubmitted -= (uint32_t)submitted < queue->unsubmitted ? (uint32_t)submitted :
+                                                                                  queue->unsubmitted;
+            } else if (errno != EINTR) {
+                VE_LOG_ERROR("io_uring_enter failed: %s", strerror(errno));
+            }
+        }
+
+        uint32_t tail = __atomic_load_n(queue->cq_tail, __ATOMIC_ACQUIRE);
+        while (head != tail && count < capacity) {
+            const struct io_uring_cqe* cqe = &queue->cqes[head & *queue->cq_mask];
+            completions[count].user_data = (void*)(uintptr_t)cqe->user_data;
+            completions[count].result = cqe->res;
+            count++;
+            head++;
+        }
+        __atomic_store_n(queue->cq_head, head, __ATOMIC_RELEASE);
+        queue->pending -= count;
+        return count;
+    }
+#endif
+
+    (void)wait;
+    while (queue->pending > 0 && count < capacity) {
+        completions[count++] = queue->completed[queue->completed_head];
+        queue->completed_head = (queue->completed_head + 1) % queue->depth;
+        queue->pending--;
+    }
+    return count;
+}
+
+uint32_t ve_io_get_pending(const ve_io_queue* queue) {
+    return queue->pending;
+}
+
+/* CPU topology */
+
+static ve_cpu_topology g_cpu_topology;
+static pthread_once_t g_cpu_topology_once = PTHREAD_ONCE_INIT;
+
+static bool read_sysfs(const char* path, char* buffer, size_t size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    ssize_t length = read(fd, buffer, size - 1);
+    close(fd);
+    if (length <= 0) {
+        return false;
+    }
+    buffer[length] = '\0';
+    return true;
+}
+
+static bool read_sysfs_uint(const char* path, uint32_t* value) {
+    char text[32];
+    if (!read_sysfs(path, text, sizeof(text))) {
+        return false;
+    }
+    *value = (uint32_t)strtoul(text, NULL, 10);
+    return true;
+}
+
+/* Kernel CPU lists look like "0-3,8,10-11" */
+static bool read_cpu_list(const char* path, ve_cpu_set* set) {
+    char text[1024];
+    ve_cpu_set_clear(set);
+    if (!read_sysfs(path, text, sizeof(text))) {
+        return false;
+    }
+
+    const char* at = text;
+    while (*at >= '0' && *at <= '9') {
+        char* end;
+        unsigned long first = strtoul(at, &end, 10);
+        unsigned long last = first;
+        if (*end == '-') {
+            last = strtoul(end + 1, &end, 10);
+        }
+        for (unsigned long cpu = first; cpu <= last && cpu < VE_MAX_CPUS; cpu++) {
+            ve_cpu_set_add(set, (uint32_t)cpu);
+        }
+        at = *end == ',' ? end + 1 : end;
+    }
+    return true;
+}
+
+static void detect_cpu_topology(void) {
+    ve_cpu_topology* topology = &g_cpu_topology;
+    memset(topology, 0, sizeof(ve_cpu_topology));
+
+    if (!read_cpu_list("/sys/devices/system/cpu/online", &topology->online)) {
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+        for (long cpu = 0; cpu < count && cpu < VE_MAX_CPUS; cpu++) {
+            ve_cpu_set_add(&topology->online, (uint32_t)cpu);
+        }
+    }
+
+    cpu_set_t allowed;
+    bool has_allowed = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+    /* Intel hybrid parts list their E-cores here; big.LITTLE parts report a smaller capacity instead */
+    ve_cpu_set atom_cpus;
+    bool has_atom = read_cpu_list("/sys/devices/cpu_atom/cpus", &atom_cpus);
+    uint32_t capacities[VE_MAX_CPUS] = {0};
+    uint32_t max_capacity = 0;
+
+    /* Physical cores are (package, core id) pairs, numbered in CPU order */
+    uint64_t core_keys[VE_MAX_CPUS];
+    uint32_t core_threads[VE_MAX_CPUS] = {0};
+    char path[128];
+    for (uint32_t cpu = 0; cpu < VE_MAX_CPUS; cpu++) {
+        if (!ve_cpu_set_contains(&topology->online, cpu)) {
+            continue;
+        }
+        topology->logical_count++;
+        if (!has_allowed || CPU_ISSET(cpu, &allowed)) {
+            ve_cpu_set_add(&topology->available, cpu);
+        }
+
+        uint32_t package = 0;
+        uint32_t core_id = cpu;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/physical_package_id", cpu);
+        read_sysfs_uint(path, &package);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/core_id", cpu);
+        read_sysfs_uint(path, &core_id);
+
+        uint64_t key = ((uint64_t)package << 32) | core_id;
+        uint32_t core = 0;
+        while (core < topology->core_count && core_keys[core] != key) {
+            core++;
+        }
+        if (core == topology->core_count) {
+            core_keys[topology->core_count++] = key;
+        }
+
+        ve_logical_cpu* logical = &topology->cpus[cpu];
+        logical->core = core;
+        logical->smt_index = core_threads[core]++;
+        logical->type = has_atom && ve_cpu_set_contains(&atom_cpus, cpu) ? VE_CORE_TYPE_EFFICIENCY
+                                                                          : VE_CORE_TYPE_PERFORMANCE;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cpu_capacity", cpu);
+        if (read_sysfs_uint(path, &capacities[cpu]) && capacities[cpu] > max_capacity) {
+            max_capacity = capacities[cpu];
+        }
+    }
+
+    /* Dense node numbers in node order; CPUs of unlisted nodes stay on node 0 */
+    ve_cpu_set nodes;
+    if (read_cpu_list("/sys/devices/system/node/online", &nodes)) {
+        for (uint32_t node = 0; node < VE_MAX_CPUS; node++) {
+            ve_cpu_set node_cpus;
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+            if (!ve_cpu_set_contains(&nodes, node) || !read_cpu_list(path, &node_cpus)) {
+                continue;
+            }
+            for (uint32_t cpu = 0; cpu < VE_MAX_CPUS; cpu++) {
+                if (ve_cpu_set_contains(&node_cpus, cpu) && ve_cpu_set_contains(&topology->online, cpu)) {
+                    topology->cpus[cpu].numa_node = topology->numa_node_count;
+                }
+            }
+            topology->numa_node_count++;
+        }
+    }
+    if (topology->numa_node_count == 0) {
+        topology->numa_node_count = 1;
+    }
+
+    bool counted[VE_MAX_CPUS] = {false};
+    for (uint32_t cpu = 0; cpu < VE_MAX_CPUS; cpu++) {
+        if (!ve_cpu_set_contains(&topology->online, cpu)) {
+            continue;
+        }
+        ve_logical_cpu* logical = &topology->cpus[cpu];
+        if (!has_atom && capacities[cpu] > 0 && capacities[cpu] < max_capacity) {
+            logical->type = VE_CORE_TYPE_EFFICIENCY;
+        }
+        if (logical->type == VE_CORE_TYPE_EFFICIENCY) {
+            topology->hybrid = true;
+        } else if (!counted[logical->core]) {
+            topology->performance_core_count++;
+        }
+        counted[logical->core] = true;
+    }
+}
+
+const ve_cpu_topology* ve_cpu_get_topology(void) {
+    pthread_once(&g_cpu_topology_once, detect_cpu_topology);
+    return &g_cpu_topology;
+}
+
+/* Loopback sockets */
+
+struct ve_socket {
+    int fd;
+};
+
+static ve_socket* wrap_socket(int fd) {
+    ve_socket* socket = (ve_socket*)malloc(sizeof(ve_socket));
+    if (!socket) {
+        close(fd);
+        return NULL;
+    }
+    socket->fd = fd;
+    return socket;
+}
+
+static struct sockaddr_in loopback_address(uint16_t port) {
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    return address;
+}
+
+/* Wait for a socket to become readable; false on timeout or failure */
+static bool wait_readable(int fd, uint32_t timeout_ms) {
+    struct pollfd entry = {.fd = fd, .events = POLLIN};
+    int result;
+    do {
+        result = poll(&entry, 1, (int)timeout_ms);
+    } while (result < 0 && errno == EINTR);
+    return result > 0;
+}
+
+ve_socket* ve_socket_listen(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    struct sockaddr_in address = loopback_address(port);
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 8) != 0) {
+        VE_LOG_ERROR("Failed to listen on port %u: %s", port, strerror(errno));
+        close(fd);
+        return NULL;
+    }
+    return wrap_socket(fd);
+}
+
+ve_socket* ve_socket_connect(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct sockaddr_in address = loopback_address(port);
+    if (connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        close(fd);
+        return NULL;
+    }
+    return wrap_socket(fd);
+}
+
+ve_socket* ve_socket_accept(ve_socket* listener, uint32_t timeout_ms) {
+    if (!wait_readable(listener->fd, timeout_ms)) {
+        return NULL;
+    }
+    int fd = accept4(listener->fd, NULL, NULL, SOCK_CLOEXEC);
+    return fd >= 0 ? wrap_socket(fd) : NULL;
+}
+
+int64_t ve_socket_receive(ve_socket* socket, void* buffer, size_t size, uint32_t timeout_ms) {
+    if (!wait_readable(socket->fd, timeout_ms)) {
+        return 0;
+    }
+    ssize_t result;
+    do {
+        result = recv(socket->fd, buffer, size, 0);
+    } while (result < 0 && errno == EINTR);
+    return result;
+}
+
+bool ve_socket_send(ve_socket* socket, const void* data, size_t size) {
+    const char* at = (const char*)data;
+    while (size > 0) {
+        /* A peer that went away must not raise SIGPIPE */
+        ssize_t sent = send(socket->fd, at, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        at += sent;
+        size -= (size_t)sent;
+    }
+    return true;
+}
+
+uint16_t ve_socket_get_port(const ve_socket* socket) {
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    if (getsockname(socket->fd, (struct sockaddr*)&address, &length) != 0) {
+        return 0;
+    }
+    return ntohs(address.sin_port);
+}
+
+void ve_socket_close(ve_socket* socket) {
+    if (socket) {
+        close(socket->fd);
+        free(socket);
+    }
+}
+
 #endif /* VE_PLATFORM_LINUX */
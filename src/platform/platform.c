@@ -26,6 +26,41 @@
 static ve_cpu_features g_cpu_features = {0};
 static bool g_cpu_features_initialized = false;
 
+#if defined(VE_PLATFORM_WINDOWS) || (defined(VE_PLATFORM_LINUX) && (defined(VE_ARCH_X86) || defined(VE_ARCH_X64)))
+/* XCR0 bits for the SSE, AVX and AVX-512 register state */
+#define XCR0_AVX_STATE 0x06u
+#define XCR0_AVX512_STATE 0xE6u
+
+static uint64_t read_xcr0(void) {
+#ifdef VE_PLATFORM_WINDOWS
+    return _xgetbv(0);
+#else
+    uint32_t lo, hi;
+    __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t)hi << 32) | lo;
+#endif
+}
+
+/**
+ * @brief Drop the AVX features whose registers the OS does not save
+ *
+ * CPUID reports what the CPU implements; code using the wide registers
+ * also needs the OS to preserve them across context switches.
+ */
+static void mask_os_unsupported_features(bool osxsave) {
+    uint64_t xcr0 = osxsave ? read_xcr0() : 0;
+    if ((xcr0 & XCR0_AVX_STATE) != XCR0_AVX_STATE) {
+        g_cpu_features.avx = false;
+        g_cpu_features.avx2 = false;
+        g_cpu_features.fma = false;
+        g_cpu_features.fma4 = false;
+    }
+    if ((xcr0 & XCR0_AVX512_STATE) != XCR0_AVX512_STATE) {
+        g_cpu_features.avx512f = false;
+    }
+}
+#endif
+
 /* CPU feature detection implementation */
 static void detect_cpu_features(void) {
     memset(&g_cpu_features, 0, sizeof(ve_cpu_features));
@@ -37,6 +72,7 @@ static void detect_cpu_features(void) {
     /* Get max leaf */
     __cpuid(regs, 0);
     int max_leaf = regs[0];
+    bool osxsave = false;
 
     /* Vendor ID */
     __cpuid(regs, 0);
@@ -51,6 +87,8 @@ static void detect_cpu_features(void) {
         g_cpu_features.sse4_2 = (regs[2] & (1 << 20)) != 0;
         g_cpu_features.popcnt = (regs[2] & (1 << 23)) != 0;
         g_cpu_features.aes_ni = (regs[2] & (1 << 25)) != 0;
+        osxsave = (regs[2] & (1 << 27)) != 0;
+        g_cpu_features.avx = (regs[2] & (1 << 28)) != 0;
         g_cpu_features.rdtsc = (regs[3] & (1 << 4)) != 0;
 
         g_cpu_features.sse = (regs[3] & (1 << 25)) != 0;
@@ -59,7 +97,7 @@ static void detect_cpu_features(void) {
 
     /* Extended features */
     if (max_leaf >= 7) {
-        __cpuid(regs, 7);
+        __cpuidex(regs, 7, 0);
         g_cpu_features.sgx = (regs[1] & (1 << 2)) != 0;
         g_cpu_features.bmi1 = (regs[1] & (1 << 3)) != 0;
         g_cpu_features.hle = (regs[1] & (1 << 4)) != 0;
@@ -75,6 +113,8 @@ static void detect_cpu_features(void) {
     __cpuid(regs, 1);
     g_cpu_features.hypervisor = (regs[2] & (1 << 31)) != 0;
 
+    mask_os_unsupported_features(osxsave);
+
 #elif defined(VE_PLATFORM_LINUX) && (defined(VE_ARCH_X86) || defined(VE_ARCH_X64))
     /* Linux x86/x64 implementation using CPUID */
     uint32_t eax, ebx, ecx, edx;
@@ -82,6 +122,7 @@ static void detect_cpu_features(void) {
     /* Get max leaf */
     __get_cpuid(0, &eax, &ebx, &ecx, &edx);
     uint32_t max_leaf = eax;
+    bool osxsave = false;
 
     /* Feature flags */
     if (max_leaf >= 1) {
@@ -93,18 +134,22 @@ static void detect_cpu_features(void) {
         g_cpu_features.sse4_2 = (ecx & (1 << 20)) != 0;
         g_cpu_features.popcnt = (ecx & (1 << 23)) != 0;
         g_cpu_features.aes_ni = (ecx & (1 << 25)) != 0;
+        osxsave = (ecx & (1 << 27)) != 0;
+        g_cpu_features.avx = (ecx & (1 << 28)) != 0;
         g_cpu_features.rdtsc = (edx & (1 << 4)) != 0;
         g_cpu_features.sse = (edx & (1 << 25)) != 0;
         g_cpu_features.sse2 = (edx & (1 << 26)) != 0;
     }
 
     if (max_leaf >= 7) {
-        __get_cpuid(7, &eax, &ebx, &ecx, &edx);
+        __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx);
         g_cpu_features.bmi1 = (ebx & (1 << 3)) != 0;
         g_cpu_features.avx2 = (ebx & (1 << 5)) != 0;
         g_cpu_features.bmi2 = (ebx & (1 << 8)) != 0;
         g_cpu_features.avx512f = (ebx & (1 << 16)) != 0;
     }
+
+    mask_os_unsupported_features(osxsave);
 #endif
 
     /* Get CPU count */
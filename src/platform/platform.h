@@ -501,6 +501,222 @@ char* ve_get_clipboard_text(void);
  */
 bool ve_set_clipboard_text(const char* text);
 
+/* Memory-mapped files */
+
+/**
+ * @brief Expected access pattern of a mapping, passed to the OS read-ahead
+ */
+typedef enum ve_file_access {
+    VE_FILE_ACCESS_NORMAL,
+    VE_FILE_ACCESS_SEQUENTIAL,
+    VE_FILE_ACCESS_RANDOM
+} ve_file_access;
+
+/**
+ * @brief Read-only view of a whole file
+ *
+ * Pages are read on first touch, so data can be used in place without a
+ * copy into heap memory.
+ */
+typedef struct ve_file_mapping {
+    const void* data;           /* NULL for empty files */
+    size_t size;
+    void* handle;               /* Platform mapping object */
+} ve_file_mapping;
+
+/**
+ * @brief Map a file read-only
+ *
+ * @param path File path
+ * @param access Access pattern hint
+ * @param mapping Output mapping
+ * @return true on success
+ */
+bool ve_file_map(const char* path, ve_file_access access, ve_file_mapping* mapping);
+
+/**
+ * @brief Unmap a file
+ *
+ * @param mapping Mapping, cleared on return
+ */
+void ve_file_unmap(ve_file_mapping* mapping);
+
+/**
+ * @brief Ask the OS to start reading part of a mapping ahead of use
+ *
+ * @param mapping Mapping
+ * @param offset First byte
+ * @param size Bytes, clamped to the file
+ */
+void ve_file_prefetch(const ve_file_mapping* mapping, size_t offset, size_t size);
+
+/* Asynchronous file reads */
+
+/**
+ * @brief File opened for asynchronous reads
+ */
+typedef struct ve_file ve_file;
+
+/**
+ * @brief Queue of asynchronous reads
+ *
+ * Backed by io_uring on Linux, with a synchronous fallback on kernels
+ * without it, and by overlapped IO on Windows. A queue is used by one
+ * thread at a time.
+ */
+typedef struct ve_io_queue ve_io_queue;
+
+/**
+ * @brief Finished read
+ */
+typedef struct ve_io_completion {
+    void* user_data;
+    int64_t result;             /* Bytes read, or a negative error code */
+} ve_io_completion;
+
+/**
+ * @brief Open a file for asynchronous reads
+ *
+ * @param path File path
+ * @return File, or NULL on failure
+ */
+ve_file* ve_file_open_async(const char* path);
+
+/**
+ * @brief Close a file with no reads in flight
+ *
+ * @param file File
+ */
+void ve_file_close(ve_file* file);
+
+/**
+ * @brief Get the size of a file
+ *
+ * @param file File
+ * @return Size in bytes
+ */
+uint64_t ve_file_get_size(const ve_file* file);
+
+/**
+ * @brief Create a read queue
+ *
+ * @param depth Most reads in flight, rounded up by some backends
+ * @return Queue, or NULL on failure
+ */
+ve_io_queue* ve_io_queue_create(uint32_t depth);
+
+/**
+ * @brief Destroy a queue, waiting for its reads in flight
+ *
+ * @param queue Queue
+ */
+void ve_io_queue_destroy(ve_io_queue* queue);
+
+/**
+ * @brief Queue a read
+ *
+ * Reads are handed to the OS in batches by ve_io_poll. A read may come
+ * back short at the end of the file or for sizes beyond 2 GB.
+ *
+ * @param queue Queue
+ * @param file File
+ * @param offset File offset
+ * @param buffer Destination, valid until the read completes
+ * @param size Bytes to read
+ * @param user_data Reported with the completion
+ * @return false if the queue is full
+ */
+bool ve_io_read(ve_io_queue* queue, ve_file* file, uint64_t offset, void* buffer, size_t size, void* user_data);
+
+/**
+ * @brief Submit queued reads and collect finished ones
+ *
+ * @param queue Queue
+ * @param completions Receives finished reads
+ * @param capacity Room in completions
+ * @param wait Block until at least one read finishes, if any is in flight
+ * @return Number of completions written
+ */
+uint32_t ve_io_poll(ve_io_queue* queue, ve_io_completion* completions, uint32_t capacity, bool wait);
+
+/**
+ * @brief Get the number of reads queued or in flight
+ *
+ * @param queue Queue
+ * @return Pending reads
+ */
+uint32_t ve_io_get_pending(const ve_io_queue* queue);
+
+/* Loopback sockets */
+
+/**
+ * @brief TCP socket bound to the loopback interface
+ *
+ * Only reachable from the local machine; used for diagnostics endpoints.
+ */
+typedef struct ve_socket ve_socket;
+
+/**
+ * @brief Listen for connections on 127.0.0.1
+ *
+ * @param port Port, or 0 for any free port
+ * @return Listening socket, or NULL on failure
+ */
+ve_socket* ve_socket_listen(uint16_t port);
+
+/**
+ * @brief Connect to a port on 127.0.0.1
+ *
+ * @param port Port
+ * @return Connected socket, or NULL on failure
+ */
+ve_socket* ve_socket_connect(uint16_t port);
+
+/**
+ * @brief Wait for a connection on a listening socket
+ *
+ * @param listener Listening socket
+ * @param timeout_ms Longest wait in milliseconds
+ * @return Connected socket, or NULL on timeout or failure
+ */
+ve_socket* ve_socket_accept(ve_socket* listener, uint32_t timeout_ms);
+
+/**
+ * @brief Receive available data
+ *
+ * @param socket Connected socket
+ * @param buffer Destination
+ * @param size Room in buffer
+ * @param timeout_ms Longest wait for data in milliseconds
+ * @return Bytes received, 0 if the peer closed or the wait timed out, negative on failure
+ */
+int64_t ve_socket_receive(ve_socket* socket, void* buffer, size_t size, uint32_t timeout_ms);
+
+/**
+ * @brief Send all of a buffer
+ *
+ * @param socket Connected socket
+ * @param data Data
+ * @param size Bytes to send
+ * @return true if everything was sent
+ */
+bool ve_socket_send(ve_socket* socket, const void* data, size_t size);
+
+/**
+ * @brief Get the local port of a socket
+ *
+ * @param socket Socket
+ * @return Port, e.g. the one picked for ve_socket_listen(0)
+ */
+uint16_t ve_socket_get_port(const ve_socket* socket);
+
+/**
+ * @brief Close a socket
+ *
+ * @param socket Socket, may be NULL
+ */
+void ve_socket_close(ve_socket* socket);
+
 #ifdef __cplusplus
 }
 #endif
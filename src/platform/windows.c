@@ -8,16 +8,23 @@
 #if defined(VE_PLATFORM_WINDOWS)
 
 #include "../core/logger.h"
+#include "../core/thread.h"
 #include <windows.h>
+#include <winsock2.h>
+#include <ws2tcpip.h>
 #include <shlobj.h>
 #include <shlwapi.h>
 #include <dbghelp.h>
 #include <psapi.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
 
 #pragma comment(lib, "shell32.lib")
 #pragma comment(lib, "shlwapi.lib")
 #pragma comment(lib, "dbghelp.lib")
 #pragma comment(lib, "psapi.lib")
+#pragma comment(lib, "ws2_32.lib")
 
 /* Windows error handling */
 char* ve_win32_get_error_string(DWORD error_code) {
@@ -280,4 +287,495 @@ void ve_win32_watchdog_kick(ve_win32_watchdog* watchdog) {
     }
 }
 
+/* Memory-mapped files */
+bool ve_file_map(const char* path, ve_file_access access, ve_file_mapping* mapping) {
+    memset(mapping, 0, sizeof(ve_file_mapping));
+
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if (access == VE_FILE_ACCESS_SEQUENTIAL) {
+        flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+    } else if (access == VE_FILE_ACCESS_RANDOM) {
+        flags |= FILE_FLAG_RANDOM_ACCESS;
+    }
+
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, flags, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return false;
+    }
+    if (size.QuadPart == 0) {
+        CloseHandle(file);
+        return true;
+    }
+
+    /* The view keeps the mapping and the file alive */
+    HANDLE section = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!section) {
+        VE_LOG_ERROR("Failed to map %s: %lu", path, GetLastError());
+        return false;
+    }
+
+    void* data = MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(section);
+    if (!data) {
+        VE_LOG_ERROR("Failed to map a view of %s: %lu", path, GetLastError());
+        return false;
+    }
+
+    mapping->data = data;
+    mapping->size = (size_t)size.QuadPart;
+    return true;
+}
+
+void ve_file_unmap(ve_file_mapping* mapping) {
+    if (mapping->data) {
+        UnmapViewOfFile(mapping->data);
+    }
+    memset(mapping, 0, sizeof(ve_file_mapping));
+}
+
+/* PrefetchVirtualMemory is Windows 8+, so it is looked up at runtime */
+typedef struct ve_win32_memory_range {
+    PVOID address;
+    SIZE_T size;
+} ve_win32_memory_range;
+
+typedef BOOL (WINAPI *ve_win32_prefetch_fn)(HANDLE process, ULONG_PTR count, ve_win32_memory_range* ranges,
+                                            ULONG flags);
+
+void ve_file_prefetch(const ve_file_mapping* mapping, size_t offset, size_t size) {
+    static ve_win32_prefetch_fn prefetch = NULL;
+    static bool resolved = false;
+
+    if (!mapping->data || offset >= mapping->size) {
+        return;
+    }
+    if (!resolved) {
+        prefetch = (ve_win32_prefetch_fn)ve_win32_get_proc_address(GetModuleHandleA("kernel32.dll"),
+                                                                    "PrefetchVirtualMemory");
+        resolved = true;
+    }
+    if (!prefetch) {
+        return;
+    }
+
+    if (size > mapping->size - offset) {
+        size = mapping->size - offset;
+    }
+    ve_win32_memory_range range = {(uint8_t*)mapping->data + offset, size};
+    prefetch(GetCurrentProcess(), 1, &range, 0);
+}
+
+/* Asynchronous file reads */
+struct ve_file {
+    HANDLE handle;
+    uint64_t size;
+};
+
+typedef struct ve_win32_io_slot {
+    OVERLAPPED overlapped;
+    HANDLE file;
+    void* user_data;
+    bool used;
+} ve_win32_io_slot;
+
+struct ve_io_queue {
+    uint32_t depth;
+    uint32_t pending;
+    uint32_t next;                  /* Oldest read in flight */
+    ve_win32_io_slot* slots;
+};
+
+ve_file* ve_file_open_async(const char* path) {
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+
+    LARGE_INTEGER size;
+    ve_file* file = (ve_file*)malloc(sizeof(ve_file));
+    if (!file || !GetFileSizeEx(handle, &size)) {
+        free(file);
+        CloseHandle(handle);
+        return NULL;
+    }
+    file->handle = handle;
+    file->size = (uint64_t)size.QuadPart;
+    return file;
+}
+
+void ve_file_close(ve_file* file) {
+    if (file) {
+        CloseHandle(file->handle);
+        free(file);
+    }
+}
+
+uint64_t ve_file_get_size(const ve_file* file) {
+    return file->size;
+}
+
+ve_io_queue* ve_io_queue_create(uint32_t depth) {
+    if (depth == 0) {
+        return NULL;
+    }
+
+    ve_io_queue* queue = (ve_io_queue*)calloc(1, sizeof(ve_io_queue));
+    if (!queue) {
+        return NULL;
+    }
+    queue->slots = (ve_win32_io_slot*)calloc(depth, sizeof(ve_win32_io_slot));
+    if (!queue->slots) {
+        free(queue);
+        return NULL;
+    }
+    queue->depth = depth;
+
+    for (uint32_t i = 0; i < depth; i++) {
+        queue->slots[i].overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+        if (!queue->slots[i].overlapped.hEvent) {
+            ve_io_queue_destroy(queue);
+            return NULL;
+        }
+    }
+    return queue;
+}
+
+void ve_io_queue_destroy(ve_io_queue* queue) {
+    if (!queue) {
+        return;
+    }
+
+    ve_io_completion completions[32];
+    while (queue->pending > 0) {
+        ve_io_poll(queue, completions, 32, true);
+    }
+
+    for (uint32_t i = 0; i < queue->depth; i++) {
+        if (queue->slots[i].overlapped.hEvent) {
+            CloseHandle(queue->slots[i].overlapped.hEvent);
+        }
+    }
+    free(queue->slots);
+    free(queue);
+}
+
+bool ve_io_read(ve_io_queue* queue, ve_file* file, uint64_t offset, void* buffer, size_t size, void* user_data) {
+    if (queue->pending == queue->depth) {
+        return false;
+    }
+    if (size > 0x7FFFF000u) {
+        size = 0x7FFFF000u;
+    }
+
+    /* Reads are issued in order into a ring, so the slot after the newest is free */
+    ve_win32_io_slot* slot = &queue->slots[(queue->next + queue->pending) % queue->depth];
+    HANDLE event = slot->overlapped.hEvent;
+    memset(&slot->overlapped, 0, sizeof(OVERLAPPED));
+    slot->overlapped.hEvent = event;
+    slot->overlapped.Offset = (DWORD)offset;
+    slot->overlapped.OffsetHigh = (DWORD)(offset >> 32);
+    slot->file = file->handle;
+    slot->user_data = user_data;
+    slot->used = true;
+    ResetEvent(event);
+
+    if (!ReadFile(file->handle, buffer, (DWORD)size, NULL, &slot->overlapped)) {
+        DWORD error = GetLastError();
+        if (error != ERROR_IO_PENDING) {
+            /* Completes at once with the error; overlapped Internal carries it to the poll */
+            slot->overlapped.Internal = (ULONG_PTR)error;
+            slot->file = NULL;
+            SetEvent(event);
+        }
+    }
+    queue->pending++;
+    return true;
+}
+
+uint32_t ve_io_poll(ve_io_queue* queue, ve_io_completion* completions, uint32_t capacity, bool wait) {
+    uint32_t count = 0;
+
+    /* Completions are reported in issue order */
+    while (queue->pending > 0 && count < capacity) {
+        ve_win32_io_slot* slot = &queue->slots[queue->next];
+        bool block = wait && count == 0;
+        if (!block && WaitForSingleObject(slot->overlapped.hEvent, 0) != WAIT_OBJECT_0) {
+            break;
+        }
+
+        int64_t result;
+        if (!slot->file) {
+            result = -(int64_t)slot->overlapped.Internal;
+        } else {
+            DWORD bytes = 0;
+            if (GetOverlappedResult(slot->file, &slot->overlapped, &bytes, TRUE)) {
+                result = (int64_t)bytes;
+            } else {
+                DWORD error = GetLastError();
+                result = error == ERROR_HANDLE_EOF ? 0 : -(int64_t)error;
+            }
+        }
+
+        completions[count].user_data = slot->user_data;
+        completions[count].result = result;
+        count++;
+        slot->used = false;
+        queue->next = (queue->next + 1) % queue->depth;
+        queue->pending--;
+    }
+    return count;
+}
+
+uint32_t ve_io_get_pending(const ve_io_queue* queue) {
+    return queue->pending;
+}
+
+/* CPU topology */
+
+static ve_cpu_topology g_cpu_topology;
+static INIT_ONCE g_cpu_topology_once = INIT_ONCE_STATIC_INIT;
+
+static void add_group_mask(ve_cpu_set* set, const GROUP_AFFINITY* mask) {
+    for (uint32_t bit = 0; bit < 64; bit++) {
+        if (mask->Mask & ((KAFFINITY)1 << bit)) {
+            ve_cpu_set_add(set, (uint32_t)mask->Group * 64 + bit);
+        }
+    }
+}
+
+static BOOL CALLBACK detect_cpu_topology(PINIT_ONCE once, PVOID parameter, PVOID* context) {
+    (void)once;
+    (void)parameter;
+    (void)context;
+
+    ve_cpu_topology* topology = &g_cpu_topology;
+    memset(topology, 0, sizeof(ve_cpu_topology));
+    topology->numa_node_count = 1;
+
+    DWORD length = 0;
+    GetLogicalProcessorInformationEx(RelationAll, NULL, &length);
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* info =
+        length ? (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)malloc(length) : NULL;
+    if (!info || !GetLogicalProcessorInformationEx(RelationAll, info, &length)) {
+        free(info);
+        DWORD count = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+        for (DWORD cpu = 0; cpu < count && cpu < VE_MAX_CPUS; cpu++) {
+            ve_cpu_set_add(&topology->online, cpu);
+            topology->cpus[cpu].core = cpu;
+        }
+        topology->core_count = topology->performance_core_count = topology->logical_count =
+            ve_cpu_set_count(&topology->online);
+        topology->available = topology->online;
+        return TRUE;
+    }
+
+    /* Hybrid parts give their cores efficiency classes, the highest being the performance cores */
+    const char* begin = (const char*)info;
+    const char* end = begin + length;
+    BYTE max_class = 0;
+    for (const char* at = begin; at < end; at += ((const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)at)->Size) {
+        const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* entry = (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)at;
+        if (entry->Relationship == RelationProcessorCore && entry->Processor.EfficiencyClass > max_class) {
+            max_class = entry->Processor.EfficiencyClass;
+        }
+    }
+
+    uint32_t node_count = 0;
+    for (const char* at = begin; at < end; at += ((const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)at)->Size) {
+        const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* entry = (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)at;
+        ve_cpu_set cpus;
+        ve_cpu_set_clear(&cpus);
+
+        if (entry->Relationship == RelationProcessorCore) {
+            for (WORD g = 0; g < entry->Processor.GroupCount; g++) {
+                add_group_mask(&cpus, &entry->Processor.GroupMask[g]);
+            }
+            ve_core_type type = entry->Processor.EfficiencyClass < max_class ? VE_CORE_TYPE_EFFICIENCY
+                                                                               : VE_CORE_TYPE_PERFORMANCE;
+            uint32_t smt_index = 0;
+            for (uint32_t cpu = 0; cpu < VE_MAX_CPUS; cpu++) {
+                if (ve_cpu_set_contains(&cpus, cpu)) {
+                    ve_cpu_set_add(&topology->online, cpu);
+                    topology->cpus[cpu].core = topology->core_count;
+                    topology->cpus[cpu].smt_index = smt_index++;
+                    topology->cpus[cpu].type = type;
+                }
+            }
+            topology->core_count++;
+            if (type == VE_CORE_TYPE_PERFORMANCE) {
+                topology->performance_core_count++;
+            } else {
+                topology->hybrid = true;
+            }
+        } else if (entry->Relationship == RelationNumaNode) {
+            /* Node numbers may be sparse; nodes are numbered densely in report order */
+            add_group_mask(&cpus, &entry->NumaNode.GroupMask);
+            for (uint32_t cpu = 0; cpu < VE_MAX_CPUS; cpu++) {
+                if (ve_cpu_set_contains(&cpus, cpu)) {
+                    topology->cpus[cpu].numa_node = node_count;
+                }
+            }
+            node_count++;
+        }
+    }
+    free(info);
+
+    topology->logical_count = ve_cpu_set_count(&topology->online);
+    if (node_count > 0) {
+        topology->numa_node_count = node_count;
+    }
+
+    /* The process mask only describes the process's group; on multi-group systems every CPU counts */
+    topology->available = topology->online;
+    DWORD_PTR process_mask = 0;
+    DWORD_PTR system_mask = 0;
+    if (GetActiveProcessorGroupCount() == 1 &&
+        GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask)) {
+        topology->available.bits[0] &= (uint64_t)process_mask;
+    }
+    return TRUE;
+}
+
+const ve_cpu_topology* ve_cpu_get_topology(void) {
+    InitOnceExecuteOnce(&g_cpu_topology_once, detect_cpu_topology, NULL, NULL);
+    return &g_cpu_topology;
+}
+
+/* Loopback sockets */
+
+struct ve_socket {
+    SOCKET handle;
+};
+
+static INIT_ONCE g_winsock_once = INIT_ONCE_STATIC_INIT;
+static bool g_winsock_ready = false;
+
+static BOOL CALLBACK start_winsock(PINIT_ONCE once, PVOID parameter, PVOID* context) {
+    (void)once;
+    (void)parameter;
+    (void)context;
+    WSADATA data;
+    g_winsock_ready = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    return TRUE;
+}
+
+static ve_socket* wrap_socket(SOCKET handle) {
+    ve_socket* result = (ve_socket*)malloc(sizeof(ve_socket));
+    if (!result) {
+        closesocket(handle);
+        return NULL;
+    }
+    result->handle = handle;
+    return result;
+}
+
+static SOCKET open_socket(void) {
+    InitOnceExecuteOnce(&g_winsock_once, start_winsock, NULL, NULL);
+    if (!g_winsock_ready) {
+        return INVALID_SOCKET;
+    }
+    return WSASocketW(AF_INET, SOCK_STREAM, IPPROTO_TCP, NULL, 0, WSA_FLAG_NO_HANDLE_INHERIT);
+}
+
+static struct sockaddr_in loopback_address(uint16_t port) {
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    return address;
+}
+
+/* Wait for a socket to become readable; false on timeout or failure */
+static bool wait_readable(SOCKET handle, uint32_t timeout_ms) {
+    WSAPOLLFD entry = {.fd = handle, .events = POLLRDNORM};
+    return WSAPoll(&entry, 1, (INT)timeout_ms) > 0;
+}
+
+ve_socket* ve_socket_listen(uint16_t port) {
+    SOCKET handle = open_socket();
+    if (handle == INVALID_SOCKET) {
+        return NULL;
+    }
+
+    /* Keep other processes from binding the same port */
+    BOOL exclusive = TRUE;
+    setsockopt(handle, SOL_SOCKET, SO_EXCLUSIVEADDRUSE, (const char*)&exclusive, sizeof(exclusive));
+    struct sockaddr_in address = loopback_address(port);
+    if (bind(handle, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(handle, 8) != 0) {
+        VE_LOG_ERROR("Failed to listen on port %u: error %d", port, WSAGetLastError());
+        closesocket(handle);
+        return NULL;
+    }
+    return wrap_socket(handle);
+}
+
+ve_socket* ve_socket_connect(uint16_t port) {
+    SOCKET handle = open_socket();
+    if (handle == INVALID_SOCKET) {
+        return NULL;
+    }
+
+    struct sockaddr_in address = loopback_address(port);
+    if (connect(handle, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        closesocket(handle);
+        return NULL;
+    }
+    return wrap_socket(handle);
+}
+
+ve_socket* ve_socket_accept(ve_socket* listener, uint32_t timeout_ms) {
+    if (!wait_readable(listener->handle, timeout_ms)) {
+        return NULL;
+    }
+    SOCKET handle = accept(listener->handle, NULL, NULL);
+    return handle != INVALID_SOCKET ? wrap_socket(handle) : NULL;
+}
+
+int64_t ve_socket_receive(ve_socket* socket, void* buffer, size_t size, uint32_t timeout_ms) {
+    if (!wait_readable(socket->handle, timeout_ms)) {
+        return 0;
+    }
+    int length = size > INT_MAX ? INT_MAX : (int)size;
+    return recv(socket->handle, (char*)buffer, length, 0);
+}
+
+bool ve_socket_send(ve_socket* socket, const void* data, size_t size) {
+    const char* at = (const char*)data;
+    while (size > 0) {
+        int length = size > INT_MAX ? INT_MAX : (int)size;
+        int sent = send(socket->handle, at, length, 0);
+        if (sent <= 0) {
+            return false;
+        }
+        at += sent;
+        size -= (size_t)sent;
+    }
+    return true;
+}
+
+uint16_t ve_socket_get_port(const ve_socket* socket) {
+    struct sockaddr_in address;
+    int length = sizeof(address);
+    if (getsockname(socket->handle, (struct sockaddr*)&address, &length) != 0) {
+        return 0;
+    }
+    return ntohs(address.sin_port);
+}
+
+void ve_socket_close(ve_socket* socket) {
+    if (socket) {
+        closesocket(socket->handle);
+        free(socket);
+    }
+}
+
 #endif /* VE_PLATFORM_WINDOWS */
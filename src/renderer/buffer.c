@@ -3,6 +3,72 @@
  * @brief Vulkan buffer management implementation
  */
 
+#define VK_NO_PROTOTYPES
 #include "buffer.h"
 
-/* TODO: Implement buffer management */
+#include "../core/logger.h"
+#include "../core/assert.h"
+
+#include <string.h>
+
+VkResult ve_buffer_create(const ve_buffer_config* config, ve_buffer* out_buffer) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VE_ASSERT(vk && vk->device);
+    VE_ASSERT(config && out_buffer && config->size > 0);
+
+    memset(out_buffer, 0, sizeof(ve_buffer));
+
+    VkBufferCreateInfo buffer_info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = config->size,
+        .usage = config->usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    /* A single family owns everything anyway */
+    const uint32_t families[2] = { vk->queue_families.graphics_family, vk->queue_families.compute_family };
+    if (config->concurrent && families[0] != families[1]) {
+        buffer_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        buffer_info.queueFamilyIndexCount = 2;
+        buffer_info.pQueueFamilyIndices = families;
+    }
+
+    VkResult result = vkCreateBuffer(vk->device, &buffer_info, NULL, &out_buffer->buffer);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to create buffer: %d", result);
+        return result;
+    }
+
+    result = ve_gpu_memory_allocate_buffer(out_buffer->buffer, config->memory_usage,
+                                           config->allocation_flags, &out_buffer->allocation);
+    if (result != VK_SUCCESS) {
+        vkDestroyBuffer(vk->device, out_buffer->buffer, NULL);
+        out_buffer->buffer = VK_NULL_HANDLE;
+        return result;
+    }
+
+    out_buffer->size = config->size;
+    out_buffer->usage = config->usage;
+
+    if (config->debug_name) {
+        VE_VK_SET_OBJECT_NAME(out_buffer->buffer, VK_OBJECT_TYPE_BUFFER, config->debug_name);
+    }
+
+    return VK_SUCCESS;
+}
+
+void ve_buffer_destroy(ve_buffer* buffer) {
+    if (!buffer || buffer->buffer == VK_NULL_HANDLE) {
+        return;
+    }
+
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    vkDestroyBuffer(vk->device, buffer->buffer, NULL);
+    ve_gpu_memory_free(&buffer->allocation);
+
+    memset(buffer, 0, sizeof(ve_buffer));
+}
+
+void* ve_buffer_get_mapped(const ve_buffer* buffer) {
+    return buffer ? buffer->allocation.mapped : NULL;
+}
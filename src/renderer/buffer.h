@@ -7,12 +7,60 @@
 #define VE_BUFFER_H
 
 #include "vulkan_core.h"
+#include "gpu_memory.h"
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* TODO: Implement buffer management */
+/**
+ * @brief Buffer creation parameters
+ */
+typedef struct ve_buffer_config {
+    VkDeviceSize size;
+    VkBufferUsageFlags usage;
+    ve_gpu_memory_usage memory_usage;
+    uint32_t allocation_flags;      /* ve_gpu_allocation_flags */
+    bool concurrent;                /* Shared by the graphics and compute families without ownership transfers */
+    const char* debug_name;         /* Optional */
+} ve_buffer_config;
+
+/**
+ * @brief Buffer with its sub-allocated memory
+ */
+typedef struct ve_buffer {
+    VkBuffer buffer;
+    ve_gpu_allocation allocation;
+    VkDeviceSize size;
+    VkBufferUsageFlags usage;
+} ve_buffer;
+
+/**
+ * @brief Create a buffer and bind memory to it
+ *
+ * @param config Buffer parameters
+ * @param out_buffer Receives the buffer
+ * @return VK_SUCCESS on success
+ */
+VkResult ve_buffer_create(const ve_buffer_config* config, ve_buffer* out_buffer);
+
+/**
+ * @brief Destroy a buffer and free its memory
+ *
+ * The GPU must be done with the buffer.
+ *
+ * @param buffer Buffer to destroy, cleared on return
+ */
+void ve_buffer_destroy(ve_buffer* buffer);
+
+/**
+ * @brief Get the host pointer of a host-visible buffer
+ *
+ * @param buffer Buffer
+ * @return Mapped pointer, or NULL if the memory is not host visible
+ */
+void* ve_buffer_get_mapped(const ve_buffer* buffer);
 
 #ifdef __cplusplus
 }
@@ -8,14 +8,48 @@
 
 #include "../core/logger.h"
 #include "../core/assert.h"
-#include "../memory/memory.h"
+#include "../core/memory.h"
+#include "sync.h"
+#include "gpu_profiler.h"
+#include "gpu_stats.h"
 
 #include <stdlib.h>
 #include <string.h>
 
+/**
+ * @brief Transient command pool owned by one frame in flight
+ *
+ * Command buffers handed out during a frame are kept together with their
+ * wrappers and reused after the pool is reset, so steady-state allocation
+ * is a bump of the used count and never calls vkAllocateCommandBuffers.
+ */
+typedef struct ve_frame_pool {
+    VkCommandPool pool;
+    ve_command_buffer_type type;
+    ve_command_buffer** buffers[2];     /* Indexed by VkCommandBufferLevel */
+    uint32_t allocated[2];
+    uint32_t used[2];
+} ve_frame_pool;
+
+/**
+ * @brief One chunk of a parallel recording
+ */
+typedef struct ve_record_chunk {
+    ve_frame_pool* recorder;
+    const VkCommandBufferInheritanceInfo* inheritance;
+    ve_secondary_record_fn record;
+    void* user_data;
+    uint32_t begin;
+    uint32_t end;
+    VkCommandBuffer buffer;
+    VkResult result;
+} ve_record_chunk;
+
 /* Global command pool state */
 static ve_command_pool g_command_pools[3] = {0};  /* Graphics, Compute, Transfer */
-static ve_command_buffer* g_frame_command_buffers[VE_MAX_FRAMES_IN_FLIGHT][3] = {0};
+static ve_frame_pool g_frame_pools[VE_MAX_FRAMES_IN_FLIGHT][3] = {0};
+static ve_command_buffer* g_frame_command_buffers[VE_MAX_FRAMES_IN_FLIGHT][3] = {0};  /* Main primaries */
+static ve_frame_pool g_recorder_pools[VE_MAX_FRAMES_IN_FLIGHT][VE_MAX_RECORDING_THREADS] = {0};
 static bool g_initialized = false;
 
 static const char* pool_type_names[] = {
@@ -24,6 +58,138 @@ static const char* pool_type_names[] = {
     "transfer_command_pool"
 };
 
+static uint32_t queue_family_for_type(ve_vulkan_context* vk, ve_command_buffer_type type) {
+    switch (type) {
+        case VE_COMMAND_BUFFER_COMPUTE:
+            return vk->queue_families.compute_family;
+        case VE_COMMAND_BUFFER_TRANSFER:
+            return vk->queue_families.transfer_family;
+        default:
+            return vk->queue_families.graphics_family;
+    }
+}
+
+static VkResult frame_pool_create(ve_frame_pool* frame_pool, ve_command_buffer_type type) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+
+    /* Buffers are only ever reset together with their pool */
+    VkCommandPoolCreateInfo pool_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = queue_family_for_type(vk, type),
+    };
+
+    memset(frame_pool, 0, sizeof(ve_frame_pool));
+    frame_pool->type = type;
+    return vkCreateCommandPool(vk->device, &pool_info, NULL, &frame_pool->pool);
+}
+
+static void frame_pool_destroy(ve_frame_pool* frame_pool) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+
+    /* Destroying the pool frees its command buffers */
+    if (frame_pool->pool != VK_NULL_HANDLE) {
+        vkDestroyCommandPool(vk->device, frame_pool->pool, NULL);
+    }
+
+    for (uint32_t level = 0; level < 2; level++) {
+        for (uint32_t i = 0; i < frame_pool->allocated[level]; i++) {
+            VE_FREE(frame_pool->buffers[level][i]);
+        }
+        if (frame_pool->buffers[level]) {
+            VE_FREE(frame_pool->buffers[level]);
+        }
+    }
+
+    memset(frame_pool, 0, sizeof(ve_frame_pool));
+}
+
+/* Allocate more command buffers for a frame pool, doubling its capacity */
+static bool frame_pool_grow(ve_frame_pool* frame_pool, uint32_t level) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+
+    uint32_t allocated = frame_pool->allocated[level];
+    uint32_t capacity = allocated ? allocated * 2 : 4;
+    uint32_t count = capacity - allocated;
+
+    ve_command_buffer** buffers = (ve_command_buffer**)VE_REALLOC(frame_pool->buffers[level],
+                                                                  capacity * sizeof(ve_command_buffer*));
+    if (!buffers) {
+        return false;
+    }
+    frame_pool->buffers[level] = buffers;
+
+    VkCommandBuffer* handles = (VkCommandBuffer*)VE_ALLOCATE_TAG(count * sizeof(VkCommandBuffer),
+                                                                 VE_MEMORY_TAG_VULKAN);
+    if (!handles) {
+        return false;
+    }
+
+    VkCommandBufferAllocateInfo alloc_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = frame_pool->pool,
+        .level = (VkCommandBufferLevel)level,
+        .commandBufferCount = count,
+    };
+
+    VkResult result = vkAllocateCommandBuffers(vk->device, &alloc_info, handles);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to allocate frame command buffers: %d", result);
+        VE_FREE(handles);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        ve_command_buffer* cmd = (ve_command_buffer*)VE_ALLOCATE_TAG(sizeof(ve_command_buffer),
+                                                                     VE_MEMORY_TAG_VULKAN);
+        if (!cmd) {
+            vkFreeCommandBuffers(vk->device, frame_pool->pool, count - i, handles + i);
+            VE_FREE(handles);
+            return false;
+        }
+
+        memset(cmd, 0, sizeof(ve_command_buffer));
+        cmd->buffer = handles[i];
+        cmd->type = frame_pool->type;
+        cmd->transient = true;
+        buffers[frame_pool->allocated[level]++] = cmd;
+    }
+
+    VE_FREE(handles);
+    return true;
+}
+
+/* Hand out the next command buffer of a frame pool */
+static ve_command_buffer* frame_pool_acquire(ve_frame_pool* frame_pool, VkCommandBufferLevel level) {
+    if (frame_pool->used[level] == frame_pool->allocated[level] && !frame_pool_grow(frame_pool, level)) {
+        return NULL;
+    }
+    return frame_pool->buffers[level][frame_pool->used[level]++];
+}
+
+/* Recycle every command buffer of a frame pool with a single pool reset */
+static void frame_pool_reset(ve_frame_pool* frame_pool) {
+    if (frame_pool->used[0] == 0 && frame_pool->used[1] == 0) {
+        return;
+    }
+
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    vkResetCommandPool(vk->device, frame_pool->pool, 0);
+
+    for (uint32_t level = 0; level < 2; level++) {
+        for (uint32_t i = 0; i < frame_pool->used[level]; i++) {
+            ve_command_buffer* cmd = frame_pool->buffers[level][i];
+            cmd->is_recording = false;
+            cmd->is_submitting = false;
+            cmd->device_mask = 0;
+            cmd->render_pass = VK_NULL_HANDLE;
+            cmd->framebuffer = VK_NULL_HANDLE;
+            cmd->subpass = 0;
+        }
+        frame_pool->used[level] = 0;
+    }
+}
+
 VkResult ve_command_buffer_init(void) {
     ve_vulkan_context* vk = ve_vulkan_get_context();
     VE_ASSERT(vk && vk->device);
@@ -66,13 +232,29 @@ VkResult ve_command_buffer_init(void) {
     g_command_pools[VE_COMMAND_BUFFER_TRANSFER].type = VE_COMMAND_BUFFER_TRANSFER;
     g_command_pools[VE_COMMAND_BUFFER_TRANSFER].queue_family_index = vk->queue_families.transfer_family;
 
-    /* Pre-allocate per-frame command buffers */
+    /* Per-frame transient pools, one per queue type and one per recorder slot */
     for (uint32_t frame = 0; frame < VE_MAX_FRAMES_IN_FLIGHT; frame++) {
         for (uint32_t type = 0; type < 3; type++) {
-            g_frame_command_buffers[frame][type] = ve_command_buffer_allocate(
-                (ve_command_buffer_type)type, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+            result = frame_pool_create(&g_frame_pools[frame][type], (ve_command_buffer_type)type);
+            if (result != VK_SUCCESS) {
+                VE_LOG_ERROR("Failed to create frame command pool: %d", result);
+                ve_command_buffer_shutdown();
+                return result;
+            }
+        }
 
-            if (!g_frame_command_buffers[frame][type]) {
+        for (uint32_t slot = 0; slot < VE_MAX_RECORDING_THREADS; slot++) {
+            result = frame_pool_create(&g_recorder_pools[frame][slot], VE_COMMAND_BUFFER_GRAPHICS);
+            if (result != VK_SUCCESS) {
+                VE_LOG_ERROR("Failed to create recorder command pool: %d", result);
+                ve_command_buffer_shutdown();
+                return result;
+            }
+        }
+
+        /* Warm up the main primaries so the first frames do not allocate */
+        for (uint32_t type = 0; type < 3; type++) {
+            if (!frame_pool_grow(&g_frame_pools[frame][type], VK_COMMAND_BUFFER_LEVEL_PRIMARY)) {
                 VE_LOG_ERROR("Failed to allocate frame command buffer");
                 ve_command_buffer_shutdown();
                 return VK_ERROR_OUT_OF_DEVICE_MEMORY;
@@ -91,13 +273,14 @@ void ve_command_buffer_shutdown(void) {
         return;
     }
 
-    /* Free per-frame command buffers */
+    /* Destroy per-frame pools together with their command buffers */
     for (uint32_t frame = 0; frame < VE_MAX_FRAMES_IN_FLIGHT; frame++) {
         for (uint32_t type = 0; type < 3; type++) {
-            if (g_frame_command_buffers[frame][type]) {
-                ve_command_buffer_free(g_frame_command_buffers[frame][type]);
-                g_frame_command_buffers[frame][type] = NULL;
-            }
+            frame_pool_destroy(&g_frame_pools[frame][type]);
+            g_frame_command_buffers[frame][type] = NULL;
+        }
+        for (uint32_t slot = 0; slot < VE_MAX_RECORDING_THREADS; slot++) {
+            frame_pool_destroy(&g_recorder_pools[frame][slot]);
         }
     }
 
@@ -153,16 +336,54 @@ ve_command_buffer* ve_command_buffer_allocate(ve_command_buffer_type type, VkCom
     cmd->type = type;
     cmd->is_recording = false;
     cmd->is_submitting = false;
+    cmd->transient = false;
+    cmd->render_pass = VK_NULL_HANDLE;
+    cmd->framebuffer = VK_NULL_HANDLE;
+    cmd->subpass = 0;
+
+    return cmd;
+}
+
+ve_command_buffer* ve_command_buffer_allocate_frame(ve_command_buffer_type type, VkCommandBufferLevel level) {
+    if (!g_initialized || type >= 3) {
+        return NULL;
+    }
 
+    uint32_t frame = ve_sync_get_current_frame_index();
+    ve_command_buffer* cmd = frame_pool_acquire(&g_frame_pools[frame][type], level);
+    if (!cmd) {
+        VE_LOG_ERROR("Failed to allocate frame command buffer");
+    }
     return cmd;
 }
 
+void ve_command_buffer_reset_frame(uint32_t frame_index) {
+    if (!g_initialized || frame_index >= VE_MAX_FRAMES_IN_FLIGHT) {
+        return;
+    }
+
+    for (uint32_t type = 0; type < 3; type++) {
+        frame_pool_reset(&g_frame_pools[frame_index][type]);
+        g_frame_command_buffers[frame_index][type] = NULL;
+    }
+
+    for (uint32_t slot = 0; slot < VE_MAX_RECORDING_THREADS; slot++) {
+        frame_pool_reset(&g_recorder_pools[frame_index][slot]);
+    }
+}
+
 void ve_command_buffer_free(ve_command_buffer* cmd) {
     ve_vulkan_context* vk = ve_vulkan_get_context();
     if (!vk || !vk->device || !cmd) {
         return;
     }
 
+    /* Frame command buffers go back to their pool on ve_command_buffer_reset_frame */
+    VE_ASSERT_MSG(!cmd->transient, "Frame command buffers cannot be freed individually");
+    if (cmd->transient) {
+        return;
+    }
+
     ve_command_pool* pool = ve_command_buffer_get_pool(cmd->type);
     if (pool) {
         vkFreeCommandBuffers(vk->device, pool->pool, 1, &cmd->buffer);
@@ -171,6 +392,11 @@ void ve_command_buffer_free(ve_command_buffer* cmd) {
     VE_FREE(cmd);
 }
 
+void ve_command_buffer_set_device_mask(ve_command_buffer* cmd, uint32_t device_mask) {
+    VE_ASSERT(cmd && !cmd->is_recording);
+    cmd->device_mask = device_mask;
+}
+
 VkResult ve_command_buffer_begin(ve_command_buffer* cmd, VkCommandBufferUsageFlags flags) {
     VE_ASSERT(cmd && !cmd->is_recording);
 
@@ -179,6 +405,15 @@ VkResult ve_command_buffer_begin(ve_command_buffer* cmd, VkCommandBufferUsageFla
         .flags = flags,
     };
 
+    /* Without it a command buffer starts out on every device of the group */
+    VkDeviceGroupCommandBufferBeginInfo group_info = {
+        .sType = VK_STRUCTURE_TYPE_DEVICE_GROUP_COMMAND_BUFFER_BEGIN_INFO,
+        .deviceMask = cmd->device_mask,
+    };
+    if (cmd->device_mask != 0 && ve_vulkan_get_device_group_size() > 1) {
+        begin_info.pNext = &group_info;
+    }
+
     VkResult result = vkBeginCommandBuffer(cmd->buffer, &begin_info);
     if (result == VK_SUCCESS) {
         cmd->is_recording = true;
@@ -200,6 +435,7 @@ VkResult ve_command_buffer_end(ve_command_buffer* cmd) {
 
 VkResult ve_command_buffer_reset(ve_command_buffer* cmd, VkCommandBufferResetFlags flags) {
     VE_ASSERT(cmd && !cmd->is_recording);
+    VE_ASSERT_MSG(!cmd->transient, "Frame command buffers are reset with their pool");
 
     return vkResetCommandBuffer(cmd->buffer, flags);
 }
@@ -258,6 +494,27 @@ VkResult ve_command_buffer_submit_simple(ve_command_buffer* cmd, VkQueue queue,
     return ve_command_buffer_submit(cmd, NULL, NULL, 0, NULL, 0, fence);
 }
 
+/* Begin a render pass, split between the devices of the group in split-frame mode */
+static void begin_render_pass(ve_command_buffer* cmd, VkRenderPassBeginInfo* begin_info,
+                              VkSubpassContents contents) {
+    VkRect2D device_areas[VE_MAX_DEVICE_GROUP_SIZE];
+    VkDeviceGroupRenderPassBeginInfo group_info = {
+        .sType = VK_STRUCTURE_TYPE_DEVICE_GROUP_RENDER_PASS_BEGIN_INFO,
+        .deviceMask = cmd->device_mask,
+        .deviceRenderAreaCount = ve_vulkan_get_device_group_size(),
+        .pDeviceRenderAreas = device_areas,
+    };
+    if (ve_vulkan_get_device_group_mode() == VE_DEVICE_GROUP_SPLIT_FRAME) {
+        if (group_info.deviceMask == 0) {
+            group_info.deviceMask = ve_vulkan_get_device_group_mask();
+        }
+        ve_vulkan_get_split_render_areas(begin_info->renderArea, device_areas);
+        begin_info->pNext = &group_info;
+    }
+
+    vkCmdBeginRenderPass(cmd->buffer, begin_info, contents);
+}
+
 void ve_command_buffer_begin_render_pass(ve_command_buffer* cmd,
                                         VkRenderPass render_pass,
                                         VkFramebuffer framebuffer,
@@ -280,12 +537,154 @@ void ve_command_buffer_begin_render_pass(ve_command_buffer* cmd,
         .pClearValues = clear_values,
     };
 
-    vkCmdBeginRenderPass(cmd->buffer, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
+    begin_render_pass(cmd, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
+}
+
+void ve_command_buffer_begin_render_pass_secondary(ve_command_buffer* cmd,
+                                                  VkRenderPass render_pass,
+                                                  VkFramebuffer framebuffer,
+                                                  VkOffset2D offset,
+                                                  VkExtent2D extent,
+                                                  const VkClearValue* clear_values,
+                                                  uint32_t clear_count)
+{
+    VE_ASSERT(cmd && cmd->is_recording);
+
+    VkRenderPassBeginInfo begin_info = {
+        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+        .renderPass = render_pass,
+        .framebuffer = framebuffer,
+        .renderArea = {
+            .offset = offset,
+            .extent = extent,
+        },
+        .clearValueCount = clear_count,
+        .pClearValues = clear_values,
+    };
+
+    begin_render_pass(cmd, &begin_info, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+    cmd->render_pass = render_pass;
+    cmd->framebuffer = framebuffer;
+    cmd->subpass = 0;
+}
+
+void ve_command_buffer_next_subpass_secondary(ve_command_buffer* cmd) {
+    VE_ASSERT(cmd && cmd->is_recording && cmd->render_pass != VK_NULL_HANDLE);
+    vkCmdNextSubpass(cmd->buffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    cmd->subpass++;
+}
+
+static void record_chunk_task(void* user_data) {
+    ve_record_chunk* chunk = (ve_record_chunk*)user_data;
+
+    ve_command_buffer* secondary = frame_pool_acquire(chunk->recorder, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+    if (!secondary) {
+        chunk->result = VK_ERROR_OUT_OF_HOST_MEMORY;
+        return;
+    }
+    chunk->buffer = secondary->buffer;
+
+    VkCommandBufferBeginInfo begin_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                 VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+        .pInheritanceInfo = chunk->inheritance,
+    };
+
+    chunk->result = vkBeginCommandBuffer(chunk->buffer, &begin_info);
+    if (chunk->result != VK_SUCCESS) {
+        return;
+    }
+
+    chunk->record(chunk->buffer, chunk->begin, chunk->end, chunk->user_data);
+    chunk->result = vkEndCommandBuffer(chunk->buffer);
+}
+
+VkResult ve_command_buffer_record_parallel(ve_command_buffer* cmd,
+                                           ve_thread_pool* pool,
+                                           uint32_t count,
+                                           uint32_t min_batch,
+                                           ve_secondary_record_fn record,
+                                           void* user_data)
+{
+    VE_ASSERT(cmd && cmd->is_recording && cmd->render_pass != VK_NULL_HANDLE && record);
+
+    if (count == 0) {
+        return VK_SUCCESS;
+    }
+
+    /* One chunk per worker plus the calling thread, bounded by the recorder slots */
+    uint32_t max_chunks = pool ? ve_thread_pool_get_thread_count(pool) + 1 : 1;
+    if (max_chunks > VE_MAX_RECORDING_THREADS) {
+        max_chunks = VE_MAX_RECORDING_THREADS;
+    }
+
+    uint32_t batch = (count + max_chunks - 1) / max_chunks;
+    if (batch < min_batch) {
+        batch = min_batch;
+    }
+    if (batch == 0) {
+        batch = 1;
+    }
+    uint32_t chunk_count = (count + batch - 1) / batch;
+
+    VkCommandBufferInheritanceInfo inheritance = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .renderPass = cmd->render_pass,
+        .subpass = cmd->subpass,
+        .framebuffer = cmd->framebuffer,
+    };
+
+    uint32_t frame = ve_sync_get_current_frame_index();
+    ve_record_chunk chunks[VE_MAX_RECORDING_THREADS];
+
+    for (uint32_t i = 0; i < chunk_count; i++) {
+        chunks[i].recorder = &g_recorder_pools[frame][i];
+        chunks[i].inheritance = &inheritance;
+        chunks[i].record = record;
+        chunks[i].user_data = user_data;
+        chunks[i].begin = i * batch;
+        chunks[i].end = (i + 1) * batch < count ? (i + 1) * batch : count;
+        chunks[i].buffer = VK_NULL_HANDLE;
+        chunks[i].result = VK_SUCCESS;
+    }
+
+    if (pool && chunk_count > 1) {
+        ve_task_group group;
+        ve_task_group_init(&group, pool);
+        for (uint32_t i = 1; i < chunk_count; i++) {
+            if (!ve_task_group_run(&group, record_chunk_task, &chunks[i])) {
+                record_chunk_task(&chunks[i]);
+            }
+        }
+        record_chunk_task(&chunks[0]);
+        ve_task_group_wait(&group);
+    } else {
+        for (uint32_t i = 0; i < chunk_count; i++) {
+            record_chunk_task(&chunks[i]);
+        }
+    }
+
+    VkCommandBuffer buffers[VE_MAX_RECORDING_THREADS];
+    for (uint32_t i = 0; i < chunk_count; i++) {
+        if (chunks[i].result != VK_SUCCESS) {
+            VE_LOG_ERROR("Failed to record secondary command buffer %u: %d", i, chunks[i].result);
+            return chunks[i].result;
+        }
+        buffers[i] = chunks[i].buffer;
+    }
+
+    vkCmdExecuteCommands(cmd->buffer, chunk_count, buffers);
+    return VK_SUCCESS;
 }
 
 void ve_command_buffer_end_render_pass(ve_command_buffer* cmd) {
     VE_ASSERT(cmd && cmd->is_recording);
     vkCmdEndRenderPass(cmd->buffer);
+    cmd->render_pass = VK_NULL_HANDLE;
+    cmd->framebuffer = VK_NULL_HANDLE;
+    cmd->subpass = 0;
 }
 
 void ve_command_buffer_set_viewport(ve_command_buffer* cmd, const VkViewport* viewport) {
@@ -361,6 +760,52 @@ void ve_command_buffer_draw(ve_command_buffer* cmd,
     vkCmdDraw(cmd->buffer, vertex_count, instance_count, first_vertex, first_instance);
 }
 
+void ve_command_buffer_draw_indirect(ve_command_buffer* cmd,
+                                    VkBuffer buffer,
+                                    VkDeviceSize offset,
+                                    uint32_t draw_count,
+                                    uint32_t stride)
+{
+    VE_ASSERT(cmd && cmd->is_recording);
+    vkCmdDrawIndirect(cmd->buffer, buffer, offset, draw_count, stride);
+}
+
+void ve_command_buffer_draw_indexed_indirect(ve_command_buffer* cmd,
+                                            VkBuffer buffer,
+                                            VkDeviceSize offset,
+                                            uint32_t draw_count,
+                                            uint32_t stride)
+{
+    VE_ASSERT(cmd && cmd->is_recording);
+    vkCmdDrawIndexedIndirect(cmd->buffer, buffer, offset, draw_count, stride);
+}
+
+void ve_command_buffer_draw_indirect_count(ve_command_buffer* cmd,
+                                          VkBuffer buffer,
+                                          VkDeviceSize offset,
+                                          VkBuffer count_buffer,
+                                          VkDeviceSize count_offset,
+                                          uint32_t max_draw_count,
+                                          uint32_t stride)
+{
+    VE_ASSERT(cmd && cmd->is_recording);
+    VE_ASSERT_MSG(ve_vulkan_supports_draw_indirect_count(), "drawIndirectCount not enabled");
+    vkCmdDrawIndirectCount(cmd->buffer, buffer, offset, count_buffer, count_offset, max_draw_count, stride);
+}
+
+void ve_command_buffer_draw_indexed_indirect_count(ve_command_buffer* cmd,
+                                                  VkBuffer buffer,
+                                                  VkDeviceSize offset,
+                                                  VkBuffer count_buffer,
+                                                  VkDeviceSize count_offset,
+                                                  uint32_t max_draw_count,
+                                                  uint32_t stride)
+{
+    VE_ASSERT(cmd && cmd->is_recording);
+    VE_ASSERT_MSG(ve_vulkan_supports_draw_indirect_count(), "drawIndirectCount not enabled");
+    vkCmdDrawIndexedIndirectCount(cmd->buffer, buffer, offset, count_buffer, count_offset, max_draw_count, stride);
+}
+
 void ve_command_buffer_dispatch(ve_command_buffer* cmd,
                                uint32_t group_count_x,
                                uint32_t group_count_y,
@@ -447,12 +892,26 @@ void ve_command_buffer_blit_image(ve_command_buffer* cmd,
     vkCmdBlitImage(cmd->buffer, src, src_layout, dst, dst_layout, region_count, regions, filter);
 }
 
+void ve_command_buffer_clear_color_image(ve_command_buffer* cmd,
+                                        VkImage image,
+                                        const VkClearColorValue* color,
+                                        const VkImageSubresourceRange* range)
+{
+    VE_ASSERT(cmd && cmd->is_recording);
+    vkCmdClearColorImage(cmd->buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, color, 1, range);
+}
+
 ve_command_buffer* ve_command_buffer_get_current(ve_command_buffer_type type) {
     if (!g_initialized || type >= 3) {
         return NULL;
     }
 
-    uint32_t current_frame = ve_vulkan_get_current_frame();
+    /* The main primary is the first buffer handed out from the frame's pool */
+    uint32_t current_frame = ve_sync_get_current_frame_index();
+    if (!g_frame_command_buffers[current_frame][type]) {
+        g_frame_command_buffers[current_frame][type] = frame_pool_acquire(
+            &g_frame_pools[current_frame][type], VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    }
     return g_frame_command_buffers[current_frame][type];
 }
 
@@ -473,6 +932,11 @@ ve_command_buffer* ve_command_buffer_begin_frame(ve_command_buffer_type type) {
         return NULL;
     }
 
+    if (type == VE_COMMAND_BUFFER_GRAPHICS) {
+        ve_gpu_profiler_begin_frame(cmd->buffer);
+        ve_gpu_stats_begin_frame(cmd->buffer);
+    }
+
     return cmd;
 }
 
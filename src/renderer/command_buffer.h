@@ -1,18 +1,28 @@
 /**
  * @file command_buffer.h
  * @brief Vulkan command buffer management
+ *
+ * Long-lived command buffers come from one resettable pool per queue type.
+ * Command buffers used for a single frame come from that frame's transient
+ * pools instead: they are handed out by bumping a counter and all of them
+ * are recycled with one vkResetCommandPool once the frame's fence has
+ * signalled (ve_sync_wait_for_frame).
  */
 
 #ifndef VE_COMMAND_BUFFER_H
 #define VE_COMMAND_BUFFER_H
 
 #include "vulkan_core.h"
+#include "../core/thread.h"
 #include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* Recorder slots for parallel secondary command buffer recording */
+#define VE_MAX_RECORDING_THREADS 16
+
 /**
  * @brief Command buffer types
  */
@@ -39,8 +49,25 @@ typedef struct ve_command_buffer {
     ve_command_buffer_type type;
     bool is_recording;
     bool is_submitting;
+    bool transient;         /* Owned by a frame pool, see ve_command_buffer_allocate_frame */
+    uint32_t device_mask;   /* Devices of the device group that run it, 0 for all */
+
+    /* Render pass state inherited by secondary command buffers */
+    VkRenderPass render_pass;
+    VkFramebuffer framebuffer;
+    uint32_t subpass;
 } ve_command_buffer;
 
+/**
+ * @brief Records one chunk of work into a secondary command buffer
+ *
+ * @param cmd Secondary command buffer, recording and inside the primary's render pass
+ * @param begin First item of the chunk
+ * @param end One past the last item of the chunk
+ * @param user_data User data passed to ve_command_buffer_record_parallel
+ */
+typedef void (*ve_secondary_record_fn)(VkCommandBuffer cmd, uint32_t begin, uint32_t end, void* user_data);
+
 /**
  * @brief Initialize command pools
  *
@@ -70,13 +97,49 @@ ve_command_pool* ve_command_buffer_get_pool(ve_command_buffer_type type);
  */
 ve_command_buffer* ve_command_buffer_allocate(ve_command_buffer_type type, VkCommandBufferLevel level);
 
+/**
+ * @brief Allocate a command buffer from the current frame's transient pool
+ *
+ * The buffer is valid until the frame slot comes around again and its pool
+ * is reset; it must not be freed or reset individually. Frame pools are not
+ * thread-safe, so only the thread recording the frame may call this.
+ *
+ * @param type Command buffer type
+ * @param level Command buffer level
+ * @return Command buffer or NULL
+ */
+ve_command_buffer* ve_command_buffer_allocate_frame(ve_command_buffer_type type, VkCommandBufferLevel level);
+
+/**
+ * @brief Recycle every command buffer of a frame slot
+ *
+ * Resets the slot's transient pools, including the recorder pools used by
+ * ve_command_buffer_record_parallel. Called by ve_sync_wait_for_frame once
+ * the slot's fence has signalled.
+ *
+ * @param frame_index Frame in flight index
+ */
+void ve_command_buffer_reset_frame(uint32_t frame_index);
+
 /**
  * @brief Free a command buffer
  *
- * @param cmd Command buffer to free
+ * @param cmd Command buffer from ve_command_buffer_allocate
  */
 void ve_command_buffer_free(ve_command_buffer* cmd);
 
+/**
+ * @brief Choose the devices of the device group that run a command buffer
+ *
+ * Call before ve_command_buffer_begin; the submission batcher submits it to
+ * the same devices. Frame command buffers go back to all devices when their
+ * frame slot is reset. Without a device group the mask is ignored.
+ *
+ * @param cmd Primary command buffer, not recording
+ * @param device_mask Device mask (ve_vulkan_get_frame_device_mask), 0 for all
+ */
+void ve_command_buffer_set_device_mask(ve_command_buffer* cmd, uint32_t device_mask);
+
 /**
  * @brief Begin recording a command buffer
  *
@@ -136,6 +199,10 @@ VkResult ve_command_buffer_submit_simple(ve_command_buffer* cmd, VkQueue queue,
 /**
  * @brief Begin a render pass
  *
+ * In split-frame device group mode each device of the command buffer's
+ * mask renders its band of the render area (ve_vulkan_get_split_render_areas),
+ * here and in ve_command_buffer_begin_render_pass_secondary.
+ *
  * @param cmd Command buffer
  * @param render_pass Render pass
  * @param framebuffer Framebuffer
@@ -152,6 +219,61 @@ void ve_command_buffer_begin_render_pass(ve_command_buffer* cmd,
                                         const VkClearValue* clear_values,
                                         uint32_t clear_count);
 
+/**
+ * @brief Begin a render pass whose contents come from secondary command buffers
+ *
+ * Use ve_command_buffer_record_parallel to fill the subpass.
+ *
+ * @param cmd Primary command buffer
+ * @param render_pass Render pass
+ * @param framebuffer Framebuffer
+ * @param offset Render area offset
+ * @param extent Render area extent
+ * @param clear_values Clear values
+ * @param clear_count Number of clear values
+ */
+void ve_command_buffer_begin_render_pass_secondary(ve_command_buffer* cmd,
+                                                  VkRenderPass render_pass,
+                                                  VkFramebuffer framebuffer,
+                                                  VkOffset2D offset,
+                                                  VkExtent2D extent,
+                                                  const VkClearValue* clear_values,
+                                                  uint32_t clear_count);
+
+/**
+ * @brief Advance to the next subpass, keeping secondary command buffer contents
+ *
+ * @param cmd Primary command buffer
+ */
+void ve_command_buffer_next_subpass_secondary(ve_command_buffer* cmd);
+
+/**
+ * @brief Record [0, count) into secondary command buffers on the thread pool
+ *
+ * The range is split into at most VE_MAX_RECORDING_THREADS chunks of at least
+ * min_batch items. Each chunk is recorded by one task into a secondary
+ * command buffer from that chunk's own per-frame command pool, so no pool is
+ * ever used by two threads. The secondaries are then executed by the primary
+ * in chunk order, which keeps the draw order deterministic.
+ *
+ * Must be called from the thread recording the primary, between
+ * ve_command_buffer_begin_render_pass_secondary and the end of the subpass.
+ *
+ * @param cmd Primary command buffer
+ * @param pool Thread pool (NULL records every chunk on the calling thread)
+ * @param count Number of items
+ * @param min_batch Minimum number of items per chunk (0 = 1)
+ * @param record Function recording a chunk
+ * @param user_data User data for record
+ * @return VK_SUCCESS on success
+ */
+VkResult ve_command_buffer_record_parallel(ve_command_buffer* cmd,
+                                           ve_thread_pool* pool,
+                                           uint32_t count,
+                                           uint32_t min_batch,
+                                           ve_secondary_record_fn record,
+                                           void* user_data);
+
 /**
  * @brief End a render pass
  *
@@ -269,6 +391,78 @@ void ve_command_buffer_draw(ve_command_buffer* cmd,
                            uint32_t first_vertex,
                            uint32_t first_instance);
 
+/**
+ * @brief Draw from VkDrawIndirectCommand records in a buffer
+ *
+ * @param cmd Command buffer
+ * @param buffer Buffer holding the commands
+ * @param offset Offset of the first command
+ * @param draw_count Number of commands
+ * @param stride Bytes between commands
+ */
+void ve_command_buffer_draw_indirect(ve_command_buffer* cmd,
+                                    VkBuffer buffer,
+                                    VkDeviceSize offset,
+                                    uint32_t draw_count,
+                                    uint32_t stride);
+
+/**
+ * @brief Draw indexed from VkDrawIndexedIndirectCommand records in a buffer
+ *
+ * @param cmd Command buffer
+ * @param buffer Buffer holding the commands
+ * @param offset Offset of the first command
+ * @param draw_count Number of commands
+ * @param stride Bytes between commands
+ */
+void ve_command_buffer_draw_indexed_indirect(ve_command_buffer* cmd,
+                                            VkBuffer buffer,
+                                            VkDeviceSize offset,
+                                            uint32_t draw_count,
+                                            uint32_t stride);
+
+/**
+ * @brief Draw with the command count read from a buffer
+ *
+ * Requires ve_vulkan_supports_draw_indirect_count().
+ *
+ * @param cmd Command buffer
+ * @param buffer Buffer holding the commands
+ * @param offset Offset of the first command
+ * @param count_buffer Buffer holding the uint32_t command count
+ * @param count_offset Offset of the count
+ * @param max_draw_count Upper bound on the count
+ * @param stride Bytes between commands
+ */
+void ve_command_buffer_draw_indirect_count(ve_command_buffer* cmd,
+                                          VkBuffer buffer,
+                                          VkDeviceSize offset,
+                                          VkBuffer count_buffer,
+                                          VkDeviceSize count_offset,
+                                          uint32_t max_draw_count,
+                                          uint32_t stride);
+
+/**
+ * @brief Draw indexed with the command count read from a buffer
+ *
+ * Requires ve_vulkan_supports_draw_indirect_count().
+ *
+ * @param cmd Command buffer
+ * @param buffer Buffer holding the commands
+ * @param offset Offset of the first command
+ * @param count_buffer Buffer holding the uint32_t command count
+ * @param count_offset Offset of the count
+ * @param max_draw_count Upper bound on the count
+ * @param stride Bytes between commands
+ */
+void ve_command_buffer_draw_indexed_indirect_count(ve_command_buffer* cmd,
+                                                  VkBuffer buffer,
+                                                  VkDeviceSize offset,
+                                                  VkBuffer count_buffer,
+                                                  VkDeviceSize count_offset,
+                                                  uint32_t max_draw_count,
+                                                  uint32_t stride);
+
 /**
  * @brief Dispatch compute
  *
@@ -381,9 +575,25 @@ void ve_command_buffer_blit_image(ve_command_buffer* cmd,
                                  const VkImageBlit* regions,
                                  VkFilter filter);
 
+/**
+ * @brief Clear a color image outside a render pass
+ *
+ * @param cmd Command buffer
+ * @param image Image in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+ * @param color Clear color
+ * @param range Subresource range to clear
+ */
+void ve_command_buffer_clear_color_image(ve_command_buffer* cmd,
+                                        VkImage image,
+                                        const VkClearColorValue* color,
+                                        const VkImageSubresourceRange* range);
+
 /**
  * @brief Get current frame command buffer
  *
+ * The main primary of the frame, taken from the frame's transient pool the
+ * first time it is requested after the slot was reset.
+ *
  * @param type Command buffer type
  * @return Command buffer or NULL
  */
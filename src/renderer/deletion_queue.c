@@ -0,0 +1,294 @@
+/**
+ * @file deletion_queue.c
+ * @brief Deferred destruction of GPU resources implementation
+ */
+
+#define VK_NO_PROTOTYPES
+#include "deletion_queue.h"
+
+#include "../core/logger.h"
+#include "../core/assert.h"
+#include "../core/memory.h"
+#include "../core/queue.h"
+#include "../core/thread.h"
+
+#include <string.h>
+
+/* Initial ring capacity, must be a power of two */
+#define VE_DELETION_QUEUE_INITIAL_CAPACITY 256
+
+/* Inbox entries added per pool growth */
+#define VE_DELETION_QUEUE_INBOX_CHUNK 256
+
+typedef enum ve_deletion_type {
+    VE_DELETION_BUFFER,
+    VE_DELETION_IMAGE,
+    VE_DELETION_IMAGE_VIEW,
+    VE_DELETION_SAMPLER,
+    VE_DELETION_PIPELINE,
+    VE_DELETION_PIPELINE_LAYOUT,
+    VE_DELETION_DESCRIPTOR_POOL,
+    VE_DELETION_FRAMEBUFFER,
+    VE_DELETION_MEMORY,
+    VE_DELETION_SWAPCHAIN,
+    VE_DELETION_CALLBACK,
+} ve_deletion_type;
+
+/**
+ * @brief Resource waiting for the GPU to pass its frame
+ */
+typedef struct ve_deletion_entry {
+    ve_deletion_type type;
+    uint64_t frame;             /* Frame that last may use the resource */
+    union {
+        VkBuffer buffer;
+        VkImage image;
+        VkImageView image_view;
+        VkSampler sampler;
+        VkPipeline pipeline;
+        VkPipelineLayout pipeline_layout;
+        VkDescriptorPool descriptor_pool;
+        VkFramebuffer framebuffer;
+        VkDeviceMemory memory;
+        VkSwapchainKHR swapchain;
+        struct {
+            ve_deletion_fn fn;
+            void* user_data;
+        } callback;
+    } resource;
+} ve_deletion_entry;
+
+/**
+ * @brief Entry on its way from a pushing thread to the frame thread
+ */
+typedef struct ve_deletion_request {
+    ve_mpsc_node node;
+    ve_deletion_entry entry;
+} ve_deletion_request;
+
+/* Global deletion queue state. Any thread pushes into the inbox without a
+   lock; the frame thread moves the inbox into a FIFO ring ordered by frame,
+   which only it touches. */
+static struct {
+    ve_concurrent_pool* requests;
+    ve_mpsc_queue inbox;
+    ve_deletion_entry* entries;     /* Frame thread only */
+    uint32_t capacity;
+    uint32_t head;
+    uint32_t count;
+    ve_atomic_int32 pending;        /* Inbox and ring */
+    ve_atomic_int64 frame_number;
+} g_deletion_queue = {0};
+
+bool ve_deletion_queue_init(void) {
+    memset(&g_deletion_queue, 0, sizeof(g_deletion_queue));
+
+    ve_mpsc_queue_init(&g_deletion_queue.inbox);
+    g_deletion_queue.requests = ve_concurrent_pool_create(sizeof(ve_deletion_request),
+                                                          VE_DELETION_QUEUE_INBOX_CHUNK);
+    g_deletion_queue.entries = (ve_deletion_entry*)VE_ALLOCATE_TAG(
+        VE_DELETION_QUEUE_INITIAL_CAPACITY * sizeof(ve_deletion_entry), VE_MEMORY_TAG_VULKAN);
+
+    if (!g_deletion_queue.requests || !g_deletion_queue.entries) {
+        VE_LOG_ERROR("Failed to create deletion queue");
+        ve_deletion_queue_shutdown();
+        return false;
+    }
+
+    g_deletion_queue.capacity = VE_DELETION_QUEUE_INITIAL_CAPACITY;
+    return true;
+}
+
+void ve_deletion_queue_shutdown(void) {
+    if (g_deletion_queue.entries) {
+        ve_deletion_queue_flush();
+        VE_FREE(g_deletion_queue.entries);
+    }
+    if (g_deletion_queue.requests) {
+        ve_concurrent_pool_destroy(g_deletion_queue.requests);
+    }
+    memset(&g_deletion_queue, 0, sizeof(g_deletion_queue));
+}
+
+static void release_entry(ve_vulkan_context* vk, const ve_deletion_entry* entry) {
+    switch (entry->type) {
+        case VE_DELETION_BUFFER:
+            vkDestroyBuffer(vk->device, entry->resource.buffer, NULL);
+            break;
+        case VE_DELETION_IMAGE:
+            vkDestroyImage(vk->device, entry->resource.image, NULL);
+            break;
+        case VE_DELETION_IMAGE_VIEW:
+            vkDestroyImageView(vk->device, entry->resource.image_view, NULL);
+            break;
+        case VE_DELETION_SAMPLER:
+            vkDestroySampler(vk->device, entry->resource.sampler, NULL);
+            break;
+        case VE_DELETION_PIPELINE:
+            vkDestroyPipeline(vk->device, entry->resource.pipeline, NULL);
+            break;
+        case VE_DELETION_PIPELINE_LAYOUT:
+            vkDestroyPipelineLayout(vk->device, entry->resource.pipeline_layout, NULL);
+            break;
+        case VE_DELETION_DESCRIPTOR_POOL:
+            vkDestroyDescriptorPool(vk->device, entry->resource.descriptor_pool, NULL);
+            break;
+        case VE_DELETION_FRAMEBUFFER:
+            vkDestroyFramebuffer(vk->device, entry->resource.framebuffer, NULL);
+            break;
+        case VE_DELETION_MEMORY:
+            vkFreeMemory(vk->device, entry->resource.memory, NULL);
+            break;
+        case VE_DELETION_SWAPCHAIN:
+            vkDestroySwapchainKHR(vk->device, entry->resource.swapchain, NULL);
+            break;
+        case VE_DELETION_CALLBACK:
+            entry->resource.callback.fn(entry->resource.callback.user_data);
+            break;
+    }
+}
+
+/* Double the ring, unwrapping it so the head is at index 0 */
+static bool grow_ring(void) {
+    uint32_t capacity = g_deletion_queue.capacity * 2;
+    ve_deletion_entry* entries = (ve_deletion_entry*)VE_ALLOCATE_TAG(
+        capacity * sizeof(ve_deletion_entry), VE_MEMORY_TAG_VULKAN);
+    if (!entries) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < g_deletion_queue.count; i++) {
+        entries[i] = g_deletion_queue.entries[(g_deletion_queue.head + i) & (g_deletion_queue.capacity - 1)];
+    }
+
+    VE_FREE(g_deletion_queue.entries);
+    g_deletion_queue.entries = entries;
+    g_deletion_queue.capacity = capacity;
+    g_deletion_queue.head = 0;
+    return true;
+}
+
+/* Move the inbox to the back of the ring. Pushes are stamped when made, so the ring stays ordered by frame
+   up to pushes racing a frame change, which at worst wait one frame longer behind a later stamp. */
+static void drain_inbox(void) {
+    for (;;) {
+        if (g_deletion_queue.count == g_deletion_queue.capacity && !grow_ring()) {
+            /* Entries stay in the inbox until the ring can grow */
+            VE_LOG_ERROR("Deletion queue out of memory, %u entries held back",
+                         (uint32_t)ve_atomic_load32(&g_deletion_queue.pending) - g_deletion_queue.count);
+            return;
+        }
+
+        ve_mpsc_node* node = ve_mpsc_queue_pop(&g_deletion_queue.inbox);
+        if (!node) {
+            return;
+        }
+
+        ve_deletion_request* request = VE_MPSC_ELEMENT(node, ve_deletion_request, node);
+        uint32_t tail = (g_deletion_queue.head + g_deletion_queue.count) & (g_deletion_queue.capacity - 1);
+        g_deletion_queue.entries[tail] = request->entry;
+        g_deletion_queue.count++;
+        ve_concurrent_pool_free(g_deletion_queue.requests, request);
+    }
+}
+
+/* Release entries from the head of the ring whose frame has completed, or all of them */
+static void release_entries(uint64_t completed_frames, bool all) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+
+    for (;;) {
+        drain_inbox();
+
+        while (g_deletion_queue.count > 0) {
+            /* Copied out first: a callback may push, which only touches the inbox */
+            ve_deletion_entry entry = g_deletion_queue.entries[g_deletion_queue.head];
+            if (!all && entry.frame >= completed_frames) {
+                break;
+            }
+            g_deletion_queue.head = (g_deletion_queue.head + 1) & (g_deletion_queue.capacity - 1);
+            g_deletion_queue.count--;
+            release_entry(vk, &entry);
+            ve_atomic_decrement32(&g_deletion_queue.pending);
+        }
+
+        /* Flushing also releases what the callbacks pushed */
+        if (!all || ve_atomic_load32(&g_deletion_queue.pending) == 0) {
+            return;
+        }
+    }
+}
+
+void ve_deletion_queue_collect(uint64_t frame_number, uint64_t completed_frames) {
+    if (!g_deletion_queue.entries) {
+        return;
+    }
+
+    ve_atomic_store64(&g_deletion_queue.frame_number, (int64_t)frame_number);
+    release_entries(completed_frames, false);
+}
+
+void ve_deletion_queue_flush(void) {
+    if (!g_deletion_queue.entries) {
+        return;
+    }
+    release_entries(0, true);
+}
+
+uint32_t ve_deletion_queue_get_pending_count(void) {
+    if (!g_deletion_queue.entries) {
+        return 0;
+    }
+    return (uint32_t)ve_atomic_load32(&g_deletion_queue.pending);
+}
+
+static void push_entry(ve_deletion_entry* entry) {
+    VE_ASSERT_MSG(g_deletion_queue.entries, "Deletion queue not initialized");
+
+    ve_deletion_request* request = (ve_deletion_request*)ve_concurrent_pool_allocate(g_deletion_queue.requests);
+    if (!request) {
+        /* Better to stall once than to leak or destroy a resource in use */
+        VE_LOG_ERROR("Deletion queue out of memory, waiting for the device");
+        ve_vulkan_wait_idle();
+        release_entry(ve_vulkan_get_context(), entry);
+        return;
+    }
+
+    entry->frame = (uint64_t)ve_atomic_load64(&g_deletion_queue.frame_number);
+    request->entry = *entry;
+    ve_atomic_increment32(&g_deletion_queue.pending);
+    ve_mpsc_queue_push(&g_deletion_queue.inbox, &request->node);
+}
+
+#define DEFINE_PUSH(suffix, vk_type, field, deletion_type) \
+    void ve_deletion_queue_push_##suffix(vk_type handle) { \
+        if (handle == VK_NULL_HANDLE) { \
+            return; \
+        } \
+        ve_deletion_entry entry = { .type = deletion_type }; \
+        entry.resource.field = handle; \
+        push_entry(&entry); \
+    }
+
+DEFINE_PUSH(buffer, VkBuffer, buffer, VE_DELETION_BUFFER)
+DEFINE_PUSH(image, VkImage, image, VE_DELETION_IMAGE)
+DEFINE_PUSH(image_view, VkImageView, image_view, VE_DELETION_IMAGE_VIEW)
+DEFINE_PUSH(sampler, VkSampler, sampler, VE_DELETION_SAMPLER)
+DEFINE_PUSH(pipeline, VkPipeline, pipeline, VE_DELETION_PIPELINE)
+DEFINE_PUSH(pipeline_layout, VkPipelineLayout, pipeline_layout, VE_DELETION_PIPELINE_LAYOUT)
+DEFINE_PUSH(descriptor_pool, VkDescriptorPool, descriptor_pool, VE_DELETION_DESCRIPTOR_POOL)
+DEFINE_PUSH(framebuffer, VkFramebuffer, framebuffer, VE_DELETION_FRAMEBUFFER)
+DEFINE_PUSH(memory, VkDeviceMemory, memory, VE_DELETION_MEMORY)
+DEFINE_PUSH(swapchain, VkSwapchainKHR, swapchain, VE_DELETION_SWAPCHAIN)
+
+#undef DEFINE_PUSH
+
+void ve_deletion_queue_push_callback(ve_deletion_fn fn, void* user_data) {
+    if (!fn) {
+        return;
+    }
+
+    ve_deletion_entry entry = { .type = VE_DELETION_CALLBACK };
+    entry.resource.callback.fn = fn;
+    entry.resource.callback.user_data = user_data;
+    push_entry(&entry);
+}
@@ -0,0 +1,96 @@
+/**
+ * @file deletion_queue.h
+ * @brief Deferred destruction of GPU resources
+ *
+ * Resources that may still be referenced by frames in flight are pushed
+ * here instead of being destroyed. Each entry is stamped with the frame
+ * being recorded and released once the GPU completed-frame counter
+ * (ve_sync_get_completed_frame_count) has passed it, so resources can be
+ * retired during play without ve_vulkan_wait_idle. Entries are released in
+ * the order they were pushed.
+ *
+ * Pushing is thread-safe and takes no lock: entries go through an
+ * intrusive MPSC inbox (core/queue.h) that collection, which runs on the
+ * frame thread from ve_sync_wait_for_frame, moves into its ring.
+ */
+
+#ifndef VE_DELETION_QUEUE_H
+#define VE_DELETION_QUEUE_H
+
+#include "vulkan_core.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Destroys a custom resource once the GPU is done with it
+ *
+ * @param user_data User data passed to ve_deletion_queue_push_callback
+ */
+typedef void (*ve_deletion_fn)(void* user_data);
+
+/**
+ * @brief Initialize the deletion queue
+ *
+ * @return true on success
+ */
+bool ve_deletion_queue_init(void);
+
+/**
+ * @brief Release every pending entry and free the queue
+ *
+ * The device must be idle.
+ */
+void ve_deletion_queue_shutdown(void);
+
+/**
+ * @brief Release the entries whose frame has completed on the GPU
+ *
+ * Also starts stamping new entries with frame_number.
+ *
+ * @param frame_number Frame about to be recorded (ve_sync_get_frame_number)
+ * @param completed_frames GPU completed-frame counter
+ */
+void ve_deletion_queue_collect(uint64_t frame_number, uint64_t completed_frames);
+
+/**
+ * @brief Release every pending entry immediately
+ *
+ * The device must be idle.
+ */
+void ve_deletion_queue_flush(void);
+
+/**
+ * @brief Get the number of entries waiting for the GPU
+ *
+ * @return Pending entry count
+ */
+uint32_t ve_deletion_queue_get_pending_count(void);
+
+/* Deferred vkDestroy* / vkFree* calls; VK_NULL_HANDLE is ignored */
+void ve_deletion_queue_push_buffer(VkBuffer buffer);
+void ve_deletion_queue_push_image(VkImage image);
+void ve_deletion_queue_push_image_view(VkImageView image_view);
+void ve_deletion_queue_push_sampler(VkSampler sampler);
+void ve_deletion_queue_push_pipeline(VkPipeline pipeline);
+void ve_deletion_queue_push_pipeline_layout(VkPipelineLayout pipeline_layout);
+void ve_deletion_queue_push_descriptor_pool(VkDescriptorPool descriptor_pool);
+void ve_deletion_queue_push_framebuffer(VkFramebuffer framebuffer);
+void ve_deletion_queue_push_memory(VkDeviceMemory memory);
+void ve_deletion_queue_push_swapchain(VkSwapchainKHR swapchain);
+
+/**
+ * @brief Defer a custom destruction function
+ *
+ * @param fn Function called once the GPU has passed the current frame
+ * @param user_data User data for fn
+ */
+void ve_deletion_queue_push_callback(ve_deletion_fn fn, void* user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_DELETION_QUEUE_H */
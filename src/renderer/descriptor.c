@@ -3,6 +3,917 @@
  * @brief Vulkan descriptor set management implementation
  */
 
+#define VK_NO_PROTOTYPES
 #include "descriptor.h"
 
-/* TODO: Implement descriptor management */
+#include "deletion_queue.h"
+#include "sync.h"
+#include "../core/logger.h"
+#include "../core/assert.h"
+#include "../core/memory.h"
+#include "../core/thread.h"
+
+#include <string.h>
+
+/* Bits of a deferred release's user data holding the index, the table is above */
+#define VE_BINDLESS_INDEX_BITS 24
+
+/**
+ * @brief Index allocator of one bindless table
+ */
+typedef struct ve_bindless_slots {
+    uint32_t capacity;
+    uint32_t next;              /* Indices at and above next were never handed out */
+    uint32_t* free_list;
+    uint32_t free_count;
+    uint32_t used;
+} ve_bindless_slots;
+
+/* Global bindless state */
+static struct {
+    bool initialized;
+    ve_mutex* mutex;
+    VkDescriptorSetLayout set_layout;
+    VkDescriptorPool pool;
+    VkDescriptorSet set;
+    VkPipelineLayout pipeline_layout;
+    uint32_t push_constant_size;
+    ve_bindless_slots slots[VE_BINDLESS_TABLE_COUNT];
+} g_bindless = {0};
+
+static const VkDescriptorType g_bindless_types[VE_BINDLESS_TABLE_COUNT] = {
+    VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+    VK_DESCRIPTOR_TYPE_SAMPLER,
+};
+
+static uint32_t min_u32(uint32_t a, uint32_t b) {
+    return a < b ? a : b;
+}
+
+VkResult ve_bindless_init(void) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VE_ASSERT(vk && vk->device);
+
+    memset(&g_bindless, 0, sizeof(g_bindless));
+
+    if (!ve_vulkan_supports_bindless()) {
+        VE_LOG_WARN("Bindless descriptors not supported");
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    const VkPhysicalDeviceDescriptorIndexingPropertiesEXT* limits = &vk->device_properties.descriptor_indexing;
+    g_bindless.slots[VE_BINDLESS_SAMPLED_IMAGES].capacity = min_u32(VE_BINDLESS_MAX_SAMPLED_IMAGES,
+        min_u32(limits->maxDescriptorSetUpdateAfterBindSampledImages,
+                limits->maxPerStageDescriptorUpdateAfterBindSampledImages));
+    g_bindless.slots[VE_BINDLESS_STORAGE_BUFFERS].capacity = min_u32(VE_BINDLESS_MAX_STORAGE_BUFFERS,
+        min_u32(limits->maxDescriptorSetUpdateAfterBindStorageBuffers,
+                limits->maxPerStageDescriptorUpdateAfterBindStorageBuffers));
+    g_bindless.slots[VE_BINDLESS_SAMPLERS].capacity = min_u32(VE_BINDLESS_MAX_SAMPLERS,
+        min_u32(limits->maxDescriptorSetUpdateAfterBindSamplers,
+                limits->maxPerStageDescriptorUpdateAfterBindSamplers));
+
+    g_bindless.mutex = ve_mutex_create();
+    if (!g_bindless.mutex) {
+        VE_LOG_ERROR("Failed to create bindless mutex");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    for (uint32_t i = 0; i < VE_BINDLESS_TABLE_COUNT; i++) {
+        g_bindless.slots[i].free_list = (uint32_t*)VE_ALLOCATE_TAG(
+            g_bindless.slots[i].capacity * sizeof(uint32_t), VE_MEMORY_TAG_RENDERER);
+        if (!g_bindless.slots[i].free_list) {
+            ve_bindless_shutdown();
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+    }
+
+    /* Every binding is sparse and may change while the set is bound */
+    VkDescriptorSetLayoutBinding bindings[VE_BINDLESS_TABLE_COUNT];
+    VkDescriptorBindingFlags binding_flags[VE_BINDLESS_TABLE_COUNT];
+    VkDescriptorPoolSize pool_sizes[VE_BINDLESS_TABLE_COUNT];
+    for (uint32_t i = 0; i < VE_BINDLESS_TABLE_COUNT; i++) {
+        bindings[i] = (VkDescriptorSetLayoutBinding){
+            .binding = i,
+            .descriptorType = g_bindless_types[i],
+            .descriptorCount = g_bindless.slots[i].capacity,
+            .stageFlags = VK_SHADER_STAGE_ALL,
+        };
+        binding_flags[i] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                           VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                           VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+        pool_sizes[i] = (VkDescriptorPoolSize){
+            .type = g_bindless_types[i],
+            .descriptorCount = g_bindless.slots[i].capacity,
+        };
+    }
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flags_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .bindingCount = VE_BINDLESS_TABLE_COUNT,
+        .pBindingFlags = binding_flags,
+    };
+
+    VkDescriptorSetLayoutCreateInfo layout_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = &flags_info,
+        .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+        .bindingCount = VE_BINDLESS_TABLE_COUNT,
+        .pBindings = bindings,
+    };
+
+    VkResult result = vkCreateDescriptorSetLayout(vk->device, &layout_info, NULL, &g_bindless.set_layout);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to create bindless set layout: %d", result);
+        ve_bindless_shutdown();
+        return result;
+    }
+
+    VkDescriptorPoolCreateInfo pool_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+        .maxSets = 1,
+        .poolSizeCount = VE_BINDLESS_TABLE_COUNT,
+        .pPoolSizes = pool_sizes,
+    };
+
+    result = vkCreateDescriptorPool(vk->device, &pool_info, NULL, &g_bindless.pool);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to create bindless descriptor pool: %d", result);
+        ve_bindless_shutdown();
+        return result;
+    }
+
+    VkDescriptorSetAllocateInfo allocate_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = g_bindless.pool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &g_bindless.set_layout,
+    };
+
+    result = vkAllocateDescriptorSets(vk->device, &allocate_info, &g_bindless.set);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to allocate bindless descriptor set: %d", result);
+        ve_bindless_shutdown();
+        return result;
+    }
+
+    /* One layout for every pipeline, so the set stays bound across pipeline changes */
+    g_bindless.push_constant_size = min_u32(VE_BINDLESS_PUSH_CONSTANT_SIZE,
+                                            vk->device_properties.properties.limits.maxPushConstantsSize);
+    VkPushConstantRange push_range = {
+        .stageFlags = VK_SHADER_STAGE_ALL,
+        .offset = 0,
+        .size = g_bindless.push_constant_size,
+    };
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pSetLayouts = &g_bindless.set_layout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &push_range,
+    };
+
+    result = vkCreatePipelineLayout(vk->device, &pipeline_layout_info, NULL, &g_bindless.pipeline_layout);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to create bindless pipeline layout: %d", result);
+        ve_bindless_shutdown();
+        return result;
+    }
+
+    VE_VK_SET_OBJECT_NAME(g_bindless.set, VK_OBJECT_TYPE_DESCRIPTOR_SET, "bindless_set");
+
+    g_bindless.initialized = true;
+
+    VE_LOG_INFO("Bindless heap created: %u images, %u storage buffers, %u samplers",
+                g_bindless.slots[VE_BINDLESS_SAMPLED_IMAGES].capacity,
+                g_bindless.slots[VE_BINDLESS_STORAGE_BUFFERS].capacity,
+                g_bindless.slots[VE_BINDLESS_SAMPLERS].capacity);
+    return VK_SUCCESS;
+}
+
+void ve_bindless_shutdown(void) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+
+    if (vk && vk->device) {
+        if (g_bindless.pipeline_layout != VK_NULL_HANDLE) {
+            vkDestroyPipelineLayout(vk->device, g_bindless.pipeline_layout, NULL);
+        }
+        /* Destroying the pool frees the set */
+        if (g_bindless.pool != VK_NULL_HANDLE) {
+            vkDestroyDescriptorPool(vk->device, g_bindless.pool, NULL);
+        }
+        if (g_bindless.set_layout != VK_NULL_HANDLE) {
+            vkDestroyDescriptorSetLayout(vk->device, g_bindless.set_layout, NULL);
+        }
+    }
+
+    for (uint32_t i = 0; i < VE_BINDLESS_TABLE_COUNT; i++) {
+        VE_FREE(g_bindless.slots[i].free_list);
+    }
+    if (g_bindless.mutex) {
+        ve_mutex_destroy(g_bindless.mutex);
+    }
+
+    memset(&g_bindless, 0, sizeof(g_bindless));
+}
+
+bool ve_bindless_is_enabled(void) {
+    return g_bindless.initialized;
+}
+
+static uint32_t acquire_index(ve_bindless_table table) {
+    ve_bindless_slots* slots = &g_bindless.slots[table];
+    uint32_t index = VE_BINDLESS_INVALID_INDEX;
+
+    ve_mutex_lock(g_bindless.mutex);
+    if (slots->free_count > 0) {
+        index = slots->free_list[--slots->free_count];
+    } else if (slots->next < slots->capacity) {
+        index = slots->next++;
+    }
+    if (index != VE_BINDLESS_INVALID_INDEX) {
+        slots->used++;
+    }
+    ve_mutex_unlock(g_bindless.mutex);
+
+    if (index == VE_BINDLESS_INVALID_INDEX) {
+        VE_LOG_ERROR("Bindless table %d is full (%u entries)", table, slots->capacity);
+    }
+    return index;
+}
+
+static void write_descriptor(ve_bindless_table table, uint32_t index,
+                             const VkDescriptorImageInfo* image_info,
+                             const VkDescriptorBufferInfo* buffer_info) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+
+    VkWriteDescriptorSet write = {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = g_bindless.set,
+        .dstBinding = (uint32_t)table,
+        .dstArrayElement = index,
+        .descriptorCount = 1,
+        .descriptorType = g_bindless_types[table],
+        .pImageInfo = image_info,
+        .pBufferInfo = buffer_info,
+    };
+    vkUpdateDescriptorSets(vk->device, 1, &write, 0, NULL);
+}
+
+uint32_t ve_bindless_register_image(VkImageView view, VkImageLayout layout) {
+    VE_ASSERT_MSG(g_bindless.initialized, "Bindless heap not initialized");
+
+    uint32_t index = acquire_index(VE_BINDLESS_SAMPLED_IMAGES);
+    if (index != VE_BINDLESS_INVALID_INDEX) {
+        ve_bindless_update_image(index, view, layout);
+    }
+    return index;
+}
+
+uint32_t ve_bindless_register_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+    VE_ASSERT_MSG(g_bindless.initialized, "Bindless heap not initialized");
+
+    uint32_t index = acquire_index(VE_BINDLESS_STORAGE_BUFFERS);
+    if (index != VE_BINDLESS_INVALID_INDEX) {
+        VkDescriptorBufferInfo buffer_info = {
+            .buffer = buffer,
+            .offset = offset,
+            .range = range,
+        };
+        write_descriptor(VE_BINDLESS_STORAGE_BUFFERS, index, NULL, &buffer_info);
+    }
+    return index;
+}
+
+uint32_t ve_bindless_register_sampler(VkSampler sampler) {
+    VE_ASSERT_MSG(g_bindless.initialized, "Bindless heap not initialized");
+
+    uint32_t index = acquire_index(VE_BINDLESS_SAMPLERS);
+    if (index != VE_BINDLESS_INVALID_INDEX) {
+        VkDescriptorImageInfo image_info = {
+            .sampler = sampler,
+        };
+        write_descriptor(VE_BINDLESS_SAMPLERS, index, &image_info, NULL);
+    }
+    return index;
+}
+
+void ve_bindless_update_image(uint32_t index, VkImageView view, VkImageLayout layout) {
+    VE_ASSERT(index < g_bindless.slots[VE_BINDLESS_SAMPLED_IMAGES].capacity);
+
+    VkDescriptorImageInfo image_info = {
+        .imageView = view,
+        .imageLayout = layout,
+    };
+    write_descriptor(VE_BINDLESS_SAMPLED_IMAGES, index, &image_info, NULL);
+}
+
+/* Deletion queue callback: the GPU is done with the index */
+static void free_index(void* user_data) {
+    uintptr_t packed = (uintptr_t)user_data;
+    ve_bindless_table table = (ve_bindless_table)(packed >> VE_BINDLESS_INDEX_BITS);
+    uint32_t index = (uint32_t)(packed & ((1u << VE_BINDLESS_INDEX_BITS) - 1));
+
+    if (!g_bindless.initialized) {
+        return;
+    }
+
+    ve_bindless_slots* slots = &g_bindless.slots[table];
+    ve_mutex_lock(g_bindless.mutex);
+    slots->free_list[slots->free_count++] = index;
+    slots->used--;
+    ve_mutex_unlock(g_bindless.mutex);
+}
+
+void ve_bindless_release(ve_bindless_table table, uint32_t index) {
+    if (!g_bindless.initialized || index == VE_BINDLESS_INVALID_INDEX) {
+        return;
+    }
+
+    VE_ASSERT(table < VE_BINDLESS_TABLE_COUNT && index < g_bindless.slots[table].capacity);
+
+    /* Partially bound: the stale descriptor is never written, just not handed out yet */
+    uintptr_t packed = ((uintptr_t)table << VE_BINDLESS_INDEX_BITS) | index;
+    ve_deletion_queue_push_callback(free_index, (void*)packed);
+}
+
+VkDescriptorSetLayout ve_bindless_get_set_layout(void) {
+    return g_bindless.set_layout;
+}
+
+VkDescriptorSet ve_bindless_get_set(void) {
+    return g_bindless.set;
+}
+
+VkPipelineLayout ve_bindless_get_pipeline_layout(void) {
+    return g_bindless.pipeline_layout;
+}
+
+uint32_t ve_bindless_get_push_constant_size(void) {
+    return g_bindless.push_constant_size;
+}
+
+void ve_bindless_bind(ve_command_buffer* cmd, VkPipelineBindPoint bind_point) {
+    VE_ASSERT(cmd && g_bindless.initialized);
+
+    vkCmdBindDescriptorSets(cmd->buffer, bind_point, g_bindless.pipeline_layout,
+                            0, 1, &g_bindless.set, 0, NULL);
+}
+
+uint32_t ve_bindless_get_used_count(ve_bindless_table table) {
+    if (!g_bindless.initialized || table >= VE_BINDLESS_TABLE_COUNT) {
+        return 0;
+    }
+
+    ve_mutex_lock(g_bindless.mutex);
+    uint32_t used = g_bindless.slots[table].used;
+    ve_mutex_unlock(g_bindless.mutex);
+    return used;
+}
+
+/* Descriptors per set a pool is sized for, by type */
+static const VkDescriptorPoolSize g_pool_ratios[] = {
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2},
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1},
+    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2},
+    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1},
+    {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4},
+    {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 2},
+    {VK_DESCRIPTOR_TYPE_SAMPLER, 1},
+    {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1},
+    {VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1},
+};
+
+#define VE_POOL_RATIO_COUNT (sizeof(g_pool_ratios) / sizeof(g_pool_ratios[0]))
+
+/**
+ * @brief Growable list of descriptor pools
+ *
+ * Frame allocators fill pools[0..current] in order and reset them together;
+ * the persistent allocator frees sets back into any of its pools.
+ */
+typedef struct ve_descriptor_allocator {
+    VkDescriptorPool* pools;
+    uint32_t* pool_sets;        /* Set capacity of each pool */
+    uint32_t pool_count;
+    uint32_t pool_capacity;
+    uint32_t current;           /* Pool allocations are tried from first */
+    uint32_t next_sets;         /* Set capacity of the next pool created */
+    uint32_t set_count;         /* Sets allocated and not yet reset or freed */
+    VkDescriptorPoolCreateFlags flags;
+} ve_descriptor_allocator;
+
+/**
+ * @brief Cached set layout, bindings sorted by binding number
+ */
+typedef struct ve_layout_entry {
+    uint64_t hash;
+    VkDescriptorSetLayoutCreateFlags flags;
+    uint32_t binding_count;
+    VkDescriptorSetLayoutBinding bindings[VE_DESCRIPTOR_MAX_LAYOUT_BINDINGS];
+    VkDescriptorBindingFlags binding_flags[VE_DESCRIPTOR_MAX_LAYOUT_BINDINGS];
+    VkSampler* samplers;        /* Copies of the immutable samplers, bindings point into it */
+    VkDescriptorSetLayout layout;
+} ve_layout_entry;
+
+/* Global descriptor allocator state */
+static struct {
+    bool initialized;
+    ve_mutex* mutex;            /* Guards the layout cache and persistent allocator */
+    ve_descriptor_allocator frames[VE_MAX_FRAMES_IN_FLIGHT];
+    ve_descriptor_allocator persistent;
+    ve_layout_entry* entries;
+    uint32_t entry_count;
+    uint32_t entry_capacity;
+    uint32_t* table;            /* Open addressing, entry index + 1, 0 is empty */
+    uint32_t table_capacity;    /* Power of two */
+    uint64_t layout_hits;
+} g_descriptors = {0};
+
+static VkDescriptorPool create_pool(uint32_t sets, VkDescriptorPoolCreateFlags flags) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+
+    VkDescriptorPoolSize sizes[VE_POOL_RATIO_COUNT];
+    for (uint32_t i = 0; i < VE_POOL_RATIO_COUNT; i++) {
+        sizes[i].type = g_pool_ratios[i].type;
+        sizes[i].descriptorCount = g_pool_ratios[i].descriptorCount * sets;
+    }
+
+    VkDescriptorPoolCreateInfo pool_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = flags,
+        .maxSets = sets,
+        .poolSizeCount = VE_POOL_RATIO_COUNT,
+        .pPoolSizes = sizes,
+    };
+
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkResult result = vkCreateDescriptorPool(vk->device, &pool_info, NULL, &pool);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to create descriptor pool: %d", result);
+        return VK_NULL_HANDLE;
+    }
+    return pool;
+}
+
+static void allocator_init(ve_descriptor_allocator* allocator, VkDescriptorPoolCreateFlags flags) {
+    memset(allocator, 0, sizeof(ve_descriptor_allocator));
+    allocator->next_sets = VE_DESCRIPTOR_POOL_INITIAL_SETS;
+    allocator->flags = flags;
+}
+
+static void allocator_destroy_pools(ve_descriptor_allocator* allocator) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+
+    for (uint32_t i = 0; i < allocator->pool_count; i++) {
+        vkDestroyDescriptorPool(vk->device, allocator->pools[i], NULL);
+    }
+    allocator->pool_count = 0;
+    allocator->current = 0;
+    allocator->set_count = 0;
+}
+
+static void allocator_destroy(ve_descriptor_allocator* allocator) {
+    allocator_destroy_pools(allocator);
+    VE_FREE(allocator->pools);
+    VE_FREE(allocator->pool_sets);
+    memset(allocator, 0, sizeof(ve_descriptor_allocator));
+}
+
+static bool allocator_add_pool(ve_descriptor_allocator* allocator, uint32_t sets) {
+    if (allocator->pool_count == allocator->pool_capacity) {
+        uint32_t capacity = allocator->pool_capacity ? allocator->pool_capacity * 2 : 4;
+        VkDescriptorPool* pools = (VkDescriptorPool*)ve_reallocate(
+            allocator->pools, capacity * sizeof(VkDescriptorPool), VE_MEMORY_TAG_RENDERER);
+        if (!pools) {
+            return false;
+        }
+        allocator->pools = pools;
+
+        uint32_t* pool_sets = (uint32_t*)ve_reallocate(
+            allocator->pool_sets, capacity * sizeof(uint32_t), VE_MEMORY_TAG_RENDERER);
+        if (!pool_sets) {
+            return false;
+        }
+        allocator->pool_sets = pool_sets;
+        allocator->pool_capacity = capacity;
+    }
+
+    VkDescriptorPool pool = create_pool(sets, allocator->flags);
+    if (pool == VK_NULL_HANDLE) {
+        return false;
+    }
+
+    allocator->pools[allocator->pool_count] = pool;
+    allocator->pool_sets[allocator->pool_count] = sets;
+    allocator->pool_count++;
+    return true;
+}
+
+static VkResult allocate_from_pool(VkDescriptorPool pool, VkDescriptorSetLayout layout, VkDescriptorSet* set) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+
+    VkDescriptorSetAllocateInfo allocate_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = pool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &layout,
+    };
+    return vkAllocateDescriptorSets(vk->device, &allocate_info, set);
+}
+
+/* Allocate from the existing pools starting at current, then from a new pool */
+static VkDescriptorPool allocator_allocate(ve_descriptor_allocator* allocator, VkDescriptorSetLayout layout,
+                                           VkDescriptorSet* set) {
+    for (uint32_t tried = 0; tried < allocator->pool_count; tried++) {
+        uint32_t index = (allocator->current + tried) % allocator->pool_count;
+        VkResult result = allocate_from_pool(allocator->pools[index], layout, set);
+        if (result == VK_SUCCESS) {
+            allocator->current = index;
+            allocator->set_count++;
+            return allocator->pools[index];
+        }
+        if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) {
+            VE_LOG_ERROR("Failed to allocate descriptor set: %d", result);
+            return VK_NULL_HANDLE;
+        }
+    }
+
+    if (!allocator_add_pool(allocator, allocator->next_sets)) {
+        return VK_NULL_HANDLE;
+    }
+    allocator->next_sets = min_u32(allocator->next_sets * 2, VE_DESCRIPTOR_POOL_MAX_SETS);
+    allocator->current = allocator->pool_count - 1;
+
+    VkResult result = allocate_from_pool(allocator->pools[allocator->current], layout, set);
+    if (result != VK_SUCCESS) {
+        /* A fresh pool only fails for sets with more descriptors than it is sized for */
+        VE_LOG_ERROR("Descriptor set layout too large for pool: %d", result);
+        return VK_NULL_HANDLE;
+    }
+    allocator->set_count++;
+    return allocator->pools[allocator->current];
+}
+
+VkResult ve_descriptor_init(void) {
+    memset(&g_descriptors, 0, sizeof(g_descriptors));
+
+    g_descriptors.mutex = ve_mutex_create();
+    if (!g_descriptors.mutex) {
+        VE_LOG_ERROR("Failed to create descriptor mutex");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    g_descriptors.table_capacity = 64;
+    g_descriptors.table = (uint32_t*)ve_allocate_cleared(
+        g_descriptors.table_capacity * sizeof(uint32_t), VE_MEMORY_TAG_RENDERER);
+    if (!g_descriptors.table) {
+        ve_descriptor_shutdown();
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    for (uint32_t frame = 0; frame < VE_MAX_FRAMES_IN_FLIGHT; frame++) {
+        allocator_init(&g_descriptors.frames[frame], 0);
+    }
+    allocator_init(&g_descriptors.persistent, VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
+
+    g_descriptors.initialized = true;
+    return VK_SUCCESS;
+}
+
+void ve_descriptor_shutdown(void) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+
+    if (g_descriptors.initialized) {
+        for (uint32_t frame = 0; frame < VE_MAX_FRAMES_IN_FLIGHT; frame++) {
+            allocator_destroy(&g_descriptors.frames[frame]);
+        }
+        allocator_destroy(&g_descriptors.persistent);
+
+        for (uint32_t i = 0; i < g_descriptors.entry_count; i++) {
+            vkDestroyDescriptorSetLayout(vk->device, g_descriptors.entries[i].layout, NULL);
+            VE_FREE(g_descriptors.entries[i].samplers);
+        }
+    }
+
+    VE_FREE(g_descriptors.entries);
+    VE_FREE(g_descriptors.table);
+    if (g_descriptors.mutex) {
+        ve_mutex_destroy(g_descriptors.mutex);
+    }
+
+    memset(&g_descriptors, 0, sizeof(g_descriptors));
+}
+
+/* FNV-1a */
+static uint64_t hash_bytes(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static uint64_t hash_u32(uint64_t hash, uint32_t value) {
+    return hash_bytes(hash, &value, sizeof(value));
+}
+
+/* Hash the layout with bindings in sorted order, ignoring pointers other than sampler handles */
+static uint64_t hash_layout(const VkDescriptorSetLayoutCreateInfo* info, const uint32_t* order,
+                            const VkDescriptorBindingFlags* binding_flags) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    hash = hash_u32(hash, info->flags);
+    hash = hash_u32(hash, info->bindingCount);
+
+    for (uint32_t i = 0; i < info->bindingCount; i++) {
+        const VkDescriptorSetLayoutBinding* binding = &info->pBindings[order[i]];
+        hash = hash_u32(hash, binding->binding);
+        hash = hash_u32(hash, (uint32_t)binding->descriptorType);
+        hash = hash_u32(hash, binding->descriptorCount);
+        hash = hash_u32(hash, binding->stageFlags);
+        hash = hash_u32(hash, binding_flags ? binding_flags[order[i]] : 0);
+        if (binding->pImmutableSamplers) {
+            hash = hash_bytes(hash, binding->pImmutableSamplers, binding->descriptorCount * sizeof(VkSampler));
+        }
+    }
+    return hash;
+}
+
+static bool layout_matches(const ve_layout_entry* entry, uint64_t hash, const VkDescriptorSetLayoutCreateInfo* info,
+                           const uint32_t* order, const VkDescriptorBindingFlags* binding_flags) {
+    if (entry->hash != hash || entry->flags != info->flags || entry->binding_count != info->bindingCount) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < info->bindingCount; i++) {
+        const VkDescriptorSetLayoutBinding* a = &entry->bindings[i];
+        const VkDescriptorSetLayoutBinding* b = &info->pBindings[order[i]];
+        if (a->binding != b->binding || a->descriptorType != b->descriptorType ||
+            a->descriptorCount != b->descriptorCount || a->stageFlags != b->stageFlags ||
+            entry->binding_flags[i] != (binding_flags ? binding_flags[order[i]] : 0)) {
+            return false;
+        }
+        if ((a->pImmutableSamplers == NULL) != (b->pImmutableSamplers == NULL)) {
+            return false;
+        }
+        if (a->pImmutableSamplers &&
+            memcmp(a->pImmutableSamplers, b->pImmutableSamplers, a->descriptorCount * sizeof(VkSampler)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool grow_layout_table(void) {
+    uint32_t capacity = g_descriptors.table_capacity * 2;
+    uint32_t* table = (uint32_t*)ve_allocate_cleared(capacity * sizeof(uint32_t), VE_MEMORY_TAG_RENDERER);
+    if (!table) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < g_descriptors.entry_count; i++) {
+        uint32_t slot = (uint32_t)g_descriptors.entries[i].hash & (capacity - 1);
+        while (table[slot] != 0) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        table[slot] = i + 1;
+    }
+
+    VE_FREE(g_descriptors.table);
+    g_descriptors.table = table;
+    g_descriptors.table_capacity = capacity;
+    return true;
+}
+
+/* Copy a created layout into the cache, called with the mutex held */
+static bool insert_layout(uint64_t hash, const VkDescriptorSetLayoutCreateInfo* info, const uint32_t* order,
+                          const VkDescriptorBindingFlags* binding_flags, VkDescriptorSetLayout layout) {
+    if ((g_descriptors.entry_count + 1) * 4 > g_descriptors.table_capacity * 3 && !grow_layout_table()) {
+        return false;
+    }
+
+    if (g_descriptors.entry_count == g_descriptors.entry_capacity) {
+        uint32_t capacity = g_descriptors.entry_capacity ? g_descriptors.entry_capacity * 2 : 32;
+        ve_layout_entry* entries = (ve_layout_entry*)ve_reallocate(
+            g_descriptors.entries, capacity * sizeof(ve_layout_entry), VE_MEMORY_TAG_RENDERER);
+        if (!entries) {
+            return false;
+        }
+        g_descriptors.entries = entries;
+        g_descriptors.entry_capacity = capacity;
+    }
+
+    uint32_t sampler_count = 0;
+    for (uint32_t i = 0; i < info->bindingCount; i++) {
+        if (info->pBindings[i].pImmutableSamplers) {
+            sampler_count += info->pBindings[i].descriptorCount;
+        }
+    }
+
+    ve_layout_entry* entry = &g_descriptors.entries[g_descriptors.entry_count];
+    memset(entry, 0, sizeof(ve_layout_entry));
+    if (sampler_count > 0) {
+        entry->samplers = (VkSampler*)VE_ALLOCATE_TAG(sampler_count * sizeof(VkSampler), VE_MEMORY_TAG_RENDERER);
+        if (!entry->samplers) {
+            return false;
+        }
+    }
+
+    entry->hash = hash;
+    entry->flags = info->flags;
+    entry->binding_count = info->bindingCount;
+    entry->layout = layout;
+
+    uint32_t sampler_offset = 0;
+    for (uint32_t i = 0; i < info->bindingCount; i++) {
+        const VkDescriptorSetLayoutBinding* binding = &info->pBindings[order[i]];
+        entry->bindings[i] = *binding;
+        entry->binding_flags[i] = binding_flags ? binding_flags[order[i]] : 0;
+        if (binding->pImmutableSamplers) {
+            VkSampler* samplers = entry->samplers + sampler_offset;
+            memcpy(samplers, binding->pImmutableSamplers, binding->descriptorCount * sizeof(VkSampler));
+            entry->bindings[i].pImmutableSamplers = samplers;
+            sampler_offset += binding->descriptorCount;
+        }
+    }
+
+    uint32_t slot = (uint32_t)hash & (g_descriptors.table_capacity - 1);
+    while (g_descriptors.table[slot] != 0) {
+        slot = (slot + 1) & (g_descriptors.table_capacity - 1);
+    }
+    g_descriptors.table[slot] = ++g_descriptors.entry_count;
+    return true;
+}
+
+VkDescriptorSetLayout ve_descriptor_layout_get(const VkDescriptorSetLayoutCreateInfo* info) {
+    VE_ASSERT(info && g_descriptors.initialized);
+
+    if (info->bindingCount > VE_DESCRIPTOR_MAX_LAYOUT_BINDINGS) {
+        VE_LOG_ERROR("Descriptor set layout has too many bindings: %u", info->bindingCount);
+        return VK_NULL_HANDLE;
+    }
+
+    const VkDescriptorBindingFlags* binding_flags = NULL;
+    for (const VkBaseInStructure* next = (const VkBaseInStructure*)info->pNext; next; next = next->pNext) {
+        if (next->sType != VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO) {
+            VE_LOG_ERROR("Unsupported structure in descriptor set layout pNext: %d", next->sType);
+            return VK_NULL_HANDLE;
+        }
+        const VkDescriptorSetLayoutBindingFlagsCreateInfo* flags_info =
+            (const VkDescriptorSetLayoutBindingFlagsCreateInfo*)next;
+        if (flags_info->bindingCount > 0) {
+            binding_flags = flags_info->pBindingFlags;
+        }
+    }
+
+    /* Order bindings by binding number so declaration order does not matter */
+    uint32_t order[VE_DESCRIPTOR_MAX_LAYOUT_BINDINGS];
+    for (uint32_t i = 0; i < info->bindingCount; i++) {
+        uint32_t j = i;
+        while (j > 0 && info->pBindings[order[j - 1]].binding > info->pBindings[i].binding) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    uint64_t hash = hash_layout(info, order, binding_flags);
+
+    ve_mutex_lock(g_descriptors.mutex);
+
+    uint32_t slot = (uint32_t)hash & (g_descriptors.table_capacity - 1);
+    while (g_descriptors.table[slot] != 0) {
+        ve_layout_entry* entry = &g_descriptors.entries[g_descriptors.table[slot] - 1];
+        if (layout_matches(entry, hash, info, order, binding_flags)) {
+            g_descriptors.layout_hits++;
+            VkDescriptorSetLayout layout = entry->layout;
+            ve_mutex_unlock(g_descriptors.mutex);
+            return layout;
+        }
+        slot = (slot + 1) & (g_descriptors.table_capacity - 1);
+    }
+
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    VkResult result = vkCreateDescriptorSetLayout(vk->device, info, NULL, &layout);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to create descriptor set layout: %d", result);
+    } else if (!insert_layout(hash, info, order, binding_flags, layout)) {
+        VE_LOG_ERROR("Failed to cache descriptor set layout");
+        vkDestroyDescriptorSetLayout(vk->device, layout, NULL);
+        layout = VK_NULL_HANDLE;
+    }
+
+    ve_mutex_unlock(g_descriptors.mutex);
+    return layout;
+}
+
+VkDescriptorSet ve_descriptor_allocate_frame(VkDescriptorSetLayout layout) {
+    VE_ASSERT(g_descriptors.initialized && layout != VK_NULL_HANDLE);
+
+    ve_descriptor_allocator* allocator = &g_descriptors.frames[ve_sync_get_current_frame_index()];
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    if (allocator_allocate(allocator, layout, &set) == VK_NULL_HANDLE) {
+        return VK_NULL_HANDLE;
+    }
+    return set;
+}
+
+void ve_descriptor_reset_frame(uint32_t frame_index) {
+    if (!g_descriptors.initialized || frame_index >= VE_MAX_FRAMES_IN_FLIGHT) {
+        return;
+    }
+
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    ve_descriptor_allocator* allocator = &g_descriptors.frames[frame_index];
+
+    if (allocator->pool_count > 1) {
+        /* The frame outgrew its first pool: replace them with one pool of the combined size */
+        uint32_t sets = 0;
+        for (uint32_t i = 0; i < allocator->pool_count; i++) {
+            sets += allocator->pool_sets[i];
+        }
+        allocator_destroy_pools(allocator);
+        allocator_add_pool(allocator, sets);
+        return;
+    }
+
+    if (allocator->pool_count == 1 && allocator->set_count > 0) {
+        vkResetDescriptorPool(vk->device, allocator->pools[0], 0);
+    }
+    allocator->current = 0;
+    allocator->set_count = 0;
+}
+
+bool ve_descriptor_allocate(VkDescriptorSetLayout layout, ve_descriptor_allocation* allocation) {
+    VE_ASSERT(g_descriptors.initialized && layout != VK_NULL_HANDLE && allocation);
+
+    memset(allocation, 0, sizeof(ve_descriptor_allocation));
+
+    ve_mutex_lock(g_descriptors.mutex);
+    allocation->pool = allocator_allocate(&g_descriptors.persistent, layout, &allocation->set);
+    ve_mutex_unlock(g_descriptors.mutex);
+
+    if (allocation->pool == VK_NULL_HANDLE) {
+        allocation->set = VK_NULL_HANDLE;
+        return false;
+    }
+    return true;
+}
+
+/* Deletion queue callback: the GPU is done with the set */
+static void free_set(void* user_data) {
+    ve_descriptor_allocation* allocation = (ve_descriptor_allocation*)user_data;
+
+    if (g_descriptors.initialized) {
+        ve_vulkan_context* vk = ve_vulkan_get_context();
+
+        ve_mutex_lock(g_descriptors.mutex);
+        vkFreeDescriptorSets(vk->device, allocation->pool, 1, &allocation->set);
+        g_descriptors.persistent.set_count--;
+        ve_mutex_unlock(g_descriptors.mutex);
+    }
+
+    VE_FREE(allocation);
+}
+
+void ve_descriptor_free(ve_descriptor_allocation* allocation) {
+    if (!allocation || allocation->set == VK_NULL_HANDLE) {
+        return;
+    }
+
+    ve_descriptor_allocation* pending = (ve_descriptor_allocation*)VE_ALLOCATE_TAG(
+        sizeof(ve_descriptor_allocation), VE_MEMORY_TAG_RENDERER);
+    if (pending) {
+        *pending = *allocation;
+        ve_deletion_queue_push_callback(free_set, pending);
+    } else {
+        VE_LOG_ERROR("Failed to defer descriptor set free, leaking it until shutdown");
+    }
+
+    memset(allocation, 0, sizeof(ve_descriptor_allocation));
+}
+
+void ve_descriptor_get_stats(ve_descriptor_stats* stats) {
+    VE_ASSERT(stats);
+
+    memset(stats, 0, sizeof(ve_descriptor_stats));
+    if (!g_descriptors.initialized) {
+        return;
+    }
+
+    for (uint32_t frame = 0; frame < VE_MAX_FRAMES_IN_FLIGHT; frame++) {
+        stats->frame_pools += g_descriptors.frames[frame].pool_count;
+    }
+    stats->frame_sets = g_descriptors.frames[ve_sync_get_current_frame_index()].set_count;
+
+    ve_mutex_lock(g_descriptors.mutex);
+    stats->cached_layouts = g_descriptors.entry_count;
+    stats->layout_cache_hits = g_descriptors.layout_hits;
+    stats->persistent_pools = g_descriptors.persistent.pool_count;
+    stats->persistent_sets = g_descriptors.persistent.set_count;
+    ve_mutex_unlock(g_descriptors.mutex);
+}
@@ -1,18 +1,284 @@
 /**
  * @file descriptor.h
  * @brief Vulkan descriptor set management
+ *
+ * The bindless heap is one global descriptor set holding large
+ * update-after-bind arrays of sampled images, storage buffers and
+ * samplers. Resources are registered once and referenced by index, e.g.
+ * through push constants, so draws never bind per-material descriptor
+ * sets. Released indices are reused once the frames that may still read
+ * them have completed.
+ *
+ * Set layout (set 0 of ve_bindless_get_pipeline_layout):
+ *   binding 0: texture2D textures[]
+ *   binding 1: buffer storage_buffers[]
+ *   binding 2: sampler samplers[]
+ *
+ * Without bindless support, descriptor sets come from two allocators.
+ * Transient sets are bump-allocated from per-frame pools that are reset
+ * with vkResetDescriptorPool when the frame slot comes around again, so no
+ * set is ever freed individually. Long-lived sets come from separate pools
+ * and are freed explicitly. Set layouts are deduplicated by a cache keyed
+ * on their create info.
  */
 
 #ifndef VE_DESCRIPTOR_H
 #define VE_DESCRIPTOR_H
 
 #include "vulkan_core.h"
+#include "command_buffer.h"
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* TODO: Implement descriptor management */
+/* Bindless table sizes, clamped to the device's update-after-bind limits */
+#define VE_BINDLESS_MAX_SAMPLED_IMAGES 65536
+#define VE_BINDLESS_MAX_STORAGE_BUFFERS 16384
+#define VE_BINDLESS_MAX_SAMPLERS 256
+
+/* Push constant bytes of the bindless pipeline layout, clamped to maxPushConstantsSize */
+#define VE_BINDLESS_PUSH_CONSTANT_SIZE 256
+
+/* Returned when a table is full, and meaning "no resource" in shaders */
+#define VE_BINDLESS_INVALID_INDEX UINT32_MAX
+
+/* Most bindings a cached set layout may have */
+#define VE_DESCRIPTOR_MAX_LAYOUT_BINDINGS 32
+
+/* Sets in the first pool of each allocator; later pools grow */
+#define VE_DESCRIPTOR_POOL_INITIAL_SETS 256
+#define VE_DESCRIPTOR_POOL_MAX_SETS 4096
+
+/**
+ * @brief Bindless tables, in binding order
+ */
+typedef enum ve_bindless_table {
+    VE_BINDLESS_SAMPLED_IMAGES,
+    VE_BINDLESS_STORAGE_BUFFERS,
+    VE_BINDLESS_SAMPLERS,
+    VE_BINDLESS_TABLE_COUNT
+} ve_bindless_table;
+
+/**
+ * @brief Long-lived descriptor set
+ */
+typedef struct ve_descriptor_allocation {
+    VkDescriptorSet set;
+    VkDescriptorPool pool;      /* Pool the set is returned to */
+} ve_descriptor_allocation;
+
+/**
+ * @brief Descriptor allocator statistics
+ */
+typedef struct ve_descriptor_stats {
+    uint32_t cached_layouts;
+    uint64_t layout_cache_hits;
+    uint32_t frame_pools;           /* Across all frame slots */
+    uint32_t frame_sets;            /* Allocated in the current frame slot */
+    uint32_t persistent_pools;
+    uint32_t persistent_sets;
+} ve_descriptor_stats;
+
+/**
+ * @brief Create the bindless descriptor heap
+ *
+ * @return VK_SUCCESS on success, VK_ERROR_FEATURE_NOT_PRESENT if ve_vulkan_supports_bindless() is false
+ */
+VkResult ve_bindless_init(void);
+
+/**
+ * @brief Destroy the bindless descriptor heap
+ *
+ * The device must be idle.
+ */
+void ve_bindless_shutdown(void);
+
+/**
+ * @brief Check if the bindless heap is available
+ *
+ * @return true if initialized
+ */
+bool ve_bindless_is_enabled(void);
+
+/**
+ * @brief Register a sampled image
+ *
+ * @param view Image view
+ * @param layout Layout the image is in when sampled
+ * @return Index into textures[], or VE_BINDLESS_INVALID_INDEX if full
+ */
+uint32_t ve_bindless_register_image(VkImageView view, VkImageLayout layout);
+
+/**
+ * @brief Register a storage buffer range
+ *
+ * @param buffer Buffer
+ * @param offset Offset of the range
+ * @param range Size of the range, or VK_WHOLE_SIZE
+ * @return Index into storage_buffers[], or VE_BINDLESS_INVALID_INDEX if full
+ */
+uint32_t ve_bindless_register_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+
+/**
+ * @brief Register a sampler
+ *
+ * @param sampler Sampler
+ * @return Index into samplers[], or VE_BINDLESS_INVALID_INDEX if full
+ */
+uint32_t ve_bindless_register_sampler(VkSampler sampler);
+
+/**
+ * @brief Point a registered sampled image index at another view
+ *
+ * For streaming in higher mips under the same index. The index must not be
+ * read by frames in flight unless both views are valid until they complete.
+ *
+ * @param index Index returned by ve_bindless_register_image
+ * @param view New image view
+ * @param layout Layout the image is in when sampled
+ */
+void ve_bindless_update_image(uint32_t index, VkImageView view, VkImageLayout layout);
+
+/**
+ * @brief Release an index
+ *
+ * The index is handed out again once the current frame has completed on
+ * the GPU.
+ *
+ * @param table Table the index belongs to
+ * @param index Index to release
+ */
+void ve_bindless_release(ve_bindless_table table, uint32_t index);
+
+/**
+ * @brief Get the bindless set layout
+ *
+ * @return Descriptor set layout
+ */
+VkDescriptorSetLayout ve_bindless_get_set_layout(void);
+
+/**
+ * @brief Get the bindless descriptor set
+ *
+ * @return Descriptor set
+ */
+VkDescriptorSet ve_bindless_get_set(void);
+
+/**
+ * @brief Get the shared pipeline layout
+ *
+ * The bindless set is set 0 and all stages share one push constant range
+ * of ve_bindless_get_push_constant_size() bytes.
+ *
+ * @return Pipeline layout
+ */
+VkPipelineLayout ve_bindless_get_pipeline_layout(void);
+
+/**
+ * @brief Get the push constant size of the shared pipeline layout
+ *
+ * @return Size in bytes
+ */
+uint32_t ve_bindless_get_push_constant_size(void);
+
+/**
+ * @brief Bind the bindless set as set 0
+ *
+ * Once per command buffer and bind point is enough; pipelines created with
+ * ve_bindless_get_pipeline_layout keep it bound across pipeline changes.
+ *
+ * @param cmd Command buffer
+ * @param bind_point Bind point
+ */
+void ve_bindless_bind(ve_command_buffer* cmd, VkPipelineBindPoint bind_point);
+
+/**
+ * @brief Get the number of live indices in a table
+ *
+ * @param table Table
+ * @return Registered and not yet released indices
+ */
+uint32_t ve_bindless_get_used_count(ve_bindless_table table);
+
+/**
+ * @brief Initialize the layout cache and descriptor allocators
+ *
+ * @return VK_SUCCESS on success
+ */
+VkResult ve_descriptor_init(void);
+
+/**
+ * @brief Destroy cached layouts and every descriptor pool
+ *
+ * The device must be idle.
+ */
+void ve_descriptor_shutdown(void);
+
+/**
+ * @brief Get a set layout, creating it on first use
+ *
+ * Create infos describing the same bindings return the same layout, in
+ * any binding order. A VkDescriptorSetLayoutBindingFlagsCreateInfo in pNext
+ * is part of the key; other pNext structures are not supported. The layout
+ * is owned by the cache and must not be destroyed. Thread-safe.
+ *
+ * @param info Layout create info
+ * @return Set layout or VK_NULL_HANDLE
+ */
+VkDescriptorSetLayout ve_descriptor_layout_get(const VkDescriptorSetLayoutCreateInfo* info);
+
+/**
+ * @brief Allocate a descriptor set valid for the current frame
+ *
+ * The set is recycled when the frame slot comes around again and must not
+ * be freed. Like frame command buffers, only the thread recording the
+ * frame may call this.
+ *
+ * @param layout Set layout
+ * @return Descriptor set or VK_NULL_HANDLE
+ */
+VkDescriptorSet ve_descriptor_allocate_frame(VkDescriptorSetLayout layout);
+
+/**
+ * @brief Recycle every descriptor set of a frame slot
+ *
+ * Called by ve_sync_wait_for_frame once the slot's fence has signalled.
+ * When the frame needed more than one pool, they are replaced by a single
+ * pool of their combined size, so a steady workload costs one reset.
+ *
+ * @param frame_index Frame in flight index
+ */
+void ve_descriptor_reset_frame(uint32_t frame_index);
+
+/**
+ * @brief Allocate a long-lived descriptor set
+ *
+ * Thread-safe.
+ *
+ * @param layout Set layout
+ * @param allocation Output allocation
+ * @return true on success
+ */
+bool ve_descriptor_allocate(VkDescriptorSetLayout layout, ve_descriptor_allocation* allocation);
+
+/**
+ * @brief Free a long-lived descriptor set
+ *
+ * The set is returned to its pool once the current frame has completed on
+ * the GPU.
+ *
+ * @param allocation Allocation to free, cleared on return
+ */
+void ve_descriptor_free(ve_descriptor_allocation* allocation);
+
+/**
+ * @brief Get descriptor allocator statistics
+ *
+ * @param stats Output statistics
+ */
+void ve_descriptor_get_stats(ve_descriptor_stats* stats);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,619 @@
+/**
+ * @file gpu_culling.c
+ * @brief GPU-driven instance culling and indirect draws implementation
+ */
+
+#define VK_NO_PROTOTYPES
+#include "gpu_culling.h"
+
+#include "buffer.h"
+#include "descriptor.h"
+#include "hiz.h"
+#include "pipeline.h"
+#include "shader.h"
+#include "sync.h"
+#include "../core/logger.h"
+#include "../core/assert.h"
+
+#include <math.h>
+#include <string.h>
+
+/* Descriptor bindings of instance_cull.comp: uniforms, five storage buffers, then the Hi-Z pyramid */
+#define GPU_CULL_BUFFER_BINDING_COUNT 6
+#define GPU_CULL_HIZ_BINDING 6
+#define GPU_CULL_BINDING_COUNT 7
+
+/* Command and count regions: single and early phase, then late phase */
+#define GPU_CULL_REGION_COUNT 2
+
+/**
+ * @brief CullParams uniform block (std140)
+ */
+typedef struct ve_gpu_cull_params {
+    float view_projection[16];
+    float planes[6][4];
+    uint32_t batch_offsets[VE_GPU_CULL_MAX_BATCHES];     /* uvec4 array in the shader */
+    float hiz[4];                                       /* Width, height, levels, valid */
+    uint32_t instance_count;
+    uint32_t padding[3];
+} ve_gpu_cull_params;
+
+/**
+ * @brief Mesh table entry (std430)
+ */
+typedef struct ve_gpu_cull_mesh {
+    uint32_t index_count;
+    uint32_t first_index;
+    int32_t vertex_offset;
+    uint32_t padding;
+} ve_gpu_cull_mesh;
+
+/**
+ * @brief Resources of one frame in flight
+ */
+typedef struct ve_gpu_culling_frame {
+    ve_buffer params;
+    ve_buffer instances;
+    ve_buffer commands;
+    ve_buffer counts;
+    ve_descriptor_allocation set;
+    VkImageView hiz_view;           /* Pyramid written to the set */
+    uint32_t instance_count;
+    uint32_t batch_offsets[VE_GPU_CULL_MAX_BATCHES];
+    uint32_t batch_counts[VE_GPU_CULL_MAX_BATCHES];
+} ve_gpu_culling_frame;
+
+/* Global GPU culling state */
+static struct {
+    bool initialized;
+    bool compact;                   /* drawIndirectCount available */
+    bool visibility_cleared;        /* Visibility buffer initialized on the GPU */
+    uint32_t max_draw_count;
+    VkShaderModule shader;
+    VkShaderModule late_shader;
+    VkDescriptorSetLayout set_layout;
+    VkPipelineLayout pipeline_layout;
+    ve_pipeline* pipelines[VE_GPU_CULL_PHASE_COUNT];     /* EARLY and LATE only with occlusion */
+    ve_buffer meshes;
+    ve_buffer visibility;           /* Shared by all frames, which run in order */
+    uint32_t mesh_count;
+    ve_gpu_culling_frame frames[VE_MAX_FRAMES_IN_FLIGHT];
+} g_gpu_culling = {0};
+
+static VkResult create_frame(ve_gpu_culling_frame* frame) {
+    const VkBufferUsageFlags indirect_usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                              VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                              VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    const struct {
+        ve_buffer* buffer;
+        VkDeviceSize size;
+        VkBufferUsageFlags usage;
+        ve_gpu_memory_usage memory_usage;
+        const char* name;
+    } buffers[] = {
+        {&frame->params, sizeof(ve_gpu_cull_params), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+         VE_GPU_MEMORY_USAGE_CPU_TO_GPU, "gpu_cull_params"},
+        {&frame->instances, VE_GPU_CULL_MAX_INSTANCES * sizeof(ve_gpu_cull_instance),
+         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VE_GPU_MEMORY_USAGE_CPU_TO_GPU, "gpu_cull_instances"},
+        {&frame->commands,
+         GPU_CULL_REGION_COUNT * VE_GPU_CULL_MAX_INSTANCES * sizeof(VkDrawIndexedIndirectCommand),
+         indirect_usage, VE_GPU_MEMORY_USAGE_GPU_ONLY, "gpu_cull_commands"},
+        {&frame->counts, GPU_CULL_REGION_COUNT * VE_GPU_CULL_MAX_BATCHES * sizeof(uint32_t), indirect_usage,
+         VE_GPU_MEMORY_USAGE_GPU_ONLY, "gpu_cull_counts"},
+    };
+
+    for (uint32_t i = 0; i < sizeof(buffers) / sizeof(buffers[0]); i++) {
+        ve_buffer_config config = {
+            .size = buffers[i].size,
+            .usage = buffers[i].usage,
+            .memory_usage = buffers[i].memory_usage,
+            .debug_name = buffers[i].name,
+        };
+        VkResult result = ve_buffer_create(&config, buffers[i].buffer);
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+    }
+
+    if (!ve_descriptor_allocate(g_gpu_culling.set_layout, &frame->set)) {
+        return VK_ERROR_OUT_OF_POOL_MEMORY;
+    }
+
+    /* The buffers never change, so they are written once; the pyramid is written when it changes */
+    VkDescriptorBufferInfo infos[GPU_CULL_BUFFER_BINDING_COUNT] = {
+        {frame->params.buffer, 0, VK_WHOLE_SIZE},
+        {frame->instances.buffer, 0, VK_WHOLE_SIZE},
+        {g_gpu_culling.meshes.buffer, 0, VK_WHOLE_SIZE},
+        {frame->commands.buffer, 0, VK_WHOLE_SIZE},
+        {frame->counts.buffer, 0, VK_WHOLE_SIZE},
+        {g_gpu_culling.visibility.buffer, 0, VK_WHOLE_SIZE},
+    };
+
+    VkWriteDescriptorSet writes[GPU_CULL_BUFFER_BINDING_COUNT];
+    for (uint32_t i = 0; i < GPU_CULL_BUFFER_BINDING_COUNT; i++) {
+        writes[i] = (VkWriteDescriptorSet){
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = frame->set.set,
+            .dstBinding = i,
+            .descriptorCount = 1,
+            .descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo = &infos[i],
+        };
+    }
+
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    vkUpdateDescriptorSets(vk->device, GPU_CULL_BUFFER_BINDING_COUNT, writes, 0, NULL);
+    return VK_SUCCESS;
+}
+
+static void destroy_frame(ve_gpu_culling_frame* frame) {
+    ve_descriptor_free(&frame->set);
+    ve_buffer_destroy(&frame->params);
+    ve_buffer_destroy(&frame->instances);
+    ve_buffer_destroy(&frame->commands);
+    ve_buffer_destroy(&frame->counts);
+    memset(frame, 0, sizeof(ve_gpu_culling_frame));
+}
+
+/**
+ * @brief Point a frame's set at the current Hi-Z pyramid
+ *
+ * Only called before the set is bound in the frame, so the update never
+ * invalidates a recording command buffer.
+ */
+static void update_hiz_binding(ve_gpu_culling_frame* frame) {
+    VkImageView view = ve_hiz_get_view();
+    if (view == VK_NULL_HANDLE || view == frame->hiz_view) {
+        return;
+    }
+
+    VkDescriptorImageInfo image_info = {
+        .sampler = ve_hiz_get_sampler(),
+        .imageView = view,
+        .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+    };
+    VkWriteDescriptorSet write = {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = frame->set.set,
+        .dstBinding = GPU_CULL_HIZ_BINDING,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .pImageInfo = &image_info,
+    };
+
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    vkUpdateDescriptorSets(vk->device, 1, &write, 0, NULL);
+    frame->hiz_view = view;
+}
+
+/**
+ * @brief Load the late-phase shader and queue the early and late pipelines
+ *
+ * @return false if the late shader could not be loaded
+ */
+static bool create_occlusion_pipelines(const char* late_shader_path) {
+    if (ve_shader_load_module(late_shader_path, &g_gpu_culling.late_shader) != VK_SUCCESS) {
+        VE_LOG_WARN("Late culling shader not loaded, occlusion culling disabled");
+        return false;
+    }
+
+    const struct {
+        ve_gpu_cull_phase phase;
+        VkShaderModule shader;
+        const char* name;
+    } phases[] = {
+        {VE_GPU_CULL_PHASE_EARLY, g_gpu_culling.shader, "instance_cull_early"},
+        {VE_GPU_CULL_PHASE_LATE, g_gpu_culling.late_shader, "instance_cull_late"},
+    };
+
+    for (uint32_t i = 0; i < sizeof(phases) / sizeof(phases[0]); i++) {
+        ve_shader_permutation permutation;
+        ve_shader_permutation_init(&permutation);
+        ve_shader_permutation_set_bool(&permutation, 0, g_gpu_culling.compact);
+        if (phases[i].phase == VE_GPU_CULL_PHASE_EARLY) {
+            ve_shader_permutation_set_bool(&permutation, 1, true);
+        }
+
+        ve_compute_pipeline_desc pipeline_desc = {
+            .shader = phases[i].shader,
+            .specialization = ve_shader_permutation_get_info(&permutation),
+            .layout = g_gpu_culling.pipeline_layout,
+            .debug_name = phases[i].name,
+        };
+        g_gpu_culling.pipelines[phases[i].phase] = ve_pipeline_acquire_compute(&pipeline_desc);
+    }
+
+    /* Both phases or neither */
+    if (!g_gpu_culling.pipelines[VE_GPU_CULL_PHASE_EARLY] || !g_gpu_culling.pipelines[VE_GPU_CULL_PHASE_LATE]) {
+        for (uint32_t p = VE_GPU_CULL_PHASE_EARLY; p < VE_GPU_CULL_PHASE_COUNT; p++) {
+            if (g_gpu_culling.pipelines[p]) {
+                ve_pipeline_wait(g_gpu_culling.pipelines[p]);
+                ve_pipeline_release(g_gpu_culling.pipelines[p]);
+                g_gpu_culling.pipelines[p] = NULL;
+            }
+        }
+        return false;
+    }
+    return true;
+}
+
+VkResult ve_gpu_culling_init(const char* shader_path, const char* late_shader_path) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VE_ASSERT(vk && vk->device && shader_path);
+
+    memset(&g_gpu_culling, 0, sizeof(g_gpu_culling));
+
+    if (!ve_vulkan_supports_compute() || !vk->device_features.multiDrawIndirect ||
+        !vk->device_features.drawIndirectFirstInstance) {
+        VE_LOG_WARN("Multi-draw indirect not supported, GPU culling disabled");
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    g_gpu_culling.compact = ve_vulkan_supports_draw_indirect_count();
+    g_gpu_culling.max_draw_count = vk->device_properties.properties.limits.maxDrawIndirectCount;
+    if (g_gpu_culling.max_draw_count < VE_GPU_CULL_MAX_INSTANCES) {
+        VE_LOG_WARN("maxDrawIndirectCount is %u, larger batches are truncated", g_gpu_culling.max_draw_count);
+    }
+
+    VkDescriptorSetLayoutBinding bindings[GPU_CULL_BINDING_COUNT];
+    for (uint32_t i = 0; i < GPU_CULL_BINDING_COUNT; i++) {
+        VkDescriptorType type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        if (i == 0) {
+            type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        } else if (i == GPU_CULL_HIZ_BINDING) {
+            type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        }
+        bindings[i] = (VkDescriptorSetLayoutBinding){
+            .binding = i,
+            .descriptorType = type,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        };
+    }
+
+    VkDescriptorSetLayoutCreateInfo layout_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = GPU_CULL_BINDING_COUNT,
+        .pBindings = bindings,
+    };
+
+    g_gpu_culling.set_layout = ve_descriptor_layout_get(&layout_info);
+    if (g_gpu_culling.set_layout == VK_NULL_HANDLE) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pSetLayouts = &g_gpu_culling.set_layout,
+    };
+
+    VkResult result = vkCreatePipelineLayout(vk->device, &pipeline_layout_info, NULL, &g_gpu_culling.pipeline_layout);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to create GPU culling pipeline layout: %d", result);
+        ve_gpu_culling_shutdown();
+        return result;
+    }
+
+    /* Append-only and written from the CPU, so one copy serves every frame */
+    ve_buffer_config mesh_config = {
+        .size = VE_GPU_CULL_MAX_MESHES * sizeof(ve_gpu_cull_mesh),
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        .memory_usage = VE_GPU_MEMORY_USAGE_CPU_TO_GPU,
+        .debug_name = "gpu_cull_meshes",
+    };
+    result = ve_buffer_create(&mesh_config, &g_gpu_culling.meshes);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to create GPU culling mesh table: %d", result);
+        ve_gpu_culling_shutdown();
+        return result;
+    }
+
+    ve_buffer_config visibility_config = {
+        .size = VE_GPU_CULL_MAX_INSTANCES * sizeof(uint32_t),
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .memory_usage = VE_GPU_MEMORY_USAGE_GPU_ONLY,
+        .debug_name = "gpu_cull_visibility",
+    };
+    result = ve_buffer_create(&visibility_config, &g_gpu_culling.visibility);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to create GPU culling visibility buffer: %d", result);
+        ve_gpu_culling_shutdown();
+        return result;
+    }
+
+    for (uint32_t i = 0; i < VE_MAX_FRAMES_IN_FLIGHT; i++) {
+        result = create_frame(&g_gpu_culling.frames[i]);
+        if (result != VK_SUCCESS) {
+            VE_LOG_ERROR("Failed to create GPU culling buffers: %d", result);
+            ve_gpu_culling_shutdown();
+            return result;
+        }
+    }
+
+    result = ve_shader_load_module(shader_path, &g_gpu_culling.shader);
+    if (result != VK_SUCCESS) {
+        ve_gpu_culling_shutdown();
+        return result;
+    }
+
+    ve_shader_permutation permutation;
+    ve_shader_permutation_init(&permutation);
+    ve_shader_permutation_set_bool(&permutation, 0, g_gpu_culling.compact);
+
+    /* Compiles in the background; batches draw nothing until it is ready */
+    ve_compute_pipeline_desc pipeline_desc = {
+        .shader = g_gpu_culling.shader,
+        .specialization = ve_shader_permutation_get_info(&permutation),
+        .layout = g_gpu_culling.pipeline_layout,
+        .debug_name = "instance_cull",
+    };
+    g_gpu_culling.pipelines[VE_GPU_CULL_PHASE_SINGLE] = ve_pipeline_acquire_compute(&pipeline_desc);
+    if (!g_gpu_culling.pipelines[VE_GPU_CULL_PHASE_SINGLE]) {
+        ve_gpu_culling_shutdown();
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    /* Occlusion culling is optional on top of frustum culling */
+    bool occlusion = late_shader_path && ve_hiz_is_enabled() && create_occlusion_pipelines(late_shader_path);
+
+    VE_LOG_DEBUG("GPU culling initialized (%s draws, occlusion %s)", g_gpu_culling.compact ? "compacted" : "fixed slot",
+                 occlusion ? "on" : "off");
+    g_gpu_culling.initialized = true;
+    return VK_SUCCESS;
+}
+
+void ve_gpu_culling_shutdown(void) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+
+    for (uint32_t p = 0; p < VE_GPU_CULL_PHASE_COUNT; p++) {
+        if (g_gpu_culling.pipelines[p]) {
+            ve_pipeline_wait(g_gpu_culling.pipelines[p]);
+            ve_pipeline_release(g_gpu_culling.pipelines[p]);
+        }
+    }
+    ve_shader_destroy_module(g_gpu_culling.shader);
+    ve_shader_destroy_module(g_gpu_culling.late_shader);
+
+    for (uint32_t i = 0; i < VE_MAX_FRAMES_IN_FLIGHT; i++) {
+        destroy_frame(&g_gpu_culling.frames[i]);
+    }
+    ve_buffer_destroy(&g_gpu_culling.meshes);
+    ve_buffer_destroy(&g_gpu_culling.visibility);
+
+    if (vk && vk->device && g_gpu_culling.pipeline_layout != VK_NULL_HANDLE) {
+        vkDestroyPipelineLayout(vk->device, g_gpu_culling.pipeline_layout, NULL);
+    }
+
+    /* The set layout belongs to the layout cache */
+    memset(&g_gpu_culling, 0, sizeof(g_gpu_culling));
+}
+
+bool ve_gpu_culling_is_enabled(void) {
+    return g_gpu_culling.initialized;
+}
+
+bool ve_gpu_culling_supports_occlusion(void) {
+    return g_gpu_culling.initialized && g_gpu_culling.pipelines[VE_GPU_CULL_PHASE_LATE] != NULL;
+}
+
+uint32_t ve_gpu_culling_add_mesh(uint32_t index_count, uint32_t first_index, int32_t vertex_offset) {
+    VE_ASSERT(g_gpu_culling.initialized);
+
+    if (g_gpu_culling.mesh_count >= VE_GPU_CULL_MAX_MESHES) {
+        VE_LOG_ERROR("GPU culling mesh table full (%u meshes)", VE_GPU_CULL_MAX_MESHES);
+        return VE_GPU_CULL_INVALID_MESH;
+    }
+
+    /* Entries past mesh_count are never read by frames in flight */
+    ve_gpu_cull_mesh* meshes = (ve_gpu_cull_mesh*)ve_buffer_get_mapped(&g_gpu_culling.meshes);
+    uint32_t index = g_gpu_culling.mesh_count++;
+    meshes[index] = (ve_gpu_cull_mesh){
+        .index_count = index_count,
+        .first_index = first_index,
+        .vertex_offset = vertex_offset,
+    };
+    return index;
+}
+
+uint32_t ve_gpu_culling_set_instances(const ve_gpu_cull_instance* instances, uint32_t count) {
+    VE_ASSERT(g_gpu_culling.initialized && (instances || count == 0));
+
+    if (count > VE_GPU_CULL_MAX_INSTANCES) {
+        VE_LOG_WARN("Too many instances (%u), keeping %u", count, VE_GPU_CULL_MAX_INSTANCES);
+        count = VE_GPU_CULL_MAX_INSTANCES;
+    }
+
+    ve_gpu_culling_frame* frame = &g_gpu_culling.frames[ve_sync_get_current_frame_index()];
+    memset(frame->batch_counts, 0, sizeof(frame->batch_counts));
+    for (uint32_t i = 0; i < count; i++) {
+        VE_ASSERT_MSG(instances[i].batch < VE_GPU_CULL_MAX_BATCHES, "Instance batch out of range");
+        VE_ASSERT_MSG(instances[i].mesh < g_gpu_culling.mesh_count, "Instance mesh not registered");
+        frame->batch_counts[instances[i].batch]++;
+    }
+
+    /* Batch ranges are packed in batch order */
+    uint32_t offset = 0;
+    for (uint32_t b = 0; b < VE_GPU_CULL_MAX_BATCHES; b++) {
+        frame->batch_offsets[b] = offset;
+        offset += frame->batch_counts[b];
+    }
+
+    /* Fixed slots for the uncompacted path, unused when compacting */
+    uint32_t cursors[VE_GPU_CULL_MAX_BATCHES];
+    memcpy(cursors, frame->batch_offsets, sizeof(cursors));
+
+    ve_gpu_cull_instance* mapped = (ve_gpu_cull_instance*)ve_buffer_get_mapped(&frame->instances);
+    for (uint32_t i = 0; i < count; i++) {
+        ve_gpu_cull_instance instance = instances[i];
+        instance.slot = cursors[instance.batch]++;
+        mapped[i] = instance;
+    }
+
+    frame->instance_count = count;
+    return count;
+}
+
+/**
+ * @brief Extract normalized frustum planes from a view-projection matrix
+ *
+ * Rows are combined as in Gribb and Hartmann, with the near plane at clip
+ * z = 0 for Vulkan depth.
+ */
+static void extract_planes(const float m[16], float planes[6][4]) {
+    /* Element (row r, column c) of a column-major matrix */
+#define M(r, c) m[(c) * 4 + (r)]
+    for (uint32_t c = 0; c < 4; c++) {
+        planes[0][c] = M(3, c) + M(0, c);      /* Left */
+        planes[1][c] = M(3, c) - M(0, c);      /* Right */
+        planes[2][c] = M(3, c) + M(1, c);      /* Bottom */
+        planes[3][c] = M(3, c) - M(1, c);      /* Top */
+        planes[4][c] = M(2, c);                /* Near */
+        planes[5][c] = M(3, c) - M(2, c);      /* Far */
+    }
+#undef M
+
+    for (uint32_t i = 0; i < 6; i++) {
+        float length = sqrtf(planes[i][0] * planes[i][0] + planes[i][1] * planes[i][1] +
+                             planes[i][2] * planes[i][2]);
+        float scale = length > 0.0f ? 1.0f / length : 0.0f;
+        for (uint32_t c = 0; c < 4; c++) {
+            planes[i][c] *= scale;
+        }
+    }
+}
+
+void ve_gpu_culling_dispatch(ve_command_buffer* cmd, const float view_projection[16]) {
+    ve_gpu_culling_dispatch_phase(cmd, VE_GPU_CULL_PHASE_SINGLE, view_projection);
+}
+
+void ve_gpu_culling_dispatch_phase(ve_command_buffer* cmd, ve_gpu_cull_phase phase,
+                                   const float view_projection[16]) {
+    VE_ASSERT(cmd && cmd->is_recording && view_projection && g_gpu_culling.initialized);
+    VE_ASSERT(phase < VE_GPU_CULL_PHASE_COUNT);
+    VE_ASSERT_MSG(phase == VE_GPU_CULL_PHASE_SINGLE || ve_gpu_culling_supports_occlusion(),
+                  "Occlusion culling phases need the late pipeline");
+
+    ve_gpu_culling_frame* frame = &g_gpu_culling.frames[ve_sync_get_current_frame_index()];
+    bool occlusion = ve_gpu_culling_supports_occlusion();
+    if (occlusion) {
+        update_hiz_binding(frame);
+    }
+
+    /* Both phases of a frame share the block; the last write before submission is what they read */
+    ve_gpu_cull_params* params = (ve_gpu_cull_params*)ve_buffer_get_mapped(&frame->params);
+    memcpy(params->view_projection, view_projection, sizeof(params->view_projection));
+    extract_planes(view_projection, params->planes);
+    memcpy(params->batch_offsets, frame->batch_offsets, sizeof(params->batch_offsets));
+    params->instance_count = frame->instance_count;
+    memset(params->hiz, 0, sizeof(params->hiz));
+    if (occlusion) {
+        uint32_t width, height, mip_levels;
+        ve_hiz_get_extent(&width, &height, &mip_levels);
+        params->hiz[0] = (float)width;
+        params->hiz[1] = (float)height;
+        params->hiz[2] = (float)mip_levels;
+        params->hiz[3] = ve_hiz_is_valid() ? 1.0f : 0.0f;
+    }
+
+    ve_vulkan_begin_debug_label(cmd->buffer, "instance_culling", 0.2f, 0.8f, 1.0f);
+
+    ve_pipeline* pipeline = g_gpu_culling.pipelines[phase];
+    bool late = phase == VE_GPU_CULL_PHASE_LATE;
+    bool ready = ve_pipeline_is_ready(pipeline) && (!late || frame->hiz_view != VK_NULL_HANDLE);
+    uint32_t region = late ? 1 : 0;
+    VkDeviceSize command_offset = (VkDeviceSize)region * VE_GPU_CULL_MAX_INSTANCES *
+                                  sizeof(VkDrawIndexedIndirectCommand);
+    VkDeviceSize command_bytes = (VkDeviceSize)frame->instance_count * sizeof(VkDrawIndexedIndirectCommand);
+    VkDeviceSize count_offset = (VkDeviceSize)region * VE_GPU_CULL_MAX_BATCHES * sizeof(uint32_t);
+
+    /* Everything starts visible, so nothing pops in while the late phase is compiling */
+    if (occlusion && !g_gpu_culling.visibility_cleared) {
+        vkCmdFillBuffer(cmd->buffer, g_gpu_culling.visibility.buffer, 0, VK_WHOLE_SIZE, 1);
+        g_gpu_culling.visibility_cleared = true;
+    }
+
+    /* Counts restart at zero for appending; fixed slots are cleared only when nothing overwrites them */
+    if (g_gpu_culling.compact) {
+        vkCmdFillBuffer(cmd->buffer, frame->counts.buffer, count_offset, VE_GPU_CULL_MAX_BATCHES * sizeof(uint32_t), 0);
+    } else if (!ready && command_bytes > 0) {
+        vkCmdFillBuffer(cmd->buffer, frame->commands.buffer, command_offset, command_bytes, 0);
+    }
+
+    VkPipelineStageFlags src_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    VkAccessFlags src_access = VK_ACCESS_TRANSFER_WRITE_BIT;
+    if (ready && frame->instance_count > 0) {
+        /* Clears, and the visibility the previous phase read or wrote */
+        VkMemoryBarrier entry_barrier = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        };
+        ve_command_buffer_pipeline_barrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                                           1, &entry_barrier, 0, NULL, 0, NULL);
+
+        vkCmdBindPipeline(cmd->buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->pipeline);
+        vkCmdBindDescriptorSets(cmd->buffer, VK_PIPELINE_BIND_POINT_COMPUTE, g_gpu_culling.pipeline_layout,
+                                0, 1, &frame->set.set, 0, NULL);
+        ve_command_buffer_dispatch(cmd, (frame->instance_count + VE_GPU_CULL_GROUP_SIZE - 1) / VE_GPU_CULL_GROUP_SIZE,
+                                   1, 1);
+        src_stage |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        src_access |= VK_ACCESS_SHADER_WRITE_BIT;
+    }
+
+    VkMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = src_access,
+        .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+    };
+    ve_command_buffer_pipeline_barrier(cmd, src_stage, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0,
+                                       1, &barrier, 0, NULL, 0, NULL);
+
+    ve_vulkan_end_debug_label(cmd->buffer);
+}
+
+void ve_gpu_culling_draw(ve_command_buffer* cmd, uint32_t batch) {
+    ve_gpu_culling_draw_phase(cmd, VE_GPU_CULL_PHASE_SINGLE, batch);
+}
+
+void ve_gpu_culling_draw_phase(ve_command_buffer* cmd, ve_gpu_cull_phase phase, uint32_t batch) {
+    VE_ASSERT(cmd && cmd->is_recording && g_gpu_culling.initialized && batch < VE_GPU_CULL_MAX_BATCHES);
+    VE_ASSERT(phase < VE_GPU_CULL_PHASE_COUNT);
+
+    const ve_gpu_culling_frame* frame = &g_gpu_culling.frames[ve_sync_get_current_frame_index()];
+    uint32_t max_draws = frame->batch_counts[batch];
+    if (max_draws == 0) {
+        return;
+    }
+    if (max_draws > g_gpu_culling.max_draw_count) {
+        max_draws = g_gpu_culling.max_draw_count;
+    }
+
+    const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    uint32_t region = phase == VE_GPU_CULL_PHASE_LATE ? 1 : 0;
+    VkDeviceSize offset = ((VkDeviceSize)region * VE_GPU_CULL_MAX_INSTANCES + frame->batch_offsets[batch]) * stride;
+    if (g_gpu_culling.compact) {
+        VkDeviceSize count_offset = ((VkDeviceSize)region * VE_GPU_CULL_MAX_BATCHES + batch) * sizeof(uint32_t);
+        ve_command_buffer_draw_indexed_indirect_count(cmd, frame->commands.buffer, offset,
+                                                      frame->counts.buffer, count_offset,
+                                                      max_draws, stride);
+    } else {
+        ve_command_buffer_draw_indexed_indirect(cmd, frame->commands.buffer, offset, max_draws, stride);
+    }
+}
+
+void ve_gpu_culling_get_stats(ve_gpu_culling_stats* stats) {
+    VE_ASSERT(stats);
+    memset(stats, 0, sizeof(ve_gpu_culling_stats));
+    if (!g_gpu_culling.initialized) {
+        return;
+    }
+
+    const ve_gpu_culling_frame* frame = &g_gpu_culling.frames[ve_sync_get_current_frame_index()];
+    stats->instances = frame->instance_count;
+    for (uint32_t b = 0; b < VE_GPU_CULL_MAX_BATCHES; b++) {
+        stats->batches += frame->batch_counts[b] > 0 ? 1 : 0;
+    }
+    stats->compacted = g_gpu_culling.compact;
+}
@@ -0,0 +1,209 @@
+/**
+ * @file gpu_culling.h
+ * @brief GPU-driven instance culling and indirect draws
+ *
+ * Every instance of the frame is uploaded once with its world-space
+ * bounding sphere, mesh and batch. A compute pass tests the spheres
+ * against the view frustum and appends one VkDrawIndexedIndirectCommand
+ * per visible instance to its batch's range of the command buffer, with
+ * the batch's draw count kept in a separate buffer. Each batch (one
+ * pipeline and vertex/index buffer binding) is then drawn with a single
+ * vkCmdDrawIndexedIndirectCount, so CPU cost no longer grows with the
+ * number of objects.
+ *
+ * Commands use the instance's object index as firstInstance, so vertex
+ * shaders fetch per-object data with gl_InstanceIndex.
+ *
+ * Without drawIndirectCount, commands are not compacted: every instance
+ * keeps a fixed command slot whose instanceCount is 0 when culled, and
+ * batches are drawn with their full instance count.
+ *
+ * Two-phase occlusion culling (with hiz.h) splits the frame in two. The
+ * EARLY phase draws the instances that passed last frame's occlusion test
+ * and are still in the frustum; their depth is reduced into the Hi-Z
+ * pyramid, and the LATE phase tests every instance against it, draws the
+ * visible ones the early phase skipped and records visibility for the
+ * next frame:
+ *
+ *     ve_gpu_culling_set_instances
+ *     ve_gpu_culling_dispatch_phase(EARLY), then draw the EARLY batches
+ *     ve_hiz_build from the depth buffer
+ *     ve_gpu_culling_dispatch_phase(LATE), then draw the LATE batches
+ *
+ * Visibility is remembered by position in the instance array, so callers
+ * should keep instances in a stable order. Until the pyramid is valid the
+ * late phase tests only the frustum.
+ *
+ * Matrices are column-major with a Vulkan projection (depth 0 to 1).
+ * Instance data is per frame in flight; meshes are shared by all frames.
+ */
+
+#ifndef VE_GPU_CULLING_H
+#define VE_GPU_CULLING_H
+
+#include "vulkan_core.h"
+#include "command_buffer.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Capacities, must match instance_cull.comp where it declares them */
+#define VE_GPU_CULL_MAX_INSTANCES 65536
+#define VE_GPU_CULL_MAX_MESHES 4096
+#define VE_GPU_CULL_MAX_BATCHES 64
+
+/* Threads per workgroup of instance_cull.comp */
+#define VE_GPU_CULL_GROUP_SIZE 64
+
+/* Returned by ve_gpu_culling_add_mesh when the mesh table is full */
+#define VE_GPU_CULL_INVALID_MESH UINT32_MAX
+
+/**
+ * @brief Culling pass of a frame
+ */
+typedef enum ve_gpu_cull_phase {
+    VE_GPU_CULL_PHASE_SINGLE = 0,   /* Frustum only, no occlusion */
+    VE_GPU_CULL_PHASE_EARLY,        /* Visible last frame */
+    VE_GPU_CULL_PHASE_LATE,         /* Newly visible against the Hi-Z pyramid */
+    VE_GPU_CULL_PHASE_COUNT
+} ve_gpu_cull_phase;
+
+/**
+ * @brief Instance to cull, laid out as two uvec4 in the shader
+ */
+typedef struct ve_gpu_cull_instance {
+    float center[3];        /* World-space bounding sphere */
+    float radius;
+    uint32_t mesh;          /* From ve_gpu_culling_add_mesh */
+    uint32_t batch;         /* Below VE_GPU_CULL_MAX_BATCHES */
+    uint32_t object;        /* Becomes firstInstance of the draw */
+    uint32_t slot;          /* Filled in by ve_gpu_culling_set_instances */
+} ve_gpu_cull_instance;
+
+/**
+ * @brief Culling statistics of the current frame, counted on the CPU
+ */
+typedef struct ve_gpu_culling_stats {
+    uint32_t instances;
+    uint32_t batches;           /* Batches with at least one instance */
+    bool compacted;             /* Draw counts come from the GPU */
+} ve_gpu_culling_stats;
+
+/**
+ * @brief Create the culling pipelines and buffers
+ *
+ * Call after ve_hiz_init; the late phase is only created when Hi-Z is
+ * enabled.
+ *
+ * @param shader_path Path to instance_cull.comp.spv
+ * @param late_shader_path Path to instance_cull_late.comp.spv, or NULL for no occlusion culling
+ * @return VK_SUCCESS on success, VK_ERROR_FEATURE_NOT_PRESENT without compute or multi-draw indirect
+ */
+VkResult ve_gpu_culling_init(const char* shader_path, const char* late_shader_path);
+
+/**
+ * @brief Destroy the culling resources
+ *
+ * The device must be idle.
+ */
+void ve_gpu_culling_shutdown(void);
+
+/**
+ * @brief Check if GPU culling is available
+ *
+ * @return true if initialized
+ */
+bool ve_gpu_culling_is_enabled(void);
+
+/**
+ * @brief Check if the EARLY and LATE phases can be used
+ *
+ * @return true if the late pipeline was created
+ */
+bool ve_gpu_culling_supports_occlusion(void);
+
+/**
+ * @brief Register a mesh range of the bound index buffer
+ *
+ * Meshes are never removed, so frames in flight can keep drawing them.
+ *
+ * @param index_count Number of indices
+ * @param first_index First index
+ * @param vertex_offset Added to each index
+ * @return Mesh index, or VE_GPU_CULL_INVALID_MESH if the table is full
+ */
+uint32_t ve_gpu_culling_add_mesh(uint32_t index_count, uint32_t first_index, int32_t vertex_offset);
+
+/**
+ * @brief Set the current frame's instances
+ *
+ * Instances may come in any batch order; each batch's command range is
+ * sized by its instance count.
+ *
+ * @param instances Instances
+ * @param count Instance count
+ * @return Instances kept, at most VE_GPU_CULL_MAX_INSTANCES
+ */
+uint32_t ve_gpu_culling_set_instances(const ve_gpu_cull_instance* instances, uint32_t count);
+
+/**
+ * @brief Record the culling dispatch for the current frame
+ *
+ * Record outside a render pass, before the batches are drawn. Ends with a
+ * barrier making the commands and counts visible to indirect draws. While
+ * the pipeline is still compiling, every batch draws nothing.
+ *
+ * @param cmd Graphics or compute command buffer
+ * @param view_projection Column-major view-projection matrix
+ */
+void ve_gpu_culling_dispatch(ve_command_buffer* cmd, const float view_projection[16]);
+
+/**
+ * @brief Record the culling dispatch of one phase
+ *
+ * As ve_gpu_culling_dispatch, which is the SINGLE phase. Each phase has
+ * its own commands and counts, so EARLY draws may still be in flight when
+ * LATE is dispatched. The LATE phase reads the Hi-Z pyramid, which must be
+ * visible to compute shaders.
+ *
+ * @param cmd Graphics or compute command buffer
+ * @param phase Phase, EARLY and LATE need ve_gpu_culling_supports_occlusion
+ * @param view_projection Column-major view-projection matrix
+ */
+void ve_gpu_culling_dispatch_phase(ve_command_buffer* cmd, ve_gpu_cull_phase phase,
+                                   const float view_projection[16]);
+
+/**
+ * @brief Draw the visible instances of a batch
+ *
+ * Record inside the render pass with the batch's pipeline, vertex buffers
+ * and index buffer bound.
+ *
+ * @param cmd Graphics command buffer
+ * @param batch Batch index
+ */
+void ve_gpu_culling_draw(ve_command_buffer* cmd, uint32_t batch);
+
+/**
+ * @brief Draw the instances a phase selected in a batch
+ *
+ * @param cmd Graphics command buffer
+ * @param phase Phase dispatched this frame
+ * @param batch Batch index
+ */
+void ve_gpu_culling_draw_phase(ve_command_buffer* cmd, ve_gpu_cull_phase phase, uint32_t batch);
+
+/**
+ * @brief Get statistics of the current frame
+ *
+ * @param stats Output statistics
+ */
+void ve_gpu_culling_get_stats(ve_gpu_culling_stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_GPU_CULLING_H */
@@ -0,0 +1,797 @@
+/**
+ * @file gpu_memory.c
+ * @brief Device memory sub-allocator implementation
+ */
+
+#define VK_NO_PROTOTYPES
+#include "gpu_memory.h"
+
+#include "../core/logger.h"
+#include "../core/assert.h"
+#include "../core/memory.h"
+#include "../core/thread.h"
+
+#include <string.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/* TLSF classes: sizes below VE_TLSF_SMALL_SIZE are split linearly, larger
+   ones by power of two (first level) and VE_TLSF_SL_COUNT steps inside it */
+#define VE_TLSF_SL_LOG2 5
+#define VE_TLSF_SL_COUNT (1u << VE_TLSF_SL_LOG2)
+#define VE_TLSF_SMALL_LOG2 8
+#define VE_TLSF_SMALL_SIZE (1ull << VE_TLSF_SMALL_LOG2)
+#define VE_TLSF_FL_COUNT 32
+
+#define VE_GPU_NODE_NONE UINT32_MAX
+#define VE_GPU_NODE_INITIAL_CAPACITY 64
+
+/* Block pools per memory type: linear, and optimal tiling when kept apart */
+#define VE_GPU_POOL_LINEAR 0
+#define VE_GPU_POOL_OPTIMAL 1
+#define VE_GPU_POOL_COUNT 2
+
+/**
+ * @brief Contiguous range of a block, free or allocated
+ */
+typedef struct ve_gpu_node {
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    uint32_t prev_physical;     /* Neighbouring ranges in address order */
+    uint32_t next_physical;
+    uint32_t prev_free;         /* Free list of the size class; next_free also links unused nodes */
+    uint32_t next_free;
+    bool free;
+} ve_gpu_node;
+
+struct ve_gpu_block {
+    struct ve_gpu_block* next;
+    VkDeviceMemory memory;
+    VkDeviceSize size;
+    VkDeviceSize used;
+    void* mapped;
+    uint32_t memory_type;
+    uint32_t pool;
+    uint32_t allocation_count;
+
+    ve_gpu_node* nodes;
+    uint32_t node_capacity;
+    uint32_t node_count;
+    uint32_t unused_nodes;      /* Recycled node slots */
+
+    uint32_t fl_bitmap;
+    uint32_t sl_bitmap[VE_TLSF_FL_COUNT];
+    uint32_t free_heads[VE_TLSF_FL_COUNT][VE_TLSF_SL_COUNT];
+};
+
+/* Global allocator state */
+static struct {
+    ve_mutex* mutex;
+    bool initialized;
+    bool separate_linear;                   /* bufferImageGranularity above 1 */
+    bool dedicated_info;                    /* VkMemoryDedicatedAllocateInfo available */
+    uint32_t max_allocation_count;
+    uint32_t device_allocation_count;
+    VkDeviceSize block_size[VK_MAX_MEMORY_TYPES];
+    ve_gpu_block* pools[VK_MAX_MEMORY_TYPES][VE_GPU_POOL_COUNT];
+    VkDeviceSize heap_reserved[VK_MAX_MEMORY_HEAPS];    /* Budget usage when the driver does not report it */
+    ve_gpu_memory_stats stats;
+} g_gpu_memory = {0};
+
+static uint32_t bit_scan_forward(uint32_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return (uint32_t)index;
+#else
+    return (uint32_t)__builtin_ctz(value);
+#endif
+}
+
+static uint32_t bit_scan_reverse64(uint64_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return (uint32_t)index;
+#else
+    return 63u - (uint32_t)__builtin_clzll(value);
+#endif
+}
+
+/* Size class holding free ranges of this size */
+static void mapping_insert(VkDeviceSize size, uint32_t* fl, uint32_t* sl) {
+    if (size < VE_TLSF_SMALL_SIZE) {
+        *fl = 0;
+        *sl = (uint32_t)(size / (VE_TLSF_SMALL_SIZE / VE_TLSF_SL_COUNT));
+        return;
+    }
+
+    uint32_t msb = bit_scan_reverse64(size);
+    *sl = (uint32_t)(size >> (msb - VE_TLSF_SL_LOG2)) ^ VE_TLSF_SL_COUNT;
+    *fl = msb - VE_TLSF_SMALL_LOG2 + 1;
+}
+
+/* First size class whose ranges are all at least this size */
+static void mapping_search(VkDeviceSize size, uint32_t* fl, uint32_t* sl) {
+    if (size >= VE_TLSF_SMALL_SIZE) {
+        size += (1ull << (bit_scan_reverse64(size) - VE_TLSF_SL_LOG2)) - 1;
+    } else {
+        size += VE_TLSF_SMALL_SIZE / VE_TLSF_SL_COUNT - 1;
+    }
+    mapping_insert(size, fl, sl);
+}
+
+static void insert_free(ve_gpu_block* block, uint32_t index) {
+    ve_gpu_node* node = &block->nodes[index];
+    uint32_t fl, sl;
+    mapping_insert(node->size, &fl, &sl);
+
+    uint32_t head = block->free_heads[fl][sl];
+    node->free = true;
+    node->prev_free = VE_GPU_NODE_NONE;
+    node->next_free = head;
+    if (head != VE_GPU_NODE_NONE) {
+        block->nodes[head].prev_free = index;
+    }
+
+    block->free_heads[fl][sl] = index;
+    block->fl_bitmap |= 1u << fl;
+    block->sl_bitmap[fl] |= 1u << sl;
+}
+
+static void remove_free(ve_gpu_block* block, uint32_t index) {
+    ve_gpu_node* node = &block->nodes[index];
+    uint32_t fl, sl;
+    mapping_insert(node->size, &fl, &sl);
+
+    if (node->prev_free != VE_GPU_NODE_NONE) {
+        block->nodes[node->prev_free].next_free = node->next_free;
+    } else {
+        block->free_heads[fl][sl] = node->next_free;
+        if (node->next_free == VE_GPU_NODE_NONE) {
+            block->sl_bitmap[fl] &= ~(1u << sl);
+            if (block->sl_bitmap[fl] == 0) {
+                block->fl_bitmap &= ~(1u << fl);
+            }
+        }
+    }
+    if (node->next_free != VE_GPU_NODE_NONE) {
+        block->nodes[node->next_free].prev_free = node->prev_free;
+    }
+
+    node->free = false;
+}
+
+/* Free range of at least the searched size, or VE_GPU_NODE_NONE */
+static uint32_t find_free(ve_gpu_block* block, VkDeviceSize size) {
+    uint32_t fl, sl;
+    mapping_search(size, &fl, &sl);
+    if (fl >= VE_TLSF_FL_COUNT) {
+        return VE_GPU_NODE_NONE;
+    }
+
+    uint32_t sl_map = block->sl_bitmap[fl] & (~0u << sl);
+    if (sl_map == 0) {
+        uint32_t fl_map = (fl + 1 < VE_TLSF_FL_COUNT) ? block->fl_bitmap & (~0u << (fl + 1)) : 0;
+        if (fl_map == 0) {
+            return VE_GPU_NODE_NONE;
+        }
+        fl = bit_scan_forward(fl_map);
+        sl_map = block->sl_bitmap[fl];
+    }
+
+    return block->free_heads[fl][bit_scan_forward(sl_map)];
+}
+
+/* Make room for count new nodes so splitting cannot fail halfway */
+static bool reserve_nodes(ve_gpu_block* block, uint32_t count) {
+    uint32_t available = block->node_capacity - block->node_count;
+    for (uint32_t i = block->unused_nodes; i != VE_GPU_NODE_NONE && available < count;
+         i = block->nodes[i].next_free) {
+        available++;
+    }
+    if (available >= count) {
+        return true;
+    }
+
+    uint32_t capacity = block->node_capacity ? block->node_capacity * 2 : VE_GPU_NODE_INITIAL_CAPACITY;
+    ve_gpu_node* nodes = (ve_gpu_node*)ve_reallocate(block->nodes, capacity * sizeof(ve_gpu_node),
+                                                     VE_MEMORY_TAG_VULKAN);
+    if (!nodes) {
+        return false;
+    }
+
+    block->nodes = nodes;
+    block->node_capacity = capacity;
+    return true;
+}
+
+static uint32_t acquire_node(ve_gpu_block* block) {
+    uint32_t index = block->unused_nodes;
+    if (index != VE_GPU_NODE_NONE) {
+        block->unused_nodes = block->nodes[index].next_free;
+    } else {
+        VE_ASSERT(block->node_count < block->node_capacity);
+        index = block->node_count++;
+    }
+
+    memset(&block->nodes[index], 0, sizeof(ve_gpu_node));
+    return index;
+}
+
+static void release_node(ve_gpu_block* block, uint32_t index) {
+    block->nodes[index].next_free = block->unused_nodes;
+    block->unused_nodes = index;
+}
+
+/* Insert a new free range of size bytes right after index */
+static void split_after(ve_gpu_block* block, uint32_t index, VkDeviceSize size) {
+    uint32_t split = acquire_node(block);
+    ve_gpu_node* node = &block->nodes[index];
+    ve_gpu_node* rest = &block->nodes[split];
+
+    rest->offset = node->offset + node->size - size;
+    rest->size = size;
+    rest->prev_physical = index;
+    rest->next_physical = node->next_physical;
+    if (node->next_physical != VE_GPU_NODE_NONE) {
+        block->nodes[node->next_physical].prev_physical = split;
+    }
+
+    node->next_physical = split;
+    node->size -= size;
+    insert_free(block, split);
+}
+
+/* Insert a new free range of size bytes right before index */
+static void split_before(ve_gpu_block* block, uint32_t index, VkDeviceSize size) {
+    uint32_t split = acquire_node(block);
+    ve_gpu_node* node = &block->nodes[index];
+    ve_gpu_node* front = &block->nodes[split];
+
+    front->offset = node->offset;
+    front->size = size;
+    front->prev_physical = node->prev_physical;
+    front->next_physical = index;
+    if (node->prev_physical != VE_GPU_NODE_NONE) {
+        block->nodes[node->prev_physical].next_physical = split;
+    }
+
+    node->prev_physical = split;
+    node->offset += size;
+    node->size -= size;
+    insert_free(block, split);
+}
+
+static uint32_t block_allocate(ve_gpu_block* block, VkDeviceSize size, VkDeviceSize alignment) {
+    if (block->size - block->used < size || !reserve_nodes(block, 2)) {
+        return VE_GPU_NODE_NONE;
+    }
+
+    /* Any range of the searched class fits the size at any alignment */
+    uint32_t index = find_free(block, size + alignment - 1);
+    if (index == VE_GPU_NODE_NONE) {
+        return VE_GPU_NODE_NONE;
+    }
+
+    remove_free(block, index);
+
+    ve_gpu_node* node = &block->nodes[index];
+    VkDeviceSize padding = ((node->offset + alignment - 1) & ~(alignment - 1)) - node->offset;
+    if (padding > 0) {
+        split_before(block, index, padding);
+    }
+
+    node = &block->nodes[index];
+    if (node->size > size) {
+        split_after(block, index, node->size - size);
+    }
+
+    block->used += size;
+    block->allocation_count++;
+    return index;
+}
+
+static void block_free(ve_gpu_block* block, uint32_t index) {
+    ve_gpu_node* node = &block->nodes[index];
+    VE_ASSERT_MSG(!node->free, "GPU allocation freed twice");
+
+    block->used -= node->size;
+    block->allocation_count--;
+
+    /* Merge with free neighbours; two free ranges are never adjacent */
+    uint32_t next = node->next_physical;
+    if (next != VE_GPU_NODE_NONE && block->nodes[next].free) {
+        remove_free(block, next);
+        node->size += block->nodes[next].size;
+        node->next_physical = block->nodes[next].next_physical;
+        if (node->next_physical != VE_GPU_NODE_NONE) {
+            block->nodes[node->next_physical].prev_physical = index;
+        }
+        release_node(block, next);
+    }
+
+    uint32_t prev = node->prev_physical;
+    if (prev != VE_GPU_NODE_NONE && block->nodes[prev].free) {
+        remove_free(block, prev);
+        ve_gpu_node* merged = &block->nodes[prev];
+        merged->size += node->size;
+        merged->next_physical = node->next_physical;
+        if (merged->next_physical != VE_GPU_NODE_NONE) {
+            block->nodes[merged->next_physical].prev_physical = prev;
+        }
+        release_node(block, index);
+        index = prev;
+    }
+
+    insert_free(block, index);
+}
+
+/* vkAllocateMemory with accounting; dedicated_* may be VK_NULL_HANDLE */
+static VkResult allocate_device_memory(uint32_t memory_type, VkDeviceSize size,
+                                       VkBuffer dedicated_buffer, VkImage dedicated_image,
+                                       VkDeviceMemory* out_memory, void** out_mapped) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+
+    if (g_gpu_memory.device_allocation_count >= g_gpu_memory.max_allocation_count) {
+        VE_LOG_ERROR("Device memory allocation limit (%u) reached", g_gpu_memory.max_allocation_count);
+        return VK_ERROR_TOO_MANY_OBJECTS;
+    }
+
+    VkMemoryDedicatedAllocateInfo dedicated_info = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,
+        .image = dedicated_image,
+        .buffer = dedicated_buffer,
+    };
+
+    VkMemoryAllocateInfo allocate_info = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .allocationSize = size,
+        .memoryTypeIndex = memory_type,
+    };
+    if (g_gpu_memory.dedicated_info &&
+        (dedicated_buffer != VK_NULL_HANDLE || dedicated_image != VK_NULL_HANDLE)) {
+        allocate_info.pNext = &dedicated_info;
+    }
+
+    VkResult result = vkAllocateMemory(vk->device, &allocate_info, NULL, out_memory);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    /* Host-visible memory stays mapped until freed */
+    *out_mapped = NULL;
+    const VkMemoryPropertyFlags properties =
+        vk->device_properties.memory_properties.memoryTypes[memory_type].propertyFlags;
+    if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        result = vkMapMemory(vk->device, *out_memory, 0, VK_WHOLE_SIZE, 0, out_mapped);
+        if (result != VK_SUCCESS) {
+            vkFreeMemory(vk->device, *out_memory, NULL);
+            *out_memory = VK_NULL_HANDLE;
+            return result;
+        }
+    }
+
+    g_gpu_memory.device_allocation_count++;
+    g_gpu_memory.stats.reserved_bytes += size;
+    g_gpu_memory.heap_reserved[vk->device_properties.memory_properties.memoryTypes[memory_type].heapIndex] += size;
+    ve_memory_record_external(VE_MEMORY_TAG_VULKAN, (int64_t)size);
+    return VK_SUCCESS;
+}
+
+static void free_device_memory(VkDeviceMemory memory, uint32_t memory_type, VkDeviceSize size) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+
+    /* Freeing implicitly unmaps */
+    vkFreeMemory(vk->device, memory, NULL);
+
+    g_gpu_memory.device_allocation_count--;
+    g_gpu_memory.stats.reserved_bytes -= size;
+    g_gpu_memory.heap_reserved[vk->device_properties.memory_properties.memoryTypes[memory_type].heapIndex] -= size;
+    ve_memory_record_external(VE_MEMORY_TAG_VULKAN, -(int64_t)size);
+}
+
+static ve_gpu_block* create_block(uint32_t memory_type, uint32_t pool, VkDeviceSize size) {
+    ve_gpu_block* block = (ve_gpu_block*)ve_allocate_cleared(1, sizeof(ve_gpu_block), VE_MEMORY_TAG_VULKAN);
+    if (!block) {
+        return NULL;
+    }
+
+    memset(block->free_heads, 0xff, sizeof(block->free_heads));
+    block->unused_nodes = VE_GPU_NODE_NONE;
+    block->size = size;
+    block->memory_type = memory_type;
+    block->pool = pool;
+
+    if (!reserve_nodes(block, 1) ||
+        allocate_device_memory(memory_type, size, VK_NULL_HANDLE, VK_NULL_HANDLE,
+                               &block->memory, &block->mapped) != VK_SUCCESS) {
+        VE_FREE(block->nodes);
+        VE_FREE(block);
+        return NULL;
+    }
+
+    /* The whole block starts as one free range */
+    uint32_t index = acquire_node(block);
+    block->nodes[index].size = size;
+    block->nodes[index].prev_physical = VE_GPU_NODE_NONE;
+    block->nodes[index].next_physical = VE_GPU_NODE_NONE;
+    insert_free(block, index);
+
+    g_gpu_memory.stats.block_count++;
+    return block;
+}
+
+static void destroy_block(ve_gpu_block* block) {
+    free_device_memory(block->memory, block->memory_type, block->size);
+    g_gpu_memory.stats.block_count--;
+
+    VE_FREE(block->nodes);
+    VE_FREE(block);
+}
+
+bool ve_gpu_memory_init(void) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VE_ASSERT(vk && vk->device);
+
+    memset(&g_gpu_memory, 0, sizeof(g_gpu_memory));
+
+    g_gpu_memory.mutex = ve_mutex_create();
+    if (!g_gpu_memory.mutex) {
+        VE_LOG_ERROR("Failed to create GPU memory mutex");
+        return false;
+    }
+
+    const VkPhysicalDeviceProperties* properties = &vk->device_properties.properties;
+    const VkPhysicalDeviceMemoryProperties* memory = &vk->device_properties.memory_properties;
+
+    g_gpu_memory.separate_linear = properties->limits.bufferImageGranularity > 1;
+    g_gpu_memory.dedicated_info = properties->apiVersion >= VK_API_VERSION_1_1;
+    g_gpu_memory.max_allocation_count = properties->limits.maxMemoryAllocationCount;
+
+    /* Small heaps (e.g. the 256 MB BAR heap) get proportionally smaller blocks */
+    for (uint32_t i = 0; i < memory->memoryTypeCount; i++) {
+        VkDeviceSize heap_size = memory->memoryHeaps[memory->memoryTypes[i].heapIndex].size;
+        g_gpu_memory.block_size[i] = heap_size <= 1024ull * 1024 * 1024 ?
+            heap_size / 8 : VE_GPU_MEMORY_BLOCK_SIZE;
+    }
+
+    g_gpu_memory.initialized = true;
+
+    VE_LOG_INFO("GPU memory allocator initialized (granularity %llu)",
+                (unsigned long long)properties->limits.bufferImageGranularity);
+    return true;
+}
+
+void ve_gpu_memory_shutdown(void) {
+    if (!g_gpu_memory.initialized) {
+        return;
+    }
+
+    if (g_gpu_memory.stats.allocation_count > 0) {
+        VE_LOG_WARN("%u GPU allocations still alive at shutdown",
+                    g_gpu_memory.stats.allocation_count);
+    }
+
+    for (uint32_t type = 0; type < VK_MAX_MEMORY_TYPES; type++) {
+        for (uint32_t pool = 0; pool < VE_GPU_POOL_COUNT; pool++) {
+            ve_gpu_block* block = g_gpu_memory.pools[type][pool];
+            while (block) {
+                ve_gpu_block* next = block->next;
+                destroy_block(block);
+                block = next;
+            }
+        }
+    }
+
+    ve_mutex_destroy(g_gpu_memory.mutex);
+    memset(&g_gpu_memory, 0, sizeof(g_gpu_memory));
+}
+
+uint32_t ve_gpu_memory_find_type(uint32_t type_bits,
+                                 VkMemoryPropertyFlags required,
+                                 VkMemoryPropertyFlags preferred)
+{
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    const VkPhysicalDeviceMemoryProperties* memory = &vk->device_properties.memory_properties;
+
+    /* Memory types are ordered by preference, take the first match */
+    for (int pass = 0; pass < 2; pass++) {
+        VkMemoryPropertyFlags wanted = pass == 0 ? required | preferred : required;
+        for (uint32_t i = 0; i < memory->memoryTypeCount; i++) {
+            if ((type_bits & (1u << i)) &&
+                (memory->memoryTypes[i].propertyFlags & wanted) == wanted) {
+                return i;
+            }
+        }
+    }
+
+    return UINT32_MAX;
+}
+
+static uint32_t choose_memory_type(uint32_t type_bits, ve_gpu_memory_usage usage) {
+    switch (usage) {
+        case VE_GPU_MEMORY_USAGE_CPU_TO_GPU:
+            return ve_gpu_memory_find_type(type_bits,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        case VE_GPU_MEMORY_USAGE_GPU_TO_CPU:
+            return ve_gpu_memory_find_type(type_bits,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+                VK_MEMORY_PROPERTY_HOST_CACHED_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        case VE_GPU_MEMORY_USAGE_GPU_LAZY:
+            /* Tiled GPUs may then never back the attachment with physical memory */
+            return ve_gpu_memory_find_type(type_bits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+        case VE_GPU_MEMORY_USAGE_GPU_ONLY:
+        default:
+            return ve_gpu_memory_find_type(type_bits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0);
+    }
+}
+
+static VkResult allocate_dedicated(uint32_t memory_type, const VkMemoryRequirements* requirements,
+                                   VkBuffer buffer, VkImage image, ve_gpu_allocation* out_allocation) {
+    VkResult result = allocate_device_memory(memory_type, requirements->size, buffer, image,
+                                             &out_allocation->memory, &out_allocation->mapped);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    out_allocation->offset = 0;
+    out_allocation->size = requirements->size;
+    out_allocation->memory_type = memory_type;
+    out_allocation->block = NULL;
+    out_allocation->node = VE_GPU_NODE_NONE;
+
+    g_gpu_memory.stats.dedicated_count++;
+    return VK_SUCCESS;
+}
+
+static VkResult allocate_locked(const VkMemoryRequirements* requirements, ve_gpu_memory_usage usage,
+                                uint32_t flags, VkBuffer buffer, VkImage image,
+                                ve_gpu_allocation* out_allocation) {
+    uint32_t memory_type = choose_memory_type(requirements->memoryTypeBits, usage);
+    if (memory_type == UINT32_MAX) {
+        VE_LOG_ERROR("No memory type for usage %d (type bits 0x%x)", usage, requirements->memoryTypeBits);
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    VkDeviceSize block_size = g_gpu_memory.block_size[memory_type];
+    if ((flags & VE_GPU_ALLOCATION_DEDICATED) || requirements->size > block_size / 2) {
+        return allocate_dedicated(memory_type, requirements, buffer, image, out_allocation);
+    }
+
+    uint32_t pool = (g_gpu_memory.separate_linear && !(flags & VE_GPU_ALLOCATION_LINEAR)) ?
+        VE_GPU_POOL_OPTIMAL : VE_GPU_POOL_LINEAR;
+    VkDeviceSize alignment = requirements->alignment ? requirements->alignment : 1;
+
+    ve_gpu_block* block = g_gpu_memory.pools[memory_type][pool];
+    uint32_t node = VE_GPU_NODE_NONE;
+    for (; block; block = block->next) {
+        node = block_allocate(block, requirements->size, alignment);
+        if (node != VE_GPU_NODE_NONE) {
+            break;
+        }
+    }
+
+    if (!block) {
+        block = create_block(memory_type, pool, block_size);
+        if (!block) {
+            /* The heap may still fit the resource on its own */
+            return allocate_dedicated(memory_type, requirements, buffer, image, out_allocation);
+        }
+        block->next = g_gpu_memory.pools[memory_type][pool];
+        g_gpu_memory.pools[memory_type][pool] = block;
+
+        node = block_allocate(block, requirements->size, alignment);
+        VE_ASSERT(node != VE_GPU_NODE_NONE);
+    }
+
+    out_allocation->memory = block->memory;
+    out_allocation->offset = block->nodes[node].offset;
+    out_allocation->size = requirements->size;
+    out_allocation->mapped = block->mapped ? (uint8_t*)block->mapped + out_allocation->offset : NULL;
+    out_allocation->memory_type = memory_type;
+    out_allocation->block = block;
+    out_allocation->node = node;
+    return VK_SUCCESS;
+}
+
+static VkResult allocate_resource(const VkMemoryRequirements* requirements, ve_gpu_memory_usage usage,
+                                  uint32_t flags, VkBuffer buffer, VkImage image,
+                                  ve_gpu_allocation* out_allocation) {
+    VE_ASSERT(g_gpu_memory.initialized && requirements && out_allocation);
+    memset(out_allocation, 0, sizeof(ve_gpu_allocation));
+
+    ve_mutex_lock(g_gpu_memory.mutex);
+    VkResult result = allocate_locked(requirements, usage, flags, buffer, image, out_allocation);
+    if (result == VK_SUCCESS) {
+        g_gpu_memory.stats.allocation_count++;
+        g_gpu_memory.stats.used_bytes += out_allocation->size;
+    }
+    ve_mutex_unlock(g_gpu_memory.mutex);
+
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to allocate %llu bytes of GPU memory: %d",
+                     (unsigned long long)requirements->size, result);
+    }
+    return result;
+}
+
+VkResult ve_gpu_memory_allocate(const VkMemoryRequirements* requirements,
+                                ve_gpu_memory_usage usage,
+                                uint32_t flags,
+                                ve_gpu_allocation* out_allocation)
+{
+    return allocate_resource(requirements, usage, flags, VK_NULL_HANDLE, VK_NULL_HANDLE, out_allocation);
+}
+
+VkResult ve_gpu_memory_allocate_buffer(VkBuffer buffer,
+                                       ve_gpu_memory_usage usage,
+                                       uint32_t flags,
+                                       ve_gpu_allocation* out_allocation)
+{
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VkMemoryRequirements requirements;
+
+    if (g_gpu_memory.dedicated_info) {
+        VkMemoryDedicatedRequirements dedicated = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS,
+        };
+        VkMemoryRequirements2 requirements2 = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2,
+            .pNext = &dedicated,
+        };
+        VkBufferMemoryRequirementsInfo2 info = {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2,
+            .buffer = buffer,
+        };
+        vkGetBufferMemoryRequirements2(vk->device, &info, &requirements2);
+
+        requirements = requirements2.memoryRequirements;
+        if (dedicated.prefersDedicatedAllocation || dedicated.requiresDedicatedAllocation) {
+            flags |= VE_GPU_ALLOCATION_DEDICATED;
+        }
+    } else {
+        vkGetBufferMemoryRequirements(vk->device, buffer, &requirements);
+    }
+
+    VkResult result = allocate_resource(&requirements, usage, flags | VE_GPU_ALLOCATION_LINEAR,
+                                        buffer, VK_NULL_HANDLE, out_allocation);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    result = vkBindBufferMemory(vk->device, buffer, out_allocation->memory, out_allocation->offset);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to bind buffer memory: %d", result);
+        ve_gpu_memory_free(out_allocation);
+    }
+    return result;
+}
+
+VkResult ve_gpu_memory_allocate_image(VkImage image,
+                                      ve_gpu_memory_usage usage,
+                                      uint32_t flags,
+                                      ve_gpu_allocation* out_allocation)
+{
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VkMemoryRequirements requirements;
+
+    if (g_gpu_memory.dedicated_info) {
+        VkMemoryDedicatedRequirements dedicated = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS,
+        };
+        VkMemoryRequirements2 requirements2 = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2,
+            .pNext = &dedicated,
+        };
+        VkImageMemoryRequirementsInfo2 info = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2,
+            .image = image,
+        };
+        vkGetImageMemoryRequirements2(vk->device, &info, &requirements2);
+
+        requirements = requirements2.memoryRequirements;
+        if (dedicated.prefersDedicatedAllocation || dedicated.requiresDedicatedAllocation) {
+            flags |= VE_GPU_ALLOCATION_DEDICATED;
+        }
+    } else {
+        vkGetImageMemoryRequirements(vk->device, image, &requirements);
+    }
+
+    VkResult result = allocate_resource(&requirements, usage, flags, VK_NULL_HANDLE, image, out_allocation);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    result = vkBindImageMemory(vk->device, image, out_allocation->memory, out_allocation->offset);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to bind image memory: %d", result);
+        ve_gpu_memory_free(out_allocation);
+    }
+    return result;
+}
+
+void ve_gpu_memory_free(ve_gpu_allocation* allocation) {
+    if (!allocation || allocation->memory == VK_NULL_HANDLE) {
+        return;
+    }
+
+    ve_mutex_lock(g_gpu_memory.mutex);
+
+    g_gpu_memory.stats.allocation_count--;
+    g_gpu_memory.stats.used_bytes -= allocation->size;
+
+    ve_gpu_block* block = allocation->block;
+    if (!block) {
+        free_device_memory(allocation->memory, allocation->memory_type, allocation->size);
+        g_gpu_memory.stats.dedicated_count--;
+    } else {
+        block_free(block, allocation->node);
+
+        /* Keep one empty block per pool to absorb allocation churn */
+        ve_gpu_block** link = &g_gpu_memory.pools[block->memory_type][block->pool];
+        if (block->allocation_count == 0 && (*link)->next) {
+            while (*link != block) {
+                link = &(*link)->next;
+            }
+            *link = block->next;
+            destroy_block(block);
+        }
+    }
+
+    ve_mutex_unlock(g_gpu_memory.mutex);
+    memset(allocation, 0, sizeof(ve_gpu_allocation));
+}
+
+void ve_gpu_memory_get_stats(ve_gpu_memory_stats* stats) {
+    if (!stats) {
+        return;
+    }
+
+    if (!g_gpu_memory.initialized) {
+        memset(stats, 0, sizeof(ve_gpu_memory_stats));
+        return;
+    }
+
+    ve_mutex_lock(g_gpu_memory.mutex);
+    *stats = g_gpu_memory.stats;
+    ve_mutex_unlock(g_gpu_memory.mutex);
+}
+
+uint32_t ve_gpu_memory_get_budget(ve_gpu_heap_budget* budgets, uint32_t capacity) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    if (!g_gpu_memory.initialized || !budgets) {
+        return 0;
+    }
+
+    const VkPhysicalDeviceMemoryProperties* memory = &vk->device_properties.memory_properties;
+    uint32_t count = memory->memoryHeapCount < capacity ? memory->memoryHeapCount : capacity;
+
+    /* The driver's view includes other processes and allocations made outside this allocator */
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget_properties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT,
+    };
+    bool reported = vk->device_features.memoryBudget;
+    if (reported) {
+        VkPhysicalDeviceMemoryProperties2 properties2 = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+            .pNext = &budget_properties,
+        };
+        vkGetPhysicalDeviceMemoryProperties2(vk->physical_device, &properties2);
+    }
+
+    ve_mutex_lock(g_gpu_memory.mutex);
+    for (uint32_t i = 0; i < count; i++) {
+        budgets[i].size = memory->memoryHeaps[i].size;
+        budgets[i].device_local = (memory->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+        budgets[i].reserved = g_gpu_memory.heap_reserved[i];
+        budgets[i].budget = reported ? budget_properties.heapBudget[i] : memory->memoryHeaps[i].size;
+        budgets[i].usage = reported ? budget_properties.heapUsage[i] : g_gpu_memory.heap_reserved[i];
+    }
+    ve_mutex_unlock(g_gpu_memory.mutex);
+    return count;
+}
@@ -0,0 +1,197 @@
+/**
+ * @file gpu_memory.h
+ * @brief Device memory sub-allocator
+ *
+ * Buffers and images are placed in large VkDeviceMemory blocks, one heap
+ * of blocks per memory type, instead of one vkAllocateMemory each, which
+ * keeps the engine far below maxMemoryAllocationCount. Blocks are managed
+ * with a TLSF (two-level segregated fit) allocator: allocation and free are
+ * constant time and neighbouring free ranges are merged immediately.
+ *
+ * When bufferImageGranularity is above 1, linear resources (buffers and
+ * linear-tiling images) and optimal-tiling images are kept in separate
+ * blocks so they never share a granularity page. Resources the driver
+ * prefers dedicated, explicitly flagged ones and those larger than half a
+ * block get their own allocation.
+ *
+ * Host-visible blocks stay mapped for their whole lifetime. Reserved device
+ * memory is reported through ve_memory_get_stats under VE_MEMORY_TAG_VULKAN.
+ * All functions are thread-safe.
+ */
+
+#ifndef VE_GPU_MEMORY_H
+#define VE_GPU_MEMORY_H
+
+#include "vulkan_core.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Block size for heaps larger than 1 GB; smaller heaps use an eighth of their size */
+#define VE_GPU_MEMORY_BLOCK_SIZE (64ull * 1024 * 1024)
+
+/**
+ * @brief Intended access pattern, used to pick a memory type
+ */
+typedef enum ve_gpu_memory_usage {
+    VE_GPU_MEMORY_USAGE_GPU_ONLY,       /* Device local, not host visible */
+    VE_GPU_MEMORY_USAGE_CPU_TO_GPU,     /* Host visible uploads, device local when available */
+    VE_GPU_MEMORY_USAGE_GPU_TO_CPU,     /* Host visible readback, cached when available */
+    VE_GPU_MEMORY_USAGE_GPU_LAZY,       /* Transient attachments, lazily allocated when available */
+} ve_gpu_memory_usage;
+
+/**
+ * @brief Allocation flags
+ */
+typedef enum ve_gpu_allocation_flags {
+    VE_GPU_ALLOCATION_NONE       = 0,
+    VE_GPU_ALLOCATION_DEDICATED  = 1 << 0,  /* Own VkDeviceMemory, e.g. large render targets */
+    VE_GPU_ALLOCATION_LINEAR     = 1 << 1,  /* Buffer or linear-tiling image */
+} ve_gpu_allocation_flags;
+
+/* Block of device memory divided between resources */
+typedef struct ve_gpu_block ve_gpu_block;
+
+/**
+ * @brief Memory bound to a resource
+ */
+typedef struct ve_gpu_allocation {
+    VkDeviceMemory memory;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    void* mapped;               /* Host pointer to offset, NULL unless host visible */
+    uint32_t memory_type;
+    ve_gpu_block* block;        /* NULL for dedicated allocations */
+    uint32_t node;              /* Range inside the block */
+} ve_gpu_allocation;
+
+/**
+ * @brief Allocator statistics
+ */
+typedef struct ve_gpu_memory_stats {
+    uint32_t block_count;
+    uint32_t dedicated_count;
+    uint32_t allocation_count;      /* Live sub-allocations and dedicated allocations */
+    VkDeviceSize reserved_bytes;    /* Allocated from the device */
+    VkDeviceSize used_bytes;        /* Handed out to resources */
+} ve_gpu_memory_stats;
+
+/**
+ * @brief Memory budget of one heap
+ */
+typedef struct ve_gpu_heap_budget {
+    VkDeviceSize size;              /* Heap size */
+    VkDeviceSize budget;            /* What the process can use before allocations fail or get slow */
+    VkDeviceSize usage;             /* Used by the process, including allocations outside this allocator */
+    VkDeviceSize reserved;          /* Allocated from the heap by this allocator */
+    bool device_local;
+} ve_gpu_heap_budget;
+
+/**
+ * @brief Initialize the allocator
+ *
+ * Must be called after the device is created.
+ *
+ * @return true on success
+ */
+bool ve_gpu_memory_init(void);
+
+/**
+ * @brief Free every block and dedicated allocation
+ *
+ * The device must be idle. Live allocations are reported as leaks.
+ */
+void ve_gpu_memory_shutdown(void);
+
+/**
+ * @brief Allocate memory for the given requirements
+ *
+ * @param requirements Requirements from vkGet*MemoryRequirements
+ * @param usage Intended access pattern
+ * @param flags Combination of ve_gpu_allocation_flags
+ * @param out_allocation Receives the allocation
+ * @return VK_SUCCESS on success
+ */
+VkResult ve_gpu_memory_allocate(const VkMemoryRequirements* requirements,
+                                ve_gpu_memory_usage usage,
+                                uint32_t flags,
+                                ve_gpu_allocation* out_allocation);
+
+/**
+ * @brief Allocate and bind memory for a buffer
+ *
+ * @param buffer Buffer without memory
+ * @param usage Intended access pattern
+ * @param flags Combination of ve_gpu_allocation_flags, LINEAR is implied
+ * @param out_allocation Receives the allocation
+ * @return VK_SUCCESS on success
+ */
+VkResult ve_gpu_memory_allocate_buffer(VkBuffer buffer,
+                                       ve_gpu_memory_usage usage,
+                                       uint32_t flags,
+                                       ve_gpu_allocation* out_allocation);
+
+/**
+ * @brief Allocate and bind memory for an image
+ *
+ * @param image Image without memory
+ * @param usage Intended access pattern
+ * @param flags Combination of ve_gpu_allocation_flags, LINEAR for linear tiling
+ * @param out_allocation Receives the allocation
+ * @return VK_SUCCESS on success
+ */
+VkResult ve_gpu_memory_allocate_image(VkImage image,
+                                      ve_gpu_memory_usage usage,
+                                      uint32_t flags,
+                                      ve_gpu_allocation* out_allocation);
+
+/**
+ * @brief Return an allocation to its block
+ *
+ * The GPU must be done with the resource; defer through the deletion queue
+ * when frames in flight may still use it.
+ *
+ * @param allocation Allocation to free, cleared on return
+ */
+void ve_gpu_memory_free(ve_gpu_allocation* allocation);
+
+/**
+ * @brief Find a memory type
+ *
+ * @param type_bits Allowed memory types (VkMemoryRequirements::memoryTypeBits)
+ * @param required Property flags the type must have
+ * @param preferred Additional property flags to favour
+ * @return Memory type index, or UINT32_MAX if none matches
+ */
+uint32_t ve_gpu_memory_find_type(uint32_t type_bits,
+                                 VkMemoryPropertyFlags required,
+                                 VkMemoryPropertyFlags preferred);
+
+/**
+ * @brief Get allocator statistics
+ *
+ * @param stats Output statistics
+ */
+void ve_gpu_memory_get_stats(ve_gpu_memory_stats* stats);
+
+/**
+ * @brief Get the memory budget of each heap
+ *
+ * Budget and usage come from VK_EXT_memory_budget when the device has it,
+ * and otherwise fall back to the heap size and this allocator's own
+ * reservations. The values change with other processes' usage, so query
+ * them again rather than caching them.
+ *
+ * @param budgets Receives one entry per heap
+ * @param capacity Room in budgets, VK_MAX_MEMORY_HEAPS covers every device
+ * @return Number of heaps written
+ */
+uint32_t ve_gpu_memory_get_budget(ve_gpu_heap_budget* budgets, uint32_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_GPU_MEMORY_H */
@@ -0,0 +1,400 @@
+/**
+ * @file gpu_profiler.c
+ * @brief GPU timestamp profiler implementation
+ */
+
+#define VK_NO_PROTOTYPES
+#include "gpu_profiler.h"
+#include "sync.h"
+
+#include "../core/logger.h"
+#include "../core/assert.h"
+#include "../core/memory.h"
+#include "../core/profiler.h"
+
+#include <string.h>
+
+#define VE_GPU_PROFILER_MAX_QUERIES (VE_GPU_PROFILER_MAX_ZONES * 2)
+#define VE_GPU_PROFILER_NO_QUERY UINT32_MAX
+
+/**
+ * @brief Zone recorded into a frame's command buffer
+ */
+typedef struct ve_gpu_profiler_zone {
+    const char* name;
+    const char* parent;
+    uint32_t depth;
+    uint32_t begin_query;
+    uint32_t end_query;
+} ve_gpu_profiler_zone;
+
+/**
+ * @brief Query pool and zones of one frame in flight
+ */
+typedef struct ve_gpu_profiler_frame {
+    VkQueryPool pool;
+    ve_gpu_profiler_zone zones[VE_GPU_PROFILER_MAX_ZONES];
+    uint32_t zone_count;
+    uint32_t query_count;
+    bool pending;           /* Recorded but not read back yet */
+} ve_gpu_profiler_frame;
+
+/* GPU profiler state */
+static struct {
+    ve_gpu_profiler_frame frames[VE_MAX_FRAMES_IN_FLIGHT];
+
+    /* Recording state */
+    VkCommandBuffer cmd;
+    ve_gpu_profiler_frame* current;
+    uint32_t stack[VE_GPU_PROFILER_MAX_DEPTH];
+    uint32_t depth;         /* Open zones, including ones that are not timed */
+
+    /* Timestamp conversion */
+    double timestamp_period;        /* Nanoseconds per GPU tick */
+    uint64_t timestamp_mask;
+    uint64_t calibration_gpu;
+    ve_timestamp calibration_cpu;
+    double cpu_ticks_per_ns;
+    bool host_reset;
+
+    /* Last collected frame */
+    ve_gpu_zone_result results[VE_GPU_PROFILER_MAX_ZONES];
+    uint32_t result_count;
+    double frame_time_ms;
+
+    uint32_t track;
+    bool initialized;
+} g_gpu_profiler = {0};
+
+/* Convert a GPU timestamp to ve_timer_now units */
+static ve_timestamp gpu_to_cpu_time(uint64_t ticks) {
+    uint64_t elapsed = (ticks - g_gpu_profiler.calibration_gpu) & g_gpu_profiler.timestamp_mask;
+    double ns = (double)elapsed * g_gpu_profiler.timestamp_period;
+    return g_gpu_profiler.calibration_cpu + (ve_timestamp)(ns * g_gpu_profiler.cpu_ticks_per_ns);
+}
+
+/**
+ * @brief Pair a GPU timestamp with ve_timer_now
+ *
+ * Submits a single timestamp write and takes the midpoint of the CPU time
+ * around the submission as its CPU time. Runs once at startup.
+ */
+static VkResult calibrate_timestamps(void) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VkQueryPool pool = g_gpu_profiler.frames[0].pool;
+
+    VkCommandPoolCreateInfo pool_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = vk->queue_families.graphics_family,
+    };
+
+    VkCommandPool command_pool = VK_NULL_HANDLE;
+    VkResult result = vkCreateCommandPool(vk->device, &pool_info, NULL, &command_pool);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    VkCommandBufferAllocateInfo alloc_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = command_pool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1,
+    };
+
+    VkCommandBuffer cmd = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+    result = vkAllocateCommandBuffers(vk->device, &alloc_info, &cmd);
+    if (result == VK_SUCCESS) {
+        fence = ve_sync_create_fence(0, "gpu_profiler_calibration");
+        if (fence == VK_NULL_HANDLE) {
+            result = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        }
+    }
+
+    if (result == VK_SUCCESS) {
+        VkCommandBufferBeginInfo begin_info = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        };
+        vkBeginCommandBuffer(cmd, &begin_info);
+        vkCmdResetQueryPool(cmd, pool, 0, 1);
+        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, pool, 0);
+        result = vkEndCommandBuffer(cmd);
+    }
+
+    if (result == VK_SUCCESS) {
+        VkSubmitInfo submit_info = {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &cmd,
+        };
+
+        ve_timestamp cpu_before = ve_timer_now();
+        result = vkQueueSubmit(vk->queues.graphics, 1, &submit_info, fence);
+        if (result == VK_SUCCESS) {
+            result = vkWaitForFences(vk->device, 1, &fence, VK_TRUE, UINT64_MAX);
+        }
+        ve_timestamp cpu_after = ve_timer_now();
+
+        uint64_t gpu_time = 0;
+        if (result == VK_SUCCESS) {
+            result = vkGetQueryPoolResults(vk->device, pool, 0, 1, sizeof(gpu_time), &gpu_time,
+                                           sizeof(gpu_time), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+        }
+
+        g_gpu_profiler.calibration_gpu = gpu_time & g_gpu_profiler.timestamp_mask;
+        g_gpu_profiler.calibration_cpu = cpu_before + (cpu_after - cpu_before) / 2;
+    }
+
+    ve_sync_destroy_fence(fence);
+    vkDestroyCommandPool(vk->device, command_pool, NULL);
+    return result;
+}
+
+VkResult ve_gpu_profiler_init(void) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VE_ASSERT(vk && vk->device);
+
+    memset(&g_gpu_profiler, 0, sizeof(g_gpu_profiler));
+
+    /* Timestamp support of the graphics queue */
+    uint32_t family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(vk->physical_device, &family_count, NULL);
+
+    VkQueueFamilyProperties* families = (VkQueueFamilyProperties*)VE_ALLOCATE_TAG(
+        family_count * sizeof(VkQueueFamilyProperties), VE_MEMORY_TAG_VULKAN);
+    if (!families) {
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+    vkGetPhysicalDeviceQueueFamilyProperties(vk->physical_device, &family_count, families);
+
+    uint32_t valid_bits = 0;
+    if (vk->queue_families.graphics_family < family_count) {
+        valid_bits = families[vk->queue_families.graphics_family].timestampValidBits;
+    }
+    VE_FREE(families);
+
+    const VkPhysicalDeviceLimits* limits = &vk->device_properties.properties.limits;
+    if (valid_bits == 0 || limits->timestampPeriod <= 0.0f) {
+        VE_LOG_WARN("Graphics queue does not support timestamps, GPU profiler disabled");
+        return VK_SUCCESS;
+    }
+
+    g_gpu_profiler.timestamp_period = (double)limits->timestampPeriod;
+    g_gpu_profiler.timestamp_mask = valid_bits >= 64 ? UINT64_MAX : ((1ull << valid_bits) - 1);
+    g_gpu_profiler.cpu_ticks_per_ns = 1e-9 / ve_timer_to_seconds(1);
+    g_gpu_profiler.host_reset = vk->device_features.hostQueryReset;
+
+    /* One query pool per frame in flight */
+    for (uint32_t i = 0; i < VE_MAX_FRAMES_IN_FLIGHT; i++) {
+        VkQueryPoolCreateInfo pool_info = {
+            .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .queryType = VK_QUERY_TYPE_TIMESTAMP,
+            .queryCount = VE_GPU_PROFILER_MAX_QUERIES,
+        };
+
+        VkResult result = vkCreateQueryPool(vk->device, &pool_info, NULL, &g_gpu_profiler.frames[i].pool);
+        if (result != VK_SUCCESS) {
+            VE_LOG_ERROR("Failed to create timestamp query pool for frame %u: %d", i, result);
+            ve_gpu_profiler_shutdown();
+            return result;
+        }
+        VE_VK_SET_OBJECT_NAME(g_gpu_profiler.frames[i].pool, VK_OBJECT_TYPE_QUERY_POOL, "gpu_profiler_timestamps");
+    }
+
+    VkResult result = calibrate_timestamps();
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to calibrate GPU timestamps: %d", result);
+        ve_gpu_profiler_shutdown();
+        return result;
+    }
+
+    /* Fresh pools must be reset before their first use */
+    if (g_gpu_profiler.host_reset) {
+        for (uint32_t i = 0; i < VE_MAX_FRAMES_IN_FLIGHT; i++) {
+            vkResetQueryPool(vk->device, g_gpu_profiler.frames[i].pool, 0, VE_GPU_PROFILER_MAX_QUERIES);
+        }
+    }
+
+    g_gpu_profiler.track = ve_profiler_register_track("GPU");
+    g_gpu_profiler.initialized = true;
+
+    VE_LOG_INFO("GPU profiler initialized (%u valid timestamp bits, %.3f ns per tick, %s query reset)",
+                valid_bits, g_gpu_profiler.timestamp_period, g_gpu_profiler.host_reset ? "host" : "command");
+    return VK_SUCCESS;
+}
+
+void ve_gpu_profiler_shutdown(void) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    if (!vk || !vk->device) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < VE_MAX_FRAMES_IN_FLIGHT; i++) {
+        if (g_gpu_profiler.frames[i].pool != VK_NULL_HANDLE) {
+            vkDestroyQueryPool(vk->device, g_gpu_profiler.frames[i].pool, NULL);
+        }
+    }
+
+    memset(&g_gpu_profiler, 0, sizeof(g_gpu_profiler));
+}
+
+bool ve_gpu_profiler_is_enabled(void) {
+    return g_gpu_profiler.initialized;
+}
+
+void ve_gpu_profiler_begin_frame(VkCommandBuffer cmd) {
+    if (!g_gpu_profiler.initialized) {
+        return;
+    }
+
+    ve_gpu_profiler_frame* frame = &g_gpu_profiler.frames[ve_sync_get_current_frame_index()];
+
+    /* Results of a frame that was never collected are lost */
+    if (!g_gpu_profiler.host_reset || frame->pending) {
+        vkCmdResetQueryPool(cmd, frame->pool, 0, VE_GPU_PROFILER_MAX_QUERIES);
+    }
+
+    frame->zone_count = 0;
+    frame->query_count = 0;
+    frame->pending = true;
+
+    g_gpu_profiler.cmd = cmd;
+    g_gpu_profiler.current = frame;
+    g_gpu_profiler.depth = 0;
+}
+
+void ve_gpu_profiler_begin_zone(VkCommandBuffer cmd, const char* name) {
+    ve_gpu_profiler_frame* frame = g_gpu_profiler.current;
+    if (!frame || cmd != g_gpu_profiler.cmd) {
+        return;
+    }
+
+    uint32_t depth = g_gpu_profiler.depth++;
+    if (depth >= VE_GPU_PROFILER_MAX_DEPTH) {
+        return;
+    }
+
+    if (!name || frame->zone_count >= VE_GPU_PROFILER_MAX_ZONES ||
+        frame->query_count + 2 > VE_GPU_PROFILER_MAX_QUERIES) {
+        g_gpu_profiler.stack[depth] = VE_GPU_PROFILER_NO_QUERY;
+        return;
+    }
+
+    uint32_t parent = depth > 0 ? g_gpu_profiler.stack[depth - 1] : VE_GPU_PROFILER_NO_QUERY;
+
+    ve_gpu_profiler_zone* zone = &frame->zones[frame->zone_count];
+    zone->name = name;
+    zone->parent = parent != VE_GPU_PROFILER_NO_QUERY ? frame->zones[parent].name : NULL;
+    zone->depth = depth;
+    zone->begin_query = frame->query_count++;
+    zone->end_query = VE_GPU_PROFILER_NO_QUERY;
+
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame->pool, zone->begin_query);
+    g_gpu_profiler.stack[depth] = frame->zone_count++;
+}
+
+void ve_gpu_profiler_end_zone(VkCommandBuffer cmd) {
+    ve_gpu_profiler_frame* frame = g_gpu_profiler.current;
+    if (!frame || cmd != g_gpu_profiler.cmd || g_gpu_profiler.depth == 0) {
+        return;
+    }
+
+    uint32_t depth = --g_gpu_profiler.depth;
+    if (depth >= VE_GPU_PROFILER_MAX_DEPTH || g_gpu_profiler.stack[depth] == VE_GPU_PROFILER_NO_QUERY) {
+        return;
+    }
+
+    ve_gpu_profiler_zone* zone = &frame->zones[g_gpu_profiler.stack[depth]];
+    zone->end_query = frame->query_count++;
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame->pool, zone->end_query);
+}
+
+void ve_gpu_profiler_collect(uint32_t frame_index) {
+    if (!g_gpu_profiler.initialized || frame_index >= VE_MAX_FRAMES_IN_FLIGHT) {
+        return;
+    }
+
+    ve_gpu_profiler_frame* frame = &g_gpu_profiler.frames[frame_index];
+    if (!frame->pending) {
+        return;
+    }
+    if (frame == g_gpu_profiler.current) {
+        g_gpu_profiler.current = NULL;
+        g_gpu_profiler.cmd = VK_NULL_HANDLE;
+    }
+
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    g_gpu_profiler.result_count = 0;
+    g_gpu_profiler.frame_time_ms = 0.0;
+
+    if (frame->query_count > 0) {
+        /* Value and availability per query; the fence has signalled so nothing waits */
+        uint64_t data[VE_GPU_PROFILER_MAX_QUERIES * 2];
+        VkResult result = vkGetQueryPoolResults(vk->device, frame->pool, 0, frame->query_count,
+                                                frame->query_count * 2 * sizeof(uint64_t), data,
+                                                2 * sizeof(uint64_t),
+                                                VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+        if (result == VK_SUCCESS || result == VK_NOT_READY) {
+            ve_timestamp frame_start = 0;
+            ve_timestamp frame_end = 0;
+
+            for (uint32_t i = 0; i < frame->zone_count; i++) {
+                const ve_gpu_profiler_zone* zone = &frame->zones[i];
+                if (zone->end_query == VE_GPU_PROFILER_NO_QUERY ||
+                    data[zone->begin_query * 2 + 1] == 0 || data[zone->end_query * 2 + 1] == 0) {
+                    continue;
+                }
+
+                ve_timestamp start = gpu_to_cpu_time(data[zone->begin_query * 2]);
+                ve_timestamp end = gpu_to_cpu_time(data[zone->end_query * 2]);
+                if (end < start) {
+                    end = start;
+                }
+
+                ve_profiler_record_zone(g_gpu_profiler.track, zone->name, zone->parent, zone->depth, start, end);
+
+                if (g_gpu_profiler.result_count == 0 || start < frame_start) {
+                    frame_start = start;
+                }
+                if (end > frame_end) {
+                    frame_end = end;
+                }
+
+                ve_gpu_zone_result* out = &g_gpu_profiler.results[g_gpu_profiler.result_count++];
+                out->name = zone->name;
+                out->parent = zone->parent;
+                out->depth = zone->depth;
+                out->start_ms = ve_timer_to_milliseconds(start);
+                out->duration_ms = ve_timer_to_milliseconds(end - start);
+            }
+
+            for (uint32_t i = 0; i < g_gpu_profiler.result_count; i++) {
+                g_gpu_profiler.results[i].start_ms -= ve_timer_to_milliseconds(frame_start);
+            }
+            g_gpu_profiler.frame_time_ms = ve_timer_to_milliseconds(frame_end - frame_start);
+        } else {
+            VE_LOG_WARN("Failed to read GPU timestamps: %d", result);
+        }
+
+        if (g_gpu_profiler.host_reset) {
+            vkResetQueryPool(vk->device, frame->pool, 0, frame->query_count);
+        }
+    }
+
+    frame->pending = false;
+}
+
+uint32_t ve_gpu_profiler_get_results(ve_gpu_zone_result* results, uint32_t max_count) {
+    if (results) {
+        uint32_t count = g_gpu_profiler.result_count < max_count ? g_gpu_profiler.result_count : max_count;
+        memcpy(results, g_gpu_profiler.results, count * sizeof(ve_gpu_zone_result));
+    }
+    return g_gpu_profiler.result_count;
+}
+
+double ve_gpu_profiler_get_frame_time_ms(void) {
+    return g_gpu_profiler.frame_time_ms;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file gpu_profiler.h
+ * @brief GPU timestamp profiler
+ *
+ * Timestamps are written at debug label boundaries into a query pool owned
+ * by each frame in flight. A frame's results are read back once its render
+ * fence has signalled (ve_sync_wait_for_frame), so the readback never
+ * waits on the GPU. Zones are converted to ve_timer_now time and recorded
+ * on the "GPU" track of the CPU profiler, so they show up next to the CPU
+ * zones in the frame statistics and in Chrome trace exports.
+ */
+
+#ifndef VE_GPU_PROFILER_H
+#define VE_GPU_PROFILER_H
+
+#include "vulkan_core.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* GPU profiler limits */
+#define VE_GPU_PROFILER_MAX_ZONES 128   /* Zones per frame */
+#define VE_GPU_PROFILER_MAX_DEPTH 32    /* Deepest label nesting that is timed */
+
+/**
+ * @brief Measured GPU zone of a completed frame
+ */
+typedef struct ve_gpu_zone_result {
+    const char* name;       /* Label name */
+    const char* parent;     /* Enclosing label name, NULL for root zones */
+    uint32_t depth;         /* Nesting depth */
+    double start_ms;        /* Start relative to the first timestamp of the frame */
+    double duration_ms;     /* GPU time between the zone's timestamps */
+} ve_gpu_zone_result;
+
+/**
+ * @brief Initialize the GPU profiler
+ *
+ * Creates one timestamp query pool per frame in flight and calibrates GPU
+ * timestamps against ve_timer_now. Devices without timestamp support leave
+ * the profiler disabled and still return VK_SUCCESS.
+ *
+ * @return VK_SUCCESS on success
+ */
+VkResult ve_gpu_profiler_init(void);
+
+/**
+ * @brief Shutdown the GPU profiler
+ *
+ * The device must be idle.
+ */
+void ve_gpu_profiler_shutdown(void);
+
+/**
+ * @brief Check if GPU timestamps are being recorded
+ *
+ * @return true if the device supports timestamps and the profiler is initialized
+ */
+bool ve_gpu_profiler_is_enabled(void);
+
+/**
+ * @brief Start timing the current frame
+ *
+ * Called at the start of the frame's graphics command buffer. Zones are
+ * recorded only into this command buffer until the next call.
+ *
+ * @param cmd Frame command buffer in the recording state, outside a render pass
+ */
+void ve_gpu_profiler_begin_frame(VkCommandBuffer cmd);
+
+/**
+ * @brief Write the start timestamp of a zone
+ *
+ * @param cmd Command buffer (ignored unless it is the frame command buffer)
+ * @param name Zone name; must outlive the profiler
+ */
+void ve_gpu_profiler_begin_zone(VkCommandBuffer cmd, const char* name);
+
+/**
+ * @brief Write the end timestamp of the innermost open zone
+ *
+ * @param cmd Command buffer (ignored unless it is the frame command buffer)
+ */
+void ve_gpu_profiler_end_zone(VkCommandBuffer cmd);
+
+/**
+ * @brief Read back the timestamps of a frame whose fence has signalled
+ *
+ * @param frame_index Frame in flight index
+ */
+void ve_gpu_profiler_collect(uint32_t frame_index);
+
+/**
+ * @brief Copy the zones of the last collected frame
+ *
+ * @param results Output array (may be NULL to query the count)
+ * @param max_count Capacity of the output array
+ * @return Number of zones in the last collected frame
+ */
+uint32_t ve_gpu_profiler_get_results(ve_gpu_zone_result* results, uint32_t max_count);
+
+/**
+ * @brief Get the GPU time of the last collected frame
+ *
+ * @return Time from the first to the last timestamp of the frame in milliseconds
+ */
+double ve_gpu_profiler_get_frame_time_ms(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_GPU_PROFILER_H */
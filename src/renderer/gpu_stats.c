@@ -0,0 +1,311 @@
+/**
+ * @file gpu_stats.c
+ * @brief Per-pass pipeline statistics and occlusion queries implementation
+ */
+
+#define VK_NO_PROTOTYPES
+#include "gpu_stats.h"
+#include "sync.h"
+
+#include "../core/logger.h"
+#include "../core/assert.h"
+
+#include <string.h>
+
+/* Counters requested from pipeline statistics queries, in result order */
+#define VE_GPU_STATS_PIPELINE_FLAGS \
+    (VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT | \
+     VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT | \
+     VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT | \
+     VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT | \
+     VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT | \
+     VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT | \
+     VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT)
+#define VE_GPU_STATS_PIPELINE_COUNTERS 7
+
+/**
+ * @brief Pass recorded into a frame's command buffer
+ */
+typedef struct ve_gpu_stats_pass {
+    const char* name;
+    uint32_t flags;
+} ve_gpu_stats_pass;
+
+/**
+ * @brief Query pools and passes of one frame in flight
+ */
+typedef struct ve_gpu_stats_frame {
+    VkQueryPool pipeline_pool;
+    VkQueryPool occlusion_pool;
+    ve_gpu_stats_pass passes[VE_GPU_STATS_MAX_PASSES];
+    uint32_t pass_count;
+    bool pending;           /* Recorded but not read back yet */
+} ve_gpu_stats_frame;
+
+/* GPU statistics state */
+static struct {
+    ve_gpu_stats_frame frames[VE_MAX_FRAMES_IN_FLIGHT];
+    VkCommandBuffer cmd;
+    ve_gpu_stats_frame* current;
+    bool pass_active;
+
+    uint32_t supported_flags;
+    VkQueryControlFlags occlusion_control;
+    bool host_reset;
+
+    ve_gpu_frame_stats frame_stats;
+    bool initialized;
+} g_gpu_stats = {0};
+
+static void reset_pools_on_host(ve_gpu_stats_frame* frame, uint32_t count) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    if (frame->pipeline_pool != VK_NULL_HANDLE) {
+        vkResetQueryPool(vk->device, frame->pipeline_pool, 0, count);
+    }
+    if (frame->occlusion_pool != VK_NULL_HANDLE) {
+        vkResetQueryPool(vk->device, frame->occlusion_pool, 0, count);
+    }
+}
+
+VkResult ve_gpu_stats_init(void) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VE_ASSERT(vk && vk->device);
+
+    memset(&g_gpu_stats, 0, sizeof(g_gpu_stats));
+
+    g_gpu_stats.supported_flags = VE_GPU_STATS_OCCLUSION;
+    if (vk->device_features.pipelineStatisticsQuery) {
+        g_gpu_stats.supported_flags |= VE_GPU_STATS_PIPELINE;
+    }
+    g_gpu_stats.occlusion_control = vk->device_features.occlusionQueryPrecise ? VK_QUERY_CONTROL_PRECISE_BIT : 0;
+    g_gpu_stats.host_reset = vk->device_features.hostQueryReset;
+
+    for (uint32_t i = 0; i < VE_MAX_FRAMES_IN_FLIGHT; i++) {
+        ve_gpu_stats_frame* frame = &g_gpu_stats.frames[i];
+
+        if (g_gpu_stats.supported_flags & VE_GPU_STATS_PIPELINE) {
+            VkQueryPoolCreateInfo pool_info = {
+                .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                .queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS,
+                .queryCount = VE_GPU_STATS_MAX_PASSES,
+                .pipelineStatistics = VE_GPU_STATS_PIPELINE_FLAGS,
+            };
+
+            VkResult result = vkCreateQueryPool(vk->device, &pool_info, NULL, &frame->pipeline_pool);
+            if (result != VK_SUCCESS) {
+                VE_LOG_ERROR("Failed to create pipeline statistics query pool for frame %u: %d", i, result);
+                ve_gpu_stats_shutdown();
+                return result;
+            }
+            VE_VK_SET_OBJECT_NAME(frame->pipeline_pool, VK_OBJECT_TYPE_QUERY_POOL, "gpu_stats_pipeline");
+        }
+
+        VkQueryPoolCreateInfo pool_info = {
+            .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .queryType = VK_QUERY_TYPE_OCCLUSION,
+            .queryCount = VE_GPU_STATS_MAX_PASSES,
+        };
+
+        VkResult result = vkCreateQueryPool(vk->device, &pool_info, NULL, &frame->occlusion_pool);
+        if (result != VK_SUCCESS) {
+            VE_LOG_ERROR("Failed to create occlusion query pool for frame %u: %d", i, result);
+            ve_gpu_stats_shutdown();
+            return result;
+        }
+        VE_VK_SET_OBJECT_NAME(frame->occlusion_pool, VK_OBJECT_TYPE_QUERY_POOL, "gpu_stats_occlusion");
+
+        /* Fresh pools must be reset before their first use */
+        if (g_gpu_stats.host_reset) {
+            reset_pools_on_host(frame, VE_GPU_STATS_MAX_PASSES);
+        }
+    }
+
+    g_gpu_stats.initialized = true;
+
+    VE_LOG_INFO("GPU statistics initialized (pipeline statistics: %s, precise occlusion: %s)",
+                (g_gpu_stats.supported_flags & VE_GPU_STATS_PIPELINE) ? "yes" : "no",
+                g_gpu_stats.occlusion_control ? "yes" : "no");
+    return VK_SUCCESS;
+}
+
+void ve_gpu_stats_shutdown(void) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    if (!vk || !vk->device) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < VE_MAX_FRAMES_IN_FLIGHT; i++) {
+        if (g_gpu_stats.frames[i].pipeline_pool != VK_NULL_HANDLE) {
+            vkDestroyQueryPool(vk->device, g_gpu_stats.frames[i].pipeline_pool, NULL);
+        }
+        if (g_gpu_stats.frames[i].occlusion_pool != VK_NULL_HANDLE) {
+            vkDestroyQueryPool(vk->device, g_gpu_stats.frames[i].occlusion_pool, NULL);
+        }
+    }
+
+    memset(&g_gpu_stats, 0, sizeof(g_gpu_stats));
+}
+
+uint32_t ve_gpu_stats_get_supported_flags(void) {
+    return g_gpu_stats.initialized ? g_gpu_stats.supported_flags : 0;
+}
+
+void ve_gpu_stats_begin_frame(VkCommandBuffer cmd) {
+    if (!g_gpu_stats.initialized) {
+        return;
+    }
+
+    ve_gpu_stats_frame* frame = &g_gpu_stats.frames[ve_sync_get_current_frame_index()];
+
+    /* Results of a frame that was never collected are lost */
+    if (!g_gpu_stats.host_reset || frame->pending) {
+        if (frame->pipeline_pool != VK_NULL_HANDLE) {
+            vkCmdResetQueryPool(cmd, frame->pipeline_pool, 0, VE_GPU_STATS_MAX_PASSES);
+        }
+        vkCmdResetQueryPool(cmd, frame->occlusion_pool, 0, VE_GPU_STATS_MAX_PASSES);
+    }
+
+    frame->pass_count = 0;
+    frame->pending = true;
+
+    g_gpu_stats.cmd = cmd;
+    g_gpu_stats.current = frame;
+    g_gpu_stats.pass_active = false;
+}
+
+void ve_gpu_stats_begin_pass(VkCommandBuffer cmd, const char* name, uint32_t flags) {
+    ve_gpu_stats_frame* frame = g_gpu_stats.current;
+    if (!frame || cmd != g_gpu_stats.cmd) {
+        return;
+    }
+
+    if (g_gpu_stats.pass_active) {
+        VE_LOG_WARN("GPU statistics pass %s started inside another pass, ignored", name);
+        return;
+    }
+
+    if (frame->pass_count >= VE_GPU_STATS_MAX_PASSES) {
+        return;
+    }
+
+    uint32_t query = frame->pass_count++;
+    ve_gpu_stats_pass* pass = &frame->passes[query];
+    pass->name = name;
+    pass->flags = flags & g_gpu_stats.supported_flags;
+
+    if (pass->flags & VE_GPU_STATS_PIPELINE) {
+        vkCmdBeginQuery(cmd, frame->pipeline_pool, query, 0);
+    }
+    if (pass->flags & VE_GPU_STATS_OCCLUSION) {
+        vkCmdBeginQuery(cmd, frame->occlusion_pool, query, g_gpu_stats.occlusion_control);
+    }
+    g_gpu_stats.pass_active = true;
+}
+
+void ve_gpu_stats_end_pass(VkCommandBuffer cmd) {
+    ve_gpu_stats_frame* frame = g_gpu_stats.current;
+    if (!frame || cmd != g_gpu_stats.cmd || !g_gpu_stats.pass_active) {
+        return;
+    }
+
+    uint32_t query = frame->pass_count - 1;
+    const ve_gpu_stats_pass* pass = &frame->passes[query];
+
+    if (pass->flags & VE_GPU_STATS_OCCLUSION) {
+        vkCmdEndQuery(cmd, frame->occlusion_pool, query);
+    }
+    if (pass->flags & VE_GPU_STATS_PIPELINE) {
+        vkCmdEndQuery(cmd, frame->pipeline_pool, query);
+    }
+    g_gpu_stats.pass_active = false;
+}
+
+void ve_gpu_stats_collect(uint32_t frame_index) {
+    if (!g_gpu_stats.initialized || frame_index >= VE_MAX_FRAMES_IN_FLIGHT) {
+        return;
+    }
+
+    ve_gpu_stats_frame* frame = &g_gpu_stats.frames[frame_index];
+    if (!frame->pending) {
+        return;
+    }
+    if (frame == g_gpu_stats.current) {
+        g_gpu_stats.current = NULL;
+        g_gpu_stats.cmd = VK_NULL_HANDLE;
+    }
+
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    ve_gpu_frame_stats* stats = &g_gpu_stats.frame_stats;
+    uint64_t frame_number = stats->frame_number + 1;
+    memset(stats, 0, sizeof(ve_gpu_frame_stats));
+    stats->frame_number = frame_number;
+
+    uint32_t count = frame->pass_count;
+    if (count > 0) {
+        /* Counters followed by availability; the fence has signalled so nothing waits */
+        uint64_t pipeline[VE_GPU_STATS_MAX_PASSES][VE_GPU_STATS_PIPELINE_COUNTERS + 1];
+        uint64_t occlusion[VE_GPU_STATS_MAX_PASSES][2];
+        memset(pipeline, 0, sizeof(pipeline));
+        memset(occlusion, 0, sizeof(occlusion));
+
+        VkQueryResultFlags result_flags = VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT;
+        if (frame->pipeline_pool != VK_NULL_HANDLE) {
+            vkGetQueryPoolResults(vk->device, frame->pipeline_pool, 0, count, sizeof(pipeline[0]) * count,
+                                  pipeline, sizeof(pipeline[0]), result_flags);
+        }
+        vkGetQueryPoolResults(vk->device, frame->occlusion_pool, 0, count, sizeof(occlusion[0]) * count,
+                              occlusion, sizeof(occlusion[0]), result_flags);
+
+        for (uint32_t i = 0; i < count; i++) {
+            const ve_gpu_stats_pass* pass = &frame->passes[i];
+            ve_gpu_pass_stats* out = &stats->passes[stats->pass_count++];
+            out->name = pass->name;
+
+            /* Queries that were not begun never become available */
+            if ((pass->flags & VE_GPU_STATS_PIPELINE) && pipeline[i][VE_GPU_STATS_PIPELINE_COUNTERS]) {
+                out->available_flags |= VE_GPU_STATS_PIPELINE;
+                out->input_vertices = pipeline[i][0];
+                out->input_primitives = pipeline[i][1];
+                out->vertex_invocations = pipeline[i][2];
+                out->clipping_invocations = pipeline[i][3];
+                out->clipping_primitives = pipeline[i][4];
+                out->fragment_invocations = pipeline[i][5];
+                out->compute_invocations = pipeline[i][6];
+            }
+            if ((pass->flags & VE_GPU_STATS_OCCLUSION) && occlusion[i][1]) {
+                out->available_flags |= VE_GPU_STATS_OCCLUSION;
+                out->samples_passed = occlusion[i][0];
+            }
+
+            stats->total.available_flags |= out->available_flags;
+            stats->total.input_vertices += out->input_vertices;
+            stats->total.input_primitives += out->input_primitives;
+            stats->total.vertex_invocations += out->vertex_invocations;
+            stats->total.clipping_invocations += out->clipping_invocations;
+            stats->total.clipping_primitives += out->clipping_primitives;
+            stats->total.fragment_invocations += out->fragment_invocations;
+            stats->total.compute_invocations += out->compute_invocations;
+            stats->total.samples_passed += out->samples_passed;
+        }
+
+        if (g_gpu_stats.host_reset) {
+            reset_pools_on_host(frame, count);
+        }
+    }
+
+    frame->pending = false;
+}
+
+const ve_gpu_frame_stats* ve_gpu_stats_get_frame(void) {
+    return &g_gpu_stats.frame_stats;
+}
+
+const ve_gpu_pass_stats* ve_gpu_stats_find_pass(const char* name) {
+    const ve_gpu_frame_stats* stats = &g_gpu_stats.frame_stats;
+    for (uint32_t i = 0; i < stats->pass_count; i++) {
+        if (stats->passes[i].name && name && strcmp(stats->passes[i].name, name) == 0) {
+            return &stats->passes[i];
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,138 @@
+/**
+ * @file gpu_stats.h
+ * @brief Per-pass pipeline statistics and occlusion queries
+ *
+ * Passes are bracketed with ve_gpu_stats_begin_pass/ve_gpu_stats_end_pass
+ * in the frame's graphics command buffer. Each frame in flight owns its
+ * own query pools; a frame's counts are read back once its render fence
+ * has signalled (ve_sync_wait_for_frame) and published as a
+ * ve_gpu_frame_stats.
+ */
+
+#ifndef VE_GPU_STATS_H
+#define VE_GPU_STATS_H
+
+#include "vulkan_core.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VE_GPU_STATS_MAX_PASSES 32
+
+/**
+ * @brief Queries recorded for a pass
+ */
+typedef enum ve_gpu_stats_flags {
+    VE_GPU_STATS_PIPELINE  = 1 << 0,  /* Pipeline statistics counters */
+    VE_GPU_STATS_OCCLUSION = 1 << 1,  /* Samples passing depth/stencil */
+    VE_GPU_STATS_ALL       = VE_GPU_STATS_PIPELINE | VE_GPU_STATS_OCCLUSION,
+} ve_gpu_stats_flags;
+
+/**
+ * @brief Counters of one pass
+ *
+ * Counters whose query is unsupported or was not requested stay zero;
+ * see available_flags.
+ */
+typedef struct ve_gpu_pass_stats {
+    const char* name;
+    uint32_t available_flags;           /* ve_gpu_stats_flags that were measured */
+    uint64_t input_vertices;            /* Input assembly vertices */
+    uint64_t input_primitives;          /* Input assembly primitives */
+    uint64_t vertex_invocations;
+    uint64_t clipping_invocations;      /* Primitives entering the clipper */
+    uint64_t clipping_primitives;       /* Primitives leaving the clipper */
+    uint64_t fragment_invocations;
+    uint64_t compute_invocations;
+    uint64_t samples_passed;            /* Occlusion query result */
+} ve_gpu_pass_stats;
+
+/**
+ * @brief Counters of a completed frame
+ */
+typedef struct ve_gpu_frame_stats {
+    ve_gpu_pass_stats passes[VE_GPU_STATS_MAX_PASSES];
+    uint32_t pass_count;
+    ve_gpu_pass_stats total;            /* Sum over all passes, name is NULL */
+    uint64_t frame_number;              /* Number of frames collected before this one */
+} ve_gpu_frame_stats;
+
+/**
+ * @brief Initialize the query pools
+ *
+ * Pipeline statistics require the pipelineStatisticsQuery feature; without
+ * it only occlusion queries are recorded.
+ *
+ * @return VK_SUCCESS on success
+ */
+VkResult ve_gpu_stats_init(void);
+
+/**
+ * @brief Destroy the query pools
+ *
+ * The device must be idle.
+ */
+void ve_gpu_stats_shutdown(void);
+
+/**
+ * @brief Check which queries the device supports
+ *
+ * @return Supported ve_gpu_stats_flags
+ */
+uint32_t ve_gpu_stats_get_supported_flags(void);
+
+/**
+ * @brief Start collecting counters for the current frame
+ *
+ * @param cmd Frame command buffer in the recording state, outside a render pass
+ */
+void ve_gpu_stats_begin_frame(VkCommandBuffer cmd);
+
+/**
+ * @brief Begin measuring a pass
+ *
+ * Passes cannot nest. Vulkan requires occlusion queries that span a render
+ * pass to begin and end outside of it or within one subpass.
+ *
+ * @param cmd Frame command buffer
+ * @param name Pass name; must outlive the frame's readback
+ * @param flags ve_gpu_stats_flags to record
+ */
+void ve_gpu_stats_begin_pass(VkCommandBuffer cmd, const char* name, uint32_t flags);
+
+/**
+ * @brief End the pass started with ve_gpu_stats_begin_pass
+ *
+ * @param cmd Frame command buffer
+ */
+void ve_gpu_stats_end_pass(VkCommandBuffer cmd);
+
+/**
+ * @brief Read back the counters of a frame whose fence has signalled
+ *
+ * @param frame_index Frame in flight index
+ */
+void ve_gpu_stats_collect(uint32_t frame_index);
+
+/**
+ * @brief Get the counters of the last collected frame
+ *
+ * @return Frame statistics (valid until the next collect)
+ */
+const ve_gpu_frame_stats* ve_gpu_stats_get_frame(void);
+
+/**
+ * @brief Find a pass in the last collected frame by name
+ *
+ * @param name Pass name
+ * @return Pass statistics or NULL if the pass was not measured
+ */
+const ve_gpu_pass_stats* ve_gpu_stats_find_pass(const char* name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_GPU_STATS_H */
@@ -0,0 +1,398 @@
+/**
+ * @file hiz.c
+ * @brief Hierarchical-Z depth pyramid implementation
+ */
+
+#define VK_NO_PROTOTYPES
+#include "hiz.h"
+
+#include "deletion_queue.h"
+#include "descriptor.h"
+#include "image.h"
+#include "pipeline.h"
+#include "shader.h"
+#include "../core/logger.h"
+#include "../core/assert.h"
+#include "../core/memory.h"
+
+#include <string.h>
+
+/**
+ * @brief Push constants of hiz_build.comp
+ */
+typedef struct ve_hiz_push {
+    float size[2];          /* Destination level size */
+} ve_hiz_push;
+
+/* Global Hi-Z state */
+static struct {
+    bool initialized;
+    bool valid;                     /* Built since the last resize */
+    bool transitioned;              /* Out of VK_IMAGE_LAYOUT_UNDEFINED */
+    VkShaderModule shader;
+    VkDescriptorSetLayout set_layout;
+    VkPipelineLayout pipeline_layout;
+    ve_pipeline* pipeline;
+    VkSampler sampler;
+    ve_image pyramid;
+    VkImageView mip_views[VE_HIZ_MAX_MIPS];
+    uint32_t width;
+    uint32_t height;
+    uint32_t mip_levels;
+} g_hiz = {0};
+
+/* Largest power of two not above value */
+static uint32_t floor_pow2(uint32_t value) {
+    uint32_t result = 1;
+    while (result * 2 <= value && result < (1u << (VE_HIZ_MAX_MIPS - 1))) {
+        result *= 2;
+    }
+    return result;
+}
+
+static void destroy_image_deferred(void* user_data) {
+    ve_image* image = (ve_image*)user_data;
+    ve_image_destroy(image);
+    VE_FREE(image);
+}
+
+/**
+ * @brief Release the pyramid once frames in flight are done with it
+ */
+static void release_pyramid(void) {
+    for (uint32_t i = 0; i < g_hiz.mip_levels; i++) {
+        if (g_hiz.mip_views[i] != VK_NULL_HANDLE) {
+            ve_deletion_queue_push_image_view(g_hiz.mip_views[i]);
+        }
+    }
+
+    if (g_hiz.pyramid.image != VK_NULL_HANDLE) {
+        ve_image* pending = (ve_image*)VE_ALLOCATE_TAG(sizeof(ve_image), VE_MEMORY_TAG_RENDERER);
+        if (pending) {
+            *pending = g_hiz.pyramid;
+            ve_deletion_queue_push_callback(destroy_image_deferred, pending);
+        } else {
+            VE_LOG_ERROR("Out of memory deferring Hi-Z pyramid release, leaking it");
+        }
+    }
+
+    memset(&g_hiz.pyramid, 0, sizeof(g_hiz.pyramid));
+    memset(g_hiz.mip_views, 0, sizeof(g_hiz.mip_views));
+    g_hiz.width = 0;
+    g_hiz.height = 0;
+    g_hiz.mip_levels = 0;
+    g_hiz.valid = false;
+    g_hiz.transitioned = false;
+}
+
+VkResult ve_hiz_init(const char* shader_path) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VE_ASSERT(vk && vk->device && shader_path);
+
+    memset(&g_hiz, 0, sizeof(g_hiz));
+
+    if (!vk->device_features.samplerFilterMinmax ||
+        !ve_vulkan_is_format_supported(VK_FORMAT_R32_SFLOAT, VK_IMAGE_TILING_OPTIMAL,
+                                       VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT |
+                                       VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_MINMAX_BIT)) {
+        VE_LOG_WARN("Min/max sampler reduction not supported, Hi-Z disabled");
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    /* Linear taps reduced with max give the farthest of the four texels under them */
+    VkSamplerReductionModeCreateInfo reduction = {
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_REDUCTION_MODE_CREATE_INFO,
+        .reductionMode = VK_SAMPLER_REDUCTION_MODE_MAX,
+    };
+    VkSamplerCreateInfo sampler_info = {
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .pNext = &reduction,
+        .magFilter = VK_FILTER_LINEAR,
+        .minFilter = VK_FILTER_LINEAR,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .maxLod = VK_LOD_CLAMP_NONE,
+    };
+
+    VkResult result = vkCreateSampler(vk->device, &sampler_info, NULL, &g_hiz.sampler);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to create Hi-Z sampler: %d", result);
+        return result;
+    }
+
+    VkDescriptorSetLayoutBinding bindings[2] = {
+        {
+            .binding = 0,
+            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        },
+        {
+            .binding = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        },
+    };
+
+    VkDescriptorSetLayoutCreateInfo layout_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = 2,
+        .pBindings = bindings,
+    };
+
+    g_hiz.set_layout = ve_descriptor_layout_get(&layout_info);
+    if (g_hiz.set_layout == VK_NULL_HANDLE) {
+        ve_hiz_shutdown();
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    VkPushConstantRange push_range = {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(ve_hiz_push),
+    };
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pSetLayouts = &g_hiz.set_layout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &push_range,
+    };
+
+    result = vkCreatePipelineLayout(vk->device, &pipeline_layout_info, NULL, &g_hiz.pipeline_layout);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to create Hi-Z pipeline layout: %d", result);
+        ve_hiz_shutdown();
+        return result;
+    }
+
+    result = ve_shader_load_module(shader_path, &g_hiz.shader);
+    if (result != VK_SUCCESS) {
+        ve_hiz_shutdown();
+        return result;
+    }
+
+    ve_compute_pipeline_desc pipeline_desc = {
+        .shader = g_hiz.shader,
+        .layout = g_hiz.pipeline_layout,
+        .debug_name = "hiz_build",
+    };
+    g_hiz.pipeline = ve_pipeline_acquire_compute(&pipeline_desc);
+    if (!g_hiz.pipeline) {
+        ve_hiz_shutdown();
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    g_hiz.initialized = true;
+    return VK_SUCCESS;
+}
+
+void ve_hiz_shutdown(void) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+
+    if (g_hiz.pipeline) {
+        ve_pipeline_wait(g_hiz.pipeline);
+        ve_pipeline_release(g_hiz.pipeline);
+    }
+    ve_shader_destroy_module(g_hiz.shader);
+
+    /* The device is idle, so nothing needs deferring */
+    if (vk && vk->device) {
+        for (uint32_t i = 0; i < g_hiz.mip_levels; i++) {
+            if (g_hiz.mip_views[i] != VK_NULL_HANDLE) {
+                vkDestroyImageView(vk->device, g_hiz.mip_views[i], NULL);
+            }
+        }
+        if (g_hiz.pipeline_layout != VK_NULL_HANDLE) {
+            vkDestroyPipelineLayout(vk->device, g_hiz.pipeline_layout, NULL);
+        }
+        if (g_hiz.sampler != VK_NULL_HANDLE) {
+            vkDestroySampler(vk->device, g_hiz.sampler, NULL);
+        }
+    }
+    ve_image_destroy(&g_hiz.pyramid);
+
+    /* The set layout belongs to the layout cache */
+    memset(&g_hiz, 0, sizeof(g_hiz));
+}
+
+bool ve_hiz_is_enabled(void) {
+    return g_hiz.initialized;
+}
+
+bool ve_hiz_resize(uint32_t depth_width, uint32_t depth_height) {
+    VE_ASSERT(g_hiz.initialized && depth_width > 0 && depth_height > 0);
+
+    uint32_t width = floor_pow2(depth_width);
+    uint32_t height = floor_pow2(depth_height);
+    if (width == g_hiz.width && height == g_hiz.height) {
+        return true;
+    }
+
+    release_pyramid();
+
+    uint32_t mip_levels = 1;
+    while ((width >> mip_levels) > 0 || (height >> mip_levels) > 0) {
+        mip_levels++;
+    }
+
+    ve_image_config config = {
+        .width = width,
+        .height = height,
+        .mip_levels = mip_levels,
+        .format = VK_FORMAT_R32_SFLOAT,
+        .usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .aspect = VK_IMAGE_ASPECT_COLOR_BIT,
+        .memory_usage = VE_GPU_MEMORY_USAGE_GPU_ONLY,
+        .debug_name = "hiz_pyramid",
+    };
+    if (ve_image_create(&config, &g_hiz.pyramid) != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to create %ux%u Hi-Z pyramid", width, height);
+        return false;
+    }
+
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    for (uint32_t i = 0; i < mip_levels; i++) {
+        VkImageViewCreateInfo view_info = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .image = g_hiz.pyramid.image,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = VK_FORMAT_R32_SFLOAT,
+            .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, i, 1, 0, 1},
+        };
+        VkResult result = vkCreateImageView(vk->device, &view_info, NULL, &g_hiz.mip_views[i]);
+        if (result != VK_SUCCESS) {
+            VE_LOG_ERROR("Failed to create Hi-Z level view: %d", result);
+            g_hiz.mip_levels = i;
+            release_pyramid();
+            return false;
+        }
+    }
+
+    g_hiz.width = width;
+    g_hiz.height = height;
+    g_hiz.mip_levels = mip_levels;
+    VE_LOG_DEBUG("Hi-Z pyramid %ux%u, %u levels", width, height, mip_levels);
+    return true;
+}
+
+bool ve_hiz_build(ve_command_buffer* cmd, VkImageView depth_view, VkImageLayout depth_layout) {
+    VE_ASSERT(cmd && cmd->is_recording && depth_view != VK_NULL_HANDLE && g_hiz.initialized);
+    VE_ASSERT_MSG(g_hiz.mip_levels > 0, "ve_hiz_resize must be called before building");
+
+    if (!ve_pipeline_is_ready(g_hiz.pipeline)) {
+        return false;
+    }
+
+    ve_vulkan_begin_debug_label(cmd->buffer, "hiz_build", 0.4f, 0.4f, 0.8f);
+
+    /* Earlier occlusion tests read the pyramid; wait for them before overwriting it */
+    VkImageMemoryBarrier entry = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = 0,
+        .dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .oldLayout = g_hiz.transitioned ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = g_hiz.pyramid.image,
+        .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, g_hiz.mip_levels, 0, 1},
+    };
+    ve_command_buffer_pipeline_barrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                                       0, NULL, 0, NULL, 1, &entry);
+    g_hiz.transitioned = true;
+
+    vkCmdBindPipeline(cmd->buffer, VK_PIPELINE_BIND_POINT_COMPUTE, g_hiz.pipeline->pipeline);
+
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    for (uint32_t level = 0; level < g_hiz.mip_levels; level++) {
+        VkDescriptorSet set = ve_descriptor_allocate_frame(g_hiz.set_layout);
+        if (set == VK_NULL_HANDLE) {
+            VE_LOG_ERROR("Out of frame descriptor sets, Hi-Z build stopped at level %u", level);
+            break;
+        }
+
+        VkDescriptorImageInfo source = {
+            .sampler = g_hiz.sampler,
+            .imageView = level == 0 ? depth_view : g_hiz.mip_views[level - 1],
+            .imageLayout = level == 0 ? depth_layout : VK_IMAGE_LAYOUT_GENERAL,
+        };
+        VkDescriptorImageInfo destination = {
+            .imageView = g_hiz.mip_views[level],
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+        };
+        VkWriteDescriptorSet writes[2] = {
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = set,
+                .dstBinding = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .pImageInfo = &source,
+            },
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = set,
+                .dstBinding = 1,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                .pImageInfo = &destination,
+            },
+        };
+        vkUpdateDescriptorSets(vk->device, 2, writes, 0, NULL);
+
+        uint32_t width = g_hiz.width >> level ? g_hiz.width >> level : 1;
+        uint32_t height = g_hiz.height >> level ? g_hiz.height >> level : 1;
+        ve_hiz_push push = {{(float)width, (float)height}};
+        vkCmdBindDescriptorSets(cmd->buffer, VK_PIPELINE_BIND_POINT_COMPUTE, g_hiz.pipeline_layout,
+                                0, 1, &set, 0, NULL);
+        vkCmdPushConstants(cmd->buffer, g_hiz.pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+        ve_command_buffer_dispatch(cmd, (width + VE_HIZ_GROUP_SIZE - 1) / VE_HIZ_GROUP_SIZE,
+                                   (height + VE_HIZ_GROUP_SIZE - 1) / VE_HIZ_GROUP_SIZE, 1);
+
+        /* The next level and the occlusion tests read this one */
+        VkImageMemoryBarrier barrier = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_GENERAL,
+            .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = g_hiz.pyramid.image,
+            .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1},
+        };
+        ve_command_buffer_pipeline_barrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                                           0, NULL, 0, NULL, 1, &barrier);
+    }
+
+    ve_vulkan_end_debug_label(cmd->buffer);
+
+    g_hiz.valid = true;
+    return true;
+}
+
+bool ve_hiz_is_valid(void) {
+    return g_hiz.initialized && g_hiz.valid;
+}
+
+VkImageView ve_hiz_get_view(void) {
+    return g_hiz.pyramid.view;
+}
+
+VkSampler ve_hiz_get_sampler(void) {
+    return g_hiz.sampler;
+}
+
+void ve_hiz_get_extent(uint32_t* width, uint32_t* height, uint32_t* mip_levels) {
+    VE_ASSERT(width && height && mip_levels);
+    *width = g_hiz.width;
+    *height = g_hiz.height;
+    *mip_levels = g_hiz.mip_levels;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file hiz.h
+ * @brief Hierarchical-Z depth pyramid
+ *
+ * The pyramid is an R32_SFLOAT image whose level 0 is the depth buffer
+ * shrunk to the power of two at or below its size, and whose every texel
+ * holds the farthest depth of the texels it covers. Each level is one
+ * compute dispatch that samples the level above through a max-reduction
+ * sampler, so a bilinear tap returns the farthest of four texels.
+ *
+ * Occlusion tests sample the pyramid through ve_hiz_get_sampler at the
+ * level where a screen-space bounding box spans at most one texel; the
+ * object is hidden if its nearest depth is farther than the sample.
+ * Depth is standard (0 near, 1 far) with LESS or LESS_OR_EQUAL tests.
+ *
+ * The pyramid stays in VK_IMAGE_LAYOUT_GENERAL.
+ */
+
+#ifndef VE_HIZ_H
+#define VE_HIZ_H
+
+#include "vulkan_core.h"
+#include "command_buffer.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Levels of the largest pyramid (32768 texels across) */
+#define VE_HIZ_MAX_MIPS 16
+
+/* Threads per workgroup side of hiz_build.comp */
+#define VE_HIZ_GROUP_SIZE 8
+
+/**
+ * @brief Create the reduction pipeline and sampler
+ *
+ * @param shader_path Path to hiz_build.comp.spv
+ * @return VK_SUCCESS on success, VK_ERROR_FEATURE_NOT_PRESENT without min/max sampler reduction
+ */
+VkResult ve_hiz_init(const char* shader_path);
+
+/**
+ * @brief Destroy the pyramid, pipeline and sampler
+ *
+ * The device must be idle.
+ */
+void ve_hiz_shutdown(void);
+
+/**
+ * @brief Check if Hi-Z is available
+ *
+ * @return true if initialized
+ */
+bool ve_hiz_is_enabled(void);
+
+/**
+ * @brief Size the pyramid for a depth buffer
+ *
+ * Recreates the pyramid when its size changes; the old one is released
+ * once the frames using it have completed. The new pyramid is invalid
+ * until it is built.
+ *
+ * @param depth_width Depth buffer width
+ * @param depth_height Depth buffer height
+ * @return true on success
+ */
+bool ve_hiz_resize(uint32_t depth_width, uint32_t depth_height);
+
+/**
+ * @brief Record the pyramid build from a depth buffer
+ *
+ * Record outside a render pass. The depth writes must already be visible
+ * to compute shaders, and the view must have only the depth aspect. Ends
+ * with the pyramid visible to compute shader reads.
+ *
+ * @param cmd Graphics or compute command buffer
+ * @param depth_view Depth view, sampled
+ * @param depth_layout Layout the depth image is in
+ * @return true if recorded, false while the pipeline is still compiling
+ */
+bool ve_hiz_build(ve_command_buffer* cmd, VkImageView depth_view, VkImageLayout depth_layout);
+
+/**
+ * @brief Check if the pyramid holds a depth buffer
+ *
+ * @return true once built after the last resize
+ */
+bool ve_hiz_is_valid(void);
+
+/**
+ * @brief Get a view of the whole pyramid
+ *
+ * @return Image view, VK_NULL_HANDLE before the first resize
+ */
+VkImageView ve_hiz_get_view(void);
+
+/**
+ * @brief Get the max-reduction sampler for occlusion tests
+ *
+ * @return Sampler
+ */
+VkSampler ve_hiz_get_sampler(void);
+
+/**
+ * @brief Get the size of pyramid level 0 and the level count
+ *
+ * @param width Output width
+ * @param height Output height
+ * @param mip_levels Output level count
+ */
+void ve_hiz_get_extent(uint32_t* width, uint32_t* height, uint32_t* mip_levels);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_HIZ_H */
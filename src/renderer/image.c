@@ -3,6 +3,105 @@
  * @brief Vulkan image and texture management implementation
  */
 
+#define VK_NO_PROTOTYPES
 #include "image.h"
 
-/* TODO: Implement image management */
+#include "../core/logger.h"
+#include "../core/assert.h"
+
+#include <string.h>
+
+VkResult ve_image_create(const ve_image_config* config, ve_image* out_image) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VE_ASSERT(vk && vk->device);
+    VE_ASSERT(config && out_image && config->width > 0 && config->height > 0);
+
+    memset(out_image, 0, sizeof(ve_image));
+
+    uint32_t mip_levels = config->mip_levels ? config->mip_levels : 1;
+    uint32_t array_layers = config->array_layers ? config->array_layers : 1;
+
+    VkImageCreateInfo image_info = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = config->format,
+        .extent = { config->width, config->height, 1 },
+        .mipLevels = mip_levels,
+        .arrayLayers = array_layers,
+        .samples = config->samples ? config->samples : VK_SAMPLE_COUNT_1_BIT,
+        .tiling = config->tiling,
+        .usage = config->usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+
+    VkResult result = vkCreateImage(vk->device, &image_info, NULL, &out_image->image);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to create image: %d", result);
+        return result;
+    }
+
+    /* Render targets get their own memory instead of fragmenting the blocks */
+    uint32_t flags = config->allocation_flags;
+    if (config->usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)) {
+        flags |= VE_GPU_ALLOCATION_DEDICATED;
+    }
+    if (config->tiling == VK_IMAGE_TILING_LINEAR) {
+        flags |= VE_GPU_ALLOCATION_LINEAR;
+    }
+
+    result = ve_gpu_memory_allocate_image(out_image->image, config->memory_usage, flags,
+                                          &out_image->allocation);
+    if (result != VK_SUCCESS) {
+        vkDestroyImage(vk->device, out_image->image, NULL);
+        out_image->image = VK_NULL_HANDLE;
+        return result;
+    }
+
+    VkImageViewCreateInfo view_info = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .image = out_image->image,
+        .viewType = array_layers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D,
+        .format = config->format,
+        .subresourceRange = {
+            .aspectMask = config->aspect ? config->aspect : VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseMipLevel = 0,
+            .levelCount = mip_levels,
+            .baseArrayLayer = 0,
+            .layerCount = array_layers,
+        },
+    };
+
+    result = vkCreateImageView(vk->device, &view_info, NULL, &out_image->view);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to create image view: %d", result);
+        ve_image_destroy(out_image);
+        return result;
+    }
+
+    out_image->format = config->format;
+    out_image->extent = image_info.extent;
+    out_image->mip_levels = mip_levels;
+    out_image->array_layers = array_layers;
+
+    if (config->debug_name) {
+        VE_VK_SET_OBJECT_NAME(out_image->image, VK_OBJECT_TYPE_IMAGE, config->debug_name);
+    }
+
+    return VK_SUCCESS;
+}
+
+void ve_image_destroy(ve_image* image) {
+    if (!image || image->image == VK_NULL_HANDLE) {
+        return;
+    }
+
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    if (image->view != VK_NULL_HANDLE) {
+        vkDestroyImageView(vk->device, image->view, NULL);
+    }
+    vkDestroyImage(vk->device, image->image, NULL);
+    ve_gpu_memory_free(&image->allocation);
+
+    memset(image, 0, sizeof(ve_image));
+}
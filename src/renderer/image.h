@@ -7,12 +7,65 @@
 #define VE_IMAGE_H
 
 #include "vulkan_core.h"
+#include "gpu_memory.h"
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* TODO: Implement image management */
+/**
+ * @brief 2D image creation parameters
+ *
+ * Zero mip_levels, array_layers and samples default to 1. Color and depth
+ * attachments (render targets) get dedicated allocations, since they are
+ * large and recreated on resize.
+ */
+typedef struct ve_image_config {
+    uint32_t width;
+    uint32_t height;
+    uint32_t mip_levels;
+    uint32_t array_layers;
+    VkFormat format;
+    VkImageUsageFlags usage;
+    VkSampleCountFlagBits samples;
+    VkImageTiling tiling;
+    VkImageAspectFlags aspect;      /* View aspect */
+    ve_gpu_memory_usage memory_usage;
+    uint32_t allocation_flags;      /* ve_gpu_allocation_flags */
+    const char* debug_name;         /* Optional */
+} ve_image_config;
+
+/**
+ * @brief Image with its view and sub-allocated memory
+ */
+typedef struct ve_image {
+    VkImage image;
+    VkImageView view;
+    ve_gpu_allocation allocation;
+    VkFormat format;
+    VkExtent3D extent;
+    uint32_t mip_levels;
+    uint32_t array_layers;
+} ve_image;
+
+/**
+ * @brief Create an image, bind memory to it and create a view of all of it
+ *
+ * @param config Image parameters
+ * @param out_image Receives the image
+ * @return VK_SUCCESS on success
+ */
+VkResult ve_image_create(const ve_image_config* config, ve_image* out_image);
+
+/**
+ * @brief Destroy an image, its view and free its memory
+ *
+ * The GPU must be done with the image.
+ *
+ * @param image Image to destroy, cleared on return
+ */
+void ve_image_destroy(ve_image* image);
 
 #ifdef __cplusplus
 }
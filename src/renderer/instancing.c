@@ -0,0 +1,355 @@
+/**
+ * @file instancing.c
+ * @brief Instanced draws from a persistent instance buffer implementation
+ */
+
+#define VK_NO_PROTOTYPES
+#include "instancing.h"
+
+#include "buffer.h"
+#include "descriptor.h"
+#include "sync.h"
+#include "upload.h"
+#include "../core/logger.h"
+#include "../core/assert.h"
+#include "../core/memory.h"
+#include "../ecs/components.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+VE_STATIC_ASSERT(sizeof(ve_gpu_instance) == 64, "Instance layout out of sync with gbuffer_instanced.vert");
+VE_STATIC_ASSERT(VE_MAX_FRAMES_IN_FLIGHT <= 8, "Pending copies are tracked in a byte per slot");
+
+/**
+ * @brief Push constants of gbuffer_instanced.vert (std430)
+ */
+typedef struct ve_instancing_push {
+    float view_projection[16];
+    float position_scale[4];
+    float position_offset[4];
+    uint32_t instance_buffer;
+    uint32_t instance_id_buffer;
+} ve_instancing_push;
+
+VE_STATIC_ASSERT(sizeof(ve_instancing_push) == VE_INSTANCING_PUSH_CONSTANT_SIZE,
+                 "Instancing push constants out of sync");
+
+/**
+ * @brief Resources of one frame in flight
+ */
+typedef struct ve_instancing_frame {
+    ve_buffer instances;            /* This frame's copy of every slot */
+    ve_buffer instance_ids;         /* Slots in draw order, written by the CPU each frame */
+    uint32_t instance_index;        /* Bindless indices of the two */
+    uint32_t instance_id_index;
+    uint32_t draw_instances;
+} ve_instancing_frame;
+
+/* Global instancing state */
+static struct {
+    bool initialized;
+    uint32_t capacity;
+    ve_gpu_instance* instances;     /* CPU copy of every slot */
+    uint8_t* pending;               /* Per slot, one bit per frame copy still to upload */
+    uint32_t* pending_slots;        /* Slots with a pending bit */
+    uint32_t pending_count;
+    uint64_t uploaded_instances;
+    uint64_t upload_runs;
+    uint64_t dropped;
+    ve_instancing_frame frames[VE_MAX_FRAMES_IN_FLIGHT];
+} g_instancing = {0};
+
+static VkResult create_frame(ve_instancing_frame* frame) {
+    ve_buffer_config instance_config = {
+        .size = (VkDeviceSize)g_instancing.capacity * sizeof(ve_gpu_instance),
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .memory_usage = VE_GPU_MEMORY_USAGE_GPU_ONLY,
+        .debug_name = "instances",
+    };
+    VkResult result = ve_buffer_create(&instance_config, &frame->instances);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    ve_buffer_config id_config = {
+        .size = (VkDeviceSize)g_instancing.capacity * sizeof(uint32_t),
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        .memory_usage = VE_GPU_MEMORY_USAGE_CPU_TO_GPU,
+        .debug_name = "instance_ids",
+    };
+    result = ve_buffer_create(&id_config, &frame->instance_ids);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    frame->instance_index = ve_bindless_register_buffer(frame->instances.buffer, 0, instance_config.size);
+    frame->instance_id_index = ve_bindless_register_buffer(frame->instance_ids.buffer, 0, id_config.size);
+    if (frame->instance_index == VE_BINDLESS_INVALID_INDEX || frame->instance_id_index == VE_BINDLESS_INVALID_INDEX) {
+        return VK_ERROR_OUT_OF_POOL_MEMORY;
+    }
+    return VK_SUCCESS;
+}
+
+static void destroy_frame(ve_instancing_frame* frame) {
+    if (frame->instance_index != VE_BINDLESS_INVALID_INDEX) {
+        ve_bindless_release(VE_BINDLESS_STORAGE_BUFFERS, frame->instance_index);
+    }
+    if (frame->instance_id_index != VE_BINDLESS_INVALID_INDEX) {
+        ve_bindless_release(VE_BINDLESS_STORAGE_BUFFERS, frame->instance_id_index);
+    }
+    ve_buffer_destroy(&frame->instances);
+    ve_buffer_destroy(&frame->instance_ids);
+}
+
+VkResult ve_instancing_init(uint32_t capacity) {
+    if (g_instancing.initialized) {
+        VE_LOG_WARN("Instancing already initialized");
+        return VK_SUCCESS;
+    }
+    if (!ve_bindless_is_enabled() || !ve_upload_is_enabled()) {
+        VE_LOG_INFO("Instancing needs bindless descriptors and the staging ring, disabled");
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    memset(&g_instancing, 0, sizeof(g_instancing));
+    g_instancing.capacity = capacity ? capacity : VE_INSTANCING_MAX_INSTANCES;
+    for (uint32_t i = 0; i < VE_MAX_FRAMES_IN_FLIGHT; i++) {
+        g_instancing.frames[i].instance_index = VE_BINDLESS_INVALID_INDEX;
+        g_instancing.frames[i].instance_id_index = VE_BINDLESS_INVALID_INDEX;
+    }
+
+    g_instancing.instances =
+        (ve_gpu_instance*)ve_allocate_cleared(g_instancing.capacity, sizeof(ve_gpu_instance), VE_MEMORY_TAG_RENDERER);
+    g_instancing.pending = (uint8_t*)ve_allocate_cleared(g_instancing.capacity, sizeof(uint8_t), VE_MEMORY_TAG_RENDERER);
+    g_instancing.pending_slots =
+        (uint32_t*)ve_allocate_cleared(g_instancing.capacity, sizeof(uint32_t), VE_MEMORY_TAG_RENDERER);
+    if (!g_instancing.instances || !g_instancing.pending || !g_instancing.pending_slots) {
+        VE_LOG_ERROR("Out of memory creating %u instance slots", g_instancing.capacity);
+        ve_instancing_shutdown();
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    for (uint32_t i = 0; i < VE_MAX_FRAMES_IN_FLIGHT; i++) {
+        VkResult result = create_frame(&g_instancing.frames[i]);
+        if (result != VK_SUCCESS) {
+            VE_LOG_ERROR("Failed to create instance buffers: %d", result);
+            ve_instancing_shutdown();
+            return result;
+        }
+    }
+
+    VE_LOG_DEBUG("Instancing initialized (%u slots)", g_instancing.capacity);
+    g_instancing.initialized = true;
+    return VK_SUCCESS;
+}
+
+void ve_instancing_shutdown(void) {
+    /* Set first thing by init, so nothing exists without it */
+    if (g_instancing.capacity == 0) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < VE_MAX_FRAMES_IN_FLIGHT; i++) {
+        destroy_frame(&g_instancing.frames[i]);
+    }
+    VE_FREE(g_instancing.instances);
+    VE_FREE(g_instancing.pending);
+    VE_FREE(g_instancing.pending_slots);
+    memset(&g_instancing, 0, sizeof(g_instancing));
+}
+
+bool ve_instancing_is_enabled(void) {
+    return g_instancing.initialized;
+}
+
+/**
+ * @brief Mark a slot for upload into every frame's copy
+ */
+static void mark_pending(uint32_t slot) {
+    if (g_instancing.pending[slot] == 0) {
+        g_instancing.pending_slots[g_instancing.pending_count++] = slot;
+    }
+    g_instancing.pending[slot] = (uint8_t)((1u << ve_sync_get_frames_in_flight()) - 1);
+}
+
+void ve_instancing_set(uint32_t slot, const ve_gpu_instance* instance) {
+    VE_ASSERT(g_instancing.initialized && instance);
+    VE_ASSERT_MSG(slot < g_instancing.capacity, "Instance slot out of range");
+
+    g_instancing.instances[slot] = *instance;
+    mark_pending(slot);
+}
+
+/* Serial, so it owns the CPU copy and the pending list while it runs */
+static void instance_system(const ve_system_context* context) {
+    const ve_query_iter* chunk = context->chunk;
+    const ve_transform_component* transforms =
+        (const ve_transform_component*)ve_query_column(chunk, VE_COMPONENT_TRANSFORM);
+    const ve_render_component* renders = (const ve_render_component*)ve_query_column(chunk, VE_COMPONENT_RENDER);
+
+    for (uint32_t i = 0; i < chunk->count; i++) {
+        uint32_t slot = chunk->entities[i] & (VE_ECS_MAX_ENTITIES - 1);
+        if (slot >= g_instancing.capacity) {
+            g_instancing.dropped++;
+            continue;
+        }
+
+        const ve_transform_component* t = &transforms[i];
+        ve_mat4 model = ve_mat4_from_trs(ve_vec3_make(t->position[0], t->position[1], t->position[2]),
+                                         (ve_quat){t->rotation[0], t->rotation[1], t->rotation[2], t->rotation[3]},
+                                         ve_vec3_make(t->scale[0], t->scale[1], t->scale[2]));
+        ve_gpu_instance* instance = &g_instancing.instances[slot];
+        for (uint32_t row = 0; row < 3; row++) {
+            for (uint32_t column = 0; column < 4; column++) {
+                instance->model[row * 4 + column] = model.m[column * 4 + row];
+            }
+        }
+        instance->material = renders[i].material;
+        instance->mesh = renders[i].mesh;
+        mark_pending(slot);
+    }
+}
+
+uint32_t ve_instancing_register_system(ve_system_scheduler* scheduler) {
+    VE_ASSERT(g_instancing.initialized && scheduler);
+
+    ve_system_desc desc = {
+        .name = "instancing",
+        .fn = instance_system,
+        .reads = VE_COMPONENT_BIT(VE_COMPONENT_TRANSFORM) | VE_COMPONENT_BIT(VE_COMPONENT_RENDER),
+        .changed = VE_COMPONENT_BIT(VE_COMPONENT_TRANSFORM) | VE_COMPONENT_BIT(VE_COMPONENT_RENDER),
+        .serial = true,
+    };
+    return ve_scheduler_add_system(scheduler, &desc);
+}
+
+static int compare_slots(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+void ve_instancing_update(void) {
+    if (!g_instancing.initialized || g_instancing.pending_count == 0) {
+        return;
+    }
+
+    uint32_t frame_index = ve_sync_get_current_frame_index();
+    uint8_t bit = (uint8_t)(1u << frame_index);
+    VkBuffer buffer = g_instancing.frames[frame_index].instances.buffer;
+
+    /* Sorted, runs of consecutive slots become one copy each */
+    qsort(g_instancing.pending_slots, g_instancing.pending_count, sizeof(uint32_t), compare_slots);
+
+    bool ring_full = false;
+    uint32_t i = 0;
+    while (i < g_instancing.pending_count && !ring_full) {
+        uint32_t first = g_instancing.pending_slots[i];
+        if (!(g_instancing.pending[first] & bit)) {
+            i++;
+            continue;
+        }
+        uint32_t end = i + 1;
+        while (end < g_instancing.pending_count && g_instancing.pending_slots[end] == first + (end - i) &&
+               (g_instancing.pending[g_instancing.pending_slots[end]] & bit)) {
+            end++;
+        }
+
+        uint32_t count = end - i;
+        if (ve_upload_buffer(buffer, (VkDeviceSize)first * sizeof(ve_gpu_instance), &g_instancing.instances[first],
+                             (VkDeviceSize)count * sizeof(ve_gpu_instance))) {
+            for (uint32_t slot = first; slot < first + count; slot++) {
+                g_instancing.pending[slot] &= (uint8_t)~bit;
+            }
+            g_instancing.uploaded_instances += count;
+            g_instancing.upload_runs++;
+        } else {
+            ring_full = true;
+        }
+        i = end;
+    }
+
+    /* Drop slots every copy has received */
+    uint32_t kept = 0;
+    for (uint32_t p = 0; p < g_instancing.pending_count; p++) {
+        uint32_t slot = g_instancing.pending_slots[p];
+        if (g_instancing.pending[slot]) {
+            g_instancing.pending_slots[kept++] = slot;
+        }
+    }
+    g_instancing.pending_count = kept;
+}
+
+bool ve_instancing_set_draws(const ve_camera_draws* draws) {
+    VE_ASSERT(g_instancing.initialized && draws);
+
+    ve_instancing_frame* frame = &g_instancing.frames[ve_sync_get_current_frame_index()];
+    if (draws->instance_count > g_instancing.capacity) {
+        VE_LOG_ERROR("Too many drawn instances (%u of %u slots)", draws->instance_count, g_instancing.capacity);
+        frame->draw_instances = 0;
+        return false;
+    }
+
+    if (draws->instance_count > 0) {
+        uint32_t* mapped = (uint32_t*)ve_buffer_get_mapped(&frame->instance_ids);
+        memcpy(mapped, draws->instances, sizeof(uint32_t) * draws->instance_count);
+    }
+    frame->draw_instances = draws->instance_count;
+    return true;
+}
+
+void ve_instancing_describe_mesh(const ve_mesh_data* data, uint32_t first_index, int32_t vertex_offset,
+                                 ve_instancing_mesh* mesh) {
+    VE_ASSERT(data && mesh && data->lod_count <= VE_MESH_MAX_LODS);
+
+    memset(mesh, 0, sizeof(ve_instancing_mesh));
+    mesh->first_index = first_index;
+    mesh->vertex_offset = vertex_offset;
+    mesh->lod_count = data->lod_count;
+    memcpy(mesh->lods, data->lods, sizeof(ve_mesh_lod) * data->lod_count);
+    for (uint32_t i = 0; i < 3; i++) {
+        mesh->position_scale[i] = data->bounds_max[i] - data->bounds_min[i];
+        mesh->position_offset[i] = data->bounds_min[i];
+    }
+}
+
+void ve_instancing_draw(ve_command_buffer* cmd, const ve_instancing_mesh* mesh, const ve_instanced_draw* draw,
+                        const float view_projection[16]) {
+    VE_ASSERT(cmd && cmd->is_recording && mesh && draw && view_projection);
+
+    if (mesh->lod_count == 0 || draw->instance_count == 0) {
+        return;
+    }
+
+    /* Nodes may carry more levels than their mesh was cooked with */
+    const ve_instancing_frame* frame = &g_instancing.frames[ve_sync_get_current_frame_index()];
+    VE_ASSERT_MSG(draw->first_instance + draw->instance_count <= frame->draw_instances, "Draw outside the ID list");
+    const ve_mesh_lod* lod = &mesh->lods[draw->lod < mesh->lod_count ? draw->lod : mesh->lod_count - 1];
+
+    ve_instancing_push push = {
+        .instance_buffer = frame->instance_index,
+        .instance_id_buffer = frame->instance_id_index,
+    };
+    memcpy(push.view_projection, view_projection, sizeof(push.view_projection));
+    memcpy(push.position_scale, mesh->position_scale, sizeof(mesh->position_scale));
+    memcpy(push.position_offset, mesh->position_offset, sizeof(mesh->position_offset));
+
+    vkCmdPushConstants(cmd->buffer, ve_bindless_get_pipeline_layout(), VK_SHADER_STAGE_ALL, 0, sizeof(push), &push);
+    vkCmdDrawIndexed(cmd->buffer, lod->index_count, draw->instance_count, mesh->first_index + lod->index_offset,
+                     mesh->vertex_offset, draw->first_instance);
+}
+
+void ve_instancing_get_stats(ve_instancing_stats* stats) {
+    VE_ASSERT(stats);
+
+    memset(stats, 0, sizeof(ve_instancing_stats));
+    stats->capacity = g_instancing.capacity;
+    stats->pending = g_instancing.pending_count;
+    if (g_instancing.initialized) {
+        stats->draw_instances = g_instancing.frames[ve_sync_get_current_frame_index()].draw_instances;
+    }
+    stats->uploaded_instances = g_instancing.uploaded_instances;
+    stats->upload_runs = g_instancing.upload_runs;
+    stats->dropped = g_instancing.dropped;
+}
@@ -0,0 +1,180 @@
+/**
+ * @file instancing.h
+ * @brief Instanced draws from a persistent instance buffer
+ *
+ * Per-instance data (world transform, material, mesh) lives in a
+ * device-local storage buffer indexed by instance slot, the entity index
+ * for ECS entities. It is not rebuilt per frame: a changed-only ECS system
+ * (ve_instancing_register_system) rewrites the CPU copy of the slots whose
+ * transform or render component changed since its last run, and
+ * ve_instancing_update uploads just those slots through the staging ring,
+ * coalesced into runs of consecutive slots.
+ *
+ * Each frame in flight has its own copy of the buffer, so an upload never
+ * overwrites data a frame still in flight is reading; a changed slot is
+ * uploaded once into every copy as the frames come around.
+ *
+ * ve_camera_build_draws merges the camera's sorted visible list into
+ * instanced draws; ve_instancing_set_draws copies their instance slots into
+ * the frame's instance ID buffer. gbuffer_instanced.vert finds its slot at
+ * instance_ids[gl_InstanceIndex], since the draw's first instance is its
+ * offset into that list, and reads the transform and material from there.
+ * Requires bindless descriptors and the staging ring.
+ */
+
+#ifndef VE_INSTANCING_H
+#define VE_INSTANCING_H
+
+#include "vulkan_core.h"
+#include "command_buffer.h"
+#include "../assets/model_loader.h"
+#include "../ecs/systems.h"
+#include "../scene/camera.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Default instance slots */
+#define VE_INSTANCING_MAX_INSTANCES 65536
+
+/* Push constant bytes used by gbuffer_instanced.vert, below gbuffer.frag's material block */
+#define VE_INSTANCING_PUSH_CONSTANT_SIZE 104
+
+/**
+ * @brief Instance buffer entry (std430), 64 bytes
+ */
+typedef struct ve_gpu_instance {
+    float model[12];            /* First three rows of the world matrix */
+    uint32_t material;
+    uint32_t mesh;
+    uint32_t padding[2];
+} ve_gpu_instance;
+
+/**
+ * @brief Where a mesh's levels of detail live in the bound vertex and index buffers
+ */
+typedef struct ve_instancing_mesh {
+    uint32_t first_index;           /* Of the mesh's index data */
+    int32_t vertex_offset;
+    uint32_t lod_count;
+    ve_mesh_lod lods[VE_MESH_MAX_LODS];
+    float position_scale[3];        /* Dequantization range of the packed positions */
+    float position_offset[3];
+} ve_instancing_mesh;
+
+/**
+ * @brief Instancing statistics
+ */
+typedef struct ve_instancing_stats {
+    uint32_t capacity;
+    uint32_t pending;               /* Slots still to upload into some frame's copy */
+    uint32_t draw_instances;        /* Instance IDs of the current frame */
+    uint64_t uploaded_instances;
+    uint64_t upload_runs;
+    uint64_t dropped;               /* Entities whose slot is past the capacity */
+} ve_instancing_stats;
+
+/**
+ * @brief Create the instance buffers
+ *
+ * @param capacity Instance slots, 0 for VE_INSTANCING_MAX_INSTANCES
+ * @return VK_SUCCESS on success, VK_ERROR_FEATURE_NOT_PRESENT without bindless descriptors or the staging ring
+ */
+VkResult ve_instancing_init(uint32_t capacity);
+
+/**
+ * @brief Destroy the instance buffers
+ *
+ * The device must be idle.
+ */
+void ve_instancing_shutdown(void);
+
+/**
+ * @brief Check if instancing is available
+ *
+ * @return true if initialized
+ */
+bool ve_instancing_is_enabled(void);
+
+/**
+ * @brief Register the system that tracks instance changes
+ *
+ * The system visits entities with a transform and a render component in
+ * chunks where either changed since its last run, and writes their slots
+ * (the entity index). Transforms are taken as world transforms.
+ *
+ * @param scheduler Scheduler of the world holding the instances
+ * @return System index, or VE_INVALID_SYSTEM if the scheduler is full
+ */
+uint32_t ve_instancing_register_system(ve_system_scheduler* scheduler);
+
+/**
+ * @brief Write one instance slot directly
+ *
+ * For instances outside the ECS. Not thread safe against the system.
+ *
+ * @param slot Instance slot
+ * @param instance Instance data
+ */
+void ve_instancing_set(uint32_t slot, const ve_gpu_instance* instance);
+
+/**
+ * @brief Upload changed slots into the current frame's copy
+ *
+ * Call once per frame on the frame thread, after the frame slot's previous
+ * work has completed and the ECS systems have run, and before
+ * ve_upload_flush. Slots the staging ring has no room for stay pending for
+ * the next update.
+ */
+void ve_instancing_update(void);
+
+/**
+ * @brief Set the instance IDs the frame's draws read
+ *
+ * @param draws Draws from ve_camera_build_draws
+ * @return false if there are more instances than slots
+ */
+bool ve_instancing_set_draws(const ve_camera_draws* draws);
+
+/**
+ * @brief Describe a cooked mesh placed in shared vertex and index buffers
+ *
+ * @param data Cooked mesh
+ * @param first_index Index of the mesh's first index in the index buffer
+ * @param vertex_offset Offset of the mesh's first vertex in the vertex buffer
+ * @param mesh Output description
+ */
+void ve_instancing_describe_mesh(const ve_mesh_data* data, uint32_t first_index, int32_t vertex_offset,
+                                 ve_instancing_mesh* mesh);
+
+/**
+ * @brief Record one instanced draw
+ *
+ * Record inside a render pass with an instanced pipeline on the bindless
+ * layout, the bindless set and the mesh's vertex and index buffers bound.
+ * Material push constants past VE_INSTANCING_PUSH_CONSTANT_SIZE are left
+ * untouched.
+ *
+ * @param cmd Graphics command buffer
+ * @param mesh Mesh of the draw
+ * @param draw Draw from the list passed to ve_instancing_set_draws this frame
+ * @param view_projection View-projection matrix
+ */
+void ve_instancing_draw(ve_command_buffer* cmd, const ve_instancing_mesh* mesh, const ve_instanced_draw* draw,
+                        const float view_projection[16]);
+
+/**
+ * @brief Get instancing statistics
+ *
+ * @param stats Output statistics
+ */
+void ve_instancing_get_stats(ve_instancing_stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_INSTANCING_H */
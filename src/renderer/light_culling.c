@@ -0,0 +1,360 @@
+/**
+ * @file light_culling.c
+ * @brief Clustered light culling compute pass implementation
+ */
+
+#define VK_NO_PROTOTYPES
+#include "light_culling.h"
+
+#include "buffer.h"
+#include "descriptor.h"
+#include "pipeline.h"
+#include "shader.h"
+#include "sync.h"
+#include "../core/logger.h"
+#include "../core/assert.h"
+
+#include <math.h>
+#include <string.h>
+
+/**
+ * @brief ClusterParams uniform block (std140)
+ */
+typedef struct ve_light_cluster_params {
+    float view[16];
+    float projection[16];
+    float screen[4];        /* width, height, 1 / width, 1 / height */
+    float depth[4];         /* z_near, z_far, slice_scale, slice_bias */
+    uint32_t light_count;
+    uint32_t padding[3];
+} ve_light_cluster_params;
+
+/**
+ * @brief Resources of one frame in flight
+ */
+typedef struct ve_light_culling_frame {
+    ve_buffer params;
+    ve_buffer lights;
+    ve_buffer counts;
+    ve_buffer indices;
+    ve_descriptor_allocation set;
+    uint32_t light_count;
+} ve_light_culling_frame;
+
+/* Global light culling state */
+static struct {
+    bool initialized;
+    VkShaderModule shader;
+    VkDescriptorSetLayout set_layout;
+    VkPipelineLayout pipeline_layout;
+    ve_pipeline* pipeline;
+    ve_light_culling_frame frames[VE_MAX_FRAMES_IN_FLIGHT];
+} g_light_culling = {0};
+
+static VkResult create_frame(ve_light_culling_frame* frame) {
+    const struct {
+        ve_buffer* buffer;
+        VkDeviceSize size;
+        VkBufferUsageFlags usage;
+        ve_gpu_memory_usage memory_usage;
+        const char* name;
+    } buffers[] = {
+        {&frame->params, sizeof(ve_light_cluster_params), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+         VE_GPU_MEMORY_USAGE_CPU_TO_GPU, "light_cluster_params"},
+        {&frame->lights, VE_LIGHT_MAX_LIGHTS * sizeof(ve_point_light), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+         VE_GPU_MEMORY_USAGE_CPU_TO_GPU, "point_lights"},
+        {&frame->counts, VE_LIGHT_CLUSTER_COUNT * sizeof(uint32_t),
+         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+         VE_GPU_MEMORY_USAGE_GPU_ONLY, "light_cluster_counts"},
+        {&frame->indices, (VkDeviceSize)VE_LIGHT_CLUSTER_COUNT * VE_LIGHT_MAX_PER_CLUSTER * sizeof(uint32_t),
+         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VE_GPU_MEMORY_USAGE_GPU_ONLY, "light_cluster_indices"},
+    };
+
+    for (uint32_t i = 0; i < sizeof(buffers) / sizeof(buffers[0]); i++) {
+        ve_buffer_config config = {
+            .size = buffers[i].size,
+            .usage = buffers[i].usage,
+            .memory_usage = buffers[i].memory_usage,
+            .concurrent = true,     /* Written by async compute, read by the lighting pass */
+            .debug_name = buffers[i].name,
+        };
+        VkResult result = ve_buffer_create(&config, buffers[i].buffer);
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+    }
+
+    if (!ve_descriptor_allocate(g_light_culling.set_layout, &frame->set)) {
+        return VK_ERROR_OUT_OF_POOL_MEMORY;
+    }
+
+    /* The buffers never change, so the set is written once */
+    VkDescriptorBufferInfo infos[4] = {
+        {frame->params.buffer, 0, VK_WHOLE_SIZE},
+        {frame->lights.buffer, 0, VK_WHOLE_SIZE},
+        {frame->counts.buffer, 0, VK_WHOLE_SIZE},
+        {frame->indices.buffer, 0, VK_WHOLE_SIZE},
+    };
+
+    VkWriteDescriptorSet writes[4];
+    for (uint32_t i = 0; i < 4; i++) {
+        writes[i] = (VkWriteDescriptorSet){
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = frame->set.set,
+            .dstBinding = i,
+            .descriptorCount = 1,
+            .descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo = &infos[i],
+        };
+    }
+
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    vkUpdateDescriptorSets(vk->device, 4, writes, 0, NULL);
+    return VK_SUCCESS;
+}
+
+static void destroy_frame(ve_light_culling_frame* frame) {
+    ve_descriptor_free(&frame->set);
+    ve_buffer_destroy(&frame->params);
+    ve_buffer_destroy(&frame->lights);
+    ve_buffer_destroy(&frame->counts);
+    ve_buffer_destroy(&frame->indices);
+    memset(frame, 0, sizeof(ve_light_culling_frame));
+}
+
+VkResult ve_light_culling_init(const char* shader_path) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VE_ASSERT(vk && vk->device && shader_path);
+
+    memset(&g_light_culling, 0, sizeof(g_light_culling));
+
+    if (!ve_vulkan_supports_compute()) {
+        VE_LOG_WARN("Compute not supported, light culling disabled");
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    VkDescriptorSetLayoutBinding bindings[4];
+    for (uint32_t i = 0; i < 4; i++) {
+        bindings[i] = (VkDescriptorSetLayoutBinding){
+            .binding = i,
+            .descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        };
+    }
+
+    VkDescriptorSetLayoutCreateInfo layout_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = 4,
+        .pBindings = bindings,
+    };
+
+    g_light_culling.set_layout = ve_descriptor_layout_get(&layout_info);
+    if (g_light_culling.set_layout == VK_NULL_HANDLE) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pSetLayouts = &g_light_culling.set_layout,
+    };
+
+    VkResult result = vkCreatePipelineLayout(vk->device, &pipeline_layout_info, NULL, &g_light_culling.pipeline_layout);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to create light culling pipeline layout: %d", result);
+        ve_light_culling_shutdown();
+        return result;
+    }
+
+    for (uint32_t i = 0; i < VE_MAX_FRAMES_IN_FLIGHT; i++) {
+        result = create_frame(&g_light_culling.frames[i]);
+        if (result != VK_SUCCESS) {
+            VE_LOG_ERROR("Failed to create light culling buffers: %d", result);
+            ve_light_culling_shutdown();
+            return result;
+        }
+    }
+
+    result = ve_shader_load_module(shader_path, &g_light_culling.shader);
+    if (result != VK_SUCCESS) {
+        ve_light_culling_shutdown();
+        return result;
+    }
+
+    /* Compiles in the background; dispatches clear the clusters until it is ready */
+    ve_compute_pipeline_desc pipeline_desc = {
+        .shader = g_light_culling.shader,
+        .layout = g_light_culling.pipeline_layout,
+        .debug_name = "light_cull",
+    };
+    g_light_culling.pipeline = ve_pipeline_acquire_compute(&pipeline_desc);
+    if (!g_light_culling.pipeline) {
+        ve_light_culling_shutdown();
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    g_light_culling.initialized = true;
+    return VK_SUCCESS;
+}
+
+void ve_light_culling_shutdown(void) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+
+    if (g_light_culling.pipeline) {
+        ve_pipeline_wait(g_light_culling.pipeline);
+        ve_pipeline_release(g_light_culling.pipeline);
+    }
+    ve_shader_destroy_module(g_light_culling.shader);
+
+    for (uint32_t i = 0; i < VE_MAX_FRAMES_IN_FLIGHT; i++) {
+        destroy_frame(&g_light_culling.frames[i]);
+    }
+
+    if (vk && vk->device && g_light_culling.pipeline_layout != VK_NULL_HANDLE) {
+        vkDestroyPipelineLayout(vk->device, g_light_culling.pipeline_layout, NULL);
+    }
+
+    /* The set layout belongs to the layout cache */
+    memset(&g_light_culling, 0, sizeof(g_light_culling));
+}
+
+bool ve_light_culling_is_enabled(void) {
+    return g_light_culling.initialized;
+}
+
+uint32_t ve_light_culling_set_lights(const ve_point_light* lights, uint32_t count) {
+    VE_ASSERT(g_light_culling.initialized && (lights || count == 0));
+
+    if (count > VE_LIGHT_MAX_LIGHTS) {
+        VE_LOG_WARN("Too many point lights (%u), keeping %u", count, VE_LIGHT_MAX_LIGHTS);
+        count = VE_LIGHT_MAX_LIGHTS;
+    }
+
+    ve_light_culling_frame* frame = &g_light_culling.frames[ve_sync_get_current_frame_index()];
+    if (count > 0) {
+        memcpy(ve_buffer_get_mapped(&frame->lights), lights, count * sizeof(ve_point_light));
+    }
+    frame->light_count = count;
+    return count;
+}
+
+static void write_params(ve_light_culling_frame* frame, const ve_light_culling_view* view) {
+    VE_ASSERT(view->width > 0 && view->height > 0 && view->z_near > 0.0f && view->z_far > view->z_near);
+
+    /* Slice k of the exponential split holds view depths near * (far / near)^(k / Z) and up */
+    float log_ratio = logf(view->z_far / view->z_near);
+    ve_light_cluster_params* params = (ve_light_cluster_params*)ve_buffer_get_mapped(&frame->params);
+    memcpy(params->view, view->view, sizeof(params->view));
+    memcpy(params->projection, view->projection, sizeof(params->projection));
+    params->screen[0] = (float)view->width;
+    params->screen[1] = (float)view->height;
+    params->screen[2] = 1.0f / (float)view->width;
+    params->screen[3] = 1.0f / (float)view->height;
+    params->depth[0] = view->z_near;
+    params->depth[1] = view->z_far;
+    params->depth[2] = (float)VE_LIGHT_CLUSTER_Z / log_ratio;
+    params->depth[3] = -(float)VE_LIGHT_CLUSTER_Z * logf(view->z_near) / log_ratio;
+    params->light_count = frame->light_count;
+}
+
+/**
+ * @brief Record the dispatch, or the clear while the pipeline compiles
+ *
+ * @return Stage that wrote the cluster lists
+ */
+static VkPipelineStageFlags record_culling(ve_command_buffer* cmd, ve_light_culling_frame* frame) {
+    if (ve_pipeline_is_ready(g_light_culling.pipeline)) {
+        vkCmdBindPipeline(cmd->buffer, VK_PIPELINE_BIND_POINT_COMPUTE, g_light_culling.pipeline->pipeline);
+        vkCmdBindDescriptorSets(cmd->buffer, VK_PIPELINE_BIND_POINT_COMPUTE, g_light_culling.pipeline_layout,
+                                0, 1, &frame->set.set, 0, NULL);
+        ve_command_buffer_dispatch(cmd, (VE_LIGHT_CLUSTER_COUNT + VE_LIGHT_CULL_GROUP_SIZE - 1) / VE_LIGHT_CULL_GROUP_SIZE,
+                                   1, 1);
+        return VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    }
+
+    /* No lists yet: lighting sees empty clusters rather than stale or uninitialized ones */
+    vkCmdFillBuffer(cmd->buffer, frame->counts.buffer, 0, VK_WHOLE_SIZE, 0);
+    return VK_PIPELINE_STAGE_TRANSFER_BIT;
+}
+
+void ve_light_culling_dispatch(ve_command_buffer* cmd, const ve_light_culling_view* view) {
+    VE_ASSERT(cmd && cmd->is_recording && view && g_light_culling.initialized);
+
+    ve_light_culling_frame* frame = &g_light_culling.frames[ve_sync_get_current_frame_index()];
+    write_params(frame, view);
+
+    ve_vulkan_begin_debug_label(cmd->buffer, "light_culling", 1.0f, 0.8f, 0.2f);
+
+    VkPipelineStageFlags stage = record_culling(cmd, frame);
+    VkMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = stage == VK_PIPELINE_STAGE_TRANSFER_BIT ? VK_ACCESS_TRANSFER_WRITE_BIT
+                                                                 : VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+    };
+    ve_command_buffer_pipeline_barrier(cmd, stage, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                                       1, &barrier, 0, NULL, 0, NULL);
+
+    ve_vulkan_end_debug_label(cmd->buffer);
+}
+
+static void execute_graph_pass(ve_render_graph* graph, ve_command_buffer* cmd, void* user_data) {
+    (void)graph;
+    (void)user_data;
+
+    ve_light_culling_frame* frame = &g_light_culling.frames[ve_sync_get_current_frame_index()];
+    VkPipelineStageFlags stage = record_culling(cmd, frame);
+
+    /* The graph tracks the lists as compute writes; chain the clear into that stage */
+    if (stage == VK_PIPELINE_STAGE_TRANSFER_BIT) {
+        VkMemoryBarrier barrier = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        };
+        ve_command_buffer_pipeline_barrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                                           1, &barrier, 0, NULL, 0, NULL);
+    }
+}
+
+bool ve_light_culling_add_pass(ve_render_graph* graph, ve_light_culling_graph* handles) {
+    VE_ASSERT(graph && handles && g_light_culling.initialized);
+
+    const ve_light_culling_frame* frame = &g_light_culling.frames[0];
+    handles->counts = ve_render_graph_import_buffer(graph, "light_cluster_counts", frame->counts.buffer,
+                                                    frame->counts.size);
+    handles->indices = ve_render_graph_import_buffer(graph, "light_cluster_indices", frame->indices.buffer,
+                                                     frame->indices.size);
+    handles->pass = ve_render_graph_add_pass(graph, "light_culling", VE_RENDER_GRAPH_QUEUE_ASYNC_COMPUTE,
+                                             execute_graph_pass, NULL);
+    if (handles->counts == VE_RENDER_GRAPH_INVALID || handles->indices == VE_RENDER_GRAPH_INVALID ||
+        handles->pass == VE_RENDER_GRAPH_INVALID) {
+        return false;
+    }
+
+    return ve_render_graph_use(graph, handles->pass, handles->counts, VE_RENDER_GRAPH_ACCESS_STORAGE_WRITE) &&
+           ve_render_graph_use(graph, handles->pass, handles->indices, VE_RENDER_GRAPH_ACCESS_STORAGE_WRITE);
+}
+
+void ve_light_culling_prepare_graph(ve_render_graph* graph, const ve_light_culling_graph* handles,
+                                    const ve_light_culling_view* view) {
+    VE_ASSERT(graph && handles && view && g_light_culling.initialized);
+
+    ve_light_culling_frame* frame = &g_light_culling.frames[ve_sync_get_current_frame_index()];
+    write_params(frame, view);
+    ve_render_graph_update_buffer(graph, handles->counts, frame->counts.buffer);
+    ve_render_graph_update_buffer(graph, handles->indices, frame->indices.buffer);
+}
+
+VkDescriptorSetLayout ve_light_culling_get_set_layout(void) {
+    return g_light_culling.set_layout;
+}
+
+VkDescriptorSet ve_light_culling_get_set(void) {
+    if (!g_light_culling.initialized) {
+        return VK_NULL_HANDLE;
+    }
+    return g_light_culling.frames[ve_sync_get_current_frame_index()].set.set;
+}
@@ -0,0 +1,165 @@
+/**
+ * @file light_culling.h
+ * @brief Clustered light culling compute pass
+ *
+ * The view frustum is split into a grid of clusters: screen tiles times
+ * exponential depth slices. A compute pass tests every point light
+ * against every cluster's view-space bounds and writes each cluster's
+ * light list, so the lighting pass only shades the lights that can reach a
+ * pixel. Cost then scales with lights per pixel rather than total lights.
+ *
+ * The pass's descriptor set (see ve_light_culling_get_set_layout) is also
+ * bound as set 1 of the lighting pipeline:
+ *   binding 0: uniform ClusterParams (view, projection, screen, depth slices)
+ *   binding 1: buffer of ve_point_light
+ *   binding 2: buffer of per-cluster light counts
+ *   binding 3: buffer of per-cluster light indices, VE_LIGHT_MAX_PER_CLUSTER each
+ *
+ * Matrices are column-major, with a right-handed view looking down -Z and a
+ * Vulkan projection (depth 0 to 1). Every resource is per frame in flight.
+ */
+
+#ifndef VE_LIGHT_CULLING_H
+#define VE_LIGHT_CULLING_H
+
+#include "vulkan_core.h"
+#include "command_buffer.h"
+#include "render_graph.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Cluster grid, must match light_cull.comp and lighting.frag */
+#define VE_LIGHT_CLUSTER_X 16
+#define VE_LIGHT_CLUSTER_Y 9
+#define VE_LIGHT_CLUSTER_Z 24
+#define VE_LIGHT_CLUSTER_COUNT (VE_LIGHT_CLUSTER_X * VE_LIGHT_CLUSTER_Y * VE_LIGHT_CLUSTER_Z)
+#define VE_LIGHT_MAX_PER_CLUSTER 128
+
+/* Lights per frame */
+#define VE_LIGHT_MAX_LIGHTS 4096
+
+/* Threads per workgroup of light_cull.comp */
+#define VE_LIGHT_CULL_GROUP_SIZE 64
+
+/**
+ * @brief Point light, laid out as two vec4 in the shaders
+ */
+typedef struct ve_point_light {
+    float position[3];      /* World space */
+    float radius;           /* Light has no effect beyond this distance */
+    float color[3];
+    float intensity;
+} ve_point_light;
+
+/**
+ * @brief Camera the clusters are built for
+ */
+typedef struct ve_light_culling_view {
+    float view[16];
+    float projection[16];
+    uint32_t width;
+    uint32_t height;
+    float z_near;
+    float z_far;
+} ve_light_culling_view;
+
+/**
+ * @brief Create the culling pipeline and per-frame buffers
+ *
+ * @param shader_path Path to light_cull.comp.spv
+ * @return VK_SUCCESS on success, VK_ERROR_FEATURE_NOT_PRESENT without compute support
+ */
+VkResult ve_light_culling_init(const char* shader_path);
+
+/**
+ * @brief Destroy the culling resources
+ *
+ * The device must be idle.
+ */
+void ve_light_culling_shutdown(void);
+
+/**
+ * @brief Check if light culling is available
+ *
+ * @return true if initialized
+ */
+bool ve_light_culling_is_enabled(void);
+
+/**
+ * @brief Set the current frame's point lights
+ *
+ * @param lights Lights
+ * @param count Light count
+ * @return Lights kept, at most VE_LIGHT_MAX_LIGHTS
+ */
+uint32_t ve_light_culling_set_lights(const ve_point_light* lights, uint32_t count);
+
+/**
+ * @brief Record the culling dispatch for the current frame
+ *
+ * Record outside a render pass, before the lighting pass. Ends with a
+ * barrier making the cluster lists visible to fragment shaders. If the
+ * pipeline is still compiling, the cluster counts are cleared instead so
+ * lighting sees no point lights.
+ *
+ * @param cmd Graphics or compute command buffer
+ * @param view Camera
+ */
+void ve_light_culling_dispatch(ve_command_buffer* cmd, const ve_light_culling_view* view);
+
+/**
+ * @brief Render graph resources of the culling pass
+ */
+typedef struct ve_light_culling_graph {
+    ve_render_graph_handle pass;
+    ve_render_graph_handle counts;      /* Read these from the lighting pass as STORAGE_READ */
+    ve_render_graph_handle indices;
+} ve_light_culling_graph;
+
+/**
+ * @brief Add the culling dispatch to a render graph as an async compute pass
+ *
+ * Lighting passes that read the cluster lists must declare STORAGE_READ
+ * accesses of handles->counts and handles->indices, so the graph orders
+ * them after culling across queues.
+ *
+ * @param graph Graph being declared
+ * @param handles Output resource and pass handles
+ * @return true on success
+ */
+bool ve_light_culling_add_pass(ve_render_graph* graph, ve_light_culling_graph* handles);
+
+/**
+ * @brief Point the graph pass at the current frame's buffers and camera
+ *
+ * Call every frame before executing or submitting the graph.
+ *
+ * @param graph Graph the pass was added to
+ * @param handles Handles from ve_light_culling_add_pass
+ * @param view Camera
+ */
+void ve_light_culling_prepare_graph(ve_render_graph* graph, const ve_light_culling_graph* handles,
+                                    const ve_light_culling_view* view);
+
+/**
+ * @brief Get the cluster set layout
+ *
+ * @return Descriptor set layout
+ */
+VkDescriptorSetLayout ve_light_culling_get_set_layout(void);
+
+/**
+ * @brief Get the current frame's cluster descriptor set
+ *
+ * @return Descriptor set
+ */
+VkDescriptorSet ve_light_culling_get_set(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_LIGHT_CULLING_H */
@@ -0,0 +1,154 @@
+/**
+ * @file meshlet.c
+ * @brief Mesh shader meshlet rendering implementation
+ */
+
+#define VK_NO_PROTOTYPES
+#include "meshlet.h"
+
+#include "descriptor.h"
+#include "upload.h"
+#include "../core/logger.h"
+#include "../core/assert.h"
+#include "../core/memory.h"
+
+#include <string.h>
+
+/**
+ * @brief Push constants of meshlet.task and meshlet.mesh (std430)
+ */
+typedef struct ve_meshlet_push {
+    float model[16];
+    float view_projection[16];
+    float camera_position[3];
+    uint32_t meshlet_count;
+    uint32_t meshlet_buffer;
+    uint32_t vertex_index_buffer;
+    uint32_t triangle_buffer;
+    uint32_t vertex_buffer;
+    uint32_t vertex_stride;
+    uint32_t padding[3];
+} ve_meshlet_push;
+
+VE_STATIC_ASSERT(sizeof(ve_meshlet_push) == VE_MESHLET_PUSH_CONSTANT_SIZE, "Meshlet push constants out of sync");
+
+bool ve_meshlet_is_supported(void) {
+    return ve_vulkan_supports_mesh_shaders() && ve_bindless_is_enabled();
+}
+
+static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+bool ve_meshlet_upload(const ve_meshlet_data* data, ve_meshlet_mesh* mesh) {
+    VE_ASSERT(data && mesh && ve_meshlet_is_supported());
+
+    memset(mesh, 0, sizeof(ve_meshlet_mesh));
+    mesh->meshlet_index = VE_BINDLESS_INVALID_INDEX;
+    mesh->vertex_index = VE_BINDLESS_INVALID_INDEX;
+    mesh->triangle_index = VE_BINDLESS_INVALID_INDEX;
+    if (data->meshlet_count == 0) {
+        return true;
+    }
+
+    /* One buffer and one staging copy, so the upload either happens completely or not at all */
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VkDeviceSize alignment = vk->device_properties.properties.limits.minStorageBufferOffsetAlignment;
+    if (alignment < 4) {
+        alignment = 4;
+    }
+
+    VkDeviceSize sizes[3] = {
+        data->meshlet_count * sizeof(ve_meshlet),
+        data->vertex_count * sizeof(uint32_t),
+        align_up((VkDeviceSize)data->triangle_count * 3, 4),      /* Read as uints */
+    };
+    VkDeviceSize offsets[3] = {0};
+    offsets[1] = align_up(offsets[0] + sizes[0], alignment);
+    offsets[2] = align_up(offsets[1] + sizes[1], alignment);
+    VkDeviceSize total = offsets[2] + sizes[2];
+
+    uint8_t* staging = (uint8_t*)ve_allocate_cleared(1, (size_t)total, VE_MEMORY_TAG_RENDERER);
+    if (!staging) {
+        return false;
+    }
+    memcpy(staging + offsets[0], data->meshlets, (size_t)sizes[0]);
+    memcpy(staging + offsets[1], data->vertices, (size_t)sizes[1]);
+    memcpy(staging + offsets[2], data->triangles, (size_t)data->triangle_count * 3);
+
+    ve_buffer_config config = {
+        .size = total,
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .memory_usage = VE_GPU_MEMORY_USAGE_GPU_ONLY,
+        .debug_name = "meshlets",
+    };
+    if (ve_buffer_create(&config, &mesh->buffer) != VK_SUCCESS) {
+        VE_FREE(staging);
+        return false;
+    }
+
+    bool queued = ve_upload_buffer(mesh->buffer.buffer, 0, staging, total);
+    VE_FREE(staging);
+    if (!queued) {
+        VE_LOG_WARN("Staging ring full, %u meshlets not uploaded", data->meshlet_count);
+        ve_meshlet_destroy(mesh);
+        return false;
+    }
+
+    /* The copy is queued; from here on the buffer has to outlive the upload */
+    mesh->meshlet_count = data->meshlet_count;
+    mesh->meshlet_index = ve_bindless_register_buffer(mesh->buffer.buffer, offsets[0], sizes[0]);
+    mesh->vertex_index = ve_bindless_register_buffer(mesh->buffer.buffer, offsets[1], sizes[1]);
+    mesh->triangle_index = ve_bindless_register_buffer(mesh->buffer.buffer, offsets[2], sizes[2]);
+    if (mesh->meshlet_index == VE_BINDLESS_INVALID_INDEX || mesh->vertex_index == VE_BINDLESS_INVALID_INDEX ||
+        mesh->triangle_index == VE_BINDLESS_INVALID_INDEX) {
+        VE_LOG_ERROR("Bindless storage buffer table full, meshlets not drawable");
+        mesh->meshlet_count = 0;
+        return false;
+    }
+    return true;
+}
+
+void ve_meshlet_destroy(ve_meshlet_mesh* mesh) {
+    if (!mesh) {
+        return;
+    }
+
+    const uint32_t indices[] = {mesh->meshlet_index, mesh->vertex_index, mesh->triangle_index};
+    for (uint32_t i = 0; i < sizeof(indices) / sizeof(indices[0]); i++) {
+        if (indices[i] != VE_BINDLESS_INVALID_INDEX) {
+            ve_bindless_release(VE_BINDLESS_STORAGE_BUFFERS, indices[i]);
+        }
+    }
+
+    ve_buffer_destroy(&mesh->buffer);
+    memset(mesh, 0, sizeof(ve_meshlet_mesh));
+    mesh->meshlet_index = VE_BINDLESS_INVALID_INDEX;
+    mesh->vertex_index = VE_BINDLESS_INVALID_INDEX;
+    mesh->triangle_index = VE_BINDLESS_INVALID_INDEX;
+}
+
+void ve_meshlet_draw(ve_command_buffer* cmd, const ve_meshlet_mesh* mesh, const ve_meshlet_draw_info* info) {
+    VE_ASSERT(cmd && cmd->is_recording && mesh && info);
+    VE_ASSERT_MSG(info->vertex_stride >= 11, "Meshlet vertices need position, normal, texcoord and tangent");
+
+    if (mesh->meshlet_count == 0) {
+        return;
+    }
+
+    ve_meshlet_push push = {
+        .meshlet_count = mesh->meshlet_count,
+        .meshlet_buffer = mesh->meshlet_index,
+        .vertex_index_buffer = mesh->vertex_index,
+        .triangle_buffer = mesh->triangle_index,
+        .vertex_buffer = info->vertex_buffer,
+        .vertex_stride = info->vertex_stride,
+    };
+    memcpy(push.model, info->model, sizeof(push.model));
+    memcpy(push.view_projection, info->view_projection, sizeof(push.view_projection));
+    memcpy(push.camera_position, info->camera_position, sizeof(push.camera_position));
+
+    vkCmdPushConstants(cmd->buffer, ve_bindless_get_pipeline_layout(), VK_SHADER_STAGE_ALL, 0, sizeof(push), &push);
+    vkCmdDrawMeshTasksEXT(cmd->buffer,
+                          (mesh->meshlet_count + VE_MESHLET_TASK_GROUP_SIZE - 1) / VE_MESHLET_TASK_GROUP_SIZE, 1, 1);
+}
@@ -0,0 +1,113 @@
+/**
+ * @file meshlet.h
+ * @brief Mesh shader meshlet rendering
+ *
+ * Meshlets built by ve_meshlet_build are uploaded into storage buffers and
+ * registered in the bindless heap. A draw launches one task workgroup per
+ * VE_MESHLET_TASK_GROUP_SIZE meshlets; each task invocation rejects its
+ * meshlet against the view frustum and its normal cone, and mesh shader
+ * workgroups rasterize only the survivors. Off-screen and back-facing
+ * clusters of a mesh never reach vertex processing.
+ *
+ * Pipelines are ordinary registry pipelines on the bindless layout whose
+ * ve_graphics_pipeline_desc sets task_shader and mesh_shader
+ * (meshlet.task.spv and meshlet.mesh.spv). meshlet.mesh outputs the same
+ * varyings as gbuffer.vert, so gbuffer.frag and its material push
+ * constants are reused unchanged.
+ *
+ * Vertices are read from a bindless storage buffer of interleaved floats:
+ * position, normal, texcoord, tangent. They are not the quantized layout
+ * of cooked meshes that gbuffer.vert reads; the mesh shader's push
+ * constants leave no room for the dequantization range. Devices without
+ * mesh shaders draw the same meshes through gpu_culling.h.
+ */
+
+#ifndef VE_MESHLET_H
+#define VE_MESHLET_H
+
+#include "vulkan_core.h"
+#include "buffer.h"
+#include "command_buffer.h"
+#include "../assets/model_loader.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Meshlets tested per task workgroup, must match meshlet.task */
+#define VE_MESHLET_TASK_GROUP_SIZE 32
+
+/* Push constant bytes used by the task and mesh stages, below gbuffer.frag's material block */
+#define VE_MESHLET_PUSH_CONSTANT_SIZE 176
+
+/**
+ * @brief Meshlets of one mesh on the GPU
+ */
+typedef struct ve_meshlet_mesh {
+    ve_buffer buffer;               /* Meshlets, vertex indices and triangles, one upload */
+    uint32_t meshlet_count;
+    uint32_t meshlet_index;         /* Bindless range of the ve_meshlet array */
+    uint32_t vertex_index;          /* Bindless range of the source vertex index per meshlet vertex */
+    uint32_t triangle_index;        /* Bindless range of the local indices, four per uint */
+} ve_meshlet_mesh;
+
+/**
+ * @brief Per-draw parameters
+ *
+ * The cone test assumes the model matrix scales uniformly.
+ */
+typedef struct ve_meshlet_draw_info {
+    float model[16];
+    float view_projection[16];
+    float camera_position[3];       /* World space */
+    uint32_t vertex_buffer;         /* Bindless storage buffer index of the vertices */
+    uint32_t vertex_stride;         /* Floats per vertex, at least 11 */
+} ve_meshlet_draw_info;
+
+/**
+ * @brief Check if meshlets can be drawn
+ *
+ * @return true with mesh shaders and the bindless heap
+ */
+bool ve_meshlet_is_supported(void);
+
+/**
+ * @brief Upload meshlets and register them in the bindless heap
+ *
+ * The copies go through the staging ring and are usable once the ring's
+ * next flush has been waited on by the graphics queue.
+ *
+ * @param data Meshlets from ve_meshlet_build
+ * @param mesh Output GPU meshlets
+ * @return true on success, false if out of memory or the staging ring is full
+ */
+bool ve_meshlet_upload(const ve_meshlet_data* data, ve_meshlet_mesh* mesh);
+
+/**
+ * @brief Release the buffers and bindless indices of a mesh
+ *
+ * The GPU must be done with the mesh.
+ *
+ * @param mesh Mesh, cleared on return
+ */
+void ve_meshlet_destroy(ve_meshlet_mesh* mesh);
+
+/**
+ * @brief Draw a mesh's meshlets
+ *
+ * Record inside a render pass with a meshlet pipeline and the bindless set
+ * bound. Material push constants past VE_MESHLET_PUSH_CONSTANT_SIZE are
+ * left untouched.
+ *
+ * @param cmd Graphics command buffer
+ * @param mesh Mesh
+ * @param info Draw parameters
+ */
+void ve_meshlet_draw(ve_command_buffer* cmd, const ve_meshlet_mesh* mesh, const ve_meshlet_draw_info* info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_MESHLET_H */
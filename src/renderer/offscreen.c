@@ -0,0 +1,297 @@
+/**
+ * @file offscreen.c
+ * @brief Offscreen render targets with asynchronous readback implementation
+ */
+
+#define VK_NO_PROTOTYPES
+#include "offscreen.h"
+
+#include "buffer.h"
+#include "submit.h"
+#include "sync.h"
+#include "../core/logger.h"
+#include "../core/assert.h"
+
+#include <string.h>
+
+/**
+ * @brief Host-visible buffer one frame is copied into
+ */
+typedef struct readback_slot {
+    ve_buffer buffer;
+    uint64_t frame;
+    bool timeline;                  /* Finished once the queue's timeline reaches value */
+    ve_command_buffer_type queue;
+    uint64_t value;
+    bool held;                      /* Acquired by the CPU */
+} readback_slot;
+
+/* Offscreen state. Slots from tail to head are in submission order, so
+   only the oldest one needs checking. */
+static struct {
+    ve_image targets[VE_MAX_FRAMES_IN_FLIGHT];
+    VkExtent2D extent;
+    VkFormat format;
+    uint32_t texel_size;
+
+    readback_slot slots[VE_OFFSCREEN_MAX_READBACK_SLOTS];
+    uint32_t slot_count;
+    uint32_t head;                  /* Next slot to copy into */
+    uint32_t tail;                  /* Oldest copy */
+    uint32_t count;                 /* Copies between tail and head */
+    bool coherent;                  /* Readback memory needs no invalidation */
+
+    uint64_t read_back;
+    uint64_t dropped;
+    bool initialized;
+} g_offscreen = {0};
+
+/* Bytes per texel of the formats readback supports, 0 for the rest */
+static uint32_t texel_size(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+        case VK_FORMAT_B10G11R11_UFLOAT_PACK32:
+        case VK_FORMAT_R32_SFLOAT:
+        case VK_FORMAT_R32_UINT:
+            return 4;
+        case VK_FORMAT_R16G16B16A16_SFLOAT:
+        case VK_FORMAT_R16G16B16A16_UNORM:
+        case VK_FORMAT_R32G32_SFLOAT:
+            return 8;
+        case VK_FORMAT_R32G32B32A32_SFLOAT:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+static bool slot_is_complete(const readback_slot* slot) {
+    if (slot->timeline) {
+        return ve_submit_get_completed_value(slot->queue) >= slot->value;
+    }
+    return ve_sync_get_completed_frame_count() > slot->frame;
+}
+
+VkResult ve_offscreen_init(const ve_offscreen_config* config) {
+    VE_ASSERT(config && config->width > 0 && config->height > 0);
+
+    if (g_offscreen.initialized) {
+        return VK_SUCCESS;
+    }
+
+    memset(&g_offscreen, 0, sizeof(g_offscreen));
+    g_offscreen.extent = (VkExtent2D){config->width, config->height};
+    g_offscreen.format = config->format != VK_FORMAT_UNDEFINED ? config->format : VK_FORMAT_R8G8B8A8_UNORM;
+    g_offscreen.texel_size = texel_size(g_offscreen.format);
+
+    if (g_offscreen.texel_size == 0 ||
+        !ve_vulkan_is_format_supported(g_offscreen.format, VK_IMAGE_TILING_OPTIMAL,
+                                       VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_TRANSFER_SRC_BIT)) {
+        VE_LOG_ERROR("Offscreen format %d cannot be rendered and read back", g_offscreen.format);
+        return VK_ERROR_FORMAT_NOT_SUPPORTED;
+    }
+
+    for (uint32_t i = 0; i < VE_MAX_FRAMES_IN_FLIGHT; i++) {
+        ve_image_config image_config = {
+            .width = config->width,
+            .height = config->height,
+            .format = g_offscreen.format,
+            .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | config->usage,
+            .aspect = VK_IMAGE_ASPECT_COLOR_BIT,
+            .memory_usage = VE_GPU_MEMORY_USAGE_GPU_ONLY,
+            .debug_name = "offscreen_target",
+        };
+        VkResult result = ve_image_create(&image_config, &g_offscreen.targets[i]);
+        if (result != VK_SUCCESS) {
+            VE_LOG_ERROR("Failed to create %ux%u offscreen target", config->width, config->height);
+            ve_offscreen_shutdown();
+            return result;
+        }
+    }
+
+    if (config->readback) {
+        uint32_t slot_count = config->readback_slots > 0 ? config->readback_slots : VE_OFFSCREEN_READBACK_SLOTS;
+        if (slot_count > VE_OFFSCREEN_MAX_READBACK_SLOTS) {
+            slot_count = VE_OFFSCREEN_MAX_READBACK_SLOTS;
+        }
+
+        /* Dedicated, so a non-coherent slot can be invalidated whole */
+        ve_buffer_config buffer_config = {
+            .size = (VkDeviceSize)config->width * config->height * g_offscreen.texel_size,
+            .usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .memory_usage = VE_GPU_MEMORY_USAGE_GPU_TO_CPU,
+            .allocation_flags = VE_GPU_ALLOCATION_DEDICATED,
+            .debug_name = "offscreen_readback",
+        };
+        for (uint32_t i = 0; i < slot_count; i++) {
+            VkResult result = ve_buffer_create(&buffer_config, &g_offscreen.slots[i].buffer);
+            if (result == VK_SUCCESS && !ve_buffer_get_mapped(&g_offscreen.slots[i].buffer)) {
+                result = VK_ERROR_MEMORY_MAP_FAILED;
+            }
+            if (result != VK_SUCCESS) {
+                VE_LOG_ERROR("Failed to create offscreen readback buffer");
+                g_offscreen.slot_count = i + 1;
+                ve_offscreen_shutdown();
+                return result;
+            }
+        }
+        g_offscreen.slot_count = slot_count;
+
+        ve_vulkan_context* vk = ve_vulkan_get_context();
+        uint32_t memory_type = g_offscreen.slots[0].buffer.allocation.memory_type;
+        g_offscreen.coherent = (vk->device_properties.memory_properties.memoryTypes[memory_type].propertyFlags &
+                                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+    }
+
+    g_offscreen.initialized = true;
+
+    VE_LOG_INFO("Offscreen targets: %ux%u, %u readback slots", config->width, config->height,
+                g_offscreen.slot_count);
+    return VK_SUCCESS;
+}
+
+void ve_offscreen_shutdown(void) {
+    for (uint32_t i = 0; i < VE_MAX_FRAMES_IN_FLIGHT; i++) {
+        ve_image_destroy(&g_offscreen.targets[i]);
+    }
+    for (uint32_t i = 0; i < g_offscreen.slot_count; i++) {
+        ve_buffer_destroy(&g_offscreen.slots[i].buffer);
+    }
+
+    memset(&g_offscreen, 0, sizeof(g_offscreen));
+}
+
+bool ve_offscreen_is_enabled(void) {
+    return g_offscreen.initialized;
+}
+
+const ve_image* ve_offscreen_get_target(void) {
+    if (!g_offscreen.initialized) {
+        return NULL;
+    }
+    return &g_offscreen.targets[ve_sync_get_current_frame_index()];
+}
+
+VkExtent2D ve_offscreen_get_extent(void) {
+    return g_offscreen.extent;
+}
+
+VkFormat ve_offscreen_get_format(void) {
+    return g_offscreen.format;
+}
+
+bool ve_offscreen_record_readback(ve_command_buffer* cmd, VkImageLayout layout) {
+    VE_ASSERT(cmd);
+
+    if (!g_offscreen.initialized || g_offscreen.slot_count == 0) {
+        return false;
+    }
+    if (g_offscreen.count == g_offscreen.slot_count) {
+        g_offscreen.dropped++;
+        return false;
+    }
+
+    const ve_image* target = ve_offscreen_get_target();
+    readback_slot* slot = &g_offscreen.slots[g_offscreen.head];
+
+    VkImageSubresourceRange range = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    ve_command_buffer_image_barrier(cmd, target->image, layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                    VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                                    VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                    &range);
+
+    VkBufferImageCopy region = {
+        .bufferOffset = 0,
+        .imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+        .imageExtent = {g_offscreen.extent.width, g_offscreen.extent.height, 1},
+    };
+    vkCmdCopyImageToBuffer(cmd->buffer, target->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           slot->buffer.buffer, 1, &region);
+
+    /* Make the copy visible to host reads once the submission has completed */
+    VkBufferMemoryBarrier host_barrier = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = slot->buffer.buffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+    };
+    ve_command_buffer_pipeline_barrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+                                       0, NULL, 1, &host_barrier, 0, NULL);
+
+    slot->frame = ve_sync_get_frame_number();
+    slot->timeline = ve_submit_is_enabled();
+    slot->queue = cmd->type;
+    slot->value = slot->timeline ? ve_submit_get_pending_value(cmd->type) : 0;
+    slot->held = false;
+
+    g_offscreen.head = (g_offscreen.head + 1) % g_offscreen.slot_count;
+    g_offscreen.count++;
+    return true;
+}
+
+bool ve_offscreen_acquire_readback(ve_offscreen_frame* frame) {
+    VE_ASSERT(frame);
+
+    if (!g_offscreen.initialized || g_offscreen.count == 0) {
+        return false;
+    }
+
+    readback_slot* slot = &g_offscreen.slots[g_offscreen.tail];
+    if (!slot->held) {
+        if (!slot_is_complete(slot)) {
+            return false;
+        }
+
+        if (!g_offscreen.coherent) {
+            VkMappedMemoryRange range = {
+                .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+                .memory = slot->buffer.allocation.memory,
+                .offset = 0,
+                .size = VK_WHOLE_SIZE,
+            };
+            vkInvalidateMappedMemoryRanges(ve_vulkan_get_context()->device, 1, &range);
+        }
+
+        slot->held = true;
+        g_offscreen.read_back++;
+    }
+
+    frame->frame = slot->frame;
+    frame->data = ve_buffer_get_mapped(&slot->buffer);
+    frame->width = g_offscreen.extent.width;
+    frame->height = g_offscreen.extent.height;
+    frame->row_pitch = g_offscreen.extent.width * g_offscreen.texel_size;
+    frame->format = g_offscreen.format;
+    return true;
+}
+
+void ve_offscreen_release_readback(void) {
+    if (g_offscreen.count == 0 || !g_offscreen.slots[g_offscreen.tail].held) {
+        return;
+    }
+
+    g_offscreen.slots[g_offscreen.tail].held = false;
+    g_offscreen.tail = (g_offscreen.tail + 1) % g_offscreen.slot_count;
+    g_offscreen.count--;
+}
+
+void ve_offscreen_get_stats(ve_offscreen_stats* stats) {
+    if (!stats) {
+        return;
+    }
+
+    uint32_t held = g_offscreen.count > 0 && g_offscreen.slots[g_offscreen.tail].held ? 1 : 0;
+    stats->readback_slots = g_offscreen.slot_count;
+    stats->pending = g_offscreen.count - held;
+    stats->held = held;
+    stats->read_back = g_offscreen.read_back;
+    stats->dropped = g_offscreen.dropped;
+}
@@ -0,0 +1,161 @@
+/**
+ * @file offscreen.h
+ * @brief Offscreen render targets with asynchronous readback
+ *
+ * Headless runs (ve_vulkan_init_headless) render into color images owned
+ * by this module instead of swapchain images: one per frame in flight, so
+ * a frame never draws into a target an earlier frame is still using.
+ *
+ * Readback copies the frame's target into one of a ring of host-visible
+ * buffers at the end of the frame's command buffer, and nothing waits for
+ * it there. A copy is known to have finished from the submission timeline
+ * of the recording queue, or from the completed-frame counter without the
+ * batcher; ve_offscreen_acquire_readback then hands out the oldest
+ * finished copy. The ring holds more slots than there are frames in
+ * flight, so the CPU can hold a finished frame while the next ones render.
+ * When every slot is still pending or held, the frame is not copied and
+ * counts as dropped.
+ *
+ * All functions are called from the thread that records frames.
+ */
+
+#ifndef VE_OFFSCREEN_H
+#define VE_OFFSCREEN_H
+
+#include "vulkan_core.h"
+#include "command_buffer.h"
+#include "image.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Default readback slots: every frame in flight plus one held by the CPU */
+#define VE_OFFSCREEN_READBACK_SLOTS (VE_MAX_FRAMES_IN_FLIGHT + 1)
+
+/* Largest readback ring */
+#define VE_OFFSCREEN_MAX_READBACK_SLOTS 16
+
+/**
+ * @brief Offscreen target configuration
+ */
+typedef struct ve_offscreen_config {
+    uint32_t width;
+    uint32_t height;
+    VkFormat format;                /* 0 for VK_FORMAT_R8G8B8A8_UNORM */
+    VkImageUsageFlags usage;        /* Added to color attachment and transfer source */
+    bool readback;                  /* Create the readback ring */
+    uint32_t readback_slots;        /* 0 for VE_OFFSCREEN_READBACK_SLOTS */
+} ve_offscreen_config;
+
+/**
+ * @brief Frame read back to host memory
+ */
+typedef struct ve_offscreen_frame {
+    uint64_t frame;                 /* ve_sync_get_frame_number of the frame that was copied */
+    const void* data;               /* Tightly packed rows, valid until released */
+    uint32_t width;
+    uint32_t height;
+    uint32_t row_pitch;             /* Bytes per row */
+    VkFormat format;
+} ve_offscreen_frame;
+
+/**
+ * @brief Offscreen statistics
+ */
+typedef struct ve_offscreen_stats {
+    uint32_t readback_slots;
+    uint32_t pending;               /* Copies the GPU may not have finished */
+    uint32_t held;                  /* Acquired and not released */
+    uint64_t read_back;             /* Frames handed out */
+    uint64_t dropped;               /* Frames not copied because no slot was free */
+} ve_offscreen_stats;
+
+/**
+ * @brief Create the render targets and the readback ring
+ *
+ * @param config Configuration
+ * @return VK_SUCCESS on success, VK_ERROR_FORMAT_NOT_SUPPORTED for formats
+ *         that are not color attachments or not 4, 8 or 16 bytes per texel
+ */
+VkResult ve_offscreen_init(const ve_offscreen_config* config);
+
+/**
+ * @brief Destroy the render targets and the readback ring
+ *
+ * The device must be idle.
+ */
+void ve_offscreen_shutdown(void);
+
+/**
+ * @brief Check if offscreen targets exist
+ *
+ * @return true if initialized
+ */
+bool ve_offscreen_is_enabled(void);
+
+/**
+ * @brief Get the color target of the frame being recorded
+ *
+ * @return Target of the current frame slot, or NULL if not initialized
+ */
+const ve_image* ve_offscreen_get_target(void);
+
+/**
+ * @brief Get the size of the targets
+ *
+ * @return Extent, zero if not initialized
+ */
+VkExtent2D ve_offscreen_get_extent(void);
+
+/**
+ * @brief Get the format of the targets
+ *
+ * @return Format, VK_FORMAT_UNDEFINED if not initialized
+ */
+VkFormat ve_offscreen_get_format(void);
+
+/**
+ * @brief Record the copy of the current target into a free readback slot
+ *
+ * Record outside a render pass, after the last write to the target, in the
+ * command buffer submitted last in the frame. Ends with the target in
+ * VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL. The slot is tagged with the
+ * timeline value the queue's pending batch signals, so flush the batch this
+ * frame.
+ *
+ * @param cmd Graphics command buffer of the frame
+ * @param layout Layout the target is in, written as a color attachment
+ * @return false if there is no readback ring or every slot is busy (the frame is dropped)
+ */
+bool ve_offscreen_record_readback(ve_command_buffer* cmd, VkImageLayout layout);
+
+/**
+ * @brief Get the oldest readback the GPU has finished, without waiting
+ *
+ * Returns the same frame until it is released.
+ *
+ * @param frame Output frame
+ * @return false if no copy has finished
+ */
+bool ve_offscreen_acquire_readback(ve_offscreen_frame* frame);
+
+/**
+ * @brief Return the frame from ve_offscreen_acquire_readback to the ring
+ */
+void ve_offscreen_release_readback(void);
+
+/**
+ * @brief Get offscreen statistics
+ *
+ * @param stats Output statistics
+ */
+void ve_offscreen_get_stats(ve_offscreen_stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_OFFSCREEN_H */
@@ -3,6 +3,975 @@
  * @brief Vulkan graphics pipeline management implementation
  */
 
+#define VK_NO_PROTOTYPES
 #include "pipeline.h"
 
-/* TODO: Implement pipeline management */
+#include "descriptor.h"
+#include "deletion_queue.h"
+#include "sync.h"
+#include "../core/logger.h"
+#include "../core/assert.h"
+#include "../core/memory.h"
+#include "../core/timer.h"
+#include "../platform/platform.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* Cache file header, followed by the driver's cache data */
+#define VE_PIPELINE_CACHE_MAGIC 0x43504556u     /* "VEPC" */
+#define VE_PIPELINE_CACHE_VERSION 1
+
+typedef struct ve_pipeline_cache_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendor_id;
+    uint32_t device_id;
+    uint32_t driver_version;
+    uint8_t uuid[VK_UUID_SIZE];
+    uint64_t data_size;
+    uint64_t data_hash;
+} ve_pipeline_cache_header;
+
+/**
+ * @brief Copied description of a pipeline waiting for a worker
+ *
+ * Arrays referenced by the description live in the same allocation.
+ */
+typedef struct ve_pipeline_job {
+    ve_pipeline* pipeline;
+    ve_graphics_pipeline_desc graphics;
+    ve_compute_pipeline_desc compute;
+    VkSpecializationInfo specialization;
+} ve_pipeline_job;
+
+/**
+ * @brief Registered pipeline, shared by every request with the same state
+ */
+typedef struct ve_pipeline_entry {
+    uint64_t hash;
+    ve_pipeline_job* key;           /* Copied description with the resolved layout */
+    ve_pipeline* pipeline;
+    uint32_t ref_count;
+    uint64_t use_count;             /* Acquisitions over the entry's lifetime */
+    uint64_t last_used_frame;       /* Frame of the last acquire or release */
+} ve_pipeline_entry;
+
+/* Global pipeline state */
+static struct {
+    bool initialized;
+    VkPipelineCache cache;
+    ve_thread_pool* pool;
+    ve_mutex* mutex;        /* Guards the statistics */
+    ve_mutex* registry_mutex;
+    char cache_path[256];
+    uint64_t saved_hash;    /* Hash and size of the data last loaded or saved */
+    size_t saved_size;
+    ve_atomic_int32 pending;
+    ve_job_counter counter;     /* Tracks pool jobs; handles are freed by users and cannot own it */
+    ve_pipeline_stats stats;
+    ve_pipeline_entry* entries;
+    uint32_t entry_count;
+    uint32_t entry_capacity;
+    uint32_t* table;        /* Open addressing, entry index + 1, 0 is empty */
+    uint32_t table_capacity;
+    uint64_t registry_hits;
+    uint32_t evicted;
+} g_pipeline = {0};
+
+#define VE_HASH_SEED 0xcbf29ce484222325ull
+
+/* FNV-1a */
+static uint64_t hash_append(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static uint64_t hash_bytes(const void* data, size_t size) {
+    return hash_append(VE_HASH_SEED, data, size);
+}
+
+static void fill_cache_header(ve_pipeline_cache_header* header) {
+    const VkPhysicalDeviceProperties* properties = &ve_vulkan_get_context()->device_properties.properties;
+
+    memset(header, 0, sizeof(ve_pipeline_cache_header));
+    header->magic = VE_PIPELINE_CACHE_MAGIC;
+    header->version = VE_PIPELINE_CACHE_VERSION;
+    header->vendor_id = properties->vendorID;
+    header->device_id = properties->deviceID;
+    header->driver_version = properties->driverVersion;
+    memcpy(header->uuid, properties->pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+/* Read the cache file, returning NULL if it is missing or was written for another device or driver */
+static void* load_cache_file(const char* path, size_t* size) {
+    *size = 0;
+
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        VE_LOG_INFO("No pipeline cache at %s, starting cold", path);
+        return NULL;
+    }
+
+    ve_pipeline_cache_header expected;
+    fill_cache_header(&expected);
+
+    ve_pipeline_cache_header header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        header.magic != expected.magic || header.version != expected.version ||
+        header.vendor_id != expected.vendor_id || header.device_id != expected.device_id ||
+        header.driver_version != expected.driver_version ||
+        memcmp(header.uuid, expected.uuid, VK_UUID_SIZE) != 0 || header.data_size == 0) {
+        VE_LOG_INFO("Pipeline cache %s does not match this device or driver, discarding it", path);
+        fclose(file);
+        return NULL;
+    }
+
+    void* data = VE_ALLOCATE_TAG((size_t)header.data_size, VE_MEMORY_TAG_RENDERER);
+    if (!data) {
+        fclose(file);
+        return NULL;
+    }
+
+    size_t read = fread(data, 1, (size_t)header.data_size, file);
+    fclose(file);
+
+    if (read != header.data_size || hash_bytes(data, read) != header.data_hash) {
+        VE_LOG_WARN("Pipeline cache %s is corrupt, discarding it", path);
+        VE_FREE(data);
+        return NULL;
+    }
+
+    *size = read;
+    return data;
+}
+
+VkResult ve_pipeline_init(const char* cache_path, ve_thread_pool* pool) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VE_ASSERT(vk && vk->device);
+
+    memset(&g_pipeline, 0, sizeof(g_pipeline));
+    g_pipeline.pool = pool;
+    ve_job_counter_init(&g_pipeline.counter);
+    snprintf(g_pipeline.cache_path, sizeof(g_pipeline.cache_path), "%s",
+             cache_path ? cache_path : VE_PIPELINE_CACHE_PATH);
+
+    g_pipeline.mutex = ve_mutex_create();
+    g_pipeline.registry_mutex = ve_mutex_create();
+    if (!g_pipeline.mutex || !g_pipeline.registry_mutex) {
+        VE_LOG_ERROR("Failed to create pipeline mutex");
+        if (g_pipeline.mutex) {
+            ve_mutex_destroy(g_pipeline.mutex);
+        }
+        if (g_pipeline.registry_mutex) {
+            ve_mutex_destroy(g_pipeline.registry_mutex);
+        }
+        memset(&g_pipeline, 0, sizeof(g_pipeline));
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    size_t data_size = 0;
+    void* data = load_cache_file(g_pipeline.cache_path, &data_size);
+
+    VkPipelineCacheCreateInfo cache_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = data_size,
+        .pInitialData = data,
+    };
+
+    VkResult result = vkCreatePipelineCache(vk->device, &cache_info, NULL, &g_pipeline.cache);
+    if (result != VK_SUCCESS && data) {
+        /* The driver rejected the data despite the header check, start empty */
+        VE_LOG_WARN("Pipeline cache data rejected: %d", result);
+        cache_info.initialDataSize = 0;
+        cache_info.pInitialData = NULL;
+        data_size = 0;
+        result = vkCreatePipelineCache(vk->device, &cache_info, NULL, &g_pipeline.cache);
+    }
+
+    if (data_size > 0) {
+        g_pipeline.saved_hash = hash_bytes(data, data_size);
+        g_pipeline.saved_size = data_size;
+        g_pipeline.stats.cache_loaded_size = data_size;
+        VE_LOG_INFO("Loaded pipeline cache: %zu bytes", data_size);
+    }
+    VE_FREE(data);
+
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to create pipeline cache: %d", result);
+        ve_mutex_destroy(g_pipeline.mutex);
+        ve_mutex_destroy(g_pipeline.registry_mutex);
+        memset(&g_pipeline, 0, sizeof(g_pipeline));
+        return result;
+    }
+
+    g_pipeline.initialized = true;
+    return VK_SUCCESS;
+}
+
+void ve_pipeline_shutdown(void) {
+    if (!g_pipeline.initialized) {
+        return;
+    }
+
+    ve_pipeline_wait_all();
+    ve_pipeline_save_cache();
+
+    for (uint32_t i = 0; i < g_pipeline.entry_count; i++) {
+        ve_pipeline_destroy(g_pipeline.entries[i].pipeline);
+        VE_FREE(g_pipeline.entries[i].key);
+    }
+    VE_FREE(g_pipeline.entries);
+    VE_FREE(g_pipeline.table);
+
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    vkDestroyPipelineCache(vk->device, g_pipeline.cache, NULL);
+    ve_mutex_destroy(g_pipeline.mutex);
+    ve_mutex_destroy(g_pipeline.registry_mutex);
+
+    memset(&g_pipeline, 0, sizeof(g_pipeline));
+}
+
+bool ve_pipeline_save_cache(void) {
+    if (!g_pipeline.initialized) {
+        return false;
+    }
+
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+
+    size_t size = 0;
+    VkResult result = vkGetPipelineCacheData(vk->device, g_pipeline.cache, &size, NULL);
+    if (result != VK_SUCCESS || size == 0) {
+        return result == VK_SUCCESS;
+    }
+
+    void* data = VE_ALLOCATE_TAG(size, VE_MEMORY_TAG_RENDERER);
+    if (!data) {
+        return false;
+    }
+
+    result = vkGetPipelineCacheData(vk->device, g_pipeline.cache, &size, data);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to read pipeline cache data: %d", result);
+        VE_FREE(data);
+        return false;
+    }
+
+    uint64_t hash = hash_bytes(data, size);
+    if (hash == g_pipeline.saved_hash && size == g_pipeline.saved_size) {
+        VE_FREE(data);
+        return true;
+    }
+
+    ve_pipeline_cache_header header;
+    fill_cache_header(&header);
+    header.data_size = size;
+    header.data_hash = hash;
+
+    /* Write next to the cache and rename, so a crash never leaves a torn file */
+    char temp_path[sizeof(g_pipeline.cache_path) + 4];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", g_pipeline.cache_path);
+
+    FILE* file = fopen(temp_path, "wb");
+    bool written = file &&
+                   fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(data, 1, size, file) == size;
+    if (file) {
+        written = (fclose(file) == 0) && written;
+    }
+    VE_FREE(data);
+
+    if (written && !ve_movefile(temp_path, g_pipeline.cache_path)) {
+        ve_deletefile(g_pipeline.cache_path);
+        written = ve_movefile(temp_path, g_pipeline.cache_path);
+    }
+
+    if (!written) {
+        VE_LOG_WARN("Failed to write pipeline cache %s", g_pipeline.cache_path);
+        ve_deletefile(temp_path);
+        return false;
+    }
+
+    g_pipeline.saved_hash = hash;
+    g_pipeline.saved_size = size;
+    g_pipeline.stats.cache_saved_size = size;
+    VE_LOG_INFO("Saved pipeline cache: %zu bytes", size);
+    return true;
+}
+
+VkPipelineCache ve_pipeline_get_cache(void) {
+    return g_pipeline.cache;
+}
+
+static VkPipelineLayout resolve_layout(VkPipelineLayout layout) {
+    if (layout == VK_NULL_HANDLE && ve_bindless_is_enabled()) {
+        return ve_bindless_get_pipeline_layout();
+    }
+    return layout;
+}
+
+static VkResult build_graphics(const ve_graphics_pipeline_desc* desc, VkPipelineLayout layout, VkPipeline* pipeline) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+
+    /* Task, mesh or vertex, then fragment */
+    const struct {
+        VkShaderStageFlagBits stage;
+        VkShaderModule module;
+    } modules[] = {
+        {VK_SHADER_STAGE_TASK_BIT_EXT, desc->mesh_shader != VK_NULL_HANDLE ? desc->task_shader : VK_NULL_HANDLE},
+        {VK_SHADER_STAGE_MESH_BIT_EXT, desc->mesh_shader},
+        {VK_SHADER_STAGE_VERTEX_BIT, desc->mesh_shader == VK_NULL_HANDLE ? desc->vertex_shader : VK_NULL_HANDLE},
+        {VK_SHADER_STAGE_FRAGMENT_BIT, desc->fragment_shader},
+    };
+
+    VkPipelineShaderStageCreateInfo stages[4];
+    uint32_t stage_count = 0;
+    for (uint32_t i = 0; i < sizeof(modules) / sizeof(modules[0]); i++) {
+        if (modules[i].module == VK_NULL_HANDLE) {
+            continue;
+        }
+        stages[stage_count++] = (VkPipelineShaderStageCreateInfo){
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = modules[i].stage,
+            .module = modules[i].module,
+            .pName = "main",
+            .pSpecializationInfo = desc->specialization,
+        };
+    }
+    bool mesh = desc->mesh_shader != VK_NULL_HANDLE;
+
+    VkPipelineVertexInputStateCreateInfo vertex_input = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+        .vertexBindingDescriptionCount = desc->vertex_binding_count,
+        .pVertexBindingDescriptions = desc->vertex_bindings,
+        .vertexAttributeDescriptionCount = desc->vertex_attribute_count,
+        .pVertexAttributeDescriptions = desc->vertex_attributes,
+    };
+
+    VkPipelineInputAssemblyStateCreateInfo input_assembly = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+        .topology = desc->topology,
+    };
+
+    VkPipelineViewportStateCreateInfo viewport = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        .viewportCount = 1,
+        .scissorCount = 1,
+    };
+
+    VkPipelineRasterizationStateCreateInfo rasterization = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+        .polygonMode = desc->polygon_mode,
+        .cullMode = desc->cull_mode,
+        .frontFace = desc->front_face,
+        .lineWidth = 1.0f,
+    };
+
+    VkPipelineMultisampleStateCreateInfo multisample = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+        .rasterizationSamples = desc->samples ? desc->samples : VK_SAMPLE_COUNT_1_BIT,
+    };
+
+    VkPipelineDepthStencilStateCreateInfo depth_stencil = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+        .depthTestEnable = desc->depth_test ? VK_TRUE : VK_FALSE,
+        .depthWriteEnable = desc->depth_write ? VK_TRUE : VK_FALSE,
+        .depthCompareOp = desc->depth_compare ? desc->depth_compare : VK_COMPARE_OP_LESS_OR_EQUAL,
+    };
+
+    VkPipelineColorBlendAttachmentState opaque[VE_PIPELINE_MAX_COLOR_ATTACHMENTS];
+    for (uint32_t i = 0; i < VE_PIPELINE_MAX_COLOR_ATTACHMENTS; i++) {
+        opaque[i] = (VkPipelineColorBlendAttachmentState){
+            .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                              VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+        };
+    }
+
+    VkPipelineColorBlendStateCreateInfo color_blend = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+        .attachmentCount = desc->color_attachment_count,
+        .pAttachments = desc->blend_attachments ? desc->blend_attachments : opaque,
+    };
+
+    VkDynamicState dynamic_states[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    VkPipelineDynamicStateCreateInfo dynamic = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .dynamicStateCount = 2,
+        .pDynamicStates = dynamic_states,
+    };
+
+    VkGraphicsPipelineCreateInfo pipeline_info = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .stageCount = stage_count,
+        .pStages = stages,
+        .pVertexInputState = mesh ? NULL : &vertex_input,       /* Mesh shaders fetch their own vertices */
+        .pInputAssemblyState = mesh ? NULL : &input_assembly,
+        .pViewportState = &viewport,
+        .pRasterizationState = &rasterization,
+        .pMultisampleState = &multisample,
+        .pDepthStencilState = &depth_stencil,
+        .pColorBlendState = &color_blend,
+        .pDynamicState = &dynamic,
+        .layout = layout,
+        .renderPass = desc->render_pass,
+        .subpass = desc->subpass,
+    };
+
+    return vkCreateGraphicsPipelines(vk->device, g_pipeline.cache, 1, &pipeline_info, NULL, pipeline);
+}
+
+static VkResult build_compute(const ve_compute_pipeline_desc* desc, VkPipelineLayout layout, VkPipeline* pipeline) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+
+    VkComputePipelineCreateInfo pipeline_info = {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = desc->shader,
+            .pName = "main",
+            .pSpecializationInfo = desc->specialization,
+        },
+        .layout = layout,
+    };
+
+    return vkCreateComputePipelines(vk->device, g_pipeline.cache, 1, &pipeline_info, NULL, pipeline);
+}
+
+/* Task: create the pipeline of a job and publish the result */
+static void compile_job(void* user_data) {
+    ve_pipeline_job* job = (ve_pipeline_job*)user_data;
+    ve_pipeline* pipeline = job->pipeline;
+    const char* debug_name = NULL;
+
+    ve_timer timer = ve_timer_start();
+    VkResult result = VK_ERROR_INITIALIZATION_FAILED;
+    if (pipeline->layout == VK_NULL_HANDLE) {
+        VE_LOG_ERROR("Pipeline has no layout and bindless is not available");
+    } else if (pipeline->bind_point == VK_PIPELINE_BIND_POINT_COMPUTE) {
+        result = build_compute(&job->compute, pipeline->layout, &pipeline->pipeline);
+        debug_name = job->compute.debug_name;
+    } else {
+        result = build_graphics(&job->graphics, pipeline->layout, &pipeline->pipeline);
+        debug_name = job->graphics.debug_name;
+    }
+    pipeline->compile_time = ve_timer_stop(&timer);
+    pipeline->result = result;
+
+    if (result == VK_SUCCESS) {
+        if (debug_name) {
+            VE_VK_SET_OBJECT_NAME(pipeline->pipeline, VK_OBJECT_TYPE_PIPELINE, debug_name);
+        }
+    } else {
+        VE_LOG_ERROR("Failed to create pipeline %s: %d", debug_name ? debug_name : "", result);
+        pipeline->pipeline = VK_NULL_HANDLE;
+    }
+
+    ve_mutex_lock(g_pipeline.mutex);
+    if (result == VK_SUCCESS) {
+        g_pipeline.stats.created++;
+    } else {
+        g_pipeline.stats.failed++;
+    }
+    g_pipeline.stats.compile_time += pipeline->compile_time;
+    ve_mutex_unlock(g_pipeline.mutex);
+
+    VE_FREE(job);
+
+    /* Published last: once ready, the handle may be used and destroyed by other threads */
+    ve_atomic_store32(&pipeline->state, result == VK_SUCCESS ? VE_PIPELINE_READY : VE_PIPELINE_FAILED);
+    ve_atomic_decrement32(&g_pipeline.pending);
+}
+
+/* Bump allocation inside a job, 8-byte aligned */
+static void* job_copy(uint8_t** cursor, const void* data, size_t size) {
+    if (!data || size == 0) {
+        return NULL;
+    }
+    void* copy = *cursor;
+    memcpy(copy, data, size);
+    *cursor += (size + 7) & ~(size_t)7;
+    return copy;
+}
+
+static size_t job_size(size_t size) {
+    return (size + 7) & ~(size_t)7;
+}
+
+static size_t specialization_size(const VkSpecializationInfo* info) {
+    return info ? job_size(info->mapEntryCount * sizeof(VkSpecializationMapEntry)) + job_size(info->dataSize) : 0;
+}
+
+static const VkSpecializationInfo* copy_specialization(ve_pipeline_job* job, uint8_t** cursor,
+                                                       const VkSpecializationInfo* info) {
+    if (!info) {
+        return NULL;
+    }
+    job->specialization = *info;
+    job->specialization.pMapEntries = (const VkSpecializationMapEntry*)job_copy(
+        cursor, info->pMapEntries, info->mapEntryCount * sizeof(VkSpecializationMapEntry));
+    job->specialization.pData = job_copy(cursor, info->pData, info->dataSize);
+    return &job->specialization;
+}
+
+static ve_pipeline* pipeline_new(VkPipelineBindPoint bind_point, VkPipelineLayout layout) {
+    ve_pipeline* pipeline = (ve_pipeline*)ve_allocate_cleared(sizeof(ve_pipeline), VE_MEMORY_TAG_RENDERER);
+    if (!pipeline) {
+        return NULL;
+    }
+    pipeline->bind_point = bind_point;
+    pipeline->layout = resolve_layout(layout);
+    pipeline->result = VK_NOT_READY;
+    ve_atomic_store32(&pipeline->state, VE_PIPELINE_PENDING);
+    return pipeline;
+}
+
+static void dispatch_job(ve_pipeline_job* job) {
+    ve_atomic_increment32(&g_pipeline.pending);
+
+    if (!g_pipeline.pool ||
+        !ve_thread_pool_submit_job(g_pipeline.pool, compile_job, job, NULL, &g_pipeline.counter)) {
+        compile_job(job);
+    }
+}
+
+/* Deep copy of a graphics description, also used as a registry key */
+static ve_pipeline_job* copy_graphics_desc(const ve_graphics_pipeline_desc* desc) {
+    size_t name_size = desc->debug_name ? strlen(desc->debug_name) + 1 : 0;
+    size_t size = job_size(sizeof(ve_pipeline_job)) +
+                  job_size(desc->vertex_binding_count * sizeof(VkVertexInputBindingDescription)) +
+                  job_size(desc->vertex_attribute_count * sizeof(VkVertexInputAttributeDescription)) +
+                  (desc->blend_attachments ?
+                       job_size(desc->color_attachment_count * sizeof(VkPipelineColorBlendAttachmentState)) : 0) +
+                  specialization_size(desc->specialization) +
+                  job_size(name_size);
+
+    ve_pipeline_job* job = (ve_pipeline_job*)ve_allocate_cleared(size, VE_MEMORY_TAG_RENDERER);
+    if (!job) {
+        return NULL;
+    }
+
+    uint8_t* cursor = (uint8_t*)job + job_size(sizeof(ve_pipeline_job));
+    job->graphics = *desc;
+    job->graphics.vertex_bindings = (const VkVertexInputBindingDescription*)job_copy(
+        &cursor, desc->vertex_bindings, desc->vertex_binding_count * sizeof(VkVertexInputBindingDescription));
+    job->graphics.vertex_attributes = (const VkVertexInputAttributeDescription*)job_copy(
+        &cursor, desc->vertex_attributes, desc->vertex_attribute_count * sizeof(VkVertexInputAttributeDescription));
+    job->graphics.blend_attachments = (const VkPipelineColorBlendAttachmentState*)job_copy(
+        &cursor, desc->blend_attachments, desc->color_attachment_count * sizeof(VkPipelineColorBlendAttachmentState));
+    job->graphics.specialization = copy_specialization(job, &cursor, desc->specialization);
+    job->graphics.debug_name = (const char*)job_copy(&cursor, desc->debug_name, name_size);
+    return job;
+}
+
+static ve_pipeline_job* copy_compute_desc(const ve_compute_pipeline_desc* desc) {
+    size_t name_size = desc->debug_name ? strlen(desc->debug_name) + 1 : 0;
+    size_t size = job_size(sizeof(ve_pipeline_job)) + specialization_size(desc->specialization) + job_size(name_size);
+
+    ve_pipeline_job* job = (ve_pipeline_job*)ve_allocate_cleared(size, VE_MEMORY_TAG_RENDERER);
+    if (!job) {
+        return NULL;
+    }
+
+    uint8_t* cursor = (uint8_t*)job + job_size(sizeof(ve_pipeline_job));
+    job->compute = *desc;
+    job->compute.specialization = copy_specialization(job, &cursor, desc->specialization);
+    job->compute.debug_name = (const char*)job_copy(&cursor, desc->debug_name, name_size);
+    return job;
+}
+
+ve_pipeline* ve_pipeline_create_graphics(const ve_graphics_pipeline_desc* desc) {
+    VE_ASSERT(g_pipeline.initialized && desc &&
+              (desc->vertex_shader != VK_NULL_HANDLE || desc->mesh_shader != VK_NULL_HANDLE));
+    VE_ASSERT(desc->color_attachment_count <= VE_PIPELINE_MAX_COLOR_ATTACHMENTS);
+
+    ve_pipeline_job* job = copy_graphics_desc(desc);
+    ve_pipeline* pipeline = pipeline_new(VK_PIPELINE_BIND_POINT_GRAPHICS, desc->layout);
+    if (!job || !pipeline) {
+        VE_FREE(job);
+        VE_FREE(pipeline);
+        return NULL;
+    }
+
+    job->pipeline = pipeline;
+    dispatch_job(job);
+    return pipeline;
+}
+
+ve_pipeline* ve_pipeline_create_compute(const ve_compute_pipeline_desc* desc) {
+    VE_ASSERT(g_pipeline.initialized && desc && desc->shader != VK_NULL_HANDLE);
+
+    ve_pipeline_job* job = copy_compute_desc(desc);
+    ve_pipeline* pipeline = pipeline_new(VK_PIPELINE_BIND_POINT_COMPUTE, desc->layout);
+    if (!job || !pipeline) {
+        VE_FREE(job);
+        VE_FREE(pipeline);
+        return NULL;
+    }
+
+    job->pipeline = pipeline;
+    dispatch_job(job);
+    return pipeline;
+}
+
+bool ve_pipeline_is_ready(const ve_pipeline* pipeline) {
+    return pipeline && ve_atomic_load32(&pipeline->state) == VE_PIPELINE_READY;
+}
+
+VkResult ve_pipeline_wait(ve_pipeline* pipeline) {
+    VE_ASSERT(pipeline);
+
+    while (ve_atomic_load32(&pipeline->state) == VE_PIPELINE_PENDING) {
+        ve_thread_yield();
+    }
+    return pipeline->result;
+}
+
+void ve_pipeline_wait_all(void) {
+    if (g_pipeline.pool) {
+        ve_thread_pool_wait_counter(g_pipeline.pool, &g_pipeline.counter);
+    }
+    /* Tasks publish their result just before they return */
+    while (ve_atomic_load32(&g_pipeline.pending) > 0) {
+        ve_thread_yield();
+    }
+}
+
+void ve_pipeline_destroy(ve_pipeline* pipeline) {
+    if (!pipeline) {
+        return;
+    }
+
+    ve_pipeline_wait(pipeline);
+    if (pipeline->pipeline != VK_NULL_HANDLE) {
+        ve_deletion_queue_push_pipeline(pipeline->pipeline);
+    }
+    VE_FREE(pipeline);
+}
+
+void ve_pipeline_get_stats(ve_pipeline_stats* stats) {
+    VE_ASSERT(stats);
+
+    memset(stats, 0, sizeof(ve_pipeline_stats));
+    if (!g_pipeline.initialized) {
+        return;
+    }
+
+    ve_mutex_lock(g_pipeline.mutex);
+    *stats = g_pipeline.stats;
+    ve_mutex_unlock(g_pipeline.mutex);
+    stats->pending = (uint32_t)ve_atomic_load32(&g_pipeline.pending);
+
+    ve_mutex_lock(g_pipeline.registry_mutex);
+    stats->registered = g_pipeline.entry_count;
+    stats->registry_hits = g_pipeline.registry_hits;
+    stats->evicted = g_pipeline.evicted;
+    ve_mutex_unlock(g_pipeline.registry_mutex);
+}
+
+/* Registry */
+
+static uint64_t hash_u64(uint64_t hash, uint64_t value) {
+    return hash_append(hash, &value, sizeof(value));
+}
+
+static uint64_t hash_specialization(uint64_t hash, const VkSpecializationInfo* info) {
+    if (!info) {
+        return hash_u64(hash, 0);
+    }
+    hash = hash_u64(hash, info->mapEntryCount);
+    for (uint32_t i = 0; i < info->mapEntryCount; i++) {
+        hash = hash_u64(hash, info->pMapEntries[i].constantID);
+        hash = hash_u64(hash, info->pMapEntries[i].offset);
+        hash = hash_u64(hash, info->pMapEntries[i].size);
+    }
+    return hash_append(hash_u64(hash, info->dataSize), info->pData, info->dataSize);
+}
+
+/* Everything that affects the created pipeline; debug names do not */
+static uint64_t hash_graphics(const ve_graphics_pipeline_desc* desc, VkPipelineLayout layout) {
+    uint64_t hash = hash_u64(VE_HASH_SEED, VK_PIPELINE_BIND_POINT_GRAPHICS);
+    hash = hash_u64(hash, (uint64_t)desc->vertex_shader);
+    hash = hash_u64(hash, (uint64_t)desc->fragment_shader);
+    hash = hash_u64(hash, (uint64_t)desc->task_shader);
+    hash = hash_u64(hash, (uint64_t)desc->mesh_shader);
+    hash = hash_specialization(hash, desc->specialization);
+    hash = hash_u64(hash, desc->vertex_binding_count);
+    hash = hash_append(hash, desc->vertex_bindings,
+                       desc->vertex_binding_count * sizeof(VkVertexInputBindingDescription));
+    hash = hash_u64(hash, desc->vertex_attribute_count);
+    hash = hash_append(hash, desc->vertex_attributes,
+                       desc->vertex_attribute_count * sizeof(VkVertexInputAttributeDescription));
+    hash = hash_u64(hash, desc->topology);
+    hash = hash_u64(hash, desc->polygon_mode);
+    hash = hash_u64(hash, desc->cull_mode);
+    hash = hash_u64(hash, desc->front_face);
+    hash = hash_u64(hash, desc->samples);
+    hash = hash_u64(hash, ((uint64_t)desc->depth_test << 1) | (uint64_t)desc->depth_write);
+    hash = hash_u64(hash, desc->depth_compare);
+    hash = hash_u64(hash, desc->color_attachment_count);
+    hash = hash_u64(hash, desc->blend_attachments != NULL);
+    if (desc->blend_attachments) {
+        hash = hash_append(hash, desc->blend_attachments,
+                           desc->color_attachment_count * sizeof(VkPipelineColorBlendAttachmentState));
+    }
+    hash = hash_u64(hash, (uint64_t)layout);
+    hash = hash_u64(hash, (uint64_t)desc->render_pass);
+    return hash_u64(hash, desc->subpass);
+}
+
+static uint64_t hash_compute(const ve_compute_pipeline_desc* desc, VkPipelineLayout layout) {
+    uint64_t hash = hash_u64(VE_HASH_SEED, VK_PIPELINE_BIND_POINT_COMPUTE);
+    hash = hash_u64(hash, (uint64_t)desc->shader);
+    hash = hash_specialization(hash, desc->specialization);
+    return hash_u64(hash, (uint64_t)layout);
+}
+
+static bool bytes_equal(const void* a, const void* b, size_t size) {
+    return size == 0 || (a && b && memcmp(a, b, size) == 0);
+}
+
+static bool specialization_equal(const VkSpecializationInfo* a, const VkSpecializationInfo* b) {
+    if (!a || !b) {
+        return a == b;
+    }
+    if (a->mapEntryCount != b->mapEntryCount || a->dataSize != b->dataSize) {
+        return false;
+    }
+    for (uint32_t i = 0; i < a->mapEntryCount; i++) {
+        if (a->pMapEntries[i].constantID != b->pMapEntries[i].constantID ||
+            a->pMapEntries[i].offset != b->pMapEntries[i].offset ||
+            a->pMapEntries[i].size != b->pMapEntries[i].size) {
+            return false;
+        }
+    }
+    return bytes_equal(a->pData, b->pData, a->dataSize);
+}
+
+static bool graphics_equal(const ve_graphics_pipeline_desc* a, const ve_graphics_pipeline_desc* b,
+                           VkPipelineLayout b_layout) {
+    return a->vertex_shader == b->vertex_shader &&
+           a->fragment_shader == b->fragment_shader &&
+           a->task_shader == b->task_shader &&
+           a->mesh_shader == b->mesh_shader &&
+           specialization_equal(a->specialization, b->specialization) &&
+           a->vertex_binding_count == b->vertex_binding_count &&
+           bytes_equal(a->vertex_bindings, b->vertex_bindings,
+                       a->vertex_binding_count * sizeof(VkVertexInputBindingDescription)) &&
+           a->vertex_attribute_count == b->vertex_attribute_count &&
+           bytes_equal(a->vertex_attributes, b->vertex_attributes,
+                       a->vertex_attribute_count * sizeof(VkVertexInputAttributeDescription)) &&
+           a->topology == b->topology &&
+           a->polygon_mode == b->polygon_mode &&
+           a->cull_mode == b->cull_mode &&
+           a->front_face == b->front_face &&
+           a->samples == b->samples &&
+           a->depth_test == b->depth_test &&
+           a->depth_write == b->depth_write &&
+           a->depth_compare == b->depth_compare &&
+           a->color_attachment_count == b->color_attachment_count &&
+           (a->blend_attachments == NULL) == (b->blend_attachments == NULL) &&
+           (!a->blend_attachments ||
+            bytes_equal(a->blend_attachments, b->blend_attachments,
+                        a->color_attachment_count * sizeof(VkPipelineColorBlendAttachmentState))) &&
+           a->layout == b_layout &&
+           a->render_pass == b->render_pass &&
+           a->subpass == b->subpass;
+}
+
+static bool compute_equal(const ve_compute_pipeline_desc* a, const ve_compute_pipeline_desc* b,
+                          VkPipelineLayout b_layout) {
+    return a->shader == b->shader &&
+           specialization_equal(a->specialization, b->specialization) &&
+           a->layout == b_layout;
+}
+
+/* Rebuild the lookup table from the entry array, called with the mutex held */
+static bool rebuild_registry_table(uint32_t capacity) {
+    uint32_t* table = (uint32_t*)ve_allocate_cleared(capacity * sizeof(uint32_t), VE_MEMORY_TAG_RENDERER);
+    if (!table) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < g_pipeline.entry_count; i++) {
+        uint32_t slot = (uint32_t)g_pipeline.entries[i].hash & (capacity - 1);
+        while (table[slot] != 0) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        table[slot] = i + 1;
+    }
+
+    VE_FREE(g_pipeline.table);
+    g_pipeline.table = table;
+    g_pipeline.table_capacity = capacity;
+    return true;
+}
+
+/* Find the entry of a description, or of a handle when desc is NULL; called with the mutex held */
+static ve_pipeline_entry* find_entry(uint64_t hash, VkPipelineBindPoint bind_point, const void* desc,
+                                     VkPipelineLayout layout, const ve_pipeline* pipeline) {
+    if (g_pipeline.table_capacity == 0) {
+        return NULL;
+    }
+
+    uint32_t slot = (uint32_t)hash & (g_pipeline.table_capacity - 1);
+    while (g_pipeline.table[slot] != 0) {
+        ve_pipeline_entry* entry = &g_pipeline.entries[g_pipeline.table[slot] - 1];
+        if (entry->hash == hash) {
+            if (pipeline) {
+                if (entry->pipeline == pipeline) {
+                    return entry;
+                }
+            } else if (entry->pipeline->bind_point == bind_point &&
+                       (bind_point == VK_PIPELINE_BIND_POINT_COMPUTE ?
+                            compute_equal(&entry->key->compute, (const ve_compute_pipeline_desc*)desc, layout) :
+                            graphics_equal(&entry->key->graphics, (const ve_graphics_pipeline_desc*)desc, layout))) {
+                return entry;
+            }
+        }
+        slot = (slot + 1) & (g_pipeline.table_capacity - 1);
+    }
+    return NULL;
+}
+
+/* Register a new pipeline under its key, called with the mutex held */
+static ve_pipeline_entry* insert_entry(uint64_t hash, ve_pipeline_job* key, ve_pipeline* pipeline) {
+    if ((g_pipeline.entry_count + 1) * 4 > g_pipeline.table_capacity * 3 &&
+        !rebuild_registry_table(g_pipeline.table_capacity ? g_pipeline.table_capacity * 2 : 64)) {
+        return NULL;
+    }
+
+    if (g_pipeline.entry_count == g_pipeline.entry_capacity) {
+        uint32_t capacity = g_pipeline.entry_capacity ? g_pipeline.entry_capacity * 2 : 32;
+        ve_pipeline_entry* entries = (ve_pipeline_entry*)ve_reallocate(
+            g_pipeline.entries, capacity * sizeof(ve_pipeline_entry), VE_MEMORY_TAG_RENDERER);
+        if (!entries) {
+            return NULL;
+        }
+        g_pipeline.entries = entries;
+        g_pipeline.entry_capacity = capacity;
+    }
+
+    ve_pipeline_entry* entry = &g_pipeline.entries[g_pipeline.entry_count];
+    memset(entry, 0, sizeof(ve_pipeline_entry));
+    entry->hash = hash;
+    entry->key = key;
+    entry->pipeline = pipeline;
+    pipeline->hash = hash;
+
+    uint32_t slot = (uint32_t)hash & (g_pipeline.table_capacity - 1);
+    while (g_pipeline.table[slot] != 0) {
+        slot = (slot + 1) & (g_pipeline.table_capacity - 1);
+    }
+    g_pipeline.table[slot] = ++g_pipeline.entry_count;
+    return entry;
+}
+
+static ve_pipeline* acquire(uint64_t hash, VkPipelineBindPoint bind_point, const void* desc, VkPipelineLayout layout) {
+    ve_mutex_lock(g_pipeline.registry_mutex);
+
+    ve_pipeline_entry* entry = find_entry(hash, bind_point, desc, layout, NULL);
+    if (entry) {
+        g_pipeline.registry_hits++;
+    } else {
+        ve_pipeline_job* key = bind_point == VK_PIPELINE_BIND_POINT_COMPUTE ?
+            copy_compute_desc((const ve_compute_pipeline_desc*)desc) :
+            copy_graphics_desc((const ve_graphics_pipeline_desc*)desc);
+        ve_pipeline* pipeline = bind_point == VK_PIPELINE_BIND_POINT_COMPUTE ?
+            ve_pipeline_create_compute((const ve_compute_pipeline_desc*)desc) :
+            ve_pipeline_create_graphics((const ve_graphics_pipeline_desc*)desc);
+
+        if (key && pipeline) {
+            if (bind_point == VK_PIPELINE_BIND_POINT_COMPUTE) {
+                key->compute.layout = layout;
+            } else {
+                key->graphics.layout = layout;
+            }
+            entry = insert_entry(hash, key, pipeline);
+        }
+        if (!entry) {
+            VE_FREE(key);
+            ve_pipeline_destroy(pipeline);
+            ve_mutex_unlock(g_pipeline.registry_mutex);
+            return NULL;
+        }
+    }
+
+    entry->ref_count++;
+    entry->use_count++;
+    entry->last_used_frame = ve_sync_get_frame_number();
+    ve_pipeline* pipeline = entry->pipeline;
+
+    ve_mutex_unlock(g_pipeline.registry_mutex);
+    return pipeline;
+}
+
+ve_pipeline* ve_pipeline_acquire_graphics(const ve_graphics_pipeline_desc* desc) {
+    VE_ASSERT(g_pipeline.initialized && desc);
+
+    VkPipelineLayout layout = resolve_layout(desc->layout);
+    return acquire(hash_graphics(desc, layout), VK_PIPELINE_BIND_POINT_GRAPHICS, desc, layout);
+}
+
+ve_pipeline* ve_pipeline_acquire_compute(const ve_compute_pipeline_desc* desc) {
+    VE_ASSERT(g_pipeline.initialized && desc);
+
+    VkPipelineLayout layout = resolve_layout(desc->layout);
+    return acquire(hash_compute(desc, layout), VK_PIPELINE_BIND_POINT_COMPUTE, desc, layout);
+}
+
+void ve_pipeline_release(ve_pipeline* pipeline) {
+    if (!pipeline || !g_pipeline.initialized) {
+        return;
+    }
+
+    ve_mutex_lock(g_pipeline.registry_mutex);
+    ve_pipeline_entry* entry = find_entry(pipeline->hash, pipeline->bind_point, NULL, VK_NULL_HANDLE, pipeline);
+    VE_ASSERT_MSG(entry && entry->ref_count > 0, "Pipeline was not acquired from the registry");
+    if (entry && entry->ref_count > 0) {
+        entry->ref_count--;
+        entry->last_used_frame = ve_sync_get_frame_number();
+    }
+    ve_mutex_unlock(g_pipeline.registry_mutex);
+}
+
+uint32_t ve_pipeline_evict_unused(uint64_t min_idle_frames) {
+    if (!g_pipeline.initialized) {
+        return 0;
+    }
+
+    uint64_t frame = ve_sync_get_frame_number();
+    uint32_t evicted = 0;
+
+    ve_mutex_lock(g_pipeline.registry_mutex);
+
+    for (uint32_t i = 0; i < g_pipeline.entry_count;) {
+        ve_pipeline_entry* entry = &g_pipeline.entries[i];
+        bool idle = entry->ref_count == 0 && frame - entry->last_used_frame >= min_idle_frames &&
+                    ve_atomic_load32(&entry->pipeline->state) != VE_PIPELINE_PENDING;
+        if (!idle) {
+            i++;
+            continue;
+        }
+
+        ve_pipeline_destroy(entry->pipeline);
+        VE_FREE(entry->key);
+        g_pipeline.entries[i] = g_pipeline.entries[--g_pipeline.entry_count];
+        evicted++;
+    }
+
+    if (evicted > 0) {
+        g_pipeline.evicted += evicted;
+        /* Entries moved, so the table is rebuilt rather than patched */
+        if (!rebuild_registry_table(g_pipeline.table_capacity)) {
+            VE_LOG_ERROR("Failed to rebuild pipeline registry");
+        }
+    }
+
+    ve_mutex_unlock(g_pipeline.registry_mutex);
+    return evicted;
+}
@@ -1,18 +1,255 @@
 /**
  * @file pipeline.h
  * @brief Vulkan graphics pipeline management
+ *
+ * Pipelines are created through one VkPipelineCache that is loaded from
+ * disk at startup and written back at shutdown, so only the first run on a
+ * device and driver pays the full compile cost. The file is discarded when
+ * its vendor, device, driver version or cache UUID differ from the current
+ * device. Creation runs on the thread pool: create functions return a
+ * pending handle at once, and the caller either waits for it or keeps
+ * drawing without it until ve_pipeline_is_ready.
+ *
+ * The registry deduplicates pipelines by hashing their full state:
+ * shaders, specialization constants, vertex layout, rasterization, depth,
+ * blend, layout, render pass and subpass. Identical requests share one
+ * pipeline and a reference count; unreferenced pipelines stay cached until
+ * ve_pipeline_evict_unused.
  */
 
 #ifndef VE_PIPELINE_H
 #define VE_PIPELINE_H
 
 #include "vulkan_core.h"
+#include "../core/thread.h"
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* TODO: Implement pipeline management */
+/* Default pipeline cache file, relative to the working directory */
+#define VE_PIPELINE_CACHE_PATH "pipeline_cache.bin"
+
+/* Most color attachments of a graphics pipeline */
+#define VE_PIPELINE_MAX_COLOR_ATTACHMENTS 8
+
+/**
+ * @brief Pipeline creation state
+ */
+typedef enum ve_pipeline_state {
+    VE_PIPELINE_PENDING,
+    VE_PIPELINE_READY,
+    VE_PIPELINE_FAILED
+} ve_pipeline_state;
+
+/**
+ * @brief Graphics pipeline description
+ *
+ * Viewport and scissor are always dynamic. Zeroed fields select the
+ * defaults: fill mode, no culling, counter-clockwise front faces, one
+ * sample, opaque color writes and VK_COMPARE_OP_LESS_OR_EQUAL. With a null
+ * layout the bindless pipeline layout is used.
+ */
+typedef struct ve_graphics_pipeline_desc {
+    VkShaderModule vertex_shader;
+    VkShaderModule fragment_shader;     /* May be VK_NULL_HANDLE for depth-only pipelines */
+    VkShaderModule task_shader;         /* Optional, only with mesh_shader */
+    VkShaderModule mesh_shader;         /* Replaces vertex_shader and vertex input when set */
+    const VkSpecializationInfo* specialization;     /* Applied to both stages, may be NULL */
+
+    const VkVertexInputBindingDescription* vertex_bindings;
+    uint32_t vertex_binding_count;
+    const VkVertexInputAttributeDescription* vertex_attributes;
+    uint32_t vertex_attribute_count;
+
+    VkPrimitiveTopology topology;
+    VkPolygonMode polygon_mode;
+    VkCullModeFlags cull_mode;
+    VkFrontFace front_face;
+    VkSampleCountFlagBits samples;
+
+    bool depth_test;
+    bool depth_write;
+    VkCompareOp depth_compare;
+
+    uint32_t color_attachment_count;
+    const VkPipelineColorBlendAttachmentState* blend_attachments;   /* NULL for opaque */
+
+    VkPipelineLayout layout;
+    VkRenderPass render_pass;
+    uint32_t subpass;
+
+    const char* debug_name;
+} ve_graphics_pipeline_desc;
+
+/**
+ * @brief Compute pipeline description
+ */
+typedef struct ve_compute_pipeline_desc {
+    VkShaderModule shader;
+    const VkSpecializationInfo* specialization;     /* May be NULL */
+    VkPipelineLayout layout;                        /* VK_NULL_HANDLE for the bindless layout */
+    const char* debug_name;
+} ve_compute_pipeline_desc;
+
+/**
+ * @brief Pipeline handle
+ *
+ * pipeline and result are valid once state is no longer VE_PIPELINE_PENDING.
+ */
+typedef struct ve_pipeline {
+    VkPipeline pipeline;
+    VkPipelineLayout layout;
+    VkPipelineBindPoint bind_point;
+    ve_atomic_int32 state;          /* ve_pipeline_state */
+    VkResult result;
+    double compile_time;            /* Seconds spent in vkCreate*Pipelines */
+    uint64_t hash;                  /* Registry key hash, 0 if not registered */
+} ve_pipeline;
+
+/**
+ * @brief Pipeline statistics
+ */
+typedef struct ve_pipeline_stats {
+    uint32_t created;
+    uint32_t failed;
+    uint32_t pending;
+    double compile_time;            /* Seconds, summed over all pipelines */
+    size_t cache_loaded_size;       /* Bytes read from disk, 0 on a cold start */
+    size_t cache_saved_size;
+    uint32_t registered;            /* Pipelines in the registry */
+    uint64_t registry_hits;         /* Acquisitions served by an existing pipeline */
+    uint32_t evicted;
+} ve_pipeline_stats;
+
+/**
+ * @brief Create the pipeline cache, loading it from disk if valid
+ *
+ * @param cache_path Cache file, NULL for VE_PIPELINE_CACHE_PATH
+ * @param pool Thread pool to compile on, or NULL to compile on the calling thread
+ * @return VK_SUCCESS on success
+ */
+VkResult ve_pipeline_init(const char* cache_path, ve_thread_pool* pool);
+
+/**
+ * @brief Wait for pending pipelines, save the cache and destroy it
+ */
+void ve_pipeline_shutdown(void);
+
+/**
+ * @brief Write the pipeline cache to disk now
+ *
+ * Nothing is written when the cache has not changed since it was loaded or
+ * last saved.
+ *
+ * @return true if the file is up to date
+ */
+bool ve_pipeline_save_cache(void);
+
+/**
+ * @brief Get the pipeline cache
+ *
+ * @return Pipeline cache, shared by every pipeline creation
+ */
+VkPipelineCache ve_pipeline_get_cache(void);
+
+/**
+ * @brief Start creating a graphics pipeline
+ *
+ * The description is copied, but its shader modules, layout and render
+ * pass must stay alive until the pipeline is no longer pending.
+ *
+ * @param desc Pipeline description
+ * @return Pending pipeline, or NULL if out of memory
+ */
+ve_pipeline* ve_pipeline_create_graphics(const ve_graphics_pipeline_desc* desc);
+
+/**
+ * @brief Start creating a compute pipeline
+ *
+ * @param desc Pipeline description
+ * @return Pending pipeline, or NULL if out of memory
+ */
+ve_pipeline* ve_pipeline_create_compute(const ve_compute_pipeline_desc* desc);
+
+/**
+ * @brief Check if a pipeline can be bound
+ *
+ * @param pipeline Pipeline
+ * @return true if creation finished successfully
+ */
+bool ve_pipeline_is_ready(const ve_pipeline* pipeline);
+
+/**
+ * @brief Wait for a pipeline
+ *
+ * @param pipeline Pipeline
+ * @return Creation result
+ */
+VkResult ve_pipeline_wait(ve_pipeline* pipeline);
+
+/**
+ * @brief Wait until no pipeline is pending, running pool tasks meanwhile
+ *
+ * Used to warm the cache at load time, after starting every pipeline.
+ */
+void ve_pipeline_wait_all(void);
+
+/**
+ * @brief Destroy a pipeline
+ *
+ * Waits if it is still pending; the VkPipeline is released through the
+ * deletion queue. Not for registry pipelines, which are released with
+ * ve_pipeline_release.
+ *
+ * @param pipeline Pipeline
+ */
+void ve_pipeline_destroy(ve_pipeline* pipeline);
+
+/**
+ * @brief Get a graphics pipeline from the registry, creating it if needed
+ *
+ * Returns the same handle, pending or not, for every description with the
+ * same state, and adds a reference to it. Debug names are not part of the
+ * key. Thread-safe.
+ *
+ * @param desc Pipeline description
+ * @return Pipeline, or NULL if out of memory
+ */
+ve_pipeline* ve_pipeline_acquire_graphics(const ve_graphics_pipeline_desc* desc);
+
+/**
+ * @brief Get a compute pipeline from the registry, creating it if needed
+ *
+ * @param desc Pipeline description
+ * @return Pipeline, or NULL if out of memory
+ */
+ve_pipeline* ve_pipeline_acquire_compute(const ve_compute_pipeline_desc* desc);
+
+/**
+ * @brief Drop a reference taken by ve_pipeline_acquire_*
+ *
+ * The pipeline stays in the registry for later requests.
+ *
+ * @param pipeline Pipeline
+ */
+void ve_pipeline_release(ve_pipeline* pipeline);
+
+/**
+ * @brief Destroy registry pipelines nobody references
+ *
+ * @param min_idle_frames Frames since the last release before a pipeline may be evicted
+ * @return Number of pipelines evicted
+ */
+uint32_t ve_pipeline_evict_unused(uint64_t min_idle_frames);
+
+/**
+ * @brief Get pipeline statistics
+ *
+ * @param stats Output statistics
+ */
+void ve_pipeline_get_stats(ve_pipeline_stats* stats);
 
 #ifdef __cplusplus
 }
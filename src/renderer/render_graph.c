@@ -0,0 +1,1257 @@
+/**
+ * @file render_graph.c
+ * @brief Frame render graph implementation
+ */
+
+#define VK_NO_PROTOTYPES
+#include "render_graph.h"
+
+#include "deletion_queue.h"
+#include "gpu_memory.h"
+#include "submit.h"
+#include "../core/logger.h"
+#include "../core/assert.h"
+#include "../core/memory.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* Access bits that write memory and must be made available */
+#define RG_WRITE_ACCESS (VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | \
+                         VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT)
+
+/* Stages of shader accesses, by pass queue */
+#define RG_GRAPHICS_SHADER_STAGES (VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT)
+#define RG_COMPUTE_SHADER_STAGES VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+
+/* Queues passes execute on, indexed by ve_command_buffer_type */
+#define RG_QUEUE_COUNT 2
+#define RG_QUEUE_BIT(queue) (1u << (queue))
+
+/**
+ * @brief What an access means to the GPU
+ */
+typedef struct rg_access_info {
+    VkPipelineStageFlags stage;     /* Zero for the shader stages of the pass */
+    VkAccessFlags access;
+    VkImageLayout layout;
+    VkImageUsageFlags image_usage;  /* Zero if images cannot be accessed this way */
+    VkBufferUsageFlags buffer_usage; /* Zero if buffers cannot be accessed this way */
+    bool write;
+} rg_access_info;
+
+static const rg_access_info g_access_info[VE_RENDER_GRAPH_ACCESS_COUNT] = {
+    [VE_RENDER_GRAPH_ACCESS_COLOR_ATTACHMENT] = {
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, 0, true,
+    },
+    [VE_RENDER_GRAPH_ACCESS_DEPTH_ATTACHMENT] = {
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 0, true,
+    },
+    [VE_RENDER_GRAPH_ACCESS_DEPTH_READ] = {
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+        VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 0, false,
+    },
+    [VE_RENDER_GRAPH_ACCESS_INPUT_ATTACHMENT] = {
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT, 0, false,
+    },
+    [VE_RENDER_GRAPH_ACCESS_SAMPLED] = {
+        0, VK_ACCESS_SHADER_READ_BIT,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, 0, false,
+    },
+    [VE_RENDER_GRAPH_ACCESS_STORAGE_READ] = {
+        0, VK_ACCESS_SHADER_READ_BIT,
+        VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false,
+    },
+    [VE_RENDER_GRAPH_ACCESS_STORAGE_WRITE] = {
+        0, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true,
+    },
+    [VE_RENDER_GRAPH_ACCESS_UNIFORM] = {
+        0, VK_ACCESS_UNIFORM_READ_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, false,
+    },
+    [VE_RENDER_GRAPH_ACCESS_VERTEX_INPUT] = {
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, false,
+    },
+    [VE_RENDER_GRAPH_ACCESS_INDIRECT] = {
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, false,
+    },
+    [VE_RENDER_GRAPH_ACCESS_TRANSFER_SRC] = {
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, false,
+    },
+    [VE_RENDER_GRAPH_ACCESS_TRANSFER_DST] = {
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_BUFFER_USAGE_TRANSFER_DST_BIT, true,
+    },
+};
+
+/**
+ * @brief Resource access of a pass
+ */
+typedef struct rg_access {
+    ve_render_graph_handle resource;
+    ve_render_graph_access access;
+} rg_access;
+
+/**
+ * @brief Declared pass
+ */
+typedef struct rg_pass {
+    char name[VE_RENDER_GRAPH_MAX_NAME];
+    ve_render_graph_queue queue;
+    ve_render_graph_execute_fn execute;
+    void* user_data;
+    rg_access accesses[VE_RENDER_GRAPH_MAX_PASS_ACCESSES];
+    uint32_t access_count;
+    bool side_effects;
+    bool live;
+    ve_command_buffer_type exec_queue;  /* Chosen at compile time */
+} rg_pass;
+
+/**
+ * @brief Declared resource with its physical object and execution state
+ */
+typedef struct rg_resource {
+    char name[VE_RENDER_GRAPH_MAX_NAME];
+    bool is_image;
+    bool imported;
+
+    /* Image */
+    VkImage image;
+    VkImageView view;
+    VkFormat format;
+    VkExtent2D extent;
+    VkImageAspectFlags aspect;
+    VkImageLayout initial_layout;
+    VkImageLayout final_layout;
+    VkImageUsageFlags image_usage;
+
+    /* Buffer */
+    VkBuffer buffer;
+    VkDeviceSize size;
+    VkBufferUsageFlags buffer_usage;
+
+    /* Compile results, for transient resources */
+    bool used;                      /* Accessed by a live pass */
+    uint32_t first_pass;
+    uint32_t last_pass;
+    uint32_t slot;
+    uint32_t queue_mask;                /* RG_QUEUE_BIT of every queue accessing it */
+    VkMemoryRequirements requirements;
+    VkPipelineStageFlags entry_stages;  /* Last use of the memory before each execution */
+    VkAccessFlags entry_access;
+    ve_command_buffer_type entry_queue;
+
+    /* Execution state */
+    VkImageLayout layout;
+    VkPipelineStageFlags write_stages;  /* Stages of the last write or transition */
+    VkAccessFlags write_access;         /* Writes not yet made available */
+    VkPipelineStageFlags read_stages;   /* Stages reading since the last write */
+    VkPipelineStageFlags visible_stages;
+    VkAccessFlags visible_access;
+    ve_command_buffer_type queue;       /* Queue of the last access */
+    uint32_t epoch;                     /* Batcher flush the last access belongs to */
+} rg_resource;
+
+/**
+ * @brief Memory shared by transient resources with disjoint lifetimes
+ */
+typedef struct rg_slot {
+    ve_gpu_allocation allocation;
+    VkDeviceSize size;
+    VkDeviceSize alignment;
+    uint32_t type_bits;
+    uint32_t queue_mask;
+    bool is_image;
+} rg_slot;
+
+/**
+ * @brief Command buffer a queue is recording during ve_render_graph_submit
+ */
+typedef struct rg_queue {
+    ve_command_buffer* cmd;
+    bool has_work;                      /* Commands recorded since the last flush */
+    bool waits_pending[RG_QUEUE_COUNT]; /* Pending batch waits on another queue's pending batch */
+} rg_queue;
+
+struct ve_render_graph {
+    rg_pass passes[VE_RENDER_GRAPH_MAX_PASSES];
+    uint32_t pass_count;
+    rg_resource resources[VE_RENDER_GRAPH_MAX_RESOURCES];
+    uint32_t resource_count;
+    rg_slot slots[VE_RENDER_GRAPH_MAX_RESOURCES];
+    uint32_t slot_count;
+    bool compiled;
+    bool async_compute;                 /* Async passes run on the compute queue */
+
+    /* Submission state */
+    bool split;
+    ve_command_buffer* inline_cmd;
+    rg_queue queues[RG_QUEUE_COUNT];
+    uint32_t epoch;
+
+    uint32_t culled_passes;
+    uint32_t async_passes;
+    uint32_t queue_waits;
+    uint32_t queue_flushes;
+    VkDeviceSize unaliased_memory;
+    uint32_t barriers;
+    uint32_t barrier_batches;
+};
+
+/* Barriers collected for one pass */
+typedef struct rg_barrier_batch {
+    VkPipelineStageFlags src_stages;
+    VkPipelineStageFlags dst_stages;
+    VkImageMemoryBarrier images[VE_RENDER_GRAPH_MAX_PASS_ACCESSES + VE_RENDER_GRAPH_MAX_RESOURCES];
+    uint32_t image_count;
+    VkBufferMemoryBarrier buffers[VE_RENDER_GRAPH_MAX_PASS_ACCESSES];
+    uint32_t buffer_count;
+} rg_barrier_batch;
+
+static void free_slot_allocation(void* user_data) {
+    ve_gpu_allocation* allocation = (ve_gpu_allocation*)user_data;
+    ve_gpu_memory_free(allocation);
+    VE_FREE(allocation);
+}
+
+/**
+ * @brief Release transient objects and memory once the current frame has completed
+ */
+static void release_transients(ve_render_graph* graph) {
+    for (uint32_t i = 0; i < graph->resource_count; i++) {
+        rg_resource* resource = &graph->resources[i];
+        if (resource->imported) {
+            continue;
+        }
+        if (resource->view != VK_NULL_HANDLE) {
+            ve_deletion_queue_push_image_view(resource->view);
+        }
+        if (resource->image != VK_NULL_HANDLE) {
+            ve_deletion_queue_push_image(resource->image);
+        }
+        if (resource->buffer != VK_NULL_HANDLE) {
+            ve_deletion_queue_push_buffer(resource->buffer);
+        }
+        resource->view = VK_NULL_HANDLE;
+        resource->image = VK_NULL_HANDLE;
+        resource->buffer = VK_NULL_HANDLE;
+    }
+
+    for (uint32_t i = 0; i < graph->slot_count; i++) {
+        if (graph->slots[i].allocation.memory == VK_NULL_HANDLE) {
+            continue;
+        }
+        ve_gpu_allocation* pending = (ve_gpu_allocation*)VE_ALLOCATE_TAG(sizeof(ve_gpu_allocation),
+                                                                         VE_MEMORY_TAG_RENDERER);
+        if (pending) {
+            *pending = graph->slots[i].allocation;
+            ve_deletion_queue_push_callback(free_slot_allocation, pending);
+        } else {
+            VE_LOG_ERROR("Out of memory deferring render graph memory release, leaking it");
+        }
+    }
+
+    memset(graph->slots, 0, sizeof(graph->slots));
+    graph->slot_count = 0;
+    graph->compiled = false;
+}
+
+ve_render_graph* ve_render_graph_create(void) {
+    ve_render_graph* graph = (ve_render_graph*)ve_allocate_cleared(1, sizeof(ve_render_graph),
+                                                                   VE_MEMORY_TAG_RENDERER);
+    if (!graph) {
+        VE_LOG_ERROR("Failed to allocate render graph");
+    }
+    return graph;
+}
+
+void ve_render_graph_destroy(ve_render_graph* graph) {
+    if (!graph) {
+        return;
+    }
+
+    release_transients(graph);
+    VE_FREE(graph);
+}
+
+void ve_render_graph_reset(ve_render_graph* graph) {
+    VE_ASSERT(graph);
+
+    release_transients(graph);
+    graph->pass_count = 0;
+    graph->resource_count = 0;
+    graph->culled_passes = 0;
+    graph->unaliased_memory = 0;
+    graph->barriers = 0;
+    graph->barrier_batches = 0;
+}
+
+static rg_resource* add_resource(ve_render_graph* graph, const char* name, ve_render_graph_handle* out_handle) {
+    if (graph->resource_count >= VE_RENDER_GRAPH_MAX_RESOURCES) {
+        VE_LOG_ERROR("Render graph resource limit reached (%d)", VE_RENDER_GRAPH_MAX_RESOURCES);
+        return NULL;
+    }
+
+    /* Declaring after compiling means the graph is being rebuilt */
+    if (graph->compiled) {
+        release_transients(graph);
+    }
+
+    *out_handle = graph->resource_count;
+    rg_resource* resource = &graph->resources[graph->resource_count++];
+    memset(resource, 0, sizeof(rg_resource));
+    snprintf(resource->name, sizeof(resource->name), "%s", name ? name : "resource");
+    return resource;
+}
+
+ve_render_graph_handle ve_render_graph_create_image(ve_render_graph* graph, const char* name,
+                                                    const ve_render_graph_image_desc* desc) {
+    VE_ASSERT(graph && desc && desc->width > 0 && desc->height > 0);
+
+    ve_render_graph_handle handle = VE_RENDER_GRAPH_INVALID;
+    rg_resource* resource = add_resource(graph, name, &handle);
+    if (!resource) {
+        return VE_RENDER_GRAPH_INVALID;
+    }
+
+    resource->is_image = true;
+    resource->format = desc->format;
+    resource->extent = (VkExtent2D){ desc->width, desc->height };
+    resource->aspect = desc->aspect ? desc->aspect : VK_IMAGE_ASPECT_COLOR_BIT;
+    resource->initial_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    resource->final_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    return handle;
+}
+
+ve_render_graph_handle ve_render_graph_create_buffer(ve_render_graph* graph, const char* name, VkDeviceSize size) {
+    VE_ASSERT(graph && size > 0);
+
+    ve_render_graph_handle handle = VE_RENDER_GRAPH_INVALID;
+    rg_resource* resource = add_resource(graph, name, &handle);
+    if (!resource) {
+        return VE_RENDER_GRAPH_INVALID;
+    }
+
+    resource->size = size;
+    return handle;
+}
+
+ve_render_graph_handle ve_render_graph_import_image(ve_render_graph* graph, const char* name,
+                                                    const ve_render_graph_image_import* import) {
+    VE_ASSERT(graph && import);
+
+    ve_render_graph_handle handle = VE_RENDER_GRAPH_INVALID;
+    rg_resource* resource = add_resource(graph, name, &handle);
+    if (!resource) {
+        return VE_RENDER_GRAPH_INVALID;
+    }
+
+    resource->is_image = true;
+    resource->imported = true;
+    resource->image = import->image;
+    resource->view = import->view;
+    resource->format = import->format;
+    resource->extent = import->extent;
+    resource->aspect = import->aspect ? import->aspect : VK_IMAGE_ASPECT_COLOR_BIT;
+    resource->initial_layout = import->initial_layout;
+    resource->final_layout = import->final_layout;
+    return handle;
+}
+
+ve_render_graph_handle ve_render_graph_import_buffer(ve_render_graph* graph, const char* name,
+                                                     VkBuffer buffer, VkDeviceSize size) {
+    VE_ASSERT(graph);
+
+    ve_render_graph_handle handle = VE_RENDER_GRAPH_INVALID;
+    rg_resource* resource = add_resource(graph, name, &handle);
+    if (!resource) {
+        return VE_RENDER_GRAPH_INVALID;
+    }
+
+    resource->imported = true;
+    resource->buffer = buffer;
+    resource->size = size;
+    return handle;
+}
+
+void ve_render_graph_update_image(ve_render_graph* graph, ve_render_graph_handle resource,
+                                  VkImage image, VkImageView view) {
+    VE_ASSERT(graph && resource < graph->resource_count);
+    VE_ASSERT_MSG(graph->resources[resource].imported && graph->resources[resource].is_image,
+                  "Only imported images can be updated");
+
+    graph->resources[resource].image = image;
+    graph->resources[resource].view = view;
+}
+
+void ve_render_graph_update_buffer(ve_render_graph* graph, ve_render_graph_handle resource, VkBuffer buffer) {
+    VE_ASSERT(graph && resource < graph->resource_count);
+    VE_ASSERT_MSG(graph->resources[resource].imported && !graph->resources[resource].is_image,
+                  "Only imported buffers can be updated");
+
+    graph->resources[resource].buffer = buffer;
+}
+
+ve_render_graph_handle ve_render_graph_add_pass(ve_render_graph* graph, const char* name,
+                                                ve_render_graph_queue queue,
+                                                ve_render_graph_execute_fn execute, void* user_data) {
+    VE_ASSERT(graph && execute);
+
+    if (graph->pass_count >= VE_RENDER_GRAPH_MAX_PASSES) {
+        VE_LOG_ERROR("Render graph pass limit reached (%d)", VE_RENDER_GRAPH_MAX_PASSES);
+        return VE_RENDER_GRAPH_INVALID;
+    }
+
+    if (graph->compiled) {
+        release_transients(graph);
+    }
+
+    rg_pass* pass = &graph->passes[graph->pass_count];
+    memset(pass, 0, sizeof(rg_pass));
+    snprintf(pass->name, sizeof(pass->name), "%s", name ? name : "pass");
+    pass->queue = queue;
+    pass->execute = execute;
+    pass->user_data = user_data;
+    return graph->pass_count++;
+}
+
+bool ve_render_graph_use(ve_render_graph* graph, ve_render_graph_handle pass,
+                         ve_render_graph_handle resource, ve_render_graph_access access) {
+    VE_ASSERT(graph && pass < graph->pass_count && access < VE_RENDER_GRAPH_ACCESS_COUNT);
+
+    if (resource >= graph->resource_count) {
+        return false;
+    }
+
+    rg_pass* p = &graph->passes[pass];
+    const rg_resource* r = &graph->resources[resource];
+    const rg_access_info* info = &g_access_info[access];
+
+    if ((r->is_image && info->image_usage == 0) || (!r->is_image && info->buffer_usage == 0)) {
+        VE_LOG_ERROR("Pass %s cannot use %s with access %d", p->name, r->name, access);
+        return false;
+    }
+
+    /* One access per resource and pass, so a pass never needs two layouts of one image */
+    for (uint32_t i = 0; i < p->access_count; i++) {
+        if (p->accesses[i].resource == resource) {
+            VE_LOG_ERROR("Pass %s uses %s more than once", p->name, r->name);
+            return false;
+        }
+    }
+
+    if (p->access_count >= VE_RENDER_GRAPH_MAX_PASS_ACCESSES) {
+        VE_LOG_ERROR("Pass %s has too many accesses (%d)", p->name, VE_RENDER_GRAPH_MAX_PASS_ACCESSES);
+        return false;
+    }
+
+    if (graph->compiled) {
+        release_transients(graph);
+    }
+
+    p->accesses[p->access_count++] = (rg_access){ resource, access };
+    return true;
+}
+
+void ve_render_graph_set_side_effects(ve_render_graph* graph, ve_render_graph_handle pass) {
+    VE_ASSERT(graph && pass < graph->pass_count);
+    graph->passes[pass].side_effects = true;
+}
+
+static VkPipelineStageFlags access_stages(const rg_pass* pass, ve_render_graph_access access) {
+    if (g_access_info[access].stage) {
+        return g_access_info[access].stage;
+    }
+    return pass->queue == VE_RENDER_GRAPH_QUEUE_GRAPHICS ? RG_GRAPHICS_SHADER_STAGES : RG_COMPUTE_SHADER_STAGES;
+}
+
+/**
+ * @brief Mark passes live, walking back from imported writes and side effects
+ *
+ * A pass is live if it writes something a later live pass accesses. Writes
+ * are assumed to keep earlier contents, so earlier producers stay live too.
+ */
+static void cull_passes(ve_render_graph* graph) {
+    bool needed[VE_RENDER_GRAPH_MAX_RESOURCES] = {0};
+
+    graph->culled_passes = 0;
+    for (uint32_t p = graph->pass_count; p-- > 0;) {
+        rg_pass* pass = &graph->passes[p];
+
+        pass->live = pass->side_effects;
+        for (uint32_t i = 0; i < pass->access_count && !pass->live; i++) {
+            const rg_access* a = &pass->accesses[i];
+            if (g_access_info[a->access].write &&
+                (graph->resources[a->resource].imported || needed[a->resource])) {
+                pass->live = true;
+            }
+        }
+
+        if (!pass->live) {
+            graph->culled_passes++;
+            continue;
+        }
+
+        for (uint32_t i = 0; i < pass->access_count; i++) {
+            needed[pass->accesses[i].resource] = true;
+        }
+    }
+}
+
+/**
+ * @brief Derive usage flags and lifetimes from the live passes' accesses
+ */
+static void compute_lifetimes(ve_render_graph* graph) {
+    for (uint32_t r = 0; r < graph->resource_count; r++) {
+        rg_resource* resource = &graph->resources[r];
+        resource->used = false;
+        resource->queue_mask = 0;
+        resource->image_usage = 0;
+        resource->buffer_usage = 0;
+        resource->entry_stages = 0;
+        resource->entry_access = 0;
+    }
+
+    for (uint32_t p = 0; p < graph->pass_count; p++) {
+        const rg_pass* pass = &graph->passes[p];
+        if (!pass->live) {
+            continue;
+        }
+
+        for (uint32_t i = 0; i < pass->access_count; i++) {
+            rg_resource* resource = &graph->resources[pass->accesses[i].resource];
+            const rg_access_info* info = &g_access_info[pass->accesses[i].access];
+
+            if (!resource->used) {
+                resource->used = true;
+                resource->first_pass = p;
+            }
+            resource->last_pass = p;
+            resource->queue_mask |= RG_QUEUE_BIT(pass->exec_queue);
+            resource->image_usage |= info->image_usage;
+            resource->buffer_usage |= info->buffer_usage;
+        }
+    }
+}
+
+static VkResult create_transient(ve_render_graph* graph, rg_resource* resource) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VkResult result;
+
+    /* Shared between queue families without ownership transfers */
+    const uint32_t families[2] = { vk->queue_families.graphics_family, vk->queue_families.compute_family };
+    bool concurrent = resource->queue_mask == (RG_QUEUE_BIT(VE_COMMAND_BUFFER_GRAPHICS) |
+                                               RG_QUEUE_BIT(VE_COMMAND_BUFFER_COMPUTE)) &&
+                      families[0] != families[1];
+    VkSharingMode sharing = concurrent ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+
+    if (resource->is_image) {
+        VkImageCreateInfo image_info = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .imageType = VK_IMAGE_TYPE_2D,
+            .format = resource->format,
+            .extent = { resource->extent.width, resource->extent.height, 1 },
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = resource->image_usage,
+            .sharingMode = sharing,
+            .queueFamilyIndexCount = concurrent ? 2 : 0,
+            .pQueueFamilyIndices = concurrent ? families : NULL,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        };
+
+        result = vkCreateImage(vk->device, &image_info, NULL, &resource->image);
+        if (result != VK_SUCCESS) {
+            VE_LOG_ERROR("Failed to create render graph image %s: %d", resource->name, result);
+            return result;
+        }
+        vkGetImageMemoryRequirements(vk->device, resource->image, &resource->requirements);
+        VE_VK_SET_OBJECT_NAME(resource->image, VK_OBJECT_TYPE_IMAGE, resource->name);
+    } else {
+        VkBufferCreateInfo buffer_info = {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .size = resource->size,
+            .usage = resource->buffer_usage,
+            .sharingMode = sharing,
+            .queueFamilyIndexCount = concurrent ? 2 : 0,
+            .pQueueFamilyIndices = concurrent ? families : NULL,
+        };
+
+        result = vkCreateBuffer(vk->device, &buffer_info, NULL, &resource->buffer);
+        if (result != VK_SUCCESS) {
+            VE_LOG_ERROR("Failed to create render graph buffer %s: %d", resource->name, result);
+            return result;
+        }
+        vkGetBufferMemoryRequirements(vk->device, resource->buffer, &resource->requirements);
+        VE_VK_SET_OBJECT_NAME(resource->buffer, VK_OBJECT_TYPE_BUFFER, resource->name);
+    }
+
+    graph->unaliased_memory += resource->requirements.size;
+    return VK_SUCCESS;
+}
+
+static bool lifetimes_overlap(const rg_resource* a, const rg_resource* b) {
+    return a->first_pass <= b->last_pass && b->first_pass <= a->last_pass;
+}
+
+/**
+ * @brief Assign transient resources to memory slots, largest first
+ *
+ * A resource joins the first slot of its kind whose memory types fit and
+ * whose occupants are all dead while it is alive. Only resources used on
+ * the same single queue share memory, so handing it over never needs a
+ * cross-queue wait.
+ */
+static void assign_slots(ve_render_graph* graph) {
+    uint32_t order[VE_RENDER_GRAPH_MAX_RESOURCES];
+    uint32_t count = 0;
+
+    for (uint32_t r = 0; r < graph->resource_count; r++) {
+        const rg_resource* resource = &graph->resources[r];
+        if (!resource->imported && resource->used) {
+            order[count++] = r;
+        }
+    }
+
+    /* Insertion sort by size, descending */
+    for (uint32_t i = 1; i < count; i++) {
+        uint32_t value = order[i];
+        uint32_t j = i;
+        while (j > 0 && graph->resources[order[j - 1]].requirements.size < graph->resources[value].requirements.size) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = value;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        rg_resource* resource = &graph->resources[order[i]];
+        uint32_t slot = UINT32_MAX;
+
+        for (uint32_t s = 0; s < graph->slot_count && slot == UINT32_MAX; s++) {
+            const rg_slot* candidate = &graph->slots[s];
+            bool single_queue = (resource->queue_mask & (resource->queue_mask - 1)) == 0;
+            if (candidate->is_image != resource->is_image || !single_queue ||
+                candidate->queue_mask != resource->queue_mask ||
+                !(candidate->type_bits & resource->requirements.memoryTypeBits)) {
+                continue;
+            }
+
+            bool available = true;
+            for (uint32_t k = 0; k < i && available; k++) {
+                const rg_resource* other = &graph->resources[order[k]];
+                if (other->slot == s && lifetimes_overlap(resource, other)) {
+                    available = false;
+                }
+            }
+            if (available) {
+                slot = s;
+            }
+        }
+
+        if (slot == UINT32_MAX) {
+            slot = graph->slot_count++;
+            graph->slots[slot] = (rg_slot){
+                .type_bits = resource->requirements.memoryTypeBits,
+                .queue_mask = resource->queue_mask,
+                .is_image = resource->is_image,
+            };
+        }
+
+        rg_slot* s = &graph->slots[slot];
+        resource->slot = slot;
+        s->type_bits &= resource->requirements.memoryTypeBits;
+        if (resource->requirements.size > s->size) {
+            s->size = resource->requirements.size;
+        }
+        if (resource->requirements.alignment > s->alignment) {
+            s->alignment = resource->requirements.alignment;
+        }
+    }
+}
+
+/**
+ * @brief Find what each transient resource must wait for at the start of an execution
+ *
+ * That is the last use of its memory by the previous occupant of its slot,
+ * or by the slot's last occupant in the previous frame.
+ */
+static void compute_entry_sync(ve_render_graph* graph) {
+    for (uint32_t r = 0; r < graph->resource_count; r++) {
+        rg_resource* resource = &graph->resources[r];
+        if (resource->imported || !resource->used) {
+            continue;
+        }
+
+        /* Occupant of the slot that ends last before this one starts, wrapping around */
+        const rg_resource* before = NULL;
+        const rg_resource* latest = NULL;
+        for (uint32_t o = 0; o < graph->resource_count; o++) {
+            const rg_resource* other = &graph->resources[o];
+            if (other->imported || !other->used || other->slot != resource->slot) {
+                continue;
+            }
+            if (other->last_pass < resource->first_pass && (!before || other->last_pass > before->last_pass)) {
+                before = other;
+            }
+            if (!latest || other->last_pass > latest->last_pass) {
+                latest = other;
+            }
+        }
+        const rg_resource* previous = before ? before : latest;
+
+        /* Earlier writes were made available by the barrier before that last use */
+        ve_render_graph_handle previous_handle = (ve_render_graph_handle)(previous - graph->resources);
+        const rg_pass* pass = &graph->passes[previous->last_pass];
+        resource->entry_queue = pass->exec_queue;
+        for (uint32_t i = 0; i < pass->access_count; i++) {
+            const rg_access* a = &pass->accesses[i];
+            if (a->resource == previous_handle) {
+                resource->entry_stages = access_stages(pass, a->access);
+                resource->entry_access = g_access_info[a->access].access & RG_WRITE_ACCESS;
+            }
+        }
+    }
+}
+
+static VkResult bind_transients(ve_render_graph* graph) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+
+    for (uint32_t s = 0; s < graph->slot_count; s++) {
+        rg_slot* slot = &graph->slots[s];
+        VkMemoryRequirements requirements = {
+            .size = slot->size,
+            .alignment = slot->alignment,
+            .memoryTypeBits = slot->type_bits,
+        };
+
+        VkResult result = ve_gpu_memory_allocate(&requirements, VE_GPU_MEMORY_USAGE_GPU_ONLY,
+                                                 VE_GPU_ALLOCATION_DEDICATED, &slot->allocation);
+        if (result != VK_SUCCESS) {
+            VE_LOG_ERROR("Failed to allocate render graph memory (%llu bytes): %d",
+                         (unsigned long long)slot->size, result);
+            return result;
+        }
+    }
+
+    for (uint32_t r = 0; r < graph->resource_count; r++) {
+        rg_resource* resource = &graph->resources[r];
+        if (resource->imported || !resource->used) {
+            continue;
+        }
+
+        const ve_gpu_allocation* allocation = &graph->slots[resource->slot].allocation;
+        VkResult result;
+
+        if (!resource->is_image) {
+            result = vkBindBufferMemory(vk->device, resource->buffer, allocation->memory, allocation->offset);
+            if (result != VK_SUCCESS) {
+                VE_LOG_ERROR("Failed to bind render graph buffer %s: %d", resource->name, result);
+                return result;
+            }
+            continue;
+        }
+
+        result = vkBindImageMemory(vk->device, resource->image, allocation->memory, allocation->offset);
+        if (result != VK_SUCCESS) {
+            VE_LOG_ERROR("Failed to bind render graph image %s: %d", resource->name, result);
+            return result;
+        }
+
+        VkImageViewCreateInfo view_info = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .image = resource->image,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = resource->format,
+            .subresourceRange = { resource->aspect, 0, 1, 0, 1 },
+        };
+
+        result = vkCreateImageView(vk->device, &view_info, NULL, &resource->view);
+        if (result != VK_SUCCESS) {
+            VE_LOG_ERROR("Failed to create render graph view %s: %d", resource->name, result);
+            return result;
+        }
+    }
+
+    return VK_SUCCESS;
+}
+
+VkResult ve_render_graph_compile(ve_render_graph* graph) {
+    VE_ASSERT(graph);
+
+    release_transients(graph);
+    graph->unaliased_memory = 0;
+
+    cull_passes(graph);
+
+    graph->async_compute = ve_vulkan_supports_async_compute() && ve_submit_is_enabled();
+    graph->async_passes = 0;
+    for (uint32_t p = 0; p < graph->pass_count; p++) {
+        rg_pass* pass = &graph->passes[p];
+        bool async = graph->async_compute && pass->queue == VE_RENDER_GRAPH_QUEUE_ASYNC_COMPUTE;
+        pass->exec_queue = async ? VE_COMMAND_BUFFER_COMPUTE : VE_COMMAND_BUFFER_GRAPHICS;
+        if (async && pass->live) {
+            graph->async_passes++;
+        }
+    }
+
+    compute_lifetimes(graph);
+
+    for (uint32_t r = 0; r < graph->resource_count; r++) {
+        rg_resource* resource = &graph->resources[r];
+        if (resource->imported || !resource->used) {
+            continue;
+        }
+        VkResult result = create_transient(graph, resource);
+        if (result != VK_SUCCESS) {
+            release_transients(graph);
+            return result;
+        }
+    }
+
+    assign_slots(graph);
+    compute_entry_sync(graph);
+
+    VkResult result = bind_transients(graph);
+    if (result != VK_SUCCESS) {
+        release_transients(graph);
+        return result;
+    }
+
+    graph->compiled = true;
+
+    VkDeviceSize aliased = 0;
+    for (uint32_t s = 0; s < graph->slot_count; s++) {
+        aliased += graph->slots[s].size;
+    }
+    VE_LOG_DEBUG("Render graph compiled: %u/%u passes live, %u slots, %llu KB transient (%llu KB unaliased)",
+                 graph->pass_count - graph->culled_passes, graph->pass_count, graph->slot_count,
+                 (unsigned long long)(aliased / 1024), (unsigned long long)(graph->unaliased_memory / 1024));
+    return VK_SUCCESS;
+}
+
+static void reset_states(ve_render_graph* graph) {
+    for (uint32_t r = 0; r < graph->resource_count; r++) {
+        rg_resource* resource = &graph->resources[r];
+
+        resource->layout = resource->initial_layout;
+        resource->read_stages = 0;
+        resource->visible_stages = 0;
+        resource->visible_access = 0;
+        if (resource->imported) {
+            /* Unknown earlier work, wait for all of it */
+            resource->write_stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+            resource->write_access = VK_ACCESS_MEMORY_WRITE_BIT;
+        } else {
+            resource->layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            resource->write_stages = resource->entry_stages;
+            resource->write_access = resource->entry_access;
+        }
+
+        /* Earlier than any access of this execution */
+        resource->queue = resource->imported ? VE_COMMAND_BUFFER_GRAPHICS : resource->entry_queue;
+        resource->epoch = 0;
+    }
+}
+
+static void add_barrier(rg_barrier_batch* batch, const rg_resource* resource,
+                        VkPipelineStageFlags src_stages, VkAccessFlags src_access,
+                        VkPipelineStageFlags dst_stages, VkAccessFlags dst_access, VkImageLayout new_layout) {
+    batch->src_stages |= src_stages;
+    batch->dst_stages |= dst_stages;
+
+    if (resource->is_image) {
+        VE_ASSERT(batch->image_count < VE_RENDER_GRAPH_MAX_PASS_ACCESSES + VE_RENDER_GRAPH_MAX_RESOURCES);
+        batch->images[batch->image_count++] = (VkImageMemoryBarrier){
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask = src_access,
+            .dstAccessMask = dst_access,
+            .oldLayout = resource->layout,
+            .newLayout = new_layout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = resource->image,
+            .subresourceRange = { resource->aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS },
+        };
+    } else {
+        VE_ASSERT(batch->buffer_count < VE_RENDER_GRAPH_MAX_PASS_ACCESSES);
+        batch->buffers[batch->buffer_count++] = (VkBufferMemoryBarrier){
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .srcAccessMask = src_access,
+            .dstAccessMask = dst_access,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = resource->buffer,
+            .offset = 0,
+            .size = VK_WHOLE_SIZE,
+        };
+    }
+}
+
+/**
+ * @brief Add the barrier an access needs, if any, and advance the resource state
+ *
+ * Writes and layout transitions wait for every earlier read and write.
+ * Reads in the current layout only wait for the last write, and only if
+ * it has not been made visible to their stages yet.
+ */
+static void transition(rg_barrier_batch* batch, rg_resource* resource,
+                       VkPipelineStageFlags stages, const rg_access_info* info) {
+    VkImageLayout layout = resource->is_image ? info->layout : VK_IMAGE_LAYOUT_UNDEFINED;
+    bool layout_change = resource->is_image && layout != resource->layout;
+
+    if (info->write || layout_change) {
+        VkPipelineStageFlags src = resource->write_stages | resource->read_stages;
+        if (src || layout_change) {
+            add_barrier(batch, resource, src, resource->write_access, stages, info->access, layout);
+        }
+
+        /* Later barriers chain after the write or transition through these stages */
+        resource->layout = layout;
+        resource->write_stages = stages;
+        if (info->write) {
+            resource->write_access = info->access & RG_WRITE_ACCESS;
+            resource->read_stages = 0;
+            resource->visible_stages = 0;
+            resource->visible_access = 0;
+        } else {
+            resource->write_access = 0;
+            resource->read_stages = stages;
+            resource->visible_stages = stages;
+            resource->visible_access = info->access;
+        }
+        return;
+    }
+
+    bool visible = (stages & ~resource->visible_stages) == 0 && (info->access & ~resource->visible_access) == 0;
+    if (resource->write_stages && !visible) {
+        add_barrier(batch, resource, resource->write_stages, resource->write_access, stages, info->access, layout);
+        resource->visible_stages |= stages;
+        resource->visible_access |= info->access;
+    }
+    resource->read_stages |= stages;
+}
+
+static void flush_barriers(ve_render_graph* graph, ve_command_buffer* cmd, rg_barrier_batch* batch) {
+    if (batch->image_count == 0 && batch->buffer_count == 0) {
+        return;
+    }
+
+    ve_command_buffer_pipeline_barrier(cmd,
+        batch->src_stages ? batch->src_stages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        batch->dst_stages ? batch->dst_stages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        0, 0, NULL, batch->buffer_count, batch->buffers, batch->image_count, batch->images);
+
+    graph->barriers += batch->image_count + batch->buffer_count;
+    graph->barrier_batches++;
+    batch->src_stages = 0;
+    batch->dst_stages = 0;
+    batch->image_count = 0;
+    batch->buffer_count = 0;
+}
+
+/**
+ * @brief Get the command buffer a queue records into, beginning one if needed
+ */
+static ve_command_buffer* queue_cmd(ve_render_graph* graph, ve_command_buffer_type queue) {
+    if (!graph->split) {
+        return graph->inline_cmd;
+    }
+
+    rg_queue* q = &graph->queues[queue];
+    if (!q->cmd) {
+        q->cmd = ve_command_buffer_allocate_frame(queue, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+        if (!q->cmd || ve_command_buffer_begin(q->cmd, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT) != VK_SUCCESS) {
+            VE_LOG_ERROR("Failed to begin render graph command buffer for queue %d", queue);
+            q->cmd = NULL;
+            return NULL;
+        }
+    }
+    q->has_work = true;
+    return q->cmd;
+}
+
+/**
+ * @brief End the open command buffers and add them to the batcher
+ */
+static VkResult close_queues(ve_render_graph* graph) {
+    VkResult status = VK_SUCCESS;
+
+    for (uint32_t q = 0; q < RG_QUEUE_COUNT; q++) {
+        ve_command_buffer* cmd = graph->queues[q].cmd;
+        if (!cmd) {
+            continue;
+        }
+
+        VkResult result = ve_command_buffer_end(cmd);
+        if (result == VK_SUCCESS && !ve_submit_add(cmd)) {
+            VE_LOG_ERROR("Submission batch full, dropping render graph commands");
+            result = VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+        if (result != VK_SUCCESS) {
+            status = result;
+        }
+        graph->queues[q].cmd = NULL;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Submit everything recorded so far, starting a new epoch
+ */
+static VkResult flush_queues(ve_render_graph* graph) {
+    VkResult result = close_queues(graph);
+    if (result == VK_SUCCESS) {
+        result = ve_submit_flush();
+    }
+
+    for (uint32_t q = 0; q < RG_QUEUE_COUNT; q++) {
+        graph->queues[q].has_work = false;
+        memset(graph->queues[q].waits_pending, 0, sizeof(graph->queues[q].waits_pending));
+    }
+    graph->epoch++;
+    graph->queue_flushes++;
+    return result;
+}
+
+/**
+ * @brief Make a queue wait for the other queue's last access of a resource
+ *
+ * The wait makes every earlier write visible to the waiting stages, so
+ * later barriers on this queue only need to chain after those stages.
+ */
+static void wait_other_queue(ve_render_graph* graph, rg_resource* resource,
+                             ve_command_buffer_type queue, VkPipelineStageFlags stages) {
+    ve_command_buffer_type producer = resource->queue;
+
+    if (resource->epoch == graph->epoch) {
+        ve_submit_wait_queue(queue, producer, (VkPipelineStageFlags2)stages);
+        graph->queues[queue].waits_pending[producer] = true;
+    } else {
+        ve_submit_wait_semaphore(queue, ve_submit_get_timeline(producer),
+                                 ve_submit_get_submitted_value(producer), (VkPipelineStageFlags2)stages);
+    }
+    graph->queue_waits++;
+
+    resource->queue = queue;
+    resource->write_stages = stages;
+    resource->write_access = 0;
+    resource->read_stages = 0;
+    resource->visible_stages = stages;
+    resource->visible_access = ~0u;
+}
+
+/**
+ * @brief Record the live passes, on one command buffer or split by queue
+ */
+static VkResult record(ve_render_graph* graph) {
+    rg_barrier_batch batch;
+    memset(&batch, 0, sizeof(batch));
+
+    reset_states(graph);
+    graph->epoch = 1;
+    graph->barriers = 0;
+    graph->barrier_batches = 0;
+    graph->queue_waits = 0;
+    graph->queue_flushes = 0;
+
+    bool compute_used = false;
+
+    for (uint32_t p = 0; p < graph->pass_count; p++) {
+        rg_pass* pass = &graph->passes[p];
+        if (!pass->live) {
+            continue;
+        }
+
+        ve_command_buffer_type queue = graph->split ? pass->exec_queue : VE_COMMAND_BUFFER_GRAPHICS;
+
+        if (graph->split) {
+            /* Waiting on a pending batch that already waits on ours would deadlock */
+            bool flush = false;
+            for (uint32_t i = 0; i < pass->access_count; i++) {
+                const rg_resource* resource = &graph->resources[pass->accesses[i].resource];
+                if (resource->queue != queue && resource->epoch == graph->epoch &&
+                    graph->queues[resource->queue].waits_pending[queue]) {
+                    flush = true;
+                }
+            }
+            if (flush) {
+                VkResult result = flush_queues(graph);
+                if (result != VK_SUCCESS) {
+                    return result;
+                }
+            }
+
+            for (uint32_t i = 0; i < pass->access_count; i++) {
+                const rg_access* a = &pass->accesses[i];
+                rg_resource* resource = &graph->resources[a->resource];
+                if (resource->queue != queue) {
+                    wait_other_queue(graph, resource, queue, access_stages(pass, a->access));
+                }
+            }
+        }
+
+        ve_command_buffer* cmd = queue_cmd(graph, queue);
+        if (!cmd) {
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+
+        for (uint32_t i = 0; i < pass->access_count; i++) {
+            const rg_access* a = &pass->accesses[i];
+            rg_resource* resource = &graph->resources[a->resource];
+            transition(&batch, resource, access_stages(pass, a->access), &g_access_info[a->access]);
+            resource->queue = queue;
+            resource->epoch = graph->epoch;
+        }
+        flush_barriers(graph, cmd, &batch);
+
+        if (pass->queue == VE_RENDER_GRAPH_QUEUE_GRAPHICS) {
+            ve_vulkan_begin_debug_label(cmd->buffer, pass->name, 0.2f, 0.6f, 1.0f);
+        } else {
+            ve_vulkan_begin_debug_label(cmd->buffer, pass->name, 1.0f, 0.6f, 0.2f);
+        }
+        pass->execute(graph, cmd, pass->user_data);
+        ve_vulkan_end_debug_label(cmd->buffer);
+
+        compute_used |= queue == VE_COMMAND_BUFFER_COMPUTE;
+    }
+
+    /* Leave imported images in the layout their owner expects, on the queue that used them last */
+    for (uint32_t q = 0; q < RG_QUEUE_COUNT; q++) {
+        for (uint32_t r = 0; r < graph->resource_count; r++) {
+            rg_resource* resource = &graph->resources[r];
+            if (!resource->imported || !resource->is_image || !resource->used ||
+                (graph->split && resource->queue != q) ||
+                resource->final_layout == VK_IMAGE_LAYOUT_UNDEFINED || resource->final_layout == resource->layout) {
+                continue;
+            }
+            add_barrier(&batch, resource, resource->write_stages | resource->read_stages, resource->write_access,
+                        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, resource->final_layout);
+            resource->layout = resource->final_layout;
+        }
+
+        if (batch.image_count > 0) {
+            ve_command_buffer* cmd = queue_cmd(graph, (ve_command_buffer_type)q);
+            if (!cmd) {
+                return VK_ERROR_OUT_OF_HOST_MEMORY;
+            }
+            flush_barriers(graph, cmd, &batch);
+        }
+    }
+
+    if (!graph->split) {
+        return VK_SUCCESS;
+    }
+
+    /* The wait still has to complete before the graphics batch signals, which is what frames wait for */
+    if (compute_used) {
+        if (graph->queues[VE_COMMAND_BUFFER_COMPUTE].has_work) {
+            ve_submit_wait_queue(VE_COMMAND_BUFFER_GRAPHICS, VE_COMMAND_BUFFER_COMPUTE,
+                                 VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT);
+        } else {
+            ve_submit_wait_semaphore(VE_COMMAND_BUFFER_GRAPHICS, ve_submit_get_timeline(VE_COMMAND_BUFFER_COMPUTE),
+                                     ve_submit_get_submitted_value(VE_COMMAND_BUFFER_COMPUTE),
+                                     VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT);
+        }
+    }
+
+    return close_queues(graph);
+}
+
+void ve_render_graph_execute(ve_render_graph* graph, ve_command_buffer* cmd) {
+    VE_ASSERT(graph && cmd && cmd->is_recording);
+    VE_ASSERT_MSG(graph->compiled, "Render graph must be compiled before it is executed");
+
+    graph->split = false;
+    graph->inline_cmd = cmd;
+    record(graph);
+    graph->inline_cmd = NULL;
+}
+
+VkResult ve_render_graph_submit(ve_render_graph* graph) {
+    VE_ASSERT(graph);
+    VE_ASSERT_MSG(graph->compiled, "Render graph must be compiled before it is submitted");
+
+    if (!ve_submit_is_enabled()) {
+        VE_LOG_ERROR("Render graph submission needs the submission batcher");
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    graph->split = true;
+    memset(graph->queues, 0, sizeof(graph->queues));
+
+    VkResult result = record(graph);
+    if (result != VK_SUCCESS) {
+        /* Whatever was begun is recycled with the frame's pools */
+        for (uint32_t q = 0; q < RG_QUEUE_COUNT; q++) {
+            if (graph->queues[q].cmd) {
+                ve_command_buffer_end(graph->queues[q].cmd);
+                graph->queues[q].cmd = NULL;
+            }
+        }
+    }
+    graph->split = false;
+    return result;
+}
+
+bool ve_render_graph_is_pass_live(const ve_render_graph* graph, ve_render_graph_handle pass) {
+    VE_ASSERT(graph);
+    return graph->compiled && pass < graph->pass_count && graph->passes[pass].live;
+}
+
+VkImage ve_render_graph_get_image(const ve_render_graph* graph, ve_render_graph_handle resource) {
+    VE_ASSERT(graph);
+    return resource < graph->resource_count ? graph->resources[resource].image : VK_NULL_HANDLE;
+}
+
+VkImageView ve_render_graph_get_image_view(const ve_render_graph* graph, ve_render_graph_handle resource) {
+    VE_ASSERT(graph);
+    return resource < graph->resource_count ? graph->resources[resource].view : VK_NULL_HANDLE;
+}
+
+VkBuffer ve_render_graph_get_buffer(const ve_render_graph* graph, ve_render_graph_handle resource) {
+    VE_ASSERT(graph);
+    return resource < graph->resource_count ? graph->resources[resource].buffer : VK_NULL_HANDLE;
+}
+
+VkImageLayout ve_render_graph_get_access_layout(ve_render_graph_access access) {
+    VE_ASSERT(access < VE_RENDER_GRAPH_ACCESS_COUNT);
+    return g_access_info[access].layout;
+}
+
+void ve_render_graph_get_stats(const ve_render_graph* graph, ve_render_graph_stats* stats) {
+    VE_ASSERT(graph && stats);
+
+    memset(stats, 0, sizeof(ve_render_graph_stats));
+    stats->pass_count = graph->pass_count;
+    stats->culled_passes = graph->culled_passes;
+    stats->memory_slots = graph->slot_count;
+    stats->unaliased_memory = graph->unaliased_memory;
+    stats->barriers = graph->barriers;
+    stats->barrier_batches = graph->barrier_batches;
+    stats->async_passes = graph->async_passes;
+    stats->queue_waits = graph->queue_waits;
+    stats->queue_flushes = graph->queue_flushes;
+
+    for (uint32_t r = 0; r < graph->resource_count; r++) {
+        if (!graph->resources[r].imported && graph->resources[r].used) {
+            stats->transient_resources++;
+        }
+    }
+    for (uint32_t s = 0; s < graph->slot_count; s++) {
+        stats->transient_memory += graph->slots[s].size;
+    }
+}
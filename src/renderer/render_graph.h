@@ -0,0 +1,370 @@
+/**
+ * @file render_graph.h
+ * @brief Frame render graph with automatic barriers and transient aliasing
+ *
+ * Passes declare the images and buffers they read and write instead of
+ * recording barriers by hand. Compiling the graph
+ *   - culls passes whose results are never read, unless they write an
+ *     imported resource or are marked as having side effects,
+ *   - computes the lifetime of every transient resource and places
+ *     transient resources whose lifetimes do not overlap in the same
+ *     memory,
+ *   - derives the usage flags of transient resources from their accesses.
+ * Executing it records each live pass with the smallest set of barriers
+ * its accesses need: one vkCmdPipelineBarrier per pass at most, none
+ * between passes that only read a resource in the same layout.
+ *
+ * The graph is declared and compiled once and executed every frame;
+ * declare and compile it again when something changes, e.g. on resize.
+ * Imported resources (such as the swapchain image) can be swapped between
+ * executions with ve_render_graph_update_image. Transient resources are
+ * shared by the frames in flight; the first barrier of each frame waits
+ * for the previous frame's last use of the same memory.
+ *
+ * ve_render_graph_submit records the graph into frame command buffers and
+ * runs async compute passes on ve_queues.compute, so they overlap graphics
+ * work such as shadow and G-buffer rasterization. Dependencies between
+ * the queues become waits on the submission batcher's timelines, at the
+ * stages that consume the results. If the queues would wait on each other's
+ * pending batches, the batches recorded so far are flushed first. Transient
+ * resources used on both queues are created with concurrent sharing when
+ * the queue families differ and never alias; imported resources used by
+ * async passes need concurrent sharing too.
+ *
+ * Passes that begin a VkRenderPass must create it with initial and final
+ * layouts equal to the layouts of their declared accesses (e.g.
+ * COLOR_ATTACHMENT_OPTIMAL), since the graph performs the transitions.
+ * Graphs are not thread-safe.
+ */
+
+#ifndef VE_RENDER_GRAPH_H
+#define VE_RENDER_GRAPH_H
+
+#include "vulkan_core.h"
+#include "command_buffer.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Graph limits */
+#define VE_RENDER_GRAPH_MAX_PASSES 64
+#define VE_RENDER_GRAPH_MAX_RESOURCES 128
+#define VE_RENDER_GRAPH_MAX_PASS_ACCESSES 16
+#define VE_RENDER_GRAPH_MAX_NAME 32
+
+/* Returned when a declaration fails */
+#define VE_RENDER_GRAPH_INVALID UINT32_MAX
+
+typedef struct ve_render_graph ve_render_graph;
+
+/* Index of a resource or pass in its graph */
+typedef uint32_t ve_render_graph_handle;
+
+/**
+ * @brief Queue a pass is meant for
+ */
+typedef enum ve_render_graph_queue {
+    VE_RENDER_GRAPH_QUEUE_GRAPHICS,
+    VE_RENDER_GRAPH_QUEUE_COMPUTE,          /* Compute work on the graphics queue */
+    VE_RENDER_GRAPH_QUEUE_ASYNC_COMPUTE,    /* Compute queue under ve_render_graph_submit, when available */
+} ve_render_graph_queue;
+
+/**
+ * @brief How a pass uses a resource
+ *
+ * Shader accesses happen in the vertex and fragment stages of graphics
+ * passes and in the compute stage of compute passes.
+ */
+typedef enum ve_render_graph_access {
+    VE_RENDER_GRAPH_ACCESS_COLOR_ATTACHMENT,    /* Write */
+    VE_RENDER_GRAPH_ACCESS_DEPTH_ATTACHMENT,    /* Write, depth test and depth writes */
+    VE_RENDER_GRAPH_ACCESS_DEPTH_READ,          /* Depth test without depth writes */
+    VE_RENDER_GRAPH_ACCESS_INPUT_ATTACHMENT,
+    VE_RENDER_GRAPH_ACCESS_SAMPLED,
+    VE_RENDER_GRAPH_ACCESS_STORAGE_READ,
+    VE_RENDER_GRAPH_ACCESS_STORAGE_WRITE,       /* Write, also allows reads */
+    VE_RENDER_GRAPH_ACCESS_UNIFORM,             /* Buffers only */
+    VE_RENDER_GRAPH_ACCESS_VERTEX_INPUT,        /* Vertex and index buffers */
+    VE_RENDER_GRAPH_ACCESS_INDIRECT,            /* Indirect draw and dispatch arguments */
+    VE_RENDER_GRAPH_ACCESS_TRANSFER_SRC,
+    VE_RENDER_GRAPH_ACCESS_TRANSFER_DST,        /* Write */
+    VE_RENDER_GRAPH_ACCESS_COUNT
+} ve_render_graph_access;
+
+/**
+ * @brief Transient image, owned by the graph
+ */
+typedef struct ve_render_graph_image_desc {
+    uint32_t width;
+    uint32_t height;
+    VkFormat format;
+    VkImageAspectFlags aspect;      /* Zero for color */
+} ve_render_graph_image_desc;
+
+/**
+ * @brief Image owned outside the graph
+ */
+typedef struct ve_render_graph_image_import {
+    VkImage image;
+    VkImageView view;
+    VkFormat format;
+    VkExtent2D extent;
+    VkImageAspectFlags aspect;      /* Zero for color */
+    VkImageLayout initial_layout;   /* Layout at the start of every execution */
+    VkImageLayout final_layout;     /* Layout to leave it in, UNDEFINED to keep the last one */
+} ve_render_graph_image_import;
+
+/**
+ * @brief Records the commands of a pass
+ *
+ * @param graph Graph being executed, for looking up resource handles
+ * @param cmd Command buffer, with the pass's barriers already recorded
+ * @param user_data User data given to ve_render_graph_add_pass
+ */
+typedef void (*ve_render_graph_execute_fn)(ve_render_graph* graph, ve_command_buffer* cmd, void* user_data);
+
+/**
+ * @brief Render graph statistics
+ */
+typedef struct ve_render_graph_stats {
+    uint32_t pass_count;
+    uint32_t culled_passes;
+    uint32_t transient_resources;
+    uint32_t memory_slots;              /* Allocations shared by aliased resources */
+    VkDeviceSize transient_memory;      /* Bytes allocated for transient resources */
+    VkDeviceSize unaliased_memory;      /* Bytes they would take without aliasing */
+    uint32_t barriers;                  /* Image and buffer barriers of the last execution */
+    uint32_t barrier_batches;           /* vkCmdPipelineBarrier calls of the last execution */
+    uint32_t async_passes;              /* Live passes running on the compute queue */
+    uint32_t queue_waits;               /* Cross-queue waits of the last submission */
+    uint32_t queue_flushes;             /* Extra batcher flushes of the last submission */
+} ve_render_graph_stats;
+
+/**
+ * @brief Create an empty graph
+ *
+ * @return Graph or NULL
+ */
+ve_render_graph* ve_render_graph_create(void);
+
+/**
+ * @brief Destroy a graph and its transient resources
+ *
+ * Transient resources are released once the current frame has completed
+ * on the GPU.
+ *
+ * @param graph Graph to destroy
+ */
+void ve_render_graph_destroy(ve_render_graph* graph);
+
+/**
+ * @brief Remove every pass and resource so the graph can be declared again
+ *
+ * Transient resources are released once the current frame has completed
+ * on the GPU.
+ *
+ * @param graph Graph
+ */
+void ve_render_graph_reset(ve_render_graph* graph);
+
+/**
+ * @brief Declare a transient image
+ *
+ * @param graph Graph
+ * @param name Debug name
+ * @param desc Image description
+ * @return Resource handle or VE_RENDER_GRAPH_INVALID
+ */
+ve_render_graph_handle ve_render_graph_create_image(ve_render_graph* graph, const char* name,
+                                                    const ve_render_graph_image_desc* desc);
+
+/**
+ * @brief Declare a transient buffer
+ *
+ * @param graph Graph
+ * @param name Debug name
+ * @param size Size in bytes
+ * @return Resource handle or VE_RENDER_GRAPH_INVALID
+ */
+ve_render_graph_handle ve_render_graph_create_buffer(ve_render_graph* graph, const char* name, VkDeviceSize size);
+
+/**
+ * @brief Declare an image owned outside the graph
+ *
+ * Passes writing imported resources are never culled. The first access of
+ * each execution waits for all earlier work on the queue.
+ *
+ * @param graph Graph
+ * @param name Debug name
+ * @param import Image and its layouts
+ * @return Resource handle or VE_RENDER_GRAPH_INVALID
+ */
+ve_render_graph_handle ve_render_graph_import_image(ve_render_graph* graph, const char* name,
+                                                    const ve_render_graph_image_import* import);
+
+/**
+ * @brief Declare a buffer owned outside the graph
+ *
+ * @param graph Graph
+ * @param name Debug name
+ * @param buffer Buffer
+ * @param size Size in bytes
+ * @return Resource handle or VE_RENDER_GRAPH_INVALID
+ */
+ve_render_graph_handle ve_render_graph_import_buffer(ve_render_graph* graph, const char* name,
+                                                     VkBuffer buffer, VkDeviceSize size);
+
+/**
+ * @brief Point an imported image at another image, e.g. this frame's swapchain image
+ *
+ * @param graph Graph
+ * @param resource Imported image
+ * @param image New image, with the same format, extent and layouts
+ * @param view New view
+ */
+void ve_render_graph_update_image(ve_render_graph* graph, ve_render_graph_handle resource,
+                                  VkImage image, VkImageView view);
+
+/**
+ * @brief Point an imported buffer at another buffer, e.g. this frame's copy
+ *
+ * @param graph Graph
+ * @param resource Imported buffer
+ * @param buffer New buffer
+ */
+void ve_render_graph_update_buffer(ve_render_graph* graph, ve_render_graph_handle resource, VkBuffer buffer);
+
+/**
+ * @brief Add a pass
+ *
+ * Passes execute in the order they are added.
+ *
+ * @param graph Graph
+ * @param name Debug label of the pass
+ * @param queue Queue the pass is meant for
+ * @param execute Records the pass
+ * @param user_data User data for execute
+ * @return Pass handle or VE_RENDER_GRAPH_INVALID
+ */
+ve_render_graph_handle ve_render_graph_add_pass(ve_render_graph* graph, const char* name,
+                                                ve_render_graph_queue queue,
+                                                ve_render_graph_execute_fn execute, void* user_data);
+
+/**
+ * @brief Declare that a pass accesses a resource
+ *
+ * @param graph Graph
+ * @param pass Pass handle
+ * @param resource Resource handle
+ * @param access How the pass uses it
+ * @return true on success, false if the pass has too many accesses or the access does not fit the resource
+ */
+bool ve_render_graph_use(ve_render_graph* graph, ve_render_graph_handle pass,
+                         ve_render_graph_handle resource, ve_render_graph_access access);
+
+/**
+ * @brief Keep a pass even if none of its results are read
+ *
+ * @param graph Graph
+ * @param pass Pass handle
+ */
+void ve_render_graph_set_side_effects(ve_render_graph* graph, ve_render_graph_handle pass);
+
+/**
+ * @brief Cull passes, size and alias transient resources
+ *
+ * Transient resources of an earlier compile are released once the current
+ * frame has completed on the GPU.
+ *
+ * @param graph Graph
+ * @return VK_SUCCESS on success
+ */
+VkResult ve_render_graph_compile(ve_render_graph* graph);
+
+/**
+ * @brief Record every live pass with its barriers
+ *
+ * Async compute passes are recorded inline too.
+ *
+ * @param graph Compiled graph
+ * @param cmd Recording command buffer
+ */
+void ve_render_graph_execute(ve_render_graph* graph, ve_command_buffer* cmd);
+
+/**
+ * @brief Record every live pass into frame command buffers and queue them
+ *
+ * Async compute passes go to the compute queue when the device has a
+ * separate one and the submission batcher is enabled, otherwise everything
+ * is recorded on the graphics queue. The command buffers are added to the
+ * batcher; the caller adds swapchain waits and signals and flushes it.
+ * The graphics batch waits for the frame's compute work, so completing
+ * the frame's graphics work completes its compute work too. Call from the
+ * thread that records the frame.
+ *
+ * @param graph Compiled graph
+ * @return VK_SUCCESS on success
+ */
+VkResult ve_render_graph_submit(ve_render_graph* graph);
+
+/**
+ * @brief Check if a pass survived culling
+ *
+ * @param graph Compiled graph
+ * @param pass Pass handle
+ * @return true if the pass is executed
+ */
+bool ve_render_graph_is_pass_live(const ve_render_graph* graph, ve_render_graph_handle pass);
+
+/**
+ * @brief Get the image of a resource
+ *
+ * @param graph Compiled graph
+ * @param resource Image resource
+ * @return Image or VK_NULL_HANDLE
+ */
+VkImage ve_render_graph_get_image(const ve_render_graph* graph, ve_render_graph_handle resource);
+
+/**
+ * @brief Get the view of an image resource
+ *
+ * @param graph Compiled graph
+ * @param resource Image resource
+ * @return View or VK_NULL_HANDLE
+ */
+VkImageView ve_render_graph_get_image_view(const ve_render_graph* graph, ve_render_graph_handle resource);
+
+/**
+ * @brief Get the buffer of a resource
+ *
+ * @param graph Compiled graph
+ * @param resource Buffer resource
+ * @return Buffer or VK_NULL_HANDLE
+ */
+VkBuffer ve_render_graph_get_buffer(const ve_render_graph* graph, ve_render_graph_handle resource);
+
+/**
+ * @brief Get the layout an access puts an image in
+ *
+ * For creating render passes whose layouts match the graph's.
+ *
+ * @param access Access
+ * @return Image layout
+ */
+VkImageLayout ve_render_graph_get_access_layout(ve_render_graph_access access);
+
+/**
+ * @brief Get graph statistics
+ *
+ * @param graph Graph
+ * @param stats Output statistics
+ */
+void ve_render_graph_get_stats(const ve_render_graph* graph, ve_render_graph_stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_RENDER_GRAPH_H */
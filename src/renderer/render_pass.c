@@ -3,10 +3,13 @@
  * @brief Vulkan render pass management implementation
  */
 
+#define VK_NO_PROTOTYPES
 #include "render_pass.h"
 #include "../core/logger.h"
 #include "../core/assert.h"
-#include "../memory/memory.h"
+#include "../core/memory.h"
+
+#include <string.h>
 
 VkResult ve_render_pass_create_basic(VkFormat color_format, VkFormat depth_format, VkRenderPass* render_pass) {
     ve_vulkan_context* vk = ve_vulkan_get_context();
@@ -80,6 +83,339 @@ VkResult ve_render_pass_create_basic(VkFormat color_format, VkFormat depth_forma
     return vkCreateRenderPass(vk->device, &create_info, NULL, render_pass);
 }
 
+VkFormat ve_render_pass_get_gbuffer_normal_format(void) {
+    /* RG16 is not a required color attachment format, RGB10A2 is */
+    if (ve_vulkan_is_format_supported(VE_GBUFFER_NORMAL_FORMAT, VK_IMAGE_TILING_OPTIMAL,
+                                      VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)) {
+        return VE_GBUFFER_NORMAL_FORMAT;
+    }
+    return VE_GBUFFER_NORMAL_FALLBACK_FORMAT;
+}
+
+VkResult ve_render_pass_create_gbuffer(VkFormat depth_format, VkRenderPass* render_pass) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VE_ASSERT(vk && vk->device && render_pass);
+
+    const VkFormat color_formats[VE_GBUFFER_COLOR_ATTACHMENT_COUNT] = {
+        ve_render_pass_get_gbuffer_normal_format(),
+        VE_GBUFFER_ALBEDO_FORMAT,
+        VE_GBUFFER_MATERIAL_FORMAT,
+    };
+
+    VkAttachmentDescription attachments[VE_GBUFFER_COLOR_ATTACHMENT_COUNT + 1];
+    VkAttachmentReference color_references[VE_GBUFFER_COLOR_ATTACHMENT_COUNT];
+
+    /* Every pixel is written, so the previous contents are never loaded */
+    for (uint32_t i = 0; i < VE_GBUFFER_COLOR_ATTACHMENT_COUNT; i++) {
+        attachments[i] = (VkAttachmentDescription){
+            .format = color_formats[i],
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        };
+        color_references[i] = (VkAttachmentReference){
+            .attachment = i,
+            .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        };
+    }
+
+    /* Depth replaces the position target, so it is stored */
+    attachments[VE_GBUFFER_COLOR_ATTACHMENT_COUNT] = (VkAttachmentDescription){
+        .format = depth_format,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+        .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+    };
+
+    VkAttachmentReference depth_reference = {
+        .attachment = VE_GBUFFER_COLOR_ATTACHMENT_COUNT,
+        .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+    };
+
+    VkSubpassDescription subpass = {
+        .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+        .colorAttachmentCount = VE_GBUFFER_COLOR_ATTACHMENT_COUNT,
+        .pColorAttachments = color_references,
+        .pDepthStencilAttachment = &depth_reference,
+    };
+
+    VkSubpassDependency dependencies[2] = {
+        /* Previous frame's lighting pass has finished reading the targets */
+        {
+            .srcSubpass = VK_SUBPASS_EXTERNAL,
+            .dstSubpass = 0,
+            .srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+            .srcAccessMask = 0,
+            .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+        },
+        /* Lighting samples the targets once they are written */
+        {
+            .srcSubpass = 0,
+            .dstSubpass = VK_SUBPASS_EXTERNAL,
+            .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+        },
+    };
+
+    VkRenderPassCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+        .attachmentCount = VE_GBUFFER_COLOR_ATTACHMENT_COUNT + 1,
+        .pAttachments = attachments,
+        .subpassCount = 1,
+        .pSubpasses = &subpass,
+        .dependencyCount = 2,
+        .pDependencies = dependencies,
+    };
+
+    VkResult result = vkCreateRenderPass(vk->device, &create_info, NULL, render_pass);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to create G-buffer render pass: %d", result);
+        return result;
+    }
+
+    VE_VK_SET_OBJECT_NAME(*render_pass, VK_OBJECT_TYPE_RENDER_PASS, "gbuffer_pass");
+    return VK_SUCCESS;
+}
+
+VkResult ve_render_pass_create_deferred(VkFormat color_format, VkFormat depth_format, VkRenderPass* render_pass) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VE_ASSERT(vk && vk->device && render_pass);
+
+    const VkFormat gbuffer_formats[VE_GBUFFER_COLOR_ATTACHMENT_COUNT] = {
+        ve_render_pass_get_gbuffer_normal_format(),
+        VE_GBUFFER_ALBEDO_FORMAT,
+        VE_GBUFFER_MATERIAL_FORMAT,
+    };
+
+    VkAttachmentDescription attachments[VE_DEFERRED_ATTACHMENT_COUNT];
+
+    /* The lighting subpass writes every pixel, so nothing is loaded */
+    attachments[0] = (VkAttachmentDescription){
+        .format = color_format,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+        .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+    };
+
+    /* The G-buffer only lives inside the pass and is never written back */
+    for (uint32_t i = 0; i < VE_GBUFFER_COLOR_ATTACHMENT_COUNT; i++) {
+        attachments[1 + i] = (VkAttachmentDescription){
+            .format = gbuffer_formats[i],
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        };
+    }
+
+    attachments[VE_DEFERRED_ATTACHMENT_COUNT - 1] = (VkAttachmentDescription){
+        .format = depth_format,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+        .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+    };
+
+    /* G-buffer subpass */
+    VkAttachmentReference gbuffer_references[VE_GBUFFER_COLOR_ATTACHMENT_COUNT];
+    for (uint32_t i = 0; i < VE_GBUFFER_COLOR_ATTACHMENT_COUNT; i++) {
+        gbuffer_references[i] = (VkAttachmentReference){
+            .attachment = 1 + i,
+            .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        };
+    }
+
+    VkAttachmentReference depth_reference = {
+        .attachment = VE_DEFERRED_ATTACHMENT_COUNT - 1,
+        .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+    };
+
+    /* Lighting subpass, input order matches the sampled G-buffer bindings */
+    VkAttachmentReference input_references[VE_GBUFFER_COLOR_ATTACHMENT_COUNT + 1];
+    input_references[0] = (VkAttachmentReference){
+        .attachment = VE_DEFERRED_ATTACHMENT_COUNT - 1,
+        .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+    };
+    for (uint32_t i = 0; i < VE_GBUFFER_COLOR_ATTACHMENT_COUNT; i++) {
+        input_references[1 + i] = (VkAttachmentReference){
+            .attachment = 1 + i,
+            .layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        };
+    }
+
+    VkAttachmentReference color_reference = {
+        .attachment = 0,
+        .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+    };
+
+    VkSubpassDescription subpasses[2] = {
+        [VE_DEFERRED_SUBPASS_GBUFFER] = {
+            .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+            .colorAttachmentCount = VE_GBUFFER_COLOR_ATTACHMENT_COUNT,
+            .pColorAttachments = gbuffer_references,
+            .pDepthStencilAttachment = &depth_reference,
+        },
+        [VE_DEFERRED_SUBPASS_LIGHTING] = {
+            .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+            .inputAttachmentCount = VE_GBUFFER_COLOR_ATTACHMENT_COUNT + 1,
+            .pInputAttachments = input_references,
+            .colorAttachmentCount = 1,
+            .pColorAttachments = &color_reference,
+        },
+    };
+
+    VkSubpassDependency dependencies[3] = {
+        /* Previous frame's lighting has finished reading the G-buffer */
+        {
+            .srcSubpass = VK_SUBPASS_EXTERNAL,
+            .dstSubpass = VE_DEFERRED_SUBPASS_GBUFFER,
+            .srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+            .srcAccessMask = 0,
+            .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+        },
+        /* Swapchain image is acquired before lighting writes it */
+        {
+            .srcSubpass = VK_SUBPASS_EXTERNAL,
+            .dstSubpass = VE_DEFERRED_SUBPASS_LIGHTING,
+            .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            .srcAccessMask = 0,
+            .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+        },
+        /* Each pixel reads only its own G-buffer texel, so the dependency stays on tile */
+        {
+            .srcSubpass = VE_DEFERRED_SUBPASS_GBUFFER,
+            .dstSubpass = VE_DEFERRED_SUBPASS_LIGHTING,
+            .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,
+            .dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT,
+        },
+    };
+
+    VkRenderPassCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+        .attachmentCount = VE_DEFERRED_ATTACHMENT_COUNT,
+        .pAttachments = attachments,
+        .subpassCount = 2,
+        .pSubpasses = subpasses,
+        .dependencyCount = 3,
+        .pDependencies = dependencies,
+    };
+
+    VkResult result = vkCreateRenderPass(vk->device, &create_info, NULL, render_pass);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to create deferred render pass: %d", result);
+        return result;
+    }
+
+    VE_VK_SET_OBJECT_NAME(*render_pass, VK_OBJECT_TYPE_RENDER_PASS, "deferred_pass");
+    return VK_SUCCESS;
+}
+
+VkResult ve_render_pass_create_deferred_targets(uint32_t width, uint32_t height, VkFormat depth_format,
+                                                ve_deferred_targets* targets) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VE_ASSERT(vk && vk->device && targets);
+
+    memset(targets, 0, sizeof(ve_deferred_targets));
+
+    const VkFormat formats[VE_GBUFFER_COLOR_ATTACHMENT_COUNT] = {
+        ve_render_pass_get_gbuffer_normal_format(),
+        VE_GBUFFER_ALBEDO_FORMAT,
+        VE_GBUFFER_MATERIAL_FORMAT,
+    };
+    static const char* names[VE_GBUFFER_COLOR_ATTACHMENT_COUNT] = {
+        "gbuffer_normal", "gbuffer_albedo", "gbuffer_material",
+    };
+
+    /* Transient images may only be used as attachments */
+    const VkImageUsageFlags transient = VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+
+    for (uint32_t i = 0; i <= VE_GBUFFER_COLOR_ATTACHMENT_COUNT; i++) {
+        bool is_depth = i == VE_GBUFFER_COLOR_ATTACHMENT_COUNT;
+        ve_image_config config = {
+            .width = width,
+            .height = height,
+            .format = is_depth ? depth_format : formats[i],
+            .usage = transient | (is_depth ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
+                                           : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT),
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .aspect = is_depth ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT,
+            .memory_usage = VE_GPU_MEMORY_USAGE_GPU_LAZY,
+            .debug_name = is_depth ? "gbuffer_depth" : names[i],
+        };
+
+        ve_image* image = is_depth ? &targets->depth : &targets->color[i];
+        VkResult result = ve_image_create(&config, image);
+        if (result != VK_SUCCESS) {
+            VE_LOG_ERROR("Failed to create deferred target %s: %d", config.debug_name, result);
+            ve_render_pass_destroy_deferred_targets(targets);
+            return result;
+        }
+    }
+
+    const VkPhysicalDeviceMemoryProperties* memory = &vk->device_properties.memory_properties;
+    targets->lazily_allocated = true;
+    for (uint32_t i = 0; i <= VE_GBUFFER_COLOR_ATTACHMENT_COUNT; i++) {
+        const ve_image* image = i == VE_GBUFFER_COLOR_ATTACHMENT_COUNT ? &targets->depth : &targets->color[i];
+        if (!(memory->memoryTypes[image->allocation.memory_type].propertyFlags &
+              VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)) {
+            targets->lazily_allocated = false;
+        }
+    }
+
+    VE_LOG_DEBUG("Deferred targets %ux%u created (%s memory)", width, height,
+                 targets->lazily_allocated ? "lazily allocated" : "device local");
+    return VK_SUCCESS;
+}
+
+void ve_render_pass_destroy_deferred_targets(ve_deferred_targets* targets) {
+    if (!targets) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < VE_GBUFFER_COLOR_ATTACHMENT_COUNT; i++) {
+        ve_image_destroy(&targets->color[i]);
+    }
+    ve_image_destroy(&targets->depth);
+    targets->lazily_allocated = false;
+}
+
+void ve_render_pass_get_deferred_views(const ve_deferred_targets* targets, VkImageView swapchain_view,
+                                       VkImageView views[VE_DEFERRED_ATTACHMENT_COUNT]) {
+    VE_ASSERT(targets && views);
+
+    views[0] = swapchain_view;
+    for (uint32_t i = 0; i < VE_GBUFFER_COLOR_ATTACHMENT_COUNT; i++) {
+        views[1 + i] = targets->color[i].view;
+    }
+    views[VE_DEFERRED_ATTACHMENT_COUNT - 1] = targets->depth.view;
+}
+
 void ve_render_pass_destroy(VkRenderPass render_pass) {
     ve_vulkan_context* vk = ve_vulkan_get_context();
     if (vk && vk->device && render_pass != VK_NULL_HANDLE) {
@@ -7,12 +7,51 @@
 #define VE_RENDER_PASS_H
 
 #include "vulkan_core.h"
+#include "image.h"
 #include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/*
+ * Compact G-buffer: three color targets plus depth. Position is not stored;
+ * the lighting pass rebuilds it from depth and the inverse view-projection.
+ * Normals are octahedral-encoded into two channels.
+ *   attachment 0: normal (VE_GBUFFER_NORMAL_FORMAT, or the RGB10A2 fallback)
+ *   attachment 1: albedo (RGBA8 sRGB)
+ *   attachment 2: roughness, metallic, ao (RGBA8)
+ *   attachment 3: depth, stored and left readable for the lighting pass
+ */
+#define VE_GBUFFER_COLOR_ATTACHMENT_COUNT 3
+#define VE_GBUFFER_NORMAL_FORMAT VK_FORMAT_R16G16_UNORM
+#define VE_GBUFFER_NORMAL_FALLBACK_FORMAT VK_FORMAT_A2B10G10R10_UNORM_PACK32
+#define VE_GBUFFER_ALBEDO_FORMAT VK_FORMAT_R8G8B8A8_SRGB
+#define VE_GBUFFER_MATERIAL_FORMAT VK_FORMAT_R8G8B8A8_UNORM
+
+/*
+ * Deferred render pass: the G-buffer and lighting are two subpasses of one
+ * pass, and lighting reads the G-buffer through input attachments at the
+ * pixel it shades. The G-buffer never leaves the pass, so it is not stored
+ * and can live in transient, lazily allocated images; tiled GPUs keep it in
+ * tile memory, desktop GPUs skip the store and the reload.
+ *   attachment 0: swapchain color, written by the lighting subpass
+ *   attachments 1-3: normal, albedo, material (input attachments 1-3)
+ *   attachment 4: depth (input attachment 0)
+ */
+#define VE_DEFERRED_ATTACHMENT_COUNT (VE_GBUFFER_COLOR_ATTACHMENT_COUNT + 2)
+#define VE_DEFERRED_SUBPASS_GBUFFER 0
+#define VE_DEFERRED_SUBPASS_LIGHTING 1
+
+/**
+ * @brief Transient G-buffer images of the deferred render pass
+ */
+typedef struct ve_deferred_targets {
+    ve_image color[VE_GBUFFER_COLOR_ATTACHMENT_COUNT];  /* Normal, albedo, material */
+    ve_image depth;
+    bool lazily_allocated;      /* Every target got lazily allocated memory */
+} ve_deferred_targets;
+
 /* TODO: Implement render pass management */
 typedef struct ve_render_pass {
     VkRenderPass pass;
@@ -26,6 +65,75 @@ typedef struct ve_render_pass {
  */
 VkResult ve_render_pass_create_basic(VkFormat color_format, VkFormat depth_format, VkRenderPass* render_pass);
 
+/**
+ * @brief Get the normal target format of the G-buffer
+ *
+ * @return VE_GBUFFER_NORMAL_FORMAT if it can be rendered to, else the RGB10A2 fallback
+ */
+VkFormat ve_render_pass_get_gbuffer_normal_format(void);
+
+/**
+ * @brief Create the G-buffer render pass
+ *
+ * Color targets end in SHADER_READ_ONLY_OPTIMAL and depth in
+ * DEPTH_STENCIL_READ_ONLY_OPTIMAL, ready to be sampled by the lighting pass.
+ *
+ * @param depth_format Depth format (the image needs VK_IMAGE_USAGE_SAMPLED_BIT)
+ * @param render_pass Output render pass
+ * @return VK_SUCCESS on success
+ */
+VkResult ve_render_pass_create_gbuffer(VkFormat depth_format, VkRenderPass* render_pass);
+
+/**
+ * @brief Create the deferred render pass
+ *
+ * Subpass VE_DEFERRED_SUBPASS_GBUFFER writes attachments 1-4 and subpass
+ * VE_DEFERRED_SUBPASS_LIGHTING reads them as input attachments and writes
+ * attachment 0, which ends in PRESENT_SRC_KHR. The G-buffer is cleared and
+ * discarded at the end of the pass. Framebuffers take the swapchain view
+ * followed by the views of ve_deferred_targets in attachment order.
+ *
+ * @param color_format Swapchain format
+ * @param depth_format Depth format
+ * @param render_pass Output render pass
+ * @return VK_SUCCESS on success
+ */
+VkResult ve_render_pass_create_deferred(VkFormat color_format, VkFormat depth_format, VkRenderPass* render_pass);
+
+/**
+ * @brief Create the G-buffer images of the deferred render pass
+ *
+ * The images are transient input attachments and use lazily allocated
+ * memory where the device has it. Recreate them on resize.
+ *
+ * @param width Width in pixels
+ * @param height Height in pixels
+ * @param depth_format Depth format
+ * @param targets Output targets
+ * @return VK_SUCCESS on success
+ */
+VkResult ve_render_pass_create_deferred_targets(uint32_t width, uint32_t height, VkFormat depth_format,
+                                                ve_deferred_targets* targets);
+
+/**
+ * @brief Destroy the G-buffer images of the deferred render pass
+ *
+ * The GPU must be done with them.
+ *
+ * @param targets Targets to destroy, cleared on return
+ */
+void ve_render_pass_destroy_deferred_targets(ve_deferred_targets* targets);
+
+/**
+ * @brief Fill the framebuffer attachments of the deferred render pass
+ *
+ * @param targets G-buffer images
+ * @param swapchain_view Swapchain image view
+ * @param views Output views in attachment order
+ */
+void ve_render_pass_get_deferred_views(const ve_deferred_targets* targets, VkImageView swapchain_view,
+                                       VkImageView views[VE_DEFERRED_ATTACHMENT_COUNT]);
+
 /**
  * @brief Destroy render pass
  */
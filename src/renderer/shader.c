@@ -3,6 +3,170 @@
  * @brief Vulkan shader compilation and reflection implementation
  */
 
+#define VK_NO_PROTOTYPES
 #include "shader.h"
 
-/* TODO: Implement shader management */
+#include "../core/logger.h"
+#include "../core/assert.h"
+#include "../core/memory.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* First word of every SPIR-V module */
+#define VE_SPIRV_MAGIC 0x07230203u
+
+uint32_t* ve_shader_load_spirv(const char* path, size_t* size) {
+    VE_ASSERT(path && size);
+
+    *size = 0;
+
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        VE_LOG_ERROR("Failed to open shader: %s", path);
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    if (length < 4 || (length % 4) != 0) {
+        VE_LOG_ERROR("Invalid SPIR-V size %ld: %s", length, path);
+        fclose(file);
+        return NULL;
+    }
+
+    uint32_t* code = (uint32_t*)VE_ALLOCATE_TAG((size_t)length, VE_MEMORY_TAG_RENDERER);
+    if (!code) {
+        fclose(file);
+        return NULL;
+    }
+
+    size_t read = fread(code, 1, (size_t)length, file);
+    fclose(file);
+
+    if (read != (size_t)length || code[0] != VE_SPIRV_MAGIC) {
+        VE_LOG_ERROR("Invalid SPIR-V: %s", path);
+        VE_FREE(code);
+        return NULL;
+    }
+
+    *size = (size_t)length;
+    return code;
+}
+
+VkResult ve_shader_create_module(const uint32_t* code, size_t size, VkShaderModule* module) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VE_ASSERT(vk && vk->device && code && module);
+
+    VkShaderModuleCreateInfo module_info = {
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .codeSize = size,
+        .pCode = code,
+    };
+
+    VkResult result = vkCreateShaderModule(vk->device, &module_info, NULL, module);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to create shader module: %d", result);
+    }
+    return result;
+}
+
+VkResult ve_shader_load_module(const char* path, VkShaderModule* module) {
+    size_t size = 0;
+    uint32_t* code = ve_shader_load_spirv(path, &size);
+    if (!code) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    VkResult result = ve_shader_create_module(code, size, module);
+    VE_FREE(code);
+
+    if (result == VK_SUCCESS) {
+        VE_VK_SET_OBJECT_NAME(*module, VK_OBJECT_TYPE_SHADER_MODULE, path);
+    }
+    return result;
+}
+
+void ve_shader_destroy_module(VkShaderModule module) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+
+    if (vk && vk->device && module != VK_NULL_HANDLE) {
+        vkDestroyShaderModule(vk->device, module, NULL);
+    }
+}
+
+void ve_shader_permutation_init(ve_shader_permutation* permutation) {
+    VE_ASSERT(permutation);
+    memset(permutation, 0, sizeof(ve_shader_permutation));
+}
+
+void ve_shader_permutation_set(ve_shader_permutation* permutation, uint32_t constant_id, uint32_t value) {
+    VE_ASSERT(permutation);
+
+    /* Keep entries sorted by id; values are laid out in entry order */
+    uint32_t index = 0;
+    while (index < permutation->count && permutation->entries[index].constantID < constant_id) {
+        index++;
+    }
+
+    if (index < permutation->count && permutation->entries[index].constantID == constant_id) {
+        permutation->values[index] = value;
+        return;
+    }
+
+    VE_ASSERT_MSG(permutation->count < VE_SHADER_MAX_CONSTANTS, "Too many specialization constants");
+    if (permutation->count >= VE_SHADER_MAX_CONSTANTS) {
+        return;
+    }
+
+    for (uint32_t i = permutation->count; i > index; i--) {
+        permutation->values[i] = permutation->values[i - 1];
+        permutation->entries[i] = permutation->entries[i - 1];
+        permutation->entries[i].offset = i * (uint32_t)sizeof(uint32_t);
+    }
+
+    permutation->values[index] = value;
+    permutation->entries[index] = (VkSpecializationMapEntry){
+        .constantID = constant_id,
+        .offset = index * (uint32_t)sizeof(uint32_t),
+        .size = sizeof(uint32_t),
+    };
+    permutation->count++;
+}
+
+void ve_shader_permutation_set_bool(ve_shader_permutation* permutation, uint32_t constant_id, bool value) {
+    /* SPIR-V bool constants are specialized with a VkBool32 */
+    ve_shader_permutation_set(permutation, constant_id, value ? VK_TRUE : VK_FALSE);
+}
+
+const VkSpecializationInfo* ve_shader_permutation_get_info(ve_shader_permutation* permutation) {
+    VE_ASSERT(permutation);
+
+    if (permutation->count == 0) {
+        return NULL;
+    }
+
+    permutation->info = (VkSpecializationInfo){
+        .mapEntryCount = permutation->count,
+        .pMapEntries = permutation->entries,
+        .dataSize = permutation->count * sizeof(uint32_t),
+        .pData = permutation->values,
+    };
+    return &permutation->info;
+}
+
+void ve_shader_permutation_gbuffer(ve_shader_permutation* permutation, uint32_t features) {
+    ve_shader_permutation_init(permutation);
+
+    /* Every constant is set, so equal feature sets give identical specialization data */
+    for (uint32_t i = 0; i < VE_GBUFFER_FEATURE_COUNT; i++) {
+        ve_shader_permutation_set_bool(permutation, i, (features & (1u << i)) != 0);
+    }
+}
+
+void ve_shader_permutation_lighting(ve_shader_permutation* permutation, ve_lighting_debug_mode mode) {
+    ve_shader_permutation_init(permutation);
+    ve_shader_permutation_set(permutation, 0, (uint32_t)mode);
+}
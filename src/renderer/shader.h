@@ -1,18 +1,153 @@
 /**
  * @file shader.h
  * @brief Vulkan shader compilation and reflection
+ *
+ * Shaders are compiled to SPIR-V at build time by the CMake shaders target
+ * and loaded from disk as shader modules.
+ *
+ * Variants are selected with specialization constants instead of runtime
+ * branches on push constants: a permutation holds the constant values of
+ * one variant, and passing its VkSpecializationInfo to the pipeline
+ * registry yields one pipeline per distinct permutation. The driver folds
+ * the constants, so disabled features cost no ALU or registers.
  */
 
 #ifndef VE_SHADER_H
 #define VE_SHADER_H
 
 #include "vulkan_core.h"
+#include <stdbool.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* TODO: Implement shader management */
+/* Most specialization constants in one permutation */
+#define VE_SHADER_MAX_CONSTANTS 16
+
+/**
+ * @brief Material features of gbuffer.frag, one specialization constant each
+ */
+typedef enum ve_gbuffer_feature {
+    VE_GBUFFER_ALBEDO_MAP = 1 << 0,         /* constant_id 0 */
+    VE_GBUFFER_ROUGHNESS_MAP = 1 << 1,      /* constant_id 1 */
+    VE_GBUFFER_METALLIC_MAP = 1 << 2,       /* constant_id 2 */
+    VE_GBUFFER_AO_MAP = 1 << 3,             /* constant_id 3 */
+    VE_GBUFFER_FEATURE_COUNT = 4
+} ve_gbuffer_feature;
+
+/**
+ * @brief Output modes of lighting.frag (constant_id 0)
+ */
+typedef enum ve_lighting_debug_mode {
+    VE_LIGHTING_FINAL,
+    VE_LIGHTING_POSITION,
+    VE_LIGHTING_NORMAL,
+    VE_LIGHTING_ALBEDO,
+    VE_LIGHTING_MATERIAL
+} ve_lighting_debug_mode;
+
+/**
+ * @brief Specialization constant values of one shader variant
+ *
+ * Constants are kept sorted by id, so permutations built in any order
+ * produce identical specialization data and share a registry pipeline.
+ */
+typedef struct ve_shader_permutation {
+    uint32_t count;
+    uint32_t values[VE_SHADER_MAX_CONSTANTS];
+    VkSpecializationMapEntry entries[VE_SHADER_MAX_CONSTANTS];
+    VkSpecializationInfo info;
+} ve_shader_permutation;
+
+/**
+ * @brief Reset a permutation to no constants
+ *
+ * @param permutation Permutation
+ */
+void ve_shader_permutation_init(ve_shader_permutation* permutation);
+
+/**
+ * @brief Set a 32-bit constant (int, uint or float bits)
+ *
+ * @param permutation Permutation
+ * @param constant_id Shader constant_id
+ * @param value Value
+ */
+void ve_shader_permutation_set(ve_shader_permutation* permutation, uint32_t constant_id, uint32_t value);
+
+/**
+ * @brief Set a bool constant
+ *
+ * @param permutation Permutation
+ * @param constant_id Shader constant_id
+ * @param value Value
+ */
+void ve_shader_permutation_set_bool(ve_shader_permutation* permutation, uint32_t constant_id, bool value);
+
+/**
+ * @brief Get the specialization info of a permutation
+ *
+ * The info points into the permutation, which must not move while it is used.
+ *
+ * @param permutation Permutation
+ * @return Specialization info, or NULL without constants
+ */
+const VkSpecializationInfo* ve_shader_permutation_get_info(ve_shader_permutation* permutation);
+
+/**
+ * @brief Build the gbuffer.frag permutation of a material
+ *
+ * @param permutation Output permutation
+ * @param features Combination of ve_gbuffer_feature flags
+ */
+void ve_shader_permutation_gbuffer(ve_shader_permutation* permutation, uint32_t features);
+
+/**
+ * @brief Build the lighting.frag permutation of an output mode
+ *
+ * @param permutation Output permutation
+ * @param mode Output mode
+ */
+void ve_shader_permutation_lighting(ve_shader_permutation* permutation, ve_lighting_debug_mode mode);
+
+/**
+ * @brief Read a SPIR-V binary from disk
+ *
+ * @param path Path to the .spv file
+ * @param size Output size in bytes
+ * @return Code (free with VE_FREE), or NULL if the file is missing or not SPIR-V
+ */
+uint32_t* ve_shader_load_spirv(const char* path, size_t* size);
+
+/**
+ * @brief Create a shader module from SPIR-V code
+ *
+ * @param code SPIR-V code
+ * @param size Size in bytes, a multiple of 4
+ * @param module Output shader module
+ * @return VK_SUCCESS on success
+ */
+VkResult ve_shader_create_module(const uint32_t* code, size_t size, VkShaderModule* module);
+
+/**
+ * @brief Load a SPIR-V file and create a shader module from it
+ *
+ * @param path Path to the .spv file
+ * @param module Output shader module
+ * @return VK_SUCCESS on success, VK_ERROR_INITIALIZATION_FAILED if the file cannot be read
+ */
+VkResult ve_shader_load_module(const char* path, VkShaderModule* module);
+
+/**
+ * @brief Destroy a shader module
+ *
+ * Modules may be destroyed as soon as the pipelines using them are created.
+ *
+ * @param module Shader module
+ */
+void ve_shader_destroy_module(VkShaderModule module);
 
 #ifdef __cplusplus
 }
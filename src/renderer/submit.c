@@ -0,0 +1,375 @@
+/**
+ * @file submit.c
+ * @brief Batched queue submission implementation
+ */
+
+#define VK_NO_PROTOTYPES
+#include "submit.h"
+#include "sync.h"
+
+#include "../core/logger.h"
+#include "../core/assert.h"
+
+#include <string.h>
+
+/**
+ * @brief Semaphore operation of a pending batch
+ */
+typedef struct ve_submit_semaphore {
+    VkSemaphore semaphore;
+    uint64_t value;
+    VkPipelineStageFlags2 stage_mask;
+} ve_submit_semaphore;
+
+/**
+ * @brief Work collected for one queue until the next flush
+ */
+typedef struct ve_submit_batch {
+    VkCommandBuffer buffers[VE_SUBMIT_MAX_COMMAND_BUFFERS];
+    uint32_t device_masks[VE_SUBMIT_MAX_COMMAND_BUFFERS];   /* Devices of the group that run each, 0 for all */
+    uint32_t buffer_count;
+    ve_submit_semaphore waits[VE_SUBMIT_MAX_WAITS];
+    uint32_t wait_count;
+    ve_submit_semaphore signals[VE_SUBMIT_MAX_SIGNALS];
+    uint32_t signal_count;
+    bool required;      /* Another batch waits on this one's timeline value */
+} ve_submit_batch;
+
+/* Global submission state */
+static struct {
+    bool initialized;
+    bool synchronization2;
+    VkSemaphore timelines[VE_SUBMIT_QUEUE_COUNT];
+    uint64_t submitted[VE_SUBMIT_QUEUE_COUNT];
+    ve_submit_batch pending[VE_SUBMIT_QUEUE_COUNT];
+} g_submit = {0};
+
+static const char* timeline_names[VE_SUBMIT_QUEUE_COUNT] = {
+    "graphics_timeline",
+    "compute_timeline",
+    "transfer_timeline"
+};
+
+VkResult ve_submit_init(void) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VE_ASSERT(vk && vk->device);
+
+    memset(&g_submit, 0, sizeof(g_submit));
+
+    if (!vk->device_features.timelineSemaphore || !ve_sync_supports_timeline()) {
+        VE_LOG_WARN("Timeline semaphores not supported, submission batching disabled");
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    for (uint32_t i = 0; i < VE_SUBMIT_QUEUE_COUNT; i++) {
+        g_submit.timelines[i] = ve_sync_create_timeline_semaphore(0, timeline_names[i]);
+        if (g_submit.timelines[i] == VK_NULL_HANDLE) {
+            VE_LOG_ERROR("Failed to create %s", timeline_names[i]);
+            ve_submit_shutdown();
+            return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        }
+    }
+
+    g_submit.synchronization2 = vk->device_features.synchronization2;
+    g_submit.initialized = true;
+
+    VE_LOG_INFO("Submission batcher initialized (%s)",
+                g_submit.synchronization2 ? "vkQueueSubmit2" : "vkQueueSubmit");
+    return VK_SUCCESS;
+}
+
+void ve_submit_shutdown(void) {
+    for (uint32_t i = 0; i < VE_SUBMIT_QUEUE_COUNT; i++) {
+        ve_sync_destroy_semaphore(g_submit.timelines[i]);
+    }
+    memset(&g_submit, 0, sizeof(g_submit));
+}
+
+bool ve_submit_is_enabled(void) {
+    return g_submit.initialized;
+}
+
+bool ve_submit_add(ve_command_buffer* cmd) {
+    VE_ASSERT(g_submit.initialized && cmd && !cmd->is_recording);
+
+    ve_submit_batch* batch = &g_submit.pending[cmd->type];
+    if (batch->buffer_count == VE_SUBMIT_MAX_COMMAND_BUFFERS) {
+        VE_LOG_ERROR("Submission batch full for queue %d", cmd->type);
+        return false;
+    }
+
+    batch->device_masks[batch->buffer_count] = cmd->device_mask;
+    batch->buffers[batch->buffer_count++] = cmd->buffer;
+    return true;
+}
+
+uint32_t ve_submit_get_free_slots(ve_command_buffer_type queue) {
+    VE_ASSERT(g_submit.initialized);
+    return VE_SUBMIT_MAX_COMMAND_BUFFERS - g_submit.pending[queue].buffer_count;
+}
+
+/* Add a wait, merging it with an existing wait on the same semaphore */
+static void batch_add_wait(ve_submit_batch* batch, VkSemaphore semaphore, uint64_t value,
+                           VkPipelineStageFlags2 stage_mask)
+{
+    for (uint32_t i = 0; i < batch->wait_count; i++) {
+        if (batch->waits[i].semaphore == semaphore) {
+            if (value > batch->waits[i].value) {
+                batch->waits[i].value = value;
+            }
+            batch->waits[i].stage_mask |= stage_mask;
+            return;
+        }
+    }
+
+    VE_ASSERT_MSG(batch->wait_count < VE_SUBMIT_MAX_WAITS, "Too many waits in submission batch");
+    if (batch->wait_count < VE_SUBMIT_MAX_WAITS) {
+        batch->waits[batch->wait_count++] = (ve_submit_semaphore){semaphore, value, stage_mask};
+    }
+}
+
+void ve_submit_wait_queue(ve_command_buffer_type queue, ve_command_buffer_type producer,
+                          VkPipelineStageFlags2 stage_mask)
+{
+    VE_ASSERT(g_submit.initialized && queue < VE_SUBMIT_QUEUE_COUNT && producer < VE_SUBMIT_QUEUE_COUNT);
+    VE_ASSERT_MSG(queue != producer, "Batches on one queue already execute in order");
+
+    /* The producer must flush even if nothing else is added to it */
+    g_submit.pending[producer].required = true;
+    batch_add_wait(&g_submit.pending[queue], g_submit.timelines[producer],
+                   g_submit.submitted[producer] + 1, stage_mask);
+}
+
+void ve_submit_wait_semaphore(ve_command_buffer_type queue, VkSemaphore semaphore, uint64_t value,
+                              VkPipelineStageFlags2 stage_mask)
+{
+    VE_ASSERT(g_submit.initialized && queue < VE_SUBMIT_QUEUE_COUNT && semaphore != VK_NULL_HANDLE);
+    batch_add_wait(&g_submit.pending[queue], semaphore, value, stage_mask);
+}
+
+void ve_submit_signal_semaphore(ve_command_buffer_type queue, VkSemaphore semaphore, uint64_t value) {
+    VE_ASSERT(g_submit.initialized && queue < VE_SUBMIT_QUEUE_COUNT && semaphore != VK_NULL_HANDLE);
+
+    ve_submit_batch* batch = &g_submit.pending[queue];
+    VE_ASSERT_MSG(batch->signal_count < VE_SUBMIT_MAX_SIGNALS, "Too many signals in submission batch");
+    if (batch->signal_count < VE_SUBMIT_MAX_SIGNALS) {
+        batch->signals[batch->signal_count++] = (ve_submit_semaphore){
+            semaphore, value, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT};
+    }
+}
+
+static VkQueue queue_handle(ve_vulkan_context* vk, uint32_t queue) {
+    switch (queue) {
+        case VE_COMMAND_BUFFER_GRAPHICS:
+            return vk->queues.graphics;
+        case VE_COMMAND_BUFFER_COMPUTE:
+            return vk->queues.compute;
+        case VE_COMMAND_BUFFER_TRANSFER:
+            return vk->queues.transfer;
+        default:
+            return VK_NULL_HANDLE;
+    }
+}
+
+static VkResult submit_batch2(VkQueue queue, const ve_submit_batch* batch,
+                              VkSemaphore timeline, uint64_t value)
+{
+    VkSemaphoreSubmitInfo waits[VE_SUBMIT_MAX_WAITS];
+    VkSemaphoreSubmitInfo signals[VE_SUBMIT_MAX_SIGNALS + 1];
+    VkCommandBufferSubmitInfo buffers[VE_SUBMIT_MAX_COMMAND_BUFFERS];
+
+    for (uint32_t i = 0; i < batch->wait_count; i++) {
+        waits[i] = (VkSemaphoreSubmitInfo){
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+            .semaphore = batch->waits[i].semaphore,
+            .value = batch->waits[i].value,
+            .stageMask = batch->waits[i].stage_mask,
+        };
+    }
+
+    for (uint32_t i = 0; i < batch->signal_count; i++) {
+        signals[i] = (VkSemaphoreSubmitInfo){
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+            .semaphore = batch->signals[i].semaphore,
+            .value = batch->signals[i].value,
+            .stageMask = batch->signals[i].stage_mask,
+        };
+    }
+    signals[batch->signal_count] = (VkSemaphoreSubmitInfo){
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+        .semaphore = timeline,
+        .value = value,
+        .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+    };
+
+    for (uint32_t i = 0; i < batch->buffer_count; i++) {
+        buffers[i] = (VkCommandBufferSubmitInfo){
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+            .commandBuffer = batch->buffers[i],
+            .deviceMask = batch->device_masks[i],
+        };
+    }
+
+    VkSubmitInfo2 submit_info = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+        .waitSemaphoreInfoCount = batch->wait_count,
+        .pWaitSemaphoreInfos = waits,
+        .commandBufferInfoCount = batch->buffer_count,
+        .pCommandBufferInfos = buffers,
+        .signalSemaphoreInfoCount = batch->signal_count + 1,
+        .pSignalSemaphoreInfos = signals,
+    };
+
+    return vkQueueSubmit2(queue, 1, &submit_info, VK_NULL_HANDLE);
+}
+
+/* Fallback for devices without synchronization2; the legacy stage bits share their values */
+static VkResult submit_batch(VkQueue queue, const ve_submit_batch* batch,
+                             VkSemaphore timeline, uint64_t value)
+{
+    VkSemaphore wait_semaphores[VE_SUBMIT_MAX_WAITS];
+    uint64_t wait_values[VE_SUBMIT_MAX_WAITS];
+    VkPipelineStageFlags wait_stages[VE_SUBMIT_MAX_WAITS];
+    VkSemaphore signal_semaphores[VE_SUBMIT_MAX_SIGNALS + 1];
+    uint64_t signal_values[VE_SUBMIT_MAX_SIGNALS + 1];
+
+    for (uint32_t i = 0; i < batch->wait_count; i++) {
+        wait_semaphores[i] = batch->waits[i].semaphore;
+        wait_values[i] = batch->waits[i].value;
+        wait_stages[i] = (VkPipelineStageFlags)(batch->waits[i].stage_mask & 0xFFFFFFFFu);
+    }
+
+    for (uint32_t i = 0; i < batch->signal_count; i++) {
+        signal_semaphores[i] = batch->signals[i].semaphore;
+        signal_values[i] = batch->signals[i].value;
+    }
+    signal_semaphores[batch->signal_count] = timeline;
+    signal_values[batch->signal_count] = value;
+
+    /* Device group masks; semaphores are waited on and signalled by the first device */
+    uint32_t device_masks[VE_SUBMIT_MAX_COMMAND_BUFFERS];
+    uint32_t wait_device_indices[VE_SUBMIT_MAX_WAITS] = {0};
+    uint32_t signal_device_indices[VE_SUBMIT_MAX_SIGNALS + 1] = {0};
+    for (uint32_t i = 0; i < batch->buffer_count; i++) {
+        device_masks[i] = batch->device_masks[i] != 0 ? batch->device_masks[i] : ve_vulkan_get_device_group_mask();
+    }
+
+    VkDeviceGroupSubmitInfo group_info = {
+        .sType = VK_STRUCTURE_TYPE_DEVICE_GROUP_SUBMIT_INFO,
+        .waitSemaphoreCount = batch->wait_count,
+        .pWaitSemaphoreDeviceIndices = wait_device_indices,
+        .commandBufferCount = batch->buffer_count,
+        .pCommandBufferDeviceMasks = device_masks,
+        .signalSemaphoreCount = batch->signal_count + 1,
+        .pSignalSemaphoreDeviceIndices = signal_device_indices,
+    };
+
+    VkTimelineSemaphoreSubmitInfo timeline_info = {
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .pNext = ve_vulkan_get_device_group_size() > 1 ? &group_info : NULL,
+        .waitSemaphoreValueCount = batch->wait_count,
+        .pWaitSemaphoreValues = wait_values,
+        .signalSemaphoreValueCount = batch->signal_count + 1,
+        .pSignalSemaphoreValues = signal_values,
+    };
+
+    VkSubmitInfo submit_info = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext = &timeline_info,
+        .waitSemaphoreCount = batch->wait_count,
+        .pWaitSemaphores = wait_semaphores,
+        .pWaitDstStageMask = wait_stages,
+        .commandBufferCount = batch->buffer_count,
+        .pCommandBuffers = batch->buffers,
+        .signalSemaphoreCount = batch->signal_count + 1,
+        .pSignalSemaphores = signal_semaphores,
+    };
+
+    return vkQueueSubmit(queue, 1, &submit_info, VK_NULL_HANDLE);
+}
+
+VkResult ve_submit_flush(void) {
+    VE_ASSERT(g_submit.initialized);
+
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+
+    /* Producers first: transfer uploads feed compute, both feed graphics */
+    static const uint32_t flush_order[VE_SUBMIT_QUEUE_COUNT] = {
+        VE_COMMAND_BUFFER_TRANSFER,
+        VE_COMMAND_BUFFER_COMPUTE,
+        VE_COMMAND_BUFFER_GRAPHICS,
+    };
+
+    VkResult status = VK_SUCCESS;
+
+    for (uint32_t i = 0; i < VE_SUBMIT_QUEUE_COUNT; i++) {
+        uint32_t queue = flush_order[i];
+        ve_submit_batch* batch = &g_submit.pending[queue];
+
+        if (batch->buffer_count == 0 && batch->wait_count == 0 &&
+            batch->signal_count == 0 && !batch->required) {
+            continue;
+        }
+
+        VkQueue handle = queue_handle(vk, queue);
+        if (handle == VK_NULL_HANDLE) {
+            VE_LOG_ERROR("No queue available for submission type: %u", queue);
+            memset(batch, 0, sizeof(ve_submit_batch));
+            status = VK_ERROR_DEVICE_LOST;
+            continue;
+        }
+
+        uint64_t value = g_submit.submitted[queue] + 1;
+        VkResult result = g_submit.synchronization2
+            ? submit_batch2(handle, batch, g_submit.timelines[queue], value)
+            : submit_batch(handle, batch, g_submit.timelines[queue], value);
+
+        if (result == VK_SUCCESS) {
+            g_submit.submitted[queue] = value;
+        } else {
+            VE_LOG_ERROR("Failed to submit batch of %u command buffers: %d", batch->buffer_count, result);
+            status = result;
+        }
+
+        memset(batch, 0, sizeof(ve_submit_batch));
+    }
+
+    return status;
+}
+
+uint64_t ve_submit_get_pending_value(ve_command_buffer_type queue) {
+    VE_ASSERT(queue < VE_SUBMIT_QUEUE_COUNT);
+    return g_submit.submitted[queue] + 1;
+}
+
+uint64_t ve_submit_get_submitted_value(ve_command_buffer_type queue) {
+    VE_ASSERT(queue < VE_SUBMIT_QUEUE_COUNT);
+    return g_submit.submitted[queue];
+}
+
+uint64_t ve_submit_get_completed_value(ve_command_buffer_type queue) {
+    VE_ASSERT(queue < VE_SUBMIT_QUEUE_COUNT);
+
+    if (!g_submit.initialized) {
+        return 0;
+    }
+
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    uint64_t value = 0;
+    if (vkGetSemaphoreCounterValue(vk->device, g_submit.timelines[queue], &value) != VK_SUCCESS) {
+        return 0;
+    }
+    return value;
+}
+
+VkResult ve_submit_wait(ve_command_buffer_type queue, uint64_t value, uint64_t timeout) {
+    VE_ASSERT(g_submit.initialized && queue < VE_SUBMIT_QUEUE_COUNT);
+    return ve_sync_wait_timeline(g_submit.timelines[queue], value, timeout);
+}
+
+VkSemaphore ve_submit_get_timeline(ve_command_buffer_type queue) {
+    if (queue >= VE_SUBMIT_QUEUE_COUNT) {
+        return VK_NULL_HANDLE;
+    }
+    return g_submit.timelines[queue];
+}
@@ -0,0 +1,172 @@
+/**
+ * @file submit.h
+ * @brief Batched queue submission on timeline semaphores
+ *
+ * Command buffers are collected per queue while the frame is recorded and
+ * flushed with one vkQueueSubmit2 call per queue (vkQueueSubmit with
+ * VkTimelineSemaphoreSubmitInfo on devices without synchronization2).
+ * Every queue owns one timeline semaphore that is incremented by each
+ * flushed batch, so cross-queue dependencies are expressed as waits on a
+ * counter value and the CPU tracks GPU progress by reading that counter
+ * instead of polling per-submit fences. Binary semaphores are only needed
+ * for the swapchain.
+ *
+ * The batcher is used from the thread that records and submits frames.
+ */
+
+#ifndef VE_SUBMIT_H
+#define VE_SUBMIT_H
+
+#include "vulkan_core.h"
+#include "command_buffer.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Submission batcher limits, per queue and flush */
+#define VE_SUBMIT_MAX_COMMAND_BUFFERS 32
+#define VE_SUBMIT_MAX_WAITS 8
+#define VE_SUBMIT_MAX_SIGNALS 4
+
+/* Number of queues fed by the batcher, indexed by ve_command_buffer_type */
+#define VE_SUBMIT_QUEUE_COUNT 3
+
+/**
+ * @brief Initialize the submission batcher
+ *
+ * Creates one timeline semaphore per queue type. Requires the
+ * timelineSemaphore feature; without it the batcher stays disabled and
+ * callers keep using ve_command_buffer_submit.
+ *
+ * @return VK_SUCCESS on success, VK_ERROR_FEATURE_NOT_PRESENT without timeline semaphores
+ */
+VkResult ve_submit_init(void);
+
+/**
+ * @brief Destroy the timeline semaphores
+ *
+ * The device must be idle.
+ */
+void ve_submit_shutdown(void);
+
+/**
+ * @brief Check if the batcher is initialized
+ *
+ * @return true if submissions go through the batcher
+ */
+bool ve_submit_is_enabled(void);
+
+/**
+ * @brief Append a recorded command buffer to its queue's pending batch
+ *
+ * Command buffers execute in the order they were added.
+ *
+ * @param cmd Command buffer in the executable state
+ * @return true on success, false if the batch is full
+ */
+bool ve_submit_add(ve_command_buffer* cmd);
+
+/**
+ * @brief Get how many more command buffers a queue's pending batch accepts
+ *
+ * Lets a caller that adds related command buffers to several queues check
+ * that all of them fit before adding any.
+ *
+ * @param queue Queue
+ * @return Free command buffer slots in the pending batch
+ */
+uint32_t ve_submit_get_free_slots(ve_command_buffer_type queue);
+
+/**
+ * @brief Make a queue's pending batch wait for another queue's pending batch
+ *
+ * The wait is on the timeline value the producer's batch will signal, so
+ * it covers everything added to the producer before the next flush.
+ *
+ * @param queue Waiting queue
+ * @param producer Queue whose pending batch must complete first
+ * @param stage_mask Stages of the waiting batch that wait (VkPipelineStageFlags2)
+ */
+void ve_submit_wait_queue(ve_command_buffer_type queue, ve_command_buffer_type producer,
+                          VkPipelineStageFlags2 stage_mask);
+
+/**
+ * @brief Make a queue's pending batch wait for a semaphore
+ *
+ * @param queue Waiting queue
+ * @param semaphore Binary semaphore (value 0) or timeline semaphore
+ * @param value Timeline value to wait for, ignored for binary semaphores
+ * @param stage_mask Stages of the waiting batch that wait (VkPipelineStageFlags2)
+ */
+void ve_submit_wait_semaphore(ve_command_buffer_type queue, VkSemaphore semaphore, uint64_t value,
+                              VkPipelineStageFlags2 stage_mask);
+
+/**
+ * @brief Signal an additional semaphore when a queue's pending batch completes
+ *
+ * @param queue Signalling queue
+ * @param semaphore Binary semaphore (value 0) or timeline semaphore
+ * @param value Timeline value to signal, ignored for binary semaphores
+ */
+void ve_submit_signal_semaphore(ve_command_buffer_type queue, VkSemaphore semaphore, uint64_t value);
+
+/**
+ * @brief Submit every pending batch, one queue submission call per queue
+ *
+ * Queues are flushed transfer, compute, graphics, so producers are always
+ * submitted before the batches that wait on them. Queues without pending
+ * command buffers are skipped unless they have waits or signals.
+ *
+ * @return VK_SUCCESS on success
+ */
+VkResult ve_submit_flush(void);
+
+/**
+ * @brief Get the timeline value the queue's pending batch will signal
+ *
+ * @param queue Queue
+ * @return Timeline value
+ */
+uint64_t ve_submit_get_pending_value(ve_command_buffer_type queue);
+
+/**
+ * @brief Get the timeline value signalled by the queue's last flushed batch
+ *
+ * @param queue Queue
+ * @return Timeline value, 0 before the first flush
+ */
+uint64_t ve_submit_get_submitted_value(ve_command_buffer_type queue);
+
+/**
+ * @brief Read how far the GPU has progressed on a queue
+ *
+ * @param queue Queue
+ * @return Last timeline value the queue has completed
+ */
+uint64_t ve_submit_get_completed_value(ve_command_buffer_type queue);
+
+/**
+ * @brief Block until a queue has completed a timeline value
+ *
+ * @param queue Queue
+ * @param value Timeline value
+ * @param timeout Timeout in nanoseconds
+ * @return VK_SUCCESS when reached, VK_TIMEOUT otherwise
+ */
+VkResult ve_submit_wait(ve_command_buffer_type queue, uint64_t value, uint64_t timeout);
+
+/**
+ * @brief Get the timeline semaphore of a queue
+ *
+ * @param queue Queue
+ * @return Timeline semaphore or VK_NULL_HANDLE
+ */
+VkSemaphore ve_submit_get_timeline(ve_command_buffer_type queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_SUBMIT_H */
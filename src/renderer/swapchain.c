@@ -8,7 +8,10 @@
 
 #include "../core/logger.h"
 #include "../core/assert.h"
-#include "../memory/memory.h"
+#include "../core/memory.h"
+#include "../core/latency.h"
+#include "sync.h"
+#include "deletion_queue.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -17,18 +20,59 @@
 static ve_swapchain g_swapchain = {0};
 static bool g_owns_framebuffers = false;
 
+/* Attachments of owned framebuffers, kept to rebuild them after recreation */
+static VkRenderPass g_framebuffer_render_pass = VK_NULL_HANDLE;
+static VkImageView g_framebuffer_depth_view = VK_NULL_HANDLE;
+
 ve_swapchain* ve_swapchain_get_current(void) {
     return &g_swapchain;
 }
 
-VkResult ve_swapchain_create(const ve_swapchain_config* config) {
+/* Hand owned framebuffers to the deletion queue; frames in flight may still use them */
+static void retire_framebuffers(void) {
+    if (!g_owns_framebuffers || !g_swapchain.framebuffers) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < g_swapchain.image_count; i++) {
+        ve_deletion_queue_push_framebuffer(g_swapchain.framebuffers[i]);
+        g_swapchain.framebuffers[i] = VK_NULL_HANDLE;
+    }
+}
+
+static VkResult create_framebuffer(uint32_t index) {
     ve_vulkan_context* vk = ve_vulkan_get_context();
-    VE_ASSERT(vk && vk->physical_device && vk->surface);
 
-    /* Destroy existing swapchain if any */
-    if (g_swapchain.swapchain != VK_NULL_HANDLE) {
-        ve_swapchain_destroy();
+    VkImageView attachments[] = {
+        g_swapchain.image_views[index],
+        g_framebuffer_depth_view
+    };
+
+    uint32_t attachment_count = (g_framebuffer_depth_view != VK_NULL_HANDLE) ? 2 : 1;
+
+    VkFramebufferCreateInfo framebuffer_info = {
+        .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+        .renderPass = g_framebuffer_render_pass,
+        .attachmentCount = attachment_count,
+        .pAttachments = attachments,
+        .width = g_swapchain.extent.width,
+        .height = g_swapchain.extent.height,
+        .layers = 1,
+    };
+
+    VkResult result = vkCreateFramebuffer(vk->device, &framebuffer_info, NULL,
+                                         &g_swapchain.framebuffers[index]);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to create framebuffer %u: %d", index, result);
+        g_swapchain.framebuffers[index] = VK_NULL_HANDLE;
     }
+    return result;
+}
+
+/* Create the swapchain; old_swapchain is retired by the driver but not destroyed */
+static VkResult create_swapchain(const ve_swapchain_config* config, VkSwapchainKHR old_swapchain) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VE_ASSERT(vk && vk->physical_device && vk->surface);
 
     /* Query swapchain support */
     ve_swapchain_support support = ve_vulkan_query_swapchain_support(vk->physical_device);
@@ -45,14 +89,29 @@ VkResult ve_swapchain_create(const ve_swapchain_config* config) {
 
     VkPresentModeKHR present_mode = ve_swapchain_choose_present_mode(
         support.present_modes, support.present_mode_count,
-        config->vsync, config->triple_buffering);
+        config->vsync, config->triple_buffering, config->low_latency);
+
+    /* An explicitly preferred mode wins unless it would tear with vsync on */
+    bool preferred_tears = config->preferred_present_mode == VK_PRESENT_MODE_IMMEDIATE_KHR ||
+                           config->preferred_present_mode == VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+    if (!config->vsync || !preferred_tears) {
+        for (uint32_t i = 0; i < support.present_mode_count; i++) {
+            if (support.present_modes[i] == config->preferred_present_mode) {
+                present_mode = config->preferred_present_mode;
+                break;
+            }
+        }
+    }
 
     VkExtent2D extent = ve_swapchain_choose_extent(&support.capabilities,
                                                    config->width,
                                                    config->height);
 
-    /* Image count */
+    /* Image count; a short FIFO queue means fewer frames of latency */
     uint32_t image_count = support.capabilities.minImageCount + 1;
+    if (config->low_latency && present_mode == VK_PRESENT_MODE_FIFO_KHR) {
+        image_count = support.capabilities.minImageCount > 2 ? support.capabilities.minImageCount : 2;
+    }
     if (support.capabilities.maxImageCount > 0 &&
         image_count > support.capabilities.maxImageCount) {
         image_count = support.capabilities.maxImageCount;
@@ -73,7 +132,7 @@ VkResult ve_swapchain_create(const ve_swapchain_config* config) {
         .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
         .presentMode = present_mode,
         .clipped = VK_TRUE,
-        .oldSwapchain = VK_NULL_HANDLE,
+        .oldSwapchain = old_swapchain,
     };
 
     /* Queue family sharing */
@@ -96,12 +155,17 @@ VkResult ve_swapchain_create(const ve_swapchain_config* config) {
 
     if (result != VK_SUCCESS) {
         VE_LOG_ERROR("Failed to create swapchain: %d", result);
+        g_swapchain.swapchain = VK_NULL_HANDLE;
         return result;
     }
 
-    /* Store swapchain properties */
+    /* Store swapchain properties; present ids restart with each swapchain */
     g_swapchain.format = surface_format.format;
     g_swapchain.extent = extent;
+    g_swapchain.present_mode = present_mode;
+    g_swapchain.present_wait = vk->device_features.presentWait;
+    g_swapchain.present_id = 0;
+    g_swapchain.completed_present_id = 0;
 
     /* Get swapchain images */
     vkGetSwapchainImagesKHR(vk->device, g_swapchain.swapchain, &image_count, NULL);
@@ -118,11 +182,21 @@ VkResult ve_swapchain_create(const ve_swapchain_config* config) {
 
     g_swapchain.out_of_date = false;
     g_swapchain.framebuffers = NULL;
+    g_swapchain.generation++;
 
     VE_LOG_INFO("Swapchain created: %ux%u, %u images", extent.width, extent.height, image_count);
     return VK_SUCCESS;
 }
 
+VkResult ve_swapchain_create(const ve_swapchain_config* config) {
+    /* Destroy existing swapchain if any */
+    if (g_swapchain.swapchain != VK_NULL_HANDLE) {
+        ve_swapchain_destroy();
+    }
+
+    return create_swapchain(config, VK_NULL_HANDLE);
+}
+
 void ve_swapchain_destroy(void) {
     ve_vulkan_context* vk = ve_vulkan_get_context();
     if (!vk) {
@@ -169,17 +243,60 @@ void ve_swapchain_destroy(void) {
 
     g_swapchain.image_count = 0;
     g_swapchain.current_image_index = 0;
+    g_owns_framebuffers = false;
+    g_framebuffer_render_pass = VK_NULL_HANDLE;
+    g_framebuffer_depth_view = VK_NULL_HANDLE;
 }
 
 VkResult ve_swapchain_recreate(const ve_swapchain_config* config) {
-    ve_vulkan_wait_idle();
+    if (g_swapchain.swapchain == VK_NULL_HANDLE) {
+        return create_swapchain(config, VK_NULL_HANDLE);
+    }
+
+    /* Detach the old swapchain; the device keeps running while it retires */
+    VkSwapchainKHR old_swapchain = g_swapchain.swapchain;
+    VkImage* old_images = g_swapchain.images;
+    VkImageView* old_views = g_swapchain.image_views;
+    uint32_t old_count = g_swapchain.image_count;
+
+    retire_framebuffers();
+    VE_FREE(g_swapchain.framebuffers);
 
-    VkResult result = ve_swapchain_create(config);
-    if (result == VK_SUCCESS) {
-        VE_LOG_INFO("Swapchain recreated: %ux%u", config->width, config->height);
+    g_swapchain.swapchain = VK_NULL_HANDLE;
+    g_swapchain.images = NULL;
+    g_swapchain.image_views = NULL;
+    g_swapchain.framebuffers = NULL;
+    g_swapchain.image_count = 0;
+    g_swapchain.current_image_index = 0;
+
+    VkResult result = create_swapchain(config, old_swapchain);
+
+    /* The old swapchain is retired even if creation failed; destroy it with
+     * its views once the frames that presented from it have completed */
+    for (uint32_t i = 0; i < old_count; i++) {
+        ve_deletion_queue_push_image_view(old_views[i]);
     }
+    ve_deletion_queue_push_swapchain(old_swapchain);
+    VE_FREE(old_views);
+    VE_FREE(old_images);
 
-    return result;
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    /* Owned framebuffers are rebuilt lazily when first requested; supplied
+     * ones belong to the caller, who must set them again */
+    if (g_owns_framebuffers) {
+        g_swapchain.framebuffers = (VkFramebuffer*)VE_ALLOCATE_TAG(
+            g_swapchain.image_count * sizeof(VkFramebuffer), VE_MEMORY_TAG_VULKAN);
+        if (!g_swapchain.framebuffers) {
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+        memset(g_swapchain.framebuffers, 0, g_swapchain.image_count * sizeof(VkFramebuffer));
+    }
+
+    VE_LOG_INFO("Swapchain recreated: %ux%u", g_swapchain.extent.width, g_swapchain.extent.height);
+    return VK_SUCCESS;
 }
 
 VkResult ve_swapchain_acquire_next_image(VkSemaphore signal_semaphore) {
@@ -220,8 +337,26 @@ VkResult ve_swapchain_present(VkSemaphore wait_semaphore) {
         .pImageIndices = &g_swapchain.current_image_index,
     };
 
+    /* Tag the present so its completion can be waited on */
+    uint64_t present_id = g_swapchain.present_id + 1;
+    VkPresentIdKHR present_id_info = {
+        .sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR,
+        .swapchainCount = 1,
+        .pPresentIds = &present_id,
+    };
+    if (g_swapchain.present_wait) {
+        present_info.pNext = &present_id_info;
+    }
+
+    uint64_t frame_number = ve_sync_get_frame_number();
     VkResult result = vkQueuePresentKHR(vk->queues.present, &present_info);
 
+    if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR) {
+        ve_latency_mark(frame_number, VE_LATENCY_PRESENT);
+        g_swapchain.present_id = present_id;
+        g_swapchain.present_frames[present_id % VE_SWAPCHAIN_PRESENT_HISTORY] = frame_number;
+    }
+
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
         g_swapchain.out_of_date = true;
         return result;
@@ -231,6 +366,39 @@ VkResult ve_swapchain_present(VkSemaphore wait_semaphore) {
     return result;
 }
 
+VkResult ve_swapchain_wait_for_present(uint32_t max_pending, uint64_t timeout) {
+    if (!g_swapchain.present_wait || g_swapchain.present_id <= max_pending) {
+        return VK_SUCCESS;
+    }
+
+    uint64_t target = g_swapchain.present_id - max_pending;
+    if (target <= g_swapchain.completed_present_id) {
+        return VK_SUCCESS;
+    }
+
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VkResult result = vkWaitForPresentKHR(vk->device, g_swapchain.swapchain, target, timeout);
+
+    if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR) {
+        /* Only the waited present has a meaningful completion time */
+        if (g_swapchain.present_id - target < VE_SWAPCHAIN_PRESENT_HISTORY) {
+            ve_latency_mark(g_swapchain.present_frames[target % VE_SWAPCHAIN_PRESENT_HISTORY],
+                            VE_LATENCY_PRESENT_COMPLETE);
+        }
+        g_swapchain.completed_present_id = target;
+        return VK_SUCCESS;
+    }
+
+    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+        g_swapchain.out_of_date = true;
+    }
+    return result;
+}
+
+bool ve_swapchain_supports_present_wait(void) {
+    return g_swapchain.present_wait;
+}
+
 bool ve_swapchain_is_out_of_date(void) {
     return g_swapchain.out_of_date;
 }
@@ -255,27 +423,43 @@ VkImageView ve_swapchain_get_current_image_view(void) {
 }
 
 VkFramebuffer ve_swapchain_get_current_framebuffer(void) {
-    if (g_swapchain.current_image_index < g_swapchain.image_count && g_swapchain.framebuffers) {
-        return g_swapchain.framebuffers[g_swapchain.current_image_index];
+    uint32_t index = g_swapchain.current_image_index;
+    if (index >= g_swapchain.image_count || !g_swapchain.framebuffers) {
+        return VK_NULL_HANDLE;
     }
-    return VK_NULL_HANDLE;
+
+    /* Rebuild a framebuffer dropped by recreation or a new depth view */
+    if (g_swapchain.framebuffers[index] == VK_NULL_HANDLE && g_owns_framebuffers) {
+        create_framebuffer(index);
+    }
+    return g_swapchain.framebuffers[index];
 }
 
 void ve_swapchain_set_framebuffers(VkFramebuffer* framebuffers, uint32_t count, bool owns_framebuffers) {
-    /* Free old framebuffers if we own them */
+    /* Retire old framebuffers if we own them */
     if (g_owns_framebuffers && g_swapchain.framebuffers) {
-        ve_vulkan_context* vk = ve_vulkan_get_context();
-        for (uint32_t i = 0; i < g_swapchain.image_count; i++) {
-            if (g_swapchain.framebuffers[i] != VK_NULL_HANDLE) {
-                vkDestroyFramebuffer(vk->device, g_swapchain.framebuffers[i], NULL);
-            }
-        }
+        retire_framebuffers();
         VE_FREE(g_swapchain.framebuffers);
     }
 
     g_swapchain.framebuffers = framebuffers;
     g_swapchain.image_count = count;
     g_owns_framebuffers = owns_framebuffers;
+    g_framebuffer_render_pass = VK_NULL_HANDLE;
+    g_framebuffer_depth_view = VK_NULL_HANDLE;
+}
+
+void ve_swapchain_set_depth_view(VkImageView depth_view) {
+    if (depth_view == g_framebuffer_depth_view) {
+        return;
+    }
+
+    g_framebuffer_depth_view = depth_view;
+    retire_framebuffers();
+}
+
+uint32_t ve_swapchain_get_generation(void) {
+    return g_swapchain.generation;
 }
 
 VkSurfaceFormatKHR ve_swapchain_choose_surface_format(const VkSurfaceFormatKHR* formats,
@@ -309,12 +493,23 @@ VkSurfaceFormatKHR ve_swapchain_choose_surface_format(const VkSurfaceFormatKHR*
 VkPresentModeKHR ve_swapchain_choose_present_mode(const VkPresentModeKHR* modes,
                                                   uint32_t mode_count,
                                                   bool vsync,
-                                                  bool triple_buffering)
+                                                  bool triple_buffering,
+                                                  bool low_latency)
 {
     VE_ASSERT(modes && mode_count > 0);
 
-    /* Mailbox mode is best for triple buffering without tearing */
-    if (triple_buffering && !vsync) {
+    /* Immediate presents the newest frame without waiting for vblank */
+    if (low_latency && !vsync) {
+        for (uint32_t i = 0; i < mode_count; i++) {
+            if (modes[i] == VK_PRESENT_MODE_IMMEDIATE_KHR) {
+                return modes[i];
+            }
+        }
+    }
+
+    /* Mailbox mode is best for triple buffering without tearing, and keeps
+     * vsync latency to one refresh since queued images are replaced */
+    if ((triple_buffering && !vsync) || (low_latency && vsync)) {
         for (uint32_t i = 0; i < mode_count; i++) {
             if (modes[i] == VK_PRESENT_MODE_MAILBOX_KHR) {
                 return modes[i];
@@ -417,13 +612,9 @@ VkResult ve_swapchain_create_framebuffers(VkRenderPass render_pass, VkImageView
     VE_ASSERT(vk && vk->device);
     VE_ASSERT(render_pass != VK_NULL_HANDLE);
 
-    /* Free old framebuffers if we own them */
+    /* Retire old framebuffers if we own them */
     if (g_owns_framebuffers && g_swapchain.framebuffers) {
-        for (uint32_t i = 0; i < g_swapchain.image_count; i++) {
-            if (g_swapchain.framebuffers[i] != VK_NULL_HANDLE) {
-                vkDestroyFramebuffer(vk->device, g_swapchain.framebuffers[i], NULL);
-            }
-        }
+        retire_framebuffers();
         VE_FREE(g_swapchain.framebuffers);
     }
 
@@ -434,37 +625,21 @@ VkResult ve_swapchain_create_framebuffers(VkRenderPass render_pass, VkImageView
         return VK_ERROR_OUT_OF_HOST_MEMORY;
     }
 
+    memset(g_swapchain.framebuffers, 0, g_swapchain.image_count * sizeof(VkFramebuffer));
     g_owns_framebuffers = true;
+    g_framebuffer_render_pass = render_pass;
+    g_framebuffer_depth_view = depth_view;
 
     for (uint32_t i = 0; i < g_swapchain.image_count; i++) {
-        VkImageView attachments[] = {
-            g_swapchain.image_views[i],
-            depth_view
-        };
-
-        uint32_t attachment_count = (depth_view != VK_NULL_HANDLE) ? 2 : 1;
-
-        VkFramebufferCreateInfo framebuffer_info = {
-            .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-            .renderPass = render_pass,
-            .attachmentCount = attachment_count,
-            .pAttachments = attachments,
-            .width = g_swapchain.extent.width,
-            .height = g_swapchain.extent.height,
-            .layers = 1,
-        };
-
-        VkResult result = vkCreateFramebuffer(vk->device, &framebuffer_info, NULL,
-                                             &g_swapchain.framebuffers[i]);
+        VkResult result = create_framebuffer(i);
         if (result != VK_SUCCESS) {
-            VE_LOG_ERROR("Failed to create framebuffer %u: %d", i, result);
-
             /* Clean up already created framebuffers */
             for (uint32_t j = 0; j < i; j++) {
                 vkDestroyFramebuffer(vk->device, g_swapchain.framebuffers[j], NULL);
             }
             VE_FREE(g_swapchain.framebuffers);
             g_swapchain.framebuffers = NULL;
+            g_owns_framebuffers = false;
 
             return result;
         }
@@ -14,6 +14,9 @@
 extern "C" {
 #endif
 
+/* Presents remembered for latency markers */
+#define VE_SWAPCHAIN_PRESENT_HISTORY 8
+
 /**
  * @brief Swapchain configuration
  */
@@ -22,8 +25,9 @@ typedef struct ve_swapchain_config {
     uint32_t height;
     bool vsync;
     bool triple_buffering;
+    bool low_latency;               /* Favour input latency over throughput */
     VkSurfaceFormatKHR preferred_format;
-    VkPresentModeKHR preferred_present_mode;
+    VkPresentModeKHR preferred_present_mode;    /* Used when available and compatible with vsync */
     VkImageUsageFlags additional_usage;
 } ve_swapchain_config;
 
@@ -39,7 +43,15 @@ typedef struct ve_swapchain {
     VkExtent2D extent;
     uint32_t image_count;
     uint32_t current_image_index;
+    VkPresentModeKHR present_mode;
     bool out_of_date;
+    uint32_t generation;                /* Incremented each time the swapchain is (re)created */
+
+    /* Present ids (VK_KHR_present_id), 0 when present wait is unsupported */
+    bool present_wait;
+    uint64_t present_id;                /* Id of the last present */
+    uint64_t completed_present_id;      /* Last id known to have reached the display */
+    uint64_t present_frames[VE_SWAPCHAIN_PRESENT_HISTORY];  /* Frame number of each recent present */
 } ve_swapchain;
 
 /**
@@ -65,6 +77,12 @@ void ve_swapchain_destroy(void);
 /**
  * @brief Recreate swapchain (e.g., after resize)
  *
+ * Does not wait for the device. The current swapchain is passed as
+ * oldSwapchain, and it and its image views are retired through the
+ * deletion queue once the frames using them complete. Owned framebuffers
+ * are rebuilt lazily by ve_swapchain_get_current_framebuffer; framebuffers
+ * supplied with ve_swapchain_set_framebuffers must be set again.
+ *
  * @param config New configuration
  * @return VK_SUCCESS on success
  */
@@ -86,6 +104,27 @@ VkResult ve_swapchain_acquire_next_image(VkSemaphore signal_semaphore);
  */
 VkResult ve_swapchain_present(VkSemaphore wait_semaphore);
 
+/**
+ * @brief Wait until few enough presented images are still queued for display
+ *
+ * Blocks until the present max_pending presents ago has reached the
+ * display, which keeps the CPU from running ahead of the screen. Marks
+ * VE_LATENCY_PRESENT_COMPLETE for that frame. Without VK_KHR_present_wait
+ * this returns immediately and pacing is left to the frame limiter.
+ *
+ * @param max_pending Presents allowed to be queued (0 waits for the last present)
+ * @param timeout Timeout in nanoseconds
+ * @return VK_SUCCESS on success, VK_TIMEOUT if the present did not complete in time
+ */
+VkResult ve_swapchain_wait_for_present(uint32_t max_pending, uint64_t timeout);
+
+/**
+ * @brief Check if presents can be waited on
+ *
+ * @return true if VK_KHR_present_wait is enabled
+ */
+bool ve_swapchain_supports_present_wait(void);
+
 /**
  * @brief Check if swapchain is out of date
  *
@@ -124,10 +163,32 @@ VkImageView ve_swapchain_get_current_image_view(void);
 /**
  * @brief Get current framebuffer
  *
+ * Owned framebuffers dropped by recreation are created on first use.
+ *
  * @return Current framebuffer
  */
 VkFramebuffer ve_swapchain_get_current_framebuffer(void);
 
+/**
+ * @brief Replace the depth attachment of owned framebuffers
+ *
+ * For owners of size-dependent depth buffers after recreation. The old
+ * framebuffers are retired and rebuilt lazily.
+ *
+ * @param depth_view Depth stencil attachment view, or VK_NULL_HANDLE
+ */
+void ve_swapchain_set_depth_view(VkImageView depth_view);
+
+/**
+ * @brief Get the swapchain generation
+ *
+ * Lets dependents detect that the swapchain was recreated since they
+ * built their size-dependent resources.
+ *
+ * @return Generation, incremented on every (re)creation
+ */
+uint32_t ve_swapchain_get_generation(void);
+
 /**
  * @brief Set framebuffers (for render pass compatibility)
  *
@@ -152,16 +213,22 @@ VkSurfaceFormatKHR ve_swapchain_choose_surface_format(const VkSurfaceFormatKHR*
 /**
  * @brief Query optimal present mode
  *
+ * With vsync, low latency prefers MAILBOX, which replaces queued images
+ * instead of waiting behind them; without vsync, IMMEDIATE is chosen
+ * whenever available.
+ *
  * @param modes Available present modes
  * @param mode_count Number of modes
  * @param vsync Enable V-Sync
  * @param triple_buffering Enable triple buffering
+ * @param low_latency Favour input latency over throughput
  * @return Optimal present mode
  */
 VkPresentModeKHR ve_swapchain_choose_present_mode(const VkPresentModeKHR* modes,
                                                   uint32_t mode_count,
                                                   bool vsync,
-                                                  bool triple_buffering);
+                                                  bool triple_buffering,
+                                                  bool low_latency);
 
 /**
  * @brief Query swapchain extent
@@ -5,14 +5,23 @@
 
 #define VK_NO_PROTOTYPES
 #include "sync.h"
+#include "command_buffer.h"
+#include "descriptor.h"
+#include "gpu_profiler.h"
+#include "gpu_stats.h"
+#include "submit.h"
+#include "deletion_queue.h"
 
 #include "../core/logger.h"
 #include "../core/assert.h"
-#include "../memory/memory.h"
+#include "../core/memory.h"
 
 #include <stdlib.h>
 #include <string.h>
 
+/* Address space reserved for each frame arena */
+#define VE_FRAME_ARENA_RESERVE_SIZE ((size_t)64 * 1024 * 1024)
+
 /* Global sync state */
 static ve_sync_state g_sync_state = {0};
 
@@ -22,6 +31,7 @@ VkResult ve_sync_init(void) {
 
     memset(&g_sync_state, 0, sizeof(ve_sync_state));
     g_sync_state.current_frame = 0;
+    g_sync_state.frames_in_flight = VE_MAX_FRAMES_IN_FLIGHT;
 
     /* Check for timeline semaphore support */
     g_sync_state.timeline_semaphores = ve_sync_supports_timeline();
@@ -76,6 +86,13 @@ VkResult ve_sync_init(void) {
         }
     }
 
+    /* Per-frame scratch memory, recycled together with the frame's fence */
+    if (!ve_frame_allocator_init(VE_MAX_FRAMES_IN_FLIGHT, VE_FRAME_ARENA_RESERVE_SIZE)) {
+        ve_sync_shutdown();
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+    ve_frame_allocator_begin(g_sync_state.current_frame);
+
     VE_LOG_INFO("Synchronization primitives initialized");
     return VK_SUCCESS;
 }
@@ -113,6 +130,8 @@ void ve_sync_shutdown(void) {
         ve_sync_destroy_semaphore(g_sync_state.frames[i].transfer_finished);
     }
 
+    ve_frame_allocator_shutdown();
+
     memset(&g_sync_state, 0, sizeof(ve_sync_state));
 }
 
@@ -141,18 +160,182 @@ VkResult ve_sync_reset_fences(VkFence fence) {
     return vkResetFences(vk->device, 1, &fence);
 }
 
+/* Frames are paced on the submission timelines whenever the batcher is running */
+static bool timeline_pacing(void) {
+    return ve_submit_is_enabled();
+}
+
+/* Wait until the GPU has finished a frame's work on every queue */
+static VkResult wait_frame_timelines(uint64_t frame_number, uint64_t timeout) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    const uint64_t* frame_values = g_sync_state.frame_values[frame_number % VE_MAX_FRAMES_IN_FLIGHT];
+
+    VkSemaphore semaphores[VE_SUBMIT_QUEUE_COUNT];
+    uint64_t values[VE_SUBMIT_QUEUE_COUNT];
+    uint32_t count = 0;
+
+    for (uint32_t queue = 0; queue < VE_SUBMIT_QUEUE_COUNT; queue++) {
+        /* Queues the frame did not submit to have nothing to wait for */
+        if (frame_values[queue] == 0) {
+            continue;
+        }
+        semaphores[count] = ve_submit_get_timeline((ve_command_buffer_type)queue);
+        values[count] = frame_values[queue];
+        count++;
+    }
+
+    if (count == 0) {
+        return VK_SUCCESS;
+    }
+
+    VkSemaphoreWaitInfo wait_info = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+        .semaphoreCount = count,
+        .pSemaphores = semaphores,
+        .pValues = values,
+    };
+
+    return vkWaitSemaphores(vk->device, &wait_info, timeout);
+}
+
+/* Advance the completed-frame counter past every frame the timelines have reached */
+static void update_completed_frames(void) {
+    uint64_t completed[VE_SUBMIT_QUEUE_COUNT];
+    for (uint32_t queue = 0; queue < VE_SUBMIT_QUEUE_COUNT; queue++) {
+        completed[queue] = ve_submit_get_completed_value((ve_command_buffer_type)queue);
+    }
+
+    while (g_sync_state.completed_frames < g_sync_state.frame_number) {
+        const uint64_t* frame_values =
+            g_sync_state.frame_values[g_sync_state.completed_frames % VE_MAX_FRAMES_IN_FLIGHT];
+
+        for (uint32_t queue = 0; queue < VE_SUBMIT_QUEUE_COUNT; queue++) {
+            if (frame_values[queue] > completed[queue]) {
+                return;
+            }
+        }
+        g_sync_state.completed_frames++;
+    }
+}
+
 VkResult ve_sync_wait_for_frame(uint64_t timeout) {
-    ve_frame_sync* frame = ve_sync_get_current_frame();
-    return ve_sync_wait_for_fences(frame->render_fence, timeout);
+    VkResult result = VK_SUCCESS;
+
+    if (timeline_pacing()) {
+        /* Frame N reuses the slot of frame N - frames_in_flight */
+        if (g_sync_state.frame_number >= g_sync_state.frames_in_flight) {
+            uint64_t previous = g_sync_state.frame_number - g_sync_state.frames_in_flight;
+            if (g_sync_state.completed_frames <= previous) {
+                result = wait_frame_timelines(previous, timeout);
+            }
+        }
+        if (result == VK_SUCCESS) {
+            update_completed_frames();
+        }
+    } else {
+        ve_frame_sync* frame = ve_sync_get_current_frame();
+        result = ve_sync_wait_for_fences(frame->render_fence, timeout);
+
+        /* Every frame up to the one that last used this slot has finished */
+        if (result == VK_SUCCESS && g_sync_state.frame_number >= g_sync_state.frames_in_flight) {
+            uint64_t completed = g_sync_state.frame_number - g_sync_state.frames_in_flight + 1;
+            if (completed > g_sync_state.completed_frames) {
+                g_sync_state.completed_frames = completed;
+            }
+        }
+    }
+
+    /* The GPU is done with this slot, recycle its frame memory and read its queries */
+    if (result == VK_SUCCESS) {
+        ve_frame_allocator_begin(g_sync_state.current_frame);
+        ve_command_buffer_reset_frame(g_sync_state.current_frame);
+        ve_descriptor_reset_frame(g_sync_state.current_frame);
+        ve_deletion_queue_collect(g_sync_state.frame_number, g_sync_state.completed_frames);
+        ve_gpu_profiler_collect(g_sync_state.current_frame);
+        ve_gpu_stats_collect(g_sync_state.current_frame);
+    }
+
+    return result;
 }
 
 VkResult ve_sync_reset_frame(void) {
+    /* Timeline pacing never waits on the render fence */
+    if (timeline_pacing()) {
+        return VK_SUCCESS;
+    }
+
     ve_frame_sync* frame = ve_sync_get_current_frame();
     return ve_sync_reset_fences(frame->render_fence);
 }
 
 void ve_sync_advance_frame(void) {
-    g_sync_state.current_frame = (g_sync_state.current_frame + 1) % VE_MAX_FRAMES_IN_FLIGHT;
+    /* Remember what the finished frame submitted so its slot can be waited on */
+    uint64_t* frame_values = g_sync_state.frame_values[g_sync_state.frame_number % VE_MAX_FRAMES_IN_FLIGHT];
+    for (uint32_t queue = 0; queue < VE_SUBMIT_QUEUE_COUNT; queue++) {
+        frame_values[queue] = timeline_pacing()
+            ? ve_submit_get_submitted_value((ve_command_buffer_type)queue)
+            : 0;
+    }
+
+    g_sync_state.frame_number++;
+    g_sync_state.current_frame = (uint32_t)(g_sync_state.frame_number % g_sync_state.frames_in_flight);
+}
+
+uint64_t ve_sync_get_frame_number(void) {
+    return g_sync_state.frame_number;
+}
+
+uint64_t ve_sync_get_completed_frame_count(void) {
+    if (timeline_pacing()) {
+        update_completed_frames();
+    }
+    return g_sync_state.completed_frames;
+}
+
+uint32_t ve_sync_get_frames_in_flight(void) {
+    return g_sync_state.frames_in_flight;
+}
+
+VkResult ve_sync_set_frames_in_flight(uint32_t count) {
+    if (count == 0 || count > VE_MAX_FRAMES_IN_FLIGHT) {
+        VE_LOG_ERROR("Frames in flight must be between 1 and %d, got %u", VE_MAX_FRAMES_IN_FLIGHT, count);
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    if (count == g_sync_state.frames_in_flight) {
+        return VK_SUCCESS;
+    }
+
+    /* Slots are remapped, so drain the frames still in flight first */
+    VkResult result = VK_SUCCESS;
+    if (timeline_pacing()) {
+        if (g_sync_state.frame_number > 0) {
+            result = wait_frame_timelines(g_sync_state.frame_number - 1, UINT64_MAX);
+        }
+        if (result == VK_SUCCESS) {
+            update_completed_frames();
+        }
+    } else {
+        ve_vulkan_context* vk = ve_vulkan_get_context();
+        VkFence fences[VE_MAX_FRAMES_IN_FLIGHT];
+        for (uint32_t i = 0; i < g_sync_state.frames_in_flight; i++) {
+            fences[i] = g_sync_state.frames[i].render_fence;
+        }
+        result = vkWaitForFences(vk->device, g_sync_state.frames_in_flight, fences, VK_TRUE, UINT64_MAX);
+        if (result == VK_SUCCESS) {
+            g_sync_state.completed_frames = g_sync_state.frame_number;
+        }
+    }
+
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to drain frames in flight: %d", result);
+        return result;
+    }
+
+    g_sync_state.frames_in_flight = count;
+    g_sync_state.current_frame = (uint32_t)(g_sync_state.frame_number % count);
+    VE_LOG_INFO("Frames in flight set to %u", count);
+    return VK_SUCCESS;
 }
 
 uint32_t ve_sync_get_current_frame_index(void) {
@@ -32,8 +32,15 @@ typedef struct ve_frame_sync {
  */
 typedef struct ve_sync_state {
     ve_frame_sync frames[VE_MAX_FRAMES_IN_FLIGHT];
-    uint32_t current_frame;
+    uint32_t current_frame;         /* Slot of the frame being recorded */
+    uint32_t frames_in_flight;      /* Runtime setting, at most VE_MAX_FRAMES_IN_FLIGHT */
+    uint64_t frame_number;          /* Frames recorded before the current one */
+    uint64_t completed_frames;      /* Frames whose GPU work has finished */
     bool timeline_semaphores;
+
+    /* Submission timeline values (graphics, compute, transfer) reached by each
+     * recent frame, indexed by frame number */
+    uint64_t frame_values[VE_MAX_FRAMES_IN_FLIGHT][3];
 } ve_sync_state;
 
 /**
@@ -81,7 +88,19 @@ VkResult ve_sync_wait_for_fences(VkFence fence, uint64_t timeout);
 VkResult ve_sync_reset_fences(VkFence fence);
 
 /**
- * @brief Wait for current frame fence
+ * @brief Wait until the current frame's slot is free
+ *
+ * Frame N reuses the slot of frame N - frames_in_flight. When the
+ * submission batcher is enabled (ve_submit_init), frames are paced on its
+ * per-queue timeline semaphores: the wait is for the timeline values that
+ * frame reached, and the per-frame fences are unused. Otherwise this waits
+ * on the slot's render fence.
+ *
+ * On success the current slot of the frame allocator and the slot's
+ * command pools are reset, see ve_frame_allocate and
+ * ve_command_buffer_reset_frame, resources retired by completed frames are
+ * destroyed (ve_deletion_queue_collect), and the slot's GPU timestamps and
+ * statistics are collected.
  *
  * @param timeout Timeout in nanoseconds
  * @return VK_SUCCESS on success
@@ -91,15 +110,55 @@ VkResult ve_sync_wait_for_frame(uint64_t timeout);
 /**
  * @brief Reset current frame fences
  *
+ * Does nothing when frames are paced on timeline semaphores.
+ *
  * @return VK_SUCCESS on success
  */
 VkResult ve_sync_reset_frame(void);
 
 /**
  * @brief Advance to next frame
+ *
+ * Called after the frame's work has been submitted, so the timeline values
+ * it reached can be recorded.
  */
 void ve_sync_advance_frame(void);
 
+/**
+ * @brief Get the number of the frame being recorded
+ *
+ * @return Frames recorded before the current one
+ */
+uint64_t ve_sync_get_frame_number(void);
+
+/**
+ * @brief Get the GPU completed-frame counter
+ *
+ * Work recorded in frame N has finished on the GPU once this exceeds N,
+ * which is what deletion queues and frame arenas key off.
+ *
+ * @return Number of frames whose GPU work has finished
+ */
+uint64_t ve_sync_get_completed_frame_count(void);
+
+/**
+ * @brief Get the number of frames the CPU may record ahead of the GPU
+ *
+ * @return Frames in flight
+ */
+uint32_t ve_sync_get_frames_in_flight(void);
+
+/**
+ * @brief Change the number of frames in flight at runtime
+ *
+ * Waits for the frames still in flight, then remaps frame slots. Per-frame
+ * resources stay sized for VE_MAX_FRAMES_IN_FLIGHT.
+ *
+ * @param count Frames in flight, 1 to VE_MAX_FRAMES_IN_FLIGHT
+ * @return VK_SUCCESS on success
+ */
+VkResult ve_sync_set_frames_in_flight(uint32_t count);
+
 /**
  * @brief Get current frame index
  *
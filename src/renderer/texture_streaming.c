@@ -0,0 +1,642 @@
+/**
+ * @file texture_streaming.c
+ * @brief Mip streaming implementation
+ */
+
+#define VK_NO_PROTOTYPES
+#include "texture_streaming.h"
+
+#include "deletion_queue.h"
+#include "descriptor.h"
+#include "image.h"
+#include "upload.h"
+#include "../core/logger.h"
+#include "../core/assert.h"
+#include "../core/memory.h"
+#include "../core/thread.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STREAMING_GENERATION_MASK ((1u << (32 - VE_STREAMED_TEXTURE_INDEX_BITS)) - 1)
+#define STREAMING_NONE UINT32_MAX
+#define STREAMING_MAX_NAME 64
+
+/* Default live textures */
+#define STREAMING_DEFAULT_MAX_TEXTURES 4096
+
+/**
+ * @brief Mips of a texture in one image
+ */
+typedef struct streamed_image {
+    ve_image image;
+    uint32_t first_mip;             /* Texture mip in image level 0 */
+    VkDeviceSize size;
+} streamed_image;
+
+/**
+ * @brief One streamed texture
+ */
+typedef struct texture_slot {
+    bool live;
+    bool decompress;                /* Decoded to RGBA8 on upload, the device samples no variant */
+    bool has_pending;
+    bool queued;                    /* Every pending mip is in the staging ring */
+    uint32_t generation;
+    uint32_t next_free;
+
+    ve_texture_data data;
+    const ve_texture_variant* variant;
+    VkFormat format;
+    uint32_t bindless_index;
+    uint32_t tail_mip;              /* Finest mip of the resident tail */
+    uint32_t wanted_mip;
+    uint32_t idle_updates;
+    ve_atomic_int32 requested;      /* Largest screen size since the last update, as float bits */
+
+    bool has_current;
+    streamed_image current;         /* Bound to the index */
+    streamed_image pending;         /* Being uploaded */
+    uint32_t next_upload;           /* Next pending mip to queue, counting down */
+    uint64_t fence;
+
+    char name[STREAMING_MAX_NAME];
+} texture_slot;
+
+/**
+ * @brief Upgrade candidate of one update
+ */
+typedef struct streaming_candidate {
+    uint32_t slot;
+    uint32_t missing;               /* Levels between the resident and the wanted mip */
+} streaming_candidate;
+
+/* Global streaming state */
+static struct {
+    bool initialized;
+    ve_texture_streaming_config config;
+    uint32_t supported_families;    /* ve_texture_family flags */
+
+    ve_image placeholder;
+
+    texture_slot* slots;
+    uint32_t slot_count;
+    uint32_t free_slot;
+    uint32_t texture_count;
+    streaming_candidate* candidates;
+
+    VkDeviceSize resident_size;
+    VkDeviceSize uploaded_this_update;
+    uint32_t starved;
+    uint64_t uploaded_bytes;
+    uint64_t upgrades;
+    uint64_t downgrades;
+} g_streaming = {0};
+
+/* Vulkan format of each texture format */
+static const VkFormat g_vk_formats[VE_TEXTURE_FORMAT_COUNT] = {
+    [VE_TEXTURE_FORMAT_RGBA8_UNORM] = VK_FORMAT_R8G8B8A8_UNORM,
+    [VE_TEXTURE_FORMAT_RGBA8_SRGB] = VK_FORMAT_R8G8B8A8_SRGB,
+    [VE_TEXTURE_FORMAT_BC1_UNORM] = VK_FORMAT_BC1_RGB_UNORM_BLOCK,
+    [VE_TEXTURE_FORMAT_BC1_SRGB] = VK_FORMAT_BC1_RGB_SRGB_BLOCK,
+    [VE_TEXTURE_FORMAT_BC3_UNORM] = VK_FORMAT_BC3_UNORM_BLOCK,
+    [VE_TEXTURE_FORMAT_BC3_SRGB] = VK_FORMAT_BC3_SRGB_BLOCK,
+    [VE_TEXTURE_FORMAT_ETC2_RGB8_UNORM] = VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK,
+    [VE_TEXTURE_FORMAT_ETC2_RGB8_SRGB] = VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK,
+    [VE_TEXTURE_FORMAT_ETC2_RGBA8_UNORM] = VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK,
+    [VE_TEXTURE_FORMAT_ETC2_RGBA8_SRGB] = VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK,
+    [VE_TEXTURE_FORMAT_ASTC_4x4_UNORM] = VK_FORMAT_ASTC_4x4_UNORM_BLOCK,
+    [VE_TEXTURE_FORMAT_ASTC_4x4_SRGB] = VK_FORMAT_ASTC_4x4_SRGB_BLOCK,
+};
+
+static bool is_sampleable(VkFormat format) {
+    return ve_vulkan_is_format_supported(format, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+}
+
+static void destroy_image_deferred(void* user_data) {
+    ve_image* image = (ve_image*)user_data;
+    ve_image_destroy(image);
+    VE_FREE(image);
+}
+
+/**
+ * @brief Release an image once frames in flight are done with it
+ */
+static void release_image(streamed_image* image) {
+    g_streaming.resident_size -= image->size;
+    ve_image* pending = (ve_image*)VE_ALLOCATE_TAG(sizeof(ve_image), VE_MEMORY_TAG_TEXTURE);
+    if (pending) {
+        *pending = image->image;
+        ve_deletion_queue_push_callback(destroy_image_deferred, pending);
+    } else {
+        VE_LOG_ERROR("Out of memory deferring texture release, leaking it");
+    }
+    memset(image, 0, sizeof(streamed_image));
+}
+
+static texture_slot* get_slot(ve_streamed_texture texture) {
+    uint32_t index = texture & (VE_STREAMED_TEXTURE_MAX - 1);
+    if (texture == VE_STREAMED_TEXTURE_NULL || index >= g_streaming.slot_count) {
+        return NULL;
+    }
+    texture_slot* slot = &g_streaming.slots[index];
+    if (!slot->live || slot->generation != texture >> VE_STREAMED_TEXTURE_INDEX_BITS) {
+        return NULL;
+    }
+    return slot;
+}
+
+/* Bytes of the mips from first_mip down to 1x1 */
+static VkDeviceSize get_chain_size(const texture_slot* slot, uint32_t first_mip) {
+    VkDeviceSize size = 0;
+    for (uint32_t i = first_mip; i < slot->variant->mip_count; i++) {
+        const ve_texture_mip* mip = &slot->variant->mips[i];
+        size += slot->decompress ? (VkDeviceSize)mip->width * mip->height * 4 : mip->size;
+    }
+    return size;
+}
+
+/* Coarsest mip still at least screen_size texels across */
+static uint32_t get_wanted_mip(const texture_slot* slot, float screen_size) {
+    float largest = (float)(slot->data.width > slot->data.height ? slot->data.width : slot->data.height);
+    if (screen_size >= largest) {
+        return 0;
+    }
+    uint32_t mip = (uint32_t)floorf(log2f(largest / screen_size));
+    return mip < slot->tail_mip ? mip : slot->tail_mip;
+}
+
+/* Mip the texture is at, or is becoming */
+static uint32_t get_target_mip(const texture_slot* slot) {
+    if (slot->has_pending) {
+        return slot->pending.first_mip;
+    }
+    return slot->has_current ? slot->current.first_mip : slot->variant->mip_count;
+}
+
+/**
+ * @brief Queue the remaining mips of a pending image, coarsest first
+ *
+ * @return false if the staging ring filled up; the rest is queued next update
+ */
+static bool queue_pending_mips(texture_slot* slot) {
+    while (slot->next_upload != STREAMING_NONE) {
+        uint32_t mip_index = slot->next_upload;
+        const ve_texture_mip* mip = &slot->variant->mips[mip_index];
+        const uint8_t* data = slot->data.blob + mip->offset;
+        VkDeviceSize size = mip->size;
+
+        uint8_t* decoded = NULL;
+        if (slot->decompress) {
+            size = (VkDeviceSize)mip->width * mip->height * 4;
+            decoded = (uint8_t*)VE_ALLOCATE_TAG((size_t)size, VE_MEMORY_TAG_TEXTURE);
+            if (!decoded || !ve_texture_decompress((ve_texture_format)slot->variant->format, data, mip->width,
+                                                   mip->height, decoded)) {
+                VE_FREE(decoded);
+                return false;
+            }
+            data = decoded;
+        }
+
+        ve_upload_image_region region = {
+            .image = slot->pending.image.image,
+            .aspect = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mip_level = mip_index - slot->pending.first_mip,
+            .extent = {mip->width, mip->height, 1},
+            .final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        };
+        bool queued = ve_upload_image(&region, data, size);
+        VE_FREE(decoded);
+        if (!queued) {
+            return false;
+        }
+
+        g_streaming.uploaded_this_update += size;
+        g_streaming.uploaded_bytes += size;
+        slot->next_upload = mip_index == slot->pending.first_mip ? STREAMING_NONE : mip_index - 1;
+    }
+    slot->queued = true;
+    return true;
+}
+
+/**
+ * @brief Create the image for a new resident mip and start uploading it
+ *
+ * @return false if the image cannot be created
+ */
+static bool begin_transition(texture_slot* slot, uint32_t first_mip) {
+    VE_ASSERT(!slot->has_pending && first_mip < slot->variant->mip_count);
+
+    uint32_t previous_mip = get_target_mip(slot);
+
+    const ve_texture_mip* mip = &slot->variant->mips[first_mip];
+    ve_image_config config = {
+        .width = mip->width,
+        .height = mip->height,
+        .mip_levels = slot->variant->mip_count - first_mip,
+        .format = slot->format,
+        .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .aspect = VK_IMAGE_ASPECT_COLOR_BIT,
+        .memory_usage = VE_GPU_MEMORY_USAGE_GPU_ONLY,
+        .debug_name = slot->name[0] ? slot->name : NULL,
+    };
+    if (ve_image_create(&config, &slot->pending.image) != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to create streamed texture image %s", slot->name);
+        return false;
+    }
+
+    slot->pending.first_mip = first_mip;
+    slot->pending.size = get_chain_size(slot, first_mip);
+    slot->has_pending = true;
+    slot->queued = false;
+    slot->next_upload = slot->variant->mip_count - 1;
+    slot->fence = 0;
+    g_streaming.resident_size += slot->pending.size;
+
+    if (first_mip > previous_mip) {
+        g_streaming.downgrades++;
+    } else {
+        g_streaming.upgrades++;
+    }
+    queue_pending_mips(slot);
+    return true;
+}
+
+/* Point the index at a pending image whose upload has completed */
+static void complete_transition(texture_slot* slot) {
+    ve_bindless_update_image(slot->bindless_index, slot->pending.image.view,
+                             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    if (slot->has_current) {
+        release_image(&slot->current);
+    }
+    slot->current = slot->pending;
+    slot->has_current = true;
+    slot->has_pending = false;
+    memset(&slot->pending, 0, sizeof(streamed_image));
+}
+
+/* Most missing levels first */
+static int compare_candidates(const void* a, const void* b) {
+    const streaming_candidate* first = (const streaming_candidate*)a;
+    const streaming_candidate* second = (const streaming_candidate*)b;
+    if (first->missing != second->missing) {
+        return first->missing > second->missing ? -1 : 1;
+    }
+    return first->slot < second->slot ? -1 : first->slot > second->slot;
+}
+
+VkResult ve_texture_streaming_init(const ve_texture_streaming_config* config) {
+    if (g_streaming.initialized) {
+        VE_LOG_WARN("Texture streaming already initialized");
+        return VK_SUCCESS;
+    }
+    if (!ve_bindless_is_enabled() || !ve_upload_is_enabled()) {
+        VE_LOG_INFO("Texture streaming needs bindless descriptors and the staging ring, disabled");
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    memset(&g_streaming, 0, sizeof(g_streaming));
+    if (config) {
+        g_streaming.config = *config;
+    }
+    ve_texture_streaming_config* settings = &g_streaming.config;
+    if (settings->memory_budget == 0) {
+        settings->memory_budget = VE_TEXTURE_STREAMING_MEMORY_BUDGET;
+    }
+    if (settings->upload_budget == 0) {
+        settings->upload_budget = VE_TEXTURE_STREAMING_UPLOAD_BUDGET;
+    }
+    if (settings->tail_size == 0) {
+        settings->tail_size = VE_TEXTURE_STREAMING_TAIL_SIZE;
+    }
+    if (settings->eviction_delay == 0) {
+        settings->eviction_delay = VE_TEXTURE_STREAMING_EVICTION_DELAY;
+    }
+    if (settings->max_textures == 0) {
+        settings->max_textures = STREAMING_DEFAULT_MAX_TEXTURES;
+    }
+    if (settings->max_textures > VE_STREAMED_TEXTURE_MAX - 1) {
+        settings->max_textures = VE_STREAMED_TEXTURE_MAX - 1;
+    }
+
+    /* A family counts if the device enables it and samples its formats */
+    const vulkan_device_features* features = &ve_vulkan_get_context()->device_features;
+    g_streaming.supported_families = VE_TEXTURE_FAMILY_RGBA8;
+    if (features->textureCompressionBC && is_sampleable(VK_FORMAT_BC1_RGB_SRGB_BLOCK)) {
+        g_streaming.supported_families |= VE_TEXTURE_FAMILY_BC;
+    }
+    if (features->textureCompressionETC2 && is_sampleable(VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK)) {
+        g_streaming.supported_families |= VE_TEXTURE_FAMILY_ETC2;
+    }
+    if (features->textureCompressionASTC_LDR && is_sampleable(VK_FORMAT_ASTC_4x4_SRGB_BLOCK)) {
+        g_streaming.supported_families |= VE_TEXTURE_FAMILY_ASTC;
+    }
+
+    /* Slot 0 is never used, so no handle is VE_STREAMED_TEXTURE_NULL */
+    g_streaming.slot_count = settings->max_textures + 1;
+    g_streaming.slots = (texture_slot*)ve_allocate_cleared(g_streaming.slot_count, sizeof(texture_slot),
+                                                           VE_MEMORY_TAG_TEXTURE);
+    g_streaming.candidates = (streaming_candidate*)VE_ALLOCATE_TAG(
+        g_streaming.slot_count * sizeof(streaming_candidate), VE_MEMORY_TAG_TEXTURE);
+    if (!g_streaming.slots || !g_streaming.candidates) {
+        VE_LOG_ERROR("Failed to allocate streamed texture slots");
+        VE_FREE(g_streaming.slots);
+        VE_FREE(g_streaming.candidates);
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+    g_streaming.free_slot = STREAMING_NONE;
+    for (uint32_t i = g_streaming.slot_count - 1; i > 0; i--) {
+        g_streaming.slots[i].generation = 1;
+        g_streaming.slots[i].next_free = g_streaming.free_slot;
+        g_streaming.free_slot = i;
+    }
+
+    /* Mid gray until a texture's tail arrives */
+    ve_image_config placeholder_config = {
+        .width = 1,
+        .height = 1,
+        .format = VK_FORMAT_R8G8B8A8_UNORM,
+        .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .aspect = VK_IMAGE_ASPECT_COLOR_BIT,
+        .memory_usage = VE_GPU_MEMORY_USAGE_GPU_ONLY,
+        .debug_name = "Streaming Placeholder",
+    };
+    VkResult result = ve_image_create(&placeholder_config, &g_streaming.placeholder);
+    if (result == VK_SUCCESS) {
+        static const uint8_t gray[4] = {128, 128, 128, 255};
+        ve_upload_image_region region = {
+            .image = g_streaming.placeholder.image,
+            .aspect = VK_IMAGE_ASPECT_COLOR_BIT,
+            .extent = {1, 1, 1},
+            .final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        };
+        if (!ve_upload_image(&region, gray, sizeof(gray))) {
+            ve_image_destroy(&g_streaming.placeholder);
+            result = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        }
+    }
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to create streaming placeholder");
+        VE_FREE(g_streaming.slots);
+        VE_FREE(g_streaming.candidates);
+        return result;
+    }
+    ve_upload_flush();
+
+    g_streaming.initialized = true;
+    VE_LOG_INFO("Texture streaming initialized (%llu MB budget, families 0x%x)",
+                (unsigned long long)(settings->memory_budget / (1024 * 1024)), g_streaming.supported_families);
+    return VK_SUCCESS;
+}
+
+void ve_texture_streaming_shutdown(void) {
+    if (!g_streaming.initialized) {
+        return;
+    }
+
+    /* The device is idle, so images go at once */
+    for (uint32_t i = 1; i < g_streaming.slot_count; i++) {
+        texture_slot* slot = &g_streaming.slots[i];
+        if (!slot->live) {
+            continue;
+        }
+        ve_bindless_release(VE_BINDLESS_SAMPLED_IMAGES, slot->bindless_index);
+        if (slot->has_current) {
+            ve_image_destroy(&slot->current.image);
+        }
+        if (slot->has_pending) {
+            ve_image_destroy(&slot->pending.image);
+        }
+    }
+
+    ve_image_destroy(&g_streaming.placeholder);
+    VE_FREE(g_streaming.slots);
+    VE_FREE(g_streaming.candidates);
+    memset(&g_streaming, 0, sizeof(g_streaming));
+    VE_LOG_INFO("Texture streaming shutdown");
+}
+
+bool ve_texture_streaming_is_enabled(void) {
+    return g_streaming.initialized;
+}
+
+ve_streamed_texture ve_texture_streaming_create(const ve_texture_data* data, const char* debug_name) {
+    VE_ASSERT(g_streaming.initialized && data);
+
+    /* The best variant the device samples, else one the CPU can decode */
+    bool decompress = false;
+    int32_t variant = ve_texture_select_variant(data, g_streaming.supported_families);
+    if (variant >= 0 && !is_sampleable(g_vk_formats[data->variants[variant].format])) {
+        variant = -1;
+    }
+    for (uint32_t i = 0; variant < 0 && i < data->variant_count; i++) {
+        if (ve_texture_format_get_family((ve_texture_format)data->variants[i].format) != VE_TEXTURE_FAMILY_ASTC) {
+            variant = (int32_t)i;
+            decompress = true;
+        }
+    }
+    if (variant < 0) {
+        VE_LOG_ERROR("Texture %s has no variant this device can sample", debug_name ? debug_name : "");
+        return VE_STREAMED_TEXTURE_NULL;
+    }
+
+    if (g_streaming.free_slot == STREAMING_NONE) {
+        VE_LOG_ERROR("Streamed texture limit (%u) reached", g_streaming.config.max_textures);
+        return VE_STREAMED_TEXTURE_NULL;
+    }
+    uint32_t bindless_index = ve_bindless_register_image(g_streaming.placeholder.view,
+                                                         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    if (bindless_index == VE_BINDLESS_INVALID_INDEX) {
+        VE_LOG_ERROR("Bindless texture table is full");
+        return VE_STREAMED_TEXTURE_NULL;
+    }
+
+    uint32_t index = g_streaming.free_slot;
+    texture_slot* slot = &g_streaming.slots[index];
+    g_streaming.free_slot = slot->next_free;
+    uint32_t generation = slot->generation;
+    memset(slot, 0, sizeof(texture_slot));
+    slot->live = true;
+    slot->generation = generation;
+    slot->data = *data;
+    slot->variant = &data->variants[variant];
+    slot->decompress = decompress;
+    ve_texture_format format = (ve_texture_format)slot->variant->format;
+    if (decompress) {
+        format = ve_texture_format_is_srgb(format) ? VE_TEXTURE_FORMAT_RGBA8_SRGB : VE_TEXTURE_FORMAT_RGBA8_UNORM;
+    }
+    slot->format = g_vk_formats[format];
+    slot->bindless_index = bindless_index;
+    if (debug_name) {
+        strncpy(slot->name, debug_name, STREAMING_MAX_NAME - 1);
+    }
+
+    /* The tail starts at the first mip no larger than the tail size */
+    slot->tail_mip = slot->variant->mip_count - 1;
+    while (slot->tail_mip > 0 && slot->variant->mips[slot->tail_mip - 1].width <= g_streaming.config.tail_size &&
+           slot->variant->mips[slot->tail_mip - 1].height <= g_streaming.config.tail_size) {
+        slot->tail_mip--;
+    }
+    slot->wanted_mip = slot->tail_mip;
+
+    g_streaming.texture_count++;
+    return (generation << VE_STREAMED_TEXTURE_INDEX_BITS) | index;
+}
+
+void ve_texture_streaming_destroy(ve_streamed_texture texture) {
+    texture_slot* slot = get_slot(texture);
+    if (!slot) {
+        return;
+    }
+
+    /* Uploads are flushed by every update, so none still targets these images */
+    ve_bindless_release(VE_BINDLESS_SAMPLED_IMAGES, slot->bindless_index);
+    if (slot->has_current) {
+        release_image(&slot->current);
+    }
+    if (slot->has_pending) {
+        release_image(&slot->pending);
+    }
+
+    uint32_t index = (uint32_t)(slot - g_streaming.slots);
+    slot->live = false;
+    slot->generation = (slot->generation + 1) & STREAMING_GENERATION_MASK;
+    if (slot->generation == 0) {
+        slot->generation = 1;
+    }
+    slot->next_free = g_streaming.free_slot;
+    g_streaming.free_slot = index;
+    g_streaming.texture_count--;
+}
+
+void ve_texture_streaming_request(ve_streamed_texture texture, float screen_size) {
+    texture_slot* slot = get_slot(texture);
+    if (!slot || !(screen_size > 0.0f)) {
+        return;
+    }
+
+    /* Positive floats order like their bits */
+    int32_t bits;
+    memcpy(&bits, &screen_size, sizeof(bits));
+    int32_t current = ve_atomic_load32(&slot->requested);
+    while (bits > current && !ve_atomic_compare_exchange32(&slot->requested, &current, bits)) {
+    }
+}
+
+uint32_t ve_texture_streaming_get_index(ve_streamed_texture texture) {
+    const texture_slot* slot = get_slot(texture);
+    return slot ? slot->bindless_index : VE_BINDLESS_INVALID_INDEX;
+}
+
+uint32_t ve_texture_streaming_get_resident_mip(ve_streamed_texture texture) {
+    const texture_slot* slot = get_slot(texture);
+    if (!slot) {
+        return 0;
+    }
+    return slot->has_current ? slot->current.first_mip : slot->variant->mip_count;
+}
+
+void ve_texture_streaming_update(void) {
+    if (!g_streaming.initialized) {
+        return;
+    }
+
+    const ve_texture_streaming_config* config = &g_streaming.config;
+    g_streaming.uploaded_this_update = 0;
+    g_streaming.starved = 0;
+    bool queued_any = false;
+    uint32_t candidate_count = 0;
+
+    for (uint32_t i = 1; i < g_streaming.slot_count; i++) {
+        texture_slot* slot = &g_streaming.slots[i];
+        if (!slot->live) {
+            continue;
+        }
+
+        /* Swap in completed uploads, and keep queueing ones the ring could not take */
+        if (slot->has_pending && slot->queued && ve_upload_is_complete(slot->fence)) {
+            complete_transition(slot);
+        } else if (slot->has_pending && !slot->queued) {
+            queue_pending_mips(slot);
+            queued_any = true;
+        }
+
+        int32_t bits = ve_atomic_load32(&slot->requested);
+        while (bits != 0 && !ve_atomic_compare_exchange32(&slot->requested, &bits, 0)) {
+        }
+        if (bits != 0) {
+            float screen_size;
+            memcpy(&screen_size, &bits, sizeof(screen_size));
+            slot->wanted_mip = get_wanted_mip(slot, screen_size);
+            slot->idle_updates = 0;
+        } else if (slot->idle_updates < config->eviction_delay) {
+            slot->idle_updates++;
+        } else {
+            slot->wanted_mip = slot->tail_mip;
+        }
+        if (slot->has_pending) {
+            continue;
+        }
+
+        /* New textures get their tail and unneeded mips go at once; upgrades wait their turn */
+        uint32_t target = get_target_mip(slot);
+        uint32_t wanted = slot->wanted_mip;
+        if (target == slot->variant->mip_count) {
+            queued_any |= begin_transition(slot, slot->tail_mip);
+        } else if (wanted > target) {
+            queued_any |= begin_transition(slot, wanted);
+        } else if (wanted < target) {
+            g_streaming.candidates[candidate_count++] = (streaming_candidate){i, target - wanted};
+        }
+    }
+
+    /* One level finer per texture, neediest first, while the budgets last */
+    qsort(g_streaming.candidates, candidate_count, sizeof(streaming_candidate), compare_candidates);
+    for (uint32_t i = 0; i < candidate_count; i++) {
+        texture_slot* slot = &g_streaming.slots[g_streaming.candidates[i].slot];
+        uint32_t first_mip = get_target_mip(slot) - 1;
+        VkDeviceSize size = get_chain_size(slot, first_mip);
+        bool over_upload = g_streaming.uploaded_this_update > 0 &&
+                           g_streaming.uploaded_this_update + size > config->upload_budget;
+        if (over_upload || g_streaming.resident_size + size > config->memory_budget) {
+            g_streaming.starved = candidate_count - i;
+            break;
+        }
+        queued_any |= begin_transition(slot, first_mip);
+    }
+
+    /* Every queued mip is flushed, so one fence covers the images that finished queueing */
+    if (queued_any) {
+        uint64_t fence = ve_upload_flush();
+        for (uint32_t i = 1; i < g_streaming.slot_count; i++) {
+            texture_slot* slot = &g_streaming.slots[i];
+            if (slot->live && slot->has_pending && slot->queued && slot->fence == 0) {
+                slot->fence = fence;
+            }
+        }
+    }
+}
+
+void ve_texture_streaming_get_stats(ve_texture_streaming_stats* stats) {
+    VE_ASSERT(stats);
+
+    memset(stats, 0, sizeof(ve_texture_streaming_stats));
+    if (!g_streaming.initialized) {
+        return;
+    }
+    for (uint32_t i = 1; i < g_streaming.slot_count; i++) {
+        if (g_streaming.slots[i].live && g_streaming.slots[i].has_pending) {
+            stats->pending++;
+        }
+    }
+    stats->texture_count = g_streaming.texture_count;
+    stats->starved = g_streaming.starved;
+    stats->resident_size = g_streaming.resident_size;
+    stats->memory_budget = g_streaming.config.memory_budget;
+    stats->uploaded_bytes = g_streaming.uploaded_bytes;
+    stats->upgrades = g_streaming.upgrades;
+    stats->downgrades = g_streaming.downgrades;
+}
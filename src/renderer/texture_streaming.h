@@ -0,0 +1,172 @@
+/**
+ * @file texture_streaming.h
+ * @brief Mip streaming of cooked textures
+ *
+ * A streamed texture keeps only the mips its on-screen size needs in
+ * video memory. Each texture owns one bindless index for its lifetime;
+ * shaders sample through it without knowing which mips are resident.
+ * Behind the index is an image holding the mips from the resident level
+ * down to 1x1. Changing the resident level builds a new image, uploads
+ * its mips through the staging ring coarsest first, and swaps the index
+ * over once the transfer timeline reaches the upload, so sampling never
+ * sees a partially uploaded image. The old image is released when the
+ * frames still reading it have completed.
+ *
+ * Renderers report the size textures cover on screen each frame with
+ * ve_texture_streaming_request, from any thread. ve_texture_streaming_update
+ * turns the requests into one level finer at a time for the textures
+ * that gain the most detail, within a per-update upload budget and an
+ * overall memory budget, and drops textures nobody requested for a while
+ * back to their resident tail (the small mips every texture keeps).
+ *
+ * The variant uploaded is the best one the device samples (see
+ * ve_texture_select_variant); textures with none are decompressed to
+ * RGBA8 on the CPU as they stream. Requires bindless descriptors and the
+ * staging ring.
+ */
+
+#ifndef VE_TEXTURE_STREAMING_H
+#define VE_TEXTURE_STREAMING_H
+
+#include "vulkan_core.h"
+#include "../assets/texture_loader.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Texture handle layout: slot index in the low bits, generation above */
+#define VE_STREAMED_TEXTURE_INDEX_BITS 16
+#define VE_STREAMED_TEXTURE_MAX (1u << VE_STREAMED_TEXTURE_INDEX_BITS)
+
+/* Never a live texture */
+#define VE_STREAMED_TEXTURE_NULL 0u
+
+/* Defaults */
+#define VE_TEXTURE_STREAMING_MEMORY_BUDGET (256ull * 1024 * 1024)
+#define VE_TEXTURE_STREAMING_UPLOAD_BUDGET (8ull * 1024 * 1024)
+#define VE_TEXTURE_STREAMING_TAIL_SIZE 64
+#define VE_TEXTURE_STREAMING_EVICTION_DELAY 60
+
+typedef uint32_t ve_streamed_texture;
+
+/**
+ * @brief Streaming configuration
+ *
+ * Zeroed fields select the defaults.
+ */
+typedef struct ve_texture_streaming_config {
+    VkDeviceSize memory_budget;     /* Resident bytes of all textures */
+    VkDeviceSize upload_budget;     /* Bytes queued per update */
+    uint32_t tail_size;             /* Mips this size or smaller stay resident */
+    uint32_t eviction_delay;        /* Updates without requests before a texture drops to its tail */
+    uint32_t max_textures;          /* Live textures, at most VE_STREAMED_TEXTURE_MAX */
+} ve_texture_streaming_config;
+
+/**
+ * @brief Streaming statistics
+ */
+typedef struct ve_texture_streaming_stats {
+    uint32_t texture_count;
+    uint32_t pending;               /* Textures waiting for an upload to complete */
+    uint32_t starved;               /* Textures wanting finer mips than the budgets allowed */
+    VkDeviceSize resident_size;     /* Including pending images */
+    VkDeviceSize memory_budget;
+    uint64_t uploaded_bytes;
+    uint64_t upgrades;
+    uint64_t downgrades;
+} ve_texture_streaming_stats;
+
+/**
+ * @brief Initialize texture streaming
+ *
+ * @param config Configuration, NULL for the defaults
+ * @return VK_SUCCESS on success, VK_ERROR_FEATURE_NOT_PRESENT without bindless descriptors or the staging ring
+ */
+VkResult ve_texture_streaming_init(const ve_texture_streaming_config* config);
+
+/**
+ * @brief Destroy every texture and the placeholder
+ *
+ * The device must be idle.
+ */
+void ve_texture_streaming_shutdown(void);
+
+/**
+ * @brief Check if texture streaming is available
+ *
+ * @return true if initialized
+ */
+bool ve_texture_streaming_is_enabled(void);
+
+/**
+ * @brief Start streaming a cooked texture
+ *
+ * The texture samples as a placeholder until its resident tail has been
+ * uploaded. The data, typically from ve_texture_load_pak, must stay valid
+ * until the texture is destroyed. Main thread only.
+ *
+ * @param data Cooked texture
+ * @param debug_name Optional name for its images
+ * @return Texture, or VE_STREAMED_TEXTURE_NULL on failure
+ */
+ve_streamed_texture ve_texture_streaming_create(const ve_texture_data* data, const char* debug_name);
+
+/**
+ * @brief Stop streaming a texture and release its index
+ *
+ * Main thread only.
+ *
+ * @param texture Texture
+ */
+void ve_texture_streaming_destroy(ve_streamed_texture texture);
+
+/**
+ * @brief Report the size a texture covers on screen this frame
+ *
+ * The largest request since the last update wins. Thread safe.
+ *
+ * @param texture Texture
+ * @param screen_size Pixels covered along the texture's larger side
+ */
+void ve_texture_streaming_request(ve_streamed_texture texture, float screen_size);
+
+/**
+ * @brief Get the bindless index of a texture
+ *
+ * @param texture Texture
+ * @return Index into the bindless textures, VE_BINDLESS_INVALID_INDEX for stale handles
+ */
+uint32_t ve_texture_streaming_get_index(ve_streamed_texture texture);
+
+/**
+ * @brief Get the finest mip a texture samples
+ *
+ * @param texture Texture
+ * @return Mip level, or the mip count while only the placeholder is bound
+ */
+uint32_t ve_texture_streaming_get_resident_mip(ve_streamed_texture texture);
+
+/**
+ * @brief Stream mips in and out
+ *
+ * Swaps in completed uploads, then queues new ones and flushes the
+ * staging ring. Call once per frame on the frame thread, before the
+ * frame's graphics work is submitted.
+ */
+void ve_texture_streaming_update(void);
+
+/**
+ * @brief Get streaming statistics
+ *
+ * @param stats Output statistics
+ */
+void ve_texture_streaming_get_stats(ve_texture_streaming_stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_TEXTURE_STREAMING_H */
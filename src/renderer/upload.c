@@ -0,0 +1,564 @@
+/**
+ * @file upload.c
+ * @brief Staging ring and transfer-queue uploads implementation
+ */
+
+#define VK_NO_PROTOTYPES
+#include "upload.h"
+
+#include "buffer.h"
+#include "command_buffer.h"
+#include "submit.h"
+#include "../core/logger.h"
+#include "../core/assert.h"
+#include "../core/memory.h"
+#include "../core/thread.h"
+
+#include <string.h>
+
+/* Minimum staging offset alignment, covers every texel block size */
+#define VE_UPLOAD_MIN_ALIGNMENT 16
+
+/**
+ * @brief Copy waiting for the next flush
+ */
+typedef struct ve_upload_request {
+    bool is_image;
+    VkBuffer buffer;
+    VkBufferCopy buffer_copy;
+    ve_upload_image_region image;
+    VkBufferImageCopy image_copy;
+} ve_upload_request;
+
+/**
+ * @brief Flushed batch, owning the ring up to end until value completes
+ */
+typedef struct ve_upload_batch {
+    uint64_t value;
+    uint64_t end;
+} ve_upload_batch;
+
+/* Global upload state; ring positions are monotonic byte counters */
+static struct {
+    bool initialized;
+    ve_mutex* mutex;
+    ve_buffer ring;
+    uint8_t* mapped;
+    VkDeviceSize ring_size;
+    VkDeviceSize image_alignment;
+    uint64_t head;
+    uint64_t tail;
+
+    ve_upload_batch batches[VE_UPLOAD_MAX_BATCHES];
+    uint32_t batch_first;
+    uint32_t batch_count;
+    uint64_t last_value;
+
+    /* Queued requests, swapped with the recording array on flush */
+    ve_upload_request* requests;
+    uint32_t request_count;
+    uint32_t request_capacity;
+    ve_upload_request* recording;
+    uint32_t recording_capacity;
+
+    /* Requests whose data is still being copied into the ring, per array; flush waits for its array's */
+    ve_condvar* copied;
+    uint32_t copying[2];
+    uint32_t queue_index;           /* Index of the requests array */
+
+    /* Barrier scratch, sized to the recording array */
+    VkImageMemoryBarrier* image_barriers;
+    VkBufferMemoryBarrier* buffer_barriers;
+    uint32_t barrier_capacity;
+
+    ve_upload_stats stats;
+} g_upload = {0};
+
+VkResult ve_upload_init(VkDeviceSize ring_size) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    VE_ASSERT(vk && vk->device);
+
+    memset(&g_upload, 0, sizeof(g_upload));
+
+    if (!ve_submit_is_enabled()) {
+        VE_LOG_WARN("Upload ring disabled: requires timeline semaphores");
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    g_upload.ring_size = ring_size ? ring_size : VE_UPLOAD_RING_SIZE;
+
+    VkDeviceSize optimal = vk->device_properties.properties.limits.optimalBufferCopyOffsetAlignment;
+    g_upload.image_alignment = optimal > VE_UPLOAD_MIN_ALIGNMENT ? optimal : VE_UPLOAD_MIN_ALIGNMENT;
+
+    g_upload.mutex = ve_mutex_create();
+    g_upload.copied = ve_condvar_create();
+    if (!g_upload.mutex || !g_upload.copied) {
+        VE_LOG_ERROR("Failed to create upload synchronization");
+        ve_upload_shutdown();
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    ve_buffer_config ring_config = {
+        .size = g_upload.ring_size,
+        .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        .memory_usage = VE_GPU_MEMORY_USAGE_CPU_TO_GPU,
+        .debug_name = "upload_ring",
+    };
+
+    VkResult result = ve_buffer_create(&ring_config, &g_upload.ring);
+    if (result != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to create upload ring: %d", result);
+        ve_upload_shutdown();
+        return result;
+    }
+
+    g_upload.mapped = (uint8_t*)ve_buffer_get_mapped(&g_upload.ring);
+    VE_ASSERT_MSG(g_upload.mapped, "Upload ring is not host visible");
+
+    g_upload.stats.ring_size = g_upload.ring_size;
+    g_upload.initialized = true;
+
+    VE_LOG_INFO("Upload ring created: %llu KB, transfer family %u",
+                (unsigned long long)(g_upload.ring_size / 1024), vk->queue_families.transfer_family);
+    return VK_SUCCESS;
+}
+
+void ve_upload_shutdown(void) {
+    ve_buffer_destroy(&g_upload.ring);
+
+    VE_FREE(g_upload.requests);
+    VE_FREE(g_upload.recording);
+    VE_FREE(g_upload.image_barriers);
+    VE_FREE(g_upload.buffer_barriers);
+
+    if (g_upload.copied) {
+        ve_condvar_destroy(g_upload.copied);
+    }
+    if (g_upload.mutex) {
+        ve_mutex_destroy(g_upload.mutex);
+    }
+    memset(&g_upload, 0, sizeof(g_upload));
+}
+
+bool ve_upload_is_enabled(void) {
+    return g_upload.initialized;
+}
+
+/* Release the ring space of batches the transfer queue has completed; lock held */
+static void retire_batches(void) {
+    if (g_upload.batch_count == 0) {
+        return;
+    }
+
+    uint64_t completed = ve_submit_get_completed_value(VE_COMMAND_BUFFER_TRANSFER);
+    while (g_upload.batch_count > 0) {
+        ve_upload_batch* batch = &g_upload.batches[g_upload.batch_first];
+        if (batch->value > completed) {
+            break;
+        }
+        g_upload.tail = batch->end;
+        g_upload.batch_first = (g_upload.batch_first + 1) % VE_UPLOAD_MAX_BATCHES;
+        g_upload.batch_count--;
+    }
+}
+
+/* Reserve contiguous ring space, wrapping to the start when the end is too short; lock held */
+static bool ring_allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* out_offset) {
+    if (size == 0 || size > g_upload.ring_size) {
+        return false;
+    }
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        VkDeviceSize offset = g_upload.head % g_upload.ring_size;
+        VkDeviceSize aligned = (offset + alignment - 1) & ~(alignment - 1);
+        VkDeviceSize advance = aligned - offset;
+        if (aligned + size > g_upload.ring_size) {
+            advance = g_upload.ring_size - offset;
+            aligned = 0;
+        }
+
+        if (g_upload.head + advance + size - g_upload.tail <= g_upload.ring_size) {
+            g_upload.head += advance + size;
+            *out_offset = aligned;
+            return true;
+        }
+
+        retire_batches();
+    }
+
+    return false;
+}
+
+/* Append a request, copying its data into the ring */
+static bool queue_request(ve_upload_request* request, VkDeviceSize alignment,
+                          const void* data, VkDeviceSize size) {
+    VE_ASSERT_MSG(g_upload.initialized, "Upload ring not initialized");
+
+    ve_mutex_lock(g_upload.mutex);
+
+    if (g_upload.request_count == g_upload.request_capacity) {
+        uint32_t capacity = g_upload.request_capacity ? g_upload.request_capacity * 2 : 64;
+        ve_upload_request* requests = (ve_upload_request*)ve_reallocate(
+            g_upload.requests, capacity * sizeof(ve_upload_request), VE_MEMORY_TAG_RENDERER);
+        if (!requests) {
+            ve_mutex_unlock(g_upload.mutex);
+            return false;
+        }
+        g_upload.requests = requests;
+        g_upload.request_capacity = capacity;
+    }
+
+    VkDeviceSize offset;
+    if (!ring_allocate(size, alignment, &offset)) {
+        g_upload.stats.rejected_uploads++;
+        ve_mutex_unlock(g_upload.mutex);
+        return false;
+    }
+
+    if (request->is_image) {
+        request->image_copy.bufferOffset = offset;
+    } else {
+        request->buffer_copy.srcOffset = offset;
+    }
+    g_upload.requests[g_upload.request_count++] = *request;
+
+    /* Published in order with its ring space, so batches own the ring up to their end; the copy runs outside
+       the lock and the flush taking this request waits for it */
+    uint32_t index = g_upload.queue_index;
+    g_upload.copying[index]++;
+    ve_mutex_unlock(g_upload.mutex);
+
+    memcpy(g_upload.mapped + offset, data, (size_t)size);
+
+    ve_mutex_lock(g_upload.mutex);
+    if (--g_upload.copying[index] == 0) {
+        ve_condvar_broadcast(g_upload.copied);
+    }
+    ve_mutex_unlock(g_upload.mutex);
+    return true;
+}
+
+bool ve_upload_buffer(VkBuffer dst, VkDeviceSize dst_offset, const void* data, VkDeviceSize size) {
+    VE_ASSERT(dst != VK_NULL_HANDLE && data);
+
+    ve_upload_request request = {
+        .is_image = false,
+        .buffer = dst,
+        .buffer_copy = {
+            .dstOffset = dst_offset,
+            .size = size,
+        },
+    };
+    return queue_request(&request, VE_UPLOAD_MIN_ALIGNMENT, data, size);
+}
+
+bool ve_upload_image(const ve_upload_image_region* region, const void* data, VkDeviceSize size) {
+    VE_ASSERT(region && region->image != VK_NULL_HANDLE && data);
+
+    ve_upload_request request = {
+        .is_image = true,
+        .image = *region,
+        .image_copy = {
+            .bufferRowLength = 0,
+            .bufferImageHeight = 0,
+            .imageSubresource = {
+                .aspectMask = region->aspect,
+                .mipLevel = region->mip_level,
+                .baseArrayLayer = region->array_layer,
+                .layerCount = 1,
+            },
+            .imageOffset = region->offset,
+            .imageExtent = region->extent,
+        },
+    };
+    return queue_request(&request, g_upload.image_alignment, data, size);
+}
+
+static bool reserve_barriers(uint32_t count) {
+    if (count <= g_upload.barrier_capacity) {
+        return true;
+    }
+
+    VkImageMemoryBarrier* image_barriers = (VkImageMemoryBarrier*)ve_reallocate(
+        g_upload.image_barriers, count * sizeof(VkImageMemoryBarrier), VE_MEMORY_TAG_RENDERER);
+    if (!image_barriers) {
+        return false;
+    }
+    g_upload.image_barriers = image_barriers;
+
+    VkBufferMemoryBarrier* buffer_barriers = (VkBufferMemoryBarrier*)ve_reallocate(
+        g_upload.buffer_barriers, count * sizeof(VkBufferMemoryBarrier), VE_MEMORY_TAG_RENDERER);
+    if (!buffer_barriers) {
+        return false;
+    }
+    g_upload.buffer_barriers = buffer_barriers;
+
+    g_upload.barrier_capacity = count;
+    return true;
+}
+
+static VkImageSubresourceRange request_range(const ve_upload_request* request) {
+    VkImageSubresourceRange range = {
+        .aspectMask = request->image.aspect,
+        .baseMipLevel = request->image.mip_level,
+        .levelCount = 1,
+        .baseArrayLayer = request->image.array_layer,
+        .layerCount = 1,
+    };
+    return range;
+}
+
+/*
+ * Fill the barriers ending (release) or starting (acquire) the transfer.
+ * Without a family change there is no acquire and the release makes the
+ * writes visible directly.
+ */
+static void fill_ownership_barriers(const ve_upload_request* requests, uint32_t count,
+                                    bool acquire, bool ownership,
+                                    uint32_t* out_image_count, uint32_t* out_buffer_count) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    uint32_t src_family = ownership ? vk->queue_families.transfer_family : VK_QUEUE_FAMILY_IGNORED;
+    uint32_t dst_family = ownership ? vk->queue_families.graphics_family : VK_QUEUE_FAMILY_IGNORED;
+
+    VkAccessFlags src_access = acquire ? 0 : VK_ACCESS_TRANSFER_WRITE_BIT;
+    VkAccessFlags dst_access = (acquire || !ownership) ? VK_ACCESS_MEMORY_READ_BIT : 0;
+
+    uint32_t image_count = 0;
+    uint32_t buffer_count = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const ve_upload_request* request = &requests[i];
+        if (request->is_image) {
+            g_upload.image_barriers[image_count++] = (VkImageMemoryBarrier){
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .srcAccessMask = src_access,
+                .dstAccessMask = dst_access,
+                .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                .newLayout = request->image.final_layout,
+                .srcQueueFamilyIndex = src_family,
+                .dstQueueFamilyIndex = dst_family,
+                .image = request->image.image,
+                .subresourceRange = request_range(request),
+            };
+        } else if (ownership) {
+            g_upload.buffer_barriers[buffer_count++] = (VkBufferMemoryBarrier){
+                .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                .srcAccessMask = src_access,
+                .dstAccessMask = dst_access,
+                .srcQueueFamilyIndex = src_family,
+                .dstQueueFamilyIndex = dst_family,
+                .buffer = request->buffer,
+                .offset = request->buffer_copy.dstOffset,
+                .size = request->buffer_copy.size,
+            };
+        }
+    }
+
+    *out_image_count = image_count;
+    *out_buffer_count = buffer_count;
+}
+
+static void record_transfer(ve_command_buffer* cmd, const ve_upload_request* requests,
+                            uint32_t count, bool ownership) {
+    /* Destination subresources start undefined */
+    uint32_t image_count = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (requests[i].is_image) {
+            g_upload.image_barriers[image_count++] = (VkImageMemoryBarrier){
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .srcAccessMask = 0,
+                .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = requests[i].image.image,
+                .subresourceRange = request_range(&requests[i]),
+            };
+        }
+    }
+    if (image_count > 0) {
+        ve_command_buffer_pipeline_barrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                           VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                                           0, NULL, 0, NULL, image_count, g_upload.image_barriers);
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        const ve_upload_request* request = &requests[i];
+        if (request->is_image) {
+            ve_command_buffer_copy_buffer_to_image(cmd, g_upload.ring.buffer, request->image.image,
+                                                   1, &request->image_copy);
+        } else {
+            ve_command_buffer_copy_buffer(cmd, g_upload.ring.buffer, request->buffer,
+                                          1, &request->buffer_copy);
+        }
+    }
+
+    uint32_t buffer_count;
+    fill_ownership_barriers(requests, count, false, ownership, &image_count, &buffer_count);
+    if (image_count > 0 || buffer_count > 0) {
+        VkPipelineStageFlags dst_stage = ownership ?
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        ve_command_buffer_pipeline_barrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stage, 0,
+                                           0, NULL, buffer_count, g_upload.buffer_barriers,
+                                           image_count, g_upload.image_barriers);
+    }
+}
+
+/* Record the acquire of the destinations on the graphics queue, after the transfer batch released them */
+static ve_command_buffer* record_acquire(const ve_upload_request* requests, uint32_t count) {
+    ve_command_buffer* acquire = ve_command_buffer_allocate_frame(VE_COMMAND_BUFFER_GRAPHICS,
+                                                                  VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    if (!acquire || ve_command_buffer_begin(acquire, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT) != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to begin upload acquire command buffer");
+        return NULL;
+    }
+
+    uint32_t image_count, buffer_count;
+    fill_ownership_barriers(requests, count, true, true, &image_count, &buffer_count);
+    ve_command_buffer_pipeline_barrier(acquire, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                       VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+                                       0, NULL, buffer_count, g_upload.buffer_barriers,
+                                       image_count, g_upload.image_barriers);
+
+    if (ve_command_buffer_end(acquire) != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to end upload acquire command buffer");
+        return NULL;
+    }
+    return acquire;
+}
+
+/*
+ * Record the queued copies and hand them to the batcher. Both command buffers are recorded, and both batches
+ * checked for room, before either is queued: false means nothing was submitted.
+ */
+static bool submit_requests(const ve_upload_request* requests, uint32_t count) {
+    ve_vulkan_context* vk = ve_vulkan_get_context();
+    bool ownership = vk->queue_families.transfer_family != vk->queue_families.graphics_family;
+
+    if (!reserve_barriers(count)) {
+        VE_LOG_ERROR("Out of memory for upload barriers");
+        return false;
+    }
+
+    ve_command_buffer* cmd = ve_command_buffer_allocate_frame(VE_COMMAND_BUFFER_TRANSFER,
+                                                              VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    if (!cmd || ve_command_buffer_begin(cmd, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT) != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to begin upload command buffer");
+        return false;
+    }
+
+    record_transfer(cmd, requests, count, ownership);
+
+    if (ve_command_buffer_end(cmd) != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to end upload command buffer");
+        return false;
+    }
+
+    /* The graphics queue takes over the destinations before the frame's work */
+    ve_command_buffer* acquire = NULL;
+    if (ownership) {
+        acquire = record_acquire(requests, count);
+        if (!acquire) {
+            return false;
+        }
+    }
+
+    /* A release without its acquire would leave the destinations owned by the transfer queue */
+    if (ve_submit_get_free_slots(VE_COMMAND_BUFFER_TRANSFER) == 0 ||
+        (acquire && ve_submit_get_free_slots(VE_COMMAND_BUFFER_GRAPHICS) == 0)) {
+        VE_LOG_ERROR("Failed to queue upload command buffers: submission batch full");
+        return false;
+    }
+    ve_submit_add(cmd);
+    if (acquire) {
+        ve_submit_add(acquire);
+    }
+
+    ve_submit_wait_queue(VE_COMMAND_BUFFER_GRAPHICS, VE_COMMAND_BUFFER_TRANSFER,
+                         VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+    return true;
+}
+
+uint64_t ve_upload_flush(void) {
+    if (!g_upload.initialized) {
+        return 0;
+    }
+
+    /* Take the queued requests; uploads from other threads go to the other array */
+    ve_mutex_lock(g_upload.mutex);
+    retire_batches();
+
+    ve_upload_request* requests = g_upload.requests;
+    uint32_t count = g_upload.request_count;
+    uint32_t capacity = g_upload.request_capacity;
+    uint64_t end = g_upload.head;
+
+    g_upload.requests = g_upload.recording;
+    g_upload.request_capacity = g_upload.recording_capacity;
+    g_upload.request_count = 0;
+    g_upload.recording = requests;
+    g_upload.recording_capacity = capacity;
+
+    /* Uploads queued from now on go to the other array and are not waited for */
+    uint32_t index = g_upload.queue_index;
+    g_upload.queue_index ^= 1;
+    while (g_upload.copying[index] > 0) {
+        ve_condvar_wait(g_upload.copied, g_upload.mutex, UINT32_MAX);
+    }
+
+    uint64_t last_value = g_upload.last_value;
+    ve_mutex_unlock(g_upload.mutex);
+
+    if (count == 0) {
+        return last_value;
+    }
+
+    /* Once the copies are queued the ring space is only released when they complete */
+    uint64_t value = ve_submit_get_pending_value(VE_COMMAND_BUFFER_TRANSFER);
+    if (!submit_requests(requests, count)) {
+        /* Nothing was submitted, so nothing references the ring space: release it with the previous batch */
+        value = last_value;
+    }
+
+    ve_mutex_lock(g_upload.mutex);
+
+    /* Every batch slot in use: wait for the oldest one */
+    while (g_upload.batch_count == VE_UPLOAD_MAX_BATCHES) {
+        uint64_t oldest = g_upload.batches[g_upload.batch_first].value;
+        ve_mutex_unlock(g_upload.mutex);
+        ve_submit_wait(VE_COMMAND_BUFFER_TRANSFER, oldest, UINT64_MAX);
+        ve_mutex_lock(g_upload.mutex);
+        retire_batches();
+    }
+
+    uint32_t slot = (g_upload.batch_first + g_upload.batch_count) % VE_UPLOAD_MAX_BATCHES;
+    g_upload.batches[slot].value = value;
+    g_upload.batches[slot].end = end;
+    g_upload.batch_count++;
+    g_upload.last_value = value;
+    g_upload.stats.flushed_batches++;
+
+    ve_mutex_unlock(g_upload.mutex);
+    return value;
+}
+
+bool ve_upload_is_complete(uint64_t value) {
+    return ve_submit_get_completed_value(VE_COMMAND_BUFFER_TRANSFER) >= value;
+}
+
+void ve_upload_get_stats(ve_upload_stats* stats) {
+    if (!stats) {
+        return;
+    }
+
+    if (!g_upload.initialized) {
+        memset(stats, 0, sizeof(ve_upload_stats));
+        return;
+    }
+
+    ve_mutex_lock(g_upload.mutex);
+    *stats = g_upload.stats;
+    stats->ring_used = g_upload.head - g_upload.tail;
+    stats->pending_uploads = g_upload.request_count;
+    ve_mutex_unlock(g_upload.mutex);
+}
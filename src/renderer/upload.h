@@ -0,0 +1,139 @@
+/**
+ * @file upload.h
+ * @brief Staging ring and transfer-queue uploads
+ *
+ * Upload data is copied into one persistently mapped staging ring instead
+ * of a temporary staging buffer per upload. Copies are queued and recorded
+ * in a batch by ve_upload_flush on the transfer queue, so texture and mesh
+ * streaming does not occupy the graphics queue. When the transfer queue
+ * belongs to another family, ownership of the destinations is released by
+ * the transfer batch and acquired on the graphics queue, which waits for
+ * the transfer timeline. Each flush returns the transfer timeline value
+ * that marks its completion; ring space is reused once that value is
+ * reached.
+ *
+ * Uploads may be queued from any thread. The ring never blocks: when it
+ * has no room, the upload fails and can be retried after the next flush.
+ * A flush waits for uploads it takes that are still copying their data.
+ * Requires the submission batcher (timeline semaphores).
+ */
+
+#ifndef VE_UPLOAD_H
+#define VE_UPLOAD_H
+
+#include "vulkan_core.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Default staging ring size */
+#define VE_UPLOAD_RING_SIZE (64ull * 1024 * 1024)
+
+/* Flushed batches whose ring space may still be in use */
+#define VE_UPLOAD_MAX_BATCHES 16
+
+/**
+ * @brief Destination of an image upload
+ *
+ * The subresource is transitioned from VK_IMAGE_LAYOUT_UNDEFINED, so its
+ * previous contents are discarded.
+ */
+typedef struct ve_upload_image_region {
+    VkImage image;
+    VkImageAspectFlags aspect;
+    uint32_t mip_level;
+    uint32_t array_layer;
+    VkOffset3D offset;
+    VkExtent3D extent;
+    VkImageLayout final_layout;     /* Layout after the upload, e.g. SHADER_READ_ONLY_OPTIMAL */
+} ve_upload_image_region;
+
+/**
+ * @brief Upload statistics
+ */
+typedef struct ve_upload_stats {
+    VkDeviceSize ring_size;
+    VkDeviceSize ring_used;         /* Bytes not yet released by the GPU */
+    uint32_t pending_uploads;       /* Queued and not yet flushed */
+    uint64_t flushed_batches;
+    uint64_t rejected_uploads;      /* Failed because the ring was full */
+} ve_upload_stats;
+
+/**
+ * @brief Create the staging ring
+ *
+ * @param ring_size Ring size in bytes, 0 for VE_UPLOAD_RING_SIZE
+ * @return VK_SUCCESS on success, VK_ERROR_FEATURE_NOT_PRESENT without the submission batcher
+ */
+VkResult ve_upload_init(VkDeviceSize ring_size);
+
+/**
+ * @brief Destroy the staging ring
+ *
+ * The device must be idle; queued uploads are dropped.
+ */
+void ve_upload_shutdown(void);
+
+/**
+ * @brief Check if the upload path is available
+ *
+ * @return true if initialized
+ */
+bool ve_upload_is_enabled(void);
+
+/**
+ * @brief Queue an upload into a buffer
+ *
+ * The data is copied into the ring immediately.
+ *
+ * @param dst Destination buffer (needs VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+ * @param dst_offset Offset in the destination
+ * @param data Source data
+ * @param size Size in bytes
+ * @return true if queued, false if the ring is full
+ */
+bool ve_upload_buffer(VkBuffer dst, VkDeviceSize dst_offset, const void* data, VkDeviceSize size);
+
+/**
+ * @brief Queue an upload into one subresource of an image
+ *
+ * @param region Destination (image needs VK_IMAGE_USAGE_TRANSFER_DST_BIT)
+ * @param data Tightly packed texel data
+ * @param size Size in bytes
+ * @return true if queued, false if the ring is full
+ */
+bool ve_upload_image(const ve_upload_image_region* region, const void* data, VkDeviceSize size);
+
+/**
+ * @brief Record and submit the queued uploads
+ *
+ * Call from the frame thread before adding the frame's graphics command
+ * buffers to the batcher, so the acquire barriers execute first. The
+ * graphics batch waits for the transfer batch.
+ *
+ * @return Transfer timeline value marking completion of every upload queued so far
+ */
+uint64_t ve_upload_flush(void);
+
+/**
+ * @brief Check if uploads up to a flush have completed
+ *
+ * @param value Value returned by ve_upload_flush
+ * @return true if the GPU has finished them
+ */
+bool ve_upload_is_complete(uint64_t value);
+
+/**
+ * @brief Get upload statistics
+ *
+ * @param stats Output statistics
+ */
+void ve_upload_get_stats(ve_upload_stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_UPLOAD_H */
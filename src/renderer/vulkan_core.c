@@ -9,7 +9,8 @@
 #include "../core/logger.h"
 #include "../core/assert.h"
 #include "../platform/platform.h"
-#include "../memory/memory.h"
+#include "../core/memory.h"
+#include "gpu_profiler.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -19,7 +20,6 @@
 
 /* Required device extensions */
 static const char* g_device_extensions[] = {
-    VK_KHR_SWAPCHAIN_EXTENSION_NAME,
     VK_KHR_MAINTENANCE4_EXTENSION_NAME,
     /* Optional but recommended */
     VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
@@ -28,6 +28,37 @@ static const char* g_device_extensions[] = {
 
 static const uint32_t g_device_extension_count = sizeof(g_device_extensions) / sizeof(g_device_extensions[0]);
 
+/* Required unless headless */
+static const char* g_swapchain_extensions[] = {
+    VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+};
+
+static const uint32_t g_swapchain_extension_count =
+    sizeof(g_swapchain_extensions) / sizeof(g_swapchain_extensions[0]);
+
+/* Optional device extensions, enabled when the device supports them */
+static const char* g_present_wait_extensions[] = {
+    VK_KHR_PRESENT_ID_EXTENSION_NAME,
+    VK_KHR_PRESENT_WAIT_EXTENSION_NAME,
+};
+
+static const uint32_t g_present_wait_extension_count =
+    sizeof(g_present_wait_extensions) / sizeof(g_present_wait_extensions[0]);
+
+static const char* g_mesh_shader_extensions[] = {
+    VK_EXT_MESH_SHADER_EXTENSION_NAME,
+};
+
+static const uint32_t g_mesh_shader_extension_count =
+    sizeof(g_mesh_shader_extensions) / sizeof(g_mesh_shader_extensions[0]);
+
+static const char* g_memory_budget_extensions[] = {
+    VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+};
+
+static const uint32_t g_memory_budget_extension_count =
+    sizeof(g_memory_budget_extensions) / sizeof(g_memory_budget_extensions[0]);
+
 /* Validation layers */
 static const char* g_validation_layers[] = {
     "VK_LAYER_KHRONOS_validation",
@@ -38,6 +69,18 @@ static const uint32_t g_validation_layer_count = sizeof(g_validation_layers) / s
 /* Global Vulkan context */
 static ve_vulkan_context g_vulkan_context = {0};
 
+/* Device selection for the next initialization, kept apart from the context it is applied to */
+static ve_vulkan_device_selection g_device_selection = {.index = -1};
+
+/* Loader state and instance layers and extensions, enumerated once by ve_vulkan_preload */
+static struct {
+    bool loaded;
+    VkLayerProperties* layers;
+    uint32_t layer_count;
+    VkExtensionProperties* extensions;
+    uint32_t extension_count;
+} g_instance_support = {0};
+
 /* Debug messenger callback */
 static VKAPI_ATTR VkBool32 VKAPI_CALL debug_callback(
     VkDebugUtilsMessageSeverityFlagBitsEXT message_severity,
@@ -99,7 +142,48 @@ ve_vulkan_context* ve_vulkan_get_context(void) {
     return &g_vulkan_context;
 }
 
-bool ve_vulkan_init(const char* application_name, uint32_t application_version, bool enable_validation) {
+bool ve_vulkan_preload(void) {
+    if (g_instance_support.loaded) {
+        return true;
+    }
+
+    /* Loading the runtime and the first enumeration, which finds the drivers and layers, are the slow part */
+    if (volkInitialize() != VK_SUCCESS) {
+        VE_LOG_ERROR("Failed to initialize Volk - Vulkan runtime not found");
+        return false;
+    }
+
+    uint32_t layer_count = 0;
+    vkEnumerateInstanceLayerProperties(&layer_count, NULL);
+    g_instance_support.layers = (VkLayerProperties*)VE_ALLOCATE_TAG(
+        (layer_count ? layer_count : 1) * sizeof(VkLayerProperties), VE_MEMORY_TAG_VULKAN);
+    uint32_t extension_count = 0;
+    vkEnumerateInstanceExtensionProperties(NULL, &extension_count, NULL);
+    g_instance_support.extensions = (VkExtensionProperties*)VE_ALLOCATE_TAG(
+        (extension_count ? extension_count : 1) * sizeof(VkExtensionProperties), VE_MEMORY_TAG_VULKAN);
+    if (!g_instance_support.layers || !g_instance_support.extensions) {
+        VE_FREE(g_instance_support.layers);
+        VE_FREE(g_instance_support.extensions);
+        memset(&g_instance_support, 0, sizeof(g_instance_support));
+        return false;
+    }
+
+    vkEnumerateInstanceLayerProperties(&layer_count, g_instance_support.layers);
+    vkEnumerateInstanceExtensionProperties(NULL, &extension_count, g_instance_support.extensions);
+    g_instance_support.layer_count = layer_count;
+    g_instance_support.extension_count = extension_count;
+    g_instance_support.loaded = true;
+    return true;
+}
+
+static void release_instance_support(void) {
+    VE_FREE(g_instance_support.layers);
+    VE_FREE(g_instance_support.extensions);
+    memset(&g_instance_support, 0, sizeof(g_instance_support));
+}
+
+static bool vulkan_init(const char* application_name, uint32_t application_version, bool enable_validation,
+                        bool headless) {
     if (g_vulkan_context.initialized) {
         VE_LOG_WARN("Vulkan already initialized");
         return true;
@@ -107,10 +191,10 @@ bool ve_vulkan_init(const char* application_name, uint32_t application_version,
 
     memset(&g_vulkan_context, 0, sizeof(ve_vulkan_context));
     g_vulkan_context.validation_enabled = enable_validation;
+    g_vulkan_context.headless = headless;
 
-    /* Load Volk for dynamic Vulkan loading */
-    if (!volkInitialize()) {
-        VE_LOG_ERROR("Failed to initialize Volk - Vulkan runtime not found");
+    /* Load Volk for dynamic Vulkan loading, unless ve_vulkan_preload already has */
+    if (!ve_vulkan_preload()) {
         return false;
     }
 
@@ -147,7 +231,7 @@ bool ve_vulkan_init(const char* application_name, uint32_t application_version,
     }
 
     /* Create surface - will be initialized properly when window is created */
-    /* This will be done by the window manager */
+    /* This will be done by the window manager; headless runs never create one */
 
     /* Pick physical device */
     result = ve_vulkan_pick_physical_device();
@@ -183,10 +267,22 @@ bool ve_vulkan_init(const char* application_name, uint32_t application_version,
     g_vulkan_context.initialized = true;
     g_vulkan_context.current_frame = 0;
 
-    VE_LOG_INFO("Vulkan initialized successfully");
+    VE_LOG_INFO("Vulkan initialized successfully%s", headless ? " (headless)" : "");
     return true;
 }
 
+bool ve_vulkan_init(const char* application_name, uint32_t application_version, bool enable_validation) {
+    return vulkan_init(application_name, application_version, enable_validation, false);
+}
+
+bool ve_vulkan_init_headless(const char* application_name, uint32_t application_version, bool enable_validation) {
+    return vulkan_init(application_name, application_version, enable_validation, true);
+}
+
+bool ve_vulkan_is_headless(void) {
+    return g_vulkan_context.headless;
+}
+
 void ve_vulkan_shutdown(void) {
     if (!g_vulkan_context.initialized) {
         return;
@@ -232,6 +328,7 @@ void ve_vulkan_shutdown(void) {
     }
 
     memset(&g_vulkan_context, 0, sizeof(ve_vulkan_context));
+    release_instance_support();
 }
 
 bool ve_vulkan_is_validation_enabled(void) {
@@ -239,12 +336,15 @@ bool ve_vulkan_is_validation_enabled(void) {
 }
 
 bool ve_vulkan_get_required_extensions(const char** extensions, uint32_t* count) {
+    /* Headless runs need no surface extensions, and GLFW may have no display to ask */
     uint32_t glfw_extension_count = 0;
-    const char** glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
-
-    if (!glfw_extensions) {
-        VE_LOG_ERROR("Failed to get GLFW required extensions");
-        return false;
+    const char** glfw_extensions = NULL;
+    if (!g_vulkan_context.headless) {
+        glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
+        if (!glfw_extensions) {
+            VE_LOG_ERROR("Failed to get GLFW required extensions");
+            return false;
+        }
     }
 
     /* Add debug messenger extension if validation is enabled */
@@ -254,7 +354,9 @@ bool ve_vulkan_get_required_extensions(const char** extensions, uint32_t* count)
     }
 
     if (extensions && *count >= total_count) {
-        memcpy(extensions, glfw_extensions, glfw_extension_count * sizeof(const char*));
+        if (glfw_extension_count > 0) {
+            memcpy(extensions, glfw_extensions, glfw_extension_count * sizeof(const char*));
+        }
         if (g_vulkan_context.validation_enabled) {
             extensions[glfw_extension_count] = VK_EXT_DEBUG_UTILS_EXTENSION_NAME;
         }
@@ -267,17 +369,11 @@ bool ve_vulkan_get_required_extensions(const char** extensions, uint32_t* count)
 }
 
 bool ve_vulkan_check_validation_support(void) {
-    uint32_t layer_count;
-    vkEnumerateInstanceLayerProperties(&layer_count, NULL);
-
-    VkLayerProperties* available_layers = (VkLayerProperties*)VE_ALLOCATE_TAG(
-        layer_count * sizeof(VkLayerProperties), VE_MEMORY_TAG_VULKAN);
-
-    if (!available_layers) {
+    if (!ve_vulkan_preload()) {
         return false;
     }
-
-    vkEnumerateInstanceLayerProperties(&layer_count, available_layers);
+    const VkLayerProperties* available_layers = g_instance_support.layers;
+    uint32_t layer_count = g_instance_support.layer_count;
 
     bool all_layers_available = true;
     for (uint32_t i = 0; i < g_validation_layer_count; i++) {
@@ -295,7 +391,6 @@ bool ve_vulkan_check_validation_support(void) {
         }
     }
 
-    VE_FREE(available_layers);
     return all_layers_available;
 }
 
@@ -319,13 +414,9 @@ VkResult ve_vulkan_create_instance(const char* application_name, uint32_t applic
     }
 
     /* Check extension support */
-    uint32_t available_count = 0;
-    vkEnumerateInstanceExtensionProperties(NULL, &available_count, NULL);
-    VkExtensionProperties* available = (VkExtensionProperties*)VE_ALLOCATE_TAG(
-        available_count * sizeof(VkExtensionProperties), VE_MEMORY_TAG_VULKAN);
-
-    if (available) {
-        vkEnumerateInstanceExtensionProperties(NULL, &available_count, available);
+    if (ve_vulkan_preload()) {
+        const VkExtensionProperties* available = g_instance_support.extensions;
+        uint32_t available_count = g_instance_support.extension_count;
 
         for (uint32_t i = 0; i < extension_count; i++) {
             bool found = false;
@@ -338,13 +429,10 @@ VkResult ve_vulkan_create_instance(const char* application_name, uint32_t applic
 
             if (!found) {
                 VE_LOG_ERROR("Required instance extension not found: %s", extensions[i]);
-                VE_FREE(available);
                 VE_FREE(extensions);
                 return VK_ERROR_EXTENSION_NOT_PRESENT;
             }
         }
-
-        VE_FREE(available);
     }
 
     /* Log enabled extensions */
@@ -448,6 +536,334 @@ VkResult ve_vulkan_create_surface(void* window_handle) {
     return result;
 }
 
+/* Check for optional device extensions without warning about missing ones */
+static bool has_device_extensions(VkPhysicalDevice device, const char** names, uint32_t name_count) {
+    uint32_t available_count = 0;
+    vkEnumerateDeviceExtensionProperties(device, NULL, &available_count, NULL);
+
+    VkExtensionProperties* available = (VkExtensionProperties*)VE_ALLOCATE_TAG(
+        available_count * sizeof(VkExtensionProperties), VE_MEMORY_TAG_VULKAN);
+
+    if (!available) {
+        return false;
+    }
+
+    vkEnumerateDeviceExtensionProperties(device, NULL, &available_count, available);
+
+    uint32_t found = 0;
+    for (uint32_t i = 0; i < name_count; i++) {
+        for (uint32_t j = 0; j < available_count; j++) {
+            if (strcmp(names[i], available[j].extensionName) == 0) {
+                found++;
+                break;
+            }
+        }
+    }
+
+    VE_FREE(available);
+    return found == name_count;
+}
+
+/* Fill vulkan_device_features from what the physical device reports */
+static void store_device_features(VkPhysicalDevice device) {
+    const VkPhysicalDeviceFeatures* core = &g_vulkan_context.device_properties.features;
+    vulkan_device_features* features = &g_vulkan_context.device_features;
+    memset(features, 0, sizeof(vulkan_device_features));
+
+    #define STORE_FEATURE(name) features->name = core->name == VK_TRUE
+
+    STORE_FEATURE(robustBufferAccess);
+    STORE_FEATURE(fullDrawIndexUint32);
+    STORE_FEATURE(imageCubeArray);
+    STORE_FEATURE(independentBlend);
+    STORE_FEATURE(geometryShader);
+    STORE_FEATURE(tessellationShader);
+    STORE_FEATURE(sampleRateShading);
+    STORE_FEATURE(dualSrcBlend);
+    STORE_FEATURE(logicOp);
+    STORE_FEATURE(multiDrawIndirect);
+    STORE_FEATURE(drawIndirectFirstInstance);
+    STORE_FEATURE(depthClamp);
+    STORE_FEATURE(depthBiasClamp);
+    STORE_FEATURE(fillModeNonSolid);
+    STORE_FEATURE(depthBounds);
+    STORE_FEATURE(wideLines);
+    STORE_FEATURE(largePoints);
+    STORE_FEATURE(alphaToOne);
+    STORE_FEATURE(multiViewport);
+    STORE_FEATURE(samplerAnisotropy);
+    STORE_FEATURE(textureCompressionETC2);
+    STORE_FEATURE(textureCompressionASTC_LDR);
+    STORE_FEATURE(textureCompressionBC);
+    STORE_FEATURE(occlusionQueryPrecise);
+    STORE_FEATURE(pipelineStatisticsQuery);
+    STORE_FEATURE(fragmentStoresAndAtomics);
+    STORE_FEATURE(shaderTessellationAndGeometryPointSize);
+    STORE_FEATURE(shaderImageGatherExtended);
+    STORE_FEATURE(shaderStorageImageExtendedFormats);
+    STORE_FEATURE(shaderStorageImageReadWithoutFormat);
+    STORE_FEATURE(shaderStorageImageWriteWithoutFormat);
+    STORE_FEATURE(shaderUniformBufferArrayDynamicIndexing);
+    STORE_FEATURE(shaderSampledImageArrayDynamicIndexing);
+    STORE_FEATURE(shaderStorageBufferArrayDynamicIndexing);
+    STORE_FEATURE(shaderStorageImageArrayDynamicIndexing);
+    STORE_FEATURE(shaderClipDistance);
+    STORE_FEATURE(shaderCullDistance);
+    STORE_FEATURE(shaderFloat64);
+    STORE_FEATURE(shaderInt64);
+    STORE_FEATURE(shaderInt16);
+    STORE_FEATURE(shaderResourceMinLod);
+    STORE_FEATURE(sparseBinding);
+    STORE_FEATURE(sparseResidencyBuffer);
+    STORE_FEATURE(sparseResidencyImage2D);
+    STORE_FEATURE(sparseResidencyImage3D);
+    STORE_FEATURE(sparseResidency2Samples);
+    STORE_FEATURE(sparseResidency4Samples);
+    STORE_FEATURE(sparseResidency8Samples);
+    STORE_FEATURE(sparseResidency16Samples);
+    STORE_FEATURE(sparseResidencyAliased);
+    STORE_FEATURE(variableMultisampleRate);
+    STORE_FEATURE(inheritedQueries);
+
+    #undef STORE_FEATURE
+
+    /* Vulkan 1.2 features */
+    if (g_vulkan_context.device_properties.properties.apiVersion >= VK_API_VERSION_1_2) {
+        VkPhysicalDeviceVulkan12Features vulkan12_features = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        };
+
+        VkPhysicalDeviceFeatures2 features2 = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+            .pNext = &vulkan12_features,
+        };
+
+        vkGetPhysicalDeviceFeatures2(device, &features2);
+
+        features->descriptorIndexing = vulkan12_features.descriptorIndexing == VK_TRUE;
+        features->bindless = vulkan12_features.runtimeDescriptorArray == VK_TRUE &&
+                             vulkan12_features.descriptorBindingPartiallyBound == VK_TRUE &&
+                             vulkan12_features.descriptorBindingUpdateUnusedWhilePending == VK_TRUE &&
+                             vulkan12_features.descriptorBindingSampledImageUpdateAfterBind == VK_TRUE &&
+                             vulkan12_features.descriptorBindingStorageBufferUpdateAfterBind == VK_TRUE &&
+                             vulkan12_features.shaderSampledImageArrayNonUniformIndexing == VK_TRUE;
+        features->timelineSemaphore = vulkan12_features.timelineSemaphore == VK_TRUE;
+        features->vulkanMemoryModel = vulkan12_features.vulkanMemoryModel == VK_TRUE;
+        features->shaderSubgroupExtendedTypes = vulkan12_features.shaderSubgroupExtendedTypes == VK_TRUE;
+        features->separateDepthStencilLayouts = vulkan12_features.separateDepthStencilLayouts == VK_TRUE;
+        features->hostQueryReset = vulkan12_features.hostQueryReset == VK_TRUE;
+        features->indirectDrawing = vulkan12_features.drawIndirectCount == VK_TRUE;
+        features->samplerFilterMinmax = vulkan12_features.samplerFilterMinmax == VK_TRUE;
+        features->shaderInt8 = vulkan12_features.shaderInt8 == VK_TRUE;
+        features->shaderAtomicInt64 = vulkan12_features.shaderBufferInt64Atomics == VK_TRUE;
+        features->shaderFloat16 = vulkan12_features.shaderFloat16 == VK_TRUE;
+    }
+
+    /* Vulkan 1.3 features */
+    if (g_vulkan_context.device_properties.properties.apiVersion >= VK_API_VERSION_1_3) {
+        VkPhysicalDeviceVulkan13Features vulkan13_features = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+        };
+
+        VkPhysicalDeviceFeatures2 features2 = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+            .pNext = &vulkan13_features,
+        };
+
+        vkGetPhysicalDeviceFeatures2(device, &features2);
+
+        features->synchronization2 = vulkan13_features.synchronization2 == VK_TRUE;
+    }
+
+    /* Present wait, used to pace frames on the display */
+    if (!g_vulkan_context.headless && g_vulkan_context.device_properties.properties.apiVersion >= VK_API_VERSION_1_1 &&
+        has_device_extensions(device, g_present_wait_extensions, g_present_wait_extension_count)) {
+        VkPhysicalDevicePresentIdFeaturesKHR present_id_features = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+        };
+
+        VkPhysicalDevicePresentWaitFeaturesKHR present_wait_features = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR,
+            .pNext = &present_id_features,
+        };
+
+        VkPhysicalDeviceFeatures2 features2 = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+            .pNext = &present_wait_features,
+        };
+
+        vkGetPhysicalDeviceFeatures2(device, &features2);
+
+        features->presentWait = present_id_features.presentId == VK_TRUE &&
+                                present_wait_features.presentWait == VK_TRUE;
+    }
+
+    /* Task and mesh shaders for the meshlet path; SPIR-V 1.4 needs Vulkan 1.2 */
+    if (g_vulkan_context.device_properties.properties.apiVersion >= VK_API_VERSION_1_2 &&
+        has_device_extensions(device, g_mesh_shader_extensions, g_mesh_shader_extension_count)) {
+        VkPhysicalDeviceMeshShaderFeaturesEXT mesh_shader_features = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT,
+        };
+
+        VkPhysicalDeviceFeatures2 features2 = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+            .pNext = &mesh_shader_features,
+        };
+
+        vkGetPhysicalDeviceFeatures2(device, &features2);
+
+        features->meshShader = mesh_shader_features.taskShader == VK_TRUE &&
+                               mesh_shader_features.meshShader == VK_TRUE;
+    }
+
+    /* Per-heap budgets reported by the driver, queried through vkGetPhysicalDeviceMemoryProperties2 */
+    features->memoryBudget = g_vulkan_context.device_properties.properties.apiVersion >= VK_API_VERSION_1_1 &&
+                             has_device_extensions(device, g_memory_budget_extensions, g_memory_budget_extension_count);
+
+    features->shaderDrawParameters = g_vulkan_context.device_properties.properties.apiVersion >= VK_API_VERSION_1_1;
+}
+
+/* Discrete GPUs first, then integrated; within a type by device-local memory and the maximum texture size */
+static int64_t score_device(const vulkan_device_properties* properties, VkDeviceSize device_local_bytes) {
+    int64_t score = 0;
+    switch (properties->properties.deviceType) {
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+            score = 2000000;
+            break;
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+            score = 1000000;
+            break;
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+            score = 500000;
+            break;
+        default:
+            break;
+    }
+
+    score += (int64_t)(device_local_bytes / (1024 * 1024));
+    score += properties->properties.limits.maxImageDimension2D;
+    return score;
+}
+
+static void describe_device(VkPhysicalDevice device, uint32_t index, ve_vulkan_device_info* info) {
+    memset(info, 0, sizeof(ve_vulkan_device_info));
+
+    vulkan_device_properties properties;
+    memset(&properties, 0, sizeof(properties));
+    vkGetPhysicalDeviceProperties(device, &properties.properties);
+    vkGetPhysicalDeviceMemoryProperties(device, &properties.memory_properties);
+
+    info->index = index;
+    memcpy(info->name, properties.properties.deviceName, sizeof(info->name));
+    info->type = properties.properties.deviceType;
+
+    if (properties.properties.apiVersion >= VK_API_VERSION_1_1) {
+        VkPhysicalDeviceIDProperties id_props = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES,
+        };
+        VkPhysicalDeviceProperties2 props2 = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+            .pNext = &id_props,
+        };
+        vkGetPhysicalDeviceProperties2(device, &props2);
+        memcpy(info->uuid, id_props.deviceUUID, VK_UUID_SIZE);
+    }
+
+    const VkPhysicalDeviceMemoryProperties* memory = &properties.memory_properties;
+    for (uint32_t i = 0; i < memory->memoryHeapCount; i++) {
+        if ((memory->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) &&
+            memory->memoryHeaps[i].size > info->device_local_bytes) {
+            info->device_local_bytes = memory->memoryHeaps[i].size;
+        }
+    }
+
+    info->suitable = ve_vulkan_is_device_suitable(device);
+    info->score = score_device(&properties, info->device_local_bytes);
+    info->group_size = 1;
+}
+
+/* Get the members of the device group holding a device, the device alone without groups */
+static uint32_t get_device_group(VkPhysicalDevice device, VkPhysicalDevice members[VE_MAX_DEVICE_GROUP_SIZE]) {
+    members[0] = device;
+    if (volkGetInstanceVersion() < VK_API_VERSION_1_1 || !vkEnumeratePhysicalDeviceGroups) {
+        return 1;
+    }
+
+    uint32_t group_count = 0;
+    vkEnumeratePhysicalDeviceGroups(g_vulkan_context.instance, &group_count, NULL);
+    if (group_count == 0) {
+        return 1;
+    }
+
+    VkPhysicalDeviceGroupProperties* groups = (VkPhysicalDeviceGroupProperties*)VE_ALLOCATE_TAG(
+        group_count * sizeof(VkPhysicalDeviceGroupProperties), VE_MEMORY_TAG_VULKAN);
+    if (!groups) {
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < group_count; i++) {
+        memset(&groups[i], 0, sizeof(VkPhysicalDeviceGroupProperties));
+        groups[i].sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GROUP_PROPERTIES;
+    }
+    vkEnumeratePhysicalDeviceGroups(g_vulkan_context.instance, &group_count, groups);
+
+    uint32_t member_count = 1;
+    for (uint32_t i = 0; i < group_count; i++) {
+        for (uint32_t j = 0; j < groups[i].physicalDeviceCount; j++) {
+            if (groups[i].physicalDevices[j] == device) {
+                member_count = groups[i].physicalDeviceCount;
+                memcpy(members, groups[i].physicalDevices, member_count * sizeof(VkPhysicalDevice));
+            }
+        }
+    }
+
+    VE_FREE(groups);
+    return member_count;
+}
+
+void ve_vulkan_set_device_selection(const ve_vulkan_device_selection* selection) {
+    if (selection) {
+        g_device_selection = *selection;
+    } else {
+        memset(&g_device_selection, 0, sizeof(g_device_selection));
+        g_device_selection.index = -1;
+    }
+}
+
+VkResult ve_vulkan_enumerate_devices(ve_vulkan_device_info* devices, uint32_t* count) {
+    VE_ASSERT(count);
+
+    if (!g_vulkan_context.instance) {
+        *count = 0;
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    uint32_t device_count = 0;
+    vkEnumeratePhysicalDevices(g_vulkan_context.instance, &device_count, NULL);
+    if (!devices) {
+        *count = device_count;
+        return VK_SUCCESS;
+    }
+
+    VkPhysicalDevice* handles = (VkPhysicalDevice*)VE_ALLOCATE_TAG(
+        device_count * sizeof(VkPhysicalDevice), VE_MEMORY_TAG_VULKAN);
+    if (!handles) {
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+    vkEnumeratePhysicalDevices(g_vulkan_context.instance, &device_count, handles);
+
+    uint32_t written = device_count < *count ? device_count : *count;
+    VkPhysicalDevice members[VE_MAX_DEVICE_GROUP_SIZE];
+    for (uint32_t i = 0; i < written; i++) {
+        describe_device(handles[i], i, &devices[i]);
+        devices[i].group_size = get_device_group(handles[i], members);
+    }
+
+    VE_FREE(handles);
+    *count = written;
+    return written < device_count ? VK_INCOMPLETE : VK_SUCCESS;
+}
+
 VkResult ve_vulkan_pick_physical_device(void) {
     uint32_t device_count = 0;
     vkEnumeratePhysicalDevices(g_vulkan_context.instance, &device_count, NULL);
@@ -466,45 +882,72 @@ VkResult ve_vulkan_pick_physical_device(void) {
 
     vkEnumeratePhysicalDevices(g_vulkan_context.instance, &device_count, devices);
 
-    /* Score devices and pick the best one */
-    int best_score = -1;
+    /* Take the selected device, else the best-scoring suitable one */
+    const ve_vulkan_device_selection* selection = &g_device_selection;
+    bool explicit_selection = selection->index >= 0 || selection->match_uuid;
+    int64_t best_score = -1;
     VkPhysicalDevice best_device = VK_NULL_HANDLE;
 
     for (uint32_t i = 0; i < device_count; i++) {
-        if (ve_vulkan_is_device_suitable(devices[i])) {
-            int score = 0;
-
-            VkPhysicalDeviceProperties props;
-            vkGetPhysicalDeviceProperties(devices[i], &props);
-
-            /* Discrete GPUs are preferred */
-            if (props.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) {
-                score += 1000;
-            }
+        ve_vulkan_device_info info;
+        describe_device(devices[i], i, &info);
+        VE_LOG_INFO("GPU %u: %s (type %d, %llu MB device local, score %lld)%s", i, info.name, info.type,
+                    (unsigned long long)(info.device_local_bytes / (1024 * 1024)), (long long)info.score,
+                    info.suitable ? "" : ", unsuitable");
+
+        if (!info.suitable) {
+            continue;
+        }
 
-            /* Maximum texture size is a proxy for overall power */
-            score += props.limits.maxImageDimension2D;
+        bool selected;
+        if (selection->index >= 0) {
+            selected = (int32_t)i == selection->index;
+        } else if (selection->match_uuid) {
+            selected = memcmp(info.uuid, selection->uuid, VK_UUID_SIZE) == 0;
+        } else {
+            selected = info.score > best_score;
+        }
 
-            if (score > best_score) {
-                best_score = score;
-                best_device = devices[i];
-            }
+        if (selected) {
+            best_score = info.score;
+            best_device = devices[i];
         }
     }
 
     VE_FREE(devices);
 
     if (best_device == VK_NULL_HANDLE) {
-        VE_LOG_ERROR("No suitable physical device found");
+        if (explicit_selection) {
+            VE_LOG_ERROR("Selected physical device not found or not suitable");
+        } else {
+            VE_LOG_ERROR("No suitable physical device found");
+        }
         return VK_ERROR_INITIALIZATION_FAILED;
     }
 
     g_vulkan_context.physical_device = best_device;
 
+    /* Device group: the logical device spans every member, the picked device leads */
+    g_vulkan_context.group_devices[0] = best_device;
+    g_vulkan_context.group_device_count = 1;
+    g_vulkan_context.group_mode = VE_DEVICE_GROUP_NONE;
+    if (selection->group_mode != VE_DEVICE_GROUP_NONE) {
+        uint32_t member_count = get_device_group(best_device, g_vulkan_context.group_devices);
+        if (member_count > 1) {
+            g_vulkan_context.group_device_count = member_count;
+            g_vulkan_context.group_mode = selection->group_mode;
+            VE_LOG_INFO("Device group of %u GPUs, %s rendering", member_count,
+                        selection->group_mode == VE_DEVICE_GROUP_ALTERNATE_FRAME ? "alternate-frame" : "split-frame");
+        } else {
+            VE_LOG_WARN("Device is not in a multi-GPU device group, rendering on one GPU");
+        }
+    }
+
     /* Store device properties and features */
     vkGetPhysicalDeviceProperties(best_device, &g_vulkan_context.device_properties.properties);
     vkGetPhysicalDeviceMemoryProperties(best_device, &g_vulkan_context.device_properties.memory_properties);
     vkGetPhysicalDeviceFeatures(best_device, &g_vulkan_context.device_properties.features);
+    store_device_features(best_device);
 
     /* Query extension-specific properties */
     VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexing_props = {
@@ -550,7 +993,7 @@ VkResult ve_vulkan_pick_physical_device(void) {
 bool ve_vulkan_is_device_suitable(VkPhysicalDevice device) {
     ve_queue_family_indices indices = ve_vulkan_find_queue_families(device);
 
-    if (!indices.graphics_valid || !indices.present_valid) {
+    if (!indices.graphics_valid) {
         return false;
     }
 
@@ -562,6 +1005,16 @@ bool ve_vulkan_is_device_suitable(VkPhysicalDevice device) {
         return false;
     }
 
+    /* Headless: rendering goes to offscreen images, nothing is presented */
+    if (g_vulkan_context.headless) {
+        return true;
+    }
+
+    if (!indices.present_valid ||
+        !ve_vulkan_check_device_extension_support(device, g_swapchain_extensions, g_swapchain_extension_count)) {
+        return false;
+    }
+
     /* Check swapchain support */
     ve_swapchain_support swapchain_support = ve_vulkan_query_swapchain_support(device);
 
@@ -733,7 +1186,9 @@ VkResult ve_vulkan_create_logical_device(void) {
     ADD_QUEUE_FAMILY(indices.graphics_family);
     ADD_QUEUE_FAMILY(indices.compute_family);
     ADD_QUEUE_FAMILY(indices.transfer_family);
-    ADD_QUEUE_FAMILY(indices.present_family);
+    if (indices.present_valid) {
+        ADD_QUEUE_FAMILY(indices.present_family);
+    }
 
     float queue_priority = 1.0f;
     for (uint32_t i = 0; i < unique_count; i++) {
@@ -768,11 +1223,11 @@ VkResult ve_vulkan_create_logical_device(void) {
         .alphaToOne = VK_FALSE,
         .multiViewport = VK_TRUE,
         .samplerAnisotropy = VK_TRUE,
-        .textureCompressionETC2 = VK_FALSE,
-        .textureCompressionASTC_LDR = VK_FALSE,
-        .textureCompressionBC = VK_TRUE,
-        .occlusionQueryPrecise = VK_TRUE,
-        .pipelineStatisticsQuery = VK_FALSE,
+        .textureCompressionETC2 = g_vulkan_context.device_features.textureCompressionETC2,
+        .textureCompressionASTC_LDR = g_vulkan_context.device_features.textureCompressionASTC_LDR,
+        .textureCompressionBC = g_vulkan_context.device_features.textureCompressionBC,
+        .occlusionQueryPrecise = g_vulkan_context.device_features.occlusionQueryPrecise,
+        .pipelineStatisticsQuery = g_vulkan_context.device_features.pipelineStatisticsQuery,
         .fragmentStoresAndAtomics = VK_TRUE,
         .shaderTessellationAndGeometryPointSize = VK_FALSE,
         .shaderImageGatherExtended = VK_TRUE,
@@ -802,14 +1257,105 @@ VkResult ve_vulkan_create_logical_device(void) {
         .inheritedQueries = VK_FALSE,
     };
 
+    /* Vulkan 1.2 features; host query reset lets the GPU profiler recycle queries without commands */
+    VkPhysicalDeviceVulkan12Features vulkan12_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .descriptorIndexing = g_vulkan_context.device_features.descriptorIndexing,
+        .runtimeDescriptorArray = g_vulkan_context.device_features.bindless,
+        .descriptorBindingPartiallyBound = g_vulkan_context.device_features.bindless,
+        .descriptorBindingUpdateUnusedWhilePending = g_vulkan_context.device_features.bindless,
+        .descriptorBindingSampledImageUpdateAfterBind = g_vulkan_context.device_features.bindless,
+        .descriptorBindingStorageBufferUpdateAfterBind = g_vulkan_context.device_features.bindless,
+        .shaderSampledImageArrayNonUniformIndexing = g_vulkan_context.device_features.bindless,
+        .timelineSemaphore = g_vulkan_context.device_features.timelineSemaphore,
+        .hostQueryReset = g_vulkan_context.device_features.hostQueryReset,
+        .drawIndirectCount = g_vulkan_context.device_features.indirectDrawing,
+        .samplerFilterMinmax = g_vulkan_context.device_features.samplerFilterMinmax,
+    };
+    bool vulkan12 = g_vulkan_context.device_properties.properties.apiVersion >= VK_API_VERSION_1_2;
+
+    /* Vulkan 1.3 features; synchronization2 lets the submission batcher use vkQueueSubmit2 */
+    VkPhysicalDeviceVulkan13Features vulkan13_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+        .synchronization2 = g_vulkan_context.device_features.synchronization2,
+    };
+    if (g_vulkan_context.device_properties.properties.apiVersion >= VK_API_VERSION_1_3) {
+        vulkan12_features.pNext = &vulkan13_features;
+    }
+    void* device_next = vulkan12 ? &vulkan12_features : NULL;
+
+    /* Required extensions plus the optional ones the device supports */
+    const char* extensions[sizeof(g_device_extensions) / sizeof(g_device_extensions[0]) +
+                           sizeof(g_swapchain_extensions) / sizeof(g_swapchain_extensions[0]) +
+                           sizeof(g_present_wait_extensions) / sizeof(g_present_wait_extensions[0]) +
+                           sizeof(g_mesh_shader_extensions) / sizeof(g_mesh_shader_extensions[0]) +
+                           sizeof(g_memory_budget_extensions) / sizeof(g_memory_budget_extensions[0])];
+    uint32_t extension_count = 0;
+    for (uint32_t i = 0; i < g_device_extension_count; i++) {
+        extensions[extension_count++] = g_device_extensions[i];
+    }
+    if (!g_vulkan_context.headless) {
+        for (uint32_t i = 0; i < g_swapchain_extension_count; i++) {
+            extensions[extension_count++] = g_swapchain_extensions[i];
+        }
+    }
+
+    VkPhysicalDevicePresentIdFeaturesKHR present_id_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+        .presentId = VK_TRUE,
+    };
+    VkPhysicalDevicePresentWaitFeaturesKHR present_wait_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR,
+        .pNext = &present_id_features,
+        .presentWait = VK_TRUE,
+    };
+    if (g_vulkan_context.device_features.presentWait) {
+        for (uint32_t i = 0; i < g_present_wait_extension_count; i++) {
+            extensions[extension_count++] = g_present_wait_extensions[i];
+        }
+        present_id_features.pNext = device_next;
+        device_next = &present_wait_features;
+    }
+
+    VkPhysicalDeviceMeshShaderFeaturesEXT mesh_shader_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT,
+        .taskShader = VK_TRUE,
+        .meshShader = VK_TRUE,
+    };
+    if (g_vulkan_context.device_features.meshShader) {
+        for (uint32_t i = 0; i < g_mesh_shader_extension_count; i++) {
+            extensions[extension_count++] = g_mesh_shader_extensions[i];
+        }
+        mesh_shader_features.pNext = device_next;
+        device_next = &mesh_shader_features;
+    }
+
+    if (g_vulkan_context.device_features.memoryBudget) {
+        for (uint32_t i = 0; i < g_memory_budget_extension_count; i++) {
+            extensions[extension_count++] = g_memory_budget_extensions[i];
+        }
+    }
+
+    /* One logical device over every GPU of the group */
+    VkDeviceGroupDeviceCreateInfo group_info = {
+        .sType = VK_STRUCTURE_TYPE_DEVICE_GROUP_DEVICE_CREATE_INFO,
+        .physicalDeviceCount = g_vulkan_context.group_device_count,
+        .pPhysicalDevices = g_vulkan_context.group_devices,
+    };
+    if (g_vulkan_context.group_device_count > 1) {
+        group_info.pNext = device_next;
+        device_next = &group_info;
+    }
+
     /* Create logical device */
     VkDeviceCreateInfo create_info = {
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+        .pNext = device_next,
         .queueCreateInfoCount = unique_count,
         .pQueueCreateInfos = queue_create_infos,
         .pEnabledFeatures = &device_features,
-        .enabledExtensionCount = g_device_extension_count,
-        .ppEnabledExtensionNames = g_device_extensions,
+        .enabledExtensionCount = extension_count,
+        .ppEnabledExtensionNames = extensions,
     };
 
     /* Enable validation layers for device (deprecated but for compatibility) */
@@ -824,7 +1370,9 @@ VkResult ve_vulkan_create_logical_device(void) {
     if (result == VK_SUCCESS) {
         /* Get queue handles */
         vkGetDeviceQueue(g_vulkan_context.device, indices.graphics_family, 0, &g_vulkan_context.queues.graphics);
-        vkGetDeviceQueue(g_vulkan_context.device, indices.present_family, 0, &g_vulkan_context.queues.present);
+        if (indices.present_valid) {
+            vkGetDeviceQueue(g_vulkan_context.device, indices.present_family, 0, &g_vulkan_context.queues.present);
+        }
         vkGetDeviceQueue(g_vulkan_context.device, indices.compute_family, 0, &g_vulkan_context.queues.compute);
         vkGetDeviceQueue(g_vulkan_context.device, indices.transfer_family, 0, &g_vulkan_context.queues.transfer);
     }
@@ -846,45 +1394,48 @@ void ve_vulkan_advance_frame(void) {
     g_vulkan_context.current_frame = (g_vulkan_context.current_frame + 1) % VE_MAX_FRAMES_IN_FLIGHT;
 }
 
-bool ve_vulkan_supports_bindless(void) {
-    /* Check if descriptor indexing is supported */
-    for (uint32_t i = 0; i < g_device_extension_count; i++) {
-        if (strcmp(g_device_extensions[i], VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) == 0) {
-            return true;
-        }
-    }
-    return false;
+uint32_t ve_vulkan_get_device_group_size(void) {
+    return g_vulkan_context.group_device_count > 1 ? g_vulkan_context.group_device_count : 1;
 }
 
-bool ve_vulkan_supports_raytracing(void) {
-    /* Check for ray tracing extensions */
-    uint32_t extension_count = 0;
-    vkEnumerateDeviceExtensionProperties(g_vulkan_context.physical_device, NULL,
-                                        &extension_count, NULL);
+ve_device_group_mode ve_vulkan_get_device_group_mode(void) {
+    return g_vulkan_context.group_mode;
+}
 
-    VkExtensionProperties* extensions = (VkExtensionProperties*)VE_ALLOCATE_TAG(
-        extension_count * sizeof(VkExtensionProperties), VE_MEMORY_TAG_VULKAN);
+uint32_t ve_vulkan_get_device_group_mask(void) {
+    uint32_t count = ve_vulkan_get_device_group_size();
+    return count >= 32 ? UINT32_MAX : (1u << count) - 1;
+}
 
-    if (!extensions) {
-        return false;
+uint32_t ve_vulkan_get_frame_device_mask(uint64_t frame_number) {
+    if (g_vulkan_context.group_mode == VE_DEVICE_GROUP_ALTERNATE_FRAME) {
+        return 1u << (frame_number % ve_vulkan_get_device_group_size());
     }
+    return ve_vulkan_get_device_group_mask();
+}
 
-    vkEnumerateDeviceExtensionProperties(g_vulkan_context.physical_device, NULL,
-                                        &extension_count, extensions);
-
-    bool found = false;
-    for (uint32_t i = 0; i < extension_count; i++) {
-        if (strcmp(extensions[i].extensionName, VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME) == 0) {
-            found = true;
-            break;
-        }
+void ve_vulkan_get_split_render_areas(VkRect2D render_area, VkRect2D* areas) {
+    VE_ASSERT(areas);
+
+    uint32_t count = ve_vulkan_get_device_group_size();
+    uint64_t height = render_area.extent.height;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t top = (uint32_t)(height * i / count);
+        uint32_t bottom = (uint32_t)(height * (i + 1) / count);
+        areas[i].offset.x = render_area.offset.x;
+        areas[i].offset.y = render_area.offset.y + (int32_t)top;
+        areas[i].extent.width = render_area.extent.width;
+        areas[i].extent.height = bottom - top;
     }
+}
 
-    VE_FREE(extensions);
-    return found;
+bool ve_vulkan_supports_bindless(void) {
+    /* The descriptor indexing extension alone does not guarantee the features bindless needs */
+    return g_vulkan_context.device_features.bindless;
 }
 
-bool ve_vulkan_supports_mesh_shaders(void) {
+bool ve_vulkan_supports_raytracing(void) {
+    /* Check for ray tracing extensions */
     uint32_t extension_count = 0;
     vkEnumerateDeviceExtensionProperties(g_vulkan_context.physical_device, NULL,
                                         &extension_count, NULL);
@@ -901,7 +1452,7 @@ bool ve_vulkan_supports_mesh_shaders(void) {
 
     bool found = false;
     for (uint32_t i = 0; i < extension_count; i++) {
-        if (strcmp(extensions[i].extensionName, VK_EXT_MESH_SHADER_EXTENSION_NAME) == 0) {
+        if (strcmp(extensions[i].extensionName, VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME) == 0) {
             found = true;
             break;
         }
@@ -911,11 +1462,28 @@ bool ve_vulkan_supports_mesh_shaders(void) {
     return found;
 }
 
+bool ve_vulkan_supports_mesh_shaders(void) {
+    /* Enabled at device creation only when both task and mesh shaders are supported */
+    return g_vulkan_context.device_features.meshShader;
+}
+
 bool ve_vulkan_supports_compute(void) {
     /* All Vulkan devices support compute shaders */
     return true;
 }
 
+bool ve_vulkan_supports_async_compute(void) {
+    /* A compute family shared with graphics hands out the graphics queue itself */
+    return g_vulkan_context.device != VK_NULL_HANDLE &&
+           g_vulkan_context.queues.compute != VK_NULL_HANDLE &&
+           g_vulkan_context.queues.compute != g_vulkan_context.queues.graphics;
+}
+
+bool ve_vulkan_supports_draw_indirect_count(void) {
+    /* Only stored for 1.2 devices, where vkCmdDraw*IndirectCount are core */
+    return g_vulkan_context.device_features.indirectDrawing;
+}
+
 uint32_t ve_vulkan_find_memory_type(uint32_t type_bits, VkMemoryPropertyFlags properties) {
     VkPhysicalDeviceMemoryProperties* mem_props = &g_vulkan_context.device_properties.memory_properties;
 
@@ -957,6 +1525,9 @@ void ve_vulkan_set_object_name(uint64_t handle, VkObjectType type, const char* n
 }
 
 void ve_vulkan_begin_debug_label(VkCommandBuffer cmd, const char* name, float r, float g, float b) {
+    /* Labels double as GPU profiler zones, also when validation is off */
+    ve_gpu_profiler_begin_zone(cmd, name);
+
     if (!g_vulkan_context.validation_enabled || !name) {
         return;
     }
@@ -971,6 +1542,8 @@ void ve_vulkan_begin_debug_label(VkCommandBuffer cmd, const char* name, float r,
 }
 
 void ve_vulkan_end_debug_label(VkCommandBuffer cmd) {
+    ve_gpu_profiler_end_zone(cmd);
+
     if (g_vulkan_context.validation_enabled) {
         vkCmdEndDebugUtilsLabelEXT(cmd);
     }
@@ -25,6 +25,7 @@ extern "C" {
 #define VE_MAX_FRAMES_IN_FLIGHT 3
 #define VE_MAX_COMPUTE_QUEUES 1
 #define VE_MAX_TRANSFER_QUEUES 1
+#define VE_MAX_DEVICE_GROUP_SIZE VK_MAX_DEVICE_GROUP_SIZE
 
 /* Forward declarations */
 typedef struct ve_vulkan_context ve_vulkan_context;
@@ -114,12 +115,18 @@ typedef struct vulkan_device_features {
 
     /* Extension-specific features */
     bool descriptorIndexing;
+    bool bindless;                  /* Update-after-bind, partially bound runtime descriptor arrays */
     bool shaderDrawParameters;
     bool timelineSemaphore;
     bool vulkanMemoryModel;
     bool shaderSubgroupExtendedTypes;
     bool separateDepthStencilLayouts;
     bool hostQueryReset;
+    bool synchronization2;
+    bool presentWait;               /* VK_KHR_present_id and VK_KHR_present_wait */
+    bool meshShader;                /* VK_EXT_mesh_shader task and mesh stages */
+    bool memoryBudget;              /* VK_EXT_memory_budget heap budgets and usage */
+    bool samplerFilterMinmax;       /* Min/max sampler reduction, used to build depth pyramids */
     bool indirectDrawing;
     bool shaderInt8;
     bool shaderAtomicInt64;
@@ -143,6 +150,42 @@ typedef struct vulkan_device_properties {
     VkPhysicalDeviceVulkan13Properties vulkan13;
 } vulkan_device_properties;
 
+/**
+ * @brief How the physical devices of a device group share frames
+ */
+typedef enum ve_device_group_mode {
+    VE_DEVICE_GROUP_NONE,               /* One physical device */
+    VE_DEVICE_GROUP_ALTERNATE_FRAME,    /* Each frame runs on the next device in turn */
+    VE_DEVICE_GROUP_SPLIT_FRAME,        /* Every frame runs on all devices, each rendering a band */
+} ve_device_group_mode;
+
+/**
+ * @brief Which physical device to use, set before initialization
+ *
+ * With neither an index nor a UUID the highest-scoring suitable device is
+ * picked.
+ */
+typedef struct ve_vulkan_device_selection {
+    int32_t index;                      /* vkEnumeratePhysicalDevices order, -1 for any */
+    bool match_uuid;                    /* Pick the device whose deviceUUID is uuid */
+    uint8_t uuid[VK_UUID_SIZE];
+    ve_device_group_mode group_mode;    /* Use the device's group when it has several devices */
+} ve_vulkan_device_selection;
+
+/**
+ * @brief Physical device as seen by device selection
+ */
+typedef struct ve_vulkan_device_info {
+    uint32_t index;                     /* vkEnumeratePhysicalDevices order */
+    char name[VK_MAX_PHYSICAL_DEVICE_NAME_SIZE];
+    VkPhysicalDeviceType type;
+    uint8_t uuid[VK_UUID_SIZE];         /* Zero before Vulkan 1.1 */
+    VkDeviceSize device_local_bytes;    /* Largest device-local heap */
+    int64_t score;                      /* Higher is preferred */
+    bool suitable;
+    uint32_t group_size;                /* Physical devices in its device group */
+} ve_vulkan_device_info;
+
 /**
  * @brief Swapchain support details
  */
@@ -173,6 +216,11 @@ struct ve_vulkan_context {
     /* Logical device */
     VkDevice device;
 
+    /* Device group; one device and VE_DEVICE_GROUP_NONE without a group */
+    VkPhysicalDevice group_devices[VE_MAX_DEVICE_GROUP_SIZE];
+    uint32_t group_device_count;
+    ve_device_group_mode group_mode;
+
     /* Queues */
     ve_queue_family_indices queue_families;
     ve_queues queues;
@@ -185,6 +233,7 @@ struct ve_vulkan_context {
 
     /* State */
     bool validation_enabled;
+    bool headless;                  /* No surface or swapchain, see ve_vulkan_init_headless */
     bool initialized;
     uint32_t current_frame;
 };
@@ -196,6 +245,18 @@ struct ve_vulkan_context {
  */
 ve_vulkan_context* ve_vulkan_get_context(void);
 
+/**
+ * @brief Load the Vulkan runtime and enumerate instance layers and extensions
+ *
+ * The slow part of instance creation that needs no window, so startup can
+ * run it on a worker while the window is created. Called by
+ * ve_vulkan_init if it has not run; the results are kept until
+ * ve_vulkan_shutdown.
+ *
+ * @return false if the Vulkan runtime is not available
+ */
+bool ve_vulkan_preload(void);
+
 /**
  * @brief Initialize Vulkan
  *
@@ -206,6 +267,29 @@ ve_vulkan_context* ve_vulkan_get_context(void);
  */
 bool ve_vulkan_init(const char* application_name, uint32_t application_version, bool enable_validation);
 
+/**
+ * @brief Initialize Vulkan without a window system
+ *
+ * For servers and build machines with no display. No surface instance
+ * extensions are requested, device selection needs only a graphics queue,
+ * and the swapchain extension is not enabled: frames render into offscreen
+ * images (offscreen.h) and are read back, not presented. The present queue
+ * stays VK_NULL_HANDLE and ve_vulkan_create_surface must not be called.
+ *
+ * @param application_name Application name
+ * @param application_version Application version (VK_MAKE_VERSION)
+ * @param enable_validation Enable validation layers
+ * @return true on success
+ */
+bool ve_vulkan_init_headless(const char* application_name, uint32_t application_version, bool enable_validation);
+
+/**
+ * @brief Check if Vulkan was initialized headless
+ *
+ * @return true after ve_vulkan_init_headless
+ */
+bool ve_vulkan_is_headless(void);
+
 /**
  * @brief Shutdown Vulkan
  */
@@ -241,6 +325,27 @@ bool ve_vulkan_check_validation_support(void);
  */
 VkResult ve_vulkan_pick_physical_device(void);
 
+/**
+ * @brief Choose the device the next initialization picks
+ *
+ * Call before ve_vulkan_init. An index or UUID that matches no suitable
+ * device fails initialization rather than falling back to another GPU.
+ *
+ * @param selection Selection, NULL for the default
+ */
+void ve_vulkan_set_device_selection(const ve_vulkan_device_selection* selection);
+
+/**
+ * @brief Describe and score every physical device
+ *
+ * Needs the instance, so call after ve_vulkan_init.
+ *
+ * @param devices Output array, NULL to query the count
+ * @param count Input capacity, output device count
+ * @return VK_SUCCESS, or VK_INCOMPLETE if the array was too small
+ */
+VkResult ve_vulkan_enumerate_devices(ve_vulkan_device_info* devices, uint32_t* count);
+
 /**
  * @brief Check if a physical device is suitable
  *
@@ -325,11 +430,56 @@ uint32_t ve_vulkan_get_current_frame(void);
  */
 void ve_vulkan_advance_frame(void);
 
+/* Device groups */
+
+/**
+ * @brief Get the number of physical devices behind the logical device
+ *
+ * @return Devices in the group, 1 without a group
+ */
+uint32_t ve_vulkan_get_device_group_size(void);
+
+/**
+ * @brief Get how frames are shared between the devices of the group
+ *
+ * @return Mode, VE_DEVICE_GROUP_NONE without a group
+ */
+ve_device_group_mode ve_vulkan_get_device_group_mode(void);
+
+/**
+ * @brief Get the mask of every device in the group
+ *
+ * @return Device mask, 1 without a group
+ */
+uint32_t ve_vulkan_get_device_group_mask(void);
+
+/**
+ * @brief Get the devices that execute a frame's command buffers
+ *
+ * One device in turn for alternate-frame rendering, all of them otherwise.
+ * Set it on the frame's command buffers with ve_command_buffer_set_device_mask.
+ *
+ * @param frame_number Frame number (ve_sync_get_frame_number)
+ * @return Device mask
+ */
+uint32_t ve_vulkan_get_frame_device_mask(uint64_t frame_number);
+
+/**
+ * @brief Split a render area into one horizontal band per device
+ *
+ * @param render_area Whole render area
+ * @param areas Output, ve_vulkan_get_device_group_size entries
+ */
+void ve_vulkan_get_split_render_areas(VkRect2D render_area, VkRect2D* areas);
+
 /* Device feature queries */
 
 /**
  * @brief Check if device supports bindless descriptors
  *
+ * Requires partially bound, update-after-bind runtime descriptor arrays,
+ * which are enabled on the device when available.
+ *
  * @return true if supported
  */
 bool ve_vulkan_supports_bindless(void);
@@ -355,6 +505,20 @@ bool ve_vulkan_supports_mesh_shaders(void);
  */
 bool ve_vulkan_supports_compute(void);
 
+/**
+ * @brief Check if compute work can run on a queue separate from graphics
+ *
+ * @return true if ve_queues.compute is not the graphics queue
+ */
+bool ve_vulkan_supports_async_compute(void);
+
+/**
+ * @brief Check if indirect draws can read their count from a buffer
+ *
+ * @return true if drawIndirectCount was enabled
+ */
+bool ve_vulkan_supports_draw_indirect_count(void);
+
 /**
  * @brief Get device memory type index
  *
@@ -411,6 +575,9 @@ void ve_vulkan_set_object_name(uint64_t handle, VkObjectType type, const char* n
 
 /**
  * @brief Begin a debug label region
+ *
+ * The region is also timed by the GPU profiler when cmd is the frame's
+ * graphics command buffer, see ve_gpu_profiler_begin_zone.
  */
 void ve_vulkan_begin_debug_label(VkCommandBuffer cmd, const char* name, float r, float g, float b);
 
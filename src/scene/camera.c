@@ -4,5 +4,430 @@
  */
 
 #include "camera.h"
+#include "../core/memory.h"
+#include "../core/logger.h"
+#include "../core/assert.h"
 
-/* TODO: Implement camera system */
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Subtrees per worker, so uneven subtrees still balance */
+#define CAMERA_SUBTREES_PER_THREAD 4
+
+/* Instances per task when building sort keys */
+#define CAMERA_KEY_GRAIN 1024
+
+#define CAMERA_RADIX_BITS 8
+#define CAMERA_RADIX_BUCKETS (1u << CAMERA_RADIX_BITS)
+#define CAMERA_RADIX_PASSES (64 / CAMERA_RADIX_BITS)
+
+typedef struct camera_cull_state {
+    const ve_bvh* bvh;
+    const ve_frustum* frustum;
+    const uint32_t* subtrees;
+    const uint32_t* offsets;
+    uint32_t* counts;
+    uint32_t* users;
+} camera_cull_state;
+
+typedef struct camera_key_state {
+    const ve_camera* camera;
+    ve_scene* scene;
+    const ve_node_graph* nodes;
+    const uint32_t* users;
+    ve_visible_instance* instances;
+    uint64_t* keys;
+    uint32_t* order;
+} camera_key_state;
+
+/* Instance of a pipeline and material run, sorted by mesh and level of detail */
+typedef struct camera_draw_item {
+    uint32_t mesh;
+    uint32_t lod;
+    uint32_t position;          /* Index in the visible list */
+} camera_draw_item;
+
+typedef struct camera_cull_task {
+    ve_camera* camera;
+    ve_scene* scene;
+    ve_thread_pool* pool;
+    bool result;
+} camera_cull_task;
+
+static void cull_subtrees(uint32_t begin, uint32_t end, void* user_data) {
+    camera_cull_state* state = (camera_cull_state*)user_data;
+
+    for (uint32_t i = begin; i < end; i++) {
+        uint32_t capacity = state->offsets[i + 1] - state->offsets[i];
+        state->counts[i] = ve_bvh_cull_frustum_subtree(state->bvh, state->subtrees[i], state->frustum,
+                                                       state->users + state->offsets[i], capacity);
+    }
+}
+
+/**
+ * @brief Pipeline and material in the high bits, depth in the low bits
+ *
+ * Depth is non-negative, so its float bits order the same as its value.
+ */
+static uint64_t make_key(uint32_t pipeline, uint32_t material, float depth) {
+    uint32_t depth_bits;
+    memcpy(&depth_bits, &depth, sizeof(depth_bits));
+    return ((uint64_t)(pipeline & 0xFFFF) << 48) | ((uint64_t)(material & 0xFFFF) << 32) | depth_bits;
+}
+
+/**
+ * @brief Fraction of the viewport height a unit length covers at a depth
+ *
+ * The node's largest axis scale brings local errors to world units.
+ * Orthographic projections scale the same at every depth.
+ */
+static float lod_error_scale(const ve_camera* camera, const ve_mat4* world, float depth) {
+    const float* m = world->m;
+    float scale_sq = fmaxf(m[0] * m[0] + m[1] * m[1] + m[2] * m[2],
+                           fmaxf(m[4] * m[4] + m[5] * m[5] + m[6] * m[6], m[8] * m[8] + m[9] * m[9] + m[10] * m[10]));
+    float projection = fabsf(camera->projection.m[5]) * 0.5f * sqrtf(scale_sq);
+    if (camera->projection.m[11] == 0.0f) {
+        return projection;
+    }
+    return depth > 0.0f ? projection / depth : INFINITY;
+}
+
+static void build_keys(uint32_t begin, uint32_t end, void* user_data) {
+    camera_key_state* state = (camera_key_state*)user_data;
+    const ve_camera* camera = state->camera;
+    const ve_mat4* view = &camera->view;
+
+    for (uint32_t i = begin; i < end; i++) {
+        ve_node node = state->users[i];
+        const ve_mat4* world = ve_node_get_world(state->nodes, node);
+        float depth = -(view->m[2] * world->m[12] + view->m[6] * world->m[13] + view->m[10] * world->m[14] +
+                        view->m[14]);
+        depth = depth > 0.0f ? depth : 0.0f;
+
+        ve_visible_instance* instance = &state->instances[i];
+        instance->node = node;
+        instance->depth = depth;
+        ve_scene_get_render(state->scene, node, &instance->pipeline, &instance->material);
+        ve_scene_get_instance(state->scene, node, &instance->mesh, &instance->instance);
+        instance->lod = ve_scene_select_lod(state->scene, node, camera->lod_view,
+                                            lod_error_scale(camera, world, depth), camera->lod_threshold);
+
+        state->keys[i] = make_key(instance->pipeline, instance->material, depth);
+        state->order[i] = i;
+    }
+}
+
+/**
+ * @brief Stable LSD radix sort of keys with their values
+ *
+ * Byte passes whose digit is the same for every key are skipped, so keys
+ * with few distinct pipelines and materials cost little more than the
+ * depth passes. The sorted result ends up in keys and values.
+ */
+static void radix_sort(uint64_t* keys, uint32_t* values, uint64_t* temp_keys, uint32_t* temp_values,
+                       uint32_t count) {
+    uint32_t histograms[CAMERA_RADIX_PASSES][CAMERA_RADIX_BUCKETS];
+    memset(histograms, 0, sizeof(histograms));
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t key = keys[i];
+        for (uint32_t pass = 0; pass < CAMERA_RADIX_PASSES; pass++) {
+            histograms[pass][(key >> (pass * CAMERA_RADIX_BITS)) & (CAMERA_RADIX_BUCKETS - 1)]++;
+        }
+    }
+
+    uint64_t* src_keys = keys;
+    uint32_t* src_values = values;
+    uint64_t* dst_keys = temp_keys;
+    uint32_t* dst_values = temp_values;
+
+    for (uint32_t pass = 0; pass < CAMERA_RADIX_PASSES; pass++) {
+        uint32_t* histogram = histograms[pass];
+        uint32_t shift = pass * CAMERA_RADIX_BITS;
+        if (histogram[(src_keys[0] >> shift) & (CAMERA_RADIX_BUCKETS - 1)] == count) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (uint32_t bucket = 0; bucket < CAMERA_RADIX_BUCKETS; bucket++) {
+            uint32_t bucket_count = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucket_count;
+        }
+
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t dst = histogram[(src_keys[i] >> shift) & (CAMERA_RADIX_BUCKETS - 1)]++;
+            dst_keys[dst] = src_keys[i];
+            dst_values[dst] = src_values[i];
+        }
+
+        uint64_t* swap_keys = src_keys;
+        src_keys = dst_keys;
+        dst_keys = swap_keys;
+        uint32_t* swap_values = src_values;
+        src_values = dst_values;
+        dst_values = swap_values;
+    }
+
+    if (src_keys != keys) {
+        memcpy(keys, src_keys, sizeof(uint64_t) * count);
+        memcpy(values, src_values, sizeof(uint32_t) * count);
+    }
+}
+
+void ve_camera_init_perspective(ve_camera* camera, float fov_y, float aspect, float z_near, float z_far) {
+    VE_ASSERT(camera);
+
+    memset(camera, 0, sizeof(*camera));
+    camera->view = ve_mat4_identity();
+    camera->projection = ve_mat4_perspective(fov_y, aspect, z_near, z_far);
+    camera->lod_threshold = VE_CAMERA_LOD_THRESHOLD;
+    ve_camera_update(camera);
+}
+
+void ve_camera_look_at(ve_camera* camera, ve_vec3 eye, ve_vec3 target, ve_vec3 up) {
+    VE_ASSERT(camera);
+
+    camera->view = ve_mat4_look_at(eye, target, up);
+    camera->position = eye;
+}
+
+void ve_camera_set_view(ve_camera* camera, const ve_mat4* view) {
+    VE_ASSERT(camera && view);
+
+    camera->view = *view;
+
+    /* The eye is -R^T t for a rigid view */
+    const float* m = view->m;
+    camera->position = ve_vec3_make(-(m[0] * m[12] + m[1] * m[13] + m[2] * m[14]),
+                                    -(m[4] * m[12] + m[5] * m[13] + m[6] * m[14]),
+                                    -(m[8] * m[12] + m[9] * m[13] + m[10] * m[14]));
+}
+
+void ve_camera_update(ve_camera* camera) {
+    VE_ASSERT(camera);
+
+    camera->view_projection = ve_mat4_mul(&camera->projection, &camera->view);
+    ve_frustum_from_matrix(&camera->view_projection, &camera->frustum);
+}
+
+bool ve_camera_cull(ve_camera* camera, ve_scene* scene, ve_thread_pool* pool) {
+    VE_ASSERT(camera && scene);
+
+    camera->visibility.instances = NULL;
+    camera->visibility.count = 0;
+
+    const ve_bvh* bvh = ve_scene_get_bvh(scene);
+    uint32_t total = ve_bvh_get_count(bvh);
+    if (total == 0) {
+        return true;
+    }
+
+    /* Every subtree gets an exact slice of the output, so tasks never share one */
+    uint32_t subtrees[VE_CAMERA_MAX_SUBTREES];
+    uint32_t offsets[VE_CAMERA_MAX_SUBTREES + 1];
+    uint32_t counts[VE_CAMERA_MAX_SUBTREES];
+    uint32_t wanted = (ve_thread_pool_get_thread_count(pool) + 1) * CAMERA_SUBTREES_PER_THREAD;
+    uint32_t subtree_count = ve_bvh_get_subtrees(bvh, pool ? wanted : 1, subtrees, VE_CAMERA_MAX_SUBTREES);
+
+    offsets[0] = 0;
+    for (uint32_t i = 0; i < subtree_count; i++) {
+        offsets[i + 1] = offsets[i] + ve_bvh_get_subtree_count(bvh, subtrees[i]);
+    }
+
+    uint32_t* users = (uint32_t*)ve_frame_allocate(sizeof(uint32_t) * total);
+    if (!users) {
+        VE_LOG_ERROR("Out of frame memory culling %u scene bounds", total);
+        return false;
+    }
+
+    camera_cull_state cull = {
+        .bvh = bvh,
+        .frustum = &camera->frustum,
+        .subtrees = subtrees,
+        .offsets = offsets,
+        .counts = counts,
+        .users = users,
+    };
+    ve_parallel_for(pool, 0, subtree_count, 1, cull_subtrees, &cull);
+
+    uint32_t visible_count = 0;
+    for (uint32_t i = 0; i < subtree_count; i++) {
+        memmove(users + visible_count, users + offsets[i], sizeof(uint32_t) * counts[i]);
+        visible_count += counts[i];
+    }
+    if (visible_count == 0) {
+        return true;
+    }
+
+    ve_visible_instance* unsorted =
+        (ve_visible_instance*)ve_frame_allocate(sizeof(ve_visible_instance) * visible_count);
+    ve_visible_instance* instances =
+        (ve_visible_instance*)ve_frame_allocate(sizeof(ve_visible_instance) * visible_count);
+    uint64_t* keys = (uint64_t*)ve_frame_allocate(sizeof(uint64_t) * visible_count * 2);
+    uint32_t* order = (uint32_t*)ve_frame_allocate(sizeof(uint32_t) * visible_count * 2);
+    if (!unsorted || !instances || !keys || !order) {
+        VE_LOG_ERROR("Out of frame memory sorting %u visible instances", visible_count);
+        return false;
+    }
+
+    camera_key_state key_state = {
+        .camera = camera,
+        .scene = scene,
+        .nodes = ve_scene_get_nodes(scene),
+        .users = users,
+        .instances = unsorted,
+        .keys = keys,
+        .order = order,
+    };
+    ve_parallel_for(pool, 0, visible_count, CAMERA_KEY_GRAIN, build_keys, &key_state);
+
+    radix_sort(keys, order, keys + visible_count, order + visible_count, visible_count);
+    for (uint32_t i = 0; i < visible_count; i++) {
+        instances[i] = unsorted[order[i]];
+    }
+
+    camera->visibility.instances = instances;
+    camera->visibility.count = visible_count;
+    return true;
+}
+
+static void cull_camera_task(void* user_data) {
+    camera_cull_task* task = (camera_cull_task*)user_data;
+    task->result = ve_camera_cull(task->camera, task->scene, task->pool);
+}
+
+bool ve_camera_cull_many(ve_camera* cameras, uint32_t count, ve_scene* scene, ve_thread_pool* pool) {
+    VE_ASSERT((cameras || count == 0) && scene);
+
+    if (!pool || count <= 1) {
+        bool result = true;
+        for (uint32_t i = 0; i < count; i++) {
+            result = ve_camera_cull(&cameras[i], scene, pool) && result;
+        }
+        return result;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        for (uint32_t j = i + 1; j < count; j++) {
+            VE_ASSERT_MSG(cameras[i].lod_view != cameras[j].lod_view, "Cameras culled together share a LOD view");
+        }
+    }
+
+    camera_cull_task* tasks = (camera_cull_task*)ve_frame_allocate(sizeof(camera_cull_task) * count);
+    if (!tasks) {
+        VE_LOG_ERROR("Out of frame memory culling %u cameras", count);
+        return false;
+    }
+
+    ve_task_group group;
+    ve_task_group_init(&group, pool);
+    for (uint32_t i = 0; i < count; i++) {
+        tasks[i] = (camera_cull_task){&cameras[i], scene, pool, false};
+        if (!ve_task_group_run(&group, cull_camera_task, &tasks[i])) {
+            cull_camera_task(&tasks[i]);
+        }
+    }
+    ve_task_group_wait(&group);
+
+    bool result = true;
+    for (uint32_t i = 0; i < count; i++) {
+        result = tasks[i].result && result;
+    }
+    return result;
+}
+
+static int compare_draw_items(const void* a, const void* b) {
+    const camera_draw_item* x = (const camera_draw_item*)a;
+    const camera_draw_item* y = (const camera_draw_item*)b;
+    if (x->mesh != y->mesh) {
+        return x->mesh < y->mesh ? -1 : 1;
+    }
+    if (x->lod != y->lod) {
+        return x->lod < y->lod ? -1 : 1;
+    }
+    return (x->position > y->position) - (x->position < y->position);
+}
+
+/* Draws of one run are ordered by their nearest instance, which is the first item of each group */
+static int compare_draws(const void* a, const void* b) {
+    const ve_instanced_draw* x = (const ve_instanced_draw*)a;
+    const ve_instanced_draw* y = (const ve_instanced_draw*)b;
+    return (x->first_instance > y->first_instance) - (x->first_instance < y->first_instance);
+}
+
+bool ve_camera_build_draws(const ve_camera* camera, ve_camera_draws* draws) {
+    VE_ASSERT(camera && draws);
+
+    memset(draws, 0, sizeof(*draws));
+    const ve_visible_instance* visible = camera->visibility.instances;
+    uint32_t count = camera->visibility.count;
+    if (count == 0) {
+        return true;
+    }
+
+    camera_draw_item* items = (camera_draw_item*)ve_frame_allocate(sizeof(camera_draw_item) * count);
+    ve_instanced_draw* out_draws = (ve_instanced_draw*)ve_frame_allocate(sizeof(ve_instanced_draw) * count);
+    uint32_t* instances = (uint32_t*)ve_frame_allocate(sizeof(uint32_t) * count);
+    if (!items || !out_draws || !instances) {
+        VE_LOG_ERROR("Out of frame memory building draws for %u instances", count);
+        return false;
+    }
+
+    uint32_t draw_count = 0;
+    uint32_t begin = 0;
+    while (begin < count) {
+        uint32_t end = begin + 1;
+        while (end < count && visible[end].pipeline == visible[begin].pipeline &&
+               visible[end].material == visible[begin].material) {
+            end++;
+        }
+
+        for (uint32_t i = begin; i < end; i++) {
+            items[i] = (camera_draw_item){visible[i].mesh, visible[i].lod, i};
+        }
+        qsort(items + begin, end - begin, sizeof(camera_draw_item), compare_draw_items);
+
+        /* Group first, with first_instance holding the nearest position until the groups are ordered */
+        uint32_t run_first = draw_count;
+        for (uint32_t i = begin; i < end; i++) {
+            if (i == begin || items[i].mesh != items[i - 1].mesh || items[i].lod != items[i - 1].lod) {
+                out_draws[draw_count++] = (ve_instanced_draw){
+                    .pipeline = visible[begin].pipeline,
+                    .material = visible[begin].material,
+                    .mesh = items[i].mesh,
+                    .lod = items[i].lod,
+                    .first_instance = items[i].position,
+                    .instance_count = 0,
+                };
+            }
+            out_draws[draw_count - 1].instance_count++;
+        }
+
+        qsort(out_draws + run_first, draw_count - run_first, sizeof(ve_instanced_draw), compare_draws);
+
+        /* Lay the instance slots out in draw order; a group's nearest item is where its items start */
+        uint32_t slot = begin;
+        for (uint32_t d = run_first; d < draw_count; d++) {
+            uint32_t nearest = out_draws[d].first_instance;
+            camera_draw_item key = {visible[nearest].mesh, visible[nearest].lod, nearest};
+            const camera_draw_item* group = (const camera_draw_item*)bsearch(
+                &key, items + begin, end - begin, sizeof(camera_draw_item), compare_draw_items);
+            VE_ASSERT(group);
+            for (uint32_t i = 0; i < out_draws[d].instance_count; i++) {
+                instances[slot + i] = visible[group[i].position].instance;
+            }
+            out_draws[d].first_instance = slot;
+            slot += out_draws[d].instance_count;
+        }
+
+        begin = end;
+    }
+
+    draws->draws = out_draws;
+    draws->draw_count = draw_count;
+    draws->instances = instances;
+    draws->instance_count = count;
+    return true;
+}
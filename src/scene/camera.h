@@ -1,18 +1,198 @@
 /**
  * @file camera.h
  * @brief Camera system
+ *
+ * A camera owns the visibility result of its view. ve_camera_update
+ * extracts the frustum once per frame, and ve_camera_cull runs it against
+ * the scene BVH and leaves a list of visible instances in the frame
+ * allocator, sorted by pipeline, then material, then depth front to back.
+ * Drawing the list in order binds each pipeline and material once.
+ *
+ * Culling splits the BVH into subtrees and traverses them across the
+ * thread pool; the list is sorted with a radix sort over 64-bit keys.
+ * ve_camera_cull_many culls several cameras (main view, shadows,
+ * reflections) against the same scene concurrently. The scene must not be
+ * modified while a cull runs.
+ *
+ * Culling also picks a level of detail for every visible node with levels
+ * (ve_scene_set_lods): the coarsest whose geometric error, projected at
+ * the node's depth, covers at most lod_threshold of the viewport height.
+ * The choice has hysteresis per camera view (lod_view), so instances do
+ * not pop back and forth at the boundary distance.
+ *
+ * ve_camera_build_draws merges the sorted list into instanced draws: the
+ * instances of a pipeline and material run that share a mesh and level of
+ * detail become one draw over a range of instance slots (see
+ * ve_scene_set_instance and renderer/instancing.h).
  */
 
 #ifndef VE_CAMERA_H
 #define VE_CAMERA_H
 
+#include "scene.h"
+#include "../math/vmath.h"
+#include "../core/thread.h"
 #include <stdint.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* TODO: Implement camera system */
+/* Most BVH subtrees one cull is split into */
+#define VE_CAMERA_MAX_SUBTREES 256
+
+/* Default projected error allowed for a level of detail: about a pixel at 1080p */
+#define VE_CAMERA_LOD_THRESHOLD (1.0f / 1080.0f)
+
+/**
+ * @brief Instance that passed culling
+ */
+typedef struct ve_visible_instance {
+    ve_node node;
+    uint32_t pipeline;
+    uint32_t material;
+    uint32_t lod;               /* Level of detail to draw, 0 is the finest */
+    uint32_t mesh;
+    uint32_t instance;          /* Slot in the instance buffer */
+    float depth;                /* View space distance along the view direction */
+} ve_visible_instance;
+
+/**
+ * @brief Result of the last cull
+ *
+ * The instances live in the frame allocator slot that was current during
+ * the cull.
+ */
+typedef struct ve_camera_visibility {
+    ve_visible_instance* instances;
+    uint32_t count;
+} ve_camera_visibility;
+
+/**
+ * @brief Instances drawn with one instanced draw
+ *
+ * first_instance indexes ve_camera_draws::instances and is passed as the
+ * draw's first instance, so shaders find the slot of instance
+ * gl_InstanceIndex at that position.
+ */
+typedef struct ve_instanced_draw {
+    uint32_t pipeline;
+    uint32_t material;
+    uint32_t mesh;
+    uint32_t lod;
+    uint32_t first_instance;
+    uint32_t instance_count;
+} ve_instanced_draw;
+
+/**
+ * @brief Instanced draws of a visible list
+ *
+ * Both arrays live in the frame allocator slot that was current when they
+ * were built.
+ */
+typedef struct ve_camera_draws {
+    ve_instanced_draw* draws;
+    uint32_t draw_count;
+    uint32_t* instances;        /* Instance slots, in draw order */
+    uint32_t instance_count;
+} ve_camera_draws;
+
+/**
+ * @brief Camera
+ */
+typedef struct ve_camera {
+    ve_mat4 view;
+    ve_mat4 projection;
+    ve_mat4 view_projection;    /* Set by ve_camera_update */
+    ve_frustum frustum;         /* Set by ve_camera_update */
+    ve_vec3 position;
+    float lod_threshold;        /* Projected error allowed, as a fraction of the viewport height */
+    uint32_t lod_view;          /* Level of detail history slot, below VE_SCENE_LOD_VIEWS */
+    ve_camera_visibility visibility;
+} ve_camera;
+
+/**
+ * @brief Initialize a camera with a perspective projection
+ *
+ * The camera starts at the origin looking down -Z, with the default
+ * level of detail threshold and view 0.
+ *
+ * @param camera Camera
+ * @param fov_y Vertical field of view in radians
+ * @param aspect Width over height
+ * @param z_near Near plane distance
+ * @param z_far Far plane distance
+ */
+void ve_camera_init_perspective(ve_camera* camera, float fov_y, float aspect, float z_near, float z_far);
+
+/**
+ * @brief Place a camera at eye looking at target
+ *
+ * @param camera Camera
+ * @param eye Position
+ * @param target Point to look at
+ * @param up Up direction
+ */
+void ve_camera_look_at(ve_camera* camera, ve_vec3 eye, ve_vec3 target, ve_vec3 up);
+
+/**
+ * @brief Set the view matrix of a camera directly
+ *
+ * @param camera Camera
+ * @param view Rigid view matrix
+ */
+void ve_camera_set_view(ve_camera* camera, const ve_mat4* view);
+
+/**
+ * @brief Recompute the view-projection and frustum
+ *
+ * Call once per frame after moving the camera and before culling.
+ *
+ * @param camera Camera
+ */
+void ve_camera_update(ve_camera* camera);
+
+/**
+ * @brief Cull a scene and build the sorted visible list
+ *
+ * The scene must have been updated this frame. Replaces the camera's
+ * visibility with a list allocated from the frame allocator.
+ *
+ * @param camera Updated camera
+ * @param scene Scene
+ * @param pool Pool to spread the work across (NULL runs on the calling thread)
+ * @return false if the frame allocator is out of memory or not initialized
+ */
+bool ve_camera_cull(ve_camera* camera, ve_scene* scene, ve_thread_pool* pool);
+
+/**
+ * @brief Cull a scene for several cameras concurrently
+ *
+ * Each camera is culled by its own task, which splits its traversal
+ * across the pool as well. The cameras must have distinct lod_view slots.
+ *
+ * @param cameras Updated cameras
+ * @param count Number of cameras
+ * @param scene Scene
+ * @param pool Pool to spread the work across (NULL runs on the calling thread)
+ * @return false if any cull failed
+ */
+bool ve_camera_cull_many(ve_camera* cameras, uint32_t count, ve_scene* scene, ve_thread_pool* pool);
+
+/**
+ * @brief Merge a camera's visible list into instanced draws
+ *
+ * Draws follow the pipeline and material order of the list. Within a
+ * pipeline and material run, the instances of each mesh and level of
+ * detail are gathered into one draw, and the draws are ordered by their
+ * nearest instance, so the run still draws roughly front to back.
+ *
+ * @param camera Camera culled this frame
+ * @param draws Output draws, allocated from the frame allocator
+ * @return false if the frame allocator is out of memory
+ */
+bool ve_camera_build_draws(const ve_camera* camera, ve_camera_draws* draws);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,188 @@
+/**
+ * @file camera_path.c
+ * @brief Recorded camera paths implementation
+ */
+
+#include "camera_path.h"
+#include "../core/memory.h"
+#include "../core/logger.h"
+#include "../platform/platform.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Values per key line: time, eye, target */
+#define CAMERA_PATH_KEY_VALUES 7
+
+static bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/* Parse one line into a key; false if it is not seven numbers */
+static bool parse_key(char* line, ve_camera_key* key) {
+    float values[CAMERA_PATH_KEY_VALUES];
+    char* cursor = line;
+    for (uint32_t i = 0; i < CAMERA_PATH_KEY_VALUES; i++) {
+        char* end;
+        values[i] = strtof(cursor, &end);
+        if (end == cursor) {
+            return false;
+        }
+        cursor = end;
+    }
+    while (is_blank(*cursor)) {
+        cursor++;
+    }
+    if (*cursor != '\0') {
+        return false;
+    }
+
+    key->time = values[0];
+    key->eye = ve_vec3_make(values[1], values[2], values[3]);
+    key->target = ve_vec3_make(values[4], values[5], values[6]);
+    return true;
+}
+
+bool ve_camera_path_parse(const char* text, size_t size, ve_camera_path* path) {
+    memset(path, 0, sizeof(ve_camera_path));
+    if (!text || size == 0) {
+        return false;
+    }
+
+    /* A NUL terminated copy, so lines can be split and fed to strtof */
+    char* source = (char*)VE_ALLOCATE_TAG(size + 1, VE_MEMORY_TAG_STRING);
+    if (!source) {
+        VE_LOG_ERROR("Out of memory parsing camera path");
+        return false;
+    }
+    memcpy(source, text, size);
+    source[size] = '\0';
+
+    uint32_t capacity = 0;
+    uint32_t line_number = 0;
+    bool success = true;
+    for (char* line = source; line && success; line_number++) {
+        char* next = strchr(line, '\n');
+        if (next) {
+            *next++ = '\0';
+        }
+        while (is_blank(*line)) {
+            line++;
+        }
+        if (*line == '\0' || *line == '#') {
+            line = next;
+            continue;
+        }
+
+        ve_camera_key key;
+        if (!parse_key(line, &key)) {
+            VE_LOG_ERROR("Malformed camera path key on line %u", line_number + 1);
+            success = false;
+        } else if (path->count > 0 && key.time <= path->keys[path->count - 1].time) {
+            VE_LOG_ERROR("Camera path time does not increase on line %u", line_number + 1);
+            success = false;
+        } else {
+            if (path->count == capacity) {
+                capacity = capacity ? capacity * 2 : 16;
+                ve_camera_key* keys = (ve_camera_key*)ve_reallocate(path->keys, capacity * sizeof(ve_camera_key),
+                                                                    VE_MEMORY_TAG_SCENE);
+                if (!keys) {
+                    VE_LOG_ERROR("Out of memory parsing camera path");
+                    success = false;
+                    break;
+                }
+                path->keys = keys;
+            }
+            path->keys[path->count++] = key;
+        }
+        line = next;
+    }
+    VE_FREE(source);
+
+    if (success && path->count == 0) {
+        VE_LOG_ERROR("Camera path has no keys");
+        success = false;
+    }
+    if (!success) {
+        ve_camera_path_free(path);
+    }
+    return success;
+}
+
+bool ve_camera_path_load(const char* file, ve_camera_path* path) {
+    memset(path, 0, sizeof(ve_camera_path));
+
+    ve_file_mapping mapping;
+    if (!ve_file_map(file, VE_FILE_ACCESS_SEQUENTIAL, &mapping)) {
+        VE_LOG_ERROR("Failed to open camera path: %s", file);
+        return false;
+    }
+
+    bool success = ve_camera_path_parse((const char*)mapping.data, mapping.size, path);
+    ve_file_unmap(&mapping);
+    if (success) {
+        VE_LOG_INFO("Loaded camera path %s: %u keys, %.2f s", file, path->count, ve_camera_path_get_duration(path));
+    }
+    return success;
+}
+
+void ve_camera_path_free(ve_camera_path* path) {
+    if (path) {
+        VE_FREE(path->keys);
+        memset(path, 0, sizeof(ve_camera_path));
+    }
+}
+
+float ve_camera_path_get_duration(const ve_camera_path* path) {
+    return path->count > 0 ? path->keys[path->count - 1].time : 0.0f;
+}
+
+/* Uniform Catmull-Rom segment from p1 to p2 */
+static ve_vec3 catmull_rom(ve_vec3 p0, ve_vec3 p1, ve_vec3 p2, ve_vec3 p3, float t) {
+    float t2 = t * t;
+    float t3 = t2 * t;
+    float w0 = -0.5f * t3 + t2 - 0.5f * t;
+    float w1 = 1.5f * t3 - 2.5f * t2 + 1.0f;
+    float w2 = -1.5f * t3 + 2.0f * t2 + 0.5f * t;
+    float w3 = 0.5f * t3 - 0.5f * t2;
+    return ve_vec3_make(w0 * p0.x + w1 * p1.x + w2 * p2.x + w3 * p3.x,
+                        w0 * p0.y + w1 * p1.y + w2 * p2.y + w3 * p3.y,
+                        w0 * p0.z + w1 * p1.z + w2 * p2.z + w3 * p3.z);
+}
+
+void ve_camera_path_sample(const ve_camera_path* path, float time, ve_vec3* eye, ve_vec3* target) {
+    const ve_camera_key* keys = path->keys;
+    uint32_t last = path->count - 1;
+    if (path->count == 1 || time <= keys[0].time) {
+        *eye = keys[0].eye;
+        *target = keys[0].target;
+        return;
+    }
+    if (time >= keys[last].time) {
+        *eye = keys[last].eye;
+        *target = keys[last].target;
+        return;
+    }
+
+    /* Last key at or before the time */
+    uint32_t low = 0;
+    uint32_t high = last;
+    while (high - low > 1) {
+        uint32_t middle = (low + high) / 2;
+        if (keys[middle].time <= time) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+
+    /* The end keys stand in for their missing neighbours */
+    const ve_camera_key* k0 = &keys[low > 0 ? low - 1 : low];
+    const ve_camera_key* k1 = &keys[low];
+    const ve_camera_key* k2 = &keys[low + 1];
+    const ve_camera_key* k3 = &keys[low + 2 <= last ? low + 2 : low + 1];
+    float t = (time - k1->time) / (k2->time - k1->time);
+
+    *eye = catmull_rom(k0->eye, k1->eye, k2->eye, k3->eye, t);
+    *target = catmull_rom(k0->target, k1->target, k2->target, k3->target, t);
+}
@@ -0,0 +1,96 @@
+/**
+ * @file camera_path.h
+ * @brief Recorded camera paths
+ *
+ * A path is a list of keys, each a time with an eye position and a point
+ * to look at, read from a text file with one key per line:
+ *
+ *   # time  eye x y z  target x y z
+ *   0.0     0 2 10     0 1 0
+ *   4.0     8 2 4      0 1 0
+ *
+ * Blank lines and lines starting with '#' are skipped, and key times must
+ * increase. Sampling follows a Catmull-Rom spline through the keys, so
+ * the camera moves smoothly through every key, and holds the first and
+ * last key outside the path. Sampled at fixed time steps, a path gives the
+ * same sequence of views on every run, which benchmarks rely on.
+ */
+
+#ifndef VE_CAMERA_PATH_H
+#define VE_CAMERA_PATH_H
+
+#include "../math/vmath.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Camera placement at a point in time
+ */
+typedef struct ve_camera_key {
+    float time;                 /* Seconds from the start of the path */
+    ve_vec3 eye;
+    ve_vec3 target;
+} ve_camera_key;
+
+/**
+ * @brief Camera path
+ */
+typedef struct ve_camera_path {
+    ve_camera_key* keys;
+    uint32_t count;
+} ve_camera_path;
+
+/**
+ * @brief Parse a camera path from text
+ *
+ * @param text Path text, not necessarily NUL terminated
+ * @param size Text size in bytes
+ * @param path Output path, free with ve_camera_path_free
+ * @return false if a line is malformed, times do not increase or there are no keys
+ */
+bool ve_camera_path_parse(const char* text, size_t size, ve_camera_path* path);
+
+/**
+ * @brief Load a camera path file
+ *
+ * @param file File path
+ * @param path Output path, free with ve_camera_path_free
+ * @return true on success
+ */
+bool ve_camera_path_load(const char* file, ve_camera_path* path);
+
+/**
+ * @brief Free the keys of a path
+ *
+ * @param path Path, cleared on return
+ */
+void ve_camera_path_free(ve_camera_path* path);
+
+/**
+ * @brief Get the length of a path
+ *
+ * @param path Path
+ * @return Time of the last key, 0 for an empty path
+ */
+float ve_camera_path_get_duration(const ve_camera_path* path);
+
+/**
+ * @brief Sample the camera placement at a time
+ *
+ * @param path Path with at least one key
+ * @param time Seconds from the start of the path, clamped to the path
+ * @param eye Output eye position
+ * @param target Output point to look at
+ */
+void ve_camera_path_sample(const ve_camera_path* path, float time, ve_vec3* eye, ve_vec3* target);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VE_CAMERA_PATH_H */
@@ -1,8 +1,597 @@
 /**
  * @file node.c
- * @brief Scene node management implementation
+ * @brief Scene node hierarchy implementation
  */
 
 #include "node.h"
+#include "../math/simd.h"
+#include "../core/memory.h"
+#include "../core/logger.h"
+#include "../core/assert.h"
 
-/* TODO: Implement scene node management */
+#include <string.h>
+
+#define NODE_INDEX_MASK (VE_NODE_MAX_NODES - 1)
+#define NODE_GENERATION_MASK ((1u << VE_NODE_GENERATION_BITS) - 1)
+
+/* Marks a root's parent, a free slot and an unknown depth */
+#define NODE_NONE UINT32_MAX
+
+/* Depth of rows that die in the next sort */
+#define NODE_DEAD (UINT32_MAX - 1)
+
+#define NODE_FLAG_DIRTY     (1u << 0)   /* Local transform or parent changed */
+#define NODE_FLAG_DESTROYED (1u << 1)   /* Destroyed, slot already released */
+
+/* Rows multiplied per ve_mat4_mul_batch call */
+#define NODE_MUL_BATCH 64
+
+/**
+ * @brief Handle slot, stable while the node's row moves
+ *
+ * Free slots have row NODE_NONE and chain through next_free.
+ */
+typedef struct ve_node_slot {
+    uint32_t generation;
+    uint32_t row;
+    uint32_t next_free;
+} ve_node_slot;
+
+/**
+ * @brief Parallel per-node arrays, in one allocation
+ */
+typedef struct ve_node_rows {
+    void* memory;
+    ve_mat4* locals;
+    ve_mat4* worlds;
+    ve_node* handles;
+    uint32_t* parents;              /* Row of the parent, NODE_NONE for roots */
+    uint32_t* depths;
+    uint32_t* versions;             /* Update that last wrote the world matrix */
+    uint8_t* flags;
+    uint32_t capacity;
+} ve_node_rows;
+
+struct ve_node_graph {
+    ve_node_rows rows;
+    uint32_t row_count;             /* Includes destroyed rows until the next sort */
+    uint32_t live_count;
+
+    ve_node_slot* slots;
+    uint32_t slot_count;
+    uint32_t slot_capacity;
+    uint32_t free_head;
+
+    uint32_t* level_offsets;        /* level_count + 1 row offsets */
+    uint32_t level_count;
+    uint32_t level_capacity;
+
+    uint32_t first_dirty_level;     /* NODE_NONE when nothing is dirty */
+    uint32_t last_dirty_level;
+    bool needs_sort;
+    uint32_t version;
+};
+
+/**
+ * @brief Per-level update state shared by the tasks of a level
+ */
+typedef struct ve_node_update_context {
+    ve_node_graph* graph;
+    uint32_t version;
+    ve_atomic_int32 changed;
+} ve_node_update_context;
+
+static ve_node make_node(uint32_t index, uint32_t generation) {
+    return (generation << VE_NODE_INDEX_BITS) | index;
+}
+
+static uint32_t node_index(ve_node node) {
+    return node & NODE_INDEX_MASK;
+}
+
+static uint32_t node_generation(ve_node node) {
+    return node >> VE_NODE_INDEX_BITS;
+}
+
+/**
+ * @brief Get the row of a live node
+ *
+ * @return Row, or NODE_NONE for stale or invalid handles
+ */
+static uint32_t find_row(const ve_node_graph* graph, ve_node node) {
+    uint32_t index = node_index(node);
+    if (node == VE_NODE_NULL || index >= graph->slot_count) {
+        return NODE_NONE;
+    }
+    const ve_node_slot* slot = &graph->slots[index];
+    if (slot->row == NODE_NONE || slot->generation != node_generation(node)) {
+        return NODE_NONE;
+    }
+    return slot->row;
+}
+
+static void release_slot(ve_node_graph* graph, ve_node node) {
+    ve_node_slot* slot = &graph->slots[node_index(node)];
+
+    /* Generation 0 is skipped so that no handle equals VE_NODE_NULL */
+    uint32_t generation = (slot->generation + 1) & NODE_GENERATION_MASK;
+    slot->generation = generation ? generation : 1;
+    slot->row = NODE_NONE;
+    slot->next_free = graph->free_head;
+    graph->free_head = node_index(node);
+    graph->live_count--;
+}
+
+static void mark_dirty(ve_node_graph* graph, uint32_t row) {
+    graph->rows.flags[row] |= NODE_FLAG_DIRTY;
+    uint32_t depth = graph->rows.depths[row];
+    if (graph->first_dirty_level == NODE_NONE || depth < graph->first_dirty_level) {
+        graph->first_dirty_level = depth;
+    }
+    if (depth > graph->last_dirty_level) {
+        graph->last_dirty_level = depth;
+    }
+}
+
+/**
+ * @brief Allocate row arrays, matrices first so they stay 16-byte aligned
+ *
+ * @return false if out of memory
+ */
+static bool rows_allocate(ve_node_rows* rows, uint32_t capacity) {
+    size_t matrices = (size_t)capacity * sizeof(ve_mat4);
+    size_t words = (size_t)capacity * sizeof(uint32_t);
+    uint8_t* memory = (uint8_t*)VE_ALLOCATE_TAG(2 * matrices + 4 * words + capacity, VE_MEMORY_TAG_SCENE);
+    if (!memory) {
+        return false;
+    }
+
+    rows->memory = memory;
+    rows->locals = (ve_mat4*)memory;
+    rows->worlds = (ve_mat4*)(memory + matrices);
+    rows->handles = (ve_node*)(memory + 2 * matrices);
+    rows->parents = (uint32_t*)(memory + 2 * matrices + words);
+    rows->depths = (uint32_t*)(memory + 2 * matrices + 2 * words);
+    rows->versions = (uint32_t*)(memory + 2 * matrices + 3 * words);
+    rows->flags = memory + 2 * matrices + 4 * words;
+    rows->capacity = capacity;
+    return true;
+}
+
+static void rows_copy(ve_node_rows* dst, uint32_t to, const ve_node_rows* src, uint32_t from) {
+    dst->locals[to] = src->locals[from];
+    dst->worlds[to] = src->worlds[from];
+    dst->handles[to] = src->handles[from];
+    dst->parents[to] = src->parents[from];
+    dst->depths[to] = src->depths[from];
+    dst->versions[to] = src->versions[from];
+    dst->flags[to] = src->flags[from];
+}
+
+static bool reserve_levels(ve_node_graph* graph, uint32_t level_count) {
+    if (level_count + 1 <= graph->level_capacity) {
+        return true;
+    }
+    uint32_t capacity = graph->level_capacity ? graph->level_capacity : 16;
+    while (capacity < level_count + 1) {
+        capacity *= 2;
+    }
+    uint32_t* offsets = (uint32_t*)ve_reallocate(graph->level_offsets, capacity * sizeof(uint32_t),
+                                                 VE_MEMORY_TAG_SCENE);
+    if (!offsets) {
+        return false;
+    }
+    graph->level_offsets = offsets;
+    graph->level_capacity = capacity;
+    return true;
+}
+
+/**
+ * @brief Re-sort rows by depth after structural changes
+ *
+ * Recomputes every depth from the parent links, drops destroyed rows along
+ * with their descendants, and rebuilds the level table. A stable counting
+ * sort keeps siblings in creation order.
+ *
+ * @return false if out of memory, with the graph unchanged
+ */
+static bool sort_rows(ve_node_graph* graph) {
+    ve_node_rows* rows = &graph->rows;
+    uint32_t count = graph->row_count;
+
+    uint32_t* scratch = (uint32_t*)VE_ALLOCATE_TAG(((size_t)count * 3 + 1) * sizeof(uint32_t), VE_MEMORY_TAG_SCENE);
+    if (!scratch) {
+        return false;
+    }
+    uint32_t* depths = scratch;
+    uint32_t* remap = scratch + count;
+    uint32_t* cursors = scratch + 2 * count;
+
+    /* Depths: walk up to the first resolved ancestor, using remap as the stack */
+    for (uint32_t i = 0; i < count; i++) {
+        depths[i] = NODE_NONE;
+    }
+    uint32_t max_depth = 0;
+    bool any_live = false;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t top = 0;
+        for (uint32_t r = i; r != NODE_NONE && depths[r] == NODE_NONE; r = rows->parents[r]) {
+            remap[top++] = r;
+        }
+        while (top > 0) {
+            uint32_t r = remap[--top];
+            uint32_t parent = rows->parents[r];
+            uint32_t parent_depth = parent == NODE_NONE ? NODE_NONE : depths[parent];
+            if ((rows->flags[r] & NODE_FLAG_DESTROYED) || parent_depth == NODE_DEAD) {
+                depths[r] = NODE_DEAD;
+            } else {
+                depths[r] = parent == NODE_NONE ? 0 : parent_depth + 1;
+                max_depth = depths[r] > max_depth ? depths[r] : max_depth;
+                any_live = true;
+            }
+        }
+    }
+
+    uint32_t level_count = any_live ? max_depth + 1 : 0;
+    ve_node_rows sorted;
+    if (!reserve_levels(graph, level_count) || !rows_allocate(&sorted, rows->capacity)) {
+        VE_FREE(scratch);
+        return false;
+    }
+
+    /* Level offsets from the live row count of each depth */
+    memset(cursors, 0, (level_count + 1) * sizeof(uint32_t));
+    for (uint32_t i = 0; i < count; i++) {
+        if (depths[i] != NODE_DEAD) {
+            cursors[depths[i] + 1]++;
+        }
+    }
+    for (uint32_t level = 0; level < level_count; level++) {
+        cursors[level + 1] += cursors[level];
+    }
+    memcpy(graph->level_offsets, cursors, (level_count + 1) * sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (depths[i] == NODE_DEAD) {
+            if (!(rows->flags[i] & NODE_FLAG_DESTROYED)) {
+                release_slot(graph, rows->handles[i]);
+            }
+            remap[i] = NODE_NONE;
+        } else {
+            remap[i] = cursors[depths[i]]++;
+        }
+    }
+
+    graph->first_dirty_level = NODE_NONE;
+    graph->last_dirty_level = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t row = remap[i];
+        if (row == NODE_NONE) {
+            continue;
+        }
+        rows_copy(&sorted, row, rows, i);
+        sorted.depths[row] = depths[i];
+        sorted.parents[row] = rows->parents[i] == NODE_NONE ? NODE_NONE : remap[rows->parents[i]];
+        graph->slots[node_index(rows->handles[i])].row = row;
+    }
+
+    VE_FREE(rows->memory);
+    VE_FREE(scratch);
+    graph->rows = sorted;
+    graph->row_count = graph->level_offsets[level_count];
+    graph->level_count = level_count;
+    graph->needs_sort = false;
+
+    for (uint32_t row = 0; row < graph->row_count; row++) {
+        if (graph->rows.flags[row] & NODE_FLAG_DIRTY) {
+            mark_dirty(graph, row);
+        }
+    }
+    return true;
+}
+
+ve_node_graph* ve_node_graph_create(void) {
+    ve_node_graph* graph = (ve_node_graph*)ve_allocate_cleared(1, sizeof(ve_node_graph), VE_MEMORY_TAG_SCENE);
+    if (!graph) {
+        return NULL;
+    }
+    graph->free_head = NODE_NONE;
+    graph->first_dirty_level = NODE_NONE;
+    if (!reserve_levels(graph, 0)) {
+        VE_FREE(graph);
+        return NULL;
+    }
+    graph->level_offsets[0] = 0;
+    return graph;
+}
+
+void ve_node_graph_destroy(ve_node_graph* graph) {
+    if (!graph) {
+        return;
+    }
+    VE_FREE(graph->rows.memory);
+    VE_FREE(graph->slots);
+    VE_FREE(graph->level_offsets);
+    VE_FREE(graph);
+}
+
+/**
+ * @brief Recompute the world matrices of a range of rows within one level
+ *
+ * Rows are recomputed when marked dirty or when their parent was
+ * recomputed in this update. Rows with a parent are gathered and
+ * multiplied in batches so the SIMD kernels see full vectors.
+ */
+static void update_rows(uint32_t begin, uint32_t end, void* user_data) {
+    ve_node_update_context* context = (ve_node_update_context*)user_data;
+    ve_node_rows* rows = &context->graph->rows;
+    uint32_t version = context->version;
+
+    ve_mat4 products[NODE_MUL_BATCH];
+    ve_mat4 locals[NODE_MUL_BATCH];
+    uint32_t targets[NODE_MUL_BATCH];
+    uint32_t pending = 0;
+    int32_t changed = 0;
+
+    for (uint32_t row = begin; row < end; row++) {
+        uint32_t parent = rows->parents[row];
+        bool parent_changed = parent != NODE_NONE && rows->versions[parent] == version;
+        if (!(rows->flags[row] & NODE_FLAG_DIRTY) && !parent_changed) {
+            continue;
+        }
+        rows->flags[row] &= (uint8_t)~NODE_FLAG_DIRTY;
+        rows->versions[row] = version;
+        changed++;
+
+        if (parent == NODE_NONE) {
+            rows->worlds[row] = rows->locals[row];
+            continue;
+        }
+        products[pending] = rows->worlds[parent];
+        locals[pending] = rows->locals[row];
+        targets[pending++] = row;
+        if (pending == NODE_MUL_BATCH) {
+            ve_mat4_mul_batch(products, products, locals, pending);
+            for (uint32_t i = 0; i < pending; i++) {
+                rows->worlds[targets[i]] = products[i];
+            }
+            pending = 0;
+        }
+    }
+
+    if (pending > 0) {
+        ve_mat4_mul_batch(products, products, locals, pending);
+        for (uint32_t i = 0; i < pending; i++) {
+            rows->worlds[targets[i]] = products[i];
+        }
+    }
+    if (changed > 0) {
+        ve_atomic_fetch_add32(&context->changed, changed);
+    }
+}
+
+uint32_t ve_node_graph_update(ve_node_graph* graph, ve_thread_pool* pool) {
+    VE_ASSERT(graph);
+
+    if (graph->needs_sort && !sort_rows(graph)) {
+        VE_LOG_ERROR("Out of memory sorting %u scene nodes", graph->row_count);
+        return 0;
+    }
+
+    /* Version 0 means never computed */
+    graph->version++;
+    if (graph->version == 0) {
+        graph->version = 1;
+    }
+    if (graph->first_dirty_level == NODE_NONE) {
+        return graph->version;
+    }
+
+    ve_node_update_context context = {.graph = graph, .version = graph->version};
+    for (uint32_t level = graph->first_dirty_level; level < graph->level_count; level++) {
+        uint32_t begin = graph->level_offsets[level];
+        uint32_t end = graph->level_offsets[level + 1];
+        ve_atomic_store32(&context.changed, 0);
+        if (pool && end - begin > VE_NODE_UPDATE_GRAIN) {
+            ve_parallel_for(pool, begin, end, VE_NODE_UPDATE_GRAIN, update_rows, &context);
+        } else {
+            update_rows(begin, end, &context);
+        }
+
+        /* Nothing below changed and nothing deeper is marked: the rest is clean */
+        if (ve_atomic_load32(&context.changed) == 0 && level >= graph->last_dirty_level) {
+            break;
+        }
+    }
+
+    graph->first_dirty_level = NODE_NONE;
+    graph->last_dirty_level = 0;
+    return graph->version;
+}
+
+uint32_t ve_node_graph_get_version(const ve_node_graph* graph) {
+    VE_ASSERT(graph);
+    return graph->version;
+}
+
+uint32_t ve_node_graph_get_count(const ve_node_graph* graph) {
+    VE_ASSERT(graph);
+    return graph->live_count;
+}
+
+uint32_t ve_node_graph_get_level_count(const ve_node_graph* graph) {
+    VE_ASSERT(graph);
+    return graph->level_count;
+}
+
+ve_node ve_node_create(ve_node_graph* graph, ve_node parent) {
+    VE_ASSERT(graph);
+
+    uint32_t parent_row = NODE_NONE;
+    if (parent != VE_NODE_NULL) {
+        parent_row = find_row(graph, parent);
+        if (parent_row == NODE_NONE) {
+            return VE_NODE_NULL;
+        }
+    }
+
+    /* Reserve storage before taking a slot, so failures leave nothing behind */
+    uint32_t index = graph->free_head;
+    if (index == NODE_NONE) {
+        if (graph->slot_count == VE_NODE_MAX_NODES) {
+            VE_LOG_ERROR("Scene node limit (%u) reached", VE_NODE_MAX_NODES);
+            return VE_NODE_NULL;
+        }
+        if (graph->slot_count == graph->slot_capacity) {
+            uint32_t capacity = graph->slot_capacity ? graph->slot_capacity * 2 : 1024;
+            ve_node_slot* slots = (ve_node_slot*)ve_reallocate(graph->slots, capacity * sizeof(ve_node_slot),
+                                                               VE_MEMORY_TAG_SCENE);
+            if (!slots) {
+                return VE_NODE_NULL;
+            }
+            graph->slots = slots;
+            graph->slot_capacity = capacity;
+        }
+    }
+    if (graph->row_count == graph->rows.capacity) {
+        ve_node_rows grown;
+        if (!rows_allocate(&grown, graph->rows.capacity ? graph->rows.capacity * 2 : 1024)) {
+            return VE_NODE_NULL;
+        }
+        for (uint32_t row = 0; row < graph->row_count; row++) {
+            rows_copy(&grown, row, &graph->rows, row);
+        }
+        VE_FREE(graph->rows.memory);
+        graph->rows = grown;
+    }
+
+    uint32_t depth = parent_row == NODE_NONE ? 0 : graph->rows.depths[parent_row] + 1;
+    if (!graph->needs_sort && depth + 1 > graph->level_count && !reserve_levels(graph, depth + 1)) {
+        return VE_NODE_NULL;
+    }
+
+    /* Commit the slot */
+    if (index == NODE_NONE) {
+        index = graph->slot_count++;
+        graph->slots[index].generation = 1;
+    } else {
+        graph->free_head = graph->slots[index].next_free;
+    }
+    ve_node_slot* slot = &graph->slots[index];
+    uint32_t row = graph->row_count++;
+    slot->row = row;
+    graph->live_count++;
+
+    ve_node node = make_node(index, slot->generation);
+    ve_node_rows* rows = &graph->rows;
+    rows->locals[row] = ve_mat4_identity();
+    rows->worlds[row] = ve_mat4_identity();
+    rows->handles[row] = node;
+    rows->parents[row] = parent_row;
+    rows->depths[row] = depth;
+    rows->versions[row] = 0;
+    rows->flags[row] = 0;
+
+    /* Appending to the deepest level keeps the rows sorted */
+    if (!graph->needs_sort) {
+        if (depth + 1 == graph->level_count) {
+            graph->level_offsets[graph->level_count] = graph->row_count;
+        } else if (depth == graph->level_count) {
+            graph->level_count++;
+            graph->level_offsets[graph->level_count] = graph->row_count;
+        } else {
+            graph->needs_sort = true;
+        }
+    }
+
+    mark_dirty(graph, row);
+    return node;
+}
+
+void ve_node_destroy(ve_node_graph* graph, ve_node node) {
+    VE_ASSERT(graph);
+
+    uint32_t row = find_row(graph, node);
+    if (row == NODE_NONE) {
+        return;
+    }
+    graph->rows.flags[row] |= NODE_FLAG_DESTROYED;
+    release_slot(graph, node);
+    graph->needs_sort = true;
+}
+
+bool ve_node_is_alive(const ve_node_graph* graph, ve_node node) {
+    VE_ASSERT(graph);
+    return find_row(graph, node) != NODE_NONE;
+}
+
+bool ve_node_set_parent(ve_node_graph* graph, ve_node node, ve_node parent) {
+    VE_ASSERT(graph);
+
+    uint32_t row = find_row(graph, node);
+    VE_ASSERT_MSG(row != NODE_NONE, "Stale scene node");
+    uint32_t parent_row = NODE_NONE;
+    if (parent != VE_NODE_NULL) {
+        parent_row = find_row(graph, parent);
+        if (parent_row == NODE_NONE) {
+            return false;
+        }
+        for (uint32_t r = parent_row; r != NODE_NONE; r = graph->rows.parents[r]) {
+            if (r == row) {
+                return false;
+            }
+        }
+    }
+
+    if (graph->rows.parents[row] != parent_row) {
+        graph->rows.parents[row] = parent_row;
+        graph->rows.flags[row] |= NODE_FLAG_DIRTY;
+        graph->needs_sort = true;
+    }
+    return true;
+}
+
+ve_node ve_node_get_parent(const ve_node_graph* graph, ve_node node) {
+    VE_ASSERT(graph);
+
+    uint32_t row = find_row(graph, node);
+    if (row == NODE_NONE || graph->rows.parents[row] == NODE_NONE) {
+        return VE_NODE_NULL;
+    }
+    return graph->rows.handles[graph->rows.parents[row]];
+}
+
+void ve_node_set_local(ve_node_graph* graph, ve_node node, const ve_mat4* local) {
+    VE_ASSERT(graph && local);
+
+    uint32_t row = find_row(graph, node);
+    VE_ASSERT_MSG(row != NODE_NONE, "Stale scene node");
+    graph->rows.locals[row] = *local;
+    mark_dirty(graph, row);
+}
+
+void ve_node_set_trs(ve_node_graph* graph, ve_node node, ve_vec3 position, ve_quat rotation, ve_vec3 scale) {
+    ve_mat4 local = ve_mat4_from_trs(position, rotation, scale);
+    ve_node_set_local(graph, node, &local);
+}
+
+const ve_mat4* ve_node_get_local(const ve_node_graph* graph, ve_node node) {
+    VE_ASSERT(graph);
+
+    uint32_t row = find_row(graph, node);
+    return row == NODE_NONE ? NULL : &graph->rows.locals[row];
+}
+
+const ve_mat4* ve_node_get_world(const ve_node_graph* graph, ve_node node) {
+    VE_ASSERT(graph);
+
+    uint32_t row = find_row(graph, node);
+    return row == NODE_NONE ? NULL : &graph->rows.worlds[row];
+}
+
+uint32_t ve_node_get_world_version(const ve_node_graph* graph, ve_node node) {
+    VE_ASSERT(graph);
+
+    uint32_t row = find_row(graph, node);
+    return row == NODE_NONE ? 0 : graph->rows.versions[row];
+}
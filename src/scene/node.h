@@ -1,18 +1,202 @@
 /**
  * @file node.h
- * @brief Scene node management
+ * @brief Scene node hierarchy
+ *
+ * The hierarchy is stored flat: every node is a row in a set of parallel
+ * arrays holding its parent's row, its local and world matrices and its
+ * flags, and the rows are sorted by depth so each level is one contiguous
+ * range that comes after its parents. Updating world matrices is then one
+ * linear pass per level with no pointer chasing, and the rows of a level
+ * are independent of each other, so a level can be split across the
+ * thread pool.
+ *
+ * Only dirty subtrees are recomputed: changing a local transform marks the
+ * node, and a node is recomputed when it is marked or its parent was
+ * recomputed in the same update. Every recomputed world matrix is stamped
+ * with the graph's update version, so consumers such as spatial indices
+ * can pick up exactly the nodes that moved.
+ *
+ * Structural changes (create, destroy, reparent) only record the change;
+ * rows are re-sorted at the start of the next ve_node_graph_update.
+ * Handles are generational like entity handles, so stale handles are
+ * detected. A graph is not thread-safe.
  */
 
 #ifndef VE_NODE_H
 #define VE_NODE_H
 
+#include "../math/vmath.h"
+#include "../core/thread.h"
 #include <stdint.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* TODO: Implement scene node management */
+/* Node handle layout: slot index in the low bits, generation above */
+#define VE_NODE_INDEX_BITS 22
+#define VE_NODE_GENERATION_BITS 10
+#define VE_NODE_MAX_NODES (1u << VE_NODE_INDEX_BITS)
+
+/* Never a live node, and the parent of root nodes */
+#define VE_NODE_NULL 0u
+
+/* Rows per task when a level is split across the thread pool */
+#define VE_NODE_UPDATE_GRAIN 256
+
+typedef uint32_t ve_node;
+
+/**
+ * @brief Flattened node hierarchy
+ */
+typedef struct ve_node_graph ve_node_graph;
+
+/**
+ * @brief Create an empty graph
+ *
+ * @return Graph, or NULL if out of memory
+ */
+ve_node_graph* ve_node_graph_create(void);
+
+/**
+ * @brief Destroy a graph and all of its nodes
+ *
+ * @param graph Graph
+ */
+void ve_node_graph_destroy(ve_node_graph* graph);
+
+/**
+ * @brief Re-sort pending structural changes and recompute dirty world matrices
+ *
+ * @param graph Graph
+ * @param pool Pool that large levels are split across (NULL runs on the calling thread)
+ * @return Update version stamped on the nodes recomputed by this call, 0 if out of memory
+ */
+uint32_t ve_node_graph_update(ve_node_graph* graph, ve_thread_pool* pool);
+
+/**
+ * @brief Get the version of the last update
+ *
+ * @param graph Graph
+ * @return Version, 0 before the first update
+ */
+uint32_t ve_node_graph_get_version(const ve_node_graph* graph);
+
+/**
+ * @brief Get the number of live nodes
+ *
+ * Nodes below a destroyed node count until the next update.
+ *
+ * @param graph Graph
+ * @return Node count
+ */
+uint32_t ve_node_graph_get_count(const ve_node_graph* graph);
+
+/**
+ * @brief Get the depth of the deepest level after the last update, plus one
+ *
+ * @param graph Graph
+ * @return Level count
+ */
+uint32_t ve_node_graph_get_level_count(const ve_node_graph* graph);
+
+/**
+ * @brief Create a node with an identity local transform
+ *
+ * @param graph Graph
+ * @param parent Parent node, or VE_NODE_NULL for a root
+ * @return Node, or VE_NODE_NULL if out of memory, out of slots or the parent is stale
+ */
+ve_node ve_node_create(ve_node_graph* graph, ve_node parent);
+
+/**
+ * @brief Destroy a node and everything below it
+ *
+ * The node's handle goes stale at once; its descendants are destroyed by
+ * the next update. Stale handles are ignored.
+ *
+ * @param graph Graph
+ * @param node Node
+ */
+void ve_node_destroy(ve_node_graph* graph, ve_node node);
+
+/**
+ * @brief Check if a handle refers to a live node
+ *
+ * @param graph Graph
+ * @param node Node
+ * @return true if alive
+ */
+bool ve_node_is_alive(const ve_node_graph* graph, ve_node node);
+
+/**
+ * @brief Move a node, with its subtree, under another parent
+ *
+ * The local transform is kept, so the subtree moves in world space.
+ *
+ * @param graph Graph
+ * @param node Live node
+ * @param parent New parent, or VE_NODE_NULL to make it a root
+ * @return false if the parent is stale, or is the node or one of its descendants
+ */
+bool ve_node_set_parent(ve_node_graph* graph, ve_node node, ve_node parent);
+
+/**
+ * @brief Get the parent of a node
+ *
+ * @param graph Graph
+ * @param node Node
+ * @return Parent, or VE_NODE_NULL for roots and stale handles
+ */
+ve_node ve_node_get_parent(const ve_node_graph* graph, ve_node node);
+
+/**
+ * @brief Set the transform of a node relative to its parent
+ *
+ * @param graph Graph
+ * @param node Live node
+ * @param local Local matrix
+ */
+void ve_node_set_local(ve_node_graph* graph, ve_node node, const ve_mat4* local);
+
+/**
+ * @brief Set the local transform of a node from translation, rotation and scale
+ *
+ * @param graph Graph
+ * @param node Live node
+ * @param position Translation
+ * @param rotation Unit quaternion
+ * @param scale Per-axis scale
+ */
+void ve_node_set_trs(ve_node_graph* graph, ve_node node, ve_vec3 position, ve_quat rotation, ve_vec3 scale);
+
+/**
+ * @brief Get the local transform of a node
+ *
+ * @param graph Graph
+ * @param node Node
+ * @return Local matrix, or NULL for stale handles
+ */
+const ve_mat4* ve_node_get_local(const ve_node_graph* graph, ve_node node);
+
+/**
+ * @brief Get the world transform of a node as of the last update
+ *
+ * @param graph Graph
+ * @param node Node
+ * @return World matrix, or NULL for stale handles
+ */
+const ve_mat4* ve_node_get_world(const ve_node_graph* graph, ve_node node);
+
+/**
+ * @brief Get the update version in which a node's world matrix last changed
+ *
+ * @param graph Graph
+ * @param node Node
+ * @return Version, 0 if not computed yet or the handle is stale
+ */
+uint32_t ve_node_get_world_version(const ve_node_graph* graph, ve_node node);
 
 #ifdef __cplusplus
 }
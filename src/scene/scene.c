@@ -1,8 +1,1156 @@
 /**
  * @file scene.c
- * @brief Scene management implementation
+ * @brief Scene management and spatial index implementation
  */
 
 #include "scene.h"
+#include "../math/simd.h"
+#include "../core/memory.h"
+#include "../core/logger.h"
+#include "../core/assert.h"
 
-/* TODO: Implement scene management */
+#include <float.h>
+#include <string.h>
+
+/* Marks a missing parent, a free node or proxy, and an absent body */
+#define BVH_NONE UINT32_MAX
+
+/* Child references with this bit set are proxies, the rest are nodes */
+#define BVH_LEAF_BIT 0x80000000u
+
+/* Buckets of the binned SAH split */
+#define BVH_SAH_BINS 16
+
+/* Traversal stack entries before it moves to the heap */
+#define BVH_STACK_SIZE 128
+
+#define BVH_ROOT 0
+
+/* A subtree is worth rebuilding once changes reach 1/N of its proxies */
+#define BVH_REBUILD_CHANGE_RATIO 4
+
+/**
+ * @brief Node of up to VE_BVH_WIDTH children
+ *
+ * The child boxes are stored as center and half extent arrays so that
+ * they form a ve_aabb_soa. Free nodes have count BVH_NONE and chain
+ * through children[0].
+ */
+typedef struct ve_bvh_node {
+    float center_x[VE_BVH_WIDTH];
+    float center_y[VE_BVH_WIDTH];
+    float center_z[VE_BVH_WIDTH];
+    float extent_x[VE_BVH_WIDTH];
+    float extent_y[VE_BVH_WIDTH];
+    float extent_z[VE_BVH_WIDTH];
+    uint32_t children[VE_BVH_WIDTH];
+    uint32_t parent;                /* BVH_NONE for the root */
+    uint32_t parent_slot;
+    uint32_t count;                 /* Used child slots */
+    uint32_t proxy_count;           /* Proxies in the subtree */
+    uint32_t changes;               /* Inserts, removals and moves in the subtree since it was built */
+} ve_bvh_node;
+
+/**
+ * @brief Proxy box
+ *
+ * Free proxies have node BVH_NONE and chain through slot.
+ */
+typedef struct ve_bvh_proxy {
+    ve_aabb bounds;
+    uint32_t user;
+    uint32_t node;
+    uint32_t slot;
+} ve_bvh_proxy;
+
+struct ve_bvh {
+    ve_bvh_node* nodes;
+    uint32_t node_count;
+    uint32_t node_capacity;
+    uint32_t free_node;
+
+    ve_bvh_proxy* proxies;
+    uint32_t proxy_count;
+    uint32_t proxy_capacity;
+    uint32_t free_proxy;
+    uint32_t live_count;
+};
+
+typedef struct bvh_stack_entry {
+    uint32_t node;
+    float distance;
+} bvh_stack_entry;
+
+/**
+ * @brief Traversal stack, on the C stack until it outgrows it
+ */
+typedef struct bvh_stack {
+    bvh_stack_entry* entries;
+    uint32_t count;
+    uint32_t capacity;
+    bvh_stack_entry local[BVH_STACK_SIZE];
+} bvh_stack;
+
+static void stack_init(bvh_stack* stack) {
+    stack->entries = stack->local;
+    stack->count = 0;
+    stack->capacity = BVH_STACK_SIZE;
+}
+
+static void stack_free(bvh_stack* stack) {
+    if (stack->entries != stack->local) {
+        VE_FREE(stack->entries);
+    }
+}
+
+/**
+ * @return false if out of memory, with the entry dropped
+ */
+static bool stack_push(bvh_stack* stack, uint32_t node, float distance) {
+    if (stack->count == stack->capacity) {
+        uint32_t capacity = stack->capacity * 2;
+        bvh_stack_entry* entries = (bvh_stack_entry*)VE_ALLOCATE_TAG(capacity * sizeof(bvh_stack_entry),
+                                                                     VE_MEMORY_TAG_SCENE);
+        if (!entries) {
+            VE_LOG_ERROR("Out of memory growing the BVH traversal stack");
+            return false;
+        }
+        memcpy(entries, stack->entries, stack->count * sizeof(bvh_stack_entry));
+        stack_free(stack);
+        stack->entries = entries;
+        stack->capacity = capacity;
+    }
+    stack->entries[stack->count++] = (bvh_stack_entry){node, distance};
+    return true;
+}
+
+static ve_aabb slot_bounds(const ve_bvh_node* node, uint32_t slot) {
+    ve_aabb box = {
+        {node->center_x[slot] - node->extent_x[slot], node->center_y[slot] - node->extent_y[slot],
+         node->center_z[slot] - node->extent_z[slot]},
+        {node->center_x[slot] + node->extent_x[slot], node->center_y[slot] + node->extent_y[slot],
+         node->center_z[slot] + node->extent_z[slot]},
+    };
+    return box;
+}
+
+static void store_bounds(ve_bvh_node* node, uint32_t slot, const ve_aabb* box) {
+    node->center_x[slot] = (box->min.x + box->max.x) * 0.5f;
+    node->center_y[slot] = (box->min.y + box->max.y) * 0.5f;
+    node->center_z[slot] = (box->min.z + box->max.z) * 0.5f;
+    node->extent_x[slot] = (box->max.x - box->min.x) * 0.5f;
+    node->extent_y[slot] = (box->max.y - box->min.y) * 0.5f;
+    node->extent_z[slot] = (box->max.z - box->min.z) * 0.5f;
+}
+
+static ve_aabb node_bounds(const ve_bvh_node* node) {
+    ve_aabb box = slot_bounds(node, 0);
+    for (uint32_t slot = 1; slot < node->count; slot++) {
+        ve_aabb child = slot_bounds(node, slot);
+        box = ve_aabb_union(&box, &child);
+    }
+    return box;
+}
+
+/**
+ * @brief Point a child slot at a node or proxy and update its back reference
+ */
+static void set_slot(ve_bvh* bvh, uint32_t node, uint32_t slot, uint32_t ref, const ve_aabb* box) {
+    bvh->nodes[node].children[slot] = ref;
+    store_bounds(&bvh->nodes[node], slot, box);
+    if (ref & BVH_LEAF_BIT) {
+        ve_bvh_proxy* proxy = &bvh->proxies[ref & ~BVH_LEAF_BIT];
+        proxy->node = node;
+        proxy->slot = slot;
+    } else {
+        bvh->nodes[ref].parent = node;
+        bvh->nodes[ref].parent_slot = slot;
+    }
+}
+
+/**
+ * @brief Make room for extra nodes, so later node allocations cannot fail
+ *
+ * @return false if out of memory
+ */
+static bool reserve_nodes(ve_bvh* bvh, uint32_t extra) {
+    if (bvh->node_count + extra <= bvh->node_capacity) {
+        return true;
+    }
+    uint32_t capacity = bvh->node_capacity ? bvh->node_capacity : 64;
+    while (capacity < bvh->node_count + extra) {
+        capacity *= 2;
+    }
+    ve_bvh_node* nodes = (ve_bvh_node*)ve_reallocate(bvh->nodes, capacity * sizeof(ve_bvh_node),
+                                                     VE_MEMORY_TAG_SCENE);
+    if (!nodes) {
+        return false;
+    }
+    bvh->nodes = nodes;
+    bvh->node_capacity = capacity;
+    return true;
+}
+
+/**
+ * @brief Take a node, after reserve_nodes made room for it
+ */
+static uint32_t alloc_node(ve_bvh* bvh) {
+    uint32_t index = bvh->free_node;
+    if (index != BVH_NONE) {
+        bvh->free_node = bvh->nodes[index].children[0];
+    } else {
+        VE_ASSERT(bvh->node_count < bvh->node_capacity);
+        index = bvh->node_count++;
+    }
+    ve_bvh_node* node = &bvh->nodes[index];
+    memset(node, 0, sizeof(ve_bvh_node));
+    node->parent = BVH_NONE;
+    return index;
+}
+
+static void free_node(ve_bvh* bvh, uint32_t index) {
+    bvh->nodes[index].count = BVH_NONE;
+    bvh->nodes[index].children[0] = bvh->free_node;
+    bvh->free_node = index;
+}
+
+/**
+ * @brief Walk to the root adjusting proxy counts and change counters
+ */
+static void count_path(ve_bvh* bvh, uint32_t node, int32_t proxy_delta) {
+    for (uint32_t n = node; n != BVH_NONE; n = bvh->nodes[n].parent) {
+        bvh->nodes[n].proxy_count = (uint32_t)((int32_t)bvh->nodes[n].proxy_count + proxy_delta);
+        bvh->nodes[n].changes++;
+    }
+}
+
+/**
+ * @brief Walk to the root rewriting each node's box in its parent
+ */
+static void refit_path(ve_bvh* bvh, uint32_t node) {
+    for (uint32_t n = node; bvh->nodes[n].parent != BVH_NONE; n = bvh->nodes[n].parent) {
+        const ve_bvh_node* child = &bvh->nodes[n];
+        ve_aabb box = node_bounds(child);
+        store_bounds(&bvh->nodes[child->parent], child->parent_slot, &box);
+    }
+}
+
+/**
+ * @brief Empty a child slot, collapsing nodes left with fewer than two children
+ *
+ * @return Lowest node whose box may have changed
+ */
+static uint32_t remove_slot(ve_bvh* bvh, uint32_t node, uint32_t slot) {
+    ve_bvh_node* n = &bvh->nodes[node];
+    uint32_t last = --n->count;
+    if (slot != last) {
+        ve_aabb box = slot_bounds(n, last);
+        set_slot(bvh, node, slot, n->children[last], &box);
+    }
+    if (node == BVH_ROOT || n->count >= 2) {
+        return node;
+    }
+
+    uint32_t parent = n->parent;
+    uint32_t parent_slot = n->parent_slot;
+    if (n->count == 1) {
+        ve_aabb box = slot_bounds(n, 0);
+        set_slot(bvh, parent, parent_slot, n->children[0], &box);
+        free_node(bvh, node);
+        return parent;
+    }
+    free_node(bvh, node);
+    return remove_slot(bvh, parent, parent_slot);
+}
+
+static float proxy_centroid(const ve_bvh* bvh, uint32_t proxy, int axis) {
+    const ve_aabb* box = &bvh->proxies[proxy].bounds;
+    const float* min = &box->min.x;
+    const float* max = &box->max.x;
+    return (min[axis] + max[axis]) * 0.5f;
+}
+
+/**
+ * @brief Split proxies in two with a binned SAH along the widest centroid axis
+ *
+ * Falls back to the middle when every centroid lands in one bin.
+ *
+ * @return Proxies in the left part, moved to the front
+ */
+static uint32_t sah_split(const ve_bvh* bvh, uint32_t* proxies, uint32_t count) {
+    ve_vec3 centroid_min = ve_vec3_make(FLT_MAX, FLT_MAX, FLT_MAX);
+    ve_vec3 centroid_max = ve_vec3_make(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (uint32_t i = 0; i < count; i++) {
+        ve_vec3 c = ve_vec3_make(proxy_centroid(bvh, proxies[i], 0), proxy_centroid(bvh, proxies[i], 1),
+                                 proxy_centroid(bvh, proxies[i], 2));
+        centroid_min = ve_vec3_make(fminf(centroid_min.x, c.x), fminf(centroid_min.y, c.y), fminf(centroid_min.z, c.z));
+        centroid_max = ve_vec3_make(fmaxf(centroid_max.x, c.x), fmaxf(centroid_max.y, c.y), fmaxf(centroid_max.z, c.z));
+    }
+
+    ve_vec3 size = ve_vec3_sub(centroid_max, centroid_min);
+    int axis = size.x >= size.y && size.x >= size.z ? 0 : (size.y >= size.z ? 1 : 2);
+    float axis_min = (&centroid_min.x)[axis];
+    float axis_size = (&size.x)[axis];
+    if (!(axis_size > 0.0f)) {
+        return count / 2;
+    }
+    float scale = (float)BVH_SAH_BINS / axis_size;
+
+    uint32_t bin_counts[BVH_SAH_BINS] = {0};
+    ve_aabb bin_bounds[BVH_SAH_BINS];
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t bin = (uint32_t)((proxy_centroid(bvh, proxies[i], axis) - axis_min) * scale);
+        bin = bin < BVH_SAH_BINS ? bin : BVH_SAH_BINS - 1;
+        const ve_aabb* box = &bvh->proxies[proxies[i]].bounds;
+        bin_bounds[bin] = bin_counts[bin] ? ve_aabb_union(&bin_bounds[bin], box) : *box;
+        bin_counts[bin]++;
+    }
+
+    /* Cost of splitting after bin i is area(left) * count(left) + area(right) * count(right) */
+    float left_cost[BVH_SAH_BINS - 1];
+    ve_aabb accumulated = bin_bounds[0];
+    uint32_t accumulated_count = 0;
+    for (uint32_t i = 0; i + 1 < BVH_SAH_BINS; i++) {
+        if (bin_counts[i]) {
+            accumulated = accumulated_count ? ve_aabb_union(&accumulated, &bin_bounds[i]) : bin_bounds[i];
+            accumulated_count += bin_counts[i];
+        }
+        left_cost[i] = accumulated_count ? ve_aabb_surface_area(&accumulated) * (float)accumulated_count : -1.0f;
+    }
+
+    float best_cost = FLT_MAX;
+    uint32_t best_bin = BVH_NONE;
+    accumulated_count = 0;
+    for (uint32_t i = BVH_SAH_BINS - 1; i > 0; i--) {
+        if (bin_counts[i]) {
+            accumulated = accumulated_count ? ve_aabb_union(&accumulated, &bin_bounds[i]) : bin_bounds[i];
+            accumulated_count += bin_counts[i];
+        }
+        if (accumulated_count == 0 || left_cost[i - 1] < 0.0f) {
+            continue;
+        }
+        float cost = left_cost[i - 1] + ve_aabb_surface_area(&accumulated) * (float)accumulated_count;
+        if (cost < best_cost) {
+            best_cost = cost;
+            best_bin = i - 1;
+        }
+    }
+    if (best_bin == BVH_NONE) {
+        return count / 2;
+    }
+
+    uint32_t left = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t bin = (uint32_t)((proxy_centroid(bvh, proxies[i], axis) - axis_min) * scale);
+        if (bin <= best_bin) {
+            uint32_t swap = proxies[left];
+            proxies[left++] = proxies[i];
+            proxies[i] = swap;
+        }
+    }
+    return left;
+}
+
+/**
+ * @brief Fill an empty node with an SAH-built subtree over proxies
+ *
+ * Two levels of binary splits give up to four children. Nodes must have
+ * been reserved, one per proxy is always enough.
+ */
+static void build_node(ve_bvh* bvh, uint32_t node, uint32_t* proxies, uint32_t count) {
+    uint32_t starts[VE_BVH_WIDTH];
+    uint32_t counts[VE_BVH_WIDTH];
+    uint32_t groups = 0;
+
+    if (count <= VE_BVH_WIDTH) {
+        for (uint32_t i = 0; i < count; i++) {
+            starts[groups] = i;
+            counts[groups++] = 1;
+        }
+    } else {
+        uint32_t half = sah_split(bvh, proxies, count);
+        uint32_t half_starts[2] = {0, half};
+        uint32_t half_counts[2] = {half, count - half};
+        for (int h = 0; h < 2; h++) {
+            if (half_counts[h] == 1) {
+                starts[groups] = half_starts[h];
+                counts[groups++] = 1;
+                continue;
+            }
+            uint32_t quarter = sah_split(bvh, proxies + half_starts[h], half_counts[h]);
+            starts[groups] = half_starts[h];
+            counts[groups++] = quarter;
+            starts[groups] = half_starts[h] + quarter;
+            counts[groups++] = half_counts[h] - quarter;
+        }
+    }
+
+    for (uint32_t g = 0; g < groups; g++) {
+        if (counts[g] == 1) {
+            uint32_t proxy = proxies[starts[g]];
+            set_slot(bvh, node, g, proxy | BVH_LEAF_BIT, &bvh->proxies[proxy].bounds);
+        } else {
+            uint32_t child = alloc_node(bvh);
+            build_node(bvh, child, proxies + starts[g], counts[g]);
+            ve_aabb box = node_bounds(&bvh->nodes[child]);
+            set_slot(bvh, node, g, child, &box);
+        }
+    }
+    bvh->nodes[node].count = groups;
+    bvh->nodes[node].proxy_count = count;
+    bvh->nodes[node].changes = 0;
+}
+
+/**
+ * @brief Rebuild the subtree below a node in place
+ *
+ * @return false if out of memory, with the subtree unchanged
+ */
+static bool rebuild_subtree(ve_bvh* bvh, uint32_t node) {
+    uint32_t count = bvh->nodes[node].proxy_count;
+    uint32_t* proxies = (uint32_t*)VE_ALLOCATE_TAG((size_t)(count ? count : 1) * sizeof(uint32_t),
+                                                   VE_MEMORY_TAG_SCENE);
+    if (!proxies || !reserve_nodes(bvh, count)) {
+        VE_FREE(proxies);
+        return false;
+    }
+
+    /* Gather the proxies and release every node below this one */
+    bvh_stack stack;
+    stack_init(&stack);
+    uint32_t gathered = 0;
+    bool complete = stack_push(&stack, node, 0.0f);
+    while (complete && stack.count > 0) {
+        uint32_t n = stack.entries[--stack.count].node;
+        const ve_bvh_node* current = &bvh->nodes[n];
+        for (uint32_t slot = 0; slot < current->count; slot++) {
+            uint32_t ref = current->children[slot];
+            if (ref & BVH_LEAF_BIT) {
+                proxies[gathered++] = ref & ~BVH_LEAF_BIT;
+            } else if (!stack_push(&stack, ref, 0.0f)) {
+                complete = false;
+                break;
+            }
+        }
+    }
+    stack_free(&stack);
+    if (!complete) {
+        VE_FREE(proxies);
+        return false;
+    }
+
+    stack_init(&stack);
+    for (uint32_t slot = 0; slot < bvh->nodes[node].count; slot++) {
+        if (!(bvh->nodes[node].children[slot] & BVH_LEAF_BIT)) {
+            stack_push(&stack, bvh->nodes[node].children[slot], 0.0f);
+        }
+    }
+    while (stack.count > 0) {
+        uint32_t n = stack.entries[--stack.count].node;
+        for (uint32_t slot = 0; slot < bvh->nodes[n].count; slot++) {
+            if (!(bvh->nodes[n].children[slot] & BVH_LEAF_BIT)) {
+                stack_push(&stack, bvh->nodes[n].children[slot], 0.0f);
+            }
+        }
+        free_node(bvh, n);
+    }
+    stack_free(&stack);
+
+    VE_ASSERT(gathered == count);
+    bvh->nodes[node].count = 0;
+    if (count > 0) {
+        build_node(bvh, node, proxies, count);
+    }
+    bvh->nodes[node].changes = 0;
+    VE_FREE(proxies);
+    return true;
+}
+
+ve_bvh* ve_bvh_create(void) {
+    ve_bvh* bvh = (ve_bvh*)ve_allocate_cleared(1, sizeof(ve_bvh), VE_MEMORY_TAG_SCENE);
+    if (!bvh) {
+        return NULL;
+    }
+    bvh->free_node = BVH_NONE;
+    bvh->free_proxy = BVH_NONE;
+    if (!reserve_nodes(bvh, 1)) {
+        VE_FREE(bvh);
+        return NULL;
+    }
+    alloc_node(bvh);
+    return bvh;
+}
+
+void ve_bvh_destroy(ve_bvh* bvh) {
+    if (!bvh) {
+        return;
+    }
+    VE_FREE(bvh->nodes);
+    VE_FREE(bvh->proxies);
+    VE_FREE(bvh);
+}
+
+uint32_t ve_bvh_insert(ve_bvh* bvh, const ve_aabb* bounds, uint32_t user) {
+    VE_ASSERT(bvh && bounds);
+
+    /* Insertion creates at most one node */
+    if (!reserve_nodes(bvh, 1)) {
+        return VE_BVH_INVALID;
+    }
+    uint32_t proxy = bvh->free_proxy;
+    if (proxy == BVH_NONE) {
+        if (bvh->proxy_count == bvh->proxy_capacity) {
+            uint32_t capacity = bvh->proxy_capacity ? bvh->proxy_capacity * 2 : 256;
+            ve_bvh_proxy* proxies = (ve_bvh_proxy*)ve_reallocate(bvh->proxies, capacity * sizeof(ve_bvh_proxy),
+                                                                 VE_MEMORY_TAG_SCENE);
+            if (!proxies) {
+                return VE_BVH_INVALID;
+            }
+            bvh->proxies = proxies;
+            bvh->proxy_capacity = capacity;
+        }
+        proxy = bvh->proxy_count++;
+    } else {
+        bvh->free_proxy = bvh->proxies[proxy].slot;
+    }
+    bvh->proxies[proxy].bounds = *bounds;
+    bvh->proxies[proxy].user = user;
+    bvh->live_count++;
+
+    /* Descend along the smallest growth in surface area until a node has room */
+    uint32_t node = BVH_ROOT;
+    uint32_t ref = proxy | BVH_LEAF_BIT;
+    for (;;) {
+        ve_bvh_node* n = &bvh->nodes[node];
+        if (n->count < VE_BVH_WIDTH) {
+            set_slot(bvh, node, n->count++, ref, bounds);
+            break;
+        }
+
+        uint32_t best = 0;
+        float best_growth = FLT_MAX;
+        float best_area = FLT_MAX;
+        for (uint32_t slot = 0; slot < VE_BVH_WIDTH; slot++) {
+            ve_aabb box = slot_bounds(n, slot);
+            ve_aabb merged = ve_aabb_union(&box, bounds);
+            float area = ve_aabb_surface_area(&box);
+            float growth = ve_aabb_surface_area(&merged) - area;
+            if (growth < best_growth || (growth == best_growth && area < best_area)) {
+                best = slot;
+                best_growth = growth;
+                best_area = area;
+            }
+        }
+
+        uint32_t child = n->children[best];
+        if (!(child & BVH_LEAF_BIT)) {
+            node = child;
+            continue;
+        }
+
+        /* Full node over a proxy: pair the two under a new node */
+        ve_aabb sibling = slot_bounds(n, best);
+        uint32_t pair = alloc_node(bvh);
+        ve_aabb merged = ve_aabb_union(&sibling, bounds);
+        set_slot(bvh, node, best, pair, &merged);
+        set_slot(bvh, pair, 0, child, &sibling);
+        set_slot(bvh, pair, 1, ref, bounds);
+        bvh->nodes[pair].count = 2;
+        bvh->nodes[pair].proxy_count = 1;
+        node = pair;
+        break;
+    }
+
+    count_path(bvh, node, 1);
+    refit_path(bvh, node);
+    return proxy;
+}
+
+void ve_bvh_remove(ve_bvh* bvh, uint32_t proxy) {
+    VE_ASSERT(bvh && proxy < bvh->proxy_count && bvh->proxies[proxy].node != BVH_NONE);
+
+    ve_bvh_proxy* p = &bvh->proxies[proxy];
+    count_path(bvh, p->node, -1);
+    uint32_t changed = remove_slot(bvh, p->node, p->slot);
+    refit_path(bvh, changed);
+
+    p->node = BVH_NONE;
+    p->slot = bvh->free_proxy;
+    bvh->free_proxy = proxy;
+    bvh->live_count--;
+}
+
+void ve_bvh_move(ve_bvh* bvh, uint32_t proxy, const ve_aabb* bounds) {
+    VE_ASSERT(bvh && bounds && proxy < bvh->proxy_count && bvh->proxies[proxy].node != BVH_NONE);
+
+    ve_bvh_proxy* p = &bvh->proxies[proxy];
+    p->bounds = *bounds;
+    store_bounds(&bvh->nodes[p->node], p->slot, bounds);
+    count_path(bvh, p->node, 0);
+    refit_path(bvh, p->node);
+}
+
+const ve_aabb* ve_bvh_get_bounds(const ve_bvh* bvh, uint32_t proxy) {
+    VE_ASSERT(bvh && proxy < bvh->proxy_count);
+    return &bvh->proxies[proxy].bounds;
+}
+
+uint32_t ve_bvh_get_user(const ve_bvh* bvh, uint32_t proxy) {
+    VE_ASSERT(bvh && proxy < bvh->proxy_count);
+    return bvh->proxies[proxy].user;
+}
+
+uint32_t ve_bvh_get_count(const ve_bvh* bvh) {
+    VE_ASSERT(bvh);
+    return bvh->live_count;
+}
+
+uint32_t ve_bvh_optimize(ve_bvh* bvh, uint32_t max_proxies) {
+    VE_ASSERT(bvh);
+
+    uint32_t node = BVH_ROOT;
+    if (bvh->nodes[node].changes == 0) {
+        return 0;
+    }
+    while (bvh->nodes[node].proxy_count > max_proxies) {
+        const ve_bvh_node* n = &bvh->nodes[node];
+        uint32_t best = BVH_NONE;
+        uint32_t best_changes = 0;
+        for (uint32_t slot = 0; slot < n->count; slot++) {
+            uint32_t child = n->children[slot];
+            if (!(child & BVH_LEAF_BIT) && bvh->nodes[child].changes > best_changes) {
+                best = child;
+                best_changes = bvh->nodes[child].changes;
+            }
+        }
+        if (best == BVH_NONE) {
+            return 0;
+        }
+        node = best;
+    }
+
+    uint32_t changes = bvh->nodes[node].changes;
+    if (changes * BVH_REBUILD_CHANGE_RATIO < bvh->nodes[node].proxy_count) {
+        return 0;
+    }
+    if (!rebuild_subtree(bvh, node)) {
+        VE_LOG_ERROR("Out of memory rebuilding a BVH subtree of %u proxies", bvh->nodes[node].proxy_count);
+        return 0;
+    }
+    for (uint32_t n = bvh->nodes[node].parent; n != BVH_NONE; n = bvh->nodes[n].parent) {
+        bvh->nodes[n].changes -= changes;
+    }
+    refit_path(bvh, node);
+    return bvh->nodes[node].proxy_count;
+}
+
+void ve_bvh_rebuild(ve_bvh* bvh) {
+    VE_ASSERT(bvh);
+    if (!rebuild_subtree(bvh, BVH_ROOT)) {
+        VE_LOG_ERROR("Out of memory rebuilding a BVH of %u proxies", bvh->live_count);
+    }
+}
+
+float ve_bvh_get_sah_cost(const ve_bvh* bvh) {
+    VE_ASSERT(bvh);
+
+    const ve_bvh_node* root = &bvh->nodes[BVH_ROOT];
+    if (root->count == 0) {
+        return 0.0f;
+    }
+    ve_aabb root_box = node_bounds(root);
+    float root_area = ve_aabb_surface_area(&root_box);
+    if (!(root_area > 0.0f)) {
+        return 0.0f;
+    }
+
+    /* Every node visit tests its child boxes; every child box hit is a visit */
+    float cost = 0.0f;
+    for (uint32_t i = 0; i < bvh->node_count; i++) {
+        const ve_bvh_node* node = &bvh->nodes[i];
+        if (node->count == BVH_NONE) {
+            continue;
+        }
+        for (uint32_t slot = 0; slot < node->count; slot++) {
+            ve_aabb box = slot_bounds(node, slot);
+            cost += ve_aabb_surface_area(&box);
+        }
+    }
+    return 1.0f + cost / root_area;
+}
+
+uint32_t ve_bvh_get_subtrees(const ve_bvh* bvh, uint32_t min_count, uint32_t* subtrees, uint32_t capacity) {
+    VE_ASSERT(bvh && subtrees);
+
+    if (bvh->nodes[BVH_ROOT].count == 0 || capacity == 0) {
+        return 0;
+    }
+    uint32_t count = 0;
+    subtrees[count++] = BVH_ROOT;
+
+    /* Each pass replaces the nodes found by the previous one with their children */
+    bool expanded = true;
+    while (count < min_count && expanded) {
+        expanded = false;
+        uint32_t pass_count = count;
+        for (uint32_t i = 0; i < pass_count && count < min_count; i++) {
+            uint32_t ref = subtrees[i];
+            if (ref & BVH_LEAF_BIT) {
+                continue;
+            }
+            const ve_bvh_node* node = &bvh->nodes[ref];
+            if (count - 1 + node->count > capacity) {
+                break;
+            }
+            subtrees[i] = node->children[0];
+            for (uint32_t slot = 1; slot < node->count; slot++) {
+                subtrees[count++] = node->children[slot];
+            }
+            expanded = true;
+        }
+    }
+    return count;
+}
+
+uint32_t ve_bvh_get_subtree_count(const ve_bvh* bvh, uint32_t subtree) {
+    VE_ASSERT(bvh);
+    return (subtree & BVH_LEAF_BIT) ? 1 : bvh->nodes[subtree].proxy_count;
+}
+
+uint32_t ve_bvh_cull_frustum_subtree(const ve_bvh* bvh, uint32_t subtree, const ve_frustum* frustum,
+                                     uint32_t* users, uint32_t capacity) {
+    VE_ASSERT(bvh && frustum && (users || capacity == 0));
+
+    if (subtree & BVH_LEAF_BIT) {
+        const ve_bvh_proxy* proxy = &bvh->proxies[subtree & ~BVH_LEAF_BIT];
+        ve_bvh_node single;
+        single.count = 1;
+        store_bounds(&single, 0, &proxy->bounds);
+        ve_aabb_soa box = {
+            single.center_x, single.center_y, single.center_z, single.extent_x, single.extent_y, single.extent_z,
+        };
+        uint32_t visible;
+        if (ve_frustum_cull_aabbs(frustum, &box, 1, &visible) == 0) {
+            return 0;
+        }
+        if (capacity > 0) {
+            users[0] = proxy->user;
+        }
+        return 1;
+    }
+
+    uint32_t found = 0;
+    bvh_stack stack;
+    stack_init(&stack);
+    stack_push(&stack, subtree, 0.0f);
+    while (stack.count > 0) {
+        const ve_bvh_node* node = &bvh->nodes[stack.entries[--stack.count].node];
+        ve_aabb_soa boxes = {
+            node->center_x, node->center_y, node->center_z, node->extent_x, node->extent_y, node->extent_z,
+        };
+        uint32_t visible[VE_BVH_WIDTH];
+        uint32_t visible_count = ve_frustum_cull_aabbs(frustum, &boxes, node->count, visible);
+        for (uint32_t i = 0; i < visible_count; i++) {
+            uint32_t ref = node->children[visible[i]];
+            if (ref & BVH_LEAF_BIT) {
+                if (found < capacity) {
+                    users[found] = bvh->proxies[ref & ~BVH_LEAF_BIT].user;
+                }
+                found++;
+            } else {
+                stack_push(&stack, ref, 0.0f);
+            }
+        }
+    }
+    stack_free(&stack);
+    return found;
+}
+
+uint32_t ve_bvh_cull_frustum(const ve_bvh* bvh, const ve_frustum* frustum, uint32_t* users, uint32_t capacity) {
+    return ve_bvh_cull_frustum_subtree(bvh, BVH_ROOT, frustum, users, capacity);
+}
+
+uint32_t ve_bvh_query_aabb(const ve_bvh* bvh, const ve_aabb* bounds, uint32_t* users, uint32_t capacity) {
+    VE_ASSERT(bvh && bounds && (users || capacity == 0));
+
+    float qx = (bounds->min.x + bounds->max.x) * 0.5f, ex = (bounds->max.x - bounds->min.x) * 0.5f;
+    float qy = (bounds->min.y + bounds->max.y) * 0.5f, ey = (bounds->max.y - bounds->min.y) * 0.5f;
+    float qz = (bounds->min.z + bounds->max.z) * 0.5f, ez = (bounds->max.z - bounds->min.z) * 0.5f;
+
+    uint32_t found = 0;
+    bvh_stack stack;
+    stack_init(&stack);
+    stack_push(&stack, BVH_ROOT, 0.0f);
+    while (stack.count > 0) {
+        const ve_bvh_node* node = &bvh->nodes[stack.entries[--stack.count].node];
+        for (uint32_t slot = 0; slot < node->count; slot++) {
+            if (fabsf(node->center_x[slot] - qx) > node->extent_x[slot] + ex ||
+                fabsf(node->center_y[slot] - qy) > node->extent_y[slot] + ey ||
+                fabsf(node->center_z[slot] - qz) > node->extent_z[slot] + ez) {
+                continue;
+            }
+            uint32_t ref = node->children[slot];
+            if (ref & BVH_LEAF_BIT) {
+                if (found < capacity) {
+                    users[found] = bvh->proxies[ref & ~BVH_LEAF_BIT].user;
+                }
+                found++;
+            } else {
+                stack_push(&stack, ref, 0.0f);
+            }
+        }
+    }
+    stack_free(&stack);
+    return found;
+}
+
+bool ve_bvh_raycast(const ve_bvh* bvh, ve_vec3 origin, ve_vec3 direction, float max_distance, ve_bvh_ray_fn fn,
+                    void* user_data, ve_bvh_hit* hit) {
+    VE_ASSERT(bvh && hit);
+
+    /* Zero components give infinities, which the slab test handles */
+    ve_vec3 inv = ve_vec3_make(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    float best = max_distance;
+    bool found = false;
+
+    bvh_stack stack;
+    stack_init(&stack);
+    stack_push(&stack, BVH_ROOT, 0.0f);
+    while (stack.count > 0) {
+        bvh_stack_entry entry = stack.entries[--stack.count];
+        if (entry.distance > best) {
+            continue;
+        }
+
+        const ve_bvh_node* node = &bvh->nodes[entry.node];
+        uint32_t hits[VE_BVH_WIDTH];
+        float entries[VE_BVH_WIDTH];
+        uint32_t hit_count = 0;
+        for (uint32_t slot = 0; slot < node->count; slot++) {
+            float tx0 = (node->center_x[slot] - node->extent_x[slot] - origin.x) * inv.x;
+            float tx1 = (node->center_x[slot] + node->extent_x[slot] - origin.x) * inv.x;
+            float ty0 = (node->center_y[slot] - node->extent_y[slot] - origin.y) * inv.y;
+            float ty1 = (node->center_y[slot] + node->extent_y[slot] - origin.y) * inv.y;
+            float tz0 = (node->center_z[slot] - node->extent_z[slot] - origin.z) * inv.z;
+            float tz1 = (node->center_z[slot] + node->extent_z[slot] - origin.z) * inv.z;
+            float near = fmaxf(fmaxf(fminf(tx0, tx1), fminf(ty0, ty1)), fmaxf(fminf(tz0, tz1), 0.0f));
+            float far = fminf(fminf(fmaxf(tx0, tx1), fmaxf(ty0, ty1)), fmaxf(tz0, tz1));
+            if (near > far || near > best) {
+                continue;
+            }
+
+            /* Keep hits sorted nearest first */
+            uint32_t i = hit_count++;
+            while (i > 0 && entries[i - 1] > near) {
+                hits[i] = hits[i - 1];
+                entries[i] = entries[i - 1];
+                i--;
+            }
+            hits[i] = slot;
+            entries[i] = near;
+        }
+
+        for (uint32_t i = 0; i < hit_count; i++) {
+            uint32_t ref = node->children[hits[i]];
+            if (!(ref & BVH_LEAF_BIT) || entries[i] > best) {
+                continue;
+            }
+            const ve_bvh_proxy* proxy = &bvh->proxies[ref & ~BVH_LEAF_BIT];
+            float distance = fn ? fn(proxy->user, origin, direction, best, user_data) : entries[i];
+            if (distance >= 0.0f && distance <= best) {
+                best = distance;
+                hit->proxy = ref & ~BVH_LEAF_BIT;
+                hit->user = proxy->user;
+                hit->distance = distance;
+                found = true;
+            }
+        }
+
+        /* Farthest first, so the nearest child is popped next */
+        for (uint32_t i = hit_count; i-- > 0;) {
+            uint32_t ref = node->children[hits[i]];
+            if (!(ref & BVH_LEAF_BIT)) {
+                stack_push(&stack, ref, entries[i]);
+            }
+        }
+    }
+    stack_free(&stack);
+    return found;
+}
+
+/**
+ * @brief Node with bounds, mirrored into the BVH
+ */
+typedef struct ve_scene_body {
+    ve_node node;
+    uint32_t proxy;
+    uint32_t version;               /* World version the proxy was fitted to */
+    bool dirty;                     /* Local bounds changed since the last fit */
+    ve_aabb local_bounds;
+    uint32_t pipeline;
+    uint32_t material;
+    uint32_t mesh;
+    uint32_t instance;
+    uint32_t lod_count;
+    float lod_errors[VE_SCENE_MAX_LODS];
+    uint8_t lods[VE_SCENE_LOD_VIEWS];   /* Last level each view chose */
+} ve_scene_body;
+
+struct ve_scene {
+    ve_node_graph* nodes;
+    ve_bvh* bvh;
+
+    ve_scene_body* bodies;
+    uint32_t body_count;
+    uint32_t body_capacity;
+    uint32_t* body_of_slot;         /* Body per node slot index, BVH_NONE without one */
+    uint32_t slot_capacity;
+};
+
+static uint32_t node_slot(ve_node node) {
+    return node & (VE_NODE_MAX_NODES - 1);
+}
+
+/**
+ * @brief Find the body of a node
+ *
+ * @return Body index, or BVH_NONE if the node has none
+ */
+static uint32_t find_body(const ve_scene* scene, ve_node node) {
+    uint32_t slot = node_slot(node);
+    if (slot >= scene->slot_capacity) {
+        return BVH_NONE;
+    }
+    uint32_t body = scene->body_of_slot[slot];
+    return body != BVH_NONE && scene->bodies[body].node == node ? body : BVH_NONE;
+}
+
+static void remove_body(ve_scene* scene, uint32_t body) {
+    ve_bvh_remove(scene->bvh, scene->bodies[body].proxy);
+    scene->body_of_slot[node_slot(scene->bodies[body].node)] = BVH_NONE;
+
+    uint32_t last = --scene->body_count;
+    if (body != last) {
+        scene->bodies[body] = scene->bodies[last];
+        scene->body_of_slot[node_slot(scene->bodies[body].node)] = body;
+    }
+}
+
+ve_scene* ve_scene_create(void) {
+    ve_scene* scene = (ve_scene*)ve_allocate_cleared(1, sizeof(ve_scene), VE_MEMORY_TAG_SCENE);
+    if (!scene) {
+        return NULL;
+    }
+    scene->nodes = ve_node_graph_create();
+    scene->bvh = ve_bvh_create();
+    if (!scene->nodes || !scene->bvh) {
+        ve_scene_destroy(scene);
+        return NULL;
+    }
+    return scene;
+}
+
+void ve_scene_destroy(ve_scene* scene) {
+    if (!scene) {
+        return;
+    }
+    ve_node_graph_destroy(scene->nodes);
+    ve_bvh_destroy(scene->bvh);
+    VE_FREE(scene->bodies);
+    VE_FREE(scene->body_of_slot);
+    VE_FREE(scene);
+}
+
+ve_node_graph* ve_scene_get_nodes(ve_scene* scene) {
+    VE_ASSERT(scene);
+    return scene->nodes;
+}
+
+const ve_bvh* ve_scene_get_bvh(const ve_scene* scene) {
+    VE_ASSERT(scene);
+    return scene->bvh;
+}
+
+bool ve_scene_set_bounds(ve_scene* scene, ve_node node, const ve_aabb* local_bounds) {
+    VE_ASSERT(scene && local_bounds);
+    VE_ASSERT_MSG(ve_node_is_alive(scene->nodes, node), "Stale scene node");
+
+    uint32_t body = find_body(scene, node);
+    if (body != BVH_NONE) {
+        scene->bodies[body].local_bounds = *local_bounds;
+        scene->bodies[body].dirty = true;
+        return true;
+    }
+
+    uint32_t slot = node_slot(node);
+    if (slot >= scene->slot_capacity) {
+        uint32_t capacity = scene->slot_capacity ? scene->slot_capacity : 1024;
+        while (capacity <= slot) {
+            capacity *= 2;
+        }
+        uint32_t* body_of_slot = (uint32_t*)ve_reallocate(scene->body_of_slot, capacity * sizeof(uint32_t),
+                                                          VE_MEMORY_TAG_SCENE);
+        if (!body_of_slot) {
+            return false;
+        }
+        for (uint32_t i = scene->slot_capacity; i < capacity; i++) {
+            body_of_slot[i] = BVH_NONE;
+        }
+        scene->body_of_slot = body_of_slot;
+        scene->slot_capacity = capacity;
+    }
+
+    /* A body left behind by a destroyed node that used the same slot */
+    if (scene->body_of_slot[slot] != BVH_NONE) {
+        remove_body(scene, scene->body_of_slot[slot]);
+    }
+
+    if (scene->body_count == scene->body_capacity) {
+        uint32_t capacity = scene->body_capacity ? scene->body_capacity * 2 : 256;
+        ve_scene_body* bodies = (ve_scene_body*)ve_reallocate(scene->bodies, capacity * sizeof(ve_scene_body),
+                                                              VE_MEMORY_TAG_SCENE);
+        if (!bodies) {
+            return false;
+        }
+        scene->bodies = bodies;
+        scene->body_capacity = capacity;
+    }
+
+    ve_aabb world_bounds = ve_aabb_transform(ve_node_get_world(scene->nodes, node), local_bounds);
+    uint32_t proxy = ve_bvh_insert(scene->bvh, &world_bounds, node);
+    if (proxy == VE_BVH_INVALID) {
+        return false;
+    }
+
+    body = scene->body_count++;
+    scene->bodies[body] = (ve_scene_body){
+        .node = node,
+        .proxy = proxy,
+        .version = ve_node_get_world_version(scene->nodes, node),
+        .dirty = false,
+        .local_bounds = *local_bounds,
+    };
+    scene->body_of_slot[slot] = body;
+    return true;
+}
+
+void ve_scene_set_render(ve_scene* scene, ve_node node, uint32_t pipeline, uint32_t material) {
+    VE_ASSERT(scene);
+
+    uint32_t body = find_body(scene, node);
+    VE_ASSERT_MSG(body != BVH_NONE, "Scene node has no bounds");
+    scene->bodies[body].pipeline = pipeline;
+    scene->bodies[body].material = material;
+}
+
+bool ve_scene_get_render(const ve_scene* scene, ve_node node, uint32_t* pipeline, uint32_t* material) {
+    VE_ASSERT(scene && pipeline && material);
+
+    uint32_t body = find_body(scene, node);
+    if (body == BVH_NONE) {
+        return false;
+    }
+    *pipeline = scene->bodies[body].pipeline;
+    *material = scene->bodies[body].material;
+    return true;
+}
+
+void ve_scene_set_instance(ve_scene* scene, ve_node node, uint32_t mesh, uint32_t instance) {
+    VE_ASSERT(scene);
+
+    uint32_t body = find_body(scene, node);
+    VE_ASSERT_MSG(body != BVH_NONE, "Scene node has no bounds");
+    scene->bodies[body].mesh = mesh;
+    scene->bodies[body].instance = instance;
+}
+
+bool ve_scene_get_instance(const ve_scene* scene, ve_node node, uint32_t* mesh, uint32_t* instance) {
+    VE_ASSERT(scene && mesh && instance);
+
+    uint32_t body = find_body(scene, node);
+    if (body == BVH_NONE) {
+        return false;
+    }
+    *mesh = scene->bodies[body].mesh;
+    *instance = scene->bodies[body].instance;
+    return true;
+}
+
+void ve_scene_set_lods(ve_scene* scene, ve_node node, const float* errors, uint32_t count) {
+    VE_ASSERT(scene && (errors || count == 0));
+    VE_ASSERT_MSG(count <= VE_SCENE_MAX_LODS, "Too many levels of detail");
+
+    uint32_t body = find_body(scene, node);
+    VE_ASSERT_MSG(body != BVH_NONE, "Scene node has no bounds");
+    ve_scene_body* target = &scene->bodies[body];
+    target->lod_count = count;
+    memcpy(target->lod_errors, errors, count * sizeof(float));
+    memset(target->lods, 0, sizeof(target->lods));
+}
+
+uint32_t ve_scene_select_lod(ve_scene* scene, ve_node node, uint32_t view, float error_scale, float threshold) {
+    VE_ASSERT(scene);
+    VE_ASSERT_MSG(view < VE_SCENE_LOD_VIEWS, "Level of detail view out of range");
+
+    uint32_t body = find_body(scene, node);
+    if (body == BVH_NONE || scene->bodies[body].lod_count == 0) {
+        return 0;
+    }
+    ve_scene_body* target = &scene->bodies[body];
+
+    uint32_t lod = 0;
+    while (lod + 1 < target->lod_count && target->lod_errors[lod + 1] * error_scale <= threshold) {
+        lod++;
+    }
+
+    /* Coarser than last time only past the hysteresis band */
+    uint32_t previous = target->lods[view];
+    if (lod > previous) {
+        float coarsen_threshold = threshold * (1.0f - VE_SCENE_LOD_HYSTERESIS);
+        uint32_t coarser = previous;
+        while (coarser < lod && target->lod_errors[coarser + 1] * error_scale <= coarsen_threshold) {
+            coarser++;
+        }
+        lod = coarser;
+    }
+    target->lods[view] = (uint8_t)lod;
+    return lod;
+}
+
+void ve_scene_clear_bounds(ve_scene* scene, ve_node node) {
+    VE_ASSERT(scene);
+
+    uint32_t body = find_body(scene, node);
+    if (body != BVH_NONE) {
+        remove_body(scene, body);
+    }
+}
+
+bool ve_scene_update(ve_scene* scene, ve_thread_pool* pool) {
+    VE_ASSERT(scene);
+
+    if (ve_node_graph_update(scene->nodes, pool) == 0) {
+        return false;
+    }
+
+    /* Refit the proxies of nodes that moved this update */
+    for (uint32_t i = 0; i < scene->body_count;) {
+        ve_scene_body* body = &scene->bodies[i];
+        if (!ve_node_is_alive(scene->nodes, body->node)) {
+            remove_body(scene, i);
+            continue;
+        }
+        uint32_t version = ve_node_get_world_version(scene->nodes, body->node);
+        if (body->dirty || version != body->version) {
+            ve_aabb world_bounds = ve_aabb_transform(ve_node_get_world(scene->nodes, body->node),
+                                                     &body->local_bounds);
+            ve_bvh_move(scene->bvh, body->proxy, &world_bounds);
+            body->version = version;
+            body->dirty = false;
+        }
+        i++;
+    }
+
+    ve_bvh_optimize(scene->bvh, VE_SCENE_REBUILD_BUDGET);
+    return true;
+}
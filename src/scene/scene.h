@@ -1,18 +1,410 @@
 /**
  * @file scene.h
- * @brief Scene management
+ * @brief Scene management and spatial index
+ *
+ * A scene owns the node hierarchy and a bounding volume hierarchy over the
+ * nodes that have bounds, and brings both up to date once per frame.
+ *
+ * The BVH is 4 wide: each node keeps the boxes of its children as
+ * structure of arrays, laid out as ve_aabb_soa expects, so one
+ * ve_frustum_cull_aabbs call tests all children with the SIMD kernels.
+ * Child slots hold either another node or one proxy.
+ *
+ * It is dynamic. Inserts descend greedily along the cheapest surface area
+ * growth, moves refit the boxes on the path to the root, and removals
+ * collapse nodes left with a single child. Every change is counted along
+ * its path, and ve_bvh_optimize rebuilds the most changed subtree that
+ * fits a budget with a binned surface area heuristic (SAH) build once a
+ * quarter of it has changed, so tree quality recovers a bounded amount of
+ * work at a time.
  */
 
 #ifndef VE_SCENE_H
 #define VE_SCENE_H
 
+#include "node.h"
+#include "../math/vmath.h"
+#include "../core/thread.h"
 #include <stdint.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* TODO: Implement scene management */
+/* Children per BVH node */
+#define VE_BVH_WIDTH 4
+
+/* Never a live proxy */
+#define VE_BVH_INVALID UINT32_MAX
+
+/* Proxies rebuilt by ve_scene_update per frame */
+#define VE_SCENE_REBUILD_BUDGET 4096
+
+/* Levels of detail per node, matching VE_MESH_MAX_LODS */
+#define VE_SCENE_MAX_LODS 8
+
+/* Views that keep their own level of detail history per node */
+#define VE_SCENE_LOD_VIEWS 4
+
+/* Fraction below the threshold an error must drop to before a coarser level is chosen */
+#define VE_SCENE_LOD_HYSTERESIS 0.25f
+
+/**
+ * @brief Bounding volume hierarchy over boxes
+ */
+typedef struct ve_bvh ve_bvh;
+
+/**
+ * @brief Closest ray hit
+ */
+typedef struct ve_bvh_hit {
+    uint32_t proxy;
+    uint32_t user;
+    float distance;             /* Along the direction, in its units */
+} ve_bvh_hit;
+
+/**
+ * @brief Exact ray test against a proxy whose box the ray hits
+ *
+ * @param user User value of the proxy
+ * @param origin Ray origin
+ * @param direction Ray direction
+ * @param max_distance Closest hit so far
+ * @param user_data User data passed to ve_bvh_raycast
+ * @return Hit distance, or a negative value for a miss
+ */
+typedef float (*ve_bvh_ray_fn)(uint32_t user, ve_vec3 origin, ve_vec3 direction, float max_distance,
+                               void* user_data);
+
+/**
+ * @brief Create an empty BVH
+ *
+ * @return BVH, or NULL if out of memory
+ */
+ve_bvh* ve_bvh_create(void);
+
+/**
+ * @brief Destroy a BVH
+ *
+ * @param bvh BVH
+ */
+void ve_bvh_destroy(ve_bvh* bvh);
+
+/**
+ * @brief Add a box
+ *
+ * @param bvh BVH
+ * @param bounds Box
+ * @param user Value reported by queries
+ * @return Proxy, or VE_BVH_INVALID if out of memory
+ */
+uint32_t ve_bvh_insert(ve_bvh* bvh, const ve_aabb* bounds, uint32_t user);
+
+/**
+ * @brief Remove a box
+ *
+ * @param bvh BVH
+ * @param proxy Live proxy
+ */
+void ve_bvh_remove(ve_bvh* bvh, uint32_t proxy);
+
+/**
+ * @brief Move a box, refitting its ancestors
+ *
+ * @param bvh BVH
+ * @param proxy Live proxy
+ * @param bounds New box
+ */
+void ve_bvh_move(ve_bvh* bvh, uint32_t proxy, const ve_aabb* bounds);
+
+/**
+ * @brief Get the box of a proxy
+ *
+ * @param bvh BVH
+ * @param proxy Live proxy
+ * @return Box
+ */
+const ve_aabb* ve_bvh_get_bounds(const ve_bvh* bvh, uint32_t proxy);
+
+/**
+ * @brief Get the user value of a proxy
+ *
+ * @param bvh BVH
+ * @param proxy Live proxy
+ * @return User value
+ */
+uint32_t ve_bvh_get_user(const ve_bvh* bvh, uint32_t proxy);
+
+/**
+ * @brief Get the number of proxies
+ *
+ * @param bvh BVH
+ * @return Proxy count
+ */
+uint32_t ve_bvh_get_count(const ve_bvh* bvh);
+
+/**
+ * @brief Rebuild the most changed subtree with at most max_proxies proxies
+ *
+ * Descends from the root towards the child with the most changes until
+ * the subtree fits the budget, then rebuilds it with the SAH if at least
+ * a quarter of it changed since it was last built.
+ *
+ * @param bvh BVH
+ * @param max_proxies Budget
+ * @return Proxies rebuilt, 0 if no subtree needed it or none fits
+ */
+uint32_t ve_bvh_optimize(ve_bvh* bvh, uint32_t max_proxies);
+
+/**
+ * @brief Rebuild the whole tree with the SAH
+ *
+ * @param bvh BVH
+ */
+void ve_bvh_rebuild(ve_bvh* bvh);
+
+/**
+ * @brief Get the SAH cost of the tree, relative to the root box
+ *
+ * The expected number of nodes and proxies a random ray through the root
+ * box visits; lower is better.
+ *
+ * @param bvh BVH
+ * @return Cost, 0 for an empty tree
+ */
+float ve_bvh_get_sah_cost(const ve_bvh* bvh);
+
+/**
+ * @brief Find the boxes that intersect a frustum
+ *
+ * @param bvh BVH
+ * @param frustum Frustum
+ * @param users Receives the user values of the visible boxes
+ * @param capacity Room in users
+ * @return Number of visible boxes, which may exceed capacity
+ */
+uint32_t ve_bvh_cull_frustum(const ve_bvh* bvh, const ve_frustum* frustum, uint32_t* users, uint32_t capacity);
+
+/**
+ * @brief Cut the tree into subtrees that can be traversed independently
+ *
+ * Expands the root breadth first, one level at a time, until there are at
+ * least min_count subtrees or nothing is left to expand. Together the
+ * subtrees hold every proxy exactly once.
+ *
+ * @param bvh BVH
+ * @param min_count Subtrees wanted, typically a few per worker
+ * @param subtrees Receives the subtrees
+ * @param capacity Room in subtrees, never exceeded
+ * @return Number of subtrees, 0 for an empty tree
+ */
+uint32_t ve_bvh_get_subtrees(const ve_bvh* bvh, uint32_t min_count, uint32_t* subtrees, uint32_t capacity);
+
+/**
+ * @brief Get the number of proxies below a subtree
+ *
+ * @param bvh BVH
+ * @param subtree Subtree from ve_bvh_get_subtrees
+ * @return Proxy count
+ */
+uint32_t ve_bvh_get_subtree_count(const ve_bvh* bvh, uint32_t subtree);
+
+/**
+ * @brief Find the boxes of one subtree that intersect a frustum
+ *
+ * @param bvh BVH
+ * @param subtree Subtree from ve_bvh_get_subtrees
+ * @param frustum Frustum
+ * @param users Receives the user values of the visible boxes
+ * @param capacity Room in users
+ * @return Number of visible boxes, which may exceed capacity
+ */
+uint32_t ve_bvh_cull_frustum_subtree(const ve_bvh* bvh, uint32_t subtree, const ve_frustum* frustum,
+                                     uint32_t* users, uint32_t capacity);
+
+/**
+ * @brief Find the boxes that overlap a box
+ *
+ * @param bvh BVH
+ * @param bounds Query box
+ * @param users Receives the user values of the overlapping boxes
+ * @param capacity Room in users
+ * @return Number of overlapping boxes, which may exceed capacity
+ */
+uint32_t ve_bvh_query_aabb(const ve_bvh* bvh, const ve_aabb* bounds, uint32_t* users, uint32_t capacity);
+
+/**
+ * @brief Find the closest box along a ray
+ *
+ * Children are visited front to back and subtrees beyond the closest hit
+ * so far are skipped.
+ *
+ * @param bvh BVH
+ * @param origin Ray origin
+ * @param direction Ray direction, need not be unit length
+ * @param max_distance Farthest hit to accept
+ * @param fn Exact test for proxies whose box is hit (NULL accepts the box hit)
+ * @param user_data User data for fn
+ * @param hit Closest hit
+ * @return true if something was hit
+ */
+bool ve_bvh_raycast(const ve_bvh* bvh, ve_vec3 origin, ve_vec3 direction, float max_distance, ve_bvh_ray_fn fn,
+                    void* user_data, ve_bvh_hit* hit);
+
+/**
+ * @brief Scene
+ */
+typedef struct ve_scene ve_scene;
+
+/**
+ * @brief Create an empty scene
+ *
+ * @return Scene, or NULL if out of memory
+ */
+ve_scene* ve_scene_create(void);
+
+/**
+ * @brief Destroy a scene and all of its nodes
+ *
+ * @param scene Scene
+ */
+void ve_scene_destroy(ve_scene* scene);
+
+/**
+ * @brief Get the node hierarchy of a scene
+ *
+ * @param scene Scene
+ * @return Node graph, owned by the scene
+ */
+ve_node_graph* ve_scene_get_nodes(ve_scene* scene);
+
+/**
+ * @brief Get the spatial index of a scene
+ *
+ * The user value of every proxy is the node handle. Only valid after
+ * ve_scene_update; do not insert into or remove from it directly.
+ *
+ * @param scene Scene
+ * @return BVH, owned by the scene
+ */
+const ve_bvh* ve_scene_get_bvh(const ve_scene* scene);
+
+/**
+ * @brief Give a node bounds, adding it to the spatial index
+ *
+ * @param scene Scene
+ * @param node Live node
+ * @param local_bounds Box in the node's local space
+ * @return false if out of memory
+ */
+bool ve_scene_set_bounds(ve_scene* scene, ve_node node, const ve_aabb* local_bounds);
+
+/**
+ * @brief Set the state a node is drawn with
+ *
+ * Cameras sort their visible lists by these. Nodes start with 0 for both.
+ *
+ * @param scene Scene
+ * @param node Node with bounds
+ * @param pipeline Pipeline ID
+ * @param material Material ID
+ */
+void ve_scene_set_render(ve_scene* scene, ve_node node, uint32_t pipeline, uint32_t material);
+
+/**
+ * @brief Get the state a node is drawn with
+ *
+ * Safe to call from several threads while nothing modifies the scene.
+ *
+ * @param scene Scene
+ * @param node Node
+ * @param pipeline Receives the pipeline ID
+ * @param material Receives the material ID
+ * @return false if the node has no bounds
+ */
+bool ve_scene_get_render(const ve_scene* scene, ve_node node, uint32_t* pipeline, uint32_t* material);
+
+/**
+ * @brief Set what a node draws and where its instance data lives
+ *
+ * Visible instances sharing a mesh are merged into instanced draws (see
+ * ve_camera_build_draws). Nodes start with 0 for both.
+ *
+ * @param scene Scene
+ * @param node Node with bounds
+ * @param mesh Mesh ID
+ * @param instance Slot of the node's transform and material in the instance buffer (see renderer/instancing.h)
+ */
+void ve_scene_set_instance(ve_scene* scene, ve_node node, uint32_t mesh, uint32_t instance);
+
+/**
+ * @brief Get what a node draws and where its instance data lives
+ *
+ * Safe to call from several threads while nothing modifies the scene.
+ *
+ * @param scene Scene
+ * @param node Node
+ * @param mesh Receives the mesh ID
+ * @param instance Receives the instance slot
+ * @return false if the node has no bounds
+ */
+bool ve_scene_get_instance(const ve_scene* scene, ve_node node, uint32_t* mesh, uint32_t* instance);
+
+/**
+ * @brief Give a node levels of detail
+ *
+ * @param scene Scene
+ * @param node Node with bounds
+ * @param errors Geometric error of each level in the node's local units, finest first and
+ *               non-decreasing, as in ve_mesh_lod
+ * @param count Number of levels, at most VE_SCENE_MAX_LODS; 0 removes them
+ */
+void ve_scene_set_lods(ve_scene* scene, ve_node node, const float* errors, uint32_t count);
+
+/**
+ * @brief Pick the level of detail a view draws a node with
+ *
+ * Chooses the coarsest level whose error times error_scale is within the
+ * threshold. Moving to a coarser level than the view's last choice needs
+ * the error to be within threshold * (1 - VE_SCENE_LOD_HYSTERESIS), so a
+ * node hovering near a boundary does not alternate between levels.
+ *
+ * Each view remembers its last choice per node. Different views may
+ * select concurrently while nothing else modifies the scene; one view
+ * must not.
+ *
+ * @param scene Scene
+ * @param node Node
+ * @param view View index, below VE_SCENE_LOD_VIEWS
+ * @param error_scale Converts local errors to the threshold's units
+ * @param threshold Largest scaled error to accept
+ * @return Level index, 0 for nodes without levels
+ */
+uint32_t ve_scene_select_lod(ve_scene* scene, ve_node node, uint32_t view, float error_scale, float threshold);
+
+/**
+ * @brief Remove a node from the spatial index
+ *
+ * Destroyed nodes are removed by ve_scene_update.
+ *
+ * @param scene Scene
+ * @param node Node
+ */
+void ve_scene_clear_bounds(ve_scene* scene, ve_node node);
+
+/**
+ * @brief Bring world transforms and the spatial index up to date
+ *
+ * Refits the boxes of nodes whose world matrix changed, drops destroyed
+ * nodes, and spends up to VE_SCENE_REBUILD_BUDGET proxies on
+ * ve_bvh_optimize.
+ *
+ * @param scene Scene
+ * @param pool Pool to spread the work across (NULL runs on the calling thread)
+ * @return false if out of memory
+ */
+bool ve_scene_update(ve_scene* scene, ve_thread_pool* pool);
 
 #ifdef __cplusplus
 }
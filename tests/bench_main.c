@@ -0,0 +1,545 @@
+/**
+ * @file bench_main.c
+ * @brief Microbenchmark entry point
+ *
+ *   vulkan_engine_bench [-o results.json] [-f filter] [-s samples] [-t threads]
+ *                       [-b baseline.json] [-r percent]
+ *
+ * Every benchmark times a batch of operations per sample and reports the
+ * distribution of the per-operation time over the samples, in nanoseconds.
+ * Results are printed and written as JSON. Given a baseline written by an
+ * earlier run, each benchmark's median is compared with the baseline's and
+ * the run fails if one is slower by more than the threshold.
+ */
+
+#include "core/logger.h"
+#include "core/memory.h"
+#include "core/thread.h"
+#include "core/timer.h"
+#include "core/benchmark.h"
+#include "ecs/ecs.h"
+#include "ecs/components.h"
+#include "platform/platform.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_DEFAULT_SAMPLES 100
+#define BENCH_MAX_SAMPLES 10000
+#define BENCH_MAX_RESULTS 64
+#define BENCH_MAX_NAME 64
+#define BENCH_DEFAULT_THRESHOLD 10.0
+
+/* Operations per sample */
+#define BENCH_BATCH 1000
+
+/* Entities iterated by the ECS benchmarks */
+#define BENCH_ECS_ENTITIES 100000
+
+typedef struct bench_result {
+    char name[BENCH_MAX_NAME];
+    uint32_t samples;
+    uint32_t operations;            /* Per sample */
+    double min;
+    double mean;
+    double p50;
+    double p90;
+    double p99;
+    double max;
+} bench_result;
+
+typedef struct bench_options {
+    const char* output;
+    const char* filter;
+    const char* baseline;
+    uint32_t samples;
+    uint32_t max_threads;
+    double threshold;               /* Percent */
+} bench_options;
+
+/* Runs one sample of operations */
+typedef void (*bench_fn)(void* user_data, uint32_t operations);
+
+typedef struct bench_case {
+    const char* name;
+    void (*run)(const bench_options* options);
+} bench_case;
+
+static bench_result g_results[BENCH_MAX_RESULTS];
+static uint32_t g_result_count;
+static double g_sample_times[BENCH_MAX_SAMPLES];
+
+static void print_usage(void) {
+    fprintf(stderr,
+            "Usage: vulkan_engine_bench [options]\n"
+            "  -o <path>    Write results as JSON\n"
+            "  -f <text>    Only run benchmarks whose name contains text\n"
+            "  -s <count>   Samples per benchmark (default %d)\n"
+            "  -t <count>   Most thread pool workers to measure (default: logical CPUs)\n"
+            "  -b <path>    Baseline JSON to compare medians with\n"
+            "  -r <percent> Slowdown over the baseline that fails the run (default %.0f)\n",
+            BENCH_DEFAULT_SAMPLES, BENCH_DEFAULT_THRESHOLD);
+}
+
+static bool bench_selected(const bench_options* options, const char* name) {
+    return !options->filter || strstr(name, options->filter) != NULL;
+}
+
+/* Time samples of the function after one untimed warm-up sample, and record the distribution */
+static void bench_measure(const bench_options* options, const char* name, bench_fn fn, void* user_data,
+                          uint32_t operations) {
+    if (!bench_selected(options, name) || g_result_count == BENCH_MAX_RESULTS) {
+        return;
+    }
+
+    fn(user_data, operations);
+    for (uint32_t i = 0; i < options->samples; i++) {
+        ve_timestamp start = ve_timer_now();
+        fn(user_data, operations);
+        g_sample_times[i] = ve_timer_elapsed(start, ve_timer_now()) * 1e9 / operations;
+    }
+    ve_benchmark_sort(g_sample_times, options->samples);
+
+    bench_result* result = &g_results[g_result_count++];
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    result->samples = options->samples;
+    result->operations = operations;
+    result->min = g_sample_times[0];
+    result->max = g_sample_times[options->samples - 1];
+    result->p50 = ve_benchmark_percentile(g_sample_times, options->samples, 0.50);
+    result->p90 = ve_benchmark_percentile(g_sample_times, options->samples, 0.90);
+    result->p99 = ve_benchmark_percentile(g_sample_times, options->samples, 0.99);
+
+    double sum = 0.0;
+    for (uint32_t i = 0; i < options->samples; i++) {
+        sum += g_sample_times[i];
+    }
+    result->mean = sum / options->samples;
+
+    printf("%-36s p50 %10.1f  p90 %10.1f  p99 %10.1f  ns/op\n", result->name, result->p50, result->p90, result->p99);
+}
+
+/* General purpose allocator */
+
+static void* g_allocations[BENCH_BATCH];
+
+static void allocate_free_sample(void* user_data, uint32_t operations) {
+    size_t size = (size_t)(uintptr_t)user_data;
+    for (uint32_t i = 0; i < operations; i++) {
+        g_allocations[i] = ve_allocate(size, VE_MEMORY_TAG_APPLICATION);
+    }
+    for (uint32_t i = 0; i < operations; i++) {
+        ve_free(g_allocations[i]);
+    }
+}
+
+static void bench_allocate(const bench_options* options) {
+    static const size_t sizes[] = {16, 64, 256, 4096, 65536};
+    for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        char name[BENCH_MAX_NAME];
+        snprintf(name, sizeof(name), "allocate_free/%zu", sizes[i]);
+        bench_measure(options, name, allocate_free_sample, (void*)(uintptr_t)sizes[i], BENCH_BATCH);
+    }
+}
+
+/* Arena */
+
+typedef struct arena_bench {
+    ve_arena* arena;
+    size_t size;
+} arena_bench;
+
+static void arena_allocate_sample(void* user_data, uint32_t operations) {
+    arena_bench* bench = (arena_bench*)user_data;
+    for (uint32_t i = 0; i < operations; i++) {
+        g_allocations[i] = ve_arena_allocate(bench->arena, bench->size);
+    }
+    ve_arena_reset(bench->arena);
+}
+
+static void bench_arena(const bench_options* options) {
+    static const size_t sizes[] = {16, 64, 256};
+    for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        arena_bench bench = {
+            .arena = ve_arena_create(BENCH_BATCH * (sizes[i] + 16), 16, NULL),
+            .size = sizes[i],
+        };
+        if (!bench.arena) {
+            fprintf(stderr, "Failed to create arena\n");
+            return;
+        }
+
+        char name[BENCH_MAX_NAME];
+        snprintf(name, sizeof(name), "arena_allocate/%zu", sizes[i]);
+        bench_measure(options, name, arena_allocate_sample, &bench, BENCH_BATCH);
+        ve_arena_destroy(bench.arena);
+    }
+}
+
+/* Pool */
+
+static void pool_allocate_free_sample(void* user_data, uint32_t operations) {
+    ve_pool* pool = (ve_pool*)user_data;
+    for (uint32_t i = 0; i < operations; i++) {
+        g_allocations[i] = ve_pool_allocate(pool);
+    }
+    for (uint32_t i = 0; i < operations; i++) {
+        ve_pool_free(pool, g_allocations[i]);
+    }
+}
+
+static void bench_pool(const bench_options* options) {
+    ve_pool* pool = ve_pool_create(64, BENCH_BATCH);
+    if (!pool) {
+        fprintf(stderr, "Failed to create pool\n");
+        return;
+    }
+    bench_measure(options, "pool_allocate_free/64", pool_allocate_free_sample, pool, BENCH_BATCH);
+    ve_pool_destroy(pool);
+}
+
+/* Thread pool */
+
+static ve_atomic_int32 g_task_runs;
+
+static void counting_task(void* user_data) {
+    (void)user_data;
+    ve_atomic_increment32(&g_task_runs);
+}
+
+static void submit_wait_sample(void* user_data, uint32_t operations) {
+    ve_thread_pool* pool = (ve_thread_pool*)user_data;
+    for (uint32_t i = 0; i < operations; i++) {
+        while (!ve_thread_pool_submit(pool, counting_task, NULL)) {
+            ve_thread_yield();
+        }
+    }
+    ve_thread_pool_wait(pool);
+}
+
+static void bench_thread_pool(const bench_options* options) {
+    /* Powers of two, then the full machine */
+    uint32_t threads = 1;
+    for (;;) {
+        char name[BENCH_MAX_NAME];
+        snprintf(name, sizeof(name), "thread_pool_submit_wait/%u", threads);
+        if (bench_selected(options, name)) {
+            ve_thread_pool* pool = ve_thread_pool_create(threads);
+            if (!pool) {
+                fprintf(stderr, "Failed to create a thread pool with %u workers\n", threads);
+                return;
+            }
+            bench_measure(options, name, submit_wait_sample, pool, BENCH_BATCH);
+            ve_thread_pool_destroy(pool);
+        }
+
+        if (threads >= options->max_threads) {
+            break;
+        }
+        threads = threads * 2 < options->max_threads ? threads * 2 : options->max_threads;
+    }
+}
+
+/* Logger */
+
+#define BENCH_LOG_PATH "ve_bench.log"
+
+static void log_sample(void* user_data, uint32_t operations) {
+    (void)user_data;
+    for (uint32_t i = 0; i < operations; i++) {
+        VE_LOG_INFO("Benchmark message %u with a float %.3f and a string %s", i, i * 0.5, "payload");
+    }
+}
+
+static void bench_logger_mode(const bench_options* options, const char* name, bool async, bool deferred) {
+    if (!bench_selected(options, name)) {
+        return;
+    }
+
+    ve_logger_config config = {
+        .level = VE_LOG_INFO,
+        .targets = VE_LOG_TARGET_FILE,
+        .file_pattern = BENCH_LOG_PATH,
+        .timestamps = true,
+        .async = async,
+        .deferred_format = deferred,
+    };
+    ve_logger_shutdown();
+    remove(BENCH_LOG_PATH);
+    if (!ve_logger_init(&config)) {
+        fprintf(stderr, "Failed to initialize the logger\n");
+        return;
+    }
+    bench_measure(options, name, log_sample, NULL, BENCH_BATCH);
+    ve_logger_shutdown();
+    remove(BENCH_LOG_PATH);
+}
+
+static void bench_logger(const bench_options* options) {
+    bench_logger_mode(options, "log/sync", false, false);
+    bench_logger_mode(options, "log/async", true, false);
+    bench_logger_mode(options, "log/async_deferred", true, true);
+
+    ve_logger_config console = {
+        .level = VE_LOG_WARN,
+        .targets = VE_LOG_TARGET_CONSOLE,
+        .color_output = true,
+    };
+    ve_logger_init(&console);
+}
+
+/* ECS */
+
+static void ecs_read_sample(void* user_data, uint32_t operations) {
+    (void)operations;
+    ve_world* world = (ve_world*)user_data;
+    ve_query query = {.all = VE_COMPONENT_BIT(VE_COMPONENT_TRANSFORM) | VE_COMPONENT_BIT(VE_COMPONENT_BOUNDS)};
+
+    float sum = 0.0f;
+    ve_query_iter iter;
+    ve_query_iter_init(&iter, world, &query);
+    while (ve_query_next(&iter)) {
+        const ve_bounds_component* bounds = (const ve_bounds_component*)ve_query_column(&iter, VE_COMPONENT_BOUNDS);
+        for (uint32_t i = 0; i < iter.count; i++) {
+            sum += bounds[i].radius;
+        }
+    }
+
+    /* Keep the loop from being optimized out */
+    volatile float sink = sum;
+    (void)sink;
+}
+
+static void ecs_write_sample(void* user_data, uint32_t operations) {
+    (void)operations;
+    ve_world* world = (ve_world*)user_data;
+    ve_query query = {.all = VE_COMPONENT_BIT(VE_COMPONENT_TRANSFORM) | VE_COMPONENT_BIT(VE_COMPONENT_BOUNDS)};
+
+    ve_query_iter iter;
+    ve_query_iter_init(&iter, world, &query);
+    while (ve_query_next(&iter)) {
+        const ve_transform_component* transforms =
+            (const ve_transform_component*)ve_query_column(&iter, VE_COMPONENT_TRANSFORM);
+        ve_bounds_component* bounds = (ve_bounds_component*)ve_query_column_write(&iter, VE_COMPONENT_BOUNDS);
+        for (uint32_t i = 0; i < iter.count; i++) {
+            bounds[i].center[0] = transforms[i].position[0];
+            bounds[i].center[1] = transforms[i].position[1];
+            bounds[i].center[2] = transforms[i].position[2];
+        }
+    }
+}
+
+static void bench_ecs(const bench_options* options) {
+    if (!bench_selected(options, "ecs_iterate_read") && !bench_selected(options, "ecs_iterate_write")) {
+        return;
+    }
+
+    ve_world* world = ve_world_create();
+    if (!world || !ve_components_register(world)) {
+        fprintf(stderr, "Failed to create the ECS world\n");
+        ve_world_destroy(world);
+        return;
+    }
+
+    ve_component_mask mask = VE_COMPONENT_BIT(VE_COMPONENT_TRANSFORM) | VE_COMPONENT_BIT(VE_COMPONENT_BOUNDS);
+    for (uint32_t i = 0; i < BENCH_ECS_ENTITIES; i++) {
+        ve_entity entity = ve_ecs_create_entity_with(world, mask);
+        ve_transform_component* transform =
+            (ve_transform_component*)ve_ecs_get_component(world, entity, VE_COMPONENT_TRANSFORM);
+        ve_bounds_component* bounds = (ve_bounds_component*)ve_ecs_get_component(world, entity, VE_COMPONENT_BOUNDS);
+        if (!transform || !bounds) {
+            fprintf(stderr, "Failed to create ECS entities\n");
+            ve_world_destroy(world);
+            return;
+        }
+        ve_transform_identity(transform);
+        transform->position[0] = (float)i;
+        bounds->radius = 1.0f;
+    }
+
+    bench_measure(options, "ecs_iterate_read", ecs_read_sample, world, BENCH_ECS_ENTITIES);
+    bench_measure(options, "ecs_iterate_write", ecs_write_sample, world, BENCH_ECS_ENTITIES);
+    ve_world_destroy(world);
+}
+
+/* Reporting */
+
+static bool write_results(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Cannot write %s\n", path);
+        return false;
+    }
+
+    const ve_cpu_topology* topology = ve_cpu_get_topology();
+    fprintf(file, "{\n  \"logical_cpus\": %u,\n  \"unit\": \"ns/op\",\n  \"benchmarks\": [\n",
+            topology ? topology->logical_count : 0);
+    for (uint32_t i = 0; i < g_result_count; i++) {
+        const bench_result* result = &g_results[i];
+        fprintf(file,
+                "    {\"name\": \"%s\", \"samples\": %u, \"operations\": %u, \"min\": %.2f, \"mean\": %.2f, "
+                "\"p50\": %.2f, \"p90\": %.2f, \"p99\": %.2f, \"max\": %.2f}%s\n",
+                result->name, result->samples, result->operations, result->min, result->mean, result->p50,
+                result->p90, result->p99, result->max, i + 1 < g_result_count ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+
+    bool ok = ferror(file) == 0;
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        fprintf(stderr, "Failed to write %s\n", path);
+    }
+    return ok;
+}
+
+static char* read_text_file(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+
+    char* text = NULL;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        long size = ftell(file);
+        if (size >= 0 && fseek(file, 0, SEEK_SET) == 0) {
+            text = (char*)VE_ALLOCATE_TAG((size_t)size + 1, VE_MEMORY_TAG_APPLICATION);
+            if (text && fread(text, 1, (size_t)size, file) == (size_t)size) {
+                text[size] = '\0';
+            } else {
+                VE_FREE(text);
+            }
+        }
+    }
+    fclose(file);
+    return text;
+}
+
+/* Find the median of a benchmark in a file written by write_results */
+static bool find_baseline_p50(const char* text, const char* name, double* p50) {
+    char key[BENCH_MAX_NAME + 16];
+    snprintf(key, sizeof(key), "\"name\": \"%s\"", name);
+
+    const char* entry = strstr(text, key);
+    if (!entry) {
+        return false;
+    }
+    const char* end = strchr(entry, '}');
+    const char* value = strstr(entry, "\"p50\":");
+    if (!value || (end && value > end)) {
+        return false;
+    }
+    *p50 = strtod(value + strlen("\"p50\":"), NULL);
+    return *p50 > 0.0;
+}
+
+/* Returns the number of benchmarks slower than the baseline by more than the threshold */
+static int compare_baseline(const bench_options* options) {
+    char* text = read_text_file(options->baseline);
+    if (!text) {
+        fprintf(stderr, "Cannot read baseline %s\n", options->baseline);
+        return -1;
+    }
+
+    printf("\nAgainst %s (p50, +%.0f%% fails):\n", options->baseline, options->threshold);
+    int regressions = 0;
+    for (uint32_t i = 0; i < g_result_count; i++) {
+        const bench_result* result = &g_results[i];
+        double baseline;
+        if (!find_baseline_p50(text, result->name, &baseline)) {
+            printf("%-36s not in baseline\n", result->name);
+            continue;
+        }
+
+        double change = (result->p50 - baseline) / baseline * 100.0;
+        bool regressed = change > options->threshold;
+        printf("%-36s %10.1f -> %10.1f  %+6.1f%%%s\n", result->name, baseline, result->p50, change,
+               regressed ? "  REGRESSION" : "");
+        regressions += regressed;
+    }
+
+    VE_FREE(text);
+    return regressions;
+}
+
+/* Benchmark runner */
+int main(int argc, char* argv[]) {
+    bench_options options = {
+        .samples = BENCH_DEFAULT_SAMPLES,
+        .threshold = BENCH_DEFAULT_THRESHOLD,
+    };
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (arg[0] != '-' || arg[1] == '\0' || arg[2] != '\0' || i + 1 >= argc) {
+            print_usage();
+            return EXIT_FAILURE;
+        }
+
+        const char* value = argv[++i];
+        switch (arg[1]) {
+            case 'o': options.output = value; break;
+            case 'f': options.filter = value; break;
+            case 'b': options.baseline = value; break;
+            case 's': options.samples = (uint32_t)strtoul(value, NULL, 10); break;
+            case 't': options.max_threads = (uint32_t)strtoul(value, NULL, 10); break;
+            case 'r': options.threshold = strtod(value, NULL); break;
+            default:
+                print_usage();
+                return EXIT_FAILURE;
+        }
+    }
+    if (options.samples == 0 || options.samples > BENCH_MAX_SAMPLES) {
+        fprintf(stderr, "Samples must be between 1 and %d\n", BENCH_MAX_SAMPLES);
+        return EXIT_FAILURE;
+    }
+
+    if (!ve_memory_init()) {
+        fprintf(stderr, "Failed to initialize memory system\n");
+        return EXIT_FAILURE;
+    }
+    ve_logger_config logger_config = {
+        .level = VE_LOG_WARN,
+        .targets = VE_LOG_TARGET_CONSOLE,
+        .color_output = true,
+    };
+    ve_logger_init(&logger_config);
+    ve_timer_init();
+
+    if (options.max_threads == 0) {
+        const ve_cpu_topology* topology = ve_cpu_get_topology();
+        options.max_threads = topology && topology->logical_count > 0 ? topology->logical_count : 1;
+    }
+
+    bench_case benches[] = {
+        {"allocate", bench_allocate},
+        {"arena", bench_arena},
+        {"pool", bench_pool},
+        {"thread_pool", bench_thread_pool},
+        {"logger", bench_logger},
+        {"ecs", bench_ecs},
+    };
+
+    printf("=== Running Benchmarks (%u samples) ===\n", options.samples);
+    for (uint32_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+        benches[i].run(&options);
+    }
+
+    int status = EXIT_SUCCESS;
+    if (options.output && !write_results(options.output)) {
+        status = EXIT_FAILURE;
+    }
+    if (options.baseline) {
+        int regressions = compare_baseline(&options);
+        if (regressions != 0) {
+            status = EXIT_FAILURE;
+        }
+        if (regressions > 0) {
+            printf("%d benchmark(s) regressed\n", regressions);
+        }
+    }
+
+    ve_timer_shutdown();
+    ve_logger_shutdown();
+    ve_memory_shutdown();
+    return status;
+}
@@ -6,7 +6,31 @@
 #include "core/logger.h"
 #include "core/memory.h"
 #include "core/assert.h"
+#include "core/thread.h"
+#include "core/profiler.h"
+#include "core/latency.h"
+#include "core/queue.h"
+#include "core/frame_pipeline.h"
+#include "core/benchmark.h"
+#include "core/telemetry.h"
+#include "core/init_graph.h"
+#include "assets/model_loader.h"
+#include "ecs/ecs.h"
+#include "ecs/components.h"
+#include "ecs/systems.h"
+#include "math/simd.h"
+#include "scene/scene.h"
+#include "scene/camera.h"
+#include "scene/camera_path.h"
+#include "assets/asset_manager.h"
+#include "assets/pak.h"
+#include "assets/texture_loader.h"
+#include "platform/platform.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
 
 /* Simple test framework */
 #define TEST_ASSERT(condition) \
@@ -26,8 +50,41 @@ typedef struct {
 
 /* External test functions */
 bool test_memory_arena(void);
+bool test_memory_arena_growable(void);
+bool test_frame_allocator(void);
 bool test_memory_pool(void);
+bool test_thread_pool(void);
+bool test_parallel_for(void);
+bool test_thread_placement(void);
+bool test_sync_primitives(void);
+bool test_lockfree_queues(void);
+bool test_frame_pipeline(void);
+bool test_memory_stats_threaded(void);
+bool test_memory_size_classes(void);
+bool test_memory_external(void);
+bool test_concurrent_pool(void);
+bool test_logger_async(void);
+bool test_logger_deferred(void);
+bool test_profiler(void);
+bool test_frame_latency(void);
+bool test_benchmark_stats(void);
+bool test_telemetry(void);
+bool test_init_graph(void);
 bool test_ecs_basic(void);
+bool test_ecs_scheduler(void);
+bool test_ecs_change_versions(void);
+bool test_simd_kernels(void);
+bool test_meshlet_build(void);
+bool test_mesh_optimization(void);
+bool test_mesh_lod(void);
+bool test_scene_graph(void);
+bool test_scene_bvh(void);
+bool test_camera_visibility(void);
+bool test_camera_path(void);
+bool test_asset_streaming(void);
+bool test_file_io(void);
+bool test_pak_archive(void);
+bool test_texture_compression(void);
 
 /* Test implementations */
 
@@ -52,6 +109,103 @@ bool test_memory_arena(void) {
     return true;
 }
 
+static bool check_growable_arena(ve_arena* arena) {
+    TEST_ASSERT(arena != NULL);
+
+    /* Grow well past the first block / commit */
+    uint8_t* first = (uint8_t*)ve_arena_allocate(arena, 1000);
+    TEST_ASSERT(first != NULL);
+    memset(first, 0xAB, 1000);
+
+    size_t mark = ve_arena_get_position(arena);
+    for (int i = 0; i < 64; i++) {
+        uint8_t* ptr = (uint8_t*)ve_arena_allocate(arena, 16 * 1024);
+        TEST_ASSERT(ptr != NULL);
+        TEST_ASSERT(ve_is_aligned(ptr, 16));
+        memset(ptr, i, 16 * 1024);
+    }
+    void* big = ve_arena_allocate(arena, 512 * 1024);
+    TEST_ASSERT(big != NULL);
+    memset(big, 0xCD, 512 * 1024);
+    TEST_ASSERT(first[999] == 0xAB);
+
+    size_t high_water = ve_arena_get_high_water_mark(arena);
+    TEST_ASSERT(high_water >= 1000 + 64 * 16 * 1024 + 512 * 1024);
+
+    /* Rolling back keeps earlier allocations and lets the space be reused */
+    ve_arena_set_position(arena, mark);
+    TEST_ASSERT(ve_arena_get_usage(arena) == mark);
+    TEST_ASSERT(first[0] == 0xAB);
+    TEST_ASSERT(ve_arena_allocate(arena, 64) != NULL);
+
+    ve_arena_reset(arena);
+    TEST_ASSERT(ve_arena_get_usage(arena) == 0);
+    TEST_ASSERT(ve_arena_get_high_water_mark(arena) == high_water);
+
+    /* After a reset the previous peak fits again */
+    void* again = ve_arena_allocate(arena, 1024 * 1024);
+    TEST_ASSERT(again != NULL);
+    memset(again, 0, 1024 * 1024);
+
+    ve_arena_destroy(arena);
+    return true;
+}
+
+bool test_memory_arena_growable(void) {
+    printf("Running test_memory_arena_growable...\n");
+
+    TEST_ASSERT(check_growable_arena(ve_arena_create_growable(64 * 1024 * 1024, 16, VE_ARENA_FLAG_NONE)));
+    TEST_ASSERT(check_growable_arena(ve_arena_create_growable(64 * 1024 * 1024, 16, VE_ARENA_FLAG_DECOMMIT_ON_RESET)));
+    TEST_ASSERT(check_growable_arena(ve_arena_create_growable(0, 16, VE_ARENA_FLAG_CHAINED)));
+    TEST_ASSERT(check_growable_arena(ve_arena_create_growable(0, 16, VE_ARENA_FLAG_CHAINED | VE_ARENA_FLAG_DECOMMIT_ON_RESET)));
+
+    /* Exhausting a virtual reservation fails instead of overrunning it */
+    ve_arena* small = ve_arena_create_growable(128 * 1024, 16, VE_ARENA_FLAG_NONE);
+    TEST_ASSERT(small != NULL);
+    if (small->kind == VE_ARENA_KIND_VIRTUAL) {
+        TEST_ASSERT(ve_arena_allocate(small, 100 * 1024) != NULL);
+        TEST_ASSERT(ve_arena_allocate(small, 100 * 1024) == NULL);
+    }
+    ve_arena_destroy(small);
+
+    return true;
+}
+
+bool test_frame_allocator(void) {
+    printf("Running test_frame_allocator...\n");
+
+    TEST_ASSERT(ve_frame_allocator_init(3, 16 * 1024 * 1024));
+
+    /* Frame 0 and 1 data must survive while the other slots are in use */
+    ve_frame_allocator_begin(0);
+    uint32_t* frame0 = (uint32_t*)ve_frame_allocate(sizeof(uint32_t) * 256);
+    TEST_ASSERT(frame0 != NULL);
+    frame0[255] = 0xF00D;
+
+    ve_frame_allocator_begin(1);
+    uint32_t* frame1 = (uint32_t*)ve_frame_allocate(sizeof(uint32_t) * 256);
+    TEST_ASSERT(frame1 != NULL);
+    frame1[0] = 0xBEEF;
+
+    ve_frame_allocator_begin(2);
+    TEST_ASSERT(ve_frame_allocate(1024 * 1024) != NULL);
+    TEST_ASSERT(frame0[255] == 0xF00D);
+    TEST_ASSERT(frame1[0] == 0xBEEF);
+    TEST_ASSERT(ve_arena_get_usage(ve_frame_allocator_get_arena(2)) >= 1024 * 1024);
+
+    /* Beginning a slot again recycles only that slot */
+    ve_frame_allocator_begin(0);
+    TEST_ASSERT(ve_arena_get_usage(ve_frame_allocator_get_arena(0)) == 0);
+    TEST_ASSERT(ve_arena_get_usage(ve_frame_allocator_get_arena(1)) > 0);
+    TEST_ASSERT(ve_frame_allocate(64) == (void*)frame0);
+
+    TEST_ASSERT(ve_frame_allocator_get_arena(3) == NULL);
+
+    ve_frame_allocator_shutdown();
+    TEST_ASSERT(ve_frame_allocate(64) == NULL);
+    return true;
+}
+
 bool test_memory_pool(void) {
     printf("Running test_memory_pool...\n");
 
@@ -73,9 +227,3114 @@ bool test_memory_pool(void) {
     return true;
 }
 
-bool test_ecs_basic(void) {
-    printf("Running test_ecs_basic...\n");
-    /* TODO: Implement ECS tests */
+static void increment_task(void* user_data) {
+    ve_atomic_increment32((ve_atomic_int32*)user_data);
+}
+
+/* Long enough for a worker to pick the task up before the submitting thread steals it */
+static void slow_increment_task(void* user_data) {
+    ve_thread_sleep_ms(1);
+    ve_atomic_increment32((ve_atomic_int32*)user_data);
+}
+
+static void check_dependency_task(void* user_data) {
+    /* Runs after all increments; records whether it saw every one of them */
+    ve_atomic_int32* values = (ve_atomic_int32*)user_data;
+    ve_atomic_store32(&values[1], ve_atomic_load32(&values[0]));
+}
+
+bool test_thread_pool(void) {
+    printf("Running test_thread_pool...\n");
+
+    ve_thread_pool* pool = ve_thread_pool_create(4);
+    TEST_ASSERT(pool != NULL);
+    TEST_ASSERT(ve_thread_pool_get_thread_count(pool) == 4);
+
+    ve_atomic_int32 value = {0};
+    for (int i = 0; i < 10000; i++) {
+        TEST_ASSERT(ve_thread_pool_submit(pool, increment_task, &value));
+    }
+    ve_thread_pool_wait(pool);
+    TEST_ASSERT(ve_atomic_load32(&value) == 10000);
+    TEST_ASSERT(ve_thread_pool_get_pending_count(pool) == 0);
+
+    ve_atomic_int32 values[2] = {{0}, {0}};
+    ve_job_counter increments;
+    ve_job_counter done;
+    ve_job_counter_init(&increments);
+    ve_job_counter_init(&done);
+
+    for (int i = 0; i < 1000; i++) {
+        TEST_ASSERT(ve_thread_pool_submit_job(pool, increment_task, &values[0], NULL, &increments));
+    }
+    TEST_ASSERT(ve_thread_pool_submit_job(pool, check_dependency_task, values, &increments, &done));
+    ve_thread_pool_wait_counter(pool, &done);
+    TEST_ASSERT(ve_job_counter_is_done(&increments));
+    TEST_ASSERT(ve_atomic_load32(&values[1]) == 1000);
+
+    ve_thread_pool_destroy(pool);
+    return true;
+}
+
+static void fill_range(uint32_t begin, uint32_t end, void* user_data) {
+    uint32_t* values = (uint32_t*)user_data;
+    for (uint32_t i = begin; i < end; i++) {
+        values[i] += i;
+    }
+}
+
+bool test_parallel_for(void) {
+    printf("Running test_parallel_for...\n");
+
+    ve_thread_pool* pool = ve_thread_pool_create(4);
+    TEST_ASSERT(pool != NULL);
+
+    enum { COUNT = 100003 };
+    uint32_t* values = (uint32_t*)calloc(COUNT, sizeof(uint32_t));
+    TEST_ASSERT(values != NULL);
+
+    ve_parallel_for(pool, 0, COUNT, 0, fill_range, values);
+    ve_parallel_for(pool, 10, COUNT, 7, fill_range, values);
+
+    for (uint32_t i = 0; i < COUNT; i++) {
+        TEST_ASSERT(values[i] == (i < 10 ? i : 2 * i));
+    }
+
+    ve_task_group group;
+    ve_task_group_init(&group, pool);
+    ve_atomic_int32 value = {0};
+    for (int i = 0; i < 100; i++) {
+        TEST_ASSERT(ve_task_group_run(&group, increment_task, &value));
+    }
+    ve_task_group_wait(&group);
+    TEST_ASSERT(ve_task_group_is_done(&group));
+    TEST_ASSERT(ve_atomic_load32(&value) == 100);
+
+    /* Many short calls, each group freed (or its stack frame gone) the moment its wait returns, while the
+       worker finishing the last task may still be releasing it */
+    for (uint32_t i = 0; i < 200; i++) {
+        ve_parallel_for(pool, 0, 64, 1, fill_range, values);
+
+        ve_task_group* short_group = (ve_task_group*)malloc(sizeof(ve_task_group));
+        TEST_ASSERT(short_group != NULL);
+        ve_task_group_init(short_group, pool);
+        for (uint32_t task = 0; task < 4; task++) {
+            TEST_ASSERT(ve_task_group_run(short_group, task == 0 ? increment_task : slow_increment_task, &value));
+        }
+        ve_task_group_wait(short_group);
+        free(short_group);
+    }
+    for (uint32_t i = 0; i < 64; i++) {
+        TEST_ASSERT(values[i] == (i < 10 ? i : 2 * i) + 200 * i);
+    }
+    TEST_ASSERT(ve_atomic_load32(&value) == 100 + 4 * 200);
+
+    free(values);
+    ve_thread_pool_destroy(pool);
+    return true;
+}
+
+bool test_thread_placement(void) {
+    printf("Running test_thread_placement...\n");
+
+    const ve_cpu_topology* topology = ve_cpu_get_topology();
+    TEST_ASSERT(topology != NULL);
+    TEST_ASSERT(topology->logical_count == ve_cpu_set_count(&topology->online));
+    TEST_ASSERT(topology->logical_count >= 1);
+    TEST_ASSERT(topology->numa_node_count >= 1);
+    TEST_ASSERT(topology->performance_core_count <= topology->core_count);
+    uint32_t first_threads = 0;
+    for (uint32_t cpu = 0; cpu < VE_MAX_CPUS; cpu++) {
+        if (ve_cpu_set_contains(&topology->available, cpu)) {
+            TEST_ASSERT(ve_cpu_set_contains(&topology->online, cpu));
+        }
+        if (ve_cpu_set_contains(&topology->online, cpu)) {
+            TEST_ASSERT(topology->cpus[cpu].core < topology->core_count);
+            TEST_ASSERT(topology->cpus[cpu].numa_node < topology->numa_node_count);
+            first_threads += topology->cpus[cpu].smt_index == 0;
+        }
+    }
+    TEST_ASSERT(first_threads == topology->core_count);
+
+    /* Hybrid two-node layout: P-cores 0-1 with SMT siblings 4-5, E-cores 2-3, node 1 = CPUs 1, 3, 5 */
+    static ve_cpu_topology synthetic;
+    memset(&synthetic, 0, sizeof(synthetic));
+    const ve_logical_cpu layout[6] = {
+        {0, 0, 0, VE_CORE_TYPE_PERFORMANCE}, {1, 1, 0, VE_CORE_TYPE_PERFORMANCE},
+        {2, 0, 0, VE_CORE_TYPE_EFFICIENCY},  {3, 1, 0, VE_CORE_TYPE_EFFICIENCY},
+        {0, 0, 1, VE_CORE_TYPE_PERFORMANCE}, {1, 1, 1, VE_CORE_TYPE_PERFORMANCE},
+    };
+    for (uint32_t cpu = 0; cpu < 6; cpu++) {
+        synthetic.cpus[cpu] = layout[cpu];
+        ve_cpu_set_add(&synthetic.online, cpu);
+        if (cpu != 3) {
+            ve_cpu_set_add(&synthetic.available, cpu);
+        }
+    }
+    synthetic.logical_count = 6;
+    synthetic.core_count = 4;
+    synthetic.performance_core_count = 2;
+    synthetic.numa_node_count = 2;
+    synthetic.hybrid = true;
+
+    uint32_t placement[8];
+    TEST_ASSERT(ve_cpu_get_placement(&synthetic, -1, placement, 8) == 5);
+    const uint32_t expected[5] = {0, 1, 2, 4, 5};
+    for (uint32_t i = 0; i < 5; i++) {
+        TEST_ASSERT(placement[i] == expected[i]);
+    }
+    TEST_ASSERT(ve_cpu_get_placement(&synthetic, 1, placement, 8) == 2);
+    TEST_ASSERT(placement[0] == 1 && placement[1] == 5);
+    TEST_ASSERT(ve_cpu_get_placement(&synthetic, -1, placement, 2) == 2);
+    TEST_ASSERT(placement[0] == 0 && placement[1] == 1);
+
+    /* Affinity round trip on the calling thread */
+    ve_cpu_set original;
+    if (ve_thread_get_affinity(NULL, &original)) {
+        uint32_t cpu = 0;
+        TEST_ASSERT(ve_cpu_get_placement(topology, -1, &cpu, 1) == 1);
+        ve_cpu_set single;
+        ve_cpu_set_clear(&single);
+        ve_cpu_set_add(&single, cpu);
+        TEST_ASSERT(ve_thread_set_affinity(NULL, &single));
+        ve_cpu_set current;
+        TEST_ASSERT(ve_thread_get_affinity(NULL, &current));
+        TEST_ASSERT(ve_cpu_set_count(&current) == 1 && ve_cpu_set_contains(&current, cpu));
+        TEST_ASSERT(ve_thread_set_affinity(NULL, &original));
+    }
+    TEST_ASSERT(ve_thread_set_priority(NULL, VE_THREAD_PRIORITY_NORMAL));
+
+    /* Pinned pool clear of a reserved CPU */
+    ve_thread_pool_config config = {.thread_count = 3, .reserved_cpus = 1, .pin_workers = true};
+    ve_thread_pool* pool = ve_thread_pool_create_with_config(&config);
+    TEST_ASSERT(pool != NULL);
+    TEST_ASSERT(ve_thread_pool_get_thread_count(pool) == 3);
+
+    enum { COUNT = 10007 };
+    uint32_t* values = (uint32_t*)calloc(COUNT, sizeof(uint32_t));
+    TEST_ASSERT(values != NULL);
+    ve_parallel_for(pool, 0, COUNT, 16, fill_range, values);
+    for (uint32_t i = 0; i < COUNT; i++) {
+        TEST_ASSERT(values[i] == i);
+    }
+
+    free(values);
+    ve_thread_pool_destroy(pool);
+    return true;
+}
+
+typedef struct sync_test_state {
+    ve_lock lock;
+    uint32_t counter;               /* Guarded by lock */
+    ve_event start;
+    ve_semaphore* items;
+    ve_atomic_int32 consumed;
+} sync_test_state;
+
+static void* sync_test_thread(void* user_data) {
+    sync_test_state* state = (sync_test_state*)user_data;
+    ve_event_wait(&state->start, UINT32_MAX);
+
+    for (int i = 0; i < 20000; i++) {
+        ve_lock_acquire(&state->lock);
+        state->counter++;
+        ve_lock_release(&state->lock);
+    }
+
+    while (ve_semaphore_wait(state->items, 200)) {
+        ve_atomic_increment32(&state->consumed);
+    }
+    return NULL;
+}
+
+static void* semaphore_signal_thread(void* user_data) {
+    ve_semaphore_signal((ve_semaphore*)user_data);
+    return NULL;
+}
+
+bool test_sync_primitives(void) {
+    printf("Running test_sync_primitives...\n");
+
+    /* Uncontended paths and timeouts */
+    ve_lock lock = VE_LOCK_INIT;
+    TEST_ASSERT(ve_lock_try_acquire(&lock));
+    TEST_ASSERT(!ve_lock_try_acquire(&lock));
+    ve_lock_release(&lock);
+    ve_lock_acquire(&lock);
+    ve_lock_release(&lock);
+    TEST_ASSERT(ve_atomic_load32(&lock.state) == 0);
+
+    ve_atomic_int32 word = {0};
+    TEST_ASSERT(ve_futex_wait(&word, 1, 10));   /* Value differs: returns at once */
+    TEST_ASSERT(!ve_futex_wait(&word, 0, 0));
+
+    ve_event event = VE_EVENT_INIT;
+    TEST_ASSERT(!ve_event_is_set(&event));
+    TEST_ASSERT(!ve_event_wait(&event, 5));
+    ve_event_set(&event);
+    TEST_ASSERT(ve_event_wait(&event, 0) && ve_event_is_set(&event));
+    ve_event_reset(&event);
+    TEST_ASSERT(!ve_event_is_set(&event));
+
+    ve_semaphore* sem = ve_semaphore_create(1, 2);
+    TEST_ASSERT(sem != NULL);
+    TEST_ASSERT(ve_semaphore_signal(sem));
+    TEST_ASSERT(!ve_semaphore_signal(sem));
+    TEST_ASSERT(ve_semaphore_wait(sem, 0) && ve_semaphore_wait(sem, 0));
+    TEST_ASSERT(!ve_semaphore_wait(sem, 0));
+    TEST_ASSERT(!ve_semaphore_wait(sem, 5));
+    ve_semaphore_destroy(sem);
+
+    /* Destroyed as soon as the wait returns, while the signaling thread may still be in signal */
+    for (int i = 0; i < 200; i++) {
+        sem = ve_semaphore_create(0, 1);
+        TEST_ASSERT(sem != NULL);
+        ve_thread* signaler = ve_thread_create(semaphore_signal_thread, sem, "sem_signal");
+        TEST_ASSERT(signaler != NULL);
+        TEST_ASSERT(ve_semaphore_wait(sem, UINT32_MAX));
+        ve_semaphore_destroy(sem);
+        ve_thread_join(signaler);
+    }
+
+    /* Contended: threads released together by an event, hammering one lock, then draining a semaphore */
+    enum { THREADS = 4, ITEMS = 5000 };
+    static sync_test_state state;
+    memset(&state, 0, sizeof(state));
+    state.items = ve_semaphore_create(0, UINT32_MAX);
+    TEST_ASSERT(state.items != NULL);
+
+    ve_thread* threads[THREADS];
+    for (int i = 0; i < THREADS; i++) {
+        threads[i] = ve_thread_create(sync_test_thread, &state, "sync_test");
+        TEST_ASSERT(threads[i] != NULL);
+    }
+    ve_thread_sleep_ms(5);
+    ve_event_set(&state.start);
+
+    for (int i = 0; i < ITEMS; i++) {
+        TEST_ASSERT(ve_semaphore_signal(state.items));
+    }
+    for (int i = 0; i < THREADS; i++) {
+        ve_thread_join(threads[i]);
+    }
+
+    TEST_ASSERT(state.counter == THREADS * 20000);
+    TEST_ASSERT(ve_atomic_load32(&state.consumed) == ITEMS);
+    TEST_ASSERT(!ve_semaphore_wait(state.items, 0));
+    ve_semaphore_destroy(state.items);
+    return true;
+}
+
+enum { QUEUE_TEST_ITEMS = 100000, QUEUE_TEST_THREADS = 4 };
+
+typedef struct queue_test_item {
+    ve_mpsc_node node;
+    uint32_t producer;
+    uint32_t sequence;
+} queue_test_item;
+
+typedef struct queue_test_state {
+    ve_spsc_queue spsc;
+    ve_mpmc_queue mpmc;
+    ve_mpsc_queue mpsc;
+    queue_test_item* items;         /* QUEUE_TEST_THREADS * QUEUE_TEST_ITEMS nodes */
+    ve_atomic_int32 next_producer;
+    ve_atomic_int32 consumed;
+    ve_atomic_int64 sum;
+} queue_test_state;
+
+static void* spsc_test_producer(void* user_data) {
+    queue_test_state* state = (queue_test_state*)user_data;
+    for (uint32_t i = 0; i < QUEUE_TEST_ITEMS; i++) {
+        while (!ve_spsc_queue_push(&state->spsc, &i)) {
+            ve_thread_yield();
+        }
+    }
+    return NULL;
+}
+
+static void* mpmc_test_producer(void* user_data) {
+    queue_test_state* state = (queue_test_state*)user_data;
+    for (uint32_t i = 1; i <= QUEUE_TEST_ITEMS; i++) {
+        while (!ve_mpmc_queue_push(&state->mpmc, &i)) {
+            ve_thread_yield();
+        }
+    }
+    return NULL;
+}
+
+static void* mpmc_test_consumer(void* user_data) {
+    queue_test_state* state = (queue_test_state*)user_data;
+    while (ve_atomic_load32(&state->consumed) < QUEUE_TEST_THREADS * QUEUE_TEST_ITEMS) {
+        uint32_t value;
+        if (ve_mpmc_queue_pop(&state->mpmc, &value)) {
+            ve_atomic_fetch_add64(&state->sum, value);
+            ve_atomic_increment32(&state->consumed);
+        } else {
+            ve_thread_yield();
+        }
+    }
+    return NULL;
+}
+
+static void* mpsc_test_producer(void* user_data) {
+    queue_test_state* state = (queue_test_state*)user_data;
+    uint32_t producer = (uint32_t)ve_atomic_fetch_add32(&state->next_producer, 1);
+    for (uint32_t i = 0; i < QUEUE_TEST_ITEMS; i++) {
+        queue_test_item* item = &state->items[producer * QUEUE_TEST_ITEMS + i];
+        item->producer = producer;
+        item->sequence = i;
+        ve_mpsc_queue_push(&state->mpsc, &item->node);
+    }
+    return NULL;
+}
+
+bool test_lockfree_queues(void) {
+    printf("Running test_lockfree_queues...\n");
+
+    static queue_test_state state;
+    memset(&state, 0, sizeof(state));
+    ve_thread* threads[2 * QUEUE_TEST_THREADS];
+
+    /* SPSC: single-threaded edges, then FIFO order across two threads */
+    TEST_ASSERT(ve_spsc_queue_init(&state.spsc, sizeof(uint32_t), 100));
+    TEST_ASSERT(ve_spsc_queue_get_capacity(&state.spsc) == 128);
+    TEST_ASSERT(ve_spsc_queue_peek(&state.spsc) == NULL);
+    for (uint32_t i = 0; i < 128; i++) {
+        TEST_ASSERT(ve_spsc_queue_push(&state.spsc, &i));
+    }
+    uint32_t value = 1000;
+    TEST_ASSERT(!ve_spsc_queue_push(&state.spsc, &value));
+    TEST_ASSERT(ve_spsc_queue_get_count(&state.spsc) == 128);
+    TEST_ASSERT(*(uint32_t*)ve_spsc_queue_peek(&state.spsc) == 0);
+    TEST_ASSERT(ve_spsc_queue_pop(&state.spsc, NULL));
+    TEST_ASSERT(ve_spsc_queue_push(&state.spsc, &value));
+    for (uint32_t i = 1; i < 128; i++) {
+        TEST_ASSERT(ve_spsc_queue_pop(&state.spsc, &value) && value == i);
+    }
+    TEST_ASSERT(ve_spsc_queue_pop(&state.spsc, &value) && value == 1000);
+    TEST_ASSERT(!ve_spsc_queue_pop(&state.spsc, &value));
+
+    threads[0] = ve_thread_create(spsc_test_producer, &state, "spsc_test");
+    TEST_ASSERT(threads[0] != NULL);
+    for (uint32_t expected = 0; expected < QUEUE_TEST_ITEMS;) {
+        if (ve_spsc_queue_pop(&state.spsc, &value)) {
+            TEST_ASSERT(value == expected);
+            expected++;
+        } else {
+            ve_thread_yield();
+        }
+    }
+    ve_thread_join(threads[0]);
+    ve_spsc_queue_destroy(&state.spsc);
+
+    /* MPMC: every value delivered exactly once */
+    TEST_ASSERT(ve_mpmc_queue_init(&state.mpmc, sizeof(uint32_t), 1));
+    value = 7;
+    TEST_ASSERT(ve_mpmc_queue_push(&state.mpmc, &value) && ve_mpmc_queue_push(&state.mpmc, &value));
+    TEST_ASSERT(!ve_mpmc_queue_push(&state.mpmc, &value));
+    TEST_ASSERT(ve_mpmc_queue_get_count(&state.mpmc) == 2);
+    TEST_ASSERT(ve_mpmc_queue_pop(&state.mpmc, &value) && ve_mpmc_queue_pop(&state.mpmc, &value));
+    TEST_ASSERT(!ve_mpmc_queue_pop(&state.mpmc, &value));
+    ve_mpmc_queue_destroy(&state.mpmc);
+
+    TEST_ASSERT(ve_mpmc_queue_init(&state.mpmc, sizeof(uint32_t), 1024));
+    for (int i = 0; i < QUEUE_TEST_THREADS; i++) {
+        threads[i] = ve_thread_create(mpmc_test_producer, &state, "mpmc_test");
+        threads[QUEUE_TEST_THREADS + i] = ve_thread_create(mpmc_test_consumer, &state, "mpmc_test");
+        TEST_ASSERT(threads[i] != NULL && threads[QUEUE_TEST_THREADS + i] != NULL);
+    }
+    for (int i = 0; i < 2 * QUEUE_TEST_THREADS; i++) {
+        ve_thread_join(threads[i]);
+    }
+    TEST_ASSERT(ve_atomic_load64(&state.sum) ==
+                (int64_t)QUEUE_TEST_THREADS * QUEUE_TEST_ITEMS * (QUEUE_TEST_ITEMS + 1) / 2);
+    TEST_ASSERT(ve_mpmc_queue_get_count(&state.mpmc) == 0);
+    ve_mpmc_queue_destroy(&state.mpmc);
+
+    /* MPSC: popped while producers push, each producer's nodes in its own order */
+    state.items = (queue_test_item*)calloc(QUEUE_TEST_THREADS * QUEUE_TEST_ITEMS, sizeof(queue_test_item));
+    TEST_ASSERT(state.items != NULL);
+    ve_mpsc_queue_init(&state.mpsc);
+    TEST_ASSERT(ve_mpsc_queue_pop(&state.mpsc) == NULL);
+    for (int i = 0; i < QUEUE_TEST_THREADS; i++) {
+        threads[i] = ve_thread_create(mpsc_test_producer, &state, "mpsc_test");
+        TEST_ASSERT(threads[i] != NULL);
+    }
+    uint32_t next[QUEUE_TEST_THREADS] = {0};
+    for (uint32_t popped = 0; popped < QUEUE_TEST_THREADS * QUEUE_TEST_ITEMS;) {
+        ve_mpsc_node* node = ve_mpsc_queue_pop(&state.mpsc);
+        if (!node) {
+            ve_thread_yield();
+            continue;
+        }
+        queue_test_item* item = VE_MPSC_ELEMENT(node, queue_test_item, node);
+        TEST_ASSERT(item->sequence == next[item->producer]);
+        next[item->producer]++;
+        popped++;
+    }
+    for (int i = 0; i < QUEUE_TEST_THREADS; i++) {
+        ve_thread_join(threads[i]);
+    }
+    TEST_ASSERT(ve_mpsc_queue_pop(&state.mpsc) == NULL);
+
+    free(state.items);
+    return true;
+}
+
+typedef struct pipeline_test_state {
+    uint64_t simulation_value;      /* Written by the simulation side, read in prepare */
+    uint64_t prepared_value;        /* Render side only */
+    uint64_t rendered_frames;
+    bool in_order;
+    bool consistent;
+    ve_thread_id render_thread;
+    bool one_render_thread;
+} pipeline_test_state;
+
+static void pipeline_test_prepare(const ve_render_snapshot* snapshot, void* user_data) {
+    pipeline_test_state* state = (pipeline_test_state*)user_data;
+    /* The simulation thread is parked at the handoff, so its state is stable here */
+    state->prepared_value = state->simulation_value;
+    state->consistent = state->consistent && state->prepared_value == snapshot->frame * 10;
+}
+
+static void pipeline_test_render(const ve_render_snapshot* snapshot, void* user_data) {
+    pipeline_test_state* state = (pipeline_test_state*)user_data;
+    ve_thread_id id = ve_thread_get_current_id();
+    if (state->rendered_frames == 0) {
+        state->render_thread = id;
+    }
+    state->one_render_thread = state->one_render_thread && id == state->render_thread;
+    state->in_order = state->in_order && snapshot->frame == state->rendered_frames + 1;
+    state->consistent = state->consistent && *(const uint64_t*)snapshot->data == snapshot->frame * 10 &&
+                        snapshot->alpha == 0.5;
+    state->rendered_frames++;
+}
+
+static bool run_frame_pipeline(bool threaded, uint32_t frames) {
+    static pipeline_test_state state;
+    memset(&state, 0, sizeof(state));
+    state.in_order = true;
+    state.consistent = true;
+    state.one_render_thread = true;
+
+    ve_frame_pipeline_config config = {
+        .threaded = threaded,
+        .snapshot_size = sizeof(uint64_t),
+        .prepare = pipeline_test_prepare,
+        .render = pipeline_test_render,
+        .user_data = &state,
+    };
+    TEST_ASSERT(ve_frame_pipeline_init(&config));
+    TEST_ASSERT(ve_frame_pipeline_is_threaded() == threaded);
+
+    for (uint32_t i = 0; i < frames; i++) {
+        ve_render_snapshot* snapshot = ve_frame_pipeline_begin_snapshot();
+        TEST_ASSERT(snapshot != NULL && snapshot->frame == i + 1);
+        state.simulation_value = snapshot->frame * 10;
+        *(uint64_t*)snapshot->data = snapshot->frame * 10;
+        snapshot->alpha = 0.5;
+        ve_frame_pipeline_submit_snapshot(snapshot);
+        /* Past the handoff: simulating the next frame may touch shared state again */
+        state.simulation_value = 0;
+    }
+
+    ve_frame_pipeline_flush();
+    ve_frame_pipeline_stats stats;
+    ve_frame_pipeline_get_stats(&stats);
+    TEST_ASSERT(stats.submitted == frames && stats.rendered == frames);
+    TEST_ASSERT(state.rendered_frames == frames);
+    TEST_ASSERT(state.in_order && state.consistent && state.one_render_thread);
+    TEST_ASSERT((state.render_thread != ve_thread_get_current_id()) == threaded);
+
+    ve_frame_pipeline_shutdown();
+    TEST_ASSERT(!ve_frame_pipeline_is_threaded());
+    TEST_ASSERT(ve_frame_pipeline_begin_snapshot() == NULL);
+    return true;
+}
+
+bool test_frame_pipeline(void) {
+    printf("Running test_frame_pipeline...\n");
+
+    TEST_ASSERT(run_frame_pipeline(false, 100));
+    TEST_ASSERT(run_frame_pipeline(true, 1000));
+
+    /* Shutdown renders what is still queued */
+    ve_frame_pipeline_config config = {.threaded = true, .render = pipeline_test_render};
+    static pipeline_test_state state;
+    memset(&state, 0, sizeof(state));
+    config.user_data = &state;
+    config.snapshot_size = sizeof(uint64_t);
+    TEST_ASSERT(ve_frame_pipeline_init(&config));
+    for (uint32_t i = 0; i < 10; i++) {
+        ve_render_snapshot* snapshot = ve_frame_pipeline_begin_snapshot();
+        TEST_ASSERT(snapshot != NULL);
+        ve_frame_pipeline_submit_snapshot(snapshot);
+    }
+    ve_frame_pipeline_shutdown();
+    TEST_ASSERT(state.rendered_frames == 10);
+    return true;
+}
+
+bool test_benchmark_stats(void) {
+    printf("Running test_benchmark_stats...\n");
+
+    /* 1000 frames of 1..1000 ms: the slowest 1% are the last ten */
+    static double samples[1000];
+    for (uint32_t i = 0; i < 1000; i++) {
+        samples[999 - i] = (double)(i + 1);
+    }
+    ve_benchmark_summary summary;
+    TEST_ASSERT(ve_benchmark_summarize(samples, 1000, &summary));
+    TEST_ASSERT(summary.count == 1000 && summary.min_ms == 1.0 && summary.max_ms == 1000.0);
+    TEST_ASSERT(summary.p50_ms == 500.0 && summary.p99_ms == 990.0);
+    TEST_ASSERT(fabs(summary.mean_ms - 500.5) < 1e-9);
+    TEST_ASSERT(fabs(summary.low_1_fps - 1000.0 / 995.5) < 1e-9);
+    TEST_ASSERT(fabs(summary.low_01_fps - 1.0) < 1e-9);
+    TEST_ASSERT(!ve_benchmark_summarize(samples, 0, &summary) && summary.count == 0);
+
+    /* Warm-up frames are skipped, and passes that skip a frame count as zero in it */
+    TEST_ASSERT(ve_benchmark_begin("test", 2));
+    for (uint32_t frame = 0; frame < 6; frame++) {
+        ve_benchmark_record_cpu_frame(10.0 + frame);
+        ve_benchmark_record_gpu_pass("shadow", 1.0);
+        ve_benchmark_record_gpu_pass("shadow", 1.0);
+        if (frame % 2 == 0) {
+            ve_benchmark_record_gpu_pass("bloom", 3.0);
+        }
+        ve_benchmark_record_gpu_frame(8.0);
+    }
+    TEST_ASSERT(ve_benchmark_get_cpu_summary(&summary) && summary.count == 4 && summary.min_ms == 12.0);
+    TEST_ASSERT(ve_benchmark_get_gpu_summary(&summary) && summary.count == 4 && summary.mean_ms == 8.0);
+    TEST_ASSERT(ve_benchmark_get_pass_count() == 2);
+
+    const char* name;
+    TEST_ASSERT(ve_benchmark_get_pass_summary(0, &name, &summary));
+    TEST_ASSERT(strcmp(name, "shadow") == 0 && summary.count == 4 && summary.max_ms == 2.0);
+    TEST_ASSERT(ve_benchmark_get_pass_summary(1, &name, &summary));
+    TEST_ASSERT(strcmp(name, "bloom") == 0 && summary.count == 4 && summary.min_ms == 0.0 && summary.mean_ms == 1.5);
+    TEST_ASSERT(!ve_benchmark_get_pass_summary(2, &name, &summary));
+
+    const char* path = "ve_test_benchmark.json";
+    TEST_ASSERT(ve_benchmark_write_report(path));
+    ve_file_mapping mapping;
+    TEST_ASSERT(ve_file_map(path, VE_FILE_ACCESS_SEQUENTIAL, &mapping));
+    char text[2048] = {0};
+    memcpy(text, mapping.data, mapping.size < sizeof(text) - 1 ? mapping.size : sizeof(text) - 1);
+    ve_file_unmap(&mapping);
+    remove(path);
+    TEST_ASSERT(strstr(text, "\"name\":\"test\"") && strstr(text, "\"name\":\"bloom\""));
+    TEST_ASSERT(strstr(text, "\"low_1_fps\":") != NULL);
+
+    ve_benchmark_end();
+    TEST_ASSERT(!ve_benchmark_is_active() && ve_benchmark_get_pass_count() == 0);
+    ve_benchmark_record_cpu_frame(1.0);
+    TEST_ASSERT(!ve_benchmark_get_cpu_summary(&summary));
+    return true;
+}
+
+static void telemetry_test_source(void* user_data) {
+    (void)user_data;
+    ve_telemetry_set("test.value", 1.0);
+    ve_telemetry_set("test.value", 2.0);
+    ve_telemetry_set("test\"quoted\\", 3.0);
+    ve_telemetry_set("test.nan", NAN);
+}
+
+bool test_telemetry(void) {
+    printf("Running test_telemetry...\n");
+
+    ve_telemetry_config config = {.sample_interval = 3, .serve = true, .port = 0};
+    TEST_ASSERT(ve_telemetry_init(&config));
+    TEST_ASSERT(ve_telemetry_get_sample(NULL, 0, NULL) == 0);
+
+    ve_thread_pool* pool = ve_thread_pool_create(2);
+    TEST_ASSERT(pool != NULL);
+    TEST_ASSERT(ve_telemetry_add_thread_pool("jobs", pool));
+    TEST_ASSERT(ve_telemetry_add_source(telemetry_test_source, NULL));
+
+    /* Values set outside a sample are ignored */
+    ve_telemetry_set("test.outside", 1.0);
+
+    /* One sample every third frame */
+    ve_frame_time frame_time = {.delta_time = 0.016, .total_time = 1.0, .frame_rate = 62.5, .frame_count = 0};
+    for (uint32_t frame = 1; frame <= 7; frame++) {
+        frame_time.frame_count = frame;
+        TEST_ASSERT(ve_telemetry_frame(&frame_time) == (frame % 3 == 0));
+    }
+    uint32_t count = 0;
+    TEST_ASSERT(ve_telemetry_get_sample(NULL, 0, &count) == 2 && count > 0);
+
+    double value = 0.0;
+    TEST_ASSERT(ve_telemetry_get_value("frame.count", &value) && value == 6.0);
+    TEST_ASSERT(ve_telemetry_get_value("frame.delta_ms", &value) && fabs(value - 16.0) < 1e-9);
+    TEST_ASSERT(ve_telemetry_get_value("memory.tag.core", &value) && value > 0.0);
+    TEST_ASSERT(ve_telemetry_get_value("jobs.threads", &value) && value == 2.0);
+    TEST_ASSERT(ve_telemetry_get_value("jobs.pending", &value) && value == 0.0);
+    TEST_ASSERT(ve_telemetry_get_value("test.value", &value) && value == 2.0);
+    TEST_ASSERT(ve_telemetry_get_value("test_quoted_", &value));
+    TEST_ASSERT(!ve_telemetry_get_value("test.outside", &value));
+
+    ve_telemetry_metric metrics[VE_TELEMETRY_MAX_METRICS];
+    TEST_ASSERT(ve_telemetry_get_sample(metrics, 2, &count) == 2 && count > 2);
+    TEST_ASSERT(strcmp(metrics[0].name, "frame.count") == 0);
+
+    /* JSON reports the needed length when truncated */
+    char json[8192];
+    size_t length = ve_telemetry_write_json(json, sizeof(json));
+    TEST_ASSERT(length < sizeof(json) && strlen(json) == length);
+    TEST_ASSERT(strncmp(json, "{\"sample\":2,\"metrics\":{", 23) == 0 && strstr(json, "\"jobs.pending\":0"));
+    TEST_ASSERT(strstr(json, "\"test.nan\":null") && strcmp(json + length - 2, "}}") == 0);
+    char small[16];
+    TEST_ASSERT(ve_telemetry_write_json(small, sizeof(small)) == length && strlen(small) == sizeof(small) - 1);
+
+    /* The endpoint serves the same JSON over HTTP */
+    uint16_t port = ve_telemetry_get_port();
+    TEST_ASSERT(port != 0);
+    ve_socket* client = ve_socket_connect(port);
+    TEST_ASSERT(client != NULL);
+    const char* request = "GET / HTTP/1.0\r\n\r\n";
+    TEST_ASSERT(ve_socket_send(client, request, strlen(request)));
+    static char response[16384];
+    size_t received = 0;
+    int64_t result;
+    while ((result = ve_socket_receive(client, response + received, sizeof(response) - 1 - received, 2000)) > 0) {
+        received += (size_t)result;
+    }
+    response[received] = '\0';
+    ve_socket_close(client);
+    TEST_ASSERT(strncmp(response, "HTTP/1.0 200 OK\r\n", 17) == 0);
+    const char* body = strstr(response, "\r\n\r\n");
+    TEST_ASSERT(body && strcmp(body + 4, json) == 0);
+
+    ve_telemetry_remove_thread_pool(pool);
+    ve_telemetry_sample(NULL);
+    TEST_ASSERT(!ve_telemetry_get_value("jobs.pending", &value) && !ve_telemetry_get_value("frame.count", &value));
+    ve_thread_pool_destroy(pool);
+
+    ve_telemetry_shutdown();
+    TEST_ASSERT(!ve_telemetry_is_enabled() && ve_telemetry_get_port() == 0);
+    TEST_ASSERT(!ve_telemetry_frame(&frame_time));
+    return true;
+}
+
+typedef struct init_graph_test {
+    ve_atomic_int32 sequence;
+    ve_atomic_int32 order[8];           /* 1 + position each task ran in */
+    ve_atomic_int32 arrived;            /* Rendezvous of the two parallel tasks */
+    bool met[2];
+    ve_thread_id main_thread;
+    bool main_on_caller;
+} init_graph_test;
+
+typedef struct init_graph_test_task {
+    init_graph_test* test;
+    uint32_t slot;
+} init_graph_test_task;
+
+static bool init_graph_record_task(void* user_data) {
+    init_graph_test_task* task = (init_graph_test_task*)user_data;
+    ve_atomic_store32(&task->test->order[task->slot], ve_atomic_increment32(&task->test->sequence));
+    return true;
+}
+
+/* Waits for the other parallel task, which only arrives if both run at once */
+static bool init_graph_parallel_task(void* user_data) {
+    init_graph_test_task* task = (init_graph_test_task*)user_data;
+    init_graph_record_task(user_data);
+    ve_atomic_increment32(&task->test->arrived);
+    for (uint32_t i = 0; i < 2000 && ve_atomic_load32(&task->test->arrived) < 2; i++) {
+        ve_thread_sleep_ms(1);
+    }
+    task->test->met[task->slot - 1] = ve_atomic_load32(&task->test->arrived) == 2;
+    return true;
+}
+
+static bool init_graph_main_task(void* user_data) {
+    init_graph_test_task* task = (init_graph_test_task*)user_data;
+    task->test->main_on_caller = ve_thread_get_current_id() == task->test->main_thread;
+    return init_graph_record_task(user_data);
+}
+
+static bool init_graph_fail_task(void* user_data) {
+    init_graph_record_task(user_data);
+    return false;
+}
+
+bool test_init_graph(void) {
+    printf("Running test_init_graph...\n");
+
+    static init_graph_test test;
+    memset(&test, 0, sizeof(test));
+    test.main_thread = ve_thread_get_current_id();
+    init_graph_test_task tasks[8];
+    for (uint32_t i = 0; i < 8; i++) {
+        tasks[i].test = &test;
+        tasks[i].slot = i;
+    }
+
+    /* root -> two parallel tasks -> main-thread join */
+    static ve_init_graph graph;
+    ve_init_graph_init(&graph);
+    uint32_t root = ve_init_graph_add(&graph, "root", init_graph_record_task, &tasks[0], VE_INIT_TASK_NONE, 0);
+    uint32_t left = ve_init_graph_add(&graph, "left", init_graph_parallel_task, &tasks[1], VE_INIT_TASK_NONE,
+                                      VE_INIT_AFTER(root));
+    uint32_t right = ve_init_graph_add(&graph, "right", init_graph_parallel_task, &tasks[2], VE_INIT_TASK_NONE,
+                                       VE_INIT_AFTER(root));
+    uint32_t join = ve_init_graph_add(&graph, "join", init_graph_main_task, &tasks[3], VE_INIT_TASK_MAIN_THREAD,
+                                      VE_INIT_AFTER(left) | VE_INIT_AFTER(right));
+    TEST_ASSERT(root == 0 && left == 1 && right == 2 && join == 3);
+
+    /* Dependencies must be earlier tasks */
+    TEST_ASSERT(ve_init_graph_add(&graph, "bad", init_graph_record_task, &tasks[4], VE_INIT_TASK_NONE,
+                                  VE_INIT_AFTER(4)) == VE_INIT_TASK_INVALID);
+    TEST_ASSERT(graph.task_count == 4);
+
+    ve_thread_pool* pool = ve_thread_pool_create(2);
+    TEST_ASSERT(pool != NULL);
+    TEST_ASSERT(ve_init_graph_run(&graph, pool));
+    TEST_ASSERT(ve_atomic_load32(&test.order[0]) == 1 && ve_atomic_load32(&test.order[3]) == 4);
+    TEST_ASSERT(test.met[0] && test.met[1]);
+    TEST_ASSERT(test.main_on_caller && !graph.tasks[join].ran_on_worker && graph.tasks[left].ran_on_worker);
+    for (uint32_t i = 0; i < graph.task_count; i++) {
+        TEST_ASSERT(graph.tasks[i].state == VE_INIT_TASK_SUCCEEDED);
+    }
+    TEST_ASSERT(graph.tasks[join].start_ms >= graph.tasks[left].start_ms + graph.tasks[left].duration_ms);
+    TEST_ASSERT(graph.total_ms >= graph.tasks[join].start_ms);
+    ve_init_graph_log_timings(&graph);
+
+    /* A failure skips its dependents but lets independent running tasks finish */
+    memset(&test, 0, sizeof(test));
+    test.main_thread = ve_thread_get_current_id();
+    ve_init_graph_init(&graph);
+    uint32_t fail = ve_init_graph_add(&graph, "fail", init_graph_fail_task, &tasks[0], VE_INIT_TASK_MAIN_THREAD, 0);
+    uint32_t after = ve_init_graph_add(&graph, "after", init_graph_record_task, &tasks[1], VE_INIT_TASK_NONE,
+                                       VE_INIT_AFTER(fail));
+    uint32_t other = ve_init_graph_add(&graph, "other", init_graph_record_task, &tasks[2], VE_INIT_TASK_NONE, 0);
+    TEST_ASSERT(!ve_init_graph_run(&graph, pool));
+    TEST_ASSERT(graph.tasks[fail].state == VE_INIT_TASK_FAILED && graph.tasks[after].state == VE_INIT_TASK_SKIPPED);
+    TEST_ASSERT(graph.tasks[other].state == VE_INIT_TASK_SUCCEEDED);
+    TEST_ASSERT(ve_atomic_load32(&test.order[1]) == 0);
+
+    /* Without a pool everything runs on the caller in the order added */
+    memset(&test, 0, sizeof(test));
+    ve_init_graph_init(&graph);
+    for (uint32_t i = 0; i < 4; i++) {
+        ve_init_graph_add(&graph, "serial", init_graph_record_task, &tasks[3 - i], VE_INIT_TASK_NONE, 0);
+    }
+    TEST_ASSERT(ve_init_graph_run(&graph, NULL));
+    for (uint32_t i = 0; i < 4; i++) {
+        TEST_ASSERT(ve_atomic_load32(&test.order[3 - i]) == (int32_t)i + 1 && !graph.tasks[i].ran_on_worker);
+    }
+
+    ve_thread_pool_destroy(pool);
+    return true;
+}
+
+bool test_camera_path(void) {
+    printf("Running test_camera_path...\n");
+
+    const char* text = "# time eye target\n"
+                       "0   0 0 0    0 0 -1\n"
+                       "\n"
+                       "1   10 0 0   0 0 -1\r\n"
+                       "  2 20 0 0   0 0 -1\n"
+                       "3   30 6 0   0 0 -1";
+    ve_camera_path path;
+    TEST_ASSERT(ve_camera_path_parse(text, strlen(text), &path));
+    TEST_ASSERT(path.count == 4 && ve_camera_path_get_duration(&path) == 3.0f);
+
+    /* Passes through every key and holds the ends */
+    ve_vec3 eye, target;
+    for (uint32_t i = 0; i < path.count; i++) {
+        ve_camera_path_sample(&path, path.keys[i].time, &eye, &target);
+        TEST_ASSERT(fabsf(eye.x - path.keys[i].eye.x) < 1e-5f && fabsf(eye.y - path.keys[i].eye.y) < 1e-5f);
+        TEST_ASSERT(target.z == -1.0f);
+    }
+    ve_camera_path_sample(&path, -1.0f, &eye, &target);
+    TEST_ASSERT(eye.x == 0.0f);
+    ve_camera_path_sample(&path, 10.0f, &eye, &target);
+    TEST_ASSERT(eye.x == 30.0f && eye.y == 6.0f);
+
+    /* Evenly spaced keys on a line are followed at constant speed */
+    ve_camera_path_sample(&path, 1.5f, &eye, &target);
+    TEST_ASSERT(fabsf(eye.x - 15.0f) < 1e-4f);
+
+    /* Same time, same view */
+    ve_vec3 again;
+    ve_camera_path_sample(&path, 2.25f, &eye, &target);
+    ve_camera_path_sample(&path, 2.25f, &again, &target);
+    TEST_ASSERT(memcmp(&eye, &again, sizeof(ve_vec3)) == 0);
+    ve_camera_path_free(&path);
+    TEST_ASSERT(path.keys == NULL && path.count == 0);
+
+    /* Malformed lines, times that do not increase and empty paths are rejected */
+    const char* short_key = "0 0 0 0 0 0\n";
+    const char* backwards = "1 0 0 0 0 0 0\n0.5 0 0 0 0 0 0\n";
+    const char* trailing = "0 0 0 0 0 0 0 x\n";
+    const char* comments = "# nothing\n\n";
+    TEST_ASSERT(!ve_camera_path_parse(short_key, strlen(short_key), &path) && path.keys == NULL);
+    TEST_ASSERT(!ve_camera_path_parse(backwards, strlen(backwards), &path) && path.keys == NULL);
+    TEST_ASSERT(!ve_camera_path_parse(trailing, strlen(trailing), &path));
+    TEST_ASSERT(!ve_camera_path_parse(comments, strlen(comments), &path));
+    return true;
+}
+
+static void allocate_free_task(void* user_data) {
+    (void)user_data;
+    void* blocks[16];
+    for (int i = 0; i < 16; i++) {
+        blocks[i] = ve_allocate(64, VE_MEMORY_TAG_ECS);
+    }
+    for (int i = 0; i < 16; i++) {
+        ve_free(blocks[i]);
+    }
+}
+
+static void free_task(void* user_data) {
+    ve_free(user_data);
+}
+
+bool test_memory_stats_threaded(void) {
+    printf("Running test_memory_stats_threaded...\n");
+
+    ve_thread_pool* pool = ve_thread_pool_create(4);
+    TEST_ASSERT(pool != NULL);
+
+    ve_memory_stats before = ve_memory_get_stats();
+
+    for (int i = 0; i < 1000; i++) {
+        ve_thread_pool_submit(pool, allocate_free_task, NULL);
+    }
+
+    /* Allocated here, freed on the workers */
+    for (int i = 0; i < 1000; i++) {
+        ve_thread_pool_submit(pool, free_task, ve_allocate(32, VE_MEMORY_TAG_SCENE));
+    }
+
+    ve_thread_pool_wait(pool);
+
+    ve_memory_stats after = ve_memory_get_stats();
+    TEST_ASSERT(after.allocation_count == before.allocation_count);
+    TEST_ASSERT(after.tag_usage[VE_MEMORY_TAG_ECS] == before.tag_usage[VE_MEMORY_TAG_ECS]);
+    TEST_ASSERT(after.tag_usage[VE_MEMORY_TAG_SCENE] == before.tag_usage[VE_MEMORY_TAG_SCENE]);
+    TEST_ASSERT(after.total_allocated - before.total_allocated == 1000 * 16 * 64 + 1000 * 32);
+    TEST_ASSERT(ve_memory_validate());
+
+    ve_thread_pool_destroy(pool);
+    return true;
+}
+
+bool test_memory_external(void) {
+    printf("Running test_memory_external...\n");
+
+    ve_memory_stats before = ve_memory_get_stats();
+
+    /* E.g. a device memory block */
+    ve_memory_record_external(VE_MEMORY_TAG_VULKAN, 64 * 1024 * 1024);
+
+    ve_memory_stats during = ve_memory_get_stats();
+    TEST_ASSERT(during.external_usage - before.external_usage == 64 * 1024 * 1024);
+    TEST_ASSERT(during.tag_usage[VE_MEMORY_TAG_VULKAN] - before.tag_usage[VE_MEMORY_TAG_VULKAN] == 64 * 1024 * 1024);
+    TEST_ASSERT(during.allocation_count == before.allocation_count);
+    TEST_ASSERT(during.total_allocated == before.total_allocated);
+
+    ve_memory_record_external(VE_MEMORY_TAG_VULKAN, -64 * 1024 * 1024);
+
+    ve_memory_stats after = ve_memory_get_stats();
+    TEST_ASSERT(after.external_usage == before.external_usage);
+    TEST_ASSERT(after.tag_usage[VE_MEMORY_TAG_VULKAN] == before.tag_usage[VE_MEMORY_TAG_VULKAN]);
+
+    return true;
+}
+
+typedef struct concurrent_pool_job {
+    ve_concurrent_pool* pool;
+    uint32_t stamp;
+    ve_atomic_int32* failures;
+} concurrent_pool_job;
+
+static void concurrent_pool_task(void* user_data) {
+    concurrent_pool_job* job = (concurrent_pool_job*)user_data;
+    uint32_t* elements[32];
+
+    for (int round = 0; round < 20; round++) {
+        for (int i = 0; i < 32; i++) {
+            elements[i] = (uint32_t*)ve_concurrent_pool_allocate(job->pool);
+            if (!elements[i]) {
+                ve_atomic_increment32(job->failures);
+                return;
+            }
+            for (int j = 0; j < 8; j++) {
+                elements[i][j] = job->stamp;
+            }
+        }
+        /* A duplicate handout would have overwritten some stamps */
+        for (int i = 0; i < 32; i++) {
+            for (int j = 0; j < 8; j++) {
+                if (elements[i][j] != job->stamp) {
+                    ve_atomic_increment32(job->failures);
+                }
+            }
+            ve_concurrent_pool_free(job->pool, elements[i]);
+        }
+    }
+}
+
+typedef struct concurrent_pool_free_job {
+    ve_concurrent_pool* pool;
+    void* element;
+} concurrent_pool_free_job;
+
+static void concurrent_pool_free_task(void* user_data) {
+    concurrent_pool_free_job* job = (concurrent_pool_free_job*)user_data;
+    ve_concurrent_pool_free(job->pool, job->element);
+}
+
+bool test_concurrent_pool(void) {
+    printf("Running test_concurrent_pool...\n");
+
+    ve_concurrent_pool* pool = ve_concurrent_pool_create(32, 64);
+    TEST_ASSERT(pool != NULL);
+    TEST_ASSERT(ve_concurrent_pool_get_capacity(pool) == 0);
+
+    /* Single-threaded growth past the first chunk */
+    void* elements[512];
+    for (int i = 0; i < 512; i++) {
+        elements[i] = ve_concurrent_pool_allocate(pool);
+        TEST_ASSERT(elements[i] != NULL);
+        TEST_ASSERT(ve_is_aligned(elements[i], 16));
+        TEST_ASSERT(ve_concurrent_pool_contains(pool, elements[i]));
+    }
+    TEST_ASSERT(ve_concurrent_pool_get_capacity(pool) >= 512);
+    TEST_ASSERT(!ve_concurrent_pool_contains(pool, &elements[0]));
+
+    ve_thread_pool* threads = ve_thread_pool_create(4);
+    TEST_ASSERT(threads != NULL);
+
+    ve_atomic_int32 failures = {0};
+    static concurrent_pool_job jobs[64];
+    for (uint32_t i = 0; i < 64; i++) {
+        jobs[i].pool = pool;
+        jobs[i].stamp = 0xC0DE0000u + i;
+        jobs[i].failures = &failures;
+        ve_thread_pool_submit(threads, concurrent_pool_task, &jobs[i]);
+    }
+    /* Frees from this thread race with the workers */
+    for (int i = 0; i < 512; i++) {
+        ve_concurrent_pool_free(pool, elements[i]);
+    }
+    ve_thread_pool_wait(threads);
+    TEST_ASSERT(ve_atomic_load32(&failures) == 0);
+
+    /* Allocated here, freed on the workers, then reused without growing */
+    static concurrent_pool_free_job free_jobs[256];
+    for (int round = 0; round < 2; round++) {
+        for (int i = 0; i < 256; i++) {
+            free_jobs[i].pool = pool;
+            free_jobs[i].element = ve_concurrent_pool_allocate(pool);
+            TEST_ASSERT(free_jobs[i].element != NULL);
+        }
+        for (int i = 0; i < 256; i++) {
+            ve_thread_pool_submit(threads, concurrent_pool_free_task, &free_jobs[i]);
+        }
+        ve_thread_pool_wait(threads);
+    }
+    size_t capacity = ve_concurrent_pool_get_capacity(pool);
+    for (int i = 0; i < 256; i++) {
+        elements[i] = ve_concurrent_pool_allocate(pool);
+    }
+    TEST_ASSERT(ve_concurrent_pool_get_capacity(pool) == capacity);
+
+    ve_thread_pool_destroy(threads);
+    ve_concurrent_pool_destroy(pool);
+    return true;
+}
+
+static void log_burst_task(void* user_data) {
+    (void)user_data;
+    for (int i = 0; i < 500; i++) {
+        VE_LOG_INFO("async test message %d", i);
+    }
+}
+
+static int count_log_lines(const char* path, const char* needle) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return -1;
+    }
+    char line[1024];
+    int count = 0;
+    while (fgets(line, sizeof(line), file)) {
+        if (strstr(line, needle)) {
+            count++;
+        }
+    }
+    fclose(file);
+    return count;
+}
+
+static bool run_async_log_burst(ve_log_overflow_policy policy, size_t queue_capacity, bool deferred, int* written) {
+    const char* path = "ve_test_async.log";
+    remove(path);
+
+    ve_logger_config config = {
+        .level = VE_LOG_INFO,
+        .targets = VE_LOG_TARGET_FILE,
+        .timestamps = true,
+        .thread_ids = true,
+        .file_pattern = path,
+        .async = true,
+        .queue_capacity = queue_capacity,
+        .overflow_policy = policy,
+        .deferred_format = deferred,
+    };
+    ve_logger_shutdown();
+    TEST_ASSERT(ve_logger_init(&config));
+
+    ve_thread_pool* pool = ve_thread_pool_create(4);
+    TEST_ASSERT(pool != NULL);
+    for (int i = 0; i < 8; i++) {
+        ve_thread_pool_submit(pool, log_burst_task, NULL);
+    }
+    ve_thread_pool_wait(pool);
+    ve_thread_pool_destroy(pool);
+
+    /* Larger than a queue cell, written synchronously after a flush */
+    char big[2048];
+    memset(big, 'x', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    VE_LOG_WARN("async test oversized %s", big);
+
+    ve_logger_flush();
+    TEST_ASSERT(count_log_lines(path, "async test oversized") == 1);
+
+    ve_logger_shutdown();
+    *written = count_log_lines(path, "async test message");
+    remove(path);
+    return true;
+}
+
+bool test_logger_async(void) {
+    printf("Running test_logger_async...\n");
+
+    /* Blocking policy loses nothing */
+    int written = 0;
+    TEST_ASSERT(run_async_log_burst(VE_LOG_OVERFLOW_BLOCK, 64, false, &written));
+    TEST_ASSERT(written == 8 * 500);
+    TEST_ASSERT(run_async_log_burst(VE_LOG_OVERFLOW_BLOCK, 64, true, &written));
+    TEST_ASSERT(written == 8 * 500);
+
+    /* Dropping policy accounts for every message it discards */
+    TEST_ASSERT(run_async_log_burst(VE_LOG_OVERFLOW_DROP, 2, false, &written));
+    TEST_ASSERT(written + (int)ve_logger_get_dropped_count() == 8 * 500);
+
+    ve_logger_config console = {
+        .level = VE_LOG_INFO,
+        .targets = VE_LOG_TARGET_CONSOLE,
+        .color_output = true,
+    };
+    TEST_ASSERT(ve_logger_init(&console));
+    return true;
+}
+
+static void log_sequence_task(void* user_data) {
+    int stream = (int)(intptr_t)user_data;
+    for (int i = 0; i < 300; i++) {
+        VE_LOG_INFO("sequence %d %d", stream, i);
+    }
+}
+
+bool test_logger_deferred(void) {
+    printf("Running test_logger_deferred...\n");
+
+    const char* path = "ve_test_deferred.log";
+    remove(path);
+
+    ve_logger_config config = {
+        .level = VE_LOG_INFO,
+        .targets = VE_LOG_TARGET_FILE,
+        .file_pattern = path,
+        .async = true,
+        .deferred_format = true,
+    };
+    ve_logger_shutdown();
+    TEST_ASSERT(ve_logger_init(&config));
+
+    /* Replayed conversions must match immediate formatting */
+    char expected[512];
+    const char* name = "mesh";
+    snprintf(expected, sizeof(expected),
+             "deferred check %d %5.2f %s %-8s| %zu %lld %x %c %% %*d %.*s %u end",
+             -42, 3.14159, name, "pad", (size_t)123456789, -9000000000ll, 0xBEEFu, 'q', 6, 7, 3, "truncate", 17u);
+    VE_LOG_INFO("deferred check %d %5.2f %s %-8s| %zu %lld %x %c %% %*d %.*s %u end",
+                -42, 3.14159, name, "pad", (size_t)123456789, -9000000000ll, 0xBEEFu, 'q', 6, 7, 3, "truncate", 17u);
+
+    /* Each thread's messages stay in order after merging */
+    ve_thread_pool* pool = ve_thread_pool_create(4);
+    TEST_ASSERT(pool != NULL);
+    for (int i = 0; i < 4; i++) {
+        ve_thread_pool_submit(pool, log_sequence_task, (void*)(intptr_t)i);
+    }
+    ve_thread_pool_wait(pool);
+    ve_thread_pool_destroy(pool);
+    ve_logger_shutdown();
+
+    FILE* file = fopen(path, "r");
+    TEST_ASSERT(file != NULL);
+    char line[1024];
+    bool found = false;
+    int next[4] = {0, 0, 0, 0};
+    bool ordered = true;
+    while (fgets(line, sizeof(line), file)) {
+        char* message = strstr(line, "deferred check");
+        if (message) {
+            message[strcspn(message, "\n")] = '\0';
+            found = strcmp(message, expected) == 0;
+        }
+        int stream = 0;
+        int index = 0;
+        message = strstr(line, "sequence ");
+        if (message && sscanf(message, "sequence %d %d", &stream, &index) == 2 && stream >= 0 && stream < 4) {
+            ordered = ordered && index == next[stream];
+            next[stream] = index + 1;
+        }
+    }
+    fclose(file);
+    remove(path);
+
+    TEST_ASSERT(found);
+    TEST_ASSERT(ordered);
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT(next[i] == 300);
+    }
+
+    ve_logger_config console = {
+        .level = VE_LOG_INFO,
+        .targets = VE_LOG_TARGET_CONSOLE,
+        .color_output = true,
+    };
+    TEST_ASSERT(ve_logger_init(&console));
+    return true;
+}
+
+static void profiled_task(void* user_data) {
+    (void)user_data;
+    VE_TIMED_SCOPE("Worker") {
+        VE_TIMED_SCOPE("WorkerInner") {
+            ve_thread_yield();
+        }
+    }
+}
+
+static void profiled_function(void) {
+    VE_TIMED_FUNCTION();
+    VE_TIMED_SCOPE("Leaf") {
+        ve_thread_yield();
+    }
+}
+
+static uint32_t count_zone_calls(const ve_profile_zone_stats* stats, uint32_t count, const char* name) {
+    uint32_t calls = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (strcmp(stats[i].name, name) == 0) {
+            calls += stats[i].calls;
+        }
+    }
+    return calls;
+}
+
+static const ve_profile_zone_stats* find_zone_stats(const ve_profile_zone_stats* stats, uint32_t count,
+                                                    const char* name) {
+    for (uint32_t i = 0; i < count; i++) {
+        if (strcmp(stats[i].name, name) == 0) {
+            return &stats[i];
+        }
+    }
+    return NULL;
+}
+
+bool test_profiler(void) {
+    printf("Running test_profiler...\n");
+
+    TEST_ASSERT(ve_profiler_init());
+    TEST_ASSERT(ve_profiler_start_capture(4096));
+
+    ve_thread_pool* pool = ve_thread_pool_create(4);
+    TEST_ASSERT(pool != NULL);
+
+    ve_profiler_begin_frame();
+    VE_TIMED_SCOPE("Update") {
+        for (int i = 0; i < 3; i++) {
+            profiled_function();
+        }
+        for (int i = 0; i < 64; i++) {
+            TEST_ASSERT(ve_thread_pool_submit(pool, profiled_task, NULL));
+        }
+        ve_thread_pool_wait(pool);
+    }
+    ve_profiler_end_frame();
+
+    ve_profile_zone_stats stats[VE_PROFILER_MAX_ZONES];
+    uint32_t count = ve_profiler_get_zone_stats(stats, VE_PROFILER_MAX_ZONES);
+
+    const ve_profile_zone_stats* update = find_zone_stats(stats, count, "Update");
+    const ve_profile_zone_stats* function = find_zone_stats(stats, count, "profiled_function");
+    const ve_profile_zone_stats* leaf = find_zone_stats(stats, count, "Leaf");
+    const ve_profile_zone_stats* worker = find_zone_stats(stats, count, "Worker");
+    const ve_profile_zone_stats* inner = find_zone_stats(stats, count, "WorkerInner");
+    TEST_ASSERT(update && function && leaf && worker && inner);
+
+    TEST_ASSERT(update->calls == 1 && update->depth == 0 && update->parent_index == UINT32_MAX);
+    TEST_ASSERT(function->calls == 3 && function->depth == 1);
+    TEST_ASSERT(&stats[function->parent_index] == update);
+    TEST_ASSERT(leaf->calls == 3 && &stats[leaf->parent_index] == function);
+    /* Workers record root zones; tasks run by the waiting thread nest under Update */
+    TEST_ASSERT(count_zone_calls(stats, count, "Worker") == 64);
+    TEST_ASSERT(count_zone_calls(stats, count, "WorkerInner") == 64);
+    TEST_ASSERT(strcmp(stats[inner->parent_index].name, "Worker") == 0);
+    TEST_ASSERT(function->min_ms <= function->avg_ms && function->avg_ms <= function->max_ms);
+    TEST_ASSERT(update->total_ms >= function->total_ms);
+    TEST_ASSERT(ve_profiler_get_frame_time_ms() >= update->total_ms);
+    TEST_ASSERT(ve_profiler_get_dropped_count() == 0);
+
+    /* Zones measured elsewhere (GPU timestamps) land on their own track */
+    uint32_t track = ve_profiler_register_track("GPU");
+    TEST_ASSERT(track != UINT32_MAX);
+    ve_timestamp now = ve_timer_now();
+    ve_profiler_record_zone(track, "Update", NULL, 0, now, now + 1000);
+    ve_profiler_record_zone(track, "Update", NULL, 0, now + 2000, now + 2500);
+    ve_profiler_begin_frame();
+    ve_profiler_end_frame();
+    count = ve_profiler_get_zone_stats(stats, VE_PROFILER_MAX_ZONES);
+    TEST_ASSERT(count == 1 && stats[0].calls == 2);
+    TEST_ASSERT(stats[0].track != NULL && strcmp(stats[0].track, "GPU") == 0);
+
+    /* An empty frame resets the statistics */
+    ve_profiler_begin_frame();
+    ve_profiler_end_frame();
+    TEST_ASSERT(ve_profiler_get_zone_stats(NULL, 0) == 0);
+
+    ve_thread_pool_destroy(pool);
+
+    /* 1 + 3 * 2 + 64 * 2 CPU zones, two track zones and three frame markers */
+    ve_profiler_stop_capture();
+    TEST_ASSERT(ve_profiler_get_capture_count() == 140);
+
+    const char* path = "test_profiler_trace.json";
+    TEST_ASSERT(ve_profiler_export_chrome_trace(path));
+
+    FILE* file = fopen(path, "r");
+    TEST_ASSERT(file != NULL);
+    char text[256] = {0};
+    size_t read = fread(text, 1, sizeof(text) - 1, file);
+    fclose(file);
+    remove(path);
+    TEST_ASSERT(read > 0);
+    TEST_ASSERT(strncmp(text, "{\"traceEvents\":[", 16) == 0);
+    TEST_ASSERT(strstr(text, "\"thread_name\"") != NULL);
+
+    ve_profiler_shutdown();
+    return true;
+}
+
+bool test_memory_size_classes(void) {
+    printf("Running test_memory_size_classes...\n");
+
+    static const size_t sizes[] = {1, 16, 17, 100, 129, 1000, 4096, 30000, 40000, 1 << 20};
+    enum { SIZE_COUNT = sizeof(sizes) / sizeof(sizes[0]) };
+    uint8_t* blocks[SIZE_COUNT][8];
+
+    ve_memory_stats before = ve_memory_get_stats();
+
+    for (int i = 0; i < SIZE_COUNT; i++) {
+        for (int j = 0; j < 8; j++) {
+            blocks[i][j] = (uint8_t*)ve_allocate(sizes[i], VE_MEMORY_TAG_MESH);
+            TEST_ASSERT(blocks[i][j] != NULL);
+            TEST_ASSERT(ve_is_aligned(blocks[i][j], 16));
+            memset(blocks[i][j], (int)(i * 8 + j), sizes[i]);
+        }
+    }
+
+    for (int i = 0; i < SIZE_COUNT; i++) {
+        for (int j = 0; j < 8; j++) {
+            TEST_ASSERT(blocks[i][j][0] == (uint8_t)(i * 8 + j));
+            TEST_ASSERT(blocks[i][j][sizes[i] - 1] == (uint8_t)(i * 8 + j));
+        }
+    }
+
+    uint8_t* grown = (uint8_t*)ve_reallocate(blocks[2][0], 50000, VE_MEMORY_TAG_MESH);
+    TEST_ASSERT(grown != NULL);
+    TEST_ASSERT(grown[16] == 16);
+    blocks[2][0] = grown;
+
+    /* Freed blocks are reused by the same size class */
+    ve_free(blocks[1][7]);
+    TEST_ASSERT(ve_allocate(16, VE_MEMORY_TAG_MESH) == blocks[1][7]);
+
+    for (int i = 0; i < SIZE_COUNT; i++) {
+        for (int j = 0; j < 8; j++) {
+            ve_free(blocks[i][j]);
+        }
+    }
+
+    ve_memory_stats after = ve_memory_get_stats();
+    TEST_ASSERT(after.allocation_count == before.allocation_count);
+    TEST_ASSERT(after.tag_usage[VE_MEMORY_TAG_MESH] == before.tag_usage[VE_MEMORY_TAG_MESH]);
+    return true;
+}
+
+bool test_frame_latency(void) {
+    printf("Running test_frame_latency...\n");
+
+    TEST_ASSERT(ve_timer_init());
+
+    /* The limiter holds frames to the target rate */
+    ve_frame_time_set_target_fps(200.0);
+    ve_frame_time_set_limiter_enabled(true);
+    TEST_ASSERT(ve_frame_time_is_limiter_enabled());
+    ve_frame_time_limit();
+
+    ve_timestamp start = ve_timer_now();
+    for (int i = 0; i < 5; i++) {
+        ve_frame_time_limit();
+    }
+    double elapsed = ve_timer_elapsed(start, ve_timer_now());
+    TEST_ASSERT(elapsed >= 5 * 0.005 * 0.95);
+
+    /* Disabled, it returns immediately */
+    ve_frame_time_set_limiter_enabled(false);
+    TEST_ASSERT(ve_frame_time_limit() == 0.0);
+    ve_frame_time_set_target_fps(60.0);
+
+    /* Two frames with known marker spacing */
+    ve_latency_reset();
+    ve_timestamp base = ve_timer_now();
+    ve_timestamp step = 1000000;
+    for (uint64_t frame = 10; frame < 12; frame++) {
+        ve_timestamp input = base + frame * 100 * step;
+        ve_latency_mark_at(frame, VE_LATENCY_INPUT_SAMPLE, input);
+        ve_latency_mark_at(frame, VE_LATENCY_RENDER_SUBMIT, input + 2 * step);
+        ve_latency_mark_at(frame, VE_LATENCY_PRESENT, input + 4 * step);
+    }
+    ve_latency_mark_at(11, VE_LATENCY_PRESENT_COMPLETE, base + 1100 * step + 20 * step);
+
+    ve_latency_stats stats;
+    ve_latency_get_stats(&stats);
+    double step_ms = ve_timer_to_milliseconds(step);
+    TEST_ASSERT(stats.frame_count == 2);
+    TEST_ASSERT(stats.photon_frame_count == 1);
+    TEST_ASSERT(fabs(stats.input_to_submit_ms - 2 * step_ms) < 1e-6);
+    TEST_ASSERT(fabs(stats.input_to_present_ms - 4 * step_ms) < 1e-6);
+    TEST_ASSERT(fabs(stats.input_to_photon_ms - 20 * step_ms) < 1e-6);
+    TEST_ASSERT(fabs(stats.max_input_to_photon_ms - 20 * step_ms) < 1e-6);
+
+    /* A newer frame in the same slot replaces the old one; late markers of the old one are dropped */
+    ve_timestamp marker = 0;
+    TEST_ASSERT(ve_latency_get_marker(10, VE_LATENCY_PRESENT, &marker));
+    ve_latency_mark_at(10 + VE_LATENCY_HISTORY, VE_LATENCY_INPUT_SAMPLE, base + 5000 * step);
+    TEST_ASSERT(!ve_latency_get_marker(10, VE_LATENCY_PRESENT, &marker));
+    ve_latency_mark_at(10, VE_LATENCY_PRESENT_COMPLETE, base);
+    TEST_ASSERT(!ve_latency_get_marker(10, VE_LATENCY_PRESENT_COMPLETE, NULL));
+    TEST_ASSERT(!ve_latency_get_marker(10 + VE_LATENCY_HISTORY, VE_LATENCY_PRESENT, NULL));
+
+    ve_latency_reset();
+    ve_latency_get_stats(&stats);
+    TEST_ASSERT(stats.frame_count == 0 && stats.input_to_present_ms == 0.0);
+    return true;
+}
+
+bool test_ecs_basic(void) {
+    printf("Running test_ecs_basic...\n");
+
+    ve_world* world = ve_world_create();
+    TEST_ASSERT(world != NULL);
+    TEST_ASSERT(ve_components_register(world));
+    ve_component_id tag = ve_ecs_register_component(world, "tag", 0, 1);
+    TEST_ASSERT(tag == VE_BUILTIN_COMPONENT_COUNT);
+
+    /* Enough entities to span many chunks */
+    enum { COUNT = 10000 };
+    static ve_entity entities[COUNT];
+    ve_component_mask renderable = VE_COMPONENT_BIT(VE_COMPONENT_TRANSFORM) | VE_COMPONENT_BIT(VE_COMPONENT_BOUNDS);
+    for (uint32_t i = 0; i < COUNT; i++) {
+        entities[i] = ve_ecs_create_entity_with(world, renderable);
+        TEST_ASSERT(entities[i] != VE_ENTITY_NULL);
+        ve_bounds_component* bounds = (ve_bounds_component*)ve_ecs_get_component(world, entities[i],
+                                                                                 VE_COMPONENT_BOUNDS);
+        TEST_ASSERT(bounds && bounds->radius == 0.0f);
+        bounds->radius = (float)i;
+    }
+    TEST_ASSERT(ve_ecs_get_entity_count(world) == COUNT);
+
+    /* Moving between archetypes keeps shared components and zeroes new ones */
+    for (uint32_t i = 0; i < COUNT; i += 2) {
+        ve_render_component* render = (ve_render_component*)ve_ecs_add_component(world, entities[i],
+                                                                                 VE_COMPONENT_RENDER);
+        TEST_ASSERT(render && render->mesh == 0);
+        render->mesh = i;
+    }
+    for (uint32_t i = 0; i < COUNT; i++) {
+        ve_bounds_component* bounds = (ve_bounds_component*)ve_ecs_get_component(world, entities[i],
+                                                                                 VE_COMPONENT_BOUNDS);
+        TEST_ASSERT(bounds && bounds->radius == (float)i);
+        TEST_ASSERT(ve_ecs_has_component(world, entities[i], VE_COMPONENT_RENDER) == (i % 2 == 0));
+    }
+    TEST_ASSERT(ve_ecs_add_component(world, entities[1], tag) != NULL);
+    TEST_ASSERT(ve_ecs_remove_component(world, entities[1], tag));
+    TEST_ASSERT(!ve_ecs_remove_component(world, entities[1], tag));
+
+    /* Queries visit dense, cache-line aligned columns */
+    ve_query with_render = {.all = renderable | VE_COMPONENT_BIT(VE_COMPONENT_RENDER)};
+    ve_query without_render = {.all = renderable, .none = VE_COMPONENT_BIT(VE_COMPONENT_RENDER)};
+    TEST_ASSERT(ve_query_count(world, &with_render) == COUNT / 2);
+    TEST_ASSERT(ve_query_count(world, &without_render) == COUNT / 2);
+
+    size_t line = (size_t)(ve_get_cpu_features()->cache_line_size > 0 ? ve_get_cpu_features()->cache_line_size : 64);
+    uint32_t visited = 0;
+    uint32_t chunks = 0;
+    ve_query_iter iter;
+    ve_query_iter_init(&iter, world, &with_render);
+    while (ve_query_next(&iter)) {
+        const ve_bounds_component* bounds = (const ve_bounds_component*)ve_query_column(&iter, VE_COMPONENT_BOUNDS);
+        const ve_render_component* render = (const ve_render_component*)ve_query_column(&iter, VE_COMPONENT_RENDER);
+        TEST_ASSERT(ve_is_aligned(bounds, line) && ve_is_aligned(render, line));
+        for (uint32_t i = 0; i < iter.count; i++) {
+            TEST_ASSERT(render[i].mesh == (uint32_t)bounds[i].radius);
+            TEST_ASSERT(ve_ecs_get_component(world, iter.entities[i], VE_COMPONENT_RENDER) == &render[i]);
+        }
+        visited += iter.count;
+        chunks++;
+    }
+    TEST_ASSERT(visited == COUNT / 2 && chunks > 1);
+    TEST_ASSERT(chunks * VE_ECS_CHUNK_SIZE >= visited * (sizeof(ve_entity) + sizeof(ve_transform_component) +
+                                                          sizeof(ve_bounds_component) + sizeof(ve_render_component)));
+
+    /* Stale handles stay dead after their slot is reused */
+    ve_entity stale = entities[3];
+    ve_ecs_destroy_entity(world, stale);
+    TEST_ASSERT(!ve_ecs_is_alive(world, stale));
+    TEST_ASSERT(ve_ecs_get_component(world, stale, VE_COMPONENT_BOUNDS) == NULL);
+    ve_entity reused = ve_ecs_create_entity(world);
+    TEST_ASSERT(reused != stale && ve_ecs_is_alive(world, reused) && !ve_ecs_is_alive(world, stale));
+    TEST_ASSERT(ve_ecs_get_mask(world, reused) == 0);
+    ve_ecs_destroy_entity(world, stale);
+    TEST_ASSERT(ve_ecs_get_entity_count(world) == COUNT);
+
+    /* Removing from the middle keeps the other entities intact */
+    for (uint32_t i = 0; i < COUNT; i += 3) {
+        ve_ecs_destroy_entity(world, entities[i]);
+    }
+    for (uint32_t i = 0; i < COUNT; i++) {
+        ve_bounds_component* bounds = (ve_bounds_component*)ve_ecs_get_component(world, entities[i],
+                                                                                 VE_COMPONENT_BOUNDS);
+        TEST_ASSERT((bounds != NULL) == (i % 3 != 0));
+        TEST_ASSERT(!bounds || bounds->radius == (float)i);
+    }
+
+    ve_world_destroy(world);
+    return true;
+}
+
+static void scheduler_move_system(const ve_system_context* context) {
+    ve_transform_component* transforms = (ve_transform_component*)ve_query_column(context->chunk,
+                                                                                VE_COMPONENT_TRANSFORM);
+    for (uint32_t i = 0; i < context->chunk->count; i++) {
+        transforms[i].position[0] += context->delta_time;
+    }
+}
+
+static void scheduler_bounds_system(const ve_system_context* context) {
+    const ve_transform_component* transforms = (const ve_transform_component*)ve_query_column(context->chunk,
+                                                                                            VE_COMPONENT_TRANSFORM);
+    ve_bounds_component* bounds = (ve_bounds_component*)ve_query_column(context->chunk, VE_COMPONENT_BOUNDS);
+    for (uint32_t i = 0; i < context->chunk->count; i++) {
+        memcpy(bounds[i].center, transforms[i].position, sizeof(bounds[i].center));
+    }
+}
+
+static void scheduler_render_system(const ve_system_context* context) {
+    ve_render_component* render = (ve_render_component*)ve_query_column(context->chunk, VE_COMPONENT_RENDER);
+    for (uint32_t i = 0; i < context->chunk->count; i++) {
+        render[i].flags++;
+    }
+}
+
+static void scheduler_tag_system(const ve_system_context* context) {
+    ve_component_id tag = *(const ve_component_id*)context->user_data;
+    const ve_bounds_component* bounds = (const ve_bounds_component*)ve_query_column(context->chunk,
+                                                                                  VE_COMPONENT_BOUNDS);
+    for (uint32_t i = 0; i < context->chunk->count; i++) {
+        if (bounds[i].center[0] > 0.0f) {
+            ve_ecs_commands_add_component(context->commands, context->chunk->entities[i], tag, NULL, 0);
+        }
+    }
+}
+
+bool test_ecs_scheduler(void) {
+    printf("Running test_ecs_scheduler...\n");
+
+    ve_world* world = ve_world_create();
+    TEST_ASSERT(world && ve_components_register(world));
+    ve_component_id tag = ve_ecs_register_component(world, "moved", 0, 1);
+
+    enum { COUNT = 20000 };
+    ve_component_mask all = VE_COMPONENT_BIT(VE_COMPONENT_TRANSFORM) | VE_COMPONENT_BIT(VE_COMPONENT_BOUNDS) |
+                            VE_COMPONENT_BIT(VE_COMPONENT_RENDER);
+    for (uint32_t i = 0; i < COUNT; i++) {
+        TEST_ASSERT(ve_ecs_create_entity_with(world, all) != VE_ENTITY_NULL);
+    }
+
+    ve_thread_pool* pool = ve_thread_pool_create(4);
+    TEST_ASSERT(pool != NULL);
+    ve_system_scheduler* scheduler = ve_scheduler_create(world, pool);
+    TEST_ASSERT(scheduler != NULL);
+
+    ve_system_desc systems[] = {
+        {.name = "move", .fn = scheduler_move_system, .writes = VE_COMPONENT_BIT(VE_COMPONENT_TRANSFORM)},
+        {.name = "bounds", .fn = scheduler_bounds_system, .reads = VE_COMPONENT_BIT(VE_COMPONENT_TRANSFORM),
+         .writes = VE_COMPONENT_BIT(VE_COMPONENT_BOUNDS)},
+        {.name = "render", .fn = scheduler_render_system, .writes = VE_COMPONENT_BIT(VE_COMPONENT_RENDER)},
+        {.name = "tag", .fn = scheduler_tag_system, .user_data = &tag, .reads = VE_COMPONENT_BIT(VE_COMPONENT_BOUNDS),
+         .exclude = VE_COMPONENT_BIT(tag), .serial = true},
+    };
+    for (uint32_t i = 0; i < sizeof(systems) / sizeof(systems[0]); i++) {
+        TEST_ASSERT(ve_scheduler_add_system(scheduler, &systems[i]) == i);
+    }
+
+    /* Only read/write conflicts create edges */
+    TEST_ASSERT(ve_scheduler_get_dependencies(scheduler, 0) == 0);
+    TEST_ASSERT(ve_scheduler_get_dependencies(scheduler, 1) == 1);
+    TEST_ASSERT(ve_scheduler_get_dependencies(scheduler, 2) == 0);
+    TEST_ASSERT(ve_scheduler_get_dependencies(scheduler, 3) == 2);
+
+    for (uint32_t frame = 0; frame < 3; frame++) {
+        ve_scheduler_run(scheduler, 0.5f);
+    }
+
+    /* The tag system sees bounds written after the move each frame; its commands apply at the end */
+    ve_query query = {.all = all};
+    uint32_t visited = 0;
+    ve_query_iter iter;
+    ve_query_iter_init(&iter, world, &query);
+    while (ve_query_next(&iter)) {
+        const ve_transform_component* transforms = (const ve_transform_component*)ve_query_column(
+            &iter, VE_COMPONENT_TRANSFORM);
+        const ve_bounds_component* bounds = (const ve_bounds_component*)ve_query_column(&iter, VE_COMPONENT_BOUNDS);
+        const ve_render_component* render = (const ve_render_component*)ve_query_column(&iter, VE_COMPONENT_RENDER);
+        for (uint32_t i = 0; i < iter.count; i++) {
+            TEST_ASSERT(transforms[i].position[0] == 1.5f);
+            TEST_ASSERT(bounds[i].center[0] == 1.5f);
+            TEST_ASSERT(render[i].flags == 3);
+            TEST_ASSERT(ve_ecs_has_component(world, iter.entities[i], tag));
+        }
+        visited += iter.count;
+    }
+    TEST_ASSERT(visited == COUNT);
+
+    ve_scheduler_destroy(scheduler);
+    ve_thread_pool_destroy(pool);
+    ve_world_destroy(world);
+    return true;
+}
+
+static void versions_count_system(const ve_system_context* context) {
+    *(uint32_t*)context->user_data += context->chunk->count;
+}
+
+bool test_ecs_change_versions(void) {
+    printf("Running test_ecs_change_versions...\n");
+
+    ve_world* world = ve_world_create();
+    TEST_ASSERT(world && ve_components_register(world));
+
+    enum { COUNT = 5000 };
+    static ve_entity entities[COUNT];
+    ve_component_mask mask = VE_COMPONENT_BIT(VE_COMPONENT_TRANSFORM) | VE_COMPONENT_BIT(VE_COMPONENT_BOUNDS);
+    for (uint32_t i = 0; i < COUNT; i++) {
+        entities[i] = ve_ecs_create_entity_with(world, mask);
+    }
+
+    /* New rows count as changes */
+    ve_query changed = {.all = mask, .changed = VE_COMPONENT_BIT(VE_COMPONENT_TRANSFORM)};
+    TEST_ASSERT(ve_query_count(world, &changed) == COUNT);
+    changed.changed_since = ve_ecs_advance_version(world);
+    TEST_ASSERT(ve_query_count(world, &changed) == 0);
+
+    /* A write marks only its chunk, and only for the written component */
+    ve_transform_component* transform = (ve_transform_component*)ve_ecs_write_component(world, entities[0],
+                                                                                      VE_COMPONENT_TRANSFORM);
+    TEST_ASSERT(transform != NULL);
+    uint32_t hits = ve_query_count(world, &changed);
+    TEST_ASSERT(hits > 0 && hits < COUNT);
+    ve_query bounds_changed = changed;
+    bounds_changed.changed = VE_COMPONENT_BIT(VE_COMPONENT_BOUNDS);
+    TEST_ASSERT(ve_query_count(world, &bounds_changed) == 0);
+
+    ve_query_iter iter;
+    ve_query_iter_init(&iter, world, &changed);
+    TEST_ASSERT(ve_query_next(&iter));
+    TEST_ASSERT(iter.count == hits);
+    TEST_ASSERT(!ve_query_next(&iter));
+
+    /* Systems filtered on changes skip what nobody touched since their last run */
+    changed.changed_since = ve_ecs_advance_version(world);
+    ve_system_scheduler* scheduler = ve_scheduler_create(world, NULL);
+    TEST_ASSERT(scheduler != NULL);
+    uint32_t visited = 0;
+    ve_system_desc incremental = {
+        .name = "incremental",
+        .fn = versions_count_system,
+        .user_data = &visited,
+        .reads = mask,
+        .changed = VE_COMPONENT_BIT(VE_COMPONENT_TRANSFORM),
+    };
+    ve_scheduler_add_system(scheduler, &incremental);
+
+    ve_scheduler_run(scheduler, 0.0f);
+    TEST_ASSERT(visited == COUNT);
+    visited = 0;
+    ve_scheduler_run(scheduler, 0.0f);
+    TEST_ASSERT(visited == 0);
+
+    ve_ecs_write_component(world, entities[COUNT - 1], VE_COMPONENT_TRANSFORM);
+    ve_scheduler_run(scheduler, 0.0f);
+    TEST_ASSERT(visited > 0 && visited < COUNT);
+
+    /* Removing an entity moves another into its row, which changes that chunk */
+    visited = 0;
+    ve_ecs_destroy_entity(world, entities[0]);
+    ve_scheduler_run(scheduler, 0.0f);
+    TEST_ASSERT(visited > 0 && visited < COUNT);
+
+    /* Wrap-around safe ordering */
+    TEST_ASSERT(ve_ecs_version_newer(2, 1) && !ve_ecs_version_newer(1, 1) && ve_ecs_version_newer(1, UINT32_MAX));
+    ve_scheduler_destroy(scheduler);
+
+    /* A consumer sees what a producer earlier in the same run wrote, every run, inline and on a pool */
+    ve_thread_pool* pool = ve_thread_pool_create(2);
+    TEST_ASSERT(pool != NULL);
+    for (int pass = 0; pass < 2; pass++) {
+        scheduler = ve_scheduler_create(world, pass == 0 ? NULL : pool);
+        TEST_ASSERT(scheduler != NULL);
+
+        uint32_t produced = 0;
+        uint32_t consumed = 0;
+        ve_system_desc producer = {
+            .name = "producer",
+            .fn = versions_count_system,
+            .user_data = &produced,
+            .writes = VE_COMPONENT_BIT(VE_COMPONENT_TRANSFORM),
+            .serial = true,
+        };
+        ve_system_desc consumer = {
+            .name = "consumer",
+            .fn = versions_count_system,
+            .user_data = &consumed,
+            .reads = VE_COMPONENT_BIT(VE_COMPONENT_TRANSFORM),
+            .changed = VE_COMPONENT_BIT(VE_COMPONENT_TRANSFORM),
+            .serial = true,
+        };
+        ve_scheduler_add_system(scheduler, &producer);
+        ve_scheduler_add_system(scheduler, &consumer);
+
+        for (int run = 0; run < 3; run++) {
+            produced = 0;
+            consumed = 0;
+            ve_scheduler_run(scheduler, 0.0f);
+            TEST_ASSERT(produced == COUNT - 1);
+            TEST_ASSERT(consumed == COUNT - 1);
+        }
+        ve_scheduler_destroy(scheduler);
+    }
+    ve_thread_pool_destroy(pool);
+
+    ve_world_destroy(world);
+    return true;
+}
+
+static float simd_test_random(uint32_t* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return (float)(*state >> 8) / (float)(1u << 24) * 2.0f - 1.0f;
+}
+
+static bool simd_test_close(float a, float b) {
+    return fabsf(a - b) <= 1e-4f * (1.0f + fabsf(b));
+}
+
+bool test_simd_kernels(void) {
+    printf("Running test_simd_kernels...\n");
+
+    enum { MATRICES = 37, POINTS = 103, BOXES = 1001 };
+    static ve_mat4 a[MATRICES], b[MATRICES], out[MATRICES];
+    static float x[POINTS], y[POINTS], z[POINTS], ox[POINTS], oy[POINTS], oz[POINTS];
+    static float cx[BOXES], cy[BOXES], cz[BOXES], ex[BOXES], ey[BOXES], ez[BOXES];
+    static uint32_t expected[BOXES], visible[BOXES];
+
+    uint32_t state = 1;
+    for (uint32_t i = 0; i < MATRICES; i++) {
+        for (int j = 0; j < 16; j++) {
+            a[i].m[j] = simd_test_random(&state);
+            b[i].m[j] = simd_test_random(&state);
+        }
+    }
+    for (uint32_t i = 0; i < POINTS; i++) {
+        x[i] = simd_test_random(&state) * 10.0f;
+        y[i] = simd_test_random(&state) * 10.0f;
+        z[i] = simd_test_random(&state) * 10.0f;
+    }
+    for (uint32_t i = 0; i < BOXES; i++) {
+        cx[i] = simd_test_random(&state) * 60.0f;
+        cy[i] = simd_test_random(&state) * 60.0f;
+        cz[i] = simd_test_random(&state) * 60.0f;
+        ex[i] = fabsf(simd_test_random(&state)) * 2.0f + 0.1f;
+        ey[i] = fabsf(simd_test_random(&state)) * 2.0f + 0.1f;
+        ez[i] = fabsf(simd_test_random(&state)) * 2.0f + 0.1f;
+    }
+
+    ve_mat4 view = ve_mat4_look_at(ve_vec3_make(0, 0, 20), ve_vec3_make(0, 0, 0), ve_vec3_make(0, 1, 0));
+    ve_mat4 projection = ve_mat4_perspective(VE_PI / 3.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+    ve_mat4 view_projection = ve_mat4_mul(&projection, &view);
+    ve_frustum frustum;
+    ve_frustum_from_matrix(&view_projection, &frustum);
+
+    /* The origin is in view, a point behind the camera is not */
+    float in_x = 0, in_y = 0, in_z = 0, behind_z = 30, extent = 0.5f;
+    ve_aabb_soa origin = {&in_x, &in_y, &in_z, &extent, &extent, &extent};
+    ve_aabb_soa behind = {&in_x, &in_y, &behind_z, &extent, &extent, &extent};
+    TEST_ASSERT(ve_frustum_cull_aabbs(&frustum, &origin, 1, visible) == 1);
+    TEST_ASSERT(ve_frustum_cull_aabbs(&frustum, &behind, 1, visible) == 0);
+
+    ve_aabb_soa boxes = {cx, cy, cz, ex, ey, ez};
+    ve_sphere_soa spheres = {cx, cy, cz, ex};
+    ve_simd_level previous = ve_simd_get_level();
+    TEST_ASSERT(ve_simd_set_level(VE_SIMD_SCALAR));
+    uint32_t expected_boxes = ve_frustum_cull_aabbs(&frustum, &boxes, BOXES, expected);
+    TEST_ASSERT(expected_boxes > 0 && expected_boxes < BOXES);
+
+    /* Every level this machine runs must agree with the single-value math */
+    for (int level = 0; level < VE_SIMD_LEVEL_COUNT; level++) {
+        if (!ve_simd_set_level((ve_simd_level)level)) {
+            continue;
+        }
+
+        ve_mat4_mul_batch(out, a, b, MATRICES);
+        for (uint32_t i = 0; i < MATRICES; i++) {
+            ve_mat4 reference = ve_mat4_mul(&a[i], &b[i]);
+            for (int j = 0; j < 16; j++) {
+                TEST_ASSERT(simd_test_close(out[i].m[j], reference.m[j]));
+            }
+        }
+
+        ve_transform_points_soa(&view_projection, x, y, z, ox, oy, oz, POINTS);
+        for (uint32_t i = 0; i < POINTS; i++) {
+            ve_vec3 reference = ve_mat4_transform_point(&view_projection, ve_vec3_make(x[i], y[i], z[i]));
+            TEST_ASSERT(simd_test_close(ox[i], reference.x));
+            TEST_ASSERT(simd_test_close(oy[i], reference.y));
+            TEST_ASSERT(simd_test_close(oz[i], reference.z));
+        }
+
+        TEST_ASSERT(ve_frustum_cull_aabbs(&frustum, &boxes, BOXES, visible) == expected_boxes);
+        TEST_ASSERT(memcmp(visible, expected, expected_boxes * sizeof(uint32_t)) == 0);
+
+        uint32_t sphere_count = ve_frustum_cull_spheres(&frustum, &spheres, BOXES, visible);
+        for (uint32_t i = 0; i < sphere_count; i++) {
+            TEST_ASSERT(i == 0 || visible[i] > visible[i - 1]);
+        }
+        ve_simd_set_level(VE_SIMD_SCALAR);
+        TEST_ASSERT(ve_frustum_cull_spheres(&frustum, &spheres, BOXES, expected) == sphere_count);
+        TEST_ASSERT(memcmp(visible, expected, sphere_count * sizeof(uint32_t)) == 0);
+        ve_frustum_cull_aabbs(&frustum, &boxes, BOXES, expected);
+    }
+
+    TEST_ASSERT(!ve_simd_set_level(VE_SIMD_LEVEL_COUNT));
+    ve_simd_set_level(previous);
+    return true;
+}
+
+bool test_meshlet_build(void) {
+    printf("Running test_meshlet_build...\n");
+
+    /* Flat 16x16 quad grid facing +Z, plus one degenerate triangle */
+    enum { GRID = 16, VERTS = (GRID + 1) * (GRID + 1), TRIS = GRID * GRID * 2 };
+    static float positions[VERTS][3];
+    static uint32_t indices[TRIS * 3 + 3];
+    for (uint32_t y = 0; y <= GRID; y++) {
+        for (uint32_t x = 0; x <= GRID; x++) {
+            float* p = positions[y * (GRID + 1) + x];
+            p[0] = (float)x;
+            p[1] = (float)y;
+            p[2] = 0.0f;
+        }
+    }
+    uint32_t index_count = 0;
+    for (uint32_t y = 0; y < GRID; y++) {
+        for (uint32_t x = 0; x < GRID; x++) {
+            uint32_t v = y * (GRID + 1) + x;
+            uint32_t quad[6] = {v, v + 1, v + GRID + 2, v, v + GRID + 2, v + GRID + 1};
+            memcpy(&indices[index_count], quad, sizeof(quad));
+            index_count += 6;
+        }
+    }
+    indices[index_count++] = 0;
+    indices[index_count++] = 0;
+    indices[index_count++] = 1;
+
+    ve_meshlet_data data;
+    TEST_ASSERT(ve_meshlet_build(indices, index_count, &positions[0][0], VERTS, sizeof(positions[0]), &data));
+    TEST_ASSERT(data.triangle_count == TRIS);
+    TEST_ASSERT(data.meshlet_count >= (TRIS + VE_MESHLET_MAX_TRIANGLES - 1) / VE_MESHLET_MAX_TRIANGLES);
+
+    /* Every triangle survives in order with its original vertices */
+    uint32_t triangle = 0;
+    float above[3] = {8.0f, 8.0f, 10.0f};
+    float below[3] = {8.0f, 8.0f, -10.0f};
+    for (uint32_t m = 0; m < data.meshlet_count; m++) {
+        const ve_meshlet* meshlet = &data.meshlets[m];
+        TEST_ASSERT(meshlet->vertex_count <= VE_MESHLET_MAX_VERTICES);
+        TEST_ASSERT(meshlet->triangle_count > 0 && meshlet->triangle_count <= VE_MESHLET_MAX_TRIANGLES);
+        for (uint32_t t = 0; t < meshlet->triangle_count; t++, triangle++) {
+            for (uint32_t k = 0; k < 3; k++) {
+                uint8_t local = data.triangles[meshlet->triangle_offset + t * 3 + k];
+                TEST_ASSERT(local < meshlet->vertex_count);
+                TEST_ASSERT(data.vertices[meshlet->vertex_offset + local] == indices[triangle * 3 + k]);
+            }
+        }
+        TEST_ASSERT(fabsf(meshlet->cone_axis[2] - 1.0f) < 1e-5f);
+        TEST_ASSERT(!ve_meshlet_is_backfacing(meshlet, above));
+        TEST_ASSERT(ve_meshlet_is_backfacing(meshlet, below));
+    }
+    TEST_ASSERT(triangle == TRIS);
+
+    ve_meshlet_free(&data);
+    TEST_ASSERT(data.meshlets == NULL && data.meshlet_count == 0);
+    return true;
+}
+
+static bool scene_test_translation(const ve_mat4* world, float x, float y, float z) {
+    return world && fabsf(world->m[12] - x) < 1e-4f && fabsf(world->m[13] - y) < 1e-4f &&
+           fabsf(world->m[14] - z) < 1e-4f;
+}
+
+/* Every triangle of a appears once in b with the same winding, vertices compared within tolerance */
+static bool triangles_match(const ve_mesh_vertex* a_vertices, const uint32_t* a_indices,
+                            const ve_mesh_vertex* b_vertices, const uint32_t* b_indices, uint32_t index_count,
+                            float tolerance) {
+    bool* used = (bool*)calloc(index_count / 3, sizeof(bool));
+    bool matched = true;
+    for (uint32_t t = 0; t < index_count / 3 && matched; t++) {
+        matched = false;
+        for (uint32_t u = 0; u < index_count / 3 && !matched; u++) {
+            for (uint32_t rotation = 0; rotation < 3 && !used[u] && !matched; rotation++) {
+                bool same = true;
+                for (uint32_t k = 0; k < 3 && same; k++) {
+                    const ve_mesh_vertex* va = &a_vertices[a_indices[t * 3 + k]];
+                    const ve_mesh_vertex* vb = &b_vertices[b_indices[u * 3 + (k + rotation) % 3]];
+                    for (uint32_t c = 0; c < 3; c++) {
+                        same &= fabsf(va->position[c] - vb->position[c]) <= tolerance;
+                    }
+                    same &= fabsf(va->uv[0] - vb->uv[0]) <= tolerance && fabsf(va->uv[1] - vb->uv[1]) <= tolerance;
+                }
+                matched = used[u] = same;
+            }
+        }
+    }
+    free(used);
+    return matched;
+}
+
+bool test_mesh_optimization(void) {
+    printf("Running test_mesh_optimization...\n");
+
+    /* 32x32 quad grid with its triangles shuffled, plus one vertex no triangle uses */
+    enum { GRID = 32, VERTS = (GRID + 1) * (GRID + 1) + 1, TRIS = GRID * GRID * 2 };
+    static ve_mesh_vertex vertices[VERTS];
+    static uint32_t source[TRIS * 3];
+    static uint32_t indices[TRIS * 3];
+    for (uint32_t y = 0; y <= GRID; y++) {
+        for (uint32_t x = 0; x <= GRID; x++) {
+            ve_mesh_vertex* vertex = &vertices[y * (GRID + 1) + x];
+            *vertex = (ve_mesh_vertex){{(float)x, (float)y, 0.0f}, {0.0f, 0.0f, 1.0f},
+                                       {(float)x / GRID, (float)y / GRID}};
+        }
+    }
+    vertices[VERTS - 1] = (ve_mesh_vertex){{-1.0f, -1.0f, -1.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f}};
+    uint32_t index_count = 0;
+    for (uint32_t y = 0; y < GRID; y++) {
+        for (uint32_t x = 0; x < GRID; x++) {
+            uint32_t v = y * (GRID + 1) + x;
+            uint32_t quad[6] = {v, v + 1, v + GRID + 2, v, v + GRID + 2, v + GRID + 1};
+            memcpy(&source[index_count], quad, sizeof(quad));
+            index_count += 6;
+        }
+    }
+    uint32_t state = 12345;
+    for (uint32_t t = TRIS - 1; t > 0; t--) {
+        state = state * 1664525u + 1013904223u;
+        uint32_t other = (state >> 8) % (t + 1);
+        uint32_t swap[3];
+        memcpy(swap, &source[t * 3], sizeof(swap));
+        memcpy(&source[t * 3], &source[other * 3], sizeof(swap));
+        memcpy(&source[other * 3], swap, sizeof(swap));
+    }
+    memcpy(indices, source, sizeof(indices));
+
+    /* Cache order: far fewer transforms per triangle than the shuffled order */
+    float shuffled_acmr = ve_mesh_get_acmr(indices, index_count, VE_MESH_VERTEX_CACHE_SIZE);
+    TEST_ASSERT(ve_mesh_optimize_vertex_cache(indices, index_count, VERTS));
+    float cache_acmr = ve_mesh_get_acmr(indices, index_count, VE_MESH_VERTEX_CACHE_SIZE);
+    TEST_ASSERT(shuffled_acmr > 2.0f && cache_acmr < 0.9f);
+    TEST_ASSERT(triangles_match(vertices, source, vertices, indices, index_count, 0.0f));
+
+    /* Overdraw order moves whole runs, so the cache order mostly survives */
+    TEST_ASSERT(ve_mesh_optimize_overdraw(indices, index_count, vertices[0].position, VERTS, sizeof(ve_mesh_vertex),
+                                          VE_MESH_OVERDRAW_THRESHOLD));
+    float overdraw_acmr = ve_mesh_get_acmr(indices, index_count, VE_MESH_VERTEX_CACHE_SIZE);
+    TEST_ASSERT(overdraw_acmr < cache_acmr * 1.25f);
+    TEST_ASSERT(triangles_match(vertices, source, vertices, indices, index_count, 0.0f));
+
+    /* Fetch order: vertices appear in the order indices first use them, the unused one is dropped */
+    static ve_mesh_vertex fetched[VERTS];
+    memcpy(fetched, vertices, sizeof(fetched));
+    uint32_t vertex_count = VERTS;
+    TEST_ASSERT(ve_mesh_optimize_vertex_fetch(fetched, &vertex_count, indices, index_count));
+    TEST_ASSERT(vertex_count == VERTS - 1);
+    uint32_t next = 0;
+    for (uint32_t i = 0; i < index_count; i++) {
+        TEST_ASSERT(indices[i] <= next);
+        next += indices[i] == next;
+    }
+    TEST_ASSERT(next == vertex_count);
+    TEST_ASSERT(triangles_match(vertices, source, fetched, indices, index_count, 0.0f));
+
+    /* Quantization: positions within a step of the bounds, unit normals, half precision texcoords */
+    ve_mesh_vertex samples[] = {
+        {{-3.0f, 0.5f, 2.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}},
+        {{5.0f, 0.5f, -2.0f}, {0.0f, 0.0f, -1.0f}, {0.5f, -2.25f}},
+        {{1.25f, 0.5f, 0.0f}, {0.6f, -0.48f, -0.64f}, {0.333f, 1000.5f}},
+        {{0.0f, 0.5f, 1.0f}, {-0.70710678f, 0.70710678f, 0.0f}, {65504.0f, 1e-6f}},
+        {{4.0f, 0.5f, -1.5f}, {0.0f, 0.0f, 0.0f}, {1e6f, -0.0f}},
+    };
+    enum { SAMPLES = sizeof(samples) / sizeof(samples[0]) };
+    float bounds_min[3] = {-3.0f, 0.5f, -2.0f};
+    float bounds_max[3] = {5.0f, 0.5f, 2.0f};
+    ve_mesh_vertex_packed packed[SAMPLES];
+    ve_mesh_vertex unpacked[SAMPLES];
+    TEST_ASSERT(sizeof(ve_mesh_vertex_packed) == 16);
+    ve_mesh_quantize(samples, SAMPLES, bounds_min, bounds_max, packed);
+    ve_mesh_dequantize(packed, SAMPLES, bounds_min, bounds_max, unpacked);
+    for (uint32_t i = 0; i < SAMPLES; i++) {
+        for (uint32_t c = 0; c < 3; c++) {
+            float step = (bounds_max[c] - bounds_min[c]) / 65535.0f;
+            TEST_ASSERT(fabsf(unpacked[i].position[c] - samples[i].position[c]) <= step * 0.5f + 1e-6f);
+        }
+        const float* n = unpacked[i].normal;
+        TEST_ASSERT(fabsf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2] - 1.0f) < 1e-5f);
+    }
+    TEST_ASSERT(packed[0].position[0] == 0 && packed[1].position[0] == 65535 && packed[1].position[1] == 0);
+    for (uint32_t i = 0; i < 4; i++) {
+        const float* a = samples[i].normal;
+        const float* b = unpacked[i].normal;
+        TEST_ASSERT(a[0] * b[0] + a[1] * b[1] + a[2] * b[2] > 0.99999f);
+        for (uint32_t c = 0; c < 2; c++) {
+            TEST_ASSERT(fabsf(unpacked[i].uv[c] - samples[i].uv[c]) <= fabsf(samples[i].uv[c]) / 2048.0f + 6e-8f);
+        }
+    }
+    TEST_ASSERT(unpacked[1].uv[1] == -2.25f && unpacked[3].uv[0] == 65504.0f);
+    TEST_ASSERT(isinf(unpacked[4].uv[0]) && unpacked[4].uv[1] == 0.0f && signbit(unpacked[4].uv[1]));
+    return true;
+}
+
+/* Grid of unit quads with heights from amplitude * sin(x / 3) * cos(y / 3) */
+static void lod_test_grid(uint32_t grid, float amplitude, ve_mesh_vertex* vertices, uint32_t* indices) {
+    for (uint32_t y = 0; y <= grid; y++) {
+        for (uint32_t x = 0; x <= grid; x++) {
+            float height = amplitude * sinf((float)x / 3.0f) * cosf((float)y / 3.0f);
+            vertices[y * (grid + 1) + x] = (ve_mesh_vertex){{(float)x, (float)y, height}, {0.0f, 0.0f, 1.0f},
+                                                            {(float)x / grid, (float)y / grid}};
+        }
+    }
+    for (uint32_t y = 0; y < grid; y++) {
+        for (uint32_t x = 0; x < grid; x++) {
+            uint32_t v = y * (grid + 1) + x;
+            uint32_t quad[6] = {v, v + 1, v + grid + 2, v, v + grid + 2, v + grid + 1};
+            memcpy(&indices[(y * grid + x) * 6], quad, sizeof(quad));
+        }
+    }
+}
+
+bool test_mesh_lod(void) {
+    printf("Running test_mesh_lod...\n");
+
+    enum { GRID = 32, VERTS = (GRID + 1) * (GRID + 1), INDICES = GRID * GRID * 6 };
+    static ve_mesh_vertex vertices[VERTS + 1];
+    static uint32_t indices[INDICES];
+    static uint32_t simplified[INDICES];
+
+    /* Flat: every interior vertex collapses for free, except the seam at the center */
+    lod_test_grid(GRID, 0.0f, vertices, indices);
+    uint32_t center = (GRID / 2) * (GRID + 1) + GRID / 2;
+    vertices[VERTS] = vertices[center];
+    vertices[VERTS].uv[0] = 2.0f;
+    indices[(GRID / 2 * GRID + GRID / 2) * 6] = VERTS;
+    uint32_t count = 0;
+    float error = 1.0f;
+    TEST_ASSERT(ve_mesh_simplify(indices, INDICES, vertices[0].position, VERTS + 1, sizeof(ve_mesh_vertex),
+                                 INDICES / 8, 1e-4f, simplified, &count, &error));
+    TEST_ASSERT(count <= INDICES / 8 && count % 3 == 0 && error == 0.0f);
+    bool center_kept = false;
+    bool twin_kept = false;
+    for (uint32_t i = 0; i < count; i += 3) {
+        const float* a = vertices[simplified[i]].position;
+        const float* b = vertices[simplified[i + 1]].position;
+        const float* c = vertices[simplified[i + 2]].position;
+        float cross_z = (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+        TEST_ASSERT(cross_z > 0.0f);
+        for (uint32_t k = 0; k < 3; k++) {
+            center_kept |= simplified[i + k] == center;
+            twin_kept |= simplified[i + k] == VERTS;
+        }
+    }
+    TEST_ASSERT(center_kept && twin_kept);
+
+    /* Curved: the error bound stops simplification short of the target */
+    lod_test_grid(GRID, 1.0f, vertices, indices);
+    TEST_ASSERT(ve_mesh_simplify(indices, INDICES, vertices[0].position, VERTS, sizeof(ve_mesh_vertex), 0, 0.02f,
+                                 simplified, &count, &error));
+    TEST_ASSERT(count > INDICES / 2 && count < INDICES && error <= 0.02f);
+    uint32_t tight_count = count;
+    TEST_ASSERT(ve_mesh_simplify(indices, INDICES, vertices[0].position, VERTS, sizeof(ve_mesh_vertex), 0, 0.16f,
+                                 simplified, &count, &error));
+    TEST_ASSERT(count < tight_count / 4 && error > 0.02f && error <= 0.16f);
+
+    /* Cooked chain: consecutive ranges, fewer triangles and more error per level */
+    void* blob = NULL;
+    size_t size = 0;
+    TEST_ASSERT(ve_mesh_cook(vertices, VERTS, indices, INDICES, &blob, &size));
+    ve_mesh_data mesh;
+    TEST_ASSERT(ve_mesh_view(blob, size, &mesh));
+    TEST_ASSERT(mesh.lod_count > 2 && mesh.lod_count <= VE_MESH_MAX_LODS);
+    TEST_ASSERT(mesh.lods[0].index_offset == 0 && mesh.lods[0].index_count == INDICES && mesh.lods[0].error == 0.0f);
+    uint32_t total = mesh.lods[0].index_count;
+    for (uint32_t i = 1; i < mesh.lod_count; i++) {
+        const ve_mesh_lod* lod = &mesh.lods[i];
+        TEST_ASSERT(lod->index_offset == total && lod->index_count < mesh.lods[i - 1].index_count);
+        TEST_ASSERT(lod->error >= mesh.lods[i - 1].error && lod->error <= 0.05f * sqrtf(2.0f * GRID * GRID + 4.0f));
+        for (uint32_t j = 0; j < lod->index_count; j++) {
+            TEST_ASSERT(mesh.indices[lod->index_offset + j] < mesh.vertex_count);
+        }
+        total += lod->index_count;
+    }
+    TEST_ASSERT(mesh.index_count == total);
+    VE_FREE(blob);
+
+    /* Selection: coarser with distance, only past the hysteresis band on the way out */
+    TEST_ASSERT(ve_frame_allocator_init(1, 1024 * 1024));
+    ve_frame_allocator_begin(0);
+    ve_scene* scene = ve_scene_create();
+    TEST_ASSERT(scene != NULL);
+    ve_node node = ve_node_create(ve_scene_get_nodes(scene), VE_NODE_NULL);
+    ve_aabb unit = {ve_vec3_make(-0.5f, -0.5f, -0.5f), ve_vec3_make(0.5f, 0.5f, 0.5f)};
+    TEST_ASSERT(ve_scene_set_bounds(scene, node, &unit));
+    float errors[3] = {0.0f, 0.01f, 0.1f};
+    ve_scene_set_lods(scene, node, errors, 3);
+    TEST_ASSERT(ve_scene_update(scene, NULL));
+
+    /* With a 60 degree field of view level 1 fits from 9.4 units away and level 2 from 94 */
+    ve_camera camera;
+    ve_camera_init_perspective(&camera, VE_PI / 3.0f, 1.0f, 0.1f, 1000.0f);
+    float distances[] = {5.0f, 11.0f, 13.0f, 11.0f, 8.0f, 200.0f, 110.0f, 90.0f};
+    uint32_t expected[] = {0, 0, 1, 1, 0, 2, 2, 1};
+    for (uint32_t i = 0; i < sizeof(distances) / sizeof(distances[0]); i++) {
+        ve_camera_look_at(&camera, ve_vec3_make(0, 0, distances[i]), ve_vec3_make(0, 0, 0), ve_vec3_make(0, 1, 0));
+        ve_camera_update(&camera);
+        TEST_ASSERT(ve_camera_cull(&camera, scene, NULL));
+        TEST_ASSERT(camera.visibility.count == 1 && camera.visibility.instances[0].lod == expected[i]);
+    }
+
+    /* Views keep separate histories */
+    TEST_ASSERT(ve_scene_select_lod(scene, node, 1, 0.866f / 11.0f, VE_CAMERA_LOD_THRESHOLD) == 0);
+    TEST_ASSERT(ve_scene_select_lod(scene, node, 0, 0.866f / 11.0f, VE_CAMERA_LOD_THRESHOLD) == 1);
+
+    ve_scene_destroy(scene);
+    ve_frame_allocator_shutdown();
+    return true;
+}
+
+bool test_scene_graph(void) {
+    printf("Running test_scene_graph...\n");
+
+    ve_scene* scene = ve_scene_create();
+    TEST_ASSERT(scene != NULL);
+    ve_node_graph* graph = ve_scene_get_nodes(scene);
+
+    ve_quat identity = ve_quat_identity();
+    ve_vec3 one = ve_vec3_make(1, 1, 1);
+    ve_node root = ve_node_create(graph, VE_NODE_NULL);
+    ve_node child = ve_node_create(graph, root);
+    ve_node grandchild = ve_node_create(graph, child);
+    ve_node other = ve_node_create(graph, VE_NODE_NULL);
+    TEST_ASSERT(root && child && grandchild && other);
+    TEST_ASSERT(ve_node_get_parent(graph, grandchild) == child);
+    ve_node_set_trs(graph, root, ve_vec3_make(1, 0, 0), identity, one);
+    ve_node_set_trs(graph, child, ve_vec3_make(0, 2, 0), identity, one);
+    ve_node_set_trs(graph, grandchild, ve_vec3_make(0, 0, 3), identity, one);
+    ve_node_set_trs(graph, other, ve_vec3_make(5, 0, 0), identity, one);
+
+    TEST_ASSERT(ve_scene_update(scene, NULL));
+    TEST_ASSERT(ve_node_graph_get_level_count(graph) == 3);
+    TEST_ASSERT(scene_test_translation(ve_node_get_world(graph, grandchild), 1, 2, 3));
+    TEST_ASSERT(scene_test_translation(ve_node_get_world(graph, other), 5, 0, 0));
+
+    /* Only the moved subtree is recomputed */
+    uint32_t first = ve_node_graph_get_version(graph);
+    ve_node_set_trs(graph, child, ve_vec3_make(0, 4, 0), identity, one);
+    uint32_t second = ve_node_graph_update(graph, NULL);
+    TEST_ASSERT(second != first);
+    TEST_ASSERT(ve_node_get_world_version(graph, root) == first);
+    TEST_ASSERT(ve_node_get_world_version(graph, other) == first);
+    TEST_ASSERT(ve_node_get_world_version(graph, grandchild) == second);
+    TEST_ASSERT(scene_test_translation(ve_node_get_world(graph, grandchild), 1, 4, 3));
+
+    /* Reparenting re-sorts the levels; cycles are refused */
+    TEST_ASSERT(!ve_node_set_parent(graph, root, grandchild));
+    TEST_ASSERT(ve_node_set_parent(graph, child, other));
+    TEST_ASSERT(ve_scene_update(scene, NULL));
+    TEST_ASSERT(scene_test_translation(ve_node_get_world(graph, grandchild), 5, 4, 3));
+    TEST_ASSERT(ve_node_get_world_version(graph, root) == first);
+
+    /* Destroying a node takes its subtree with it at the next update */
+    ve_node_destroy(graph, other);
+    TEST_ASSERT(!ve_node_is_alive(graph, other));
+    TEST_ASSERT(ve_scene_update(scene, NULL));
+    TEST_ASSERT(!ve_node_is_alive(graph, child) && !ve_node_is_alive(graph, grandchild));
+    TEST_ASSERT(ve_node_is_alive(graph, root));
+    TEST_ASSERT(ve_node_graph_get_count(graph) == 1);
+    TEST_ASSERT(ve_node_graph_get_level_count(graph) == 1);
+    TEST_ASSERT(ve_node_create(graph, grandchild) == VE_NODE_NULL);
+
+    /* Wide levels split across the pool give the same matrices as a serial pass */
+    enum { WIDE = 3000 };
+    static ve_node wide[WIDE];
+    static ve_node leaves[WIDE];
+    for (uint32_t i = 0; i < WIDE; i++) {
+        wide[i] = ve_node_create(graph, root);
+        leaves[i] = ve_node_create(graph, wide[i]);
+        TEST_ASSERT(wide[i] && leaves[i]);
+        ve_node_set_trs(graph, wide[i], ve_vec3_make((float)i, 0, 0), identity, one);
+        ve_node_set_trs(graph, leaves[i], ve_vec3_make(0, 0, (float)i),
+                        ve_quat_from_axis_angle(ve_vec3_make(0, 1, 0), 0.001f * (float)i), one);
+    }
+    ve_node_set_trs(graph, root, ve_vec3_make(0, 1, 0), ve_quat_from_axis_angle(ve_vec3_make(0, 0, 1), 0.5f), one);
+
+    ve_thread_pool* pool = ve_thread_pool_create(4);
+    TEST_ASSERT(pool != NULL);
+    TEST_ASSERT(ve_scene_update(scene, pool));
+    for (uint32_t i = 0; i < WIDE; i++) {
+        ve_mat4 expected = ve_mat4_mul(ve_node_get_world(graph, wide[i]), ve_node_get_local(graph, leaves[i]));
+        const ve_mat4* world = ve_node_get_world(graph, leaves[i]);
+        for (int j = 0; j < 16; j++) {
+            TEST_ASSERT(fabsf(world->m[j] - expected.m[j]) <= 1e-3f * (1.0f + fabsf(expected.m[j])));
+        }
+    }
+    ve_thread_pool_destroy(pool);
+
+    ve_scene_destroy(scene);
+    return true;
+}
+
+static bool bvh_test_aabb_in_frustum(const ve_frustum* frustum, const ve_aabb* box) {
+    float cx = (box->min.x + box->max.x) * 0.5f, ex = (box->max.x - box->min.x) * 0.5f;
+    float cy = (box->min.y + box->max.y) * 0.5f, ey = (box->max.y - box->min.y) * 0.5f;
+    float cz = (box->min.z + box->max.z) * 0.5f, ez = (box->max.z - box->min.z) * 0.5f;
+    uint32_t visible;
+    ve_aabb_soa soa = {&cx, &cy, &cz, &ex, &ey, &ez};
+    return ve_frustum_cull_aabbs(frustum, &soa, 1, &visible) == 1;
+}
+
+static float bvh_test_ray_box(const ve_aabb* box, ve_vec3 origin, ve_vec3 direction) {
+    float near = 0.0f, far = FLT_MAX;
+    const float* o = &origin.x;
+    const float* d = &direction.x;
+    for (int axis = 0; axis < 3; axis++) {
+        float t0 = ((&box->min.x)[axis] - o[axis]) / d[axis];
+        float t1 = ((&box->max.x)[axis] - o[axis]) / d[axis];
+        near = fmaxf(near, fminf(t0, t1));
+        far = fminf(far, fmaxf(t0, t1));
+    }
+    return near <= far ? near : -1.0f;
+}
+
+/* Every user value in found must be in expected and vice versa */
+static bool bvh_test_same_set(const uint32_t* found, uint32_t found_count, const uint32_t* expected,
+                              uint32_t expected_count, uint32_t universe) {
+    static uint8_t marks[4096];
+    if (found_count != expected_count || universe > sizeof(marks)) {
+        return false;
+    }
+    memset(marks, 0, universe);
+    for (uint32_t i = 0; i < expected_count; i++) {
+        marks[expected[i]] = 1;
+    }
+    for (uint32_t i = 0; i < found_count; i++) {
+        if (marks[found[i]] != 1) {
+            return false;
+        }
+        marks[found[i]] = 2;
+    }
+    return true;
+}
+
+static bool bvh_test_queries(const ve_bvh* bvh, const ve_aabb* boxes, const bool* live, uint32_t count,
+                             const ve_frustum* frustum, uint32_t* seed) {
+    static uint32_t found[4096], expected[4096];
+    uint32_t expected_count = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (live[i] && bvh_test_aabb_in_frustum(frustum, &boxes[i])) {
+            expected[expected_count++] = i;
+        }
+    }
+    uint32_t found_count = ve_bvh_cull_frustum(bvh, frustum, found, 4096);
+    TEST_ASSERT(bvh_test_same_set(found, found_count, expected, expected_count, count));
+
+    ve_aabb range = {ve_vec3_make(-20, -20, -20), ve_vec3_make(15, 25, 5)};
+    expected_count = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (live[i] && ve_aabb_overlaps(&boxes[i], &range)) {
+            expected[expected_count++] = i;
+        }
+    }
+    found_count = ve_bvh_query_aabb(bvh, &range, found, 4096);
+    TEST_ASSERT(bvh_test_same_set(found, found_count, expected, expected_count, count));
+
+    for (int ray = 0; ray < 32; ray++) {
+        ve_vec3 origin = ve_vec3_make(simd_test_random(seed) * 120.0f, simd_test_random(seed) * 120.0f, 150.0f);
+        ve_vec3 direction = ve_vec3_make(simd_test_random(seed) * 0.3f, simd_test_random(seed) * 0.3f, -1.0f);
+        float closest = FLT_MAX;
+        for (uint32_t i = 0; i < count; i++) {
+            float t = live[i] ? bvh_test_ray_box(&boxes[i], origin, direction) : -1.0f;
+            if (t >= 0.0f && t < closest) {
+                closest = t;
+            }
+        }
+        ve_bvh_hit hit;
+        bool any = ve_bvh_raycast(bvh, origin, direction, FLT_MAX, NULL, NULL, &hit);
+        TEST_ASSERT(any == (closest < FLT_MAX));
+        TEST_ASSERT(!any || fabsf(hit.distance - closest) <= 1e-3f * (1.0f + closest));
+    }
+    return true;
+}
+
+bool test_scene_bvh(void) {
+    printf("Running test_scene_bvh...\n");
+
+    enum { BOXES = 3000 };
+    static ve_aabb boxes[BOXES];
+    static uint32_t proxies[BOXES];
+    static bool live[BOXES];
+
+    ve_bvh* bvh = ve_bvh_create();
+    TEST_ASSERT(bvh != NULL);
+
+    /* Inserting along a sweep is the worst case for greedy insertion */
+    uint32_t seed = 7;
+    for (uint32_t i = 0; i < BOXES; i++) {
+        ve_vec3 center = ve_vec3_make((float)i * 0.08f - 120.0f, simd_test_random(&seed) * 120.0f,
+                                      simd_test_random(&seed) * 120.0f);
+        ve_vec3 extent = ve_vec3_make(0.5f + fabsf(simd_test_random(&seed)), 0.5f, 0.5f);
+        boxes[i] = (ve_aabb){ve_vec3_sub(center, extent), ve_vec3_add(center, extent)};
+        proxies[i] = ve_bvh_insert(bvh, &boxes[i], i);
+        TEST_ASSERT(proxies[i] != VE_BVH_INVALID);
+        live[i] = true;
+    }
+    TEST_ASSERT(ve_bvh_get_count(bvh) == BOXES);
+
+    ve_mat4 view = ve_mat4_look_at(ve_vec3_make(0, 0, 150), ve_vec3_make(0, 0, 0), ve_vec3_make(0, 1, 0));
+    ve_mat4 projection = ve_mat4_perspective(VE_PI / 4.0f, 1.0f, 1.0f, 400.0f);
+    ve_mat4 view_projection = ve_mat4_mul(&projection, &view);
+    ve_frustum frustum;
+    ve_frustum_from_matrix(&view_projection, &frustum);
+    TEST_ASSERT(bvh_test_queries(bvh, boxes, live, BOXES, &frustum, &seed));
+
+    /* Move a third, remove a third */
+    for (uint32_t i = 0; i < BOXES; i += 3) {
+        ve_vec3 offset = ve_vec3_make(simd_test_random(&seed) * 30.0f, simd_test_random(&seed) * 30.0f, 0.0f);
+        boxes[i].min = ve_vec3_add(boxes[i].min, offset);
+        boxes[i].max = ve_vec3_add(boxes[i].max, offset);
+        ve_bvh_move(bvh, proxies[i], &boxes[i]);
+        ve_bvh_remove(bvh, proxies[i + 1]);
+        live[i + 1] = false;
+    }
+    TEST_ASSERT(ve_bvh_get_count(bvh) == BOXES - BOXES / 3);
+    TEST_ASSERT(ve_bvh_get_user(bvh, proxies[3]) == 3);
+    TEST_ASSERT(bvh_test_queries(bvh, boxes, live, BOXES, &frustum, &seed));
+
+    /* Rebuilding with the SAH beats the incrementally grown tree */
+    float incremental_cost = ve_bvh_get_sah_cost(bvh);
+    TEST_ASSERT(ve_bvh_optimize(bvh, 64) > 0);
+    TEST_ASSERT(bvh_test_queries(bvh, boxes, live, BOXES, &frustum, &seed));
+    TEST_ASSERT(ve_bvh_optimize(bvh, BOXES) == BOXES - BOXES / 3);
+    TEST_ASSERT(ve_bvh_optimize(bvh, BOXES) == 0);
+    TEST_ASSERT(ve_bvh_get_sah_cost(bvh) < incremental_cost);
+    TEST_ASSERT(bvh_test_queries(bvh, boxes, live, BOXES, &frustum, &seed));
+
+    /* Removed proxies are reused */
+    uint32_t reused = ve_bvh_insert(bvh, &boxes[1], 1);
+    live[1] = true;
+    TEST_ASSERT(reused < BOXES);
+    TEST_ASSERT(bvh_test_queries(bvh, boxes, live, BOXES, &frustum, &seed));
+    ve_bvh_destroy(bvh);
+
+    /* Scene bounds follow their nodes */
+    ve_scene* scene = ve_scene_create();
+    TEST_ASSERT(scene != NULL);
+    ve_node_graph* graph = ve_scene_get_nodes(scene);
+    ve_node parent = ve_node_create(graph, VE_NODE_NULL);
+    ve_node child = ve_node_create(graph, parent);
+    ve_aabb unit = {ve_vec3_make(-1, -1, -1), ve_vec3_make(1, 1, 1)};
+    TEST_ASSERT(ve_scene_set_bounds(scene, child, &unit));
+    ve_node_set_trs(graph, child, ve_vec3_make(10, 0, 0), ve_quat_identity(), ve_vec3_make(1, 1, 1));
+    TEST_ASSERT(ve_scene_update(scene, NULL));
+
+    uint32_t users[4];
+    ve_aabb probe = {ve_vec3_make(9.5f, -0.5f, -0.5f), ve_vec3_make(10.5f, 0.5f, 0.5f)};
+    TEST_ASSERT(ve_bvh_query_aabb(ve_scene_get_bvh(scene), &probe, users, 4) == 1 && users[0] == child);
+
+    ve_node_set_trs(graph, parent, ve_vec3_make(0, 50, 0), ve_quat_identity(), ve_vec3_make(1, 1, 1));
+    TEST_ASSERT(ve_scene_update(scene, NULL));
+    TEST_ASSERT(ve_bvh_query_aabb(ve_scene_get_bvh(scene), &probe, users, 4) == 0);
+    ve_bvh_hit hit;
+    TEST_ASSERT(ve_bvh_raycast(ve_scene_get_bvh(scene), ve_vec3_make(10, 50, 20), ve_vec3_make(0, 0, -1), 100.0f,
+                               NULL, NULL, &hit));
+    TEST_ASSERT(hit.user == child && fabsf(hit.distance - 19.0f) < 1e-4f);
+
+    ve_node_destroy(graph, parent);
+    TEST_ASSERT(ve_scene_update(scene, NULL));
+    TEST_ASSERT(ve_bvh_get_count(ve_scene_get_bvh(scene)) == 0);
+
+    ve_scene_destroy(scene);
+    return true;
+}
+
+static bool camera_test_visible_list(const ve_camera* camera, ve_scene* scene, const ve_node* nodes,
+                                     const ve_aabb* boxes, uint32_t count) {
+    const ve_camera_visibility* visibility = &camera->visibility;
+    uint32_t expected = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        expected += bvh_test_aabb_in_frustum(&camera->frustum, &boxes[i]);
+    }
+    TEST_ASSERT(visibility->count == expected);
+
+    for (uint32_t i = 0; i < visibility->count; i++) {
+        const ve_visible_instance* instance = &visibility->instances[i];
+        uint32_t index = instance->node & (VE_NODE_MAX_NODES - 1);
+        TEST_ASSERT(index < count && nodes[index] == instance->node);
+        TEST_ASSERT(bvh_test_aabb_in_frustum(&camera->frustum, &boxes[index]));
+
+        uint32_t pipeline, material;
+        TEST_ASSERT(ve_scene_get_render(scene, instance->node, &pipeline, &material));
+        TEST_ASSERT(instance->pipeline == pipeline && instance->material == material);
+
+        if (i > 0) {
+            const ve_visible_instance* prev = &visibility->instances[i - 1];
+            TEST_ASSERT(prev->node != instance->node);
+            bool ordered = prev->pipeline < instance->pipeline ||
+                           (prev->pipeline == instance->pipeline &&
+                            (prev->material < instance->material ||
+                             (prev->material == instance->material && prev->depth <= instance->depth)));
+            TEST_ASSERT(ordered);
+        }
+    }
+    return true;
+}
+
+/* Every visible instance is drawn once, by a draw matching its pipeline, material, mesh and level of detail */
+static bool camera_test_draws(const ve_camera* camera, uint32_t count) {
+    static uint32_t position_of[4000];
+    static bool drawn[4000];
+    TEST_ASSERT(count <= 4000);
+
+    const ve_camera_visibility* visibility = &camera->visibility;
+    for (uint32_t i = 0; i < visibility->count; i++) {
+        TEST_ASSERT(visibility->instances[i].instance < count);
+        position_of[visibility->instances[i].instance] = i;
+        drawn[visibility->instances[i].instance] = false;
+    }
+
+    ve_camera_draws draws;
+    TEST_ASSERT(ve_camera_build_draws(camera, &draws));
+    TEST_ASSERT(draws.instance_count == visibility->count);
+    TEST_ASSERT(draws.draw_count > 0 && draws.draw_count < draws.instance_count);
+
+    uint32_t next = 0;
+    uint32_t run_start = 0;
+    for (uint32_t d = 0; d < draws.draw_count; d++) {
+        const ve_instanced_draw* draw = &draws.draws[d];
+        TEST_ASSERT(draw->first_instance == next && draw->instance_count > 0);
+        next += draw->instance_count;
+
+        if (d > 0 && (draw->pipeline != draws.draws[d - 1].pipeline || draw->material != draws.draws[d - 1].material)) {
+            run_start = d;
+        }
+        for (uint32_t other = run_start; other < d; other++) {
+            TEST_ASSERT(draws.draws[other].mesh != draw->mesh || draws.draws[other].lod != draw->lod);
+        }
+
+        for (uint32_t i = 0; i < draw->instance_count; i++) {
+            uint32_t slot = draws.instances[draw->first_instance + i];
+            TEST_ASSERT(slot < count && !drawn[slot]);
+            drawn[slot] = true;
+            const ve_visible_instance* instance = &visibility->instances[position_of[slot]];
+            TEST_ASSERT(instance->pipeline == draw->pipeline && instance->material == draw->material);
+            TEST_ASSERT(instance->mesh == draw->mesh && instance->lod == draw->lod);
+        }
+    }
+    TEST_ASSERT(next == draws.instance_count);
+
+    /* Pipeline and material order follows the visible list */
+    uint32_t position = 0;
+    for (uint32_t d = 0; d < draws.draw_count; d++) {
+        while (visibility->instances[position].pipeline != draws.draws[d].pipeline ||
+               visibility->instances[position].material != draws.draws[d].material) {
+            position++;
+            TEST_ASSERT(position < visibility->count);
+        }
+    }
+    return true;
+}
+
+bool test_camera_visibility(void) {
+    printf("Running test_camera_visibility...\n");
+
+    enum { INSTANCES = 4000, CAMERAS = 3 };
+    static ve_node nodes[INSTANCES];
+    static ve_aabb boxes[INSTANCES];
+
+    TEST_ASSERT(ve_frame_allocator_init(3, 16 * 1024 * 1024));
+    ve_frame_allocator_begin(0);
+
+    ve_scene* scene = ve_scene_create();
+    TEST_ASSERT(scene != NULL);
+    ve_node_graph* graph = ve_scene_get_nodes(scene);
+
+    uint32_t seed = 11;
+    ve_aabb unit = {ve_vec3_make(-0.5f, -0.5f, -0.5f), ve_vec3_make(0.5f, 0.5f, 0.5f)};
+    for (uint32_t i = 0; i < INSTANCES; i++) {
+        nodes[i] = ve_node_create(graph, VE_NODE_NULL);
+        TEST_ASSERT(nodes[i] != VE_NODE_NULL);
+        ve_vec3 position = ve_vec3_make(simd_test_random(&seed) * 100.0f, simd_test_random(&seed) * 100.0f,
+                                        simd_test_random(&seed) * 100.0f);
+        ve_node_set_trs(graph, nodes[i], position, ve_quat_identity(), ve_vec3_make(1, 1, 1));
+        boxes[i] = (ve_aabb){ve_vec3_add(position, unit.min), ve_vec3_add(position, unit.max)};
+        TEST_ASSERT(ve_scene_set_bounds(scene, nodes[i], &unit));
+        ve_scene_set_render(scene, nodes[i], i % 3, (i * 7) % 5);
+        ve_scene_set_instance(scene, nodes[i], i % 4, i);
+    }
+    TEST_ASSERT(ve_scene_update(scene, NULL));
+
+    ve_camera cameras[CAMERAS];
+    ve_camera_init_perspective(&cameras[0], VE_PI / 3.0f, 16.0f / 9.0f, 0.5f, 300.0f);
+    ve_camera_look_at(&cameras[0], ve_vec3_make(0, 0, 150), ve_vec3_make(0, 0, 0), ve_vec3_make(0, 1, 0));
+    ve_camera_init_perspective(&cameras[1], VE_PI / 2.0f, 1.0f, 1.0f, 120.0f);
+    ve_mat4 view = ve_mat4_look_at(ve_vec3_make(40, 60, 0), ve_vec3_make(0, 0, 0), ve_vec3_make(0, 0, 1));
+    ve_camera_set_view(&cameras[1], &view);
+    TEST_ASSERT(fabsf(cameras[1].position.x - 40.0f) < 1e-3f && fabsf(cameras[1].position.y - 60.0f) < 1e-3f);
+    ve_camera_init_perspective(&cameras[2], VE_PI / 6.0f, 1.0f, 1.0f, 500.0f);
+    ve_camera_look_at(&cameras[2], ve_vec3_make(0, -200, 0), ve_vec3_make(0, 0, 0), ve_vec3_make(0, 0, 1));
+    for (uint32_t i = 0; i < CAMERAS; i++) {
+        cameras[i].lod_view = i;
+        ve_camera_update(&cameras[i]);
+    }
+
+    /* Single threaded, one camera at a time */
+    for (uint32_t i = 0; i < CAMERAS; i++) {
+        TEST_ASSERT(ve_camera_cull(&cameras[i], scene, NULL));
+        TEST_ASSERT(cameras[i].visibility.count > 0);
+        TEST_ASSERT(camera_test_visible_list(&cameras[i], scene, nodes, boxes, INSTANCES));
+        TEST_ASSERT(camera_test_draws(&cameras[i], INSTANCES));
+    }
+
+    /* All cameras at once, each split across the pool */
+    ve_thread_pool* pool = ve_thread_pool_create(4);
+    TEST_ASSERT(pool != NULL);
+    uint32_t single_counts[CAMERAS];
+    for (uint32_t i = 0; i < CAMERAS; i++) {
+        single_counts[i] = cameras[i].visibility.count;
+    }
+    TEST_ASSERT(ve_camera_cull_many(cameras, CAMERAS, scene, pool));
+    for (uint32_t i = 0; i < CAMERAS; i++) {
+        TEST_ASSERT(cameras[i].visibility.count == single_counts[i]);
+        TEST_ASSERT(camera_test_visible_list(&cameras[i], scene, nodes, boxes, INSTANCES));
+    }
+    ve_thread_pool_destroy(pool);
+
+    /* An empty scene leaves an empty list */
+    for (uint32_t i = 0; i < INSTANCES; i++) {
+        ve_node_destroy(graph, nodes[i]);
+    }
+    TEST_ASSERT(ve_scene_update(scene, NULL));
+    TEST_ASSERT(ve_camera_cull(&cameras[0], scene, NULL));
+    TEST_ASSERT(cameras[0].visibility.count == 0);
+    ve_camera_draws draws;
+    TEST_ASSERT(ve_camera_build_draws(&cameras[0], &draws) && draws.draw_count == 0);
+
+    ve_scene_destroy(scene);
+    ve_frame_allocator_shutdown();
+    return true;
+}
+
+/* Asset loader that keeps the file contents and records the decode order */
+static uint32_t asset_test_order[16];
+static ve_atomic_int32 asset_test_decoded;
+static uint32_t asset_test_unloaded;
+static uint64_t asset_test_next_fence;
+static uint64_t asset_test_completed_fence;
+static bool asset_test_ring_full;
+
+static bool asset_test_decode(const void* data, size_t size, void** asset, size_t* resident_size, void* user_data) {
+    (void)user_data;
+    if (size != sizeof(uint32_t) * 4) {
+        return false;
+    }
+    uint32_t* copy = (uint32_t*)VE_ALLOCATE_TAG(size, VE_MEMORY_TAG_ASSET);
+    if (!copy) {
+        return false;
+    }
+    memcpy(copy, data, size);
+    int32_t slot = ve_atomic_fetch_add32(&asset_test_decoded, 1);
+    if (slot < 16) {
+        asset_test_order[slot] = copy[0];
+    }
+    *asset = copy;
+    *resident_size = size;
+    return true;
+}
+
+static ve_asset_upload_result asset_test_upload(void* asset, uint64_t* fence, void* user_data) {
+    (void)asset;
+    (void)user_data;
+    if (asset_test_ring_full) {
+        return VE_ASSET_UPLOAD_RETRY;
+    }
+    *fence = ++asset_test_next_fence;
+    return VE_ASSET_UPLOAD_DONE;
+}
+
+static void asset_test_unload(void* asset, void* user_data) {
+    (void)user_data;
+    asset_test_unloaded++;
+    VE_FREE(asset);
+}
+
+static bool asset_test_fence_complete(uint64_t fence) {
+    return fence <= asset_test_completed_fence;
+}
+
+static void asset_test_path(char* path, size_t size, uint32_t index) {
+    snprintf(path, size, "ve_test_asset_%u.bin", index);
+}
+
+/* Update until nothing is queued, loading or uploading, letting the GPU fence catch up */
+static bool asset_test_drain(void) {
+    for (uint32_t i = 0; i < 10000; i++) {
+        asset_test_completed_fence = asset_test_next_fence;
+        ve_asset_manager_update();
+        ve_asset_stats stats;
+        ve_asset_manager_get_stats(&stats);
+        if (stats.queued == 0 && stats.loading == 0 && stats.uploading == 0) {
+            return true;
+        }
+        ve_thread_sleep_ms(1);
+    }
+    return false;
+}
+
+bool test_asset_streaming(void) {
+    printf("Running test_asset_streaming...\n");
+
+    enum { FILES = 8 };
+    char path[64];
+    for (uint32_t i = 0; i < FILES; i++) {
+        asset_test_path(path, sizeof(path), i);
+        FILE* file = fopen(path, "wb");
+        TEST_ASSERT(file != NULL);
+        uint32_t contents[4] = {i, i * 10, i * 100, 0xA55E7u};
+        TEST_ASSERT(fwrite(contents, sizeof(contents), 1, file) == 1);
+        fclose(file);
+    }
+
+    ve_asset_loader loader = {
+        .name = "test",
+        .decode = asset_test_decode,
+        .upload = asset_test_upload,
+        .unload = asset_test_unload,
+    };
+
+    /* On the main thread, one load at a time: loads follow priority */
+    ve_asset_manager_config config = {
+        .memory_budget = 1024,
+        .max_in_flight = 1,
+        .is_fence_complete = asset_test_fence_complete,
+    };
+    TEST_ASSERT(ve_asset_manager_init(&config));
+    uint32_t type = ve_asset_register_loader(&loader);
+    TEST_ASSERT(type == 0);
+
+    ve_asset assets[FILES];
+    for (uint32_t i = 0; i < FILES; i++) {
+        asset_test_path(path, sizeof(path), i);
+        assets[i] = ve_asset_load(path, type, (float)i);
+        TEST_ASSERT(assets[i] != VE_ASSET_NULL);
+        TEST_ASSERT(ve_asset_get_state(assets[i]) == VE_ASSET_QUEUED);
+    }
+    asset_test_path(path, sizeof(path), 3);
+    TEST_ASSERT(ve_asset_load(path, type, 1.0f) == assets[3]);
+    ve_asset_release(assets[3]);
+    ve_asset_set_priority(assets[0], 100.0f);
+
+    /* Releasing the last reference cancels a queued request */
+    ve_asset_release(assets[5]);
+    TEST_ASSERT(ve_asset_get_state(assets[5]) == VE_ASSET_INVALID);
+
+    ve_asset missing = ve_asset_load("ve_test_asset_missing.bin", type, 50.0f);
+    TEST_ASSERT(asset_test_drain());
+    TEST_ASSERT(ve_asset_get_state(missing) == VE_ASSET_FAILED);
+    ve_asset_release(missing);
+    TEST_ASSERT(ve_asset_get_state(missing) == VE_ASSET_INVALID);
+
+    uint32_t expected_order[] = {0, 7, 6, 4, 3, 2, 1};
+    TEST_ASSERT(ve_atomic_load32(&asset_test_decoded) == 7);
+    TEST_ASSERT(memcmp(asset_test_order, expected_order, sizeof(expected_order)) == 0);
+    for (uint32_t i = 0; i < FILES; i++) {
+        if (i == 5) {
+            continue;
+        }
+        const uint32_t* data = (const uint32_t*)ve_asset_get(assets[i]);
+        TEST_ASSERT(ve_asset_get_state(assets[i]) == VE_ASSET_READY);
+        TEST_ASSERT(data != NULL && data[0] == i && data[2] == i * 100);
+    }
+
+    /* Uploads that do not fit wait, and readiness waits for the fence */
+    asset_test_ring_full = true;
+    asset_test_path(path, sizeof(path), 5);
+    assets[5] = ve_asset_load(path, type, 0.0f);
+    ve_asset_manager_update();
+    ve_asset_manager_update();
+    TEST_ASSERT(ve_asset_get_state(assets[5]) == VE_ASSET_UPLOADING);
+    asset_test_ring_full = false;
+    ve_asset_manager_update();
+    TEST_ASSERT(ve_asset_get_state(assets[5]) == VE_ASSET_UPLOADING);
+    TEST_ASSERT(ve_asset_get(assets[5]) == NULL);
+    asset_test_completed_fence = asset_test_next_fence;
+    ve_asset_manager_update();
+    TEST_ASSERT(ve_asset_get_state(assets[5]) == VE_ASSET_READY);
+
+    ve_asset_stats stats;
+    ve_asset_manager_get_stats(&stats);
+    TEST_ASSERT(stats.ready == FILES && stats.resident_size == FILES * 16);
+    TEST_ASSERT(stats.cancelled == 1 && stats.loaded == FILES);
+    ve_asset_manager_shutdown();
+    TEST_ASSERT(asset_test_unloaded == FILES);
+
+    /* On the pool: released assets stay cached until the budget evicts the oldest */
+    ve_thread_pool* pool = ve_thread_pool_create(3);
+    TEST_ASSERT(pool != NULL);
+    config = (ve_asset_manager_config){
+        .pool = pool,
+        .memory_budget = 5 * 16,
+        .is_fence_complete = asset_test_fence_complete,
+    };
+    TEST_ASSERT(ve_asset_manager_init(&config));
+    type = ve_asset_register_loader(&loader);
+    asset_test_unloaded = 0;
+
+    for (uint32_t i = 0; i < FILES; i++) {
+        asset_test_path(path, sizeof(path), i);
+        assets[i] = ve_asset_load(path, type, 0.0f);
+    }
+    TEST_ASSERT(asset_test_drain());
+    for (uint32_t i = 0; i < FILES; i++) {
+        TEST_ASSERT(ve_asset_get_state(assets[i]) == VE_ASSET_READY);
+    }
+
+    /* Referenced assets are never evicted, even over budget */
+    ve_asset_manager_get_stats(&stats);
+    TEST_ASSERT(stats.resident_size == FILES * 16 && stats.evicted == 0);
+
+    for (uint32_t i = 0; i < 4; i++) {
+        ve_asset_release(assets[i]);
+    }
+    ve_asset_manager_update();
+    ve_asset_manager_get_stats(&stats);
+    TEST_ASSERT(stats.evicted == 3 && stats.cached == 1 && stats.resident_size == 5 * 16);
+    TEST_ASSERT(ve_asset_get_state(assets[0]) == VE_ASSET_INVALID);
+    TEST_ASSERT(ve_asset_get_state(assets[3]) == VE_ASSET_READY);
+
+    /* Requesting a cached asset again takes it out of the cache */
+    asset_test_path(path, sizeof(path), 3);
+    TEST_ASSERT(ve_asset_load(path, type, 0.0f) == assets[3]);
+    ve_asset_manager_get_stats(&stats);
+    TEST_ASSERT(stats.cached == 0);
+
+    ve_asset_manager_shutdown();
+    TEST_ASSERT(asset_test_unloaded == FILES);
+    ve_thread_pool_destroy(pool);
+
+    for (uint32_t i = 0; i < FILES; i++) {
+        asset_test_path(path, sizeof(path), i);
+        remove(path);
+    }
+    return true;
+}
+
+bool test_file_io(void) {
+    printf("Running test_file_io...\n");
+
+    enum { WORDS = 64 * 1024, CHUNK = 4096, CHUNKS = WORDS * 4 / CHUNK };
+    static uint32_t contents[WORDS];
+    static uint8_t chunks[CHUNKS][CHUNK];
+    for (uint32_t i = 0; i < WORDS; i++) {
+        contents[i] = i * 2654435761u;
+    }
+
+    const char* path = "ve_test_file_io.bin";
+    FILE* file = fopen(path, "wb");
+    TEST_ASSERT(file != NULL);
+    TEST_ASSERT(fwrite(contents, sizeof(contents), 1, file) == 1);
+    fclose(file);
+
+    /* Mapped data reads in place */
+    ve_file_mapping mapping;
+    TEST_ASSERT(ve_file_map(path, VE_FILE_ACCESS_SEQUENTIAL, &mapping));
+    TEST_ASSERT(mapping.size == sizeof(contents));
+    ve_file_prefetch(&mapping, 100, sizeof(contents));
+    TEST_ASSERT(memcmp(mapping.data, contents, sizeof(contents)) == 0);
+    ve_file_unmap(&mapping);
+    TEST_ASSERT(mapping.data == NULL && mapping.size == 0);
+    TEST_ASSERT(!ve_file_map("ve_test_file_io_missing.bin", VE_FILE_ACCESS_NORMAL, &mapping));
+
+    /* Reads complete out of a bounded queue, including one past the end */
+    ve_file* async_file = ve_file_open_async(path);
+    TEST_ASSERT(async_file != NULL);
+    TEST_ASSERT(ve_file_get_size(async_file) == sizeof(contents));
+    ve_io_queue* queue = ve_io_queue_create(8);
+    TEST_ASSERT(queue != NULL);
+
+    uint32_t issued = 0;
+    uint32_t completed = 0;
+    bool seen[CHUNKS + 1] = {false};
+    static uint8_t tail[CHUNK];
+    while (completed < CHUNKS + 1) {
+        while (issued < CHUNKS + 1) {
+            bool past_end = issued == CHUNKS;
+            void* buffer = past_end ? tail : chunks[issued];
+            uint64_t offset = past_end ? sizeof(contents) - 100 : (uint64_t)issued * CHUNK;
+            if (!ve_io_read(queue, async_file, offset, buffer, CHUNK, (void*)(uintptr_t)(issued + 1))) {
+                break;
+            }
+            issued++;
+        }
+        TEST_ASSERT(ve_io_get_pending(queue) > 0);
+
+        ve_io_completion completions[4];
+        uint32_t count = ve_io_poll(queue, completions, 4, true);
+        TEST_ASSERT(count > 0);
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t index = (uint32_t)(uintptr_t)completions[i].user_data - 1;
+            TEST_ASSERT(index <= CHUNKS && !seen[index]);
+            seen[index] = true;
+            TEST_ASSERT(completions[i].result == (index == CHUNKS ? 100 : CHUNK));
+        }
+        completed += count;
+    }
+    TEST_ASSERT(ve_io_get_pending(queue) == 0);
+    TEST_ASSERT(memcmp(chunks, contents, sizeof(contents)) == 0);
+    TEST_ASSERT(memcmp(tail, (const uint8_t*)contents + sizeof(contents) - 100, 100) == 0);
+
+    ve_io_queue_destroy(queue);
+    ve_file_close(async_file);
+    remove(path);
+    return true;
+}
+
+bool test_pak_archive(void) {
+    printf("Running test_pak_archive...\n");
+
+    enum { RANDOM_SIZE = 10000, REPEAT_SIZE = 100000 };
+    static uint8_t random_data[RANDOM_SIZE];
+    static uint8_t repeat_data[REPEAT_SIZE];
+    static uint8_t compressed[REPEAT_SIZE + 1024];
+    static uint8_t expanded[REPEAT_SIZE];
+    uint32_t seed = 12345;
+    for (uint32_t i = 0; i < RANDOM_SIZE; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        random_data[i] = (uint8_t)(seed >> 24);
+    }
+    for (uint32_t i = 0; i < REPEAT_SIZE; i++) {
+        repeat_data[i] = (uint8_t)("pak blob "[i % 9] + i / 5000);
+    }
+
+    /* LZ4 round trips, shrinking repetitive data and refusing to grow past the capacity */
+    size_t size = ve_lz4_compress(repeat_data, REPEAT_SIZE, compressed, sizeof(compressed));
+    TEST_ASSERT(size > 0 && size < REPEAT_SIZE / 10);
+    TEST_ASSERT(ve_lz4_decompress(compressed, size, expanded, REPEAT_SIZE));
+    TEST_ASSERT(memcmp(expanded, repeat_data, REPEAT_SIZE) == 0);
+    TEST_ASSERT(!ve_lz4_decompress(compressed, size, expanded, REPEAT_SIZE - 1));
+    size = ve_lz4_compress(random_data, RANDOM_SIZE, compressed, sizeof(compressed));
+    TEST_ASSERT(size > RANDOM_SIZE);
+    TEST_ASSERT(ve_lz4_decompress(compressed, size, expanded, RANDOM_SIZE));
+    TEST_ASSERT(memcmp(expanded, random_data, RANDOM_SIZE) == 0);
+    TEST_ASSERT(ve_lz4_compress(random_data, RANDOM_SIZE, compressed, RANDOM_SIZE - 1) == 0);
+
+    /* OBJ quad: shared corners become one vertex, v is flipped */
+    const char* quad_obj =
+        "# quad\n"
+        "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+        "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+        "vn 0 0 1\n"
+        "f 1/1/1 2/2/1 3/3/1 4/4/1\n"
+        "f -4/-4/-1 -2/-2/-1 -1/-1/-1";
+    ve_mesh_vertex* vertices = NULL;
+    uint32_t* indices = NULL;
+    uint32_t vertex_count = 0;
+    uint32_t index_count = 0;
+    TEST_ASSERT(ve_model_parse_obj(quad_obj, strlen(quad_obj), &vertices, &vertex_count, &indices, &index_count));
+    TEST_ASSERT(vertex_count == 4 && index_count == 9);
+    TEST_ASSERT(indices[6] == 0 && indices[7] == 2 && indices[8] == 3);
+    TEST_ASSERT(vertices[2].position[0] == 1.0f && vertices[2].uv[1] == 0.0f && vertices[0].uv[1] == 1.0f);
+    TEST_ASSERT(vertices[3].normal[2] == 1.0f);
+
+    const char* bare_obj = "v 0 0 0\nv 2 0 0\nv 0 2 0\nf 1 2 3\n";
+    ve_mesh_vertex* bare_vertices = NULL;
+    uint32_t* bare_indices = NULL;
+    TEST_ASSERT(ve_model_parse_obj(bare_obj, strlen(bare_obj), &bare_vertices, &vertex_count, &bare_indices,
+                                   &index_count));
+    TEST_ASSERT(vertex_count == 3 && fabsf(bare_vertices[1].normal[2] - 1.0f) < 1e-6f);
+    VE_FREE(bare_vertices);
+    VE_FREE(bare_indices);
+    const char* broken_obj = "v 0 0 0\nf 1 2 3\n";
+    TEST_ASSERT(!ve_model_parse_obj(broken_obj, strlen(broken_obj), &bare_vertices, &vertex_count, &bare_indices,
+                                    &index_count));
+
+    void* mesh_blob = NULL;
+    size_t mesh_size = 0;
+    TEST_ASSERT(ve_mesh_cook(vertices, 4, indices, 6, &mesh_blob, &mesh_size));
+
+    /* TGA: 2x2 bottom-up 32 bit, and 3x1 run-length encoded 24 bit */
+    static const uint8_t tga_raw[18 + 16] = {
+        0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 2, 0, 32, 8,
+        0, 0, 255, 255,  0, 255, 0, 255,    /* Bottom row: red, green */
+        255, 0, 0, 255,  255, 255, 255, 128 /* Top row: blue, white */
+    };
+    static const uint8_t tga_rle[18 + 8] = {
+        0, 0, 10, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 0, 1, 0, 24, 0x20,
+        0x81, 10, 20, 30,                   /* Two repeated pixels */
+        0x00, 40, 50, 60                    /* One raw pixel */
+    };
+    uint8_t* pixels = NULL;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    TEST_ASSERT(ve_texture_decode_tga(tga_rle, sizeof(tga_rle), &pixels, &width, &height));
+    TEST_ASSERT(width == 3 && height == 1);
+    TEST_ASSERT(pixels[4] == 30 && pixels[6] == 10 && pixels[7] == 255 && pixels[8] == 60);
+    VE_FREE(pixels);
+    TEST_ASSERT(!ve_texture_decode_tga(tga_rle, sizeof(tga_rle) - 1, &pixels, &width, &height));
+    TEST_ASSERT(ve_texture_decode_tga(tga_raw, sizeof(tga_raw), &pixels, &width, &height));
+    TEST_ASSERT(width == 2 && height == 2);
+    TEST_ASSERT(pixels[2] == 255 && pixels[7] == 128 && pixels[8] == 255 && pixels[13] == 255);
+
+    void* texture_blob = NULL;
+    size_t texture_size = 0;
+    ve_texture_cook_config cook_config = {
+        .srgb = false,
+        .families = VE_TEXTURE_FAMILY_RGBA8 | VE_TEXTURE_FAMILY_BC | VE_TEXTURE_FAMILY_ETC2,
+    };
+    TEST_ASSERT(ve_texture_cook(pixels, width, height, &cook_config, &texture_blob, &texture_size));
+    VE_FREE(pixels);
+
+    /* Write an archive mixing raw, compressed, mesh and texture entries */
+    const char* path = "ve_test_pak.pak";
+    ve_pak_writer* writer = ve_pak_writer_create(path);
+    TEST_ASSERT(writer != NULL);
+    TEST_ASSERT(ve_pak_writer_add(writer, "raw/random.bin", VE_PAK_TYPE_RAW, random_data, RANDOM_SIZE,
+                                  VE_PAK_COMPRESSION_LZ4));
+    TEST_ASSERT(ve_pak_writer_add(writer, "raw/repeat.bin", VE_PAK_TYPE_RAW, repeat_data, REPEAT_SIZE,
+                                  VE_PAK_COMPRESSION_LZ4));
+    TEST_ASSERT(ve_pak_writer_add(writer, "mesh/quad.obj", VE_PAK_TYPE_MESH, mesh_blob, mesh_size,
+                                  VE_PAK_COMPRESSION_NONE));
+    TEST_ASSERT(ve_pak_writer_add(writer, "texture/quad.tga", VE_PAK_TYPE_TEXTURE, texture_blob, texture_size,
+                                  VE_PAK_COMPRESSION_LZ4));
+    TEST_ASSERT(ve_pak_writer_finish(writer));
+
+    ve_pak* pak = ve_pak_open(path);
+    TEST_ASSERT(pak != NULL);
+    TEST_ASSERT(ve_pak_get_count(pak) == 4);
+    for (uint32_t i = 0; i < ve_pak_get_count(pak); i++) {
+        const ve_pak_entry* entry = ve_pak_get_entry(pak, i);
+        TEST_ASSERT(entry->offset % VE_PAK_ALIGNMENT == 0);
+        TEST_ASSERT(ve_pak_find(pak, ve_pak_get_name(pak, entry)) == entry);
+    }
+    TEST_ASSERT(ve_pak_find(pak, "raw/missing.bin") == NULL);
+
+    /* Incompressible blobs are stored as is and read in place */
+    const ve_pak_entry* entry = ve_pak_find(pak, "raw/random.bin");
+    TEST_ASSERT(entry != NULL && entry->compression == VE_PAK_COMPRESSION_NONE);
+    void* owned = NULL;
+    const void* contents = ve_pak_load(pak, entry, &owned);
+    TEST_ASSERT(contents != NULL && owned == NULL);
+    TEST_ASSERT(memcmp(contents, random_data, RANDOM_SIZE) == 0);
+
+    entry = ve_pak_find(pak, "raw/repeat.bin");
+    TEST_ASSERT(entry != NULL && entry->compression == VE_PAK_COMPRESSION_LZ4);
+    TEST_ASSERT(entry->stored_size < entry->size && entry->size == REPEAT_SIZE);
+    ve_pak_prefetch(pak, entry);
+    contents = ve_pak_load(pak, entry, &owned);
+    TEST_ASSERT(contents != NULL && owned == contents);
+    TEST_ASSERT(memcmp(contents, repeat_data, REPEAT_SIZE) == 0);
+    VE_FREE(owned);
+
+    /* Cooked blobs view straight out of the archive */
+    ve_model model;
+    TEST_ASSERT(ve_model_load_pak(pak, "mesh/quad.obj", &model));
+    TEST_ASSERT(model.owned == NULL);
+    TEST_ASSERT(model.mesh.vertex_count == 4 && model.mesh.index_count == 6);
+    ve_mesh_vertex cooked_vertices[4];
+    ve_mesh_dequantize(model.mesh.vertices, 4, model.mesh.bounds_min, model.mesh.bounds_max, cooked_vertices);
+    TEST_ASSERT(triangles_match(vertices, indices, cooked_vertices, model.mesh.indices, 6, 1e-6f));
+    TEST_ASSERT(fabsf(cooked_vertices[0].normal[2] - 1.0f) < 1e-6f);
+    TEST_ASSERT(model.mesh.meshlet_count == 1 && model.mesh.meshlets[0].triangle_count == 2);
+    TEST_ASSERT(model.mesh.bounds_max[1] == 1.0f && model.mesh.bounds_min[2] == 0.0f);
+    ve_model_release(&model);
+    TEST_ASSERT(!ve_model_load_pak(pak, "texture/quad.tga", &model));
+
+    ve_texture texture;
+    TEST_ASSERT(ve_texture_load_pak(pak, "texture/quad.tga", &texture));
+    TEST_ASSERT(texture.data.width == 2 && texture.data.variant_count == 3);
+    const ve_texture_variant* variant = &texture.data.variants[0];
+    TEST_ASSERT(variant->format == VE_TEXTURE_FORMAT_RGBA8_UNORM && variant->mip_count == 2);
+    TEST_ASSERT(texture.data.variants[1].format == VE_TEXTURE_FORMAT_BC3_UNORM);
+    TEST_ASSERT(texture.data.variants[2].format == VE_TEXTURE_FORMAT_ETC2_RGBA8_UNORM);
+    TEST_ASSERT(variant->mips[1].offset < variant->mips[0].offset);
+    const uint8_t* top_mip = texture.data.blob + variant->mips[1].offset;
+    TEST_ASSERT(variant->mips[1].width == 1 && variant->mips[1].size == 4);
+    TEST_ASSERT(top_mip[0] == 128 && top_mip[1] == 128 && top_mip[2] == 128 && top_mip[3] == 223);
+    TEST_ASSERT(texture.data.variants[1].mips[0].size == 16);
+    ve_texture_release(&texture);
+
+    ve_pak_close(pak);
+
+    /* Duplicate names are rejected, and so is anything that is not a pak */
+    writer = ve_pak_writer_create(path);
+    TEST_ASSERT(writer != NULL);
+    TEST_ASSERT(ve_pak_writer_add(writer, "a", VE_PAK_TYPE_RAW, random_data, 16, VE_PAK_COMPRESSION_NONE));
+    TEST_ASSERT(ve_pak_writer_add(writer, "a", VE_PAK_TYPE_RAW, random_data, 16, VE_PAK_COMPRESSION_NONE));
+    TEST_ASSERT(!ve_pak_writer_finish(writer));
+    FILE* file = fopen(path, "wb");
+    TEST_ASSERT(file != NULL);
+    TEST_ASSERT(fwrite(random_data, 100, 1, file) == 1);
+    fclose(file);
+    TEST_ASSERT(ve_pak_open(path) == NULL);
+
+    VE_FREE(vertices);
+    VE_FREE(indices);
+    VE_FREE(mesh_blob);
+    VE_FREE(texture_blob);
+    remove(path);
+    return true;
+}
+
+/* Mean absolute difference per channel between two RGBA8 images */
+static float texture_error(const uint8_t* a, const uint8_t* b, uint32_t texel_count, uint32_t channels) {
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < texel_count; i++) {
+        for (uint32_t c = 0; c < channels; c++) {
+            total += (uint64_t)abs((int)a[i * 4 + c] - (int)b[i * 4 + c]);
+        }
+    }
+    return (float)total / (float)(texel_count * channels);
+}
+
+bool test_texture_compression(void) {
+    printf("Running test_texture_compression...\n");
+
+    /* A smooth gradient, 10x6 so blocks at the right and bottom edges are partial */
+    enum { WIDTH = 10, HEIGHT = 6 };
+    uint8_t pixels[WIDTH * HEIGHT * 4];
+    for (uint32_t y = 0; y < HEIGHT; y++) {
+        for (uint32_t x = 0; x < WIDTH; x++) {
+            uint8_t* texel = &pixels[(y * WIDTH + x) * 4];
+            texel[0] = (uint8_t)(40 + (x + y) * 12);
+            texel[1] = (uint8_t)(200 - (x + y) * 9);
+            texel[2] = (uint8_t)(90 + (x + y) * 4);
+            texel[3] = 255;
+        }
+    }
+
+    TEST_ASSERT(ve_texture_get_level_size(VE_TEXTURE_FORMAT_BC1_UNORM, WIDTH, HEIGHT) == 3 * 2 * 8);
+    TEST_ASSERT(ve_texture_get_level_size(VE_TEXTURE_FORMAT_ETC2_RGBA8_SRGB, 1, 1) == 16);
+    TEST_ASSERT(ve_texture_get_level_size(VE_TEXTURE_FORMAT_RGBA8_UNORM, WIDTH, HEIGHT) == WIDTH * HEIGHT * 4);
+
+    /* Opaque images get the 8 byte per block formats */
+    ve_texture_cook_config config = {.srgb = true};
+    void* blob = NULL;
+    size_t size = 0;
+    TEST_ASSERT(ve_texture_cook(pixels, WIDTH, HEIGHT, &config, &blob, &size));
+    ve_texture_data data;
+    TEST_ASSERT(ve_texture_view(blob, size, &data));
+    TEST_ASSERT(data.variant_count == 2 && data.variants[0].mip_count == 4);
+    TEST_ASSERT(data.variants[0].format == VE_TEXTURE_FORMAT_BC1_SRGB);
+    TEST_ASSERT(data.variants[1].format == VE_TEXTURE_FORMAT_ETC2_RGB8_SRGB);
+    TEST_ASSERT(ve_texture_format_is_srgb(VE_TEXTURE_FORMAT_BC1_SRGB));
+    TEST_ASSERT(ve_texture_format_get_family(VE_TEXTURE_FORMAT_ETC2_RGB8_SRGB) == VE_TEXTURE_FAMILY_ETC2);
+
+    /* Selection follows device support, with no fallback when there is no RGBA8 variant */
+    TEST_ASSERT(ve_texture_select_variant(&data, VE_TEXTURE_FAMILY_BC | VE_TEXTURE_FAMILY_ETC2) == 0);
+    TEST_ASSERT(ve_texture_select_variant(&data, VE_TEXTURE_FAMILY_ETC2) == 1);
+    TEST_ASSERT(ve_texture_select_variant(&data, VE_TEXTURE_FAMILY_ASTC) == -1);
+
+    /* Both encodings stay close to the source */
+    uint8_t decoded[WIDTH * HEIGHT * 4];
+    for (uint32_t v = 0; v < data.variant_count; v++) {
+        const ve_texture_mip* mip = &data.variants[v].mips[0];
+        TEST_ASSERT(ve_texture_decompress((ve_texture_format)data.variants[v].format, data.blob + mip->offset,
+                                          WIDTH, HEIGHT, decoded));
+        TEST_ASSERT(texture_error(pixels, decoded, WIDTH * HEIGHT, 3) < 8.0f);
+        TEST_ASSERT(decoded[3] == 255);
+    }
+    VE_FREE(blob);
+
+    /* Flat blocks with alpha: colors within 565 precision, alpha exact */
+    for (uint32_t i = 0; i < WIDTH * HEIGHT; i++) {
+        pixels[i * 4 + 0] = 200;
+        pixels[i * 4 + 1] = 100;
+        pixels[i * 4 + 2] = 50;
+        pixels[i * 4 + 3] = i % WIDTH < 4 ? 0 : 160;
+    }
+    config = (ve_texture_cook_config){.srgb = false, .families = VE_TEXTURE_FAMILY_BC | VE_TEXTURE_FAMILY_ETC2};
+    TEST_ASSERT(ve_texture_cook(pixels, WIDTH, HEIGHT, &config, &blob, &size));
+    TEST_ASSERT(ve_texture_view(blob, size, &data));
+    TEST_ASSERT(data.variants[0].format == VE_TEXTURE_FORMAT_BC3_UNORM);
+    TEST_ASSERT(data.variants[1].format == VE_TEXTURE_FORMAT_ETC2_RGBA8_UNORM);
+    for (uint32_t v = 0; v < data.variant_count; v++) {
+        const ve_texture_mip* mip = &data.variants[v].mips[0];
+        TEST_ASSERT(ve_texture_decompress((ve_texture_format)data.variants[v].format, data.blob + mip->offset,
+                                          WIDTH, HEIGHT, decoded));
+        TEST_ASSERT(texture_error(pixels, decoded, WIDTH * HEIGHT, 3) < 4.0f);
+        for (uint32_t i = 0; i < WIDTH * HEIGHT; i++) {
+            TEST_ASSERT(decoded[i * 4 + 3] == pixels[i * 4 + 3]);
+        }
+    }
+
+    /* A blob whose mip sizes do not match its format is rejected */
+    ve_texture_blob_header* header = (ve_texture_blob_header*)blob;
+    header->variants[1].format = VE_TEXTURE_FORMAT_ETC2_RGB8_UNORM;
+    TEST_ASSERT(!ve_texture_view(blob, size, &data));
+    VE_FREE(blob);
+
+    /* ASTC is accepted in blobs but not encoded */
+    config.families = VE_TEXTURE_FAMILY_ASTC;
+    TEST_ASSERT(!ve_texture_cook(pixels, WIDTH, HEIGHT, &config, &blob, &size));
     return true;
 }
 
@@ -102,8 +3361,41 @@ int main(int argc, char* argv[]) {
     /* Test suite */
     test_case tests[] = {
         {"memory_arena", test_memory_arena},
+        {"memory_arena_growable", test_memory_arena_growable},
+        {"frame_allocator", test_frame_allocator},
         {"memory_pool", test_memory_pool},
+        {"thread_pool", test_thread_pool},
+        {"parallel_for", test_parallel_for},
+        {"thread_placement", test_thread_placement},
+        {"sync_primitives", test_sync_primitives},
+        {"lockfree_queues", test_lockfree_queues},
+        {"frame_pipeline", test_frame_pipeline},
+        {"memory_stats_threaded", test_memory_stats_threaded},
+        {"memory_size_classes", test_memory_size_classes},
+        {"memory_external", test_memory_external},
+        {"concurrent_pool", test_concurrent_pool},
+        {"logger_async", test_logger_async},
+        {"logger_deferred", test_logger_deferred},
+        {"profiler", test_profiler},
+        {"frame_latency", test_frame_latency},
+        {"benchmark_stats", test_benchmark_stats},
+        {"telemetry", test_telemetry},
+        {"init_graph", test_init_graph},
         {"ecs_basic", test_ecs_basic},
+        {"ecs_scheduler", test_ecs_scheduler},
+        {"ecs_change_versions", test_ecs_change_versions},
+        {"simd_kernels", test_simd_kernels},
+        {"meshlet_build", test_meshlet_build},
+        {"mesh_optimization", test_mesh_optimization},
+        {"mesh_lod", test_mesh_lod},
+        {"scene_graph", test_scene_graph},
+        {"scene_bvh", test_scene_bvh},
+        {"camera_visibility", test_camera_visibility},
+        {"camera_path", test_camera_path},
+        {"asset_streaming", test_asset_streaming},
+        {"file_io", test_file_io},
+        {"pak_archive", test_pak_archive},
+        {"texture_compression", test_texture_compression},
     };
 
     int passed = 0;
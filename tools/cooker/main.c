@@ -0,0 +1,280 @@
+/**
+ * @file main.c
+ * @brief Offline asset cooker
+ *
+ * Converts source assets into one pak archive (see assets/pak.h):
+ *
+ *   vulkan_engine_cooker -o game.pak [-c none|lz4|zstd] [-r root] [-l] [-t bc,etc2] files...
+ *
+ * OBJ models are cooked into mesh blobs with meshlets and levels of
+ * detail, TGA images into texture blobs with full mip chains in each
+ * requested block compressed format, and anything else is stored as is.
+ * Entries are named by their path relative to the root (the current
+ * directory by default), with forward slashes.
+ */
+
+#include "core/logger.h"
+#include "core/memory.h"
+#include "platform/platform.h"
+#include "assets/pak.h"
+#include "assets/model_loader.h"
+#include "assets/texture_loader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define COOKER_MAX_NAME 1024
+
+typedef struct cooker_options {
+    const char* output;
+    const char* root;
+    ve_pak_compression compression;
+    bool linear;                    /* Textures hold data, not sRGB color */
+    uint32_t families;              /* ve_texture_family flags, 0 for the default */
+} cooker_options;
+
+static void print_usage(void) {
+    fprintf(stderr,
+            "Usage: vulkan_engine_cooker -o <output.pak> [options] <files...>\n"
+            "  -o <path>    Output archive\n"
+            "  -c <codec>   Blob compression: none, lz4 (default) or zstd\n"
+            "  -r <dir>     Root that entry names are relative to\n"
+            "  -l           Cook textures as linear data instead of sRGB\n"
+            "  -t <formats> Texture encodings, comma separated: rgba8, bc, etc2 (default bc,etc2)\n");
+}
+
+static bool has_extension(const char* path, const char* extension) {
+    size_t length = strlen(path);
+    size_t extension_length = strlen(extension);
+    if (length < extension_length) {
+        return false;
+    }
+    const char* suffix = path + length - extension_length;
+    for (size_t i = 0; i < extension_length; i++) {
+        char c = suffix[i];
+        if ((c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c) != extension[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Strip the root and normalize separators, so names match on every platform */
+static bool make_entry_name(const char* path, const char* root, char* name, size_t capacity) {
+    if (root) {
+        size_t root_length = strlen(root);
+        if (strncmp(path, root, root_length) == 0) {
+            path += root_length;
+            while (*path == '/' || *path == '\\') {
+                path++;
+            }
+        }
+    }
+    while (path[0] == '.' && (path[1] == '/' || path[1] == '\\')) {
+        path += 2;
+    }
+
+    size_t length = strlen(path);
+    if (length == 0 || length >= capacity) {
+        return false;
+    }
+    for (size_t i = 0; i <= length; i++) {
+        name[i] = path[i] == '\\' ? '/' : path[i];
+    }
+    return true;
+}
+
+/* Parse a comma separated list of texture families */
+static bool parse_families(const char* value, uint32_t* families) {
+    static const struct {
+        const char* name;
+        ve_texture_family family;
+    } names[] = {
+        {"rgba8", VE_TEXTURE_FAMILY_RGBA8},
+        {"bc", VE_TEXTURE_FAMILY_BC},
+        {"etc2", VE_TEXTURE_FAMILY_ETC2},
+        {"astc", VE_TEXTURE_FAMILY_ASTC},
+    };
+
+    *families = 0;
+    while (*value) {
+        size_t length = strcspn(value, ",");
+        bool known = false;
+        for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+            if (strlen(names[i].name) == length && strncmp(value, names[i].name, length) == 0) {
+                *families |= (uint32_t)names[i].family;
+                known = true;
+            }
+        }
+        if (!known) {
+            return false;
+        }
+        value += length;
+        value += *value == ',';
+    }
+    return *families != 0;
+}
+
+static bool cook_model(const ve_file_mapping* source, void** blob, size_t* size) {
+    ve_mesh_vertex* vertices = NULL;
+    uint32_t* indices = NULL;
+    uint32_t vertex_count = 0;
+    uint32_t index_count = 0;
+    if (!ve_model_parse_obj((const char*)source->data, source->size, &vertices, &vertex_count, &indices,
+                            &index_count)) {
+        return false;
+    }
+    bool result = ve_mesh_cook(vertices, vertex_count, indices, index_count, blob, size);
+    VE_FREE(vertices);
+    VE_FREE(indices);
+    return result;
+}
+
+static bool cook_texture(const ve_file_mapping* source, const cooker_options* options, void** blob, size_t* size) {
+    uint8_t* pixels = NULL;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    if (!ve_texture_decode_tga(source->data, source->size, &pixels, &width, &height)) {
+        return false;
+    }
+    ve_texture_cook_config config = {
+        .srgb = !options->linear,
+        .families = options->families,
+    };
+    bool result = ve_texture_cook(pixels, width, height, &config, blob, size);
+    VE_FREE(pixels);
+    return result;
+}
+
+static bool cook_file(ve_pak_writer* writer, const char* path, const cooker_options* options) {
+    char name[COOKER_MAX_NAME];
+    if (!make_entry_name(path, options->root, name, sizeof(name))) {
+        VE_LOG_ERROR("Cannot name an entry for %s", path);
+        return false;
+    }
+
+    ve_file_mapping source;
+    if (!ve_file_map(path, VE_FILE_ACCESS_SEQUENTIAL, &source)) {
+        VE_LOG_ERROR("Failed to read %s", path);
+        return false;
+    }
+
+    ve_pak_type type = VE_PAK_TYPE_RAW;
+    void* blob = NULL;
+    size_t size = source.size;
+    bool cooked = true;
+    if (has_extension(path, ".obj")) {
+        type = VE_PAK_TYPE_MESH;
+        cooked = cook_model(&source, &blob, &size);
+    } else if (has_extension(path, ".tga")) {
+        type = VE_PAK_TYPE_TEXTURE;
+        cooked = cook_texture(&source, options, &blob, &size);
+    }
+
+    bool result = cooked && ve_pak_writer_add(writer, name, type, blob ? blob : source.data, size,
+                                              options->compression);
+    if (result) {
+        VE_LOG_INFO("Cooked %s (%zu bytes)", name, size);
+    } else {
+        VE_LOG_ERROR("Failed to cook %s", path);
+    }
+
+    VE_FREE(blob);
+    ve_file_unmap(&source);
+    return result;
+}
+
+static int run(int argc, char** argv) {
+    cooker_options options = {
+        .compression = VE_PAK_COMPRESSION_LZ4,
+    };
+
+    int first_input = argc;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (arg[0] != '-') {
+            first_input = i;
+            break;
+        }
+        if (strcmp(arg, "-l") == 0) {
+            options.linear = true;
+            continue;
+        }
+        if (i + 1 >= argc || (strcmp(arg, "-o") != 0 && strcmp(arg, "-c") != 0 && strcmp(arg, "-r") != 0 &&
+                              strcmp(arg, "-t") != 0)) {
+            print_usage();
+            return EXIT_FAILURE;
+        }
+
+        const char* value = argv[++i];
+        if (strcmp(arg, "-o") == 0) {
+            options.output = value;
+        } else if (strcmp(arg, "-r") == 0) {
+            options.root = value;
+        } else if (strcmp(arg, "-t") == 0) {
+            if (!parse_families(value, &options.families)) {
+                print_usage();
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(value, "none") == 0) {
+            options.compression = VE_PAK_COMPRESSION_NONE;
+        } else if (strcmp(value, "lz4") == 0) {
+            options.compression = VE_PAK_COMPRESSION_LZ4;
+        } else if (strcmp(value, "zstd") == 0) {
+            options.compression = VE_PAK_COMPRESSION_ZSTD;
+        } else {
+            print_usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!options.output || first_input >= argc) {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    ve_pak_writer* writer = ve_pak_writer_create(options.output);
+    if (!writer) {
+        return EXIT_FAILURE;
+    }
+
+    bool result = true;
+    for (int i = first_input; i < argc && result; i++) {
+        result = cook_file(writer, argv[i], &options);
+    }
+
+    /* Finish even after a failure, so the writer is freed */
+    result = ve_pak_writer_finish(writer) && result;
+    if (!result) {
+        remove(options.output);
+        return EXIT_FAILURE;
+    }
+
+    VE_LOG_INFO("Wrote %d entries to %s", argc - first_input, options.output);
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv) {
+    if (!ve_memory_init()) {
+        fprintf(stderr, "Failed to initialize memory system\n");
+        return EXIT_FAILURE;
+    }
+
+    ve_logger_config logger_config = {
+        .level = VE_LOG_INFO,
+        .targets = VE_LOG_TARGET_CONSOLE,
+        .color_output = true,
+    };
+    if (!ve_logger_init(&logger_config)) {
+        fprintf(stderr, "Failed to initialize logger\n");
+        ve_memory_shutdown();
+        return EXIT_FAILURE;
+    }
+
+    int result = run(argc, argv);
+
+    ve_logger_shutdown();
+    ve_memory_shutdown();
+    return result;
+}